@@ -21,6 +21,8 @@ BuildRequires:  libselinux-devel
 BuildRequires:  libcap-devel
 BuildRequires:  libblkid-devel
 BuildRequires:  bzip2-devel
+BuildRequires:  zlib-devel
+BuildRequires:  libzstd-devel
 BuildRequires:  asciidoc
 BuildRequires:  openldap-devel
 BuildRequires:  glib2-devel
@@ -24,7 +24,19 @@
 #include <config.h>
 #endif
 
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#ifndef OS_WINDOWS
+#include <unistd.h>
+#endif
+#include <openssl/evp.h>
+
 #include "common/_error.h"
+#include "common/debug_priv.h"
 #include "common/list.h"
 #include "common/public/oscap.h"
 #include "common/util.h"
@@ -32,6 +44,7 @@
 #include "CPE/public/cpe_dict.h"
 #include "CPE/public/cpe_lang.h"
 #include "OVAL/public/oval_agent_api.h"
+#include "OVAL/oval_object_cache_impl.h"
 #include "source/public/oscap_source.h"
 #include "source/oscap_source_priv.h"
 #include "oscap_helpers.h"
@@ -53,6 +66,9 @@ struct cpe_session *cpe_session_new(void)
 	cpe->lang_models = oscap_list_new();
 	cpe->oval_sessions = oscap_htable_new();
 	cpe->applicable_platforms = oscap_htable_new();
+	cpe->platform_results = oscap_htable_new();
+	cpe->check_results = oscap_htable_new();
+	cpe->name_results = oscap_htable_new();
 	cpe->thin_results = false;
 	if (!cpe_session_add_default_cpe(cpe)) {
 		oscap_seterr(OSCAP_EFAMILY_XCCDF, "Failed to add default CPE to newly created CPE Session.");
@@ -68,13 +84,37 @@ static inline void _xccdf_policy_destroy_cpe_oval_session(void* ptr)
 	oval_definition_model_free(model);
 }
 
+/*
+ * Results of the CPE OVAL definitions are kept across scans in the directory
+ * named by OSCAP_CPE_CACHE. The entry of a CPE OVAL file is named by SHA-256
+ * of its content. Its first line records the version of OpenSCAP and a
+ * fingerprint of the host: the modification times of os-release and of the
+ * package database and the machine ID. The entry is ignored if any of them
+ * changed, e.g. by an upgrade of the OS. The following lines hold the
+ * definition IDs and their results, only true and false results are kept.
+ */
+#define CPE_CACHE_MAGIC "openscap-cpe-cache-1"
+
+struct cpe_cache_entry {
+	char *path;                     ///< NULL if the entry can't be used
+	char *record;                   ///< first line of the entry
+	struct oscap_htable *results;   ///< [definition id -> "true" or "false"]
+	bool dirty;                     ///< new results have to be written
+};
+
+static void cpe_cache_entry_free(struct cpe_cache_entry *entry);
+
 void cpe_session_free(struct cpe_session *session)
 {
 	if (session != NULL) {
+		oscap_htable_free(session->cache_entries, (oscap_destruct_func) cpe_cache_entry_free);
 		oscap_list_free(session->dicts, (oscap_destruct_func) cpe_dict_model_free);
 		oscap_list_free(session->lang_models, (oscap_destruct_func) cpe_lang_model_free);
 		oscap_htable_free(session->oval_sessions, (oscap_destruct_func) _xccdf_policy_destroy_cpe_oval_session);
 		oscap_htable_free(session->applicable_platforms, NULL);
+		oscap_htable_free(session->platform_results, NULL);
+		oscap_htable_free(session->check_results, NULL);
+		oscap_htable_free(session->name_results, NULL);
 		free(session);
 	}
 }
@@ -119,6 +159,7 @@ struct oval_agent_session *cpe_session_lookup_oval_session(struct cpe_session *c
 			oscap_seterr(OSCAP_EFAMILY_OSCAP, "Cannot create OVAL session for '%s' for CPE applicability checking", prefixed_href);
 			return NULL;
 		}
+		oval_agent_set_object_cache(session, cpe->object_cache);
 		if (cpe->thin_results) {
 			struct oval_results_model *res_model = oval_agent_get_results_model(session);
 			struct oval_directives_model *dir_model = oval_results_model_get_directives_model(res_model);
@@ -136,15 +177,31 @@ struct oval_agent_session *cpe_session_lookup_oval_session(struct cpe_session *c
 	return session;
 }
 
+/* A new dictionary or lang model may make more platforms applicable */
+static inline void _cpe_session_reset_platform_results(struct cpe_session *session)
+{
+	// a CPE name may match an item of the new dictionary
+	if (session->name_results != NULL && oscap_htable_itemcount(session->name_results) != 0) {
+		oscap_htable_free(session->name_results, NULL);
+		session->name_results = oscap_htable_new();
+	}
+	if (session->platform_results == NULL || oscap_htable_itemcount(session->platform_results) == 0)
+		return;
+	oscap_htable_free(session->platform_results, NULL);
+	session->platform_results = oscap_htable_new();
+}
+
 bool cpe_session_add_cpe_lang_model_source(struct cpe_session *session, struct oscap_source *source)
 {
 	struct cpe_lang_model *lang_model = cpe_lang_model_import_source(source);
+	_cpe_session_reset_platform_results(session);
 	return oscap_list_add(session->lang_models, lang_model);
 }
 
 bool cpe_session_add_cpe_dict_source(struct cpe_session *session, struct oscap_source *source)
 {
 	struct cpe_dict_model *dict = cpe_dict_model_import_source(source);
+	_cpe_session_reset_platform_results(session);
 	return oscap_list_add(session->dicts, dict);
 }
 
@@ -166,3 +223,225 @@ void cpe_session_set_cache(struct cpe_session *session, struct oscap_htable *sou
 {
 	session->sources_cache = sources_cache;
 }
+
+void cpe_session_set_object_cache(struct cpe_session *session, struct oval_object_cache *object_cache)
+{
+	session->object_cache = object_cache;
+}
+
+#ifndef OS_WINDOWS
+static long long cpe_cache_mtime(const char *root, const char *const *paths)
+{
+	for (; *paths != NULL; ++paths) {
+		char *path = oscap_sprintf("%s%s", root, *paths);
+		struct stat st;
+		int ret = stat(path, &st);
+		free(path);
+		if (ret == 0)
+			return (long long) st.st_mtime;
+	}
+	return 0;
+}
+
+/* the parts of the host the CPE OVAL definitions usually check */
+static char *cpe_cache_host_fingerprint(void)
+{
+	static const char *const os_release[] = { "/etc/os-release", "/usr/lib/os-release", NULL };
+	static const char *const package_db[] = {
+		"/var/lib/rpm/rpmdb.sqlite", "/var/lib/rpm/Packages",
+		"/usr/lib/sysimage/rpm/rpmdb.sqlite", "/var/lib/dpkg/status", NULL
+	};
+	const char *root = getenv("OSCAP_PROBE_ROOT");
+	char machine_id[64] = "-";
+
+	if (root == NULL)
+		root = "";
+	char *path = oscap_sprintf("%s/etc/machine-id", root);
+	FILE *fp = fopen(path, "r");
+	free(path);
+	if (fp != NULL) {
+		if (fgets(machine_id, sizeof(machine_id), fp) == NULL || machine_id[0] == '\n')
+			strcpy(machine_id, "-");
+		machine_id[strcspn(machine_id, "\n")] = '\0';
+		fclose(fp);
+	}
+
+	return oscap_sprintf("%s %lld %lld %s", *root != '\0' ? root : "/",
+		cpe_cache_mtime(root, os_release), cpe_cache_mtime(root, package_db), machine_id);
+}
+
+static char *cpe_cache_digest(struct cpe_session *session, const char *prefixed_href)
+{
+	const char *memory;
+	size_t size;
+	unsigned char digest[EVP_MAX_MD_SIZE];
+	unsigned int digest_len = 0;
+	struct oscap_source *source = NULL;
+	struct oscap_source *cached = _lookup_source_in_cache(session, prefixed_href);
+
+	if (cached == NULL) {
+		source = oscap_source_new_from_file(prefixed_href);
+		cached = source;
+	}
+	bool ok = oscap_source_get_memory(cached, &memory, &size) == 0 &&
+		EVP_Digest(memory, size, digest, &digest_len, EVP_sha256(), NULL) == 1;
+	oscap_source_free(source);
+	if (!ok)
+		return NULL;
+
+	char *hex = malloc(2 * digest_len + 1);
+	for (unsigned int i = 0; i < digest_len; i++)
+		sprintf(hex + 2 * i, "%02x", digest[i]);
+	return hex;
+}
+
+/* read the results of the entry if it was written for this content and host */
+static void cpe_cache_entry_load(struct cpe_cache_entry *entry)
+{
+	struct stat st;
+	char line[4096];
+
+	int fd = open(entry->path, O_RDONLY | O_NOFOLLOW);
+	if (fd == -1)
+		return;
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_uid != geteuid()
+	    || (st.st_mode & (S_IWGRP | S_IWOTH)) != 0) {
+		close(fd);
+		return;
+	}
+	FILE *fp = fdopen(fd, "r");
+	if (fp == NULL) {
+		close(fd);
+		return;
+	}
+	if (fgets(line, sizeof(line), fp) != NULL && strcmp(line, entry->record) == 0) {
+		while (fgets(line, sizeof(line), fp) != NULL) {
+			char *sep = strrchr(line, ' ');
+			if (sep == NULL)
+				continue;
+			*sep++ = '\0';
+			if (strcmp(sep, "true\n") == 0)
+				oscap_htable_add(entry->results, line, "true");
+			else if (strcmp(sep, "false\n") == 0)
+				oscap_htable_add(entry->results, line, "false");
+		}
+	}
+	fclose(fp);
+}
+
+static void cpe_cache_entry_store(struct cpe_cache_entry *entry)
+{
+	char *tmp_path = oscap_sprintf("%s.XXXXXX", entry->path);
+	int fd = mkstemp(tmp_path);
+	if (fd == -1) {
+		dW("Can't write the CPE cache entry '%s': %s.", entry->path, strerror(errno));
+		free(tmp_path);
+		return;
+	}
+	FILE *fp = fdopen(fd, "w");
+	if (fp == NULL) {
+		close(fd);
+		unlink(tmp_path);
+		free(tmp_path);
+		return;
+	}
+	fputs(entry->record, fp);
+	struct oscap_htable_iterator *it = oscap_htable_iterator_new(entry->results);
+	while (oscap_htable_iterator_has_more(it)) {
+		const char *definition = NULL;
+		const char *result = NULL;
+		oscap_htable_iterator_next_kv(it, &definition, (void *) &result);
+		fprintf(fp, "%s %s\n", definition, result);
+	}
+	oscap_htable_iterator_free(it);
+	bool written = !ferror(fp);
+	if (fclose(fp) != 0 || !written || rename(tmp_path, entry->path) != 0) {
+		dW("Can't write the CPE cache entry '%s': %s.", entry->path, strerror(errno));
+		unlink(tmp_path);
+	}
+	free(tmp_path);
+}
+#endif
+
+static void cpe_cache_entry_free(struct cpe_cache_entry *entry)
+{
+	if (entry == NULL)
+		return;
+#ifndef OS_WINDOWS
+	if (entry->dirty)
+		cpe_cache_entry_store(entry);
+#endif
+	free(entry->path);
+	free(entry->record);
+	oscap_htable_free(entry->results, NULL);
+	free(entry);
+}
+
+static struct cpe_cache_entry *cpe_session_cache_entry(struct cpe_session *session, const char *prefixed_href)
+{
+	if (prefixed_href == NULL)
+		return NULL;
+	if (session->cache_entries != NULL) {
+		struct cpe_cache_entry *entry = oscap_htable_get(session->cache_entries, prefixed_href);
+		if (entry != NULL)
+			return entry->path != NULL ? entry : NULL;
+	}
+#ifdef OS_WINDOWS
+	return NULL;
+#else
+	const char *dir = getenv("OSCAP_CPE_CACHE");
+	if (dir == NULL || *dir == '\0')
+		return NULL;
+	if (session->cache_entries == NULL)
+		session->cache_entries = oscap_htable_new();
+
+	struct cpe_cache_entry *entry = calloc(1, sizeof(struct cpe_cache_entry));
+	entry->results = oscap_htable_new();
+	oscap_htable_add(session->cache_entries, prefixed_href, entry);
+
+	struct stat st;
+	if (mkdir(dir, 0700) != 0 && errno != EEXIST) {
+		dW("Can't create the CPE cache '%s': %s.", dir, strerror(errno));
+		return NULL;
+	}
+	// entries written by somebody else could make any platform applicable
+	if (stat(dir, &st) != 0 || !S_ISDIR(st.st_mode) || st.st_uid != geteuid()
+	    || (st.st_mode & (S_IWGRP | S_IWOTH)) != 0) {
+		dW("Ignoring the CPE cache '%s', it's not a directory writable only by its owner.", dir);
+		return NULL;
+	}
+	char *digest = cpe_cache_digest(session, prefixed_href);
+	if (digest == NULL)
+		return NULL;
+	char *fingerprint = cpe_cache_host_fingerprint();
+	entry->path = oscap_sprintf("%s/%s", dir, digest);
+	entry->record = oscap_sprintf(CPE_CACHE_MAGIC " %s %s %s\n", digest, OPENSCAP_VERSION, fingerprint);
+	free(fingerprint);
+	free(digest);
+
+	cpe_cache_entry_load(entry);
+	return entry;
+#endif
+}
+
+bool cpe_session_cached_result(struct cpe_session *session, const char *prefixed_href, const char *definition, bool *result)
+{
+	struct cpe_cache_entry *entry = cpe_session_cache_entry(session, prefixed_href);
+	if (entry == NULL)
+		return false;
+	const char *cached = oscap_htable_get(entry->results, definition);
+	if (cached == NULL)
+		return false;
+	*result = strcmp(cached, "true") == 0;
+	dI("Using the cached result of the CPE OVAL definition '%s' from '%s'.", definition, prefixed_href);
+	return true;
+}
+
+void cpe_session_cache_result(struct cpe_session *session, const char *prefixed_href, const char *definition, bool result)
+{
+	struct cpe_cache_entry *entry = cpe_session_cache_entry(session, prefixed_href);
+	if (entry == NULL)
+		return;
+	if (oscap_htable_add(entry->results, definition, result ? "true" : "false"))
+		entry->dirty = true;
+}
@@ -36,8 +36,13 @@ struct cpe_session {
 	struct oscap_list *lang_models;                 ///< All CPE lang models except the one embedded in XCCDF
 	struct oscap_htable *oval_sessions;             ///< Caches CPE OVAL check results
 	struct oscap_htable *applicable_platforms;
+	struct oscap_htable *platform_results;          ///< Caches applicability of platforms [platform -> bool]
+	struct oscap_htable *check_results;             ///< Caches results of check-fact-refs [href#id -> bool]
+	struct oscap_htable *name_results;              ///< Caches results of fact-refs [CPE name -> bool]
 	struct oscap_htable *sources_cache;             ///< Not owned cache [path -> oscap_source]
 	bool thin_results;                              ///< Should OVAL results related to CPE be exported as THIN?
+	struct oval_object_cache *object_cache;         ///< Not owned cache of collected objects
+	struct oscap_htable *cache_entries;             ///< Results kept across scans [path -> struct cpe_cache_entry]
 };
 
 struct cpe_session *cpe_session_new(void);
@@ -48,5 +53,19 @@ bool cpe_session_add_cpe_lang_model_source(struct cpe_session *session, struct o
 bool cpe_session_add_cpe_dict_source(struct cpe_session *session, struct oscap_source *source);
 bool cpe_session_add_cpe_autodetect_source(struct cpe_session *session, struct oscap_source *source);
 void cpe_session_set_cache(struct cpe_session *session, struct oscap_htable *sources_cache);
+void cpe_session_set_object_cache(struct cpe_session *session, struct oval_object_cache *object_cache);
+
+/**
+ * Get the result of a CPE OVAL definition evaluated by an earlier scan of
+ * the same host, if OSCAP_CPE_CACHE names the directory keeping them.
+ * @return true if the result was found
+ */
+bool cpe_session_cached_result(struct cpe_session *session, const char *prefixed_href, const char *definition, bool *result);
+
+/**
+ * Keep the result of a CPE OVAL definition for later scans, it's written
+ * when the session is freed.
+ */
+void cpe_session_cache_result(struct cpe_session *session, const char *prefixed_href, const char *definition, bool result);
 
 #endif
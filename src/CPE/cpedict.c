@@ -41,9 +41,11 @@
 #include "common/xmlns_priv.h"
 #include "common/elements.h"
 #include "common/xmltext_priv.h"
+#include "oscap_helpers.h"
 #include "source/oscap_source_priv.h"
 #include "source/public/oscap_source.h"
 #include <string.h>
+#include <ctype.h>
 
 #define CPE_DICT_SUPPORTED "2.3"
 
@@ -60,6 +62,7 @@ struct cpe_dict_model *cpe_dict_model_import_source(struct oscap_source *source)
 		dict = cpe_dict_model_parse(ctx);
 		if (dict != NULL) {
 			dict->origin_file = oscap_strdup(oscap_source_readable_origin(source));
+			cpe_dict_model_index(dict);
 		}
 	}
 	cpe_parser_ctx_free(ctx);
@@ -80,18 +83,165 @@ void cpe_dict_model_export(const struct cpe_dict_model *dict, const char *file)
 
 }
 
-bool cpe_name_match_dict(struct cpe_name * cpe, struct cpe_dict_model * dict)
+#define CPE_DICT_INDEX_HSIZE 65521
+
+/* items sharing part, vendor and product in the dictionary order */
+struct cpe_dict_bucket {
+	size_t count;
+	size_t alloc;
+	struct cpe_item **items;
+};
+
+static void cpe_dict_bucket_free(void *ptr)
 {
-	// FIXME: We could match faster by matching per component and storing all
-	//        cpe_dict items in a big tree where leaves contain cpe_items and
-	//        inner nodes are the components.
+	struct cpe_dict_bucket *bucket = ptr;
+
+	if (bucket == NULL)
+		return;
+	free(bucket->items);
+	free(bucket);
+}
+
+static bool cpe_dict_bucket_add(struct cpe_dict_bucket *bucket, struct cpe_item *item)
+{
+	if (bucket->count == bucket->alloc) {
+		size_t alloc = bucket->alloc > 0 ? bucket->alloc * 2 : 4;
+		struct cpe_item **items = realloc(bucket->items, alloc * sizeof(struct cpe_item *));
+
+		if (items == NULL)
+			return false;
+		bucket->items = items;
+		bucket->alloc = alloc;
+	}
+	bucket->items[bucket->count++] = item;
+	return true;
+}
+
+/*
+ * Key of the part, vendor and product of a name. Missing components are
+ * empty, which is what they compare to in cpe_name_match_one, and the key
+ * is lowercase because the comparison ignores case.
+ */
+static char *cpe_dict_index_key(const struct cpe_name *name)
+{
+	const char *part, *vendor, *product;
+	char *key, *c;
+
+	switch (cpe_name_get_part(name)) {
+	case CPE_PART_HW:
+		part = "h";
+		break;
+	case CPE_PART_OS:
+		part = "o";
+		break;
+	case CPE_PART_APP:
+		part = "a";
+		break;
+	default:
+		part = "";
+		break;
+	}
+	vendor = cpe_name_get_vendor(name);
+	product = cpe_name_get_product(name);
+	key = oscap_sprintf("%s:%s:%s", part, vendor != NULL ? vendor : "", product != NULL ? product : "");
+	for (c = key; *c != '\0'; ++c)
+		*c = tolower((unsigned char)*c);
+	return key;
+}
+
+static bool cpe_dict_index_complete(const struct cpe_name *name)
+{
+	return cpe_name_get_part(name) != CPE_PART_NONE &&
+		cpe_name_get_vendor(name) != NULL && cpe_name_get_product(name) != NULL;
+}
+
+void cpe_dict_model_drop_index(struct cpe_dict_model *dict)
+{
+	oscap_htable_free(dict->index, cpe_dict_bucket_free);
+	dict->index = NULL;
+	cpe_dict_bucket_free(dict->wildcards);
+	dict->wildcards = NULL;
+	dict->index_count = 0;
+}
+
+void cpe_dict_model_index(struct cpe_dict_model *dict)
+{
+	int count = oscap_list_get_itemcount(dict->items);
+
+	if (dict->index != NULL && dict->index_count == count)
+		return;
+	cpe_dict_model_drop_index(dict);
+
+	dict->index = oscap_htable_new1(strcmp, CPE_DICT_INDEX_HSIZE);
+	dict->wildcards = calloc(1, sizeof(struct cpe_dict_bucket));
+	if (dict->index == NULL || dict->wildcards == NULL) {
+		cpe_dict_model_drop_index(dict);
+		return;
+	}
+
+	bool ok = true;
+	struct cpe_item_iterator *items = cpe_dict_model_get_items(dict);
+	while (ok && cpe_item_iterator_has_more(items)) {
+		struct cpe_item *item = cpe_item_iterator_next(items);
+		struct cpe_name *name = cpe_item_get_name(item);
+
+		/* an item without name doesn't match anything */
+		if (name == NULL)
+			continue;
+
+		char *key = cpe_dict_index_key(name);
+		struct cpe_dict_bucket *bucket = oscap_htable_get(dict->index, key);
+		if (bucket == NULL) {
+			bucket = calloc(1, sizeof(struct cpe_dict_bucket));
+			if (bucket == NULL || !oscap_htable_add(dict->index, key, bucket)) {
+				cpe_dict_bucket_free(bucket);
+				bucket = NULL;
+			}
+		}
+		ok = bucket != NULL && cpe_dict_bucket_add(bucket, item);
+		if (ok && !cpe_dict_index_complete(name))
+			ok = cpe_dict_bucket_add(dict->wildcards, item);
+		free(key);
+	}
+	cpe_item_iterator_free(items);
+
+	if (ok) {
+		dict->index_count = count;
+	} else {
+		/* matching falls back to going through all the items */
+		cpe_dict_model_drop_index(dict);
+	}
+}
 
+bool cpe_name_match_dict(struct cpe_name * cpe, struct cpe_dict_model * dict)
+{
 	__attribute__nonnull__(cpe);
 	__attribute__nonnull__(dict);
 
 	if (cpe == NULL || dict == NULL)
 		return false;
 
+	cpe_dict_model_index(dict);
+	if (dict->index != NULL) {
+		/*
+		 * The name of an item has to have the part, vendor and product
+		 * of the matched name, unless it leaves them out.
+		 */
+		char *key = cpe_dict_index_key(cpe);
+		struct cpe_dict_bucket *bucket = oscap_htable_get(dict->index, key);
+		free(key);
+
+		for (size_t i = 0; bucket != NULL && i < bucket->count; ++i) {
+			if (cpe_name_match_one(cpe_item_get_name(bucket->items[i]), cpe))
+				return true;
+		}
+		for (size_t i = 0; i < dict->wildcards->count; ++i) {
+			if (cpe_name_match_one(cpe_item_get_name(dict->wildcards->items[i]), cpe))
+				return true;
+		}
+		return false;
+	}
+
 	struct cpe_item_iterator *items = cpe_dict_model_get_items(dict);
 
 	bool ret = false;
@@ -110,16 +260,32 @@ bool cpe_name_match_dict(struct cpe_name * cpe, struct cpe_dict_model * dict)
 
 bool cpe_name_applicable_dict(struct cpe_name *cpe, struct cpe_dict_model *dict, cpe_check_fn cb, void* usr)
 {
-	// FIXME: We could match faster by matching per component and storing all
-	//        cpe_dict items in a big tree where leaves contain cpe_items and
-	//        inner nodes are the components.
-
 	__attribute__nonnull__(cpe);
 	__attribute__nonnull__(dict);
 
 	if (cpe == NULL || dict == NULL)
 		return false;
 
+	cpe_dict_model_index(dict);
+	if (dict->index != NULL && cpe_dict_index_complete(cpe)) {
+		/*
+		 * Only the items with the part, vendor and product of the name
+		 * can match it. They are in the dictionary order, so the checks
+		 * are evaluated in the same order as without the index.
+		 */
+		char *key = cpe_dict_index_key(cpe);
+		struct cpe_dict_bucket *bucket = oscap_htable_get(dict->index, key);
+		free(key);
+
+		for (size_t i = 0; bucket != NULL && i < bucket->count; ++i) {
+			struct cpe_item *item = bucket->items[i];
+
+			if (cpe_name_match_one(cpe, cpe_item_get_name(item)) && cpe_item_is_applicable(item, cb, usr))
+				return true;
+		}
+		return false;
+	}
+
 	struct cpe_item_iterator *items = cpe_dict_model_get_items(dict);
 
 	// essentially, we want at least one applicable match so as soon as we find
@@ -1313,6 +1313,7 @@ void cpe_dict_model_free(struct cpe_dict_model *dict)
 	if (dict == NULL)
 		return;
 
+	cpe_dict_model_drop_index(dict);
 	oscap_list_free(dict->items, (oscap_destruct_func) cpe_item_free);
 	oscap_list_free(dict->vendors, (oscap_destruct_func) cpe_vendor_free);
 	cpe_generator_free(dict->generator);
@@ -134,6 +134,18 @@ bool cpe_dict_model_set_origin_file(struct cpe_dict_model* dict, const char* ori
  */
 const char* cpe_dict_model_get_origin_file(const struct cpe_dict_model* dict);
 
+/**
+ * Index the items by part, vendor and product, so that matching a name
+ * compares only the items which can match it. The index is rebuilt when
+ * the number of items has changed.
+ */
+void cpe_dict_model_index(struct cpe_dict_model *dict);
+
+/**
+ * Drop the index, it has to be done whenever items are changed or removed.
+ */
+void cpe_dict_model_drop_index(struct cpe_dict_model *dict);
+
 /* <cpe-list>
  * */
 struct cpe_dict_model {		// the main node
@@ -142,6 +154,9 @@ struct cpe_dict_model {		// the main node
 	int base_version;
 	struct cpe_generator *generator;
 	char* origin_file;
+	struct oscap_htable *index;	// "part:vendor:product" -> struct cpe_dict_bucket
+	struct cpe_dict_bucket *wildcards;	// items without part, vendor or product
+	int index_count;	// number of items indexed
 };
 
 /** 
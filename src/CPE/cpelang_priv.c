@@ -428,28 +428,33 @@ struct cpe_testexpr *cpe_testexpr_parse(xmlTextReaderPtr reader)
 static char *parse_text_element(xmlTextReaderPtr reader, char *name)
 {
 
-	char *string = NULL;
+	struct oscap_strbuf text;
+	bool has_text = false;
 
 	__attribute__nonnull__(reader);
 	__attribute__nonnull__(name);
 
 	// parse string element attributes here (like xml:lang)
 
+	oscap_strbuf_init(&text);
 	while (xmlTextReaderNextNode(reader)) {
 		if (xmlTextReaderNodeType(reader) == XML_READER_TYPE_END_ELEMENT &&
 		    !xmlStrcmp(xmlTextReaderConstLocalName(reader), BAD_CAST name)) {
-			return string;
+			break;
 		}
 
 		switch (xmlTextReaderNodeType(reader)) {
 		case XML_READER_TYPE_TEXT:
-			string = (char *)xmlTextReaderValue(reader);
+			oscap_strbuf_append_string(&text, (const char *)xmlTextReaderConstValue(reader));
+			has_text = true;
 			break;
 		default:
 			oscap_seterr(OSCAP_EFAMILY_OSCAP, "Unknown XML element in platform");
 			break;
 		}
 	}
+	char *string = has_text ? oscap_strbuf_strdup(&text) : NULL;
+	oscap_strbuf_release(&text);
 	return string;
 }
 
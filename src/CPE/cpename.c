@@ -39,6 +39,7 @@
 #include <stdio.h>
 #include <pcre.h>
 #include <ctype.h>
+#include <pthread.h>
 
 #include "cpe_name.h"
 #include "common/util.h"
@@ -544,43 +545,173 @@ bool cpe_name_match_one(const struct cpe_name * cpe, const struct cpe_name * aga
 	return true;
 }
 
-cpe_format_t cpe_name_get_format_of_str(const char *str)
+/* characters which can follow a backslash in a formatted string */
+#define CPE_FS_QUOTED "\\*?!\"#$%&'()+,/:;<=>@[]^`{|}~"
+
+static bool cpe_fs_unquoted(char c)
 {
-	if (str == NULL)
-		return CPE_FORMAT_UNKNOWN;
+	return isascii((unsigned char)c) && (isalnum((unsigned char)c) || c == '-' || c == '.' || c == '_');
+}
+
+/*
+ * Check a component of a formatted string, ((\?*|\*?)char+(\?*|\*?))|[\*\-]
+ * from the XSD, where char is an unquoted character or a backslash followed
+ * by a quoted one.
+ */
+static bool cpe_fs_component_check(const char *comp, size_t len)
+{
+	const char *c = comp, *end = comp + len;
+	const char *body;
+
+	if (len == 1 && (*c == '*' || *c == '-'))
+		return true;
+
+	if (c < end && *c == '*') {
+		++c;
+	} else {
+		while (c < end && *c == '?')
+			++c;
+	}
+	body = c;
+	while (c < end) {
+		if (*c == '\\') {
+			if (c + 1 >= end || c[1] == '\0' || strchr(CPE_FS_QUOTED, c[1]) == NULL)
+				return false;
+			c += 2;
+		} else if (cpe_fs_unquoted(*c)) {
+			++c;
+		} else {
+			break;
+		}
+	}
+	if (c == body)
+		return false;
+	if (c < end && *c == '*') {
+		++c;
+	} else {
+		while (c < end && *c == '?')
+			++c;
+	}
+	return c == end;
+}
+
+/* [a-zA-Z]{2,3}(-([a-zA-Z]{2}|[0-9]{3}))?|[\*\-] */
+static bool cpe_fs_language_check(const char *lang, size_t len)
+{
+	size_t i = 0;
+
+	if (len == 1 && (*lang == '*' || *lang == '-'))
+		return true;
+
+	while (i < len && i < 3 && isascii((unsigned char)lang[i]) && isalpha((unsigned char)lang[i]))
+		++i;
+	if (i < 2)
+		return false;
+	if (i == len)
+		return true;
+	if (lang[i] != '-')
+		return false;
+	++i;
+	if (len - i == 2)
+		return isascii((unsigned char)lang[i]) && isalpha((unsigned char)lang[i]) &&
+			isascii((unsigned char)lang[i + 1]) && isalpha((unsigned char)lang[i + 1]);
+	if (len - i == 3)
+		return isdigit((unsigned char)lang[i]) && isdigit((unsigned char)lang[i + 1]) &&
+			isdigit((unsigned char)lang[i + 2]);
+	return false;
+}
+
+/*
+ * Check a CPE 2.3 formatted string against the pattern of the XSD at
+ * http://scap.nist.gov/schema/cpe/2.3/cpe-naming_2.3.xsd without a regex.
+ * The components are separated by colons which aren't quoted, a backslash
+ * always quotes the next character.
+ */
+static bool cpe_fs_check(const char *str)
+{
+	const char *c, *comp, *end;
+	int field = 0;
+
+	if (strncmp(str, "cpe:2.3:", strlen("cpe:2.3:")) != 0)
+		return false;
+	end = str + strlen(str);
+	/* like $ in the regex, allow a newline at the end */
+	if (end > str && end[-1] == '\n')
+		--end;
+
+	comp = c = str + strlen("cpe:2.3:");
+	for (;;) {
+		if (c < end && *c == '\\') {
+			c += (c + 1 < end) ? 2 : 1;
+			continue;
+		}
+		if (c < end && *c != ':') {
+			++c;
+			continue;
+		}
+
+		size_t len = (c > end ? end : c) - comp;
+		bool ok;
+		if (field == 0)
+			ok = len == 1 && strchr("aho*-", *comp) != NULL;
+		else if (field == 6)
+			ok = cpe_fs_language_check(comp, len);
+		else
+			ok = cpe_fs_component_check(comp, len);
+		if (!ok)
+			return false;
+		++field;
+
+		if (c >= end)
+			break;
+		comp = ++c;
+	}
 
-	pcre *re;
+	return field == 11;
+}
+
+/* compiled once, the patterns are matched by many threads */
+static pthread_once_t cpe_format_regex_once = PTHREAD_ONCE_INIT;
+static pcre *cpe_uri_re = NULL;
+static pcre_extra *cpe_uri_extra = NULL;
+static pcre *cpe_wfn_re = NULL;
+static pcre_extra *cpe_wfn_extra = NULL;
+
+static void cpe_format_regex_init(void)
+{
 	const char *error;
 	int erroffset;
-	int rc;
-	int ovector[30];
 
 	// The regex was taken from the official XSD at
 	// http://scap.nist.gov/schema/cpe/2.3/cpe-naming_2.3.xsd
 	// [c] was replaced with [cC] here and in the schemas
+	cpe_uri_re = oscap_pcre_compile("^[cC][pP][eE]:/[AHOaho]?(:[A-Za-z0-9\\._\\-~%]*){0,6}$", 0, &error, &erroffset, &cpe_uri_extra);
 
-	re = pcre_compile("^[cC][pP][eE]:/[AHOaho]?(:[A-Za-z0-9\\._\\-~%]*){0,6}$", 0, &error, &erroffset, NULL);
-	rc = pcre_exec(re, NULL, str, strlen(str), 0, 0, ovector, 30);
-	pcre_free(re);
+	// FIXME: This should be way more strict
+	cpe_wfn_re = oscap_pcre_compile("^wfn:\\[.+\\]$", PCRE_CASELESS, &error, &erroffset, &cpe_wfn_extra);
+}
 
-	if (rc >= 0)
-		return CPE_FORMAT_URI;
+static bool cpe_format_regex_match(pcre *re, pcre_extra *extra, const char *str)
+{
+	int ovector[30];
 
-	// The regex was taken from the official XSD at
-	// http://scap.nist.gov/schema/cpe/2.3/cpe-naming_2.3.xsd
-	re = pcre_compile("^cpe:2\\.3:[aho\\*\\-](:(((\\?*|\\*?)([a-zA-Z0-9\\-\\._]|(\\\\[\\\\\\*\\?!\"#$$%&'\\(\\)\\+,/:;<=>@\\[\\]\\^`\\{\\|}~]))+(\\?*|\\*?))|[\\*\\-])){5}(:(([a-zA-Z]{2,3}(-([a-zA-Z]{2}|[0-9]{3}))?)|[\\*\\-]))(:(((\\?*|\\*?)([a-zA-Z0-9\\-\\._]|(\\\\[\\\\\\*\\?!\"#$$%&'\\(\\)\\+,/:;<=>@\\[\\]\\^`\\{\\|}~]))+(\\?*|\\*?))|[\\*\\-])){4}$", 0, &error, &erroffset, NULL);
-	rc = pcre_exec(re, NULL, str, strlen(str), 0, 0, ovector, 30);
-	pcre_free(re);
+	return re != NULL && pcre_exec(re, extra, str, strlen(str), 0, 0, ovector, 30) >= 0;
+}
 
-	if (rc >= 0)
-		return CPE_FORMAT_STRING;
+cpe_format_t cpe_name_get_format_of_str(const char *str)
+{
+	if (str == NULL)
+		return CPE_FORMAT_UNKNOWN;
 
-	// FIXME: This should be way more strict
-	re = pcre_compile("^wfn:\\[.+\\]$", PCRE_CASELESS, &error, &erroffset, NULL);
-	rc = pcre_exec(re, NULL, str, strlen(str), 0, 0, ovector, 30);
-	pcre_free(re);
+	pthread_once(&cpe_format_regex_once, cpe_format_regex_init);
+
+	if (cpe_format_regex_match(cpe_uri_re, cpe_uri_extra, str))
+		return CPE_FORMAT_URI;
+
+	if (cpe_fs_check(str))
+		return CPE_FORMAT_STRING;
 
-	if (rc >= 0)
+	if (cpe_format_regex_match(cpe_wfn_re, cpe_wfn_extra, str))
 		return CPE_FORMAT_WFN;
 
 	return CPE_FORMAT_UNKNOWN;
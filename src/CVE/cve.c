@@ -62,6 +62,21 @@ struct cve_model *cve_model_import(const char *file)
 	return cve;
 }
 
+/**
+ * Public function to parse CVE entries one at a time.
+ * Every entry is freed after the callback returns.
+ */
+int cve_model_import_stream(const char *file, const char *product_prefix, cve_entry_fn callback, void *arg)
+{
+
+	__attribute__nonnull__(file);
+
+	if (file == NULL || callback == NULL)
+		return -1;
+
+	return cve_model_parse_xml_stream(file, product_prefix, callback, arg);
+}
+
 /**
  * Public function to export CVE model to OSCAP export target.
  * Function fill the structure _target_ with model that is represented by structure
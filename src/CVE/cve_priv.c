@@ -42,6 +42,7 @@
 #include "cve_priv.h"
 
 #include "common/list.h"
+#include "common/util.h"
 #include "common/_error.h"
 #include "common/xmltext_priv.h"
 #include "common/elements.h"
@@ -459,7 +460,84 @@ struct cve_model *cve_model_parse(xmlTextReaderPtr reader)
 	return ret;
 }
 
+int cve_model_parse_xml_stream(const char *file, const char *prefix, cve_entry_fn callback, void *arg)
+{
+
+	__attribute__nonnull__(file);
+	__attribute__nonnull__(callback);
+
+	struct cve_entry *entry;
+	bool skipped;
+	int ret = 0;
+
+	struct oscap_source *source = oscap_source_new_from_file(file);
+	xmlTextReader *reader = oscap_source_get_xmlTextReader(source);
+	if (!reader) {
+		oscap_source_free(source);
+		return -1;
+	}
+
+	if (xmlTextReaderNextNode(reader) == -1 ||
+	    xmlStrcmp(xmlTextReaderConstLocalName(reader), TAG_NVD_STR) ||
+	    xmlTextReaderNodeType(reader) != XML_READER_TYPE_ELEMENT) {
+		xmlFreeTextReader(reader);
+		oscap_source_free(source);
+		return -1;
+	}
+
+	/* skip nodes until new element */
+	xmlTextReaderNextElement(reader);
+
+	/* every entry is freed before the next one is read */
+	while (ret == 0 && xmlStrcmp(xmlTextReaderConstLocalName(reader), TAG_CVE_STR) == 0) {
+
+		entry = cve_entry_parse_filtered(reader, prefix, &skipped);
+		if (entry) {
+			ret = callback(entry, arg);
+			cve_entry_free(entry);
+		}
+		xmlTextReaderNextElement(reader);
+	}
+
+	xmlFreeTextReader(reader);
+	oscap_source_free(source);
+	return ret;
+}
+
 struct cve_entry *cve_entry_parse(xmlTextReaderPtr reader)
+{
+	bool skipped;
+
+	return cve_entry_parse_filtered(reader, NULL, &skipped);
+}
+
+/* whether some product of the entry starts with the prefix */
+static bool cve_entry_has_product(const struct cve_entry *entry, const char *prefix)
+{
+	struct oscap_iterator *it = oscap_iterator_new(entry->products);
+	size_t len = strlen(prefix);
+	bool found = false;
+
+	while (!found && oscap_iterator_has_more(it)) {
+		const struct cve_product *product = oscap_iterator_next(it);
+
+		found = product->value != NULL && oscap_strncasecmp(product->value, prefix, len) == 0;
+	}
+	oscap_iterator_free(it);
+	return found;
+}
+
+/* move the reader to the end tag of the entry without reading the rest of it */
+static void cve_entry_skip(xmlTextReaderPtr reader, int depth)
+{
+	while (xmlTextReaderNodeType(reader) != XML_READER_TYPE_END_ELEMENT ||
+	       xmlTextReaderDepth(reader) != depth) {
+		if (xmlTextReaderNext(reader) != 1)
+			break;
+	}
+}
+
+struct cve_entry *cve_entry_parse_filtered(xmlTextReaderPtr reader, const char *prefix, bool *skipped)
 {
 
 	__attribute__nonnull__(reader);
@@ -469,6 +547,9 @@ struct cve_entry *cve_entry_parse(xmlTextReaderPtr reader)
 	struct cve_reference *refer;
 	struct cve_summary *summary;
 	struct cve_configuration *conf;
+	int depth;
+
+	*skipped = false;
 
 	/* allocate platform structure here */
 	ret = cve_entry_new();
@@ -483,8 +564,15 @@ struct cve_entry *cve_entry_parse(xmlTextReaderPtr reader)
 	}
 
 	/* If <empty /> then return, because there is no child element */
-	if (xmlTextReaderIsEmptyElement(reader))
+	if (xmlTextReaderIsEmptyElement(reader)) {
+		if (prefix != NULL) {
+			*skipped = true;
+			cve_entry_free(ret);
+			return NULL;
+		}
 		return ret;
+	}
+	depth = xmlTextReaderDepth(reader);
 
 	/* skip from <entry> node to next one */
 	xmlTextReaderNextNode(reader);
@@ -525,6 +613,13 @@ struct cve_entry *cve_entry_parse(xmlTextReaderPtr reader)
 				}
 				xmlTextReaderNextNode(reader);
 			}
+			/* the products precede the bulky parts of the entry */
+			if (prefix != NULL && !cve_entry_has_product(ret, prefix)) {
+				cve_entry_skip(reader, depth);
+				*skipped = true;
+				cve_entry_free(ret);
+				return NULL;
+			}
 		} else if (!xmlStrcmp(xmlTextReaderConstLocalName(reader), TAG_CVE_ID_STR)) {
 			ret->cve_id = oscap_element_string_copy(reader);
 		} else if (!xmlStrcmp(xmlTextReaderConstLocalName(reader), TAG_DISCOVERED_DATETIME_STR)) {
@@ -599,6 +694,11 @@ struct cve_entry *cve_entry_parse(xmlTextReaderPtr reader)
 		xmlTextReaderNextNode(reader);
 	}
 
+	if (prefix != NULL && !cve_entry_has_product(ret, prefix)) {
+		*skipped = true;
+		cve_entry_free(ret);
+		return NULL;
+	}
 	return ret;
 }
 
@@ -38,6 +38,7 @@
 
 #include "../common/list.h"
 #include "../common/elements.h"
+#include "public/cve_nvd.h"
 
 /** 
  * @cond INTERNAL
@@ -101,6 +102,25 @@ struct cve_model *cve_model_parse(xmlTextReaderPtr reader);
  */
 struct cve_entry *cve_entry_parse(xmlTextReaderPtr reader);
 
+/**
+ * Parse CVE entries from XML one at a time (private function)
+ * @param file OSCAP import source
+ * @param prefix product prefix the entries have to match or NULL
+ * @param callback called with each entry, the entry is freed afterwards
+ * @param arg argument of the callback
+ * @return see cve_model_import_stream
+ */
+int cve_model_parse_xml_stream(const char *file, const char *prefix, cve_entry_fn callback, void *arg);
+
+/**
+ * Parse CVE entry, skipping it if none of its products starts with the prefix
+ * @param reader XML Text Reader representing XML model
+ * @param prefix product prefix or NULL to parse every entry
+ * @param skipped set to true if the entry didn't match the prefix
+ * @return parsed CVE entry or NULL
+ */
+struct cve_entry *cve_entry_parse_filtered(xmlTextReaderPtr reader, const char *prefix, bool *skipped);
+
 /**
  * Export CVE model to XML file
  * @param cve CVE model
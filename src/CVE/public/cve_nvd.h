@@ -673,6 +673,27 @@ OSCAP_API void cve_model_export(struct cve_model *cve, const char *file);
  */
 OSCAP_API struct cve_model *cve_model_import(const char *file);
 
+/**
+ * Callback of cve_model_import_stream.
+ * @param entry the parsed CVE entry, it is freed when the callback returns
+ * @param arg user data passed to cve_model_import_stream
+ * @return 0 to continue with the next entry, anything else to stop
+ */
+typedef int (*cve_entry_fn)(const struct cve_entry *entry, void *arg);
+
+/**
+ * Parses the specified XML file one entry at a time, only the entry being
+ * processed is held in memory. Entries with no vulnerable product starting
+ * with the prefix are skipped without being parsed completely.
+ * @memberof cve_model
+ * @param file filename
+ * @param product_prefix prefix of the product CPE (e.g. "cpe:/o:redhat:"), compared case-insensitively, or NULL for all entries
+ * @param callback function called with each entry
+ * @param arg user data passed to the callback
+ * @return 0 if all the entries were processed, -1 on error, or the non-zero value the callback stopped with
+ */
+OSCAP_API int cve_model_import_stream(const char *file, const char *product_prefix, cve_entry_fn callback, void *arg);
+
 /// @memberof cve_model
 OSCAP_API const char *cve_model_get_nvd_xml_version(const struct cve_model *item);
 /// @memberof cve_model
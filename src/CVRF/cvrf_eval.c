@@ -24,6 +24,7 @@
 #include <config.h>
 #endif
 
+#include <stdlib.h>
 #include <string.h>
 
 #include <libxml/xmlreader.h>
@@ -41,6 +42,8 @@
 #include "common/elements.h"
 #include "common/oscap_string.h"
 #include "common/util.h"
+#include "common/debug_priv.h"
+#include "common/oscap_threadpool.h"
 
 #include "CPE/cpelang_priv.h"
 #include "CPE/public/cpe_dict.h"
@@ -187,6 +190,31 @@ static int find_all_cvrf_product_ids_from_cpe(struct cvrf_session *session) {
 	return 0;
 }
 
+/*
+ * Map the IDs of the products listed in the statuses of the vulnerability
+ * to their status, so the products of the session are joined against it
+ * with one lookup each instead of scanning all the statuses per product.
+ */
+static struct oscap_htable *cvrf_vulnerability_status_ids(struct cvrf_vulnerability *vuln) {
+	struct oscap_htable *ids = oscap_htable_new();
+	if (ids == NULL)
+		return NULL;
+
+	struct cvrf_product_status_iterator *it = cvrf_vulnerability_get_product_statuses(vuln);
+	while (cvrf_product_status_iterator_has_more(it)) {
+		struct cvrf_product_status *stat = cvrf_product_status_iterator_next(it);
+		struct oscap_string_iterator *product_ids = cvrf_product_status_get_ids(stat);
+
+		while (oscap_string_iterator_has_more(product_ids)) {
+			/* the first status wins, like in cvrf_product_vulnerability_fixed */
+			oscap_htable_add(ids, oscap_string_iterator_next(product_ids), stat);
+		}
+		oscap_string_iterator_free(product_ids);
+	}
+	cvrf_product_status_iterator_free(it);
+	return ids;
+}
+
 static xmlNode *cvrf_model_results_to_dom(struct cvrf_session *session) {
 	xmlNode *root_node = xmlNewNode(NULL, BAD_CAST "cvrfdoc");
 	xmlNewNs(root_node, CVRF_NS, NULL);
@@ -202,6 +230,7 @@ static xmlNode *cvrf_model_results_to_dom(struct cvrf_session *session) {
 		xmlNode *vuln_node = cvrf_vulnerability_to_dom(vuln);
 		xmlAddChild(root_node, vuln_node);
 		xmlNode *results_node = xmlNewTextChild(vuln_node, NULL, BAD_CAST "Results", NULL);
+		struct oscap_htable *status_ids = cvrf_vulnerability_status_ids(vuln);
 
 		struct oscap_string_iterator *product_ids = cvrf_session_get_product_ids(session);
 		while (oscap_string_iterator_has_more(product_ids)) {
@@ -209,7 +238,10 @@ static xmlNode *cvrf_model_results_to_dom(struct cvrf_session *session) {
 			xmlNode *result_node = xmlNewTextChild(results_node, NULL, BAD_CAST "Result", NULL);
 			cvrf_element_add_child("ProductID", product_id, result_node);
 
-			if (cvrf_product_vulnerability_fixed(vuln, product_id)) {
+			bool fixed = status_ids != NULL ?
+				oscap_htable_get(status_ids, product_id) != NULL :
+				cvrf_product_vulnerability_fixed(vuln, product_id);
+			if (fixed) {
 				cvrf_element_add_child("VulnerabilityStatus", "FIXED", result_node);
 			}
 			else {
@@ -217,6 +249,7 @@ static xmlNode *cvrf_model_results_to_dom(struct cvrf_session *session) {
 			}
 		}
 		oscap_string_iterator_free(product_ids);
+		oscap_htable_free0(status_ids);
 	}
 	cvrf_vulnerability_iterator_free(it);
 	return root_node;
@@ -253,32 +286,107 @@ struct oscap_source *cvrf_model_get_results_source(struct oscap_source *import_s
 	return source;
 }
 
+#define CVRF_INDEX_MAX_JOBS 64
+
+struct cvrf_index_pool {
+	char **paths;
+	const char *os_name;
+	xmlNode **nodes;                ///< results of the documents in the order of the index
+};
+
+/*
+ * Parse and evaluate one document of the index. The documents don't share
+ * anything but the OS name, each one has its own product IDs.
+ */
+static xmlNode *cvrf_index_document_results(const char *path, const char *os_name) {
+	struct oscap_source *source = oscap_source_new_from_file(path);
+	struct cvrf_model *model = cvrf_model_import(source);
+	oscap_source_free(source);
+	if (model == NULL)
+		return NULL;
+
+	struct cvrf_session session = {
+		.model = model,
+		.os_name = (char *)os_name,
+		.product_ids = oscap_stringlist_new(),
+	};
+	find_all_cvrf_product_ids_from_cpe(&session);
+	xmlNode *model_node = cvrf_model_results_to_dom(&session);
+
+	oscap_stringlist_free(session.product_ids);
+	cvrf_model_free(model);
+	return model_node;
+}
+
+static void cvrf_index_pool_run(void *arg, size_t i) {
+	struct cvrf_index_pool *pool = arg;
+
+	pool->nodes[i] = cvrf_index_document_results(pool->paths[i], pool->os_name);
+}
+
 struct oscap_source *cvrf_index_get_results_source(struct oscap_source *import_source, const char *os_name) {
-	struct cvrf_session *session = cvrf_session_new_from_source_index(import_source);
-	cvrf_session_set_os_name(session, os_name);
+	__attribute__nonnull__(import_source);
+	__attribute__nonnull__(os_name);
 
-	xmlDocPtr doc = xmlNewDoc(BAD_CAST "1.0");
-	if (doc == NULL) {
-		oscap_setxmlerr(xmlGetLastError());
-		cvrf_session_free(session);
+	struct oscap_stringlist *paths = cvrf_index_parse_paths(import_source);
+	if (paths == NULL)
 		return NULL;
-	}
-	xmlNode *index_node = xmlNewNode(NULL, BAD_CAST "Index");
-	xmlDocSetRootElement(doc, index_node);
 
-	struct cvrf_model_iterator *it = cvrf_index_get_models(session->index);
-	while (cvrf_model_iterator_has_more(it)) {
-		struct cvrf_model *model = cvrf_model_iterator_next(it);
-		session->model = model;
-		find_all_cvrf_product_ids_from_cpe(session);
+	struct cvrf_index_pool pool;
+	size_t i, jobs, count;
+	char **errors;
+
+	memset(&pool, 0, sizeof(pool));
+	count = oscap_list_get_itemcount((struct oscap_list *)paths);
+	pool.paths = calloc(count + 1, sizeof(char *));
+	pool.nodes = calloc(count + 1, sizeof(xmlNode *));
+	pool.os_name = os_name;
+	errors = calloc(count + 1, sizeof(char *));
+
+	struct oscap_string_iterator *it = oscap_stringlist_get_strings(paths);
+	for (i = 0; oscap_string_iterator_has_more(it); i++)
+		pool.paths[i] = (char *)oscap_string_iterator_next(it);
+	oscap_string_iterator_free(it);
+
+	jobs = oscap_threadpool_jobs("OSCAP_CVRF_JOBS", 0, CVRF_INDEX_MAX_JOBS);
+	if (jobs > count)
+		jobs = count;
+	dI("Evaluating %zu CVRF documents using %zu threads.", count, jobs);
+	oscap_threadpool_run(jobs, count, cvrf_index_pool_run, &pool, errors);
+
+	/* as if the documents were evaluated one by one until the first failure */
+	bool failed = false;
+	for (i = 0; i < count; i++) {
+		if (errors[i] != NULL)
+			oscap_seterr(OSCAP_EFAMILY_OSCAP, "%s", errors[i]);
+		if (pool.nodes[i] == NULL) {
+			failed = true;
+			break;
+		}
+	}
 
-		xmlNode *model_node = cvrf_model_results_to_dom(session);
-		xmlAddChild(index_node, model_node);
+	struct oscap_source *source = NULL;
+	xmlDocPtr doc = failed ? NULL : xmlNewDoc(BAD_CAST "1.0");
+	if (doc != NULL) {
+		xmlNode *index_node = xmlNewNode(NULL, BAD_CAST "Index");
+		xmlDocSetRootElement(doc, index_node);
+		for (i = 0; i < count; i++) {
+			xmlAddChild(index_node, pool.nodes[i]);
+			pool.nodes[i] = NULL;
+		}
+		source = oscap_source_new_from_xmlDoc(doc, NULL);
+	} else if (!failed) {
+		oscap_setxmlerr(xmlGetLastError());
 	}
-	cvrf_model_iterator_free(it);
 
-	struct oscap_source *source = oscap_source_new_from_xmlDoc(doc, NULL);
-	cvrf_session_free(session);
+	for (i = 0; i < count; i++) {
+		xmlFreeNode(pool.nodes[i]);
+		free(errors[i]);
+	}
+	free(errors);
+	free(pool.nodes);
+	free(pool.paths);
+	oscap_stringlist_free(paths);
 	return source;
 }
 
@@ -25,6 +25,7 @@
 #endif
 
 #include <string.h>
+#include <ctype.h>
 #include <math.h>
 
 #include <libxml/xmlreader.h>
@@ -2326,18 +2327,73 @@ xmlNode *cvrf_model_to_dom(struct cvrf_model *model, xmlDocPtr doc, xmlNode *par
 	return root_node;
 }
 
-struct cvrf_index *cvrf_index_parse_xml(struct oscap_source *index_source) {
+struct oscap_stringlist *cvrf_index_parse_paths(struct oscap_source *index_source) {
 	__attribute__nonnull__(index_source);
 
-	char *buffer = "";
-	char **buffer_ptr = &buffer;
-	/* oscap_source_get_raw_memory doesn't check for null pointers s.a. null size */
+	char *buffer = NULL;
 	size_t size = 0;
-	if (oscap_source_get_raw_memory(index_source, buffer_ptr, &size) == 1) {
+	if (oscap_source_get_raw_memory(index_source, &buffer, &size) != 0)
 		return NULL;
+
+	char *origin = oscap_strdup(oscap_source_readable_origin(index_source));
+	char *dir = oscap_dirname(origin);
+	struct oscap_stringlist *paths = oscap_stringlist_new();
+
+	/* one file name per line, relative to the directory of the index */
+	char *line = buffer;
+	char *buffer_end = buffer + size;
+	while (line < buffer_end) {
+		char *end = memchr(line, '\n', buffer_end - line);
+		size_t len = (end != NULL ? end : buffer_end) - line;
+
+		while (len > 0 && isspace((unsigned char)*line)) {
+			line++;
+			len--;
+		}
+		while (len > 0 && isspace((unsigned char)line[len - 1]))
+			len--;
+		if (len > 0 && *line != '#') {
+			char *path = line[0] == '/' ?
+				oscap_sprintf("%.*s", (int)len, line) :
+				oscap_sprintf("%s/%.*s", dir, (int)len, line);
+			oscap_stringlist_add_string(paths, path);
+			free(path);
+		}
+		if (end == NULL)
+			break;
+		line = end + 1;
 	}
+
+	free(dir);
+	free(origin);
+	free(buffer);
+	return paths;
+}
+
+struct cvrf_index *cvrf_index_parse_xml(struct oscap_source *index_source) {
+	__attribute__nonnull__(index_source);
+
+	struct oscap_stringlist *paths = cvrf_index_parse_paths(index_source);
+	if (paths == NULL)
+		return NULL;
+
 	struct cvrf_index *index = cvrf_index_new();
 	cvrf_index_set_index_file(index, oscap_source_readable_origin(index_source));
+
+	struct oscap_string_iterator *it = oscap_stringlist_get_strings(paths);
+	while (oscap_string_iterator_has_more(it)) {
+		struct oscap_source *source = oscap_source_new_from_file(oscap_string_iterator_next(it));
+		struct cvrf_model *model = cvrf_model_import(source);
+		oscap_source_free(source);
+		if (model == NULL) {
+			cvrf_index_free(index);
+			index = NULL;
+			break;
+		}
+		cvrf_index_add_model(index, model);
+	}
+	oscap_string_iterator_free(it);
+	oscap_stringlist_free(paths);
 	return index;
 }
 
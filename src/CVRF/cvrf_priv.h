@@ -632,6 +632,15 @@ struct cvrf_document *cvrf_document_parse(xmlTextReaderPtr reader);
  */
 struct cvrf_model *cvrf_model_parse(xmlTextReaderPtr reader);
 
+/**
+ * Get the paths of the CVRF files listed in an index file, one per line. Relative
+ * paths are resolved against the directory of the index, empty lines and lines
+ * starting with '#' are skipped.
+ * @param index_source OSCAP source of index file containing list of all CVRF files
+ * @return New list of the paths in the order of the index, NULL if the index can't be read
+ */
+struct oscap_stringlist *cvrf_index_parse_paths(struct oscap_source *index_source);
+
 /**
  * Parse all CVRF models from all files listed in an index file
  * @param index_source OSCAP source of index file containing list of all CVRF files
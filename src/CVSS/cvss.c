@@ -228,6 +228,18 @@ static const struct cvss_valtab_entry *cvss_valtab(enum cvss_key key, unsigned v
     return entry;
 }
 
+enum cvss_key cvss_key_from_vector(const char *component, unsigned *value)
+{
+    const struct cvss_valtab_entry *entry = cvss_valtab(0, 0, component, NULL);
+    *value = entry->value;
+    return entry->key;
+}
+
+float cvss_key_weight(enum cvss_key key, unsigned value)
+{
+    return cvss_valtab(key, value, NULL, NULL)->weight;
+}
+
 struct cvss_impact *cvss_impact_new_from_vector(const char *cvss_vector)
 {
     struct cvss_impact *impact = cvss_impact_new();
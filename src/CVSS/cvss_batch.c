@@ -0,0 +1,419 @@
+/*! \file cvss_batch.c
+ *  \brief Scoring of many CVSS version 2 and 3.x vectors at once
+ *
+ *  See details at https://www.first.org/cvss/
+ *
+ */
+
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "public/cvss_score.h"
+#include "cvss_priv.h"
+#include "oscap_helpers.h"
+
+/*
+ * The vectors are kept as a structure of arrays, one array of small value
+ * codes per metric, and are scored by loops doing only table lookups and
+ * arithmetic on them. Code 0 means that the metric isn't set; for version
+ * 2 the codes are the values of the cvss_* enums, for version 3.x they
+ * are positions in the value letters of CVSS_V3_METRICS.
+ */
+
+// metric slots shared by the versions, version 2 uses AU for Authentication
+enum cvss_slot {
+    CVSS_SLOT_AV, CVSS_SLOT_AC, CVSS_SLOT_AU, CVSS_SLOT_PR = CVSS_SLOT_AU, CVSS_SLOT_UI, CVSS_SLOT_S,
+    CVSS_SLOT_C, CVSS_SLOT_I, CVSS_SLOT_A,
+    CVSS_SLOT_E, CVSS_SLOT_RL, CVSS_SLOT_RC,
+    CVSS_SLOT_CDP, CVSS_SLOT_TD, CVSS_SLOT_CR, CVSS_SLOT_IR, CVSS_SLOT_AR,
+    CVSS_SLOT_MAV, CVSS_SLOT_MAC, CVSS_SLOT_MPR, CVSS_SLOT_MUI, CVSS_SLOT_MS,
+    CVSS_SLOT_MC, CVSS_SLOT_MI, CVSS_SLOT_MA,
+    CVSS_SLOT_NUM
+};
+
+#define CVSS_CODE_NUM 8
+
+// metric groups present in a vector
+#define CVSS_GROUP_TEMPORAL      0x01
+#define CVSS_GROUP_ENVIRONMENTAL 0x02
+
+#define CVSS_BATCH_INITIAL 64
+
+struct cvss_batch {
+    size_t count;
+    size_t capacity;
+    uint8_t *version;                // enum cvss_version
+    uint8_t *groups;                 // CVSS_GROUP_* flags
+    uint8_t *metrics[CVSS_SLOT_NUM]; // value codes
+};
+
+static const enum cvss_key CVSS_V2_SLOT_KEY[CVSS_SLOT_NUM] = {
+    [CVSS_SLOT_AV]  = CVSS_KEY_access_vector,
+    [CVSS_SLOT_AC]  = CVSS_KEY_access_complexity,
+    [CVSS_SLOT_AU]  = CVSS_KEY_authentication,
+    [CVSS_SLOT_C]   = CVSS_KEY_confidentiality_impact,
+    [CVSS_SLOT_I]   = CVSS_KEY_integrity_impact,
+    [CVSS_SLOT_A]   = CVSS_KEY_availability_impact,
+    [CVSS_SLOT_E]   = CVSS_KEY_exploitability,
+    [CVSS_SLOT_RL]  = CVSS_KEY_remediation_level,
+    [CVSS_SLOT_RC]  = CVSS_KEY_report_confidence,
+    [CVSS_SLOT_CDP] = CVSS_KEY_collateral_damage_potential,
+    [CVSS_SLOT_TD]  = CVSS_KEY_target_distribution,
+    [CVSS_SLOT_CR]  = CVSS_KEY_confidentiality_requirement,
+    [CVSS_SLOT_IR]  = CVSS_KEY_integrity_requirement,
+    [CVSS_SLOT_AR]  = CVSS_KEY_availability_requirement,
+};
+
+// version 2 weights by slot and code, filled from the table of cvss.c
+static float CVSS_V2_WEIGHTS[CVSS_SLOT_NUM][CVSS_CODE_NUM];
+static pthread_once_t cvss_v2_weights_once = PTHREAD_ONCE_INIT;
+
+static void cvss_v2_weights_init(void)
+{
+    for (size_t slot = 0; slot < CVSS_SLOT_NUM; ++slot)
+        for (unsigned code = 0; code < CVSS_CODE_NUM; ++code)
+            CVSS_V2_WEIGHTS[slot][code] = CVSS_V2_SLOT_KEY[slot] != 0 ? cvss_key_weight(CVSS_V2_SLOT_KEY[slot], code) : NAN;
+}
+
+struct cvss_v3_metric {
+    const char *name;
+    enum cvss_slot slot;
+    const char *values; // letter of each code, '-' if code 0 can't be given
+};
+
+static const struct cvss_v3_metric CVSS_V3_METRICS[] = {
+    // Base metrics:
+    { "AV",  CVSS_SLOT_AV,  "-NALP" },
+    { "AC",  CVSS_SLOT_AC,  "-LH"   },
+    { "PR",  CVSS_SLOT_PR,  "-NLH"  },
+    { "UI",  CVSS_SLOT_UI,  "-NR"   },
+    { "S",   CVSS_SLOT_S,   "-UC"   },
+    { "C",   CVSS_SLOT_C,   "-HLN"  },
+    { "I",   CVSS_SLOT_I,   "-HLN"  },
+    { "A",   CVSS_SLOT_A,   "-HLN"  },
+    // Temporal metrics:
+    { "E",   CVSS_SLOT_E,   "XHFPU" },
+    { "RL",  CVSS_SLOT_RL,  "XUWTO" },
+    { "RC",  CVSS_SLOT_RC,  "XCRU"  },
+    // Environmental metrics:
+    { "CR",  CVSS_SLOT_CR,  "XHML"  },
+    { "IR",  CVSS_SLOT_IR,  "XHML"  },
+    { "AR",  CVSS_SLOT_AR,  "XHML"  },
+    { "MAV", CVSS_SLOT_MAV, "XNALP" },
+    { "MAC", CVSS_SLOT_MAC, "XLH"   },
+    { "MPR", CVSS_SLOT_MPR, "XNLH"  },
+    { "MUI", CVSS_SLOT_MUI, "XNR"   },
+    { "MS",  CVSS_SLOT_MS,  "XUC"   },
+    { "MC",  CVSS_SLOT_MC,  "XHLN"  },
+    { "MI",  CVSS_SLOT_MI,  "XHLN"  },
+    { "MA",  CVSS_SLOT_MA,  "XHLN"  },
+    // end of list
+    { NULL, CVSS_SLOT_NUM, NULL }
+};
+
+// version 3.x weights by code, the modified metrics use the base tables
+static const double CVSS_V3_AV[CVSS_CODE_NUM]   = { NAN, 0.85, 0.62, 0.55, 0.2 };
+static const double CVSS_V3_AC[CVSS_CODE_NUM]   = { NAN, 0.77, 0.44 };
+static const double CVSS_V3_PR_U[CVSS_CODE_NUM] = { NAN, 0.85, 0.62, 0.27 };
+static const double CVSS_V3_PR_C[CVSS_CODE_NUM] = { NAN, 0.85, 0.68, 0.5 };
+static const double CVSS_V3_UI[CVSS_CODE_NUM]   = { NAN, 0.85, 0.62 };
+static const double CVSS_V3_CIA[CVSS_CODE_NUM]  = { NAN, 0.56, 0.22, 0.0 };
+static const double CVSS_V3_E[CVSS_CODE_NUM]    = { 1.0, 1.0, 0.97, 0.94, 0.91 };
+static const double CVSS_V3_RL[CVSS_CODE_NUM]   = { 1.0, 1.0, 0.97, 0.96, 0.95 };
+static const double CVSS_V3_RC[CVSS_CODE_NUM]   = { 1.0, 1.0, 0.96, 0.92 };
+static const double CVSS_V3_REQ[CVSS_CODE_NUM]  = { 1.0, 1.5, 1.0, 0.5 };
+
+#define CVSS_V3_SCOPE_CHANGED 2
+
+struct cvss_batch *cvss_batch_new(void)
+{
+    pthread_once(&cvss_v2_weights_once, cvss_v2_weights_init);
+    return calloc(1, sizeof(struct cvss_batch));
+}
+
+void cvss_batch_free(struct cvss_batch *batch)
+{
+    if (batch) {
+        free(batch->version);
+        free(batch->groups);
+        for (size_t slot = 0; slot < CVSS_SLOT_NUM; ++slot)
+            free(batch->metrics[slot]);
+        free(batch);
+    }
+}
+
+size_t cvss_batch_get_count(const struct cvss_batch *batch)
+{
+    assert(batch != NULL);
+    return batch->count;
+}
+
+enum cvss_version cvss_batch_get_version(const struct cvss_batch *batch, size_t i)
+{
+    assert(batch != NULL);
+    return i < batch->count ? batch->version[i] : CVSS_VERSION_NONE;
+}
+
+static bool cvss_batch_reserve(struct cvss_batch *batch)
+{
+    if (batch->count < batch->capacity) return true;
+
+    size_t capacity = batch->capacity ? 2 * batch->capacity : CVSS_BATCH_INITIAL;
+    uint8_t *arr;
+
+    // arrays already grown stay grown if a later one fails
+    if ((arr = realloc(batch->version, capacity)) == NULL) return false;
+    batch->version = arr;
+    if ((arr = realloc(batch->groups, capacity)) == NULL) return false;
+    batch->groups = arr;
+    for (size_t slot = 0; slot < CVSS_SLOT_NUM; ++slot) {
+        if ((arr = realloc(batch->metrics[slot], capacity)) == NULL) return false;
+        batch->metrics[slot] = arr;
+    }
+    batch->capacity = capacity;
+    return true;
+}
+
+static bool cvss_batch_parse_v2(char *vector, uint8_t *codes, uint8_t *groups)
+{
+    size_t len = strlen(vector);
+
+    // vector in parenthesis
+    if (vector[0] == '(') {
+        if (len < 2 || vector[len - 1] != ')') return false;
+        vector[len - 1] = '\0';
+        ++vector;
+    }
+    oscap_strtoupper(vector);
+
+    char *saveptr = NULL;
+
+    for (char *comp = oscap_strtok_r(vector, "/", &saveptr); comp != NULL; comp = oscap_strtok_r(NULL, "/", &saveptr)) {
+        unsigned value;
+        enum cvss_key key = cvss_key_from_vector(comp, &value);
+        size_t slot;
+
+        if (key == CVSS_KEY_NONE) return false;
+        for (slot = 0; slot < CVSS_SLOT_NUM && CVSS_V2_SLOT_KEY[slot] != key; ++slot)
+            ;
+        codes[slot] = value;
+        if (CVSS_CATEGORY(key) == CVSS_TEMPORAL)      *groups |= CVSS_GROUP_TEMPORAL;
+        if (CVSS_CATEGORY(key) == CVSS_ENVIRONMENTAL) *groups |= CVSS_GROUP_ENVIRONMENTAL;
+    }
+    return true;
+}
+
+static bool cvss_batch_parse_v3(char *vector, uint8_t *codes, uint8_t *groups)
+{
+    bool seen[CVSS_SLOT_NUM] = { false };
+
+    char *saveptr = NULL;
+
+    for (char *comp = oscap_strtok_r(vector, "/", &saveptr); comp != NULL; comp = oscap_strtok_r(NULL, "/", &saveptr)) {
+        char *colon = strchr(comp, ':');
+        const struct cvss_v3_metric *m;
+        const char *letter;
+
+        if (colon == NULL || colon[1] == '\0' || colon[2] != '\0') return false;
+        *colon = '\0';
+        for (m = CVSS_V3_METRICS; m->name != NULL && strcmp(m->name, comp) != 0; ++m)
+            ;
+        if (m->name == NULL || seen[m->slot]) return false;
+        letter = strchr(m->values, colon[1]);
+        if (letter == NULL) return false;
+
+        seen[m->slot] = true;
+        codes[m->slot] = letter - m->values;
+        if (m->slot >= CVSS_SLOT_CR)     *groups |= CVSS_GROUP_ENVIRONMENTAL;
+        else if (m->slot >= CVSS_SLOT_E) *groups |= CVSS_GROUP_TEMPORAL;
+    }
+    return true;
+}
+
+bool cvss_batch_add_vector(struct cvss_batch *batch, const char *cvss_vector)
+{
+    assert(batch != NULL);
+
+    uint8_t codes[CVSS_SLOT_NUM] = { 0 };
+    uint8_t groups = 0;
+    enum cvss_version version = CVSS_VERSION_NONE;
+    char *vector;
+
+    if (!cvss_batch_reserve(batch)) return false;
+
+    vector = oscap_strdup(cvss_vector);
+    if (vector != NULL) {
+        if (strncmp(vector, "CVSS:3.0/", 9) == 0)
+            version = cvss_batch_parse_v3(vector + 9, codes, &groups) ? CVSS_VERSION_3_0 : CVSS_VERSION_NONE;
+        else if (strncmp(vector, "CVSS:3.1/", 9) == 0)
+            version = cvss_batch_parse_v3(vector + 9, codes, &groups) ? CVSS_VERSION_3_1 : CVSS_VERSION_NONE;
+        else
+            version = cvss_batch_parse_v2(vector, codes, &groups) ? CVSS_VERSION_2_0 : CVSS_VERSION_NONE;
+        free(vector);
+    }
+    if (version == CVSS_VERSION_NONE) {
+        memset(codes, 0, sizeof(codes));
+        groups = 0;
+    }
+
+    size_t i = batch->count++;
+    batch->version[i] = version;
+    batch->groups[i] = groups;
+    for (size_t slot = 0; slot < CVSS_SLOT_NUM; ++slot)
+        batch->metrics[slot][i] = codes[slot];
+    return version != CVSS_VERSION_NONE;
+}
+
+// the scores of version 2 computed like cvss_impact_*_score() do
+static void cvss_batch_scores_v2(const struct cvss_batch *batch, size_t i, float *base, float *temporal, float *environmental)
+{
+    const float (*w)[CVSS_CODE_NUM] = CVSS_V2_WEIGHTS;
+    uint8_t *const *m = batch->metrics;
+    float av = w[CVSS_SLOT_AV][m[CVSS_SLOT_AV][i]], ac = w[CVSS_SLOT_AC][m[CVSS_SLOT_AC][i]];
+    float au = w[CVSS_SLOT_AU][m[CVSS_SLOT_AU][i]];
+    float c = w[CVSS_SLOT_C][m[CVSS_SLOT_C][i]], in = w[CVSS_SLOT_I][m[CVSS_SLOT_I][i]];
+    float a = w[CVSS_SLOT_A][m[CVSS_SLOT_A][i]];
+    // not set base metrics weigh NAN
+    bool valid = !isnan(av + ac + au + c + in + a);
+
+    float exp_s = 20 * av * ac * au;
+    float imp_s = 10.41 * (1.0 - (1.0 - c) * (1.0 - in) * (1.0 - a));
+    float f_imp = (imp_s == 0.0 ? 0.0 : 1.176);
+    float base_s = valid ? cvss_round((0.6 * imp_s + 0.4 * exp_s - 1.5) * f_imp) : NAN;
+
+    float mult = w[CVSS_SLOT_E][m[CVSS_SLOT_E][i]] * w[CVSS_SLOT_RL][m[CVSS_SLOT_RL][i]] * w[CVSS_SLOT_RC][m[CVSS_SLOT_RC][i]];
+    bool has_temporal = batch->groups[i] & CVSS_GROUP_TEMPORAL;
+
+    *base = base_s;
+    *temporal = valid && has_temporal ? cvss_round(base_s * mult) : NAN;
+
+    if (!valid || !(batch->groups[i] & CVSS_GROUP_ENVIRONMENTAL)) {
+        *environmental = NAN;
+        return;
+    }
+    float ca = c * w[CVSS_SLOT_CR][m[CVSS_SLOT_CR][i]];
+    float ia = in * w[CVSS_SLOT_IR][m[CVSS_SLOT_IR][i]];
+    float aa = a * w[CVSS_SLOT_AR][m[CVSS_SLOT_AR][i]];
+    float adj_imp = 10.41 * (1.0 - (1.0 - ca) * (1.0 - ia) * (1.0 - aa));
+    if (adj_imp > 10.0) adj_imp = 10.0;
+    float f_adj = (adj_imp == 0.0 ? 0.0 : 1.176);
+    float adj_base = cvss_round((0.6 * adj_imp + 0.4 * exp_s - 1.5) * f_adj);
+    // temporal metrics which aren't given are Not Defined
+    float adj_temp = cvss_round(adj_base * (has_temporal ? mult : 1.0f));
+    *environmental = cvss_round((adj_temp + (10.0 - adj_temp) * w[CVSS_SLOT_CDP][m[CVSS_SLOT_CDP][i]]) * w[CVSS_SLOT_TD][m[CVSS_SLOT_TD][i]]);
+}
+
+// round up to one decimal place, v3.1 defines it free of floating point artifacts
+static inline double cvss_v3_roundup(double x, bool v31)
+{
+    if (!v31) return ceil(x * 10.0) / 10.0;
+
+    long int_input = lround(x * 100000.0);
+    if (int_input % 10000 == 0) return int_input / 100000.0;
+    return (floor(int_input / 10000.0) + 1) / 10.0;
+}
+
+static inline double cvss_pow13(double x)
+{
+    double x2 = x * x, x4 = x2 * x2, x8 = x4 * x4;
+    return x * x4 * x8;
+}
+
+static inline double cvss_pow15(double x)
+{
+    double x2 = x * x, x4 = x2 * x2, x8 = x4 * x4;
+    return x * x2 * x4 * x8;
+}
+
+// the scores of version 3.0 and 3.1 as defined by their specifications
+static void cvss_batch_scores_v3(const struct cvss_batch *batch, size_t i, float *base, float *temporal, float *environmental)
+{
+    uint8_t *const *m = batch->metrics;
+    bool v31 = batch->version[i] == CVSS_VERSION_3_1;
+
+    bool valid = m[CVSS_SLOT_AV][i] && m[CVSS_SLOT_AC][i] && m[CVSS_SLOT_PR][i] && m[CVSS_SLOT_UI][i] &&
+                 m[CVSS_SLOT_S][i] && m[CVSS_SLOT_C][i] && m[CVSS_SLOT_I][i] && m[CVSS_SLOT_A][i];
+    if (!valid) {
+        *base = *temporal = *environmental = NAN;
+        return;
+    }
+
+    bool changed = m[CVSS_SLOT_S][i] == CVSS_V3_SCOPE_CHANGED;
+    double iss = 1.0 - (1.0 - CVSS_V3_CIA[m[CVSS_SLOT_C][i]]) * (1.0 - CVSS_V3_CIA[m[CVSS_SLOT_I][i]]) * (1.0 - CVSS_V3_CIA[m[CVSS_SLOT_A][i]]);
+    double imp = changed ? 7.52 * (iss - 0.029) - 3.25 * cvss_pow15(iss - 0.02) : 6.42 * iss;
+    double expl = 8.22 * CVSS_V3_AV[m[CVSS_SLOT_AV][i]] * CVSS_V3_AC[m[CVSS_SLOT_AC][i]] *
+                  (changed ? CVSS_V3_PR_C : CVSS_V3_PR_U)[m[CVSS_SLOT_PR][i]] * CVSS_V3_UI[m[CVSS_SLOT_UI][i]];
+    double base_s = imp <= 0 ? 0.0 : cvss_v3_roundup(fmin((changed ? 1.08 : 1.0) * (imp + expl), 10.0), v31);
+    double mult = CVSS_V3_E[m[CVSS_SLOT_E][i]] * CVSS_V3_RL[m[CVSS_SLOT_RL][i]] * CVSS_V3_RC[m[CVSS_SLOT_RC][i]];
+
+    *base = base_s;
+    *temporal = batch->groups[i] & CVSS_GROUP_TEMPORAL ? cvss_v3_roundup(base_s * mult, v31) : NAN;
+
+    if (!(batch->groups[i] & CVSS_GROUP_ENVIRONMENTAL)) {
+        *environmental = NAN;
+        return;
+    }
+    // modified metrics which aren't given take the base value
+#define CVSS_V3_MOD(slot) (m[CVSS_SLOT_M##slot][i] ? m[CVSS_SLOT_M##slot][i] : m[CVSS_SLOT_##slot][i])
+    bool m_changed = CVSS_V3_MOD(S) == CVSS_V3_SCOPE_CHANGED;
+    double miss = 1.0 - (1.0 - CVSS_V3_REQ[m[CVSS_SLOT_CR][i]] * CVSS_V3_CIA[CVSS_V3_MOD(C)]) *
+                        (1.0 - CVSS_V3_REQ[m[CVSS_SLOT_IR][i]] * CVSS_V3_CIA[CVSS_V3_MOD(I)]) *
+                        (1.0 - CVSS_V3_REQ[m[CVSS_SLOT_AR][i]] * CVSS_V3_CIA[CVSS_V3_MOD(A)]);
+    miss = fmin(miss, 0.915);
+    double m_imp;
+    if (!m_changed)
+        m_imp = 6.42 * miss;
+    else if (v31)
+        m_imp = 7.52 * (miss - 0.029) - 3.25 * cvss_pow13(miss * 0.9731 - 0.02);
+    else
+        m_imp = 7.52 * (miss - 0.029) - 3.25 * cvss_pow15(miss - 0.02);
+    double m_expl = 8.22 * CVSS_V3_AV[CVSS_V3_MOD(AV)] * CVSS_V3_AC[CVSS_V3_MOD(AC)] *
+                    (m_changed ? CVSS_V3_PR_C : CVSS_V3_PR_U)[CVSS_V3_MOD(PR)] * CVSS_V3_UI[CVSS_V3_MOD(UI)];
+#undef CVSS_V3_MOD
+    *environmental = m_imp <= 0 ? 0.0 : cvss_v3_roundup(cvss_v3_roundup(fmin((m_changed ? 1.08 : 1.0) * (m_imp + m_expl), 10.0), v31) * mult, v31);
+}
+
+void cvss_batch_scores(const struct cvss_batch *batch, float *base, float *temporal, float *environmental)
+{
+    assert(batch != NULL);
+
+    for (size_t i = 0; i < batch->count; ++i) {
+        float b, t, e;
+
+        switch (batch->version[i]) {
+            case CVSS_VERSION_2_0: cvss_batch_scores_v2(batch, i, &b, &t, &e); break;
+            case CVSS_VERSION_3_0:
+            case CVSS_VERSION_3_1: cvss_batch_scores_v3(batch, i, &b, &t, &e); break;
+            default: b = t = e = NAN;
+        }
+        if (base)          base[i] = b;
+        if (temporal)      temporal[i] = t;
+        if (environmental) environmental[i] = e;
+    }
+}
@@ -97,6 +97,11 @@ struct cvss_metrics {
     } metrics;
 };
 
+// lookup a vector component such as "AV:N", CVSS_KEY_NONE if there is no such one
+enum cvss_key cvss_key_from_vector(const char *component, unsigned *value);
+// weight of the value of a component, NAN if it isn't set
+float cvss_key_weight(enum cvss_key key, unsigned value);
+
 struct cvss_impact *cvss_impact_new_from_xml(xmlTextReaderPtr reader);
 bool cvss_impact_export(const struct cvss_impact *imp, xmlTextWriterPtr writer);
 struct cvss_metrics *cvss_metrics_new_from_xml(xmlTextReaderPtr reader);
@@ -413,5 +413,60 @@ OSCAP_API bool cvss_metrics_set_availability_requirement(struct cvss_metrics* me
 
 /** @} */
 
+/// CVSS version of a vector
+enum cvss_version {
+    CVSS_VERSION_NONE, ///< the vector couldn't be parsed
+    CVSS_VERSION_2_0,
+    CVSS_VERSION_3_0,
+    CVSS_VERSION_3_1
+};
+
+/**
+ * @struct cvss_batch
+ * CVSS vectors scored together
+ *
+ * Holds the parsed metrics of many vectors in packed arrays, so scoring
+ * a whole feed is done without a cvss_impact for every vector.
+ */
+struct cvss_batch;
+
+/// @memberof cvss_batch
+OSCAP_API struct cvss_batch *cvss_batch_new(void);
+/// @memberof cvss_batch
+OSCAP_API void cvss_batch_free(struct cvss_batch *batch);
+
+/**
+ * Parse a vector and add it to the batch.
+ *
+ * Version 2 vectors are accepted in the form cvss_impact_new_from_vector()
+ * takes, version 3.x vectors have to start with "CVSS:3.0/" or "CVSS:3.1/".
+ * A vector which can't be parsed is added as well, with version
+ * CVSS_VERSION_NONE and all of its scores NAN, so the scores keep the
+ * order of the added vectors.
+ * @return false if the vector couldn't be parsed or added
+ * @memberof cvss_batch
+ */
+OSCAP_API bool cvss_batch_add_vector(struct cvss_batch *batch, const char *cvss_vector);
+
+/// @memberof cvss_batch
+OSCAP_API size_t cvss_batch_get_count(const struct cvss_batch *batch);
+
+/// Get version of the i-th vector of the batch
+/// @memberof cvss_batch
+OSCAP_API enum cvss_version cvss_batch_get_version(const struct cvss_batch *batch, size_t i);
+
+/**
+ * Calculate base, temporal and environmental scores of all the vectors.
+ *
+ * Each array has to hold cvss_batch_get_count() scores, any of them may be
+ * NULL if those scores aren't needed. A score is NAN if the vector lacks
+ * some base metric or has no metrics of that group. Version 2 scores are
+ * the ones of cvss_impact_base_score(), cvss_impact_temporal_score() and
+ * cvss_impact_environmental_score(), with temporal metrics which aren't
+ * given treated as Not Defined.
+ * @memberof cvss_batch
+ */
+OSCAP_API void cvss_batch_scores(const struct cvss_batch *batch, float *base, float *temporal, float *environmental);
+
 /**@}*/
 #endif // _CVSSCALC_H_
@@ -81,6 +81,11 @@ struct rds_index *ds_rds_session_get_rds_idx(struct ds_rds_session *session)
 	return session->index;
 }
 
+struct oscap_source *ds_rds_session_get_source(struct ds_rds_session *session)
+{
+	return session->source;
+}
+
 xmlDoc *ds_rds_session_get_xmlDoc(struct ds_rds_session *session)
 {
 	return oscap_source_get_xmlDoc(session->source);
@@ -33,6 +33,7 @@
 #include "DS/public/ds_rds_session.h"
 
 
+struct oscap_source *ds_rds_session_get_source(struct ds_rds_session *session);
 xmlDoc *ds_rds_session_get_xmlDoc(struct ds_rds_session *session);
 const char *ds_rds_session_get_target_dir(struct ds_rds_session *session);
 int ds_rds_session_register_component_source(struct ds_rds_session *session, const char *content_id, struct oscap_source *component);
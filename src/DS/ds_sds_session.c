@@ -46,6 +46,8 @@
 struct ds_sds_session {
 	struct oscap_source *source;            ///< Source DataStream raw representation
 	struct ds_sds_index *index;             ///< Source DataStream index
+	struct ds_sds_component_index *components; ///< Byte ranges of the components, NULL if not indexed
+	bool components_indexed;                ///< Indexing of the components was attempted
 	char *temp_dir;                         ///< Temp directory managed by the session
 	const char *target_dir;                 ///< Target directory for current split
 	const char *datastream_id;              ///< ID of selected datastream
@@ -84,6 +86,7 @@ void ds_sds_session_free(struct ds_sds_session *sds_session)
 {
 	if (sds_session != NULL) {
 		ds_sds_index_free(sds_session->index);
+		ds_sds_component_index_free(sds_session->components);
 		if (sds_session->temp_dir != NULL) {
 			oscap_acquire_cleanup_dir(&(sds_session->temp_dir));
 		}
@@ -251,7 +254,7 @@ struct oscap_source *ds_sds_session_select_tailoring(struct ds_sds_session *sess
 
 xmlNode *ds_sds_session_get_selected_datastream(struct ds_sds_session *session)
 {
-	xmlDoc *doc = oscap_source_get_xmlDoc(session->source);
+	xmlDoc *doc = ds_sds_session_get_xmlDoc(session);
 	xmlNode *datastream = ds_sds_lookup_datastream_in_collection(doc, session->datastream_id);
 	if (datastream == NULL) {
 		char *error = session->datastream_id ?
@@ -263,11 +266,36 @@ xmlNode *ds_sds_session_get_selected_datastream(struct ds_sds_session *session)
 	return datastream;
 }
 
+static struct ds_sds_component_index *ds_sds_session_get_component_index(struct ds_sds_session *session)
+{
+	if (!session->components_indexed) {
+		session->components_indexed = true;
+		const char *memory;
+		size_t size;
+		if (oscap_source_get_memory(session->source, &memory, &size) == 0)
+			session->components = ds_sds_component_index_parse(memory, size, oscap_source_readable_origin(session->source),
+				oscap_source_get_dict(session->source));
+	}
+	return session->components;
+}
+
 xmlDoc *ds_sds_session_get_xmlDoc(struct ds_sds_session *session)
 {
+	// Components are left empty, they are parsed one by one when registered
+	struct ds_sds_component_index *components = ds_sds_session_get_component_index(session);
+	if (components != NULL)
+		return ds_sds_component_index_get_xmlDoc(components);
 	return oscap_source_get_xmlDoc(session->source);
 }
 
+xmlDoc *ds_sds_session_parse_component(struct ds_sds_session *session, const char *component_id)
+{
+	struct ds_sds_component_index *components = ds_sds_session_get_component_index(session);
+	if (components == NULL)
+		return NULL;
+	return ds_sds_component_index_parse_component(components, component_id);
+}
+
 int ds_sds_session_register_component_source(struct ds_sds_session *session, const char *relative_filepath, struct oscap_source *component)
 {
 	if (!oscap_htable_add(session->component_sources, relative_filepath, component)) {
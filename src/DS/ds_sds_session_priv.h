@@ -33,7 +33,17 @@
 
 
 xmlNode *ds_sds_session_get_selected_datastream(struct ds_sds_session *session);
+/**
+ * Get DOM of the Source DataStream. The components may be left empty in it,
+ * use ds_sds_session_parse_component to get their content.
+ */
 xmlDoc *ds_sds_session_get_xmlDoc(struct ds_sds_session *session);
+/**
+ * Parse the single component from the Source DataStream.
+ * @returns document owned by the caller or NULL if the components are
+ * not indexed and the DOM of the whole Source DataStream is to be used
+ */
+xmlDoc *ds_sds_session_parse_component(struct ds_sds_session *session, const char *component_id);
 int ds_sds_session_register_component_source(struct ds_sds_session *session, const char *relative_filepath, struct oscap_source *component);
 const char *ds_sds_session_get_target_dir(struct ds_sds_session *session);
 struct oscap_htable *ds_sds_session_get_component_sources(struct ds_sds_session *session);
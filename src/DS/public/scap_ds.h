@@ -95,6 +95,33 @@ OSCAP_API int ds_sds_compose_add_component(const char *target_datastream, const
 OSCAP_API int ds_rds_create(const char* sds_file, const char* xccdf_result_file,
         const char** oval_result_files, const char* target_file);
 
+/**
+ * @brief takes a result data stream referencing its source data stream by digest and embeds the source data stream
+ *
+ * ARF written by XCCDF session with @ref xccdf_session_set_arf_sds_reference
+ * holds only the path and SHA-256 digest of the source data stream (and of
+ * the tailoring file) in its report-request. This makes the complete ARF
+ * out of it. The referenced files must not have changed since the scan.
+ *
+ * @param arf_file
+ *      Path to the result data stream referencing the source data stream
+ *
+ * @param sds_file
+ *      Path to the source data stream, NULL to use the path recorded in the ARF
+ *
+ * @param tailoring_file
+ *      Path to the tailoring file, NULL to use the path recorded in the ARF
+ *
+ * @param target_file
+ *      Path to the file where the complete result data stream will be stored
+ *
+ * @returns
+ * 	    0 if no errors were encountered
+ * 	   -1 in case of errors
+ */
+OSCAP_API int ds_rds_inflate(const char *arf_file, const char *sds_file,
+        const char *tailoring_file, const char *target_file);
+
 /**
  * @struct ds_stream_index
  *
@@ -167,6 +194,15 @@ OSCAP_API struct oscap_string_iterator* ds_stream_index_get_dictionaries(struct
  */
 OSCAP_API struct oscap_string_iterator* ds_stream_index_get_extended_components(struct ds_stream_index* s);
 
+/**
+ * @brief retrieves ID of the component which given component-ref points to
+ *
+ * @returns the component ID or NULL if the component-ref doesn't point to
+ * a component inside of the same collection
+ * @memberof ds_stream_index
+ */
+OSCAP_API const char *ds_stream_index_get_component_id(struct ds_stream_index* s, const char *component_ref_id);
+
 /**
  * @struct ds_sds_index
  *
@@ -199,6 +235,30 @@ OSCAP_API struct ds_stream_index* ds_sds_index_get_stream(struct ds_sds_index* s
  */
 OSCAP_API struct ds_stream_index_iterator* ds_sds_index_get_streams(struct ds_sds_index* s);
 
+/**
+ * @brief retrieves IDs of the XCCDF profiles in a component
+ *
+ * The profiles of the Benchmark or Tailoring in each component are recorded
+ * when the collection is indexed, so they can be listed without importing
+ * the XCCDF model.
+ *
+ * @returns iterator over the profile IDs in document order or NULL if the
+ * component contains neither Benchmark nor Tailoring
+ * @memberof ds_sds_index
+ */
+OSCAP_API struct oscap_string_iterator *ds_sds_index_get_profiles(struct ds_sds_index* s, const char *component_id);
+
+/**
+ * @brief retrieves title of an XCCDF profile in a component
+ *
+ * The title in the default language is preferred, as with
+ * oscap_textlist_get_preferred_plaintext.
+ *
+ * @returns the title or NULL if the profile has none
+ * @memberof ds_sds_index
+ */
+OSCAP_API const char *ds_sds_index_get_profile_title(struct ds_sds_index* s, const char *component_id, const char *profile_id);
+
 /**
  * @brief chooses datastream and checklist id combination given the IDs
  *
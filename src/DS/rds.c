@@ -40,15 +40,24 @@
 #include "sds_priv.h"
 #include "source/public/oscap_source.h"
 #include "source/oscap_source_priv.h"
+#include "source/compress_priv.h"
 
 #include <sys/stat.h>
 #include <time.h>
 #include <string.h>
+#ifdef OS_WINDOWS
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 #include <libxml/parser.h>
 #include <libxml/tree.h>
+#include <libxml/xmlreader.h>
+#include <libxml/xmlwriter.h>
 #include <libxml/xpath.h>
 #include <libxml/xpathInternals.h>
+#include <openssl/evp.h>
 #include "oscap_helpers.h"
 
 static const char* arf_ns_uri = "http://scap.nist.gov/schema/asset-reporting-format/1.1";
@@ -56,6 +65,9 @@ static const char* core_ns_uri = "http://scap.nist.gov/schema/reporting-core/1.1
 static const char* arfvocab_ns_uri = "http://scap.nist.gov/specifications/arf/vocabulary/relationships/1.0#";
 static const char* ai_ns_uri = "http://scap.nist.gov/schema/asset-identification/1.1";
 static const char* xlink_ns_uri = "http://www.w3.org/1999/xlink";
+static const char* ovalres_ns_uri = "http://oval.mitre.org/XMLSchema/oval-results-5";
+static const char* ovalsys_ns_uri = "http://oval.mitre.org/XMLSchema/oval-system-characteristics-5";
+static const char* sds_ref_ns_uri = "http://open-scap.org/page/ARF_SDS_reference";
 
 
 xmlNode *ds_rds_lookup_container(xmlDocPtr doc, const char *container_name)
@@ -132,19 +144,78 @@ static xmlNodePtr ds_rds_get_inner_content(xmlDocPtr doc, xmlNodePtr parent_node
 	return content_node;
 }
 
+/*
+ * Find the component with a reader, so that the DOM of the whole result
+ * data stream isn't built. Only the subtree of the component is expanded,
+ * the reader skips the other components. The component is valid until the
+ * reader is freed.
+ */
+static xmlNodePtr ds_rds_stream_component(xmlTextReaderPtr reader, const char *container_name, const char *component_name, const char *id)
+{
+	int ret = xmlTextReaderRead(reader);
+	while (ret == 1 && xmlTextReaderNodeType(reader) != XML_READER_TYPE_ELEMENT)
+		ret = xmlTextReaderRead(reader);
+	if (ret != 1 || xmlTextReaderIsEmptyElement(reader))
+		return NULL;
+
+	// the first container of the name is a child of the root, like in ds_rds_lookup_container
+	int depth = 1;
+	ret = xmlTextReaderRead(reader);
+	while (ret == 1 && xmlTextReaderDepth(reader) >= depth) {
+		if (xmlTextReaderNodeType(reader) != XML_READER_TYPE_ELEMENT || xmlTextReaderDepth(reader) != depth) {
+			ret = xmlTextReaderRead(reader);
+			continue;
+		}
+		const char *name = (const char *) xmlTextReaderConstLocalName(reader);
+		if (depth == 1 && oscap_streq(name, container_name)) {
+			if (xmlTextReaderIsEmptyElement(reader))
+				return NULL;
+			depth = 2;
+			ret = xmlTextReaderRead(reader);
+			continue;
+		}
+		if (depth == 2 && oscap_streq(name, component_name)) {
+			char *candidate_id = (char *) xmlTextReaderGetAttribute(reader, BAD_CAST "id");
+			bool found = oscap_streq(candidate_id, id);
+			xmlFree(candidate_id);
+			if (found)
+				return xmlTextReaderExpand(reader);
+		}
+		ret = xmlTextReaderNext(reader);
+	}
+	return NULL;
+}
+
 int ds_rds_dump_arf_content(struct ds_rds_session *session, const char *container_name, const char *component_name, const char *content_id)
 {
-	xmlDoc *doc = ds_rds_session_get_xmlDoc(session);
-	xmlNodePtr parent_node = ds_rds_lookup_component(doc, container_name, component_name, content_id);
+	struct oscap_source *rds_source = ds_rds_session_get_source(session);
+	xmlTextReader *reader = NULL;
+	xmlNodePtr parent_node;
+	const char *memory;
+	size_t size;
+
+	// Until the DOM is built (and possibly changed) the component is read
+	// right from the file
+	if (oscap_source_get_memory(rds_source, &memory, &size) == 0) {
+		reader = oscap_source_get_xmlTextReader(rds_source);
+		if (reader == NULL)
+			return -1;
+		parent_node = ds_rds_stream_component(reader, container_name, component_name, content_id);
+	} else {
+		parent_node = ds_rds_lookup_component(ds_rds_session_get_xmlDoc(session), container_name, component_name, content_id);
+	}
 	if (!parent_node) {
 		oscap_seterr(OSCAP_EFAMILY_OSCAP, "Could not find any %s of id '%s'", component_name, content_id);
+		xmlFreeTextReader(reader);
 		return -1;
 	}
 
 	xmlNodePtr content_node = ds_rds_get_inner_content(NULL, parent_node);
 
-	if (!content_node)
+	if (!content_node) {
+		xmlFreeTextReader(reader);
 		return -1;
+	}
 
 	xmlNodePtr candidate = content_node->children;
 	xmlNodePtr inner_root = NULL;
@@ -164,12 +235,14 @@ int ds_rds_dump_arf_content(struct ds_rds_session *session, const char *containe
 	if (inner_root == NULL) {
 		oscap_seterr(OSCAP_EFAMILY_XML, "Could not found any child inside 'arf:content' node when looking for %s.",
 				content_id);
+		xmlFreeTextReader(reader);
 		return -1;
 	}
 
 	// We assume that arf:content is XML. This is reasonable because both
 	// reports and report requests are XML documents.
-	xmlDoc *new_doc = ds_doc_from_foreign_node(inner_root, ds_rds_session_get_xmlDoc(session));
+	xmlDoc *new_doc = ds_doc_from_foreign_node(inner_root, inner_root->doc);
+	xmlFreeTextReader(reader);
 	char *target_file = oscap_sprintf("%s/%s.xml", ds_rds_session_get_target_dir(session), component_name);
 	struct oscap_source *source = oscap_source_new_from_xmlDoc(new_doc, target_file);
 	free(target_file);
@@ -186,6 +259,11 @@ xmlNodePtr ds_rds_create_report(xmlDocPtr target_doc, xmlNodePtr reports_node, x
 	xmlNodePtr report_content = xmlNewNode(arf_ns, BAD_CAST "content");
 	xmlAddChild(report, report_content);
 
+	if (source_doc == NULL) {
+		xmlAddChild(reports_node, report);
+		return report;
+	}
+
 	xmlDOMWrapCtxtPtr wrap_ctxt = xmlDOMWrapNewCtxt();
 	xmlNodePtr res_node = NULL;
 	xmlDOMWrapCloneNode(wrap_ctxt, source_doc, xmlDocGetRootElement(source_doc),
@@ -661,13 +739,95 @@ static void ds_rds_add_xccdf_test_results(xmlDocPtr doc, xmlNodePtr reports,
 	}
 }
 
+/*
+ * OVAL results report which is not copied into the ARF document, its
+ * content is serialized straight from the OVAL results document.
+ */
+struct ds_rds_deferred_report {
+	xmlNodePtr content;
+	xmlDocPtr doc;
+};
+
+/*
+ * Add the tailoring document to the data stream collection as a new component
+ * referenced from the checklists of the first data stream.
+ */
+static int ds_rds_add_tailoring(xmlDocPtr doc, xmlNodePtr sds_res_node, xmlDocPtr tailoring_doc,
+		const char *tailoring_filepath, const char *tailoring_doc_timestamp)
+{
+	char *mangled_tailoring_filepath = ds_sds_mangle_filepath(tailoring_filepath);
+	char *tailoring_component_id = oscap_sprintf("scap_org.open-scap_comp_%s_tailoring", mangled_tailoring_filepath);
+	char *tailoring_component_ref_id = oscap_sprintf("scap_org.open-scap_cref_%s_tailoring", mangled_tailoring_filepath);
+
+	// Need unique id (ref_id) - if generated already exists, then create new one
+	int counter = 0;
+	while (lookup_component_in_collection(sds_res_node, tailoring_component_id) != NULL) {
+		free(tailoring_component_id);
+		tailoring_component_id = oscap_sprintf("scap_org.open-scap_comp_%s_tailoring%03d", mangled_tailoring_filepath, counter++);
+	}
+
+	counter = 0;
+	while (ds_sds_find_component_ref(xmlDocGetRootElement((xmlDocPtr) sds_res_node)->children, tailoring_component_ref_id) != NULL) {
+		free(tailoring_component_ref_id);
+		tailoring_component_ref_id = oscap_sprintf("scap_org.open-scap_cref_%s_tailoring%03d", mangled_tailoring_filepath, counter++);
+	}
+
+	free(mangled_tailoring_filepath);
+
+	xmlDOMWrapCtxtPtr tailoring_wrap_ctxt = xmlDOMWrapNewCtxt();
+	xmlNodePtr tailoring_res_node = NULL;
+	xmlDOMWrapCloneNode(tailoring_wrap_ctxt, tailoring_doc, xmlDocGetRootElement(tailoring_doc),
+			&tailoring_res_node, doc, NULL, 1, 0);
+	xmlNsPtr sds_ns = sds_res_node->ns;
+	xmlNodePtr tailoring_component = xmlNewNode(sds_ns, BAD_CAST "component");
+	xmlSetProp(tailoring_component, BAD_CAST "id", BAD_CAST tailoring_component_id);
+	xmlSetProp(tailoring_component, BAD_CAST "timestamp", BAD_CAST tailoring_doc_timestamp);
+	xmlAddChild(tailoring_component, tailoring_res_node);
+	xmlAddChild(sds_res_node, tailoring_component);
+
+	xmlNodePtr checklists_element = NULL;
+	xmlNodePtr datastream_element = node_get_child_element(sds_res_node, "data-stream");
+	if (datastream_element == NULL) {
+		datastream_element = xmlNewNode(sds_ns, BAD_CAST "data-stream");
+		xmlAddChild(sds_res_node, datastream_element);
+		checklists_element = xmlNewNode(sds_ns, BAD_CAST "checklists");
+		xmlAddChild(datastream_element, checklists_element);
+	}
+	else {
+		checklists_element = node_get_child_element(datastream_element, "checklists");
+	}
+
+	xmlNodePtr tailoring_component_ref = xmlNewNode(sds_ns, BAD_CAST "component-ref");
+	xmlSetProp(tailoring_component_ref, BAD_CAST "id", BAD_CAST tailoring_component_ref_id);
+	free(tailoring_component_ref_id);
+	xmlNsPtr xlink_ns = xmlSearchNsByHref(doc, sds_res_node, BAD_CAST xlink_ns_uri);
+	if (!xlink_ns) {
+		oscap_seterr(OSCAP_EFAMILY_XML,
+				"Unable to find namespace '%s' in the XML DOM tree. "
+				"This is most likely an internal error!.",
+				xlink_ns_uri);
+		free(tailoring_component_id);
+		return -1;
+	}
+	char *tailoring_cref_href = oscap_sprintf("#%s", tailoring_component_id);
+	free(tailoring_component_id);
+	xmlSetNsProp(tailoring_component_ref, xlink_ns, BAD_CAST "href", BAD_CAST tailoring_cref_href);
+	free(tailoring_cref_href);
+	xmlAddChild(checklists_element, tailoring_component_ref);
+
+	xmlDOMWrapReconcileNamespaces(tailoring_wrap_ctxt, tailoring_res_node, 0);
+	xmlDOMWrapFreeCtxt(tailoring_wrap_ctxt);
+	return 0;
+}
+
 static int _ds_rds_create_from_dom(xmlDocPtr *ret, xmlDocPtr sds_doc,
 		xmlDocPtr tailoring_doc, const char *tailoring_filepath,
 		char *tailoring_doc_timestamp, xmlDocPtr xccdf_result_file_doc,
 		struct oscap_htable *oval_result_sources,
 		struct oscap_htable *oval_result_mapping,
 		struct oscap_htable *arf_report_mapping,
-		bool clone)
+		const struct ds_rds_sds_reference *sds_reference,
+		bool clone, struct oscap_list *deferred_reports)
 {
 	*ret = NULL;
 
@@ -694,88 +854,45 @@ static int _ds_rds_create_from_dom(xmlDocPtr *ret, xmlDocPtr sds_doc,
 	xmlNodePtr report_request = xmlNewNode(arf_ns, BAD_CAST "report-request");
 	xmlSetProp(report_request, BAD_CAST "id", BAD_CAST "collection1");
 
-	xmlNodePtr arf_content = xmlNewNode(arf_ns, BAD_CAST "content");
-
-	xmlDOMWrapCtxtPtr sds_wrap_ctxt = xmlDOMWrapNewCtxt();
-	xmlNodePtr sds_res_node = NULL;
-	if (clone) {
-		xmlDOMWrapCloneNode(sds_wrap_ctxt, sds_doc, xmlDocGetRootElement(sds_doc),
-				&sds_res_node, doc, NULL, 1, 0);
-	} else {
-		sds_res_node = xmlDocGetRootElement(sds_doc);
-		xmlDOMWrapAdoptNode(sds_wrap_ctxt, sds_doc, sds_res_node, doc, NULL, 0);
-	}
-	xmlAddChild(arf_content, sds_res_node);
-	xmlDOMWrapReconcileNamespaces(sds_wrap_ctxt, sds_res_node, 0);
-	xmlDOMWrapFreeCtxt(sds_wrap_ctxt);
-
-	if (tailoring_doc && strcmp(tailoring_filepath, "NONEXISTENT")) {
-		char *mangled_tailoring_filepath = ds_sds_mangle_filepath(tailoring_filepath);
-		char *tailoring_component_id = oscap_sprintf("scap_org.open-scap_comp_%s_tailoring", mangled_tailoring_filepath);
-		char *tailoring_component_ref_id = oscap_sprintf("scap_org.open-scap_cref_%s_tailoring", mangled_tailoring_filepath);
-
-		// Need unique id (ref_id) - if generated already exists, then create new one
-		int counter = 0;
-		while (lookup_component_in_collection(sds_res_node, tailoring_component_id) != NULL) {
-			free(tailoring_component_id);
-			tailoring_component_id = oscap_sprintf("scap_org.open-scap_comp_%s_tailoring%03d", mangled_tailoring_filepath, counter++);
+	if (sds_reference != NULL) {
+		/* Only the reference to the data stream, see ds_rds_inflate */
+		xmlNodePtr remote_resource = xmlNewNode(arf_ns, BAD_CAST "remote-resource");
+		xmlNsPtr xlink_ns = xmlNewNs(remote_resource, BAD_CAST xlink_ns_uri, BAD_CAST "xlink");
+		xmlNsPtr ref_ns = xmlNewNs(remote_resource, BAD_CAST sds_ref_ns_uri, BAD_CAST "sds-ref");
+		xmlSetNsProp(remote_resource, xlink_ns, BAD_CAST "type", BAD_CAST "simple");
+		xmlSetNsProp(remote_resource, xlink_ns, BAD_CAST "href", BAD_CAST sds_reference->href);
+		xmlSetNsProp(remote_resource, ref_ns, BAD_CAST "digest-algorithm", BAD_CAST "sha256");
+		xmlSetNsProp(remote_resource, ref_ns, BAD_CAST "digest", BAD_CAST sds_reference->digest);
+		if (sds_reference->tailoring_href != NULL) {
+			xmlSetNsProp(remote_resource, ref_ns, BAD_CAST "tailoring-href", BAD_CAST sds_reference->tailoring_href);
+			xmlSetNsProp(remote_resource, ref_ns, BAD_CAST "tailoring-digest", BAD_CAST sds_reference->tailoring_digest);
+			if (sds_reference->tailoring_timestamp != NULL)
+				xmlSetNsProp(remote_resource, ref_ns, BAD_CAST "tailoring-timestamp", BAD_CAST sds_reference->tailoring_timestamp);
 		}
-
-		counter = 0;
-		while (ds_sds_find_component_ref(xmlDocGetRootElement((xmlDocPtr) sds_res_node)->children, tailoring_component_ref_id) != NULL) {
-			free(tailoring_component_ref_id);
-			tailoring_component_ref_id = oscap_sprintf("scap_org.open-scap_cref_%s_tailoring%03d", mangled_tailoring_filepath, counter++);
-		}
-
-		free(mangled_tailoring_filepath);
-
-		xmlDOMWrapCtxtPtr tailoring_wrap_ctxt = xmlDOMWrapNewCtxt();
-		xmlNodePtr tailoring_res_node = NULL;
-		xmlDOMWrapCloneNode(tailoring_wrap_ctxt, tailoring_doc, xmlDocGetRootElement(tailoring_doc),
-				&tailoring_res_node, doc, NULL, 1, 0);
-		xmlNsPtr sds_ns = sds_res_node->ns;
-		xmlNodePtr tailoring_component = xmlNewNode(sds_ns, BAD_CAST "component");
-		xmlSetProp(tailoring_component, BAD_CAST "id", BAD_CAST tailoring_component_id);
-		xmlSetProp(tailoring_component, BAD_CAST "timestamp", BAD_CAST tailoring_doc_timestamp);
-		xmlAddChild(tailoring_component, tailoring_res_node);
-		xmlAddChild(sds_res_node, tailoring_component);
-
-		xmlNodePtr checklists_element = NULL;
-		xmlNodePtr datastream_element = node_get_child_element(sds_res_node, "data-stream");
-		if (datastream_element == NULL) {
-			datastream_element = xmlNewNode(sds_ns, BAD_CAST "data-stream");
-			xmlAddChild(sds_res_node, datastream_element);
-			checklists_element = xmlNewNode(sds_ns, BAD_CAST "checklists");
-			xmlAddChild(datastream_element, checklists_element);
-		}
-		else {
-			checklists_element = node_get_child_element(datastream_element, "checklists");
+		xmlAddChild(report_request, remote_resource);
+	} else {
+		xmlNodePtr arf_content = xmlNewNode(arf_ns, BAD_CAST "content");
+
+		xmlDOMWrapCtxtPtr sds_wrap_ctxt = xmlDOMWrapNewCtxt();
+		xmlNodePtr sds_res_node = NULL;
+		if (clone) {
+			xmlDOMWrapCloneNode(sds_wrap_ctxt, sds_doc, xmlDocGetRootElement(sds_doc),
+					&sds_res_node, doc, NULL, 1, 0);
+		} else {
+			sds_res_node = xmlDocGetRootElement(sds_doc);
+			xmlDOMWrapAdoptNode(sds_wrap_ctxt, sds_doc, sds_res_node, doc, NULL, 0);
 		}
+		xmlAddChild(arf_content, sds_res_node);
+		xmlDOMWrapReconcileNamespaces(sds_wrap_ctxt, sds_res_node, 0);
+		xmlDOMWrapFreeCtxt(sds_wrap_ctxt);
 
-		xmlNodePtr tailoring_component_ref = xmlNewNode(sds_ns, BAD_CAST "component-ref");
-		xmlSetProp(tailoring_component_ref, BAD_CAST "id", BAD_CAST tailoring_component_ref_id);
-		free(tailoring_component_ref_id);
-		xmlNsPtr xlink_ns = xmlSearchNsByHref(doc, sds_res_node, BAD_CAST xlink_ns_uri);
-		if (!xlink_ns) {
-			oscap_seterr(OSCAP_EFAMILY_XML,
-					"Unable to find namespace '%s' in the XML DOM tree. "
-					"This is most likely an internal error!.",
-					xlink_ns_uri);
-			free(tailoring_component_id);
-			return -1;
+		if (tailoring_doc && strcmp(tailoring_filepath, "NONEXISTENT")) {
+			if (ds_rds_add_tailoring(doc, sds_res_node, tailoring_doc, tailoring_filepath, tailoring_doc_timestamp) != 0)
+				return -1;
 		}
-		char *tailoring_cref_href = oscap_sprintf("#%s", tailoring_component_id);
-		free(tailoring_component_id);
-		xmlSetNsProp(tailoring_component_ref, xlink_ns, BAD_CAST "href", BAD_CAST tailoring_cref_href);
-		free(tailoring_cref_href);
-		xmlAddChild(checklists_element, tailoring_component_ref);
 
-		xmlDOMWrapReconcileNamespaces(tailoring_wrap_ctxt, tailoring_res_node, 0);
-		xmlDOMWrapFreeCtxt(tailoring_wrap_ctxt);
+		xmlAddChild(report_request, arf_content);
 	}
-
-	xmlAddChild(report_request, arf_content);
-
 	xmlAddChild(report_requests, report_request);
 
 	xmlNodePtr reports = xmlNewNode(arf_ns, BAD_CAST "reports");
@@ -792,7 +909,15 @@ static int _ds_rds_create_from_dom(xmlDocPtr *ret, xmlDocPtr sds_doc,
 		struct oscap_source *oval_source = oscap_htable_get(oval_result_sources, report_file);
 		xmlDoc *oval_result_doc = oscap_source_get_xmlDoc(oval_source);
 
-		ds_rds_create_report(doc, reports, oval_result_doc, report_id);
+		if (deferred_reports != NULL) {
+			xmlNodePtr report = ds_rds_create_report(doc, reports, NULL, report_id);
+			struct ds_rds_deferred_report *deferred = malloc(sizeof(struct ds_rds_deferred_report));
+			deferred->content = report->children;
+			deferred->doc = oval_result_doc;
+			oscap_list_add(deferred_reports, deferred);
+		} else {
+			ds_rds_create_report(doc, reports, oval_result_doc, report_id);
+		}
 	}
 	oscap_htable_iterator_free(hit);
 
@@ -812,7 +937,7 @@ int ds_rds_create_from_dom(xmlDocPtr *ret, xmlDocPtr sds_doc,
 	return _ds_rds_create_from_dom(ret, sds_doc, tailoring_doc,
 			tailoring_filepath, tailoring_doc_timestamp,
 			xccdf_result_file_doc, oval_result_sources, oval_result_mapping,
-			arf_report_mapping, false);
+			arf_report_mapping, NULL, false, NULL);
 }
 
 static int ds_rds_create_from_dom_clone(xmlDocPtr *ret, xmlDocPtr sds_doc,
@@ -825,7 +950,213 @@ static int ds_rds_create_from_dom_clone(xmlDocPtr *ret, xmlDocPtr sds_doc,
 	return _ds_rds_create_from_dom(ret, sds_doc, tailoring_doc,
 			tailoring_filepath, tailoring_doc_timestamp,
 			xccdf_result_file_doc, oval_result_sources, oval_result_mapping,
-			arf_report_mapping, true);
+			arf_report_mapping, NULL, true, NULL);
+}
+
+static bool ds_rds_node_holds_deferred(xmlNodePtr node, struct oscap_list *deferred_reports)
+{
+	bool res = false;
+	struct oscap_iterator *it = oscap_iterator_new(deferred_reports);
+	while (!res && oscap_iterator_has_more(it)) {
+		struct ds_rds_deferred_report *deferred = oscap_iterator_next(it);
+		for (xmlNodePtr cur = deferred->content; cur != NULL && !res; cur = cur->parent)
+			res = (cur == node);
+	}
+	oscap_iterator_free(it);
+	return res;
+}
+
+static xmlDocPtr ds_rds_deferred_doc(xmlNodePtr node, struct oscap_list *deferred_reports)
+{
+	xmlDocPtr doc = NULL;
+	struct oscap_iterator *it = oscap_iterator_new(deferred_reports);
+	while (doc == NULL && oscap_iterator_has_more(it)) {
+		struct ds_rds_deferred_report *deferred = oscap_iterator_next(it);
+		if (deferred->content == node)
+			doc = deferred->doc;
+	}
+	oscap_iterator_free(it);
+	return doc;
+}
+
+static char *ds_rds_qname(xmlNsPtr ns, const xmlChar *name)
+{
+	if (ns != NULL && ns->prefix != NULL)
+		return oscap_sprintf("%s:%s", (const char *) ns->prefix, (const char *) name);
+	return oscap_strdup((const char *) name);
+}
+
+/*
+ * Serialize the node into the writer. Subtrees of the ARF document are
+ * dumped as they are, the elements leading to the deferred reports are
+ * written by the text writer and the deferred reports are dumped straight
+ * from the OVAL results documents.
+ */
+static int ds_rds_write_node(xmlTextWriterPtr writer, xmlOutputBufferPtr out, xmlDocPtr doc,
+		xmlNodePtr node, int level, struct oscap_list *deferred_reports)
+{
+	if (!ds_rds_node_holds_deferred(node, deferred_reports)) {
+		/* Close a pending start tag and pass the writer's data on before dumping */
+		if (xmlTextWriterWriteRaw(writer, BAD_CAST "") < 0 || xmlTextWriterFlush(writer) < 0)
+			return -1;
+		xmlNodeDumpOutput(out, doc, node, level, 1, "UTF-8");
+		return out->error == 0 ? 0 : -1;
+	}
+
+	char *qname = ds_rds_qname(node->ns, node->name);
+	int ret = xmlTextWriterStartElement(writer, BAD_CAST qname);
+	free(qname);
+	if (ret < 0)
+		return -1;
+
+	for (xmlNsPtr ns = node->nsDef; ns != NULL; ns = ns->next) {
+		char *attr_name = ns->prefix != NULL ? oscap_sprintf("xmlns:%s", (const char *) ns->prefix) : oscap_strdup("xmlns");
+		ret = xmlTextWriterWriteAttribute(writer, BAD_CAST attr_name, ns->href);
+		free(attr_name);
+		if (ret < 0)
+			return -1;
+	}
+	for (xmlAttrPtr attr = node->properties; attr != NULL; attr = attr->next) {
+		char *attr_name = ds_rds_qname(attr->ns, attr->name);
+		xmlChar *value = xmlNodeGetContent((xmlNodePtr) attr);
+		ret = xmlTextWriterWriteAttribute(writer, BAD_CAST attr_name, value != NULL ? value : BAD_CAST "");
+		xmlFree(value);
+		free(attr_name);
+		if (ret < 0)
+			return -1;
+	}
+
+	xmlDocPtr deferred_doc = ds_rds_deferred_doc(node, deferred_reports);
+	if (deferred_doc != NULL) {
+		if (xmlTextWriterWriteRaw(writer, BAD_CAST "") < 0 || xmlTextWriterFlush(writer) < 0)
+			return -1;
+		xmlNodeDumpOutput(out, deferred_doc, xmlDocGetRootElement(deferred_doc), level + 1, 1, "UTF-8");
+		if (out->error != 0)
+			return -1;
+	} else {
+		for (xmlNodePtr child = node->children; child != NULL; child = child->next) {
+			if (child->type != XML_ELEMENT_NODE)
+				continue;
+			if (ds_rds_write_node(writer, out, doc, child, level + 1, deferred_reports) != 0)
+				return -1;
+		}
+	}
+	return xmlTextWriterEndElement(writer) < 0 ? -1 : 0;
+}
+
+static int _ds_rds_write_from_dom(const char *target_file, xmlDocPtr sds_doc,
+		xmlDocPtr tailoring_doc, const char *tailoring_filepath,
+		char *tailoring_doc_timestamp, xmlDocPtr xccdf_result_file_doc,
+		struct oscap_htable *oval_result_sources,
+		struct oscap_htable *oval_result_mapping,
+		struct oscap_htable *arf_report_mapping,
+		const struct ds_rds_sds_reference *sds_reference)
+{
+	struct oscap_list *deferred_reports = oscap_list_new();
+	xmlDocPtr doc = NULL;
+	if (_ds_rds_create_from_dom(&doc, sds_doc, tailoring_doc,
+			tailoring_filepath, tailoring_doc_timestamp,
+			xccdf_result_file_doc, oval_result_sources, oval_result_mapping,
+			arf_report_mapping, sds_reference, false, deferred_reports) != 0) {
+		oscap_list_free(deferred_reports, free);
+		return -1;
+	}
+
+	int ret = -1;
+	int fd = -1;
+	xmlOutputBufferPtr out = NULL;
+	if (oscap_compress_by_filename(target_file) != OSCAP_COMPRESS_NONE) {
+		/* The buffer closes the file */
+		out = oscap_compress_output_open(target_file);
+		if (out == NULL)
+			goto cleanup;
+	} else {
+		fd = strcmp(target_file, "-") == 0 ? dup(fileno(stdout)) : oscap_open_writable(target_file);
+		if (fd == -1)
+			goto cleanup;
+		out = xmlOutputBufferCreateFd(fd, NULL);
+		if (out == NULL) {
+			close(fd);
+			oscap_setxmlerr(xmlGetLastError());
+			goto cleanup;
+		}
+	}
+	/* The writer takes the ownership of the output buffer */
+	xmlTextWriterPtr writer = xmlNewTextWriter(out);
+	if (writer == NULL) {
+		xmlOutputBufferClose(out);
+		if (fd != -1)
+			close(fd);
+		oscap_setxmlerr(xmlGetLastError());
+		goto cleanup;
+	}
+	xmlTextWriterSetIndent(writer, 1);
+
+	if (xmlTextWriterStartDocument(writer, NULL, "UTF-8", NULL) >= 0 &&
+			ds_rds_write_node(writer, out, doc, xmlDocGetRootElement(doc), 0, deferred_reports) == 0 &&
+			xmlTextWriterEndDocument(writer) >= 0 &&
+			xmlTextWriterFlush(writer) >= 0 &&
+			oscap_compress_output_finish(out) == 0)
+		ret = 0;
+	xmlFreeTextWriter(writer);
+	if (fd != -1)
+		close(fd);
+
+	if (ret != 0)
+		oscap_seterr(OSCAP_EFAMILY_XML, "Could not write the ARF report to '%s'.", target_file);
+
+cleanup:
+	oscap_list_free(deferred_reports, free);
+	xmlFreeDoc(doc);
+	return ret;
+}
+
+int ds_rds_write_from_dom(const char *target_file, xmlDocPtr sds_doc,
+		xmlDocPtr tailoring_doc, const char *tailoring_filepath,
+		char *tailoring_doc_timestamp, xmlDocPtr xccdf_result_file_doc,
+		struct oscap_htable *oval_result_sources,
+		struct oscap_htable *oval_result_mapping,
+		struct oscap_htable *arf_report_mapping)
+{
+	return _ds_rds_write_from_dom(target_file, sds_doc, tailoring_doc,
+			tailoring_filepath, tailoring_doc_timestamp,
+			xccdf_result_file_doc, oval_result_sources, oval_result_mapping,
+			arf_report_mapping, NULL);
+}
+
+int ds_rds_write_sds_reference(const char *target_file,
+		const struct ds_rds_sds_reference *sds_reference,
+		xmlDocPtr xccdf_result_file_doc,
+		struct oscap_htable *oval_result_sources,
+		struct oscap_htable *oval_result_mapping,
+		struct oscap_htable *arf_report_mapping)
+{
+	return _ds_rds_write_from_dom(target_file, NULL, NULL, NULL, NULL,
+			xccdf_result_file_doc, oval_result_sources, oval_result_mapping,
+			arf_report_mapping, sds_reference);
+}
+
+char *ds_rds_file_digest(const char *filepath)
+{
+	char *memory = NULL;
+	size_t size = 0;
+	unsigned char digest[EVP_MAX_MD_SIZE];
+	unsigned int digest_len = 0;
+
+	struct oscap_source *source = oscap_source_new_from_file(filepath);
+	bool ok = oscap_source_get_raw_memory(source, &memory, &size) == 0 &&
+		EVP_Digest(memory, size, digest, &digest_len, EVP_sha256(), NULL) == 1;
+	free(memory);
+	oscap_source_free(source);
+	if (!ok) {
+		oscap_seterr(OSCAP_EFAMILY_OSCAP, "Could not compute the digest of '%s'.", filepath);
+		return NULL;
+	}
+
+	char *hex = malloc(2 * digest_len + 1);
+	for (unsigned int i = 0; i < digest_len; i++)
+		sprintf(hex + 2 * i, "%02x", digest[i]);
+	return hex;
 }
 
 struct oscap_source *ds_rds_create_source(struct oscap_source *sds_source, struct oscap_source *tailoring_source, struct oscap_source *xccdf_result_source, struct oscap_htable *oval_result_sources, struct oscap_htable *oval_result_mapping, struct oscap_htable *arf_report_mapping, const char *target_file)
@@ -909,3 +1240,204 @@ int ds_rds_create(const char* sds_file, const char* xccdf_result_file, const cha
 
 	return result;
 }
+
+static bool ds_rds_node_is(xmlNodePtr node, const char *ns_uri, const char *name)
+{
+	return node->type == XML_ELEMENT_NODE && node->ns != NULL &&
+		oscap_streq((const char *) node->ns->href, ns_uri) &&
+		oscap_streq((const char *) node->name, name);
+}
+
+static xmlNodePtr ds_rds_child(xmlNodePtr parent, const char *ns_uri, const char *name)
+{
+	for (xmlNodePtr child = parent->children; child != NULL; child = child->next) {
+		if (ds_rds_node_is(child, ns_uri, name))
+			return child;
+	}
+	return NULL;
+}
+
+static void ds_rds_prune_oval_system(xmlNodePtr system)
+{
+	struct oscap_htable *tested_items = oscap_htable_new();
+	xmlNodePtr tests = ds_rds_child(system, ovalres_ns_uri, "tests");
+	for (xmlNodePtr test = tests ? tests->children : NULL; test != NULL; test = test->next) {
+		if (!ds_rds_node_is(test, ovalres_ns_uri, "test"))
+			continue;
+		for (xmlNodePtr item = test->children; item != NULL; item = item->next) {
+			if (!ds_rds_node_is(item, ovalres_ns_uri, "tested_item"))
+				continue;
+			char *item_id = (char *) xmlGetProp(item, BAD_CAST "item_id");
+			if (item_id != NULL)
+				oscap_htable_add(tested_items, item_id, item);
+			xmlFree(item_id);
+		}
+	}
+
+	xmlNodePtr syschar = ds_rds_child(system, ovalsys_ns_uri, "oval_system_characteristics");
+	xmlNodePtr objects = syschar ? ds_rds_child(syschar, ovalsys_ns_uri, "collected_objects") : NULL;
+	xmlNodePtr system_data = syschar ? ds_rds_child(syschar, ovalsys_ns_uri, "system_data") : NULL;
+
+	/* The report only shows the messages of the collected objects */
+	for (xmlNodePtr object = objects ? objects->children : NULL; object != NULL; object = object->next) {
+		xmlNodePtr child = object->children;
+		while (child != NULL) {
+			xmlNodePtr next = child->next;
+			if (ds_rds_node_is(child, ovalsys_ns_uri, "reference")) {
+				xmlUnlinkNode(child);
+				xmlFreeNode(child);
+			}
+			child = next;
+		}
+	}
+
+	/* and only the items the tests refer to */
+	xmlNodePtr item = system_data ? system_data->children : NULL;
+	while (item != NULL) {
+		xmlNodePtr next = item->next;
+		if (item->type == XML_ELEMENT_NODE) {
+			char *id = (char *) xmlGetProp(item, BAD_CAST "id");
+			if (id == NULL || oscap_htable_get(tested_items, id) == NULL) {
+				xmlUnlinkNode(item);
+				xmlFreeNode(item);
+			}
+			xmlFree(id);
+		}
+		item = next;
+	}
+
+	oscap_htable_free0(tested_items);
+}
+
+void ds_rds_prune_for_report(xmlDocPtr doc)
+{
+	xmlNodePtr reports = ds_rds_lookup_container(doc, "reports");
+	if (reports == NULL)
+		return;
+
+	for (xmlNodePtr report = reports->children; report != NULL; report = report->next) {
+		if (!ds_rds_node_is(report, arf_ns_uri, "report"))
+			continue;
+		xmlNodePtr content = ds_rds_child(report, arf_ns_uri, "content");
+		xmlNodePtr oval_results = content ? ds_rds_child(content, ovalres_ns_uri, "oval_results") : NULL;
+		xmlNodePtr results = oval_results ? ds_rds_child(oval_results, ovalres_ns_uri, "results") : NULL;
+		if (results == NULL)
+			continue;
+		for (xmlNodePtr system = results->children; system != NULL; system = system->next) {
+			if (ds_rds_node_is(system, ovalres_ns_uri, "system"))
+				ds_rds_prune_oval_system(system);
+		}
+	}
+}
+
+/*
+ * Load the document referenced from the ARF, the file must not have changed
+ * since the ARF was written.
+ */
+static xmlDocPtr ds_rds_load_referenced_doc(const char *filepath, const xmlChar *digest, bool compose_sds)
+{
+	char *actual_digest = ds_rds_file_digest(filepath);
+	if (actual_digest == NULL)
+		return NULL;
+	if (strcmp(actual_digest, (const char *) digest) != 0) {
+		oscap_seterr(OSCAP_EFAMILY_OSCAP, "The digest of '%s' doesn't match the one recorded in the ARF, "
+				"it isn't the file the results were created from.", filepath);
+		free(actual_digest);
+		return NULL;
+	}
+	free(actual_digest);
+
+	struct oscap_source *source = oscap_source_new_from_file(filepath);
+	xmlDocPtr doc = NULL;
+	if (compose_sds && oscap_source_get_scap_type(source) != OSCAP_DOCUMENT_SDS)
+		doc = ds_sds_compose_xmlDoc_from_xccdf_source(source);
+	else
+		doc = oscap_source_pop_xmlDoc(source);
+	oscap_source_free(source);
+	return doc;
+}
+
+static int ds_rds_inflate_report_request(xmlDocPtr doc, xmlNodePtr remote_resource,
+		const char *sds_file, const char *tailoring_file)
+{
+	int ret = -1;
+	xmlChar *href = xmlGetNsProp(remote_resource, BAD_CAST "href", BAD_CAST xlink_ns_uri);
+	xmlChar *digest = xmlGetNsProp(remote_resource, BAD_CAST "digest", BAD_CAST sds_ref_ns_uri);
+	xmlChar *tailoring_href = xmlGetNsProp(remote_resource, BAD_CAST "tailoring-href", BAD_CAST sds_ref_ns_uri);
+	xmlChar *tailoring_digest = xmlGetNsProp(remote_resource, BAD_CAST "tailoring-digest", BAD_CAST sds_ref_ns_uri);
+	xmlChar *tailoring_timestamp = xmlGetNsProp(remote_resource, BAD_CAST "tailoring-timestamp", BAD_CAST sds_ref_ns_uri);
+	xmlDocPtr tailoring_doc = NULL;
+
+	if (sds_file == NULL)
+		sds_file = (const char *) href;
+	if (sds_file == NULL) {
+		oscap_seterr(OSCAP_EFAMILY_OSCAP, "The source data stream to inflate the ARF with is not known.");
+		goto cleanup;
+	}
+	xmlDocPtr sds_doc = ds_rds_load_referenced_doc(sds_file, digest, true);
+	if (sds_doc == NULL)
+		goto cleanup;
+
+	xmlNsPtr arf_ns = xmlSearchNsByHref(doc, xmlDocGetRootElement(doc), BAD_CAST arf_ns_uri);
+	xmlNodePtr arf_content = xmlNewNode(arf_ns, BAD_CAST "content");
+	xmlDOMWrapCtxtPtr sds_wrap_ctxt = xmlDOMWrapNewCtxt();
+	xmlNodePtr sds_res_node = xmlDocGetRootElement(sds_doc);
+	xmlDOMWrapAdoptNode(sds_wrap_ctxt, sds_doc, sds_res_node, doc, NULL, 0);
+	xmlAddChild(arf_content, sds_res_node);
+	xmlDOMWrapReconcileNamespaces(sds_wrap_ctxt, sds_res_node, 0);
+	xmlDOMWrapFreeCtxt(sds_wrap_ctxt);
+	xmlFreeDoc(sds_doc);
+
+	xmlReplaceNode(remote_resource, arf_content);
+	xmlFreeNode(remote_resource);
+
+	if (tailoring_digest != NULL) {
+		if (tailoring_file == NULL)
+			tailoring_file = (const char *) tailoring_href;
+		tailoring_doc = ds_rds_load_referenced_doc(tailoring_file, tailoring_digest, false);
+		if (tailoring_doc == NULL)
+			goto cleanup;
+		/* The component IDs are made from the original path */
+		if (ds_rds_add_tailoring(doc, sds_res_node, tailoring_doc, (const char *) tailoring_href,
+				(const char *) tailoring_timestamp) != 0)
+			goto cleanup;
+	}
+	ret = 0;
+
+cleanup:
+	xmlFreeDoc(tailoring_doc);
+	xmlFree(href);
+	xmlFree(digest);
+	xmlFree(tailoring_href);
+	xmlFree(tailoring_digest);
+	xmlFree(tailoring_timestamp);
+	return ret;
+}
+
+int ds_rds_inflate(const char *arf_file, const char *sds_file, const char *tailoring_file, const char *target_file)
+{
+	struct oscap_source *arf_source = oscap_source_new_from_file(arf_file);
+	xmlDocPtr doc = oscap_source_pop_xmlDoc(arf_source);
+	oscap_source_free(arf_source);
+	if (doc == NULL)
+		return -1;
+
+	xmlNodePtr report_requests = ds_rds_lookup_container(doc, "report-requests");
+	for (xmlNodePtr request = report_requests ? report_requests->children : NULL; request != NULL; request = request->next) {
+		if (!ds_rds_node_is(request, arf_ns_uri, "report-request"))
+			continue;
+		xmlNodePtr remote_resource = ds_rds_child(request, arf_ns_uri, "remote-resource");
+		/* Remote resources not written by ds_rds_write_sds_reference are kept */
+		if (remote_resource == NULL || !xmlHasNsProp(remote_resource, BAD_CAST "digest", BAD_CAST sds_ref_ns_uri))
+			continue;
+		if (ds_rds_inflate_report_request(doc, remote_resource, sds_file, tailoring_file) != 0) {
+			xmlFreeDoc(doc);
+			return -1;
+		}
+	}
+
+	struct oscap_source *target = oscap_source_new_from_xmlDoc(doc, target_file);
+	int ret = oscap_source_save_as(target, NULL);
+	oscap_source_free(target);
+	return ret;
+}
@@ -42,6 +42,11 @@ struct rds_index
 	struct oscap_list *report_requests;
 	struct oscap_list *assets;
 	struct oscap_list *reports;
+
+	// the first of each ID, like in the lists
+	struct oscap_htable *report_request_map;
+	struct oscap_htable *asset_map;
+	struct oscap_htable *report_map;
 };
 
 struct rds_index *rds_index_new(void)
@@ -50,6 +55,9 @@ struct rds_index *rds_index_new(void)
 	ret->report_requests = oscap_list_new();
 	ret->assets = oscap_list_new();
 	ret->reports = oscap_list_new();
+	ret->report_request_map = oscap_htable_new();
+	ret->asset_map = oscap_htable_new();
+	ret->report_map = oscap_htable_new();
 
 	return ret;
 }
@@ -57,6 +65,9 @@ struct rds_index *rds_index_new(void)
 void rds_index_free(struct rds_index *s)
 {
 	if (s != NULL) {
+		oscap_htable_free0(s->report_request_map);
+		oscap_htable_free0(s->asset_map);
+		oscap_htable_free0(s->report_map);
 		oscap_list_free(s->report_requests, (oscap_destruct_func)rds_report_request_index_free);
 		oscap_list_free(s->assets, (oscap_destruct_func)rds_asset_index_free);
 		oscap_list_free(s->reports, (oscap_destruct_func)rds_report_index_free);
@@ -67,6 +78,7 @@ void rds_index_free(struct rds_index *s)
 static void rds_index_add_report_request(struct rds_index *s, struct rds_report_request_index *rr_index)
 {
 	oscap_list_add(s->report_requests, rr_index);
+	oscap_htable_add(s->report_request_map, rds_report_request_index_get_id(rr_index), rr_index);
 }
 
 struct rds_report_request_index_iterator *rds_index_get_report_requests(struct rds_index *s)
@@ -77,6 +89,7 @@ struct rds_report_request_index_iterator *rds_index_get_report_requests(struct r
 static void rds_index_add_asset(struct rds_index *s, struct rds_asset_index *a_index)
 {
 	oscap_list_add(s->assets, a_index);
+	oscap_htable_add(s->asset_map, rds_asset_index_get_id(a_index), a_index);
 }
 
 struct rds_asset_index_iterator *rds_index_get_assets(struct rds_index *s)
@@ -87,6 +100,7 @@ struct rds_asset_index_iterator *rds_index_get_assets(struct rds_index *s)
 static void rds_index_add_report(struct rds_index* s, struct rds_report_index *r_index)
 {
 	oscap_list_add(s->reports, r_index);
+	oscap_htable_add(s->report_map, rds_report_index_get_id(r_index), r_index);
 }
 
 struct rds_report_index_iterator *rds_index_get_reports(struct rds_index* s)
@@ -96,62 +110,17 @@ struct rds_report_index_iterator *rds_index_get_reports(struct rds_index* s)
 
 struct rds_report_request_index* rds_index_get_report_request(struct rds_index* rds, const char* id)
 {
-	struct rds_report_request_index* ret = NULL;
-
-	struct rds_report_request_index_iterator* it = rds_index_get_report_requests(rds);
-	while (rds_report_request_index_iterator_has_more(it))
-	{
-		struct rds_report_request_index* rr_index = rds_report_request_index_iterator_next(it);
-		if (strcmp(rds_report_request_index_get_id(rr_index), id) == 0) {
-			ret = rr_index;
-			break;
-		}
-
-	}
-	rds_report_request_index_iterator_free(it);
-
-	return ret;
+	return oscap_htable_get(rds->report_request_map, id);
 }
 
 struct rds_asset_index* rds_index_get_asset(struct rds_index *rds, const char *id)
 {
-	struct rds_asset_index *ret = NULL;
-
-	if (id == NULL)
-		return ret;
-
-	struct rds_asset_index_iterator *it = rds_index_get_assets(rds);
-	while (rds_asset_index_iterator_has_more(it))
-	{
-		struct rds_asset_index *a_index = rds_asset_index_iterator_next(it);
-		if (strcmp(rds_asset_index_get_id(a_index), id) == 0) {
-			ret = a_index;
-			break;
-		}
-
-	}
-	rds_asset_index_iterator_free(it);
-
-	return ret;
+	return oscap_htable_get(rds->asset_map, id);
 }
 
 struct rds_report_index *rds_index_get_report(struct rds_index *rds, const char *id)
 {
-	struct rds_report_index *ret = NULL;
-
-	struct rds_report_index_iterator *it = rds_index_get_reports(rds);
-	while (rds_report_index_iterator_has_more(it))
-	{
-		struct rds_report_index *r_index = rds_report_index_iterator_next(it);
-		if (strcmp(rds_report_index_get_id(r_index), id) == 0) {
-			ret = r_index;
-			break;
-		}
-
-	}
-	rds_report_index_iterator_free(it);
-
-	return ret;
+	return oscap_htable_get(rds->report_map, id);
 }
 
 static xmlChar *relationship_get_inner_ref(xmlNodePtr node)
@@ -356,17 +325,20 @@ int rds_index_select_report(struct rds_index *s, const char **report_id)
 {
 	int ret = 1;
 
+	if (*report_id != NULL) {
+		struct rds_report_index *report_idx = rds_index_get_report(s, *report_id);
+		if (report_idx == NULL)
+			return 1;
+		*report_id = rds_report_index_get_id(report_idx);
+		return 0;
+	}
+
+	// no ID given, the first report
 	struct rds_report_index_iterator *reports_it = rds_index_get_reports(s);
-	while (rds_report_index_iterator_has_more(reports_it))
+	if (rds_report_index_iterator_has_more(reports_it))
 	{
-		struct rds_report_index* report_idx = rds_report_index_iterator_next(reports_it);
-		const char *report_idx_id = rds_report_index_get_id(report_idx);
-
-		if (!*report_id || strcmp(report_idx_id, *report_id) == 0) {
-			*report_id = report_idx_id;
-			ret = 0;
-			break;
-		}
+		*report_id = rds_report_index_get_id(rds_report_index_iterator_next(reports_it));
+		ret = 0;
 	}
 	rds_report_index_iterator_free(reports_it);
 
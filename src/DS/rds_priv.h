@@ -23,6 +23,14 @@
 
 #ifdef HAVE_CONFIG_H
 #include <config.h>
+
+/**
+ * Remove the parts of an ARF document which the HTML report does not use:
+ * the system characteristics items which are not referred to by any OVAL
+ * test result and the item references of the collected objects.
+ * The document is not a valid ARF afterwards.
+ */
+void ds_rds_prune_for_report(xmlDocPtr doc);
 #endif
 
 #include <libxml/tree.h>
@@ -40,4 +48,47 @@ struct oscap_source *ds_rds_create_source(struct oscap_source *sds_source, struc
 xmlNodePtr ds_rds_create_report(xmlDocPtr target_doc, xmlNodePtr reports_node, xmlDocPtr source_doc, const char* report_id);
 
 int ds_rds_create_from_dom(xmlDocPtr* ret, xmlDocPtr sds_doc, xmlDocPtr tailoring_doc, const char* tailoring_filepath, char *tailoring_doc_timestamp, xmlDocPtr xccdf_result_file_doc, struct oscap_htable* oval_result_sources, struct oscap_htable* oval_result_mapping, struct oscap_htable *arf_report_mapping);
+
+/**
+ * Write the ARF report to the target file without building the whole ARF
+ * document in memory. Takes the same arguments as ds_rds_create_from_dom,
+ * the root element of sds_doc is moved to the ARF document and freed.
+ * The OVAL results documents are serialized directly from their sources.
+ * @returns 0 on success
+ */
+int ds_rds_write_from_dom(const char *target_file, xmlDocPtr sds_doc, xmlDocPtr tailoring_doc, const char* tailoring_filepath, char *tailoring_doc_timestamp, xmlDocPtr xccdf_result_file_doc, struct oscap_htable* oval_result_sources, struct oscap_htable* oval_result_mapping, struct oscap_htable *arf_report_mapping);
+
+/**
+ * Reference to the source data stream written into the report-request of
+ * the ARF in place of the data stream, see ds_rds_inflate.
+ */
+struct ds_rds_sds_reference {
+	const char *href;			///< Path to the source data stream (or XCCDF) file
+	const char *digest;			///< SHA-256 of the file, see ds_rds_file_digest
+	const char *tailoring_href;		///< Path to the tailoring file, NULL without tailoring
+	const char *tailoring_digest;		///< SHA-256 of the tailoring file
+	const char *tailoring_timestamp;	///< Timestamp of the tailoring component
+};
+
+/**
+ * Write the ARF report like ds_rds_write_from_dom, but with only a reference
+ * to the source data stream and the tailoring in the report-request.
+ * The target file "-" means standard output.
+ * @returns 0 on success
+ */
+int ds_rds_write_sds_reference(const char *target_file, const struct ds_rds_sds_reference *sds_reference, xmlDocPtr xccdf_result_file_doc, struct oscap_htable* oval_result_sources, struct oscap_htable* oval_result_mapping, struct oscap_htable *arf_report_mapping);
+
+/**
+ * Get SHA-256 of the content of the file, hex encoded.
+ * @returns the digest to be freed by the caller or NULL on error
+ */
+char *ds_rds_file_digest(const char *filepath);
+
+/**
+ * Remove the parts of an ARF document which the HTML report does not use:
+ * the system characteristics items which are not referred to by any OVAL
+ * test result and the item references of the collected objects.
+ * The document is not a valid ARF afterwards.
+ */
+void ds_rds_prune_for_report(xmlDocPtr doc);
 #endif
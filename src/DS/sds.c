@@ -40,6 +40,7 @@
 #include "common/util.h"
 #include "common/list.h"
 #include "common/oscap_acquire.h"
+#include "common/oscap_threadpool.h"
 #include "source/oscap_source_priv.h"
 #include "source/public/oscap_source.h"
 #include "oscap_helpers.h"
@@ -293,11 +294,14 @@ static xmlNodePtr ds_sds_get_component_root_by_id(xmlDoc *doc, const char* compo
 
 static int ds_sds_dump_local_component(const char* component_id, struct ds_sds_session *session, const char *target_filename_dirname, const char *relative_filepath)
 {
-	xmlDoc *doc = ds_sds_session_get_xmlDoc(session);
+	xmlDoc *component_doc = ds_sds_session_parse_component(session, component_id);
+	xmlDoc *doc = component_doc != NULL ? component_doc : ds_sds_session_get_xmlDoc(session);
 
 	xmlNodePtr inner_root = ds_sds_get_component_root_by_id(doc, component_id);
 
-	return ds_sds_register_component(session, doc, inner_root, component_id, target_filename_dirname, relative_filepath);
+	int ret = ds_sds_register_component(session, doc, inner_root, component_id, target_filename_dirname, relative_filepath);
+	xmlFreeDoc(component_doc);
+	return ret;
 }
 
 static int ds_sds_dump_file_component(const char* external_file, const char* component_id, struct ds_sds_session *session, const char *target_filename_dirname, const char *relative_filepath)
@@ -490,6 +494,50 @@ static int ds_sds_dump_component_by_href(struct ds_sds_session *session, char* x
 	return 0;
 }
 
+/*
+ * Download the remote components referenced from the catalog at once,
+ * before they are dumped one by one.
+ */
+static void ds_sds_prefetch_catalog(xmlNodePtr catalog, struct ds_sds_session *session)
+{
+	char **urls = NULL;
+	size_t count = 0;
+
+	if (!ds_sds_session_fetch_remote_resources(session))
+		return;
+
+	for (xmlNodePtr uri = catalog->children; uri != NULL; uri = uri->next) {
+		if (uri->type != XML_ELEMENT_NODE || strcmp((const char *)uri->name, "uri") != 0)
+			continue;
+
+		char *str_uri = (char *)xmlGetProp(uri, BAD_CAST "uri");
+		if (str_uri == NULL || str_uri[0] != '#') {
+			xmlFree(str_uri);
+			continue;
+		}
+		xmlNodePtr cat_component_ref = ds_sds_find_component_ref(ds_sds_session_get_selected_datastream(session), str_uri + 1);
+		xmlFree(str_uri);
+		if (cat_component_ref == NULL)
+			continue;
+
+		char *xlink_href = (char *)xmlGetNsProp(cat_component_ref, BAD_CAST "href", BAD_CAST xlink_ns_uri);
+		if (xlink_href != NULL && oscap_acquire_url_is_supported(xlink_href)) {
+			char *sep = strchr(xlink_href, '#');
+			if (sep != NULL)
+				*sep = '\0';
+			urls = realloc(urls, (count + 1) * sizeof(char *));
+			urls[count++] = oscap_strdup(xlink_href);
+		}
+		xmlFree(xlink_href);
+	}
+
+	if (count > 1)
+		oscap_acquire_url_prefetch((const char **)urls, count);
+	for (size_t i = 0; i < count; ++i)
+		free(urls[i]);
+	free(urls);
+}
+
 int ds_sds_dump_component_ref_as(const xmlNodePtr component_ref, struct ds_sds_session *session, const char* sub_dir, const char* relative_filepath)
 {
 	char* cref_id = (char*)xmlGetProp(component_ref, BAD_CAST "id");
@@ -527,6 +575,8 @@ int ds_sds_dump_component_ref_as(const xmlNodePtr component_ref, struct ds_sds_s
 	xmlNodePtr catalog = node_get_child_element(component_ref, "catalog");
 	if (catalog)
 	{
+		ds_sds_prefetch_catalog(catalog, session);
+
 		xmlNodePtr uri = catalog->children;
 
 		for (; uri != NULL; uri = uri->next)
@@ -665,7 +715,140 @@ static inline int ds_sds_compose_component_add_script_content(xmlNode *component
 	}
 }
 
-static int ds_sds_compose_add_component_internal(xmlDocPtr doc, xmlNodePtr datastream, struct oscap_source *component_source, const char* comp_id, bool extended)
+#define DS_SDS_COMPOSE_MAX_JOBS 64
+
+/*
+ * Look-up tables of the collection being composed, so that adding
+ * a component doesn't search the whole collection for the IDs taken.
+ */
+struct ds_sds_compose_index {
+	struct oscap_htable *crefs;		///< xlink:href of the component-refs of the data stream by their IDs
+	struct oscap_htable *components;	///< components and extended components by their IDs
+	struct oscap_htable *sources;		///< component files loaded so far by their paths
+	xmlNodePtr first_extended;		///< first extended component of the collection
+};
+
+static void ds_sds_compose_index_add_cref(struct ds_sds_compose_index *index, xmlNodePtr cref)
+{
+	char *cref_id = (char *) xmlGetProp(cref, BAD_CAST "id");
+	if (cref_id == NULL)
+		return;
+	char *href = (char *) xmlGetNsProp(cref, BAD_CAST "href", BAD_CAST xlink_ns_uri);
+	char *value = oscap_strdup(href != NULL ? href : "");
+	// the first component-ref of an ID is the one found
+	if (!oscap_htable_add(index->crefs, cref_id, value))
+		free(value);
+	xmlFree(href);
+	xmlFree(cref_id);
+}
+
+static struct ds_sds_compose_index *ds_sds_compose_index_new(xmlDocPtr doc, xmlNodePtr datastream)
+{
+	struct ds_sds_compose_index *index = calloc(1, sizeof(struct ds_sds_compose_index));
+	index->crefs = oscap_htable_new();
+	index->components = oscap_htable_new();
+	index->sources = oscap_htable_new();
+
+	for (xmlNodePtr parent = datastream->children; parent != NULL; parent = parent->next) {
+		if (parent->type != XML_ELEMENT_NODE)
+			continue;
+		for (xmlNodePtr cref = parent->children; cref != NULL; cref = cref->next) {
+			if (cref->type == XML_ELEMENT_NODE && strcmp((const char *) cref->name, "component-ref") == 0)
+				ds_sds_compose_index_add_cref(index, cref);
+		}
+	}
+
+	xmlNodePtr root = xmlDocGetRootElement(doc);
+	for (xmlNodePtr component = root->children; component != NULL; component = component->next) {
+		if (component->type != XML_ELEMENT_NODE)
+			continue;
+		bool extended = strcmp((const char *) component->name, "extended-component") == 0;
+		if (!extended && strcmp((const char *) component->name, "component") != 0)
+			continue;
+		if (extended && index->first_extended == NULL)
+			index->first_extended = component;
+		char *component_id = (char *) xmlGetProp(component, BAD_CAST "id");
+		if (component_id != NULL)
+			oscap_htable_add(index->components, component_id, component);
+		xmlFree(component_id);
+	}
+	return index;
+}
+
+static void ds_sds_compose_index_free(struct ds_sds_compose_index *index)
+{
+	if (index != NULL) {
+		oscap_htable_free(index->crefs, (oscap_destruct_func) free);
+		oscap_htable_free0(index->components);
+		oscap_htable_free(index->sources, (oscap_destruct_func) oscap_source_free);
+		free(index);
+	}
+}
+
+struct ds_sds_compose_load {
+	char **paths;
+	struct oscap_source **sources;
+};
+
+static void ds_sds_compose_load_source(void *arg, size_t i)
+{
+	struct ds_sds_compose_load *load = arg;
+	bool had_err = oscap_err();
+
+	load->sources[i] = oscap_source_new_from_file(load->paths[i]);
+	if (oscap_source_get_xmlDoc(load->sources[i]) == NULL) {
+		// Not XML or broken, the file is loaded again when its component
+		// is added, which reports the errors in order
+		oscap_source_free(load->sources[i]);
+		load->sources[i] = NULL;
+		if (!had_err)
+			oscap_clearerr();
+	}
+}
+
+/*
+ * Load and parse the component files which aren't loaded yet by several
+ * threads at once. The files which fail to parse are left out.
+ */
+static void ds_sds_compose_index_load(struct ds_sds_compose_index *index, char **paths, size_t count)
+{
+	struct ds_sds_compose_load load;
+	struct oscap_htable *wanted = oscap_htable_new();
+	size_t i, todo = 0;
+
+	load.paths = malloc(count * sizeof(char *));
+	for (i = 0; i < count; i++) {
+		if (oscap_htable_get(index->sources, paths[i]) == NULL && oscap_htable_add(wanted, paths[i], "")) {
+			load.paths[todo++] = paths[i];
+		}
+	}
+	oscap_htable_free0(wanted);
+
+	if (todo > 1) {
+		size_t jobs = oscap_threadpool_jobs("OSCAP_SDS_COMPOSE_JOBS", 0, DS_SDS_COMPOSE_MAX_JOBS);
+		load.sources = calloc(todo, sizeof(struct oscap_source *));
+		dI("Loading %zu components using %zu threads.", todo, jobs < todo ? jobs : todo);
+		oscap_threadpool_run(jobs, todo, ds_sds_compose_load_source, &load, NULL);
+		for (i = 0; i < todo; i++) {
+			if (load.sources[i] != NULL)
+				oscap_htable_add(index->sources, load.paths[i], load.sources[i]);
+		}
+		free(load.sources);
+	}
+	free(load.paths);
+}
+
+static struct oscap_source *ds_sds_compose_index_get_source(struct ds_sds_compose_index *index, const char *filepath)
+{
+	struct oscap_source *source = oscap_htable_get(index->sources, filepath);
+	if (source == NULL) {
+		source = oscap_source_new_from_file(filepath);
+		oscap_htable_add(index->sources, filepath, source);
+	}
+	return source;
+}
+
+static int ds_sds_compose_add_component_internal(xmlDocPtr doc, xmlNodePtr datastream, struct ds_sds_compose_index *index, struct oscap_source *component_source, const char* comp_id, bool extended)
 {
 	xmlNsPtr ds_ns = xmlSearchNsByHref(doc, datastream, BAD_CAST datastream_ns_uri);
 	if (!ds_ns)
@@ -712,6 +895,8 @@ static int ds_sds_compose_add_component_internal(xmlDocPtr doc, xmlNodePtr datas
 		}
 		// extended components always go at the end
 		xmlAddChild(doc_root, component);
+		if (index->first_extended == NULL)
+			index->first_extended = component;
 	} else {
 		xmlDoc *component_doc = oscap_source_get_xmlDoc(component_source);
 		if (!component_doc) {
@@ -756,65 +941,21 @@ static int ds_sds_compose_add_component_internal(xmlDocPtr doc, xmlNodePtr datas
 		// already is an extended-component and if so, add it right before
 		// that component
 
-		xmlNodePtr first_extended_component = node_get_child_element(doc_root, "extended-component");
-		if (first_extended_component == NULL)
+		if (index->first_extended == NULL)
 		{
 			// no extended component yet, add to the end
 			xmlAddChild(doc_root, component);
 		}
 		else
 		{
-			xmlAddPrevSibling(first_extended_component, component);
+			xmlAddPrevSibling(index->first_extended, component);
 		}
 	}
+	oscap_htable_add(index->components, comp_id, component);
 
 	return 0;
 }
 
-static int ds_sds_compose_catalog_has_uri(xmlDocPtr doc, xmlNodePtr catalog, const char* uri)
-{
-	xmlXPathContextPtr xpathCtx = xmlXPathNewContext(doc);
-	if (xpathCtx == NULL)
-	{
-		oscap_seterr(OSCAP_EFAMILY_XML, "Error: unable to create a new XPath context.");
-		return -1;
-	}
-
-	xmlXPathRegisterNs(xpathCtx, BAD_CAST "cat", BAD_CAST cat_ns_uri);
-	xmlXPathRegisterNs(xpathCtx, BAD_CAST "xlink", BAD_CAST xlink_ns_uri);
-
-	// limit xpath execution to just the catalog node
-	// this is done for performance reasons
-	xpathCtx->node = catalog;
-
-	char *expression = oscap_sprintf("cat:uri[@uri = '%s']", uri);
-
-	xmlXPathObjectPtr xpathObj = xmlXPathEvalExpression(
-			BAD_CAST expression,
-			xpathCtx);
-
-	free(expression);
-
-	if (xpathObj == NULL)
-	{
-		oscap_seterr(OSCAP_EFAMILY_XML, "Error: Unable to evaluate XPath expression.");
-		xmlXPathFreeContext(xpathCtx);
-
-		return -1;
-	}
-
-	int result = 0;
-
-	xmlNodeSetPtr nodeset = xpathObj->nodesetval;
-	if (nodeset != NULL)
-		result = nodeset->nodeNr > 0 ? 0 : 1;
-
-	xmlXPathFreeObject(xpathObj);
-	xmlXPathFreeContext(xpathCtx);
-
-	return result;
-}
-
 // takes given relative filepath and mangles it so that it's acceptable
 // as a component id
 char* ds_sds_mangle_filepath(const char* filepath)
@@ -853,78 +994,66 @@ char* ds_sds_mangle_filepath(const char* filepath)
 	return ret;
 }
 
-static int ds_sds_compose_add_component_with_ref(xmlDocPtr doc, xmlNodePtr datastream, const char* filepath, const char* cref_id);
+static int ds_sds_compose_add_component_with_ref(xmlDocPtr doc, xmlNodePtr datastream, struct ds_sds_compose_index *index, const char* filepath, const char* cref_id);
 
-static inline const char *_get_dep_xpath_for_type(int document_type)
+static inline const char *_get_dep_name_for_type(int document_type)
 {
-	static const char *xccdf_xpath = "//*[local-name() = 'check-content-ref']";
-	static const char *cpe_xpath = "//*[local-name() = 'check']";
 	if (document_type == OSCAP_DOCUMENT_CPE_DICTIONARY)
-		return cpe_xpath;
-	return xccdf_xpath;
+		return "check";
+	return "check-content-ref";
 }
 
-static int ds_sds_compose_add_component_dependencies(xmlDocPtr doc, xmlNodePtr datastream, struct oscap_source *component_source, xmlNodePtr catalog, int component_type)
+// the next node of the document in document order, not descending into node
+static xmlNodePtr _next_node_after(xmlNodePtr node)
 {
-	xmlDocPtr component_doc = oscap_source_get_xmlDoc(component_source);
-	if (component_doc == NULL)
-	{
-		return -1;
+	while (node->next == NULL) {
+		node = node->parent;
+		if (node == NULL || node->type != XML_ELEMENT_NODE)
+			return NULL;
 	}
+	return node->next;
+}
 
-	xmlXPathContextPtr xpathCtx = xmlXPathNewContext(component_doc);
-	if (xpathCtx == NULL)
+static int ds_sds_compose_add_component_dependencies(xmlDocPtr doc, xmlNodePtr datastream, struct ds_sds_compose_index *index, struct oscap_source *component_source, xmlNodePtr catalog, int component_type)
+{
+	xmlDocPtr component_doc = oscap_source_get_xmlDoc(component_source);
+	if (component_doc == NULL)
 	{
-		oscap_seterr(OSCAP_EFAMILY_XML, "Error: unable to create new XPath context.");
 		return -1;
 	}
 
-	xmlXPathObjectPtr xpathObj = xmlXPathEvalExpression(
-			// we want robustness and support for future versions, this expression
-			// retrieves check-content-refs from any namespace
-			BAD_CAST _get_dep_xpath_for_type(component_type),
-			xpathCtx);
-	if (xpathObj == NULL)
-	{
-		oscap_seterr(OSCAP_EFAMILY_XML, "Error: Unable to evaluate XPath expression.");
-		xmlXPathFreeContext(xpathCtx);
+	// we want robustness and support for future versions, the references
+	// are elements of the name from any namespace
+	const char *ref_name = _get_dep_name_for_type(component_type);
 
-		return -1;
-	}
+	struct oscap_htable *exported = oscap_htable_new();
+	char* filepath_cpy = oscap_strdup(oscap_source_readable_origin(component_source));
+	char *dir = oscap_dirname(filepath_cpy);
+	struct oscap_list *hrefs = oscap_list_new();
+	struct oscap_list *real_paths = oscap_list_new();
 
-	xmlNsPtr cat_ns = xmlSearchNsByHref(doc, datastream, BAD_CAST cat_ns_uri);
-
-	xmlNodeSetPtr nodeset = xpathObj->nodesetval;
-	if (nodeset != NULL)
+	xmlNodePtr node = xmlDocGetRootElement(component_doc);
+	while (node != NULL)
 	{
-		struct oscap_htable *exported = oscap_htable_new();
-		char* filepath_cpy = oscap_strdup(oscap_source_readable_origin(component_source));
-		char *dir = oscap_dirname(filepath_cpy);
+		if (node->type != XML_ELEMENT_NODE) {
+			node = _next_node_after(node);
+			continue;
+		}
 
-		for (int i = 0; i < nodeset->nodeNr; i++)
+		if (strcmp((const char *) node->name, ref_name) == 0 && xmlHasProp(node, BAD_CAST "href"))
 		{
-			xmlNodePtr node = nodeset->nodeTab[i];
-
-			if (node->type != XML_ELEMENT_NODE)
-				continue;
-
-			if (xmlHasProp(node, BAD_CAST "href"))
-			{
-				char* href = (char*)xmlGetProp(node, BAD_CAST "href");
-				if (oscap_htable_get(exported, href) != NULL) {
-					// This path has been already exported. Do not export duplicate.
-					xmlFree(href);
-					continue;
-				}
+			char* href = (char*)xmlGetProp(node, BAD_CAST "href");
+			if (oscap_htable_get(exported, href) != NULL) {
+				// This path has been already exported. Do not export duplicate.
+				xmlFree(href);
+			} else if (oscap_acquire_url_is_supported(href)) {
+				oscap_htable_add(exported, href, "");
+				/* If the referenced component is remote one, do not include
+				 * it within the DataStream. Such component shall only be
+				 * downloaded once the scan is run. */
+				xmlFree(href);
+			} else {
 				oscap_htable_add(exported, href, "");
-
-				if (oscap_acquire_url_is_supported(href)) {
-					/* If the referenced component is remote one, do not include
-					 * it within the DataStream. Such component shall only be
-					 * downloaded once the scan is run. */
-					xmlFree(href);
-					continue;
-				}
 
 				// skip over file:// if it's used in the file href
 				const char *altered_href = oscap_str_startswith(href, "file://") ? href + 7 : href;
@@ -932,111 +1061,87 @@ static int ds_sds_compose_add_component_dependencies(xmlDocPtr doc, xmlNodePtr d
 				char* real_path = (strcmp(dir, "") == 0 || strcmp(dir, ".") == 0 || altered_href[0] == '/') ?
 					oscap_strdup(altered_href) : oscap_sprintf("%s/%s", dir, altered_href);
 
-				char* mangled_path = ds_sds_mangle_filepath(real_path);
-				char* cref_id = oscap_sprintf("scap_org.open-scap_cref_%s", mangled_path);
-
-				int counter = 0;
-				while (ds_sds_find_component_ref(datastream, cref_id) != NULL) {
-					// While the given component ID already exists in the document.
-					free(cref_id);
-					cref_id = oscap_sprintf("scap_org.open-scap_cref_%s%03d", mangled_path, counter++);
-				}
-				free(mangled_path);
-
-				char* uri = oscap_sprintf("#%s", cref_id);
-
-				// we don't want duplicated uri elements in the catalog
-				if (ds_sds_compose_catalog_has_uri(doc, catalog, uri) == 0)
-				{
-					free(uri);
-					free(cref_id);
-					free(real_path);
-					xmlFree(href);
-					continue;
-				}
-
-				int ret = ds_sds_compose_add_component_with_ref(doc, datastream, real_path, cref_id);
-				if (ret == 0) {
-					xmlNodePtr catalog_uri = xmlNewNode(cat_ns, BAD_CAST "uri");
-					xmlSetProp(catalog_uri, BAD_CAST "name", BAD_CAST href);
-					xmlSetProp(catalog_uri, BAD_CAST "uri", BAD_CAST uri);
-					xmlAddChild(catalog, catalog_uri);
-				}
-
-				free(cref_id);
-				free(uri);
-				free(real_path);
+				oscap_list_add(hrefs, oscap_strdup(href));
+				oscap_list_add(real_paths, real_path);
 				xmlFree(href);
-
-				if (ret < 0) {
-					// oscap_seterr has already been called
-					oscap_htable_free0(exported);
-					xmlXPathFreeObject(xpathObj);
-					xmlXPathFreeContext(xpathCtx);
-					free(filepath_cpy);
-					free(dir);
-					return -1;
-				}
-
 			}
 		}
-
-		free(dir);
-		oscap_htable_free0(exported);
-		free(filepath_cpy);
+		node = node->children != NULL ? node->children : _next_node_after(node);
 	}
+	free(dir);
+	free(filepath_cpy);
+	oscap_htable_free0(exported);
+
+	// the referenced files are parsed at once, then added one by one
+	size_t count = oscap_list_get_itemcount(real_paths);
+	char **paths = malloc(count * sizeof(char *));
+	struct oscap_iterator *path_it = oscap_iterator_new(real_paths);
+	for (size_t i = 0; i < count; i++)
+		paths[i] = oscap_iterator_next(path_it);
+	oscap_iterator_free(path_it);
+	ds_sds_compose_index_load(index, paths, count);
 
-	xmlXPathFreeObject(xpathObj);
-	xmlXPathFreeContext(xpathCtx);
-
-	return 0;
-}
+	xmlNsPtr cat_ns = xmlSearchNsByHref(doc, datastream, BAD_CAST cat_ns_uri);
+	struct oscap_htable *uris = oscap_htable_new();
+	struct oscap_iterator *href_it = oscap_iterator_new(hrefs);
+	int ret = 0;
 
-static int ds_sds_compose_has_component_ref(xmlDocPtr doc, xmlNodePtr datastream, const char* filepath, const char* cref_id)
-{
-	xmlXPathContextPtr xpathCtx = xmlXPathNewContext(doc);
-	if (xpathCtx == NULL)
+	for (size_t i = 0; i < count && ret >= 0; i++)
 	{
-		oscap_seterr(OSCAP_EFAMILY_XML, "Error: unable to create new XPath context.");
-		return -1;
-	}
+		const char *href = oscap_iterator_next(href_it);
+		const char *real_path = paths[i];
 
-	xmlXPathRegisterNs(xpathCtx, BAD_CAST "ds", BAD_CAST datastream_ns_uri);
-	xmlXPathRegisterNs(xpathCtx, BAD_CAST "xlink", BAD_CAST xlink_ns_uri);
+		char* mangled_path = ds_sds_mangle_filepath(real_path);
+		char* cref_id = oscap_sprintf("scap_org.open-scap_cref_%s", mangled_path);
 
-	// limit xpath execution to just the datastream node
-	// this is done for performance reasons
-	xpathCtx->node = datastream;
-
-	char *expression = oscap_sprintf("*/ds:component-ref[@xlink:href = '#%s' and @id = '%s']", filepath, cref_id);
+		int counter = 0;
+		while (oscap_htable_get(index->crefs, cref_id) != NULL) {
+			// While the given component ID already exists in the document.
+			free(cref_id);
+			cref_id = oscap_sprintf("scap_org.open-scap_cref_%s%03d", mangled_path, counter++);
+		}
+		free(mangled_path);
 
-	xmlXPathObjectPtr xpathObj = xmlXPathEvalExpression(
-			BAD_CAST expression,
-			xpathCtx);
+		char* uri = oscap_sprintf("#%s", cref_id);
 
-	free(expression);
+		// we don't want duplicated uri elements in the catalog
+		if (oscap_htable_get(uris, uri) != NULL)
+		{
+			free(uri);
+			free(cref_id);
+			continue;
+		}
 
-	if (xpathObj == NULL)
-	{
-		oscap_seterr(OSCAP_EFAMILY_XML, "Error: Unable to evaluate XPath expression.");
-		xmlXPathFreeContext(xpathCtx);
+		ret = ds_sds_compose_add_component_with_ref(doc, datastream, index, real_path, cref_id);
+		if (ret == 0) {
+			xmlNodePtr catalog_uri = xmlNewNode(cat_ns, BAD_CAST "uri");
+			xmlSetProp(catalog_uri, BAD_CAST "name", BAD_CAST href);
+			xmlSetProp(catalog_uri, BAD_CAST "uri", BAD_CAST uri);
+			xmlAddChild(catalog, catalog_uri);
+			oscap_htable_add(uris, uri, "");
+		}
 
-		return -1;
+		free(cref_id);
+		free(uri);
 	}
 
-	int result = 1;
+	oscap_iterator_free(href_it);
+	oscap_htable_free0(uris);
+	free(paths);
+	oscap_list_free(hrefs, free);
+	oscap_list_free(real_paths, free);
 
-	xmlNodeSetPtr nodeset = xpathObj->nodesetval;
-	if (nodeset != NULL)
-		result = nodeset->nodeNr > 0 ? 0 : 1;
-
-	xmlXPathFreeObject(xpathObj);
-	xmlXPathFreeContext(xpathCtx);
+	// oscap_seterr has already been called
+	return ret < 0 ? -1 : 0;
+}
 
-	return result;
+static int ds_sds_compose_has_component_ref(struct ds_sds_compose_index *index, const char* filepath, const char* cref_id)
+{
+	const char *href = oscap_htable_get(index->crefs, cref_id);
+	return (href != NULL && href[0] == '#' && strcmp(href + 1, filepath) == 0) ? 0 : 1;
 }
 
-static int ds_sds_compose_add_component_source_with_ref(xmlDocPtr doc, xmlNodePtr datastream, struct oscap_source *component_source, const char* cref_id)
+static int ds_sds_compose_add_component_source_with_ref(xmlDocPtr doc, xmlNodePtr datastream, struct ds_sds_compose_index *index, struct oscap_source *component_source, const char* cref_id)
 {
 	xmlNsPtr ds_ns = xmlSearchNsByHref(doc, datastream, BAD_CAST datastream_ns_uri);
 	xmlNsPtr xlink_ns = xmlSearchNsByHref(doc, datastream, BAD_CAST xlink_ns_uri);
@@ -1046,19 +1151,12 @@ static int ds_sds_compose_add_component_source_with_ref(xmlDocPtr doc, xmlNodePt
 	// In case we already have this component we just return, no need to add
 	// it twice. We will typically have many references to OVAL files, adding
 	// component for each reference would create unnecessarily huge datastreams
-	int result = ds_sds_compose_has_component_ref(doc, datastream, filepath, cref_id);
+	int result = ds_sds_compose_has_component_ref(index, filepath, cref_id);
 	if (result == 0)
 	{
 		return 0;
 	}
 
-	if (result == -1)
-	{
-		// no need to free anything
-		// oscap_seterr has already been called
-		return -1;
-	}
-
 	xmlNodePtr cref_catalog = xmlNewNode(cat_ns, BAD_CAST "catalog");
 	xmlNodePtr cref_parent;
 
@@ -1068,7 +1166,7 @@ static int ds_sds_compose_add_component_source_with_ref(xmlDocPtr doc, xmlNodePt
 	if (doc_type == OSCAP_DOCUMENT_XCCDF)
 	{
 		cref_parent = node_get_child_element(datastream, "checklists");
-		if (ds_sds_compose_add_component_dependencies(doc, datastream, component_source, cref_catalog, doc_type) != 0)
+		if (ds_sds_compose_add_component_dependencies(doc, datastream, index, component_source, cref_catalog, doc_type) != 0)
 		{
 			// oscap_seterr has already been called
 			return -1;
@@ -1089,7 +1187,7 @@ static int ds_sds_compose_add_component_source_with_ref(xmlDocPtr doc, xmlNodePt
 				cref_parent = NULL;
 			}
 		}
-		if (ds_sds_compose_add_component_dependencies(doc, datastream, component_source, cref_catalog, doc_type) != 0) {
+		if (ds_sds_compose_add_component_dependencies(doc, datastream, index, component_source, cref_catalog, doc_type) != 0) {
 			return -1;
 		}
 	}
@@ -1111,8 +1209,7 @@ static int ds_sds_compose_add_component_source_with_ref(xmlDocPtr doc, xmlNodePt
 		extended_component ? "e" : "", mangled_filepath);
 
 	int counter = 0;
-	xmlNodePtr root = xmlDocGetRootElement(doc);
-	while (lookup_component_in_collection(root, comp_id) != NULL) {
+	while (oscap_htable_get(index->components, comp_id) != NULL) {
 		// While a component of the given ID already exists, generate a new one
 		free(comp_id);
 		comp_id = oscap_sprintf("scap_org.open-scap_%scomp_%s%03d",
@@ -1121,7 +1218,7 @@ static int ds_sds_compose_add_component_source_with_ref(xmlDocPtr doc, xmlNodePt
 
 	free(mangled_filepath);
 
-	result = ds_sds_compose_add_component_internal(doc, datastream, component_source, comp_id, extended_component);
+	result = ds_sds_compose_add_component_internal(doc, datastream, index, component_source, comp_id, extended_component);
 	if (result == 0) {
 		xmlNodePtr cref = xmlNewNode(ds_ns, BAD_CAST "component-ref");
 		xmlAddChild(cref, cref_catalog);
@@ -1134,6 +1231,8 @@ static int ds_sds_compose_add_component_source_with_ref(xmlDocPtr doc, xmlNodePt
 		if (xmlAddChild(cref_parent, cref) == NULL) {
 			oscap_seterr(OSCAP_EFAMILY_XML, "Failed to add component-ref/@id='%s' to the DataStream.", cref_id);
 			result = 1;
+		} else {
+			ds_sds_compose_index_add_cref(index, cref);
 		}
 	}
 
@@ -1148,12 +1247,10 @@ static int ds_sds_compose_add_component_source_with_ref(xmlDocPtr doc, xmlNodePt
 	return result;
 }
 
-int ds_sds_compose_add_component_with_ref(xmlDocPtr doc, xmlNodePtr datastream, const char* filepath, const char* cref_id)
+static int ds_sds_compose_add_component_with_ref(xmlDocPtr doc, xmlNodePtr datastream, struct ds_sds_compose_index *index, const char* filepath, const char* cref_id)
 {
-	struct oscap_source *component_source = oscap_source_new_from_file(filepath);
-	int ret = ds_sds_compose_add_component_source_with_ref(doc, datastream, component_source, cref_id);
-	oscap_source_free(component_source);
-	return ret;
+	struct oscap_source *component_source = ds_sds_compose_index_get_source(index, filepath);
+	return ds_sds_compose_add_component_source_with_ref(doc, datastream, index, component_source, cref_id);
 }
 
 int ds_sds_compose_add_component(const char *target_datastream, const char *datastream_id, const char *new_component, bool extended)
@@ -1180,12 +1277,14 @@ int ds_sds_compose_add_component(const char *target_datastream, const char *data
 
 	char* cref_id = oscap_sprintf("scap_org.open-scap_cref_%s", mangled_path);
 	free(mangled_path);
-	if (ds_sds_compose_add_component_with_ref(doc, datastream, new_component, cref_id) != 0) {
-		free(cref_id);
+	struct ds_sds_compose_index *index = ds_sds_compose_index_new(doc, datastream);
+	int ret = ds_sds_compose_add_component_with_ref(doc, datastream, index, new_component, cref_id);
+	ds_sds_compose_index_free(index);
+	free(cref_id);
+	if (ret != 0) {
 		oscap_source_free(sds_source);
 		return 1;
 	}
-	free(cref_id);
 
 	if (oscap_source_save_as(sds_source, NULL) != 0) {
 		oscap_seterr(OSCAP_EFAMILY_GLIBC, "Error saving source datastream to '%s'.", target_datastream);
@@ -1245,7 +1344,10 @@ xmlDocPtr ds_sds_compose_xmlDoc_from_xccdf_source(struct oscap_source *xccdf_sou
 	xmlAddChild(datastream, extended_components);
 
 	char* cref_id = oscap_sprintf("scap_org.open-scap_cref_%s", mangled_xccdf_file);
-	if (ds_sds_compose_add_component_source_with_ref(doc, datastream, xccdf_source, cref_id) != 0)
+	struct ds_sds_compose_index *index = ds_sds_compose_index_new(doc, datastream);
+	int ret = ds_sds_compose_add_component_source_with_ref(doc, datastream, index, xccdf_source, cref_id);
+	ds_sds_compose_index_free(index);
+	if (ret != 0)
 	{
 		// oscap_seterr already called
 		free(cref_id);
@@ -27,12 +27,17 @@
 #include "public/scap_ds.h"
 #include "common/list.h"
 #include "common/_error.h"
+#include "common/debug_priv.h"
 #include "common/elements.h"
+#include "oscap_helpers.h"
 #include "sds_index_priv.h"
 #include "source/oscap_source_priv.h"
 #include "source/public/oscap_source.h"
 
+#include <libxml/parser.h>
+#include <libxml/parserInternals.h>
 #include <libxml/xmlreader.h>
+#include <limits.h>
 #include <string.h>
 
 struct ds_stream_index
@@ -47,6 +52,7 @@ struct ds_stream_index
 	struct oscap_stringlist* extended_components;
 
 	struct oscap_htable *component_id_to_component_ref_id;
+	struct oscap_htable *component_ref_id_to_component_id;
 };
 
 struct ds_stream_index* ds_stream_index_new(void)
@@ -63,6 +69,7 @@ struct ds_stream_index* ds_stream_index_new(void)
 	ret->extended_components = oscap_stringlist_new();
 
 	ret->component_id_to_component_ref_id = oscap_htable_new();
+	ret->component_ref_id_to_component_id = oscap_htable_new();
 
 	return ret;
 }
@@ -79,6 +86,7 @@ void ds_stream_index_free(struct ds_stream_index* s)
 	oscap_stringlist_free(s->extended_components);
 
 	oscap_htable_free(s->component_id_to_component_ref_id, (oscap_destruct_func)free);
+	oscap_htable_free(s->component_ref_id_to_component_id, (oscap_destruct_func)free);
 
 	free(s);
 }
@@ -118,6 +126,11 @@ struct oscap_string_iterator* ds_stream_index_get_extended_components(struct ds_
 	return oscap_iterator_new((struct oscap_list*)s->extended_components);
 }
 
+const char *ds_stream_index_get_component_id(struct ds_stream_index* s, const char *component_ref_id)
+{
+	return (const char*)oscap_htable_get(s->component_ref_id_to_component_id, component_ref_id);
+}
+
 static struct ds_stream_index* ds_stream_index_parse(xmlTextReaderPtr reader)
 {
 	// sanity check
@@ -191,6 +204,11 @@ static struct ds_stream_index* ds_stream_index_parse(xmlTextReaderPtr reader)
 
 				// because of the leading '#' in the href preceding the component id
 				const char *component_id = (const char*)(href_attr && href_attr[0] ? (href_attr + 1 * sizeof(char)) : NULL);
+				if (id_attr && href_attr && href_attr[0] == '#') {
+					char *mapped_id = oscap_strdup(component_id);
+					if (!oscap_htable_add(ret->component_ref_id_to_component_id, (const char*)id_attr, mapped_id))
+						free(mapped_id);
+				}
 				if (!component_id || !oscap_htable_add(ret->component_id_to_component_ref_id, component_id, (char*)id_attr)) {
 					if (component_id) {
 						oscap_seterr(OSCAP_EFAMILY_XML,
@@ -211,11 +229,51 @@ static struct ds_stream_index* ds_stream_index_parse(xmlTextReaderPtr reader)
 	return ret;
 }
 
+/*
+ * Profiles of the Benchmark or Tailoring in a component, recorded while
+ * indexing so that they can be listed without importing the XCCDF model.
+ */
+struct ds_profile_title
+{
+	xmlChar *title;
+	int rank;                               ///< rank of the language of the title
+};
+
+struct ds_component_profiles
+{
+	struct oscap_stringlist *ids;
+	struct oscap_htable *titles;            ///< profile id -> ds_profile_title
+};
+
+static void ds_profile_title_free(struct ds_profile_title *t)
+{
+	xmlFree(t->title);
+	free(t);
+}
+
+static struct ds_component_profiles *ds_component_profiles_new(void)
+{
+	struct ds_component_profiles *ret = malloc(sizeof(struct ds_component_profiles));
+	ret->ids = oscap_stringlist_new();
+	ret->titles = oscap_htable_new();
+	return ret;
+}
+
+static void ds_component_profiles_free(struct ds_component_profiles *p)
+{
+	if (p != NULL) {
+		oscap_stringlist_free(p->ids);
+		oscap_htable_free(p->titles, (oscap_destruct_func)ds_profile_title_free);
+		free(p);
+	}
+}
+
 struct ds_sds_index
 {
 	struct oscap_list *streams;
 
 	struct oscap_htable *benchmark_id_to_component_id;
+	struct oscap_htable *component_profiles;
 };
 
 struct ds_sds_index* ds_sds_index_new(void)
@@ -224,6 +282,7 @@ struct ds_sds_index* ds_sds_index_new(void)
 	ret->streams = oscap_list_new();
 
 	ret->benchmark_id_to_component_id = oscap_htable_new();
+	ret->component_profiles = oscap_htable_new();
 
 	return ret;
 }
@@ -234,11 +293,29 @@ void ds_sds_index_free(struct ds_sds_index* s)
 		oscap_list_free(s->streams, (oscap_destruct_func)ds_stream_index_free);
 
 		oscap_htable_free(s->benchmark_id_to_component_id, (oscap_destruct_func)free);
+		oscap_htable_free(s->component_profiles, (oscap_destruct_func)ds_component_profiles_free);
 
 		free(s);
 	}
 }
 
+struct oscap_string_iterator *ds_sds_index_get_profiles(struct ds_sds_index *s, const char *component_id)
+{
+	struct ds_component_profiles *profiles = oscap_htable_get(s->component_profiles, component_id);
+	if (profiles == NULL)
+		return NULL;
+	return oscap_iterator_new((struct oscap_list*)profiles->ids);
+}
+
+const char *ds_sds_index_get_profile_title(struct ds_sds_index *s, const char *component_id, const char *profile_id)
+{
+	struct ds_component_profiles *profiles = oscap_htable_get(s->component_profiles, component_id);
+	if (profiles == NULL)
+		return NULL;
+	struct ds_profile_title *title = oscap_htable_get(profiles->titles, profile_id);
+	return title != NULL ? (const char*)title->title : NULL;
+}
+
 static void ds_sds_index_add_stream(struct ds_sds_index* s, struct ds_stream_index* stream)
 {
 	oscap_list_add(s->streams, stream);
@@ -269,7 +346,40 @@ struct ds_stream_index_iterator* ds_sds_index_get_streams(struct ds_sds_index* s
 	return (struct ds_stream_index_iterator*)oscap_iterator_new(s->streams);
 }
 
-static char *ds_sds_component_dig_benchmark_id(xmlTextReaderPtr reader)
+/*
+ * Rank the language of a title the way oscap_textlist_get_preferred_text
+ * does: the default language first, then a title without any language,
+ * then any other one.
+ */
+static int ds_component_profiles_title_rank(xmlTextReaderPtr reader)
+{
+	xmlChar *lang = xmlTextReaderXmlLang(reader);
+	int rank = lang == NULL ? 1 : (strcmp((const char*)lang, OSCAP_LANG_DEFAULT) == 0 ? 0 : 2);
+	xmlFree(lang);
+	return rank;
+}
+
+static void ds_component_profiles_add_title(struct ds_component_profiles *profiles, const char *profile_id, xmlTextReaderPtr reader)
+{
+	int rank = ds_component_profiles_title_rank(reader);
+	struct ds_profile_title *title = oscap_htable_get(profiles->titles, profile_id);
+	if (title != NULL && title->rank <= rank)
+		return;
+
+	// same as the plain text of the title in the XCCDF model
+	xmlChar *text = xmlTextReaderReadInnerXml(reader);
+	if (text == NULL)
+		return;
+	if (title == NULL) {
+		title = calloc(1, sizeof(struct ds_profile_title));
+		oscap_htable_add(profiles->titles, profile_id, title);
+	}
+	xmlFree(title->title);
+	title->title = text;
+	title->rank = rank;
+}
+
+static char *ds_sds_component_dig_benchmark_id(xmlTextReaderPtr reader, struct ds_component_profiles **profiles)
 {
 	// sanity check
 	if (xmlTextReaderNodeType(reader) != XML_READER_TYPE_ELEMENT ||
@@ -284,6 +394,9 @@ static char *ds_sds_component_dig_benchmark_id(xmlTextReaderPtr reader)
 	}
 
 	char *ret = NULL;
+	// depth of the Benchmark or Tailoring whose profiles are recorded
+	int root_depth = -1;
+	char *profile_id = NULL;
 	while (xmlTextReaderRead(reader) == 1)
 	{
 		int node_type = xmlTextReaderNodeType(reader);
@@ -303,12 +416,40 @@ static char *ds_sds_component_dig_benchmark_id(xmlTextReaderPtr reader)
 			}
 			else {
 				ret = (char*)xmlTextReaderGetAttribute(reader, BAD_CAST "id");
+				if (*profiles == NULL) {
+					*profiles = ds_component_profiles_new();
+					root_depth = xmlTextReaderDepth(reader);
+				}
 			}
 		}
-		else {
-			// ignore
+		else if (node_type == XML_READER_TYPE_ELEMENT &&
+				 strcmp(local_name, "Tailoring") == 0 && *profiles == NULL) {
+			*profiles = ds_component_profiles_new();
+			root_depth = xmlTextReaderDepth(reader);
+		}
+		else if (root_depth >= 0 && node_type == XML_READER_TYPE_ELEMENT) {
+			int depth = xmlTextReaderDepth(reader);
+			if (depth == root_depth + 1) {
+				free(profile_id);
+				profile_id = NULL;
+				if (strcmp(local_name, "Profile") == 0) {
+					profile_id = (char*)xmlTextReaderGetAttribute(reader, BAD_CAST "id");
+					if (profile_id != NULL)
+						oscap_stringlist_add_string((*profiles)->ids, profile_id);
+				}
+			}
+			else if (depth == root_depth + 2 && profile_id != NULL &&
+					 strcmp(local_name, "title") == 0) {
+				ds_component_profiles_add_title(*profiles, profile_id, reader);
+			}
+		}
+		else if (node_type == XML_READER_TYPE_END_ELEMENT &&
+				 xmlTextReaderDepth(reader) == root_depth) {
+			// the profiles are direct children of the first Benchmark or Tailoring only
+			root_depth = -1;
 		}
 	}
+	free(profile_id);
 
 	return ret;
 }
@@ -361,7 +502,13 @@ struct ds_sds_index* ds_sds_index_parse(xmlTextReaderPtr reader)
 		}
 		else if (strcmp(name, "component") == 0) {
 			char *component_id = (char*)xmlTextReaderGetAttribute(reader, BAD_CAST "id");
-			char *benchmark_id = ds_sds_component_dig_benchmark_id(reader);
+			struct ds_component_profiles *profiles = NULL;
+			char *benchmark_id = ds_sds_component_dig_benchmark_id(reader, &profiles);
+
+			if (profiles != NULL && (component_id == NULL ||
+					!oscap_htable_add(ret->component_profiles, component_id, profiles))) {
+				ds_component_profiles_free(profiles);
+			}
 
 			if (benchmark_id == NULL) {
 				free(component_id);
@@ -501,3 +648,273 @@ void ds_stream_index_iterator_free(struct ds_stream_index_iterator *it)
 {
 	oscap_iterator_free((struct oscap_iterator*)it);
 }
+
+struct ds_sds_component_range
+{
+	size_t start;
+	size_t end;
+};
+
+struct ds_sds_component_index
+{
+	const char *memory;
+	size_t size;
+	char *filename;
+
+	size_t root_end;                        ///< end of the start tag of the collection
+	char *root_name;                        ///< qualified name of the collection
+	xmlDoc *doc;                            ///< collection with empty components
+	struct oscap_htable *ranges;            ///< component id -> ds_sds_component_range
+	xmlDict *dict;                          ///< dictionary of the parsed components or NULL
+};
+
+/*
+ * State of the indexing pass. The events are passed to the default SAX2
+ * handlers building DOM except of those inside of the components.
+ */
+struct ds_sds_component_locator
+{
+	struct ds_sds_component_index *index;
+	xmlSAXHandler sax;                      ///< default SAX2 handlers
+	int depth;
+	char *component_id;                     ///< id of the component being skipped
+	size_t component_start;
+	bool failed;
+};
+
+#define DS_LOCATOR(ctx) ((struct ds_sds_component_locator *)((xmlParserCtxtPtr)(ctx))->_private)
+
+static bool ds_sds_component_locator_has_tag(struct ds_sds_component_locator *loc, size_t start, const xmlChar *prefix, const xmlChar *localname)
+{
+	const char *tag = loc->index->memory + start;
+	size_t len = loc->index->size - start;
+
+	if (len < 1 || tag[0] != '<')
+		return false;
+	++tag; --len;
+	if (prefix != NULL) {
+		size_t prefix_len = strlen((const char *)prefix);
+		if (len <= prefix_len || strncmp(tag, (const char *)prefix, prefix_len) != 0 || tag[prefix_len] != ':')
+			return false;
+		tag += prefix_len + 1;
+		len -= prefix_len + 1;
+	}
+	size_t name_len = strlen((const char *)localname);
+	return len > name_len && strncmp(tag, (const char *)localname, name_len) == 0;
+}
+
+static void ds_sds_component_locator_start(void *ctx, const xmlChar *localname, const xmlChar *prefix, const xmlChar *URI,
+	int nb_namespaces, const xmlChar **namespaces, int nb_attributes, int nb_defaulted, const xmlChar **attributes)
+{
+	struct ds_sds_component_locator *loc = DS_LOCATOR(ctx);
+
+	++loc->depth;
+	if (loc->component_id != NULL)
+		return;
+	loc->sax.startElementNs(ctx, localname, prefix, URI, nb_namespaces, namespaces, nb_attributes, nb_defaulted, attributes);
+
+	if (loc->depth > 2)
+		return;
+	// The parser is at the end of the start tag, '<' can't appear inside of it
+	long consumed = xmlByteConsumed((xmlParserCtxtPtr)ctx);
+	if (consumed <= 0 || (size_t)consumed >= loc->index->size) {
+		loc->failed = true;
+		return;
+	}
+	size_t start = consumed;
+	while (start > 0 && loc->index->memory[start] != '<')
+		--start;
+	if (!ds_sds_component_locator_has_tag(loc, start, prefix, localname)) {
+		loc->failed = true;
+		return;
+	}
+
+	if (loc->depth == 1) {
+		const char *end = memchr(loc->index->memory + consumed - 1, '>', loc->index->size - consumed + 1);
+		if (end == NULL) {
+			loc->failed = true;
+			return;
+		}
+		loc->index->root_end = end - loc->index->memory + 1;
+		loc->index->root_name = prefix == NULL ? oscap_strdup((const char *)localname) :
+			oscap_sprintf("%s:%s", (const char *)prefix, (const char *)localname);
+	}
+	else if (strcmp((const char *)localname, "component") == 0 ||
+	         strcmp((const char *)localname, "extended-component") == 0) {
+		xmlNode *component = ((xmlParserCtxtPtr)ctx)->node;
+		loc->component_id = component != NULL ? (char *)xmlGetProp(component, BAD_CAST "id") : NULL;
+		loc->component_start = start;
+		if (loc->component_id == NULL)
+			loc->failed = true;
+	}
+}
+
+static void ds_sds_component_locator_end(void *ctx, const xmlChar *localname, const xmlChar *prefix, const xmlChar *URI)
+{
+	struct ds_sds_component_locator *loc = DS_LOCATOR(ctx);
+
+	if (loc->component_id != NULL && loc->depth == 2) {
+		// The parser is right behind the end tag of the component
+		long consumed = xmlByteConsumed((xmlParserCtxtPtr)ctx);
+		if (consumed <= 0 || (size_t)consumed > loc->index->size || loc->index->memory[consumed - 1] != '>') {
+			loc->failed = true;
+		} else {
+			struct ds_sds_component_range *range = malloc(sizeof(struct ds_sds_component_range));
+			range->start = loc->component_start;
+			range->end = consumed;
+			if (!oscap_htable_add(loc->index->ranges, loc->component_id, range))
+				free(range); // the first component of the id is used, like in the DOM
+		}
+		free(loc->component_id);
+		loc->component_id = NULL;
+	}
+	if (loc->component_id == NULL)
+		loc->sax.endElementNs(ctx, localname, prefix, URI);
+	--loc->depth;
+}
+
+static void ds_sds_component_locator_characters(void *ctx, const xmlChar *ch, int len)
+{
+	struct ds_sds_component_locator *loc = DS_LOCATOR(ctx);
+	if (loc->component_id == NULL)
+		loc->sax.characters(ctx, ch, len);
+}
+
+static void ds_sds_component_locator_cdata(void *ctx, const xmlChar *value, int len)
+{
+	struct ds_sds_component_locator *loc = DS_LOCATOR(ctx);
+	if (loc->component_id == NULL)
+		loc->sax.cdataBlock(ctx, value, len);
+}
+
+static void ds_sds_component_locator_comment(void *ctx, const xmlChar *value)
+{
+	struct ds_sds_component_locator *loc = DS_LOCATOR(ctx);
+	if (loc->component_id == NULL)
+		loc->sax.comment(ctx, value);
+}
+
+static void ds_sds_component_locator_pi(void *ctx, const xmlChar *target, const xmlChar *data)
+{
+	struct ds_sds_component_locator *loc = DS_LOCATOR(ctx);
+	if (loc->component_id == NULL)
+		loc->sax.processingInstruction(ctx, target, data);
+}
+
+static void ds_sds_component_locator_reference(void *ctx, const xmlChar *name)
+{
+	struct ds_sds_component_locator *loc = DS_LOCATOR(ctx);
+	if (loc->component_id == NULL)
+		loc->sax.reference(ctx, name);
+}
+
+static void ds_sds_component_locator_error(void *ctx, xmlErrorPtr error)
+{
+	// The whole document is parsed and the errors are reported if indexing fails
+}
+
+struct ds_sds_component_index *ds_sds_component_index_parse(const char *memory, size_t size, const char *filename, xmlDict *dict)
+{
+	if (size > INT_MAX)
+		return NULL;
+	xmlParserCtxtPtr ctxt = xmlCreateMemoryParserCtxt(memory, size);
+	if (ctxt == NULL)
+		return NULL;
+
+	struct ds_sds_component_index *index = calloc(1, sizeof(struct ds_sds_component_index));
+	index->memory = memory;
+	index->size = size;
+	index->filename = oscap_strdup(filename);
+	index->ranges = oscap_htable_new();
+	if (dict != NULL) {
+		xmlDictReference(dict);
+		index->dict = dict;
+	}
+
+	struct ds_sds_component_locator loc = {
+		.index = index,
+		.sax = *ctxt->sax,
+	};
+	ctxt->_private = &loc;
+	ctxt->sax->startElementNs = ds_sds_component_locator_start;
+	ctxt->sax->endElementNs = ds_sds_component_locator_end;
+	ctxt->sax->characters = ds_sds_component_locator_characters;
+	ctxt->sax->ignorableWhitespace = ds_sds_component_locator_characters;
+	ctxt->sax->cdataBlock = ds_sds_component_locator_cdata;
+	ctxt->sax->comment = ds_sds_component_locator_comment;
+	ctxt->sax->processingInstruction = ds_sds_component_locator_pi;
+	ctxt->sax->reference = ds_sds_component_locator_reference;
+	ctxt->sax->serror = ds_sds_component_locator_error;
+
+	if (dict != NULL) {
+		oscap_source_dict_lock();
+		oscap_source_ctxt_set_dict(ctxt, dict);
+	}
+	xmlParseDocument(ctxt);
+
+	index->doc = ctxt->myDoc;
+	ctxt->myDoc = NULL;
+	// Byte offsets match the content only if it wasn't converted from another encoding
+	bool converted = ctxt->input != NULL && ctxt->input->buf != NULL && ctxt->input->buf->encoder != NULL;
+	if (!ctxt->wellFormed || loc.failed || converted || index->root_name == NULL) {
+		dD("Components of '%s' can't be indexed, the whole document will be parsed.", filename);
+		ds_sds_component_index_free(index);
+		index = NULL;
+	}
+	free(loc.component_id);
+	xmlFreeParserCtxt(ctxt);
+	if (dict != NULL)
+		oscap_source_dict_unlock();
+	return index;
+}
+
+void ds_sds_component_index_free(struct ds_sds_component_index *index)
+{
+	if (index != NULL) {
+		free(index->filename);
+		free(index->root_name);
+		xmlFreeDoc(index->doc);
+		oscap_htable_free(index->ranges, (oscap_destruct_func) free);
+		if (index->dict != NULL)
+			xmlDictFree(index->dict);
+		free(index);
+	}
+}
+
+xmlDoc *ds_sds_component_index_get_xmlDoc(struct ds_sds_component_index *index)
+{
+	return index->doc;
+}
+
+xmlDoc *ds_sds_component_index_parse_component(struct ds_sds_component_index *index, const char *component_id)
+{
+	struct ds_sds_component_range *range = oscap_htable_get(index->ranges, component_id);
+	if (range == NULL)
+		return NULL;
+
+	// The component keeps namespaces and entities declared before it
+	xmlParserCtxtPtr ctxt = xmlCreatePushParserCtxt(NULL, NULL, NULL, 0, index->filename);
+	if (ctxt == NULL)
+		return NULL;
+	if (index->dict != NULL) {
+		oscap_source_dict_lock();
+		oscap_source_ctxt_set_dict(ctxt, index->dict);
+	}
+	char *end_tag = oscap_sprintf("</%s>", index->root_name);
+	xmlParseChunk(ctxt, index->memory, index->root_end, 0);
+	xmlParseChunk(ctxt, index->memory + range->start, range->end - range->start, 0);
+	xmlParseChunk(ctxt, end_tag, strlen(end_tag), 1);
+	free(end_tag);
+
+	xmlDoc *doc = ctxt->myDoc;
+	if (!ctxt->wellFormed) {
+		oscap_setxmlerr(xmlGetLastError());
+		oscap_seterr(OSCAP_EFAMILY_XML, "Unable to parse component '%s' of '%s'.", component_id, index->filename);
+		xmlFreeDoc(doc);
+		doc = NULL;
+	}
+	xmlFreeParserCtxt(ctxt);
+	if (index->dict != NULL)
+		oscap_source_dict_unlock();
+	return doc;
+}
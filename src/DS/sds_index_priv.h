@@ -33,4 +33,35 @@
 
 struct ds_sds_index* ds_sds_index_parse(xmlTextReaderPtr reader);
 
+/**
+ * Byte ranges of the components of a Source DataStream held in memory. They
+ * are recorded in a single pass over the document which also builds DOM of
+ * the collection with the components left empty. A component is parsed from
+ * its range only when it is requested.
+ */
+struct ds_sds_component_index;
+
+/**
+ * Index the components of a Source DataStream. The memory must outlive the
+ * index. The collection and the components are parsed with the dictionary
+ * if it isn't NULL, see oscap_source_set_dict().
+ * @returns the index or NULL if the document can't be indexed, the whole
+ * document has to be parsed then
+ */
+struct ds_sds_component_index *ds_sds_component_index_parse(const char *memory, size_t size, const char *filename, xmlDict *dict);
+void ds_sds_component_index_free(struct ds_sds_component_index *index);
+
+/**
+ * Get DOM of the data-stream-collection with empty components. The document
+ * is owned by the index.
+ */
+xmlDoc *ds_sds_component_index_get_xmlDoc(struct ds_sds_component_index *index);
+
+/**
+ * Parse the component of given id. The document returned contains the
+ * data-stream-collection with the single component and it is owned by the caller.
+ * @returns the document or NULL if there is no such component or it can't be parsed
+ */
+xmlDoc *ds_sds_component_index_parse_component(struct ds_sds_component_index *index, const char *component_id);
+
 #endif
@@ -37,7 +37,8 @@
  * Type of the handler function. This function takes care of handling
  * all the actions defined bellow, that is: initialization, freeing,
  * opening, evaluating, reseting and closing (whatever that means in
- * your particular case).
+ * your particular case). Evaluation can be also split into sending
+ * the object and receiving the result, see @ref oval_probe_query_objects.
  */
 typedef int (oval_probe_handler_t)(oval_subtype_t, void *, int, ...);
 
@@ -48,6 +49,8 @@ typedef int (oval_probe_handler_t)(oval_subtype_t, void *, int, ...);
 #define PROBE_HANDLER_ACT_RESET 4
 #define PROBE_HANDLER_ACT_CLOSE 5
 #define PROBE_HANDLER_ACT_ABORT 6
+#define PROBE_HANDLER_ACT_SEND  7
+#define PROBE_HANDLER_ACT_RECV  8
 
 #define PROBE_HANDLER_IGNORE NULL
 
@@ -30,6 +30,9 @@
 #ifndef _OVAL_PROBE_SESSION
 #define _OVAL_PROBE_SESSION
 
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
 #include "public/oval_probe_session.h"
 #include "_oval_probe_handler.h"
 #include "oval_probe_ext.h"
@@ -45,8 +48,77 @@ struct oval_probe_session {
         struct oval_syschar_model *sys_model; /**< system characteristics model */
         char         *dir;  /**< probe session directory */
         uint32_t      flg;  /**< probe session flags */
+        struct oval_object_cache *ocache; /**< shared collected object cache (not owned) */
+        bool referenced_entities_only; /**< collect only the item entities the definitions use */
+        struct oval_string_map *item_entities; /**< object id -> used item entities */
+        pthread_mutex_t item_entities_lock;
+        struct oval_string_map *sexps; /**< object or state -> S-exp sent to the probes */
+        struct oval_string_map *varrefs; /**< object or state id -> referenced variables */
+        pthread_mutex_t memo_lock; /**< protects sexps and varrefs */
 };
 
+void oval_probe_session_set_object_cache(oval_probe_session_t *sess, struct oval_object_cache *cache);
+
+/*
+ * Let the probes leave out the item entities which no state, filter or
+ * variable of the definitions looks at. Only for sessions whose system
+ * characteristics are not exported.
+ */
+void oval_probe_session_set_referenced_entities_only(oval_probe_session_t *sess, bool referenced_only);
+
+/**
+ * Get the item entities used by the definitions for the object.
+ * @return the names separated by spaces, NULL if all the entities have to
+ * be collected
+ */
+const char *oval_probe_session_item_entities(oval_probe_session_t *sess, struct oval_object *object);
+
+/**
+ * Get the number of existing items which decide all the tests of the
+ * object, when none of them has a state and no variable or set uses its
+ * items. The probe may stop collecting once it has found them.
+ * @return the number of items, 0 if all of them have to be collected
+ */
+uint32_t oval_probe_session_item_limit(oval_probe_session_t *sess, struct oval_object *object);
+
+/**
+ * Get the S-exp of the object as made by oval_object_to_sexp(). It is made
+ * once per object and variable instance and kept until the variables or
+ * the session are reset, unless the object is to be skipped.
+ * @param out_sexp new reference to the S-exp
+ * @return 0 on success, -1 on error
+ */
+int oval_probe_session_object_sexp(oval_probe_session_t *sess, const char *typestr, struct oval_syschar *syschar, SEXP_t **out_sexp);
+
+/**
+ * Get the S-exp of the state as made by oval_state_to_sexp(), kept the
+ * same way as the S-exps of the objects.
+ * @param out_sexp new reference to the S-exp
+ * @return 0 on success, -1 on error
+ */
+int oval_probe_session_state_sexp(oval_probe_session_t *sess, struct oval_state *state, SEXP_t **out_sexp);
+
+/**
+ * Drop the kept S-exps of the objects and states, the values of the
+ * variables they carry are no longer valid.
+ */
+void oval_probe_session_forget_sexps(oval_probe_session_t *sess);
+
+/**
+ * Get the variables the object references, as collected by
+ * oval_obj_collect_var_refs(). The map belongs to the session and is kept
+ * until the session is reset.
+ * @return variable id -> struct oval_variable
+ */
+struct oval_string_map *oval_probe_session_object_varrefs(oval_probe_session_t *sess, struct oval_object *object);
+
+/**
+ * Get the variables the state references, as collected by
+ * oval_ste_collect_var_refs().
+ * @see oval_probe_session_object_varrefs
+ */
+struct oval_string_map *oval_probe_session_state_varrefs(oval_probe_session_t *sess, struct oval_state *state);
+
 #endif /* _OVAL_PROBE_SESSION */
 
 /// @}
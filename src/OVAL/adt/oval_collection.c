@@ -42,30 +42,56 @@
 /* Variable definitions
  * */
 
-typedef struct _oval_collection_item_frame {
-	struct _oval_collection_item_frame *next;
-	void *item;
-} _oval_collection_item_frame_t;
+#define OVAL_COLLECTION_MIN_ALLOC 4
 
+/* The items are kept in an array in the order they were added */
 typedef struct oval_collection {
-	struct _oval_collection_item_frame *item_collection_frame;
+	void **items;
+	size_t count;
+	size_t alloc;
 } oval_collection_t;
 
+/*
+ * An iterator of a collection walks the array of the collection in place,
+ * up to the items present when it was created. An iterator created by
+ * oval_collection_iterator_new() holds its own items and returns them in
+ * reverse order of oval_collection_iterator_add().
+ */
 typedef struct oval_iterator {
-	struct _oval_collection_item_frame *item_iterator_frame;
+	struct oval_collection *collection;	/* NULL if the iterator holds its own items */
+	void **items;
+	size_t pos;
+	size_t count;
+	size_t alloc;
 } oval_iterator_t;
 
 /* End of variable definitions
  * */
 /***************************************************************************/
 
+static bool oval_collection_reserve(void ***items, size_t *alloc, size_t count)
+{
+	if (count < *alloc)
+		return true;
+
+	size_t new_alloc = *alloc ? *alloc * 2 : OVAL_COLLECTION_MIN_ALLOC;
+	void **new_items = realloc(*items, new_alloc * sizeof(void *));
+	if (new_items == NULL)
+		return false;
+	*items = new_items;
+	*alloc = new_alloc;
+	return true;
+}
+
 struct oval_collection *oval_collection_new()
 {
 	struct oval_collection *collection = (struct oval_collection *)malloc(sizeof(oval_collection_t));
 	if (collection == NULL)
 		return NULL;
 
-	collection->item_collection_frame = NULL;
+	collection->items = NULL;
+	collection->count = 0;
+	collection->alloc = 0;
 	return collection;
 }
 
@@ -77,19 +103,15 @@ void oval_collection_free(struct oval_collection *collection)
 void oval_collection_free_items(struct oval_collection *collection, oscap_destruct_func free_func)
 {
 	if (collection) {
-		struct _oval_collection_item_frame *frame = collection->item_collection_frame;
-		while (frame != NULL) {
-			if (free_func != NULL) {
-				void *item = frame->item;
+		if (free_func != NULL) {
+			/* the last added item first, like it always was */
+			for (size_t i = collection->count; i > 0; --i) {
+				void *item = collection->items[i - 1];
 				if (item)
 					(*free_func) (item);
-				frame->item = NULL;
 			}
-			struct _oval_collection_item_frame *temp = frame;
-			frame = frame->next;
-			temp->next = NULL;
-			free(temp);
 		}
+		free(collection->items);
 		free(collection);
 	}
 }
@@ -97,20 +119,16 @@ void oval_collection_free_items(struct oval_collection *collection, oscap_destru
 int oval_collection_is_empty(struct oval_collection *collection)
 {
 	__attribute__nonnull__(collection);
-	return collection->item_collection_frame == NULL;
+	return collection->count == 0;
 }
 
 void oval_collection_add(struct oval_collection *collection, void *item)
 {
 	__attribute__nonnull__(collection);
 
-	struct _oval_collection_item_frame *next = malloc(sizeof(_oval_collection_item_frame_t));
-	if (next == NULL)
+	if (!oval_collection_reserve(&collection->items, &collection->alloc, collection->count))
 		return;
-
-	next->next = collection->item_collection_frame;
-	collection->item_collection_frame = next;
-	next->item = item;
+	collection->items[collection->count++] = item;
 }
 
 struct oval_iterator *oval_collection_iterator(struct oval_collection *collection)
@@ -121,18 +139,11 @@ struct oval_iterator *oval_collection_iterator(struct oval_collection *collectio
 	if (iterator == NULL)
 		return NULL;
 
-	iterator->item_iterator_frame = NULL;
-	struct _oval_collection_item_frame *collection_frame = collection->item_collection_frame;
-
-	while (collection_frame != NULL) {
-		struct _oval_collection_item_frame *iterator_frame =
-		    (struct _oval_collection_item_frame *)malloc(sizeof(_oval_collection_item_frame_t));
-
-		iterator_frame->next = iterator->item_iterator_frame;
-		iterator_frame->item = collection_frame->item;
-		iterator->item_iterator_frame = iterator_frame;
-		collection_frame = collection_frame->next;
-	}
+	iterator->collection = collection;
+	iterator->items = NULL;
+	iterator->pos = 0;
+	iterator->count = collection->count;
+	iterator->alloc = 0;
 	return iterator;
 }
 
@@ -140,53 +151,31 @@ bool oval_collection_iterator_has_more(struct oval_iterator * iterator)
 {
 	__attribute__nonnull__(iterator);
 
-	return iterator->item_iterator_frame != NULL;
+	return iterator->pos < iterator->count;
 }
 
 int oval_collection_iterator_remaining(struct oval_iterator *iterator)
 {
 	__attribute__nonnull__(iterator);
 
-	int remaining;
-	struct _oval_collection_item_frame *next = iterator->item_iterator_frame;
-
-	for (remaining = 0; next; remaining++)
-		next = next->next;
-
-	return remaining;
+	return iterator->count - iterator->pos;
 }
 
 void *oval_collection_iterator_next(struct oval_iterator *iterator)
 {
 	__attribute__nonnull__(iterator);
 
-	struct _oval_collection_item_frame *oc_next = iterator->item_iterator_frame;
-	void *next;
-
-	if (oc_next == NULL) {
-		next = NULL;
-	} else {
-		next = oc_next->item;
-		iterator->item_iterator_frame = oc_next->next;
-		oc_next->item = NULL;
-		oc_next->next = NULL;
-		free(oc_next);
-	}
-	return next;
+	if (iterator->pos >= iterator->count)
+		return NULL;
+	if (iterator->collection != NULL)
+		return iterator->collection->items[iterator->pos++];
+	return iterator->items[iterator->count - ++iterator->pos];
 }
 
 void oval_collection_iterator_free(struct oval_iterator *iterator)
 {
 	if (iterator) {		//NOOP if iterator is NULL
-		while (iterator->item_iterator_frame) {
-			struct _oval_collection_item_frame *oc_this;
-			oc_this = iterator->item_iterator_frame;
-			iterator->item_iterator_frame = oc_this->next;
-			oc_this->item = NULL;
-			oc_this->next = NULL;
-			free(oc_this);
-		}
-		iterator->item_iterator_frame = NULL;
+		free(iterator->items);
 		free(iterator);
 	}
 }
@@ -197,7 +186,11 @@ struct oval_iterator *oval_collection_iterator_new()
 	if (iterator == NULL)
 		return NULL;
 
-	iterator->item_iterator_frame = NULL;
+	iterator->collection = NULL;
+	iterator->items = NULL;
+	iterator->pos = 0;
+	iterator->count = 0;
+	iterator->alloc = 0;
 	return iterator;
 }
 
@@ -205,14 +198,9 @@ void oval_collection_iterator_add(struct oval_iterator *iterator, void *item)
 {
 	__attribute__nonnull__(iterator);
 
-	struct _oval_collection_item_frame *newframe =
-	    (struct _oval_collection_item_frame *)malloc(sizeof(_oval_collection_item_frame_t));
-	if (newframe == NULL)	/* We don't have any information that error occurred ! */
-		return;
-
-	newframe->next = iterator->item_iterator_frame;
-	newframe->item = item;
-	iterator->item_iterator_frame = newframe;
+	if (!oval_collection_reserve(&iterator->items, &iterator->alloc, iterator->count))
+		return;	/* We don't have any information that error occurred ! */
+	iterator->items[iterator->count++] = item;
 }
 
 bool oval_string_iterator_has_more(struct oval_string_iterator * iterator)
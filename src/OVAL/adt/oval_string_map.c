@@ -35,6 +35,8 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
 
 #include "oval_string_map_impl.h"
 #include "common/util.h"
@@ -192,25 +194,206 @@ void oval_string_map_free_string(struct oval_string_map *map)
 	oval_string_map_free(map, free);
 }
 #else
-# include "probes/SEAP/generic/rbt/rbt.h"
+/*
+ * Open addressing hash table with linear probing. The entries are kept in
+ * a dense array and the slots only hold the hash of the key and the index
+ * of the entry, so a lookup touches one cache line of slots and compares
+ * the strings of the matching hashes only. The keys, values and
+ * collections are returned ordered by key, from a sorted copy of the
+ * entries after an out of order insertion. Only insertions modify the
+ * map, it can be read by several threads at once.
+ */
+struct oval_string_map_entry {
+	char    *key;
+	void    *val;
+	uint32_t hash;
+	uint32_t keylen;
+};
+
+struct oval_string_map_slot {
+	uint32_t hash;
+	uint32_t index; /* entry index + 1, 0 marks an empty slot */
+};
+
+struct oval_string_map {
+	struct oval_string_map_entry *entries;
+	uint32_t count;
+	uint32_t capacity;
+	struct oval_string_map_slot *slots;
+	uint32_t mask;  /* number of slots - 1 */
+	bool     sorted;  /* the entries were inserted ordered by key */
+};
+
+#define OVAL_STRING_MAP_MINSLOTS 16
+
+/* FNV-1a, computes the length of the key too */
+static uint32_t oval_string_map_hash(const char *key, uint32_t *keylen)
+{
+	const unsigned char *p = (const unsigned char *)key;
+	uint32_t hash = 2166136261U;
+
+	while (*p != '\0') {
+		hash ^= *p++;
+		hash *= 16777619U;
+	}
+
+	*keylen = (uint32_t)(p - (const unsigned char *)key);
+	return hash;
+}
 
 struct oval_string_map *oval_string_map_new(void)
 {
-	return (struct oval_string_map *)(rbt_str_new());
+	struct oval_string_map *map = malloc(sizeof(struct oval_string_map));
+
+	if (map == NULL)
+		return NULL;
+
+	map->entries = NULL;
+	map->count = 0;
+	map->capacity = 0;
+	map->slots = NULL;
+	map->mask = 0;
+	map->sorted = true;
+
+	return map;
+}
+
+static void oval_string_map_slot_insert(struct oval_string_map *map, uint32_t hash, uint32_t index)
+{
+	uint32_t i = hash & map->mask;
+
+	while (map->slots[i].index != 0)
+		i = (i + 1) & map->mask;
+
+	map->slots[i].hash = hash;
+	map->slots[i].index = index + 1;
+}
+
+static int oval_string_map_rehash(struct oval_string_map *map, uint32_t nslots)
+{
+	struct oval_string_map_slot *slots;
+	uint32_t i;
+
+	slots = calloc(nslots, sizeof(struct oval_string_map_slot));
+	if (slots == NULL)
+		return -1;
+
+	free(map->slots);
+	map->slots = slots;
+	map->mask = nslots - 1;
+
+	for (i = 0; i < map->count; ++i)
+		oval_string_map_slot_insert(map, map->entries[i].hash, i);
+
+	return 0;
+}
+
+static struct oval_string_map_entry *oval_string_map_find(struct oval_string_map *map, const char *key,
+                                                          uint32_t hash, uint32_t keylen)
+{
+	uint32_t i;
+
+	if (map->slots == NULL)
+		return NULL;
+
+	for (i = hash & map->mask; map->slots[i].index != 0; i = (i + 1) & map->mask) {
+		if (map->slots[i].hash == hash) {
+			struct oval_string_map_entry *entry = &map->entries[map->slots[i].index - 1];
+
+			if (entry->keylen == keylen && memcmp(entry->key, key, keylen) == 0)
+				return entry;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * Insert a new key, the map takes the ownership of key. Returns -1 if the
+ * key is already present, the old value is kept in that case.
+ */
+static int oval_string_map_insert(struct oval_string_map *map, char *key, void *val)
+{
+	struct oval_string_map_entry *entry;
+	uint32_t hash, keylen;
+
+	hash = oval_string_map_hash(key, &keylen);
+
+	if (oval_string_map_find(map, key, hash, keylen) != NULL)
+		return -1;
+
+	if (map->count == map->capacity) {
+		uint32_t capacity = map->capacity == 0 ? OVAL_STRING_MAP_MINSLOTS / 2 : 2 * map->capacity;
+
+		entry = realloc(map->entries, capacity * sizeof(struct oval_string_map_entry));
+		if (entry == NULL)
+			return -1;
+
+		map->entries = entry;
+		map->capacity = capacity;
+	}
+
+	/* keep the load factor under 3/4 */
+	if (map->slots == NULL || 4 * (map->count + 1) > 3 * (map->mask + 1)) {
+		if (oval_string_map_rehash(map, map->slots == NULL ?
+		                           OVAL_STRING_MAP_MINSLOTS : 2 * (map->mask + 1)) != 0)
+			return -1;
+	}
+
+	if (map->sorted && map->count > 0)
+		map->sorted = strcmp(map->entries[map->count - 1].key, key) < 0;
+
+	entry = &map->entries[map->count];
+	entry->key = key;
+	entry->val = val;
+	entry->hash = hash;
+	entry->keylen = keylen;
+
+	oval_string_map_slot_insert(map, hash, map->count++);
+
+	return 0;
+}
+
+static int oval_string_map_entry_cmp(const void *a, const void *b)
+{
+	return strcmp(((const struct oval_string_map_entry *)a)->key,
+	              ((const struct oval_string_map_entry *)b)->key);
+}
+
+/*
+ * Get the entries ordered by key, either the entries of the map or a sorted
+ * copy which has to be freed by the caller. The entries are returned in
+ * the order of insertion if the copy can't be made.
+ */
+static struct oval_string_map_entry *oval_string_map_sorted(const struct oval_string_map *map)
+{
+	struct oval_string_map_entry *entries;
+
+	if (map->sorted)
+		return map->entries;
+
+	entries = malloc(map->count * sizeof(struct oval_string_map_entry));
+	if (entries == NULL)
+		return map->entries;
+
+	memcpy(entries, map->entries, map->count * sizeof(struct oval_string_map_entry));
+	qsort(entries, map->count, sizeof(struct oval_string_map_entry), oval_string_map_entry_cmp);
+
+	return entries;
 }
 
 void oval_string_map_put(struct oval_string_map *map, const char *key, void *val)
 {
-        char *key_copy;
+	char *key_copy;
 
 	if (map == NULL || key == NULL) {
 		return;
 	}
 
-	if (rbt_str_add((rbt_t *)map, key_copy = strdup(key), val) != 0) {
-		dD("rbt_str_add: non-zero return code");
-                free(key_copy);
-        }
+	if (oval_string_map_insert(map, key_copy = strdup(key), val) != 0) {
+		dD("oval_string_map_insert: key '%s' not inserted", key);
+		free(key_copy);
+	}
 }
 
 void oval_string_map_put_string(struct oval_string_map *map, const char *key, const char *val)
@@ -220,44 +403,44 @@ void oval_string_map_put_string(struct oval_string_map *map, const char *key, co
 	}
 	char *str = strdup(val), *key_copy;
 
-	if (rbt_str_add((rbt_t *)map, key_copy = strdup(key), str) == 0)
-		return;
-	else {
+	if (oval_string_map_insert(map, key_copy = strdup(key), str) != 0) {
 		free(str);
-                free(key_copy);
-        }
-	return;
+		free(key_copy);
+	}
 }
 
 void *oval_string_map_get_value(struct oval_string_map *map, const char *key)
 {
-	void *val = NULL;
+	struct oval_string_map_entry *entry;
+	uint32_t hash, keylen;
 
 	if (map == NULL || key == NULL) {
 		return NULL;
 	}
 
-	if (rbt_str_get((rbt_t *)map, key, &val) != 0)
-		return (NULL);
-	else
-		return (val);
-}
+	hash = oval_string_map_hash(key, &keylen);
+	entry = oval_string_map_find(map, key, hash, keylen);
 
-static void __oval_string_map_node_free(struct rbt_str_node *n, oscap_destruct_func destroy)
-{
-	if (destroy != NULL)
-		destroy(n->data);
-	free(n->key);
+	return entry != NULL ? entry->val : NULL;
 }
 
 void oval_string_map_free(struct oval_string_map *map, oscap_destruct_func destroy)
 {
+	uint32_t i;
+
 	if (map == NULL) {
 		return;
 	}
-	rbt_str_free_cb2((rbt_t *)map,
-			 (void(*)(struct rbt_str_node *, void *))__oval_string_map_node_free,
-			 (void *)destroy);
+
+	for (i = 0; i < map->count; ++i) {
+		if (destroy != NULL)
+			destroy(map->entries[i].val);
+		free(map->entries[i].key);
+	}
+
+	free(map->entries);
+	free(map->slots);
+	free(map);
 }
 
 void oval_string_map_free0(struct oval_string_map *map)
@@ -273,72 +456,70 @@ void oval_string_map_free_string(struct oval_string_map *map)
 	oval_string_map_free(map, free);
 }
 
-static int __oval_iterator_addkey(struct rbt_str_node *n, void *u)
-{
-	struct oval_iterator *it = (struct oval_iterator *)u;
-
-	oval_collection_iterator_add(it, (void *)n->key);
-
-	return (0);
-}
-
-static int __oval_iterator_addval(struct rbt_str_node *n, void *u)
-{
-	struct oval_iterator *it = (struct oval_iterator *)u;
-
-	oval_collection_iterator_add(it, n->data);
-
-	return (0);
-}
-
-static int __oval_collection_addval(struct rbt_str_node *n, void *u)
-{
-	struct oval_collection *c = (struct oval_collection *)u;
-
-	oval_collection_add(c, n->data);
-
-	return (0);
-}
-
 struct oval_iterator *oval_string_map_keys(struct oval_string_map *map)
 {
+	struct oval_string_map_entry *entries;
 	struct oval_iterator *it;
+	uint32_t i;
 
 	if (map == NULL) {
 		return NULL;
 	}
 
+	entries = oval_string_map_sorted(map);
+
 	it = oval_collection_iterator_new();
-	rbt_str_walk_inorder2((rbt_t *)map, __oval_iterator_addkey, it, 0);
+	for (i = 0; i < map->count; ++i)
+		oval_collection_iterator_add(it, (void *)entries[i].key);
+
+	if (entries != map->entries)
+		free(entries);
 
 	return (it);
 }
 
 struct oval_iterator *oval_string_map_values(struct oval_string_map *map)
 {
+	struct oval_string_map_entry *entries;
 	struct oval_iterator *it;
+	uint32_t i;
 
 	if (map == NULL) {
 		return NULL;
 	}
 
+	entries = oval_string_map_sorted(map);
+
 	it = oval_collection_iterator_new();
-	rbt_str_walk_inorder2((rbt_t *)map, __oval_iterator_addval, it, 0);
+	for (i = 0; i < map->count; ++i)
+		oval_collection_iterator_add(it, entries[i].val);
+
+	if (entries != map->entries)
+		free(entries);
 
 	return (it);
 }
 
 struct oval_collection *oval_string_map_collect_values(struct oval_string_map *map, struct oval_collection *collection)
 {
+	struct oval_string_map_entry *entries;
+	uint32_t i;
+
 	if (map == NULL) {
 		return NULL;
 	}
 
+	entries = oval_string_map_sorted(map);
+
 	if (collection == NULL)
 		collection = oval_collection_new();
-	rbt_str_walk_inorder2((rbt_t *)map, __oval_collection_addval, collection, 0);
+	for (i = 0; i < map->count; ++i)
+		oval_collection_add(collection, entries[i].val);
+
+	if (entries != map->entries)
+		free(entries);
 
 	return (collection);
 }
 
-#endif /* OVAL_STRINGMAP_LINEAR */
+#endif /* OVAL_STRINGMAP_OLD */
@@ -54,6 +54,9 @@ static void _comp_collect_var_refs(struct oval_component *comp, struct oval_stri
 	case OVAL_FUNCTION_SPLIT:
 	case OVAL_FUNCTION_SUBSTRING:
 	case OVAL_FUNCTION_TIMEDIF:
+	case OVAL_FUNCTION_COUNT:
+	case OVAL_FUNCTION_UNIQUE:
+	case OVAL_FUNCTION_GLOB_TO_REGEX:
 		cmp_itr = oval_component_get_function_components(comp);
 		while (oval_component_iterator_has_more(cmp_itr)) {
 			struct oval_component *cmp;
@@ -83,6 +86,11 @@ static void _var_collect_var_refs(struct oval_variable *var, struct oval_string_
 	}
 }
 
+void oval_var_collect_var_refs(struct oval_variable *var, struct oval_string_map *vm)
+{
+	_var_collect_var_refs(var, vm);
+}
+
 static void _ent_collect_var_refs(struct oval_entity *ent, struct oval_string_map *vm)
 {
 	oval_entity_varref_type_t vrt;
@@ -203,19 +203,21 @@ static int _oval_affected_parse_tag(xmlTextReaderPtr reader, struct oval_parser_
 	//xmlChar *namespace = xmlTextReaderNamespaceUri(reader);
 
 	if (strcmp((char *)tagname, "platform") == 0) {
-		char *platform = NULL;
-		return_code = oscap_parser_text_value(reader, &oscap_text_consumer, &platform);
-		if (platform != NULL) {
-			oval_affected_add_platform(affected, platform);
-			free(platform);
-		}
+		struct oscap_strbuf platform;
+		oscap_strbuf_init(&platform);
+		bool empty = xmlTextReaderIsEmptyElement(reader);
+		return_code = oscap_parser_text_append(reader, &platform);
+		if (!empty)
+			oval_affected_add_platform(affected, (char *)oscap_strbuf_get(&platform));
+		oscap_strbuf_release(&platform);
 	} else if (strcmp((char *)tagname, "product") == 0) {
-		char *product = NULL;
-		return_code = oscap_parser_text_value(reader, &oscap_text_consumer, &product);
-		if (product != NULL) {
-			oval_affected_add_product(affected, product);
-			free(product);
-		}
+		struct oscap_strbuf product;
+		oscap_strbuf_init(&product);
+		bool empty = xmlTextReaderIsEmptyElement(reader);
+		return_code = oscap_parser_text_append(reader, &product);
+		if (!empty)
+			oval_affected_add_product(affected, (char *)oscap_strbuf_get(&product));
+		oscap_strbuf_release(&product);
 	} else {
 		dD("Skipping tag: %s", tagname);
 		return_code = oval_parser_skip_tag(reader, context);
@@ -32,8 +32,11 @@
 #include <config.h>
 #endif
 
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <pthread.h>
 
 #include "oval_agent_api.h"
 #include "oval_definitions_impl.h"
@@ -42,14 +45,17 @@
 #include "adt/oval_string_map_impl.h"
 #include "oval_system_characteristics_impl.h"
 #include "results/oval_results_impl.h"
+#include "oval_object_cache_impl.h"
 #if defined(OVAL_PROBES_ENABLED)
 # include "oval_probe_impl.h"
+# include "_oval_probe_session.h"
 #endif
 #include "common/list.h"
 #include "common/util.h"
 #include "common/debug_priv.h"
 #include "common/_error.h"
 #include "oval_agent_xccdf_api.h"
+#include "common/oscap_threadpool.h"
 
 struct oval_agent_session {
 	char *filename;
@@ -57,6 +63,7 @@ struct oval_agent_session {
 
 	struct oval_definition_model * def_model;
 	struct oval_variable_model *cur_var_model;
+	struct oscap_stringlist *bound_values;		///< names and values of the last resolved bindings
 	struct oval_syschar_model    * sys_model;
 	struct oval_syschar_model    * sys_models[2];
 #if defined(OVAL_PROBES_ENABLED)
@@ -103,6 +110,7 @@ oval_agent_session_t * oval_agent_new_session(struct oval_definition_model *mode
 	ag_sess->filename = oscap_strdup(name);
 	ag_sess->def_model = model;
 	ag_sess->cur_var_model = NULL;
+	ag_sess->bound_values = NULL;
 	ag_sess->sys_model = oval_syschar_model_new(model);
 #if defined(OVAL_PROBES_ENABLED)
 	ag_sess->psess     = oval_probe_session_new(ag_sess->sys_model);
@@ -177,6 +185,10 @@ int oval_agent_eval_definition(oval_agent_session_t *ag_sess, const char *id)
 	struct oval_result_system *rsystem;
 
 	rsystem = _oval_agent_get_first_result_system(ag_sess);
+	/* probe all the objects of the definition at once */
+	struct oval_definition *definition = oval_definition_model_get_definition(ag_sess->def_model, id);
+	if (definition != NULL)
+		oval_probe_query_definition(ag_sess->psess, definition);
 	/* eval */
 	ret = oval_result_system_eval_definition(rsystem, id);
 	return ret;
@@ -186,6 +198,18 @@ int oval_agent_eval_definition(oval_agent_session_t *ag_sess, const char *id)
 #endif
 }
 
+int oval_agent_collect_definitions(oval_agent_session_t *ag_sess, struct oscap_stringlist *ids)
+{
+#if defined(OVAL_PROBES_ENABLED)
+	if (ag_sess == NULL || ag_sess->psess == NULL)
+		return -1;
+	return oval_probe_query_definition_list(ag_sess->psess, ag_sess->def_model, ids, true);
+#else
+	/* TODO */
+	return -1;
+#endif
+}
+
 int oval_agent_get_definition_result(oval_agent_session_t *ag_sess, const char *id, oval_result_t * result)
 {
 	struct oval_result_system *rsystem;
@@ -221,9 +245,23 @@ struct oval_result_definition * oval_agent_get_result_definition(oval_agent_sess
 	return rdef;
 }
 
-int oval_agent_reset_session(oval_agent_session_t * ag_sess) {
+static void _oval_agent_reset_variables(oval_agent_session_t *ag_sess)
+{
 	ag_sess->cur_var_model = NULL;
+	oscap_stringlist_free(ag_sess->bound_values);
+	ag_sess->bound_values = NULL;
 	oval_definition_model_clear_external_variables(ag_sess->def_model);
+	/* Local variables are computed once and kept for the whole session,
+	 * only those depending on the external values are computed again */
+	oval_definition_model_reset_local_variables(ag_sess->def_model);
+#if defined(OVAL_PROBES_ENABLED)
+	/* the objects and states made for the probes carry the old values */
+	oval_probe_session_forget_sexps(ag_sess->psess);
+#endif
+}
+
+int oval_agent_reset_session(oval_agent_session_t * ag_sess) {
+	_oval_agent_reset_variables(ag_sess);
 
 	/* We intentionally do not flush out the results model which should
 	 * be able to encompass results from multiple evaluations */
@@ -254,6 +292,39 @@ int oval_agent_reset_session(oval_agent_session_t * ag_sess) {
 	return 0;
 }
 
+int oval_agent_clear_session(oval_agent_session_t *ag_sess)
+{
+	_oval_agent_reset_variables(ag_sess);
+#if defined(OVAL_PROBES_ENABLED)
+	oval_results_model_clear(ag_sess->res_model);
+#endif
+	oval_syschar_model_reset(ag_sess->sys_model);
+#if defined(OVAL_PROBES_ENABLED)
+	/* The probes keep running, only their caches are dropped */
+	if (oval_probe_session_reset(ag_sess->psess, ag_sess->sys_model) != 0)
+		return -1;
+#endif
+	return 0;
+}
+
+void oval_agent_set_object_cache(oval_agent_session_t *ag_sess, struct oval_object_cache *cache)
+{
+	if (ag_sess == NULL)
+		return;
+#if defined(OVAL_PROBES_ENABLED)
+	oval_probe_session_set_object_cache(ag_sess->psess, cache);
+#endif
+}
+
+void oval_agent_set_referenced_entities_only(oval_agent_session_t *ag_sess, bool referenced_only)
+{
+	if (ag_sess == NULL)
+		return;
+#if defined(OVAL_PROBES_ENABLED)
+	oval_probe_session_set_referenced_entities_only(ag_sess->psess, referenced_only);
+#endif
+}
+
 int oval_agent_abort_session(oval_agent_session_t *ag_sess)
 {
 	if (ag_sess == NULL) {
@@ -270,6 +341,184 @@ int oval_agent_abort_session(oval_agent_session_t *ag_sess)
 #endif
 }
 
+#if defined(OVAL_PROBES_ENABLED)
+#define OVAL_AGENT_EVAL_MAX_JOBS 64
+
+struct oval_agent_eval_pool {
+	struct oval_result_test **tests;
+	size_t count;
+	size_t size;
+	size_t next;                    ///< first test which isn't taken by a thread
+	pthread_mutex_t lock;
+};
+
+/* Number of threads evaluating the tests, the definitions are evaluated one by one if it is 1 */
+static size_t _oval_agent_eval_jobs(void)
+{
+	return oscap_threadpool_jobs("OSCAP_OVAL_EVAL_JOBS", 1, OVAL_AGENT_EVAL_MAX_JOBS);
+}
+
+/* Gather the tests of the criteria tree and of the extended definitions, each of them once */
+static void _oval_agent_collect_tests(struct oval_result_criteria_node *node, struct oval_string_map *seen,
+				      struct oval_agent_eval_pool *pool)
+{
+	char key[32];
+
+	if (node == NULL)
+		return;
+
+	switch (oval_result_criteria_node_get_type(node)) {
+	case OVAL_NODETYPE_CRITERIA: {
+		struct oval_result_criteria_node_iterator *subnodes = oval_result_criteria_node_get_subnodes(node);
+		while (oval_result_criteria_node_iterator_has_more(subnodes))
+			_oval_agent_collect_tests(oval_result_criteria_node_iterator_next(subnodes), seen, pool);
+		oval_result_criteria_node_iterator_free(subnodes);
+	} break;
+	case OVAL_NODETYPE_CRITERION: {
+		struct oval_result_test *rtest = oval_result_criteria_node_get_test(node);
+
+		snprintf(key, sizeof(key), "%p", (void *)rtest);
+		if (rtest == NULL || oval_string_map_get_value(seen, key) != NULL)
+			break;
+		oval_string_map_put(seen, key, rtest);
+
+		if (pool->count == pool->size) {
+			pool->size = pool->size ? pool->size * 2 : 64;
+			pool->tests = realloc(pool->tests, pool->size * sizeof(struct oval_result_test *));
+		}
+		pool->tests[pool->count++] = rtest;
+	} break;
+	case OVAL_NODETYPE_EXTENDDEF: {
+		struct oval_result_definition *rdef = oval_result_criteria_node_get_extends(node);
+
+		snprintf(key, sizeof(key), "%p", (void *)rdef);
+		if (rdef == NULL || oval_string_map_get_value(seen, key) != NULL)
+			break;
+		oval_string_map_put(seen, key, rdef);
+		_oval_agent_collect_tests(oval_result_definition_get_criteria(rdef), seen, pool);
+	} break;
+	default:
+		break;
+	}
+}
+
+static void *_oval_agent_eval_thread(void *arg)
+{
+	struct oval_agent_eval_pool *pool = arg;
+	struct oval_result_test *rtest;
+
+	for (;;) {
+		pthread_mutex_lock(&pool->lock);
+		if (pool->next == pool->count) {
+			pthread_mutex_unlock(&pool->lock);
+			break;
+		}
+		rtest = pool->tests[pool->next++];
+		pthread_mutex_unlock(&pool->lock);
+
+		oval_result_test_eval_collected(rtest);
+	}
+
+	return NULL;
+}
+
+/* The objects are probed and the variables are computed one test after another,
+ * then the items of the tests are compared to the states by a pool of threads */
+static void _oval_agent_eval_tests(struct oval_agent_eval_pool *pool, size_t jobs)
+{
+	pthread_t threads[OVAL_AGENT_EVAL_MAX_JOBS];
+	size_t i, count = 0, started = 0;
+
+	for (i = 0; i < pool->count; i++) {
+		if (oval_result_test_collect(pool->tests[i]) != 0)
+			oval_result_test_eval(pool->tests[i]);
+		else
+			pool->tests[count++] = pool->tests[i];
+	}
+	pool->count = count;
+	pool->next = 0;
+
+	if (jobs > count)
+		jobs = count;
+
+	pthread_mutex_init(&pool->lock, NULL);
+	for (i = 1; i < jobs; i++) {
+		int err = pthread_create(&threads[started], NULL, _oval_agent_eval_thread, pool);
+
+		if (err != 0) {
+			dW("Can't start a test evaluation thread: %s.", strerror(err));
+			break;
+		}
+		started++;
+	}
+	/* the calling thread takes part too */
+	_oval_agent_eval_thread(pool);
+
+	for (i = 0; i < started; i++)
+		pthread_join(threads[i], NULL);
+	pthread_mutex_destroy(&pool->lock);
+}
+
+/* Evaluate the tests of all the definitions at once, then report the definitions in document order */
+static int _oval_agent_eval_system_parallel(oval_agent_session_t *ag_sess, agent_reporter cb, void *arg, size_t jobs)
+{
+	struct oval_result_system *rsystem;
+	struct oval_definition_iterator *oval_def_it;
+	struct oval_string_map *seen;
+	struct oval_agent_eval_pool pool;
+	struct oscap_list *rdefs;
+	struct oscap_iterator *rdef_it;
+	int ret = 0;
+
+	rsystem = _oval_agent_get_first_result_system(ag_sess);
+	memset(&pool, 0, sizeof(pool));
+	seen = oval_string_map_new();
+	rdefs = oscap_list_new();
+
+	/* all the result definitions and tests are created before the threads start */
+	oval_def_it = oval_definition_model_get_definitions(ag_sess->def_model);
+	while (oval_definition_iterator_has_more(oval_def_it)) {
+		struct oval_definition *oval_def = oval_definition_iterator_next(oval_def_it);
+		struct oval_result_definition *rdef;
+
+		oval_probe_query_definition(ag_sess->psess, oval_def);
+		rdef = oval_result_system_prepare_definition(rsystem, oval_definition_get_id(oval_def));
+		if (rdef == NULL) {
+			ret = -1;
+			break;
+		}
+		oscap_list_add(rdefs, rdef);
+		_oval_agent_collect_tests(oval_result_definition_get_criteria(rdef), seen, &pool);
+	}
+	oval_definition_iterator_free(oval_def_it);
+	oval_string_map_free(seen, NULL);
+
+	dI("Evaluating %zu tests using %zu threads.", pool.count, jobs);
+	_oval_agent_eval_tests(&pool, jobs);
+	free(pool.tests);
+
+	/* as in the sequential mode, nothing is reported after a definition which can't be prepared */
+	rdef_it = oscap_iterator_new(rdefs);
+	while (oscap_iterator_has_more(rdef_it)) {
+		struct oval_result_definition *rdef = oscap_iterator_next(rdef_it);
+
+		oval_result_definition_eval(rdef);
+		if (cb != NULL) {
+			int cb_ret = cb(rdef, arg);
+			/* stop? */
+			if (cb_ret != 0) {
+				ret = cb_ret;
+				break;
+			}
+		}
+	}
+	oscap_iterator_free(rdef_it);
+	oscap_list_free0(rdefs);
+
+	return ret;
+}
+#endif
+
 int oval_agent_eval_system(oval_agent_session_t * ag_sess, agent_reporter cb, void *arg) {
 	struct oval_definition *oval_def;
 	struct oval_definition_iterator *oval_def_it;
@@ -277,6 +526,16 @@ int oval_agent_eval_system(oval_agent_session_t * ag_sess, agent_reporter cb, vo
 	int ret = 0;
 
 	dI("OVAL agent started to evaluate OVAL definitions on your system.");
+#if defined(OVAL_PROBES_ENABLED)
+	oval_probe_query_definitions(ag_sess->psess, ag_sess->def_model);
+
+	size_t jobs = _oval_agent_eval_jobs();
+	if (jobs > 1) {
+		ret = _oval_agent_eval_system_parallel(ag_sess, cb, arg, jobs);
+		dI("OVAL agent finished evaluation.");
+		return ret;
+	}
+#endif
 	oval_def_it = oval_definition_model_get_definitions(ag_sess->def_model);
 	while (oval_definition_iterator_has_more(oval_def_it)) {
 		oval_def = oval_definition_iterator_next(oval_def_it);
@@ -329,6 +588,7 @@ const char * oval_agent_get_filename(oval_agent_session_t * ag_sess) {
 void oval_agent_destroy_session(oval_agent_session_t * ag_sess) {
 	if (ag_sess != NULL) {
 		free(ag_sess->product_name);
+		oscap_stringlist_free(ag_sess->bound_values);
 #if defined(OVAL_PROBES_ENABLED)
 		oval_probe_session_destroy(ag_sess->psess);
 		oval_results_model_free(ag_sess->res_model);
@@ -336,6 +596,7 @@ void oval_agent_destroy_session(oval_agent_session_t * ag_sess) {
 		oval_syschar_model_free(ag_sess->sys_model);
 	        free(ag_sess->filename);
 		free(ag_sess);
+		oscap_pcre_cache_flush();
 	}
 }
 
@@ -391,6 +652,55 @@ static struct oscap_htable *_binding_iterator_to_dict(struct xccdf_value_binding
 	return dict;
 }
 
+static const char *_binding_get_value(struct xccdf_value_binding *binding)
+{
+	const char *value = xccdf_value_binding_get_setvalue(binding);
+
+	if (value == NULL)
+		value = xccdf_value_binding_get_value(binding);
+	return value != NULL ? value : "";
+}
+
+/**
+ * Check whether the bindings are the same, in the same order, as those
+ * resolved last time. Consecutive rules mostly export the same values
+ * and the variables bound to them are then kept as they are.
+ */
+static bool _oval_agent_bindings_unchanged(struct oval_agent_session *session, struct xccdf_value_binding_iterator *it)
+{
+	bool unchanged = true;
+
+	if (session->bound_values == NULL)
+		return false;
+
+	struct oscap_string_iterator *bound_it = oscap_stringlist_get_strings(session->bound_values);
+	while (unchanged && xccdf_value_binding_iterator_has_more(it)) {
+		struct xccdf_value_binding *binding = xccdf_value_binding_iterator_next(it);
+
+		unchanged = oscap_string_iterator_has_more(bound_it) &&
+			oscap_streq(oscap_string_iterator_next(bound_it), xccdf_value_binding_get_name(binding)) &&
+			oscap_streq(oscap_string_iterator_next(bound_it), _binding_get_value(binding));
+	}
+	if (oscap_string_iterator_has_more(bound_it))
+		unchanged = false;
+	oscap_string_iterator_free(bound_it);
+	xccdf_value_binding_iterator_reset(it);
+	return unchanged;
+}
+
+static void _oval_agent_remember_bindings(struct oval_agent_session *session, struct xccdf_value_binding_iterator *it)
+{
+	oscap_stringlist_free(session->bound_values);
+	session->bound_values = oscap_stringlist_new();
+	while (xccdf_value_binding_iterator_has_more(it)) {
+		struct xccdf_value_binding *binding = xccdf_value_binding_iterator_next(it);
+
+		oscap_stringlist_add_string(session->bound_values, xccdf_value_binding_get_name(binding));
+		oscap_stringlist_add_string(session->bound_values, _binding_get_value(binding));
+	}
+	xccdf_value_binding_iterator_reset(it);
+}
+
 /**
  * Ensure that the newly binded values do not pose conflict with existing value set.
  * The lists should be equal or the existing must be empty.
@@ -425,7 +735,7 @@ static void _oval_agent_resolve_variables_conflict(struct oval_agent_session *se
 	struct oscap_htable_iterator *hit = oscap_htable_iterator_new(dict);
 	struct oval_definition_model *def_model =
 			oval_results_model_get_definition_model(oval_agent_get_results_model(session));
-	while (!conflict && oscap_htable_iterator_has_more(hit)) {
+	while (oscap_htable_iterator_has_more(hit)) {
 		oscap_htable_iterator_next_kv(hit, &var_name, (void*) &value_list);
 		struct oval_variable *variable = oval_definition_model_get_variable(def_model, var_name);
 		if (variable != NULL) {
@@ -454,6 +764,12 @@ static void _oval_agent_resolve_variables_conflict(struct oval_agent_session *se
 				// @variable_instance attribute. And each result-definition refers to different
 				// set of tests. These tests might have same @id but differ in @variable_instance
 				// attribute. Further, some of these tests will differ in tested_variable element.
+				//
+				// Only the objects which depend on the variable are collected again, the
+				// other collected objects are kept for the new variable instance.
+#if defined(OVAL_PROBES_ENABLED)
+				oval_probe_hint_variable(session->psess, def_model, variable);
+#endif
 				struct oval_result_system *r_system = _oval_agent_get_first_result_system(session);
 				if (r_system == NULL) {
 					oval_value_iterator_free(value_it);
@@ -474,14 +790,6 @@ static void _oval_agent_resolve_variables_conflict(struct oval_agent_session *se
 						// to the oval_variable files.
 						int instance = oval_result_definition_get_instance(r_definition);
 						oval_result_definition_set_variable_instance_hint(r_definition, instance + 1);
-						struct oval_definition *definition = oval_result_definition_get_definition(r_definition);
-#if defined(OVAL_PROBES_ENABLED)
-						oval_probe_hint_definition(session->psess, definition, instance + 1);
-#endif
-					}
-					else {
-						// TODO: We really need oval_agent_session wide variable_instance attribute
-						// to be able to correctly handle syschars even when there is no result-definition.
 					}
 				}
 				oval_string_iterator_free(def_it);
@@ -493,8 +801,9 @@ static void _oval_agent_resolve_variables_conflict(struct oval_agent_session *se
 	oscap_htable_free(dict, (oscap_destruct_func) oscap_stringlist_free);
 
     if (conflict) {
-        /* We have a conflict, clear session and external variables */
-        oval_agent_reset_session(session);
+        /* We have a conflict, clear the variables. The probe session is kept,
+         * the dependent objects have been hinted for another collection. */
+        _oval_agent_reset_variables(session);
     }
 
     if (!session->cur_var_model) {
@@ -517,6 +826,11 @@ int oval_agent_resolve_variables(struct oval_agent_session * session, struct xcc
 	if (!xccdf_value_binding_iterator_has_more(it))
 		return 0;
 
+	if (_oval_agent_bindings_unchanged(session, it)) {
+		dI("Variable bindings are the same as for the previous check.");
+		return 0;
+	}
+
 	_oval_agent_resolve_variables_conflict(session, it);
 
 	/* Get the definition model from OVAL agent session */
@@ -551,6 +865,13 @@ int oval_agent_resolve_variables(struct oval_agent_session * session, struct xcc
         }
     }
 
+#if defined(OVAL_PROBES_ENABLED)
+    /* values may have been bound to variables which had none */
+    oval_probe_session_forget_sexps(session->psess);
+#endif
+    xccdf_value_binding_iterator_reset(it);
+    _oval_agent_remember_bindings(session, it);
+
     return retval;
 }
 
@@ -634,7 +955,10 @@ _oval_agent_list_definitions(void *usr, xccdf_policy_engine_query_t query_type,
 	if (query_data != NULL && strcmp(sess->filename, (const char *) query_data)) {
 		return NULL;
 	}
-	if (query_type == POLICY_ENGINE_QUERY_NAMES_FOR_HREF) {
+	if (query_type == POLICY_ENGINE_QUERY_SYSTEM_CHANGED) {
+		oval_probe_session_flush_caches(sess->psess);
+		return NULL;
+	} else if (query_type == POLICY_ENGINE_QUERY_NAMES_FOR_HREF) {
 		struct oval_definition_iterator *iterator = oval_definition_model_get_definitions(sess->def_model);
 		struct oscap_stringlist *result = oscap_stringlist_new();
 
@@ -60,8 +60,27 @@ typedef struct oval_definition_model {
 	struct oval_collection *bound_variable_models;
         char *schema;
 	struct oval_string_map *vardef_map;		///< look-up table for efficient @variable_instance processing
+	struct oval_string_map *varobj_map;		///< look-up table of objects to collect again for a new @variable_instance
+	struct oscap_source *lazy_source;		///< document of a model loaded on demand (not owned)
+	struct oval_string_map *lazy_index;		///< ID -> oval_lazy_entry of a model loaded on demand
 } oval_definition_model_t;
 
+/* An element of the definitions, tests, objects, states or variables
+ * section of a document which is loaded on demand */
+struct oval_lazy_entry {
+	char **deps;		///< IDs of the elements referenced by this one
+	int dep_cnt;
+	bool loaded;
+};
+
+static void oval_lazy_entry_free(struct oval_lazy_entry *entry)
+{
+	for (int i = 0; i < entry->dep_cnt; i++)
+		free(entry->deps[i]);
+	free(entry->deps);
+	free(entry);
+}
+
 /* failed   - NULL
  * success  - oval_definition_model
  * */
@@ -80,6 +99,9 @@ struct oval_definition_model *oval_definition_model_new()
 	newmodel->bound_variable_models = NULL;
 	newmodel->schema = oscap_strdup(OVAL_DEF_SCHEMA_LOCATION);
 	newmodel->vardef_map = NULL;
+	newmodel->varobj_map = NULL;
+	newmodel->lazy_source = NULL;
+	newmodel->lazy_index = NULL;
 
 	return newmodel;
 }
@@ -120,6 +142,7 @@ struct oval_definition_model *oval_definition_model_clone(struct oval_definition
 	    (oldmodel->variable_map, newmodel, (_oval_clone_func) oval_variable_clone);
         newmodel->schema = oscap_strdup(oldmodel->schema);
 	newmodel->vardef_map = NULL;
+	newmodel->varobj_map = NULL;
 	return newmodel;
 }
 
@@ -133,6 +156,10 @@ void oval_definition_model_free(struct oval_definition_model *model)
 		oval_string_map_free(model->variable_map, (oscap_destruct_func) oval_variable_free);
 		if (model->vardef_map != NULL)
 			oval_string_map_free(model->vardef_map, (oscap_destruct_func) oval_string_map_free0);
+		if (model->varobj_map != NULL)
+			oval_string_map_free(model->varobj_map, (oscap_destruct_func) oval_string_map_free0);
+		if (model->lazy_index != NULL)
+			oval_string_map_free(model->lazy_index, (oscap_destruct_func) oval_lazy_entry_free);
 		if (model->bound_variable_models)
 			oval_collection_free_items(model->bound_variable_models,
 					   (oscap_destruct_func) oval_variable_model_free);
@@ -222,7 +249,8 @@ void oval_definition_model_add_variable(struct oval_definition_model *model, str
 	oval_string_map_put(model->variable_map, key, (void *)variable);
 }
 
-static inline int _oval_definition_model_merge_source(struct oval_definition_model *model, struct oscap_source *source)
+static inline int _oval_definition_model_merge_source(struct oval_definition_model *model, struct oscap_source *source,
+						      struct oval_string_map *id_filter)
 {
 	/* setup context */
 	struct oval_parser_context context;
@@ -232,6 +260,7 @@ static inline int _oval_definition_model_merge_source(struct oval_definition_mod
 	}
 	context.definition_model = model;
 	context.user_data = NULL;
+	context.id_filter = id_filter;
 	/* jump into oval_definitions */
 	while (xmlTextReaderRead(context.reader) == 1
 		&& xmlTextReaderNodeType(context.reader) != XML_READER_TYPE_ELEMENT) ;
@@ -243,8 +272,22 @@ static inline int _oval_definition_model_merge_source(struct oval_definition_mod
 
 struct oval_definition_model *oval_definition_model_import_source(struct oscap_source *source)
 {
-        struct oval_definition_model *model = oval_definition_model_new();
-	int ret = _oval_definition_model_merge_source(model, source);
+	struct oval_definition_model *model = oval_definition_model_new();
+	struct oval_parser_context context;
+	context.reader = NULL;
+	context.definition_model = model;
+	context.user_data = NULL;
+	context.id_filter = NULL;
+	bool had_err = oscap_err();
+	int ret = oval_definition_model_parse_parallel(source, &context);
+	if (ret == -2) {
+		/* start over, the sequential parsing reports the errors */
+		if (!had_err)
+			oscap_clearerr();
+		oval_definition_model_free(model);
+		model = oval_definition_model_new();
+		ret = _oval_definition_model_merge_source(model, source, NULL);
+	}
         if (ret == -1 ) {
                 oval_definition_model_free(model);
                 model = NULL;
@@ -252,6 +295,425 @@ struct oval_definition_model *oval_definition_model_import_source(struct oscap_s
 	return model;
 }
 
+static void _oval_lazy_entry_add_dep(struct oval_lazy_entry *entry, const char *id)
+{
+	char **deps;
+
+	if (id == NULL || *id == '\0')
+		return;
+
+	deps = realloc(entry->deps, (entry->dep_cnt + 1) * sizeof(char *));
+	if (deps == NULL)
+		return;
+	entry->deps = deps;
+	entry->deps[entry->dep_cnt++] = oscap_strdup(id);
+}
+
+/*
+ * Read the document once, parse the generator and record the references
+ * of each element with an ID. The references are the values of the *_ref
+ * attributes (definition_ref, test_ref, object_ref, state_ref, var_ref)
+ * and the content of the object_reference and filter elements of sets.
+ */
+static int _oval_definition_model_index_source(struct oval_definition_model *model, struct oscap_source *source)
+{
+	struct oval_parser_context context;
+	struct oval_lazy_entry *entry = NULL;
+	int ret = 0;
+
+	context.reader = oscap_source_get_xmlTextReader(source);
+	if (context.reader == NULL) {
+		return -1;
+	}
+	context.definition_model = model;
+	context.user_data = NULL;
+	context.id_filter = NULL;
+
+	xmlTextReaderPtr reader = context.reader;
+	while (ret != -1 && xmlTextReaderRead(reader) == 1) {
+		if (xmlTextReaderNodeType(reader) != XML_READER_TYPE_ELEMENT)
+			continue;
+
+		int depth = xmlTextReaderDepth(reader);
+		if (depth == 1) {
+			/* section */
+			entry = NULL;
+			if (oscap_strcmp((const char *) xmlTextReaderConstLocalName(reader), "generator") == 0)
+				ret = oval_parser_parse_tag(reader, &context, &oval_generator_parse_tag, model->generator);
+		} else if (depth == 2) {
+			/* definition, test, object, state or variable */
+			char *id = (char *) xmlTextReaderGetAttribute(reader, BAD_CAST "id");
+			entry = NULL;
+			if (id != NULL) {
+				entry = oval_string_map_get_value(model->lazy_index, id);
+				if (entry == NULL) {
+					entry = calloc(1, sizeof(struct oval_lazy_entry));
+					oval_string_map_put(model->lazy_index, id, entry);
+				}
+				free(id);
+			}
+		} else if (entry != NULL) {
+			const char *tagname = (const char *) xmlTextReaderConstLocalName(reader);
+			if (oscap_strcmp(tagname, "object_reference") == 0 || oscap_strcmp(tagname, "filter") == 0) {
+				char *ref = (char *) xmlTextReaderReadString(reader);
+				_oval_lazy_entry_add_dep(entry, ref);
+				free(ref);
+			}
+			while (xmlTextReaderMoveToNextAttribute(reader) == 1) {
+				const char *name = (const char *) xmlTextReaderConstLocalName(reader);
+				size_t len = strlen(name);
+				if (len > 4 && strcmp(name + len - 4, "_ref") == 0) {
+					char *ref = (char *) xmlTextReaderValue(reader);
+					_oval_lazy_entry_add_dep(entry, ref);
+					free(ref);
+				}
+			}
+			xmlTextReaderMoveToElement(reader);
+		}
+	}
+	xmlFreeTextReader(reader);
+	return ret;
+}
+
+struct oval_definition_model *oval_definition_model_import_source_deferred(struct oscap_source *source)
+{
+	struct oval_definition_model *model = oval_definition_model_new();
+
+	model->lazy_index = oval_string_map_new();
+	if (_oval_definition_model_index_source(model, source) == -1) {
+		oval_definition_model_free(model);
+		return NULL;
+	}
+	model->lazy_source = source;
+
+	dI("Indexed %s for loading on demand.", oscap_source_readable_origin(source));
+	return model;
+}
+
+static void _oval_definition_model_bind_ext_vars(struct oval_definition_model *defmodel, struct oval_variable_model *varmodel);
+static void _fp_object(struct oval_definition_model *model, struct oval_object *obj);
+
+struct oval_lazy_stack {
+	const char **ids;
+	int cnt;
+	int size;
+};
+
+/* the model got new elements, bind them and drop what was derived from the old ones */
+static void _oval_definition_model_refresh(struct oval_definition_model *model)
+{
+	/* bind the new external variables */
+	if (model->bound_variable_models != NULL) {
+		struct oval_iterator *vm_itr = oval_collection_iterator(model->bound_variable_models);
+		while (oval_collection_iterator_has_more(vm_itr))
+			_oval_definition_model_bind_ext_vars(model, oval_collection_iterator_next(vm_itr));
+		oval_collection_iterator_free(vm_itr);
+	}
+
+	/* the variable look-up tables are built again on demand */
+	if (model->vardef_map != NULL) {
+		oval_string_map_free(model->vardef_map, (oscap_destruct_func) oval_string_map_free0);
+		model->vardef_map = NULL;
+	}
+	if (model->varobj_map != NULL) {
+		oval_string_map_free(model->varobj_map, (oscap_destruct_func) oval_string_map_free0);
+		model->varobj_map = NULL;
+	}
+}
+
+static bool _oval_lazy_stack_push(struct oval_lazy_stack *stack, const char *id)
+{
+	if (stack->cnt == stack->size) {
+		int size = stack->size > 0 ? 2 * stack->size : 64;
+		const char **ids = realloc(stack->ids, size * sizeof(const char *));
+		if (ids == NULL)
+			return false;
+		stack->ids = ids;
+		stack->size = size;
+	}
+	stack->ids[stack->cnt++] = id;
+	return true;
+}
+
+int oval_definition_model_load_definitions(struct oval_definition_model *model, struct oscap_stringlist *ids)
+{
+	struct oval_string_map *filter;
+	struct oval_lazy_stack stack = { NULL, 0, 0 };
+	int load_cnt = 0;
+	int ret = 0;
+
+	__attribute__nonnull__(model);
+
+	if (model->lazy_index == NULL)
+		return 0;
+
+	if (ids != NULL) {
+		struct oscap_string_iterator *id_itr = oscap_stringlist_get_strings(ids);
+		while (ret == 0 && oscap_string_iterator_has_more(id_itr)) {
+			if (!_oval_lazy_stack_push(&stack, oscap_string_iterator_next(id_itr)))
+				ret = -1;
+		}
+		oscap_string_iterator_free(id_itr);
+	} else {
+		struct oval_string_iterator *id_itr = (struct oval_string_iterator *) oval_string_map_keys(model->lazy_index);
+		while (ret == 0 && oval_string_iterator_has_more(id_itr)) {
+			if (!_oval_lazy_stack_push(&stack, oval_string_iterator_next(id_itr)))
+				ret = -1;
+		}
+		oval_string_iterator_free(id_itr);
+	}
+
+	/* the elements reachable from ids which have not been loaded yet */
+	filter = oval_string_map_new();
+	while (ret == 0 && stack.cnt > 0) {
+		const char *id = stack.ids[--stack.cnt];
+		struct oval_lazy_entry *entry = oval_string_map_get_value(model->lazy_index, id);
+
+		if (entry == NULL || entry->loaded || oval_string_map_get_value(filter, id) != NULL)
+			continue;
+		oval_string_map_put(filter, id, entry);
+		load_cnt++;
+
+		for (int i = 0; ret == 0 && i < entry->dep_cnt; i++) {
+			if (!_oval_lazy_stack_push(&stack, entry->deps[i]))
+				ret = -1;
+		}
+	}
+	free(stack.ids);
+
+	if (ret == 0 && load_cnt > 0)
+		ret = _oval_definition_model_merge_source(model, model->lazy_source, filter);
+
+	if (ret != -1 && load_cnt > 0) {
+		struct oval_string_iterator *key_itr;
+
+		key_itr = (struct oval_string_iterator *) oval_string_map_keys(filter);
+		while (oval_string_iterator_has_more(key_itr)) {
+			char *id = oval_string_iterator_next(key_itr);
+			struct oval_lazy_entry *entry = oval_string_map_get_value(filter, id);
+			struct oval_object *obj;
+
+			entry->loaded = true;
+			obj = oval_definition_model_get_object(model, id);
+			if (obj != NULL)
+				_fp_object(model, obj);
+		}
+		oval_string_iterator_free(key_itr);
+
+		_oval_definition_model_refresh(model);
+
+		dI("Loaded %d elements of %s.", load_cnt, oscap_source_readable_origin(model->lazy_source));
+	}
+	oval_string_map_free(filter, NULL);
+
+	return ret == -1 ? -1 : 0;
+}
+
+/* sections of a document, in the order of oval_definition_model_merge_source */
+static const char *_oval_merge_sections[] = { "definitions", "tests", "objects", "states", "variables", NULL };
+
+/* an element of the merged document replacing one of the model */
+struct oval_merge_entry {
+	int section;
+	void *element;
+};
+
+static void *_oval_merge_lookup(struct oval_definition_model *model, int section, const char *id)
+{
+	switch (section) {
+	case 0: return oval_definition_model_get_definition(model, id);
+	case 1: return oval_definition_model_get_test(model, id);
+	case 2: return oval_definition_model_get_object(model, id);
+	case 3: return oval_definition_model_get_state(model, id);
+	default: return oval_definition_model_get_variable(model, id);
+	}
+}
+
+static int _oval_merge_version(void *element, int section)
+{
+	switch (section) {
+	case 0: return oval_definition_get_version(element);
+	case 1: return oval_test_get_version(element);
+	case 2: return oval_object_get_version(element);
+	case 3: return oval_state_get_version(element);
+	default: return oval_variable_get_version(element);
+	}
+}
+
+/*
+ * An object can't be changed in place if filters of a set have been
+ * propagated into copies of it (see oval_set_propagate_filters), or if it
+ * is such a set.
+ */
+static bool _oval_merge_object_is_propagated(struct oval_object *object, struct oval_string_map *bases)
+{
+	struct oval_object_content_iterator *cit;
+	bool propagated = false;
+
+	if (oval_string_map_get_value(bases, oval_object_get_id(object)) != NULL)
+		return true;
+
+	cit = oval_object_get_object_contents(object);
+	if (oval_object_content_iterator_has_more(cit)) {
+		struct oval_object_content *cont = oval_object_content_iterator_next(cit);
+		propagated = oval_object_content_get_type(cont) == OVAL_OBJECTCONTENT_SET;
+	}
+	oval_object_content_iterator_free(cit);
+
+	return propagated;
+}
+
+/*
+ * Read the versions of the elements of the document. The elements which are
+ * not in the model or have another version are put in filter, those of them
+ * which are in the model are also put in changed.
+ * -1 error; 0 OK; 1 the model can't be updated in place
+ */
+static int _oval_definition_model_merge_scan(struct oval_definition_model *model, struct oscap_source *source,
+					     struct oval_string_map *filter, struct oval_string_map *changed)
+{
+	struct oval_string_map *bases = NULL;
+	xmlTextReaderPtr reader;
+	int section = -1;
+	int ret = 0;
+
+	reader = oscap_source_get_xmlTextReader(source);
+	if (reader == NULL)
+		return -1;
+
+	while (ret == 0 && xmlTextReaderRead(reader) == 1) {
+		if (xmlTextReaderNodeType(reader) != XML_READER_TYPE_ELEMENT)
+			continue;
+
+		int depth = xmlTextReaderDepth(reader);
+		if (depth == 1) {
+			const char *tagname = (const char *) xmlTextReaderConstLocalName(reader);
+			for (section = 0; _oval_merge_sections[section] != NULL; section++) {
+				if (oscap_strcmp(tagname, _oval_merge_sections[section]) == 0)
+					break;
+			}
+			if (_oval_merge_sections[section] == NULL)
+				section = -1;
+			continue;
+		}
+		if (depth != 2 || section == -1)
+			continue;
+
+		char *id = (char *) xmlTextReaderGetAttribute(reader, BAD_CAST "id");
+		if (id == NULL)
+			continue;
+		char *version = (char *) xmlTextReaderGetAttribute(reader, BAD_CAST "version");
+		void *element = _oval_merge_lookup(model, section, id);
+
+		if (element == NULL) {
+			oval_string_map_put(filter, id, filter);
+		} else if (_oval_merge_version(element, section) != (version != NULL ? atoi(version) : 0)) {
+			if (section == 2) {
+				if (bases == NULL) {
+					struct oval_object_iterator *obj_itr = oval_definition_model_get_objects(model);
+					bases = oval_string_map_new();
+					while (oval_object_iterator_has_more(obj_itr)) {
+						struct oval_object *base = oval_object_get_base_obj(oval_object_iterator_next(obj_itr));
+						if (base != NULL)
+							oval_string_map_put(bases, oval_object_get_id(base), base);
+					}
+					oval_object_iterator_free(obj_itr);
+				}
+				if (_oval_merge_object_is_propagated(element, bases)) {
+					dI("Object '%s' is used by a set with filters, it can't be updated in place.", id);
+					ret = 1;
+				}
+			} else if (section == 4 && oval_variable_get_type(element) != OVAL_VARIABLE_UNKNOWN &&
+				   oscap_strcmp((const char *) xmlTextReaderConstLocalName(reader),
+						oval_variable_type_get_text(oval_variable_get_type(element))) != 0) {
+				dI("Variable '%s' has changed its type, it can't be updated in place.", id);
+				ret = 1;
+			}
+
+			struct oval_merge_entry *entry = malloc(sizeof(struct oval_merge_entry));
+			entry->section = section;
+			entry->element = element;
+			oval_string_map_put(changed, id, entry);
+			oval_string_map_put(filter, id, filter);
+		}
+		free(version);
+		free(id);
+	}
+	xmlFreeTextReader(reader);
+	if (bases != NULL)
+		oval_string_map_free(bases, NULL);
+
+	return ret;
+}
+
+int oval_definition_model_merge_source(struct oval_definition_model *model, struct oscap_source *source,
+				       struct oscap_stringlist *updated)
+{
+	struct oval_string_map *filter, *changed;
+	struct oval_string_iterator *key_itr;
+	int merged = 0;
+	int ret;
+
+	__attribute__nonnull__(model);
+
+	/* elements of a model loaded on demand are compared with the new ones too */
+	if (oval_definition_model_load_definitions(model, NULL) != 0)
+		return -1;
+
+	filter = oval_string_map_new();
+	changed = oval_string_map_new();
+	ret = _oval_definition_model_merge_scan(model, source, filter, changed);
+	if (ret != 0)
+		goto cleanup;
+
+	key_itr = (struct oval_string_iterator *) oval_string_map_keys(changed);
+	while (oval_string_iterator_has_more(key_itr)) {
+		struct oval_merge_entry *entry = oval_string_map_get_value(changed, oval_string_iterator_next(key_itr));
+
+		switch (entry->section) {
+		case 0: oval_definition_clear(entry->element); break;
+		case 1: oval_test_clear(entry->element); break;
+		case 2: oval_object_clear(entry->element); break;
+		case 3: oval_state_clear(entry->element); break;
+		default: oval_variable_clear(entry->element); break;
+		}
+	}
+	oval_string_iterator_free(key_itr);
+
+	ret = _oval_definition_model_merge_source(model, source, filter);
+	if (ret == -1)
+		goto cleanup;
+
+	key_itr = (struct oval_string_iterator *) oval_string_map_keys(filter);
+	while (oval_string_iterator_has_more(key_itr)) {
+		char *id = oval_string_iterator_next(key_itr);
+		struct oval_object *obj = oval_definition_model_get_object(model, id);
+
+		if (obj != NULL)
+			_fp_object(model, obj);
+		merged++;
+		if (updated != NULL)
+			oscap_stringlist_add_string(updated, id);
+	}
+	oval_string_iterator_free(key_itr);
+
+	_oval_definition_model_refresh(model);
+
+	/* the values may have been computed from the replaced elements */
+	struct oval_variable_iterator *vars_itr = oval_definition_model_get_variables(model);
+	while (oval_variable_iterator_has_more(vars_itr))
+		oval_variable_reset_computed_values(oval_variable_iterator_next(vars_itr), true);
+	oval_variable_iterator_free(vars_itr);
+
+	dI("Merged %d new or updated elements of %s.", merged, oscap_source_readable_origin(source));
+	ret = 0;
+
+cleanup:
+	oval_string_map_free(changed, free);
+	oval_string_map_free(filter, NULL);
+	return ret;
+}
+
 struct oval_definition *oval_definition_model_get_definition(struct oval_definition_model *model, const char *key)
 {
 	__attribute__nonnull__(model);
@@ -287,18 +749,10 @@ struct oval_variable *oval_definition_model_get_variable(struct oval_definition_
 	return (struct oval_variable *)oval_string_map_get_value(model->variable_map, key);
 }
 
-int oval_definition_model_bind_variable_model(struct oval_definition_model *defmodel,
-					       struct oval_variable_model *varmodel)
+static void _oval_definition_model_bind_ext_vars(struct oval_definition_model *defmodel, struct oval_variable_model *varmodel)
 {
 	struct oval_string_iterator *evar_id_itr;
 
-	if (!defmodel->bound_variable_models)
-		defmodel->bound_variable_models = oval_collection_new();
-
-	oval_collection_add(defmodel->bound_variable_models, varmodel);
-
-	/* todo: keep reference count for each variable model if it can be bound to multiple definition models */
-
 	evar_id_itr = oval_variable_model_get_variable_ids(varmodel);
 	while (oval_string_iterator_has_more(evar_id_itr)) {
 		char *evar_id;
@@ -312,6 +766,19 @@ int oval_definition_model_bind_variable_model(struct oval_definition_model *defm
 		oval_variable_bind_ext_var(var, varmodel, evar_id);
 	}
 	oval_string_iterator_free(evar_id_itr);
+}
+
+int oval_definition_model_bind_variable_model(struct oval_definition_model *defmodel,
+					       struct oval_variable_model *varmodel)
+{
+	if (!defmodel->bound_variable_models)
+		defmodel->bound_variable_models = oval_collection_new();
+
+	oval_collection_add(defmodel->bound_variable_models, varmodel);
+
+	/* todo: keep reference count for each variable model if it can be bound to multiple definition models */
+
+	_oval_definition_model_bind_ext_vars(defmodel, varmodel);
 
 	return 0;
 }
@@ -341,6 +808,24 @@ void oval_definition_model_clear_external_variables(struct oval_definition_model
 	oval_variable_iterator_free(vars_itr);
 }
 
+void oval_definition_model_reset_local_variables(struct oval_definition_model *model)
+{
+	struct oval_variable_iterator *vars_itr;
+	int reset_cnt = 0;
+
+	vars_itr = oval_definition_model_get_variables(model);
+	while (oval_variable_iterator_has_more(vars_itr)) {
+		struct oval_variable *var;
+
+		var = oval_variable_iterator_next(vars_itr);
+		if (oval_variable_reset_computed_values(var, false))
+			reset_cnt++;
+	}
+	oval_variable_iterator_free(vars_itr);
+
+	dI("Values of %d local variables dependent on external variables have been dropped.", reset_cnt);
+}
+
 struct oval_definition_iterator *oval_definition_model_get_definitions(struct oval_definition_model
 								       *model)
 {
@@ -365,6 +850,19 @@ struct oval_string_iterator *oval_definition_model_get_definitions_dependent_on_
 		oval_string_map_keys(def_list) : oval_collection_iterator_new());
 }
 
+struct oval_object_iterator *oval_definition_model_get_objects_dependent_on_variable(struct oval_definition_model *model, struct oval_variable *variable)
+{
+	__attribute__nonnull__(model);
+	__attribute__nonnull__(variable);
+
+	if (model->varobj_map == NULL)
+		model->varobj_map = oval_definition_model_build_varobj_mapping(model);
+
+	struct oval_string_map *obj_list = (struct oval_string_map *) oval_string_map_get_value(model->varobj_map, oval_variable_get_id(variable));
+	return (struct oval_object_iterator *) (obj_list != NULL ?
+		oval_string_map_values(obj_list) : oval_collection_iterator_new());
+}
+
 struct oval_test_iterator *oval_definition_model_get_tests(struct oval_definition_model *model)
 {
 	__attribute__nonnull__(model);
@@ -493,6 +991,7 @@ xmlNode *oval_definition_model_to_dom(struct oval_definition_model *definition_m
 				definitions_node = xmlNewTextChild(root_node, ns_defntns, BAD_CAST "definitions", NULL);
 			}
 			oval_definition_to_dom(definition, doc, definitions_node);
+			oscap_xml_stream_flush(doc, definitions_node);
 		}
 	}
         oval_definition_iterator_free(definitions);
@@ -504,6 +1003,7 @@ xmlNode *oval_definition_model_to_dom(struct oval_definition_model *definition_m
 		while (oval_test_iterator_has_more(tests)) {
 			struct oval_test *test = oval_test_iterator_next(tests);
 			oval_test_to_dom(test, doc, tests_node);
+			oscap_xml_stream_flush(doc, tests_node);
 		}
 	}
 	oval_test_iterator_free(tests);
@@ -518,6 +1018,7 @@ xmlNode *oval_definition_model_to_dom(struct oval_definition_model *definition_m
 				/* Skip internal objects */
 				continue;
 			oval_object_to_dom(object, doc, objects_node);
+			oscap_xml_stream_flush(doc, objects_node);
 		}
 	}
 	oval_object_iterator_free(objects);
@@ -529,6 +1030,7 @@ xmlNode *oval_definition_model_to_dom(struct oval_definition_model *definition_m
 		while (oval_state_iterator_has_more(states)) {
 			struct oval_state *state = oval_state_iterator_next(states);
 			oval_state_to_dom(state, doc, states_node);
+			oscap_xml_stream_flush(doc, states_node);
 		}
 	}
 	oval_state_iterator_free(states);
@@ -540,6 +1042,7 @@ xmlNode *oval_definition_model_to_dom(struct oval_definition_model *definition_m
 		while (oval_variable_iterator_has_more(variables)) {
 			struct oval_variable *variable = oval_variable_iterator_next(variables);
 			oval_variable_to_dom(variable, doc, variables_node);
+			oscap_xml_stream_flush(doc, variables_node);
 		}
 	}
 	oval_variable_iterator_free(variables);
@@ -581,6 +1084,42 @@ static void _fp_set_recurse(struct oval_definition_model *model, struct oval_set
 	oval_setobject_iterator_free(subset_itr);
 }
 
+static void _fp_object(struct oval_definition_model *model, struct oval_object *obj)
+{
+	char *obj_id;
+	struct oval_object_content_iterator *cont_itr;
+	struct oval_object_content *cont;
+	struct oval_setobject *set;
+	struct oval_filter_iterator *filter_itr;
+
+	obj_id = oval_object_get_id(obj);
+	cont_itr = oval_object_get_object_contents(obj);
+	if (!oval_object_content_iterator_has_more(cont_itr)) {
+		oval_object_content_iterator_free(cont_itr);
+		return;
+	}
+
+	cont = oval_object_content_iterator_next(cont_itr);
+	oval_object_content_iterator_free(cont_itr);
+	if (oval_object_content_get_type(cont) != OVAL_OBJECTCONTENT_SET)
+		return;
+
+	set = oval_object_content_get_setobject(cont);
+	if (oval_setobject_get_type(set) == OVAL_SET_AGGREGATE) {
+		_fp_set_recurse(model, set, obj_id);
+		return;
+	}
+
+	filter_itr = oval_setobject_get_filters(set);
+	if (!oval_filter_iterator_has_more(filter_itr)) {
+		oval_filter_iterator_free(filter_itr);
+		return;
+	}
+	oval_filter_iterator_free(filter_itr);
+
+	oval_set_propagate_filters(model, set, obj_id);
+}
+
 void oval_definition_model_optimize_by_filter_propagation(struct oval_definition_model *model)
 {
 	struct oval_object_iterator *obj_itr;
@@ -592,10 +1131,6 @@ void oval_definition_model_optimize_by_filter_propagation(struct oval_definition
 	while (oval_object_iterator_has_more(obj_itr)) {
 		struct oval_object *obj;
 		char *obj_id;
-		struct oval_object_content_iterator *cont_itr;
-		struct oval_object_content *cont;
-		struct oval_setobject *set;
-		struct oval_filter_iterator *filter_itr;
 
 		obj = oval_object_iterator_next(obj_itr);
 		obj_id = oval_object_get_id(obj);
@@ -603,32 +1138,7 @@ void oval_definition_model_optimize_by_filter_propagation(struct oval_definition
 			continue;
 
 		oval_string_map_put(processed_obj_map, obj_id, obj);
-
-		cont_itr = oval_object_get_object_contents(obj);
-		if (!oval_object_content_iterator_has_more(cont_itr)) {
-			oval_object_content_iterator_free(cont_itr);
-			continue;
-		}
-
-		cont = oval_object_content_iterator_next(cont_itr);
-		oval_object_content_iterator_free(cont_itr);
-		if (oval_object_content_get_type(cont) != OVAL_OBJECTCONTENT_SET)
-			continue;
-
-		set = oval_object_content_get_setobject(cont);
-		if (oval_setobject_get_type(set) == OVAL_SET_AGGREGATE) {
-			_fp_set_recurse(model, set, obj_id);
-			continue;
-		}
-
-		filter_itr = oval_setobject_get_filters(set);
-		if (!oval_filter_iterator_has_more(filter_itr)) {
-			oval_filter_iterator_free(filter_itr);
-			continue;
-		}
-		oval_filter_iterator_free(filter_itr);
-
-		oval_set_propagate_filters(model, set, obj_id);
+		_fp_object(model, obj);
 	}
 	oval_object_iterator_free(obj_itr);
 
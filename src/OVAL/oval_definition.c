@@ -41,6 +41,7 @@
 #include "oval_agent_api_impl.h"
 
 #include "common/util.h"
+#include "common/memtag_priv.h"
 #include "common/debug_priv.h"
 #include "common/elements.h"
 #include "common/_error.h"
@@ -149,6 +150,7 @@ struct oval_definition *oval_definition_new(struct oval_definition_model *model,
 {
 	__attribute__nonnull__(model);
 	struct oval_definition *definition = (struct oval_definition *)malloc(sizeof(oval_definition_t));
+	oscap_memtag_alloc(OSCAP_MEMTAG_OVAL_MODEL, definition, sizeof(oval_definition_t));
 
 	definition->id = oscap_strdup(id);
 	definition->version = 0;
@@ -235,9 +237,35 @@ void oval_definition_free(struct oval_definition *definition)
 	definition->notes = NULL;
 	definition->anyxml = NULL;
 	definition->title = NULL;
+	oscap_memtag_free(OSCAP_MEMTAG_OVAL_MODEL, definition, sizeof(oval_definition_t));
 	free(definition);
 }
 
+void oval_definition_clear(struct oval_definition *definition)
+{
+	__attribute__nonnull__(definition);
+
+	free(definition->title);
+	free(definition->description);
+	if (definition->criteria != NULL)
+		oval_criteria_node_free(definition->criteria);
+	oval_collection_free_items(definition->affected, (oscap_destruct_func) oval_affected_free);
+	oval_collection_free_items(definition->reference, (oscap_destruct_func) oval_reference_free);
+	oval_collection_free_items(definition->notes, (oscap_destruct_func) free);
+	free(definition->anyxml);
+
+	definition->version = 0;
+	definition->class = OVAL_CLASS_UNKNOWN;
+	definition->deprecated = 0;
+	definition->title = NULL;
+	definition->description = NULL;
+	definition->affected = oval_collection_new();
+	definition->reference = oval_collection_new();
+	definition->notes = oval_collection_new();
+	definition->anyxml = NULL;
+	definition->criteria = NULL;
+}
+
 bool oval_definition_iterator_has_more(struct oval_definition_iterator
 				       *oc_definition)
 {
@@ -64,6 +64,16 @@ oval_arithmetic_operation_t oval_arithmetic_operation_parse(xmlTextReaderPtr, ch
 oval_datetime_format_t oval_datetime_format_parse(xmlTextReaderPtr, char *, oval_datetime_format_t);
 oval_message_level_t oval_message_level_parse(xmlTextReaderPtr, char *, oval_message_level_t);
 void oval_variable_set_type(struct oval_variable *variable, oval_variable_type_t type);
+/**
+ * Drop computed values of a local variable which depends on an external variable.
+ * @param all drop the values even if the variable doesn't depend on an external one
+ * @return true if the values have been dropped
+ */
+bool oval_variable_reset_computed_values(struct oval_variable *variable, bool all);
+/**
+ * Reset a variable to the state it had when it was created, keeping its ID and type.
+ */
+void oval_variable_clear(struct oval_variable *variable);
 
 
 oval_definition_class_t oval_definition_class_enum(char *);
@@ -86,6 +96,11 @@ int oval_reference_parse_tag(xmlTextReaderPtr, struct oval_parser_context *, ova
 
 int oval_definition_parse_tag(xmlTextReaderPtr reader, struct oval_parser_context *context, void *);
 xmlNode *oval_definition_to_dom(struct oval_definition *, xmlDoc *, xmlNode *);
+/* reset the element to the state it had when it was created, keeping its ID, to parse it again */
+void oval_definition_clear(struct oval_definition *definition);
+void oval_test_clear(struct oval_test *test);
+void oval_object_clear(struct oval_object *object);
+void oval_state_clear(struct oval_state *state);
 
 int oval_object_parse_tag(xmlTextReaderPtr reader, struct oval_parser_context *context, void *);
 xmlNode *oval_object_to_dom(struct oval_object *, xmlDoc *, xmlNode *);
@@ -182,6 +197,33 @@ oval_schema_version_t oval_definition_model_get_platform_schema_version(struct o
 
 struct oval_string_map *oval_definition_model_build_vardef_mapping(struct oval_definition_model *model);
 struct oval_string_iterator *oval_definition_model_get_definitions_dependent_on_variable(struct oval_definition_model *model, struct oval_variable *variable);
+struct oval_string_map *oval_definition_model_build_varobj_mapping(struct oval_definition_model *model);
+/**
+ * Get objects which reference the variable, directly or through other
+ * variables and objects.
+ */
+struct oval_object_iterator *oval_definition_model_get_objects_dependent_on_variable(struct oval_definition_model *model, struct oval_variable *variable);
+/**
+ * Drop computed values of local variables which depend on an external
+ * variable, so that they are computed again with the new external values.
+ * Values of the other local variables are kept.
+ */
+void oval_definition_model_reset_local_variables(struct oval_definition_model *model);
+/**
+ * Import the source without building its definitions, tests, objects, states
+ * and variables. Only the generator is parsed and the references between the
+ * elements are indexed; the elements are built by
+ * @ref oval_definition_model_load_definitions. The source has to outlive the model.
+ */
+struct oval_definition_model *oval_definition_model_import_source_deferred(struct oscap_source *source);
+/**
+ * Build the given definitions of a model imported by
+ * @ref oval_definition_model_import_source_deferred together with all the
+ * tests, objects, states and variables they use.
+ * @param ids IDs of the definitions, NULL to build the whole document
+ * @return 0 on success (also when the model has been fully loaded), -1 on error
+ */
+int oval_definition_model_load_definitions(struct oval_definition_model *model, struct oscap_stringlist *ids);
 
 /* variable model */
 struct oval_collection *oval_variable_model_get_values_ref(struct oval_variable_model *, char *);
@@ -117,6 +117,7 @@ int oval_directives_model_import_source(struct oval_directives_model *model, str
 	}
         context.directives_model = model;
         context.user_data = NULL;
+        context.id_filter = NULL;
         /* jump into oval_system_characteristics */
         xmlTextReaderRead(context.reader);
 
@@ -165,6 +166,28 @@ struct oval_result_directives *oval_directives_model_get_defdirs(struct oval_dir
 	return model->def_directives;
 }
 
+static bool oval_result_directives_is_thin(struct oval_result_directives *directives)
+{
+	for (int i = 0; i < NUMBER_OF_RESULTS; i++) {
+		if (directives->directive[i].reported &&
+		    directives->directive[i].content == OVAL_DIRECTIVE_CONTENT_FULL)
+			return false;
+	}
+	return true;
+}
+
+bool oval_directives_model_is_thin(struct oval_directives_model *model)
+{
+	if (model->def_directives != NULL && !oval_result_directives_is_thin(model->def_directives))
+		return false;
+
+	for (int i = 0; i < NUMBER_OF_CLASSES; i++) {
+		if (model->class_directives[i] != NULL && !oval_result_directives_is_thin(model->class_directives[i]))
+			return false;
+	}
+	return true;
+}
+
 struct oval_result_directives *oval_directives_model_get_classdir(struct oval_directives_model *model, oval_definition_class_t classdir)
 {
 	/* enum -> index */
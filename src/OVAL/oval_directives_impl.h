@@ -40,6 +40,11 @@
 int oval_result_directives_parse_tag(xmlTextReaderPtr, struct oval_parser_context *, void *);
 int oval_result_directives_to_dom(struct oval_result_directives *, xmlDoc *, xmlNode *);
 xmlNode *oval_directives_model_to_dom(struct oval_directives_model *, xmlDocPtr, xmlNode *);
+/**
+ * Check whether none of the reported definitions is exported with full
+ * content, i.e. results of the tested items are never exported.
+ */
+bool oval_directives_model_is_thin(struct oval_directives_model *);
 
 
 #define OVAL_DIRECTIVES_IMPL_H_
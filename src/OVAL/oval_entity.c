@@ -43,6 +43,7 @@
 #include "oval_parser_impl.h"
 
 #include "common/util.h"
+#include "common/memtag_priv.h"
 #include "common/debug_priv.h"
 #include "common/elements.h"
 #include "common/_error.h"
@@ -161,6 +162,7 @@ struct oval_value *oval_entity_get_value(struct oval_entity *entity)
 struct oval_entity *oval_entity_new(struct oval_definition_model *model)
 {
 	struct oval_entity *entity = (struct oval_entity *)malloc(sizeof(struct oval_entity));
+	oscap_memtag_alloc(OSCAP_MEMTAG_OVAL_MODEL, entity, sizeof(struct oval_entity));
 	if (entity == NULL)
 		return NULL;
 
@@ -215,6 +217,7 @@ void oval_entity_free(struct oval_entity *entity)
 	entity->name = NULL;
 	entity->value = NULL;
 	entity->variable = NULL;
+	oscap_memtag_free(OSCAP_MEMTAG_OVAL_MODEL, entity, sizeof(struct oval_entity));
 	free(entity);
 }
 
@@ -0,0 +1,485 @@
+/**
+ * @file oval_glob.c
+ * \brief Open Vulnerability and Assessment Language
+ *
+ * See more details at http://oval.mitre.org/
+ */
+
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "oval_glob.h"
+
+typedef enum {
+	OVAL_GLOB_CHAR,  /* a byte of the pattern */
+	OVAL_GLOB_ANY,   /* [^/] */
+	OVAL_GLOB_STAR,  /* [^/]* */
+	OVAL_GLOB_CLASS  /* a character class, ASCII members only */
+} oval_glob_tok_type_t;
+
+struct oval_glob_tok {
+	oval_glob_tok_type_t type;
+	unsigned char c;
+	bool negated;
+	uint32_t set[4];
+};
+
+struct oval_glob_seg {
+	bool nodot;                 /* starts with (?=[^.]) */
+	char *text;                 /* the segment if it has no wildcards */
+	size_t len;
+	struct oval_glob_tok *toks;
+	size_t count;
+};
+
+struct oval_glob {
+	struct oval_glob_seg *segs;
+	size_t count;
+};
+
+/* length of the UTF-8 character, 0 if it isn't valid as PCRE checks it */
+static size_t oval_glob_utf8_len(const unsigned char *s, size_t len)
+{
+	size_t n;
+	uint32_t cp;
+
+	if (s[0] < 0x80)
+		return 1;
+	if (s[0] >= 0xc2 && s[0] <= 0xdf) {
+		n = 2;
+		cp = s[0] & 0x1f;
+	} else if (s[0] >= 0xe0 && s[0] <= 0xef) {
+		n = 3;
+		cp = s[0] & 0x0f;
+	} else if (s[0] >= 0xf0 && s[0] <= 0xf4) {
+		n = 4;
+		cp = s[0] & 0x07;
+	} else {
+		return 0;
+	}
+	if (len < n)
+		return 0;
+	for (size_t i = 1; i < n; i++) {
+		if ((s[i] & 0xc0) != 0x80)
+			return 0;
+		cp = (cp << 6) | (s[i] & 0x3f);
+	}
+	/* overlong forms, surrogates and code points above U+10FFFF */
+	if ((n == 3 && cp < 0x800) || (n == 4 && cp < 0x10000)
+	    || (cp >= 0xd800 && cp <= 0xdfff) || cp > 0x10ffff)
+		return 0;
+
+	return n;
+}
+
+static bool oval_glob_utf8_valid(const char *str, size_t len)
+{
+	const unsigned char *s = (const unsigned char *)str;
+
+	for (size_t i = 0; i < len; ) {
+		size_t n = oval_glob_utf8_len(s + i, len - i);
+
+		if (n == 0)
+			return false;
+		i += n;
+	}
+
+	return true;
+}
+
+static void oval_glob_set_add(uint32_t *set, unsigned char lo, unsigned char hi)
+{
+	for (unsigned int c = lo; c <= hi; c++)
+		set[c / 32] |= 1u << (c % 32);
+}
+
+static bool oval_glob_set_has(const uint32_t *set, unsigned char c)
+{
+	return (set[c / 32] >> (c % 32)) & 1;
+}
+
+/* POSIX class of a bracket expression, the ASCII characters only as without PCRE_UCP */
+static bool oval_glob_set_posix(uint32_t *set, const char *name, size_t len)
+{
+	static const struct {
+		const char *name;
+		int (*is)(int);
+	} classes[] = {
+		{ "alnum", isalnum }, { "alpha", isalpha }, { "blank", isblank },
+		{ "cntrl", iscntrl }, { "digit", isdigit }, { "graph", isgraph },
+		{ "lower", islower }, { "print", isprint }, { "punct", ispunct },
+		{ "space", isspace }, { "upper", isupper }, { "xdigit", isxdigit }
+	};
+
+	for (size_t i = 0; i < sizeof(classes) / sizeof(classes[0]); i++) {
+		if (strlen(classes[i].name) != len || strncmp(classes[i].name, name, len) != 0)
+			continue;
+		for (int c = 0; c < 0x80; c++) {
+			if (classes[i].is(c))
+				oval_glob_set_add(set, c, c);
+		}
+		return true;
+	}
+	if (len == 4 && strncmp(name, "word", 4) == 0) {
+		for (int c = 0; c < 0x80; c++) {
+			if (isalnum(c) || c == '_')
+				oval_glob_set_add(set, c, c);
+		}
+		return true;
+	}
+
+	return false;
+}
+
+/* a member of a class which stands for itself, 0 if it doesn't */
+static unsigned char oval_glob_class_char(const char **p)
+{
+	const unsigned char *q = (const unsigned char *)*p;
+
+	if (q[0] == '\\') {
+		/* escapes of letters and digits are classes or codes */
+		if (q[1] == '\0' || q[1] >= 0x80 || isalnum(q[1]))
+			return 0;
+		*p += 2;
+		return q[1];
+	}
+	if (q[0] >= 0x80 || (q[0] == '[' && (q[1] == ':' || q[1] == '.' || q[1] == '=')))
+		return 0;
+	*p += 1;
+	return q[0];
+}
+
+/* parse a class at p, return a pointer past it or NULL if it isn't supported */
+static const char *oval_glob_parse_class(const char *p, struct oval_glob_tok *tok)
+{
+	bool first = true;
+
+	memset(tok, 0, sizeof(*tok));
+	tok->type = OVAL_GLOB_CLASS;
+	p++; /* '[' */
+	if (*p == '^') {
+		tok->negated = true;
+		p++;
+	}
+
+	for (;;) {
+		unsigned char lo, hi;
+
+		if (*p == '\0')
+			return NULL;
+		if (*p == ']' && !first)
+			return p + 1;
+		first = false;
+
+		if (p[0] == '[' && p[1] == ':') {
+			const char *end = strstr(p + 2, ":]");
+
+			if (end == NULL || p[2] == '^' || !oval_glob_set_posix(tok->set, p + 2, end - p - 2))
+				return NULL;
+			p = end + 2;
+			continue;
+		}
+
+		lo = oval_glob_class_char(&p);
+		if (lo == 0)
+			return NULL;
+		if (p[0] == '-' && p[1] != ']' && p[1] != '\0') {
+			p++;
+			hi = oval_glob_class_char(&p);
+			if (hi == 0 || hi < lo)
+				return NULL;
+		} else {
+			hi = lo;
+		}
+		oval_glob_set_add(tok->set, lo, hi);
+	}
+}
+
+static bool oval_glob_seg_add(struct oval_glob_seg *seg, const struct oval_glob_tok *tok)
+{
+	struct oval_glob_tok *toks;
+
+	/* consecutive stars match the same as one */
+	if (tok->type == OVAL_GLOB_STAR && seg->count > 0 && seg->toks[seg->count - 1].type == OVAL_GLOB_STAR)
+		return true;
+
+	toks = realloc(seg->toks, (seg->count + 1) * sizeof(struct oval_glob_tok));
+	if (toks == NULL)
+		return false;
+	seg->toks = toks;
+	seg->toks[seg->count++] = *tok;
+
+	return true;
+}
+
+static struct oval_glob_seg *oval_glob_add_seg(struct oval_glob *glob)
+{
+	struct oval_glob_seg *segs;
+
+	segs = realloc(glob->segs, (glob->count + 1) * sizeof(struct oval_glob_seg));
+	if (segs == NULL)
+		return NULL;
+	glob->segs = segs;
+	memset(&glob->segs[glob->count], 0, sizeof(struct oval_glob_seg));
+
+	return &glob->segs[glob->count++];
+}
+
+/* the segments without wildcards are compared as strings */
+static bool oval_glob_seg_finish(struct oval_glob_seg *seg)
+{
+	for (size_t i = 0; i < seg->count; i++) {
+		if (seg->toks[i].type != OVAL_GLOB_CHAR)
+			return true;
+	}
+
+	seg->text = malloc(seg->count + 1);
+	if (seg->text == NULL)
+		return false;
+	for (size_t i = 0; i < seg->count; i++)
+		seg->text[i] = seg->toks[i].c;
+	seg->text[seg->count] = '\0';
+	seg->len = seg->count;
+
+	return true;
+}
+
+struct oval_glob *oval_glob_from_regex(const char *regex)
+{
+	struct oval_glob *glob;
+	struct oval_glob_seg *seg;
+	const char *p = regex;
+
+	if (regex == NULL || *p != '^' || !oval_glob_utf8_valid(regex, strlen(regex)))
+		return NULL;
+	p++;
+
+	glob = calloc(1, sizeof(struct oval_glob));
+	if (glob == NULL || (seg = oval_glob_add_seg(glob)) == NULL)
+		goto fail;
+
+	for (;;) {
+		struct oval_glob_tok tok;
+
+		memset(&tok, 0, sizeof(tok));
+		if (p[0] == '$' && p[1] == '\0')
+			break;
+
+		switch (*p) {
+		case '\0':
+			/* not anchored at the end */
+			goto fail;
+		case '(':
+			/* a leading '*' or '?' doesn't match a dot */
+			if (strncmp(p, "(?=[^.])", 8) != 0 || seg->count > 0 || seg->nodot)
+				goto fail;
+			seg->nodot = true;
+			p += 8;
+			continue;
+		case '[':
+			if (strncmp(p, "[^/]*", 5) == 0) {
+				tok.type = OVAL_GLOB_STAR;
+				p += 5;
+			} else if (strncmp(p, "[^/]", 4) == 0) {
+				tok.type = OVAL_GLOB_ANY;
+				p += 4;
+			} else {
+				p = oval_glob_parse_class(p, &tok);
+				/* a class matching a slash would span the segments */
+				if (p == NULL || oval_glob_set_has(tok.set, '/') == !tok.negated)
+					goto fail;
+			}
+			break;
+		case '\\':
+			if (p[1] == '\0' || (unsigned char)p[1] >= 0x80 || isalnum((unsigned char)p[1]))
+				goto fail;
+			tok.type = OVAL_GLOB_CHAR;
+			tok.c = p[1];
+			p += 2;
+			break;
+		case '.': case '|': case '^': case ')': case '{': case '}':
+		case '+': case '$': case '*': case '?':
+			goto fail;
+		default:
+			tok.type = OVAL_GLOB_CHAR;
+			tok.c = *p++;
+			break;
+		}
+
+		if (tok.type == OVAL_GLOB_CHAR && tok.c == '/') {
+			if (!oval_glob_seg_finish(seg) || (seg = oval_glob_add_seg(glob)) == NULL)
+				goto fail;
+			continue;
+		}
+		/* a quantifier after the token isn't a glob any more */
+		if (*p == '*' || *p == '+' || *p == '?' || *p == '{')
+			goto fail;
+		if (!oval_glob_seg_add(seg, &tok))
+			goto fail;
+	}
+
+	if (!oval_glob_seg_finish(seg))
+		goto fail;
+
+	return glob;
+fail:
+	oval_glob_free(glob);
+	return NULL;
+}
+
+void oval_glob_free(struct oval_glob *glob)
+{
+	if (glob == NULL)
+		return;
+	for (size_t i = 0; i < glob->count; i++) {
+		free(glob->segs[i].text);
+		free(glob->segs[i].toks);
+	}
+	free(glob->segs);
+	free(glob);
+}
+
+/* bytes of the string the token matches, 0 if it doesn't match */
+static size_t oval_glob_tok_match(const struct oval_glob_tok *tok, const unsigned char *s, size_t len)
+{
+	switch (tok->type) {
+	case OVAL_GLOB_CHAR:
+		return s[0] == tok->c ? 1 : 0;
+	case OVAL_GLOB_ANY:
+		return oval_glob_utf8_len(s, len);
+	case OVAL_GLOB_CLASS:
+		if (s[0] < 0x80)
+			return oval_glob_set_has(tok->set, s[0]) != tok->negated ? 1 : 0;
+		/* the members are ASCII, a negated class matches the others */
+		return tok->negated ? oval_glob_utf8_len(s, len) : 0;
+	default:
+		return 0;
+	}
+}
+
+/*
+ * Match one component of the path, more tells whether a character which
+ * isn't a dot follows it for the lookahead of an empty component.
+ */
+static bool oval_glob_seg_match(const struct oval_glob_seg *seg, const char *str, size_t len, bool more)
+{
+	const unsigned char *s = (const unsigned char *)str;
+	size_t ti = 0, si = 0, star_ti = SIZE_MAX, star_si = 0;
+
+	if (seg->nodot && (len > 0 ? s[0] == '.' : !more))
+		return false;
+	if (seg->text != NULL)
+		return len == seg->len && memcmp(str, seg->text, len) == 0;
+
+	/* a star takes one character more each time the rest doesn't match */
+	while (si < len) {
+		if (ti < seg->count) {
+			const struct oval_glob_tok *tok = &seg->toks[ti];
+			size_t n;
+
+			if (tok->type == OVAL_GLOB_STAR) {
+				star_ti = ti++;
+				star_si = si;
+				continue;
+			}
+			n = oval_glob_tok_match(tok, s + si, len - si);
+			if (n > 0) {
+				si += n;
+				ti++;
+				continue;
+			}
+		}
+		if (star_ti == SIZE_MAX)
+			return false;
+		ti = star_ti + 1;
+		star_si += oval_glob_utf8_len(s + star_si, len - star_si);
+		si = star_si;
+	}
+	while (ti < seg->count && seg->toks[ti].type == OVAL_GLOB_STAR)
+		ti++;
+
+	return ti == seg->count;
+}
+
+static bool oval_glob_match_full(const struct oval_glob *glob, const char *str, size_t len, bool newline)
+{
+	const char *end = str + len;
+
+	for (size_t i = 0; i < glob->count; i++) {
+		const char *slash = memchr(str, '/', end - str);
+		bool last = (i == glob->count - 1);
+
+		if (last != (slash == NULL))
+			return false;
+		if (last)
+			return oval_glob_seg_match(&glob->segs[i], str, end - str, newline);
+		if (!oval_glob_seg_match(&glob->segs[i], str, slash - str, true))
+			return false;
+		str = slash + 1;
+	}
+
+	return false;
+}
+
+int oval_glob_match(const struct oval_glob *glob, const char *str, size_t len)
+{
+	if (!oval_glob_utf8_valid(str, len))
+		return -1;
+	if (oval_glob_match_full(glob, str, len, false))
+		return 1;
+	/* '$' matches also before a newline at the end */
+	if (len > 0 && str[len - 1] == '\n' && oval_glob_match_full(glob, str, len - 1, true))
+		return 1;
+
+	return 0;
+}
+
+bool oval_glob_match_below(const struct oval_glob *glob, const char *dir, size_t len)
+{
+	const char *end;
+	size_t i;
+
+	if (len > 0 && dir[len - 1] == '/')
+		len--;
+	if (!oval_glob_utf8_valid(dir, len))
+		return true;
+
+	/* every component of the directory has to match, a segment has to be left for the rest */
+	end = dir + len;
+	for (i = 0; i < glob->count; i++) {
+		const char *slash = memchr(dir, '/', end - dir);
+		const char *comp_end = slash != NULL ? slash : end;
+
+		if (!oval_glob_seg_match(&glob->segs[i], dir, comp_end - dir, true))
+			return false;
+		if (slash == NULL)
+			break;
+		dir = slash + 1;
+	}
+
+	return i + 1 < glob->count;
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef _OVAL_GLOB
+#define _OVAL_GLOB
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Compiled glob, matched without PCRE. The objects see the globs only as
+ * the regular expressions made of them by oval_glob_to_regex(), so the
+ * glob is compiled back from such a regular expression. Any pattern built
+ * of the same pieces is accepted: anchored literal characters, '[^/]*'
+ * for '*' (consecutive ones, as '**' gives, are one), '[^/]' and '[^./]'
+ * for '?', the '(?=[^.])' of a leading '*' and character classes that
+ * can't match a '/'. The matching is the same as of pcre_exec() with
+ * PCRE_UTF8 on the pattern.
+ *
+ * The pattern is split into the segments between the slashes, each of
+ * them matches one component of a path. Segments without wildcards are
+ * compared by memcmp().
+ */
+struct oval_glob;
+
+/**
+ * Compile the glob a regular expression was made of.
+ * @param regex regular expression, e.g. from oval_glob_to_regex()
+ * @return the glob or NULL if the regular expression isn't one
+ */
+struct oval_glob *oval_glob_from_regex(const char *regex);
+
+void oval_glob_free(struct oval_glob *glob);
+
+/**
+ * Match a string with the glob.
+ * @return 1 if it matches, 0 if it doesn't, -1 if the string isn't
+ * valid UTF-8 and PCRE would report an error instead
+ */
+int oval_glob_match(const struct oval_glob *glob, const char *str, size_t len);
+
+/**
+ * Check whether a path below the directory may match the glob, the
+ * directories for which it is false need not be walked.
+ * @param dir path of the directory
+ */
+bool oval_glob_match_below(const struct oval_glob *glob, const char *dir, size_t len);
+
+#endif
@@ -39,6 +39,7 @@
 #include "adt/oval_collection_impl.h"
 #include "oval_agent_api_impl.h"
 #include "common/debug_priv.h"
+#include "common/memtag_priv.h"
 #include "common/elements.h"
 #include "public/oval_schema_version.h"
 
@@ -166,6 +167,7 @@ struct oval_object *oval_object_new(struct oval_definition_model *model, const c
 	oval_object_t *object;
 
 	object = (oval_object_t *) malloc(sizeof(oval_object_t));
+	oscap_memtag_alloc(OSCAP_MEMTAG_OVAL_MODEL, object, sizeof(oval_object_t));
 	if (object == NULL)
 		return NULL;
 
@@ -248,9 +250,29 @@ void oval_object_free(struct oval_object *object)
 	object->behaviors = NULL;
 	object->notes = NULL;
 	object->object_content = NULL;
+	oscap_memtag_free(OSCAP_MEMTAG_OVAL_MODEL, object, sizeof(oval_object_t));
 	free(object);
 }
 
+void oval_object_clear(struct oval_object *object)
+{
+	__attribute__nonnull__(object);
+
+	free(object->comment);
+	oval_collection_free_items(object->behaviors, (oscap_destruct_func) oval_behavior_free);
+	oval_collection_free_items(object->notes, (oscap_destruct_func) free);
+	oval_collection_free_items(object->object_content, (oscap_destruct_func) oval_object_content_free);
+
+	object->comment = NULL;
+	object->subtype = OVAL_SUBTYPE_UNKNOWN;
+	object->base_obj_ref = NULL;
+	object->deprecated = 0;
+	object->version = 0;
+	object->behaviors = oval_collection_new();
+	object->notes = oval_collection_new();
+	object->object_content = oval_collection_new();
+}
+
 void oval_object_set_subtype(struct oval_object *object, oval_subtype_t subtype)
 {
 	__attribute__nonnull__(object);
@@ -39,6 +39,7 @@
 #include "adt/oval_collection_impl.h"
 #include "oval_agent_api_impl.h"
 #include "common/util.h"
+#include "common/memtag_priv.h"
 #include "common/debug_priv.h"
 
 typedef struct oval_object_content {
@@ -196,6 +197,7 @@ struct oval_object_content
 		dE("Unsupported object content type: %d.", type);
 		return NULL;
 	}
+	oscap_memtag_alloc(OSCAP_MEMTAG_OVAL_MODEL, content, sizeof(oval_object_content_t));
 	content->model = model;
 	content->fieldName = NULL;
 	content->type = type;
@@ -260,6 +262,7 @@ void oval_object_content_free(struct oval_object_content *content)
 	case OVAL_OBJECTCONTENT_UNKNOWN:
 		break;
 	}
+	oscap_memtag_free(OSCAP_MEMTAG_OVAL_MODEL, content, sizeof(oval_object_content_t));
 	free(content);
 }
 
@@ -0,0 +1,800 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+#include <pthread.h>
+#if !defined(OS_WINDOWS)
+#include <fcntl.h>
+#include <libgen.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+
+#include "common/debug_priv.h"
+#include "probes/SEAP/generic/rbt/rbt.h"
+#include "probes/public/probe-api.h"
+#include "oval_object_cache_impl.h"
+#include "_sexp-types.h"
+#include "_sexp-ID.h"
+#include "sexp-binary.h"
+
+struct oval_object_cache_entry {
+	SEXP_t *canonical; ///< canonical form of the object
+	SEXP_t *s_sys;     ///< collected object
+	uint64_t signature; ///< inputs of the collection, 0 if not persisted
+	struct oval_object_cache_entry *next; ///< entry with the same fingerprint
+	struct oval_object_cache_entry *all_next; ///< next entry of the cache
+};
+
+/* object collected by a previous scan, points into the loaded state file */
+struct oval_object_state_entry {
+	uint64_t signature;
+	const uint8_t *canonical;
+	uint32_t canonical_len;
+	const uint8_t *s_sys;
+	uint32_t s_sys_len;
+	struct oval_object_state_entry *next; ///< entry with the same fingerprint
+};
+
+struct oval_object_cache {
+	pthread_mutex_t lock;
+	rbt_t *tree;       ///< fingerprint -> list of entries
+	struct oval_object_cache_entry *entries; ///< all the entries
+	size_t hits;
+	size_t misses;
+	char *state_path;  ///< OSCAP_INCREMENTAL_STATE, NULL if not set
+	time_t created;
+	bool state_loaded;
+	rbt_t *previous;   ///< fingerprint -> list of oval_object_state_entry
+	uint8_t *state_buf;
+	size_t reused;
+};
+
+struct oval_object_cache *oval_object_cache_new(void)
+{
+	struct oval_object_cache *cache = malloc(sizeof(struct oval_object_cache));
+
+	if (cache == NULL)
+		return NULL;
+
+	if (pthread_mutex_init(&cache->lock, NULL) != 0) {
+		free(cache);
+		return NULL;
+	}
+
+	cache->tree = rbt_i64_new();
+	cache->entries = NULL;
+	cache->hits = 0;
+	cache->misses = 0;
+	cache->state_path = NULL;
+	cache->created = time(NULL);
+	cache->state_loaded = false;
+	cache->previous = NULL;
+	cache->state_buf = NULL;
+	cache->reused = 0;
+
+#if !defined(OS_WINDOWS)
+	const char *state_path = getenv("OSCAP_INCREMENTAL_STATE");
+	if (state_path != NULL && *state_path != '\0')
+		cache->state_path = strdup(state_path);
+#endif
+
+	return cache;
+}
+
+static void oval_object_cache_free_node(struct rbt_i64_node *n)
+{
+	struct oval_object_cache_entry *entry = n->data, *next;
+
+	while (entry != NULL) {
+		next = entry->next;
+		SEXP_free(entry->canonical);
+		SEXP_free(entry->s_sys);
+		free(entry);
+		entry = next;
+	}
+}
+
+static void oval_object_state_free_node(struct rbt_i64_node *n)
+{
+	struct oval_object_state_entry *entry = n->data, *next;
+
+	while (entry != NULL) {
+		next = entry->next;
+		free(entry);
+		entry = next;
+	}
+}
+
+#if !defined(OS_WINDOWS)
+#define OVAL_OBJECT_STATE_MAGIC "OpenSCAP collected objects 1\n"
+/*
+ * Objects reading files which changed less than this many seconds before
+ * the scan started are not persisted, the files may change again without
+ * changing their timestamps.
+ */
+#define OVAL_OBJECT_STATE_RACY 2
+
+/* followed by the encoded canonical object and collected object */
+struct oval_object_state_record {
+	uint64_t fingerprint;
+	uint64_t signature;
+	uint32_t canonical_len;
+	uint32_t s_sys_len;
+};
+
+/* objects whose items depend only on the files named by their entities */
+static const char *oval_object_state_file_objects[] = {
+	"file_object", "fileextendedattribute_object", "filehash_object",
+	"filehash58_object", "textfilecontent_object", "textfilecontent54_object",
+	"xmlfilecontent_object", "yamlfilecontent_object", NULL
+};
+
+/* objects whose items depend only on the rpmdb */
+static const char *oval_object_state_rpm_objects[] = {
+	"rpminfo_object", NULL
+};
+
+/* directories and files of the rpmdb which change when a package is (un)installed */
+static const char *oval_object_state_rpmdb_files[] = {
+	"/var/lib/rpm", "/var/lib/rpm/Packages", "/var/lib/rpm/Packages.db",
+	"/var/lib/rpm/rpmdb.sqlite", "/var/lib/rpm/rpmdb.sqlite-wal",
+	"/usr/lib/sysimage/rpm", "/usr/lib/sysimage/rpm/rpmdb.sqlite",
+	"/usr/lib/sysimage/rpm/rpmdb.sqlite-wal", NULL
+};
+
+struct oval_object_signature {
+	uint64_t hash;
+	time_t newest;      ///< the newest change time of the stat-ed files
+	const char *prefix; ///< OSCAP_PROBE_ROOT
+};
+
+static bool oval_object_state_name_in(const char *name, const char **names)
+{
+	for (; *names != NULL; ++names) {
+		if (strcmp(name, *names) == 0)
+			return true;
+	}
+	return false;
+}
+
+/* FNV-1a */
+static void oval_object_signature_add(struct oval_object_signature *sig, const void *data, size_t len)
+{
+	const uint8_t *p = data;
+
+	for (size_t i = 0; i < len; ++i) {
+		sig->hash ^= p[i];
+		sig->hash *= 1099511628211ULL;
+	}
+}
+
+static void oval_object_signature_stat(struct oval_object_signature *sig, const char *path)
+{
+	struct {
+		uint64_t dev, ino;
+		int64_t size, mtime, mtime_nsec, ctime, ctime_nsec;
+		int64_t err;
+	} tuple;
+	char full_path[PATH_MAX];
+	struct stat st;
+
+	oval_object_signature_add(sig, path, strlen(path) + 1);
+	if (snprintf(full_path, sizeof(full_path), "%s%s", sig->prefix, path) >= (int)sizeof(full_path)) {
+		/* can't be stat-ed now, nor could it be collected */
+		oval_object_signature_add(sig, "", 1);
+		return;
+	}
+
+	/* the status of symlinks and of their targets */
+	for (int follow = 0; follow < 2; ++follow) {
+		memset(&tuple, 0, sizeof(tuple));
+		if ((follow ? stat(full_path, &st) : lstat(full_path, &st)) != 0) {
+			tuple.err = errno;
+		} else {
+			tuple.dev = st.st_dev;
+			tuple.ino = st.st_ino;
+			tuple.size = st.st_size;
+			tuple.mtime = st.st_mtime;
+			tuple.ctime = st.st_ctime;
+#if defined(OS_LINUX) || defined(OS_SOLARIS)
+			tuple.mtime_nsec = st.st_mtim.tv_nsec;
+			tuple.ctime_nsec = st.st_ctim.tv_nsec;
+#endif
+			if (st.st_ctime > sig->newest)
+				sig->newest = st.st_ctime;
+		}
+		oval_object_signature_add(sig, &tuple, sizeof(tuple));
+		if (tuple.err != 0 || !S_ISLNK(st.st_mode))
+			break;
+	}
+}
+
+/*
+ * Get the values of an object entity which names paths.
+ * @return -1 if the entity doesn't name the paths directly
+ */
+static int oval_object_signature_values(const SEXP_t *obj, const char *name, SEXP_t **vals)
+{
+	SEXP_t *ent, *attr, *val;
+	int ret = 0;
+
+	*vals = NULL;
+	ent = probe_obj_getent(obj, name, 1);
+	if (ent == NULL)
+		return 0;
+
+	attr = probe_ent_getattrval(ent, "operation");
+	if (attr != NULL && SEXP_number_getu(attr) != OVAL_OPERATION_EQUALS)
+		ret = -1;
+	SEXP_free(attr);
+
+	if (ret == 0 && probe_ent_getvals(ent, vals) > 0) {
+		SEXP_list_foreach(val, *vals) {
+			if (!SEXP_stringp(val))
+				ret = -1;
+		}
+	}
+	SEXP_free(ent);
+
+	if (ret != 0) {
+		SEXP_free(*vals);
+		*vals = NULL;
+	}
+	return ret;
+}
+
+/*
+ * Stat the files and directories named by the path, filename and filepath
+ * entities of an object, the files are looked up even if none was found.
+ * @return -1 if the entities don't name the paths directly
+ */
+static int oval_object_signature_files(struct oval_object_signature *sig, const SEXP_t *obj)
+{
+	SEXP_t *paths, *names, *filepaths, *path_val, *name_val;
+	char path[PATH_MAX];
+	size_t len;
+	int ret = -1;
+
+	if (oval_object_signature_values(obj, "path", &paths) != 0)
+		return -1;
+	if (oval_object_signature_values(obj, "filename", &names) != 0) {
+		SEXP_free(paths);
+		return -1;
+	}
+	if (oval_object_signature_values(obj, "filepath", &filepaths) != 0)
+		goto cleanup;
+
+	if (filepaths != NULL) {
+		SEXP_list_foreach(path_val, filepaths) {
+			if (SEXP_string_cstr_r(path_val, path, sizeof(path)) == 0)
+				goto cleanup;
+			oval_object_signature_stat(sig, path);
+		}
+	}
+	if (paths != NULL) {
+		SEXP_list_foreach(path_val, paths) {
+			/* files added to or removed from the directory change its status */
+			if ((len = SEXP_string_cstr_r(path_val, path, sizeof(path))) == 0)
+				goto cleanup;
+			oval_object_signature_stat(sig, path);
+			if (names == NULL)
+				continue;
+			if (path[len - 1] != '/' && len + 1 < sizeof(path))
+				path[len++] = '/';
+			SEXP_list_foreach(name_val, names) {
+				/* empty (nil) filename names the directory itself */
+				if (SEXP_string_length(name_val) == 0)
+					continue;
+				if (len + SEXP_string_length(name_val) >= sizeof(path))
+					goto cleanup;
+				SEXP_string_cstr_r(name_val, path + len, sizeof(path) - len);
+				oval_object_signature_stat(sig, path);
+			}
+		}
+	}
+	ret = 0;
+
+cleanup:
+	SEXP_free(paths);
+	SEXP_free(names);
+	SEXP_free(filepaths);
+	return ret;
+}
+
+/* the path of a file item, false if the item has none */
+static bool oval_object_item_path(const SEXP_t *item, char *path, size_t size)
+{
+	SEXP_t *val;
+	size_t len;
+
+	val = probe_obj_getentval(item, "filepath", 1);
+	if (val != NULL) {
+		len = SEXP_stringp(val) ? SEXP_string_cstr_r(val, path, size) : 0;
+		SEXP_free(val);
+		return len > 0;
+	}
+
+	val = probe_obj_getentval(item, "path", 1);
+	len = val != NULL && SEXP_stringp(val) ? SEXP_string_cstr_r(val, path, size) : 0;
+	SEXP_free(val);
+	if (len == 0)
+		return false;
+
+	val = probe_obj_getentval(item, "filename", 1);
+	if (val != NULL && SEXP_stringp(val) && SEXP_string_length(val) > 0 && len + 1 < size) {
+		path[len++] = '/';
+		SEXP_string_cstr_r(val, path + len, size - len);
+	}
+	SEXP_free(val);
+
+	return true;
+}
+
+/*
+ * Compute the signature of everything the collection of the object read:
+ * the status of the files and directories named by the object and of the
+ * files of its items, or of the rpmdb.
+ * @return 0 on success, -1 if the object can't be persisted
+ */
+static int oval_object_signature(const SEXP_t *canonical, const SEXP_t *s_sys, time_t not_after, uint64_t *signature)
+{
+	struct oval_object_signature sig;
+	char name[64], path[PATH_MAX];
+	SEXP_t *ent, *attr, *items, *item;
+	const char *prefix;
+
+	if (probe_obj_getname_r(canonical, name, sizeof(name)) == 0)
+		return -1;
+
+	prefix = getenv("OSCAP_PROBE_ROOT");
+	sig.hash = 14695981039346656037ULL;
+	sig.newest = 0;
+	sig.prefix = prefix != NULL ? prefix : "";
+	oval_object_signature_add(&sig, name, strlen(name));
+
+	if (oval_object_state_name_in(name, oval_object_state_rpm_objects)) {
+		for (const char **file = oval_object_state_rpmdb_files; *file != NULL; ++file)
+			oval_object_signature_stat(&sig, *file);
+	} else if (oval_object_state_name_in(name, oval_object_state_file_objects)) {
+		/* a recursive walk can find files in any of the subdirectories */
+		ent = probe_obj_getent(canonical, "behaviors", 1);
+		if (ent != NULL) {
+			attr = probe_ent_getattrval(ent, "recurse_direction");
+			SEXP_free(ent);
+			if (attr != NULL && SEXP_strcmp(attr, "none") != 0) {
+				SEXP_free(attr);
+				return -1;
+			}
+			SEXP_free(attr);
+		}
+		/* a file matching a filename pattern may appear without changing anything stat-ed */
+		if (oval_object_signature_files(&sig, canonical) != 0)
+			return -1;
+
+		items = probe_cobj_get_items(s_sys);
+		SEXP_list_foreach(item, items) {
+			if (oval_object_item_path(item, path, sizeof(path)))
+				oval_object_signature_stat(&sig, path);
+		}
+		SEXP_free(items);
+	} else {
+		return -1;
+	}
+
+	if (sig.newest >= not_after)
+		return -1;
+
+	*signature = sig.hash != 0 ? sig.hash : 1;
+	return 0;
+}
+
+/* must be called with the cache lock held */
+static void oval_object_state_load(struct oval_object_cache *cache)
+{
+	struct oval_object_state_record rec;
+	struct stat st;
+	size_t off, count = 0;
+	int fd;
+
+	cache->state_loaded = true;
+	cache->previous = rbt_i64_new();
+
+	fd = open(cache->state_path, O_RDONLY | O_NOFOLLOW);
+	if (fd == -1) {
+		if (errno != ENOENT)
+			dW("Can't open the incremental state '%s': %s.", cache->state_path, strerror(errno));
+		return;
+	}
+	/* collected objects anybody else can write to would make the scan worthless */
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_uid != geteuid()
+	    || (st.st_mode & (S_IWGRP | S_IWOTH)) != 0) {
+		dW("Ignoring the incremental state '%s', it's not a regular file "
+		   "writable only by its owner.", cache->state_path);
+		close(fd);
+		return;
+	}
+
+	cache->state_buf = malloc(st.st_size > 0 ? st.st_size : 1);
+	if (cache->state_buf == NULL) {
+		close(fd);
+		return;
+	}
+	for (off = 0; off < (size_t)st.st_size;) {
+		ssize_t nread = read(fd, cache->state_buf + off, st.st_size - off);
+
+		if (nread == -1 && errno == EINTR)
+			continue;
+		if (nread <= 0)
+			break;
+		off += nread;
+	}
+	close(fd);
+
+	if (off != (size_t)st.st_size || off < sizeof(OVAL_OBJECT_STATE_MAGIC) - 1
+	    || memcmp(cache->state_buf, OVAL_OBJECT_STATE_MAGIC, sizeof(OVAL_OBJECT_STATE_MAGIC) - 1) != 0) {
+		dW("Ignoring the incremental state '%s' of an unknown format.", cache->state_path);
+		return;
+	}
+
+	for (off = sizeof(OVAL_OBJECT_STATE_MAGIC) - 1; off + sizeof(rec) <= (size_t)st.st_size;) {
+		struct oval_object_state_entry *entry, *head;
+
+		memcpy(&rec, cache->state_buf + off, sizeof(rec));
+		off += sizeof(rec);
+		if ((size_t)rec.canonical_len + rec.s_sys_len > (size_t)st.st_size - off) {
+			dW("The incremental state '%s' is truncated.", cache->state_path);
+			break;
+		}
+
+		entry = malloc(sizeof(struct oval_object_state_entry));
+		if (entry == NULL)
+			break;
+		entry->signature = rec.signature;
+		entry->canonical = cache->state_buf + off;
+		entry->canonical_len = rec.canonical_len;
+		entry->s_sys = entry->canonical + rec.canonical_len;
+		entry->s_sys_len = rec.s_sys_len;
+		entry->next = NULL;
+		off += (size_t)rec.canonical_len + rec.s_sys_len;
+
+		if (rbt_i64_get(cache->previous, (int64_t)rec.fingerprint, (void **)&head) == 0) {
+			entry->next = head->next;
+			head->next = entry;
+		} else if (rbt_i64_add(cache->previous, (int64_t)rec.fingerprint, entry, NULL) != 0) {
+			free(entry);
+			continue;
+		}
+		++count;
+	}
+
+	dI("Loaded %zu objects collected by the previous scan from '%s'.", count, cache->state_path);
+}
+
+/*
+ * Find the object in the state of the previous scan.
+ * @return the collected object if nothing it was collected from changed
+ */
+static SEXP_t *oval_object_state_get(struct oval_object_cache *cache, uint64_t fingerprint,
+                                     const SEXP_t *canonical, uint64_t *signature)
+{
+	struct oval_object_state_entry *entry = NULL;
+	SEXP_t *s_canon, *s_sys = NULL;
+	uint64_t prev_signature = 0;
+
+	pthread_mutex_lock(&cache->lock);
+	if (!cache->state_loaded)
+		oval_object_state_load(cache);
+	if (rbt_i64_get(cache->previous, (int64_t)fingerprint, (void **)&entry) != 0)
+		entry = NULL;
+	pthread_mutex_unlock(&cache->lock);
+
+	/* the loaded entries aren't modified anymore */
+	for (; entry != NULL && s_sys == NULL; entry = entry->next) {
+		s_canon = SEXP_bin_decode(entry->canonical, entry->canonical_len);
+		if (s_canon != NULL && SEXP_deepcmp(s_canon, canonical)) {
+			s_sys = SEXP_bin_decode(entry->s_sys, entry->s_sys_len);
+			prev_signature = entry->signature;
+		}
+		SEXP_free(s_canon);
+	}
+	if (s_sys == NULL)
+		return NULL;
+
+	if (oval_object_signature(canonical, s_sys, cache->created - OVAL_OBJECT_STATE_RACY, signature) != 0
+	    || *signature != prev_signature) {
+		SEXP_free(s_sys);
+		return NULL;
+	}
+
+	return s_sys;
+}
+
+static int oval_object_state_write(const struct oval_object_cache *cache, FILE *fp)
+{
+	struct oval_object_cache_entry *entry;
+
+	if (fputs(OVAL_OBJECT_STATE_MAGIC, fp) == EOF)
+		return -1;
+
+	for (entry = cache->entries; entry != NULL; entry = entry->all_next) {
+		struct oval_object_state_record rec;
+		void *canonical = NULL, *s_sys = NULL;
+		size_t canonical_len, s_sys_len;
+		int ret = 0;
+
+		if (entry->signature == 0)
+			continue;
+		if (SEXP_bin_encode(entry->canonical, &canonical, &canonical_len) != 0
+		    || SEXP_bin_encode(entry->s_sys, &s_sys, &s_sys_len) != 0
+		    || canonical_len > UINT32_MAX || s_sys_len > UINT32_MAX) {
+			free(canonical);
+			free(s_sys);
+			continue;
+		}
+
+		memset(&rec, 0, sizeof(rec));
+		rec.fingerprint = SEXP_ID_v(entry->canonical);
+		rec.signature = entry->signature;
+		rec.canonical_len = canonical_len;
+		rec.s_sys_len = s_sys_len;
+		if (fwrite(&rec, sizeof(rec), 1, fp) != 1
+		    || fwrite(canonical, canonical_len, 1, fp) != 1
+		    || fwrite(s_sys, s_sys_len, 1, fp) != 1)
+			ret = -1;
+		free(canonical);
+		free(s_sys);
+		if (ret != 0)
+			return -1;
+	}
+
+	return 0;
+}
+
+/* write the persisted entries of the cache to the state file */
+static void oval_object_state_save(const struct oval_object_cache *cache)
+{
+	char *tmp_path, *dir_copy;
+	FILE *fp;
+	int fd;
+
+	tmp_path = malloc(strlen(cache->state_path) + sizeof(".XXXXXX"));
+	if (tmp_path == NULL)
+		return;
+	sprintf(tmp_path, "%s.XXXXXX", cache->state_path);
+
+	dir_copy = strdup(cache->state_path);
+	if (dir_copy != NULL) {
+		if (mkdir(dirname(dir_copy), 0700) != 0 && errno != EEXIST)
+			dW("Can't create the directory of the incremental state '%s': %s.",
+			   cache->state_path, strerror(errno));
+		free(dir_copy);
+	}
+
+	fd = mkstemp(tmp_path);
+	if (fd == -1) {
+		dW("Can't write the incremental state '%s': %s.", cache->state_path, strerror(errno));
+		free(tmp_path);
+		return;
+	}
+	fp = fdopen(fd, "w");
+	if (fp == NULL) {
+		close(fd);
+		unlink(tmp_path);
+		free(tmp_path);
+		return;
+	}
+
+	if (oval_object_state_write(cache, fp) != 0 || fflush(fp) != 0 || fsync(fd) != 0 || ferror(fp)) {
+		dW("Can't write the incremental state '%s': %s.", cache->state_path, strerror(errno));
+		fclose(fp);
+		unlink(tmp_path);
+		free(tmp_path);
+		return;
+	}
+	fclose(fp);
+
+	if (rename(tmp_path, cache->state_path) != 0) {
+		dW("Can't replace the incremental state '%s': %s.", cache->state_path, strerror(errno));
+		unlink(tmp_path);
+	}
+	free(tmp_path);
+}
+#endif /* OS_WINDOWS */
+
+void oval_object_cache_free(struct oval_object_cache *cache)
+{
+	if (cache == NULL)
+		return;
+
+	dI("Collected object cache: %zu hits, %zu misses.", cache->hits, cache->misses);
+
+#if !defined(OS_WINDOWS)
+	if (cache->state_path != NULL) {
+		dI("Reused %zu objects collected by the previous scan.", cache->reused);
+		/* nothing was collected, e.g. the session was freed before the evaluation */
+		if (cache->entries != NULL)
+			oval_object_state_save(cache);
+	}
+#endif
+
+	rbt_i64_free_cb(cache->tree, &oval_object_cache_free_node);
+	if (cache->previous != NULL)
+		rbt_i64_free_cb(cache->previous, &oval_object_state_free_node);
+	free(cache->state_buf);
+	free(cache->state_path);
+	pthread_mutex_destroy(&cache->lock);
+	free(cache);
+}
+
+int oval_object_cache_fingerprint(const SEXP_t *s_obj, SEXP_t **canonical, uint64_t *fingerprint)
+{
+	SEXP_t *head, *rest, *c_head, *c_head_lst, *elm;
+	uint32_t i;
+
+	head = SEXP_list_first(s_obj);
+
+	if (head == NULL || !SEXP_listp(head)) {
+		SEXP_free(head);
+		return -1;
+	}
+
+	/*
+	 * Copy the object name and attributes except the id attribute.
+	 * Objects that failed variable resolution are never shared.
+	 */
+	c_head = SEXP_list_new(NULL);
+
+	for (i = 1; (elm = SEXP_list_nth(head, i)) != NULL; ++i) {
+		if (SEXP_stringp(elm) && SEXP_strcmp(elm, ":id") == 0) {
+			SEXP_free(elm);
+			++i;
+			continue;
+		}
+		if (SEXP_stringp(elm) && SEXP_strcmp(elm, ":skip_eval") == 0) {
+			SEXP_free(elm);
+			SEXP_free(c_head);
+			SEXP_free(head);
+			return -1;
+		}
+		SEXP_list_add(c_head, elm);
+		SEXP_free(elm);
+	}
+	SEXP_free(head);
+
+	c_head_lst = SEXP_list_new(c_head, NULL);
+	rest = SEXP_list_rest(s_obj);
+
+	*canonical = SEXP_list_join(c_head_lst, rest);
+	*fingerprint = SEXP_ID_v(*canonical);
+
+	SEXP_free(rest);
+	SEXP_free(c_head_lst);
+	SEXP_free(c_head);
+
+	return 0;
+}
+
+static int oval_object_cache_insert(struct oval_object_cache *cache, uint64_t fingerprint,
+                                    SEXP_t *canonical, SEXP_t *s_sys, uint64_t signature);
+
+SEXP_t *oval_object_cache_get(struct oval_object_cache *cache, uint64_t fingerprint, const SEXP_t *canonical)
+{
+	struct oval_object_cache_entry *entry = NULL;
+	SEXP_t *s_sys = NULL;
+
+	pthread_mutex_lock(&cache->lock);
+
+	if (rbt_i64_get(cache->tree, (int64_t)fingerprint, (void **)&entry) == 0) {
+		for (; entry != NULL; entry = entry->next) {
+			if (SEXP_deepcmp(entry->canonical, canonical)) {
+				s_sys = SEXP_ref(entry->s_sys);
+				break;
+			}
+		}
+	}
+
+	if (s_sys != NULL)
+		++cache->hits;
+	else
+		++cache->misses;
+
+	pthread_mutex_unlock(&cache->lock);
+
+#if !defined(OS_WINDOWS)
+	if (s_sys == NULL && cache->state_path != NULL) {
+		uint64_t signature;
+
+		s_sys = oval_object_state_get(cache, fingerprint, canonical, &signature);
+		if (s_sys != NULL) {
+			/* kept for the objects which are the same and for the next scan */
+			if (oval_object_cache_insert(cache, fingerprint, (SEXP_t *)canonical, s_sys, signature) != 0)
+				dW("Can't add a reused object to the collected object cache.");
+			pthread_mutex_lock(&cache->lock);
+			++cache->reused;
+			pthread_mutex_unlock(&cache->lock);
+		}
+	}
+#endif
+
+	return s_sys;
+}
+
+int oval_object_cache_add(struct oval_object_cache *cache, uint64_t fingerprint, SEXP_t *canonical, SEXP_t *s_sys)
+{
+	uint64_t signature = 0;
+
+#if !defined(OS_WINDOWS)
+	if (cache->state_path != NULL &&
+	    oval_object_signature(canonical, s_sys, cache->created - OVAL_OBJECT_STATE_RACY, &signature) != 0)
+		signature = 0;
+#endif
+
+	return oval_object_cache_insert(cache, fingerprint, canonical, s_sys, signature);
+}
+
+static int oval_object_cache_insert(struct oval_object_cache *cache, uint64_t fingerprint,
+                                    SEXP_t *canonical, SEXP_t *s_sys, uint64_t signature)
+{
+	struct oval_object_cache_entry *entry, *head = NULL;
+	int ret = 0;
+
+	entry = malloc(sizeof(struct oval_object_cache_entry));
+	if (entry == NULL)
+		return -1;
+
+	entry->canonical = SEXP_ref(canonical);
+	entry->s_sys = SEXP_ref(s_sys);
+	entry->signature = signature;
+	entry->next = NULL;
+
+	pthread_mutex_lock(&cache->lock);
+
+	if (rbt_i64_get(cache->tree, (int64_t)fingerprint, (void **)&head) == 0) {
+		/* fingerprint collision, append to the chain */
+		while (head->next != NULL)
+			head = head->next;
+		head->next = entry;
+	} else if (rbt_i64_add(cache->tree, (int64_t)fingerprint, entry, NULL) != 0) {
+		ret = -1;
+	}
+	if (ret == 0) {
+		entry->all_next = cache->entries;
+		cache->entries = entry;
+	}
+
+	pthread_mutex_unlock(&cache->lock);
+
+	if (ret != 0) {
+		SEXP_free(entry->canonical);
+		SEXP_free(entry->s_sys);
+		free(entry);
+	}
+
+	return ret;
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef OVAL_OBJECT_CACHE_IMPL_H
+#define OVAL_OBJECT_CACHE_IMPL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sexp.h>
+#include "public/oval_agent_api.h"
+#include "common/util.h"
+
+/**
+ * Cache of collected objects shared by all OVAL agent sessions of one scan.
+ *
+ * Objects are identified by a fingerprint computed from the object S-exp
+ * after variable references were resolved, omitting the object id. Two
+ * semantically identical objects from different OVAL documents have the
+ * same fingerprint and are collected only once.
+ *
+ * If OSCAP_INCREMENTAL_STATE names a file, the collected objects are written
+ * there when the cache is freed, and an object collected by the previous scan
+ * is reused if the status (device, inode, size, mtime, ctime) of everything
+ * it was collected from is the same. This is done only for non-recursive
+ * file based objects, whose inputs are the named paths and the files found,
+ * and for rpminfo objects, whose input is the rpmdb.
+ */
+struct oval_object_cache;
+
+#if defined(OVAL_PROBES_ENABLED)
+struct oval_object_cache *oval_object_cache_new(void);
+void oval_object_cache_free(struct oval_object_cache *cache);
+
+/**
+ * Compute the canonical form of an object S-exp, i.e. the object without
+ * its id attribute, and its fingerprint.
+ * @param s_obj object S-exp as produced by oval_object_to_sexp
+ * @param canonical canonical form of the object (to be freed by the caller)
+ * @param fingerprint fingerprint of the canonical form
+ * @return 0 on success, -1 if the object can't be shared
+ */
+int oval_object_cache_fingerprint(const SEXP_t *s_obj, SEXP_t **canonical, uint64_t *fingerprint);
+
+/**
+ * Lookup a collected object.
+ * @return new reference to the collected object S-exp or NULL if not cached
+ */
+SEXP_t *oval_object_cache_get(struct oval_object_cache *cache, uint64_t fingerprint, const SEXP_t *canonical);
+
+/**
+ * Store a collected object. The cache takes a new reference to both S-exps.
+ * @return 0 on success, -1 on error
+ */
+int oval_object_cache_add(struct oval_object_cache *cache, uint64_t fingerprint, SEXP_t *canonical, SEXP_t *s_sys);
+#else
+static inline struct oval_object_cache *oval_object_cache_new(void) { return NULL; }
+static inline void oval_object_cache_free(struct oval_object_cache *cache) { }
+#endif /* OVAL_PROBES_ENABLED */
+
+/**
+ * Use the cache for object collection in the given agent session. The cache
+ * is not owned by the session and has to outlive it. NULL collects every
+ * object anew.
+ */
+void oval_agent_set_object_cache(oval_agent_session_t *ag_sess, struct oval_object_cache *cache);
+
+/**
+ * Let the probes of the agent session skip the item entities the
+ * definitions don't use. The collected items are incomplete then, so it
+ * must not be enabled when the system characteristics are exported.
+ */
+void oval_agent_set_referenced_entities_only(oval_agent_session_t *ag_sess, bool referenced_only);
+
+/**
+ * Drop everything the agent session collected and evaluated, so that the
+ * system can be evaluated again from scratch. Unlike
+ * oval_agent_reset_session the system characteristics and the results are
+ * dropped too. The definitions and the running probes are kept.
+ * @return 0 on success, -1 on error
+ */
+int oval_agent_clear_session(oval_agent_session_t *ag_sess);
+
+#endif /* OVAL_OBJECT_CACHE_IMPL_H */
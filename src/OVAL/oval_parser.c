@@ -39,13 +39,16 @@
 #include "oval_agent_api_impl.h"
 #include "oval_parser_impl.h"
 #include "oval_definitions_impl.h"
+#include "adt/oval_string_map_impl.h"
 #include "common/util.h"
 #include "common/debug_priv.h"
 #include "common/_error.h"
 #include "common/elements.h"
 #include "common/public/oscap.h"
+#include "common/public/oscap_helpers.h"
 #include "source/public/oscap_source.h"
 #include "source/oscap_source_priv.h"
+#include "common/oscap_threadpool.h"
 
 /**
  * -1 error; 0 OK; 1 warning
@@ -133,6 +136,39 @@ char *oval_determine_document_schema_version_priv(xmlTextReader *reader, oscap_d
 	return version;
 }
 
+struct oval_filtered_tag_parser {
+	oval_xml_tag_parser parser;
+};
+
+/* parse the element only if its ID is in context->id_filter */
+static int _oval_parser_filtered_tag(xmlTextReaderPtr reader, struct oval_parser_context *context, void *user)
+{
+	struct oval_filtered_tag_parser *filtered = (struct oval_filtered_tag_parser *) user;
+	char *id = (char *) xmlTextReaderGetAttribute(reader, BAD_CAST "id");
+	int ret;
+
+	if (id != NULL && oval_string_map_get_value(context->id_filter, id) != NULL)
+		ret = (*filtered->parser) (reader, context, NULL);
+	else if (xmlTextReaderIsEmptyElement(reader))
+		ret = 0;
+	else
+		ret = oval_parser_skip_tag(reader, context);
+
+	free(id);
+	return ret;
+}
+
+static int _oval_parser_parse_section(xmlTextReaderPtr reader, struct oval_parser_context *context, oval_xml_tag_parser tag_parser)
+{
+	struct oval_filtered_tag_parser filtered;
+
+	if (context->id_filter == NULL)
+		return oval_parser_parse_tag(reader, context, tag_parser, NULL);
+
+	filtered.parser = tag_parser;
+	return oval_parser_parse_tag(reader, context, &_oval_parser_filtered_tag, &filtered);
+}
+
 /*
  * -1 error; 0 OK; 1 warning
  */
@@ -156,15 +192,18 @@ int oval_definition_model_parse(xmlTextReaderPtr reader, struct oval_parser_cont
 
 			int is_oval = strcmp((const char *)OVAL_DEFINITIONS_NAMESPACE, namespace) == 0;
 			if (is_oval && (strcmp(tagname, tagname_definitions) == 0)) {
-				ret = oval_parser_parse_tag(reader, context, &oval_definition_parse_tag, NULL);
+				ret = _oval_parser_parse_section(reader, context, &oval_definition_parse_tag);
 			} else if (is_oval && strcmp(tagname, tagname_tests) == 0) {
-				ret = oval_parser_parse_tag(reader, context, &oval_test_parse_tag, NULL);
+				ret = _oval_parser_parse_section(reader, context, &oval_test_parse_tag);
 			} else if (is_oval && strcmp(tagname, tagname_objects) == 0) {
-				ret =  oval_parser_parse_tag(reader, context, &oval_object_parse_tag, NULL);
+				ret = _oval_parser_parse_section(reader, context, &oval_object_parse_tag);
 			} else if (is_oval && strcmp(tagname, tagname_states) == 0) {
-				ret =  oval_parser_parse_tag(reader, context, &oval_state_parse_tag, NULL);
+				ret = _oval_parser_parse_section(reader, context, &oval_state_parse_tag);
 			} else if (is_oval && strcmp(tagname, tagname_variables) == 0) {
-				ret =  oval_parser_parse_tag(reader, context, &oval_variable_parse_tag, NULL);
+				ret = _oval_parser_parse_section(reader, context, &oval_variable_parse_tag);
+			} else if (is_oval && strcmp(tagname, tagname_generator) == 0 && context->id_filter != NULL) {
+				/* the generator has been parsed with the index of the document */
+				oval_parser_skip_tag(reader, context);
 			} else if (is_oval && strcmp(tagname, tagname_generator) == 0) {
 				struct oval_generator *gen;
 				gen = oval_definition_model_get_generator(context->definition_model);
@@ -187,6 +226,362 @@ int oval_definition_model_parse(xmlTextReaderPtr reader, struct oval_parser_cont
 	return ret;
 }
 
+/*
+ * Parallel parsing of large documents. The mapped document is split by a
+ * scan of its markup at the boundaries of the elements of the sections,
+ * each chunk is parsed into a small DOM by a worker thread and the model
+ * is built from the DOMs in document order, so the references between
+ * the elements are resolved as with the sequential parsing.
+ */
+
+/* documents smaller than this are parsed sequentially */
+#define OVAL_PARSE_PARALLEL_MIN (8 * 1024 * 1024)
+/* smallest chunk, the chunks are split so that each thread gets several */
+#define OVAL_PARSE_CHUNK_MIN (256 * 1024)
+#define OVAL_PARSE_MAX_JOBS 64
+
+enum oval_markup {
+	OVAL_MARKUP_START,
+	OVAL_MARKUP_EMPTY,
+	OVAL_MARKUP_END,
+	OVAL_MARKUP_OTHER
+};
+
+struct oval_parse_section {
+	size_t start;		///< start tag of the section
+	size_t end;
+	size_t name_len;
+};
+
+struct oval_parse_chunk {
+	size_t start;		///< elements of the chunk
+	size_t end;
+	int section;		///< section of the elements, -1 for a whole element of the root
+	xmlDoc *doc;
+};
+
+struct oval_parse_plan {
+	const char *memory;
+	size_t size;
+	size_t root_start;	///< start tag of the root element
+	size_t root_end;
+	size_t root_name_len;
+	struct oval_parse_section *sections;
+	int section_cnt;
+	struct oval_parse_chunk *chunks;
+	size_t chunk_cnt;
+	size_t batch;		///< first chunk parsed by the threads
+};
+
+static size_t _oval_scan_find(const char *mem, size_t size, size_t pos, const char *str)
+{
+	size_t len = strlen(str);
+
+	while (pos + len <= size) {
+		const char *c = memchr(mem + pos, str[0], size - pos - len + 1);
+		if (c == NULL)
+			return 0;
+		pos = c - mem;
+		if (memcmp(c, str, len) == 0)
+			return pos + len;
+		pos++;
+	}
+	return 0;
+}
+
+static bool _oval_scan_starts(const char *mem, size_t size, size_t pos, const char *str)
+{
+	size_t len = strlen(str);
+	return pos + len <= size && memcmp(mem + pos, str, len) == 0;
+}
+
+static size_t _oval_scan_name_len(const char *mem, size_t size, size_t pos)
+{
+	size_t end = pos;
+	while (end < size && !strchr(" \t\r\n/>", mem[end]))
+		end++;
+	return end - pos;
+}
+
+/*
+ * Find the end of the markup at pos, which starts with '<'.
+ * Returns the offset after the markup or 0 if it isn't terminated or
+ * can't be split around (DOCTYPE).
+ */
+static size_t _oval_scan_markup(const char *mem, size_t size, size_t pos, enum oval_markup *kind)
+{
+	*kind = OVAL_MARKUP_OTHER;
+	if (_oval_scan_starts(mem, size, pos, "<!--"))
+		return _oval_scan_find(mem, size, pos + 4, "-->");
+	if (_oval_scan_starts(mem, size, pos, "<![CDATA["))
+		return _oval_scan_find(mem, size, pos + 9, "]]>");
+	if (_oval_scan_starts(mem, size, pos, "<?"))
+		return _oval_scan_find(mem, size, pos + 2, "?>");
+	if (_oval_scan_starts(mem, size, pos, "<!"))
+		return 0;
+
+	*kind = _oval_scan_starts(mem, size, pos, "</") ? OVAL_MARKUP_END : OVAL_MARKUP_START;
+	for (size_t i = pos + 1; i < size; i++) {
+		if (mem[i] == '"' || mem[i] == '\'') {
+			const char *quote = memchr(mem + i + 1, mem[i], size - i - 1);
+			if (quote == NULL)
+				return 0;
+			i = quote - mem;
+		} else if (mem[i] == '>') {
+			if (*kind == OVAL_MARKUP_START && mem[i - 1] == '/')
+				*kind = OVAL_MARKUP_EMPTY;
+			return i + 1;
+		}
+	}
+	return 0;
+}
+
+/* the sections whose elements may be split between chunks */
+static bool _oval_scan_is_section(const char *name, size_t len)
+{
+	static const char *sections[] = { "definitions", "tests", "objects", "states", "variables", NULL };
+	const char *colon = memchr(name, ':', len);
+
+	if (colon != NULL) {
+		len -= colon + 1 - name;
+		name = colon + 1;
+	}
+	for (int i = 0; sections[i] != NULL; i++) {
+		if (strlen(sections[i]) == len && memcmp(sections[i], name, len) == 0)
+			return true;
+	}
+	return false;
+}
+
+static void _oval_parse_plan_add_chunk(struct oval_parse_plan *plan, size_t start, size_t end, int section)
+{
+	if (plan->chunk_cnt % 64 == 0)
+		plan->chunks = realloc(plan->chunks, (plan->chunk_cnt + 64) * sizeof(struct oval_parse_chunk));
+	struct oval_parse_chunk *chunk = &plan->chunks[plan->chunk_cnt++];
+	chunk->start = start;
+	chunk->end = end;
+	chunk->section = section;
+	chunk->doc = NULL;
+}
+
+static bool _oval_scan_end_matches(const struct oval_parse_plan *plan, size_t pos, size_t start, size_t name_len)
+{
+	return _oval_scan_name_len(plan->memory, plan->size, pos + 2) == name_len &&
+		memcmp(plan->memory + pos + 2, plan->memory + start + 1, name_len) == 0;
+}
+
+/*
+ * Split the document into chunks. Anything the scan doesn't understand
+ * (DOCTYPE, other encodings, broken markup at the top levels) makes the
+ * document parsed sequentially. Broken markup inside of the chunks is
+ * found by the parser of the chunk.
+ */
+static int _oval_parse_plan_build(struct oval_parse_plan *plan, size_t chunk_size)
+{
+	const char *mem = plan->memory;
+	size_t size = plan->size;
+	size_t pos = 0, end, elem_start = 0, chunk_start = 0;
+	enum oval_markup kind;
+	int depth, section = -1;
+
+	if (_oval_scan_starts(mem, size, pos, "\xEF\xBB\xBF"))
+		pos += 3;
+	for (;;) {
+		while (pos < size && strchr(" \t\r\n", mem[pos]) && mem[pos] != '\0')
+			pos++;
+		if (pos >= size || mem[pos] != '<')
+			return -1;
+		end = _oval_scan_markup(mem, size, pos, &kind);
+		if (end == 0)
+			return -1;
+		if (kind != OVAL_MARKUP_OTHER)
+			break;
+		pos = end;
+	}
+	if (kind != OVAL_MARKUP_START)
+		return -1;
+	plan->root_name_len = _oval_scan_name_len(mem, size, pos + 1);
+	plan->root_start = pos;
+	plan->root_end = end;
+
+	depth = 1;
+	pos = end;
+	while (depth > 0) {
+		if (pos >= size)
+			return -1;
+		if (mem[pos] != '<') {
+			const char *next = memchr(mem + pos, '<', size - pos);
+			if (next == NULL)
+				return -1;
+			/* text of the root is ignored by the parser, unless it is broken */
+			if (depth == 1) {
+				for (size_t i = pos; mem + i < next; i++) {
+					if (!strchr(" \t\r\n", mem[i]) || mem[i] == '\0')
+						return -1;
+				}
+			}
+			pos = next - mem;
+			continue;
+		}
+		end = _oval_scan_markup(mem, size, pos, &kind);
+		if (end == 0)
+			return -1;
+
+		switch (kind) {
+		case OVAL_MARKUP_START:
+		case OVAL_MARKUP_EMPTY:
+			if (depth == 1) {
+				size_t name_len = _oval_scan_name_len(mem, size, pos + 1);
+				if (kind == OVAL_MARKUP_EMPTY) {
+					_oval_parse_plan_add_chunk(plan, pos, end, -1);
+				} else if (_oval_scan_is_section(mem + pos + 1, name_len)) {
+					if (plan->section_cnt % 8 == 0)
+						plan->sections = realloc(plan->sections, (plan->section_cnt + 8) * sizeof(struct oval_parse_section));
+					plan->sections[plan->section_cnt].start = pos;
+					plan->sections[plan->section_cnt].end = end;
+					plan->sections[plan->section_cnt].name_len = name_len;
+					section = plan->section_cnt++;
+					chunk_start = end;
+				} else {
+					section = -1;
+				}
+				elem_start = pos;
+			} else if (depth == 2 && section != -1 && pos - chunk_start >= chunk_size) {
+				_oval_parse_plan_add_chunk(plan, chunk_start, pos, section);
+				chunk_start = pos;
+			}
+			if (kind == OVAL_MARKUP_START)
+				depth++;
+			break;
+		case OVAL_MARKUP_END:
+			depth--;
+			if (depth == 0) {
+				if (!_oval_scan_end_matches(plan, pos, plan->root_start, plan->root_name_len))
+					return -1;
+			} else if (depth == 1) {
+				size_t name_len = _oval_scan_name_len(mem, size, elem_start + 1);
+				if (!_oval_scan_end_matches(plan, pos, elem_start, name_len))
+					return -1;
+				if (section != -1)
+					_oval_parse_plan_add_chunk(plan, chunk_start, pos, section);
+				else
+					_oval_parse_plan_add_chunk(plan, elem_start, end, -1);
+				section = -1;
+				elem_start = 0;
+			}
+			break;
+		default:
+			break;
+		}
+		pos = end;
+	}
+
+	/* only comments and processing instructions may follow the root */
+	while (pos < size) {
+		if (strchr(" \t\r\n", mem[pos]) && mem[pos] != '\0') {
+			pos++;
+			continue;
+		}
+		if (mem[pos] != '<' || (end = _oval_scan_markup(mem, size, pos, &kind)) == 0 || kind != OVAL_MARKUP_OTHER)
+			return -1;
+		pos = end;
+	}
+	return 0;
+}
+
+static void _oval_parse_chunk(void *arg, size_t index)
+{
+	struct oval_parse_plan *plan = arg;
+	struct oval_parse_chunk *chunk = &plan->chunks[plan->batch + index];
+	const char *mem = plan->memory;
+	char *end_tag;
+
+	xmlParserCtxtPtr ctxt = xmlCreatePushParserCtxt(NULL, NULL, NULL, 0, NULL);
+	if (ctxt == NULL)
+		return;
+	/* errors are reported by the sequential parsing which follows */
+	xmlCtxtUseOptions(ctxt, XML_PARSE_NOERROR | XML_PARSE_NOWARNING);
+
+	/* the chunk keeps the namespaces declared by the root and the section */
+	xmlParseChunk(ctxt, mem, plan->root_end, 0);
+	if (chunk->section != -1) {
+		const struct oval_parse_section *section = &plan->sections[chunk->section];
+		xmlParseChunk(ctxt, mem + section->start, section->end - section->start, 0);
+		xmlParseChunk(ctxt, mem + chunk->start, chunk->end - chunk->start, 0);
+		end_tag = oscap_sprintf("</%.*s>", (int) section->name_len, mem + section->start + 1);
+		xmlParseChunk(ctxt, end_tag, strlen(end_tag), 0);
+		free(end_tag);
+	} else {
+		xmlParseChunk(ctxt, mem + chunk->start, chunk->end - chunk->start, 0);
+	}
+	end_tag = oscap_sprintf("</%.*s>", (int) plan->root_name_len, mem + plan->root_start + 1);
+	xmlParseChunk(ctxt, end_tag, strlen(end_tag), 1);
+	free(end_tag);
+
+	if (ctxt->wellFormed)
+		chunk->doc = ctxt->myDoc;
+	else
+		xmlFreeDoc(ctxt->myDoc);
+	xmlFreeParserCtxt(ctxt);
+}
+
+int oval_definition_model_parse_parallel(struct oscap_source *source, struct oval_parser_context *context)
+{
+	struct oval_parse_plan plan;
+	int ret = 0;
+
+	memset(&plan, 0, sizeof(plan));
+	if (oscap_source_get_memory(source, &plan.memory, &plan.size) != 0 || plan.size < OVAL_PARSE_PARALLEL_MIN)
+		return -2;
+	size_t jobs = oscap_threadpool_jobs("OSCAP_OVAL_PARSE_JOBS", 0, OVAL_PARSE_MAX_JOBS);
+	if (jobs < 2)
+		return -2;
+
+	size_t chunk_size = plan.size / (jobs * 16);
+	if (chunk_size < OVAL_PARSE_CHUNK_MIN)
+		chunk_size = OVAL_PARSE_CHUNK_MIN;
+	if (_oval_parse_plan_build(&plan, chunk_size) != 0 || plan.chunk_cnt < 2) {
+		ret = -2;
+		goto cleanup;
+	}
+	dI("Parsing %s in %zu chunks by %zu threads.", oscap_source_readable_origin(source), plan.chunk_cnt, jobs);
+
+	/* the threads parse a batch of chunks at once, so that only a part of the document is held in DOMs */
+	for (plan.batch = 0; plan.batch < plan.chunk_cnt && ret != -2; plan.batch += jobs) {
+		size_t count = plan.chunk_cnt - plan.batch < jobs ? plan.chunk_cnt - plan.batch : jobs;
+		oscap_threadpool_run(jobs, count, _oval_parse_chunk, &plan, NULL);
+
+		for (size_t i = 0; i < count; i++) {
+			struct oval_parse_chunk *chunk = &plan.chunks[plan.batch + i];
+			if (chunk->doc == NULL || ret == -2) {
+				ret = -2;
+				continue;
+			}
+			context->reader = xmlReaderWalker(chunk->doc);
+			if (context->reader == NULL) {
+				ret = -2;
+				continue;
+			}
+			/* jump into the root element */
+			while (xmlTextReaderRead(context->reader) == 1
+				&& xmlTextReaderNodeType(context->reader) != XML_READER_TYPE_ELEMENT) ;
+			if (oval_definition_model_parse(context->reader, context) == -1)
+				ret = -2;
+			xmlFreeTextReader(context->reader);
+			context->reader = NULL;
+			xmlFreeDoc(chunk->doc);
+			chunk->doc = NULL;
+		}
+	}
+
+cleanup:
+	for (size_t i = 0; i < plan.chunk_cnt; i++)
+		xmlFreeDoc(plan.chunks[i].doc);
+	free(plan.chunks);
+	free(plan.sections);
+	return ret;
+}
+
 /* -1 error; 0 OK */
 int oval_parser_skip_tag(xmlTextReaderPtr reader, struct oval_parser_context *context)
 {
@@ -49,9 +49,16 @@ struct oval_parser_context {
 	struct oval_directives_model *directives_model;
 	xmlTextReader *reader;
 	void *user_data;
+	struct oval_string_map *id_filter;	///< parse only the definitions, tests, ... with these IDs (NULL - all)
 };
 
 int oval_definition_model_parse(xmlTextReaderPtr, struct oval_parser_context *);
+/**
+ * Parse a large document mapped in memory by several threads, see OSCAP_OVAL_PARSE_JOBS.
+ * @returns -1 error; 0 OK; 1 warning; -2 the document wasn't parsed in parallel and the
+ * model has to be parsed again sequentially, it may contain a part of the document
+ */
+int oval_definition_model_parse_parallel(struct oscap_source *source, struct oval_parser_context *context);
 int oval_syschar_model_parse(xmlTextReaderPtr, struct oval_parser_context *);
 int oval_results_model_parse(xmlTextReaderPtr , struct oval_parser_context *);
 
@@ -29,9 +29,7 @@
 #include <string.h>
 #include <limits.h>
 #include <errno.h>
-#if defined(OSCAP_THREAD_SAFE)
-# include <pthread.h>
-#endif
+#include <pthread.h>
 
 #include "oscap_helpers.h"
 #include "oval_probe.h"
@@ -43,11 +41,12 @@
 #include "common/util.h"
 #include "common/bfind.h"
 #include "common/debug_priv.h"
+#include "common/profiling_priv.h"
 
 #include "_oval_probe_session.h"
 #include "_oval_probe_handler.h"
 #include "oval_probe_ext.h"
-#include "collectVarRefs_impl.h"
+#include "oval_deadline.h"
 
 #ifdef OS_WINDOWS
 #define X_OK 0
@@ -64,6 +63,21 @@ struct id_desc_t OSCAP_GSYM(id_desc);
 
 #define __ERRBUF_SIZE 128
 
+/*
+ * System information of the scanned system. It is the same for all the
+ * agent sessions of a scan, so it is collected by the first one and the
+ * others get a copy. Dropped with the other scan caches.
+ */
+static pthread_mutex_t sysinfo_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct oval_sysinfo *sysinfo_cache = NULL;
+
+/*
+ * Time each object took in a previous scan, read from the profiling output
+ * given by OSCAP_PROBE_TIMINGS. Used to start the longest objects first.
+ */
+static pthread_once_t timings_once = PTHREAD_ONCE_INIT;
+static struct oscap_htable *timings = NULL;
+
 static void _syschar_add_bindings(struct oval_syschar *sc, struct oval_string_map *vm)
 {
 	struct oval_iterator *var_itr;
@@ -94,6 +108,39 @@ static void _syschar_add_bindings(struct oval_syschar *sc, struct oval_string_ma
 	oval_collection_iterator_free(var_itr);
 }
 
+static void _oval_probe_timings_free(void)
+{
+	oscap_htable_free(timings, free);
+	timings = NULL;
+}
+
+static void _oval_probe_timings_load(void)
+{
+	const char *path = getenv("OSCAP_PROBE_TIMINGS");
+	bool had_err = oscap_err();
+
+	if (path == NULL || *path == '\0')
+		return;
+
+	timings = oscap_profiling_import_times(path, OSCAP_PROFILING_OBJECT);
+	if (timings == NULL) {
+		dW("Can't read the object times from '%s', the objects are collected in their order.", path);
+		if (!had_err)
+			oscap_clearerr();
+		return;
+	}
+	atexit(_oval_probe_timings_free);
+}
+
+static void _oval_probe_set_incomplete(struct oval_syschar *sysc)
+{
+	char *msg = oscap_sprintf("Object was not collected because %s.", oval_deadline_reason());
+
+	oval_syschar_add_new_message(sysc, msg, OVAL_MESSAGE_LEVEL_WARNING);
+	free(msg);
+	oval_syschar_set_flag(sysc, SYSCHAR_FLAG_INCOMPLETE);
+}
+
 int oval_probe_query_object(oval_probe_session_t *psess, struct oval_object *object, int flags, struct oval_syschar **out_syschar)
 {
 	char *oid;
@@ -101,7 +148,6 @@ int oval_probe_query_object(oval_probe_session_t *psess, struct oval_object *obj
         oval_subtype_t type;
 	const char *type_name;
         oval_ph_t *ph;
-	struct oval_string_map *vm;
 	struct oval_syschar_model *model;
 	int ret;
 
@@ -153,16 +199,18 @@ int oval_probe_query_object(oval_probe_session_t *psess, struct oval_object *obj
 		return 1;
 	}
 
+	if (oval_deadline_passed()) {
+		dI("Not collecting %s_object '%s', %s.", type_name, oid, oval_deadline_reason());
+		_oval_probe_set_incomplete(sysc);
+		return 0;
+	}
+
 	if ((ret = oval_probe_ext_handler(type, ph->uptr, PROBE_HANDLER_ACT_EVAL, sysc, flags)) != 0) {
 		return ret;
 	}
 
-	if (!(flags & OVAL_PDFLAG_NOREPLY)) {
-		vm = oval_string_map_new();
-		oval_obj_collect_var_refs(object, vm);
-		_syschar_add_bindings(sysc, vm);
-		oval_string_map_free(vm, NULL);
-	}
+	if (!(flags & OVAL_PDFLAG_NOREPLY))
+		_syschar_add_bindings(sysc, oval_probe_session_object_varrefs(psess, object));
 
 	return 0;
 }
@@ -187,16 +235,42 @@ int oval_probe_query_sysinfo(oval_probe_session_t *sess, struct oval_sysinfo **o
 		return(-1);
         }
 
+	pthread_mutex_lock(&sysinfo_lock);
+	if (sysinfo_cache != NULL) {
+		*out_sysinfo = oval_sysinfo_clone(sess->sys_model, sysinfo_cache);
+		pthread_mutex_unlock(&sysinfo_lock);
+		dI("Using the system information collected by a previous session.");
+		return(0);
+	}
+	pthread_mutex_unlock(&sysinfo_lock);
+
         sysinf = NULL;
 
 	ret = oval_probe_sys_handler(OVAL_INDEPENDENT_SYSCHAR_SUBTYPE, ph->uptr, PROBE_HANDLER_ACT_EVAL, NULL, &sysinf, 0);
 	if (ret != 0)
 		return(ret);
 
+	pthread_mutex_lock(&sysinfo_lock);
+	if (sysinfo_cache == NULL)
+		sysinfo_cache = oval_sysinfo_clone(NULL, sysinf);
+	pthread_mutex_unlock(&sysinfo_lock);
+
 	*out_sysinfo = sysinf;
 	return(0);
 }
 
+void oval_probe_sysinfo_reset(void)
+{
+	struct oval_sysinfo *sysinf;
+
+	pthread_mutex_lock(&sysinfo_lock);
+	sysinf = sysinfo_cache;
+	sysinfo_cache = NULL;
+	pthread_mutex_unlock(&sysinfo_lock);
+
+	oval_sysinfo_free(sysinf);
+}
+
 static int oval_probe_query_var_ref(oval_probe_session_t *sess, struct oval_state *state)
 {
 	struct oval_state_content_iterator *contents = oval_state_get_contents(state);
@@ -272,3 +346,411 @@ int oval_probe_query_test(oval_probe_session_t *sess, struct oval_test *test)
 	return 0;
 }
 
+
+static void _oval_probe_recv_object(oval_probe_session_t *psess, struct oval_syschar *sysc, bool had_err)
+{
+	struct oval_object *object;
+	oval_subtype_t type;
+	oval_ph_t *ph;
+	int ret;
+
+	object = oval_syschar_get_object(sysc);
+	type = oval_object_get_subtype(object);
+	ph = oval_probe_handler_get(psess->ph, type);
+
+	ret = oval_probe_ext_handler(type, ph->uptr, PROBE_HANDLER_ACT_RECV, sysc);
+	switch (ret) {
+	case 0:
+		_syschar_add_bindings(sysc, oval_probe_session_object_varrefs(psess, object));
+		break;
+	case 1:
+		/* the reply was already received by oval_probe_query_object */
+		break;
+	default:
+		/*
+		 * The object stays uncollected and oval_probe_query_object
+		 * will try again (and report the error) during evaluation.
+		 */
+		dW("Can't collect %s_object '%s'.", oval_subtype_get_text(type), oval_object_get_id(object));
+		if (!had_err)
+			oscap_clearerr();
+	}
+}
+
+static struct oscap_list *_oval_probe_schedule(oval_probe_session_t *psess, struct oscap_list *objects);
+
+int oval_probe_query_objects(oval_probe_session_t *psess, struct oscap_list *objects)
+{
+	struct oval_syschar *pending[OVAL_PROBE_MAXPENDING];
+	struct oscap_list *scheduled;
+	struct oscap_iterator *it;
+	size_t head, count;
+	bool had_err;
+	int ret;
+
+	head = count = 0;
+	had_err = oscap_err();
+
+	pthread_once(&timings_once, _oval_probe_timings_load);
+	oval_deadline_start();
+
+	scheduled = _oval_probe_schedule(psess, objects);
+	it = oscap_iterator_new(scheduled != NULL ? scheduled : objects);
+	while (oscap_iterator_has_more(it)) {
+		struct oval_object *object = oscap_iterator_next(it);
+		const char *oid = oval_object_get_id(object);
+		oval_subtype_t type = oval_object_get_subtype(object);
+		struct oval_syschar *sysc;
+		oval_ph_t *ph;
+
+		if (oval_syschar_model_get_syschar(psess->sys_model, oid) != NULL)
+			continue;
+		ph = oval_probe_handler_get(psess->ph, type);
+		if (ph == NULL)
+			continue;
+
+		if (count == OVAL_PROBE_MAXPENDING) {
+			_oval_probe_recv_object(psess, pending[head], had_err);
+			head = (head + 1) % OVAL_PROBE_MAXPENDING;
+			--count;
+		}
+
+		sysc = oval_syschar_new(psess->sys_model, object);
+		if (oval_deadline_passed()) {
+			dI("Not sending %s object '%s', %s.", oval_subtype_get_text(type), oid, oval_deadline_reason());
+			_oval_probe_set_incomplete(sysc);
+			continue;
+		}
+
+		dI("Sending %s object '%s' to the probe.", oval_subtype_get_text(type), oid);
+
+		ret = oval_probe_ext_handler(type, ph->uptr, PROBE_HANDLER_ACT_SEND, sysc, 0);
+		switch (ret) {
+		case 0:
+			pending[(head + count) % OVAL_PROBE_MAXPENDING] = sysc;
+			++count;
+			break;
+		case 1:
+			/* collected without asking the probe */
+			_syschar_add_bindings(sysc, oval_probe_session_object_varrefs(psess, object));
+			break;
+		case 2:
+			/* not supported, the syschar is flagged accordingly */
+			break;
+		default:
+			dW("Can't send %s_object '%s' to the probe.", oval_subtype_get_text(type), oid);
+			if (!had_err)
+				oscap_clearerr();
+		}
+	}
+	oscap_iterator_free(it);
+	oscap_list_free(scheduled, NULL);
+
+	while (count > 0) {
+		_oval_probe_recv_object(psess, pending[head], had_err);
+		head = (head + 1) % OVAL_PROBE_MAXPENDING;
+		--count;
+	}
+
+	return 0;
+}
+
+static void _oval_probe_definition_objects(oval_probe_session_t *psess, struct oval_definition *definition, struct oscap_list *objects, struct oval_string_map *visited);
+
+static void _oval_probe_component_objects(struct oval_component *comp, struct oscap_list *objects)
+{
+	struct oval_component_iterator *cmp_itr;
+
+	switch (oval_component_get_type(comp)) {
+	case OVAL_COMPONENT_OBJECTREF:{
+		struct oval_object *object = oval_component_get_object(comp);
+		if (object != NULL)
+			oscap_list_add(objects, object);
+		break;
+	}
+	case OVAL_COMPONENT_LITERAL:
+	case OVAL_COMPONENT_VARREF:
+		/* the referenced variables are already in the map */
+		break;
+	default:
+		cmp_itr = oval_component_get_function_components(comp);
+		while (oval_component_iterator_has_more(cmp_itr))
+			_oval_probe_component_objects(oval_component_iterator_next(cmp_itr), objects);
+		oval_component_iterator_free(cmp_itr);
+		break;
+	}
+}
+
+struct oval_probe_job {
+	struct oval_object *object;
+	double priority; /* expected time of the object or of an object waiting for it */
+	size_t index;    /* position in the original order */
+};
+
+static int _oval_probe_job_cmp(const void *a, const void *b)
+{
+	const struct oval_probe_job *ja = a, *jb = b;
+
+	if (ja->priority != jb->priority)
+		return ja->priority < jb->priority ? 1 : -1;
+
+	return ja->index < jb->index ? -1 : ja->index > jb->index;
+}
+
+/* objects referenced by object_components of the variables in the map */
+static void _oval_probe_varrefs_objects(struct oval_string_map *vm, struct oscap_list *objects)
+{
+	struct oval_iterator *var_itr;
+
+	var_itr = oval_string_map_values(vm);
+	while (oval_collection_iterator_has_more(var_itr)) {
+		struct oval_variable *var = oval_collection_iterator_next(var_itr);
+		struct oval_component *comp;
+
+		if (oval_variable_get_type(var) == OVAL_VARIABLE_LOCAL &&
+		    (comp = oval_variable_get_component(var)) != NULL)
+			_oval_probe_component_objects(comp, objects);
+	}
+	oval_collection_iterator_free(var_itr);
+}
+
+/* objects whose items are needed to query the object */
+static void _oval_probe_object_deps(oval_probe_session_t *psess, struct oval_object *object, struct oscap_list *deps)
+{
+	_oval_probe_varrefs_objects(oval_probe_session_object_varrefs(psess, object), deps);
+}
+
+/*
+ * Order the objects longest first by the times of the previous scan, so
+ * that a long object doesn't start last and hold up the end of the scan.
+ * Objects missing in the previous scan are expected to take the average
+ * time. An object needed by another one inherits its priority, so it still
+ * precedes it. Equal priorities keep the original order.
+ * @return the ordered objects or NULL if there are no times to order by
+ */
+static struct oscap_list *_oval_probe_schedule(oval_probe_session_t *psess, struct oscap_list *objects)
+{
+	struct oval_string_map *jobmap;
+	struct oval_probe_job *jobs;
+	struct oscap_iterator *it;
+	struct oscap_list *scheduled;
+	size_t njobs = 0, nknown = 0, i;
+	double total = 0, average;
+
+	if (timings == NULL)
+		return NULL;
+
+	jobs = malloc(oscap_list_get_itemcount(objects) * sizeof(struct oval_probe_job));
+	if (jobs == NULL)
+		return NULL;
+	jobmap = oval_string_map_new();
+
+	/* an object listed more than once is scheduled with its first occurrence */
+	it = oscap_iterator_new(objects);
+	while (oscap_iterator_has_more(it)) {
+		struct oval_object *object = oscap_iterator_next(it);
+		const char *oid = oval_object_get_id(object);
+		double *seconds;
+
+		if (oval_string_map_get_value(jobmap, oid) != NULL)
+			continue;
+
+		jobs[njobs].object = object;
+		jobs[njobs].index = njobs;
+		jobs[njobs].priority = -1;
+		seconds = oscap_htable_get(timings, oid);
+		if (seconds != NULL) {
+			jobs[njobs].priority = *seconds;
+			total += *seconds;
+			++nknown;
+		}
+		oval_string_map_put(jobmap, oid, &jobs[njobs]);
+		++njobs;
+	}
+	oscap_iterator_free(it);
+
+	average = nknown > 0 ? total / nknown : 0;
+	for (i = 0; i < njobs; ++i) {
+		if (jobs[i].priority < 0)
+			jobs[i].priority = average;
+	}
+
+	/* the objects needed by another one come before it in the list */
+	for (i = njobs; i-- > 0;) {
+		struct oscap_list *deps = oscap_list_new();
+
+		_oval_probe_object_deps(psess, jobs[i].object, deps);
+		it = oscap_iterator_new(deps);
+		while (oscap_iterator_has_more(it)) {
+			struct oval_object *dep = oscap_iterator_next(it);
+			struct oval_probe_job *job = oval_string_map_get_value(jobmap, oval_object_get_id(dep));
+
+			if (job != NULL && job->priority < jobs[i].priority)
+				job->priority = jobs[i].priority;
+		}
+		oscap_iterator_free(it);
+		oscap_list_free(deps, NULL);
+	}
+	oval_string_map_free(jobmap, NULL);
+
+	qsort(jobs, njobs, sizeof(struct oval_probe_job), _oval_probe_job_cmp);
+
+	scheduled = oscap_list_new();
+	for (i = 0; i < njobs; ++i)
+		oscap_list_add(scheduled, jobs[i].object);
+	free(jobs);
+
+	dD("Scheduled %zu objects by the times of the previous scan.", njobs);
+
+	return scheduled;
+}
+
+/*
+ * The objects referenced by object_components of the variables used by the test
+ * (transitively) are queried before the object of the test which depends on them.
+ */
+static void _oval_probe_test_objects(oval_probe_session_t *psess, struct oval_test *test, struct oval_object *object, struct oscap_list *objects)
+{
+	struct oval_state_iterator *ste_itr;
+
+	/* an object listed twice is queried once */
+	_oval_probe_varrefs_objects(oval_probe_session_object_varrefs(psess, object), objects);
+	ste_itr = oval_test_get_states(test);
+	while (oval_state_iterator_has_more(ste_itr))
+		_oval_probe_varrefs_objects(oval_probe_session_state_varrefs(psess, oval_state_iterator_next(ste_itr)), objects);
+	oval_state_iterator_free(ste_itr);
+
+	oscap_list_add(objects, object);
+}
+
+static void _oval_probe_criteria_objects(oval_probe_session_t *psess, struct oval_criteria_node *cnode, struct oscap_list *objects, struct oval_string_map *visited)
+{
+	switch (oval_criteria_node_get_type(cnode)) {
+	case OVAL_NODETYPE_CRITERION:{
+		struct oval_test *test = oval_criteria_node_get_test(cnode);
+		if (test == NULL)
+			return;
+		struct oval_object *object = oval_test_get_object(test);
+		if (object == NULL || oval_test_get_subtype(test) != oval_object_get_subtype(object))
+			return;
+		_oval_probe_test_objects(psess, test, object, objects);
+		break;
+	}
+	case OVAL_NODETYPE_CRITERIA:{
+		struct oval_criteria_node_iterator *cnode_it = oval_criteria_node_get_subnodes(cnode);
+		if (cnode_it == NULL)
+			return;
+		while (oval_criteria_node_iterator_has_more(cnode_it)) {
+			struct oval_criteria_node *node = oval_criteria_node_iterator_next(cnode_it);
+			_oval_probe_criteria_objects(psess, node, objects, visited);
+		}
+		oval_criteria_node_iterator_free(cnode_it);
+		break;
+	}
+	case OVAL_NODETYPE_EXTENDDEF:{
+		struct oval_definition *definition = oval_criteria_node_get_definition(cnode);
+		if (definition != NULL)
+			_oval_probe_definition_objects(psess, definition, objects, visited);
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+static void _oval_probe_definition_objects(oval_probe_session_t *psess, struct oval_definition *definition, struct oscap_list *objects, struct oval_string_map *visited)
+{
+	struct oval_criteria_node *cnode;
+	const char *id = oval_definition_get_id(definition);
+
+	if (oval_string_map_get_value(visited, id) != NULL)
+		return;
+	oval_string_map_put(visited, id, definition);
+
+	cnode = oval_definition_get_criteria(definition);
+	if (cnode != NULL)
+		_oval_probe_criteria_objects(psess, cnode, objects, visited);
+}
+
+int oval_probe_query_definition(oval_probe_session_t *psess, struct oval_definition *definition)
+{
+	struct oscap_list *objects = oscap_list_new();
+	struct oval_string_map *visited = oval_string_map_new();
+	int ret;
+
+	_oval_probe_definition_objects(psess, definition, objects, visited);
+	ret = oval_probe_query_objects(psess, objects);
+
+	oval_string_map_free(visited, NULL);
+	oscap_list_free(objects, NULL);
+
+	return ret;
+}
+
+int oval_probe_query_definitions(oval_probe_session_t *psess, struct oval_definition_model *model)
+{
+	return oval_probe_query_definition_list(psess, model, NULL, false);
+}
+
+static bool _oval_probe_object_uses_external(oval_probe_session_t *psess, struct oval_object *object)
+{
+	struct oval_iterator *var_itr;
+	bool ret = false;
+
+	var_itr = oval_string_map_values(oval_probe_session_object_varrefs(psess, object));
+	while (!ret && oval_collection_iterator_has_more(var_itr)) {
+		struct oval_variable *var = oval_collection_iterator_next(var_itr);
+		ret = oval_variable_get_type(var) == OVAL_VARIABLE_EXTERNAL;
+	}
+	oval_collection_iterator_free(var_itr);
+
+	return ret;
+}
+
+int oval_probe_query_definition_list(oval_probe_session_t *psess, struct oval_definition_model *model, struct oscap_stringlist *ids, bool skip_external)
+{
+	struct oscap_list *objects = oscap_list_new();
+	struct oval_string_map *visited = oval_string_map_new();
+	int ret;
+
+	if (ids == NULL) {
+		struct oval_definition_iterator *def_it = oval_definition_model_get_definitions(model);
+		while (oval_definition_iterator_has_more(def_it)) {
+			struct oval_definition *definition = oval_definition_iterator_next(def_it);
+			_oval_probe_definition_objects(psess, definition, objects, visited);
+		}
+		oval_definition_iterator_free(def_it);
+	} else {
+		struct oscap_string_iterator *id_it = oscap_stringlist_get_strings(ids);
+		while (oscap_string_iterator_has_more(id_it)) {
+			const char *id = oscap_string_iterator_next(id_it);
+			struct oval_definition *definition = oval_definition_model_get_definition(model, id);
+			if (definition == NULL) {
+				dW("No definition with ID: %s in definition model.", id);
+				continue;
+			}
+			_oval_probe_definition_objects(psess, definition, objects, visited);
+		}
+		oscap_string_iterator_free(id_it);
+	}
+
+	if (skip_external) {
+		struct oscap_list *bound = oscap_list_new();
+		struct oscap_iterator *obj_it = oscap_iterator_new(objects);
+		while (oscap_iterator_has_more(obj_it)) {
+			struct oval_object *object = oscap_iterator_next(obj_it);
+			if (!_oval_probe_object_uses_external(psess, object))
+				oscap_list_add(bound, object);
+		}
+		oscap_iterator_free(obj_it);
+		oscap_list_free(objects, NULL);
+		objects = bound;
+	}
+
+	ret = oval_probe_query_objects(psess, objects);
+
+	oval_string_map_free(visited, NULL);
+	oscap_list_free(objects, NULL);
+
+	return ret;
+}
@@ -45,8 +45,13 @@
 #include "probes/public/probe-api.h"
 #include "oval_probe_ext.h"
 #include "oval_sexp.h"
+#include "oval_system_characteristics_impl.h"
+#include "adt/oval_string_map_impl.h"
+#include "oval_object_cache_impl.h"
+#include "_oval_probe_session.h"
 #include "probe-table.h"
 #include "_oval_probe_handler.h"
+#include "oval_deadline.h"
 
 #define __ERRBUF_SIZE 128
 
@@ -55,6 +60,36 @@ static void          oval_pdtbl_free(oval_pdtbl_t *table);
 static int           oval_pdtbl_add(oval_pdtbl_t *table, oval_subtype_t type, int sd, const char *uri);
 static oval_pd_t    *oval_pdtbl_get(oval_pdtbl_t *table, oval_subtype_t type);
 
+/*
+ * Request sent to a probe and waiting for the reply
+ */
+typedef struct {
+	oval_pd_t  *pd;
+	SEAP_msg_t *msg;
+	sch_queue_call_t *call; /* direct call, used instead of msg */
+	SEXP_t     *s_canon; /* object cache key, NULL if not cached */
+	uint64_t    fingerprint;
+	int         flags;
+} oval_preq_t;
+
+static void oval_preq_free(oval_preq_t *req)
+{
+	if (req->call != NULL) {
+		SEXP_t *s_sys = NULL;
+
+		sch_queue_call_wait(req->call, &s_sys);
+		SEXP_free(s_sys);
+	}
+	SEAP_msg_free(req->msg);
+	SEXP_free(req->s_canon);
+	free(req);
+}
+
+static void oval_preq_free_cb(struct rbt_i64_node *n)
+{
+	oval_preq_free(n->data);
+}
+
 /*
  * oval_pext_
  */
@@ -65,10 +100,14 @@ oval_pext_t *oval_pext_new(void)
         pext->do_init = true;
         pthread_mutex_init(&pext->lock, NULL);
         pext->pdtbl     = NULL;
+        pext->pending   = rbt_i64_new();
+        pext->rpm_inventory = NULL;
 
         return(pext);
 }
 
+static void oval_pkg_inventory_free(struct oval_pkg_inventory *inv);
+
 void oval_pext_free(oval_pext_t *pext)
 {
         if (!pext->do_init) {
@@ -76,6 +115,8 @@ void oval_pext_free(oval_pext_t *pext)
                 oval_pdtbl_free(pext->pdtbl);
         }
 
+        rbt_i64_free_cb(pext->pending, oval_preq_free_cb);
+        oval_pkg_inventory_free(pext->rpm_inventory);
         pthread_mutex_destroy(&pext->lock);
         free(pext);
 }
@@ -284,7 +325,7 @@ static SEXP_t *oval_probe_cmd_ste_fetch(SEXP_t *sexp, void *arg)
 				return (NULL);
 			}
 
-			ret = oval_state_to_sexp(pext->sess_ptr, ste, &ste_sexp);
+			ret = oval_probe_session_state_sexp(pext->sess_ptr, ste, &ste_sexp);
 			if (ret !=0) {
 				dE("Failed to convert OVAL state to SEXP, id: %s.",
 					       id_str);
@@ -421,12 +462,11 @@ static inline int _handle_SEAP_receive_failure(SEAP_CTX_t *ctx, oval_pd_t *pd, S
 	return (-1);
 }
 
-static int oval_probe_comm(SEAP_CTX_t *ctx, oval_pd_t *pd, const SEXP_t *s_iobj, int flags, SEXP_t **out_sexp)
+static int oval_probe_comm_send(SEAP_CTX_t *ctx, oval_pd_t *pd, const SEXP_t *s_iobj, SEXP_t *s_prefetch, int flags, SEAP_msg_t **out_msg)
 {
 	int retry, ret;
 
-	SEAP_msg_t *s_imsg, *s_omsg;
-	SEXP_t *s_oobj;
+	SEAP_msg_t *s_omsg;
 
 	if (pd == NULL || s_iobj == NULL) {
 		return -1;
@@ -483,6 +523,16 @@ static int oval_probe_comm(SEAP_CTX_t *ctx, oval_pd_t *pd, const SEXP_t *s_iobj,
 			}
 		}
 
+		if (s_prefetch != NULL) {
+			if (SEAP_msgattr_set(s_omsg, "prefetch", s_prefetch) != 0) {
+				dE("Can't set prefetch attribute.");
+				SEAP_msg_free(s_omsg);
+				oscap_seterr(OSCAP_EFAMILY_OVAL, "OVAL_EPROBEUNKNOWN");
+
+				return (-1);
+			}
+		}
+
 		dD("Sending message.");
 
 		ret = SEAP_sendmsg(ctx, pd->sd, s_omsg);
@@ -523,6 +573,7 @@ static int oval_probe_comm(SEAP_CTX_t *ctx, oval_pd_t *pd, const SEXP_t *s_iobj,
 			pd->sd = -1;
 
 			if (++retry <= OVAL_PROBE_MAXRETRY) {
+				SEAP_msg_free(s_omsg);
 				dD("Send: retry %u/%u.", retry, OVAL_PROBE_MAXRETRY);
 				continue;
 			} else {
@@ -542,53 +593,85 @@ static int oval_probe_comm(SEAP_CTX_t *ctx, oval_pd_t *pd, const SEXP_t *s_iobj,
 			}
 		}
 
-		dD("Waiting for reply.");
+		break;
+	}
 
-		/* recv_retry: */
-		s_imsg = NULL;
+	*out_msg = s_omsg;
+	return (0);
+}
 
-		ret = SEAP_recvmsg(ctx, pd->sd, &s_imsg);
-		if (ret != 0) {
-			protect_errno {
-				ret = _handle_SEAP_receive_failure(ctx, pd, s_omsg, flags);
-				SEAP_msg_free(s_imsg);
-				SEAP_msg_free(s_omsg);
-			}
-			if (errno == ECONNABORTED) {
-				dD("Connection was aborted.");
-				return (-2);
-			} else {
-				if (++retry <= OVAL_PROBE_MAXRETRY) {
-					dD("Recv: retry %u/%u.", retry, OVAL_PROBE_MAXRETRY);
-					continue;
-				} else {
-					protect_errno {
-						dE("Recv: retry limit (%u) reached.", OVAL_PROBE_MAXRETRY);
-					}
+/*
+ * Wait for the reply to a message sent by oval_probe_comm_send. Replies to
+ * other messages pending on the same probe descriptor are kept by SEAP until
+ * they are asked for. The s_omsg message is always freed.
+ */
+static int oval_probe_comm_recv(SEAP_CTX_t *ctx, oval_pd_t *pd, SEAP_msg_t *s_omsg, int flags, SEXP_t **out_sexp)
+{
+	int ret;
 
-					char errbuf[__ERRBUF_SIZE];
-					if (oscap_strerror_r (errno, errbuf, sizeof errbuf - 1) == 0)
-						oscap_seterr(OSCAP_EFAMILY_OVAL, "%s", errbuf);
-					oscap_seterr(OSCAP_EFAMILY_OVAL, "Unable to receive a message from probe");
+	SEAP_msg_t *s_imsg;
 
-					return ret;
-				}
-			}
-		}
+	dD("Waiting for reply.");
 
-		dD("Message received.");
-		break;
+	s_imsg = NULL;
+
+	ret = SEAP_recvmsg_byid(ctx, pd->sd, SEAP_msg_id(s_omsg), &s_imsg);
+	if (ret != 0) {
+		protect_errno {
+			ret = _handle_SEAP_receive_failure(ctx, pd, s_omsg, flags);
+			SEAP_msg_free(s_imsg);
+			SEAP_msg_free(s_omsg);
+		}
+		if (errno == ECONNABORTED) {
+			dD("Connection was aborted.");
+			return (-2);
+		}
+		return (ret);
 	}
 
-	s_oobj = SEAP_msg_get(s_imsg);
+	dD("Message received.");
+
+	*out_sexp = SEAP_msg_get(s_imsg);
 
 	SEAP_msg_free(s_imsg);
 	SEAP_msg_free(s_omsg);
 
-	*out_sexp = s_oobj;
 	return (0);
 }
 
+static int oval_probe_comm(SEAP_CTX_t *ctx, oval_pd_t *pd, const SEXP_t *s_iobj, int flags, SEXP_t **out_sexp)
+{
+	int retry, ret;
+
+	SEAP_msg_t *s_omsg;
+
+	for (retry = 0;;) {
+		ret = oval_probe_comm_send(ctx, pd, s_iobj, NULL, flags, &s_omsg);
+		if (ret != 0)
+			return (ret);
+
+		ret = oval_probe_comm_recv(ctx, pd, s_omsg, flags, out_sexp);
+		if (ret != -1)
+			return (ret);
+
+		if (++retry <= OVAL_PROBE_MAXRETRY) {
+			dD("Recv: retry %u/%u.", retry, OVAL_PROBE_MAXRETRY);
+			continue;
+		} else {
+			protect_errno {
+				dE("Recv: retry limit (%u) reached.", OVAL_PROBE_MAXRETRY);
+			}
+
+			char errbuf[__ERRBUF_SIZE];
+			if (oscap_strerror_r (errno, errbuf, sizeof errbuf - 1) == 0)
+				oscap_seterr(OSCAP_EFAMILY_OVAL, "%s", errbuf);
+			oscap_seterr(OSCAP_EFAMILY_OVAL, "Unable to receive a message from probe");
+
+			return (ret);
+		}
+	}
+}
+
 static int oval_probe_sys_eval(SEAP_CTX_t *ctx, oval_pd_t *pd, struct oval_syschar_model *model, struct oval_sysinfo **out_sysinf)
 {
 	struct oval_sysinfo *sysinf;
@@ -795,6 +878,82 @@ int oval_probe_sys_handler(oval_subtype_t type, void *ptr, int act, ...)
         return(ret);
 }
 
+/*
+ * Look up the descriptor of the probe collecting objects of the given
+ * syschar, the probe is started if needed. Returns 1 if there is no such
+ * probe, the syschar is flagged as not collected in that case.
+ */
+static int oval_probe_ext_getpd(oval_pext_t *pext, struct oval_syschar *sys, oval_pd_t **out_pd)
+{
+	struct oval_object *obj;
+	oval_subtype_t obj_subtype;
+	oval_pd_t *pd;
+
+	obj = oval_syschar_get_object(sys);
+	obj_subtype = oval_object_get_subtype(obj);
+	pd = oval_pdtbl_get(pext->pdtbl, obj_subtype);
+
+	if (pd == NULL) {
+		char         probe_uri[PATH_MAX + 1];
+		size_t       probe_urilen;
+
+		if (!probe_table_exists(obj_subtype)) {
+			oval_syschar_add_new_message(sys, "OVAL object not supported", OVAL_MESSAGE_LEVEL_WARNING);
+			oval_syschar_set_flag(sys, SYSCHAR_FLAG_NOT_COLLECTED);
+			return (1);
+		}
+
+		probe_urilen = snprintf(probe_uri, sizeof probe_uri, "%s://%s",
+				OVAL_PROBE_SCHEME, oval_subtype_get_text(obj_subtype));
+
+		if (probe_urilen >= sizeof probe_uri) {
+			oscap_seterr (OSCAP_EFAMILY_GLIBC, "probe URI too long");
+			return (-1);
+		}
+
+		dI("Starting probe on URI '%s'.", probe_uri);
+
+		if (oval_pdtbl_add(pext->pdtbl, obj_subtype, -1, probe_uri) != 0) {
+			oval_syschar_add_new_message(sys, "OVAL object not supported", OVAL_MESSAGE_LEVEL_WARNING);
+			oval_syschar_set_flag(sys, SYSCHAR_FLAG_NOT_COLLECTED);
+			return (1);
+		}
+
+		pd = oval_pdtbl_get(pext->pdtbl, obj_subtype);
+
+		if (pd == NULL) {
+			oscap_seterr (OSCAP_EFAMILY_OVAL, "internal error");
+			return (-1);
+		}
+	}
+
+	*out_pd = pd;
+	return (0);
+}
+
+/*
+ * Restart all probes after a connection was aborted. Requests still waiting
+ * for a reply are dropped, their syschars stay uncollected.
+ */
+static void oval_probe_ext_restart(oval_pext_t *pext, int flags)
+{
+	if (flags & OVAL_PDFLAG_SLAVE)
+		return;
+
+	if (!pext->do_init) {
+		oval_pdtbl_free(pext->pdtbl);
+	}
+
+	rbt_i64_free_cb(pext->pending, oval_preq_free_cb);
+	pext->pending  = rbt_i64_new();
+	pext->do_init  = true;
+	pext->pdtbl    = NULL;
+
+	oval_probe_ext_init(pext);
+
+	errno = ECONNABORTED;
+}
+
 int oval_probe_ext_handler(oval_subtype_t type, void *ptr, int act, ...)
 {
         int          ret = 0;
@@ -806,76 +965,56 @@ int oval_probe_ext_handler(oval_subtype_t type, void *ptr, int act, ...)
 
         switch(act) {
         case PROBE_HANDLER_ACT_EVAL:
+        case PROBE_HANDLER_ACT_SEND:
         {
-		struct oval_object *obj;
 		struct oval_syschar *sys;
+		void *req;
 		int flags;
 
 		sys = va_arg(ap, struct oval_syschar *);
 		flags = va_arg(ap, int);
-		obj = oval_syschar_get_object(sys);
-		oval_subtype_t obj_subtype = oval_object_get_subtype(obj);
-		pd = oval_pdtbl_get(pext->pdtbl, obj_subtype);
-
-                if (pd == NULL) {
-                        char         probe_uri[PATH_MAX + 1];
-                        size_t       probe_urilen;
-
-			if (!probe_table_exists(obj_subtype)) {
-				oval_syschar_add_new_message(sys, "OVAL object not supported", OVAL_MESSAGE_LEVEL_WARNING);
-				oval_syschar_set_flag(sys, SYSCHAR_FLAG_NOT_COLLECTED);
-				va_end(ap);
-				return (1);
-			}
-
-			probe_urilen = snprintf(probe_uri, sizeof probe_uri, "%s://%s",
-					OVAL_PROBE_SCHEME, oval_subtype_get_text(obj_subtype));
-
-                        if (probe_urilen >= sizeof probe_uri) {
-                                oscap_seterr (OSCAP_EFAMILY_GLIBC, "probe URI too long");
-				va_end(ap);
-                                return (-1);
-                        }
-
-                        dI("Starting probe on URI '%s'.", probe_uri);
-
-                        if (oval_pdtbl_add(pext->pdtbl, obj_subtype, -1, probe_uri) != 0) {
-				oval_syschar_add_new_message(sys, "OVAL object not supported", OVAL_MESSAGE_LEVEL_WARNING);
-				oval_syschar_set_flag(sys, SYSCHAR_FLAG_NOT_COLLECTED);
-				va_end(ap);
-                                return (1);
-			}
-
-			pd = oval_pdtbl_get(pext->pdtbl, obj_subtype);
-
-                        if (pd == NULL) {
-                                oscap_seterr (OSCAP_EFAMILY_OVAL, "internal error");
-				va_end(ap);
-                                return (-1);
-                        }
-                }
+		va_end(ap);
 
-		ret = oval_probe_ext_eval(pext->pdtbl->ctx, pd, pext, sys, flags);
+		/*
+		 * The object might have been sent to the probe already, e.g. when
+		 * it is needed for evaluation of another object sent in the same
+		 * batch. Just wait for the reply in that case.
+		 */
+		if (rbt_i64_get(pext->pending, (int64_t)(uintptr_t)sys, &req) == 0) {
+			if (act == PROBE_HANDLER_ACT_SEND)
+				return (0);
+			ret = oval_probe_ext_recv(pext->pdtbl->ctx, pext, sys);
+		} else {
+			ret = oval_probe_ext_getpd(pext, sys, &pd);
+			if (ret != 0)
+				return (act == PROBE_HANDLER_ACT_SEND && ret == 1 ? 2 : ret);
+
+			if (act == PROBE_HANDLER_ACT_EVAL)
+				ret = oval_probe_ext_eval(pext->pdtbl->ctx, pd, pext, sys, flags);
+			else
+				ret = oval_probe_ext_send(pext->pdtbl->ctx, pd, pext, sys, flags);
+		}
 
-		if (ret >= 0)
+		if (act == PROBE_HANDLER_ACT_EVAL && ret >= 0)
 			ret = 0;
 
-		if (ret < 0 && errno == ECONNABORTED) {
-			if (!(flags & OVAL_PDFLAG_SLAVE)) {
-				if (!pext->do_init) {
-					oval_pdtbl_free(pext->pdtbl);
-				}
+		if (ret < 0 && errno == ECONNABORTED)
+			oval_probe_ext_restart(pext, flags);
 
-				pext->do_init  = true;
-				pext->pdtbl    = NULL;
+		return ret;
+        }
+        case PROBE_HANDLER_ACT_RECV:
+        {
+		struct oval_syschar *sys;
 
-				oval_probe_ext_init(pext);
+		sys = va_arg(ap, struct oval_syschar *);
+		va_end(ap);
 
-				errno = ECONNABORTED;
-			}
-		}
+		ret = oval_probe_ext_recv(pext->pdtbl->ctx, pext, sys);
+
+		if (ret < 0 && errno == ECONNABORTED)
+			oval_probe_ext_restart(pext, 0);
 
-		va_end(ap);
 		return ret;
         }
         case PROBE_HANDLER_ACT_OPEN:
@@ -960,10 +1099,382 @@ int oval_probe_ext_init(oval_pext_t *pext)
         return(ret);
 }
 
-int oval_probe_ext_eval(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext, struct oval_syschar *syschar, int flags)
+/*
+ * Objects with sets and filters depend on other objects and states which
+ * are looked up by their id, such objects are never shared.
+ */
+static bool oval_object_is_shareable(struct oval_object *object)
 {
-        SEXP_t *s_obj, *s_sys;
+	struct oval_object_content_iterator *cit;
+	bool shareable = true;
+
+	cit = oval_object_get_object_contents(object);
+	while (oval_object_content_iterator_has_more(cit)) {
+		struct oval_object_content *content = oval_object_content_iterator_next(cit);
+
+		switch (oval_object_content_get_type(content)) {
+		case OVAL_OBJECTCONTENT_SET:
+		case OVAL_OBJECTCONTENT_FILTER:
+			shareable = false;
+			break;
+		default:
+			break;
+		}
+	}
+	oval_object_content_iterator_free(cit);
+
+	return shareable;
+}
+
+/*
+ * The states and the set sub-objects needed for the evaluation of an object
+ * are sent along with it so that the probe doesn't have to ask for them one
+ * by one using PROBECMD_STE_FETCH and PROBECMD_OBJ_EVAL. The sub-objects are
+ * listed after the objects they reference and are evaluated by the probe in
+ * that order. Anything left out is requested by the probe as before.
+ */
+struct oval_prefetch {
+	oval_pext_t *pext;
+	oval_subtype_t subtype;
+	struct oval_string_map *seen;
+	SEXP_t *stes;
+	SEXP_t *objs;
+};
+
+static void oval_prefetch_contents(struct oval_prefetch *pf, struct oval_object *object);
+
+static void oval_prefetch_filter(struct oval_prefetch *pf, struct oval_filter *filter)
+{
+	struct oval_state *ste;
+	const char *ste_id;
+	SEXP_t *ste_sexp;
+
+	ste = oval_filter_get_state(filter);
+	if (ste == NULL)
+		return;
+
+	ste_id = oval_state_get_id(ste);
+	if (oval_string_map_get_value(pf->seen, ste_id) != NULL)
+		return;
+	oval_string_map_put(pf->seen, ste_id, pf);
+
+	if (oval_probe_session_state_sexp(pf->pext->sess_ptr, ste, &ste_sexp) != 0)
+		return;
+
+	SEXP_list_add(pf->stes, ste_sexp);
+	SEXP_free(ste_sexp);
+}
+
+static void oval_prefetch_object(struct oval_prefetch *pf, struct oval_object *object)
+{
+	struct oval_syschar_model *model;
+	struct oval_syschar *sysc;
+	const char *obj_id;
+	SEXP_t *s_obj;
+
+	obj_id = oval_object_get_id(object);
+	if (oval_string_map_get_value(pf->seen, obj_id) != NULL)
+		return;
+	oval_string_map_put(pf->seen, obj_id, pf);
+
+	if (oval_object_get_subtype(object) != pf->subtype)
+		return;
+
+	oval_prefetch_contents(pf, object);
+
+	/* the same syschar is used when the probe asks for the object */
+	model = *(pf->pext->model);
+	sysc = oval_syschar_model_get_syschar(model, obj_id);
+	if (sysc == NULL)
+		sysc = oval_syschar_new(model, object);
+	else if (oval_syschar_get_variable_instance_hint(sysc) != oval_syschar_get_variable_instance(sysc))
+		return;
+
+	if (oval_probe_session_object_sexp(pf->pext->sess_ptr, oval_subtype_to_str(pf->subtype), sysc, &s_obj) != 0)
+		return;
+
+	if (probe_obj_attrexists(s_obj, "skip_eval")) {
+		SEXP_free(s_obj);
+		return;
+	}
+
+	SEXP_list_add(pf->objs, s_obj);
+	SEXP_free(s_obj);
+}
+
+static void oval_prefetch_set(struct oval_prefetch *pf, struct oval_setobject *set)
+{
+	struct oval_setobject_iterator *sit;
+	struct oval_object_iterator *oit;
+	struct oval_filter_iterator *fit;
+
+	switch (oval_setobject_get_type(set)) {
+	case OVAL_SET_AGGREGATE:
+		sit = oval_setobject_get_subsets(set);
+		while (oval_setobject_iterator_has_more(sit))
+			oval_prefetch_set(pf, oval_setobject_iterator_next(sit));
+		oval_setobject_iterator_free(sit);
+		break;
+	case OVAL_SET_COLLECTIVE:
+		oit = oval_setobject_get_objects(set);
+		while (oval_object_iterator_has_more(oit))
+			oval_prefetch_object(pf, oval_object_iterator_next(oit));
+		oval_object_iterator_free(oit);
+
+		fit = oval_setobject_get_filters(set);
+		while (oval_filter_iterator_has_more(fit))
+			oval_prefetch_filter(pf, oval_filter_iterator_next(fit));
+		oval_filter_iterator_free(fit);
+		break;
+	default:
+		break;
+	}
+}
+
+static void oval_prefetch_contents(struct oval_prefetch *pf, struct oval_object *object)
+{
+	struct oval_object_content_iterator *cit;
+
+	cit = oval_object_get_object_contents(object);
+	while (oval_object_content_iterator_has_more(cit)) {
+		struct oval_object_content *content = oval_object_content_iterator_next(cit);
+
+		switch (oval_object_content_get_type(content)) {
+		case OVAL_OBJECTCONTENT_SET:
+			oval_prefetch_set(pf, oval_object_content_get_setobject(content));
+			break;
+		case OVAL_OBJECTCONTENT_FILTER:
+			oval_prefetch_filter(pf, oval_object_content_get_filter(content));
+			break;
+		default:
+			break;
+		}
+	}
+	oval_object_content_iterator_free(cit);
+}
+
+/*
+ * Build the value of the `prefetch' message attribute: ((ste ...) (obj ...)).
+ * Returns NULL if there is nothing to send.
+ */
+static SEXP_t *oval_probe_prefetch(oval_pext_t *pext, struct oval_object *object)
+{
+	struct oval_prefetch pf;
+	SEXP_t *res = NULL;
+
+	pf.pext = pext;
+	pf.subtype = oval_object_get_subtype(object);
+	pf.seen = oval_string_map_new();
+	pf.stes = SEXP_list_new(NULL);
+	pf.objs = SEXP_list_new(NULL);
+
+	oval_string_map_put(pf.seen, oval_object_get_id(object), &pf);
+	oval_prefetch_contents(&pf, object);
+
+	if (SEXP_list_length(pf.stes) > 0 || SEXP_list_length(pf.objs) > 0)
+		res = SEXP_list_new(pf.stes, pf.objs, NULL);
+
+	SEXP_free(pf.stes);
+	SEXP_free(pf.objs);
+	oval_string_map_free(pf.seen, NULL);
+
+	return (res);
+}
+
+/*
+ * Vulnerability feeds consist of thousands of rpminfo objects, each of them
+ * naming one package. Once OVAL_PKG_INVENTORY_MIN such objects were sent to
+ * the probe, all the installed packages are collected by one object matching
+ * any name, and the following objects are answered by looking their name up
+ * in that inventory. Objects with anything else than a single name entity
+ * compared for equality still go to the probe.
+ */
+#define OVAL_PKG_INVENTORY_MIN 64
+#define OVAL_PKG_INVENTORY_ID  "oval:org.open-scap.inventory:obj:1"
+
+struct oval_pkg_inventory {
+	unsigned int requests;      /* objects by name seen before the inventory was collected */
+	bool failed;                /* the inventory couldn't be collected */
+	char *oval_version;         /* version of the object used to collect the inventory */
+	struct oscap_htable *items; /* name -> SEXP list of items */
+};
+
+static void oval_pkg_inventory_free(struct oval_pkg_inventory *inv)
+{
+	if (inv == NULL)
+		return;
+
+	oscap_htable_free(inv->items, (oscap_destruct_func)SEXP_free);
+	free(inv->oval_version);
+	free(inv);
+}
+
+/* the name of the package if the object looks it up by name, NULL otherwise */
+static char *oval_pkg_object_name(const SEXP_t *s_obj)
+{
+	SEXP_t *ent, *val;
+	char *name = NULL;
+
+	if (SEXP_list_length(s_obj) != 2 || probe_obj_attrexists(s_obj, "skip_eval"))
+		return (NULL);
+
+	ent = probe_obj_getent(s_obj, "name", 1);
+	if (ent == NULL)
+		return (NULL);
+
+	val = probe_ent_getattrval(ent, "operation");
+	if ((val == NULL || SEXP_number_geti_32(val) == OVAL_OPERATION_EQUALS) &&
+	    !probe_ent_attrexists(ent, "var_ref") && !probe_ent_getmask(ent) &&
+	    probe_ent_getdatatype(ent) == OVAL_DATATYPE_STRING) {
+		SEXP_free(val);
+		val = probe_ent_getval(ent);
+		if (val != NULL && SEXP_stringp(val))
+			name = SEXP_string_cstr(val);
+	}
+	SEXP_free(val);
+	SEXP_free(ent);
+
+	return (name);
+}
+
+static char *oval_pkg_object_version(const SEXP_t *s_obj)
+{
+	SEXP_t *val;
+	char *version;
+
+	val = probe_obj_getattrval(s_obj, "oval_version");
+	version = val != NULL && SEXP_stringp(val) ? SEXP_string_cstr(val) : NULL;
+	SEXP_free(val);
+
+	return (version);
+}
+
+static int oval_pkg_inventory_collect(SEAP_CTX_t *ctx, oval_pd_t *pd, struct oval_pkg_inventory *inv, const char *oval_version)
+{
+	SEXP_t *s_inv, *s_attr, *s_ent, *s_sys, *items, *item, *r0, *r1;
+	oval_syschar_collection_flag_t flag;
+	char obj_name[128];
+	int ret;
+
+	snprintf(obj_name, sizeof obj_name, "%s_object", oval_subtype_to_str(pd->subtype));
+	s_attr = probe_attr_creat("id", r0 = SEXP_string_newf("%s", OVAL_PKG_INVENTORY_ID),
+	                          "oval_version", r1 = SEXP_string_newf("%s", oval_version),
+	                          NULL);
+	SEXP_free(r0);
+	SEXP_free(r1);
+	s_inv = probe_obj_new(obj_name, s_attr);
+	SEXP_free(s_attr);
+
+	s_attr = probe_attr_creat("operation", r0 = SEXP_number_newu_32(OVAL_OPERATION_PATTERN_MATCH), NULL);
+	s_ent = probe_ent_creat1("name", s_attr, r1 = SEXP_string_newf(".*"));
+	SEXP_free(r0);
+	SEXP_free(r1);
+	SEXP_free(s_attr);
+	SEXP_list_add(s_inv, s_ent);
+	SEXP_free(s_ent);
+
+	dI("Collecting all the installed packages for the %s objects.", obj_name);
+	s_sys = NULL;
+	ret = oval_probe_comm(ctx, pd, s_inv, 0, &s_sys);
+	SEXP_free(s_inv);
+	if (ret != 0)
+		return (-1);
+
+	flag = probe_cobj_get_flag(s_sys);
+	if (flag != SYSCHAR_FLAG_COMPLETE && flag != SYSCHAR_FLAG_DOES_NOT_EXIST) {
+		dW("The package inventory is %s, querying the packages one by one.",
+		   oval_syschar_collection_flag_get_text(flag));
+		SEXP_free(s_sys);
+		return (-1);
+	}
+
+	inv->items = oscap_htable_new();
+	items = probe_cobj_get_items(s_sys);
+	SEXP_list_foreach(item, items) {
+		SEXP_t *val, *lst;
+		char *name;
+
+		val = probe_obj_getentval(item, "name", 1);
+		name = val != NULL && SEXP_stringp(val) ? SEXP_string_cstr(val) : NULL;
+		SEXP_free(val);
+		if (name == NULL)
+			continue;
+
+		lst = oscap_htable_get(inv->items, name);
+		if (lst == NULL) {
+			lst = SEXP_list_new(NULL);
+			oscap_htable_add(inv->items, name, lst);
+		}
+		SEXP_list_add(lst, item);
+		free(name);
+	}
+	SEXP_free(items);
+	SEXP_free(s_sys);
+
+	inv->oval_version = strdup(oval_version);
+	dI("The package inventory has %zu names.", oscap_htable_itemcount(inv->items));
+
+	return (0);
+}
+
+/*
+ * Answer an object looking up a package by name from the inventory.
+ * Returns the collected object or NULL if the probe has to be asked.
+ */
+static SEXP_t *oval_pkg_inventory_lookup(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext, const SEXP_t *s_obj)
+{
+	struct oval_pkg_inventory *inv;
+	SEXP_t *items = NULL;
+	char *name, *version;
+	bool found = false;
+
+	inv = pext->rpm_inventory;
+	if (inv != NULL && inv->failed)
+		return (NULL);
+
+	name = oval_pkg_object_name(s_obj);
+	if (name == NULL)
+		return (NULL);
+	version = oval_pkg_object_version(s_obj);
+	if (version == NULL) {
+		free(name);
+		return (NULL);
+	}
+
+	if (inv == NULL)
+		inv = pext->rpm_inventory = calloc(1, sizeof(struct oval_pkg_inventory));
+
+	if (inv->items == NULL && ++inv->requests >= OVAL_PKG_INVENTORY_MIN &&
+	    oval_pkg_inventory_collect(ctx, pd, inv, version) != 0) {
+		inv->failed = true;
+		oscap_clearerr();
+	}
+
+	/* the items of another schema version may have different entities */
+	if (inv->items != NULL && strcmp(inv->oval_version, version) == 0) {
+		items = oscap_htable_get(inv->items, name);
+		found = true;
+	}
+	free(version);
+	free(name);
+
+	if (!found)
+		return (NULL);
+
+	return probe_cobj_new(items != NULL ? SYSCHAR_FLAG_COMPLETE : SYSCHAR_FLAG_DOES_NOT_EXIST,
+			      NULL, items, NULL);
+}
+
+int oval_probe_ext_send(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext, struct oval_syschar *syschar, int flags)
+{
+        SEXP_t *s_obj, *s_sys, *s_canon = NULL, *s_prefetch = NULL;
 	struct oval_object *object;
+	struct oval_object_cache *ocache;
+	oval_preq_t *req;
+	SEAP_msg_t *s_omsg = NULL;
+	sch_queue_call_t *call = NULL;
+	uint64_t fingerprint = 0;
+	bool simple;
 	int ret;
 
 	if (syschar == NULL) {
@@ -972,14 +1483,127 @@ int oval_probe_ext_eval(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext, struc
 	}
 
 	object = oval_syschar_get_object(syschar);
-	ret = oval_object_to_sexp(pext->sess_ptr, oval_subtype_to_str(oval_object_get_subtype(object)), syschar, &s_obj);
+	ret = oval_probe_session_object_sexp(pext->sess_ptr, oval_subtype_to_str(oval_object_get_subtype(object)), syschar, &s_obj);
 
 	if (ret != 0)
 		return (1);
 
-	ret = oval_probe_comm(ctx, pd, s_obj, flags, &s_sys);
+	ocache = ((oval_probe_session_t *)pext->sess_ptr)->ocache;
+	simple = !(flags & OVAL_PDFLAG_NOREPLY) && oval_object_is_shareable(object);
+
+	if (ocache != NULL && simple) {
+		if (oval_object_cache_fingerprint(s_obj, &s_canon, &fingerprint) == 0) {
+			s_sys = oval_object_cache_get(ocache, fingerprint, s_canon);
+
+			if (s_sys != NULL) {
+				dI("Object '%s' was already collected, using the cached result.",
+				   oval_object_get_id(object));
+				SEXP_free(s_canon);
+				SEXP_free(s_obj);
+
+				ret = oval_sexp_to_sysch(s_sys, syschar);
+				SEXP_free(s_sys);
+
+				return (ret == 0 ? 1 : ret);
+			}
+		}
+	}
+
+	if (simple && oval_object_get_subtype(object) == OVAL_LINUX_RPM_INFO) {
+		s_sys = oval_pkg_inventory_lookup(ctx, pd, pext, s_obj);
+
+		if (s_sys != NULL) {
+			if (s_canon != NULL && oval_object_cache_add(ocache, fingerprint, s_canon, s_sys) != 0)
+				dW("Can't add object '%s' to the collected object cache.",
+				   oval_object_get_id(object));
+			SEXP_free(s_canon);
+			SEXP_free(s_obj);
+
+			ret = oval_sexp_to_sysch(s_sys, syschar);
+			SEXP_free(s_sys);
+
+			return (ret == 0 ? 1 : ret);
+		}
+	}
+
+	/*
+	 * Objects without sets and filters don't need to call back into the
+	 * library, so an already running in-process probe can take them
+	 * directly. Everything else goes through SEAP.
+	 */
+	if (simple && pd->sd != -1)
+		call = SEAP_call(ctx, pd->sd, s_obj);
+
+	if (call == NULL) {
+		/* requests made by the probe itself were preceded by the prefetch */
+		if (!simple && !(flags & OVAL_PDFLAG_SLAVE))
+			s_prefetch = oval_probe_prefetch(pext, object);
+
+		ret = oval_probe_comm_send(ctx, pd, s_obj, s_prefetch, flags, &s_omsg);
+		SEXP_free(s_prefetch);
+	}
 	SEXP_free(s_obj);
 
+	if (ret != 0) {
+		SEXP_free(s_canon);
+		return (ret);
+	}
+
+	req = malloc(sizeof(oval_preq_t));
+	req->pd = pd;
+	req->msg = s_omsg;
+	req->call = call;
+	req->s_canon = s_canon;
+	req->fingerprint = fingerprint;
+	req->flags = flags;
+
+	if (rbt_i64_add(pext->pending, (int64_t)(uintptr_t)syschar, req, NULL) != 0) {
+		oscap_seterr(OSCAP_EFAMILY_OVAL, "Internal error: object '%s' is already being collected",
+			     oval_object_get_id(object));
+		oval_preq_free(req);
+		return (-1);
+	}
+
+	return (0);
+}
+
+int oval_probe_ext_recv(SEAP_CTX_t *ctx, oval_pext_t *pext, struct oval_syschar *syschar)
+{
+	SEXP_t *s_sys;
+	oval_preq_t *req;
+	oval_pd_t *pd;
+	int ret, flags;
+
+	if (rbt_i64_del(pext->pending, (int64_t)(uintptr_t)syschar, (void **)&req) != 0)
+		return (1);
+
+	pd = req->pd;
+	flags = req->flags;
+
+	if (req->call != NULL) {
+		ret = sch_queue_call_wait(req->call, &s_sys);
+		req->call = NULL;
+
+		if (ret != 0) {
+			oscap_seterr(OSCAP_EFAMILY_OVAL, "Probe at sd=%d (%s) reported an error: %s",
+				     pd->sd, oval_subtype_to_str(pd->subtype), _probe_strerror(ret));
+			errno = ECANCELED;
+			ret = -1;
+		}
+	} else {
+		ret = oval_probe_comm_recv(ctx, pd, req->msg, flags, &s_sys);
+		req->msg = NULL;
+	}
+
+	if (ret == 0 && req->s_canon != NULL) {
+		if (probe_cobj_get_flag(s_sys) != SYSCHAR_FLAG_ERROR &&
+		    oval_object_cache_add(((oval_probe_session_t *)pext->sess_ptr)->ocache,
+					  req->fingerprint, req->s_canon, s_sys) != 0)
+			dW("Can't add object '%s' to the collected object cache.",
+			   oval_object_get_id(oval_syschar_get_object(syschar)));
+	}
+	oval_preq_free(req);
+
 	if (ret != 0) {
 		switch (errno) {
 		case ECONNABORTED:
@@ -1013,15 +1637,32 @@ int oval_probe_ext_eval(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext, struc
         /*
 	 * Convert the received S-exp to OVAL system characteristic.
 	 */
-	ret = oval_sexp_to_sysch(s_sys, syschar);
+	ret = oval_sexp_to_sysch_consume(s_sys, syschar);
 	SEXP_free(s_sys);
 
 	return (ret);
 }
 
+int oval_probe_ext_eval(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext, struct oval_syschar *syschar, int flags)
+{
+	int ret;
+
+	ret = oval_probe_ext_send(ctx, pd, pext, syschar, flags);
+	if (ret != 0)
+		return (ret);
+
+	return oval_probe_ext_recv(ctx, pext, syschar);
+}
+
 int oval_probe_ext_reset(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext)
 {
+        if (pd->subtype == OVAL_LINUX_RPM_INFO) {
+                oval_pkg_inventory_free(pext->rpm_inventory);
+                pext->rpm_inventory = NULL;
+        }
         SEAP_cmd_exec(ctx, pd->sd, SEAP_EXEC_RECV, PROBECMD_RESET, NULL, SEAP_CMDTYPE_SYNC, NULL, NULL);
+	/* the probes collect again after an abort */
+	oval_deadline_resume();
 
         return (0);
 }
@@ -1040,8 +1681,14 @@ int oval_probe_ext_abort(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext)
 
 #else
 
+/*
+ * The probe threads share the deadline of the process, so an abort stops
+ * all of them at their next checkpoint and the objects not sent yet are
+ * not collected, until the session is reset.
+ */
 int oval_probe_ext_abort(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext)
 {
+	oval_deadline_abort();
 	return (0);
 }
 
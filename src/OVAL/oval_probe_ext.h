@@ -28,6 +28,7 @@
 #include "oval_probe_impl.h"
 #include "oval_system_characteristics_impl.h"
 #include "common/util.h"
+#include "probes/SEAP/generic/rbt/rbt.h"
 
 typedef struct {
 	oval_subtype_t subtype;
@@ -50,6 +51,9 @@ struct oval_pext {
 
         void *sess_ptr;
         struct oval_syschar_model **model;
+
+        rbt_t *pending; /* requests waiting for a reply, keyed by syschar */
+        struct oval_pkg_inventory *rpm_inventory; /* installed packages, see oval_pkg_inventory_lookup */
 };
 
 typedef struct oval_pext oval_pext_t;
@@ -58,6 +62,8 @@ oval_pext_t *oval_pext_new(void);
 void oval_pext_free(oval_pext_t *pext);
 int oval_probe_ext_init(oval_pext_t *pext);
 int oval_probe_ext_eval(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext, struct oval_syschar *syschar, int flags);
+int oval_probe_ext_send(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext, struct oval_syschar *syschar, int flags);
+int oval_probe_ext_recv(SEAP_CTX_t *ctx, oval_pext_t *pext, struct oval_syschar *syschar);
 int oval_probe_ext_reset(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext);
 int oval_probe_ext_abort(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext);
 
@@ -24,11 +24,16 @@
 #include <config.h>
 #endif
 
+#include <stdlib.h>
+
 #include "public/oval_definitions.h"
 #include "public/oval_system_characteristics.h"
 #include "oval_system_characteristics_impl.h"
+#include "oval_definitions_impl.h"
 #include "oval_probe_impl.h"
 #include "_oval_probe_session.h"
+#include "_oval_probe_handler.h"
+#include "common/debug_priv.h"
 
 static int _oval_probe_hint_criteria(oval_probe_session_t *sess, struct oval_criteria_node *cnode, int variable_instance_hint);
 static int _oval_probe_hint_object(oval_probe_session_t *psess, struct oval_object *object, int variable_instance_hint);
@@ -99,3 +104,55 @@ int _oval_probe_hint_object(oval_probe_session_t *psess, struct oval_object *obj
 	}
 	return 0;
 }
+
+/**
+ * Marks the collected objects which depend on the given variable with the next
+ * variable_instance_hint, so they are collected again when the variable is bound
+ * to new values. Unlike @ref oval_probe_hint_definition, the objects which do not
+ * reference the variable keep their collected items. The probes of the hinted
+ * objects are reset to drop their results cached under the same object id.
+ * @returns 0 on success; -1 on error
+ */
+int oval_probe_hint_variable(oval_probe_session_t *sess, struct oval_definition_model *model, struct oval_variable *variable)
+{
+	oval_subtype_t *reset = NULL;
+	int reset_cnt = 0, reset_max = 0, ret = 0;
+
+	struct oval_object_iterator *obj_it = oval_definition_model_get_objects_dependent_on_variable(model, variable);
+	while (oval_object_iterator_has_more(obj_it)) {
+		struct oval_object *object = oval_object_iterator_next(obj_it);
+		struct oval_syschar *syschar = oval_syschar_model_get_syschar(sess->sys_model, oval_object_get_id(object));
+		if (syschar == NULL)
+			continue;
+
+		int instance = oval_syschar_get_variable_instance(syschar);
+		if (oval_syschar_get_variable_instance_hint(syschar) == instance)
+			oval_syschar_set_variable_instance_hint(syschar, instance + 1);
+
+		oval_subtype_t type = oval_object_get_subtype(object);
+		int i;
+		for (i = 0; i < reset_cnt && reset[i] != type; i++)
+			;
+		if (i == reset_cnt) {
+			if (reset_cnt == reset_max) {
+				reset_max = reset_max ? reset_max * 2 : 8;
+				reset = realloc(reset, reset_max * sizeof(oval_subtype_t));
+			}
+			reset[reset_cnt++] = type;
+		}
+	}
+	oval_object_iterator_free(obj_it);
+
+	for (int i = 0; i < reset_cnt; i++) {
+		oval_ph_t *ph = oval_probe_handler_get(sess->ph, reset[i]);
+		if (ph == NULL)
+			continue;
+		dI("Resetting %s probe, its objects depend on variable '%s'.",
+		   oval_subtype_get_text(reset[i]), oval_variable_get_id(variable));
+		if (ph->func(reset[i], ph->uptr, PROBE_HANDLER_ACT_RESET) != 0)
+			ret = -1;
+	}
+	free(reset);
+
+	return ret;
+}
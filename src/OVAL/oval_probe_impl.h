@@ -37,6 +37,7 @@
 #include "oval_parser_impl.h"
 #include "public/oval_system_characteristics.h"
 #include "../common/util.h"
+#include "../common/list.h"
 #include "public/oval_probe.h"
 #include "probes/_probe-api.h"
 
@@ -48,8 +49,45 @@
 
 #define OVAL_PROBE_MAXRETRY 0
 
+/* Maximum number of objects sent to the probes and waiting for collection */
+#define OVAL_PROBE_MAXPENDING 32
+
 int oval_probe_query_test(oval_probe_session_t *sess, struct oval_test *test);
 
+/**
+ * Send all the given objects which were not collected yet to the probes
+ * and then collect the replies. Objects of different types are collected
+ * concurrently by their probes. At most OVAL_PROBE_MAXPENDING objects are
+ * waiting for collection at a time.
+ * An object which fails to be collected is left for @ref oval_probe_query_object
+ * to try again and report the error.
+ * @param objects list of struct oval_object
+ * @returns 0 on success; -1 on error
+ */
+int oval_probe_query_objects(oval_probe_session_t *sess, struct oscap_list *objects);
+
+/**
+ * Collect the objects of all the tests referenced by the definition
+ * (and the definitions it extends) using @ref oval_probe_query_objects.
+ */
+int oval_probe_query_definition(oval_probe_session_t *sess, struct oval_definition *definition);
+
+/**
+ * Collect the objects of all the tests of the definition model
+ * using @ref oval_probe_query_objects.
+ */
+int oval_probe_query_definitions(oval_probe_session_t *sess, struct oval_definition_model *model);
+
+/**
+ * Collect the objects of all the tests of the definitions with given IDs
+ * using @ref oval_probe_query_objects, the definitions which aren't in the
+ * model are skipped.
+ * @param ids IDs of the definitions, all the definitions of the model if NULL
+ * @param skip_external skip the objects depending on external variables which
+ *        may not have their values bound yet
+ */
+int oval_probe_query_definition_list(oval_probe_session_t *sess, struct oval_definition_model *model, struct oscap_stringlist *ids, bool skip_external);
+
 
 extern probe_ncache_t *OSCAP_GSYM(ncache);
 
@@ -62,6 +100,13 @@ void oval_probe_tblinit(void);
 const char *oval_subtype_to_str(oval_subtype_t subtype);
 
 int oval_probe_hint_definition(oval_probe_session_t *sess, struct oval_definition *definition, int variable_instance_hint);
+int oval_probe_hint_variable(oval_probe_session_t *sess, struct oval_definition_model *model, struct oval_variable *variable);
+
+/**
+ * Drop the system information shared by the agent sessions, the next
+ * oval_probe_query_sysinfo call collects it again.
+ */
+void oval_probe_sysinfo_reset(void);
 
 #endif /* OVAL_PROBE_IMPL_H */
 /// @}
@@ -42,13 +42,39 @@
 
 
 #include "public/oval_definitions.h"
+#include "oscap_helpers.h"
 #include "_oval_probe_session.h"
 #include "_oval_probe_handler.h"
 #include "oval_probe_impl.h"
 #include "oval_probe_ext.h"
 #include "probe-table.h"
 #include "oval_types.h"
+#include "adt/oval_string_map_impl.h"
+#include "oval_sexp.h"
+#include "collectVarRefs_impl.h"
+#include "probes/public/probe-api.h"
 #include "crapi/crapi.h"
+#include "probes/probe/registry.h"
+#include "probes/oval_fts_cache.h"
+#include "probes/oval_content_cache.h"
+#include "probes/oval_digest_cache.h"
+#include "probes/oval_proc_cache.h"
+#include "probes/oval_sysctl_cache.h"
+#include "probes/oval_account_cache.h"
+#include "probes/oval_net_cache.h"
+#include "probes/oval_realpath_cache.h"
+#ifdef SELINUX_FOUND
+#include "probes/oval_selinux_cache.h"
+#endif
+#if defined(OPENSCAP_PROBE_LINUX_SYSTEMDUNITDEPENDENCY) || defined(OPENSCAP_PROBE_LINUX_SYSTEMDUNITPROPERTY)
+#include "probes/unix/linux/systemd-cache.h"
+#define OVAL_PROBE_SYSTEMD_CACHE
+#endif
+#if defined(OPENSCAP_PROBE_LINUX_RPMINFO) || defined(OPENSCAP_PROBE_LINUX_RPMVERIFY) || \
+    defined(OPENSCAP_PROBE_LINUX_RPMVERIFYFILE) || defined(OPENSCAP_PROBE_LINUX_RPMVERIFYPACKAGE)
+#include "probes/unix/linux/rpm-helper.h"
+#define OVAL_PROBE_RPM_INDEX
+#endif
 
 #if defined(OSCAP_THREAD_SAFE)
 #include <pthread.h>
@@ -57,6 +83,14 @@ static pthread_once_t __oval_probe_session_init_once = PTHREAD_ONCE_INIT;
 static volatile int __oval_probe_session_init_once = 0;
 #endif /* OSCAP_THREAD_SAFE */
 
+/*
+ * The caches of the probes belong to the process, all the live sessions
+ * share them. They are dropped when the last session is freed and when
+ * any session is reset or flushed.
+ */
+static pthread_mutex_t oval_probe_sessions_lock = PTHREAD_MUTEX_INITIALIZER;
+static unsigned int oval_probe_sessions_live = 0;
+
 /**
  * Entity name cache exit hook. This hook is registered using
  * atexit(3) during initialization and ensures that the element
@@ -94,6 +128,10 @@ static void oval_probe_session_libinit(void)
 	SEXP_free((SEXP_t *)exp);
 
         ncache_libinit();
+	/*
+	 * Probe states are kept between sessions, finalize them at exit
+	 */
+	atexit(probe_registry_cleanup);
 	/*
 	 * Initialize crypto API
 	 */
@@ -127,6 +165,10 @@ static void __init_once(void)
 
 static void oval_probe_session_init(oval_probe_session_t *sess, struct oval_syschar_model *model)
 {
+	pthread_mutex_lock(&oval_probe_sessions_lock);
+	oval_probe_sessions_live++;
+	pthread_mutex_unlock(&oval_probe_sessions_lock);
+
         sess->ph = oval_phtbl_new();
         sess->sys_model = model;
         sess->flg = 0;
@@ -154,12 +196,472 @@ static void oval_probe_session_init(oval_probe_session_t *sess, struct oval_sysc
 oval_probe_session_t *oval_probe_session_new(struct oval_syschar_model *model)
 {
         oval_probe_session_t *sess = malloc(sizeof(oval_probe_session_t));
+        sess->ocache = NULL;
+        sess->referenced_entities_only = false;
+        sess->item_entities = NULL;
+        pthread_mutex_init(&sess->item_entities_lock, NULL);
+        sess->sexps = NULL;
+        sess->varrefs = NULL;
+        pthread_mutex_init(&sess->memo_lock, NULL);
         oval_probe_session_init(sess, model);
         return sess;
 }
 
+void oval_probe_session_set_object_cache(oval_probe_session_t *sess, struct oval_object_cache *cache)
+{
+	sess->ocache = cache;
+}
+
+void oval_probe_session_set_referenced_entities_only(oval_probe_session_t *sess, bool referenced_only)
+{
+	sess->referenced_entities_only = referenced_only;
+	/* the objects carry the entities to collect */
+	oval_probe_session_forget_sexps(sess);
+}
+
+/* item entities of an object used by the definitions */
+struct oval_item_entities {
+	bool all;
+	char *names; /* separated by spaces */
+	bool all_items; /* some reference needs all the items */
+	uint32_t items; /* existing items which decide the tests without a state */
+};
+
+static void oval_item_entities_free(void *ptr)
+{
+	struct oval_item_entities *ents = ptr;
+
+	free(ents->names);
+	free(ents);
+}
+
+static struct oval_item_entities *oval_item_entities_get(struct oval_string_map *map, struct oval_object *object)
+{
+	const char *id = oval_object_get_id(object);
+	struct oval_item_entities *ents = oval_string_map_get_value(map, id);
+
+	if (ents == NULL) {
+		ents = calloc(1, sizeof(struct oval_item_entities));
+		ents->names = strdup("");
+		oval_string_map_put(map, id, ents);
+	}
+	return ents;
+}
+
+static bool oval_item_entities_has(const char *names, const char *name)
+{
+	size_t len = strlen(name);
+	const char *p = names;
+
+	while ((p = strstr(p, name)) != NULL) {
+		if ((p == names || p[-1] == ' ') && (p[len] == ' ' || p[len] == '\0'))
+			return true;
+		p += len;
+	}
+	return false;
+}
+
+static void oval_item_entities_add(struct oval_string_map *map, struct oval_object *object, const char *name)
+{
+	struct oval_item_entities *ents = oval_item_entities_get(map, object);
+	size_t len;
+	char *names;
+
+	if (ents->all || name == NULL || oval_item_entities_has(ents->names, name))
+		return;
+	len = strlen(ents->names);
+	names = realloc(ents->names, len + strlen(name) + 2);
+	if (names == NULL) {
+		ents->all = true;
+		return;
+	}
+	if (len > 0)
+		names[len++] = ' ';
+	strcpy(names + len, name);
+	ents->names = names;
+}
+
+static void oval_item_entities_add_state(struct oval_string_map *map, struct oval_object *object, struct oval_state *state)
+{
+	struct oval_state_content_iterator *it = oval_state_get_contents(state);
+
+	while (oval_state_content_iterator_has_more(it)) {
+		struct oval_entity *entity = oval_state_content_get_entity(oval_state_content_iterator_next(it));
+
+		if (entity != NULL)
+			oval_item_entities_add(map, object, oval_entity_get_name(entity));
+	}
+	oval_state_content_iterator_free(it);
+}
+
+/*
+ * A test without a state looks only at how many items exist, the first
+ * ones decide it when the collected object is incomplete (see the
+ * SYSCHAR_FLAG_INCOMPLETE case of the test evaluation).
+ */
+static void oval_item_entities_add_test(struct oval_string_map *map, struct oval_object *object, struct oval_test *test, bool has_state)
+{
+	struct oval_item_entities *ents = oval_item_entities_get(map, object);
+	uint32_t items;
+
+	switch (oval_test_get_existence(test)) {
+	case OVAL_AT_LEAST_ONE_EXISTS:
+	case OVAL_NONE_EXIST:
+		items = 1;
+		break;
+	case OVAL_ONLY_ONE_EXISTS:
+		items = 2;
+		break;
+	default:
+		items = 0;
+		break;
+	}
+
+	if (has_state || items == 0)
+		ents->all_items = true;
+	else if (items > ents->items)
+		ents->items = items;
+}
+
+/* the items of set members end up in the set, they are collected whole */
+static void oval_item_entities_add_set(struct oval_string_map *map, struct oval_setobject *set)
+{
+	if (oval_setobject_get_type(set) == OVAL_SET_AGGREGATE) {
+		struct oval_setobject_iterator *sit = oval_setobject_get_subsets(set);
+
+		while (oval_setobject_iterator_has_more(sit))
+			oval_item_entities_add_set(map, oval_setobject_iterator_next(sit));
+		oval_setobject_iterator_free(sit);
+	} else {
+		struct oval_object_iterator *oit = oval_setobject_get_objects(set);
+
+		while (oval_object_iterator_has_more(oit)) {
+			struct oval_item_entities *ents = oval_item_entities_get(map, oval_object_iterator_next(oit));
+
+			ents->all = true;
+			ents->all_items = true;
+		}
+		oval_object_iterator_free(oit);
+	}
+}
+
+static void oval_item_entities_add_component(struct oval_string_map *map, struct oval_component *component)
+{
+	struct oval_component_iterator *it;
+
+	switch (oval_component_get_type(component)) {
+	case OVAL_COMPONENT_OBJECTREF:
+		if (oval_component_get_object(component) != NULL) {
+			oval_item_entities_add(map, oval_component_get_object(component),
+					       oval_component_get_item_field(component));
+			/* the variable takes the values of all the items */
+			oval_item_entities_get(map, oval_component_get_object(component))->all_items = true;
+		}
+		break;
+	case OVAL_COMPONENT_LITERAL:
+	case OVAL_COMPONENT_VARREF:
+		break;
+	default:
+		it = oval_component_get_function_components(component);
+		while (oval_component_iterator_has_more(it))
+			oval_item_entities_add_component(map, oval_component_iterator_next(it));
+		oval_component_iterator_free(it);
+		break;
+	}
+}
+
+/*
+ * Map the objects to the item entities which are compared with states by
+ * the tests and filters or read by object components of variables, and to
+ * the number of items their tests need.
+ */
+static struct oval_string_map *oval_item_entities_build(struct oval_definition_model *model)
+{
+	struct oval_string_map *map = oval_string_map_new();
+	struct oval_test_iterator *tit;
+	struct oval_object_iterator *oit;
+	struct oval_variable_iterator *vit;
+
+	tit = oval_definition_model_get_tests(model);
+	while (oval_test_iterator_has_more(tit)) {
+		struct oval_test *test = oval_test_iterator_next(tit);
+		struct oval_object *object = oval_test_get_object(test);
+		struct oval_state_iterator *sit;
+		bool has_state = false;
+
+		if (object == NULL)
+			continue;
+		oval_item_entities_get(map, object);
+		sit = oval_test_get_states(test);
+		while (oval_state_iterator_has_more(sit)) {
+			oval_item_entities_add_state(map, object, oval_state_iterator_next(sit));
+			has_state = true;
+		}
+		oval_state_iterator_free(sit);
+		oval_item_entities_add_test(map, object, test, has_state);
+	}
+	oval_test_iterator_free(tit);
+
+	oit = oval_definition_model_get_objects(model);
+	while (oval_object_iterator_has_more(oit)) {
+		struct oval_object *object = oval_object_iterator_next(oit);
+		struct oval_object_content_iterator *cit = oval_object_get_object_contents(object);
+
+		while (oval_object_content_iterator_has_more(cit)) {
+			struct oval_object_content *content = oval_object_content_iterator_next(cit);
+			struct oval_state *state;
+
+			switch (oval_object_content_get_type(content)) {
+			case OVAL_OBJECTCONTENT_FILTER:
+				state = oval_filter_get_state(oval_object_content_get_filter(content));
+				if (state != NULL)
+					oval_item_entities_add_state(map, object, state);
+				break;
+			case OVAL_OBJECTCONTENT_SET:
+				oval_item_entities_add_set(map, oval_object_content_get_setobject(content));
+				break;
+			default:
+				break;
+			}
+		}
+		oval_object_content_iterator_free(cit);
+	}
+	oval_object_iterator_free(oit);
+
+	vit = oval_definition_model_get_variables(model);
+	while (oval_variable_iterator_has_more(vit)) {
+		struct oval_variable *variable = oval_variable_iterator_next(vit);
+
+		if (oval_variable_get_type(variable) == OVAL_VARIABLE_LOCAL &&
+		    oval_variable_get_component(variable) != NULL)
+			oval_item_entities_add_component(map, oval_variable_get_component(variable));
+	}
+	oval_variable_iterator_free(vit);
+
+	return map;
+}
+
+/* called with item_entities_lock held */
+static struct oval_item_entities *oval_probe_session_lookup(oval_probe_session_t *sess, struct oval_object *object)
+{
+	/* built on the first use, the lazily loaded definitions are in by then */
+	if (sess->item_entities == NULL)
+		sess->item_entities = oval_item_entities_build(oval_syschar_model_get_definition_model(sess->sys_model));
+	return oval_string_map_get_value(sess->item_entities, oval_object_get_id(object));
+}
+
+const char *oval_probe_session_item_entities(oval_probe_session_t *sess, struct oval_object *object)
+{
+	struct oval_item_entities *ents;
+	const char *names = NULL;
+
+	if (!sess->referenced_entities_only || sess->sys_model == NULL)
+		return NULL;
+
+	pthread_mutex_lock(&sess->item_entities_lock);
+	ents = oval_probe_session_lookup(sess, object);
+	if (ents != NULL && !ents->all)
+		names = ents->names;
+	pthread_mutex_unlock(&sess->item_entities_lock);
+
+	return names;
+}
+
+uint32_t oval_probe_session_item_limit(oval_probe_session_t *sess, struct oval_object *object)
+{
+	struct oval_item_entities *ents;
+	uint32_t items = 0;
+
+	if (!sess->referenced_entities_only || sess->sys_model == NULL)
+		return 0;
+
+	pthread_mutex_lock(&sess->item_entities_lock);
+	ents = oval_probe_session_lookup(sess, object);
+	if (ents != NULL && !ents->all_items)
+		items = ents->items;
+	pthread_mutex_unlock(&sess->item_entities_lock);
+
+	return items;
+}
+
+static void oval_probe_session_sexp_free(void *ptr)
+{
+	SEXP_free(ptr);
+}
+
+static void oval_probe_session_varrefs_free(void *ptr)
+{
+	oval_string_map_free(ptr, NULL);
+}
+
+/*
+ * Look up the S-exp kept under the key, a new reference to it is returned.
+ */
+static SEXP_t *oval_probe_session_sexp_get(oval_probe_session_t *sess, const char *key)
+{
+	SEXP_t *sexp = NULL;
+
+	pthread_mutex_lock(&sess->memo_lock);
+	if (sess->sexps != NULL && (sexp = oval_string_map_get_value(sess->sexps, key)) != NULL)
+		sexp = SEXP_ref(sexp);
+	pthread_mutex_unlock(&sess->memo_lock);
+
+	return sexp;
+}
+
+static void oval_probe_session_sexp_put(oval_probe_session_t *sess, const char *key, SEXP_t *sexp)
+{
+	pthread_mutex_lock(&sess->memo_lock);
+	if (sess->sexps == NULL)
+		sess->sexps = oval_string_map_new();
+	/* made by another thread in the meantime, it is the same */
+	if (oval_string_map_get_value(sess->sexps, key) == NULL)
+		oval_string_map_put(sess->sexps, key, SEXP_ref(sexp));
+	pthread_mutex_unlock(&sess->memo_lock);
+}
+
+int oval_probe_session_object_sexp(oval_probe_session_t *sess, const char *typestr, struct oval_syschar *syschar, SEXP_t **out_sexp)
+{
+	struct oval_object *object = oval_syschar_get_object(syschar);
+	char *key;
+	int ret;
+
+	key = oscap_sprintf("o:%d:%s", oval_syschar_get_variable_instance(syschar), oval_object_get_id(object));
+	*out_sexp = oval_probe_session_sexp_get(sess, key);
+	if (*out_sexp != NULL) {
+		free(key);
+		return 0;
+	}
+
+	/*
+	 * The S-exp is made without the lock, the variables it references
+	 * may need objects collected through this session first.
+	 */
+	ret = oval_object_to_sexp(sess, typestr, syschar, out_sexp);
+
+	/* a skipped object has left its messages and flag in the syschar */
+	if (ret == 0 && !probe_obj_attrexists(*out_sexp, "skip_eval"))
+		oval_probe_session_sexp_put(sess, key, *out_sexp);
+	free(key);
+
+	return ret;
+}
+
+int oval_probe_session_state_sexp(oval_probe_session_t *sess, struct oval_state *state, SEXP_t **out_sexp)
+{
+	char *key;
+	int ret;
+
+	key = oscap_sprintf("s:%s", oval_state_get_id(state));
+	*out_sexp = oval_probe_session_sexp_get(sess, key);
+	if (*out_sexp != NULL) {
+		free(key);
+		return 0;
+	}
+
+	ret = oval_state_to_sexp(sess, state, out_sexp);
+	if (ret == 0)
+		oval_probe_session_sexp_put(sess, key, *out_sexp);
+	free(key);
+
+	return ret;
+}
+
+void oval_probe_session_forget_sexps(oval_probe_session_t *sess)
+{
+	pthread_mutex_lock(&sess->memo_lock);
+	oval_string_map_free(sess->sexps, oval_probe_session_sexp_free);
+	sess->sexps = NULL;
+	pthread_mutex_unlock(&sess->memo_lock);
+}
+
+/*
+ * The references depend only on the definitions, the map made for an
+ * object or state is kept for the whole session.
+ */
+static struct oval_string_map *oval_probe_session_varrefs_get(oval_probe_session_t *sess, const char *key,
+                                                              struct oval_object *object, struct oval_state *state)
+{
+	struct oval_string_map *vm;
+
+	pthread_mutex_lock(&sess->memo_lock);
+	if (sess->varrefs == NULL)
+		sess->varrefs = oval_string_map_new();
+	vm = oval_string_map_get_value(sess->varrefs, key);
+	if (vm == NULL) {
+		vm = oval_string_map_new();
+		if (object != NULL)
+			oval_obj_collect_var_refs(object, vm);
+		else
+			oval_ste_collect_var_refs(state, vm);
+		oval_string_map_put(sess->varrefs, key, vm);
+	}
+	pthread_mutex_unlock(&sess->memo_lock);
+
+	return vm;
+}
+
+struct oval_string_map *oval_probe_session_object_varrefs(oval_probe_session_t *sess, struct oval_object *object)
+{
+	char *key = oscap_sprintf("o:%s", oval_object_get_id(object));
+	struct oval_string_map *vm = oval_probe_session_varrefs_get(sess, key, object, NULL);
+
+	free(key);
+	return vm;
+}
+
+struct oval_string_map *oval_probe_session_state_varrefs(oval_probe_session_t *sess, struct oval_state *state)
+{
+	char *key = oscap_sprintf("s:%s", oval_state_get_id(state));
+	struct oval_string_map *vm = oval_probe_session_varrefs_get(sess, key, NULL, state);
+
+	free(key);
+	return vm;
+}
+
+/*
+ * Drop what the probes have read from the system, the objects collected
+ * next read it again.
+ */
+static void oval_probe_caches_flush(void)
+{
+	oval_probe_sysinfo_reset();
+	probe_memo_reset();
+#ifndef OS_WINDOWS
+	oval_fts_cache_reset();
+	oval_content_cache_reset();
+	oval_sysctl_cache_reset();
+#ifdef OVAL_PROBE_SYSTEMD_CACHE
+	systemd_cache_reset();
+#endif
+	oval_account_cache_reset();
+	oval_proc_cache_reset();
+	oval_net_cache_reset();
+	oval_realpath_cache_reset();
+#ifdef SELINUX_FOUND
+	oval_selinux_cache_reset();
+#endif
+#ifdef OVAL_PROBE_RPM_INDEX
+	rpm_index_invalidate();
+#endif
+#endif
+}
+
+/* the objects and states may be gone with the definitions */
+static void oval_probe_session_memo_reset(oval_probe_session_t *sess)
+{
+	pthread_mutex_lock(&sess->memo_lock);
+	oval_string_map_free(sess->sexps, oval_probe_session_sexp_free);
+	sess->sexps = NULL;
+	oval_string_map_free(sess->varrefs, oval_probe_session_varrefs_free);
+	sess->varrefs = NULL;
+	pthread_mutex_unlock(&sess->memo_lock);
+}
+
 static void oval_probe_session_free(oval_probe_session_t *sess)
 {
+	bool last;
+
 	if (sess == NULL) {
 		dE("Invalid session (NULL)");
 		return;
@@ -167,6 +669,21 @@ static void oval_probe_session_free(oval_probe_session_t *sess)
 
 	oval_phtbl_free(sess->ph);
 	oval_pext_free(sess->pext);
+	oval_string_map_free(sess->item_entities, oval_item_entities_free);
+	sess->item_entities = NULL;
+	oval_probe_session_memo_reset(sess);
+
+	pthread_mutex_lock(&oval_probe_sessions_lock);
+	last = --oval_probe_sessions_live == 0;
+	pthread_mutex_unlock(&oval_probe_sessions_lock);
+	/* other sessions may be scanning with the caches */
+	if (!last)
+		return;
+	/* the scan is over, don't answer the next one from stale metadata */
+	oval_probe_caches_flush();
+#ifndef OS_WINDOWS
+	oval_digest_cache_flush();
+#endif
 }
 
 void oval_probe_session_reinit(oval_probe_session_t *sess, struct oval_syschar_model *model)
@@ -179,6 +696,8 @@ void oval_probe_session_reinit(oval_probe_session_t *sess, struct oval_syschar_m
 void oval_probe_session_destroy(oval_probe_session_t *sess)
 {
 	oval_probe_session_free(sess);
+	pthread_mutex_destroy(&sess->item_entities_lock);
+	pthread_mutex_destroy(&sess->memo_lock);
 	free(sess);
 }
 
@@ -194,12 +713,31 @@ int oval_probe_session_reset(oval_probe_session_t *sess, struct oval_syschar_mod
         if (ph->func(OVAL_SUBTYPE_ALL, ph->uptr, PROBE_HANDLER_ACT_RESET) != 0) {
                 return(-1);
         }
+        oval_probe_caches_flush();
+#ifndef OS_WINDOWS
+        oval_digest_cache_flush();
+#endif
         if (sysch != NULL)
                 sess->sys_model = sysch;
+        pthread_mutex_lock(&sess->item_entities_lock);
+        oval_string_map_free(sess->item_entities, oval_item_entities_free);
+        sess->item_entities = NULL;
+        pthread_mutex_unlock(&sess->item_entities_lock);
+        oval_probe_session_memo_reset(sess);
 
         return(0);
 }
 
+void oval_probe_session_flush_caches(oval_probe_session_t *sess)
+{
+	if (sess == NULL) {
+		dE("Invalid session (NULL)");
+		return;
+	}
+
+	oval_probe_caches_flush();
+}
+
 int oval_probe_session_abort(oval_probe_session_t *sess)
 {
 	oval_ph_t *ph;
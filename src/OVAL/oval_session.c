@@ -35,6 +35,7 @@
 #endif
 
 #include "common/debug_priv.h"
+#include "common/profiling_priv.h"
 #include "common/util.h"
 #include "common/_error.h"
 #include "common/oscapxml.h"
@@ -55,6 +56,8 @@ struct oval_session {
 	struct oval_definition_model *def_model;
 	struct oval_variable_model *var_model;
 	struct oval_results_model *res_model;
+	/* recorded System Characteristics replayed instead of probing */
+	struct oval_syschar_model *sys_model;
 
 	oval_agent_session_t *sess;
 	struct ds_sds_session *sds_session;
@@ -63,6 +66,7 @@ struct oval_session {
 		struct oscap_source *definitions;
 		struct oscap_source *variables;
 		struct oscap_source *directives;
+		struct oscap_source *syschar;
 	} oval;
 
 	char *datastream_id;
@@ -137,6 +141,18 @@ void oval_session_set_directives(struct oval_session *session, const char *filen
 		session->oval.directives = NULL;
 }
 
+void oval_session_set_system_characteristics(struct oval_session *session, const char *filename)
+{
+	__attribute__nonnull__(session);
+
+	oscap_source_free(session->oval.syschar);
+
+	if (filename != NULL)
+		session->oval.syschar = oscap_source_new_from_file(filename);
+	else
+		session->oval.syschar = NULL;
+}
+
 void oval_session_set_validation(struct oval_session *session, bool validate, bool full_validation)
 {
 	__attribute__nonnull__(session);
@@ -291,7 +307,33 @@ static int oval_session_load_variables(struct oval_session *session)
 	return 0;
 }
 
-int oval_session_load(struct oval_session *session)
+static int oval_session_load_system_characteristics(struct oval_session *session)
+{
+	__attribute__nonnull__(session);
+
+	if (session->oval.syschar == NULL)
+		return 0;
+
+	if (session->validation && !oval_session_validate(session, session->oval.syschar, OSCAP_DOCUMENT_OVAL_SYSCHAR))
+		return 1;
+
+	if (session->sys_model != NULL) {
+		if (session->res_model != NULL)
+			oval_results_model_free(session->res_model);
+		session->res_model = NULL;
+		oval_syschar_model_free(session->sys_model);
+	}
+	session->sys_model = oval_syschar_model_new(session->def_model);
+	if (oval_syschar_model_import_source(session->sys_model, session->oval.syschar) != 0) {
+		oscap_seterr(OSCAP_EFAMILY_OVAL, "Failed to import the OVAL System Characteristics "
+				"from '%s'.", oscap_source_readable_origin(session->oval.syschar));
+		return 1;
+	}
+	dI("Loaded OVAL System Characteristics, the system won't be probed.");
+	return 0;
+}
+
+static int _oval_session_load(struct oval_session *session)
 {
 	__attribute__nonnull__(session);
 
@@ -303,6 +345,21 @@ int oval_session_load(struct oval_session *session)
 	if ((ret = oval_session_load_variables(session)) != 0) {
 		return ret;
 	}
+	if ((ret = oval_session_load_system_characteristics(session)) != 0) {
+		return ret;
+	}
+
+	return ret;
+}
+
+int oval_session_load(struct oval_session *session)
+{
+	struct oscap_profiling_mark mark;
+	int ret;
+
+	oscap_profiling_start(&mark);
+	ret = _oval_session_load(session);
+	oscap_profiling_stop(&mark, OSCAP_PROFILING_PHASE, "load", NULL, 0);
 
 	return ret;
 }
@@ -336,7 +393,72 @@ static int oval_session_setup_agent(struct oval_session *session)
 	return 0;
 }
 
-int oval_session_evaluate_id(struct oval_session *session, const char *id, oval_result_t *result)
+/*
+ * Results of the recorded System Characteristics, only the tests and the
+ * definitions are evaluated, nothing is collected.
+ */
+static struct oval_result_system *oval_session_setup_replay(struct oval_session *session)
+{
+	struct oval_syschar_model *sys_models[2] = { session->sys_model, NULL };
+	struct oval_result_system_iterator *systems;
+	struct oval_result_system *rsystem = NULL;
+	struct oval_generator *generator;
+
+	if (session->res_model == NULL) {
+		session->res_model = oval_results_model_new(session->def_model, sys_models);
+		generator = oval_results_model_get_generator(session->res_model);
+		oval_generator_set_product_name(generator, (char *)oscap_productname);
+		oval_generator_set_product_version(generator, oscap_get_version());
+	}
+
+	systems = oval_results_model_get_systems(session->res_model);
+	if (oval_result_system_iterator_has_more(systems))
+		rsystem = oval_result_system_iterator_next(systems);
+	oval_result_system_iterator_free(systems);
+	return rsystem;
+}
+
+static int oval_session_replay_id(struct oval_session *session, const char *id, oval_result_t *result)
+{
+	struct oval_result_system *rsystem = oval_session_setup_replay(session);
+	struct oval_result_definition *rdef;
+
+	if (rsystem == NULL || oval_result_system_eval_definition(rsystem, id) != 0)
+		return 1;
+	rdef = oval_result_system_get_definition(rsystem, id);
+	if (rdef == NULL) {
+		oscap_seterr(OSCAP_EFAMILY_OSCAP, "No definition with ID: %s in result model.", id);
+		return 1;
+	}
+	*result = oval_result_definition_get_result(rdef);
+	return 0;
+}
+
+static int oval_session_replay(struct oval_session *session, agent_reporter fn, void *arg)
+{
+	struct oval_result_system *rsystem = oval_session_setup_replay(session);
+	struct oval_definition_iterator *definitions;
+	int ret = 0;
+
+	if (rsystem == NULL)
+		return 1;
+
+	definitions = oval_definition_model_get_definitions(session->def_model);
+	while (ret == 0 && oval_definition_iterator_has_more(definitions)) {
+		const char *id = oval_definition_get_id(oval_definition_iterator_next(definitions));
+
+		if (oval_result_system_eval_definition(rsystem, id) != 0) {
+			ret = 1;
+			break;
+		}
+		if (fn != NULL && fn(oval_result_system_get_definition(rsystem, id), arg) != 0)
+			break;
+	}
+	oval_definition_iterator_free(definitions);
+	return ret;
+}
+
+static int _oval_session_evaluate_id(struct oval_session *session, const char *id, oval_result_t *result)
 {
 	__attribute__nonnull__(session);
 
@@ -345,6 +467,9 @@ int oval_session_evaluate_id(struct oval_session *session, const char *id, oval_
 		return 1;
 	}
 
+	if (session->sys_model != NULL)
+		return oval_session_replay_id(session, id, result);
+
 	if (oval_session_setup_agent(session) != 0) {
 		return 1;
 	}
@@ -361,10 +486,29 @@ int oval_session_evaluate_id(struct oval_session *session, const char *id, oval_
 	return 0;
 }
 
-int oval_session_evaluate(struct oval_session *session, agent_reporter fn, void *arg)
+int oval_session_evaluate_id(struct oval_session *session, const char *id, oval_result_t *result)
+{
+	struct oscap_profiling_mark mark;
+	int ret;
+
+	oscap_profiling_start(&mark);
+	ret = _oval_session_evaluate_id(session, id, result);
+	oscap_profiling_stop(&mark, OSCAP_PROFILING_PHASE, "evaluate", NULL, 0);
+
+	return ret;
+}
+
+static int _oval_session_evaluate(struct oval_session *session, agent_reporter fn, void *arg)
 {
 	__attribute__nonnull__(session);
 
+	if (session->sys_model != NULL) {
+		if (oval_session_replay(session, fn, arg) != 0 || oscap_err())
+			return 1;
+		dI("OVAL evaluation of the recorded System Characteristics finished.");
+		return 0;
+	}
+
 	if (oval_session_setup_agent(session) != 0) {
 		return 1;
 	}
@@ -380,7 +524,19 @@ int oval_session_evaluate(struct oval_session *session, agent_reporter fn, void
 	return 0;
 }
 
-int oval_session_export(struct oval_session *session)
+int oval_session_evaluate(struct oval_session *session, agent_reporter fn, void *arg)
+{
+	struct oscap_profiling_mark mark;
+	int ret;
+
+	oscap_profiling_start(&mark);
+	ret = _oval_session_evaluate(session, fn, arg);
+	oscap_profiling_stop(&mark, OSCAP_PROFILING_PHASE, "evaluate", NULL, 0);
+
+	return ret;
+}
+
+static int _oval_session_export(struct oval_session *session)
 {
 	__attribute__nonnull__(session);
 
@@ -447,6 +603,18 @@ cleanup:
 	return ret;
 }
 
+int oval_session_export(struct oval_session *session)
+{
+	struct oscap_profiling_mark mark;
+	int ret;
+
+	oscap_profiling_start(&mark);
+	ret = _oval_session_export(session);
+	oscap_profiling_stop(&mark, OSCAP_PROFILING_PHASE, "export", NULL, 0);
+
+	return ret;
+}
+
 void oval_session_set_export_system_characteristics(struct oval_session *session, bool export)
 {
 	session->export_sys_chars = export;
@@ -471,6 +639,7 @@ void oval_session_free(struct oval_session *session)
 
 	oscap_source_free(session->oval.directives);
 	oscap_source_free(session->oval.variables);
+	oscap_source_free(session->oval.syschar);
 	oscap_source_free(session->source);
 	free(session->datastream_id);
 	free(session->component_id);
@@ -478,6 +647,12 @@ void oval_session_free(struct oval_session *session)
 	free(session->export.report);
 	if (session->sess)
 		oval_agent_destroy_session(session->sess);
+	/* the Results of the agent session are freed with it */
+	if (session->sys_model != NULL) {
+		if (session->res_model != NULL)
+			oval_results_model_free(session->res_model);
+		oval_syschar_model_free(session->sys_model);
+	}
 	if (session->def_model)
 		oval_definition_model_free(session->def_model);
 	ds_sds_session_free(session->sds_session);
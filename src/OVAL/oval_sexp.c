@@ -44,6 +44,7 @@
 
 #include "oval_probe_impl.h"
 #include "oval_sexp.h"
+#include "_oval_probe_session.h"
 #include "probes/public/probe-api.h"
 #include "oval_definitions_impl.h"
 #include "oval_system_characteristics_impl.h"
@@ -425,7 +426,8 @@ int oval_object_to_sexp(void *sess, const char *typestr, struct oval_syschar *sy
 	struct oval_entity *entity;
 
 	char obj_name[128];
-	const char *obj_id;
+	const char *obj_id, *item_ents;
+	uint32_t item_limit;
 
 	object = oval_syschar_get_object(syschar);
 
@@ -441,9 +443,21 @@ int oval_object_to_sexp(void *sess, const char *typestr, struct oval_syschar *sy
 	// even though it returns const char* it has to be freed :-(
 	char *obj_over = (char*)oval_schema_version_to_cstr(oval_object_get_platform_schema_version(object));
 	obj_id   = oval_object_get_id(object);
-	obj_attr = probe_attr_creat("id", SEXP_string_new_r(&sm0, obj_id, strlen(obj_id)),
-	                            "oval_version", SEXP_string_new_r(&sm1, obj_over, strlen(obj_over)),
-	                            NULL);
+	/* the probes may skip the item entities not listed */
+	item_ents = sess != NULL ? oval_probe_session_item_entities(sess, object) : NULL;
+	if (item_ents != NULL) {
+		SEXP_t sm2;
+
+		obj_attr = probe_attr_creat("id", SEXP_string_new_r(&sm0, obj_id, strlen(obj_id)),
+		                            "oval_version", SEXP_string_new_r(&sm1, obj_over, strlen(obj_over)),
+		                            "item_entities", SEXP_string_new_r(&sm2, item_ents, strlen(item_ents)),
+		                            NULL);
+		SEXP_free_r(&sm2);
+	} else {
+		obj_attr = probe_attr_creat("id", SEXP_string_new_r(&sm0, obj_id, strlen(obj_id)),
+		                            "oval_version", SEXP_string_new_r(&sm1, obj_over, strlen(obj_over)),
+		                            NULL);
+	}
 	free(obj_over);
 
 	obj_sexp = probe_obj_new(obj_name, obj_attr);
@@ -452,6 +466,14 @@ int oval_object_to_sexp(void *sess, const char *typestr, struct oval_syschar *sy
 	SEXP_free_r(&sm1);
 	SEXP_free(obj_attr);
 
+	/* the probe may stop after the items which decide the tests */
+	if (sess != NULL && (item_limit = oval_probe_session_item_limit(sess, object)) > 0) {
+		SEXP_t *r3;
+
+		probe_item_attr_add(obj_sexp, "item_limit", r3 = SEXP_number_newu_32(item_limit));
+		SEXP_free(r3);
+	}
+
 	/*
 	 * Object content
 	 */
@@ -657,6 +679,7 @@ static struct oval_record_field *oval_record_field_ITEM_from_sexp(SEXP_t *sexp)
 {
 	struct oval_sysent *sysent;
 	struct oval_record_field *rf;
+	char buf[OVAL_SYSENT_VALUE_BUFSIZE];
 
 	sysent = oval_sexp_to_sysent(NULL, NULL, sexp, NULL);
 	if (sysent == NULL)
@@ -670,7 +693,7 @@ static struct oval_record_field *oval_record_field_ITEM_from_sexp(SEXP_t *sexp)
 	free(name_str);
 	SEXP_free(name_sexp);
 
-	oval_record_field_set_value(rf, oval_sysent_get_value(sysent));
+	oval_record_field_set_value(rf, (char *) oval_sysent_get_value_text(sysent, buf, sizeof(buf)));
 	oval_record_field_set_datatype(rf, oval_sysent_get_datatype(sysent));
 	oval_record_field_set_mask(rf, oval_sysent_get_mask(sysent));
 	oval_record_field_set_status(rf, oval_sysent_get_status(sysent));
@@ -881,36 +904,45 @@ static struct oval_sysent *oval_sexp_to_sysent(struct oval_syschar_model *model,
 		char val[64], *valp = val;
 		SEXP_t *sval;
 		SEXP_numtype_t sndt;
+		uint64_t u64;
 
 		sval = probe_ent_getval(sexp);
 		if (sval == NULL)
 			return ent;
 
+		/* integers and booleans are kept as numbers, the strings are taken as they are */
 		switch (dt) {
 		case OVAL_DATATYPE_BOOLEAN:
-			snprintf(val, sizeof(val), "%s", SEXP_number_getb(sval) ? "true" : "false");
+			oval_sysent_set_boolean(ent, SEXP_number_getb(sval));
+			valp = NULL;
 			break;
 		case OVAL_DATATYPE_FLOAT:
 			snprintf(val, sizeof(val), "%f", SEXP_number_getf(sval));
 			break;
 		case OVAL_DATATYPE_INTEGER:
 			sndt = SEXP_number_type(sval);
+			valp = NULL;
 			switch (sndt) {
 			case SEXP_NUM_INT8:
 			case SEXP_NUM_INT16:
 			case SEXP_NUM_INT32:
 			case SEXP_NUM_INT64:
-				snprintf(val, sizeof(val), "%" PRId64, SEXP_number_geti_64(sval));
+				oval_sysent_set_integer(ent, SEXP_number_geti_64(sval));
 				break;
 			case SEXP_NUM_UINT8:
 			case SEXP_NUM_UINT16:
 			case SEXP_NUM_UINT32:
 			case SEXP_NUM_UINT64:
-				snprintf(val, sizeof(val), "%" PRIu64, SEXP_number_getu_64(sval));
+				u64 = SEXP_number_getu_64(sval);
+				if (u64 <= INTMAX_MAX) {
+					oval_sysent_set_integer(ent, (intmax_t) u64);
+				} else {
+					snprintf(val, sizeof(val), "%" PRIu64, u64);
+					valp = val;
+				}
 				break;
 			default:
 				dE("Unexpected SEXP number datatype: %d, name: '%s'.", sndt, key);
-				valp = NULL;
 				break;
 			}
 			break;
@@ -920,7 +952,8 @@ static struct oval_sysent *oval_sexp_to_sysent(struct oval_syschar_model *model,
 		case OVAL_DATATYPE_IPV6ADDR:
 		case OVAL_DATATYPE_STRING:
 		case OVAL_DATATYPE_VERSION:
-			valp = SEXP_string_cstr(sval);
+			oval_sysent_take_value(ent, SEXP_string_cstr(sval));
+			valp = NULL;
 			break;
 		default:
 			dE("Unexpected OVAL datatype: %d, '%s', name: '%s'.",
@@ -929,9 +962,8 @@ static struct oval_sysent *oval_sexp_to_sysent(struct oval_syschar_model *model,
 			break;
 		}
 
-		oval_sysent_set_value(ent, valp);
-		if (valp != val)
-			free(valp);
+		if (valp != NULL)
+			oval_sysent_set_value(ent, valp);
                 SEXP_free(sval);
 	}
 
@@ -988,7 +1020,7 @@ static struct oval_sysitem *oval_sexp_to_sysitem(struct oval_syschar_model *mode
 
 	int status = probe_ent_getstatus(sexp);
 
-	sysitem = oval_sysitem_new(model, id);
+	sysitem = oval_sysitem_new_unbound(model, id);
 	oval_sysitem_set_status(sysitem, status);
 	oval_sysitem_set_subtype(sysitem, type);
 
@@ -998,13 +1030,38 @@ static struct oval_sysitem *oval_sexp_to_sysitem(struct oval_syschar_model *mode
 		SEXP_free(sub);
 	}
 
+	/*
+	 * The same item collected for other objects, by another probe or
+	 * after the item cache was dropped comes with another id, it is
+	 * stored once.
+	 */
+	sysitem = oval_syschar_model_intern_sysitem(model, sysitem);
+
  cleanup:
         free(id);
 	free(item_name);
 	return sysitem;
 }
 
-int oval_sexp_to_sysch(const SEXP_t *cobj, struct oval_syschar *syschar)
+static void oval_sexp_add_sysitem(struct oval_syschar *syschar, struct oval_syschar_model *model,
+				  SEXP_t *item, struct oval_string_map *itm_id_map,
+				  struct oval_string_map *item_mask_map)
+{
+	struct oval_sysitem *sysitem;
+
+	sysitem = oval_sexp_to_sysitem(model, item, item_mask_map);
+	if (sysitem != NULL) {
+		char *itm_id;
+
+		itm_id = oval_sysitem_get_id(sysitem);
+		if (oval_string_map_get_value(itm_id_map, itm_id) == NULL) {
+			oval_string_map_put(itm_id_map, itm_id, itm_id);
+			oval_syschar_add_sysitem(syschar, sysitem);
+		}
+	}
+}
+
+static int _oval_sexp_to_sysch(SEXP_t *cobj, struct oval_syschar *syschar, bool consume)
 {
 	oval_syschar_collection_flag_t flag;
 	SEXP_t *messages, *msg, *items, *item, *mask;
@@ -1044,21 +1101,28 @@ int oval_sexp_to_sysch(const SEXP_t *cobj, struct oval_syschar *syschar)
         } else
             item_mask_map = NULL;
 
-	SEXP_list_foreach(item, items) {
-		struct oval_sysitem *sysitem;
+	if (consume && items != NULL && SEXP_refs(items) == 2) {
+		SEXP_t *items_ref;
 
-		sysitem = oval_sexp_to_sysitem(model, item, item_mask_map);
-		if (sysitem != NULL) {
-			char *itm_id;
+		/*
+		 * Nobody else holds the item list. Take the items out of it
+		 * one by one so that every item and its list block can be
+		 * released as soon as the item is converted.
+		 */
+		SEXP_free(items);
+		items_ref = SEXP_listref_nth(cobj, 3);
 
-			itm_id = oval_sysitem_get_id(sysitem);
-			if (oval_string_map_get_value(itm_id_map, itm_id) == NULL) {
-				oval_string_map_put(itm_id_map, itm_id, itm_id);
-				oval_syschar_add_sysitem(syschar, sysitem);
-			}
+		while ((item = SEXP_list_pop(items_ref)) != NULL) {
+			oval_sexp_add_sysitem(syschar, model, item, itm_id_map, item_mask_map);
+			SEXP_free(item);
+		}
+		SEXP_free(items_ref);
+	} else {
+		SEXP_list_foreach(item, items) {
+			oval_sexp_add_sysitem(syschar, model, item, itm_id_map, item_mask_map);
 		}
+		SEXP_free(items);
 	}
-	SEXP_free(items);
 	oval_string_map_free(itm_id_map, NULL);
         if (item_mask_map != NULL)
             oval_string_map_free_string(item_mask_map);
@@ -1066,4 +1130,17 @@ int oval_sexp_to_sysch(const SEXP_t *cobj, struct oval_syschar *syschar)
 	return 0;
 }
 
+int oval_sexp_to_sysch(const SEXP_t *cobj, struct oval_syschar *syschar)
+{
+	return _oval_sexp_to_sysch((SEXP_t *)cobj, syschar, false);
+}
+
+int oval_sexp_to_sysch_consume(SEXP_t *cobj, struct oval_syschar *syschar)
+{
+	if (SEXP_refs(cobj) != 1)
+		return _oval_sexp_to_sysch(cobj, syschar, false);
+
+	return _oval_sexp_to_sysch(cobj, syschar, true);
+}
+
 /// @}
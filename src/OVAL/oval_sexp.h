@@ -52,6 +52,13 @@ int oval_state_to_sexp(void *sess, struct oval_state *state, SEXP_t **out_sexp);
  */
 int oval_sexp_to_sysch(const SEXP_t *cobj, struct oval_syschar *syschar);
 
+/*
+ * Same as oval_sexp_to_sysch, but the collected object may be emptied
+ * while it is converted to release the items early. Used when the caller
+ * is about to free an object it holds the only reference to.
+ */
+int oval_sexp_to_sysch_consume(SEXP_t *cobj, struct oval_syschar *syschar);
+
 #endif				/* OVAL_SEXP_H */
 
 /// @}
@@ -39,6 +39,7 @@
 #include "adt/oval_collection_impl.h"
 #include "oval_agent_api_impl.h"
 #include "common/util.h"
+#include "common/memtag_priv.h"
 #include "common/debug_priv.h"
 #include "common/elements.h"
 
@@ -146,6 +147,7 @@ struct oval_state *oval_state_new(struct oval_definition_model *model, const cha
 	oval_state_t *state;
 
 	state = (oval_state_t *) malloc(sizeof(oval_state_t));
+	oscap_memtag_alloc(OSCAP_MEMTAG_OVAL_MODEL, state, sizeof(oval_state_t));
 	if (state == NULL)
 		return NULL;
 
@@ -207,9 +209,27 @@ void oval_state_free(struct oval_state *state)
 	state->contents = NULL;
 	state->id = NULL;
 	state->notes = NULL;
+	oscap_memtag_free(OSCAP_MEMTAG_OVAL_MODEL, state, sizeof(oval_state_t));
 	free(state);
 }
 
+void oval_state_clear(struct oval_state *state)
+{
+	__attribute__nonnull__(state);
+
+	free(state->comment);
+	oval_collection_free_items(state->notes, &free);
+	oval_collection_free_items(state->contents, (oscap_destruct_func) oval_state_content_free);
+
+	state->deprecated = 0;
+	state->version = 0;
+	state->operator = OVAL_OPERATOR_UNKNOWN;
+	state->subtype = OVAL_SUBTYPE_UNKNOWN;
+	state->comment = NULL;
+	state->notes = oval_collection_new();
+	state->contents = oval_collection_new();
+}
+
 void oval_state_set_subtype(struct oval_state *state, oval_subtype_t subtype)
 {
 	__attribute__nonnull__(state);
@@ -39,6 +39,7 @@
 #include "adt/oval_collection_impl.h"
 #include "oval_agent_api_impl.h"
 #include "common/util.h"
+#include "common/memtag_priv.h"
 #include "common/debug_priv.h"
 #include "oval_schema_version.h"
 
@@ -117,6 +118,7 @@ struct oval_state_content *oval_state_content_new(struct oval_definition_model *
 {
 	oval_state_content_t *content = (oval_state_content_t *)
 	    malloc(sizeof(oval_state_content_t));
+	    oscap_memtag_alloc(OSCAP_MEMTAG_OVAL_MODEL, content, sizeof(oval_state_content_t));
 	if (content == NULL)
 		return NULL;
 
@@ -151,6 +153,7 @@ void oval_state_content_free(struct oval_state_content *content)
 		oval_entity_free(content->entity);
 	if (content->record_fields)
 		oval_collection_free_items(content->record_fields, (oscap_destruct_func) oval_record_field_free);
+	oscap_memtag_free(OSCAP_MEMTAG_OVAL_MODEL, content, sizeof(oval_state_content_t));
 	free(content);
 }
 
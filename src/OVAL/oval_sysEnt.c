@@ -34,6 +34,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <inttypes.h>
 
 #include "oval_agent_api_impl.h"
 #include "oval_system_characteristics_impl.h"
@@ -42,22 +43,51 @@
 #include "oval_definitions_impl.h"
 
 #include "common/util.h"
+#include "common/memtag_priv.h"
 #include "common/debug_priv.h"
 #include "common/elements.h"
 
+/*
+ * Form in which the value is kept. The probes report integers and booleans
+ * as numbers, these are stored as such and compared without parsing. Their
+ * text is made only when asked for by oval_sysent_get_value(), the export
+ * writes it from a buffer of the stack.
+ */
+typedef enum {
+	OVAL_SYSENT_TEXT = 0,		///< value is the allocated text
+	OVAL_SYSENT_INTEGER,		///< native.integer, value is its text once made
+	OVAL_SYSENT_BOOLEAN		///< native.boolean, value is a static "true" or "false"
+} oval_sysent_kind_t;
+
 typedef struct oval_sysent {
 	struct oval_syschar_model *model;
 	char *name;
 	char *value;
 	struct oval_collection *record_fields;
-	int mask;
+	union {
+		intmax_t integer;
+		bool boolean;
+	} native;
+	unsigned int mask:1;
+	unsigned int kind:2;
 	oval_datatype_t datatype;
 	oval_syschar_status_t status;
 } oval_sysent_t;
 
+static void _oval_sysent_free_value(struct oval_sysent *sysent)
+{
+	if (sysent->value != NULL && sysent->kind != OVAL_SYSENT_BOOLEAN) {
+		oscap_memtag_free(OSCAP_MEMTAG_SYSCHAR, sysent->value, strlen(sysent->value) + 1);
+		free(sysent->value);
+	}
+	sysent->value = NULL;
+	sysent->kind = OVAL_SYSENT_TEXT;
+}
+
 struct oval_sysent *oval_sysent_new(struct oval_syschar_model *model)
 {
 	oval_sysent_t *sysent = (oval_sysent_t *) malloc(sizeof(oval_sysent_t));
+	oscap_memtag_alloc(OSCAP_MEMTAG_SYSCHAR, sysent, sizeof(oval_sysent_t));
 	if (sysent == NULL)
 		return NULL;
 
@@ -67,6 +97,8 @@ struct oval_sysent *oval_sysent_new(struct oval_syschar_model *model)
 	sysent->status = SYSCHAR_STATUS_UNKNOWN;
 	sysent->datatype = OVAL_DATATYPE_UNKNOWN;
 	sysent->mask = 0;
+	sysent->kind = OVAL_SYSENT_TEXT;
+	sysent->native.integer = 0;
 	sysent->model = model;
 	return sysent;
 }
@@ -75,9 +107,17 @@ struct oval_sysent *oval_sysent_clone(struct oval_syschar_model *new_model, stru
 {
 	struct oval_sysent *new_item = oval_sysent_new(new_model);
 
-	char *old_value = oval_sysent_get_value(old_item);
-	if (old_value) {
-		oval_sysent_set_value(new_item, old_value);
+	switch (old_item->kind) {
+	case OVAL_SYSENT_INTEGER:
+		oval_sysent_set_integer(new_item, old_item->native.integer);
+		break;
+	case OVAL_SYSENT_BOOLEAN:
+		oval_sysent_set_boolean(new_item, old_item->native.boolean);
+		break;
+	default:
+		if (old_item->value != NULL)
+			oval_sysent_set_value(new_item, old_item->value);
+		break;
 	}
 
 	char *old_name = oval_sysent_get_name(old_item);
@@ -99,14 +139,13 @@ void oval_sysent_free(struct oval_sysent *sysent)
 
 	if (sysent->name != NULL)
 		free(sysent->name);
-	if (sysent->value != NULL)
-		free(sysent->value);
+	_oval_sysent_free_value(sysent);
 	if (sysent->record_fields)
 		oval_collection_free_items(sysent->record_fields, (oscap_destruct_func) oval_record_field_free);
 
 	sysent->name = NULL;
-	sysent->value = NULL;
 
+	oscap_memtag_free(OSCAP_MEMTAG_SYSCHAR, sysent, sizeof(oval_sysent_t));
 	free(sysent);
 }
 
@@ -145,9 +184,52 @@ char *oval_sysent_get_value(struct oval_sysent *sysent)
 {
 	__attribute__nonnull__(sysent);
 
+	if (sysent->kind == OVAL_SYSENT_INTEGER && sysent->value == NULL) {
+		char buf[OVAL_SYSENT_VALUE_BUFSIZE];
+		char *text;
+
+		snprintf(buf, sizeof(buf), "%" PRIdMAX, sysent->native.integer);
+		text = oscap_strdup(buf);
+		/* items are shared, another thread may have made the text already */
+		if (__sync_bool_compare_and_swap(&sysent->value, NULL, text))
+			oscap_memtag_alloc(OSCAP_MEMTAG_SYSCHAR, text, strlen(text) + 1);
+		else
+			free(text);
+	}
+	return sysent->value;
+}
+
+const char *oval_sysent_get_value_text(struct oval_sysent *sysent, char *buf, size_t size)
+{
+	__attribute__nonnull__(sysent);
+
+	if (sysent->kind == OVAL_SYSENT_INTEGER && sysent->value == NULL) {
+		snprintf(buf, size, "%" PRIdMAX, sysent->native.integer);
+		return buf;
+	}
 	return sysent->value;
 }
 
+bool oval_sysent_get_integer(struct oval_sysent *sysent, intmax_t *integer)
+{
+	__attribute__nonnull__(sysent);
+
+	if (sysent->kind != OVAL_SYSENT_INTEGER)
+		return false;
+	*integer = sysent->native.integer;
+	return true;
+}
+
+bool oval_sysent_get_boolean(struct oval_sysent *sysent, bool *boolean)
+{
+	__attribute__nonnull__(sysent);
+
+	if (sysent->kind != OVAL_SYSENT_BOOLEAN)
+		return false;
+	*boolean = sysent->native.boolean;
+	return true;
+}
+
 struct oval_record_field_iterator *oval_sysent_get_record_fields(struct oval_sysent *sysent)
 {
 	if (!sysent->record_fields)
@@ -194,15 +276,39 @@ void oval_sysent_set_datatype(struct oval_sysent *sysent, oval_datatype_t dataty
 void oval_sysent_set_mask(struct oval_sysent *sysent, int mask)
 {
 	__attribute__nonnull__(sysent);
-	sysent->mask = mask;
+	sysent->mask = mask ? 1 : 0;
 }
 
 void oval_sysent_set_value(struct oval_sysent *sysent, char *value)
 {
 	__attribute__nonnull__(sysent);
-	if (sysent->value != NULL)
-		free(sysent->value);
-	sysent->value = oscap_strdup(value);
+	oval_sysent_take_value(sysent, oscap_strdup(value));
+}
+
+void oval_sysent_take_value(struct oval_sysent *sysent, char *value)
+{
+	__attribute__nonnull__(sysent);
+	_oval_sysent_free_value(sysent);
+	sysent->value = value;
+	if (value != NULL)
+		oscap_memtag_alloc(OSCAP_MEMTAG_SYSCHAR, value, strlen(value) + 1);
+}
+
+void oval_sysent_set_integer(struct oval_sysent *sysent, intmax_t integer)
+{
+	__attribute__nonnull__(sysent);
+	_oval_sysent_free_value(sysent);
+	sysent->kind = OVAL_SYSENT_INTEGER;
+	sysent->native.integer = integer;
+}
+
+void oval_sysent_set_boolean(struct oval_sysent *sysent, bool boolean)
+{
+	__attribute__nonnull__(sysent);
+	_oval_sysent_free_value(sysent);
+	sysent->kind = OVAL_SYSENT_BOOLEAN;
+	sysent->native.boolean = boolean;
+	sysent->value = (char *) (boolean ? "true" : "false");
 }
 
 void oval_sysent_add_record_field(struct oval_sysent *sysent, struct oval_record_field *rf)
@@ -280,8 +386,9 @@ void oval_sysent_to_dom(struct oval_sysent *sysent, xmlDoc * doc, xmlNode * pare
 	xmlNodePtr root_node = xmlDocGetRootElement(doc);
 	xmlNode *sysent_tag = NULL;
 
+	char buf[OVAL_SYSENT_VALUE_BUFSIZE];
 	char *tagname = oval_sysent_get_name(sysent);
-	char *content = oval_sysent_get_value(sysent);
+	const char *content = oval_sysent_get_value_text(sysent, buf, sizeof(buf));
 	bool mask = oval_sysent_get_mask(sysent);
 
 	/* omit the value in oval_results if mask=true */
@@ -31,6 +31,7 @@
 #include <config.h>
 #endif
 
+#include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -40,6 +41,7 @@
 #include "adt/oval_collection_impl.h"
 #include "oval_definitions_impl.h"
 #include "common/util.h"
+#include "common/memtag_priv.h"
 #include "common/debug_priv.h"
 
 typedef struct oval_sysitem {
@@ -52,12 +54,13 @@ typedef struct oval_sysitem {
 	oval_syschar_status_t status;
 } oval_sysitem_t;				///< Represents a single <*_item> element
 
-struct oval_sysitem *oval_sysitem_new(struct oval_syschar_model *model, const char *id)
+struct oval_sysitem *oval_sysitem_new_unbound(struct oval_syschar_model *model, const char *id)
 {
 	__attribute__nonnull__(model);
 	oval_sysitem_t *sysitem;
 
 	sysitem = (oval_sysitem_t *) malloc(sizeof(oval_sysitem_t));
+	oscap_memtag_alloc(OSCAP_MEMTAG_SYSCHAR, sysitem, sizeof(oval_sysitem_t));
 	if (sysitem == NULL)
 		return NULL;
 
@@ -68,7 +71,15 @@ struct oval_sysitem *oval_sysitem_new(struct oval_syschar_model *model, const ch
 	sysitem->sysents = oval_collection_new();
 	sysitem->model = model;
 
-	oval_syschar_model_add_sysitem(model, sysitem);
+	return sysitem;
+}
+
+struct oval_sysitem *oval_sysitem_new(struct oval_syschar_model *model, const char *id)
+{
+	struct oval_sysitem *sysitem = oval_sysitem_new_unbound(model, id);
+
+	if (sysitem != NULL)
+		oval_syschar_model_add_sysitem(model, sysitem);
 
 	return sysitem;
 }
@@ -111,6 +122,7 @@ void oval_sysitem_free(struct oval_sysitem *sysitem)
 	sysitem->id = NULL;
 	sysitem->sysents = NULL;
 	sysitem->messages = NULL;
+	oscap_memtag_free(OSCAP_MEMTAG_SYSCHAR, sysitem, sizeof(oval_sysitem_t));
 	free(sysitem);
 }
 
@@ -189,6 +201,135 @@ void oval_sysitem_set_status(struct oval_sysitem *data, oval_syschar_status_t st
 	data->status = status;
 }
 
+/* FNV-1a, the terminating zero separates the strings */
+static uint64_t _oval_sysitem_hash_str(uint64_t hash, const char *str)
+{
+	if (str != NULL) {
+		for (; *str != '\0'; ++str)
+			hash = (hash ^ (unsigned char)*str) * UINT64_C(0x100000001b3);
+	}
+	return hash * UINT64_C(0x100000001b3);
+}
+
+static uint64_t _oval_sysitem_hash_int(uint64_t hash, int value)
+{
+	return (hash ^ (uint64_t)(unsigned int)value) * UINT64_C(0x100000001b3);
+}
+
+uint64_t oval_sysitem_hash(struct oval_sysitem *sysitem)
+{
+	uint64_t hash = UINT64_C(0xcbf29ce484222325);
+	struct oval_sysent_iterator *sysents;
+	struct oval_message_iterator *messages;
+
+	hash = _oval_sysitem_hash_int(hash, sysitem->subtype);
+	hash = _oval_sysitem_hash_int(hash, sysitem->status);
+
+	sysents = oval_sysitem_get_sysents(sysitem);
+	while (oval_sysent_iterator_has_more(sysents)) {
+		struct oval_sysent *sysent = oval_sysent_iterator_next(sysents);
+		struct oval_record_field_iterator *fields;
+		char buf[OVAL_SYSENT_VALUE_BUFSIZE];
+
+		hash = _oval_sysitem_hash_str(hash, oval_sysent_get_name(sysent));
+		hash = _oval_sysitem_hash_str(hash, oval_sysent_get_value_text(sysent, buf, sizeof(buf)));
+		hash = _oval_sysitem_hash_int(hash, oval_sysent_get_datatype(sysent));
+
+		fields = oval_sysent_get_record_fields(sysent);
+		while (oval_record_field_iterator_has_more(fields)) {
+			struct oval_record_field *rf = oval_record_field_iterator_next(fields);
+
+			hash = _oval_sysitem_hash_str(hash, oval_record_field_get_name(rf));
+			hash = _oval_sysitem_hash_str(hash, oval_record_field_get_value(rf));
+		}
+		oval_record_field_iterator_free(fields);
+	}
+	oval_sysent_iterator_free(sysents);
+
+	messages = oval_sysitem_get_messages(sysitem);
+	while (oval_message_iterator_has_more(messages))
+		hash = _oval_sysitem_hash_str(hash, oval_message_get_text(oval_message_iterator_next(messages)));
+	oval_message_iterator_free(messages);
+
+	return hash;
+}
+
+static bool _oval_sysitem_str_equal(const char *a, const char *b)
+{
+	return a == b || (a != NULL && b != NULL && strcmp(a, b) == 0);
+}
+
+static bool _oval_sysitem_fields_equal(struct oval_sysent *a, struct oval_sysent *b)
+{
+	struct oval_record_field_iterator *ait = oval_sysent_get_record_fields(a);
+	struct oval_record_field_iterator *bit = oval_sysent_get_record_fields(b);
+	bool equal = true;
+
+	while (equal && oval_record_field_iterator_has_more(ait) && oval_record_field_iterator_has_more(bit)) {
+		struct oval_record_field *arf = oval_record_field_iterator_next(ait);
+		struct oval_record_field *brf = oval_record_field_iterator_next(bit);
+
+		equal = _oval_sysitem_str_equal(oval_record_field_get_name(arf), oval_record_field_get_name(brf)) &&
+			_oval_sysitem_str_equal(oval_record_field_get_value(arf), oval_record_field_get_value(brf)) &&
+			oval_record_field_get_datatype(arf) == oval_record_field_get_datatype(brf) &&
+			oval_record_field_get_mask(arf) == oval_record_field_get_mask(brf) &&
+			oval_record_field_get_status(arf) == oval_record_field_get_status(brf);
+	}
+	if (equal)
+		equal = !oval_record_field_iterator_has_more(ait) && !oval_record_field_iterator_has_more(bit);
+	oval_record_field_iterator_free(ait);
+	oval_record_field_iterator_free(bit);
+
+	return equal;
+}
+
+bool oval_sysitem_equal(struct oval_sysitem *a, struct oval_sysitem *b)
+{
+	struct oval_sysent_iterator *ait, *bit;
+	struct oval_message_iterator *amit, *bmit;
+	bool equal;
+
+	if (a->subtype != b->subtype || a->status != b->status)
+		return false;
+
+	equal = true;
+	ait = oval_sysitem_get_sysents(a);
+	bit = oval_sysitem_get_sysents(b);
+	while (equal && oval_sysent_iterator_has_more(ait) && oval_sysent_iterator_has_more(bit)) {
+		struct oval_sysent *aent = oval_sysent_iterator_next(ait);
+		struct oval_sysent *bent = oval_sysent_iterator_next(bit);
+		char abuf[OVAL_SYSENT_VALUE_BUFSIZE], bbuf[OVAL_SYSENT_VALUE_BUFSIZE];
+
+		equal = _oval_sysitem_str_equal(oval_sysent_get_name(aent), oval_sysent_get_name(bent)) &&
+			_oval_sysitem_str_equal(oval_sysent_get_value_text(aent, abuf, sizeof(abuf)),
+						oval_sysent_get_value_text(bent, bbuf, sizeof(bbuf))) &&
+			oval_sysent_get_datatype(aent) == oval_sysent_get_datatype(bent) &&
+			oval_sysent_get_mask(aent) == oval_sysent_get_mask(bent) &&
+			oval_sysent_get_status(aent) == oval_sysent_get_status(bent) &&
+			_oval_sysitem_fields_equal(aent, bent);
+	}
+	if (equal)
+		equal = !oval_sysent_iterator_has_more(ait) && !oval_sysent_iterator_has_more(bit);
+	oval_sysent_iterator_free(ait);
+	oval_sysent_iterator_free(bit);
+
+	amit = oval_sysitem_get_messages(a);
+	bmit = oval_sysitem_get_messages(b);
+	while (equal && oval_message_iterator_has_more(amit) && oval_message_iterator_has_more(bmit)) {
+		struct oval_message *am = oval_message_iterator_next(amit);
+		struct oval_message *bm = oval_message_iterator_next(bmit);
+
+		equal = oval_message_get_level(am) == oval_message_get_level(bm) &&
+			_oval_sysitem_str_equal(oval_message_get_text(am), oval_message_get_text(bm));
+	}
+	if (equal)
+		equal = !oval_message_iterator_has_more(amit) && !oval_message_iterator_has_more(bmit);
+	oval_message_iterator_free(amit);
+	oval_message_iterator_free(bmit);
+
+	return equal;
+}
+
 static void _oval_sysitem_parse_subtag_message_consumer(struct oval_message *message, void *sysitem)
 {
 	oval_sysitem_add_message(sysitem, message);
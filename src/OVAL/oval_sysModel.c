@@ -32,6 +32,8 @@
 #include <config.h>
 #endif
 
+#include <inttypes.h>
+#include <stdio.h>
 #include <string.h>
 #include <time.h>
 
@@ -59,9 +61,37 @@ typedef struct oval_syschar_model {
 	struct oval_definition_model *definition_model;
 	struct oval_smc *syschar_map;				///< Represents objects within <collected_objects> element
 	struct oval_string_map *sysitem_map;			///< Represents items within <system_data> element
+	struct oval_string_map *sysitem_index;			///< Content hash of the items -> oval_sysitem_bucket
+	struct oval_string_map *sysitem_alias;			///< Ids of the items which were equal to a stored item
         char *schema;
 } oval_syschar_model_t;						///< Represents <oval_system_characteristics> element
 
+/* items of the same content hash */
+struct oval_sysitem_bucket {
+	struct oval_sysitem *sysitem;
+	struct oval_sysitem_bucket *next;
+};
+
+static void oval_sysitem_bucket_free(struct oval_sysitem_bucket *bucket)
+{
+	while (bucket != NULL) {
+		struct oval_sysitem_bucket *next = bucket->next;
+
+		free(bucket);
+		bucket = next;
+	}
+}
+
+static void _oval_syschar_model_free_items(struct oval_syschar_model *model)
+{
+	if (model->sysitem_map)
+		oval_string_map_free(model->sysitem_map, (oscap_destruct_func) oval_sysitem_free);
+	oval_string_map_free(model->sysitem_index, (oscap_destruct_func) oval_sysitem_bucket_free);
+	oval_string_map_free(model->sysitem_alias, NULL);
+	model->sysitem_index = NULL;
+	model->sysitem_alias = NULL;
+}
+
 
 /* failed   - NULL
  * success  - oval_syschar_model
@@ -80,6 +110,8 @@ struct oval_syschar_model *oval_syschar_model_new(struct oval_definition_model *
 	newmodel->definition_model = definition_model;
 	newmodel->syschar_map = oval_smc_new();
 	newmodel->sysitem_map = oval_string_map_new();
+	newmodel->sysitem_index = NULL;
+	newmodel->sysitem_alias = NULL;
         newmodel->schema = oscap_strdup(OVAL_SYS_SCHEMA_LOCATION);
 
 	/* check possible allocation problems */
@@ -141,8 +173,7 @@ void oval_syschar_model_free(struct oval_syschar_model *model)
 	if (model != NULL) {
 		oval_sysinfo_free(model->sysinfo);
 		oval_smc_free(model->syschar_map, (oscap_destruct_func) oval_syschar_free);
-		if (model->sysitem_map)
-			oval_string_map_free(model->sysitem_map, (oscap_destruct_func) oval_sysitem_free);
+		_oval_syschar_model_free_items(model);
 		free(model->schema);
 		oval_generator_free(model->generator);
 		free(model);
@@ -153,8 +184,7 @@ void oval_syschar_model_reset(struct oval_syschar_model *model)
 {
         if (model->syschar_map)
                 oval_smc_free(model->syschar_map, (oscap_destruct_func) oval_syschar_free);
-        if (model->sysitem_map)
-                oval_string_map_free(model->sysitem_map, (oscap_destruct_func) oval_sysitem_free);
+        _oval_syschar_model_free_items(model);
         model->syschar_map = oval_smc_new();
         model->sysitem_map = oval_string_map_new();
 }
@@ -242,6 +272,7 @@ int oval_syschar_model_import_source(struct oval_syschar_model *model, struct os
         context.definition_model = oval_syschar_model_get_definition_model(model);
         context.syschar_model = model;
         context.user_data = NULL;
+        context.id_filter = NULL;
 
 	/* jump into oval_system_characteristics */
 	xmlTextReaderRead(context.reader);
@@ -281,8 +312,53 @@ struct oval_syschar *oval_syschar_model_get_syschar(struct oval_syschar_model *m
 struct oval_sysitem *oval_syschar_model_get_sysitem(struct oval_syschar_model *model, const char *id)
 {
 	__attribute__nonnull__(model);
+	struct oval_sysitem *sysitem;
+
+	sysitem = (struct oval_sysitem *)oval_string_map_get_value(model->sysitem_map, id);
+	if (sysitem == NULL && model->sysitem_alias != NULL)
+		sysitem = (struct oval_sysitem *)oval_string_map_get_value(model->sysitem_alias, id);
+
+	return sysitem;
+}
+
+struct oval_sysitem *oval_syschar_model_intern_sysitem(struct oval_syschar_model *model, struct oval_sysitem *sysitem)
+{
+	__attribute__nonnull__(model);
+	struct oval_sysitem_bucket *head, *bucket;
+	char key[17];
+
+	snprintf(key, sizeof key, "%016" PRIx64, oval_sysitem_hash(sysitem));
+	if (model->sysitem_index == NULL) {
+		model->sysitem_index = oval_string_map_new();
+		model->sysitem_alias = oval_string_map_new();
+	}
+
+	head = oval_string_map_get_value(model->sysitem_index, key);
+	for (bucket = head; bucket != NULL; bucket = bucket->next) {
+		if (oval_sysitem_equal(bucket->sysitem, sysitem)) {
+			/* the next item with this id is the stored one right away */
+			oval_string_map_put(model->sysitem_alias, oval_sysitem_get_id(sysitem), bucket->sysitem);
+			oval_sysitem_free(sysitem);
+			return bucket->sysitem;
+		}
+	}
 
-	return (struct oval_sysitem *)oval_string_map_get_value(model->sysitem_map, id);
+	oval_syschar_model_add_sysitem(model, sysitem);
+
+	bucket = malloc(sizeof(struct oval_sysitem_bucket));
+	if (bucket == NULL)
+		return sysitem;
+	bucket->sysitem = sysitem;
+	if (head == NULL) {
+		bucket->next = NULL;
+		oval_string_map_put(model->sysitem_index, key, bucket);
+	} else {
+		/* the map keeps the head, the new item goes second */
+		bucket->next = head->next;
+		head->next = bucket;
+	}
+
+	return sysitem;
 }
 
 
@@ -368,6 +444,7 @@ xmlNode *oval_syschar_model_to_dom(struct oval_syschar_model * syschar_model, xm
 			    || oval_object_get_base_obj(object)) /* Skip internal objects */
 				continue;
 			oval_syschar_to_dom(syschar, doc, tag_objects);
+			oscap_xml_stream_flush(doc, tag_objects);
 			struct oval_sysitem_iterator *sysitems = oval_syschar_get_sysitem(syschar);
 			while (oval_sysitem_iterator_has_more(sysitems)) {
 				struct oval_sysitem *sysitem = oval_sysitem_iterator_next(sysitems);
@@ -386,6 +463,7 @@ xmlNode *oval_syschar_model_to_dom(struct oval_syschar_model * syschar_model, xm
 			struct oval_sysitem *sysitem = (struct oval_sysitem *)
 			    oval_collection_iterator_next(sysitems);
 			oval_sysitem_to_dom(sysitem, doc, tag_items);
+			oscap_xml_stream_flush(doc, tag_items);
 		}
 	}
 	oval_collection_iterator_free(sysitems);
@@ -407,7 +485,15 @@ int oval_syschar_model_export(struct oval_syschar_model *model, const char *file
 		return -1;
 	}
 
+	/* The system characteristics are written as they are built */
+	struct oscap_xml_stream *stream = oscap_xml_stream_new(file, doc);
+	if (stream == NULL) {
+		xmlFreeDoc(doc);
+		return -1;
+	}
 	oval_syschar_model_to_dom(model, doc, NULL, NULL, NULL, true);
-	return oscap_xml_save_filename_free(file, doc);
+	int ret = oscap_xml_stream_finish(stream);
+	xmlFreeDoc(doc);
+	return ret == 0 ? 1 : -1;
 }
 
@@ -42,6 +42,7 @@
 #include "oval_definitions_impl.h"
 
 #include "common/util.h"
+#include "common/memtag_priv.h"
 #include "common/debug_priv.h"
 
 typedef struct oval_syschar {
@@ -146,6 +147,7 @@ struct oval_syschar *oval_syschar_new(struct oval_syschar_model *model, struct o
 	oval_syschar_t *syschar;
 
 	syschar = (oval_syschar_t *) malloc(sizeof(oval_syschar_t));
+	oscap_memtag_alloc(OSCAP_MEMTAG_SYSCHAR, syschar, sizeof(oval_syschar_t));
 	if (syschar == NULL)
 		return NULL;
 
@@ -223,6 +225,7 @@ void oval_syschar_free(struct oval_syschar *syschar)
 	syschar->object = NULL;
 	syschar->sysitem = NULL;
 	syschar->variable_bindings = NULL;
+	oscap_memtag_free(OSCAP_MEMTAG_SYSCHAR, syschar, sizeof(oval_syschar_t));
 	free(syschar);
 }
 
@@ -31,6 +31,7 @@
 #ifndef OVAL_SYSCHAR_IMPL
 #define OVAL_SYSCHAR_IMPL
 
+#include <stdint.h>
 #include "public/oval_system_characteristics.h"
 #include "oval_parser_impl.h"
 #include "adt/oval_smc_impl.h"
@@ -49,6 +50,11 @@ int oval_sysinfo_parse_tag(xmlTextReaderPtr reader, struct oval_parser_context *
 /* sysitem */
 void oval_sysitem_to_dom(struct oval_sysitem *, xmlDoc *, xmlNode *);
 int oval_sysitem_parse_tag(xmlTextReaderPtr, struct oval_parser_context *, void *usr);
+/* an item which is not in the model yet, see oval_syschar_model_intern_sysitem() */
+struct oval_sysitem *oval_sysitem_new_unbound(struct oval_syschar_model *model, const char *id);
+/* hash and equality of the content, i.e. everything but the id */
+uint64_t oval_sysitem_hash(struct oval_sysitem *sysitem);
+bool oval_sysitem_equal(struct oval_sysitem *a, struct oval_sysitem *b);
 
 /* syschar */
 void oval_syschar_to_dom(struct oval_syschar *, xmlDoc *, xmlNode *);
@@ -62,6 +68,18 @@ typedef void (*oval_sysent_consumer) (struct oval_sysent *, void *client);
 int oval_sysent_parse_tag(xmlTextReaderPtr, struct oval_parser_context *, oval_sysent_consumer, void *);
 void oval_sysent_to_dom(struct oval_sysent *sysent, xmlDoc * doc, xmlNode * tag_parent);
 void oval_sysent_to_print(struct oval_sysent *, char *, int);
+/* like oval_sysent_set_value() but the value is taken, not copied */
+void oval_sysent_take_value(struct oval_sysent *sysent, char *value);
+/* values kept as numbers, oval_sysent_get_value() makes their text on demand */
+void oval_sysent_set_integer(struct oval_sysent *sysent, intmax_t integer);
+void oval_sysent_set_boolean(struct oval_sysent *sysent, bool boolean);
+/* false if the value isn't kept as the number asked for */
+bool oval_sysent_get_integer(struct oval_sysent *sysent, intmax_t *integer);
+bool oval_sysent_get_boolean(struct oval_sysent *sysent, bool *boolean);
+/* large enough for the text of any value kept as a number */
+#define OVAL_SYSENT_VALUE_BUFSIZE 32
+/* the value's text, written to buf instead of being allocated if it isn't made yet */
+const char *oval_sysent_get_value_text(struct oval_sysent *sysent, char *buf, size_t size);
 
 /* syschar_model */
 typedef bool oval_syschar_resolver(struct oval_syschar *, void *);
@@ -72,6 +90,12 @@ struct oval_syschar *oval_syschar_model_get_new_syschar(struct oval_syschar_mode
 struct oval_sysitem *oval_syschar_model_get_new_sysitem(struct oval_syschar_model *, const char *id);
 void oval_syschar_model_add_syschar(struct oval_syschar_model *model, struct oval_syschar *syschar);
 void oval_syschar_model_add_sysitem(struct oval_syschar_model *model, struct oval_sysitem *sysitem);
+/**
+ * Store an unbound item in the model unless an equal one is there already.
+ * Then the given item is freed and its id refers to the stored one.
+ * @return the item stored in the model
+ */
+struct oval_sysitem *oval_syschar_model_intern_sysitem(struct oval_syschar_model *model, struct oval_sysitem *sysitem);
 
 void oval_syschar_model_set_schema(struct oval_syschar_model *model, const char * schema);
 const char * oval_syschar_model_get_schema(struct oval_syschar_model * model);
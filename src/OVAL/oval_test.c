@@ -41,6 +41,7 @@
 #include "oval_agent_api_impl.h"
 #include "common/oscap_string.h"
 #include "common/util.h"
+#include "common/memtag_priv.h"
 #include "common/debug_priv.h"
 #include "common/elements.h"
 #include "common/_error.h"
@@ -194,6 +195,7 @@ struct oval_test *oval_test_new(struct oval_definition_model *model, const char
 	oval_test_t *test;
 
 	test = (oval_test_t *) malloc(sizeof(oval_test_t));
+	oscap_memtag_alloc(OSCAP_MEMTAG_OVAL_MODEL, test, sizeof(oval_test_t));
 	if (test == NULL)
 		return NULL;
 
@@ -265,9 +267,30 @@ void oval_test_free(struct oval_test *test)
 	oval_collection_free_items(test->notes, free);
 	oval_collection_free(test->states);
 
+	oscap_memtag_free(OSCAP_MEMTAG_OVAL_MODEL, test, sizeof(oval_test_t));
 	free(test);
 }
 
+void oval_test_clear(struct oval_test *test)
+{
+	__attribute__nonnull__(test);
+
+	free(test->comment);
+	oval_collection_free_items(test->notes, free);
+	oval_collection_free(test->states);
+
+	test->deprecated = 0;
+	test->version = 0;
+	test->check = OVAL_CHECK_UNKNOWN;
+	test->existence = OVAL_EXISTENCE_UNKNOWN;
+	test->state_operator = OVAL_OPERATOR_AND;
+	test->subtype = OVAL_SUBTYPE_UNKNOWN;
+	test->comment = NULL;
+	test->object = NULL;
+	test->states = oval_collection_new();
+	test->notes = oval_collection_new();
+}
+
 void oval_test_set_deprecated(struct oval_test *test, bool deprecated)
 {
 	__attribute__nonnull__(test);
@@ -39,6 +39,7 @@
 #include "oval_definitions_impl.h"
 #include "adt/oval_collection_impl.h"
 #include "common/util.h"
+#include "common/memtag_priv.h"
 #include "common/debug_priv.h"
 #include "common/elements.h"
 
@@ -119,6 +120,7 @@ long long oval_value_get_integer(struct oval_value *value)
 struct oval_value *oval_value_new(oval_datatype_t datatype, char *text_value)
 {
 	oval_value_t *value = (oval_value_t *) malloc(sizeof(oval_value_t));
+	oscap_memtag_alloc(OSCAP_MEMTAG_OVAL_MODEL, value, sizeof(oval_value_t));
 	if (value == NULL)
 		return NULL;
 
@@ -142,6 +144,7 @@ void oval_value_free(struct oval_value *value)
         return;
 
     free(value->text);
+    oscap_memtag_free(OSCAP_MEMTAG_OVAL_MODEL, value, sizeof(oval_value_t));
     free(value);
 }
 
@@ -284,6 +284,7 @@ static int _oval_variable_model_parse(struct oval_variable_model *model, xmlText
 	context.variable_model = model;
 	context.reader = reader;
 	context.user_data = user_param;
+	context.id_filter = NULL;
 	char *tagname = (char *)xmlTextReaderLocalName(reader);
 	char *namespace = (char *)xmlTextReaderNamespaceUri(reader);
 	bool is_variables = (oscap_strcmp(NAMESPACE_VARIABLES, namespace) == 0) && (oscap_strcmp(OVAL_ROOT_ELM_VARIABLES, tagname) == 0);
@@ -25,6 +25,7 @@
 #endif
 
 #include "oval_definitions_impl.h"
+#include "collectVarRefs_impl.h"
 
 static void _oval_definition_fill_vardef(struct oval_definition *definition, struct oval_string_map *vardef);
 static void _oval_criteria_fill_vardef(struct oval_criteria_node *cnode, struct oval_string_map *vardef, const char *definition_id);
@@ -172,8 +173,16 @@ void _oval_entity_fill_vardef(struct oval_entity *entity, struct oval_string_map
 	if (oval_entity_get_varref_type(entity) == OVAL_ENTITY_VARREF_ATTRIBUTE ||
 		oval_entity_get_varref_type(entity) == OVAL_ENTITY_VARREF_ELEMENT) {
 		struct oval_variable *variable = oval_entity_get_variable(entity);
-		if (variable != NULL)
-			_vardef_insert(vardef, definition_id, oval_variable_get_id(variable));
+		if (variable != NULL) {
+			/* The definition depends also on the variables used to compute this one */
+			struct oval_string_map *vm = oval_string_map_new();
+			oval_var_collect_var_refs(variable, vm);
+			struct oval_string_iterator *var_it = (struct oval_string_iterator *) oval_string_map_keys(vm);
+			while (oval_string_iterator_has_more(var_it))
+				_vardef_insert(vardef, definition_id, oval_string_iterator_next(var_it));
+			oval_string_iterator_free(var_it);
+			oval_string_map_free(vm, NULL);
+		}
 	}
 }
 
@@ -186,3 +195,28 @@ void _vardef_insert(struct oval_string_map *vardef, const char *definition_id, c
 	}
 	oval_string_map_put(def_list, definition_id, (void *) "");
 }
+
+struct oval_string_map *oval_definition_model_build_varobj_mapping(struct oval_definition_model *model)
+{
+	struct oval_string_map *varobj = oval_string_map_new();
+	struct oval_object_iterator *obj_it = oval_definition_model_get_objects(model);
+	while (oval_object_iterator_has_more(obj_it)) {
+		struct oval_object *object = oval_object_iterator_next(obj_it);
+		struct oval_string_map *vm = oval_string_map_new();
+		oval_obj_collect_var_refs(object, vm);
+		struct oval_string_iterator *var_it = (struct oval_string_iterator *) oval_string_map_keys(vm);
+		while (oval_string_iterator_has_more(var_it)) {
+			char *variable_id = oval_string_iterator_next(var_it);
+			struct oval_string_map *obj_list = (struct oval_string_map *) oval_string_map_get_value(varobj, variable_id);
+			if (obj_list == NULL) {
+				obj_list = oval_string_map_new();
+				oval_string_map_put(varobj, variable_id, obj_list);
+			}
+			oval_string_map_put(obj_list, oval_object_get_id(object), object);
+		}
+		oval_string_iterator_free(var_it);
+		oval_string_map_free(vm, NULL);
+	}
+	oval_object_iterator_free(obj_it);
+	return varobj;
+}
@@ -46,6 +46,7 @@
 #include "results/oval_cmp_impl.h"
 #include "results/oval_results_impl.h"
 #include "public/oval_probe.h"
+#include "collectVarRefs_impl.h"
 
 typedef struct oval_variable {
 #define VAR_BASE				\
@@ -77,6 +78,7 @@ typedef struct {
 	VAR_BASE;
 	struct oval_component *component;
 	struct oval_collection *values;
+	int external_dep;	/* references an external variable: -1 unknown, 0 no, 1 yes */
 } oval_variable_LOCAL_t;
 
 typedef struct {
@@ -764,6 +766,59 @@ void oval_variable_free(struct oval_variable *variable)
 	}
 }
 
+void oval_variable_clear(struct oval_variable *variable)
+{
+	__attribute__nonnull__(variable);
+
+	free(variable->comment);
+	variable->comment = NULL;
+	variable->version = 0;
+	variable->deprecated = 0;
+	variable->datatype = OVAL_DATATYPE_UNKNOWN;
+
+	switch (variable->type) {
+	case OVAL_VARIABLE_CONSTANT: {
+		oval_variable_CONSTANT_t *cvar;
+
+		cvar = (oval_variable_CONSTANT_t *) variable;
+		if (cvar->values)
+			oval_collection_free_items(cvar->values, (oscap_destruct_func) oval_value_free);
+		cvar->values = NULL;
+		cvar->flag = SYSCHAR_FLAG_NOT_COLLECTED;
+
+		break;
+	}
+	case OVAL_VARIABLE_EXTERNAL: {
+		oval_variable_EXTERNAL_t *evar;
+
+		evar = (oval_variable_EXTERNAL_t *) variable;
+		oval_collection_free_items(evar->possible_values, (oscap_destruct_func) oval_variable_possible_value_free);
+		oval_collection_free_items(evar->possible_restrictions, (oscap_destruct_func) oval_variable_possible_restriction_free);
+		evar->possible_values = oval_collection_new();
+		evar->possible_restrictions = oval_collection_new();
+		evar->values_ref = NULL;
+		evar->flag = SYSCHAR_FLAG_NOT_COLLECTED;
+
+		break;
+	}
+	case OVAL_VARIABLE_LOCAL: {
+		oval_variable_LOCAL_t *lvar;
+
+		lvar = (oval_variable_LOCAL_t *) variable;
+		if (lvar->values)
+			oval_collection_free_items(lvar->values, (oscap_destruct_func) oval_value_free);
+		lvar->values = NULL;
+		oval_component_free(lvar->component);
+		lvar->component = NULL;
+		lvar->flag = SYSCHAR_FLAG_UNKNOWN;
+
+		break;
+	}
+	default:
+		break;
+	}
+}
+
 void oval_variable_set_datatype(struct oval_variable *variable, oval_datatype_t datatype)
 {
 	variable->datatype = datatype;
@@ -807,6 +862,7 @@ void oval_variable_set_type(struct oval_variable *variable, oval_variable_type_t
 		lvar->component = NULL;
 		lvar->values = NULL;
 		lvar->flag = SYSCHAR_FLAG_UNKNOWN;
+		lvar->external_dep = -1;
 
 		break;
 	}
@@ -904,6 +960,54 @@ void oval_variable_clear_values(struct oval_variable *variable)
 	}
 }
 
+static bool oval_variable_depends_on_external(oval_variable_LOCAL_t *var)
+{
+	struct oval_string_map *vm;
+	struct oval_iterator *var_itr;
+
+	if (var->external_dep != -1)
+		return var->external_dep;
+
+	var->external_dep = 0;
+	vm = oval_string_map_new();
+	oval_var_collect_var_refs((struct oval_variable *) var, vm);
+	var_itr = oval_string_map_values(vm);
+	while (oval_collection_iterator_has_more(var_itr)) {
+		struct oval_variable *ref = oval_collection_iterator_next(var_itr);
+
+		if (oval_variable_get_type(ref) == OVAL_VARIABLE_EXTERNAL) {
+			var->external_dep = 1;
+			break;
+		}
+	}
+	oval_collection_iterator_free(var_itr);
+	oval_string_map_free(vm, NULL);
+
+	return var->external_dep;
+}
+
+bool oval_variable_reset_computed_values(struct oval_variable *variable, bool all)
+{
+	oval_variable_LOCAL_t *lvar;
+
+	__attribute__nonnull__(variable);
+
+	if (variable->type != OVAL_VARIABLE_LOCAL)
+		return false;
+
+	lvar = (oval_variable_LOCAL_t *) variable;
+	if (lvar->flag == SYSCHAR_FLAG_UNKNOWN || (!all && !oval_variable_depends_on_external(lvar)))
+		return false;
+
+	if (lvar->values) {
+		oval_collection_free_items(lvar->values, (oscap_destruct_func) oval_value_free);
+		lvar->values = NULL;
+	}
+	lvar->flag = SYSCHAR_FLAG_UNKNOWN;
+
+	return true;
+}
+
 static int oval_value_satisfies_possible_restriction(struct oval_value *value, struct oval_variable_possible_restriction *pr)
 {
 	oval_datatype_t datatype = oval_value_get_datatype(value);
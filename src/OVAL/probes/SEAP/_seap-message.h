@@ -45,12 +45,14 @@ struct SEAP_msg {
         SEAP_msgid_t id;
         SEAP_attr_t *attrs;
         uint16_t     attrs_cnt;
+        uint16_t     attrs_max; /* allocated size of attrs */
         SEXP_t      *sexp;
 };
 
 typedef struct SEAP_msg SEAP_msg_t;
 
 SEAP_msg_t *SEAP_msg_new(void);
+SEAP_msg_t *SEAP_msg_move(SEAP_msg_t *msg);
 SEAP_msg_t *SEAP_msg_clone(SEAP_msg_t *msg);
 void SEAP_msg_free(SEAP_msg_t *msg);
 
@@ -62,5 +64,6 @@ SEXP_t *SEAP_msg_get(SEAP_msg_t *msg);
 
 int SEAP_msgattr_set(SEAP_msg_t *msg, const char *name, SEXP_t *value);
 bool SEAP_msgattr_exists(SEAP_msg_t *msg, const char *name);
+SEXP_t *SEAP_msgattr_get(SEAP_msg_t *msg, const char *name);
 
 #endif /* _SEAP_MESSAGE_H */
@@ -0,0 +1,53 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#pragma once
+#ifndef _SEAP_POOL_H
+#define _SEAP_POOL_H
+
+/*
+ * Per-thread free lists of the small SEAP objects which are created and
+ * destroyed for every message and command. An object returned to a pool
+ * is kept in the list of the thread which returned it and the lists are
+ * released when the thread exits.
+ */
+typedef enum {
+        SEAP_POOL_PACKET = 0,
+        SEAP_POOL_PACKETQ_ITEM,
+        SEAP_POOL_MSG,
+        SEAP_POOL_CMDREC,
+        SEAP_POOL_CMDJOB,
+        SEAP_POOL_TYPES
+} SEAP_pooltype_t;
+
+/* Maximal number of unused objects of one type kept by a thread */
+#define SEAP_POOL_MAXFREE 64
+
+/**
+ * Get an object from the free list of the calling thread or allocate
+ * a new one. The content of the object is undefined.
+ */
+void *SEAP_pool_alloc(SEAP_pooltype_t type);
+
+/**
+ * Return an object allocated by SEAP_pool_alloc. NULL is ignored.
+ */
+void SEAP_pool_free(SEAP_pooltype_t type, void *obj);
+
+#endif /* _SEAP_POOL_H */
@@ -36,6 +36,16 @@ typedef uint8_t SEAP_cflags_t;
 typedef struct {
         rbt_t       *tree;
         bitmap_t    *bmap;
+        /*
+         * Message and command ID counters shared by all the descriptors
+         * of the table, updated with atomic operations only
+         */
+#if SEAP_MSGID_BITS == 64
+        uint64_t     next_id;
+#else
+        uint32_t     next_id;
+#endif
+        uint16_t     next_cid;
 } SEAP_desctable_t;
 
 typedef struct {
@@ -54,8 +54,17 @@ int SEAP_openfd(SEAP_CTX_t *ctx, int fd, uint32_t flags);
 int SEAP_openfd2(SEAP_CTX_t *ctx, int ifd, int ofd, uint32_t flags);
 int SEAP_add_probe(SEAP_CTX_t *ctx, sch_queuedata_t *data);
 
+/*
+ * Pass an object to the in-process probe at sd without building a SEAP
+ * message. Returns NULL if the probe can't take direct calls, in which
+ * case the object has to be sent with SEAP_sendmsg. The call has to be
+ * finished with sch_queue_call_wait.
+ */
+sch_queue_call_t *SEAP_call(SEAP_CTX_t *ctx, int sd, SEXP_t *obj);
+
 int SEAP_recvsexp(SEAP_CTX_t *ctx, int sd, SEXP_t **sexp);
 int SEAP_recvmsg(SEAP_CTX_t *ctx, int sd, SEAP_msg_t **seap_msg);
+int SEAP_recvmsg_byid(SEAP_CTX_t *ctx, int sd, SEAP_msgid_t id, SEAP_msg_t **seap_msg);
 
 int SEAP_sendsexp(SEAP_CTX_t *ctx, int sd, SEXP_t *sexp);
 int SEAP_sendmsg(SEAP_CTX_t *ctx, int sd, SEAP_msg_t *seap_msg);
@@ -24,15 +24,17 @@
 #define _SEXP_ID_H
 
 typedef uint64_t SEXP_ID_t;
-typedef struct {
-	SEXP_ID_t hash;
-	int       part;
-} __IDres_pair;
-
 
 /**
- * Compute an S-exp value identifier
+ * Compute an S-exp value identifier. The identifiers of lists
+ * are memoized in the list values.
  */
 SEXP_ID_t SEXP_ID_v(const SEXP_t *s);
 
+/**
+ * Return the memoized identifier of a list or 0 if it
+ * hasn't been computed yet.
+ */
+SEXP_ID_t SEXP_ID_memo(const SEXP_t *s);
+
 #endif /* _SEXP_ID_H */
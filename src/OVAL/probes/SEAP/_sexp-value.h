@@ -40,6 +40,7 @@ typedef uint8_t SEXP_valtype_t;
 
 typedef struct {
         uint32_t refs;
+        uint32_t owner; /* thread confined value, see SEXP_local_begin */
         size_t   size;
 } SEXP_valhdr_t;
 
@@ -56,12 +57,25 @@ typedef struct {
 #define SEXP_VALP_HDR(p) ((SEXP_valhdr_t *)(((uintptr_t)(p)) & SEXP_VALP_MASK))
 
 int       SEXP_val_new (SEXP_val_t *dst, size_t vmemsize, SEXP_valtype_t type);
+void      SEXP_val_free (SEXP_val_t *dsc);
 void      SEXP_val_dsc (SEXP_val_t *dst, uintptr_t ptr);
 uintptr_t SEXP_val_ptr (SEXP_val_t *dsc);
 
+/**
+ * Number of bytes currently allocated for S-exp values and list blocks
+ * by all threads. The value is maintained by SEXP_val_new, SEXP_val_free
+ * and the list block allocator and is cheap to read.
+ */
+size_t    SEXP_val_memusage (void);
+
 uintptr_t SEXP_rawval_incref (uintptr_t valp);
 int       SEXP_rawval_decref (uintptr_t valp);
 
+/**
+ * Clear the owner of the value and of all the values reachable from it.
+ */
+void      SEXP_rawval_promote (uintptr_t valp);
+
 #define SEXP_DEFNUM(s,T)   struct SEXP_val_num_##s { T n; SEXP_numtype_t t; }
 #define SEXP_NCASTP(s,p) ((struct SEXP_val_num_##s *)(p))
 #define SEXP_NTYPEP(sz,p) *((SEXP_numtype_t *)(((uint8_t *)(p)) + (sz) - sizeof (SEXP_numtype_t)))
@@ -85,7 +99,11 @@ SEXP_DEFNUM(u64, uint64_t);
 
 struct SEXP_val_list {
         void    *b_addr;
+        void    *b_last; /* last block of the chain, NULL if not known yet */
+        uint32_t length; /* number of members, not counting the skipped ones */
         uint16_t offset;
+        uint16_t shared; /* the chain may be shared with another list */
+        uint64_t hash;   /* memoized SEXP_ID_v of the list, 0 if not known */
 };
 
 #define SEXP_LCASTP(p) ((struct SEXP_val_list *)(p))
@@ -98,6 +116,8 @@ struct SEXP_val_lblk {
 };
 
 size_t    SEXP_rawval_list_length (struct SEXP_val_list *list);
+uintptr_t SEXP_rawval_list_last (struct SEXP_val_list *list);
+void      SEXP_rawval_list_add (struct SEXP_val_list *list, const SEXP_t *s_exp);
 uintptr_t SEXP_rawval_list_copy (uintptr_t s_valp);
 
 uintptr_t SEXP_rawval_lblk_copy (uintptr_t lblkp, uint16_t n_skip);
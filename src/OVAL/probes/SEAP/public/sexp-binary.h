@@ -0,0 +1,118 @@
+/**
+ * @file   sexp-binary.h
+ * @brief  Compact binary encoding of S-expressions
+ *
+ * The encoding starts with a table of the strings which occur more than
+ * once in the encoded S-exp (and of all the datatype names), followed by
+ * the value itself. Every length is prefixed, so a decoder never has to
+ * scan for delimiters, and strings can be read as views into the buffer.
+ */
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#pragma once
+#ifndef SEXP_BINARY_H
+#define SEXP_BINARY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <sexp-types.h>
+#include "oscap_export.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Encode an S-exp. The buffer is allocated by the function and has to be
+ * freed by the caller.
+ * @param s_exp the S-exp to encode
+ * @param buf the encoded S-exp
+ * @param len the length of the encoded S-exp
+ * @return 0 on success, -1 on failure
+ */
+OSCAP_API int SEXP_bin_encode(const SEXP_t *s_exp, void **buf, size_t *len);
+
+/**
+ * Decode an S-exp encoded by SEXP_bin_encode.
+ * @param buf the encoded S-exp
+ * @param len the length of the buffer
+ * @return a new S-exp or NULL if the buffer doesn't hold a valid encoding
+ */
+OSCAP_API SEXP_t *SEXP_bin_decode(const void *buf, size_t len);
+
+typedef enum {
+	SEXP_BIN_END = 0, ///< the whole value has been read
+	SEXP_BIN_EMPTY,   ///< an empty S-exp
+	SEXP_BIN_LIST,    ///< a list, followed by its `list.length' members
+	SEXP_BIN_STRING,  ///< a string
+	SEXP_BIN_NUMBER   ///< a number
+} SEXP_bin_toktype_t;
+
+/**
+ * A token read from an encoded S-exp. The strings point into the encoded
+ * buffer and are not NUL terminated.
+ */
+typedef struct {
+	SEXP_bin_toktype_t type;
+	const char *datatype;     ///< datatype name or NULL
+	size_t      datatype_len;
+	union {
+		struct {
+			uint32_t length;
+		} list;
+		struct {
+			const char *str;
+			size_t      len;
+		} string;
+		struct {
+			SEXP_numtype_t type;
+			union {
+				bool     b;
+				int64_t  i;
+				uint64_t u;
+				double   f;
+			} v;
+		} number;
+	} u;
+} SEXP_bin_token_t;
+
+typedef struct SEXP_bin_reader SEXP_bin_reader_t;
+
+/**
+ * Create a reader of an encoded S-exp. The buffer has to stay valid
+ * while the reader and the tokens returned by it are used.
+ * @return a new reader or NULL if the header of the encoding is invalid
+ */
+OSCAP_API SEXP_bin_reader_t *SEXP_bin_reader_new(const void *buf, size_t len);
+
+/**
+ * Read the next token. The members of lists are returned in pre-order.
+ * @return 0 on success, -1 if the encoding is invalid
+ */
+OSCAP_API int SEXP_bin_reader_next(SEXP_bin_reader_t *reader, SEXP_bin_token_t *token);
+
+OSCAP_API void SEXP_bin_reader_free(SEXP_bin_reader_t *reader);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SEXP_BINARY_H */
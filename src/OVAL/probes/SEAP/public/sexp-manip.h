@@ -497,6 +497,31 @@ OSCAP_API SEXP_t *SEXP_ref (const SEXP_t *s_exp);
 
 OSCAP_API SEXP_t *SEXP_unref (SEXP_t *s_exp_o);
 
+/**
+ * Start building a thread confined S-exp. Values created by the calling
+ * thread until the matching SEXP_local_end call use non-atomic reference
+ * counting. The values must not be shared with other threads before the
+ * window is closed. The calls may be nested.
+ */
+OSCAP_API void SEXP_local_begin (void);
+
+/**
+ * Close the window opened by SEXP_local_begin. The values reachable from
+ * s_exp are converted to shared values and s_exp can be handed off to
+ * other threads afterwards. The other values built inside the window
+ * which are still referenced become shared values as well.
+ * @param s_exp the result of the window or NULL
+ */
+OSCAP_API void SEXP_local_end (const SEXP_t *s_exp);
+
+/**
+ * Convert the values reachable from s_exp to shared values while inside
+ * the window opened by SEXP_local_begin, e.g. before s_exp is stored in
+ * a structure visible to other threads.
+ * @param s_exp the S-exp to share
+ */
+OSCAP_API void SEXP_local_share (const SEXP_t *s_exp);
+
 /**
  * Create a new soft reference to a sexp object.
  * @param s_exp the object to which create the soft reference
@@ -43,6 +43,12 @@ extern "C" {
 
 OSCAP_API SEXP_t *SEXP_init(SEXP_t *sexp_mem);
 
+/**
+ * Create a new reference to a sexp object in the memory provided by the caller.
+ * The reference has to be released using SEXP_free_r.
+ */
+OSCAP_API SEXP_t *SEXP_ref_r(SEXP_t *sexp_mem, const SEXP_t *s_exp_o);
+
 OSCAP_API SEXP_t *SEXP_number_newb_r(SEXP_t *sexp_mem, bool n);
 #define SEXP_number_newi_r SEXP_number_newi_32_r
 OSCAP_API SEXP_t *SEXP_number_newi_32_r(SEXP_t *sexp_mem, int32_t n);
@@ -28,5 +28,6 @@
 #include <sexp-manip.h>
 #include <sexp-manip_r.h>
 #include <sexp-output.h>
+#include <sexp-binary.h>
 
 #endif /* SEXP_H */
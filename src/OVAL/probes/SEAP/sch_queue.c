@@ -28,6 +28,7 @@
 
 #include "_sexp-types.h"
 #include "_seap-types.h"
+#include "public/sexp-manip.h"
 #include "sch_queue.h"
 #include "seap-descriptor.h"
 #include "common/debug_priv.h"
@@ -51,6 +52,10 @@ int sch_queue_connect(SEAP_desc_t *desc)
 
 	data->parent_thread_id = pthread_self();
 
+	pthread_mutex_init(&data->call_mutex, NULL);
+	data->call_fn = NULL;
+	data->call_arg = NULL;
+
 	struct probe_common_main_argument *arg = malloc(sizeof(struct probe_common_main_argument));
 	arg->subtype = desc->subtype;
 	arg->queuedata = data;
@@ -69,24 +74,9 @@ int sch_queue_connect(SEAP_desc_t *desc)
 	return 0;
 }
 
-SEXP_t *sch_queue_recvsexp(SEAP_desc_t *desc)
+static SEXP_t *sch_queue_pop(struct oscap_queue *queue, pthread_mutex_t *mutex,
+                             pthread_cond_t *cond, int *cnt)
 {
-	sch_queuedata_t *data = (sch_queuedata_t *)desc->scheme_data;
-	struct oscap_queue *queue;
-	pthread_mutex_t *mutex;
-	pthread_cond_t *cond;
-	int *cnt;
-	if (pthread_equal(pthread_self(), data->parent_thread_id)) {
-		queue = data->from_probe_queue;
-		mutex = &data->from_probe_mutex;
-		cond = &data->from_probe_cond;
-		cnt = &data->from_probe_cnt;
-	} else {
-		queue = data->to_probe_queue;
-		mutex = &data->to_probe_mutex;
-		cond = &data->to_probe_cond;
-		cnt = &data->to_probe_cnt;
-	}
 	pthread_mutex_lock(mutex);
 	while (*cnt == 0) {
 		pthread_cond_wait(cond, mutex);
@@ -97,6 +87,28 @@ SEXP_t *sch_queue_recvsexp(SEAP_desc_t *desc)
 	return sexp;
 }
 
+SEXP_t *sch_queue_recvsexp(SEAP_desc_t *desc)
+{
+	sch_queuedata_t *data = (sch_queuedata_t *)desc->scheme_data;
+
+	if (pthread_equal(pthread_self(), data->parent_thread_id))
+		return sch_queue_recvsexp_parent(data);
+
+	return sch_queue_pop(data->to_probe_queue, &data->to_probe_mutex,
+	                     &data->to_probe_cond, &data->to_probe_cnt);
+}
+
+/*
+ * Receive a S-exp sent by the probe from any thread of the parent side,
+ * used by the worker processes (see sch_shm.c) which forward the replies
+ * from a dedicated thread.
+ */
+SEXP_t *sch_queue_recvsexp_parent(sch_queuedata_t *data)
+{
+	return sch_queue_pop(data->from_probe_queue, &data->from_probe_mutex,
+	                     &data->from_probe_cond, &data->from_probe_cnt);
+}
+
 ssize_t sch_queue_sendsexp(SEAP_desc_t *desc, SEXP_t *sexp, uint32_t flags)
 {
 	sch_queuedata_t *data = (sch_queuedata_t *) desc->scheme_data;
@@ -143,7 +155,92 @@ int sch_queue_close(SEAP_desc_t *desc, uint32_t flags)
 cleanup:
 	oscap_queue_free(data->to_probe_queue, NULL);
 	oscap_queue_free(data->from_probe_queue, NULL);
+	pthread_mutex_destroy(&data->call_mutex);
 	free(data);
 	free(desc->arg);
 	return ret;
 }
+
+/*
+ * Called by the probe thread when it is ready to accept direct calls and,
+ * with fn == NULL, before it goes away.
+ */
+void sch_queue_call_register(sch_queuedata_t *data, sch_queue_callfn_t fn, void *arg)
+{
+	pthread_mutex_lock(&data->call_mutex);
+	data->call_fn = fn;
+	data->call_arg = arg;
+	pthread_mutex_unlock(&data->call_mutex);
+}
+
+/*
+ * Hand the object over to the probe. Returns NULL if the probe doesn't
+ * accept direct calls (yet), the caller should use SEAP messages then.
+ */
+sch_queue_call_t *sch_queue_call(SEAP_desc_t *desc, SEXP_t *obj)
+{
+	sch_queuedata_t *data = (sch_queuedata_t *) desc->scheme_data;
+	sch_queue_call_t *call;
+	int ret = -1;
+
+	if (data == NULL)
+		return NULL;
+
+	call = malloc(sizeof(sch_queue_call_t));
+	call->obj = SEXP_ref(obj);
+	call->cobj = NULL;
+	call->ret = 0;
+	call->done = false;
+	pthread_mutex_init(&call->mutex, NULL);
+	pthread_cond_init(&call->cond, NULL);
+
+	pthread_mutex_lock(&data->call_mutex);
+	if (data->call_fn != NULL)
+		ret = data->call_fn(data->call_arg, call);
+	pthread_mutex_unlock(&data->call_mutex);
+
+	if (ret != 0) {
+		SEXP_free(call->obj);
+		pthread_cond_destroy(&call->cond);
+		pthread_mutex_destroy(&call->mutex);
+		free(call);
+		return NULL;
+	}
+
+	return call;
+}
+
+/*
+ * Wait for the probe to complete the call and free it. The collected object
+ * is stored in cobj (NULL on error) and the probe return code is returned.
+ */
+int sch_queue_call_wait(sch_queue_call_t *call, SEXP_t **cobj)
+{
+	int ret;
+
+	pthread_mutex_lock(&call->mutex);
+	while (!call->done) {
+		pthread_cond_wait(&call->cond, &call->mutex);
+	}
+	pthread_mutex_unlock(&call->mutex);
+
+	ret = call->ret;
+	*cobj = call->cobj;
+
+	SEXP_free(call->obj);
+	pthread_cond_destroy(&call->cond);
+	pthread_mutex_destroy(&call->mutex);
+	free(call);
+
+	return ret;
+}
+
+void sch_queue_call_done(sch_queue_call_t *call, SEXP_t *cobj, int ret)
+{
+	pthread_mutex_lock(&call->mutex);
+	call->cobj = cobj;
+	call->ret = ret;
+	call->done = true;
+	pthread_cond_signal(&call->cond);
+	pthread_mutex_unlock(&call->mutex);
+}
@@ -23,10 +23,31 @@
 #ifndef OPENSCAP_SCH_QUEUE_H
 #define OPENSCAP_SCH_QUEUE_H
 
+#include <stdbool.h>
 #include "util.h"
 #include "oscap_queue.h"
 #include "seap-descriptor.h"
 
+/*
+ * Direct call into a probe running in this process. The object is handed
+ * over by reference and the collected object is returned the same way,
+ * without SEAP message framing.
+ */
+typedef struct {
+	SEXP_t *obj;  /* object to be collected */
+	SEXP_t *cobj; /* collected object, set on completion */
+	int     ret;  /* 0 or a PROBE_E* code, set on completion */
+	bool    done;
+	pthread_mutex_t mutex;
+	pthread_cond_t  cond;
+} sch_queue_call_t;
+
+/*
+ * Function registered by the probe to accept direct calls. It has to return
+ * 0 if the call was accepted and will be completed by sch_queue_call_done.
+ */
+typedef int (*sch_queue_callfn_t)(void *arg, sch_queue_call_t *call);
+
 typedef struct {
 	pthread_t probe_thread_id;
 	pthread_t parent_thread_id;
@@ -38,11 +59,20 @@ typedef struct {
 	pthread_mutex_t from_probe_mutex;
 	int to_probe_cnt;
 	int from_probe_cnt;
+	pthread_mutex_t call_mutex;
+	sch_queue_callfn_t call_fn; /* NULL until the probe is ready */
+	void *call_arg;
 } sch_queuedata_t;
 
 int sch_queue_connect(SEAP_desc_t *desc);
 ssize_t sch_queue_sendsexp(SEAP_desc_t *desc, SEXP_t *sexp, uint32_t flags);
 SEXP_t *sch_queue_recvsexp(SEAP_desc_t *desc);
+SEXP_t *sch_queue_recvsexp_parent(sch_queuedata_t *data);
 int sch_queue_close(SEAP_desc_t *desc, uint32_t flags);
 
+void sch_queue_call_register(sch_queuedata_t *data, sch_queue_callfn_t fn, void *arg);
+sch_queue_call_t *sch_queue_call(SEAP_desc_t *desc, SEXP_t *obj);
+int sch_queue_call_wait(sch_queue_call_t *call, SEXP_t **cobj);
+void sch_queue_call_done(sch_queue_call_t *call, SEXP_t *cobj, int ret);
+
 #endif /* OPENSCAP_SCH_QUEUE_H */
@@ -0,0 +1,493 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "_sexp-types.h"
+#include "_seap-types.h"
+#include "public/sexp-manip.h"
+#include "public/sexp-binary.h"
+#include "sch_queue.h"
+#include "sch_shm.h"
+#include "seap-descriptor.h"
+#include "common/debug_priv.h"
+#include "oval_definitions.h"
+
+/*
+ * Single producer, single consumer byte ring. The counters only grow, the
+ * difference is the number of bytes waiting to be read. Every message is
+ * a 32-bit length followed by the encoded S-exp, messages larger than the
+ * ring are streamed through it. The writers (readers) of one ring are
+ * serialized by the descriptor write (read) lock in the library process
+ * and there's only one of each in the worker process, so a message is
+ * never interleaved with another one.
+ */
+typedef struct {
+	pthread_mutex_t mutex; /* process shared, robust */
+	pthread_cond_t  cond;
+	uint64_t        head;  /* bytes written */
+	uint64_t        tail;  /* bytes read */
+	bool            closed;
+	uint8_t         data[SCH_SHM_RINGSIZE];
+} sch_shm_ring_t;
+
+typedef struct {
+	sch_shm_ring_t *to_probe;
+	sch_shm_ring_t *from_probe;
+	pid_t pid;        /* worker process, 0 in the worker itself */
+	pid_t parent_pid;
+	bool  exited;     /* the worker process was reaped */
+} sch_shmdata_t;
+
+static pthread_mutex_t sch_shm_count_mutex = PTHREAD_MUTEX_INITIALIZER;
+static long sch_shm_count = 0;
+
+static long sch_shm_max_processes(void)
+{
+	const char *procs_str;
+	char *end;
+	long procs;
+
+	procs_str = getenv("OSCAP_PROBE_PROCESSES");
+	if (procs_str == NULL)
+		return 0;
+
+	procs = strtol(procs_str, &end, 10);
+	if (*end != '\0' || procs < 0) {
+		dW("Invalid OSCAP_PROBE_PROCESSES value '%s'.", procs_str);
+		return 0;
+	}
+
+	return procs;
+}
+
+bool sch_shm_acquire(void)
+{
+	long max = sch_shm_max_processes();
+	bool ret = false;
+
+	if (max == 0)
+		return false;
+
+	pthread_mutex_lock(&sch_shm_count_mutex);
+	if (sch_shm_count < max) {
+		++sch_shm_count;
+		ret = true;
+	}
+	pthread_mutex_unlock(&sch_shm_count_mutex);
+
+	return ret;
+}
+
+static void sch_shm_release(void)
+{
+	pthread_mutex_lock(&sch_shm_count_mutex);
+	--sch_shm_count;
+	pthread_mutex_unlock(&sch_shm_count_mutex);
+}
+
+static int sch_shm_ring_init(sch_shm_ring_t *ring)
+{
+	pthread_mutexattr_t mattr;
+	pthread_condattr_t  cattr;
+
+	pthread_mutexattr_init(&mattr);
+	pthread_mutexattr_setpshared(&mattr, PTHREAD_PROCESS_SHARED);
+	pthread_mutexattr_setrobust(&mattr, PTHREAD_MUTEX_ROBUST);
+	pthread_condattr_init(&cattr);
+	pthread_condattr_setpshared(&cattr, PTHREAD_PROCESS_SHARED);
+
+	if (pthread_mutex_init(&ring->mutex, &mattr) != 0 ||
+	    pthread_cond_init(&ring->cond, &cattr) != 0) {
+		pthread_mutexattr_destroy(&mattr);
+		pthread_condattr_destroy(&cattr);
+		return -1;
+	}
+
+	pthread_mutexattr_destroy(&mattr);
+	pthread_condattr_destroy(&cattr);
+
+	ring->head = 0;
+	ring->tail = 0;
+	ring->closed = false;
+
+	return 0;
+}
+
+/*
+ * The other side died while holding the mutex, nothing it left in the
+ * ring can be trusted anymore.
+ */
+static void sch_shm_ring_recover(sch_shm_ring_t *ring)
+{
+	pthread_mutex_consistent(&ring->mutex);
+	ring->closed = true;
+}
+
+static void sch_shm_ring_lock(sch_shm_ring_t *ring)
+{
+	if (pthread_mutex_lock(&ring->mutex) == EOWNERDEAD)
+		sch_shm_ring_recover(ring);
+}
+
+static void sch_shm_ring_close(sch_shm_ring_t *ring)
+{
+	sch_shm_ring_lock(ring);
+	ring->closed = true;
+	pthread_cond_broadcast(&ring->cond);
+	pthread_mutex_unlock(&ring->mutex);
+}
+
+static bool sch_shm_peer_alive(sch_shmdata_t *data)
+{
+	if (data->pid == 0)
+		return getppid() == data->parent_pid;
+
+	if (!data->exited) {
+		int status;
+		pid_t ret = waitpid(data->pid, &status, WNOHANG);
+
+		if (ret == data->pid || (ret < 0 && errno == ECHILD)) {
+			dW("Probe worker process %d has terminated.", (int)data->pid);
+			data->exited = true;
+		}
+	}
+
+	return !data->exited;
+}
+
+/*
+ * Wait for a change of the ring. The wait is limited so that a peer which
+ * has gone away is noticed and the ring gets closed.
+ */
+static void sch_shm_ring_wait(sch_shm_ring_t *ring, sch_shmdata_t *data)
+{
+	struct timespec ts;
+	int ret;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	ts.tv_sec += 1;
+
+	ret = pthread_cond_timedwait(&ring->cond, &ring->mutex, &ts);
+
+	if (ret == EOWNERDEAD)
+		sch_shm_ring_recover(ring);
+	else if (ret == ETIMEDOUT && !sch_shm_peer_alive(data))
+		ring->closed = true;
+}
+
+static int sch_shm_ring_put(sch_shm_ring_t *ring, sch_shmdata_t *data, const void *buf, size_t len)
+{
+	const uint8_t *src = buf;
+
+	while (len > 0) {
+		size_t avail, off, n;
+
+		if (ring->closed) {
+			errno = EPIPE;
+			return -1;
+		}
+
+		avail = SCH_SHM_RINGSIZE - (size_t)(ring->head - ring->tail);
+		if (avail == 0) {
+			sch_shm_ring_wait(ring, data);
+			continue;
+		}
+
+		off = (size_t)(ring->head % SCH_SHM_RINGSIZE);
+		n = len;
+		if (n > avail)
+			n = avail;
+		if (n > SCH_SHM_RINGSIZE - off)
+			n = SCH_SHM_RINGSIZE - off;
+
+		memcpy(ring->data + off, src, n);
+		ring->head += n;
+		src += n;
+		len -= n;
+
+		pthread_cond_broadcast(&ring->cond);
+	}
+
+	return 0;
+}
+
+static int sch_shm_ring_get(sch_shm_ring_t *ring, sch_shmdata_t *data, void *buf, size_t len)
+{
+	uint8_t *dst = buf;
+
+	while (len > 0) {
+		size_t used, off, n;
+
+		used = (size_t)(ring->head - ring->tail);
+		if (used == 0) {
+			if (ring->closed) {
+				errno = ECONNRESET;
+				return -1;
+			}
+			sch_shm_ring_wait(ring, data);
+			continue;
+		}
+
+		off = (size_t)(ring->tail % SCH_SHM_RINGSIZE);
+		n = len;
+		if (n > used)
+			n = used;
+		if (n > SCH_SHM_RINGSIZE - off)
+			n = SCH_SHM_RINGSIZE - off;
+
+		memcpy(dst, ring->data + off, n);
+		ring->tail += n;
+		dst += n;
+		len -= n;
+
+		pthread_cond_broadcast(&ring->cond);
+	}
+
+	return 0;
+}
+
+static int sch_shm_ring_send(sch_shm_ring_t *ring, sch_shmdata_t *data, const SEXP_t *sexp)
+{
+	void *buf;
+	size_t len;
+	uint32_t len32;
+	int ret;
+
+	if (SEXP_bin_encode(sexp, &buf, &len) != 0)
+		return -1;
+
+	if (len > UINT32_MAX) {
+		free(buf);
+		errno = EMSGSIZE;
+		return -1;
+	}
+
+	len32 = (uint32_t)len;
+
+	sch_shm_ring_lock(ring);
+	ret = sch_shm_ring_put(ring, data, &len32, sizeof len32);
+	if (ret == 0)
+		ret = sch_shm_ring_put(ring, data, buf, len);
+	pthread_mutex_unlock(&ring->mutex);
+
+	free(buf);
+	return ret;
+}
+
+static SEXP_t *sch_shm_ring_recv(sch_shm_ring_t *ring, sch_shmdata_t *data)
+{
+	SEXP_t *sexp;
+	uint32_t len32;
+	void *buf;
+
+	sch_shm_ring_lock(ring);
+	if (sch_shm_ring_get(ring, data, &len32, sizeof len32) != 0) {
+		pthread_mutex_unlock(&ring->mutex);
+		return NULL;
+	}
+
+	buf = malloc(len32 > 0 ? len32 : 1);
+	if (buf == NULL || sch_shm_ring_get(ring, data, buf, len32) != 0) {
+		/* the rest of the message can't be skipped, give up on the ring */
+		ring->closed = true;
+		pthread_cond_broadcast(&ring->cond);
+		pthread_mutex_unlock(&ring->mutex);
+		free(buf);
+		return NULL;
+	}
+	pthread_mutex_unlock(&ring->mutex);
+
+	sexp = SEXP_bin_decode(buf, len32);
+	free(buf);
+
+	return sexp;
+}
+
+struct sch_shm_output_arg {
+	sch_shmdata_t   *data;
+	sch_queuedata_t *queuedata;
+};
+
+/*
+ * Worker process: forward everything the probe sends to the library.
+ */
+static void *sch_shm_worker_output(void *arg)
+{
+	struct sch_shm_output_arg *out = arg;
+	SEXP_t *sexp;
+
+	for (;;) {
+		sexp = sch_queue_recvsexp_parent(out->queuedata);
+
+		if (sch_shm_ring_send(out->data->from_probe, out->data, sexp) != 0) {
+			SEXP_free(sexp);
+			break;
+		}
+
+		SEXP_free(sexp);
+	}
+
+	return NULL;
+}
+
+/*
+ * Worker process: run the probe in a thread, like the library does, and
+ * forward the requests to it until the library closes the connection.
+ */
+static void sch_shm_worker(sch_shmdata_t *data, oval_subtype_t subtype)
+{
+	struct sch_shm_output_arg out;
+	SEAP_desc_t *qdesc;
+	pthread_t th_output;
+	SEXP_t *sexp;
+
+	qdesc = calloc(1, sizeof(SEAP_desc_t));
+	if (qdesc == NULL)
+		_exit(1);
+
+	qdesc->subtype = subtype;
+
+	if (sch_queue_connect(qdesc) != 0)
+		_exit(1);
+
+	out.data = data;
+	out.queuedata = qdesc->scheme_data;
+
+	if (pthread_create(&th_output, NULL, &sch_shm_worker_output, &out) != 0)
+		_exit(1);
+
+	while ((sexp = sch_shm_ring_recv(data->to_probe, data)) != NULL) {
+		sch_queue_sendsexp(qdesc, sexp, 0);
+		SEXP_free(sexp);
+	}
+
+	sch_shm_ring_close(data->from_probe);
+	sch_queue_close(qdesc, 0);
+
+	_exit(0);
+}
+
+int sch_shm_connect(SEAP_desc_t *desc)
+{
+	sch_shmdata_t *data;
+	void *region;
+	pid_t pid;
+
+	data = malloc(sizeof(sch_shmdata_t));
+	if (data == NULL)
+		goto fail;
+
+	region = mmap(NULL, 2 * sizeof(sch_shm_ring_t), PROT_READ | PROT_WRITE,
+	              MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (region == MAP_FAILED) {
+		dE("Cannot map the shared memory for the %s_probe worker: %s.",
+		   oval_subtype_get_text(desc->subtype), strerror(errno));
+		free(data);
+		goto fail;
+	}
+
+	data->to_probe = region;
+	data->from_probe = data->to_probe + 1;
+	data->parent_pid = getpid();
+	data->exited = false;
+
+	if (sch_shm_ring_init(data->to_probe) != 0 ||
+	    sch_shm_ring_init(data->from_probe) != 0)
+		goto fail_unmap;
+
+	pid = fork();
+	if (pid < 0) {
+		dE("Cannot fork the %s_probe worker: %s.",
+		   oval_subtype_get_text(desc->subtype), strerror(errno));
+		goto fail_unmap;
+	}
+
+	if (pid == 0) {
+		data->pid = 0;
+		sch_shm_worker(data, desc->subtype);
+		/* NOTREACHED */
+	}
+
+	dI("Started %s_probe worker process %d.", oval_subtype_get_text(desc->subtype), (int)pid);
+
+	data->pid = pid;
+	desc->scheme_data = data;
+	return 0;
+
+fail_unmap:
+	munmap(region, 2 * sizeof(sch_shm_ring_t));
+	free(data);
+fail:
+	sch_shm_release();
+	return -1;
+}
+
+SEXP_t *sch_shm_recvsexp(SEAP_desc_t *desc)
+{
+	sch_shmdata_t *data = (sch_shmdata_t *)desc->scheme_data;
+
+	return sch_shm_ring_recv(data->from_probe, data);
+}
+
+ssize_t sch_shm_sendsexp(SEAP_desc_t *desc, SEXP_t *sexp, uint32_t flags)
+{
+	sch_shmdata_t *data = (sch_shmdata_t *)desc->scheme_data;
+
+	return sch_shm_ring_send(data->to_probe, data, sexp);
+}
+
+int sch_shm_close(SEAP_desc_t *desc, uint32_t flags)
+{
+	sch_shmdata_t *data = (sch_shmdata_t *)desc->scheme_data;
+	int ret = 0;
+
+	sch_shm_ring_close(data->to_probe);
+
+	if (!data->exited) {
+		int status;
+
+		if (waitpid(data->pid, &status, 0) != data->pid) {
+			dE("Cannot wait for the %s_probe worker process %d: %s.",
+			   oval_subtype_get_text(desc->subtype), (int)data->pid, strerror(errno));
+			ret = -1;
+		} else if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+			dW("The %s_probe worker process %d did not exit cleanly.",
+			   oval_subtype_get_text(desc->subtype), (int)data->pid);
+		}
+	}
+
+	munmap(data->to_probe, 2 * sizeof(sch_shm_ring_t));
+	free(data);
+	sch_shm_release();
+
+	return ret;
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef OPENSCAP_SCH_SHM_H
+#define OPENSCAP_SCH_SHM_H
+
+#include <stdbool.h>
+#include <sys/types.h>
+#include "seap-descriptor.h"
+
+/*
+ * Probe running in a forked worker process. The requests and the results
+ * are exchanged over a pair of ring buffers in shared memory using the
+ * binary S-exp encoding (see sexp-binary.h). In the worker process the
+ * probe runs in a thread connected by sch_queue, as it would in the
+ * library.
+ *
+ * The mode is disabled by default. Setting the OSCAP_PROBE_PROCESSES
+ * environment variable to N > 0 runs each probe type in its own worker
+ * process, at most N of them at a time; any further probe types run as
+ * threads of the library process.
+ */
+
+/* Size of each of the ring buffers in bytes */
+#define SCH_SHM_RINGSIZE (1024 * 1024)
+
+/**
+ * Reserve a worker process slot if the mode is enabled.
+ * @return true if the caller should use sch_shm_connect
+ */
+bool sch_shm_acquire(void);
+
+int sch_shm_connect(SEAP_desc_t *desc);
+ssize_t sch_shm_sendsexp(SEAP_desc_t *desc, SEXP_t *sexp, uint32_t flags);
+SEXP_t *sch_shm_recvsexp(SEAP_desc_t *desc);
+int sch_shm_close(SEAP_desc_t *desc, uint32_t flags);
+
+#endif /* OPENSCAP_SCH_SHM_H */
@@ -37,6 +37,7 @@
 #include "generic/redblack.h"
 #include "_seap-command.h"
 #include "_seap-packet.h"
+#include "_seap-pool.h"
 #include "_seap.h"
 #include "debug_priv.h"
 
@@ -117,7 +118,7 @@ int SEAP_cmd_register (SEAP_CTX_t *ctx, SEAP_cmdcode_t code, uint32_t flags, SEA
  */
 SEAP_cmdrec_t *SEAP_cmdrec_new (void)
 {
-	SEAP_cmdrec_t *r = malloc(sizeof(SEAP_cmdrec_t));
+	SEAP_cmdrec_t *r = SEAP_pool_alloc(SEAP_POOL_CMDREC);
         r->code = 0;
         r->func = NULL;
         r->arg  = NULL;
@@ -127,7 +128,7 @@ SEAP_cmdrec_t *SEAP_cmdrec_new (void)
 
 void SEAP_cmdrec_free (SEAP_cmdrec_t *r)
 {
-	free(r);
+	SEAP_pool_free(SEAP_POOL_CMDREC, r);
 }
 
 SEAP_cmdtbl_t *SEAP_cmdtbl_new (void)
@@ -500,7 +501,7 @@ SEXP_t *SEAP_cmd_exec (SEAP_CTX_t    *ctx,
 
 SEAP_cmdjob_t *SEAP_cmdjob_new (void)
 {
-        SEAP_cmdjob_t *j = malloc(sizeof(SEAP_cmdjob_t));
+        SEAP_cmdjob_t *j = SEAP_pool_alloc(SEAP_POOL_CMDJOB);
         j->ctx = NULL;
         j->sd  = -1;
 
@@ -509,5 +510,5 @@ SEAP_cmdjob_t *SEAP_cmdjob_new (void)
 
 void SEAP_cmdjob_free (SEAP_cmdjob_t *j)
 {
-	free(j);
+	SEAP_pool_free(SEAP_POOL_CMDJOB, j);
 }
@@ -35,6 +35,8 @@ SEAP_desctable_t *SEAP_desctable_new (void)
 	SEAP_desctable_t *t = malloc(sizeof(SEAP_desctable_t));
         t->tree = NULL;
         t->bmap = NULL;
+        t->next_id  = 0;
+        t->next_cid = 0;
 
         return(t);
 }
@@ -59,14 +61,12 @@ int SEAP_desc_add(SEAP_desctable_t *sd_table, SEAP_scheme_t scheme,
 
 		sd_dsc = malloc(sizeof(SEAP_desc_t));
 
-                sd_dsc->next_id = 0;
                 /* sd_dsc->sexpcnt = 0; */
                 sd_dsc->scheme  = scheme;
                 sd_dsc->scheme_data = scheme_data;
-                sd_dsc->next_cid = 0;
                 sd_dsc->cmd_c_table = SEAP_cmdtbl_new ();
                 sd_dsc->cmd_w_table = SEAP_cmdtbl_new ();
-		sd_dsc->msg_queue = NULL;
+		sd_dsc->msg_queue = rbt_i32_new();
 		sd_dsc->err_queue = rbt_i32_new();
 		sd_dsc->cmd_queue = NULL;
 
@@ -119,6 +119,11 @@ static void __SEAP_desc_errqueue_free_cb(struct rbt_i32_node *n)
     SEAP_error_free(n->data);
 }
 
+static void __SEAP_desc_msgqueue_free_cb(struct rbt_i32_node *n)
+{
+	SEAP_msg_free(n->data);
+}
+
 void SEAP_desc_free(SEAP_desc_t *dsc)
 {
         SEAP_cmdtbl_free(dsc->cmd_c_table);
@@ -127,6 +132,7 @@ void SEAP_desc_free(SEAP_desc_t *dsc)
         pthread_mutex_destroy(&(dsc->r_lock));
         pthread_mutex_destroy(&(dsc->w_lock));
 	rbt_i32_free_cb(dsc->err_queue, __SEAP_desc_errqueue_free_cb);
+	rbt_i32_free_cb(dsc->msg_queue, __SEAP_desc_msgqueue_free_cb);
 	free(dsc);
 }
 
@@ -161,38 +167,30 @@ SEAP_desc_t *SEAP_desc_get (SEAP_desctable_t *sd_table, int sd)
         return(dsc);
 }
 
+/*
+ * The IDs are unique within the whole descriptor table, so there's no need
+ * to look up (and lock) the descriptor to generate one.
+ */
 SEAP_msgid_t SEAP_desc_genmsgid (SEAP_desctable_t *sd_table, int sd)
 {
-        SEAP_desc_t *dsc;
-        SEAP_msgid_t  id;
-        dsc = SEAP_desc_get (sd_table, sd);
-
-        if (dsc == NULL) {
+        if (sd < 0) {
                 errno = EINVAL;
                 return (-1);
         }
 
 #if SEAP_MSGID_BITS == 64
-        id = SEXP_atomic_inc_u64 (&(dsc->next_id));
+        return SEXP_atomic_inc_u64 (&(sd_table->next_id));
 #else
-        id = SEXP_atomic_inc_u32 (&(dsc->next_id));
+        return SEXP_atomic_inc_u32 (&(sd_table->next_id));
 #endif
-        return (id);
 }
 
 SEAP_cmdid_t SEAP_desc_gencmdid (SEAP_desctable_t *sd_table, int sd)
 {
-        SEAP_desc_t *dsc;
-        SEAP_cmdid_t  id;
-
-        dsc = SEAP_desc_get (sd_table, sd);
-
-        if (dsc == NULL) {
+        if (sd < 0) {
                 errno = EINVAL;
                 return (-1);
         }
 
-        id = SEXP_atomic_inc_u16 (&(dsc->next_cid));
-
-        return (id);
+        return SEXP_atomic_inc_u16 (&(sd_table->next_cid));
 }
@@ -38,15 +38,17 @@
 
 typedef uint8_t SEAP_scheme_t;
 
+#define SCH_QUEUE 4 /* probe thread, see sch_queue.h */
+#define SCH_SHM   5 /* probe worker process, see sch_shm.h */
+
 /*
  * Descriptor table + related stuff
  */
 typedef struct {
-        SEAP_msgid_t   next_id;
         SEAP_scheme_t  scheme; /* Protocol/Scheme used for this descriptor */
         void          *scheme_data; /* Protocol/Scheme related data */
 
-        SEXP_t *msg_queue;
+	rbt_t  *msg_queue;
 	rbt_t  *err_queue;
         SEXP_t *cmd_queue;
 
@@ -55,7 +57,6 @@ typedef struct {
         pthread_mutex_t w_lock;
         pthread_mutex_t r_lock;
 
-        SEAP_cmdid_t   next_cid;
         SEAP_cmdtbl_t *cmd_c_table; /* Local SEAP commands */
         SEAP_cmdtbl_t *cmd_w_table; /* Waiting SEAP commands */
     oval_subtype_t subtype;
@@ -66,7 +67,7 @@ typedef struct {
 #define SEAP_DESC_FDOUT 0x00000002
 #define SEAP_DESC_SELF  -1
 
-#define SEAP_DESCTBL_INITIALIZER { NULL, NULL }
+#define SEAP_DESCTBL_INITIALIZER { NULL, NULL, 0, 0 }
 
 #define SEAP_BUFFER_SIZE 2*4096
 #define SEAP_MAX_OPENDESC 128
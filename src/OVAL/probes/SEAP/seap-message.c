@@ -29,27 +29,42 @@
 #include "_sexp-types.h"
 #include "_seap-types.h"
 #include "_seap-message.h"
+#include "_seap-pool.h"
 #include "debug_priv.h"
 
 SEAP_msg_t *SEAP_msg_new (void)
 {
-	SEAP_msg_t *new = malloc(sizeof(SEAP_msg_t));
+	SEAP_msg_t *new = SEAP_pool_alloc(SEAP_POOL_MSG);
         new->id = 0;
         new->attrs = NULL;
         new->attrs_cnt = 0;
+        new->attrs_max = 0;
         new->sexp = NULL;
 
         return (new);
 }
 
+/*
+ * Take over the content of a message embedded in another structure,
+ * e.g. in a received packet.
+ */
+SEAP_msg_t *SEAP_msg_move (SEAP_msg_t *msg)
+{
+	SEAP_msg_t *new = SEAP_pool_alloc(SEAP_POOL_MSG);
+        memcpy (new, msg, sizeof (SEAP_msg_t));
+
+        return (new);
+}
+
 SEAP_msg_t *SEAP_msg_clone (SEAP_msg_t *msg)
 {
         uint16_t i;
 
-	SEAP_msg_t *new = malloc(sizeof(SEAP_msg_t));
+	SEAP_msg_t *new = SEAP_pool_alloc(SEAP_POOL_MSG);
         memcpy (new, msg, sizeof (SEAP_msg_t));
 
 	new->attrs = malloc(sizeof(SEAP_attr_t) * new->attrs_cnt);
+        new->attrs_max = new->attrs_cnt;
 
         for (i = 0; i < new->attrs_cnt; ++i) {
                 new->attrs[i].name  = strdup (msg->attrs[i].name);
@@ -82,7 +97,7 @@ void SEAP_msg_free (SEAP_msg_t *msg)
         if (msg->sexp != NULL)
                 SEXP_free (msg->sexp);
 
-	free(msg);
+	SEAP_pool_free(SEAP_POOL_MSG, msg);
         return;
 }
 
@@ -118,10 +133,17 @@ int SEAP_msgattr_set (SEAP_msg_t *msg, const char *attr, SEXP_t *value)
         if (value != NULL)
                 SEXP_VALIDATE(value);
 #endif
-        void *new_attrs = realloc(msg->attrs, sizeof(SEAP_attr_t) * (++msg->attrs_cnt));
-        if (new_attrs == NULL)
-                return -1;
-        msg->attrs = new_attrs;
+        if (msg->attrs_cnt >= msg->attrs_max) {
+                /* grow in steps, most of the messages get a couple of attributes */
+                uint16_t new_max = msg->attrs_cnt < 2 ? 4 : 2 * msg->attrs_cnt;
+                void *new_attrs = realloc(msg->attrs, sizeof(SEAP_attr_t) * new_max);
+                if (new_attrs == NULL)
+                        return -1;
+                msg->attrs = new_attrs;
+                msg->attrs_max = new_max;
+        }
+
+        ++msg->attrs_cnt;
         msg->attrs[msg->attrs_cnt - 1].name  = strdup (attr);
         msg->attrs[msg->attrs_cnt - 1].value = (value != NULL ? SEXP_ref (value) : NULL);
 
@@ -147,3 +169,18 @@ bool SEAP_msgattr_exists (SEAP_msg_t *msg, const char *name)
         return (false);
 }
 
+SEXP_t *SEAP_msgattr_get (SEAP_msg_t *msg, const char *name)
+{
+        uint16_t i;
+
+        _A(msg  != NULL);
+        _A(name != NULL);
+
+        for (i = 0; i < msg->attrs_cnt; ++i) {
+                if (strcmp (name, msg->attrs[i].name) == 0)
+                        return (msg->attrs[i].value != NULL ? SEXP_ref (msg->attrs[i].value) : NULL);
+        }
+
+        return (NULL);
+}
+
@@ -33,13 +33,17 @@
 #include "_seap-packetq.h"
 #include "_seap-packet.h"
 #include "_seap-types.h"
+#include "_seap-pool.h"
 #include "seap-descriptor.h"
 #include "sch_queue.h"
+#include "sch_shm.h"
 #include "debug_priv.h"
+#include "stats_priv.h"
+#include "trace_priv.h"
 
 SEAP_packet_t *SEAP_packet_new (void)
 {
-	SEAP_packet_t *p = malloc(sizeof(SEAP_packet_t));
+	SEAP_packet_t *p = SEAP_pool_alloc(SEAP_POOL_PACKET);
         memset (p, 0, sizeof (SEAP_packet_t));
         p->type = SEAP_PACKET_INV;
 
@@ -48,7 +52,7 @@ SEAP_packet_t *SEAP_packet_new (void)
 
 void SEAP_packet_free (SEAP_packet_t *packet)
 {
-	free(packet);
+	SEAP_pool_free(SEAP_POOL_PACKET, packet);
 }
 
 void *SEAP_packet_settype (SEAP_packet_t *packet, uint8_t type)
@@ -107,6 +111,7 @@ static int SEAP_packet_sexp2msg (SEXP_t *sexp_msg, SEAP_msg_t *seap_msg)
         msg_icnt = SEXP_list_length (sexp_msg);
 
         seap_msg->attrs_cnt = msg_icnt - 4;
+        seap_msg->attrs_max = seap_msg->attrs_cnt;
 	seap_msg->attrs = malloc(sizeof (SEAP_attr_t) * seap_msg->attrs_cnt);
 
         for (msg_n = 2, attr_i = 0; msg_n < msg_icnt; ++msg_n) {
@@ -660,7 +665,16 @@ int SEAP_packet_recv (SEAP_CTX_t *ctx, int sd, SEAP_packet_t **packet)
         }
 eloop_exit:
 
-	sexp_buffer = sch_queue_recvsexp(dsc);
+	if (dsc->scheme == SCH_SHM)
+		sexp_buffer = sch_shm_recvsexp(dsc);
+	else
+		sexp_buffer = sch_queue_recvsexp(dsc);
+
+	if (sexp_buffer == NULL) {
+		dE("The connection to the probe was lost: dsc=%p.", dsc);
+		errno = ECONNRESET;
+		return (-1);
+	}
 	SEXP_VALIDATE(sexp_buffer);
 
 	(*packet) = NULL;
@@ -792,6 +806,8 @@ eloop_exit:
 
 
 		dD("Received packet");
+		oscap_stats_add(OSCAP_STATS_SEAP_RECEIVED, 1);
+		OSCAP_TRACE2(seap__recv, sd, _packet->type);
 		dO(OSCAP_DEBUGOBJ_SEXP, sexp_packet);
 		dD("packet size: %zu", SEXP_sizeof(sexp_packet));
 
@@ -866,12 +882,17 @@ int SEAP_packet_send (SEAP_CTX_t *ctx, int sd, SEAP_packet_t *packet)
 	if (DESC_WLOCK(dsc) == 1) {
                 ret = 0;
 
-		if (sch_queue_sendsexp(dsc, packet_sexp, 0) < 0) {
+		if ((dsc->scheme == SCH_SHM ?
+		     sch_shm_sendsexp(dsc, packet_sexp, 0) :
+		     sch_queue_sendsexp(dsc, packet_sexp, 0)) < 0) {
                         ret = -1;
 
                         protect_errno {
                                 dD("FAIL: errno=%u, %s.", errno, strerror (errno));
                         }
+                } else {
+                        oscap_stats_add(OSCAP_STATS_SEAP_SENT, 1);
+                        OSCAP_TRACE2(seap__send, sd, packet->type);
                 }
 
 		if (DESC_WUNLOCK(dsc) != 1) {
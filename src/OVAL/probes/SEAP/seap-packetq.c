@@ -4,6 +4,7 @@
 #include <errno.h>
 #include "_seap-packet.h"
 #include "_seap-packetq.h"
+#include "_seap-pool.h"
 
 int SEAP_packetq_init(SEAP_packetq_t *queue)
 {
@@ -33,7 +34,7 @@ void SEAP_packetq_free(SEAP_packetq_t *queue)
 
 struct SEAP_packetq_item *SEAP_packetq_item_new(void)
 {
-	struct SEAP_packetq_item *i = malloc(sizeof(struct SEAP_packetq_item));
+	struct SEAP_packetq_item *i = SEAP_pool_alloc(SEAP_POOL_PACKETQ_ITEM);
 
 	i->next   = NULL;
 	i->prev   = NULL;
@@ -51,7 +52,7 @@ void SEAP_packetq_item_free(struct SEAP_packetq_item *i, bool freepacket)
 	i->next   = NULL;
 	i->packet = NULL;
 
-	free(i);
+	SEAP_pool_free(SEAP_POOL_PACKETQ_ITEM, i);
 }
 
 int SEAP_packetq_get(SEAP_packetq_t *queue, SEAP_packet_t **packet_dst)
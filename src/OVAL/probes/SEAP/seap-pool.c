@@ -0,0 +1,129 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "_seap-pool.h"
+#include "_seap-packet.h"
+#include "_seap-packetq.h"
+#include "_seap-message.h"
+#include "_seap-command.h"
+
+struct SEAP_pool_obj {
+        struct SEAP_pool_obj *next;
+};
+
+struct SEAP_pool_cache {
+        struct SEAP_pool_obj *head[SEAP_POOL_TYPES];
+        uint16_t              count[SEAP_POOL_TYPES];
+};
+
+static const size_t SEAP_pool_objsize[SEAP_POOL_TYPES] = {
+        [SEAP_POOL_PACKET]       = sizeof(SEAP_packet_t),
+        [SEAP_POOL_PACKETQ_ITEM] = sizeof(struct SEAP_packetq_item),
+        [SEAP_POOL_MSG]          = sizeof(SEAP_msg_t),
+        [SEAP_POOL_CMDREC]       = sizeof(SEAP_cmdrec_t),
+        [SEAP_POOL_CMDJOB]       = sizeof(SEAP_cmdjob_t)
+};
+
+static pthread_once_t SEAP_pool_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t  SEAP_pool_key;
+
+static void SEAP_pool_cache_free(void *arg)
+{
+        struct SEAP_pool_cache *cache = arg;
+        struct SEAP_pool_obj   *obj;
+        int t;
+
+        for (t = 0; t < SEAP_POOL_TYPES; ++t) {
+                while ((obj = cache->head[t]) != NULL) {
+                        cache->head[t] = obj->next;
+                        free(obj);
+                }
+        }
+
+        free(cache);
+}
+
+static void SEAP_pool_key_init(void)
+{
+        (void)pthread_key_create(&SEAP_pool_key, &SEAP_pool_cache_free);
+}
+
+static struct SEAP_pool_cache *SEAP_pool_cache_get(bool create)
+{
+        struct SEAP_pool_cache *cache;
+
+        (void)pthread_once(&SEAP_pool_key_once, &SEAP_pool_key_init);
+        cache = pthread_getspecific(SEAP_pool_key);
+
+        if (cache == NULL && create) {
+                cache = calloc(1, sizeof(struct SEAP_pool_cache));
+
+                if (cache != NULL && pthread_setspecific(SEAP_pool_key, cache) != 0) {
+                        free(cache);
+                        cache = NULL;
+                }
+        }
+
+        return (cache);
+}
+
+void *SEAP_pool_alloc(SEAP_pooltype_t type)
+{
+        struct SEAP_pool_cache *cache;
+        struct SEAP_pool_obj   *obj;
+
+        cache = SEAP_pool_cache_get(false);
+
+        if (cache != NULL && (obj = cache->head[type]) != NULL) {
+                cache->head[type] = obj->next;
+                --cache->count[type];
+
+                return (obj);
+        }
+
+        return malloc(SEAP_pool_objsize[type]);
+}
+
+void SEAP_pool_free(SEAP_pooltype_t type, void *obj)
+{
+        struct SEAP_pool_cache *cache;
+
+        if (obj == NULL)
+                return;
+
+        cache = SEAP_pool_cache_get(true);
+
+        if (cache == NULL || cache->count[type] >= SEAP_POOL_MAXFREE) {
+                free(obj);
+                return;
+        }
+
+        ((struct SEAP_pool_obj *)obj)->next = cache->head[type];
+        cache->head[type] = obj;
+        ++cache->count[type];
+}
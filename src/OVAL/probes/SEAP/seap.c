@@ -45,9 +45,9 @@
 #include "_seap-packet.h"
 #include "_seap.h"
 #include "seap-descriptor.h"
+#include "sch_shm.h"
 #include "debug_priv.h"
-
-#define SCH_QUEUE 4
+#include "oval_definitions.h"
 
 static void SEAP_CTX_initdefault (SEAP_CTX_t *ctx)
 {
@@ -113,6 +113,14 @@ int SEAP_connect(SEAP_CTX_t *ctx)
         }
 	dsc->subtype = ctx->subtype;
 
+	if (sch_shm_acquire()) {
+		if (sch_shm_connect(dsc) == 0) {
+			dsc->scheme = SCH_SHM;
+			return (sd);
+		}
+		dW("Running %s_probe in the library process.", oval_subtype_get_text(dsc->subtype));
+	}
+
 	if (sch_queue_connect(dsc) != 0) {
                 dD("FAIL: errno=%u, %s.", errno, strerror (errno));
                 SEAP_desc_del(ctx->sd_table, sd);
@@ -173,6 +181,20 @@ int SEAP_add_probe (SEAP_CTX_t *ctx, sch_queuedata_t *data)
     return sd;
 }
 
+sch_queue_call_t *SEAP_call (SEAP_CTX_t *ctx, int sd, SEXP_t *obj)
+{
+        SEAP_desc_t *dsc;
+
+        dsc = SEAP_desc_get (ctx->sd_table, sd);
+
+        if (dsc == NULL || dsc->scheme != SCH_QUEUE) {
+                errno = EBADF;
+                return (NULL);
+        }
+
+        return sch_queue_call(dsc, obj);
+}
+
 int SEAP_recvsexp (SEAP_CTX_t *ctx, int sd, SEXP_t **sexp)
 {
         SEAP_msg_t *msg = NULL;
@@ -368,8 +390,7 @@ int SEAP_recvmsg (SEAP_CTX_t *ctx, int sd, SEAP_msg_t **seap_msg)
                 switch (SEAP_packet_gettype (packet)) {
                 case SEAP_PACKET_MSG:
 
-			(*seap_msg) = malloc(sizeof(SEAP_msg_t));
-                        memcpy ((*seap_msg), SEAP_packet_msg (packet), sizeof (SEAP_msg_t));
+			(*seap_msg) = SEAP_msg_move (SEAP_packet_msg (packet));
 
 			SEAP_packet_free (packet);
                         return (0);
@@ -409,6 +430,124 @@ int SEAP_recvmsg (SEAP_CTX_t *ctx, int sd, SEAP_msg_t **seap_msg)
         return (-1);
 }
 
+static int __SEAP_msg_replyid (SEAP_msg_t *msg, SEAP_msgid_t *id)
+{
+        SEXP_t *r0;
+
+        r0 = SEAP_msgattr_get (msg, "reply-id");
+
+        if (r0 == NULL)
+                return (-1);
+#if SEAP_MSGID_BITS == 64
+        *id = SEXP_number_getu_64 (r0);
+#else
+        *id = SEXP_number_getu_32 (r0);
+#endif
+        SEXP_free (r0);
+
+        return (0);
+}
+
+/**
+ * Receive the reply to the message with ID `id' sent on `sd'.
+ * Replies to other messages which arrive in the meantime are queued
+ * in the descriptor and handed over by a later call with a matching ID.
+ * Errors are handled the same way, an error caused by the message with
+ * ID `id' makes this function fail with errno set to ECANCELED and the
+ * error can be retrieved using SEAP_recverr_byid.
+ */
+int SEAP_recvmsg_byid (SEAP_CTX_t *ctx, int sd, SEAP_msgid_t id, SEAP_msg_t **seap_msg)
+{
+        SEAP_desc_t   *sd_desc;
+        SEAP_packet_t *packet;
+        SEAP_msg_t    *msg;
+        SEAP_msgid_t   rid;
+        void          *data;
+
+        _A(ctx      != NULL);
+        _A(seap_msg != NULL);
+
+        (*seap_msg) = NULL;
+        sd_desc = SEAP_desc_get (ctx->sd_table, sd);
+
+        if (sd_desc == NULL) {
+                errno = EBADF;
+                return (-1);
+        }
+
+        /*
+         * Packet loop. Both queues are checked before each receive because
+         * the commands processed below may receive (and queue) the reply
+         * this call is waiting for.
+         */
+        for (;;) {
+                /* XXX: handle 64bit message ids */
+                data = NULL;
+
+                if (rbt_i32_del (sd_desc->msg_queue, (uint32_t)id, &data) == 0) {
+                        (*seap_msg) = (SEAP_msg_t *)data;
+                        return (0);
+                }
+
+                if (rbt_i32_get (sd_desc->err_queue, (uint32_t)id, &data) == 0) {
+                        errno = ECANCELED;
+                        return (-1);
+                }
+
+                if (SEAP_packet_recv (ctx, sd, &packet) != 0) {
+			protect_errno {
+				dD("FAIL: ctx=%p, sd=%d, errno=%u, %s.",
+				   ctx, sd, errno, strerror (errno));
+			}
+                        return (-1);
+                }
+
+                switch (SEAP_packet_gettype (packet)) {
+                case SEAP_PACKET_MSG:
+			msg = SEAP_msg_move (SEAP_packet_msg (packet));
+			SEAP_packet_free (packet);
+
+                        if (__SEAP_msg_replyid (msg, &rid) != 0 || rid == id) {
+                                (*seap_msg) = msg;
+                                return (0);
+                        }
+
+                        if (rbt_i32_add (sd_desc->msg_queue, (uint32_t)rid, msg, NULL) != 0) {
+                                dW("Dropping a duplicate reply to message %u on sd=%d.", (uint32_t)rid, sd);
+                                SEAP_msg_free (msg);
+                        }
+                        continue;
+                case SEAP_PACKET_CMD:
+                        switch (__SEAP_recvmsg_process_cmd (ctx, sd, SEAP_packet_cmd (packet))) {
+                        case  0:
+                                SEAP_packet_free (packet);
+                                continue;
+                        default:
+                                errno = EDOOFUS;
+                                return (-1);
+                        }
+                case SEAP_PACKET_ERR:
+                        switch (__SEAP_recvmsg_process_err (ctx, sd, SEAP_packet_err (packet))) {
+                        case 0:
+                                SEAP_packet_free (packet);
+                                continue;
+                        case -1:
+                                SEAP_packet_free (packet);
+                                return (-1);
+                        default:
+                                errno = EDOOFUS;
+                                return (-1);
+                        }
+                default:
+                        abort ();
+                }
+        }
+
+        /* NOTREACHED */
+        errno = EDOOFUS;
+        return (-1);
+}
+
 int SEAP_sendmsg (SEAP_CTX_t *ctx, int sd, SEAP_msg_t *seap_msg)
 {
         int ret;
@@ -609,7 +748,10 @@ int SEAP_close (SEAP_CTX_t *ctx, int sd)
                 return (-1);
         }
 
-	ret = sch_queue_close(dsc, 0); /* TODO: Are flags usable here? */
+	if (dsc->scheme == SCH_SHM)
+		ret = sch_shm_close(dsc, 0);
+	else
+		ret = sch_queue_close(dsc, 0); /* TODO: Are flags usable here? */
 
         protect_errno {
                 if (SEAP_desc_del (ctx->sd_table, sd) != 0) {
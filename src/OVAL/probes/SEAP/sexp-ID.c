@@ -46,51 +46,77 @@
 
 #include "MurmurHash3.h"
 
-static SEXP_ID_t SEXP_ID_hash(void *buf, size_t len, SEXP_ID_t seed, int part)
+#define SEXP_ID_SEED 0xAD30917100C0FFEE
+
+static SEXP_ID_t SEXP_ID_hash(const void *buf, size_t len, SEXP_ID_t seed)
 {
         uint64_t resbuf[2];
 
-	if (part != 0 && part != 1) {
-		return -1;
-	}
-
         MurmurHash3_x86_128(buf, (int)len, (uint32_t)((0x7C0FFEE7 ^ seed) ^ (seed >> 32)), resbuf);
 
-        return (resbuf[part]);
+        return (resbuf[0]);
 }
 
-static int SEXP_ID_v_callback(const SEXP_t *sexp, __IDres_pair *pair)
+static SEXP_ID_t SEXP_ID_value(uintptr_t s_valp);
+
+static int SEXP_ID_v_callback(const SEXP_t *sexp, SEXP_ID_t *hash)
 {
-        SEXP_val_t v_dsc;
+        SEXP_ID_t memb_hash;
 
-	if (sexp == NULL || pair == NULL) {
+	if (sexp == NULL || hash == NULL) {
 		return -1;
 	}
 
+        memb_hash = SEXP_ID_value(sexp->s_valp);
+        *hash = SEXP_ID_hash(&memb_hash, sizeof memb_hash, *hash);
+
+        return (0);
+}
+
+/*
+ * The hash of a list is computed from the hashes of its members, so it
+ * can be memoized in the list value and reused by every list containing
+ * it. The list functions which modify a list in place drop its memoized
+ * hash, shared values are copied before they are modified.
+ */
+static SEXP_ID_t SEXP_ID_value(uintptr_t s_valp)
+{
+        SEXP_val_t v_dsc;
+        SEXP_ID_t  hash;
+
         /*
          * Fill v_dsc with metainformation
          */
-        SEXP_val_dsc(&v_dsc, sexp->s_valp);
+        SEXP_val_dsc(&v_dsc, s_valp);
 
         switch (v_dsc.type) {
         case SEXP_VALTYPE_NUMBER:
         case SEXP_VALTYPE_STRING:
-                pair->hash = SEXP_ID_hash(v_dsc.mem, v_dsc.hdr->size, pair->hash, pair->part);
-                break;
+                return SEXP_ID_hash(v_dsc.mem, v_dsc.hdr->size, SEXP_ID_SEED + v_dsc.type);
         case SEXP_VALTYPE_LIST:
         {
-                SEXP_rawval_lblk_cb ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr,
+                struct SEXP_val_list *list = SEXP_LCASTP(v_dsc.mem);
+
+                if (list->hash != 0)
+                        return (list->hash);
+
+                hash = SEXP_ID_SEED + v_dsc.type;
+
+                SEXP_rawval_lblk_cb ((uintptr_t)list->b_addr,
                                      (int (*)(SEXP_t *, void *)) SEXP_ID_v_callback,
-                                     (void *) pair,
-                                     SEXP_LCASTP(v_dsc.mem)->offset + 1);
+                                     (void *) &hash,
+                                     list->offset + 1);
 
-                pair->hash = SEXP_ID_hash(&pair->hash, 1,
-					  pair->hash + SEXP_LCASTP(v_dsc.mem)->offset, pair->part);
-                break;
+                hash = SEXP_ID_hash(&hash, sizeof hash, list->length);
+
+                /* 0 means "not computed" */
+                list->hash = (hash != 0 ? hash : 1);
+
+                return (list->hash);
         }
         case SEXP_VALTYPE_EMPTY:
-                pair->hash = SEXP_ID_hash(&pair->hash, 1, pair->hash, pair->part);
-                break;
+                hash = SEXP_ID_SEED;
+                return SEXP_ID_hash(&hash, sizeof hash, SEXP_ID_SEED + v_dsc.type);
         default:
                 /* Unknown S-exp value type */
                 abort ();
@@ -101,14 +127,19 @@ static int SEXP_ID_v_callback(const SEXP_t *sexp, __IDres_pair *pair)
 
 SEXP_ID_t SEXP_ID_v(const SEXP_t *s)
 {
-	__IDres_pair pair;
+        return SEXP_ID_value(s->s_valp);
+}
+
+SEXP_ID_t SEXP_ID_memo(const SEXP_t *s)
+{
+        SEXP_val_t v_dsc;
 
-        pair.hash = 0xAD30917100C0FFEE;
-	pair.part = 0;
+        SEXP_val_dsc(&v_dsc, s->s_valp);
 
-        SEXP_ID_v_callback(s, &pair);
+        if (v_dsc.type != SEXP_VALTYPE_LIST)
+                return (0);
 
-        return (pair.hash);
+        return (SEXP_LCASTP(v_dsc.mem)->hash);
 }
 
 /// @}
@@ -0,0 +1,792 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Layout of the encoding:
+ *
+ *   "SEXB" version:u8
+ *   count:uvarint { length:uvarint bytes }*count      -- string table
+ *   value
+ *
+ * value := tag:u8 [datatype:uvarint] payload
+ *
+ * The low bits of the tag select the payload, SEXP_BIN_TAG_DATATYPE
+ * means that the index of the datatype name in the string table
+ * precedes it:
+ *
+ *   EMPTY      -
+ *   LIST       count:uvarint value*count
+ *   STRING     length:uvarint bytes
+ *   STRING_REF index:uvarint
+ *   NUMBER     type:u8 bool:u8 | signed:zigzag uvarint | unsigned:uvarint | double:8 bytes LE
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "_sexp-types.h"
+#include "_sexp-value.h"
+#include "public/sexp-manip.h"
+#include "public/sexp-binary.h"
+#include "generic/rbt/rbt.h"
+#include "debug_priv.h"
+
+#define SEXP_BIN_MAGIC   "SEXB"
+#define SEXP_BIN_VERSION 1
+
+#define SEXP_BIN_TAG_EMPTY      0x00
+#define SEXP_BIN_TAG_LIST       0x01
+#define SEXP_BIN_TAG_STRING     0x02
+#define SEXP_BIN_TAG_STRING_REF 0x03
+#define SEXP_BIN_TAG_NUMBER     0x04
+#define SEXP_BIN_TAG_MASK       0x0f
+#define SEXP_BIN_TAG_DATATYPE   0x80
+
+/** Longest string which is considered for the string table */
+#define SEXP_BIN_INTERN_MAXLEN 128
+/** Maximum nesting of lists accepted by the decoder */
+#define SEXP_BIN_MAXDEPTH      4096
+
+/*
+ * Encoder
+ */
+struct SEXP_bin_string {
+	char    *key;
+	uint32_t count;
+	uint32_t index; /* index in the string table, UINT32_MAX if inlined */
+};
+
+struct SEXP_bin_enc {
+	uint8_t *buf;
+	size_t   len;
+	size_t   size;
+
+	rbt_t   *strmap;  /* key -> position in str + 1 */
+	struct SEXP_bin_string *str;
+	size_t   str_count;
+	size_t   str_size;
+	uint32_t table_count;
+	int      error;
+};
+
+static void enc_bytes(struct SEXP_bin_enc *enc, const void *data, size_t len)
+{
+	if (enc->error != 0)
+		return;
+
+	if (enc->len + len > enc->size) {
+		size_t size = enc->size > 0 ? enc->size : 256;
+		uint8_t *buf;
+
+		while (size < enc->len + len)
+			size *= 2;
+
+		buf = realloc(enc->buf, size);
+
+		if (buf == NULL) {
+			enc->error = ENOMEM;
+			return;
+		}
+
+		enc->buf = buf;
+		enc->size = size;
+	}
+
+	memcpy(enc->buf + enc->len, data, len);
+	enc->len += len;
+}
+
+static void enc_byte(struct SEXP_bin_enc *enc, uint8_t b)
+{
+	enc_bytes(enc, &b, 1);
+}
+
+static void enc_uvarint(struct SEXP_bin_enc *enc, uint64_t v)
+{
+	uint8_t b[10];
+	size_t  n = 0;
+
+	while (v >= 0x80) {
+		b[n++] = (uint8_t)(v | 0x80);
+		v >>= 7;
+	}
+	b[n++] = (uint8_t)v;
+
+	enc_bytes(enc, b, n);
+}
+
+static struct SEXP_bin_string *enc_string_lookup(struct SEXP_bin_enc *enc, const char *key)
+{
+	void *pos;
+
+	if (rbt_str_get(enc->strmap, key, &pos) != 0)
+		return NULL;
+
+	return &enc->str[(uintptr_t)pos - 1];
+}
+
+/*
+ * Look up the entry of a string value. Only short strings without
+ * embedded NUL characters can be stored in the string table.
+ */
+static struct SEXP_bin_string *enc_string_get(struct SEXP_bin_enc *enc, const char *str, size_t len)
+{
+	char key[SEXP_BIN_INTERN_MAXLEN + 1];
+
+	if (len > SEXP_BIN_INTERN_MAXLEN || memchr(str, '\0', len) != NULL)
+		return NULL;
+
+	memcpy(key, str, len);
+	key[len] = '\0';
+
+	return enc_string_lookup(enc, key);
+}
+
+static void enc_string_count(struct SEXP_bin_enc *enc, const char *str, size_t len, uint32_t inc)
+{
+	struct SEXP_bin_string *s;
+	char *key;
+
+	if (memchr(str, '\0', len) != NULL)
+		return;
+
+	key = malloc(len + 1);
+
+	if (key == NULL) {
+		enc->error = ENOMEM;
+		return;
+	}
+
+	memcpy(key, str, len);
+	key[len] = '\0';
+
+	s = enc_string_lookup(enc, key);
+
+	if (s != NULL) {
+		s->count += inc;
+		free(key);
+		return;
+	}
+
+	if (enc->str_count == enc->str_size) {
+		size_t size = enc->str_size > 0 ? enc->str_size * 2 : 64;
+		struct SEXP_bin_string *n_str = realloc(enc->str, size * sizeof(struct SEXP_bin_string));
+
+		if (n_str == NULL) {
+			free(key);
+			enc->error = ENOMEM;
+			return;
+		}
+
+		enc->str = n_str;
+		enc->str_size = size;
+	}
+
+	if (rbt_str_add(enc->strmap, key, (void *)(uintptr_t)(enc->str_count + 1)) != 0) {
+		free(key);
+		enc->error = ENOMEM;
+		return;
+	}
+
+	s = &enc->str[enc->str_count++];
+	s->key = key;
+	s->count = inc;
+	s->index = UINT32_MAX;
+}
+
+static int enc_count_cb(SEXP_t *s_exp, struct SEXP_bin_enc *enc)
+{
+	SEXP_val_t v_dsc;
+	const char *dt;
+
+	/* datatype names are always stored in the string table */
+	if ((dt = SEXP_datatype(s_exp)) != NULL)
+		enc_string_count(enc, dt, strlen(dt), 2);
+
+	SEXP_val_dsc(&v_dsc, s_exp->s_valp);
+
+	switch (v_dsc.type) {
+	case SEXP_VALTYPE_STRING:
+		if (v_dsc.hdr->size <= SEXP_BIN_INTERN_MAXLEN)
+			enc_string_count(enc, v_dsc.mem, v_dsc.hdr->size, 1);
+		break;
+	case SEXP_VALTYPE_LIST:
+		SEXP_rawval_lblk_cb((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr,
+				    (int (*)(SEXP_t *, void *))enc_count_cb, enc,
+				    SEXP_LCASTP(v_dsc.mem)->offset + 1);
+		break;
+	}
+
+	return (enc->error != 0 ? -1 : 0);
+}
+
+static int enc_value_cb(SEXP_t *s_exp, struct SEXP_bin_enc *enc)
+{
+	SEXP_val_t v_dsc;
+	struct SEXP_bin_string *s, *dts = NULL;
+	const char *dt;
+	uint8_t flags = 0;
+
+	if ((dt = SEXP_datatype(s_exp)) != NULL) {
+		dts = enc_string_lookup(enc, dt);
+
+		if (dts == NULL || dts->index == UINT32_MAX) {
+			dE("Datatype name \"%s\" is missing in the string table", dt);
+			enc->error = EINVAL;
+			return (-1);
+		}
+		flags = SEXP_BIN_TAG_DATATYPE;
+	}
+
+	SEXP_val_dsc(&v_dsc, s_exp->s_valp);
+
+#define ENC_TAG(t)						\
+	do {							\
+		enc_byte(enc, (t) | flags);			\
+		if (dts != NULL)				\
+			enc_uvarint(enc, dts->index);		\
+	} while (0)
+
+	switch (v_dsc.type) {
+	case SEXP_VALTYPE_EMPTY:
+		ENC_TAG(SEXP_BIN_TAG_EMPTY);
+		break;
+	case SEXP_VALTYPE_STRING:
+		s = enc_string_get(enc, v_dsc.mem, v_dsc.hdr->size);
+
+		if (s != NULL && s->index != UINT32_MAX) {
+			ENC_TAG(SEXP_BIN_TAG_STRING_REF);
+			enc_uvarint(enc, s->index);
+		} else {
+			ENC_TAG(SEXP_BIN_TAG_STRING);
+			enc_uvarint(enc, v_dsc.hdr->size);
+			enc_bytes(enc, v_dsc.mem, v_dsc.hdr->size);
+		}
+		break;
+	case SEXP_VALTYPE_NUMBER:
+	{
+		SEXP_numtype_t t = SEXP_NTYPEP(v_dsc.hdr->size, v_dsc.mem);
+		int64_t  i;
+		uint64_t u;
+		uint8_t  d[8];
+		double   f;
+		int      k;
+
+		ENC_TAG(SEXP_BIN_TAG_NUMBER);
+		enc_byte(enc, t);
+
+		switch (t) {
+		case SEXP_NUM_BOOL:
+			enc_byte(enc, SEXP_NCASTP(b, v_dsc.mem)->n ? 1 : 0);
+			break;
+		case SEXP_NUM_INT8:
+		case SEXP_NUM_INT16:
+		case SEXP_NUM_INT32:
+		case SEXP_NUM_INT64:
+			switch (t) {
+			case SEXP_NUM_INT8:  i = SEXP_NCASTP(i8,  v_dsc.mem)->n; break;
+			case SEXP_NUM_INT16: i = SEXP_NCASTP(i16, v_dsc.mem)->n; break;
+			case SEXP_NUM_INT32: i = SEXP_NCASTP(i32, v_dsc.mem)->n; break;
+			default:             i = SEXP_NCASTP(i64, v_dsc.mem)->n; break;
+			}
+			enc_uvarint(enc, ((uint64_t)i << 1) ^ (uint64_t)(i >> 63));
+			break;
+		case SEXP_NUM_UINT8:
+		case SEXP_NUM_UINT16:
+		case SEXP_NUM_UINT32:
+		case SEXP_NUM_UINT64:
+			switch (t) {
+			case SEXP_NUM_UINT8:  u = SEXP_NCASTP(u8,  v_dsc.mem)->n; break;
+			case SEXP_NUM_UINT16: u = SEXP_NCASTP(u16, v_dsc.mem)->n; break;
+			case SEXP_NUM_UINT32: u = SEXP_NCASTP(u32, v_dsc.mem)->n; break;
+			default:              u = SEXP_NCASTP(u64, v_dsc.mem)->n; break;
+			}
+			enc_uvarint(enc, u);
+			break;
+		case SEXP_NUM_DOUBLE:
+			f = SEXP_NCASTP(f, v_dsc.mem)->n;
+			memcpy(&u, &f, sizeof u);
+			for (k = 0; k < 8; ++k)
+				d[k] = (uint8_t)(u >> (8 * k));
+			enc_bytes(enc, d, sizeof d);
+			break;
+		default:
+			dE("Unknown number type: %u", (unsigned int)t);
+			enc->error = EINVAL;
+			return (-1);
+		}
+		break;
+	}
+	case SEXP_VALTYPE_LIST:
+		ENC_TAG(SEXP_BIN_TAG_LIST);
+		enc_uvarint(enc, SEXP_rawval_list_length(SEXP_LCASTP(v_dsc.mem)));
+		SEXP_rawval_lblk_cb((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr,
+				    (int (*)(SEXP_t *, void *))enc_value_cb, enc,
+				    SEXP_LCASTP(v_dsc.mem)->offset + 1);
+		break;
+	default:
+		enc->error = EINVAL;
+		return (-1);
+	}
+#undef ENC_TAG
+
+	return (enc->error != 0 ? -1 : 0);
+}
+
+int SEXP_bin_encode(const SEXP_t *s_exp, void **buf, size_t *len)
+{
+	struct SEXP_bin_enc enc;
+	size_t i;
+
+	if (s_exp == NULL || buf == NULL || len == NULL) {
+		errno = EFAULT;
+		return (-1);
+	}
+
+	memset(&enc, 0, sizeof enc);
+	enc.strmap = rbt_str_new();
+
+	if (enc.strmap == NULL) {
+		errno = ENOMEM;
+		return (-1);
+	}
+
+	/* PASS #1: find the strings which occur more than once */
+	enc_count_cb((SEXP_t *)s_exp, &enc);
+
+	for (i = 0; i < enc.str_count; ++i) {
+		if (enc.str[i].count > 1)
+			enc.str[i].index = enc.table_count++;
+	}
+
+	/* PASS #2: write the header, the string table and the value */
+	enc_bytes(&enc, SEXP_BIN_MAGIC, strlen(SEXP_BIN_MAGIC));
+	enc_byte(&enc, SEXP_BIN_VERSION);
+	enc_uvarint(&enc, enc.table_count);
+
+	for (i = 0; i < enc.str_count; ++i) {
+		if (enc.str[i].index != UINT32_MAX) {
+			size_t klen = strlen(enc.str[i].key);
+
+			enc_uvarint(&enc, klen);
+			enc_bytes(&enc, enc.str[i].key, klen);
+		}
+	}
+
+	if (enc.error == 0)
+		enc_value_cb((SEXP_t *)s_exp, &enc);
+
+	/* the keys are owned by the tree */
+	rbt_str_free(enc.strmap);
+	free(enc.str);
+
+	if (enc.error != 0) {
+		free(enc.buf);
+		errno = enc.error;
+		return (-1);
+	}
+
+	*buf = enc.buf;
+	*len = enc.len;
+
+	return (0);
+}
+
+/*
+ * Reader
+ */
+struct SEXP_bin_view {
+	const char *str;
+	size_t      len;
+};
+
+struct SEXP_bin_reader {
+	const uint8_t *buf;
+	size_t         len;
+	size_t         pos;
+
+	struct SEXP_bin_view *table;
+	uint32_t       table_count;
+
+	uint32_t      *stack; /* number of members left in the open lists */
+	size_t         depth;
+	bool           started;
+};
+
+static int rd_uvarint(SEXP_bin_reader_t *r, uint64_t *v)
+{
+	uint64_t res = 0;
+	unsigned int shift = 0;
+
+	while (r->pos < r->len && shift < 64) {
+		uint8_t b = r->buf[r->pos++];
+
+		res |= (uint64_t)(b & 0x7f) << shift;
+
+		if ((b & 0x80) == 0) {
+			*v = res;
+			return (0);
+		}
+		shift += 7;
+	}
+
+	return (-1);
+}
+
+static int rd_view(SEXP_bin_reader_t *r, struct SEXP_bin_view *view)
+{
+	uint64_t len;
+
+	if (rd_uvarint(r, &len) != 0 || len > r->len - r->pos)
+		return (-1);
+
+	view->str = (const char *)r->buf + r->pos;
+	view->len = (size_t)len;
+	r->pos += (size_t)len;
+
+	return (0);
+}
+
+static int rd_index(SEXP_bin_reader_t *r, struct SEXP_bin_view *view)
+{
+	uint64_t idx;
+
+	if (rd_uvarint(r, &idx) != 0 || idx >= r->table_count)
+		return (-1);
+
+	*view = r->table[idx];
+
+	return (0);
+}
+
+SEXP_bin_reader_t *SEXP_bin_reader_new(const void *buf, size_t len)
+{
+	SEXP_bin_reader_t *r;
+	uint64_t count, i;
+	size_t   mlen = strlen(SEXP_BIN_MAGIC);
+
+	if (buf == NULL) {
+		errno = EFAULT;
+		return (NULL);
+	}
+
+	if (len < mlen + 1 || memcmp(buf, SEXP_BIN_MAGIC, mlen) != 0 ||
+	    ((const uint8_t *)buf)[mlen] != SEXP_BIN_VERSION) {
+		errno = EINVAL;
+		return (NULL);
+	}
+
+	r = calloc(1, sizeof(SEXP_bin_reader_t));
+
+	if (r == NULL)
+		return (NULL);
+
+	r->buf = buf;
+	r->len = len;
+	r->pos = mlen + 1;
+
+	/* every entry takes at least one byte */
+	if (rd_uvarint(r, &count) != 0 || count > r->len - r->pos)
+		goto fail;
+
+	if (count > 0) {
+		r->table = malloc((size_t)count * sizeof(struct SEXP_bin_view));
+
+		if (r->table == NULL)
+			goto fail;
+	}
+
+	for (i = 0; i < count; ++i) {
+		if (rd_view(r, &r->table[i]) != 0)
+			goto fail;
+	}
+	r->table_count = (uint32_t)count;
+
+	return (r);
+fail:
+	SEXP_bin_reader_free(r);
+	errno = EINVAL;
+	return (NULL);
+}
+
+int SEXP_bin_reader_next(SEXP_bin_reader_t *r, SEXP_bin_token_t *tok)
+{
+	struct SEXP_bin_view view;
+	uint64_t v;
+	uint8_t  tag;
+
+	if (r == NULL || tok == NULL) {
+		errno = EFAULT;
+		return (-1);
+	}
+
+	while (r->depth > 0 && r->stack[r->depth - 1] == 0)
+		--r->depth;
+
+	memset(tok, 0, sizeof *tok);
+
+	if (r->depth == 0 && r->started) {
+		/* trailing garbage */
+		if (r->pos != r->len)
+			goto invalid;
+
+		tok->type = SEXP_BIN_END;
+		return (0);
+	}
+
+	if (r->depth > 0)
+		--r->stack[r->depth - 1];
+
+	r->started = true;
+
+	if (r->pos >= r->len)
+		goto invalid;
+
+	tag = r->buf[r->pos++];
+
+	if (tag & SEXP_BIN_TAG_DATATYPE) {
+		if (rd_index(r, &view) != 0)
+			goto invalid;
+
+		tok->datatype = view.str;
+		tok->datatype_len = view.len;
+	}
+
+	switch (tag & ~SEXP_BIN_TAG_DATATYPE) {
+	case SEXP_BIN_TAG_EMPTY:
+		tok->type = SEXP_BIN_EMPTY;
+		break;
+	case SEXP_BIN_TAG_STRING:
+	case SEXP_BIN_TAG_STRING_REF:
+		if ((tag & SEXP_BIN_TAG_MASK) == SEXP_BIN_TAG_STRING) {
+			if (rd_view(r, &view) != 0)
+				goto invalid;
+		} else if (rd_index(r, &view) != 0) {
+			goto invalid;
+		}
+
+		tok->type = SEXP_BIN_STRING;
+		tok->u.string.str = view.str;
+		tok->u.string.len = view.len;
+		break;
+	case SEXP_BIN_TAG_NUMBER:
+		if (r->pos >= r->len)
+			goto invalid;
+
+		tok->type = SEXP_BIN_NUMBER;
+		tok->u.number.type = r->buf[r->pos++];
+
+		switch (tok->u.number.type) {
+		case SEXP_NUM_BOOL:
+			if (r->pos >= r->len || r->buf[r->pos] > 1)
+				goto invalid;
+			tok->u.number.v.b = r->buf[r->pos++] != 0;
+			break;
+		case SEXP_NUM_INT8:
+		case SEXP_NUM_INT16:
+		case SEXP_NUM_INT32:
+		case SEXP_NUM_INT64:
+			if (rd_uvarint(r, &v) != 0)
+				goto invalid;
+			tok->u.number.v.i = (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+			break;
+		case SEXP_NUM_UINT8:
+		case SEXP_NUM_UINT16:
+		case SEXP_NUM_UINT32:
+		case SEXP_NUM_UINT64:
+			if (rd_uvarint(r, &v) != 0)
+				goto invalid;
+			tok->u.number.v.u = v;
+			break;
+		case SEXP_NUM_DOUBLE:
+		{
+			int k;
+
+			if (r->len - r->pos < 8)
+				goto invalid;
+
+			for (v = 0, k = 0; k < 8; ++k)
+				v |= (uint64_t)r->buf[r->pos++] << (8 * k);
+
+			memcpy(&tok->u.number.v.f, &v, sizeof v);
+			break;
+		}
+		default:
+			goto invalid;
+		}
+		break;
+	case SEXP_BIN_TAG_LIST:
+		/* every member takes at least one byte */
+		if (rd_uvarint(r, &v) != 0 || v > r->len - r->pos || v > UINT32_MAX)
+			goto invalid;
+
+		tok->type = SEXP_BIN_LIST;
+		tok->u.list.length = (uint32_t)v;
+
+		if (v > 0) {
+			if (r->depth == SEXP_BIN_MAXDEPTH)
+				goto invalid;
+
+			if (r->stack == NULL) {
+				r->stack = malloc(SEXP_BIN_MAXDEPTH * sizeof(uint32_t));
+
+				if (r->stack == NULL)
+					return (-1);
+			}
+
+			r->stack[r->depth++] = (uint32_t)v;
+		}
+		break;
+	default:
+		goto invalid;
+	}
+
+	return (0);
+invalid:
+	errno = EINVAL;
+	return (-1);
+}
+
+void SEXP_bin_reader_free(SEXP_bin_reader_t *r)
+{
+	if (r == NULL)
+		return;
+
+	free(r->table);
+	free(r->stack);
+	free(r);
+}
+
+/*
+ * Decoder
+ */
+static int dec_datatype_set(SEXP_t *s_exp, const SEXP_bin_token_t *tok)
+{
+	char buf[SEXP_BIN_INTERN_MAXLEN + 1], *dt = buf;
+	int ret;
+
+	if (tok->datatype_len >= sizeof buf) {
+		dt = malloc(tok->datatype_len + 1);
+
+		if (dt == NULL)
+			return (-1);
+	}
+
+	memcpy(dt, tok->datatype, tok->datatype_len);
+	dt[tok->datatype_len] = '\0';
+
+	ret = SEXP_datatype_set(s_exp, dt);
+
+	if (dt != buf)
+		free(dt);
+
+	return (ret);
+}
+
+static SEXP_t *dec_value(SEXP_bin_reader_t *r, SEXP_bin_token_t *tok)
+{
+	SEXP_t *s_exp = NULL;
+
+	switch (tok->type) {
+	case SEXP_BIN_EMPTY:
+		s_exp = SEXP_new();
+		break;
+	case SEXP_BIN_STRING:
+		s_exp = SEXP_string_new(tok->u.string.str, tok->u.string.len);
+		break;
+	case SEXP_BIN_NUMBER:
+		switch (tok->u.number.type) {
+		case SEXP_NUM_BOOL:   s_exp = SEXP_number_newb(tok->u.number.v.b); break;
+		case SEXP_NUM_INT8:   s_exp = SEXP_number_newi_8((int8_t)tok->u.number.v.i); break;
+		case SEXP_NUM_UINT8:  s_exp = SEXP_number_newu_8((uint8_t)tok->u.number.v.u); break;
+		case SEXP_NUM_INT16:  s_exp = SEXP_number_newi_16((int16_t)tok->u.number.v.i); break;
+		case SEXP_NUM_UINT16: s_exp = SEXP_number_newu_16((uint16_t)tok->u.number.v.u); break;
+		case SEXP_NUM_INT32:  s_exp = SEXP_number_newi_32((int32_t)tok->u.number.v.i); break;
+		case SEXP_NUM_UINT32: s_exp = SEXP_number_newu_32((uint32_t)tok->u.number.v.u); break;
+		case SEXP_NUM_INT64:  s_exp = SEXP_number_newi_64(tok->u.number.v.i); break;
+		case SEXP_NUM_UINT64: s_exp = SEXP_number_newu_64(tok->u.number.v.u); break;
+		case SEXP_NUM_DOUBLE: s_exp = SEXP_number_newf(tok->u.number.v.f); break;
+		}
+		break;
+	case SEXP_BIN_LIST:
+	{
+		SEXP_bin_token_t m_tok;
+		SEXP_t *memb;
+		uint32_t i, n = tok->u.list.length;
+
+		s_exp = SEXP_list_new(NULL);
+
+		for (i = 0; i < n; ++i) {
+			/* empty S-exps can't be list members */
+			if (SEXP_bin_reader_next(r, &m_tok) != 0 ||
+			    m_tok.type == SEXP_BIN_END || m_tok.type == SEXP_BIN_EMPTY ||
+			    (memb = dec_value(r, &m_tok)) == NULL) {
+				SEXP_free(s_exp);
+				return (NULL);
+			}
+			SEXP_list_add(s_exp, memb);
+			SEXP_free(memb);
+		}
+		break;
+	}
+	default:
+		break;
+	}
+
+	if (s_exp != NULL && tok->datatype != NULL && dec_datatype_set(s_exp, tok) != 0) {
+		SEXP_free(s_exp);
+		return (NULL);
+	}
+
+	return (s_exp);
+}
+
+SEXP_t *SEXP_bin_decode(const void *buf, size_t len)
+{
+	SEXP_bin_reader_t *r;
+	SEXP_bin_token_t tok;
+	SEXP_t *s_exp = NULL;
+
+	r = SEXP_bin_reader_new(buf, len);
+
+	if (r == NULL)
+		return (NULL);
+
+	if (SEXP_bin_reader_next(r, &tok) == 0 && tok.type != SEXP_BIN_END)
+		s_exp = dec_value(r, &tok);
+
+	/* the whole buffer has to be consumed */
+	if (s_exp != NULL &&
+	    (SEXP_bin_reader_next(r, &tok) != 0 || tok.type != SEXP_BIN_END)) {
+		SEXP_free(s_exp);
+		s_exp = NULL;
+	}
+
+	SEXP_bin_reader_free(r);
+
+	if (s_exp == NULL)
+		errno = EINVAL;
+
+	return (s_exp);
+}
@@ -46,6 +46,7 @@
 #include "public/sexp-manip.h"
 #include "public/sexp-manip_r.h"
 #include "debug_priv.h"
+#include "common/memtag_priv.h"
 
 static void SEXP_free_lmemb (SEXP_t *s_exp);
 
@@ -882,6 +883,10 @@ int SEXP_string_cmp (const SEXP_t *str_a, const SEXP_t *str_b)
         SEXP_VALIDATE(str_a);
         SEXP_VALIDATE(str_b);
 
+        /* interned strings share the value */
+        if (str_a->s_valp == str_b->s_valp)
+                return (0);
+
         a = SEXP_string_cstr (str_a);
         b = SEXP_string_cstr (str_b);
 
@@ -1027,6 +1032,8 @@ SEXP_t *SEXP_listref_first (SEXP_t *list)
 
         s_exp = SEXP_rawval_lblk_nth ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr,
                                       SEXP_LCASTP(v_dsc.mem)->offset + 1);
+        /* the member may be modified through the soft reference */
+        SEXP_LCASTP(v_dsc.mem)->hash = 0;
 
         return (s_exp == NULL ? NULL : SEXP_softref (s_exp));
 }
@@ -1069,7 +1076,7 @@ SEXP_t *SEXP_list_last (const SEXP_t *list)
                 return (NULL);
         }
 
-        l_blk = SEXP_VALP_LBLK(SEXP_rawval_lblk_last ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr));
+        l_blk = SEXP_VALP_LBLK(SEXP_rawval_list_last (SEXP_LCASTP(v_dsc.mem)));
 
         if (l_blk == NULL)
                 return (NULL);
@@ -1113,6 +1120,9 @@ SEXP_t *SEXP_list_replace (SEXP_t *list, uint32_t n, const SEXP_t *n_val)
         SEXP_LCASTP(v_dsc.mem)->b_addr = (void *) SEXP_rawval_lblk_replace ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr,
                                                                             SEXP_LCASTP(v_dsc.mem)->offset + n,
                                                                             n_val, &o_val);
+        /* the blocks from the replaced one on may have been copied */
+        SEXP_LCASTP(v_dsc.mem)->b_last = NULL;
+        SEXP_LCASTP(v_dsc.mem)->hash   = 0;
 
         return (o_val);
 }
@@ -1174,6 +1184,8 @@ SEXP_t *SEXP_listref_nth (SEXP_t *list, uint32_t n)
 
         s_exp = SEXP_rawval_lblk_nth ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr,
                                       SEXP_LCASTP(v_dsc.mem)->offset + n);
+        /* the member may be modified through the soft reference */
+        SEXP_LCASTP(v_dsc.mem)->hash = 0;
 
 #if !defined(NDEBUG)
         if (s_exp != NULL)
@@ -1217,20 +1229,16 @@ SEXP_t *SEXP_list_add (SEXP_t *list, const SEXP_t *s_exp)
 
                 list->s_valp = uptr;
                 SEXP_val_dsc (&v_dsc, list->s_valp);
-
-                uptr = SEXP_rawval_lblk_last ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr);
-                SEXP_rawval_lblk_add1 (uptr, s_exp);
-        } else {
-                /*
-                 * Only one reference exists to the value.
-                 * However, list blocks have their own
-                 * reference counter and some blocks can
-                 * be shared. This case is handled by the
-                 * function SEXP_rawval_list_add.
-                 */
-                SEXP_LCASTP(v_dsc.mem)->b_addr = (void *)SEXP_rawval_lblk_add ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr, s_exp);
         }
 
+        /*
+         * Only one reference exists to the value now.
+         * However, list blocks have their own reference
+         * counter and some blocks can be shared. This
+         * case is handled by SEXP_rawval_list_add.
+         */
+        SEXP_rawval_list_add (SEXP_LCASTP(v_dsc.mem), s_exp);
+
         return (list);
 }
 
@@ -1297,12 +1305,28 @@ SEXP_t *SEXP_list_pop (SEXP_t *list)
         lblk = SEXP_VALP_LBLK(SEXP_LCASTP(v_dsc.mem)->b_addr);
 
         if (lblk != NULL) {
+                --SEXP_LCASTP(v_dsc.mem)->length;
+                SEXP_LCASTP(v_dsc.mem)->hash = 0;
+
                 if (++SEXP_LCASTP(v_dsc.mem)->offset == lblk->real) {
+                        uintptr_t next = (uintptr_t)SEXP_VALP_LBLK(lblk->nxsz);
+                        uintptr_t head = next;
+
+                        /*
+                         * Take a reference to the next block, the first
+                         * one is freed only if no other list shares it.
+                         */
+                        if (next != 0)
+                                head = SEXP_rawval_lblk_incref (next);
+
                         SEXP_LCASTP(v_dsc.mem)->offset = 0;
-                        SEXP_LCASTP(v_dsc.mem)->b_addr = SEXP_VALP_LBLK(lblk->nxsz);
-                }
+                        SEXP_LCASTP(v_dsc.mem)->b_addr = (void *)head;
+
+                        if (head == 0 || head != next)
+                                SEXP_LCASTP(v_dsc.mem)->b_last = NULL;
 
-                SEXP_rawval_lblk_free1 ((uintptr_t)lblk, SEXP_free_lmemb);
+                        SEXP_rawval_lblk_free ((uintptr_t)lblk, SEXP_free_lmemb);
+                }
         }
 
 #if !defined(NDEBUG)
@@ -1392,6 +1416,7 @@ SEXP_t *SEXP_list_sort(SEXP_t *list, int(*compare)(const SEXP_t *, const SEXP_t
          * TODO: check reference counts and make copies of list
          * blocks if needed
          */
+        SEXP_LCASTP(v_dsc.mem)->hash = 0;
 
         /*
          * PASS #1: Sort each block and build the iterator array
@@ -1505,6 +1530,7 @@ SEXP_t *SEXP_list_sort(SEXP_t *list, int(*compare)(const SEXP_t *, const SEXP_t
 SEXP_t *SEXP_new (void)
 {
 	SEXP_t *s_exp = malloc(sizeof(SEXP_t));
+	oscap_memtag_alloc(OSCAP_MEMTAG_SEXP, s_exp, sizeof(SEXP_t));
         s_exp->s_type = NULL;
         s_exp->s_valp = 0;
 
@@ -1552,16 +1578,16 @@ SEXP_t *SEXP_unref (SEXP_t *s_exp_o)
 
                         switch (v_dsc.type) {
                         case SEXP_VALTYPE_STRING:
-				oscap_aligned_free(v_dsc.hdr);
+				SEXP_val_free(&v_dsc);
                                 break;
                         case SEXP_VALTYPE_NUMBER:
-				oscap_aligned_free(v_dsc.hdr);
+				SEXP_val_free(&v_dsc);
                                 break;
                         case SEXP_VALTYPE_LIST:
                                 if (SEXP_LCASTP(v_dsc.mem)->b_addr != NULL)
                                         SEXP_rawval_lblk_free ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr, SEXP_free_lmemb);
 
-				oscap_aligned_free(v_dsc.hdr);
+				SEXP_val_free(&v_dsc);
                                 break;
                         default:
                                 abort ();
@@ -1665,6 +1691,12 @@ bool SEXP_deepcmp(const SEXP_t *a, const SEXP_t *b)
                 return (a == b);
         if ((type = SEXP_typeof(a)) != SEXP_typeof(b))
                 return (false);
+        /*
+         * Shared values (interned names, refs to the same list)
+         * are equal without looking at their contents.
+         */
+        if (a->s_valp == b->s_valp)
+                return (true);
         if (!SEXP_listp(a)) {
                 /* compare simple objects */
                 switch(type) {
@@ -1708,6 +1740,17 @@ bool SEXP_deepcmp(const SEXP_t *a, const SEXP_t *b)
                 register SEXP_list_it *it_a, *it_b;
 		register SEXP_t *ia, *ib;
 		register bool ret = false;
+                SEXP_val_t v_a, v_b;
+
+                /* lists with different memoized hashes can't be equal */
+                SEXP_val_dsc(&v_a, a->s_valp);
+                SEXP_val_dsc(&v_b, b->s_valp);
+
+                if (SEXP_LCASTP(v_a.mem)->hash != 0 && SEXP_LCASTP(v_b.mem)->hash != 0 &&
+                    SEXP_LCASTP(v_a.mem)->hash != SEXP_LCASTP(v_b.mem)->hash)
+                        return (false);
+                if (SEXP_LCASTP(v_a.mem)->length != SEXP_LCASTP(v_b.mem)->length)
+                        return (false);
 
                 it_a = SEXP_list_it_new(a);
                 it_b = SEXP_list_it_new(b);
@@ -1747,16 +1790,16 @@ static void SEXP_free_lmemb (SEXP_t *s_exp)
                 if (SEXP_rawval_decref (s_exp->s_valp)) {
                         switch (v_dsc.type) {
                         case SEXP_VALTYPE_STRING:
-				oscap_aligned_free(v_dsc.hdr);
+				SEXP_val_free(&v_dsc);
                                 break;
                         case SEXP_VALTYPE_NUMBER:
-				oscap_aligned_free(v_dsc.hdr);
+				SEXP_val_free(&v_dsc);
                                 break;
                         case SEXP_VALTYPE_LIST:
                                 if (SEXP_LCASTP(v_dsc.mem)->b_addr != NULL)
                                         SEXP_rawval_lblk_free ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr, SEXP_free_lmemb);
 
-				oscap_aligned_free(v_dsc.hdr);
+				SEXP_val_free(&v_dsc);
                                 break;
                         default:
                                 abort ();
@@ -1778,6 +1821,7 @@ void SEXP_free (SEXP_t *s_exp)
 {
         if (s_exp != NULL) {
                 SEXP_free_r(s_exp);
+		oscap_memtag_free(OSCAP_MEMTAG_SEXP, s_exp, sizeof(SEXP_t));
 		free(s_exp);
         }
         return;
@@ -47,6 +47,22 @@ SEXP_t *SEXP_init(SEXP_t *sexp_mem)
         return (sexp_mem);
 }
 
+SEXP_t *SEXP_ref_r(SEXP_t *sexp_mem, const SEXP_t *s_exp_o)
+{
+        if (sexp_mem == NULL || s_exp_o == NULL) {
+                errno = EFAULT;
+                return (NULL);
+        }
+
+        SEXP_VALIDATE(s_exp_o);
+
+        SEXP_init(sexp_mem);
+        sexp_mem->s_type = s_exp_o->s_type;
+        sexp_mem->s_valp = SEXP_rawval_incref (s_exp_o->s_valp);
+
+        return (sexp_mem);
+}
+
 SEXP_t *SEXP_number_newi_32_r(SEXP_t *sexp_mem, int32_t n)
 {
         SEXP_val_t v_dsc;
@@ -300,18 +316,23 @@ SEXP_t *SEXP_list_new_rv (SEXP_t *sexp_mem, SEXP_t *memb, va_list alist)
                 s_ptr[++s_cur] = va_arg (alist, SEXP_t *);
         }
 
-        if (SEXP_val_new (&v_dsc, sizeof (void *) + sizeof (uint16_t),
+        if (SEXP_val_new (&v_dsc, sizeof (struct SEXP_val_list),
                           SEXP_VALTYPE_LIST) != 0)
         {
                 /* TODO: handle this */
                 return (NULL);
         }
 
+        SEXP_LCASTP(v_dsc.mem)->length = s_cur;
+        SEXP_LCASTP(v_dsc.mem)->shared = 0;
+        SEXP_LCASTP(v_dsc.mem)->hash   = 0;
+
         if (s_cur > 0) {
                 for (b_exp = 0; (size_t)(1 << b_exp) < s_cur; ++b_exp);
 
                 SEXP_LCASTP(v_dsc.mem)->offset = 0;
                 SEXP_LCASTP(v_dsc.mem)->b_addr = (void *)SEXP_rawval_lblk_new (b_exp);
+                SEXP_LCASTP(v_dsc.mem)->b_last = SEXP_LCASTP(v_dsc.mem)->b_addr;
 
                 if (SEXP_rawval_lblk_fill ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr,
                                            s_ptr, s_cur) != ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr))
@@ -322,6 +343,7 @@ SEXP_t *SEXP_list_new_rv (SEXP_t *sexp_mem, SEXP_t *memb, va_list alist)
         } else {
                 SEXP_LCASTP(v_dsc.mem)->offset = 0;
                 SEXP_LCASTP(v_dsc.mem)->b_addr = NULL;
+                SEXP_LCASTP(v_dsc.mem)->b_last = NULL;
         }
 
         SEXP_init(sexp_mem);
@@ -369,26 +391,47 @@ SEXP_t *SEXP_list_rest_r (SEXP_t *rest, const SEXP_t *list)
                 return (NULL);
         }
 
-        if (SEXP_val_new (&v_dsc_r, sizeof (void *) + sizeof (uint16_t),
+        if (SEXP_val_new (&v_dsc_r, sizeof (struct SEXP_val_list),
                           SEXP_VALTYPE_LIST) != 0)
         {
                 /* TODO: handle this */
                 return (NULL);
         }
 
-        SEXP_LCASTP(v_dsc_r.mem)->offset = SEXP_LCASTP(v_dsc_o.mem)->offset + 1;
-        SEXP_LCASTP(v_dsc_r.mem)->b_addr = SEXP_LCASTP(v_dsc_o.mem)->b_addr;
+        SEXP_LCASTP(v_dsc_r.mem)->offset = 0;
+        SEXP_LCASTP(v_dsc_r.mem)->b_addr = NULL;
+        SEXP_LCASTP(v_dsc_r.mem)->b_last = NULL;
+        SEXP_LCASTP(v_dsc_r.mem)->length = 0;
+        SEXP_LCASTP(v_dsc_r.mem)->shared = 0;
+        SEXP_LCASTP(v_dsc_r.mem)->hash   = 0;
 
-        lblk = SEXP_VALP_LBLK(SEXP_LCASTP(v_dsc_r.mem)->b_addr);
+        lblk = SEXP_VALP_LBLK(SEXP_LCASTP(v_dsc_o.mem)->b_addr);
 
         if (lblk != NULL) {
+                SEXP_LCASTP(v_dsc_r.mem)->offset = SEXP_LCASTP(v_dsc_o.mem)->offset + 1;
+                SEXP_LCASTP(v_dsc_r.mem)->b_addr = lblk;
+                SEXP_LCASTP(v_dsc_r.mem)->length = SEXP_LCASTP(v_dsc_o.mem)->length - 1;
+
                 if (SEXP_LCASTP(v_dsc_r.mem)->offset == lblk->real) {
                         SEXP_LCASTP(v_dsc_r.mem)->offset = 0;
                         SEXP_LCASTP(v_dsc_r.mem)->b_addr = SEXP_VALP_LBLK(lblk->nxsz);
                 }
 
-                if (SEXP_VALP_LBLK(SEXP_LCASTP(v_dsc_r.mem)->b_addr) != NULL)
-                        SEXP_LCASTP(v_dsc_r.mem)->b_addr = (void *)SEXP_rawval_lblk_incref ((uintptr_t) SEXP_LCASTP(v_dsc_r.mem)->b_addr);
+                if (SEXP_VALP_LBLK(SEXP_LCASTP(v_dsc_r.mem)->b_addr) != NULL) {
+                        uintptr_t b_addr = SEXP_rawval_lblk_incref ((uintptr_t) SEXP_LCASTP(v_dsc_r.mem)->b_addr);
+
+                        if (b_addr == (uintptr_t)SEXP_LCASTP(v_dsc_r.mem)->b_addr) {
+                                /*
+                                 * Both lists share the rest of the chain now,
+                                 * so neither of them may append to its last
+                                 * block without checking the other one.
+                                 */
+                                SEXP_LCASTP(v_dsc_r.mem)->b_last = SEXP_LCASTP(v_dsc_o.mem)->b_last;
+                                SEXP_LCASTP(v_dsc_r.mem)->shared = 1;
+                                SEXP_LCASTP(v_dsc_o.mem)->shared = 1;
+                        }
+                        SEXP_LCASTP(v_dsc_r.mem)->b_addr = (void *)b_addr;
+                }
         }
 
         SEXP_init(rest);
@@ -430,16 +473,16 @@ void __SEXP_free_r (SEXP_t *s_exp, const char *file, uint32_t line, const char *
                 if (SEXP_rawval_decref (s_exp->s_valp)) {
                         switch (v_dsc.type) {
                         case SEXP_VALTYPE_STRING:
-				oscap_aligned_free(v_dsc.hdr);
+				SEXP_val_free(&v_dsc);
                                 break;
                         case SEXP_VALTYPE_NUMBER:
-				oscap_aligned_free(v_dsc.hdr);
+				SEXP_val_free(&v_dsc);
                                 break;
                         case SEXP_VALTYPE_LIST:
                                 if (SEXP_LCASTP(v_dsc.mem)->b_addr != NULL)
                                         SEXP_rawval_lblk_free ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr, SEXP_free_r);
 
-				oscap_aligned_free(v_dsc.hdr);
+				SEXP_val_free(&v_dsc);
                                 break;
                         default:
                                 abort ();
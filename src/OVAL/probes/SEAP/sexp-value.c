@@ -26,19 +26,106 @@
 
 #include <stdint.h>
 #include <string.h>
+#include <pthread.h>
 
 #include "_sexp-atomic.h"
 #include "_sexp-value.h"
+#include "public/sexp-manip.h"
 #include "debug_priv.h"
+#include "common/memtag_priv.h"
+
+static volatile size_t SEXP_val_memused = 0;
+
+#if defined(_MSC_VER)
+# define SEXP_THREAD_LOCAL __declspec(thread)
+#else
+# define SEXP_THREAD_LOCAL __thread
+#endif
+
+/*
+ * Thread confined values. Between SEXP_local_begin and SEXP_local_end
+ * the new values are tagged with the owner tag of the current thread,
+ * their reference counters are updated without atomic operations and
+ * the allocated memory is accounted locally. SEXP_local_end clears the
+ * tags of the values reachable from the result before it can be seen
+ * by any other thread. The tagged values which are still alive and not
+ * reachable from the result have escaped the window; the thread never
+ * uses their tag again, so they are treated as shared values from then on.
+ */
+static volatile uint32_t SEXP_local_lasttag = 0;
+static SEXP_THREAD_LOCAL uint32_t SEXP_local_threadtag = 0;
+static SEXP_THREAD_LOCAL uint32_t SEXP_local_tag = 0;   /* != 0 inside the window */
+static SEXP_THREAD_LOCAL uint32_t SEXP_local_depth = 0;
+static SEXP_THREAD_LOCAL ssize_t  SEXP_local_memused = 0;
+static SEXP_THREAD_LOCAL size_t   SEXP_local_live = 0;  /* tagged values alive */
+
+#if !defined(HAVE_ATOMIC_BUILTINS)
+static pthread_mutex_t SEXP_val_memused_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static void SEXP_val_memused_flush (ssize_t delta)
+{
+#if defined(HAVE_ATOMIC_BUILTINS)
+        __sync_fetch_and_add (&SEXP_val_memused, (size_t)delta);
+#else
+        pthread_mutex_lock (&SEXP_val_memused_mutex);
+        SEXP_val_memused += (size_t)delta;
+        pthread_mutex_unlock (&SEXP_val_memused_mutex);
+#endif
+}
+
+static void SEXP_val_memused_add (size_t size)
+{
+        if (oscap_memtag_enabled)
+                oscap_memtag_account(OSCAP_MEMTAG_SEXP, (int64_t)size);
+        if (SEXP_local_tag != 0) {
+                SEXP_local_memused += (ssize_t)size;
+                return;
+        }
+#if defined(HAVE_ATOMIC_BUILTINS)
+        __sync_fetch_and_add (&SEXP_val_memused, size);
+#else
+        pthread_mutex_lock (&SEXP_val_memused_mutex);
+        SEXP_val_memused += size;
+        pthread_mutex_unlock (&SEXP_val_memused_mutex);
+#endif
+}
+
+static void SEXP_val_memused_sub (size_t size)
+{
+        if (oscap_memtag_enabled)
+                oscap_memtag_account(OSCAP_MEMTAG_SEXP, -(int64_t)size);
+        if (SEXP_local_tag != 0) {
+                SEXP_local_memused -= (ssize_t)size;
+                return;
+        }
+#if defined(HAVE_ATOMIC_BUILTINS)
+        __sync_fetch_and_sub (&SEXP_val_memused, size);
+#else
+        pthread_mutex_lock (&SEXP_val_memused_mutex);
+        SEXP_val_memused -= size;
+        pthread_mutex_unlock (&SEXP_val_memused_mutex);
+#endif
+}
+
+size_t SEXP_val_memusage (void)
+{
+        return (SEXP_val_memused);
+}
 
 int SEXP_val_new (SEXP_val_t *dst, size_t vmemsize, SEXP_type_t type)
 {
 	void *s_val = oscap_aligned_malloc(sizeof(SEXP_valhdr_t) + vmemsize, SEXP_VALP_ALIGN);
 
+        SEXP_val_memused_add (sizeof(SEXP_valhdr_t) + vmemsize);
+
         SEXP_val_dsc (dst, (uintptr_t) s_val);
 
-        dst->hdr->refs = 1;
-        dst->hdr->size = vmemsize;
+        dst->hdr->refs  = 1;
+        dst->hdr->owner = SEXP_local_tag;
+        dst->hdr->size  = vmemsize;
+        if (SEXP_local_tag != 0)
+                ++SEXP_local_live;
         dst->type      = type;
         dst->ptr       = SEXP_val_ptr (dst);
 #if defined(SEAP_VERBOSE_DEBUG)
@@ -48,6 +135,14 @@ int SEXP_val_new (SEXP_val_t *dst, size_t vmemsize, SEXP_type_t type)
         return (0);
 }
 
+void SEXP_val_free (SEXP_val_t *dsc)
+{
+        if (SEXP_local_tag != 0 && dsc->hdr->owner == SEXP_local_tag)
+                --SEXP_local_live;
+        SEXP_val_memused_sub (sizeof(SEXP_valhdr_t) + dsc->hdr->size);
+        oscap_aligned_free(dsc->hdr);
+}
+
 void SEXP_val_dsc (SEXP_val_t *dst, uintptr_t ptr)
 {
         dst->ptr  = ptr;
@@ -68,7 +163,12 @@ uintptr_t SEXP_val_ptr (SEXP_val_t *dsc)
  */
 uintptr_t SEXP_rawval_incref (uintptr_t valp)
 {
-        return SEXP_atomic_inc_u32 (&(SEXP_VALP_HDR(valp)->refs)) > 0 ? valp : (uintptr_t) NULL;
+        SEXP_valhdr_t *hdr = SEXP_VALP_HDR(valp);
+
+        if (SEXP_local_tag != 0 && hdr->owner == SEXP_local_tag)
+                return (++hdr->refs > 0 ? valp : (uintptr_t) NULL);
+
+        return SEXP_atomic_inc_u32 (&(hdr->refs)) > 0 ? valp : (uintptr_t) NULL;
 }
 
 /*
@@ -78,7 +178,80 @@ uintptr_t SEXP_rawval_incref (uintptr_t valp)
  */
 int SEXP_rawval_decref (uintptr_t valp)
 {
-        return (SEXP_atomic_dec_u32 (&(SEXP_VALP_HDR(valp)->refs)) == 0);
+        SEXP_valhdr_t *hdr = SEXP_VALP_HDR(valp);
+
+        if (SEXP_local_tag != 0 && hdr->owner == SEXP_local_tag)
+                return (--hdr->refs == 0);
+
+        return (SEXP_atomic_dec_u32 (&(hdr->refs)) == 0);
+}
+
+static int SEXP_rawval_promote_cb (SEXP_t *s_exp, void *arg)
+{
+        (void)arg;
+
+        if (s_exp->s_valp != 0)
+                SEXP_rawval_promote (s_exp->s_valp);
+
+        return (0);
+}
+
+void SEXP_rawval_promote (uintptr_t valp)
+{
+        SEXP_val_t v_dsc;
+
+        SEXP_val_dsc (&v_dsc, valp);
+
+        if (v_dsc.hdr == NULL)
+                return;
+
+        if (v_dsc.hdr->owner != 0 && v_dsc.hdr->owner == SEXP_local_tag)
+                --SEXP_local_live;
+        v_dsc.hdr->owner = 0;
+
+        if (v_dsc.type == SEXP_VALTYPE_LIST) {
+                SEXP_rawval_lblk_cb ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr,
+                                     SEXP_rawval_promote_cb, NULL,
+                                     SEXP_LCASTP(v_dsc.mem)->offset + 1);
+        }
+}
+
+void SEXP_local_begin (void)
+{
+        if (SEXP_local_depth++ > 0)
+                return;
+
+        while (SEXP_local_threadtag == 0)
+                SEXP_local_threadtag = SEXP_atomic_inc_u32 (&SEXP_local_lasttag);
+
+        SEXP_local_tag = SEXP_local_threadtag;
+}
+
+void SEXP_local_share (const SEXP_t *s_exp)
+{
+        if (s_exp != NULL && s_exp->s_valp != 0)
+                SEXP_rawval_promote (s_exp->s_valp);
+}
+
+void SEXP_local_end (const SEXP_t *s_exp)
+{
+        SEXP_local_share (s_exp);
+
+        if (SEXP_local_depth == 0 || --SEXP_local_depth > 0)
+                return;
+
+        SEXP_local_tag = 0;
+
+        if (SEXP_local_live != 0) {
+                dD("%zu values escaped the thread confined window", SEXP_local_live);
+                SEXP_local_threadtag = 0;
+                SEXP_local_live = 0;
+        }
+
+        if (SEXP_local_memused != 0) {
+                SEXP_val_memused_flush (SEXP_local_memused);
+                SEXP_local_memused = 0;
+        }
 }
 
 SEXP_numtype_t SEXP_rawval_number_type (SEXP_val_t *dsc)
@@ -88,28 +261,60 @@ SEXP_numtype_t SEXP_rawval_number_type (SEXP_val_t *dsc)
 
 size_t SEXP_rawval_list_length (struct SEXP_val_list *list)
 {
-        size_t length;
-        register struct SEXP_val_lblk *lblk;
+        return (list->length);
+}
+
+uintptr_t SEXP_rawval_list_last (struct SEXP_val_list *list)
+{
+        if (list->b_last == NULL && list->b_addr != NULL)
+                list->b_last = (void *)SEXP_rawval_lblk_last ((uintptr_t)list->b_addr);
 
-        length = 0;
-        lblk   = SEXP_VALP_LBLK(list->b_addr);
+        return ((uintptr_t)list->b_last);
+}
 
-        while (lblk != NULL) {
-                length += lblk->real;
-                lblk    = SEXP_VALP_LBLK(lblk->nxsz);
+void SEXP_rawval_list_add (struct SEXP_val_list *list, const SEXP_t *s_exp)
+{
+        struct SEXP_val_lblk *last;
+
+        if (list->shared) {
+                /*
+                 * Some blocks of the chain may belong to another list
+                 * too. Walk the chain and copy it from the first shared
+                 * block on, the whole chain is private afterwards.
+                 */
+                list->b_addr = (void *)SEXP_rawval_lblk_add ((uintptr_t)list->b_addr, s_exp);
+                list->b_last = NULL;
+                list->shared = 0;
+        } else if (list->b_addr == NULL) {
+                list->b_addr = (void *)SEXP_rawval_lblk_new (1);
+                list->b_last = list->b_addr;
+                (void)SEXP_rawval_lblk_add1 ((uintptr_t)list->b_addr, s_exp);
+        } else {
+                last = SEXP_VALP_LBLK(SEXP_rawval_list_last (list));
+                (void)SEXP_rawval_lblk_add1 ((uintptr_t)last, s_exp);
+
+                if (SEXP_VALP_LBLK(last->nxsz) != NULL)
+                        list->b_last = SEXP_VALP_LBLK(last->nxsz);
         }
 
-        return (length - list->offset);
+        ++list->length;
+        list->hash = 0;
 }
 
 uintptr_t SEXP_rawval_lblk_new (uint8_t sz)
 {
         _A(sz < 16);
 
+        /*
+         * The members are stored right behind the block header so
+         * that a block costs one allocation instead of two.
+         */
         struct SEXP_val_lblk *lblk = oscap_aligned_malloc(
-                sizeof(struct SEXP_val_lblk),
+                sizeof(struct SEXP_val_lblk) + sizeof(SEXP_t) * (1 << sz),
                 SEXP_LBLK_ALIGN);
-        lblk->memb = malloc(sizeof(SEXP_t) * (1 << sz));
+        lblk->memb = (SEXP_t *)(lblk + 1);
+
+        SEXP_val_memused_add (sizeof(struct SEXP_val_lblk) + sizeof(SEXP_t) * (1 << sz));
 
         lblk->nxsz = ((uintptr_t)(NULL) & SEXP_LBLKP_MASK) | ((uintptr_t)sz & SEXP_LBLKS_MASK);
         lblk->refs = 1;
@@ -199,7 +404,7 @@ uintptr_t SEXP_rawval_lblk_add (uintptr_t lblkp, const SEXP_t *s_exp)
                                  * than one list so we have to create a copy of the
                                  * rest of the list.
                                  */
-                                lb_ptr = SEXP_rawval_lblk_copy (lblkp, 0);
+                                lb_ptr = SEXP_rawval_lblk_copy ((uintptr_t)lblk, 0);
 
                                 if (lb_prev == 0)
                                         lb_head = lb_ptr;
@@ -212,7 +417,7 @@ uintptr_t SEXP_rawval_lblk_add (uintptr_t lblkp, const SEXP_t *s_exp)
                                 if (lb_prev != 0)
                                         SEXP_VALP_LBLK(lb_prev)->nxsz = (lb_ptr & SEXP_LBLKP_MASK) | (SEXP_VALP_LBLK(lb_prev)->nxsz & SEXP_LBLKS_MASK);
 
-                                SEXP_rawval_lblk_decref (lblkp);
+                                SEXP_rawval_lblk_decref ((uintptr_t)lblk);
 
                                 /*
                                  * Get the last block without checking refs
@@ -320,7 +525,7 @@ uintptr_t SEXP_rawval_lblk_replace (uintptr_t lblkp, uint32_t n, const SEXP_t *n
         lb_head = lblkp;
         lb_prev = 0;
 
-        while (n > lblk->real) {
+        while (n > lblk->real || lblk->refs > 1) {
                 if (lblk->refs < 2) {
                         n      -= lblk->real;
                         lb_prev = (uintptr_t)lblk;
@@ -426,7 +631,7 @@ uintptr_t SEXP_rawval_list_copy (uintptr_t s_valp)
 {
         SEXP_val_t v_dsc_o, v_dsc_c;
 
-        if (SEXP_val_new (&v_dsc_c, sizeof (void *) + sizeof (uint16_t),
+        if (SEXP_val_new (&v_dsc_c, sizeof (struct SEXP_val_list),
                           SEXP_VALTYPE_LIST) != 0)
         {
                 /* TODO: handle this */
@@ -437,7 +642,11 @@ uintptr_t SEXP_rawval_list_copy (uintptr_t s_valp)
 
         SEXP_LCASTP(v_dsc_c.mem)->b_addr = (void *) SEXP_rawval_lblk_copy ((uintptr_t)SEXP_LCASTP(v_dsc_o.mem)->b_addr,
                                                                            (uintptr_t)SEXP_LCASTP(v_dsc_o.mem)->offset);
+        SEXP_LCASTP(v_dsc_c.mem)->b_last = NULL;
+        SEXP_LCASTP(v_dsc_c.mem)->length = SEXP_LCASTP(v_dsc_o.mem)->length;
         SEXP_LCASTP(v_dsc_c.mem)->offset = 0;
+        SEXP_LCASTP(v_dsc_c.mem)->shared = 0;
+        SEXP_LCASTP(v_dsc_c.mem)->hash   = 0;
 
         return (SEXP_val_ptr (&v_dsc_c));
 }
@@ -459,7 +668,13 @@ uintptr_t SEXP_rawval_lblk_copy (uintptr_t lblkp, uint16_t n_skip)
         if (lb_old == NULL)
                 return ((uintptr_t) NULL);
 
-        cur_sz  = 0;
+        /*
+         * The first block of the copy holds at least the members of the
+         * first copied block, so that the offset of a list pointing into
+         * it remains valid for the copy.
+         */
+        for (cur_sz = 0; (1 << cur_sz) < lb_old->real - off_o; ++cur_sz);
+
         lb_new  = (struct SEXP_val_lblk *)SEXP_rawval_lblk_new (cur_sz);
         lb_head = (uintptr_t)lb_new;
 
@@ -480,7 +695,8 @@ uintptr_t SEXP_rawval_lblk_copy (uintptr_t lblkp, uint16_t n_skip)
                  * allocate new block
                  */
                 if (lb_new->real >= (1 << (cur_sz))) {
-                        lb_next = SEXP_rawval_lblk_new (++cur_sz);
+                        cur_sz  = cur_sz == 15 ? 6 : cur_sz + 1;
+                        lb_next = SEXP_rawval_lblk_new (cur_sz);
                         lb_new->nxsz = (lb_next & SEXP_LBLKP_MASK) | (lb_new->nxsz & SEXP_LBLKS_MASK);
                         lb_new  = SEXP_VALP_LBLK(lb_next);
                         off_n   = 0;
@@ -519,7 +735,8 @@ void SEXP_rawval_lblk_free (uintptr_t lblkp, void (*func) (SEXP_t *))
                         func (lblk->memb + lblk->real);
                 }
 
-                free(lblk->memb);
+                SEXP_val_memused_sub (sizeof(struct SEXP_val_lblk) +
+                                      sizeof(SEXP_t) * (1 << (lblk->nxsz & SEXP_LBLKS_MASK)));
                 oscap_aligned_free(lblk);
 
                 if (next != NULL)
@@ -541,7 +758,8 @@ void SEXP_rawval_lblk_free1 (uintptr_t lblkp, void (*func) (SEXP_t *))
                         func (lblk->memb + lblk->real);
                 }
 
-                free(lblk->memb);
+                SEXP_val_memused_sub (sizeof(struct SEXP_val_lblk) +
+                                      sizeof(SEXP_t) * (1 << (lblk->nxsz & SEXP_LBLKS_MASK)));
                 oscap_aligned_free(lblk);
         }
 
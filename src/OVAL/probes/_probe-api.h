@@ -48,6 +48,43 @@ struct id_desc_t {
 	int item_id_ctr;	///< id counter
 };
 
+/*
+ * Scan memo: data a probe reads once per scan and answers all its objects
+ * from, e.g. a listing of a small configuration or a reply of a service.
+ * The data is built by the first object asking for it under the given
+ * name and kept until the probe session ends. Building it may be slow,
+ * it is done without holding any lock, and if two threads race the result
+ * of the later one is thrown away.
+ */
+typedef struct probe_memo probe_memo_t;
+
+/**
+ * Get the data memoized under the name, calling build(arg) to create it if
+ * there is none. The reference has to be released by probe_memo_release.
+ * @param destroy function freeing what build returned
+ * @return the memo or NULL if build returned NULL, which isn't memoized
+ */
+probe_memo_t *probe_memo_acquire(const char *name, void *(*build)(void *), void *arg, void (*destroy)(void *));
+
+void *probe_memo_value(probe_memo_t *memo);
+
+void probe_memo_release(probe_memo_t *memo);
+
+/**
+ * Drop all the memos. Memos still held are freed on release.
+ */
+void probe_memo_reset(void);
+
+struct probe_filter_set;
+
+/**
+ * Compile the object filters, lists of (action state) prepared by the
+ * worker, for probe_filters_reject.
+ */
+struct probe_filter_set *probe_filter_set_new(const SEXP_t *filters);
+
+void probe_filter_set_free(struct probe_filter_set *set);
+
 #define SEAP_LOCK pthread_mutex_lock (&globals.seap_lock)
 #define SEAP_UNLOCK pthread_mutex_unlock (&globals.seap_lock)
 
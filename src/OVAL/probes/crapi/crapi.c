@@ -24,7 +24,14 @@
 #include <config.h>
 #endif
 
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
 #include "crapi.h"
+#include "../oval_throttle.h"
 
 #if defined(HAVE_NSS3)
 #include <nss.h>
@@ -53,3 +60,64 @@ int crapi_init (void *unused)
         return (0);
 }
 #endif
+
+static pthread_key_t crapi_io_key;
+static pthread_once_t crapi_io_once = PTHREAD_ONCE_INIT;
+
+static void crapi_io_key_init (void)
+{
+        (void) pthread_key_create (&crapi_io_key, &free);
+}
+
+void *crapi_io_buffer (size_t *size)
+{
+        void *buf;
+
+        pthread_once (&crapi_io_once, &crapi_io_key_init);
+
+        buf = pthread_getspecific (crapi_io_key);
+        if (buf == NULL) {
+#if defined(HAVE_POSIX_MEMALIGN)
+                if (posix_memalign (&buf, 4096, CRAPI_IO_LARGE_BUFSZ) != 0)
+                        buf = NULL;
+#else
+                buf = malloc (CRAPI_IO_LARGE_BUFSZ);
+#endif
+                if (buf == NULL) {
+                        errno = ENOMEM;
+                        return (NULL);
+                }
+                if (pthread_setspecific (crapi_io_key, buf) != 0) {
+                        free (buf);
+                        errno = ENOMEM;
+                        return (NULL);
+                }
+        }
+
+        *size = CRAPI_IO_LARGE_BUFSZ;
+        return (buf);
+}
+
+void crapi_io_advise (int fd)
+{
+#if defined(HAVE_POSIX_FADVISE) && defined(POSIX_FADV_SEQUENTIAL)
+        (void) posix_fadvise (fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#else
+        (void) fd;
+#endif
+}
+
+ssize_t crapi_io_read (int fd, void *buf, size_t size)
+{
+        ssize_t ret;
+
+        size = oval_throttle_io_size (size);
+        do {
+                ret = read (fd, buf, size);
+        } while (ret == -1 && errno == EINTR);
+
+        if (ret > 0)
+                oval_throttle_io ((size_t) ret);
+
+        return (ret);
+}
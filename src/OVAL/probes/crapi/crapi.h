@@ -24,13 +24,36 @@
 #define CRAPI_H
 
 #define CRAPI_IO_BUFSZ 4096
+/* size of the per-thread buffer files are digested through */
+#define CRAPI_IO_LARGE_BUFSZ (256 * 1024)
 
 #ifndef _FILE_OFFSET_BITS
 # define _FILE_OFFSET_BITS 32
 #endif
 
+#include <stddef.h>
+#include <sys/types.h>
+
 #include "digest.h"
 
 int crapi_init (void *unused);
 
+/*
+ * Page aligned buffer of CRAPI_IO_LARGE_BUFSZ bytes owned by the calling
+ * thread, used to read files which are digested. NULL if out of memory.
+ */
+void *crapi_io_buffer (size_t *size);
+
+/*
+ * Tell the kernel that the file is going to be read sequentially from
+ * its current offset to the end.
+ */
+void crapi_io_advise (int fd);
+
+/*
+ * read(2) which is restarted when interrupted. Reads are split and
+ * delayed to keep within OSCAP_MAX_IO_RATE (see oval_throttle.h).
+ */
+ssize_t crapi_io_read (int fd, void *buf, size_t size);
+
 #endif /* CRAPI_H */
@@ -75,113 +75,101 @@ int crapi_digest_fd (int fd, crapi_alg_t alg, void *dst, size_t *size)
         return (-1);
 }
 
-int crapi_mdigest_fd (int fd, int num, ... /* crapi_alg_t alg, void *dst, size_t *size, ...*/)
+static int crapi_mdigest_ctbl (crapi_alg_t alg, struct digest_ctbl_t *ctbl)
 {
-        register int i;
-        va_list ap;
-        struct digest_ctbl_t *ctbl = malloc(num * sizeof(struct digest_ctbl_t));
+        switch (alg) {
+#ifdef OPENSCAP_ENABLE_MD5
+        case CRAPI_DIGEST_MD5:
+                ctbl->init   = &crapi_md5_init;
+                ctbl->update = &crapi_md5_update;
+                ctbl->fini   = &crapi_md5_fini;
+                ctbl->free   = &crapi_md5_free;
+                return 0;
+#endif
+#ifdef OPENSCAP_ENABLE_SHA1
+        case CRAPI_DIGEST_SHA1:
+                ctbl->init   = &crapi_sha1_init;
+                ctbl->update = &crapi_sha1_update;
+                ctbl->fini   = &crapi_sha1_fini;
+                ctbl->free   = &crapi_sha1_free;
+                return 0;
+#endif
+        case CRAPI_DIGEST_SHA224:
+                ctbl->init   = &crapi_sha224_init;
+                ctbl->update = &crapi_sha224_update;
+                ctbl->fini   = &crapi_sha224_fini;
+                ctbl->free   = &crapi_sha224_free;
+                return 0;
+        case CRAPI_DIGEST_SHA256:
+                ctbl->init   = &crapi_sha256_init;
+                ctbl->update = &crapi_sha256_update;
+                ctbl->fini   = &crapi_sha256_fini;
+                ctbl->free   = &crapi_sha256_free;
+                return 0;
+        case CRAPI_DIGEST_SHA384:
+                ctbl->init   = &crapi_sha384_init;
+                ctbl->update = &crapi_sha384_update;
+                ctbl->fini   = &crapi_sha384_fini;
+                ctbl->free   = &crapi_sha384_free;
+                return 0;
+        case CRAPI_DIGEST_SHA512:
+                ctbl->init   = &crapi_sha512_init;
+                ctbl->update = &crapi_sha512_update;
+                ctbl->fini   = &crapi_sha512_fini;
+                ctbl->free   = &crapi_sha512_free;
+                return 0;
+        case CRAPI_DIGEST_RMD160:
+                ctbl->init   = &crapi_rmd160_init;
+                ctbl->update = &crapi_rmd160_update;
+                ctbl->fini   = &crapi_rmd160_fini;
+                ctbl->free   = &crapi_rmd160_free;
+                return 0;
+        }
 
-        crapi_alg_t alg;
-        void       *dst;
-        size_t     *size;
+        errno = EINVAL;
+        return -1;
+}
 
-        uint8_t fd_buf[CRAPI_IO_BUFSZ];
+int crapi_mdigest_fdv (int fd, int num, const crapi_alg_t *alg, void **dst, size_t **size)
+{
+        register int i;
+        struct digest_ctbl_t *ctbl;
+        uint8_t *fd_buf;
+        size_t fd_bufsz;
         ssize_t ret;
 
 	if (num <= 0 || fd <= 0) {
 		errno = EINVAL;
-		free(ctbl);
 		return -1;
 	}
+
+        fd_buf = crapi_io_buffer(&fd_bufsz);
+        if (fd_buf == NULL)
+                return -1;
+        ctbl = malloc(num * sizeof(struct digest_ctbl_t));
+        if (ctbl == NULL) {
+                errno = ENOMEM;
+                return -1;
+        }
         for (i = 0; i < num; ++i)
                 ctbl[i].ctx = NULL;
 
-        va_start (ap, num);
-
         for (i = 0; i < num; ++i) {
-                alg  = va_arg (ap, crapi_alg_t);
-                dst  = va_arg (ap, void *);
-                size = va_arg (ap, size_t *);
-
-                switch (alg) {
-#ifdef OPENSCAP_ENABLE_MD5
-                case CRAPI_DIGEST_MD5:
-                        ctbl[i].init   = &crapi_md5_init;
-                        ctbl[i].update = &crapi_md5_update;
-                        ctbl[i].fini   = &crapi_md5_fini;
-                        ctbl[i].free   = &crapi_md5_free;
-                        break;
-#endif
-#ifdef OPENSCAP_ENABLE_SHA1
-                case CRAPI_DIGEST_SHA1:
-                        ctbl[i].init   = &crapi_sha1_init;
-                        ctbl[i].update = &crapi_sha1_update;
-                        ctbl[i].fini   = &crapi_sha1_fini;
-                        ctbl[i].free   = &crapi_sha1_free;
-                        break;
-#endif
-                case CRAPI_DIGEST_SHA224:
-                        ctbl[i].init   = &crapi_sha224_init;
-                        ctbl[i].update = &crapi_sha224_update;
-                        ctbl[i].fini   = &crapi_sha224_fini;
-                        ctbl[i].free   = &crapi_sha224_free;
-                        break;
-                case CRAPI_DIGEST_SHA256:
-                        ctbl[i].init   = &crapi_sha256_init;
-                        ctbl[i].update = &crapi_sha256_update;
-                        ctbl[i].fini   = &crapi_sha256_fini;
-                        ctbl[i].free   = &crapi_sha256_free;
-                        break;
-                case CRAPI_DIGEST_SHA384:
-                        ctbl[i].init   = &crapi_sha384_init;
-                        ctbl[i].update = &crapi_sha384_update;
-                        ctbl[i].fini   = &crapi_sha384_fini;
-                        ctbl[i].free   = &crapi_sha384_free;
-                        break;
-                case CRAPI_DIGEST_SHA512:
-                        ctbl[i].init   = &crapi_sha512_init;
-                        ctbl[i].update = &crapi_sha512_update;
-                        ctbl[i].fini   = &crapi_sha512_fini;
-                        ctbl[i].free   = &crapi_sha512_free;
-                        break;
-                case CRAPI_DIGEST_RMD160:
-                        ctbl[i].init   = &crapi_rmd160_init;
-                        ctbl[i].update = &crapi_rmd160_update;
-                        ctbl[i].fini   = &crapi_rmd160_fini;
-                        ctbl[i].free   = &crapi_rmd160_free;
-                        break;
-                default:
-                        va_end (ap);
+                if (crapi_mdigest_ctbl (alg[i], &ctbl[i]) != 0)
                         goto fail;
-                }
-
-                if ((ctbl[i].ctx = ctbl[i].init (dst, size)) == NULL)
-			*size = 0;
-        }
-
-        va_end (ap);
-
-        while ((ret = read (fd, fd_buf, sizeof fd_buf)) == sizeof fd_buf) {
-                for (i = 0; i < num; ++i) {
-			if (ctbl[i].ctx == NULL)
-				continue;
-                        if (ctbl[i].update (ctbl[i].ctx, fd_buf, sizeof fd_buf) != 0) {
-                                goto fail;
-                        }
-                }
+                if ((ctbl[i].ctx = ctbl[i].init (dst[i], size[i])) == NULL)
+			*size[i] = 0;
         }
 
-        switch (ret) {
-        case 0:
-                break;
-        case -1:
-                goto fail;
-        default:
-		if (ret <= 0) {
-			free(ctbl);
-			return -1;
-		}
+        crapi_io_advise(fd);
 
+        /* every digest is updated from the same read, the file is read once */
+        for (;;) {
+                ret = crapi_io_read (fd, fd_buf, fd_bufsz);
+                if (ret == 0)
+                        break;
+                if (ret < 0)
+                        goto fail;
                 for (i = 0; i < num; ++i) {
 			if (ctbl[i].ctx == NULL)
 				continue;
@@ -206,3 +194,46 @@ fail:
         free(ctbl);
         return (-1);
 }
+
+int crapi_mdigest_fd (int fd, int num, ... /* crapi_alg_t alg, void *dst, size_t *size, ...*/)
+{
+        register int i;
+        va_list ap;
+        crapi_alg_t *alg;
+        void **dst;
+        size_t **size;
+        int ret;
+
+	if (num <= 0 || fd <= 0) {
+		errno = EINVAL;
+		return -1;
+	}
+
+        alg  = malloc(num * sizeof(crapi_alg_t));
+        dst  = malloc(num * sizeof(void *));
+        size = malloc(num * sizeof(size_t *));
+        if (alg == NULL || dst == NULL || size == NULL) {
+                free(alg);
+                free(dst);
+                free(size);
+                errno = ENOMEM;
+                return -1;
+        }
+
+        va_start (ap, num);
+
+        for (i = 0; i < num; ++i) {
+                alg[i]  = va_arg (ap, crapi_alg_t);
+                dst[i]  = va_arg (ap, void *);
+                size[i] = va_arg (ap, size_t *);
+        }
+
+        va_end (ap);
+
+        ret = crapi_mdigest_fdv (fd, num, alg, dst, size);
+
+        free(alg);
+        free(dst);
+        free(size);
+        return ret;
+}
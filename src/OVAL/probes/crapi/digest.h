@@ -57,4 +57,10 @@ struct digest_ctbl_t {
 
 int crapi_mdigest_fd (int fd, int num, ... /*crapi_alg_t alg, void *dst, size_t *size, ...*/);
 
+/*
+ * Compute num digests of the file in one pass, like crapi_mdigest_fd with
+ * the algorithms, destinations and sizes passed in arrays.
+ */
+int crapi_mdigest_fdv (int fd, int num, const crapi_alg_t *alg, void **dst, size_t **size);
+
 #endif /* CRAPI_DIGEST_H */
@@ -175,6 +175,7 @@ int crapi_md5_fd (int fd, void *dst, size_t *size)
         if (fstat (fd, &st) != 0)
                 return (-1);
         else {
+                crapi_io_advise (fd);
 #if _FILE_OFFSET_BITS == 32
                 buflen = st.st_size;
 # if defined(OS_FREEBSD)
@@ -182,32 +183,26 @@ int crapi_md5_fd (int fd, void *dst, size_t *size)
 # else
                 buffer = mmap (NULL, buflen, PROT_READ, MAP_SHARED, fd, 0);        
 # endif
-                if (buffer == NULL) {
+                if (buffer == MAP_FAILED) {
 #endif
-                        uint8_t _buffer[CRAPI_IO_BUFSZ];
+                        size_t  _bufsz;
                         void   *ctx;
                         ssize_t ret;
                 
-                        buffer = _buffer;
+                        buffer = crapi_io_buffer (&_bufsz);
+                        if (buffer == NULL)
+                                return (-1);
                         ctx    = crapi_md5_init (dst, size);
                         
                         if (ctx == NULL)
                                 return (-1);
                 
-                        while ((ret = read (fd, buffer, sizeof _buffer)) == sizeof _buffer)
-                                crapi_md5_update (ctx, buffer, sizeof _buffer);
-                        
-                        switch (ret) {
-                        case 0:
-                                break;
-                        case -1:
-                                return (-1);
-                        default:
-				if (ret <= 0) {
-					crapi_md5_free(ctx);
-					return -1;
-				}
+                        while ((ret = crapi_io_read (fd, buffer, _bufsz)) > 0)
                                 crapi_md5_update (ctx, buffer, (size_t) ret);
+
+                        if (ret < 0) {
+                                crapi_md5_free(ctx);
+                                return (-1);
                         }
                         
                         crapi_md5_fini (ctx);
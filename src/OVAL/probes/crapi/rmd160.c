@@ -138,6 +138,7 @@ int crapi_rmd160_fd (int fd, void *dst, size_t *size)
         if (fstat (fd, &st) != 0)
                 return (-1);
         else {
+                crapi_io_advise (fd);
 #if _FILE_OFFSET_BITS == 32
                 buflen = st.st_size;
 # if defined(OS_FREEBSD)
@@ -145,29 +146,23 @@ int crapi_rmd160_fd (int fd, void *dst, size_t *size)
 # else
                 buffer = mmap (NULL, buflen, PROT_READ, MAP_SHARED, fd, 0);        
 # endif        
-                if (buffer == NULL) {
+                if (buffer == MAP_FAILED) {
 #endif /* _FILE_OFFSET_BITS == 32 */
-                        uint8_t _buffer[CRAPI_IO_BUFSZ];
+                        size_t  _bufsz;
                         gcry_md_hd_t hd;
                         ssize_t ret;
                 
-                        buffer = _buffer;
+                        buffer = crapi_io_buffer (&_bufsz);
+                        if (buffer == NULL)
+                                return (-1);
                         gcry_md_open (&hd, GCRY_MD_RMD160, 0);
                 
-                        while ((ret = read (fd, buffer, sizeof _buffer)) == sizeof _buffer)
-                                gcry_md_write (hd, (const void *)buffer, sizeof _buffer);
-                
-                        switch (ret) {
-                        case 0:
-                                break;
-                        case -1:
+                        while ((ret = crapi_io_read (fd, buffer, _bufsz)) > 0)
+                                gcry_md_write (hd, (const void *)buffer, (size_t) ret);
+
+                        if (ret < 0) {
+                                gcry_md_close(hd);
                                 return (-1);
-                        default:
-				if (ret <= 0) {
-					gcry_md_close(hd);
-					return -1;
-				}
-                                gcry_md_write (hd, (const void *)buffer, (size_t)ret);
                         }
                 
                         gcry_md_final (hd);
@@ -55,6 +55,7 @@ static int crapi_sha2_fd (HASH_HashType algo, int fd, void *dst, size_t *size)
         if (fstat (fd, &st) != 0)
                 return (-1);
         else {
+                crapi_io_advise (fd);
 #if _FILE_OFFSET_BITS == 32
                 buflen = st.st_size;
 # if defined(OS_FREEBSD)
@@ -62,32 +63,26 @@ static int crapi_sha2_fd (HASH_HashType algo, int fd, void *dst, size_t *size)
 # else
                 buffer = mmap (NULL, buflen, PROT_READ, MAP_SHARED, fd, 0);
 # endif
-                if (buffer == NULL) {
+                if (buffer == MAP_FAILED) {
 #endif /* _FILE_OFFSET_BITS == 32 */
-                        uint8_t _buffer[CRAPI_IO_BUFSZ];
+                        size_t  _bufsz;
                         HASHContext *ctx;
                         ssize_t ret;
 
-                        buffer = _buffer;
+                        buffer = crapi_io_buffer (&_bufsz);
+                        if (buffer == NULL)
+                                return (-1);
                         ctx    = HASH_Create (algo);
 
                         if (ctx == NULL)
                                 return (-1);
 
-                        while ((ret = read (fd, buffer, sizeof _buffer)) == sizeof _buffer)
-                                HASH_Update (ctx, (const unsigned char *)buffer, (unsigned int) sizeof _buffer);
+                        while ((ret = crapi_io_read (fd, buffer, _bufsz)) > 0)
+                                HASH_Update (ctx, (const unsigned char *)buffer, (unsigned int) ret);
 
-                        switch (ret) {
-                        case 0:
-                                break;
-                        case -1:
+                        if (ret < 0) {
+                                HASH_Destroy(ctx);
                                 return (-1);
-                        default:
-				if (ret <= 0) {
-					HASH_Destroy(ctx);
-					return -1;
-				}
-                                HASH_Update (ctx, (const unsigned char *)buffer, (unsigned int) ret);
                         }
 
                         HASH_End (ctx, dst, (unsigned int *)size, *size);
@@ -223,6 +218,7 @@ static int crapi_sha2_fd (int algo, int fd, void *dst, size_t *size)
         if (fstat (fd, &st) != 0)
                 return (-1);
         else {
+                crapi_io_advise (fd);
 #if _FILE_OFFSET_BITS == 32
                 buflen = st.st_size;
 # if defined(OS_FREEBSD)
@@ -230,29 +226,23 @@ static int crapi_sha2_fd (int algo, int fd, void *dst, size_t *size)
 # else
                 buffer = mmap (NULL, buflen, PROT_READ, MAP_SHARED, fd, 0);
 # endif
-                if (buffer == NULL) {
+                if (buffer == MAP_FAILED) {
 #endif /* _FILE_OFFSET_BITS == 32 */
-                        uint8_t _buffer[CRAPI_IO_BUFSZ];
+                        size_t  _bufsz;
                         gcry_md_hd_t hd;
                         ssize_t ret;
 
-                        buffer = _buffer;
+                        buffer = crapi_io_buffer (&_bufsz);
+                        if (buffer == NULL)
+                                return (-1);
                         gcry_md_open (&hd, algo, 0);
 
-                        while ((ret = read (fd, buffer, sizeof _buffer)) == sizeof _buffer)
-                                gcry_md_write (hd, (const void *)buffer, sizeof _buffer);
+                        while ((ret = crapi_io_read (fd, buffer, _bufsz)) > 0)
+                                gcry_md_write (hd, (const void *)buffer, (size_t) ret);
 
-                        switch (ret) {
-                        case 0:
-                                break;
-                        case -1:
+                        if (ret < 0) {
+                                gcry_md_close(hd);
                                 return (-1);
-                        default:
-				if (ret <= 0) {
-					gcry_md_close(hd);
-					return -1;
-				}
-                                gcry_md_write (hd, (const void *)buffer, (size_t)ret);
                         }
 
                         gcry_md_final (hd);
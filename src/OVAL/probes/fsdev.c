@@ -38,10 +38,16 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <errno.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <pthread.h>
 
 #if defined(OS_LINUX)
 # include <mntent.h>
+# include <sys/statvfs.h>
 # include <unistd.h>
+# include <fcntl.h>
+# include <poll.h>
 # ifndef _PATH_MOUNTED
 #  define _PATH_MOUNTED MOUNTED
 # endif
@@ -57,6 +63,7 @@
 # include <unistd.h>
 # include <mntent.h>
 # include <fshelp.h>
+# include <sys/statvfs.h>
 # include <sys/vfs.h>
 # include <sys/vmount.h>
 # define _PATH_MOUNTED MOUNTED
@@ -175,29 +182,109 @@ static int is_local_fs(struct mntent *ment)
 
 #endif /* OS_AIX */
 
-static fsdev_t *__fsdev_init(fsdev_t *lfs)
+struct fsdev_statvfs {
+	bool done;
+	int err;
+	struct statvfs st;
+};
+
+struct fsdev_mounts {
+	uint32_t refs;
+	size_t count;
+	struct mntent *ents;
+	struct fsdev_statvfs *vfs; /**< filled in on demand */
+};
+
+static void fsdev_mounts_free(fsdev_mounts_t *mounts)
+{
+	size_t i;
+
+	for (i = 0; i < mounts->count; ++i) {
+		free(mounts->ents[i].mnt_fsname);
+		free(mounts->ents[i].mnt_dir);
+		free(mounts->ents[i].mnt_type);
+		free(mounts->ents[i].mnt_opts);
+	}
+	free(mounts->ents);
+	free(mounts->vfs);
+	free(mounts);
+}
+
+fsdev_mounts_t *fsdev_mounts_read(const char *path)
 {
 	int e;
 	FILE *fp;
-	size_t i;
+	size_t alloc = 0;
+	struct mntent *ment, *ent;
+	fsdev_mounts_t *mounts;
 
-	struct mntent *ment;
-	struct stat st;
+	mounts = calloc(1, sizeof(fsdev_mounts_t));
+	if (mounts == NULL)
+		return (NULL);
+	mounts->refs = 1;
 
-	fp = setmntent(_PATH_MOUNTED, "r");
+	fp = setmntent(path, "r");
 	if (fp == NULL) {
 		e = errno;
-		free(lfs);
+		free(mounts);
+		errno = e;
+		return (NULL);
+	}
+
+	while ((ment = getmntent(fp)) != NULL) {
+		if (mounts->count == alloc) {
+			alloc += DEVID_ARRAY_SIZE;
+			void *new_ents = realloc(mounts->ents, sizeof(struct mntent) * alloc);
+			if (new_ents == NULL)
+				break;
+			mounts->ents = new_ents;
+		}
+		ent = &mounts->ents[mounts->count];
+		*ent = *ment;
+		ent->mnt_fsname = strdup(ment->mnt_fsname);
+		ent->mnt_dir    = strdup(ment->mnt_dir);
+		ent->mnt_type   = strdup(ment->mnt_type);
+		ent->mnt_opts   = strdup(ment->mnt_opts);
+		++mounts->count;
+		if (ent->mnt_fsname == NULL || ent->mnt_dir == NULL ||
+		    ent->mnt_type == NULL || ent->mnt_opts == NULL)
+			break;
+	}
+	e = errno;
+	endmntent(fp);
+
+	if (ment != NULL) {
+		fsdev_mounts_free(mounts);
 		errno = e;
 		return (NULL);
 	}
 
+	mounts->vfs = calloc(mounts->count > 0 ? mounts->count : 1, sizeof(struct fsdev_statvfs));
+	if (mounts->vfs == NULL) {
+		fsdev_mounts_free(mounts);
+		return (NULL);
+	}
+
+	return (mounts);
+}
+
+const struct mntent *fsdev_mounts_entry(const fsdev_mounts_t *mounts, size_t i)
+{
+	return i < mounts->count ? &mounts->ents[i] : NULL;
+}
+
+static fsdev_t *__fsdev_init_mounts(fsdev_t *lfs, const fsdev_mounts_t *mounts)
+{
+	int e;
+	size_t i, m;
+
+	struct stat st;
+
 	lfs->ids = malloc(sizeof(dev_t) * DEVID_ARRAY_SIZE);
 
 	if (lfs->ids == NULL) {
 		e = errno;
 		free(lfs);
-		endmntent(fp);
 		errno = e;
 		return (NULL);
 	}
@@ -205,7 +292,9 @@ static fsdev_t *__fsdev_init(fsdev_t *lfs)
 	lfs->cnt = DEVID_ARRAY_SIZE;
 	i = 0;
 
-	while ((ment = getmntent(fp)) != NULL) {
+	for (m = 0; m < mounts->count; ++m) {
+		struct mntent *ment = &mounts->ents[m];
+
 		if (!is_local_fs(ment))
 			continue;
 		if (stat(ment->mnt_dir, &st) != 0)
@@ -217,7 +306,6 @@ static fsdev_t *__fsdev_init(fsdev_t *lfs)
 				e = errno;
 				free(lfs->ids);
 				free(lfs);
-				endmntent(fp);
 				errno = e;
 				return (NULL);
 			}
@@ -226,8 +314,6 @@ static fsdev_t *__fsdev_init(fsdev_t *lfs)
 		memcpy(&(lfs->ids[i++]), &st.st_dev, sizeof(dev_t));
 	}
 
-	endmntent(fp);
-
 	void *new_ids = realloc(lfs->ids, sizeof(dev_t) * i);
 	if (new_ids == NULL && i > 0) {
 		e = errno;
@@ -242,6 +328,27 @@ static fsdev_t *__fsdev_init(fsdev_t *lfs)
 	return (lfs);
 }
 
+static fsdev_t *__fsdev_init(fsdev_t *lfs)
+{
+	int e;
+	fsdev_mounts_t *mounts;
+
+	mounts = fsdev_mounts_read(_PATH_MOUNTED);
+	if (mounts == NULL) {
+		e = errno;
+		free(lfs);
+		errno = e;
+		return (NULL);
+	}
+
+	lfs = __fsdev_init_mounts(lfs, mounts);
+	e = errno;
+	fsdev_mounts_free(mounts);
+	errno = e;
+
+	return (lfs);
+}
+
 #elif defined(OS_FREEBSD) || defined(OS_APPLE)
 static fsdev_t *__fsdev_init(fsdev_t *lfs)
 {
@@ -357,8 +464,9 @@ fsdev_t *fsdev_init()
 
 	if (lfs == NULL)
 		return (NULL);
+	lfs->refs = 0;
 
-	if (__fsdev_init(lfs) == NULL)
+	if ((lfs = __fsdev_init(lfs)) == NULL)
 		return (NULL);
 
         if (lfs->ids != NULL && lfs->cnt > 1)
@@ -376,6 +484,184 @@ void fsdev_free(fsdev_t * lfs)
 	return;
 }
 
+static pthread_mutex_t fsdev_shared_lock = PTHREAD_MUTEX_INITIALIZER;
+static fsdev_t *fsdev_shared = NULL;
+static unsigned int fsdev_shared_gen = 0;
+static unsigned int fsdev_generation = 0;
+#if defined(OS_LINUX)
+static int fsdev_mountinfo_fd = -1;
+#endif
+#if defined(OS_LINUX) || defined(OS_AIX)
+static fsdev_mounts_t *fsdev_mounts_shared = NULL;
+static unsigned int fsdev_mounts_gen = 0;
+#endif
+
+/*
+ * Get the generation of the mount table, it's bumped each time a change
+ * is seen so that all the shared tables notice it.
+ * must be called with fsdev_shared_lock held
+ */
+static unsigned int fsdev_shared_generation(void)
+{
+#if defined(OS_LINUX)
+	struct pollfd pfd;
+
+	if (fsdev_mountinfo_fd == -1) {
+		fsdev_mountinfo_fd = open("/proc/self/mountinfo", O_RDONLY | O_CLOEXEC);
+		/* can't tell, the tables are built once then */
+		if (fsdev_mountinfo_fd == -1)
+			return fsdev_generation;
+		/* the first poll reports the current state as a change */
+		pfd.fd = fsdev_mountinfo_fd;
+		pfd.events = POLLPRI;
+		(void)poll(&pfd, 1, 0);
+		return fsdev_generation;
+	}
+
+	pfd.fd = fsdev_mountinfo_fd;
+	pfd.events = POLLPRI;
+	pfd.revents = 0;
+	if (poll(&pfd, 1, 0) > 0 && (pfd.revents & (POLLPRI | POLLERR)))
+		++fsdev_generation;
+#endif
+	return fsdev_generation;
+}
+
+#if defined(OS_LINUX) || defined(OS_AIX)
+/* must be called with fsdev_shared_lock held */
+static fsdev_mounts_t *fsdev_mounts_current(unsigned int gen)
+{
+	fsdev_mounts_t *mounts;
+
+	if (fsdev_mounts_shared != NULL && fsdev_mounts_gen == gen)
+		return fsdev_mounts_shared;
+
+	mounts = fsdev_mounts_read(_PATH_MOUNTED);
+	if (mounts == NULL)
+		return NULL;
+	/* users of the old table keep it until they put it */
+	if (fsdev_mounts_shared != NULL && --fsdev_mounts_shared->refs == 0)
+		fsdev_mounts_free(fsdev_mounts_shared);
+	fsdev_mounts_shared = mounts;
+	fsdev_mounts_gen = gen;
+
+	return mounts;
+}
+
+fsdev_mounts_t *fsdev_mounts_get(void)
+{
+	fsdev_mounts_t *mounts;
+
+	pthread_mutex_lock(&fsdev_shared_lock);
+	mounts = fsdev_mounts_current(fsdev_shared_generation());
+	if (mounts != NULL)
+		mounts->refs++;
+	pthread_mutex_unlock(&fsdev_shared_lock);
+
+	return mounts;
+}
+
+void fsdev_mounts_put(fsdev_mounts_t *mounts)
+{
+	if (mounts == NULL)
+		return;
+
+	pthread_mutex_lock(&fsdev_shared_lock);
+	if (--mounts->refs == 0)
+		fsdev_mounts_free(mounts);
+	pthread_mutex_unlock(&fsdev_shared_lock);
+}
+
+int fsdev_mounts_statvfs(fsdev_mounts_t *mounts, size_t i, const char *prefix, struct statvfs *st)
+{
+	char path[PATH_MAX];
+	struct fsdev_statvfs *vfs;
+	int ret, e;
+
+	if (i >= mounts->count) {
+		errno = EINVAL;
+		return (-1);
+	}
+	vfs = &mounts->vfs[i];
+
+	pthread_mutex_lock(&fsdev_shared_lock);
+	if (vfs->done) {
+		*st = vfs->st;
+		e = vfs->err;
+		pthread_mutex_unlock(&fsdev_shared_lock);
+		errno = e;
+		return (e == 0 ? 0 : -1);
+	}
+	pthread_mutex_unlock(&fsdev_shared_lock);
+
+	/* statvfs may block on a network filesystem, don't hold the lock */
+	snprintf(path, sizeof(path), "%s%s", prefix != NULL ? prefix : "", mounts->ents[i].mnt_dir);
+	ret = statvfs(path, st);
+	e = ret == 0 ? 0 : errno;
+
+	pthread_mutex_lock(&fsdev_shared_lock);
+	if (!vfs->done) {
+		vfs->done = true;
+		vfs->err = e;
+		if (ret == 0)
+			vfs->st = *st;
+	}
+	pthread_mutex_unlock(&fsdev_shared_lock);
+
+	errno = e;
+	return (ret);
+}
+#endif
+
+fsdev_t *fsdev_get(void)
+{
+	fsdev_t *lfs;
+	unsigned int gen;
+
+	pthread_mutex_lock(&fsdev_shared_lock);
+	gen = fsdev_shared_generation();
+	if (fsdev_shared == NULL || fsdev_shared_gen != gen) {
+#if defined(OS_LINUX) || defined(OS_AIX)
+		fsdev_mounts_t *mounts = fsdev_mounts_current(gen);
+
+		lfs = NULL;
+		if (mounts != NULL && (lfs = malloc(sizeof(fsdev_t))) != NULL) {
+			lfs->refs = 0;
+			lfs = __fsdev_init_mounts(lfs, mounts);
+			if (lfs != NULL && lfs->ids != NULL && lfs->cnt > 1)
+				qsort(lfs->ids, lfs->cnt, sizeof(dev_t), fsdev_cmp);
+		}
+#else
+		lfs = fsdev_init();
+#endif
+		if (lfs != NULL) {
+			/* users of the old table keep it until they put it */
+			if (fsdev_shared != NULL && --fsdev_shared->refs == 0)
+				fsdev_free(fsdev_shared);
+			lfs->refs = 1;
+			fsdev_shared = lfs;
+			fsdev_shared_gen = gen;
+		}
+	}
+	lfs = fsdev_shared;
+	if (lfs != NULL)
+		lfs->refs++;
+	pthread_mutex_unlock(&fsdev_shared_lock);
+
+	return lfs;
+}
+
+void fsdev_put(fsdev_t *lfs)
+{
+	if (lfs == NULL)
+		return;
+
+	pthread_mutex_lock(&fsdev_shared_lock);
+	if (--lfs->refs == 0)
+		fsdev_free(lfs);
+	pthread_mutex_unlock(&fsdev_shared_lock);
+}
+
 int fsdev_search(fsdev_t * lfs, void *id)
 {
 	uint16_t w, s;
@@ -37,6 +37,7 @@
 
 #if defined(__linux__) || defined(_AIX)
 #include <mntent.h>
+#include <sys/statvfs.h>
 #endif
 
 /**
@@ -45,6 +46,7 @@
 typedef struct {
 	dev_t *ids;   /**< Sorted array of device ids   */
 	uint16_t cnt; /**< Number of items in the array */
+	uint32_t refs; /**< Users of the shared table, 0 if not shared */
 } fsdev_t;
 
 /**
@@ -58,6 +60,19 @@ fsdev_t *fsdev_init(void);
  */
 void fsdev_free(fsdev_t *lfs);
 
+/**
+ * Get the fsdev_t structure shared by the whole process. The table is built
+ * on the first call and rebuilt when the mount table changes, which is
+ * detected by poll(2) on /proc/self/mountinfo on Linux. The table has to be
+ * given back by fsdev_put.
+ */
+fsdev_t *fsdev_get(void);
+
+/**
+ * Give back a table obtained by fsdev_get.
+ */
+void fsdev_put(fsdev_t *lfs);
+
 /**
  * Search an id in the fsdev_t structure.
  */
@@ -85,4 +100,47 @@ int fsdev_path(fsdev_t *lfs, const char *path);
  */
 int fsdev_fd(fsdev_t *lfs, int fd);
 
+#if defined(__linux__) || defined(_AIX)
+/**
+ * Snapshot of the mount table.
+ */
+typedef struct fsdev_mounts fsdev_mounts_t;
+
+/**
+ * Read a mount table, e.g. /proc/mounts of an offline system. The snapshot
+ * has to be given back by fsdev_mounts_put.
+ * @return the snapshot or NULL with errno set if the table can't be read
+ */
+fsdev_mounts_t *fsdev_mounts_read(const char *path);
+
+/**
+ * Get the snapshot of the mount table shared by the whole process, the
+ * one fsdev_get builds its table from. It's taken again when the mount
+ * table changes like the fsdev_t structure. The snapshot has to be given
+ * back by fsdev_mounts_put.
+ */
+fsdev_mounts_t *fsdev_mounts_get(void);
+
+/**
+ * Give back a snapshot obtained by fsdev_mounts_get or fsdev_mounts_read.
+ */
+void fsdev_mounts_put(fsdev_mounts_t *mounts);
+
+/**
+ * Get the i-th entry of the snapshot, the entry must not be modified.
+ * @return the entry or NULL past the last one
+ */
+const struct mntent *fsdev_mounts_entry(const fsdev_mounts_t *mounts, size_t i);
+
+/**
+ * Get the statvfs(3) of the i-th mount point. It's called once per
+ * snapshot, later calls get the same result.
+ * @param prefix prepended to the mount point, may be NULL
+ * @retval 0 on success
+ * @retval -1 with errno set on failure
+ */
+int fsdev_mounts_statvfs(fsdev_mounts_t *mounts, size_t i, const char *prefix, struct statvfs *st);
+#endif
+
+
 #endif				/* FSDEV_H */
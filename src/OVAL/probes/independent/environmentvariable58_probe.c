@@ -68,6 +68,7 @@
 #include "probe/entcmp.h"
 #include "common/debug_priv.h"
 #include "environmentvariable58_probe.h"
+#include "oval_proc_cache.h"
 
 #if defined(OS_FREEBSD)
 static int read_environment(SEXP_t *pid_ent, SEXP_t *name_ent, probe_ctx *ctx)
@@ -232,8 +233,6 @@ static int read_environment(SEXP_t *pid_ent, SEXP_t *name_ent, probe_ctx *ctx)
 }
 
 #else
-#define BUFFER_SIZE 256
-
 extern char **environ;
 
 static int collect_variable(char *buffer, size_t env_name_size, int pid, SEXP_t *name_ent, probe_ctx *ctx)
@@ -261,14 +260,10 @@ static int collect_variable(char *buffer, size_t env_name_size, int pid, SEXP_t
 
 static int read_environment(SEXP_t *pid_ent, SEXP_t *name_ent, probe_ctx *ctx)
 {
-	int err = 1, pid, fd;
-	bool empty;
+	int err = 1, pid, *pids;
 	SEXP_t *item, *pid_sexp;
-	DIR *d;
-	struct dirent *d_entry;
-	char *buffer, *null_char, path[PATH_MAX] = {0};
-	ssize_t buffer_used;
-	size_t buffer_size;
+	char *buffer, *var, path[PATH_MAX] = {0};
+	size_t buffer_size, pid_count, i;
 
 	const char *extra_vars = getenv("OSCAP_CONTAINER_VARS");
 	if (extra_vars && *extra_vars) {
@@ -291,25 +286,13 @@ static int read_environment(SEXP_t *pid_ent, SEXP_t *name_ent, probe_ctx *ctx)
 	}
 
 	const char *prefix = getenv("OSCAP_PROBE_ROOT");
-	snprintf(path, PATH_MAX, "%s/proc", prefix ? prefix : "");
-	d = opendir(path);
-	if (d == NULL) {
+	if (oval_proc_cache_pids(&pids, &pid_count) != 0) {
 		dE("Can't read %s/proc: errno=%d, %s.", prefix ? prefix : "", errno, strerror(errno));
 		return PROBE_EACCESS;
 	}
 
-	if ((buffer = realloc(NULL, BUFFER_SIZE)) == NULL) {
-		dE("Can't re-allocate memory");
-		closedir(d);
-		return PROBE_EFAULT;
-	}
-	buffer_size = BUFFER_SIZE;
-
-	while ((d_entry = readdir(d))) {
-		if (strspn(d_entry->d_name, "0123456789") != strlen(d_entry->d_name))
-			continue;
-
-		pid = atoi(d_entry->d_name);
+	for (i = 0; i < pid_count; ++i) {
+		pid = pids[i];
 		pid_sexp = SEXP_number_newi_32(pid);
 
 		if (probe_entobj_cmp(pid_ent, pid_sexp) != OVAL_RESULT_TRUE) {
@@ -318,8 +301,10 @@ static int read_environment(SEXP_t *pid_ent, SEXP_t *name_ent, probe_ctx *ctx)
 		}
 		SEXP_free(pid_sexp);
 
-		snprintf(path, PATH_MAX, "%s/proc/%d/environ", prefix ? prefix : "", pid);
-		if ((fd = open(path, O_RDONLY)) == -1) {
+		/* the environments are kept for the other objects of the scan */
+		buffer = oval_proc_cache_environ(pid, &buffer_size);
+		if (buffer == NULL) {
+			snprintf(path, PATH_MAX, "%s/proc/%d/environ", prefix ? prefix : "", pid);
 			dE("Can't open \"%s\": errno=%d, %s.", path, errno, strerror (errno));
 			item = probe_item_create(
 					OVAL_INDEPENDENT_ENVIRONMENT_VARIABLE58, NULL,
@@ -334,60 +319,23 @@ static int read_environment(SEXP_t *pid_ent, SEXP_t *name_ent, probe_ctx *ctx)
 			continue;
 		}
 
-		empty = true;
-
-		if ((buffer_used = read(fd, buffer, buffer_size - 1)) > 0) {
-			empty = false;
-		}
-
-		while (! empty) {
-			while (! (null_char = memchr(buffer, 0, buffer_used))) {
-				ssize_t s;
-				if ((size_t)buffer_used >= buffer_size) {
-					buffer_size += BUFFER_SIZE;
-					void *new_buffer = realloc(buffer, buffer_size);
-					if (new_buffer == NULL) {
-						dE("Can't re-allocate memory");
-						free(buffer);
-						closedir(d);
-						close(fd);
-						return PROBE_ENOMEM;
-					}
-					buffer = new_buffer;
-				}
-				s = read(fd, buffer + buffer_used, buffer_size - buffer_used);
-				if (s <= 0) {
-					empty = true;
-					buffer[buffer_used++] = 0;
-				}
-				else {
-					buffer_used += s;
-				}
+		/* the data is NUL terminated even if the last variable isn't */
+		for (var = buffer; var < buffer + buffer_size; var += strlen(var) + 1) {
+			char *eq_char = strchr(var, '=');
+			if (eq_char == NULL) {
+				/* strange but possible:
+				 * $ strings /proc/1218/environ
+				/dev/input/event0 /dev/input/event1 /dev/input/event4 /dev/input/event3
+				*/
+				continue;
 			}
 
-			do {
-				char *eq_char = strchr(buffer, '=');
-				if (eq_char == NULL) {
-					/* strange but possible:
-					 * $ strings /proc/1218/environ
- 					/dev/input/event0 /dev/input/event1 /dev/input/event4 /dev/input/event3
-					*/
-					buffer_used -= null_char + 1 - buffer;
-					memmove(buffer, null_char + 1, buffer_used);
-					continue;
-				}
-
-				collect_variable(buffer, eq_char - buffer, pid, name_ent, ctx);
-
-				buffer_used -= null_char + 1 - buffer;
-				memmove(buffer, null_char + 1, buffer_used);
-			} while ((null_char = memchr(buffer, 0, buffer_used)));
+			collect_variable(var, eq_char - var, pid, name_ent, ctx);
 		}
 
-		close(fd);
+		free(buffer);
 	}
-	closedir(d);
-	free(buffer);
+	free(pids);
 	if (err) {
 		SEXP_t *msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR,
 				"Can't find process with requested PID.");
@@ -45,18 +45,31 @@
 #include <limits.h>
 #include <pthread.h>
 #include <errno.h>
+#include <stdbool.h>
+#include <unistd.h>
 #include <crapi/crapi.h>
 #include <probe/probe.h>
 #include <probe/option.h>
 
 #include "common/debug_priv.h"
 #include "oval_fts.h"
+#include "oval_digest_cache.h"
 #include "util.h"
 #include "probe/entcmp.h"
 #include "filehash58_probe.h"
 #include "oscap_helpers.h"
+#include "common/oscap_threadpool.h"
 
 #define FILE_SEPARATOR '/'
+/* number of OVAL_FILEHASH58_HASH_TYPES */
+#define FILEHASH58_MAX_TYPES 6
+/* SHA-512 */
+#define FILEHASH58_MAX_DIGEST 64
+#ifndef FILEHASH58_MAX_JOBS
+#define FILEHASH58_MAX_JOBS 16
+#endif
+/* files queued per hashing thread */
+#define FILEHASH58_QUEUE_FACTOR 4
 
 /* List of hash types listed in OVAL specification */
 static const char *OVAL_FILEHASH58_HASH_TYPES[] = {
@@ -101,6 +114,51 @@ static const struct oscap_string_map CRAPI_ALG_MAP_SIZE[] = {
 };
 
 
+/* hash types of the object, in the order of OVAL_FILEHASH58_HASH_TYPES */
+struct filehash58_type {
+	const char *name;
+	crapi_alg_t alg; /* 0 if not supported */
+	size_t size;
+};
+
+struct filehash58_job {
+	char *path;
+	char *file;
+	char  filepath[PATH_MAX+1];
+	int   open_errno;	/* 0 if the file was opened */
+	int   digest_ret;
+	bool  done;
+	uint8_t digest[FILEHASH58_MAX_TYPES][FILEHASH58_MAX_DIGEST];
+	size_t  digest_len[FILEHASH58_MAX_TYPES];
+};
+
+/*
+ * Files found by the walk are queued to a few threads which compute all
+ * the requested digests of a file in one read. Items are created by the
+ * probe thread in the order in which the files were found.
+ */
+struct filehash58_pool {
+	const char *prefix;
+	const struct filehash58_type *types;
+	size_t types_count;
+
+	pthread_mutex_t lock;
+	pthread_cond_t work_cond;
+	pthread_cond_t done_cond;
+	bool stop;
+
+	struct filehash58_job **queue;
+	size_t queue_size;
+	size_t queued;	/* counters of jobs ever queued, taken by a thread, */
+	size_t taken;	/* and turned into items; the slot of the job n is */
+	size_t emitted;	/* n % queue_size */
+
+	bool started;
+	size_t threads_max;
+	size_t threads_count;
+	pthread_t threads[FILEHASH58_MAX_JOBS];
+};
+
 static int mem2hex (uint8_t *mem, size_t mlen, char *str, size_t slen)
 {
 	const char ch[] = "0123456789abcdef";
@@ -121,124 +179,264 @@ static int mem2hex (uint8_t *mem, size_t mlen, char *str, size_t slen)
 	return (0);
 }
 
-static int filehash58_cb(const char *prefix, const char *p, const char *f, const char *h, probe_ctx *ctx)
+static void filehash58_job_free(struct filehash58_job *job)
 {
-	SEXP_t *itm;
+	free(job->path);
+	free(job->file);
+	free(job);
+}
 
-	char   pbuf[PATH_MAX+1];
-	size_t plen, flen;
+/* open the file and compute its digests, runs without the pool lock */
+static void filehash58_job_hash(struct filehash58_pool *pool, struct filehash58_job *job)
+{
+	crapi_alg_t alg[FILEHASH58_MAX_TYPES];
+	void *dst[FILEHASH58_MAX_TYPES];
+	size_t *size[FILEHASH58_MAX_TYPES];
+	int fd, num = 0;
 
-	int fd;
+	if (pool->prefix == NULL) {
+		fd = open(job->filepath, O_RDONLY);
+	} else {
+		char *path_with_prefix = oscap_path_join(pool->prefix, job->filepath);
+		fd = open(path_with_prefix, O_RDONLY);
+		free(path_with_prefix);
+	}
 
-	if (f == NULL)
-		return (0);
+	if (fd < 0) {
+		job->open_errno = errno;
+		return;
+	}
 
-	/*
-	 * Prepare path
-	 */
-	plen = strlen (p);
-	flen = strlen (f);
+	for (size_t i = 0; i < pool->types_count; i++) {
+		if (pool->types[i].alg == 0)
+			continue;
+		job->digest_len[i] = pool->types[i].size;
+		alg[num] = pool->types[i].alg;
+		dst[num] = job->digest[i];
+		size[num] = &job->digest_len[i];
+		++num;
+	}
 
-	if (plen + flen + 1 > PATH_MAX)
-		return (-1);
+	if (num > 0)
+		job->digest_ret = oval_digest_cache_fdv(fd, num, alg, dst, size);
 
-	memcpy (pbuf, p, sizeof (char) * plen);
+	close(fd);
+}
 
-	if (p[plen - 1] != FILE_SEPARATOR) {
-		pbuf[plen] = FILE_SEPARATOR;
-		++plen;
-	}
+static void *filehash58_pool_thread(void *arg)
+{
+	struct filehash58_pool *pool = arg;
+	struct filehash58_job *job;
 
-	memcpy (pbuf + plen, f, sizeof (char) * flen);
-	pbuf[plen+flen] = '\0';
+	pthread_mutex_lock(&pool->lock);
+	for (;;) {
+		while (!pool->stop && pool->taken == pool->queued)
+			pthread_cond_wait(&pool->work_cond, &pool->lock);
+		if (pool->taken == pool->queued)
+			break;
 
-	/*
-	 * Open the file
-	 */
-	if (prefix == NULL) {
-		fd = open(pbuf, O_RDONLY);
-	} else {
-		char *path_with_prefix = oscap_path_join(prefix, pbuf);
-		fd = open(path_with_prefix, O_RDONLY);
-		free(path_with_prefix);
+		job = pool->queue[pool->taken++ % pool->queue_size];
+		pthread_mutex_unlock(&pool->lock);
+
+		filehash58_job_hash(pool, job);
+
+		pthread_mutex_lock(&pool->lock);
+		job->done = true;
+		pthread_cond_broadcast(&pool->done_cond);
 	}
+	pthread_mutex_unlock(&pool->lock);
 
-	if (fd < 0) {
-		strerror_r (errno, pbuf, PATH_MAX);
-		pbuf[PATH_MAX] = '\0';
-
-		itm = probe_item_create (OVAL_INDEPENDENT_FILE_HASH58, NULL,
-					"filepath", OVAL_DATATYPE_STRING, pbuf,
-					"path",     OVAL_DATATYPE_STRING, p,
-					"filename", OVAL_DATATYPE_STRING, f,
-					"hash_type",OVAL_DATATYPE_STRING, h,
-					NULL);
-		probe_item_add_msg(itm, OVAL_MESSAGE_LEVEL_ERROR,
-			"Can't open \"%s\": errno=%d, %s.", pbuf, errno, strerror (errno));
-		probe_item_setstatus(itm, SYSCHAR_STATUS_ERROR);
-
-		probe_item_collect(ctx, itm);
-		return 0;
+	return NULL;
+}
+
+static size_t filehash58_pool_jobs(void)
+{
+	return oscap_threadpool_jobs(NULL, 0, FILEHASH58_MAX_JOBS);
+}
+
+static int filehash58_pool_init(struct filehash58_pool *pool, const char *prefix,
+                                const struct filehash58_type *types, size_t types_count)
+{
+	memset(pool, 0, sizeof(struct filehash58_pool));
+	pool->prefix = prefix;
+	pool->types = types;
+	pool->types_count = types_count;
+	pool->threads_max = filehash58_pool_jobs();
+	pool->queue_size = pool->threads_max * FILEHASH58_QUEUE_FACTOR;
+	pool->queue = calloc(pool->queue_size, sizeof(struct filehash58_job *));
+	if (pool->queue == NULL)
+		return -1;
+
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->work_cond, NULL);
+	pthread_cond_init(&pool->done_cond, NULL);
+
+	return 0;
+}
+
+/* the threads are started once there is more than one file to hash */
+static void filehash58_pool_start(struct filehash58_pool *pool)
+{
+	pool->started = true;
+	if (pool->threads_max < 2)
+		return;
+
+	for (size_t i = 0; i < pool->threads_max; i++) {
+		int err = pthread_create(&pool->threads[i], NULL, filehash58_pool_thread, pool);
+
+		if (err != 0) {
+			dW("Can't start a hashing thread: %s.", strerror(err));
+			break;
+		}
+		pool->threads_count++;
 	}
+}
+
+static void filehash58_collect(struct filehash58_pool *pool, struct filehash58_job *job, probe_ctx *ctx)
+{
+	SEXP_t *itm;
+	char hash_str[FILEHASH58_MAX_DIGEST * 2 + 1];
+
+	for (size_t i = 0; i < pool->types_count; i++) {
+		const struct filehash58_type *type = &pool->types[i];
+
+		itm = NULL;
+		if (job->open_errno != 0) {
+			itm = probe_item_create(OVAL_INDEPENDENT_FILE_HASH58, NULL,
+				"filepath", OVAL_DATATYPE_STRING, job->filepath,
+				"path", OVAL_DATATYPE_STRING, job->path,
+				"filename", OVAL_DATATYPE_STRING, job->file,
+				"hash_type", OVAL_DATATYPE_STRING, type->name,
+				NULL);
+			probe_item_add_msg(itm, OVAL_MESSAGE_LEVEL_ERROR,
+				"Can't open \"%s\": errno=%d, %s.", job->filepath,
+				job->open_errno, strerror(job->open_errno));
+			probe_item_setstatus(itm, SYSCHAR_STATUS_ERROR);
+		} else if (type->alg == 0) {
+			char *msg = oscap_sprintf("This version of OpenSCAP doesn't support the '%s' hash algorithm.", type->name);
+			dW(msg);
+			itm = probe_item_create(OVAL_INDEPENDENT_FILE_HASH58, NULL,
+				"filepath", OVAL_DATATYPE_STRING, job->filepath,
+				"path", OVAL_DATATYPE_STRING, job->path,
+				"filename", OVAL_DATATYPE_STRING, job->file,
+				"hash_type", OVAL_DATATYPE_STRING, type->name,
+				NULL);
+			probe_item_add_msg(itm, OVAL_MESSAGE_LEVEL_ERROR, msg);
+			free(msg);
+			probe_item_setstatus(itm, SYSCHAR_STATUS_ERROR);
+		} else if (job->digest_ret == 0) {
+			hash_str[0] = '\0';
+			mem2hex(job->digest[i], job->digest_len[i], hash_str, sizeof(hash_str));
+
+			itm = probe_item_create(OVAL_INDEPENDENT_FILE_HASH58, NULL,
+				"filepath", OVAL_DATATYPE_STRING, job->filepath,
+				"path", OVAL_DATATYPE_STRING, job->path,
+				"filename", OVAL_DATATYPE_STRING, job->file,
+				"hash_type", OVAL_DATATYPE_STRING, type->name,
+				"hash", OVAL_DATATYPE_STRING, hash_str,
+				NULL);
+
+			if (job->digest_len[i] == 0) {
+				probe_item_add_msg(itm, OVAL_MESSAGE_LEVEL_ERROR,
+					"Unable to compute %s hash value of \"%s\".", type->name, job->filepath);
+				probe_item_setstatus(itm, SYSCHAR_STATUS_ERROR);
+			}
+		}
 
-	uint8_t hash_dst[1025];
-	size_t hash_dstlen = sizeof(hash_dst);
-	char hash_str[2051];
-	crapi_alg_t hash_type;
-
-	hash_type = oscap_string_to_enum(CRAPI_ALG_MAP, h);
-	if (hash_type == 0) {
-		char *msg = oscap_sprintf("This version of OpenSCAP doesn't support the '%s' hash algorithm.", h);
-		dW(msg);
-		itm = probe_item_create (OVAL_INDEPENDENT_FILE_HASH58, NULL,
-			"filepath", OVAL_DATATYPE_STRING, pbuf,
-			"path", OVAL_DATATYPE_STRING, p,
-			"filename", OVAL_DATATYPE_STRING, f,
-			"hash_type", OVAL_DATATYPE_STRING, h,
-			NULL);
-		probe_item_add_msg(itm, OVAL_MESSAGE_LEVEL_ERROR, msg);
-		free(msg);
-		probe_item_setstatus(itm, SYSCHAR_STATUS_ERROR);
-		probe_item_collect(ctx, itm);
-		close(fd);
-		return 0;
+		if (itm != NULL)
+			probe_item_collect(ctx, itm);
 	}
+}
 
-	hash_dstlen = oscap_string_to_enum(CRAPI_ALG_MAP_SIZE, h);
+/* wait for the oldest job and turn it into items, called with the lock held */
+static void filehash58_pool_emit(struct filehash58_pool *pool, probe_ctx *ctx)
+{
+	struct filehash58_job *job = pool->queue[pool->emitted % pool->queue_size];
 
-	/*
-	 * Compute hash value
-	 */
-	if (crapi_mdigest_fd(fd, 1, hash_type, hash_dst, &hash_dstlen) != 0) {
-		close (fd);
-		return (-1);
+	if (pool->threads_count == 0) {
+		/* no threads, hash in the probe thread */
+		pool->taken++;
+		pthread_mutex_unlock(&pool->lock);
+		filehash58_job_hash(pool, job);
+	} else {
+		while (!job->done)
+			pthread_cond_wait(&pool->done_cond, &pool->lock);
+		pthread_mutex_unlock(&pool->lock);
 	}
 
-	close (fd);
+	filehash58_collect(pool, job, ctx);
+	filehash58_job_free(job);
+
+	pthread_mutex_lock(&pool->lock);
+	pool->queue[pool->emitted++ % pool->queue_size] = NULL;
+}
+
+static void filehash58_pool_push(struct filehash58_pool *pool, struct filehash58_job *job, probe_ctx *ctx)
+{
+	pthread_mutex_lock(&pool->lock);
+	if (!pool->started && pool->queued > 0)
+		filehash58_pool_start(pool);
+	while (pool->queued - pool->emitted == pool->queue_size)
+		filehash58_pool_emit(pool, ctx);
+	pool->queue[pool->queued++ % pool->queue_size] = job;
+	pthread_cond_signal(&pool->work_cond);
+	pthread_mutex_unlock(&pool->lock);
+}
+
+static void filehash58_pool_finish(struct filehash58_pool *pool, probe_ctx *ctx)
+{
+	pthread_mutex_lock(&pool->lock);
+	while (pool->emitted < pool->queued)
+		filehash58_pool_emit(pool, ctx);
+	pool->stop = true;
+	pthread_cond_broadcast(&pool->work_cond);
+	pthread_mutex_unlock(&pool->lock);
+
+	for (size_t i = 0; i < pool->threads_count; i++)
+		pthread_join(pool->threads[i], NULL);
+
+	pthread_cond_destroy(&pool->done_cond);
+	pthread_cond_destroy(&pool->work_cond);
+	pthread_mutex_destroy(&pool->lock);
+	free(pool->queue);
+}
 
-	hash_str[0] = '\0';
-	mem2hex(hash_dst, hash_dstlen, hash_str, sizeof(hash_str));
+static struct filehash58_job *filehash58_job_new(const char *p, const char *f)
+{
+	struct filehash58_job *job;
+	size_t plen, flen;
 
 	/*
-	 * Create and add the item
+	 * Prepare path
 	 */
-	itm = probe_item_create(OVAL_INDEPENDENT_FILE_HASH58, NULL,
-		"filepath", OVAL_DATATYPE_STRING, pbuf,
-		"path", OVAL_DATATYPE_STRING, p,
-		"filename", OVAL_DATATYPE_STRING, f,
-		"hash_type",OVAL_DATATYPE_STRING, h,
-		"hash", OVAL_DATATYPE_STRING, hash_str,
-		NULL);
-
-	if (hash_dstlen == 0) {
-		probe_item_add_msg(itm, OVAL_MESSAGE_LEVEL_ERROR,
-			"Unable to compute %s hash value of \"%s\".", h, pbuf);
-		probe_item_setstatus(itm, SYSCHAR_STATUS_ERROR);
+	plen = strlen (p);
+	flen = strlen (f);
+
+	if (plen + flen + 1 > PATH_MAX)
+		return (NULL);
+
+	job = calloc(1, sizeof(struct filehash58_job));
+	if (job == NULL)
+		return (NULL);
+
+	memcpy (job->filepath, p, sizeof (char) * plen);
+
+	if (p[plen - 1] != FILE_SEPARATOR) {
+		job->filepath[plen] = FILE_SEPARATOR;
+		++plen;
 	}
 
-	probe_item_collect(ctx, itm);
+	memcpy (job->filepath + plen, f, sizeof (char) * flen);
+	job->filepath[plen+flen] = '\0';
 
-	return (0);
+	job->path = strdup(p);
+	job->file = strdup(f);
+	if (job->path == NULL || job->file == NULL) {
+		filehash58_job_free(job);
+		return (NULL);
+	}
+
+	return (job);
 }
 
 int filehash58_probe_offline_mode_supported()
@@ -282,6 +480,9 @@ int filehash58_probe_main(probe_ctx *ctx, void *arg)
 
 	OVAL_FTS    *ofts;
 	OVAL_FTSENT *ofts_ent;
+	struct filehash58_type types[FILEHASH58_MAX_TYPES];
+	size_t types_count = 0;
+	struct filehash58_pool pool;
 
 	pthread_mutex_t *filehash58_probe_mutex = (pthread_mutex_t *)arg;
 	if (filehash58_probe_mutex == NULL) {
@@ -320,25 +521,40 @@ int filehash58_probe_main(probe_ctx *ctx, void *arg)
 		goto cleanup;
 	}
 
+	/* find hash types to compare with entity, think "not satisfy" */
+	for (int i = 0; OVAL_FILEHASH58_HASH_TYPES[i] != NULL; i++) {
+		const char *oval_filehash58_hash_type = OVAL_FILEHASH58_HASH_TYPES[i];
+		SEXP_t *oval_filehash58_hash_type_sexp = SEXP_string_new(oval_filehash58_hash_type, strlen(oval_filehash58_hash_type));
+		if (probe_entobj_cmp(hash_type, oval_filehash58_hash_type_sexp) == OVAL_RESULT_TRUE) {
+			types[types_count].name = oval_filehash58_hash_type;
+			types[types_count].alg = oscap_string_to_enum(CRAPI_ALG_MAP, oval_filehash58_hash_type);
+			types[types_count].size = oscap_string_to_enum(CRAPI_ALG_MAP_SIZE, oval_filehash58_hash_type);
+			types_count++;
+		}
+
+		SEXP_free(oval_filehash58_hash_type_sexp);
+	}
+
 	const char *prefix = getenv("OSCAP_PROBE_ROOT");
+	if (types_count == 0 || filehash58_pool_init(&pool, prefix, types, types_count) != 0)
+		goto cleanup;
+
 	if ((ofts = oval_fts_open_prefixed(prefix, path, filename, filepath, behaviors, probe_ctx_getresult(ctx))) != NULL) {
 		while ((ofts_ent = oval_fts_read(ofts)) != NULL) {
-			/* find hash types to compare with entity, think "not satisfy" */
-			for (int i = 0; OVAL_FILEHASH58_HASH_TYPES[i] != NULL; i++) {
-				const char *oval_filehash58_hash_type = OVAL_FILEHASH58_HASH_TYPES[i];
-				SEXP_t *oval_filehash58_hash_type_sexp = SEXP_string_new(oval_filehash58_hash_type, strlen(oval_filehash58_hash_type));
-				if (probe_entobj_cmp(hash_type, oval_filehash58_hash_type_sexp) == OVAL_RESULT_TRUE) {
-					filehash58_cb(prefix, ofts_ent->path, ofts_ent->file, oval_filehash58_hash_type, ctx);
-				}
-
-				SEXP_free(oval_filehash58_hash_type_sexp);
-			}
+			struct filehash58_job *job = NULL;
+
+			if (ofts_ent->file != NULL)
+				job = filehash58_job_new(ofts_ent->path, ofts_ent->file);
+			if (job != NULL)
+				filehash58_pool_push(&pool, job, ctx);
 			oval_ftsent_free(ofts_ent);
 		}
 
 		oval_fts_close(ofts);
 	}
 
+	filehash58_pool_finish(&pool, ctx);
+
 cleanup:
 	SEXP_free (behaviors);
 	SEXP_free (path);
@@ -49,6 +49,7 @@
 #include <probe/option.h>
 
 #include "oval_fts.h"
+#include "oval_digest_cache.h"
 #include <common/debug_priv.h>
 #include "filehash_probe.h"
 
@@ -142,9 +143,11 @@ static int filehash_cb (const char *prefix, const char *p, const char *f, probe_
                 /*
                  * Compute hash values
                  */
-                if (crapi_mdigest_fd (fd, 2,
-                                      CRAPI_DIGEST_MD5,  md5_dst,  &md5_dstlen,
-                                      CRAPI_DIGEST_SHA1, sha1_dst, &sha1_dstlen) != 0)
+                const crapi_alg_t alg[2] = { CRAPI_DIGEST_MD5, CRAPI_DIGEST_SHA1 };
+                void   *dst[2]  = { md5_dst, sha1_dst };
+                size_t *size[2] = { &md5_dstlen, &sha1_dstlen };
+
+                if (oval_digest_cache_fdv (fd, 2, alg, dst, size) != 0)
                 {
                         close (fd);
                         return (-1);
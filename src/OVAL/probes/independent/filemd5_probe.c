@@ -49,6 +49,7 @@
 #include <probe/option.h>
 
 #include "oval_fts.h"
+#include "oval_digest_cache.h"
 
 #define FILE_SEPARATOR '/'
 
@@ -129,7 +130,11 @@ static int filehash_cb (const char *p, const char *f, void *ptr, const SEXP_t *f
                 /*
                  * Compute hash values
                  */
-                if (crapi_digest_fd (fd, CRAPI_DIGEST_MD5,  &md5_dst,  &md5_dstlen) != 0)
+                const crapi_alg_t alg = CRAPI_DIGEST_MD5;
+                void   *dst  = md5_dst;
+                size_t *size = &md5_dstlen;
+
+                if (oval_digest_cache_fdv (fd, 1, &alg, &dst, &size) != 0)
                 {
                         close (fd);
                         return (-1);
@@ -34,6 +34,7 @@
 #include "_seap.h"
 #include <probe-api.h>
 #include <stdlib.h>
+#include <stdbool.h>
 #include <string.h>
 #include <ctype.h>
 #include <common/debug_priv.h>
@@ -42,6 +43,7 @@
 #include <errno.h>
 #include <opendbx/api.h>
 #include "sql57_probe.h"
+#include "sql_pool.h"
 
 #ifndef SQLPROBE_DEFAULT_CONNTIMEOUT
 # define SQLPROBE_DEFAULT_CONNTIMEOUT 30
@@ -243,7 +245,8 @@ __fail:
 }
 
 static int dbSQL_eval(const char *engine, const char *version,
-                      const char *conn, const char *sql, probe_ctx *ctx)
+                      const char *conn, const char *sql, probe_ctx *ctx,
+                      sql_pool_t *pool)
 {
 	int err = -1;
 	dbURIInfo_t uriInfo = { .host = NULL,
@@ -263,6 +266,7 @@ static int dbSQL_eval(const char *engine, const char *version,
 		odbx_t        *sql_dbh = NULL; /* handle */
 		dbEngineMap_t *sql_dbe; /* engine */
 		odbx_result_t *sql_dbr; /* result */
+		bool           pooled;
 		SEXP_t        *item;
 
 		sql_dbe = oscap_bfind (engine_map, ENGINE_MAP_COUNT, sizeof(dbEngineMap_t), (char *)engine,
@@ -290,49 +294,62 @@ static int dbSQL_eval(const char *engine, const char *version,
 			goto __exit;
 		}
 
-		int odbx_res = odbx_init (&sql_dbh, sql_dbe->b_engine,
-				uriInfo.host, uriInfo.port);
-		if (odbx_res != ODBX_ERR_SUCCESS) {
-			const char *error_msg = odbx_error(NULL, odbx_res);
-			dE("odbx_init failed: e=%s, h=%s:%s msg=%s",
-				sql_dbe->b_engine, uriInfo.host, uriInfo.port,
-				error_msg != NULL ? error_msg : "(none)");
-			if (odbx_res == -ODBX_ERR_NOTEXIST) {
+		/* reuse a connection of an earlier object if there's one */
+		sql_dbh = sql_pool_get(pool, sql_dbe->b_engine, conn);
+		pooled  = sql_dbh != NULL;
+__connect:
+		if (sql_dbh == NULL) {
+			int odbx_res = odbx_init (&sql_dbh, sql_dbe->b_engine,
+					uriInfo.host, uriInfo.port);
+			if (odbx_res != ODBX_ERR_SUCCESS) {
+				const char *error_msg = odbx_error(NULL, odbx_res);
+				dE("odbx_init failed: e=%s, h=%s:%s msg=%s",
+					sql_dbe->b_engine, uriInfo.host, uriInfo.port,
+					error_msg != NULL ? error_msg : "(none)");
+				if (odbx_res == -ODBX_ERR_NOTEXIST) {
+					SEXP_t *msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR,
+						"odbx_init failed. Please install the opendbx %s backend", engine);
+					probe_cobj_add_msg(probe_ctx_getresult(ctx), msg);
+					SEXP_free(msg);
+					probe_cobj_set_flag(probe_ctx_getresult(ctx), SYSCHAR_FLAG_ERROR);
+					err = 0;
+					fprintf(stderr, "Could not connect to the database. "
+						"Please install the opendbx %s backend.\n",
+						sql_dbe->b_engine);
+				}
+				goto __exit;
+			}
+
+			/* set options */
+			odbx_res = odbx_bind(sql_dbh, uriInfo.db, uriInfo.user, uriInfo.pass, ODBX_BIND_SIMPLE);
+			if (odbx_res != ODBX_ERR_SUCCESS)
+			{
+				const char *error_msg = odbx_error(sql_dbh, odbx_res);
 				SEXP_t *msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR,
-					"odbx_init failed. Please install the opendbx %s backend", engine);
+					"odbx_bind failed. Could not connect to the database '%s': %s",
+					uriInfo.db, error_msg != NULL ? error_msg : "(none)");
 				probe_cobj_add_msg(probe_ctx_getresult(ctx), msg);
 				SEXP_free(msg);
 				probe_cobj_set_flag(probe_ctx_getresult(ctx), SYSCHAR_FLAG_ERROR);
 				err = 0;
-				fprintf(stderr, "Could not connect to the database. "
-					"Please install the opendbx %s backend.\n",
-					sql_dbe->b_engine);
+				dE("odbx_bind failed: db=%s, u=%s, p=%s",
+				   uriInfo.db, uriInfo.user, uriInfo.pass);
+				odbx_finish(sql_dbh);
+				goto __exit;
 			}
-			goto __exit;
-		}
-
-		/* set options */
-		odbx_res = odbx_bind(sql_dbh, uriInfo.db, uriInfo.user, uriInfo.pass, ODBX_BIND_SIMPLE);
-		if (odbx_res != ODBX_ERR_SUCCESS)
-		{
-			const char *error_msg = odbx_error(sql_dbh, odbx_res);
-			SEXP_t *msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR,
-				"odbx_bind failed. Could not connect to the database '%s': %s",
-				uriInfo.db, error_msg != NULL ? error_msg : "(none)");
-			probe_cobj_add_msg(probe_ctx_getresult(ctx), msg);
-			SEXP_free(msg);
-			probe_cobj_set_flag(probe_ctx_getresult(ctx), SYSCHAR_FLAG_ERROR);
-			err = 0;
-			dE("odbx_bind failed: db=%s, u=%s, p=%s",
-			   uriInfo.db, uriInfo.user, uriInfo.pass);
-			odbx_finish(sql_dbh);
-			goto __exit;
 		}
 
 		if (odbx_query(sql_dbh, sql, strlen (sql)) != ODBX_ERR_SUCCESS) {
-			dE("odbx_query failed: q=%s", sql);
 			odbx_finish(sql_dbh);
+			sql_dbh = NULL;
 
+			if (pooled) {
+				/* the server may have closed the idle connection */
+				dD("odbx_query failed on a pooled connection, reconnecting");
+				pooled = false;
+				goto __connect;
+			}
+			dE("odbx_query failed: q=%s", sql);
 			goto __exit;
 		} else {
 			sql_dbr = NULL;
@@ -420,10 +437,18 @@ static int dbSQL_eval(const char *engine, const char *version,
 				odbx_result_finish(sql_dbr);
 			}
 
+			if (sql_err == ODBX_RES_NOROWS) {
+				odbx_result_finish(sql_dbr);
+				/* read the rest so the connection can be pooled */
+				sql_err = sql_pool_drain(sql_dbh);
+			}
+
                         probe_item_collect(ctx, item);
 		}
 
-		if (odbx_finish(sql_dbh) != ODBX_ERR_SUCCESS) {
+		if (sql_err == ODBX_RES_DONE) {
+			sql_pool_put(pool, sql_dbe->b_engine, conn, sql_dbh);
+		} else if (odbx_finish(sql_dbh) != ODBX_ERR_SUCCESS) {
 			dE("odbx_finish failed");
 			goto __exit;
 		}
@@ -435,6 +460,16 @@ __exit:
 	return (err);
 }
 
+void *sql57_probe_init(void)
+{
+	return sql_pool_new();
+}
+
+void sql57_probe_fini(void *arg)
+{
+	sql_pool_free(arg);
+}
+
 int sql57_probe_main(probe_ctx *ctx, void *arg)
 {
 	char *engine, *version, *conn, *sqlexp;
@@ -479,7 +514,7 @@ int sql57_probe_main(probe_ctx *ctx, void *arg)
 	/*
 	 * evaluate the SQL statement
 	 */
-	err = dbSQL_eval(engine, version, conn, sqlexp, ctx);
+	err = dbSQL_eval(engine, version, conn, sqlexp, ctx, arg);
 __exit:
 	if (engine != NULL) {
 		__clearmem(conn, strlen(engine));
@@ -25,6 +25,10 @@
 
 #include "probe-api.h"
 
+void *sql57_probe_init(void);
+
 int sql57_probe_main(probe_ctx *ctx, void *arg);
 
+void sql57_probe_fini(void *arg);
+
 #endif /* OPENSCAP_SQL57_PROBE_H */
@@ -0,0 +1,151 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "common/debug_priv.h"
+#include "sql_pool.h"
+
+struct sql_pool_conn {
+	char *engine;
+	char *conn;   /* the connection string, it holds the password */
+	odbx_t *dbh;
+	struct sql_pool_conn *next;
+};
+
+struct sql_pool {
+	pthread_mutex_t lock;
+	struct sql_pool_conn *idle;
+};
+
+/* the connection string is wiped before it's freed */
+static void sql_pool_conn_free(struct sql_pool_conn *c)
+{
+	volatile char *p;
+
+	if (c->conn != NULL) {
+		for (p = c->conn; *p != '\0'; ++p)
+			*p = '\0';
+		free(c->conn);
+	}
+	free(c->engine);
+	free(c);
+}
+
+sql_pool_t *sql_pool_new(void)
+{
+	sql_pool_t *pool = malloc(sizeof(sql_pool_t));
+
+	if (pool == NULL)
+		return (NULL);
+
+	pthread_mutex_init(&pool->lock, NULL);
+	pool->idle = NULL;
+
+	return (pool);
+}
+
+void sql_pool_free(sql_pool_t *pool)
+{
+	struct sql_pool_conn *c, *next;
+
+	if (pool == NULL)
+		return;
+
+	for (c = pool->idle; c != NULL; c = next) {
+		next = c->next;
+		if (odbx_unbind(c->dbh) != ODBX_ERR_SUCCESS)
+			dD("odbx_unbind failed");
+		if (odbx_finish(c->dbh) != ODBX_ERR_SUCCESS)
+			dE("odbx_finish failed");
+		sql_pool_conn_free(c);
+	}
+	pthread_mutex_destroy(&pool->lock);
+	free(pool);
+}
+
+odbx_t *sql_pool_get(sql_pool_t *pool, const char *engine, const char *conn)
+{
+	struct sql_pool_conn **cp, *c;
+	odbx_t *dbh = NULL;
+
+	if (pool == NULL)
+		return (NULL);
+
+	pthread_mutex_lock(&pool->lock);
+	for (cp = &pool->idle; (c = *cp) != NULL; cp = &c->next) {
+		if (strcmp(c->engine, engine) == 0 && strcmp(c->conn, conn) == 0) {
+			*cp = c->next;
+			dbh = c->dbh;
+			sql_pool_conn_free(c);
+			break;
+		}
+	}
+	pthread_mutex_unlock(&pool->lock);
+
+	return (dbh);
+}
+
+void sql_pool_put(sql_pool_t *pool, const char *engine, const char *conn, odbx_t *dbh)
+{
+	struct sql_pool_conn *c;
+
+	c = pool != NULL ? calloc(1, sizeof(struct sql_pool_conn)) : NULL;
+	if (c != NULL) {
+		c->engine = strdup(engine);
+		c->conn = strdup(conn);
+		c->dbh = dbh;
+	}
+	if (c == NULL || c->engine == NULL || c->conn == NULL) {
+		if (c != NULL)
+			sql_pool_conn_free(c);
+		odbx_unbind(dbh);
+		odbx_finish(dbh);
+		return;
+	}
+
+	pthread_mutex_lock(&pool->lock);
+	c->next = pool->idle;
+	pool->idle = c;
+	pthread_mutex_unlock(&pool->lock);
+}
+
+int sql_pool_drain(odbx_t *dbh)
+{
+	odbx_result_t *dbr;
+	int res;
+
+	for (;;) {
+		dbr = NULL;
+		res = odbx_result(dbh, &dbr, NULL, 0);
+		if (dbr != NULL)
+			odbx_result_finish(dbr);
+		if (res == ODBX_RES_DONE)
+			return (0);
+		/* a timeout or an error leaves the connection in an unknown state */
+		if (res != ODBX_RES_ROWS && res != ODBX_RES_NOROWS)
+			return (-1);
+	}
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef OPENSCAP_SQL_POOL_H
+#define OPENSCAP_SQL_POOL_H
+
+#include <opendbx/api.h>
+
+/*
+ * Idle database connections of the sql and sql57 probes. A connection is
+ * taken out of the pool for the time of one query, so the objects being
+ * collected in parallel don't share it, and put back when the results
+ * were read. The pool lives from the probe init to the probe fini.
+ */
+
+typedef struct sql_pool sql_pool_t;
+
+sql_pool_t *sql_pool_new(void);
+
+/**
+ * Close all the idle connections and free the pool.
+ */
+void sql_pool_free(sql_pool_t *pool);
+
+/**
+ * Take an idle connection bound with the same backend and connection
+ * string out of the pool.
+ * @return the connection or NULL if there's none
+ */
+odbx_t *sql_pool_get(sql_pool_t *pool, const char *engine, const char *conn);
+
+/**
+ * Give a connection back to the pool so the next query with the same
+ * backend and connection string can use it.
+ */
+void sql_pool_put(sql_pool_t *pool, const char *engine, const char *conn, odbx_t *dbh);
+
+/**
+ * Read the remaining results of a query so the connection can be used
+ * for another one.
+ * @return 0 if the connection can be reused, -1 otherwise
+ */
+int sql_pool_drain(odbx_t *dbh);
+
+#endif /* OPENSCAP_SQL_POOL_H */
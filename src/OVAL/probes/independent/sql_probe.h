@@ -25,6 +25,10 @@
 
 #include "probe-api.h"
 
+void *sql_probe_init(void);
+
 int sql_probe_main(probe_ctx *ctx, void *arg);
 
+void sql_probe_fini(void *arg);
+
 #endif /* OPENSCAP_SQL_PROBE_H */
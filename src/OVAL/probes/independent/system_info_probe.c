@@ -84,6 +84,7 @@
 #include <limits.h>
 #include "system_info_probe.h"
 #include "oscap_helpers.h"
+#include "common/util.h"
 
 #define _REGEX_RES_VECSIZE     12
 #define MAX_BUFFER_SIZE        4096
@@ -112,25 +113,7 @@
 #endif
 
 #if defined(OS_LINUX)
-static char *get_mac(const struct ifaddrs *ifa, int fd)
-{
-       struct ifreq ifr;
-       unsigned char mac[6];
-       static char mac_buf[20];
-
-       memset(&ifr, 0, sizeof(struct ifreq));
-       strncpy(ifr.ifr_name, ifa->ifa_name, IFNAMSIZ);
-       ifr.ifr_name[IFNAMSIZ-1] = 0;
-       if (ioctl(fd, SIOCGIFHWADDR, &ifr) >= 0) {
-               memcpy(mac, ifr.ifr_hwaddr.sa_data, sizeof(mac));
-               snprintf(mac_buf, sizeof(mac_buf),
-                       "%02X:%02X:%02X:%02X:%02X:%02X",
-                       mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
-       } else
-               mac_buf[0] = 0;
-
-       return mac_buf;
-}
+#include "oval_net_cache.h"
 #elif defined(OS_SOLARIS)
 #include <sys/socket.h>
 #include <ifaddrs.h>
@@ -218,7 +201,43 @@ static char *get_mac(const struct ifaddrs *ifa, int fd)
 }
 #endif
 
-#if defined(OS_LINUX) || defined(OS_SOLARIS) || defined(OS_FREEBSD)
+#if defined(OS_LINUX)
+static int get_ifs(SEXP_t *item)
+{
+	oval_net_cache_t *net;
+	const struct oval_net_addr *addr;
+	char host[INET6_ADDRSTRLEN];
+	SEXP_t *attrs;
+	SEXP_t *r0, *r1, *r2;
+	size_t i;
+
+	net = oval_net_cache_acquire(OVAL_NET_CACHE_ADDRS);
+	if (net == NULL)
+		return 1;
+
+	for (i = 0; (addr = oval_net_cache_addr(net, i)) != NULL; ++i) {
+		inet_ntop(addr->family, &addr->addr, host, sizeof(host));
+		attrs = probe_attr_creat("name",
+					 r0 = SEXP_string_newf("%s", addr->name),
+					 "ip_address",
+					 r1 = SEXP_string_newf("%s", host),
+					 "mac_address",
+					 r2 = SEXP_string_newf("%02X:%02X:%02X:%02X:%02X:%02X",
+							       addr->hw_addr[0], addr->hw_addr[1], addr->hw_addr[2],
+							       addr->hw_addr[3], addr->hw_addr[4], addr->hw_addr[5]),
+					 NULL);
+		probe_item_ent_add(item, "interface", attrs, NULL);
+		SEXP_free(attrs);
+		SEXP_free(r0);
+		SEXP_free(r1);
+		SEXP_free(r2);
+	}
+	oval_net_cache_release(net);
+
+	return 0;
+}
+
+#elif defined(OS_SOLARIS) || defined(OS_FREEBSD)
 static int get_ifs(SEXP_t *item)
 {
        struct ifaddrs *ifaddr, *ifa;
@@ -542,7 +561,7 @@ static char *_get_os_release_elem(char *os_release_data, const char *elem_name)
 
 	const char *error;
 	int erroffset, ovec[_REGEX_RES_VECSIZE] = {0};
-	pcre *re = pcre_compile(elem_re, PCRE_MULTILINE, &error, &erroffset, NULL);
+	pcre *re = oscap_pcre_compile(elem_re, PCRE_MULTILINE, &error, &erroffset, NULL);
 	if (re == NULL)
 		goto finish;
 
@@ -554,7 +573,7 @@ static char *_get_os_release_elem(char *os_release_data, const char *elem_name)
 		ptr = strndup(os_release_data+ovec[2], ovec[3]-ovec[2]);
 		ret = ptr;
 	}
-	pcre_free(re);
+	oscap_pcre_free(re, NULL);
 
 finish:
 	return ret;
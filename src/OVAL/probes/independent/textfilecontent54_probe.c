@@ -51,20 +51,31 @@
 #include <probe/probe.h>
 #include <probe/option.h>
 #include <oval_fts.h>
+#include <oval_content_cache.h>
+#include <oval_deadline.h>
+#include <oval_throttle.h>
 #include "common/debug_priv.h"
 #include "common/util.h"
 #include "textfilecontent54_probe.h"
 
 #define FILE_SEPARATOR '/'
+#define OVECTOR_LEN 60
+/* default of OSCAP_TEXTFILE_STREAM_SIZE in MiB */
+#define STREAM_SIZE_DEFAULT 64
+/* initial window of the streamed files, grows for longer lines */
+#define STREAM_WINDOW_SIZE (1024 * 1024)
 
+/*
+ * The substrings are taken from the buffer by the offsets in the ovector
+ * returned by oscap_match_substrings(), unset subexpressions are skipped.
+ */
 static SEXP_t *create_item(const char *path, const char *filename, char *pattern,
-			   int instance, char **substrs, int substr_cnt, oval_schema_version_t over)
+			   int instance, const char *buf, const int *ovector, int substr_cnt, oval_schema_version_t over)
 {
 	int i;
 	SEXP_t *item;
 	SEXP_t *r0;
-	SEXP_t *se_instance, *se_filepath;
-	char *text;
+	SEXP_t *se_instance, *se_filepath, *se_text;
 
         if (strlen(path) + strlen(filename) + 1 > PATH_MAX) {
                 dE("path+filename too long");
@@ -72,12 +83,12 @@ static SEXP_t *create_item(const char *path, const char *filename, char *pattern
         }
 
 	if (oval_schema_version_cmp(over, OVAL_SCHEMA_VERSION(5.4)) < 0) {
-		pattern = text = NULL;
+		pattern = NULL;
 		se_instance = NULL;
 	} else {
-		text = substrs[0];
 		se_instance = SEXP_number_newu_64((int64_t) instance);
 	}
+	se_text = SEXP_string_new(buf + ovector[0], ovector[1] - ovector[0]);
 	if (oval_schema_version_cmp(over, OVAL_SCHEMA_VERSION(5.6)) < 0) {
 		se_filepath = NULL;
 	} else {
@@ -97,16 +108,19 @@ static SEXP_t *create_item(const char *path, const char *filename, char *pattern
                                  "pattern",  OVAL_DATATYPE_STRING, pattern,
                                  "instance", OVAL_DATATYPE_SEXP, se_instance,
                                  "line",     OVAL_DATATYPE_STRING, pattern,
-                                 "text",     OVAL_DATATYPE_STRING, substrs[0],
+                                 "text",     OVAL_DATATYPE_SEXP, se_text,
                                  NULL);
 
 	for (i = 1; i < substr_cnt; ++i) {
-                probe_item_ent_add (item, "subexpression", NULL, r0 = SEXP_string_new (substrs[i], strlen (substrs[i])));
+		if (ovector[2 * i] == -1)
+			continue;
+                probe_item_ent_add (item, "subexpression", NULL, r0 = SEXP_string_new (buf + ovector[2 * i], ovector[2 * i + 1] - ovector[2 * i]));
                 SEXP_free (r0);
 	}
 
 	SEXP_free(se_filepath);
 	SEXP_free(se_instance);
+	SEXP_free(se_text);
 	return item;
 }
 
@@ -116,16 +130,281 @@ struct pfdata {
 	SEXP_t *instance_ent;
         probe_ctx *ctx;
 	pcre *compiled_regex;
+	pcre_extra *regex_extra;
+	/* files of at least this size are matched in windows, if the pattern allows it */
+	off_t stream_size;
 };
 
+/*
+ * A pattern which can't match a newline character matches the same in
+ * a line as in the whole text, so such patterns can be matched in windows
+ * of whole lines. The check is conservative, anything which might match
+ * a newline (negated classes, \s, escapes of character codes, inline
+ * options, ...) rules the pattern out. Lookbehind can't see past the
+ * start of the line then either.
+ */
+static bool pattern_is_line_local(const char *pattern, int re_opts)
+{
+	const char *p;
+	bool in_class = false, prev_plain = false;
+
+	if (re_opts & PCRE_DOTALL)
+		return false;
+
+	for (p = pattern; *p != '\0'; ++p) {
+		unsigned char c = (unsigned char) *p;
+
+		if (c < 0x20 && c != '\t')
+			return false;
+		if (c == '\\') {
+			char n = p[1];
+
+			if (n == '\0' || strchr("sSnrvVRHhWDxXpPCcoAZzG0", n) != NULL)
+				return false;
+			/* \12 could be an octal code */
+			if (n >= '1' && n <= '9' && p[2] >= '0' && p[2] <= '9')
+				return false;
+			++p;
+			prev_plain = false;
+			continue;
+		}
+		if (in_class) {
+			if (c == ']') {
+				in_class = false;
+			} else if (c == '[' && p[1] == ':') {
+				const char *name_end = strstr(p + 2, ":]");
+
+				/* POSIX classes which include a newline */
+				if (name_end == NULL || p[2] == '^' || strncmp(p, "[:space:]", 9) == 0
+				    || strncmp(p, "[:cntrl:]", 9) == 0)
+					return false;
+				p = name_end + 1;
+				prev_plain = false;
+				continue;
+			} else if (c == '-' && !prev_plain && p[1] != ']') {
+				/* a range from a tab or an escape might span a newline */
+				return false;
+			}
+			prev_plain = c > 0x20;
+			continue;
+		}
+		if (c == '[') {
+			if (p[1] == '^')
+				return false;
+			in_class = true;
+			prev_plain = false;
+			/* a leading ']' is a literal */
+			if (p[1] == ']') {
+				++p;
+				prev_plain = true;
+			}
+			continue;
+		}
+		if (c == '(' && p[1] == '*')
+			return false;
+		if (c == '(' && p[1] == '?') {
+			const char *o = p + 2;
+
+			/* option settings like (?s) or (?m-i:...) */
+			while ((*o >= 'a' && *o <= 'z') || (*o >= 'A' && *o <= 'Z') || *o == '-') {
+				if (*o == 's' || *o == 'm' || *o == 'x')
+					return false;
+				++o;
+			}
+		}
+	}
+
+	return true;
+}
+
+static off_t stream_size_get(void)
+{
+	const char *env = getenv("OSCAP_TEXTFILE_STREAM_SIZE");
+	unsigned long mib = STREAM_SIZE_DEFAULT;
+
+	if (env != NULL) {
+		char *end;
+
+		errno = 0;
+		mib = strtoul(env, &end, 10);
+		if (errno != 0 || end == env || *end != '\0') {
+			dW("Invalid value of OSCAP_TEXTFILE_STREAM_SIZE: '%s', using %d.",
+			   env, STREAM_SIZE_DEFAULT);
+			mib = STREAM_SIZE_DEFAULT;
+		}
+	}
+
+	return (off_t) mib * 1024 * 1024;
+}
+
+/*
+ * Match the pattern in the text from *ofs on and collect the wanted
+ * instances. A text which isn't the end of the file is a window of whole
+ * lines, a match of the empty string at its end is left for the next
+ * window. Returns 0 or -3 if the pattern failed to match.
+ */
+static int match_text(struct pfdata *pfd, const char *path, const char *file, const char *whole_path,
+		      const char *text, size_t text_len, size_t end, int exec_opts, int *cur_inst, oval_schema_version_t over)
+{
+	int substr_cnt, ofs = 0;
+	int ovector[OVECTOR_LEN];
+	SEXP_t *next_inst = NULL;
+	bool last = !(exec_opts & PCRE_NOTEOL);
+
+	do {
+		int want_instance;
+
+		next_inst = SEXP_number_newi_32(*cur_inst + 1);
+
+		if (probe_entobj_cmp(pfd->instance_ent, next_inst) == OVAL_RESULT_TRUE)
+			want_instance = 1;
+		else
+			want_instance = 0;
+
+		SEXP_free(next_inst);
+		substr_cnt = oscap_match_substrings_opts(text, text_len, &ofs, pfd->compiled_regex, pfd->regex_extra,
+							 exec_opts, ovector, OVECTOR_LEN);
+
+		if (substr_cnt < 0) {
+			SEXP_t *msg;
+			msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR,
+				"Regular expression pattern match failed in file %s with error %d.",
+				whole_path, substr_cnt);
+			probe_cobj_add_msg(probe_ctx_getresult(pfd->ctx), msg);
+			SEXP_free(msg);
+			probe_cobj_set_flag(probe_ctx_getresult(pfd->ctx), SYSCHAR_FLAG_ERROR);
+			return -3;
+		}
+
+		if (substr_cnt > 0 && !last && (size_t) ovector[0] >= text_len)
+			break;
+
+		if (substr_cnt > 0) {
+			++(*cur_inst);
+
+			if (want_instance) {
+				SEXP_t *item;
+
+				item = create_item(path, file, pfd->pattern,
+						*cur_inst, text, ovector, substr_cnt, over);
+
+                                probe_item_collect(pfd->ctx, item);
+			}
+		}
+	} while (substr_cnt > 0 && (size_t) ofs < end && !oval_deadline_expired());
+
+	return 0;
+}
+
+/*
+ * Read the file in windows of whole lines and match each of them in turn,
+ * the memory used doesn't depend on the size of the file, only on its
+ * longest line. The pattern has to pass pattern_is_line_local(). ^ and $
+ * of a pattern without the multiline behavior match at the start and end
+ * of the file only, the windows in between are matched with PCRE_NOTBOL
+ * and PCRE_NOTEOL. The text ends at the first NUL character.
+ */
+static int process_file_windowed(struct pfdata *pfd, const char *path, const char *file, const char *whole_path,
+				 const char *whole_path_with_prefix, oval_schema_version_t over)
+{
+	int fd, ret = 0, cur_inst = 0;
+	size_t buf_size = STREAM_WINDOW_SIZE, buf_used = 0;
+	bool at_start = true, at_eof = false;
+	char *buf = NULL;
+	const char *op = "open";
+
+	fd = open(whole_path_with_prefix, O_RDONLY);
+	if (fd == -1)
+		goto error;
+	op = "read";
+	buf = malloc(buf_size);
+	if (buf == NULL)
+		goto error;
+
+	while (!at_eof && !oval_deadline_expired()) {
+		size_t text_len, end, window_len;
+		const char *nul, *nl;
+		int exec_opts = 0;
+		ssize_t nread;
+
+		if (buf_used == buf_size) {
+			char *new_buf = realloc(buf, buf_size * 2);
+
+			if (new_buf == NULL)
+				goto error;
+			buf = new_buf;
+			buf_size *= 2;
+		}
+		nread = read(fd, buf + buf_used, oval_throttle_io_size(buf_size - buf_used));
+		if (nread == -1) {
+			if (errno == EINTR)
+				continue;
+			goto error;
+		}
+		oval_throttle_io(nread);
+		buf_used += nread;
+
+		if (nread == 0) {
+			at_eof = true;
+			window_len = text_len = buf_used;
+		} else {
+			/* memrchr() isn't available everywhere */
+			for (nl = buf + buf_used - 1; nl >= buf && *nl != '\n'; --nl)
+				;
+			if (nl < buf)
+				continue;
+			window_len = text_len = nl - buf + 1;
+		}
+
+		nul = memchr(buf, '\0', text_len);
+		if (nul != NULL) {
+			text_len = nul - buf;
+			at_eof = true;
+		}
+
+		if (!at_start && !(pfd->re_opts & PCRE_MULTILINE))
+			exec_opts |= PCRE_NOTBOL;
+		if (!at_eof)
+			exec_opts |= PCRE_NOTEOL;
+		/* the empty string at the end of the text is matched too */
+		end = at_eof ? text_len + 1 : text_len;
+
+		ret = match_text(pfd, path, file, whole_path, buf, text_len, end, exec_opts, &cur_inst, over);
+		if (ret != 0)
+			break;
+
+		memmove(buf, buf + window_len, buf_used - window_len);
+		buf_used -= window_len;
+		at_start = false;
+	}
+
+	free(buf);
+	close(fd);
+	return ret;
+
+ error:
+	{
+		SEXP_t *msg;
+
+		msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR, "%s(): '%s' %s.",
+			op, whole_path, strerror(errno));
+		probe_cobj_add_msg(probe_ctx_getresult(pfd->ctx), msg);
+		SEXP_free(msg);
+		probe_cobj_set_flag(probe_ctx_getresult(pfd->ctx), SYSCHAR_FLAG_ERROR);
+	}
+	free(buf);
+	if (fd != -1)
+		close(fd);
+	return -1;
+}
+
 static int process_file(const char *prefix, const char *path, const char *file, void *arg, oval_schema_version_t over)
 {
 	struct pfdata *pfd = (struct pfdata *) arg;
-	int ret = 0, path_len, file_len, cur_inst = 0, fd = -1, substr_cnt,
-		buf_size = 0, buf_used = 0, ofs = 0, buf_inc = 4096;
-	char **substrs = NULL;
-	char *whole_path = NULL, *whole_path_with_prefix = NULL, *buf = NULL;
-	SEXP_t *next_inst = NULL;
+	int ret = 0, path_len, file_len, cur_inst = 0;
+	size_t text_len;
+	char *whole_path = NULL, *whole_path_with_prefix = NULL;
+	oval_content_t *content = NULL;
 	struct stat st;
 
 	if (file == NULL)
@@ -154,113 +433,44 @@ static int process_file(const char *prefix, const char *path, const char *file,
 	 * be determined with stat().
 	 */
 	whole_path_with_prefix = oscap_path_join(prefix, whole_path);
-	if (stat(whole_path_with_prefix, &st) == -1)
+	if (oval_fts_cache_stat(whole_path_with_prefix, &st) == -1)
 		goto cleanup;
 	if (!S_ISREG(st.st_mode))
 		goto cleanup;
 
-	fd = open(whole_path_with_prefix, O_RDONLY);
-	if (fd == -1) {
+	if (pfd->stream_size >= 0 && st.st_size >= pfd->stream_size) {
+		ret = process_file_windowed(pfd, path, file, whole_path, whole_path_with_prefix, over);
+		goto cleanup;
+	}
+
+	ret = oval_content_cache_get(whole_path_with_prefix, &st, &content);
+	if (ret != 0) {
 		SEXP_t *msg;
 
-		msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR, "open(): '%s' %s.", whole_path, strerror(errno));
+		msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR, "%s(): '%s' %s.",
+			ret == -1 ? "open" : "read", whole_path, strerror(errno));
 		probe_cobj_add_msg(probe_ctx_getresult(pfd->ctx), msg);
 		SEXP_free(msg);
 		probe_cobj_set_flag(probe_ctx_getresult(pfd->ctx), SYSCHAR_FLAG_ERROR);
-		ret = -1;
 		goto cleanup;
 	}
 
-	do {
-		buf_size += buf_inc;
-		void *new_buf = realloc(buf, buf_size);
-		if (new_buf == NULL) {
-			dE("Can't re-allocate memory for file-processing buffer");
-			ret = PROBE_ENOMEM;
-			goto cleanup;
-		}
-		buf = new_buf;
-		ret = read(fd, buf + buf_used, buf_inc);
-		if (ret == -1) {
-			SEXP_t *msg;
-
-			msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR, "read(): '%s' %s.", whole_path, strerror(errno));
-			probe_cobj_add_msg(probe_ctx_getresult(pfd->ctx), msg);
-			SEXP_free(msg);
-			probe_cobj_set_flag(probe_ctx_getresult(pfd->ctx), SYSCHAR_FLAG_ERROR);
-			ret = -2;
-			goto cleanup;
-		}
-		buf_used += ret;
-	} while (ret == buf_inc);
-
-	if (buf_used == buf_size) {
-		void *new_buf = realloc(buf, ++buf_size);
-		if (new_buf == NULL) {
-			dE("Can't re-allocate memory");
-			ret = PROBE_ENOMEM;
-			goto cleanup;
-		}
-		buf = new_buf;
-	}
-	buf[buf_used++] = '\0';
-
-	do {
-		int want_instance;
-
-		next_inst = SEXP_number_newi_32(cur_inst + 1);
-
-		if (probe_entobj_cmp(pfd->instance_ent, next_inst) == OVAL_RESULT_TRUE)
-			want_instance = 1;
-		else
-			want_instance = 0;
-
-		SEXP_free(next_inst);
-		substr_cnt = oscap_get_substrings(buf, &ofs, pfd->compiled_regex, want_instance, &substrs);
-
-		if (substr_cnt < 0) {
-			SEXP_t *msg;
-			msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR,
-				"Regular expression pattern match failed in file %s with error %d.",
-				whole_path, substr_cnt);
-			probe_cobj_add_msg(probe_ctx_getresult(pfd->ctx), msg);
-			SEXP_free(msg);
-			probe_cobj_set_flag(probe_ctx_getresult(pfd->ctx), SYSCHAR_FLAG_ERROR);
-			ret = -3;
-			goto cleanup;
-		}
-
-		if (substr_cnt > 0) {
-			++cur_inst;
-
-			if (want_instance) {
-				int k;
-				SEXP_t *item;
-
-				item = create_item(path, file, pfd->pattern,
-						cur_inst, substrs, substr_cnt, over);
-
-                                probe_item_collect(pfd->ctx, item);
-
-				for (k = 0; k < substr_cnt; ++k)
-					free(substrs[k]);
-				free(substrs);
-			}
-		}
-	} while (substr_cnt > 0 && ofs < buf_used);
+	/* the text ends at the first NUL character as it always has */
+	text_len = strlen(content->data);
+	ret = match_text(pfd, path, file, whole_path, content->data, text_len, content->size + 1, 0, &cur_inst, over);
 
  cleanup:
-	if (fd != -1)
-		close(fd);
-	free(buf);
+	if (content != NULL)
+		oval_content_cache_release(content);
 	if (whole_path != NULL)
 		free(whole_path);
 	free(whole_path_with_prefix);
 
-	/* coverity[leaked_storage] - substrs is not leaked */
 	return ret;
 }
 
+const char *const textfilecontent54_probe_multival_entities[] = { "path", "filename", "filepath", NULL };
+
 int textfilecontent54_probe_offline_mode_supported()
 {
 	return PROBE_OFFLINE_OWN;
@@ -269,7 +479,8 @@ int textfilecontent54_probe_offline_mode_supported()
 int textfilecontent54_probe_main(probe_ctx *ctx, void *arg)
 {
 	SEXP_t *path_ent, *file_ent, *inst_ent, *bh_ent, *patt_ent, *filepath_ent, *probe_in;
-        SEXP_t *r0;
+        SEXP_t *r0, *val_ent, *sel;
+	int i, val_cnt;
 	bool val;
 	struct pfdata pfd;
 	int ret = 0;
@@ -339,8 +550,8 @@ int textfilecontent54_probe_main(probe_ctx *ctx, void *arg)
 			pfd.re_opts |= PCRE_DOTALL;
 	}
 
-	pfd.compiled_regex = pcre_compile(pfd.pattern, pfd.re_opts, &error,
-					  &errorffset, NULL);
+	pfd.compiled_regex = oscap_pcre_compile(pfd.pattern, pfd.re_opts, &error,
+					  &errorffset, &pfd.regex_extra);
 	if (pfd.compiled_regex == NULL) {
 		SEXP_t *msg;
 
@@ -350,10 +561,26 @@ int textfilecontent54_probe_main(probe_ctx *ctx, void *arg)
 		probe_cobj_set_flag(probe_ctx_getresult(pfd.ctx), SYSCHAR_FLAG_ERROR);
 		goto cleanup;
 	}
+	pfd.stream_size = pattern_is_line_local(pfd.pattern, pfd.re_opts) ? stream_size_get() : -1;
 
 	const char *prefix = getenv("OSCAP_PROBE_ROOT");
 
-	if ((ofts = oval_fts_open_prefixed(prefix, path_ent, file_ent, filepath_ent, bh_ent, probe_ctx_getresult(ctx))) != NULL) {
+	/* the filename is matched against all of its values, the walk is done for each path */
+	val_ent = (filepath_ent != NULL) ? filepath_ent : path_ent;
+	val_cnt = probe_ent_getvals(val_ent, NULL);
+
+	for (i = 0; i == 0 || i < val_cnt; ++i) {
+		sel = probe_ent_select_val(val_ent, i);
+
+		if (filepath_ent != NULL)
+			ofts = oval_fts_open_prefixed(prefix, path_ent, file_ent, sel, bh_ent, probe_ctx_getresult(ctx));
+		else
+			ofts = oval_fts_open_prefixed(prefix, sel, file_ent, filepath_ent, bh_ent, probe_ctx_getresult(ctx));
+		SEXP_free(sel);
+
+		if (ofts == NULL)
+			continue;
+
 		while ((ofts_ent = oval_fts_read(ofts)) != NULL) {
 			if (ofts_ent->fts_info == FTS_F
 			    || ofts_ent->fts_info == FTS_SL) {
@@ -374,7 +601,6 @@ int textfilecontent54_probe_main(probe_ctx *ctx, void *arg)
         SEXP_free(filepath_ent);
 	if (pfd.pattern != NULL)
 		free(pfd.pattern);
-	if (pfd.compiled_regex != NULL)
-		pcre_free(pfd.compiled_regex);
+	oscap_pcre_free(pfd.compiled_regex, pfd.regex_extra);
 	return ret;
 }
@@ -27,5 +27,6 @@
 
 int textfilecontent54_probe_offline_mode_supported(void);
 int textfilecontent54_probe_main(probe_ctx *ctx, void *arg);
+extern const char *const textfilecontent54_probe_multival_entities[];
 
 #endif /* OPENSCAP_TEXTFILECONTENT54_PROBE_H */
@@ -70,6 +70,8 @@
 #include <probe/probe.h>
 #include <probe/option.h>
 #include <oval_fts.h>
+#include <oval_content_cache.h>
+#include <oval_deadline.h>
 #include "common/debug_priv.h"
 #include "common/util.h"
 #include "textfilecontent_probe.h"
@@ -132,6 +134,8 @@ static SEXP_t *create_item(const char *path, const char *filename, char *pattern
 
 struct pfdata {
 	char *pattern;
+	pcre *re;
+	pcre_extra *re_extra;
 	SEXP_t *filename_ent;
         probe_ctx *ctx;
 };
@@ -141,21 +145,11 @@ static int process_file(const char *prefix, const char *path, const char *filena
 	struct pfdata *pfd = (struct pfdata *) arg;
 	int ret = 0, path_len, filename_len;
 	char *whole_path = NULL, *whole_path_with_prefix = NULL;
-	FILE *fp = NULL;
+	oval_content_t *content = NULL;
 	struct stat st;
 	char **substrs = NULL;
 	int substr_cnt = 0;
 
-// todo: move to probe_main()?
-	int erroffset = -1;
-	pcre *re = NULL;
-	const char *error;
-
-	re = pcre_compile(pfd->pattern, PCRE_UTF8, &error, &erroffset, NULL);
-	if (re == NULL) {
-		return -1;
-	}
-
 	if (filename == NULL)
 		goto cleanup;
 
@@ -179,13 +173,12 @@ static int process_file(const char *prefix, const char *path, const char *filena
 	 * be determined with stat().
 	 */
 	whole_path_with_prefix = oscap_path_join(prefix, whole_path);
-	if (stat(whole_path_with_prefix, &st) == -1)
+	if (oval_fts_cache_stat(whole_path_with_prefix, &st) == -1)
 		goto cleanup;
 	if (!S_ISREG(st.st_mode))
 		goto cleanup;
 
-	fp = fopen(whole_path_with_prefix, "rb");
-	if (fp == NULL) {
+	if (oval_content_cache_get(whole_path_with_prefix, &st, &content) != 0) {
 		ret = -2;
 		goto cleanup;
 	}
@@ -193,9 +186,23 @@ static int process_file(const char *prefix, const char *path, const char *filena
 	int cur_inst = 0;
 	char line[4096];
 	int ofs = 0;
-
-	while (fgets(line, sizeof(line), fp) != NULL) {
-		substr_cnt = oscap_get_substrings(line, &ofs, re, 1, &substrs);
+	const char *pos = content->data, *end = content->data + content->size;
+
+	while (pos < end && !oval_deadline_expired()) {
+		/* split the content into the lines fgets(3) would have read */
+		size_t line_len = (size_t) (end - pos);
+		const char *nl;
+
+		if (line_len > sizeof(line) - 1)
+			line_len = sizeof(line) - 1;
+		nl = memchr(pos, '\n', line_len);
+		if (nl != NULL)
+			line_len = nl - pos + 1;
+		memcpy(line, pos, line_len);
+		line[line_len] = '\0';
+		pos += line_len;
+
+		substr_cnt = oscap_get_substrings(line, &ofs, pfd->re, pfd->re_extra, 1, &substrs);
 		if (substr_cnt > 0) {
 			int k;
 			SEXP_t *item;
@@ -213,12 +220,10 @@ static int process_file(const char *prefix, const char *path, const char *filena
 	}
 
  cleanup:
-	if (fp != NULL)
-		fclose(fp);
+	if (content != NULL)
+		oval_content_cache_release(content);
 	if (whole_path != NULL)
 		free(whole_path);
-	if (re != NULL)
-		pcre_free(re);
 	free(whole_path_with_prefix);
 
 	return ret;
@@ -281,10 +286,18 @@ int textfilecontent_probe_main(probe_ctx *ctx, void *arg)
 	probe_filebehaviors_canonicalize(&behaviors_ent);
 
 	struct pfdata pfd;
+	int erroffset = -1;
+	const char *error;
 
 	pfd.pattern = pattern;
 	pfd.filename_ent = filename_ent;
 	pfd.ctx = ctx;
+	/* the pattern is matched against every line of every file */
+	pfd.re = oscap_pcre_compile(pattern, PCRE_UTF8, &error, &erroffset, &pfd.re_extra);
+	if (pfd.re == NULL) {
+		dE("pcre_compile() '%s' failed at offset %d: %s.", pattern, erroffset, error);
+		goto cleanup;
+	}
 
 	const char *prefix = getenv("OSCAP_PROBE_ROOT");
 
@@ -301,6 +314,8 @@ int textfilecontent_probe_main(probe_ctx *ctx, void *arg)
 		oval_fts_close(ofts);
 	}
 
+	oscap_pcre_free(pfd.re, pfd.re_extra);
+cleanup:
 	SEXP_free(path_ent);
 	SEXP_free(filename_ent);
 	SEXP_free(behaviors_ent);
@@ -53,9 +53,12 @@
 #include <config.h>
 #endif
 
+#include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
 #include <limits.h>
+#include <pthread.h>
+#include <sys/stat.h>
 
 #include <libxml/tree.h>
 #include <libxml/parser.h>
@@ -71,15 +74,46 @@
 #include <probe/probe.h>
 #include <probe/option.h>
 #include <oval_fts.h>
+#include <oval_content_cache.h>
 #include <common/debug_priv.h>
 #include "xmlfilecontent_probe.h"
 
 #define FILE_SEPARATOR '/'
+/* parsed documents kept for the next objects looking into the same files */
+#define XMLFILECONTENT_DOC_CACHE_MAX 16
+
+#if defined(OS_FREEBSD) || defined(OS_APPLE)
+#define XMLFILECONTENT_MTIME_NSEC(st) ((st)->st_mtimespec.tv_nsec)
+#elif defined(OS_LINUX) || defined(OS_SOLARIS)
+#define XMLFILECONTENT_MTIME_NSEC(st) ((st)->st_mtim.tv_nsec)
+#else
+#define XMLFILECONTENT_MTIME_NSEC(st) 0L
+#endif
+
+/* a parsed file with the namespaces removed */
+struct xml_doc_entry {
+	struct stat st;
+	xmlDocPtr doc;
+	unsigned int refs;
+	bool cached;
+	unsigned long used;     /* when it was used the last time */
+	pthread_mutex_t lock;   /* XPath evaluations of the document */
+};
+
+struct xmlfilecontent_global {
+	xsltStylesheetPtr strip_ns; /* NULL if the template can't be parsed */
+	pthread_mutex_t lock;
+	struct xml_doc_entry *docs[XMLFILECONTENT_DOC_CACHE_MAX];
+	size_t doc_count;
+	unsigned long clock;
+};
 
 struct pfdata {
 	SEXP_t *filename_ent;
 	char *xpath;
+	xmlXPathCompExprPtr xpath_comp; /* NULL if the expression is invalid */
         probe_ctx *ctx;
+        struct xmlfilecontent_global *g;
 };
 
 static void dummy_err_func(void * ctx, const char * msg, ...)
@@ -91,24 +125,12 @@ int xmlfilecontent_probe_offline_mode_supported()
 	return PROBE_OFFLINE_OWN;
 }
 
-void *xmlfilecontent_probe_init(void)
-{
-	/* init libxml */
-	//LIBXML_TEST_VERSION;
-	xmlInitParser();
-	xmlSetGenericErrorFunc(NULL, dummy_err_func);
-
-	return NULL;
-}
-
-void xmlfilecontent_probe_fini(void *arg)
-{
-        (void)arg;
-	/* deinit libxml */
-	xmlCleanupParser();
-}
-
-static xmlDocPtr strip_ns(xmlDocPtr doc)
+/* Remove the namespace from the examined document. The XPath expressions
+ * will be evaluated as if the namespace is ignored. Even though the
+ * xmlfilecontent should use standardized XPath, existing content expects
+ * this behavior.
+ */
+static xsltStylesheetPtr strip_ns_stylesheet(void)
 {
 	const char template[] = 
 	"<xsl:stylesheet version=\"1.0\" xmlns:xsl=\"http://www.w3.org/1999/XSL/Transform\">"
@@ -134,12 +156,182 @@ static xmlDocPtr strip_ns(xmlDocPtr doc)
 		xmlFreeDoc(stylesheet_doc);
 		return NULL;
 	}
-	xmlDocPtr result = xsltApplyStylesheet(stylesheet, doc, NULL);
-	if (result == NULL) {
-		fprintf(stderr, "Can't apply XSLT on the document\n");
+	return stylesheet;
+}
+
+void *xmlfilecontent_probe_init(void)
+{
+	struct xmlfilecontent_global *g;
+
+	/* init libxml */
+	//LIBXML_TEST_VERSION;
+	xmlInitParser();
+	xmlSetGenericErrorFunc(NULL, dummy_err_func);
+
+	g = calloc(1, sizeof(struct xmlfilecontent_global));
+	if (g == NULL)
+		return NULL;
+	pthread_mutex_init(&g->lock, NULL);
+	/* built once, applying a stylesheet doesn't modify it */
+	g->strip_ns = strip_ns_stylesheet();
+
+	return g;
+}
+
+static void xml_doc_entry_free(struct xml_doc_entry *entry)
+{
+	xmlFreeDoc(entry->doc);
+	pthread_mutex_destroy(&entry->lock);
+	free(entry);
+}
+
+void xmlfilecontent_probe_fini(void *arg)
+{
+	struct xmlfilecontent_global *g = arg;
+	size_t i;
+
+	if (g != NULL) {
+		for (i = 0; i < g->doc_count; ++i)
+			xml_doc_entry_free(g->docs[i]);
+		if (g->strip_ns != NULL)
+			xsltFreeStylesheet(g->strip_ns);
+		pthread_mutex_destroy(&g->lock);
+		free(g);
 	}
-	xsltFreeStylesheet(stylesheet);
-	return result;
+	/* deinit libxml */
+	xmlCleanupParser();
+}
+
+static xmlDocPtr parse_file(const char *path)
+{
+	oval_content_t *content;
+	struct stat st;
+	xmlDocPtr doc;
+
+	/* let libxml read the file itself if the cache can't provide it */
+	if (oval_fts_cache_stat(path, &st) != 0 || !S_ISREG(st.st_mode)
+	    || oval_content_cache_get(path, &st, &content) != 0)
+		return xmlParseFile(path);
+
+	doc = xmlReadMemory(content->data, content->size, path, NULL, 0);
+	oval_content_cache_release(content);
+
+	return doc;
+}
+
+static bool same_file(const struct stat *a, const struct stat *b)
+{
+	return a->st_dev == b->st_dev && a->st_ino == b->st_ino
+	    && a->st_size == b->st_size
+	    && a->st_mtime == b->st_mtime
+	    && XMLFILECONTENT_MTIME_NSEC(a) == XMLFILECONTENT_MTIME_NSEC(b);
+}
+
+/* must be called with g->lock held */
+static struct xml_doc_entry *doc_cache_find(struct xmlfilecontent_global *g, const struct stat *st)
+{
+	size_t i;
+
+	for (i = 0; i < g->doc_count; ++i) {
+		if (same_file(&g->docs[i]->st, st)) {
+			g->docs[i]->refs++;
+			g->docs[i]->used = ++g->clock;
+			return g->docs[i];
+		}
+	}
+	return NULL;
+}
+
+/* must be called with g->lock held */
+static void doc_cache_insert(struct xmlfilecontent_global *g, struct xml_doc_entry *entry)
+{
+	size_t i, lru = 0;
+
+	if (g->doc_count == XMLFILECONTENT_DOC_CACHE_MAX) {
+		for (i = 1; i < g->doc_count; ++i) {
+			if (g->docs[i]->used < g->docs[lru]->used)
+				lru = i;
+		}
+		/* a document still in use is freed on release */
+		g->docs[lru]->cached = false;
+		if (g->docs[lru]->refs == 0)
+			xml_doc_entry_free(g->docs[lru]);
+		g->docs[lru] = g->docs[--g->doc_count];
+	}
+	entry->cached = true;
+	entry->used = ++g->clock;
+	g->docs[g->doc_count++] = entry;
+}
+
+/*
+ * Get the document without namespaces, parsing the file only if no
+ * earlier object parsed the same version of it.
+ * @return the document, NULL with *err set to -1 if the file can't be
+ * parsed or -2 if the namespaces can't be removed
+ */
+static struct xml_doc_entry *get_doc(struct xmlfilecontent_global *g, const char *path, int *err)
+{
+	struct xml_doc_entry *entry, *found;
+	struct stat st;
+	bool cacheable;
+	xmlDocPtr doc;
+
+	cacheable = oval_fts_cache_stat(path, &st) == 0 && S_ISREG(st.st_mode);
+	if (cacheable) {
+		pthread_mutex_lock(&g->lock);
+		entry = doc_cache_find(g, &st);
+		pthread_mutex_unlock(&g->lock);
+		if (entry != NULL)
+			return entry;
+	}
+
+	doc = parse_file(path);
+	if (doc == NULL) {
+		*err = -1;
+		return NULL;
+	}
+
+	entry = calloc(1, sizeof(struct xml_doc_entry));
+	if (entry == NULL || g->strip_ns == NULL ||
+	    (entry->doc = xsltApplyStylesheet(g->strip_ns, doc, NULL)) == NULL) {
+		if (g->strip_ns != NULL)
+			fprintf(stderr, "Can't apply XSLT on the document\n");
+		xmlFreeDoc(doc);
+		free(entry);
+		*err = -2;
+		return NULL;
+	}
+	xmlFreeDoc(doc);
+	pthread_mutex_init(&entry->lock, NULL);
+	entry->st = st;
+	entry->refs = 1;
+
+	if (cacheable) {
+		pthread_mutex_lock(&g->lock);
+		found = doc_cache_find(g, &st);
+		if (found == NULL)
+			doc_cache_insert(g, entry);
+		pthread_mutex_unlock(&g->lock);
+		if (found != NULL) {
+			/* parsed by another thread meanwhile */
+			xml_doc_entry_free(entry);
+			entry = found;
+		}
+	}
+
+	return entry;
+}
+
+static void release_doc(struct xmlfilecontent_global *g, struct xml_doc_entry *entry)
+{
+	bool unused;
+
+	pthread_mutex_lock(&g->lock);
+	unused = --entry->refs == 0 && !entry->cached;
+	pthread_mutex_unlock(&g->lock);
+
+	if (unused)
+		xml_doc_entry_free(entry);
 }
 
 static int process_file(const char *prefix, const char *path, const char *filename, void *arg)
@@ -147,8 +339,8 @@ static int process_file(const char *prefix, const char *path, const char *filena
 	struct pfdata *pfd = (struct pfdata *) arg;
 	int ret = 0, path_len, filename_len;
 	char *whole_path = NULL;
-	xmlDoc *doc = NULL;
-	xmlDoc *doc_no_ns = NULL;
+	struct xml_doc_entry *doc = NULL;
+	int doc_err = 0;
 	xmlXPathContext *xpath_ctx = NULL;
 	xmlXPathObject *xpath_obj = NULL;
 	SEXP_t *item = NULL;
@@ -172,14 +364,14 @@ static int process_file(const char *prefix, const char *path, const char *filena
 	memcpy(whole_path + path_len, filename, filename_len + 1);
 
 	if (prefix == NULL) {
-		doc = xmlParseFile(whole_path);
+		doc = get_doc(pfd->g, whole_path, &doc_err);
 	} else {
 		char *path_with_prefix = oscap_path_join(prefix, whole_path);
-		doc = xmlParseFile(path_with_prefix);
+		doc = get_doc(pfd->g, path_with_prefix, &doc_err);
 		free(path_with_prefix);
 	}
 
-	if (doc == NULL) {
+	if (doc == NULL && doc_err == -1) {
                 SEXP_t *msg;
                 msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR, "Can't parse '%s'.", whole_path);
                 probe_cobj_add_msg(probe_ctx_getresult(pfd->ctx), msg);
@@ -190,13 +382,8 @@ static int process_file(const char *prefix, const char *path, const char *filena
 		goto cleanup;
 	}
 
-	/* Remove the namespace from the examined document. The XPath expressions
-	 * will be evaluated as if the namespace is ignored. Even though the
-	 * xmlfilecontent should use standardized XPath, existing content expects
-	 * this behavior.
-	 */
-	doc_no_ns = strip_ns(doc);
-	if (doc_no_ns == NULL) {
+	/* the namespaces are removed when the document is parsed */
+	if (doc == NULL) {
 		SEXP_t *msg;
 		msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR,
 			"Can't remove namespaces from '%s'.", whole_path);
@@ -207,8 +394,9 @@ static int process_file(const char *prefix, const char *path, const char *filena
 		goto cleanup;
 	}
 
-	/* evaluate xpath */
-	xpath_ctx = xmlXPathNewContext(doc_no_ns);
+	/* evaluate xpath, the documents may be shared by several threads */
+	pthread_mutex_lock(&doc->lock);
+	xpath_ctx = xmlXPathNewContext(doc->doc);
 	if (xpath_ctx == NULL) {
                 SEXP_t *msg;
                 msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR, "xmlXPathNewContext() error.");
@@ -220,7 +408,7 @@ static int process_file(const char *prefix, const char *path, const char *filena
 		goto cleanup;
 	}
 
-	xpath_obj = xmlXPathEvalExpression(BAD_CAST pfd->xpath, xpath_ctx);
+	xpath_obj = pfd->xpath_comp != NULL ? xmlXPathCompiledEval(pfd->xpath_comp, xpath_ctx) : NULL;
 	if (xpath_obj == NULL) {
                 SEXP_t *msg;
                 msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR, "xmlXPathEvalExpression() error");
@@ -333,10 +521,10 @@ static int process_file(const char *prefix, const char *path, const char *filena
 		xmlXPathFreeObject(xpath_obj);
 	if (xpath_ctx != NULL)
 		xmlXPathFreeContext(xpath_ctx);
-	if (doc != NULL)
-		xmlFreeDoc(doc);
-	if (doc_no_ns != NULL)
-		xmlFreeDoc(doc_no_ns);
+	if (doc != NULL) {
+		pthread_mutex_unlock(&doc->lock);
+		release_doc(pfd->g, doc);
+	}
 	if (whole_path != NULL)
 		free(whole_path);
 
@@ -351,7 +539,8 @@ int xmlfilecontent_probe_main(probe_ctx *ctx, void *arg)
 	OVAL_FTS    *ofts;
 	OVAL_FTSENT *ofts_ent;
 
-        (void)arg;
+        if (arg == NULL)
+                return PROBE_EINIT;
 
         probe_in = probe_ctx_getobject(ctx);
 
@@ -386,8 +575,11 @@ int xmlfilecontent_probe_main(probe_ctx *ctx, void *arg)
 	pfd.xpath = SEXP_string_cstr(r0 = probe_ent_getval(xpath_ent));
         SEXP_free (r0);
 
+	/* compiled once for all the files of the object */
+	pfd.xpath_comp = pfd.xpath != NULL ? xmlXPathCompile(BAD_CAST pfd.xpath) : NULL;
 	pfd.filename_ent = filename_ent;
         pfd.ctx = ctx;
+        pfd.g = arg;
 
 	const char *prefix = getenv("OSCAP_PROBE_ROOT");
 
@@ -400,6 +592,8 @@ int xmlfilecontent_probe_main(probe_ctx *ctx, void *arg)
 		oval_fts_close(ofts);
 	}
 
+        if (pfd.xpath_comp != NULL)
+                xmlXPathFreeCompExpr(pfd.xpath_comp);
         free(pfd.xpath);
         SEXP_free (path_ent);
         SEXP_free (filename_ent);
@@ -26,6 +26,8 @@
 
 #include <math.h>
 #include <errno.h>
+#include <sys/stat.h>
+#include <pthread.h>
 #include <pcre.h>
 #include <yaml.h>
 #include <yaml-path.h>
@@ -34,8 +36,10 @@
 #include "sexp-manip.h"
 #include "debug_priv.h"
 #include "oval_fts.h"
+#include "oval_content_cache.h"
 #include "list.h"
 #include "probe/probe.h"
+#include "common/util.h"
 
 #define OSCAP_YAML_STRING_TAG "tag:yaml.org,2002:str"
 #define OSCAP_YAML_BOOL_TAG "tag:yaml.org,2002:bool"
@@ -44,25 +48,141 @@
 #define OSCAP_YAML_NULL_TAG "tag:yaml.org,2002:null"
 
 #define OVECCOUNT 30 /* should be a multiple of 3 */
+/* parsed files kept for the next objects looking into the same files */
+#define YAML_DOC_CACHE_MAX 16
+
+#if defined(OS_FREEBSD) || defined(OS_APPLE)
+#define YAML_MTIME_NSEC(st) ((st)->st_mtimespec.tv_nsec)
+#elif defined(OS_LINUX) || defined(OS_SOLARIS)
+#define YAML_MTIME_NSEC(st) ((st)->st_mtim.tv_nsec)
+#else
+#define YAML_MTIME_NSEC(st) 0L
+#endif
+
+/* events of a parsed YAML stream, replayed for every yamlpath */
+struct yaml_events {
+	yaml_event_t *events;
+	size_t count;
+	char *problem; /* parser error after the last event, NULL if none */
+};
+
+struct yaml_doc_entry {
+	struct stat st;
+	struct yaml_events events; /* not modified once parsed */
+	unsigned int refs;
+	bool cached;
+	unsigned long used;     /* when it was used the last time */
+};
+
+struct yamlfilecontent_global {
+	pthread_mutex_t lock;
+	struct yaml_doc_entry *docs[YAML_DOC_CACHE_MAX];
+	size_t doc_count;
+	unsigned long clock;
+};
+
+/* yamlpath of an object, parsed once and used for all the files */
+struct yaml_query {
+	const char *str;
+	yaml_path_t *path;
+	bool invalid;
+	yaml_parser_t parser; /* only passed to the filter */
+};
 
 int yamlfilecontent_probe_offline_mode_supported()
 {
 	return PROBE_OFFLINE_OWN;
 }
 
-static bool match_regex(const char *pattern, const char *value)
+void *yamlfilecontent_probe_init(void)
+{
+	struct yamlfilecontent_global *g;
+
+	g = calloc(1, sizeof(struct yamlfilecontent_global));
+	if (g == NULL)
+		return NULL;
+	pthread_mutex_init(&g->lock, NULL);
+
+	return g;
+}
+
+static void yaml_events_free(struct yaml_events *ev)
+{
+	size_t i;
+
+	for (i = 0; i < ev->count; ++i)
+		yaml_event_delete(&ev->events[i]);
+	free(ev->events);
+	free(ev->problem);
+}
+
+static void yaml_doc_entry_free(struct yaml_doc_entry *entry)
+{
+	yaml_events_free(&entry->events);
+	free(entry);
+}
+
+void yamlfilecontent_probe_fini(void *arg)
+{
+	struct yamlfilecontent_global *g = arg;
+	size_t i;
+
+	if (g == NULL)
+		return;
+	for (i = 0; i < g->doc_count; ++i)
+		yaml_doc_entry_free(g->docs[i]);
+	pthread_mutex_destroy(&g->lock);
+	free(g);
+}
+
+/* The patterns below are fixed and matched against every scalar, they are
+ * compiled once and kept for the lifetime of the process. */
+#define REGEX_CACHE_SIZE 16
+
+static struct {
+	const char *pattern;
+	pcre *re;
+	pcre_extra *extra;
+} regex_cache[REGEX_CACHE_SIZE];
+static pthread_mutex_t regex_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static pcre *get_regex(const char *pattern, pcre_extra **extra)
 {
 	const char *errptr;
-	int erroroffset;
-	pcre *re = pcre_compile(pattern, 0, &errptr, &erroroffset, NULL);
+	int erroroffset, i;
+	pcre *re = NULL;
+
+	pthread_mutex_lock(&regex_cache_lock);
+	for (i = 0; i < REGEX_CACHE_SIZE && regex_cache[i].pattern != NULL; i++) {
+		if (regex_cache[i].pattern == pattern) {
+			re = regex_cache[i].re;
+			*extra = regex_cache[i].extra;
+			goto unlock;
+		}
+	}
+	re = oscap_pcre_compile(pattern, 0, &errptr, &erroroffset, extra);
 	if (re == NULL) {
 		dE("pcre_compile failed on pattern '%s': %s at %d", pattern,
 			errptr, erroroffset);
+	} else if (i < REGEX_CACHE_SIZE) {
+		regex_cache[i].pattern = pattern;
+		regex_cache[i].re = re;
+		regex_cache[i].extra = *extra;
+	}
+unlock:
+	pthread_mutex_unlock(&regex_cache_lock);
+	return re;
+}
+
+static bool match_regex(const char *pattern, const char *value)
+{
+	pcre_extra *extra = NULL;
+	pcre *re = get_regex(pattern, &extra);
+	if (re == NULL) {
 		return false;
 	}
 	int ovector[OVECCOUNT];
-	int rc = pcre_exec(re, NULL, value, strlen(value), 0, 0, ovector, OVECCOUNT);
-	pcre_free(re);
+	int rc = pcre_exec(re, extra, value, strlen(value), 0, 0, ovector, OVECCOUNT);
 	if (rc > 0) {
 		return true;
 	}
@@ -190,19 +310,39 @@ do {                                                                     \
 	ret = -1;                                                            \
 } while (0)
 
-static int yaml_path_query(yaml_parser_t *parser, const char *yaml_path_cstr, struct oscap_list *values, probe_ctx *ctx)
+static void yaml_query_parse(struct yaml_query *query)
+{
+	query->path = yaml_path_create();
+	query->invalid = yaml_path_parse(query->path, (char *) query->str) != 0;
+}
+
+static void yaml_query_init(struct yaml_query *query, const char *yaml_path_cstr)
+{
+	query->str = yaml_path_cstr;
+	yaml_query_parse(query);
+	yaml_parser_initialize(&query->parser);
+}
+
+static void yaml_query_destroy(struct yaml_query *query)
+{
+	yaml_path_destroy(query->path);
+	yaml_parser_delete(&query->parser);
+}
+
+static int yaml_path_query(const struct yaml_events *ev, struct yaml_query *query, struct oscap_list *values, probe_ctx *ctx)
 {
 	int ret = 0;
+	const char *yaml_path_cstr = query->str;
+	yaml_path_t *yaml_path = query->path;
 
-	yaml_path_t *yaml_path = yaml_path_create();
-	if (yaml_path_parse(yaml_path, (char *) yaml_path_cstr)) {
+	if (query->invalid) {
 		result_error("Invalid YAML path '%s': %s", yaml_path_cstr, yaml_path_error_get(yaml_path)->message);
-		yaml_path_destroy(yaml_path);
 		return ret;
 	};
 
-	yaml_event_t event;
+	yaml_event_t *event;
 	yaml_event_type_t event_type;
+	size_t i = 0;
 	bool sequence = false;
 	bool mapping = false;
 	bool fake_mapping = false;
@@ -212,14 +352,15 @@ static int yaml_path_query(yaml_parser_t *parser, const char *yaml_path_cstr, st
 	struct oscap_htable *record = NULL;
 
 	do {
-		if (!yaml_parser_parse(parser, &event)) {
-			result_error("YAML parser error: %s", parser->problem);
+		if (i == ev->count) {
+			result_error("YAML parser error: %s", ev->problem);
 			goto cleanup;
 		}
 
-		event_type = event.type;
+		event = &ev->events[i++];
+		event_type = event->type;
 
-		if (yaml_path_filter_event(yaml_path, parser, &event) == YAML_PATH_FILTER_RESULT_OUT) {
+		if (yaml_path_filter_event(yaml_path, &query->parser, event) == YAML_PATH_FILTER_RESULT_OUT) {
 			goto next;
 		}
 
@@ -290,15 +431,15 @@ static int yaml_path_query(yaml_parser_t *parser, const char *yaml_path_cstr, st
 				if (!sequence) {
 					if (index++ % 2 == 0) {
 						free(key);
-						key = escape_key(strdup((const char *) event.data.scalar.value));
+						key = escape_key(strdup((const char *) event->data.scalar.value));
 						goto next;
 					}
 				}
 			}
 
-			SEXP_t *sexp = yaml_scalar_event_to_sexp(&event);
+			SEXP_t *sexp = yaml_scalar_event_to_sexp(event);
 			if (sexp == NULL) {
-				result_error("Can't convert '%s %s' to SEXP", event.data.scalar.tag, event.data.scalar.value);
+				result_error("Can't convert '%s %s' to SEXP", event->data.scalar.tag, event->data.scalar.value);
 				goto cleanup;
 			}
 
@@ -313,16 +454,18 @@ static int yaml_path_query(yaml_parser_t *parser, const char *yaml_path_cstr, st
 			oscap_list_add(field, sexp);
 		}
 next:
-		yaml_event_delete(&event);
+		;
 	} while (event_type != YAML_STREAM_END_EVENT);
 
 cleanup:
-	if (event.type != 0)
-		yaml_event_delete(&event);
 	if (record)
 		oscap_list_add(values, record);
 	free(key);
-	yaml_path_destroy(yaml_path);
+	if (ret != 0) {
+		/* the filter state is left in the middle of the stream */
+		yaml_path_destroy(yaml_path);
+		yaml_query_parse(query);
+	}
 
 	return ret;
 }
@@ -337,7 +480,7 @@ static void values_free(struct oscap_htable *record)
 	oscap_htable_free(record, (oscap_destruct_func) record_free);
 }
 
-static int process_yaml(yaml_parser_t *parser, const char *yamlpath, SEXP_t *item, probe_ctx *ctx)
+static int process_yaml(const struct yaml_events *ev, struct yaml_query *query, SEXP_t *item, probe_ctx *ctx)
 {
 	int ret = 0;
 
@@ -346,7 +489,7 @@ static int process_yaml(yaml_parser_t *parser, const char *yamlpath, SEXP_t *ite
 
 	struct oscap_list *values = oscap_list_new();
 
-	if (yaml_path_query(parser, yamlpath, values, ctx)) {
+	if (yaml_path_query(ev, query, values, ctx)) {
 		ret = -1;
 		goto cleanup;
 	}
@@ -387,81 +530,233 @@ cleanup:
 	return ret;
 }
 
-static int process_yaml_file(const char *prefix, const char *path, const char *filename, const char *yamlpath, probe_ctx *ctx)
+/* parse the whole stream, the events up to an error are kept */
+static void yaml_events_parse(yaml_parser_t *parser, struct yaml_events *ev)
 {
-	int ret = 0;
+	size_t alloc = 0;
+	yaml_event_t event;
+
+	for (;;) {
+		if (!yaml_parser_parse(parser, &event)) {
+			ev->problem = oscap_strdup(parser->problem);
+			return;
+		}
+		if (ev->count == alloc) {
+			yaml_event_t *new_events = realloc(ev->events, (alloc + 256) * sizeof(yaml_event_t));
+			if (new_events == NULL) {
+				yaml_event_delete(&event);
+				ev->problem = strdup("out of memory");
+				return;
+			}
+			ev->events = new_events;
+			alloc += 256;
+		}
+		ev->events[ev->count++] = event;
+		if (event.type == YAML_STREAM_END_EVENT)
+			return;
+	}
+}
+
+static bool same_file(const struct stat *a, const struct stat *b)
+{
+	return a->st_dev == b->st_dev && a->st_ino == b->st_ino
+	    && a->st_size == b->st_size
+	    && a->st_mtime == b->st_mtime
+	    && YAML_MTIME_NSEC(a) == YAML_MTIME_NSEC(b);
+}
+
+/* must be called with g->lock held */
+static struct yaml_doc_entry *doc_cache_find(struct yamlfilecontent_global *g, const struct stat *st)
+{
+	size_t i;
+
+	for (i = 0; i < g->doc_count; ++i) {
+		if (same_file(&g->docs[i]->st, st)) {
+			g->docs[i]->refs++;
+			g->docs[i]->used = ++g->clock;
+			return g->docs[i];
+		}
+	}
+	return NULL;
+}
+
+/* must be called with g->lock held */
+static void doc_cache_insert(struct yamlfilecontent_global *g, struct yaml_doc_entry *entry)
+{
+	size_t i, lru = 0;
 
+	if (g->doc_count == YAML_DOC_CACHE_MAX) {
+		for (i = 1; i < g->doc_count; ++i) {
+			if (g->docs[i]->used < g->docs[lru]->used)
+				lru = i;
+		}
+		/* a document still in use is freed on release */
+		g->docs[lru]->cached = false;
+		if (g->docs[lru]->refs == 0)
+			yaml_doc_entry_free(g->docs[lru]);
+		g->docs[lru] = g->docs[--g->doc_count];
+	}
+	entry->cached = true;
+	entry->used = ++g->clock;
+	g->docs[g->doc_count++] = entry;
+}
+
+/*
+ * Get the events of a file, parsing it only if no earlier object parsed
+ * the same version of it.
+ * @return the parsed file or NULL with errno set if it can't be opened
+ */
+static struct yaml_doc_entry *get_doc(struct yamlfilecontent_global *g, const char *filepath)
+{
+	struct yaml_doc_entry *entry, *found;
+	oval_content_t *content = NULL;
+	FILE *yaml_file = NULL;
 	yaml_parser_t parser;
+	struct stat st;
+	bool cacheable;
+
+	cacheable = oval_fts_cache_stat(filepath, &st) == 0 && S_ISREG(st.st_mode);
+	if (cacheable) {
+		pthread_mutex_lock(&g->lock);
+		entry = doc_cache_find(g, &st);
+		pthread_mutex_unlock(&g->lock);
+		if (entry != NULL)
+			return entry;
+	}
+
+	if (!cacheable || oval_content_cache_get(filepath, &st, &content) != 0) {
+		yaml_file = fopen(filepath, "r");
+		if (yaml_file == NULL)
+			return NULL;
+	}
+
+	entry = calloc(1, sizeof(struct yaml_doc_entry));
+	if (entry == NULL) {
+		if (yaml_file != NULL)
+			fclose(yaml_file);
+		if (content != NULL)
+			oval_content_cache_release(content);
+		errno = ENOMEM;
+		return NULL;
+	}
 	yaml_parser_initialize(&parser);
+	if (content != NULL)
+		yaml_parser_set_input_string(&parser, (const unsigned char *) content->data, content->size);
+	else
+		yaml_parser_set_input_file(&parser, yaml_file);
+	yaml_events_parse(&parser, &entry->events);
+	yaml_parser_delete(&parser);
+	if (yaml_file != NULL)
+		fclose(yaml_file);
+	if (content != NULL)
+		oval_content_cache_release(content);
+
+	entry->st = st;
+	entry->refs = 1;
+
+	if (cacheable) {
+		pthread_mutex_lock(&g->lock);
+		found = doc_cache_find(g, &st);
+		if (found == NULL)
+			doc_cache_insert(g, entry);
+		pthread_mutex_unlock(&g->lock);
+		if (found != NULL) {
+			/* parsed by another thread meanwhile */
+			yaml_doc_entry_free(entry);
+			entry = found;
+		}
+	}
+
+	return entry;
+}
+
+static void release_doc(struct yamlfilecontent_global *g, struct yaml_doc_entry *entry)
+{
+	bool unused;
+
+	pthread_mutex_lock(&g->lock);
+	unused = --entry->refs == 0 && !entry->cached;
+	pthread_mutex_unlock(&g->lock);
+
+	if (unused)
+		yaml_doc_entry_free(entry);
+}
+
+static int process_yaml_file(struct yamlfilecontent_global *g, const char *prefix, const char *path, const char *filename, struct yaml_query *query, probe_ctx *ctx)
+{
+	int ret = 0;
 
 	char *filepath = oscap_path_join(path, filename);
 	char *filepath_with_prefix = oscap_path_join(prefix, filepath);
 
-	FILE *yaml_file = fopen(filepath_with_prefix, "r");
-	if (yaml_file == NULL) {
+	struct yaml_doc_entry *doc = get_doc(g, filepath_with_prefix);
+	if (doc == NULL) {
 		result_error("Unable to open file '%s': %s", filepath_with_prefix, strerror(errno));
 		goto cleanup;
 	}
 
-	yaml_parser_set_input_file(&parser, yaml_file);
-
 	SEXP_t *item = probe_item_create(
 		OVAL_INDEPENDENT_YAML_FILE_CONTENT,
 		NULL,
 		"filepath", OVAL_DATATYPE_STRING, filepath,
 		"path", OVAL_DATATYPE_STRING, path,
 		"filename", OVAL_DATATYPE_STRING, filename,
-		"yamlpath", OVAL_DATATYPE_STRING, yamlpath,
+		"yamlpath", OVAL_DATATYPE_STRING, query->str,
 		// TODO: Implement "windows_view",
 		NULL
 	);
 
-	if (process_yaml(&parser, yamlpath, item, ctx)) {
+	if (process_yaml(&doc->events, query, item, ctx)) {
 		SEXP_free(item);
 		ret = -1;
 		goto cleanup;
 	}
 
 cleanup:
-	if (yaml_file != NULL)
-		fclose(yaml_file);
-	yaml_parser_delete(&parser);
+	if (doc != NULL)
+		release_doc(g, doc);
 	free(filepath_with_prefix);
 	free(filepath);
 
 	return ret;
 }
 
-static int process_yaml_content(const char *content, const char *yamlpath, probe_ctx *ctx)
+static int process_yaml_content(const char *content, struct yaml_query *query, probe_ctx *ctx)
 {
 	int ret = 0;
+	struct yaml_events ev = { NULL, 0, NULL };
 
 	yaml_parser_t parser;
 	yaml_parser_initialize(&parser);
 	yaml_parser_set_input_string(&parser, (unsigned char *) content, strlen(content));
+	yaml_events_parse(&parser, &ev);
+	yaml_parser_delete(&parser);
 
 	SEXP_t *item = probe_item_create(
 		OVAL_INDEPENDENT_YAML_FILE_CONTENT,
 		NULL,
 		"content", OVAL_DATATYPE_STRING, content,
-		"yamlpath", OVAL_DATATYPE_STRING, yamlpath,
+		"yamlpath", OVAL_DATATYPE_STRING, query->str,
 		NULL
 	);
 
-	if (process_yaml(&parser, yamlpath, item, ctx)) {
+	if (process_yaml(&ev, query, item, ctx)) {
 		SEXP_free(item);
 		ret = -1;
 		goto cleanup;
 	}
 
 cleanup:
-	yaml_parser_delete(&parser);
+	yaml_events_free(&ev);
 
 	return ret;
 }
 
 int yamlfilecontent_probe_main(probe_ctx *ctx, void *arg)
 {
+	if (arg == NULL)
+		return PROBE_EINIT;
+
 	SEXP_t *probe_in = probe_ctx_getobject(ctx);
 	SEXP_t *behaviors_ent = probe_obj_getent(probe_in, "behaviors", 1);
 	SEXP_t *filepath_ent = probe_obj_getent(probe_in, "filepath", 1);
@@ -473,9 +768,12 @@ int yamlfilecontent_probe_main(probe_ctx *ctx, void *arg)
 	SEXP_t *content_ent = probe_obj_getent(probe_in, "content", 1);
 	SEXP_t *content_val = probe_ent_getval(content_ent);
 	char *content_str = SEXP_string_cstr(content_val);
+	struct yaml_query query;
+
+	yaml_query_init(&query, yamlpath_str);
 
 	if (content_str != NULL) {
-		process_yaml_content(content_str, yamlpath_str, ctx);
+		process_yaml_content(content_str, &query, ctx);
 	} else {
 		probe_filebehaviors_canonicalize(&behaviors_ent);
 		const char *prefix = getenv("OSCAP_PROBE_ROOT");
@@ -487,8 +785,8 @@ int yamlfilecontent_probe_main(probe_ctx *ctx, void *arg)
 			while ((ofts_ent = oval_fts_read(ofts)) != NULL) {
 				if (ofts_ent->fts_info == FTS_F
 					|| ofts_ent->fts_info == FTS_SL) {
-					process_yaml_file(prefix, ofts_ent->path, ofts_ent->file,
-						yamlpath_str, ctx);
+					process_yaml_file(arg, prefix, ofts_ent->path, ofts_ent->file,
+						&query, ctx);
 				}
 				oval_ftsent_free(ofts_ent);
 			}
@@ -496,6 +794,7 @@ int yamlfilecontent_probe_main(probe_ctx *ctx, void *arg)
 		}
 	}
 
+	yaml_query_destroy(&query);
 	free(content_str);
 	SEXP_free(content_val);
 	SEXP_free(content_ent);
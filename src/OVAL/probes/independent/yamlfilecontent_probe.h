@@ -26,6 +26,8 @@
 #include "probe-api.h"
 
 int yamlfilecontent_probe_offline_mode_supported(void);
+void *yamlfilecontent_probe_init(void);
 int yamlfilecontent_probe_main(probe_ctx *ctx, void *arg);
+void yamlfilecontent_probe_fini(void *arg);
 
 #endif /* OPENSCAP_YAMLFILECONTENT_PROBE_H */
@@ -0,0 +1,283 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "common/list.h"
+#include "common/util.h"
+#include "common/debug_priv.h"
+#include "oval_account_cache.h"
+
+#define OVAL_ACCOUNT_HSIZE 1031
+
+enum oval_account_db_type {
+	OVAL_ACCOUNT_PASSWD,
+	OVAL_ACCOUNT_SHADOW,
+	OVAL_ACCOUNT_DB_TYPES
+};
+
+struct oval_account_db {
+	unsigned int refs;
+	size_t count;
+	size_t alloc;
+	void **entries;              /* struct passwd or struct spwd with its strings */
+	struct oscap_htable *by_name; /* name -> the first entry of the name */
+};
+
+/* one snapshot of NSS and one of the files under a root for each type */
+static pthread_mutex_t account_lock = PTHREAD_MUTEX_INITIALIZER;
+static oval_account_db_t *account_dbs[OVAL_ACCOUNT_DB_TYPES][2];
+
+static void oval_account_db_free(oval_account_db_t *db)
+{
+	size_t i;
+
+	oscap_htable_free0(db->by_name);
+	for (i = 0; i < db->count; ++i)
+		free(db->entries[i]);
+	free(db->entries);
+	free(db);
+}
+
+static bool oval_account_db_add(oval_account_db_t *db, const char *name, void *entry)
+{
+	if (entry == NULL)
+		return false;
+	if (db->count == db->alloc) {
+		void **new_entries = realloc(db->entries, (db->alloc + 256) * sizeof(void *));
+
+		if (new_entries == NULL) {
+			free(entry);
+			return false;
+		}
+		db->entries = new_entries;
+		db->alloc += 256;
+	}
+	db->entries[db->count++] = entry;
+	/* a duplicate name keeps the first entry, like getpwnam does */
+	oscap_htable_add(db->by_name, name, entry);
+
+	return true;
+}
+
+/* copy the strings to the end of the entry */
+static char *oval_account_strcpy(char **dst, const char *src)
+{
+	char *s = *dst;
+	size_t len = src != NULL ? strlen(src) : 0;
+
+	if (len > 0)
+		memcpy(s, src, len);
+	s[len] = '\0';
+	*dst += len + 1;
+
+	return s;
+}
+
+static size_t oval_account_strlen(const char *s)
+{
+	return (s != NULL ? strlen(s) : 0) + 1;
+}
+
+static struct passwd *oval_account_passwd_dup(const struct passwd *pw)
+{
+	struct passwd *copy;
+	char *s;
+
+	copy = malloc(sizeof(struct passwd) + oval_account_strlen(pw->pw_name) +
+		      oval_account_strlen(pw->pw_passwd) + oval_account_strlen(pw->pw_gecos) +
+		      oval_account_strlen(pw->pw_dir) + oval_account_strlen(pw->pw_shell));
+	if (copy == NULL)
+		return NULL;
+	*copy = *pw;
+	s = (char *)(copy + 1);
+	copy->pw_name = oval_account_strcpy(&s, pw->pw_name);
+	copy->pw_passwd = oval_account_strcpy(&s, pw->pw_passwd);
+	copy->pw_gecos = oval_account_strcpy(&s, pw->pw_gecos);
+	copy->pw_dir = oval_account_strcpy(&s, pw->pw_dir);
+	copy->pw_shell = oval_account_strcpy(&s, pw->pw_shell);
+
+	return copy;
+}
+
+#ifdef HAVE_SHADOW_H
+static struct spwd *oval_account_shadow_dup(const struct spwd *sp)
+{
+	struct spwd *copy;
+	char *s;
+
+	copy = malloc(sizeof(struct spwd) + oval_account_strlen(sp->sp_namp) +
+		      oval_account_strlen(sp->sp_pwdp));
+	if (copy == NULL)
+		return NULL;
+	*copy = *sp;
+	s = (char *)(copy + 1);
+	copy->sp_namp = oval_account_strcpy(&s, sp->sp_namp);
+	copy->sp_pwdp = oval_account_strcpy(&s, sp->sp_pwdp);
+
+	return copy;
+}
+#endif
+
+/* must be called with account_lock held, the NSS enumeration isn't reentrant */
+static oval_account_db_t *oval_account_db_load(enum oval_account_db_type type, const char *root)
+{
+	oval_account_db_t *db;
+	FILE *fp = NULL;
+
+	if (root != NULL) {
+#if defined(OS_FREEBSD) || defined(OS_APPLE)
+		return NULL;
+#else
+		char *path = oscap_path_join(root, type == OVAL_ACCOUNT_PASSWD ? "/etc/passwd" : "/etc/shadow");
+
+		fp = fopen(path, "r");
+		free(path);
+		if (fp == NULL)
+			return NULL;
+#endif
+	}
+
+	db = calloc(1, sizeof(oval_account_db_t));
+	if (db == NULL) {
+		if (fp != NULL)
+			fclose(fp);
+		return NULL;
+	}
+	db->by_name = oscap_htable_new1(strcmp, OVAL_ACCOUNT_HSIZE);
+
+	if (type == OVAL_ACCOUNT_PASSWD) {
+		struct passwd *pw;
+
+#if defined(OS_FREEBSD) || defined(OS_APPLE)
+		while ((pw = getpwent()) != NULL)
+#else
+		while ((pw = (fp != NULL ? fgetpwent(fp) : getpwent())) != NULL)
+#endif
+			oval_account_db_add(db, pw->pw_name, oval_account_passwd_dup(pw));
+		if (fp == NULL)
+			endpwent();
+	}
+#ifdef HAVE_SHADOW_H
+	else {
+		struct spwd *sp;
+
+		while ((sp = (fp != NULL ? fgetspent(fp) : getspent())) != NULL)
+			oval_account_db_add(db, sp->sp_namp, oval_account_shadow_dup(sp));
+		if (fp == NULL)
+			endspent();
+	}
+#endif
+	if (fp != NULL)
+		fclose(fp);
+	dD("Read %zu %s entries.", db->count, type == OVAL_ACCOUNT_PASSWD ? "passwd" : "shadow");
+
+	return db;
+}
+
+static oval_account_db_t *oval_account_cache_get(enum oval_account_db_type type, const char *root)
+{
+	oval_account_db_t **slot = &account_dbs[type][root != NULL];
+	oval_account_db_t *db;
+
+	pthread_mutex_lock(&account_lock);
+	if (*slot == NULL) {
+		*slot = oval_account_db_load(type, root);
+		/* one reference is held by the cache */
+		if (*slot != NULL)
+			(*slot)->refs = 1;
+	}
+	db = *slot;
+	if (db != NULL)
+		db->refs++;
+	pthread_mutex_unlock(&account_lock);
+
+	return db;
+}
+
+oval_account_db_t *oval_account_cache_passwd(const char *root)
+{
+	return oval_account_cache_get(OVAL_ACCOUNT_PASSWD, root);
+}
+
+const struct passwd *oval_account_cache_passwd_at(const oval_account_db_t *db, size_t i)
+{
+	return i < db->count ? db->entries[i] : NULL;
+}
+
+const struct passwd *oval_account_cache_passwd_by_name(const oval_account_db_t *db, const char *name)
+{
+	return oscap_htable_get(db->by_name, name);
+}
+
+#ifdef HAVE_SHADOW_H
+oval_account_db_t *oval_account_cache_shadow(const char *root)
+{
+	return oval_account_cache_get(OVAL_ACCOUNT_SHADOW, root);
+}
+
+const struct spwd *oval_account_cache_shadow_at(const oval_account_db_t *db, size_t i)
+{
+	return i < db->count ? db->entries[i] : NULL;
+}
+
+const struct spwd *oval_account_cache_shadow_by_name(const oval_account_db_t *db, const char *name)
+{
+	return oscap_htable_get(db->by_name, name);
+}
+#endif
+
+void oval_account_cache_release(oval_account_db_t *db)
+{
+	bool last;
+
+	if (db == NULL)
+		return;
+
+	pthread_mutex_lock(&account_lock);
+	last = --db->refs == 0;
+	pthread_mutex_unlock(&account_lock);
+
+	if (last)
+		oval_account_db_free(db);
+}
+
+void oval_account_cache_reset(void)
+{
+	oval_account_db_t *dbs[OVAL_ACCOUNT_DB_TYPES][2];
+	int i, j;
+
+	pthread_mutex_lock(&account_lock);
+	memcpy(dbs, account_dbs, sizeof(dbs));
+	memset(account_dbs, 0, sizeof(account_dbs));
+	pthread_mutex_unlock(&account_lock);
+
+	for (i = 0; i < OVAL_ACCOUNT_DB_TYPES; ++i) {
+		for (j = 0; j < 2; ++j)
+			oval_account_cache_release(dbs[i][j]);
+	}
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+#ifndef OVAL_ACCOUNT_CACHE_H
+#define OVAL_ACCOUNT_CACHE_H
+
+#include <stddef.h>
+#include <pwd.h>
+#ifdef HAVE_SHADOW_H
+#include <shadow.h>
+#endif
+
+/*
+ * Snapshot of the user accounts shared by the password and shadow objects
+ * of one scan. The entries are enumerated once, so NSS backends like SSSD
+ * or LDAP are not asked again for every object, and looked up by name
+ * without a walk. With a root directory the files under it are read
+ * instead. Everything is dropped after each remediation fix and when the
+ * last probe session ends.
+ */
+
+typedef struct oval_account_db oval_account_db_t;
+
+/**
+ * Get the passwd entries, enumerating them on the first call.
+ * @param root read root/etc/passwd, NULL to ask NSS
+ * @return the snapshot to be released by oval_account_cache_release, NULL
+ * if the file can't be read
+ */
+oval_account_db_t *oval_account_cache_passwd(const char *root);
+
+/**
+ * Get the i-th passwd entry in the order of the enumeration.
+ * @return the entry or NULL past the last one
+ */
+const struct passwd *oval_account_cache_passwd_at(const oval_account_db_t *db, size_t i);
+
+/**
+ * Get the first passwd entry of the user.
+ * @return the entry or NULL if there is none
+ */
+const struct passwd *oval_account_cache_passwd_by_name(const oval_account_db_t *db, const char *name);
+
+#ifdef HAVE_SHADOW_H
+/**
+ * Get the shadow entries, enumerating them on the first call.
+ * @param root read root/etc/shadow, NULL to ask NSS
+ * @return the snapshot to be released by oval_account_cache_release, NULL
+ * if the file can't be read
+ */
+oval_account_db_t *oval_account_cache_shadow(const char *root);
+
+const struct spwd *oval_account_cache_shadow_at(const oval_account_db_t *db, size_t i);
+
+const struct spwd *oval_account_cache_shadow_by_name(const oval_account_db_t *db, const char *name);
+#endif
+
+void oval_account_cache_release(oval_account_db_t *db);
+
+/**
+ * Drop the snapshots. Snapshots still held are freed on release.
+ */
+void oval_account_cache_reset(void);
+
+#endif /* OVAL_ACCOUNT_CACHE_H */
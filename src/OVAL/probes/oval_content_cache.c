@@ -0,0 +1,320 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "oscap_platforms.h"
+#include "common/list.h"
+#include "common/debug_priv.h"
+#include "oval_content_cache.h"
+#include "oval_throttle.h"
+
+/* default of OSCAP_CONTENT_CACHE_SIZE in MiB */
+#define OVAL_CONTENT_CACHE_SIZE_DEFAULT 64
+#define OVAL_CONTENT_CACHE_HSIZE        1021
+/* read size for files which don't report their size */
+#define OVAL_CONTENT_READ_CHUNK         4096
+
+#if defined(OS_FREEBSD) || defined(OS_APPLE)
+#define OVAL_CONTENT_MTIME_NSEC(st) ((st)->st_mtimespec.tv_nsec)
+#elif defined(OS_LINUX) || defined(OS_SOLARIS)
+#define OVAL_CONTENT_MTIME_NSEC(st) ((st)->st_mtim.tv_nsec)
+#else
+#define OVAL_CONTENT_MTIME_NSEC(st) 0L
+#endif
+
+struct oval_content_entry {
+	oval_content_t content; /* first, the callers get a pointer to it */
+	char *data;
+	unsigned int refs;
+	bool cached;            /* in the table and on the LRU list */
+	char key[80];
+	struct oval_content_entry *prev, *next;
+};
+
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct oscap_htable *content_table = NULL;
+/* most recently used first */
+static struct oval_content_entry *lru_head = NULL, *lru_tail = NULL;
+static size_t cache_bytes = 0;
+static size_t cache_budget = 0;
+static bool cache_budget_set = false;
+
+/* must be called with cache_lock held */
+static size_t oval_content_cache_budget(void)
+{
+	if (!cache_budget_set) {
+		const char *env = getenv("OSCAP_CONTENT_CACHE_SIZE");
+		unsigned long mib = OVAL_CONTENT_CACHE_SIZE_DEFAULT;
+
+		if (env != NULL) {
+			char *end;
+
+			errno = 0;
+			mib = strtoul(env, &end, 10);
+			if (errno != 0 || end == env || *end != '\0') {
+				dW("Invalid value of OSCAP_CONTENT_CACHE_SIZE: '%s', using %d.",
+				   env, OVAL_CONTENT_CACHE_SIZE_DEFAULT);
+				mib = OVAL_CONTENT_CACHE_SIZE_DEFAULT;
+			}
+		}
+		cache_budget = mib > SIZE_MAX / (1024 * 1024) ? SIZE_MAX : mib * 1024 * 1024;
+		cache_budget_set = true;
+	}
+
+	return cache_budget;
+}
+
+static void oval_content_entry_free(struct oval_content_entry *entry)
+{
+	free(entry->data);
+	free(entry);
+}
+
+/* must be called with cache_lock held */
+static void oval_content_lru_unlink(struct oval_content_entry *entry)
+{
+	if (entry->prev != NULL)
+		entry->prev->next = entry->next;
+	else
+		lru_head = entry->next;
+	if (entry->next != NULL)
+		entry->next->prev = entry->prev;
+	else
+		lru_tail = entry->prev;
+	entry->prev = entry->next = NULL;
+}
+
+/* must be called with cache_lock held */
+static void oval_content_lru_push(struct oval_content_entry *entry)
+{
+	entry->prev = NULL;
+	entry->next = lru_head;
+	if (lru_head != NULL)
+		lru_head->prev = entry;
+	lru_head = entry;
+	if (lru_tail == NULL)
+		lru_tail = entry;
+}
+
+/* must be called with cache_lock held */
+static void oval_content_evict(struct oval_content_entry *entry)
+{
+	oval_content_lru_unlink(entry);
+	oscap_htable_detach(content_table, entry->key);
+	cache_bytes -= entry->content.size;
+	entry->cached = false;
+	if (entry->refs == 0)
+		oval_content_entry_free(entry);
+}
+
+static void oval_content_key(char *key, size_t size, const struct stat *st)
+{
+	snprintf(key, size, "%ju:%ju:%jd.%09ld:%jd",
+	         (uintmax_t) st->st_dev, (uintmax_t) st->st_ino,
+	         (intmax_t) st->st_mtime, (long) OVAL_CONTENT_MTIME_NSEC(st),
+	         (intmax_t) st->st_size);
+}
+
+static bool oval_content_same_file(const struct stat *a, const struct stat *b)
+{
+	return a->st_dev == b->st_dev && a->st_ino == b->st_ino
+	    && a->st_size == b->st_size
+	    && a->st_mtime == b->st_mtime
+	    && OVAL_CONTENT_MTIME_NSEC(a) == OVAL_CONTENT_MTIME_NSEC(b);
+}
+
+/*
+ * Read the whole file into one allocation of the stat-ed size, one byte
+ * more is requested to see the end of file in the same loop. Files which
+ * grew meanwhile or report no size are read in chunks.
+ */
+static int oval_content_read(int fd, size_t size_hint, char **data, size_t *size)
+{
+	size_t buf_size = size_hint > 0 ? size_hint + 1 : OVAL_CONTENT_READ_CHUNK;
+	size_t buf_used = 0;
+	ssize_t nread;
+	char *buf;
+
+	buf = malloc(buf_size);
+	if (buf == NULL)
+		return -1;
+
+	for (;;) {
+		if (buf_used == buf_size) {
+			char *new_buf = realloc(buf, buf_size + OVAL_CONTENT_READ_CHUNK);
+
+			if (new_buf == NULL) {
+				free(buf);
+				errno = ENOMEM;
+				return -1;
+			}
+			buf = new_buf;
+			buf_size += OVAL_CONTENT_READ_CHUNK;
+		}
+		nread = read(fd, buf + buf_used, oval_throttle_io_size(buf_size - buf_used));
+		if (nread == -1) {
+			int err = errno;
+
+			if (err == EINTR)
+				continue;
+			free(buf);
+			errno = err;
+			return -1;
+		}
+		if (nread == 0)
+			break;
+		buf_used += nread;
+		oval_throttle_io(nread);
+	}
+
+	if (buf_used == buf_size) {
+		char *new_buf = realloc(buf, buf_size + 1);
+
+		if (new_buf == NULL) {
+			free(buf);
+			errno = ENOMEM;
+			return -1;
+		}
+		buf = new_buf;
+	}
+	buf[buf_used] = '\0';
+
+	*data = buf;
+	*size = buf_used;
+	return 0;
+}
+
+int oval_content_cache_get(const char *path, const struct stat *st, oval_content_t **content)
+{
+	struct oval_content_entry *entry, *cached;
+	struct stat fst;
+	bool cacheable;
+	int fd, err;
+	char key[sizeof(entry->key)];
+
+	oval_content_key(key, sizeof(key), st);
+	/* sizes of /proc and similar files don't describe their content */
+	cacheable = st->st_size > 0;
+
+	if (cacheable) {
+		pthread_mutex_lock(&cache_lock);
+		entry = content_table != NULL ? oscap_htable_get(content_table, key) : NULL;
+		if (entry != NULL) {
+			entry->refs++;
+			oval_content_lru_unlink(entry);
+			oval_content_lru_push(entry);
+			pthread_mutex_unlock(&cache_lock);
+			*content = &entry->content;
+			return 0;
+		}
+		pthread_mutex_unlock(&cache_lock);
+	}
+
+	fd = open(path, O_RDONLY);
+	if (fd == -1)
+		return -1;
+
+	entry = calloc(1, sizeof(struct oval_content_entry));
+	if (entry == NULL) {
+		close(fd);
+		errno = ENOMEM;
+		return -2;
+	}
+	if (oval_content_read(fd, cacheable ? (size_t) st->st_size : 0, &entry->data, &entry->content.size) != 0) {
+		err = errno;
+		close(fd);
+		free(entry);
+		errno = err;
+		return -2;
+	}
+	entry->content.data = entry->data;
+	entry->refs = 1;
+	memcpy(entry->key, key, sizeof(key));
+
+	/* don't cache what was modified after the stat(2) we were given */
+	if (cacheable && (fstat(fd, &fst) != 0 || !oval_content_same_file(st, &fst)
+	                  || (size_t) fst.st_size != entry->content.size))
+		cacheable = false;
+	close(fd);
+
+	if (cacheable) {
+		pthread_mutex_lock(&cache_lock);
+		if (entry->content.size <= oval_content_cache_budget() / 2) {
+			if (content_table == NULL)
+				content_table = oscap_htable_new1(strcmp, OVAL_CONTENT_CACHE_HSIZE);
+			/* another probe may have read the file meanwhile */
+			cached = content_table != NULL ? oscap_htable_get(content_table, key) : NULL;
+			if (cached != NULL) {
+				oval_content_entry_free(entry);
+				entry = cached;
+				entry->refs++;
+				oval_content_lru_unlink(entry);
+				oval_content_lru_push(entry);
+			} else if (content_table != NULL && oscap_htable_add(content_table, key, entry)) {
+				entry->cached = true;
+				oval_content_lru_push(entry);
+				cache_bytes += entry->content.size;
+				while (cache_bytes > cache_budget && lru_tail != entry)
+					oval_content_evict(lru_tail);
+			}
+		}
+		pthread_mutex_unlock(&cache_lock);
+	}
+
+	*content = &entry->content;
+	return 0;
+}
+
+void oval_content_cache_release(oval_content_t *content)
+{
+	struct oval_content_entry *entry = (struct oval_content_entry *) content;
+
+	if (entry == NULL)
+		return;
+
+	pthread_mutex_lock(&cache_lock);
+	if (--entry->refs == 0 && !entry->cached)
+		oval_content_entry_free(entry);
+	pthread_mutex_unlock(&cache_lock);
+}
+
+void oval_content_cache_reset(void)
+{
+	pthread_mutex_lock(&cache_lock);
+	while (lru_head != NULL)
+		oval_content_evict(lru_head);
+	oscap_htable_free(content_table, NULL);
+	content_table = NULL;
+	cache_bytes = 0;
+	pthread_mutex_unlock(&cache_lock);
+}
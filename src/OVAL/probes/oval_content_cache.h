@@ -0,0 +1,64 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+#ifndef OVAL_CONTENT_CACHE_H
+#define OVAL_CONTENT_CACHE_H
+
+#include <stddef.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+/*
+ * File content cache shared by the probes reading whole files during one
+ * scan (textfilecontent, textfilecontent54, yamlfilecontent, xmlfilecontent).
+ * Contents are keyed by the device, inode, modification time and size of
+ * the file, so many objects looking into the same file read it from the
+ * disk once, and a file replaced or modified meanwhile is read again. The
+ * least recently used contents are dropped when the cache grows beyond
+ * OSCAP_CONTENT_CACHE_SIZE MiB; the cache is emptied after each remediation
+ * fix and when the last probe session ends.
+ */
+
+typedef struct {
+	const char *data; /* content followed by a NUL byte */
+	size_t size;      /* without the NUL byte */
+} oval_content_t;
+
+/**
+ * Get the content of a regular file, reading it if it is not cached.
+ * Files which don't report their size (e.g. in /proc) are read every time.
+ * The content has to be released by oval_content_cache_release.
+ * @param path the path of the file including the OSCAP_PROBE_ROOT prefix
+ * @param st the stat(2) of the file
+ * @param content the content, set on success
+ * @return 0 on success, -1 if the file can't be opened or -2 if it can't be
+ * read, errno is set on failure
+ */
+int oval_content_cache_get(const char *path, const struct stat *st, oval_content_t **content);
+
+/**
+ * Release a content obtained by oval_content_cache_get.
+ */
+void oval_content_cache_release(oval_content_t *content);
+
+/**
+ * Drop all the cached contents. Contents still held are freed on release.
+ */
+void oval_content_cache_reset(void);
+
+#endif /* OVAL_CONTENT_CACHE_H */
@@ -0,0 +1,195 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "common/debug_priv.h"
+#include "oval_deadline.h"
+
+#if defined(_MSC_VER)
+# define OVAL_DEADLINE_THREAD_LOCAL __declspec(thread)
+#else
+# define OVAL_DEADLINE_THREAD_LOCAL __thread
+#endif
+
+static pthread_once_t deadline_once = PTHREAD_ONCE_INIT;
+static uint64_t deadline_ns = 0; /* CLOCK_MONOTONIC, 0 if there is no deadline */
+static volatile bool deadline_passed = false;
+static volatile bool deadline_aborted = false;
+static uint64_t object_timeout_ns = 0; /* 0 if the objects have no timeout */
+
+/* the object collected by the thread, 0 if it doesn't expire */
+static OVAL_DEADLINE_THREAD_LOCAL uint64_t object_expires_ns = 0;
+static OVAL_DEADLINE_THREAD_LOCAL bool object_stopped = false;
+static OVAL_DEADLINE_THREAD_LOCAL bool object_decided = false; /* by oval_deadline_object_stop() */
+
+static uint64_t oval_deadline_clock(void)
+{
+	struct timespec ts;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0)
+		return 0;
+
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* @return the seconds of the variable, 0 if it isn't set or valid */
+static double oval_deadline_getenv(const char *name)
+{
+	const char *str;
+	char *end;
+	double seconds;
+
+	str = getenv(name);
+	if (str == NULL || *str == '\0')
+		return 0;
+
+	seconds = strtod(str, &end);
+	if (*end != '\0' || seconds <= 0) {
+		dW("Invalid %s value '%s'.", name, str);
+		return 0;
+	}
+
+	return seconds;
+}
+
+static void oval_deadline_init(void)
+{
+	double seconds;
+
+	seconds = oval_deadline_getenv("OSCAP_OBJECT_TIMEOUT");
+	if (seconds > 0) {
+		object_timeout_ns = (uint64_t)(seconds * 1e9);
+		dI("Objects not collected within %.1f seconds each will be incomplete.", seconds);
+	}
+
+	seconds = oval_deadline_getenv("OSCAP_SCAN_DEADLINE");
+	if (seconds > 0) {
+		deadline_ns = oval_deadline_clock() + (uint64_t)(seconds * 1e9);
+		dI("Objects not collected within %.1f seconds will be incomplete.", seconds);
+	}
+}
+
+void oval_deadline_start(void)
+{
+	pthread_once(&deadline_once, oval_deadline_init);
+}
+
+bool oval_deadline_passed(void)
+{
+	pthread_once(&deadline_once, oval_deadline_init);
+
+	if (deadline_aborted)
+		return true;
+	if (deadline_ns == 0)
+		return false;
+	if (deadline_passed)
+		return true;
+
+	if (oval_deadline_clock() >= deadline_ns) {
+		dW("The scan deadline was reached, the remaining objects are incomplete.");
+		deadline_passed = true;
+	}
+
+	return deadline_passed;
+}
+
+void oval_deadline_abort(void)
+{
+	if (!deadline_aborted)
+		dW("The scan was aborted, the remaining objects are incomplete.");
+	deadline_aborted = true;
+}
+
+void oval_deadline_resume(void)
+{
+	deadline_aborted = false;
+}
+
+void oval_deadline_object_begin(void)
+{
+	pthread_once(&deadline_once, oval_deadline_init);
+
+	object_expires_ns = object_timeout_ns > 0 ? oval_deadline_clock() + object_timeout_ns : 0;
+	object_stopped = false;
+	object_decided = false;
+}
+
+void oval_deadline_object_end(void)
+{
+	object_expires_ns = 0;
+	object_stopped = false;
+	object_decided = false;
+}
+
+uint64_t oval_deadline_object_get(void)
+{
+	return object_expires_ns;
+}
+
+void oval_deadline_object_set(uint64_t expires)
+{
+	object_expires_ns = expires;
+	object_stopped = false;
+	object_decided = false;
+}
+
+void oval_deadline_object_stop(void)
+{
+	object_stopped = true;
+	object_decided = true;
+}
+
+static bool oval_deadline_object_expired(void)
+{
+	return object_expires_ns != 0 && oval_deadline_clock() >= object_expires_ns;
+}
+
+bool oval_deadline_expired(void)
+{
+	if (object_stopped)
+		return true;
+	if (oval_deadline_passed() || oval_deadline_object_expired())
+		object_stopped = true;
+
+	return object_stopped;
+}
+
+bool oval_deadline_object_stopped(void)
+{
+	return object_stopped;
+}
+
+const char *oval_deadline_reason(void)
+{
+	if (object_decided)
+		return "the items collected decide its tests";
+	if (deadline_aborted)
+		return "the scan was aborted";
+	if (deadline_passed)
+		return "the scan deadline was reached";
+	return "the object timeout was reached";
+}
@@ -0,0 +1,121 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+#ifndef OVAL_DEADLINE_H
+#define OVAL_DEADLINE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Global deadline of the scan, for scans which have to fit into a
+ * maintenance window. It is read from the environment on the first use:
+ *
+ *   OSCAP_SCAN_DEADLINE  seconds the objects may be collected for,
+ *                        counted from the first collected object
+ *
+ * Objects which weren't sent to the probes before the deadline are not
+ * collected and the probes stop collecting items of the objects they are
+ * working on, all of them are flagged as incomplete. Probes running in
+ * separate worker processes (OSCAP_PROBE_PROCESSES) inherit the deadline
+ * when they are started after the first object was collected.
+ *
+ * Each object may also be given its own time limit:
+ *
+ *   OSCAP_OBJECT_TIMEOUT  seconds a probe may spend collecting one object
+ *
+ * The probes don't poll the deadlines, they call oval_deadline_expired() at
+ * their checkpoints: for every collected item, for every entry of a
+ * filesystem walk and in the loops which read or match large inputs. Once
+ * a checkpoint returns true the probe stops and the object it was
+ * collecting is flagged as incomplete with the reason as a message.
+ *
+ * The same checkpoints stop a probe which has collected the items the
+ * tests of its object need, see oval_deadline_object_stop().
+ */
+
+/**
+ * Start counting the deadline, if it wasn't started yet.
+ */
+void oval_deadline_start(void);
+
+/**
+ * @return true if the deadline was set and has passed
+ */
+bool oval_deadline_passed(void);
+
+/**
+ * Make the scan deadline pass now, the probes stop at their next
+ * checkpoint. It holds until oval_deadline_resume() is called.
+ */
+void oval_deadline_abort(void);
+
+/**
+ * Cancel the effect of oval_deadline_abort().
+ */
+void oval_deadline_resume(void);
+
+/**
+ * Start the timeout of the object collected by the calling thread.
+ */
+void oval_deadline_object_begin(void);
+
+/**
+ * End the collection of the object of the calling thread.
+ */
+void oval_deadline_object_end(void);
+
+/**
+ * @return the time the object of the calling thread expires at, to be
+ * handed over to the threads helping with its collection
+ */
+uint64_t oval_deadline_object_get(void);
+
+/**
+ * Collect for an object which expires at the given time, see
+ * oval_deadline_object_get().
+ */
+void oval_deadline_object_set(uint64_t expires);
+
+/**
+ * Stop the collection of the object of the calling thread at the next
+ * checkpoint because the items collected so far decide its tests.
+ */
+void oval_deadline_object_stop(void);
+
+/**
+ * Checkpoint of a probe: the scan deadline or the timeout of the object
+ * of the calling thread has passed, or the scan was aborted. The probes
+ * may hold their locks at the checkpoints, they stop by returning.
+ * @return true if the collection of the object has to stop
+ */
+bool oval_deadline_expired(void);
+
+/**
+ * @return true if a checkpoint stopped the collection of the object of the
+ * calling thread since oval_deadline_object_begin()
+ */
+bool oval_deadline_object_stopped(void);
+
+/**
+ * @return why the collection stops, e.g. "the scan deadline was reached",
+ * for the message of the incomplete object
+ */
+const char *oval_deadline_reason(void);
+
+#endif /* OVAL_DEADLINE_H */
@@ -0,0 +1,378 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <libgen.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "oscap_platforms.h"
+#include "common/list.h"
+#include "common/debug_priv.h"
+#include "crapi/crapi.h"
+#include "oval_digest_cache.h"
+
+#define OVAL_DIGEST_CACHE_HSIZE   65521
+#define OVAL_DIGEST_CACHE_MAGIC   "# OpenSCAP digest cache 1"
+/* entries not used for this many days are not written back */
+#define OVAL_DIGEST_CACHE_EXPIRE  30
+/*
+ * Digests of files changed less than this many seconds before they were
+ * read are not stored, the file may have changed again without changing
+ * its timestamps.
+ */
+#define OVAL_DIGEST_CACHE_RACY    2
+#define OVAL_DIGEST_MAX_LEN       64
+#define OVAL_DIGEST_MAX_ALGS      8
+
+#if defined(OS_FREEBSD) || defined(OS_APPLE)
+#define OVAL_DIGEST_MTIME_NSEC(st) ((st)->st_mtimespec.tv_nsec)
+#define OVAL_DIGEST_CTIME_NSEC(st) ((st)->st_ctimespec.tv_nsec)
+#elif defined(OS_LINUX) || defined(OS_SOLARIS)
+#define OVAL_DIGEST_MTIME_NSEC(st) ((st)->st_mtim.tv_nsec)
+#define OVAL_DIGEST_CTIME_NSEC(st) ((st)->st_ctim.tv_nsec)
+#else
+#define OVAL_DIGEST_MTIME_NSEC(st) 0L
+#define OVAL_DIGEST_CTIME_NSEC(st) 0L
+#endif
+
+struct oval_digest_file {
+	uintmax_t dev;
+	uintmax_t ino;
+	intmax_t size;
+	intmax_t mtime;
+	long mtime_nsec;
+	intmax_t ctime;
+	long ctime_nsec;
+};
+
+struct oval_digest_entry {
+	unsigned long day; /* when the digest was used the last time */
+	size_t len;
+	uint8_t digest[OVAL_DIGEST_MAX_LEN];
+};
+
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
+/* NULL until the cache file is loaded */
+static struct oscap_htable *digest_table = NULL;
+static char *cache_path = NULL;
+static bool cache_dirty = false;
+
+static unsigned long oval_digest_cache_today(void)
+{
+	return (unsigned long) (time(NULL) / 86400);
+}
+
+static void oval_digest_key(char *key, size_t size, const struct oval_digest_file *file, unsigned int alg)
+{
+	snprintf(key, size, "%ju %ju %jd %jd.%09ld %jd.%09ld %u",
+	         file->dev, file->ino, file->size,
+	         file->mtime, file->mtime_nsec, file->ctime, file->ctime_nsec, alg);
+}
+
+static int oval_digest_hex2mem(const char *hex, uint8_t *mem, size_t *len)
+{
+	size_t hlen = strlen(hex);
+
+	if (hlen % 2 != 0 || hlen / 2 > OVAL_DIGEST_MAX_LEN)
+		return -1;
+	for (size_t i = 0; i < hlen / 2; i++) {
+		unsigned int byte;
+
+		if (sscanf(hex + 2 * i, "%2x", &byte) != 1)
+			return -1;
+		mem[i] = (uint8_t) byte;
+	}
+	*len = hlen / 2;
+
+	return 0;
+}
+
+/* must be called with cache_lock held */
+static void oval_digest_cache_load(const char *path)
+{
+	struct oval_digest_file file;
+	struct stat st;
+	char *line = NULL;
+	size_t line_size = 0;
+	FILE *fp;
+	int fd;
+
+	digest_table = oscap_htable_new1(strcmp, OVAL_DIGEST_CACHE_HSIZE);
+	cache_path = strdup(path);
+	if (digest_table == NULL || cache_path == NULL)
+		return;
+
+	fd = open(path, O_RDONLY | O_NOFOLLOW);
+	if (fd == -1) {
+		if (errno != ENOENT)
+			dW("Can't open the digest cache '%s': %s.", path, strerror(errno));
+		return;
+	}
+	/* digests anybody else can write to would make the scan worthless */
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_uid != geteuid()
+	    || (st.st_mode & (S_IWGRP | S_IWOTH)) != 0) {
+		dW("Ignoring the digest cache '%s', it's not a regular file "
+		   "writable only by its owner.", path);
+		close(fd);
+		return;
+	}
+	fp = fdopen(fd, "r");
+	if (fp == NULL) {
+		close(fd);
+		return;
+	}
+
+	if (getline(&line, &line_size, fp) == -1
+	    || strncmp(line, OVAL_DIGEST_CACHE_MAGIC "\n", sizeof(OVAL_DIGEST_CACHE_MAGIC)) != 0) {
+		dW("Ignoring the digest cache '%s' of an unknown format.", path);
+		goto cleanup;
+	}
+
+	while (getline(&line, &line_size, fp) != -1) {
+		struct oval_digest_entry *entry;
+		char key[160], hex[2 * OVAL_DIGEST_MAX_LEN + 1];
+		unsigned int alg;
+		unsigned long day;
+
+		if (sscanf(line, "%ju %ju %jd %jd.%ld %jd.%ld %u %lu %128s",
+		           &file.dev, &file.ino, &file.size, &file.mtime, &file.mtime_nsec,
+		           &file.ctime, &file.ctime_nsec, &alg, &day, hex) != 10)
+			continue;
+
+		entry = malloc(sizeof(struct oval_digest_entry));
+		if (entry == NULL)
+			break;
+		entry->day = day;
+		if (oval_digest_hex2mem(hex, entry->digest, &entry->len) != 0) {
+			free(entry);
+			continue;
+		}
+		oval_digest_key(key, sizeof(key), &file, alg);
+		if (!oscap_htable_add(digest_table, key, entry))
+			free(entry);
+	}
+	dI("Loaded %zu digests from the digest cache '%s'.",
+	   oscap_htable_itemcount(digest_table), path);
+
+cleanup:
+	free(line);
+	fclose(fp);
+}
+
+/* must be called with cache_lock held */
+static int oval_digest_cache_save(void)
+{
+	struct oscap_htable_iterator *hit;
+	unsigned long today = oval_digest_cache_today();
+	char *tmp_path, *dir_copy;
+	FILE *fp;
+	int fd;
+
+	tmp_path = malloc(strlen(cache_path) + sizeof(".XXXXXX"));
+	if (tmp_path == NULL)
+		return -1;
+	sprintf(tmp_path, "%s.XXXXXX", cache_path);
+
+	/* the directory of the cache file, e.g. /var/cache/openscap */
+	dir_copy = strdup(cache_path);
+	if (dir_copy != NULL) {
+		if (mkdir(dirname(dir_copy), 0700) != 0 && errno != EEXIST)
+			dW("Can't create the directory of the digest cache '%s': %s.",
+			   cache_path, strerror(errno));
+		free(dir_copy);
+	}
+
+	fd = mkstemp(tmp_path);
+	if (fd == -1) {
+		dW("Can't write the digest cache '%s': %s.", cache_path, strerror(errno));
+		free(tmp_path);
+		return -1;
+	}
+	fp = fdopen(fd, "w");
+	if (fp == NULL) {
+		close(fd);
+		unlink(tmp_path);
+		free(tmp_path);
+		return -1;
+	}
+
+	fprintf(fp, OVAL_DIGEST_CACHE_MAGIC "\n");
+	hit = oscap_htable_iterator_new(digest_table);
+	while (oscap_htable_iterator_has_more(hit)) {
+		const char *key;
+		struct oval_digest_entry *entry;
+
+		oscap_htable_iterator_next_kv(hit, &key, (void **) &entry);
+		if (entry == NULL || entry->day + OVAL_DIGEST_CACHE_EXPIRE < today)
+			continue;
+		/* the key is the leading part of the line */
+		fprintf(fp, "%s %lu ", key, entry->day);
+		for (size_t i = 0; i < entry->len; i++)
+			fprintf(fp, "%02x", entry->digest[i]);
+		fputc('\n', fp);
+	}
+	oscap_htable_iterator_free(hit);
+
+	if (fflush(fp) != 0 || fsync(fd) != 0 || ferror(fp)) {
+		dW("Can't write the digest cache '%s': %s.", cache_path, strerror(errno));
+		fclose(fp);
+		unlink(tmp_path);
+		free(tmp_path);
+		return -1;
+	}
+	fclose(fp);
+
+	if (rename(tmp_path, cache_path) != 0) {
+		dW("Can't replace the digest cache '%s': %s.", cache_path, strerror(errno));
+		unlink(tmp_path);
+		free(tmp_path);
+		return -1;
+	}
+	free(tmp_path);
+
+	return 0;
+}
+
+bool oval_digest_cache_enabled(void)
+{
+	const char *path = getenv("OSCAP_DIGEST_CACHE");
+
+	return path != NULL && *path != '\0';
+}
+
+int oval_digest_cache_fdv(int fd, int num, const crapi_alg_t *alg, void **dst, size_t **size)
+{
+	struct oval_digest_file file;
+	struct stat st;
+	char keys[OVAL_DIGEST_MAX_ALGS][160];
+	crapi_alg_t miss_alg[OVAL_DIGEST_MAX_ALGS];
+	void *miss_dst[OVAL_DIGEST_MAX_ALGS];
+	size_t *miss_size[OVAL_DIGEST_MAX_ALGS];
+	int miss_idx[OVAL_DIGEST_MAX_ALGS];
+	int misses = 0;
+	unsigned long today;
+	bool racy;
+
+	if (!oval_digest_cache_enabled() || num <= 0 || num > OVAL_DIGEST_MAX_ALGS)
+		return crapi_mdigest_fdv(fd, num, alg, dst, size);
+	/* the metadata of the open file, it can't be replaced meanwhile */
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+		return crapi_mdigest_fdv(fd, num, alg, dst, size);
+
+	file.dev = (uintmax_t) st.st_dev;
+	file.ino = (uintmax_t) st.st_ino;
+	file.size = (intmax_t) st.st_size;
+	file.mtime = (intmax_t) st.st_mtime;
+	file.mtime_nsec = (long) OVAL_DIGEST_MTIME_NSEC(&st);
+	file.ctime = (intmax_t) st.st_ctime;
+	file.ctime_nsec = (long) OVAL_DIGEST_CTIME_NSEC(&st);
+	today = oval_digest_cache_today();
+
+	pthread_mutex_lock(&cache_lock);
+	if (digest_table == NULL)
+		oval_digest_cache_load(getenv("OSCAP_DIGEST_CACHE"));
+	for (int i = 0; i < num; i++) {
+		struct oval_digest_entry *entry = NULL;
+
+		oval_digest_key(keys[i], sizeof(keys[i]), &file, (unsigned int) alg[i]);
+		if (digest_table != NULL)
+			entry = oscap_htable_get(digest_table, keys[i]);
+		if (entry != NULL && entry->len <= *size[i]) {
+			memcpy(dst[i], entry->digest, entry->len);
+			*size[i] = entry->len;
+			if (entry->day != today) {
+				entry->day = today;
+				cache_dirty = true;
+			}
+			continue;
+		}
+		miss_alg[misses] = alg[i];
+		miss_dst[misses] = dst[i];
+		miss_size[misses] = size[i];
+		miss_idx[misses] = i;
+		misses++;
+	}
+	pthread_mutex_unlock(&cache_lock);
+
+	if (misses == 0)
+		return 0;
+	if (crapi_mdigest_fdv(fd, misses, miss_alg, miss_dst, miss_size) != 0)
+		return -1;
+
+	racy = (intmax_t) time(NULL) - OVAL_DIGEST_CACHE_RACY < (file.ctime > file.mtime ? file.ctime : file.mtime);
+	if (racy)
+		return 0;
+	/* the file was written to while it was read */
+	if (fstat(fd, &st) != 0 || (intmax_t) st.st_size != file.size
+	    || (intmax_t) st.st_mtime != file.mtime || (long) OVAL_DIGEST_MTIME_NSEC(&st) != file.mtime_nsec
+	    || (intmax_t) st.st_ctime != file.ctime || (long) OVAL_DIGEST_CTIME_NSEC(&st) != file.ctime_nsec)
+		return 0;
+
+	pthread_mutex_lock(&cache_lock);
+	for (int i = 0; i < misses && digest_table != NULL; i++) {
+		struct oval_digest_entry *entry;
+
+		if (*miss_size[i] == 0 || *miss_size[i] > OVAL_DIGEST_MAX_LEN)
+			continue;
+		entry = oscap_htable_get(digest_table, keys[miss_idx[i]]);
+		if (entry == NULL) {
+			entry = malloc(sizeof(struct oval_digest_entry));
+			if (entry == NULL)
+				break;
+			if (!oscap_htable_add(digest_table, keys[miss_idx[i]], entry)) {
+				free(entry);
+				continue;
+			}
+		}
+		entry->day = today;
+		entry->len = *miss_size[i];
+		memcpy(entry->digest, miss_dst[i], entry->len);
+		cache_dirty = true;
+	}
+	pthread_mutex_unlock(&cache_lock);
+
+	return 0;
+}
+
+void oval_digest_cache_flush(void)
+{
+	pthread_mutex_lock(&cache_lock);
+	if (digest_table != NULL && cache_path != NULL && cache_dirty)
+		(void) oval_digest_cache_save();
+	oscap_htable_free(digest_table, free);
+	digest_table = NULL;
+	free(cache_path);
+	cache_path = NULL;
+	cache_dirty = false;
+	pthread_mutex_unlock(&cache_lock);
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+#ifndef OVAL_DIGEST_CACHE_H
+#define OVAL_DIGEST_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "crapi/digest.h"
+
+/*
+ * Persistent cache of file digests used by the probes hashing files
+ * (filehash58, filehash, filemd5, rpmverifyfile). It is enabled by setting
+ * OSCAP_DIGEST_CACHE to the path of the cache file. A digest is reused
+ * when the device, inode, size, modification and change time of the file
+ * are the same as when it was computed, so a rescan of unchanged files
+ * only reads their metadata. The cache file is loaded on the first use and
+ * written back when the probe session ends.
+ */
+
+/**
+ * Whether the digest cache is enabled by OSCAP_DIGEST_CACHE.
+ */
+bool oval_digest_cache_enabled(void);
+
+/**
+ * Compute digests of an open regular file like crapi_mdigest_fdv, digests
+ * stored in the cache for the file are not computed again.
+ * @return 0 on success, -1 on failure (errno is set)
+ */
+int oval_digest_cache_fdv(int fd, int num, const crapi_alg_t *alg, void **dst, size_t **size);
+
+/**
+ * Write the cache file if the cache changed and drop the loaded entries.
+ */
+void oval_digest_cache_flush(void);
+
+#endif /* OVAL_DIGEST_CACHE_H */
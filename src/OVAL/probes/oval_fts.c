@@ -31,7 +31,10 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <limits.h>
+#include <ctype.h>
 #include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
 #include <pcre.h>
 
 #include "oscap_helpers.h"
@@ -40,6 +43,13 @@
 #include "probe/entcmp.h"
 #include "debug_priv.h"
 #include "oval_fts.h"
+#include "oval_fts_cache.h"
+#include "oval_throttle.h"
+#include "oval_deadline.h"
+#include "oval_glob.h"
+#include "common/oscap_threadpool.h"
+#include "common/stats_priv.h"
+#include "common/trace_priv.h"
 #if defined(OS_SOLARIS)
 #include "fts_sun.h"
 #include <sys/mntent.h>
@@ -53,6 +63,13 @@
 
 #undef OSCAP_FTS_DEBUG
 
+/* upper bound of the threads of one parallel walk */
+#define OVAL_FTS_PWALK_MAX_THREADS 16
+
+static size_t oval_fts_pwalk_jobs(void);
+static void oval_fts_pwalk_free(struct oval_fts_pwalk *pwalk);
+static void oval_fts_literal_free(struct oval_fts_literal *lit);
+
 static OVAL_FTS *OVAL_FTS_new()
 {
 	OVAL_FTS *ofts = calloc(1, sizeof(OVAL_FTS));
@@ -60,6 +77,7 @@ static OVAL_FTS *OVAL_FTS_new()
 	ofts->max_depth  = -1;
 	ofts->direction  = -1;
 	ofts->filesystem = -1;
+	pthread_mutex_init(&ofts->localdevs_lock, NULL);
 
 	return (ofts);
 }
@@ -70,6 +88,13 @@ static void OVAL_FTS_free(OVAL_FTS *ofts)
 		fts_close(ofts->ofts_match_path_fts);
 	if (ofts->ofts_recurse_path_fts != NULL)
 		fts_close(ofts->ofts_recurse_path_fts);
+	oval_fts_cache_dir_release(ofts->ofts_recurse_path_dir);
+	oval_fts_pwalk_free(ofts->ofts_recurse_path_pwalk);
+	oval_fts_literal_free(ofts->ofts_spath_lit);
+	oval_fts_literal_free(ofts->ofts_sfilename_lit);
+	oval_glob_free(ofts->ofts_path_glob);
+	oval_glob_free(ofts->ofts_sfilename_glob);
+	pthread_mutex_destroy(&ofts->localdevs_lock);
 
 	free(ofts);
 	return;
@@ -90,11 +115,12 @@ static int pathlen_from_ftse(int fts_pathlen, int fts_namelen)
 	return pathlen;
 }
 
-static OVAL_FTSENT *OVAL_FTSENT_new(OVAL_FTS *ofts, FTSENT *fts_ent)
+static OVAL_FTSENT *OVAL_FTSENT_new_path(OVAL_FTS *ofts, const char *fts_path, int fts_pathlen,
+                                         const char *fts_name, int fts_namelen, unsigned int fts_info)
 {
 	OVAL_FTSENT *ofts_ent = calloc(1, sizeof(OVAL_FTSENT));
 
-	ofts_ent->fts_info = fts_ent->fts_info;
+	ofts_ent->fts_info = fts_info;
 	/* The 'shift' variable stores length of the prefix if the prefix
 	 * is defined, otherwise it is set to 0. The value of 'shift' gives
 	 * us information how many characters of the path string are part of
@@ -103,22 +129,22 @@ static OVAL_FTSENT *OVAL_FTSENT_new(OVAL_FTS *ofts, FTSENT *fts_ent)
 	 */
 	const size_t shift = ofts->prefix ? strlen(ofts->prefix) : 0;
 	if (ofts->ofts_sfilename || ofts->ofts_sfilepath) {
-		ofts_ent->path_len = pathlen_from_ftse(fts_ent->fts_pathlen, fts_ent->fts_namelen) - shift;
+		ofts_ent->path_len = pathlen_from_ftse(fts_pathlen, fts_namelen) - shift;
 		if (ofts_ent->path_len > 0) {
 			ofts_ent->path = malloc(ofts_ent->path_len + 1);
-			strncpy(ofts_ent->path, fts_ent->fts_path + shift, ofts_ent->path_len);
+			strncpy(ofts_ent->path, fts_path + shift, ofts_ent->path_len);
 			ofts_ent->path[ofts_ent->path_len] = '\0';
 		} else {
 			ofts_ent->path_len = 1;
 			ofts_ent->path = strdup("/");
 		}
 
-		ofts_ent->file_len = fts_ent->fts_namelen;
-		ofts_ent->file = strdup(fts_ent->fts_name);
+		ofts_ent->file_len = fts_namelen;
+		ofts_ent->file = strdup(fts_name);
 	} else {
-		ofts_ent->path_len = fts_ent->fts_pathlen - shift;
+		ofts_ent->path_len = fts_pathlen - shift;
 		if (ofts_ent->path_len > 0) {
-			ofts_ent->path = strdup(fts_ent->fts_path + shift);
+			ofts_ent->path = strdup(fts_path + shift);
 		} else {
 			ofts_ent->path_len = 1;
 			ofts_ent->path = strdup("/");
@@ -134,6 +160,12 @@ static OVAL_FTSENT *OVAL_FTSENT_new(OVAL_FTS *ofts, FTSENT *fts_ent)
 	return (ofts_ent);
 }
 
+static OVAL_FTSENT *OVAL_FTSENT_new(OVAL_FTS *ofts, FTSENT *fts_ent)
+{
+	return OVAL_FTSENT_new_path(ofts, fts_ent->fts_path, fts_ent->fts_pathlen,
+	                            fts_ent->fts_name, fts_ent->fts_namelen, fts_ent->fts_info);
+}
+
 static void OVAL_FTSENT_free(OVAL_FTSENT *ofts_ent)
 {
 	free(ofts_ent->path);
@@ -295,9 +327,29 @@ static bool OVAL_FTS_localp(OVAL_FTS *ofts, const char *path, void *id)
 		return (false);
 	}
 #else
-	if (id != NULL)
-		return (fsdev_search(ofts->localdevs, id) == 1 ? true : false);
-	else if (path != NULL)
+	if (id != NULL) {
+		dev_t dev = *(dev_t *)id;
+		bool local;
+
+		/* most walks stay on a handful of devices, remember them */
+		pthread_mutex_lock(&ofts->localdevs_lock);
+		for (size_t i = 0; i < ofts->localdevs_memo_cnt; i++) {
+			if (ofts->localdevs_memo[i].dev == dev) {
+				local = ofts->localdevs_memo[i].local;
+				pthread_mutex_unlock(&ofts->localdevs_lock);
+				return local;
+			}
+		}
+		local = fsdev_search(ofts->localdevs, id) == 1;
+		if (ofts->localdevs_memo_cnt < OVAL_FTS_LOCALDEVS_MEMO) {
+			ofts->localdevs_memo[ofts->localdevs_memo_cnt].dev = dev;
+			ofts->localdevs_memo[ofts->localdevs_memo_cnt].local = local;
+			ofts->localdevs_memo_cnt++;
+		}
+		pthread_mutex_unlock(&ofts->localdevs_lock);
+
+		return local;
+	} else if (path != NULL)
 		return (fsdev_path(ofts->localdevs, path) == 1 ? true : false);
 	else
 		return (false);
@@ -660,6 +712,449 @@ static int process_pattern_match(const char *path, pcre **regex_out)
 #undef TEST_PATH1
 #undef TEST_PATH2
 
+/*
+ * Literal parts of a pattern which every matching string has to contain.
+ * They are checked with memcmp/memchr before the string is handed over
+ * to PCRE, most of the names met during a walk are rejected by them.
+ */
+struct oval_fts_literal {
+	char *prefix;
+	size_t prefix_len;
+	char *suffix;
+	size_t suffix_len;
+	char *infix;
+	size_t infix_len;
+};
+
+struct oval_fts_literal_tok {
+	char c;
+	bool literal;
+};
+
+/* skip a character class, return a pointer past its closing bracket */
+static const char *oval_fts_literal_skip_class(const char *p)
+{
+	p++; /* '[' */
+	if (*p == '^')
+		p++;
+	if (*p == ']')
+		p++;
+	while (*p != '\0' && *p != ']') {
+		if (*p == '\\' && p[1] != '\0') {
+			p += 2;
+		} else if (*p == '[' && p[1] == ':') {
+			const char *end = strstr(p + 2, ":]");
+
+			if (end == NULL)
+				return NULL;
+			p = end + 2;
+		} else {
+			p++;
+		}
+	}
+
+	return *p == ']' ? p + 1 : NULL;
+}
+
+/* skip a group, return a pointer past its closing parenthesis */
+static const char *oval_fts_literal_skip_group(const char *p)
+{
+	int depth = 0;
+
+	while (*p != '\0') {
+		switch (*p) {
+		case '\\':
+			if (p[1] == '\0')
+				return NULL;
+			p += 2;
+			continue;
+		case '[':
+			p = oval_fts_literal_skip_class(p);
+			if (p == NULL)
+				return NULL;
+			continue;
+		case '(':
+			depth++;
+			break;
+		case ')':
+			if (--depth == 0)
+				return p + 1;
+			break;
+		}
+		p++;
+	}
+
+	return NULL;
+}
+
+/* {n}, {n,} or {n,m}, anything else is taken literally by PCRE */
+static const char *oval_fts_literal_skip_quantifier(const char *p)
+{
+	const char *q = p + 1;
+
+	if (!isdigit((unsigned char)*q))
+		return NULL;
+	while (isdigit((unsigned char)*q))
+		q++;
+	if (*q == ',') {
+		q++;
+		while (isdigit((unsigned char)*q))
+			q++;
+	}
+
+	return *q == '}' ? q + 1 : NULL;
+}
+
+static char *oval_fts_literal_run(const struct oval_fts_literal_tok *toks, size_t start, size_t len)
+{
+	char *run = malloc(len + 1);
+
+	if (run == NULL)
+		return NULL;
+	for (size_t i = 0; i < len; i++)
+		run[i] = toks[start + i].c;
+	run[len] = '\0';
+
+	return run;
+}
+
+/*
+ * Split the top level of the pattern into single characters and other
+ * atoms, a character is required if it isn't quantified. Anything that
+ * could change how the characters are matched (alternation, inline
+ * options, escapes with arguments, non-ASCII input) makes the analysis
+ * give up and the pattern is left to PCRE alone.
+ */
+static struct oval_fts_literal *oval_fts_literal_new(const char *pattern)
+{
+	struct oval_fts_literal_tok *toks;
+	struct oval_fts_literal *lit;
+	const char *p = pattern;
+	size_t cnt = 0, run_start, run_len, best_start = 0, best_len = 0;
+	bool anchored_start = false, anchored_end = false;
+
+	toks = malloc((strlen(pattern) + 1) * sizeof(struct oval_fts_literal_tok));
+	if (toks == NULL)
+		return NULL;
+
+	if (*p == '^') {
+		anchored_start = true;
+		p++;
+	}
+
+	while (*p != '\0') {
+		const char *next;
+
+		if ((unsigned char)*p >= 0x80)
+			goto fail;
+
+		switch (*p) {
+		case '\\':
+			if (p[1] == '\0' || (unsigned char)p[1] >= 0x80)
+				goto fail;
+			if (isalnum((unsigned char)p[1])) {
+				/* classes, assertions and single character escapes */
+				if (strchr("dDwWsShHvVRXbBAzZGKnrtfea", p[1]) == NULL)
+					goto fail;
+				toks[cnt].literal = false;
+			} else {
+				toks[cnt].c = p[1];
+				toks[cnt].literal = true;
+			}
+			cnt++;
+			p += 2;
+			break;
+		case '[':
+			p = oval_fts_literal_skip_class(p);
+			if (p == NULL)
+				goto fail;
+			toks[cnt++].literal = false;
+			break;
+		case '(':
+			/* inline options apply to the rest of the pattern */
+			if (p[1] == '?' && (isalpha((unsigned char)p[2]) || p[2] == '-' || p[2] == '^' || p[2] == ')'))
+				goto fail;
+			p = oval_fts_literal_skip_group(p);
+			if (p == NULL)
+				goto fail;
+			toks[cnt++].literal = false;
+			break;
+		case '|':
+		case ')':
+			goto fail;
+		case '*':
+		case '+':
+		case '?':
+		case '{':
+			next = *p == '{' ? oval_fts_literal_skip_quantifier(p) : p + 1;
+			if (next == NULL) {
+				/* a literal brace, it still may quantify nothing */
+				next = p + 1;
+			} else if (*next == '?' || *next == '+') {
+				next++; /* lazy or possessive */
+			}
+			if (cnt > 0)
+				toks[cnt - 1].literal = false;
+			toks[cnt++].literal = false;
+			p = next;
+			break;
+		case '$':
+			if (p[1] == '\0') {
+				anchored_end = true;
+				p++;
+				break;
+			}
+			/* fall through */
+		case '.':
+		case '^':
+			toks[cnt++].literal = false;
+			p++;
+			break;
+		default:
+			toks[cnt].c = *p;
+			toks[cnt].literal = true;
+			cnt++;
+			p++;
+		}
+	}
+
+	lit = calloc(1, sizeof(struct oval_fts_literal));
+	if (lit == NULL)
+		goto fail;
+
+	if (anchored_start) {
+		while (lit->prefix_len < cnt && toks[lit->prefix_len].literal)
+			lit->prefix_len++;
+		if (lit->prefix_len > 0)
+			lit->prefix = oval_fts_literal_run(toks, 0, lit->prefix_len);
+	}
+	if (anchored_end) {
+		while (lit->suffix_len < cnt && toks[cnt - lit->suffix_len - 1].literal)
+			lit->suffix_len++;
+		if (lit->suffix_len > 0)
+			lit->suffix = oval_fts_literal_run(toks, cnt - lit->suffix_len, lit->suffix_len);
+	}
+
+	/* the longest run of required characters not covered by the above */
+	for (run_start = 0; run_start < cnt; run_start += run_len + 1) {
+		for (run_len = 0; run_start + run_len < cnt && toks[run_start + run_len].literal; run_len++)
+			;
+		if (run_len > best_len) {
+			best_start = run_start;
+			best_len = run_len;
+		}
+	}
+	if (best_len > 0
+	    && !(anchored_start && best_start == 0)
+	    && !(anchored_end && best_start + best_len == cnt)) {
+		lit->infix_len = best_len;
+		lit->infix = oval_fts_literal_run(toks, best_start, best_len);
+	}
+
+	free(toks);
+
+	if ((lit->prefix_len > 0 && lit->prefix == NULL)
+	    || (lit->suffix_len > 0 && lit->suffix == NULL)
+	    || (lit->infix_len > 0 && lit->infix == NULL)
+	    || (lit->prefix_len == 0 && lit->suffix_len == 0 && lit->infix_len == 0)) {
+		oval_fts_literal_free(lit);
+		return NULL;
+	}
+
+	return lit;
+fail:
+	free(toks);
+	return NULL;
+}
+
+static void oval_fts_literal_free(struct oval_fts_literal *lit)
+{
+	if (lit == NULL)
+		return;
+	free(lit->prefix);
+	free(lit->suffix);
+	free(lit->infix);
+	free(lit);
+}
+
+/* find the literal with memchr() for its first character */
+static bool oval_fts_literal_find(const char *str, size_t len, const char *needle, size_t needle_len)
+{
+	const char *end = str + len - needle_len + 1;
+	const char *p = str;
+
+	if (len < needle_len)
+		return false;
+	while (p < end && (p = memchr(p, needle[0], end - p)) != NULL) {
+		if (memcmp(p, needle, needle_len) == 0)
+			return true;
+		p++;
+	}
+
+	return false;
+}
+
+/* true if the string can't match the pattern the literals come from */
+static bool oval_fts_literal_reject(const struct oval_fts_literal *lit, const char *str, size_t len)
+{
+	if (lit == NULL)
+		return false;
+
+	if (lit->prefix_len > 0
+	    && (len < lit->prefix_len || memcmp(str, lit->prefix, lit->prefix_len) != 0))
+		return true;
+
+	if (lit->suffix_len > 0) {
+		/* '$' matches also before a newline at the end */
+		if (len > 0 && str[len - 1] == '\n'
+		    && !(len > lit->suffix_len && str[len - lit->suffix_len - 1] == '\n'
+		         && memcmp(str + len - lit->suffix_len, lit->suffix, lit->suffix_len) == 0))
+			len--;
+		if (len < lit->suffix_len || memcmp(str + len - lit->suffix_len, lit->suffix, lit->suffix_len) != 0)
+			return true;
+	}
+
+	if (lit->infix_len > 0 && !oval_fts_literal_find(str, len, lit->infix, lit->infix_len))
+		return true;
+
+	return false;
+}
+
+/*
+ * Get the pattern of an entity compared by a single pattern, so that the
+ * result of the pattern is the result of the entity. Entities referencing
+ * variables with several values are left to probe_entobj_cmp().
+ */
+static bool oval_fts_ent_pattern(SEXP_t *ent, char *pattern, size_t size)
+{
+	SEXP_t *r0;
+
+	if (ent == NULL)
+		return false;
+
+	r0 = probe_ent_getattrval(ent, "operation");
+	if (r0 == NULL)
+		return false;
+	if (SEXP_number_getu(r0) != OVAL_OPERATION_PATTERN_MATCH) {
+		SEXP_free(r0);
+		return false;
+	}
+	SEXP_free(r0);
+
+	if (probe_ent_getvals(ent, NULL) != 1)
+		return false;
+	r0 = probe_ent_getattrval(ent, "var_check");
+	if (r0 != NULL) {
+		oval_check_t ochk = SEXP_number_geti_32(r0);
+
+		SEXP_free(r0);
+		if (ochk != OVAL_CHECK_ALL && ochk != OVAL_CHECK_AT_LEAST_ONE && ochk != OVAL_CHECK_ONLY_ONE)
+			return false;
+	}
+	r0 = probe_ent_getval(ent);
+	if (r0 == NULL)
+		return false;
+	if (!SEXP_stringp(r0) || SEXP_string_cstr_r(r0, pattern, size) == (size_t)-1) {
+		SEXP_free(r0);
+		return false;
+	}
+	SEXP_free(r0);
+
+	return true;
+}
+
+/* Build the prefilter for an entity compared by a single pattern */
+static struct oval_fts_literal *oval_fts_literal_from_ent(SEXP_t *ent)
+{
+	char pattern[PATH_MAX + 1];
+	struct oval_fts_literal *lit;
+	const char *errptr;
+	int errofs;
+	pcre *regex;
+
+	if (!oval_fts_ent_pattern(ent, pattern, sizeof(pattern)))
+		return NULL;
+
+	/* invalid patterns have to be reported by the comparison */
+	regex = pcre_compile(pattern, PCRE_UTF8, &errptr, &errofs, NULL);
+	if (regex == NULL)
+		return NULL;
+	pcre_free(regex);
+
+	lit = oval_fts_literal_new(pattern);
+#if defined(OSCAP_FTS_DEBUG)
+	if (lit != NULL)
+		dD("pattern '%s', prefix '%s', suffix '%s', infix '%s'.", pattern,
+		   lit->prefix ? lit->prefix : "", lit->suffix ? lit->suffix : "",
+		   lit->infix ? lit->infix : "");
+#endif
+	return lit;
+}
+
+/* Compile the glob of an entity compared by a single pattern made of one */
+static struct oval_glob *oval_fts_glob_from_ent(SEXP_t *ent)
+{
+	char pattern[PATH_MAX + 1];
+	struct oval_glob *glob;
+
+	if (!oval_fts_ent_pattern(ent, pattern, sizeof(pattern)))
+		return NULL;
+
+	glob = oval_glob_from_regex(pattern);
+#if defined(OSCAP_FTS_DEBUG)
+	if (glob != NULL)
+		dD("pattern '%s' is matched as a glob.", pattern);
+#endif
+	return glob;
+}
+
+/* compare a path with the path or filepath entity */
+static oval_result_t oval_fts_cmp_path(OVAL_FTS *ofts, const char *path, size_t len)
+{
+	oval_result_t result;
+	SEXP_t *stmp;
+
+	if (ofts->ofts_path_glob != NULL) {
+		int match = oval_glob_match(ofts->ofts_path_glob, path, len);
+
+		if (match >= 0)
+			return match ? OVAL_RESULT_TRUE : OVAL_RESULT_FALSE;
+	} else if (oval_fts_literal_reject(ofts->ofts_spath_lit, path, len)) {
+		return OVAL_RESULT_FALSE;
+	}
+
+	stmp = SEXP_string_newf("%s", path);
+	if (ofts->ofts_sfilepath)
+		result = probe_entobj_cmp(ofts->ofts_sfilepath, stmp);
+	else
+		result = probe_entobj_cmp(ofts->ofts_spath, stmp);
+	SEXP_free(stmp);
+
+	return result;
+}
+
+/* compare a name with the filename entity, prefiltered by its literals */
+static oval_result_t oval_fts_cmp_filename(OVAL_FTS *ofts, const char *name)
+{
+	oval_result_t result;
+	SEXP_t *stmp;
+
+	if (ofts->ofts_sfilename_glob != NULL) {
+		int match = oval_glob_match(ofts->ofts_sfilename_glob, name, strlen(name));
+
+		if (match >= 0)
+			return match ? OVAL_RESULT_TRUE : OVAL_RESULT_FALSE;
+	} else if (oval_fts_literal_reject(ofts->ofts_sfilename_lit, name, strlen(name))) {
+		return OVAL_RESULT_FALSE;
+	}
+
+	stmp = SEXP_string_newf("%s", name);
+	result = probe_entobj_cmp(ofts->ofts_sfilename, stmp);
+	SEXP_free(stmp);
+
+	return result;
+}
+
 OVAL_FTS *oval_fts_open(SEXP_t *path, SEXP_t *filename, SEXP_t *filepath, SEXP_t *behaviors, SEXP_t* result)
 {
 	return oval_fts_open_prefixed(NULL, path, filename, filepath, behaviors, result);
@@ -839,7 +1334,7 @@ OVAL_FTS *oval_fts_open_prefixed(const char *prefix, SEXP_t *path, SEXP_t *filen
 	dI("Opening file '%s'.", paths[0]);
 	/* Fail if the provided path doensn't actually exist. Symlinks
 	   without targets are accepted. */
-	if (lstat(paths[0], &st) == -1) {
+	if (oval_fts_cache_lstat(paths[0], &st) == -1) {
 		if (errno) {
 			dD("lstat() failed: errno: %d, '%s'.",
 			   errno, strerror(errno));
@@ -867,20 +1362,27 @@ OVAL_FTS *oval_fts_open_prefixed(const char *prefix, SEXP_t *path, SEXP_t *filen
 
 	ofts->ofts_recurse_path_fts_opts = rec_fts_options;
 	ofts->ofts_path_op = path_op;
-	if (regex != NULL) {
-		const char *errptr = NULL;
-
+	/* a pattern made of a glob is matched without PCRE */
+	ofts->ofts_path_glob = oval_fts_glob_from_ent(path != NULL ? path : filepath);
+	if (ofts->ofts_path_glob != NULL) {
+		pcre_free(regex);
+	} else if (regex != NULL) {
 		ofts->ofts_path_regex = regex;
-		ofts->ofts_path_regex_extra = pcre_study(regex, 0, &errptr);
+		/* the directories are matched partially */
+#if defined(PCRE_STUDY_JIT_PARTIAL_SOFT_COMPILE)
+		ofts->ofts_path_regex_extra = oscap_pcre_study(regex, PCRE_STUDY_JIT_PARTIAL_SOFT_COMPILE);
+#else
+		ofts->ofts_path_regex_extra = oscap_pcre_study(regex, 0);
+#endif
 	}
 
 	if (filesystem == OVAL_RECURSE_FS_LOCAL) {
 #if defined(OS_SOLARIS)
 		ofts->localdevs = NULL;
 #else
-		ofts->localdevs = fsdev_init();
+		ofts->localdevs = fsdev_get();
 		if (ofts->localdevs == NULL) {
-			dE("fsdev_init() failed.");
+			dE("fsdev_get() failed.");
 			/* One dummy read to get rid of an uninitialized
 			 * value in the FTS data before calling
 			 * fts_close() on it. */
@@ -902,16 +1404,38 @@ OVAL_FTS *oval_fts_open_prefixed(const char *prefix, SEXP_t *path, SEXP_t *filen
 
 	ofts->recurse = recurse;
 	ofts->filesystem = filesystem;
+#if !defined(OS_SOLARIS)
+	/* Looking for files in a directory without recursion is answered
+	   from the directory listing kept in the metadata cache, the other
+	   probes looking into the same directory won't read it again. */
+	ofts->ofts_recurse_path_cached = (path != NULL && !nilfilename
+		&& direction == OVAL_RECURSE_DIRECTION_NONE
+		&& filesystem == OVAL_RECURSE_FS_ALL);
+#endif
+#if !defined(OS_SOLARIS) && !defined(OS_AIX)
+	/* Walks down are split among several threads and share the directory
+	   listings with the other objects walking the same subtree. */
+	ofts->ofts_recurse_path_parallel = (path != NULL
+		&& direction == OVAL_RECURSE_DIRECTION_DOWN && max_depth != 0);
+#endif
 
 	if (path) { /* filepath == NULL */
 		ofts->ofts_spath = SEXP_ref(path); /* path entity */
-		if (!nilfilename)
+		if (ofts->ofts_path_glob == NULL)
+			ofts->ofts_spath_lit = oval_fts_literal_from_ent(path);
+		if (!nilfilename) {
 			ofts->ofts_sfilename = SEXP_ref(filename); /* filename entity */
+			ofts->ofts_sfilename_glob = oval_fts_glob_from_ent(filename);
+			if (ofts->ofts_sfilename_glob == NULL)
+				ofts->ofts_sfilename_lit = oval_fts_literal_from_ent(filename);
+		}
 
 		ofts->max_depth = max_depth;
 		ofts->direction = direction;
 	} else { /* filepath != NULL */
 		ofts->ofts_sfilepath = SEXP_ref(filepath);
+		if (ofts->ofts_path_glob == NULL)
+			ofts->ofts_spath_lit = oval_fts_literal_from_ent(filepath);
 	}
 
 #if defined(OS_SOLARIS)
@@ -948,7 +1472,6 @@ static inline int _oval_fts_is_local(OVAL_FTS *ofts, FTSENT *fts_ent) {
 static FTSENT *oval_fts_read_match_path(OVAL_FTS *ofts)
 {
 	FTSENT *fts_ent = NULL;
-	SEXP_t *stmp;
 	oval_result_t ores;
 
 	/* iterate until a match is found or all elements have been traversed */
@@ -993,10 +1516,17 @@ static FTSENT *oval_fts_read_match_path(OVAL_FTS *ofts)
 		}
 
 		const size_t shift = ofts->prefix ? strlen(ofts->prefix) : 0;
+		/* the glob prunes the directories below which nothing can match */
+		if (ofts->ofts_path_glob != NULL && fts_ent->fts_info == FTS_D) {
+			if (!oval_glob_match_below(ofts->ofts_path_glob, fts_ent->fts_path + shift, fts_ent->fts_pathlen - shift))
+				fts_set(ofts->ofts_match_path_fts, fts_ent, FTS_SKIP);
+			if (oval_glob_match(ofts->ofts_path_glob, fts_ent->fts_path + shift, fts_ent->fts_pathlen - shift) == 0)
+				continue;
 		/* partial match optimization for OVAL_OPERATION_PATTERN_MATCH operation on path and filepath */
-		if (ofts->ofts_path_regex != NULL && fts_ent->fts_info == FTS_D) {
+		} else if (ofts->ofts_path_regex != NULL && fts_ent->fts_info == FTS_D) {
 			int ret, svec[3];
 
+			oscap_stats_add(OSCAP_STATS_REGEX_EXECUTIONS, 1);
 			ret = pcre_exec(ofts->ofts_path_regex, ofts->ofts_path_regex_extra,
 					fts_ent->fts_path+shift, fts_ent->fts_pathlen-shift, 0, PCRE_PARTIAL,
 					svec, sizeof(svec) / sizeof(svec[0]));
@@ -1020,15 +1550,8 @@ static FTSENT *oval_fts_read_match_path(OVAL_FTS *ofts)
 		    || (!ofts->ofts_sfilepath && fts_ent->fts_info != FTS_D))
 			continue;
 
-		stmp = SEXP_string_newf("%s", fts_ent->fts_path + shift);
-
-		if (ofts->ofts_sfilepath)
-			/* try to match filepath */
-			ores = probe_entobj_cmp(ofts->ofts_sfilepath, stmp);
-		else
-			/* try to match path */
-			ores = probe_entobj_cmp(ofts->ofts_spath, stmp);
-		SEXP_free(stmp);
+		/* try to match filepath or path */
+		ores = oval_fts_cmp_path(ofts, fts_ent->fts_path + shift, fts_ent->fts_pathlen - shift);
 
 		if (ores == OVAL_RESULT_TRUE)
 			break;
@@ -1112,6 +1635,9 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 		while (out_fts_ent == NULL) {
 			FTSENT *fts_ent;
 
+			if (oval_deadline_expired())
+				return NULL;
+
 			fts_ent = fts_read(ofts->ofts_recurse_path_fts);
 			if (fts_ent == NULL) {
 				fts_close(ofts->ofts_recurse_path_fts);
@@ -1143,10 +1669,7 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 					out_fts_ent = fts_ent;
 			} else {
 				if (fts_ent->fts_info != FTS_D) {
-					SEXP_t *stmp;
-
-					stmp = SEXP_string_newf("%s", fts_ent->fts_name);
-					oval_result_t result = probe_entobj_cmp(ofts->ofts_sfilename, stmp);
+					oval_result_t result = oval_fts_cmp_filename(ofts, fts_ent->fts_name);
 					switch (result){
 						case OVAL_RESULT_TRUE:
 							out_fts_ent = fts_ent;
@@ -1159,8 +1682,6 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 						default:
 							break;
 					}
-
-					SEXP_free(stmp);
 				}
 			}
 
@@ -1288,12 +1809,8 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 					}
 				} else {
 					if (fts_ent->fts_info != FTS_D && fts_ent->fts_info != FTS_DP && fts_ent->fts_info != FTS_DC) {
-						SEXP_t *stmp;
-
-						stmp = SEXP_string_newf("%s", fts_ent->fts_name);
-						if (probe_entobj_cmp(ofts->ofts_sfilename, stmp) == OVAL_RESULT_TRUE)
+						if (oval_fts_cmp_filename(ofts, fts_ent->fts_name) == OVAL_RESULT_TRUE)
 							out_fts_ent = fts_ent;
-						SEXP_free(stmp);
 					}
 				}
 
@@ -1328,7 +1845,545 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 	return out_fts_ent;
 }
 
-OVAL_FTSENT *oval_fts_read(OVAL_FTS *ofts)
+/* find the next matching file in the cached listing of the matched directory */
+static OVAL_FTSENT *oval_fts_read_recurse_cache(OVAL_FTS *ofts)
+{
+	const oval_fts_cache_dirent_t *dirent;
+	FTSENT *dir_ent = ofts->ofts_match_path_fts_ent;
+	char path[PATH_MAX];
+	int pathlen;
+
+	if (ofts->ofts_recurse_path_dir == NULL) {
+		ofts->ofts_recurse_path_dir = oval_fts_cache_dir_get(dir_ent->fts_path, false);
+		ofts->ofts_recurse_path_diridx = 0;
+		if (ofts->ofts_recurse_path_dir == NULL)
+			return NULL;
+	}
+
+	while ((dirent = oval_fts_cache_dir_entry(ofts->ofts_recurse_path_dir,
+	                                          ofts->ofts_recurse_path_diridx++)) != NULL) {
+		oval_result_t result;
+
+		if (dirent->fts_info == FTS_D)
+			continue;
+
+		result = oval_fts_cmp_filename(ofts, dirent->name);
+
+		if (result == OVAL_RESULT_ERROR)
+			probe_cobj_set_flag(ofts->result, SYSCHAR_FLAG_ERROR);
+		if (result != OVAL_RESULT_TRUE)
+			continue;
+
+		/* build the path the same way fts_read() does */
+		pathlen = dir_ent->fts_pathlen;
+		if (pathlen > 0 && dir_ent->fts_path[pathlen - 1] == '/')
+			pathlen--;
+		pathlen = snprintf(path, sizeof(path), "%.*s/%s", pathlen, dir_ent->fts_path, dirent->name);
+		if (pathlen >= (int) sizeof(path))
+			continue;
+
+		return OVAL_FTSENT_new_path(ofts, path, pathlen, dirent->name,
+		                            strlen(dirent->name), dirent->fts_info);
+	}
+
+	oval_fts_cache_dir_release(ofts->ofts_recurse_path_dir);
+	ofts->ofts_recurse_path_dir = NULL;
+
+	return NULL;
+}
+
+/*
+ * Parallel walk
+ *
+ * A recursive walk down is split by directories: the walker threads take
+ * directories from a shared stack, read them and push the subdirectories
+ * back, so big trees are traversed by several threads at once. Directories
+ * are listed through the metadata cache, so objects which differ only in
+ * the filename pattern read the shared subtree once per scan and each of
+ * them tests its own patterns on the entries. The walk applies the same
+ * rules as the fts based walk in oval_fts_read_recurse_path(). Matches are
+ * returned either as they are found (OSCAP_FTS_ORDER=unsorted) or sorted
+ * by path once the walk is over, which is the default as it keeps the
+ * results reproducible.
+ */
+
+struct oval_fts_pwalk_id {
+	dev_t dev;
+	ino_t ino;
+};
+
+struct oval_fts_pwalk_dir {
+	char *path;
+	int level;
+	/* directories on the way from the walk root, for cycle detection */
+	struct oval_fts_pwalk_id *ancestors;
+	size_t ancestors_count;
+	struct oval_fts_pwalk_dir *next;
+};
+
+struct oval_fts_pwalk_match {
+	char *path;
+	int pathlen;
+	int namelen;
+	unsigned int fts_info;
+};
+
+struct oval_fts_pwalk {
+	OVAL_FTS *ofts;
+	pthread_mutex_t lock;
+	pthread_cond_t dir_cond;   /* signalled when a directory is queued or the walk ends */
+	pthread_cond_t match_cond; /* signalled when a match is found or the walk ends */
+	struct oval_fts_pwalk_dir *dirs;
+	size_t pending;            /* queued directories and the ones being read */
+	bool abort;                /* set when freed or when the object expired */
+	bool sorted;
+	bool error;                /* filename comparison failed */
+
+	struct oval_fts_pwalk_match *matches;
+	size_t matches_count;
+	size_t matches_size;
+	size_t matches_next;
+
+	uint64_t expires;          /* of the object, see oval_deadline_object_get() */
+	size_t threads_count;
+	pthread_t threads[OVAL_FTS_PWALK_MAX_THREADS];
+};
+
+static size_t oval_fts_pwalk_jobs(void)
+{
+	return oscap_threadpool_jobs("OSCAP_FTS_JOBS", 0, OVAL_FTS_PWALK_MAX_THREADS);
+}
+
+static void oval_fts_pwalk_dir_free(struct oval_fts_pwalk_dir *dir)
+{
+	free(dir->path);
+	free(dir->ancestors);
+	free(dir);
+}
+
+/* must be called with the walk lock held */
+static void oval_fts_pwalk_add_match(struct oval_fts_pwalk *pwalk, const char *path, int pathlen,
+                                     int namelen, unsigned int fts_info)
+{
+	struct oval_fts_pwalk_match *match;
+
+	if (pwalk->matches_count == pwalk->matches_size) {
+		size_t size = pwalk->matches_size ? pwalk->matches_size * 2 : 64;
+
+		match = realloc(pwalk->matches, size * sizeof(struct oval_fts_pwalk_match));
+		if (match == NULL)
+			return;
+		pwalk->matches = match;
+		pwalk->matches_size = size;
+	}
+
+	match = &pwalk->matches[pwalk->matches_count];
+	match->path = strdup(path);
+	if (match->path == NULL)
+		return;
+	match->pathlen = pathlen;
+	match->namelen = namelen;
+	match->fts_info = fts_info;
+	pwalk->matches_count++;
+
+	if (!pwalk->sorted)
+		pthread_cond_signal(&pwalk->match_cond);
+}
+
+static bool oval_fts_pwalk_cycle(const struct oval_fts_pwalk_dir *parent, const struct stat *st)
+{
+	for (size_t i = 0; i < parent->ancestors_count; i++) {
+		if (parent->ancestors[i].dev == st->st_dev && parent->ancestors[i].ino == st->st_ino)
+			return true;
+	}
+
+	return false;
+}
+
+static struct oval_fts_pwalk_dir *oval_fts_pwalk_dir_new(const struct oval_fts_pwalk_dir *parent,
+                                                         const char *path, const struct stat *st)
+{
+	struct oval_fts_pwalk_dir *dir;
+	size_t count = parent != NULL ? parent->ancestors_count : 0;
+
+	dir = malloc(sizeof(struct oval_fts_pwalk_dir));
+	if (dir == NULL)
+		return NULL;
+	dir->path = strdup(path);
+	dir->ancestors = malloc((count + 1) * sizeof(struct oval_fts_pwalk_id));
+	if (dir->path == NULL || dir->ancestors == NULL) {
+		free(dir->path);
+		free(dir->ancestors);
+		free(dir);
+		return NULL;
+	}
+	if (count > 0)
+		memcpy(dir->ancestors, parent->ancestors, count * sizeof(struct oval_fts_pwalk_id));
+	dir->ancestors[count].dev = st->st_dev;
+	dir->ancestors[count].ino = st->st_ino;
+	dir->ancestors_count = count + 1;
+	dir->level = parent != NULL ? parent->level + 1 : 0;
+	dir->next = NULL;
+
+	return dir;
+}
+
+static unsigned int oval_fts_pwalk_info(const struct stat *st)
+{
+	if (S_ISDIR(st->st_mode))
+		return FTS_D;
+	if (S_ISLNK(st->st_mode))
+		return FTS_SL;
+	if (S_ISREG(st->st_mode))
+		return FTS_F;
+
+	return FTS_DEFAULT;
+}
+
+/* don't recurse into non-local filesystems or beyond the initial one */
+static bool oval_fts_pwalk_skip_fs(OVAL_FTS *ofts, const char *path, const struct stat *st)
+{
+	if (ofts->filesystem == OVAL_RECURSE_FS_LOCAL
+	    && !OVAL_FTS_localp(ofts, path, (void *)&st->st_dev))
+		return true;
+	if (ofts->filesystem == OVAL_RECURSE_FS_DEFINED
+	    && ofts->ofts_recurse_path_devid != st->st_dev)
+		return true;
+
+	return false;
+}
+
+static void oval_fts_pwalk_collect(struct oval_fts_pwalk *pwalk, const char *path, int pathlen,
+                                   const char *name, int level, unsigned int fts_info)
+{
+	OVAL_FTS *ofts = pwalk->ofts;
+	oval_result_t result = OVAL_RESULT_FALSE;
+
+	if (ofts->ofts_sfilename == NULL) {
+		if (fts_info == FTS_D && (ofts->max_depth == -1 || level <= ofts->max_depth))
+			result = OVAL_RESULT_TRUE;
+	} else if (fts_info != FTS_D) {
+		result = oval_fts_cmp_filename(ofts, name);
+	}
+
+	if (result != OVAL_RESULT_TRUE && result != OVAL_RESULT_ERROR)
+		return;
+
+	pthread_mutex_lock(&pwalk->lock);
+	if (result == OVAL_RESULT_TRUE)
+		oval_fts_pwalk_add_match(pwalk, path, pathlen, strlen(name), fts_info);
+	else
+		pwalk->error = true;
+	pthread_mutex_unlock(&pwalk->lock);
+}
+
+/*
+ * Process an entry of a directory, the subdirectories to descend into are
+ * prepended to the list in 'subdirs'.
+ */
+static void oval_fts_pwalk_entry(struct oval_fts_pwalk *pwalk, const struct oval_fts_pwalk_dir *parent,
+                                 const char *path, int pathlen, const char *name,
+                                 unsigned int fts_info, const struct stat *st, bool followed,
+                                 struct oval_fts_pwalk_dir **subdirs)
+{
+	OVAL_FTS *ofts = pwalk->ofts;
+	struct oval_fts_pwalk_dir *dir;
+	struct stat target;
+	int level = parent->level + 1;
+
+	if (fts_info == FTS_D && oval_fts_pwalk_cycle(parent, st)) {
+		dW("Filesystem tree cycle detected at '%s'.", path);
+		return;
+	}
+
+	oval_fts_pwalk_collect(pwalk, path, pathlen, name, level, fts_info);
+
+	/* limit recursion depth */
+	if (ofts->max_depth != -1 && level > ofts->max_depth)
+		return;
+
+	/* limit recursion only to selected file types */
+	switch (fts_info) {
+	case FTS_D:
+		if (!(ofts->recurse & OVAL_RECURSE_DIRS) && !(ofts->recurse & OVAL_RECURSE_SYMLINKS && followed))
+			return;
+		break;
+	case FTS_SL:
+		if (!(ofts->recurse & OVAL_RECURSE_SYMLINKS))
+			return;
+		break;
+	default:
+		return;
+	}
+
+	if (oval_fts_pwalk_skip_fs(ofts, path, st))
+		return;
+
+	if (fts_info == FTS_SL) {
+		/* the target of the symlink is processed as another entry */
+		if (oval_fts_cache_stat(path, &target) != 0) {
+			oval_fts_pwalk_entry(pwalk, parent, path, pathlen, name, FTS_SLNONE, st, true, subdirs);
+			return;
+		}
+		oval_fts_pwalk_entry(pwalk, parent, path, pathlen, name,
+		                     oval_fts_pwalk_info(&target), &target, true, subdirs);
+		return;
+	}
+
+	dir = oval_fts_pwalk_dir_new(parent, path, st);
+	if (dir != NULL) {
+		dir->next = *subdirs;
+		*subdirs = dir;
+	}
+}
+
+static void oval_fts_pwalk_read_dir(struct oval_fts_pwalk *pwalk, struct oval_fts_pwalk_dir *dir)
+{
+	struct oval_fts_pwalk_dir *subdirs = NULL, *last;
+	const oval_fts_cache_dirent_t *dirent;
+	oval_fts_cache_dir_t *listing;
+	char path[PATH_MAX];
+	size_t dirlen;
+
+	/* directories are listed through the metadata cache, objects walking
+	   the same subtree share the listings */
+	listing = oval_fts_cache_dir_get(dir->path, true);
+	if (listing == NULL) {
+		/* fts reports the directory once again as FTS_DNR */
+		if (dir->level > 0) {
+			const char *name = strrchr(dir->path, '/');
+
+			oval_fts_pwalk_collect(pwalk, dir->path, strlen(dir->path),
+			                       name != NULL ? name + 1 : dir->path, dir->level, FTS_DNR);
+		}
+		return;
+	}
+
+	/* same paths as fts_read() would build for the entries */
+	dirlen = strlen(dir->path);
+	if (dirlen > 0 && dir->path[dirlen - 1] == '/')
+		dirlen--;
+
+	for (size_t i = 0; (dirent = oval_fts_cache_dir_entry(listing, i)) != NULL; i++) {
+		unsigned int fts_info = dirent->fts_info;
+		struct stat st;
+		int pathlen;
+
+		pathlen = snprintf(path, sizeof(path), "%.*s/%s", (int)dirlen, dir->path, dirent->name);
+		if (pathlen >= (int)sizeof(path))
+			continue;
+
+		/* regular files don't need to be stat-ed, their type is all we need,
+		   subdirectories and symlinks need the ids from the listing */
+		memset(&st, 0, sizeof(st));
+		if (fts_info != FTS_F && fts_info != FTS_NS) {
+			if (dirent->has_id) {
+				st.st_mode = dirent->mode;
+				st.st_dev = dirent->dev;
+				st.st_ino = dirent->ino;
+			} else if (oval_fts_cache_lstat(path, &st) != 0) {
+				fts_info = FTS_NS;
+			} else {
+				fts_info = oval_fts_pwalk_info(&st);
+			}
+		}
+
+		oval_fts_pwalk_entry(pwalk, dir, path, pathlen, dirent->name, fts_info, &st, false, &subdirs);
+	}
+	oval_fts_cache_dir_release(listing);
+
+	if (subdirs == NULL)
+		return;
+
+	for (last = subdirs; last->next != NULL; last = last->next)
+		;
+
+	pthread_mutex_lock(&pwalk->lock);
+	for (struct oval_fts_pwalk_dir *d = subdirs; d != NULL; d = d->next)
+		pwalk->pending++;
+	last->next = pwalk->dirs;
+	pwalk->dirs = subdirs;
+	pthread_cond_broadcast(&pwalk->dir_cond);
+	pthread_mutex_unlock(&pwalk->lock);
+}
+
+static void *oval_fts_pwalk_thread(void *arg)
+{
+	struct oval_fts_pwalk *pwalk = arg;
+	struct oval_fts_pwalk_dir *dir;
+
+	oval_deadline_object_set(pwalk->expires);
+
+	pthread_mutex_lock(&pwalk->lock);
+	while (!pwalk->abort && pwalk->pending > 0) {
+		if (pwalk->dirs == NULL) {
+			pthread_cond_wait(&pwalk->dir_cond, &pwalk->lock);
+			continue;
+		}
+		if (oval_deadline_expired()) {
+			/* the reader stops waiting for the directories left */
+			pwalk->abort = true;
+			pthread_cond_broadcast(&pwalk->dir_cond);
+			pthread_cond_broadcast(&pwalk->match_cond);
+			break;
+		}
+		dir = pwalk->dirs;
+		pwalk->dirs = dir->next;
+		pthread_mutex_unlock(&pwalk->lock);
+
+		oval_throttle_cpu();
+		oval_fts_pwalk_read_dir(pwalk, dir);
+		oval_fts_pwalk_dir_free(dir);
+
+		pthread_mutex_lock(&pwalk->lock);
+		if (--pwalk->pending == 0) {
+			pthread_cond_broadcast(&pwalk->dir_cond);
+			pthread_cond_broadcast(&pwalk->match_cond);
+		}
+	}
+	pthread_mutex_unlock(&pwalk->lock);
+
+	return NULL;
+}
+
+static int oval_fts_pwalk_cmp(const void *a, const void *b)
+{
+	return strcmp(((const struct oval_fts_pwalk_match *)a)->path,
+	              ((const struct oval_fts_pwalk_match *)b)->path);
+}
+
+static void oval_fts_pwalk_free(struct oval_fts_pwalk *pwalk)
+{
+	struct oval_fts_pwalk_dir *dir;
+
+	if (pwalk == NULL)
+		return;
+
+	pthread_mutex_lock(&pwalk->lock);
+	pwalk->abort = true;
+	pthread_cond_broadcast(&pwalk->dir_cond);
+	pthread_mutex_unlock(&pwalk->lock);
+
+	for (size_t i = 0; i < pwalk->threads_count; i++)
+		pthread_join(pwalk->threads[i], NULL);
+
+	while ((dir = pwalk->dirs) != NULL) {
+		pwalk->dirs = dir->next;
+		oval_fts_pwalk_dir_free(dir);
+	}
+	for (size_t i = pwalk->matches_next; i < pwalk->matches_count; i++)
+		free(pwalk->matches[i].path);
+	free(pwalk->matches);
+
+	pthread_cond_destroy(&pwalk->match_cond);
+	pthread_cond_destroy(&pwalk->dir_cond);
+	pthread_mutex_destroy(&pwalk->lock);
+	free(pwalk);
+}
+
+static struct oval_fts_pwalk *oval_fts_pwalk_new(OVAL_FTS *ofts, const char *root, size_t jobs)
+{
+	struct oval_fts_pwalk *pwalk;
+	struct oval_fts_pwalk_dir *dir;
+	const char *order;
+	struct stat st;
+
+	/* the walk root is followed like with FTS_COMFOLLOW */
+	if (oval_fts_cache_stat(root, &st) != 0 || !S_ISDIR(st.st_mode))
+		return NULL;
+
+	pwalk = calloc(1, sizeof(struct oval_fts_pwalk));
+	if (pwalk == NULL)
+		return NULL;
+	pwalk->ofts = ofts;
+	pwalk->expires = oval_deadline_object_get();
+	order = getenv("OSCAP_FTS_ORDER");
+	pwalk->sorted = order == NULL || strcmp(order, "unsorted") != 0;
+	pthread_mutex_init(&pwalk->lock, NULL);
+	pthread_cond_init(&pwalk->dir_cond, NULL);
+	pthread_cond_init(&pwalk->match_cond, NULL);
+
+	/* the root itself is collected as a directory at level 0 */
+	if (ofts->ofts_sfilename == NULL) {
+		pthread_mutex_lock(&pwalk->lock);
+		oval_fts_pwalk_add_match(pwalk, root, strlen(root), 0, FTS_D);
+		pthread_mutex_unlock(&pwalk->lock);
+	}
+
+	if (oval_fts_pwalk_skip_fs(ofts, root, &st))
+		return pwalk;
+
+	dir = oval_fts_pwalk_dir_new(NULL, root, &st);
+	if (dir == NULL)
+		return pwalk;
+	pwalk->dirs = dir;
+	pwalk->pending = 1;
+
+	for (size_t i = 0; i < jobs; i++) {
+		int err = pthread_create(&pwalk->threads[i], NULL, oval_fts_pwalk_thread, pwalk);
+
+		if (err != 0) {
+			dW("Can't start a walker thread: %s.", strerror(err));
+			break;
+		}
+		pwalk->threads_count++;
+	}
+	if (pwalk->threads_count == 0) {
+		/* walk in the calling thread then */
+		oval_fts_pwalk_thread(pwalk);
+	}
+
+	return pwalk;
+}
+
+/* find the next matching file or directory using the parallel walk */
+static OVAL_FTSENT *oval_fts_read_recurse_pwalk(OVAL_FTS *ofts)
+{
+	struct oval_fts_pwalk *pwalk = ofts->ofts_recurse_path_pwalk;
+	struct oval_fts_pwalk_match match;
+	OVAL_FTSENT *ofts_ent;
+
+	if (pwalk == NULL) {
+		pwalk = oval_fts_pwalk_new(ofts, ofts->ofts_match_path_fts_ent->fts_path,
+		                           oval_fts_pwalk_jobs());
+		if (pwalk == NULL)
+			return NULL;
+		ofts->ofts_recurse_path_pwalk = pwalk;
+	}
+
+	pthread_mutex_lock(&pwalk->lock);
+	if (pwalk->sorted) {
+		while (pwalk->pending > 0 && !pwalk->abort)
+			pthread_cond_wait(&pwalk->match_cond, &pwalk->lock);
+		if (pwalk->matches_next == 0 && pwalk->matches_count > 1)
+			qsort(pwalk->matches, pwalk->matches_count,
+			      sizeof(struct oval_fts_pwalk_match), oval_fts_pwalk_cmp);
+	} else {
+		while (pwalk->pending > 0 && !pwalk->abort && pwalk->matches_next == pwalk->matches_count)
+			pthread_cond_wait(&pwalk->match_cond, &pwalk->lock);
+	}
+	if (pwalk->error) {
+		probe_cobj_set_flag(ofts->result, SYSCHAR_FLAG_ERROR);
+		pwalk->error = false;
+	}
+	if (pwalk->matches_next == pwalk->matches_count) {
+		pthread_mutex_unlock(&pwalk->lock);
+		oval_fts_pwalk_free(pwalk);
+		ofts->ofts_recurse_path_pwalk = NULL;
+		return NULL;
+	}
+	match = pwalk->matches[pwalk->matches_next++];
+	pthread_mutex_unlock(&pwalk->lock);
+
+	ofts_ent = OVAL_FTSENT_new_path(ofts, match.path, match.pathlen,
+	                                match.path + match.pathlen - match.namelen, match.namelen,
+	                                match.fts_info);
+	free(match.path);
+
+	return ofts_ent;
+}
+
+static OVAL_FTSENT *oval_fts_read_next(OVAL_FTS *ofts)
 {
 	FTSENT *fts_ent;
 
@@ -1339,6 +2394,8 @@ OVAL_FTSENT *oval_fts_read(OVAL_FTS *ofts)
 	if (ofts == NULL)
 		return NULL;
 
+	oval_throttle_cpu();
+
 	for (;;) {
 		if (ofts->ofts_match_path_fts_ent == NULL) {
 			ofts->ofts_match_path_fts_ent = oval_fts_read_match_path(ofts);
@@ -1356,6 +2413,24 @@ OVAL_FTSENT *oval_fts_read(OVAL_FTS *ofts)
 				continue;
 			}
 			break;
+		} else if (ofts->ofts_recurse_path_cached) {
+			OVAL_FTSENT *ofts_ent = oval_fts_read_recurse_cache(ofts);
+			if (ofts_ent != NULL)
+				return ofts_ent;
+
+			ofts->ofts_match_path_fts_ent = NULL;
+
+			if (ofts->ofts_path_op == OVAL_OPERATION_EQUALS)
+				return (NULL);
+		} else if (ofts->ofts_recurse_path_parallel) {
+			OVAL_FTSENT *ofts_ent = oval_fts_read_recurse_pwalk(ofts);
+			if (ofts_ent != NULL)
+				return ofts_ent;
+
+			ofts->ofts_match_path_fts_ent = NULL;
+
+			if (ofts->ofts_path_op == OVAL_OPERATION_EQUALS)
+				return (NULL);
 		} else {
 			fts_ent = oval_fts_read_recurse_path(ofts);
 			if (fts_ent != NULL)
@@ -1373,6 +2448,24 @@ OVAL_FTSENT *oval_fts_read(OVAL_FTS *ofts)
 	return OVAL_FTSENT_new(ofts, fts_ent);
 }
 
+OVAL_FTSENT *oval_fts_read(OVAL_FTS *ofts)
+{
+	OVAL_FTSENT *ofts_ent;
+
+	if (oval_deadline_expired())
+		return NULL;
+
+	ofts_ent = oval_fts_read_next(ofts);
+	if (ofts_ent != NULL) {
+		oscap_stats_add(OSCAP_STATS_FTS_ENTRIES, 1);
+		OSCAP_TRACE2(fts__entry, ofts_ent->path, ofts_ent->fts_info);
+	} else {
+		/* the walker threads may have stopped the walk at a deadline */
+		oval_deadline_expired();
+	}
+	return ofts_ent;
+}
+
 void oval_ftsent_free(OVAL_FTSENT *ofts_ent)
 {
 	OVAL_FTSENT_free(ofts_ent);
@@ -1383,10 +2476,7 @@ int oval_fts_close(OVAL_FTS *ofts)
 	if (ofts->ofts_recurse_path_pthcpy != NULL)
 		free(ofts->ofts_recurse_path_pthcpy);
 
-	if (ofts->ofts_path_regex)
-		pcre_free(ofts->ofts_path_regex);
-	if (ofts->ofts_path_regex_extra)
-		pcre_free(ofts->ofts_path_regex_extra);
+	oscap_pcre_free(ofts->ofts_path_regex, ofts->ofts_path_regex_extra);
 
 	if (ofts->ofts_spath != NULL)
 		SEXP_free(ofts->ofts_spath);
@@ -1395,7 +2485,7 @@ int oval_fts_close(OVAL_FTS *ofts)
 	if (ofts->ofts_sfilepath != NULL)
 		SEXP_free(ofts->ofts_sfilepath);
 
-	fsdev_free(ofts->localdevs);
+	fsdev_put(ofts->localdevs);
 
 	OVAL_FTS_free(ofts);
 #if defined(OS_SOLARIS)
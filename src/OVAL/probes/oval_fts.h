@@ -31,7 +31,9 @@
 #include <fts.h>
 #endif
 #include <pcre.h>
+#include <pthread.h>
 #include "fsdev.h"
+#include "oval_fts_cache.h"
 
 #define ENT_GET_AREF(ent, dst, attr_name, mandatory)			\
 	do {								\
@@ -66,6 +68,11 @@
 		}						\
 	} while (0)
 
+struct oval_fts_pwalk;
+struct oval_fts_literal;
+
+#define OVAL_FTS_LOCALDEVS_MEMO 16
+
 typedef struct {
 	/* oval_fts_read_match_path() state */
 	FTS *ofts_match_path_fts;
@@ -77,6 +84,13 @@ typedef struct {
 	char *ofts_recurse_path_pthcpy;
 	char *ofts_recurse_path_curpth;
 	dev_t ofts_recurse_path_devid;
+	/* listing from the metadata cache used instead of the fts */
+	bool ofts_recurse_path_cached;
+	oval_fts_cache_dir_t *ofts_recurse_path_dir;
+	size_t ofts_recurse_path_diridx;
+	/* multi-threaded walk used instead of the fts */
+	bool ofts_recurse_path_parallel;
+	struct oval_fts_pwalk *ofts_recurse_path_pwalk;
 
 	pcre       *ofts_path_regex;
 	pcre_extra *ofts_path_regex_extra;
@@ -85,6 +99,12 @@ typedef struct {
 	SEXP_t *ofts_spath;
 	SEXP_t *ofts_sfilename;
 	SEXP_t *ofts_sfilepath;
+	/* literals of the patterns checked before running PCRE */
+	struct oval_fts_literal *ofts_spath_lit;
+	struct oval_fts_literal *ofts_sfilename_lit;
+	/* globs of the patterns matched instead of PCRE, see oval_glob.h */
+	struct oval_glob *ofts_path_glob;
+	struct oval_glob *ofts_sfilename_glob;
 	SEXP_t *result;
 
 	int max_depth;
@@ -94,6 +114,13 @@ typedef struct {
 	int following;
 
 	fsdev_t *localdevs;
+	/* devices already classified by OVAL_FTS_localp() */
+	pthread_mutex_t localdevs_lock;
+	size_t localdevs_memo_cnt;
+	struct {
+		dev_t dev;
+		bool local;
+	} localdevs_memo[OVAL_FTS_LOCALDEVS_MEMO];
 	const char *prefix;
 } OVAL_FTS;
 
@@ -0,0 +1,485 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <stdint.h>
+#include "oscap_platforms.h"
+#if defined(OS_LINUX)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/sysmacros.h>
+#endif
+
+#include "common/list.h"
+#include "common/stats_priv.h"
+#include "oval_fts_cache.h"
+#include "oval_throttle.h"
+#if defined(OS_SOLARIS) || defined(OS_AIX)
+#include "fts_sun.h"
+#else
+#include <fts.h>
+#endif
+
+/* upper bound of entries in each of the tables, walks over big trees
+   shouldn't turn the cache into a copy of the filesystem */
+#define OVAL_FTS_CACHE_MAX_ENTRIES 65536
+/* upper bound of names in all the cached directory listings */
+#define OVAL_FTS_CACHE_MAX_DIRENTS 262144
+#define OVAL_FTS_CACHE_HSIZE       4099
+
+typedef struct {
+	int err; /* errno of a failed call, 0 on success */
+	struct stat st;
+} oval_fts_cache_stat_t;
+
+struct oval_fts_cache_dir {
+	unsigned int refs;
+	int err;
+	size_t count;
+	oval_fts_cache_dirent_t *entries;
+};
+
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct oscap_htable *lstat_table = NULL;
+static struct oscap_htable *stat_table = NULL;
+static struct oscap_htable *dir_table = NULL;
+static size_t dir_table_names = 0;
+
+static void oval_fts_cache_dir_free(oval_fts_cache_dir_t *dir)
+{
+	for (size_t i = 0; i < dir->count; i++)
+		free(dir->entries[i].name);
+	free(dir->entries);
+	free(dir);
+}
+
+/* must be called with cache_lock held */
+static void oval_fts_cache_dir_unref(oval_fts_cache_dir_t *dir)
+{
+	if (--dir->refs == 0)
+		oval_fts_cache_dir_free(dir);
+}
+
+static void oval_fts_cache_dir_unref_cb(void *dir)
+{
+	oval_fts_cache_dir_unref(dir);
+}
+
+/* must be called with cache_lock held */
+static struct oscap_htable *oval_fts_cache_table(struct oscap_htable **table)
+{
+	if (*table == NULL)
+		*table = oscap_htable_new1(strcmp, OVAL_FTS_CACHE_HSIZE);
+
+	return *table;
+}
+
+/* must be called with cache_lock held */
+static void oval_fts_cache_add(struct oscap_htable **table, const char *path, int err, const struct stat *st)
+{
+	oval_fts_cache_stat_t *entry;
+
+	if (oval_fts_cache_table(table) == NULL
+	    || oscap_htable_itemcount(*table) >= OVAL_FTS_CACHE_MAX_ENTRIES)
+		return;
+
+	entry = malloc(sizeof(oval_fts_cache_stat_t));
+	if (entry == NULL)
+		return;
+	entry->err = err;
+	if (st != NULL)
+		memcpy(&entry->st, st, sizeof(struct stat));
+	else
+		memset(&entry->st, 0, sizeof(struct stat));
+
+	if (!oscap_htable_add(*table, path, entry))
+		free(entry);
+}
+
+/* must be called with cache_lock held */
+static int oval_fts_cache_lookup(struct oscap_htable *table, const char *path, struct stat *st)
+{
+	oval_fts_cache_stat_t *entry;
+
+	if (table == NULL || (entry = oscap_htable_get(table, path)) == NULL)
+		return 1;
+
+	if (entry->err != 0) {
+		errno = entry->err;
+		return -1;
+	}
+	memcpy(st, &entry->st, sizeof(struct stat));
+
+	return 0;
+}
+
+int oval_fts_cache_lstat(const char *path, struct stat *st)
+{
+	int ret;
+
+	pthread_mutex_lock(&cache_lock);
+	ret = oval_fts_cache_lookup(lstat_table, path, st);
+	pthread_mutex_unlock(&cache_lock);
+
+	if (ret != 1)
+		return ret;
+
+	ret = lstat(path, st);
+
+	pthread_mutex_lock(&cache_lock);
+	oval_fts_cache_add(&lstat_table, path, ret == 0 ? 0 : errno, ret == 0 ? st : NULL);
+	pthread_mutex_unlock(&cache_lock);
+
+	return ret;
+}
+
+int oval_fts_cache_stat(const char *path, struct stat *st)
+{
+	int ret;
+
+	pthread_mutex_lock(&cache_lock);
+	ret = oval_fts_cache_lookup(stat_table, path, st);
+	/* stat() and lstat() agree on everything but symlinks */
+	if (ret == 1 && oval_fts_cache_lookup(lstat_table, path, st) == 0 && !S_ISLNK(st->st_mode))
+		ret = 0;
+	pthread_mutex_unlock(&cache_lock);
+
+	if (ret != 1)
+		return ret;
+
+	ret = stat(path, st);
+
+	pthread_mutex_lock(&cache_lock);
+	oval_fts_cache_add(&stat_table, path, ret == 0 ? 0 : errno, ret == 0 ? st : NULL);
+	pthread_mutex_unlock(&cache_lock);
+
+	return ret;
+}
+
+void oval_fts_cache_store(const char *path, const struct stat *st)
+{
+	pthread_mutex_lock(&cache_lock);
+	oval_fts_cache_add(&lstat_table, path, 0, st);
+	pthread_mutex_unlock(&cache_lock);
+}
+
+static unsigned int oval_fts_cache_mode_info(mode_t mode)
+{
+	if (S_ISDIR(mode))
+		return FTS_D;
+	if (S_ISLNK(mode))
+		return FTS_SL;
+	if (S_ISREG(mode))
+		return FTS_F;
+
+	return FTS_DEFAULT;
+}
+
+static unsigned int oval_fts_cache_type_info(unsigned char d_type)
+{
+#if defined(_DIRENT_HAVE_D_TYPE) || defined(DT_UNKNOWN)
+	switch (d_type) {
+	case DT_DIR:
+		return FTS_D;
+	case DT_LNK:
+		return FTS_SL;
+	case DT_REG:
+		return FTS_F;
+	case DT_UNKNOWN:
+		return FTS_NS;
+	default:
+		return FTS_DEFAULT;
+	}
+#else
+	return FTS_NS;
+#endif
+}
+
+static oval_fts_cache_dirent_t *oval_fts_cache_dir_add(oval_fts_cache_dir_t *dir, size_t *size, const char *name)
+{
+	oval_fts_cache_dirent_t *entry;
+
+	if (dir->count == *size) {
+		size_t new_size = *size ? *size * 2 : 32;
+
+		entry = realloc(dir->entries, new_size * sizeof(oval_fts_cache_dirent_t));
+		if (entry == NULL) {
+			dir->err = ENOMEM;
+			return NULL;
+		}
+		dir->entries = entry;
+		*size = new_size;
+	}
+
+	entry = &dir->entries[dir->count];
+	entry->name = strdup(name);
+	if (entry->name == NULL) {
+		dir->err = ENOMEM;
+		return NULL;
+	}
+	entry->has_id = false;
+	dir->count++;
+
+	return entry;
+}
+
+#if defined(OS_LINUX)
+/* record layout of getdents64(2) */
+struct oval_fts_cache_dirent64 {
+	uint64_t d_ino;
+	int64_t d_off;
+	unsigned short d_reclen;
+	unsigned char d_type;
+	char d_name[];
+};
+
+#define OVAL_FTS_CACHE_GETDENTS_BUFSIZE (64 * 1024)
+
+/*
+ * Fill in the type, and the device and inode number if asked for, with the
+ * least work: statx(2) with just the type and inode in the mask, relative
+ * to the open directory so the path is not resolved again.
+ */
+static void oval_fts_cache_dirent_stat(int fd, oval_fts_cache_dirent_t *entry)
+{
+	struct stat st;
+
+#if defined(HAVE_STATX)
+	static bool statx_missing = false;
+	struct statx stx;
+
+	if (!statx_missing) {
+		if (statx(fd, entry->name, AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT,
+		          STATX_TYPE | STATX_INO, &stx) == 0) {
+			entry->fts_info = oval_fts_cache_mode_info(stx.stx_mode);
+			entry->mode = stx.stx_mode;
+			entry->dev = makedev(stx.stx_dev_major, stx.stx_dev_minor);
+			entry->ino = stx.stx_ino;
+			entry->has_id = true;
+			return;
+		}
+		if (errno != ENOSYS) {
+			entry->fts_info = FTS_NS;
+			return;
+		}
+		statx_missing = true;
+	}
+#endif
+	if (fstatat(fd, entry->name, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+		entry->fts_info = FTS_NS;
+		return;
+	}
+	entry->fts_info = oval_fts_cache_mode_info(st.st_mode);
+	entry->mode = st.st_mode;
+	entry->dev = st.st_dev;
+	entry->ino = st.st_ino;
+	entry->has_id = true;
+}
+
+static oval_fts_cache_dir_t *oval_fts_cache_dir_read(const char *path, bool ids)
+{
+	oval_fts_cache_dir_t *dir;
+	size_t size = 0;
+	char *buf;
+	long n = 0;
+	int fd;
+
+	dir = calloc(1, sizeof(oval_fts_cache_dir_t));
+	if (dir == NULL)
+		return NULL;
+
+	fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (fd == -1) {
+		dir->err = errno;
+		return dir;
+	}
+
+	buf = malloc(OVAL_FTS_CACHE_GETDENTS_BUFSIZE);
+	if (buf == NULL) {
+		dir->err = ENOMEM;
+		close(fd);
+		return dir;
+	}
+
+	while (dir->err == 0 && (n = syscall(SYS_getdents64, fd, buf, OVAL_FTS_CACHE_GETDENTS_BUFSIZE)) > 0) {
+		oval_throttle_io(n);
+		oscap_stats_add(OSCAP_STATS_FTS_DIR_BYTES, n);
+		for (long off = 0; off < n;) {
+			struct oval_fts_cache_dirent64 *dp = (struct oval_fts_cache_dirent64 *)(buf + off);
+			oval_fts_cache_dirent_t *entry;
+
+			off += dp->d_reclen;
+			if (strcmp(dp->d_name, ".") == 0 || strcmp(dp->d_name, "..") == 0)
+				continue;
+
+			entry = oval_fts_cache_dir_add(dir, &size, dp->d_name);
+			if (entry == NULL)
+				break;
+
+			entry->fts_info = oval_fts_cache_type_info(dp->d_type);
+			/* regular files and the like don't need to be stat-ed */
+			if (entry->fts_info == FTS_NS
+			    || (ids && (entry->fts_info == FTS_D || entry->fts_info == FTS_SL)))
+				oval_fts_cache_dirent_stat(fd, entry);
+		}
+	}
+	if (n < 0 && dir->err == 0)
+		dir->err = errno;
+
+	free(buf);
+	close(fd);
+
+	return dir;
+}
+#else
+static oval_fts_cache_dir_t *oval_fts_cache_dir_read(const char *path, bool ids)
+{
+	oval_fts_cache_dir_t *dir;
+	struct dirent *dp;
+	DIR *dirp;
+	size_t size = 0, len;
+	char entry_path[PATH_MAX];
+
+	dir = calloc(1, sizeof(oval_fts_cache_dir_t));
+	if (dir == NULL)
+		return NULL;
+
+	dirp = opendir(path);
+	if (dirp == NULL) {
+		dir->err = errno;
+		return dir;
+	}
+
+	/* same paths as fts_read() would build for the entries */
+	len = strlen(path);
+	if (len > 0 && path[len - 1] == '/')
+		len--;
+
+	while ((dp = readdir(dirp)) != NULL) {
+		oval_fts_cache_dirent_t *entry;
+		struct stat st;
+
+		oval_throttle_io(sizeof(struct dirent));
+		oscap_stats_add(OSCAP_STATS_FTS_DIR_BYTES, sizeof(struct dirent));
+		if (strcmp(dp->d_name, ".") == 0 || strcmp(dp->d_name, "..") == 0)
+			continue;
+
+		entry = oval_fts_cache_dir_add(dir, &size, dp->d_name);
+		if (entry == NULL)
+			break;
+
+		entry->fts_info = oval_fts_cache_type_info(dp->d_type);
+		if (entry->fts_info != FTS_NS
+		    && !(ids && (entry->fts_info == FTS_D || entry->fts_info == FTS_SL)))
+			continue;
+
+		if (snprintf(entry_path, sizeof(entry_path), "%.*s/%s", (int)len, path, dp->d_name) >= (int)sizeof(entry_path)
+		    || oval_fts_cache_lstat(entry_path, &st) != 0) {
+			entry->fts_info = FTS_NS;
+			continue;
+		}
+		entry->fts_info = oval_fts_cache_mode_info(st.st_mode);
+		entry->mode = st.st_mode;
+		entry->dev = st.st_dev;
+		entry->ino = st.st_ino;
+		entry->has_id = true;
+	}
+	closedir(dirp);
+
+	return dir;
+}
+#endif
+
+oval_fts_cache_dir_t *oval_fts_cache_dir_get(const char *path, bool ids)
+{
+	oval_fts_cache_dir_t *dir, *cached;
+
+	pthread_mutex_lock(&cache_lock);
+	dir = dir_table != NULL ? oscap_htable_get(dir_table, path) : NULL;
+	if (dir != NULL)
+		dir->refs++;
+	pthread_mutex_unlock(&cache_lock);
+
+	if (dir == NULL) {
+		dir = oval_fts_cache_dir_read(path, ids);
+		if (dir == NULL)
+			return NULL;
+		dir->refs = 1;
+
+		pthread_mutex_lock(&cache_lock);
+		/* another probe may have listed the directory meanwhile */
+		cached = dir_table != NULL ? oscap_htable_get(dir_table, path) : NULL;
+		if (cached != NULL) {
+			oval_fts_cache_dir_unref(dir);
+			dir = cached;
+			dir->refs++;
+		} else if (dir->err != ENOMEM
+		           && oval_fts_cache_table(&dir_table) != NULL
+		           && oscap_htable_itemcount(dir_table) < OVAL_FTS_CACHE_MAX_ENTRIES
+		           && dir_table_names + dir->count <= OVAL_FTS_CACHE_MAX_DIRENTS
+		           && oscap_htable_add(dir_table, path, dir)) {
+			dir->refs++;
+			dir_table_names += dir->count;
+		}
+		pthread_mutex_unlock(&cache_lock);
+	}
+
+	if (dir->err != 0) {
+		errno = dir->err;
+		oval_fts_cache_dir_release(dir);
+		return NULL;
+	}
+
+	return dir;
+}
+
+const oval_fts_cache_dirent_t *oval_fts_cache_dir_entry(const oval_fts_cache_dir_t *dir, size_t i)
+{
+	return i < dir->count ? &dir->entries[i] : NULL;
+}
+
+void oval_fts_cache_dir_release(oval_fts_cache_dir_t *dir)
+{
+	if (dir == NULL)
+		return;
+
+	pthread_mutex_lock(&cache_lock);
+	oval_fts_cache_dir_unref(dir);
+	pthread_mutex_unlock(&cache_lock);
+}
+
+void oval_fts_cache_reset(void)
+{
+	pthread_mutex_lock(&cache_lock);
+	oscap_htable_free(lstat_table, free);
+	oscap_htable_free(stat_table, free);
+	oscap_htable_free(dir_table, oval_fts_cache_dir_unref_cb);
+	lstat_table = stat_table = dir_table = NULL;
+	dir_table_names = 0;
+	pthread_mutex_unlock(&cache_lock);
+}
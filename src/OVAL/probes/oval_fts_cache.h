@@ -0,0 +1,90 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+#ifndef OVAL_FTS_CACHE_H
+#define OVAL_FTS_CACHE_H
+
+#include <stdbool.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+/*
+ * Filesystem metadata cache shared by all the probes walking the filesystem
+ * during one scan. Directory listings and stat(2)/lstat(2) results are kept
+ * in memory keyed by the full path (including OSCAP_PROBE_ROOT), so objects
+ * of different probes looking into the same directories don't read and stat
+ * the same inodes again. Recursive walks of several objects over the same
+ * subtree read each directory once this way. Nothing is checked against
+ * the filesystem again: the cache has to be dropped by oval_fts_cache_reset
+ * whenever the filesystem may have changed, which is done after each
+ * remediation fix and when the last probe session ends.
+ */
+
+typedef struct {
+	char *name;
+	unsigned int fts_info; /* FTS_F, FTS_D, FTS_SL, FTS_DEFAULT or FTS_NS */
+	bool has_id;           /* mode, dev and ino are set */
+	mode_t mode;
+	dev_t dev;
+	ino_t ino;
+} oval_fts_cache_dirent_t;
+
+typedef struct oval_fts_cache_dir oval_fts_cache_dir_t;
+
+/**
+ * Cached lstat(2).
+ * @return 0 on success, -1 with errno set on failure
+ */
+int oval_fts_cache_lstat(const char *path, struct stat *st);
+
+/**
+ * Cached stat(2).
+ * @return 0 on success, -1 with errno set on failure
+ */
+int oval_fts_cache_stat(const char *path, struct stat *st);
+
+/**
+ * Store a lstat(2) result obtained elsewhere, e.g. by fts_read(3).
+ */
+void oval_fts_cache_store(const char *path, const struct stat *st);
+
+/**
+ * Get the listing of a directory, reading it if it is not cached yet.
+ * Entries are stat-ed only if readdir(3) doesn't tell their type, or, when
+ * 'ids' is set, to get the device and inode number of subdirectories and
+ * symlinks. A listing cached without them is returned as is.
+ * The listing has to be released by oval_fts_cache_dir_release.
+ * @return the listing or NULL if the directory can't be read
+ */
+oval_fts_cache_dir_t *oval_fts_cache_dir_get(const char *path, bool ids);
+
+/**
+ * Get the i-th entry of a directory listing.
+ * @return the entry or NULL past the last one
+ */
+const oval_fts_cache_dirent_t *oval_fts_cache_dir_entry(const oval_fts_cache_dir_t *dir, size_t i);
+
+void oval_fts_cache_dir_release(oval_fts_cache_dir_t *dir);
+
+/**
+ * Drop everything cached so far. Listings still held by a caller stay valid
+ * until they are released.
+ */
+void oval_fts_cache_reset(void);
+
+#endif /* OVAL_FTS_CACHE_H */
@@ -0,0 +1,519 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#if defined(OS_LINUX)
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#endif
+
+#include "common/debug_priv.h"
+#include "oval_net_cache.h"
+
+#define OVAL_NET_BUFSIZE  32768
+#define RT_INFO_DELIMITERS " \t"
+
+struct oval_net_link {
+	int index;
+	char name[IFNAMSIZ];
+	unsigned int flags;
+	unsigned short type;
+	unsigned char hw_addr[6];
+};
+
+struct oval_net_cache {
+	unsigned int refs;
+	unsigned int taken;               /* OVAL_NET_CACHE_* parts taken */
+
+	struct oval_net_link *links;      /* needed only to resolve the addresses */
+	size_t link_count;
+	size_t link_alloc;
+
+	struct oval_net_addr *addrs;
+	size_t addr_count;
+	size_t addr_alloc;
+
+	struct oval_net_route *routes[2]; /* IPv4, IPv6 */
+	size_t route_count[2];
+	size_t route_alloc[2];
+};
+
+static pthread_mutex_t net_lock = PTHREAD_MUTEX_INITIALIZER;
+static oval_net_cache_t *net_cache = NULL;
+
+static void oval_net_cache_free(oval_net_cache_t *net)
+{
+	free(net->links);
+	free(net->addrs);
+	free(net->routes[0]);
+	free(net->routes[1]);
+	free(net);
+}
+
+/* get a new zeroed element at the end of the array */
+static void *oval_net_push(void **items, size_t *count, size_t *alloc, size_t size)
+{
+	void *item;
+
+	if (*count == *alloc) {
+		size_t new_alloc = *alloc > 0 ? *alloc * 2 : 32;
+		void *new_items = realloc(*items, new_alloc * size);
+
+		if (new_items == NULL)
+			return NULL;
+		*items = new_items;
+		*alloc = new_alloc;
+	}
+	item = (char *)*items + (*count)++ * size;
+	memset(item, 0, size);
+
+	return item;
+}
+
+#if defined(OS_LINUX)
+static uint32_t net_seq = 0;
+
+/*
+ * Send a dump request and pass every message of the reply to the callback.
+ * must be called with net_lock held
+ */
+static int oval_net_dump(int fd, int type, int (*cb)(oval_net_cache_t *, struct nlmsghdr *), oval_net_cache_t *net)
+{
+	struct {
+		struct nlmsghdr nh;
+		struct rtgenmsg g;
+	} req;
+	struct sockaddr_nl sa;
+	struct nlmsghdr *nh;
+	ssize_t len;
+	void *buf;
+
+	memset(&req, 0, sizeof(req));
+	req.nh.nlmsg_len = NLMSG_LENGTH(sizeof(struct rtgenmsg));
+	req.nh.nlmsg_type = type;
+	req.nh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+	req.nh.nlmsg_seq = ++net_seq;
+	req.g.rtgen_family = AF_UNSPEC;
+
+	memset(&sa, 0, sizeof(sa));
+	sa.nl_family = AF_NETLINK;
+
+	if (sendto(fd, &req, req.nh.nlmsg_len, 0, (struct sockaddr *)&sa, sizeof(sa)) < 0)
+		return -1;
+
+	buf = malloc(OVAL_NET_BUFSIZE);
+	if (buf == NULL)
+		return -1;
+
+	for (;;) {
+		len = recv(fd, buf, OVAL_NET_BUFSIZE, 0);
+		if (len < 0) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+		if (len == 0) {
+			errno = EIO;
+			break;
+		}
+		for (nh = buf; NLMSG_OK(nh, len); nh = NLMSG_NEXT(nh, len)) {
+			if (nh->nlmsg_seq != req.nh.nlmsg_seq)
+				continue;
+			if (nh->nlmsg_type == NLMSG_DONE) {
+				free(buf);
+				return 0;
+			}
+			if (nh->nlmsg_type == NLMSG_ERROR) {
+				struct nlmsgerr *err = NLMSG_DATA(nh);
+
+				errno = -err->error;
+				free(buf);
+				return -1;
+			}
+			if (cb(net, nh) != 0) {
+				errno = ENOMEM;
+				free(buf);
+				return -1;
+			}
+		}
+	}
+	free(buf);
+
+	return -1;
+}
+
+static int oval_net_link_cb(oval_net_cache_t *net, struct nlmsghdr *nh)
+{
+	struct ifinfomsg *ifi = NLMSG_DATA(nh);
+	struct oval_net_link *link;
+	struct rtattr *rta;
+	int len;
+
+	if (nh->nlmsg_type != RTM_NEWLINK)
+		return 0;
+
+	link = oval_net_push((void **)&net->links, &net->link_count, &net->link_alloc, sizeof(*link));
+	if (link == NULL)
+		return -1;
+	link->index = ifi->ifi_index;
+	link->flags = ifi->ifi_flags;
+	link->type  = ifi->ifi_type;
+
+	len = IFLA_PAYLOAD(nh);
+	for (rta = IFLA_RTA(ifi); RTA_OK(rta, len); rta = RTA_NEXT(rta, len)) {
+		switch (rta->rta_type) {
+		case IFLA_IFNAME:
+			snprintf(link->name, sizeof(link->name), "%.*s", (int)RTA_PAYLOAD(rta), (char *)RTA_DATA(rta));
+			break;
+		case IFLA_ADDRESS:
+			/* the links without one report zeros like SIOCGIFHWADDR does */
+			memcpy(link->hw_addr, RTA_DATA(rta),
+			       RTA_PAYLOAD(rta) < sizeof(link->hw_addr) ? RTA_PAYLOAD(rta) : sizeof(link->hw_addr));
+			break;
+		}
+	}
+
+	return 0;
+}
+
+static int oval_net_addr_cb(oval_net_cache_t *net, struct nlmsghdr *nh)
+{
+	struct ifaddrmsg *ifa = NLMSG_DATA(nh);
+	struct oval_net_link *link = NULL;
+	struct oval_net_addr *addr;
+	struct rtattr *rta, *local = NULL, *address = NULL, *broadcast = NULL, *label = NULL;
+	size_t i;
+	int len;
+
+	if (nh->nlmsg_type != RTM_NEWADDR)
+		return 0;
+	if (ifa->ifa_family != AF_INET && ifa->ifa_family != AF_INET6)
+		return 0;
+
+	for (i = 0; i < net->link_count; ++i) {
+		if (net->links[i].index == (int)ifa->ifa_index) {
+			link = net->links + i;
+			break;
+		}
+	}
+	if (link == NULL)
+		return 0;
+
+	len = IFA_PAYLOAD(nh);
+	for (rta = IFA_RTA(ifa); RTA_OK(rta, len); rta = RTA_NEXT(rta, len)) {
+		switch (rta->rta_type) {
+		case IFA_LOCAL:
+			local = rta;
+			break;
+		case IFA_ADDRESS:
+			address = rta;
+			break;
+		case IFA_BROADCAST:
+			broadcast = rta;
+			break;
+		case IFA_LABEL:
+			label = rta;
+			break;
+		}
+	}
+	/* the local address differs from IFA_ADDRESS on point-to-point links */
+	if (ifa->ifa_family == AF_INET && local != NULL)
+		address = local;
+	if (address == NULL)
+		return 0;
+
+	addr = oval_net_push((void **)&net->addrs, &net->addr_count, &net->addr_alloc, sizeof(*addr));
+	if (addr == NULL)
+		return -1;
+
+	if (ifa->ifa_family == AF_INET && label != NULL)
+		snprintf(addr->name, sizeof(addr->name), "%.*s", (int)RTA_PAYLOAD(label), (char *)RTA_DATA(label));
+	else
+		snprintf(addr->name, sizeof(addr->name), "%s", link->name);
+	addr->family = ifa->ifa_family;
+	addr->flags = link->flags;
+	addr->hw_type = link->type;
+	memcpy(addr->hw_addr, link->hw_addr, sizeof(addr->hw_addr));
+	addr->prefixlen = ifa->ifa_prefixlen;
+	if (ifa->ifa_family == AF_INET) {
+		memcpy(&addr->addr.in, RTA_DATA(address), sizeof(addr->addr.in));
+		if (broadcast != NULL) {
+			memcpy(&addr->broadcast, RTA_DATA(broadcast), sizeof(addr->broadcast));
+			addr->has_broadcast = true;
+		}
+	} else {
+		memcpy(&addr->addr.in6, RTA_DATA(address), sizeof(addr->addr.in6));
+	}
+
+	return 0;
+}
+
+/* must be called with net_lock held */
+static int oval_net_take_addrs(oval_net_cache_t *net)
+{
+	int fd, ret = -1;
+
+	/* drop what a failed dump left behind */
+	net->link_count = 0;
+	net->addr_count = 0;
+
+	fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+	if (fd < 0) {
+		dE("Can't open a netlink socket: %u, %s", errno, strerror(errno));
+		return -1;
+	}
+
+	if (oval_net_dump(fd, RTM_GETLINK, oval_net_link_cb, net) != 0) {
+		dE("Can't dump the links: %u, %s", errno, strerror(errno));
+	} else if (oval_net_dump(fd, RTM_GETADDR, oval_net_addr_cb, net) != 0) {
+		dE("Can't dump the addresses: %u, %s", errno, strerror(errno));
+	} else {
+		dD("Found %zu links with %zu addresses.", net->link_count, net->addr_count);
+		ret = 0;
+	}
+	close(fd);
+
+	return ret;
+}
+#else
+/* must be called with net_lock held */
+static int oval_net_take_addrs(oval_net_cache_t *net)
+{
+	errno = ENOSYS;
+	return -1;
+}
+#endif /* OS_LINUX */
+
+static int oval_net_hex2bin(const char *hex, uint8_t *bin, size_t binlen)
+{
+	size_t i;
+
+	if (strlen(hex) != binlen * 2)
+		return -1;
+
+	for (i = 0; i < binlen; ++i) {
+		char byte[3] = { hex[2 * i], hex[2 * i + 1], '\0' };
+		char *end;
+
+		bin[i] = (uint8_t)strtoul(byte, &end, 16);
+		if (*end != '\0')
+			return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * /proc/net/route: Iface Destination Gateway Flags ..., the addresses are
+ * the values of s_addr in hex
+ */
+static int oval_net_route4(char *line, struct oval_net_route *rt)
+{
+	char *token[4], *save = NULL, *end;
+	struct in_addr ip4;
+	int i;
+
+	token[0] = strtok_r(line, RT_INFO_DELIMITERS, &save);
+	for (i = 1; i < 4; ++i) {
+		token[i] = strtok_r(NULL, RT_INFO_DELIMITERS, &save);
+		if (token[i] == NULL)
+			return -1;
+	}
+
+	ip4.s_addr = (uint32_t)strtoul(token[1], &end, 16);
+	if (*end != '\0' || inet_ntop(AF_INET, &ip4, rt->dst, sizeof(rt->dst)) == NULL)
+		return -1;
+	ip4.s_addr = (uint32_t)strtoul(token[2], &end, 16);
+	if (*end != '\0' || inet_ntop(AF_INET, &ip4, rt->gw, sizeof(rt->gw)) == NULL)
+		return -1;
+	rt->flags = strtoul(token[3], &end, 16);
+	if (*end != '\0')
+		return -1;
+	snprintf(rt->if_name, sizeof(rt->if_name), "%s", token[0]);
+
+	return 0;
+}
+
+/*
+ * /proc/net/ipv6_route: dst dst_len src src_len gateway metric refcnt use
+ * flags iface, the addresses in hex in network byte order
+ */
+static int oval_net_route6(char *line, struct oval_net_route *rt)
+{
+	char *token[10], *save = NULL, *end;
+	struct in6_addr ip6;
+	int i;
+
+	token[0] = strtok_r(line, RT_INFO_DELIMITERS, &save);
+	for (i = 1; i < 10; ++i) {
+		token[i] = strtok_r(NULL, RT_INFO_DELIMITERS, &save);
+		if (token[i] == NULL)
+			return -1;
+	}
+
+	if (oval_net_hex2bin(token[0], ip6.s6_addr, sizeof(ip6.s6_addr)) != 0 ||
+	    inet_ntop(AF_INET6, &ip6, rt->dst, sizeof(rt->dst)) == NULL)
+		return -1;
+	if (oval_net_hex2bin(token[4], ip6.s6_addr, sizeof(ip6.s6_addr)) != 0 ||
+	    inet_ntop(AF_INET6, &ip6, rt->gw, sizeof(rt->gw)) == NULL)
+		return -1;
+	rt->flags = strtoul(token[8], &end, 16);
+	if (*end != '\0')
+		return -1;
+	snprintf(rt->if_name, sizeof(rt->if_name), "%s", token[9]);
+
+	return 0;
+}
+
+/* must be called with net_lock held */
+static int oval_net_take_routes(oval_net_cache_t *net, int v6)
+{
+	const char *path = v6 ? "/proc/net/ipv6_route" : "/proc/net/route";
+	struct oval_net_route *rt;
+	char *line = NULL;
+	size_t line_len = 0;
+	FILE *fp;
+
+	fp = fopen(path, "r");
+	if (fp == NULL) {
+		dE("Can't open %s: %u, %s", path, errno, strerror(errno));
+		return -1;
+	}
+
+	/* the IPv4 table has a header line */
+	if (v6 || getline(&line, &line_len, fp) != -1) {
+		while (getline(&line, &line_len, fp) != -1) {
+			line[strcspn(line, "\n")] = '\0';
+			rt = oval_net_push((void **)&net->routes[v6], &net->route_count[v6],
+					   &net->route_alloc[v6], sizeof(*rt));
+			if (rt == NULL)
+				break;
+			if ((v6 ? oval_net_route6(line, rt) : oval_net_route4(line, rt)) != 0) {
+				dE("Can't parse a line of %s", path);
+				--net->route_count[v6];
+				break;
+			}
+		}
+	}
+	if (!feof(fp))
+		dE("An error ocured while reading %s: %s", path, strerror(errno));
+	free(line);
+	fclose(fp);
+
+	return 0;
+}
+
+oval_net_cache_t *oval_net_cache_acquire(unsigned int what)
+{
+	oval_net_cache_t *net;
+	int err = 0;
+
+	pthread_mutex_lock(&net_lock);
+	if (net_cache == NULL) {
+		net_cache = calloc(1, sizeof(oval_net_cache_t));
+		if (net_cache == NULL) {
+			pthread_mutex_unlock(&net_lock);
+			return NULL;
+		}
+		/* one reference is held by the cache */
+		net_cache->refs = 1;
+	}
+	net = net_cache;
+
+	if ((what & OVAL_NET_CACHE_ADDRS) && !(net->taken & OVAL_NET_CACHE_ADDRS)) {
+		if (oval_net_take_addrs(net) == 0)
+			net->taken |= OVAL_NET_CACHE_ADDRS;
+		else
+			err = errno;
+	}
+	if ((what & OVAL_NET_CACHE_ROUTES4) && !(net->taken & OVAL_NET_CACHE_ROUTES4)) {
+		if (oval_net_take_routes(net, 0) == 0)
+			net->taken |= OVAL_NET_CACHE_ROUTES4;
+		else
+			err = errno;
+	}
+	if ((what & OVAL_NET_CACHE_ROUTES6) && !(net->taken & OVAL_NET_CACHE_ROUTES6)) {
+		if (oval_net_take_routes(net, 1) == 0)
+			net->taken |= OVAL_NET_CACHE_ROUTES6;
+		else
+			err = errno;
+	}
+
+	if (err != 0) {
+		/* a part that failed is taken again by the next caller */
+		pthread_mutex_unlock(&net_lock);
+		errno = err;
+		return NULL;
+	}
+	net->refs++;
+	pthread_mutex_unlock(&net_lock);
+
+	return net;
+}
+
+void oval_net_cache_release(oval_net_cache_t *net)
+{
+	bool last;
+
+	if (net == NULL)
+		return;
+
+	pthread_mutex_lock(&net_lock);
+	last = --net->refs == 0;
+	pthread_mutex_unlock(&net_lock);
+
+	if (last)
+		oval_net_cache_free(net);
+}
+
+const struct oval_net_addr *oval_net_cache_addr(const oval_net_cache_t *net, size_t i)
+{
+	return i < net->addr_count ? net->addrs + i : NULL;
+}
+
+const struct oval_net_route *oval_net_cache_route(const oval_net_cache_t *net, int family, size_t i)
+{
+	int v6 = family == AF_INET6;
+
+	return i < net->route_count[v6] ? net->routes[v6] + i : NULL;
+}
+
+void oval_net_cache_reset(void)
+{
+	oval_net_cache_t *net;
+
+	pthread_mutex_lock(&net_lock);
+	net = net_cache;
+	net_cache = NULL;
+	pthread_mutex_unlock(&net_lock);
+
+	oval_net_cache_release(net);
+}
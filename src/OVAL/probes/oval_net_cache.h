@@ -0,0 +1,94 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+#ifndef OVAL_NET_CACHE_H
+#define OVAL_NET_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <netinet/in.h>
+#include <net/if.h>
+
+/*
+ * Network configuration shared by the interface, routingtable and
+ * system_info probes during one scan. The links and their addresses are
+ * taken with a single RTNETLINK dump (Linux only), which carries the
+ * hardware address and type of the links too, so nothing is asked per
+ * interface. The IPv4 and IPv6 routing tables are read once from
+ * /proc/net/route and /proc/net/ipv6_route, which report the RTF_* flags
+ * the routingtable items consist of. Everything is dropped after each
+ * remediation fix and when the last probe session ends.
+ */
+
+typedef struct oval_net_cache oval_net_cache_t;
+
+#define OVAL_NET_CACHE_ADDRS   0x01
+#define OVAL_NET_CACHE_ROUTES4 0x02
+#define OVAL_NET_CACHE_ROUTES6 0x04
+
+/* an address of a link, like the AF_INET and AF_INET6 entries of getifaddrs */
+struct oval_net_addr {
+	char name[IFNAMSIZ];          /* label of the address (e.g. eth0:1) or name of the link */
+	int family;                   /* AF_INET or AF_INET6 */
+	unsigned int flags;           /* IFF_* flags of the link */
+	unsigned short hw_type;       /* ARPHRD_* type of the link */
+	unsigned char hw_addr[6];     /* hardware address of the link, zeros if it has none */
+	unsigned char prefixlen;
+	union {
+		struct in_addr in;
+		struct in6_addr in6;
+	} addr;
+	bool has_broadcast;
+	struct in_addr broadcast;
+};
+
+struct oval_net_route {
+	char dst[INET6_ADDRSTRLEN];
+	char gw[INET6_ADDRSTRLEN];
+	unsigned int flags;           /* RTF_* flags */
+	char if_name[IFNAMSIZ];
+};
+
+/**
+ * Get the snapshot, taking the parts of it the caller wants which aren't
+ * taken yet. It has to be released by oval_net_cache_release.
+ * @param what OVAL_NET_CACHE_* flags
+ * @return the snapshot or NULL with errno set if some part can't be taken
+ */
+oval_net_cache_t *oval_net_cache_acquire(unsigned int what);
+
+void oval_net_cache_release(oval_net_cache_t *net);
+
+/**
+ * Get the i-th address in the order the kernel reports them.
+ * @return the address or NULL past the last one
+ */
+const struct oval_net_addr *oval_net_cache_addr(const oval_net_cache_t *net, size_t i);
+
+/**
+ * Get the i-th route of the IPv4 (AF_INET) or IPv6 (AF_INET6) table.
+ * @return the route or NULL past the last one
+ */
+const struct oval_net_route *oval_net_cache_route(const oval_net_cache_t *net, int family, size_t i);
+
+/**
+ * Drop the snapshot. Snapshots still held are freed on release.
+ */
+void oval_net_cache_reset(void);
+
+#endif /* OVAL_NET_CACHE_H */
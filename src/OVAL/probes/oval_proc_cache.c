@@ -0,0 +1,593 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <pthread.h>
+
+#include "common/debug_priv.h"
+#include "SEAP/generic/rbt/rbt.h"
+#include "oval_proc_cache.h"
+
+/* default of OSCAP_PROC_CACHE_ENVIRON_SIZE in MiB */
+#define OVAL_PROC_CACHE_ENVIRON_SIZE_DEFAULT 64
+#define OVAL_PROC_READ_CHUNK                 4096
+
+/* what was read already */
+#define OVAL_PROC_STAT    0x01
+#define OVAL_PROC_UIDS    0x02
+#define OVAL_PROC_CMDLINE 0x04
+#define OVAL_PROC_ENVIRON 0x08
+#define OVAL_PROC_SOCKETS 0x10
+
+struct oval_proc_entry {
+	unsigned int loaded;
+	int stat_ret;
+	struct oval_proc_stat stat;
+	int uids_ret;
+	int ruid, euid;
+	char *cmdline;
+	char *environ_data;
+	size_t environ_size;
+	int environ_errno;       /* 0 if environ_data is set */
+	int sockets_ret;
+	unsigned long *inodes;
+	size_t inode_count;
+};
+
+static pthread_mutex_t proc_lock = PTHREAD_MUTEX_INITIALIZER;
+static rbt_t *proc_table = NULL;  /* pid -> struct oval_proc_entry */
+static int *proc_pids = NULL;
+static size_t proc_pid_count = 0;
+static bool proc_pids_loaded = false;
+static size_t environ_bytes = 0;
+static size_t environ_budget = 0;
+static bool environ_budget_set = false;
+
+static const char *oval_proc_prefix(void)
+{
+	const char *prefix = getenv("OSCAP_PROBE_ROOT");
+
+	return prefix != NULL ? prefix : "";
+}
+
+/* must be called with proc_lock held */
+static struct oval_proc_entry *oval_proc_entry_get(int pid)
+{
+	struct oval_proc_entry *entry = NULL;
+
+	if (proc_table == NULL)
+		proc_table = rbt_i64_new();
+	if (rbt_i64_get(proc_table, pid, (void **)&entry) == 0)
+		return entry;
+
+	entry = calloc(1, sizeof(struct oval_proc_entry));
+	if (entry == NULL)
+		return NULL;
+	if (rbt_i64_add(proc_table, pid, entry, NULL) != 0) {
+		free(entry);
+		return NULL;
+	}
+	return entry;
+}
+
+/* must be called with proc_lock held */
+static size_t oval_proc_environ_budget(void)
+{
+	if (!environ_budget_set) {
+		const char *env = getenv("OSCAP_PROC_CACHE_ENVIRON_SIZE");
+		unsigned long mib = OVAL_PROC_CACHE_ENVIRON_SIZE_DEFAULT;
+
+		if (env != NULL) {
+			char *end;
+
+			errno = 0;
+			mib = strtoul(env, &end, 10);
+			if (errno != 0 || end == env || *end != '\0') {
+				dW("Invalid value of OSCAP_PROC_CACHE_ENVIRON_SIZE: '%s', using %d.",
+				   env, OVAL_PROC_CACHE_ENVIRON_SIZE_DEFAULT);
+				mib = OVAL_PROC_CACHE_ENVIRON_SIZE_DEFAULT;
+			}
+		}
+		environ_budget = mib > SIZE_MAX / (1024 * 1024) ? SIZE_MAX : mib * 1024 * 1024;
+		environ_budget_set = true;
+	}
+
+	return environ_budget;
+}
+
+/* read a whole /proc file, they don't report their size */
+static char *oval_proc_read(int pid, const char *name, size_t *size)
+{
+	char path[PATH_MAX], *data = NULL;
+	size_t used = 0, alloc = 0;
+	int fd;
+
+	snprintf(path, sizeof(path), "%s/proc/%d/%s", oval_proc_prefix(), pid, name);
+	fd = open(path, O_RDONLY);
+	if (fd == -1)
+		return NULL;
+
+	for (;;) {
+		ssize_t nread;
+
+		if (alloc - used < OVAL_PROC_READ_CHUNK + 1) {
+			char *new_data = realloc(data, alloc + OVAL_PROC_READ_CHUNK + 1);
+
+			if (new_data == NULL) {
+				free(data);
+				close(fd);
+				errno = ENOMEM;
+				return NULL;
+			}
+			data = new_data;
+			alloc += OVAL_PROC_READ_CHUNK + 1;
+		}
+		nread = read(fd, data + used, alloc - used - 1);
+		if (nread == -1 && errno == EINTR)
+			continue;
+		if (nread == -1) {
+			int saved_errno = errno;
+
+			free(data);
+			close(fd);
+			errno = saved_errno;
+			return NULL;
+		}
+		if (nread == 0)
+			break;
+		used += nread;
+	}
+	close(fd);
+
+	data[used] = '\0';
+	*size = used;
+	return data;
+}
+
+int oval_proc_cache_pids(int **pids, size_t *count)
+{
+	int *list = NULL;
+	size_t n = 0, alloc = 0;
+	char path[PATH_MAX];
+	struct dirent *ent;
+	DIR *d;
+
+	pthread_mutex_lock(&proc_lock);
+	if (proc_pids_loaded)
+		goto copy;
+	pthread_mutex_unlock(&proc_lock);
+
+	snprintf(path, sizeof(path), "%s/proc", oval_proc_prefix());
+	d = opendir(path);
+	if (d == NULL)
+		return -1;
+	while ((ent = readdir(d)) != NULL) {
+		char *end;
+		long pid;
+
+		if (ent->d_name[0] < '0' || ent->d_name[0] > '9')
+			continue;
+		errno = 0;
+		pid = strtol(ent->d_name, &end, 10);
+		if (errno != 0 || *end != '\0' || pid > INT_MAX)
+			continue;
+		if (n == alloc) {
+			int *new_list = realloc(list, (alloc + 256) * sizeof(int));
+
+			if (new_list == NULL)
+				break;
+			list = new_list;
+			alloc += 256;
+		}
+		list[n++] = (int)pid;
+	}
+	closedir(d);
+
+	pthread_mutex_lock(&proc_lock);
+	if (!proc_pids_loaded) {
+		proc_pids = list;
+		proc_pid_count = n;
+		proc_pids_loaded = true;
+		dD("Listed %zu processes in %s.", n, path);
+	} else {
+		free(list);
+	}
+copy:
+	*count = proc_pid_count;
+	*pids = malloc((proc_pid_count > 0 ? proc_pid_count : 1) * sizeof(int));
+	if (*pids != NULL && proc_pid_count > 0)
+		memcpy(*pids, proc_pids, proc_pid_count * sizeof(int));
+	pthread_mutex_unlock(&proc_lock);
+
+	return *pids != NULL ? 0 : -1;
+}
+
+static int oval_proc_parse_stat(int pid, struct oval_proc_stat *st)
+{
+	unsigned long minflt, cminflt, majflt, cmajflt;
+	long cutime, cstime, cnice, nthreads, itrealvalue;
+	unsigned flags;
+	int tpgid, scanned_pid;
+	char *data, *tmp;
+	size_t size;
+
+	memset(st, 0, sizeof(*st));
+	data = oval_proc_read(pid, "stat", &size);
+	if (data == NULL)
+		return -1;
+	if (size < 40 || (tmp = strrchr(data, ')')) == NULL) {
+		free(data);
+		return -1;
+	}
+	*tmp = '\0';
+
+	/* the command name may contain spaces and parentheses */
+	sscanf(data, "%d (%15c", &scanned_pid, st->comm);
+	sscanf(tmp + 2, "%c %d %d %d %d %d "
+			"%u %lu %lu %lu %lu "
+			"%lu %lu %ld %ld %ld "
+			"%ld %ld %ld %llu",
+		&st->state, &st->ppid, &st->pgrp, &st->session, &st->tty_nr, &tpgid,
+		&flags, &minflt, &cminflt, &majflt, &cmajflt,
+		&st->utime, &st->stime, &cutime, &cstime, &st->priority,
+		&cnice, &nthreads, &itrealvalue, &st->start);
+	free(data);
+
+	return 0;
+}
+
+int oval_proc_cache_stat(int pid, struct oval_proc_stat *stat)
+{
+	struct oval_proc_entry *entry;
+	struct oval_proc_stat st;
+	int ret;
+
+	pthread_mutex_lock(&proc_lock);
+	entry = oval_proc_entry_get(pid);
+	if (entry != NULL && (entry->loaded & OVAL_PROC_STAT)) {
+		*stat = entry->stat;
+		ret = entry->stat_ret;
+		pthread_mutex_unlock(&proc_lock);
+		return ret;
+	}
+	pthread_mutex_unlock(&proc_lock);
+
+	ret = oval_proc_parse_stat(pid, &st);
+
+	pthread_mutex_lock(&proc_lock);
+	entry = oval_proc_entry_get(pid);
+	if (entry != NULL && !(entry->loaded & OVAL_PROC_STAT)) {
+		entry->stat = st;
+		entry->stat_ret = ret;
+		entry->loaded |= OVAL_PROC_STAT;
+	}
+	pthread_mutex_unlock(&proc_lock);
+
+	*stat = st;
+	return ret;
+}
+
+int oval_proc_cache_uids(int pid, int *ruid, int *euid)
+{
+	struct oval_proc_entry *entry;
+	char *data, *line;
+	size_t size;
+	int ret = -1, r = -1, e = -1;
+
+	pthread_mutex_lock(&proc_lock);
+	entry = oval_proc_entry_get(pid);
+	if (entry != NULL && (entry->loaded & OVAL_PROC_UIDS)) {
+		*ruid = entry->ruid;
+		*euid = entry->euid;
+		ret = entry->uids_ret;
+		pthread_mutex_unlock(&proc_lock);
+		return ret;
+	}
+	pthread_mutex_unlock(&proc_lock);
+
+	data = oval_proc_read(pid, "status", &size);
+	if (data != NULL) {
+		for (line = data; line != NULL; line = strchr(line, '\n')) {
+			if (*line == '\n')
+				++line;
+			if (strncmp(line, "Uid:", 4) == 0) {
+				if (sscanf(line, "Uid: %d %d", &r, &e) == 2)
+					ret = 0;
+				break;
+			}
+		}
+		free(data);
+	}
+
+	pthread_mutex_lock(&proc_lock);
+	entry = oval_proc_entry_get(pid);
+	if (entry != NULL && !(entry->loaded & OVAL_PROC_UIDS)) {
+		entry->ruid = r;
+		entry->euid = e;
+		entry->uids_ret = ret;
+		entry->loaded |= OVAL_PROC_UIDS;
+	}
+	pthread_mutex_unlock(&proc_lock);
+
+	*ruid = r;
+	*euid = e;
+	return ret;
+}
+
+/* ps-like form of the NUL separated arguments, NULL if there are none */
+static char *oval_proc_format_cmdline(char *data, size_t size)
+{
+	ssize_t i;
+
+	if (size == 0) {
+		free(data);
+		return NULL;
+	}
+
+	// Skip multiple trailing zeros
+	i = size - 1;
+	while (i > 0 && data[i] == '\0')
+		--i;
+	data[i + 1] = '\0';
+
+	// Program and args are separated by '\0'
+	// Replace them with spaces ' '
+	for (; i >= 0; --i) {
+		char chr = data[i];
+
+		if (chr == '\0' || chr == '\n')
+			data[i] = ' ';
+		else if (!isprint((unsigned char)chr)) // "ps" replace non-printable characters with '.' (LC_ALL=C)
+			data[i] = '.';
+	}
+
+	return data;
+}
+
+char *oval_proc_cache_cmdline(int pid)
+{
+	struct oval_proc_entry *entry;
+	char *data, *cmdline;
+	size_t size;
+
+	pthread_mutex_lock(&proc_lock);
+	entry = oval_proc_entry_get(pid);
+	if (entry != NULL && (entry->loaded & OVAL_PROC_CMDLINE)) {
+		cmdline = entry->cmdline != NULL ? strdup(entry->cmdline) : NULL;
+		pthread_mutex_unlock(&proc_lock);
+		return cmdline;
+	}
+	pthread_mutex_unlock(&proc_lock);
+
+	data = oval_proc_read(pid, "cmdline", &size);
+	cmdline = data != NULL ? oval_proc_format_cmdline(data, size) : NULL;
+
+	pthread_mutex_lock(&proc_lock);
+	entry = oval_proc_entry_get(pid);
+	if (entry != NULL && !(entry->loaded & OVAL_PROC_CMDLINE)) {
+		entry->cmdline = cmdline != NULL ? strdup(cmdline) : NULL;
+		entry->loaded |= OVAL_PROC_CMDLINE;
+	}
+	pthread_mutex_unlock(&proc_lock);
+
+	return cmdline;
+}
+
+char *oval_proc_cache_environ(int pid, size_t *size)
+{
+	struct oval_proc_entry *entry;
+	char *data;
+	int saved_errno;
+
+	pthread_mutex_lock(&proc_lock);
+	entry = oval_proc_entry_get(pid);
+	if (entry != NULL && (entry->loaded & OVAL_PROC_ENVIRON)) {
+		data = NULL;
+		if (entry->environ_data != NULL) {
+			data = malloc(entry->environ_size + 1);
+			if (data != NULL) {
+				memcpy(data, entry->environ_data, entry->environ_size + 1);
+				*size = entry->environ_size;
+			}
+		}
+		saved_errno = entry->environ_data != NULL ? ENOMEM : entry->environ_errno;
+		pthread_mutex_unlock(&proc_lock);
+		errno = saved_errno;
+		return data;
+	}
+	pthread_mutex_unlock(&proc_lock);
+
+	data = oval_proc_read(pid, "environ", size);
+	saved_errno = errno;
+
+	pthread_mutex_lock(&proc_lock);
+	entry = oval_proc_entry_get(pid);
+	if (entry != NULL && !(entry->loaded & OVAL_PROC_ENVIRON)) {
+		if (data == NULL) {
+			entry->environ_errno = saved_errno;
+			entry->loaded |= OVAL_PROC_ENVIRON;
+		} else if (environ_bytes + *size <= oval_proc_environ_budget()) {
+			entry->environ_data = malloc(*size + 1);
+			if (entry->environ_data != NULL) {
+				memcpy(entry->environ_data, data, *size + 1);
+				entry->environ_size = *size;
+				environ_bytes += *size;
+				entry->loaded |= OVAL_PROC_ENVIRON;
+			}
+		}
+	}
+	pthread_mutex_unlock(&proc_lock);
+
+	errno = saved_errno;
+	return data;
+}
+
+/* socket inode of a /proc/<pid>/fd/<n> link target, 0 if it's not a socket */
+static unsigned long oval_proc_socket_inode(char *line)
+{
+	char *s, *e;
+	unsigned long inode;
+
+	if (memcmp(line, "socket:", 7) == 0) {
+		// Type 1 sockets
+		s = strchr(line + 7, '[');
+		if (s == NULL)
+			return 0;
+		s++;
+		e = strchr(s, ']');
+		if (e == NULL)
+			return 0;
+		*e = 0;
+	} else if (memcmp(line, "[0000]:", 7) == 0) {
+		// Type 2 sockets
+		s = line + 8;
+	} else {
+		return 0;
+	}
+	errno = 0;
+	inode = strtoul(s, NULL, 10);
+	return errno == 0 ? inode : 0;
+}
+
+static int oval_proc_read_sockets(int pid, unsigned long **inodes, size_t *count)
+{
+	char path[PATH_MAX], link_path[PATH_MAX], line[256];
+	struct dirent *ent;
+	size_t alloc = 0;
+	DIR *d;
+
+	*inodes = NULL;
+	*count = 0;
+	snprintf(path, sizeof(path), "%s/proc/%d/fd", oval_proc_prefix(), pid);
+	d = opendir(path);
+	if (d == NULL)
+		return -1;
+
+	while ((ent = readdir(d)) != NULL) {
+		unsigned long inode;
+		ssize_t lnlen;
+
+		if (ent->d_name[0] == '.')
+			continue;
+		if (snprintf(link_path, sizeof(link_path), "%s/%s", path, ent->d_name) >= (int)sizeof(link_path))
+			continue;
+		lnlen = readlink(link_path, line, sizeof(line) - 1);
+		if (lnlen < 0)
+			continue;
+		line[lnlen] = '\0';
+
+		inode = oval_proc_socket_inode(line);
+		if (inode == 0)
+			continue;
+		if (*count == alloc) {
+			unsigned long *new_inodes = realloc(*inodes, (alloc + 16) * sizeof(unsigned long));
+
+			if (new_inodes == NULL)
+				break;
+			*inodes = new_inodes;
+			alloc += 16;
+		}
+		(*inodes)[(*count)++] = inode;
+	}
+	closedir(d);
+
+	return 0;
+}
+
+int oval_proc_cache_socket_inodes(int pid, unsigned long **inodes, size_t *count)
+{
+	struct oval_proc_entry *entry;
+	unsigned long *list;
+	size_t n;
+	int ret;
+
+	pthread_mutex_lock(&proc_lock);
+	entry = oval_proc_entry_get(pid);
+	if (entry == NULL || !(entry->loaded & OVAL_PROC_SOCKETS)) {
+		pthread_mutex_unlock(&proc_lock);
+
+		ret = oval_proc_read_sockets(pid, &list, &n);
+
+		pthread_mutex_lock(&proc_lock);
+		entry = oval_proc_entry_get(pid);
+		if (entry != NULL && !(entry->loaded & OVAL_PROC_SOCKETS)) {
+			entry->inodes = list;
+			entry->inode_count = n;
+			entry->sockets_ret = ret;
+			entry->loaded |= OVAL_PROC_SOCKETS;
+			list = NULL;
+		}
+		if (entry == NULL) {
+			pthread_mutex_unlock(&proc_lock);
+			*inodes = list;
+			*count = n;
+			return ret;
+		}
+		free(list);
+	}
+
+	ret = entry->sockets_ret;
+	*count = entry->inode_count;
+	*inodes = malloc((entry->inode_count > 0 ? entry->inode_count : 1) * sizeof(unsigned long));
+	if (*inodes == NULL)
+		ret = -1;
+	else if (entry->inode_count > 0)
+		memcpy(*inodes, entry->inodes, entry->inode_count * sizeof(unsigned long));
+	pthread_mutex_unlock(&proc_lock);
+
+	return ret;
+}
+
+static void oval_proc_entry_free(struct rbt_i64_node *n)
+{
+	struct oval_proc_entry *entry = n->data;
+
+	free(entry->cmdline);
+	free(entry->environ_data);
+	free(entry->inodes);
+	free(entry);
+}
+
+void oval_proc_cache_reset(void)
+{
+	pthread_mutex_lock(&proc_lock);
+	if (proc_table != NULL)
+		rbt_i64_free_cb(proc_table, &oval_proc_entry_free);
+	proc_table = NULL;
+	free(proc_pids);
+	proc_pids = NULL;
+	proc_pid_count = 0;
+	proc_pids_loaded = false;
+	environ_bytes = 0;
+	pthread_mutex_unlock(&proc_lock);
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+#ifndef OVAL_PROC_CACHE_H
+#define OVAL_PROC_CACHE_H
+
+#include <stddef.h>
+
+/*
+ * Snapshot of /proc shared by the probes looking at processes during one
+ * scan (process58, environmentvariable58, inetlisteningservers). The list
+ * of the processes is read on the first lookup, the files of a process are
+ * read when some probe asks for them and kept, so further objects of any
+ * of the probes don't read /proc of thousands of processes again. The paths
+ * are prefixed with OSCAP_PROBE_ROOT. Everything is dropped after each
+ * remediation fix and when the last probe session ends.
+ *
+ * The environments are kept up to OSCAP_PROC_CACHE_ENVIRON_SIZE bytes in
+ * total, 64 MiB by default; the rest is read again on each lookup.
+ */
+
+/* parsed /proc/<pid>/stat */
+struct oval_proc_stat {
+	char comm[16];       /* command name, up to 15 characters */
+	char state;
+	int ppid;
+	int pgrp;
+	int session;
+	int tty_nr;
+	unsigned long utime; /* in clock ticks */
+	unsigned long stime;
+	long priority;
+	unsigned long long start; /* in clock ticks after boot */
+};
+
+/**
+ * Get the process IDs listed in /proc.
+ * @param pids the IDs, to be freed by the caller
+ * @return 0 on success, -1 with errno set if /proc can't be read
+ */
+int oval_proc_cache_pids(int **pids, size_t *count);
+
+/**
+ * Get the parsed stat file of a process.
+ * @return 0 on success, -1 if the process is gone or the file is malformed
+ */
+int oval_proc_cache_stat(int pid, struct oval_proc_stat *stat);
+
+/**
+ * Get the real and effective user ID of a process from its status file.
+ * @return 0 on success, -1 if they can't be read
+ */
+int oval_proc_cache_uids(int pid, int *ruid, int *euid);
+
+/**
+ * Get the command line of a process formatted like ps(1) does: arguments
+ * separated by spaces and nonprintable characters replaced by dots.
+ * @return the command line to be freed by the caller, NULL if the process
+ * has none (kernel threads, zombies) or is gone
+ */
+char *oval_proc_cache_cmdline(int pid);
+
+/**
+ * Get the raw environ file of a process, NUL separated NAME=VALUE strings.
+ * @param size size of the data
+ * @return the data to be freed by the caller, NULL with errno set if the
+ * file can't be read
+ */
+char *oval_proc_cache_environ(int pid, size_t *size);
+
+/**
+ * Get the inodes of the sockets opened by a process.
+ * @param inodes the inodes, to be freed by the caller
+ * @return 0 on success, -1 if the descriptors of the process can't be read
+ */
+int oval_proc_cache_socket_inodes(int pid, unsigned long **inodes, size_t *count);
+
+/**
+ * Drop the snapshot.
+ */
+void oval_proc_cache_reset(void);
+
+#endif /* OVAL_PROC_CACHE_H */
@@ -0,0 +1,250 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "common/list.h"
+#include "common/debug_priv.h"
+#include "oval_realpath_cache.h"
+
+#define OVAL_REALPATH_HSIZE 4099
+
+struct oval_realpath_entry {
+	int err;     /* errno of the resolution, 0 on success */
+	bool dir;    /* the path is a directory */
+	char *path;  /* the canonical path, "" is the root */
+};
+
+static pthread_mutex_t realpath_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct oscap_htable *realpath_table = NULL; /* path with a canonical parent -> struct oval_realpath_entry */
+
+static void oval_realpath_entry_free(void *ptr)
+{
+	struct oval_realpath_entry *entry = ptr;
+
+	free(entry->path);
+	free(entry);
+}
+
+static bool oval_realpath_lookup(const char *key, char *out, bool *dir, int *err)
+{
+	struct oval_realpath_entry *entry;
+
+	pthread_mutex_lock(&realpath_lock);
+	entry = realpath_table != NULL ? oscap_htable_get(realpath_table, key) : NULL;
+	if (entry != NULL) {
+		*err = entry->err;
+		*dir = entry->dir;
+		if (entry->err == 0)
+			strcpy(out, entry->path);
+	}
+	pthread_mutex_unlock(&realpath_lock);
+
+	return entry != NULL;
+}
+
+static void oval_realpath_store(const char *key, const char *path, bool dir, int err)
+{
+	struct oval_realpath_entry *entry;
+
+	entry = malloc(sizeof(struct oval_realpath_entry));
+	if (entry == NULL)
+		return;
+	entry->err = err;
+	entry->dir = dir;
+	entry->path = err == 0 ? strdup(path) : NULL;
+	if (err == 0 && entry->path == NULL) {
+		free(entry);
+		return;
+	}
+
+	pthread_mutex_lock(&realpath_lock);
+	if (realpath_table == NULL)
+		realpath_table = oscap_htable_new1(strcmp, OVAL_REALPATH_HSIZE);
+	/* resolved by another thread meanwhile if it fails */
+	if (realpath_table == NULL || !oscap_htable_add(realpath_table, key, entry))
+		oval_realpath_entry_free(entry);
+	pthread_mutex_unlock(&realpath_lock);
+}
+
+static int oval_realpath_path(const char *root, const char *base, const char *path, char *out, bool *dir, int links);
+
+/*
+ * Resolve the name in the canonical directory parent, the result is
+ * stored in out (PATH_MAX bytes). The canonical paths have no links, so
+ * prepending the root to them is enough to stay inside of it.
+ */
+static int oval_realpath_component(const char *root, const char *parent, const char *name, char *out, bool *dir, int links)
+{
+	char key[PATH_MAX], target[PATH_MAX], rooted[PATH_MAX];
+	const char *sys_key = key;
+	struct stat st;
+	ssize_t len;
+	int err;
+
+	if (snprintf(key, sizeof(key), "%s/%s", parent, name) >= (int)sizeof(key))
+		return ENAMETOOLONG;
+	/* the entries are stored under the path in the system, it is unique across roots */
+	if (root != NULL) {
+		if (snprintf(rooted, sizeof(rooted), "%s%s", root, key) >= (int)sizeof(rooted))
+			return ENAMETOOLONG;
+		sys_key = rooted;
+	}
+	if (oval_realpath_lookup(sys_key, out, dir, &err))
+		return err;
+
+	*dir = false;
+	if (lstat(sys_key, &st) != 0) {
+		err = errno;
+	} else if (!S_ISLNK(st.st_mode)) {
+		strcpy(out, key);
+		*dir = S_ISDIR(st.st_mode);
+		err = 0;
+	} else if (links >= OVAL_REALPATH_MAXLINKS) {
+		/* not stored, a shorter chain may lead to it */
+		return ELOOP;
+	} else if ((len = readlink(sys_key, target, sizeof(target) - 1)) < 0) {
+		err = errno;
+	} else {
+		target[len] = '\0';
+		err = oval_realpath_path(root, parent, target, out, dir, links + 1);
+		if (err == ELOOP)
+			return err;
+	}
+
+	oval_realpath_store(sys_key, out, *dir, err);
+	return err;
+}
+
+/*
+ * Resolve the path relative to the canonical directory base ("" is the
+ * root), the result is stored in out (PATH_MAX bytes).
+ */
+static int oval_realpath_path(const char *root, const char *base, const char *path, char *out, bool *dir, int links)
+{
+	char res[PATH_MAX], name[NAME_MAX + 1];
+	const char *p = path, *end;
+	size_t len;
+	bool res_dir = true;
+	int err;
+
+	if (*path == '/')
+		res[0] = '\0';
+	else
+		strcpy(res, base);
+
+	while (*p != '\0') {
+		while (*p == '/')
+			++p;
+		if (*p == '\0')
+			break;
+		end = strchr(p, '/');
+		if (end == NULL)
+			end = p + strlen(p);
+		len = end - p;
+		if (len > NAME_MAX)
+			return ENAMETOOLONG;
+
+		/* a component followed by more has to be a directory */
+		if (!res_dir)
+			return ENOTDIR;
+
+		if (len == 1 && p[0] == '.') {
+			/* nothing to do */
+		} else if (len == 2 && p[0] == '.' && p[1] == '.') {
+			char *slash = strrchr(res, '/');
+
+			if (slash != NULL)
+				*slash = '\0';
+		} else {
+			memcpy(name, p, len);
+			name[len] = '\0';
+			err = oval_realpath_component(root, res, name, res, &res_dir, links);
+			if (err != 0)
+				return err;
+		}
+		p = end;
+	}
+	if (!res_dir && path[strlen(path) - 1] == '/')
+		return ENOTDIR;
+
+	strcpy(out, res);
+	*dir = res_dir;
+	return 0;
+}
+
+char *oval_realpath_cache_resolve(const char *path, char *resolved_path)
+{
+	return oval_realpath_cache_resolve_in(NULL, path, resolved_path);
+}
+
+char *oval_realpath_cache_resolve_in(const char *root, const char *path, char *resolved_path)
+{
+	char cwd[PATH_MAX], out[PATH_MAX];
+	const char *base = "";
+	bool dir;
+	int err;
+
+	if (path == NULL) {
+		errno = EINVAL;
+		return NULL;
+	}
+	if (*path == '\0') {
+		errno = ENOENT;
+		return NULL;
+	}
+	if (*path != '/' && root == NULL) {
+		if (getcwd(cwd, sizeof(cwd)) == NULL)
+			return NULL;
+		base = strcmp(cwd, "/") == 0 ? "" : cwd;
+	}
+
+	err = oval_realpath_path(root, base, path, out, &dir, 0);
+	if (err != 0) {
+		errno = err;
+		return NULL;
+	}
+	if (out[0] == '\0')
+		strcpy(out, "/");
+
+	if (resolved_path == NULL)
+		return strdup(out);
+	strcpy(resolved_path, out);
+	return resolved_path;
+}
+
+void oval_realpath_cache_reset(void)
+{
+	pthread_mutex_lock(&realpath_lock);
+	oscap_htable_free(realpath_table, oval_realpath_entry_free);
+	realpath_table = NULL;
+	pthread_mutex_unlock(&realpath_lock);
+}
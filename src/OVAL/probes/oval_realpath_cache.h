@@ -0,0 +1,57 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+#ifndef OVAL_REALPATH_CACHE_H
+#define OVAL_REALPATH_CACHE_H
+
+/*
+ * Canonical paths of the files the probes of one scan resolve. A path is
+ * resolved a component at a time and the canonical path of each prefix
+ * is kept, so the links shared by many paths (e.g. /lib -> usr/lib or the
+ * /etc/alternatives chains) are read once per scan. Following more than
+ * OVAL_REALPATH_MAXLINKS links fails with ELOOP like realpath(3) does.
+ * Everything is dropped after each remediation fix and when the last
+ * probe session ends.
+ */
+
+#define OVAL_REALPATH_MAXLINKS 40
+
+/**
+ * Resolve a path like realpath(3).
+ * @param resolved_path buffer of PATH_MAX bytes, or NULL to allocate
+ * the result which the caller frees then
+ * @return the resolved path or NULL with errno set
+ */
+char *oval_realpath_cache_resolve(const char *path, char *resolved_path);
+
+/**
+ * Resolve a path of the system under the given root, as realpath(3) would
+ * after chroot(2) to it: absolute links and ".." don't leave the root.
+ * The resolved path is relative to the root. The resolved paths are
+ * shared with oval_realpath_cache_resolve(), a scan has only one root.
+ * @param root the root directory or NULL for the root of the process,
+ * relative paths are taken from the root then
+ */
+char *oval_realpath_cache_resolve_in(const char *root, const char *path, char *resolved_path);
+
+/**
+ * Drop the resolved paths.
+ */
+void oval_realpath_cache_reset(void);
+
+#endif /* OVAL_REALPATH_CACHE_H */
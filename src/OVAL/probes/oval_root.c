@@ -0,0 +1,293 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <pthread.h>
+#if defined(HAVE_LINUX_OPENAT2_H)
+#include <linux/openat2.h>
+#include <sys/syscall.h>
+#endif
+
+#include "common/util.h"
+#include "common/debug_priv.h"
+#include "oval_realpath_cache.h"
+#include "oval_root.h"
+
+#if defined(HAVE_LINUX_OPENAT2_H) && defined(SYS_openat2) && defined(O_PATH)
+# define OVAL_ROOT_OPENAT2
+#endif
+
+static inline bool oval_root_none(const char *root)
+{
+	return root == NULL || *root == '\0';
+}
+
+#if defined(OVAL_ROOT_OPENAT2)
+static pthread_mutex_t root_lock = PTHREAD_MUTEX_INITIALIZER;
+static char *root_path = NULL;
+static int root_fd = -1;
+static volatile bool openat2_missing = false;
+
+/*
+ * A descriptor of the root, the caller closes it. It is a duplicate of the
+ * cached one, which a scan of another root may close in the meantime.
+ * @return the descriptor, -1 if the root can't be opened
+ */
+static int oval_root_fd(const char *root)
+{
+	int fd = -1;
+
+	pthread_mutex_lock(&root_lock);
+	if (root_path == NULL || strcmp(root_path, root) != 0) {
+		/* another root is scanned after the previous scan ended */
+		if (root_fd != -1)
+			close(root_fd);
+		free(root_path);
+		root_path = strdup(root);
+		root_fd = open(root, O_PATH | O_DIRECTORY | O_CLOEXEC);
+		if (root_fd == -1)
+			dW("Can't open the root directory '%s': %s.", root, strerror(errno));
+	}
+	if (root_fd != -1)
+		fd = fcntl(root_fd, F_DUPFD_CLOEXEC, 0);
+	pthread_mutex_unlock(&root_lock);
+
+	return fd;
+}
+
+/*
+ * openat2(2) of the path inside the root.
+ * @return the descriptor, -1 with errno set or -2 if the kernel can't do it
+ */
+static int oval_root_openat2(const char *root, const char *path, int flags)
+{
+	struct open_how how;
+	int dirfd, fd, err;
+
+	if (openat2_missing || (dirfd = oval_root_fd(root)) == -1)
+		return -2;
+
+	memset(&how, 0, sizeof(how));
+	how.flags = (uint64_t)(flags | O_CLOEXEC);
+	how.resolve = RESOLVE_IN_ROOT | RESOLVE_NO_MAGICLINKS;
+
+	fd = (int)syscall(SYS_openat2, dirfd, *path != '\0' ? path : "/", &how, sizeof(how));
+	err = errno;
+	close(dirfd);
+
+	if (fd == -1 && err == ENOSYS) {
+		dI("openat2() is not available, the paths in the root are resolved by the probes.");
+		openat2_missing = true;
+		return -2;
+	}
+	/*
+	 * Seccomp filters of containers fail unknown system calls with EPERM,
+	 * the path is resolved by the probes then. A genuine EPERM is reported
+	 * again by that resolution. It is decided for each call, one denial
+	 * doesn't turn RESOLVE_IN_ROOT off for the rest of the process.
+	 */
+	if (fd == -1 && err == EPERM)
+		return -2;
+
+	errno = err;
+	return fd;
+}
+#else
+static int oval_root_openat2(const char *root, const char *path, int flags)
+{
+	return -2;
+}
+#endif
+
+/*
+ * The host path of the file of the root. The directories are resolved in
+ * the root, the last component too if follow is true. NULL with errno set.
+ */
+static char *oval_root_resolve(const char *root, const char *path, bool follow)
+{
+	char resolved[PATH_MAX];
+	const char *name;
+	char *dir, *host;
+
+	name = strrchr(path, '/');
+	name = name != NULL ? name + 1 : path;
+	if (follow || *name == '\0' || strcmp(name, ".") == 0 || strcmp(name, "..") == 0) {
+		if (oval_realpath_cache_resolve_in(root, path, resolved) == NULL)
+			return NULL;
+		return oscap_path_join(root, resolved);
+	}
+
+	dir = strndup(path, name - path);
+	if (dir == NULL)
+		return NULL;
+	if (oval_realpath_cache_resolve_in(root, *dir != '\0' ? dir : "/", resolved) == NULL) {
+		free(dir);
+		return NULL;
+	}
+	free(dir);
+
+	dir = oscap_path_join(root, resolved);
+	host = oscap_path_join(dir, name);
+	free(dir);
+	return host;
+}
+
+int oval_root_open(const char *root, const char *path, int flags)
+{
+	char *host;
+	int fd, err;
+
+	if (oval_root_none(root))
+		return open(path, flags);
+
+	fd = oval_root_openat2(root, path, flags);
+	if (fd != -2)
+		return fd;
+
+	host = oval_root_resolve(root, path, !(flags & O_NOFOLLOW));
+	if (host == NULL)
+		return -1;
+	fd = open(host, flags);
+	err = errno;
+	free(host);
+	errno = err;
+
+	return fd;
+}
+
+FILE *oval_root_fopen(const char *root, const char *path)
+{
+	FILE *fp;
+	int fd;
+
+	fd = oval_root_open(root, path, O_RDONLY);
+	if (fd == -1)
+		return NULL;
+	fp = fdopen(fd, "r");
+	if (fp == NULL)
+		close(fd);
+
+	return fp;
+}
+
+DIR *oval_root_opendir(const char *root, const char *path)
+{
+	DIR *dp;
+	int fd;
+
+	if (oval_root_none(root))
+		return opendir(path);
+
+	fd = oval_root_open(root, path, O_RDONLY | O_DIRECTORY);
+	if (fd == -1)
+		return NULL;
+	dp = fdopendir(fd);
+	if (dp == NULL)
+		close(fd);
+
+	return dp;
+}
+
+static int oval_root_stat_common(const char *root, const char *path, struct stat *st, bool follow)
+{
+	char *host;
+	int ret, err;
+
+#if defined(OVAL_ROOT_OPENAT2)
+	int fd = oval_root_openat2(root, path, O_PATH | (follow ? 0 : O_NOFOLLOW));
+
+	if (fd == -1)
+		return -1;
+	if (fd >= 0) {
+		/* the descriptor of a link made with O_NOFOLLOW is the link itself */
+		ret = fstat(fd, st);
+		err = errno;
+		close(fd);
+		errno = err;
+		return ret;
+	}
+#endif
+	host = oval_root_resolve(root, path, follow);
+	if (host == NULL)
+		return -1;
+	ret = follow ? stat(host, st) : lstat(host, st);
+	err = errno;
+	free(host);
+	errno = err;
+
+	return ret;
+}
+
+int oval_root_stat(const char *root, const char *path, struct stat *st)
+{
+	if (oval_root_none(root))
+		return stat(path, st);
+	return oval_root_stat_common(root, path, st, true);
+}
+
+int oval_root_lstat(const char *root, const char *path, struct stat *st)
+{
+	if (oval_root_none(root))
+		return lstat(path, st);
+	return oval_root_stat_common(root, path, st, false);
+}
+
+ssize_t oval_root_readlink(const char *root, const char *path, char *buf, size_t size)
+{
+	char *host;
+	ssize_t ret;
+	int err;
+
+	if (oval_root_none(root))
+		return readlink(path, buf, size);
+
+#if defined(OVAL_ROOT_OPENAT2)
+	int fd = oval_root_openat2(root, path, O_PATH | O_NOFOLLOW);
+
+	if (fd == -1)
+		return -1;
+	if (fd >= 0) {
+		ret = readlinkat(fd, "", buf, size);
+		err = errno;
+		close(fd);
+		errno = err;
+		return ret;
+	}
+#endif
+	host = oval_root_resolve(root, path, false);
+	if (host == NULL)
+		return -1;
+	ret = readlink(host, buf, size);
+	err = errno;
+	free(host);
+	errno = err;
+
+	return ret;
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+#ifndef OVAL_ROOT_H
+#define OVAL_ROOT_H
+
+#include <stdio.h>
+#include <dirent.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+/*
+ * Access to the files of an offline system for the probes running in the
+ * PROBE_OFFLINE_OWN mode. The paths are resolved inside the root as if the
+ * process was chroot-ed to it: absolute links and ".." don't leave the
+ * root. On Linux with openat2(2) it is done by the kernel with
+ * RESOLVE_IN_ROOT relative to a descriptor of the root, otherwise the
+ * directories are resolved by oval_realpath_cache_resolve_in(). Nothing
+ * of the state of the process changes, so the probe threads collect from
+ * the root at the same time.
+ *
+ * The root is usually getenv("OSCAP_PROBE_ROOT"). With a NULL or empty
+ * root the functions are the plain system calls.
+ */
+
+/**
+ * open(2) a file of the root, without O_CREAT.
+ */
+int oval_root_open(const char *root, const char *path, int flags);
+
+/**
+ * Open a file of the root for reading.
+ */
+FILE *oval_root_fopen(const char *root, const char *path);
+
+/**
+ * opendir(3) a directory of the root.
+ */
+DIR *oval_root_opendir(const char *root, const char *path);
+
+/**
+ * stat(2) a file of the root.
+ */
+int oval_root_stat(const char *root, const char *path, struct stat *st);
+
+/**
+ * lstat(2) a file of the root.
+ */
+int oval_root_lstat(const char *root, const char *path, struct stat *st);
+
+/**
+ * readlink(2) a link of the root, the target is as it is in the link.
+ */
+ssize_t oval_root_readlink(const char *root, const char *path, char *buf, size_t size);
+
+#endif /* OVAL_ROOT_H */
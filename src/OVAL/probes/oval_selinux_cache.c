@@ -0,0 +1,171 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <selinux/selinux.h>
+
+#include "common/list.h"
+#include "common/debug_priv.h"
+#include "oval_selinux_cache.h"
+
+#define OVAL_SELINUX_HSIZE 4099
+
+struct oval_selinux_entry {
+	int err;           /* errno of the lookup, 0 if it succeeded */
+	const char *con;   /* translated label owned by trans_table */
+};
+
+static pthread_mutex_t selinux_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct oscap_htable *file_table = NULL;  /* path -> struct oval_selinux_entry */
+static struct oscap_htable *pid_table = NULL;   /* pid -> struct oval_selinux_entry */
+static struct oscap_htable *trans_table = NULL; /* raw label -> translated label */
+
+/* must be called with selinux_lock held */
+static const char *oval_selinux_trans(const char *raw)
+{
+	char *trans, *con;
+
+	if (trans_table == NULL)
+		trans_table = oscap_htable_new1(strcmp, 257);
+	con = oscap_htable_get(trans_table, raw);
+	if (con != NULL)
+		return con;
+
+	if (selinux_raw_to_trans_context(raw, &trans) == 0) {
+		con = strdup(trans);
+		freecon(trans);
+	} else {
+		con = strdup(raw);
+	}
+	if (con != NULL && !oscap_htable_add(trans_table, raw, con)) {
+		free(con);
+		return NULL;
+	}
+	return con;
+}
+
+/* must be called with selinux_lock held */
+static int oval_selinux_lookup(struct oscap_htable *table, const char *key, char **con)
+{
+	struct oval_selinux_entry *entry;
+
+	entry = table != NULL ? oscap_htable_get(table, key) : NULL;
+	if (entry == NULL)
+		return 1;
+	if (entry->err != 0) {
+		errno = entry->err;
+		return -1;
+	}
+	*con = strdup(entry->con);
+	return *con != NULL ? 0 : -1;
+}
+
+/* must be called with selinux_lock held */
+static int oval_selinux_store(struct oscap_htable **table, const char *key, int err, char *raw, char **con)
+{
+	struct oval_selinux_entry *entry;
+
+	if (*table == NULL)
+		*table = oscap_htable_new1(strcmp, OVAL_SELINUX_HSIZE);
+
+	/* it may have been looked up by another thread meanwhile */
+	entry = *table != NULL ? oscap_htable_get(*table, key) : NULL;
+	if (entry == NULL && (entry = calloc(1, sizeof(struct oval_selinux_entry))) != NULL) {
+		entry->err = err;
+		if (err == 0) {
+			entry->con = oval_selinux_trans(raw);
+			if (entry->con == NULL)
+				entry->err = ENOMEM;
+		}
+		if (*table == NULL || !oscap_htable_add(*table, key, entry)) {
+			free(entry);
+			entry = NULL;
+		}
+	}
+	if (raw != NULL)
+		freecon(raw);
+
+	if (entry == NULL) {
+		errno = ENOMEM;
+		return -1;
+	}
+	return oval_selinux_lookup(*table, key, con);
+}
+
+int oval_selinux_cache_filecon(const char *path, char **con)
+{
+	char *raw = NULL;
+	int ret, err;
+
+	pthread_mutex_lock(&selinux_lock);
+	ret = oval_selinux_lookup(file_table, path, con);
+	pthread_mutex_unlock(&selinux_lock);
+	if (ret != 1)
+		return ret;
+
+	err = getfilecon_raw(path, &raw) == -1 ? errno : 0;
+
+	pthread_mutex_lock(&selinux_lock);
+	ret = oval_selinux_store(&file_table, path, err, raw, con);
+	pthread_mutex_unlock(&selinux_lock);
+
+	return ret;
+}
+
+int oval_selinux_cache_pidcon(int pid, char **con)
+{
+	char key[16], *raw = NULL;
+	int ret, err;
+
+	snprintf(key, sizeof(key), "%d", pid);
+
+	pthread_mutex_lock(&selinux_lock);
+	ret = oval_selinux_lookup(pid_table, key, con);
+	pthread_mutex_unlock(&selinux_lock);
+	if (ret != 1)
+		return ret;
+
+	err = getpidcon_raw(pid, &raw) == -1 ? errno : 0;
+
+	pthread_mutex_lock(&selinux_lock);
+	ret = oval_selinux_store(&pid_table, key, err, raw, con);
+	pthread_mutex_unlock(&selinux_lock);
+
+	return ret;
+}
+
+void oval_selinux_cache_reset(void)
+{
+	pthread_mutex_lock(&selinux_lock);
+	oscap_htable_free(file_table, free);
+	file_table = NULL;
+	oscap_htable_free(pid_table, free);
+	pid_table = NULL;
+	oscap_htable_free(trans_table, free);
+	trans_table = NULL;
+	pthread_mutex_unlock(&selinux_lock);
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+#ifndef OVAL_SELINUX_CACHE_H
+#define OVAL_SELINUX_CACHE_H
+
+/*
+ * SELinux labels of files and processes shared by the probes of one scan
+ * (selinuxsecuritycontext, process58). The raw label of a path or process
+ * is fetched once and the translation to the human readable form, which
+ * is a round trip to mcstransd, is done once per distinct raw label.
+ * Everything is dropped after each remediation fix and when the last
+ * probe session ends.
+ */
+
+/**
+ * Get the translated label of a file, following symlinks like getfilecon.
+ * @param path the path including OSCAP_PROBE_ROOT
+ * @param con the label to be freed by the caller
+ * @return 0 on success, -1 with errno set if the label can't be read
+ */
+int oval_selinux_cache_filecon(const char *path, char **con);
+
+/**
+ * Get the translated label of a process like getpidcon.
+ * @param con the label to be freed by the caller
+ * @return 0 on success, -1 with errno set if the label can't be read
+ */
+int oval_selinux_cache_pidcon(int pid, char **con);
+
+/**
+ * Drop the cached labels.
+ */
+void oval_selinux_cache_reset(void);
+
+#endif /* OVAL_SELINUX_CACHE_H */
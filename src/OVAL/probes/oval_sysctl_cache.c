@@ -0,0 +1,380 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "common/list.h"
+#include "common/debug_priv.h"
+#include "oval_sysctl_cache.h"
+
+#define PROC_SYS_DIR        "/proc/sys"
+#define PROC_SYS_MAXDEPTH   7
+#define OVAL_SYSCTL_HSIZE   4099
+
+struct oval_sysctl_names {
+	unsigned int refs;
+	size_t count;
+	size_t alloc;
+	char **mibs;
+};
+
+struct oval_sysctl_entry {
+	char *path;        /* NULL if there is no such sysctl */
+	bool loaded;       /* the value was read */
+	int ret;           /* see oval_sysctl_cache_value */
+	int err;
+	size_t len;
+	char *value;
+};
+
+static pthread_mutex_t sysctl_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct oscap_htable *sysctl_table = NULL; /* mib -> struct oval_sysctl_entry */
+static oval_sysctl_names_t *sysctl_names = NULL;
+
+static void oval_sysctl_entry_free(void *ptr)
+{
+	struct oval_sysctl_entry *entry = ptr;
+
+	free(entry->path);
+	free(entry->value);
+	free(entry);
+}
+
+static void oval_sysctl_names_free(oval_sysctl_names_t *names)
+{
+	size_t i;
+
+	for (i = 0; i < names->count; ++i)
+		free(names->mibs[i]);
+	free(names->mibs);
+	free(names);
+}
+
+/* must be called with sysctl_lock held */
+static struct oval_sysctl_entry *oval_sysctl_entry_add(const char *mib, const char *path)
+{
+	struct oval_sysctl_entry *entry;
+
+	if (sysctl_table == NULL)
+		sysctl_table = oscap_htable_new1(strcmp, OVAL_SYSCTL_HSIZE);
+	entry = oscap_htable_get(sysctl_table, mib);
+	if (entry != NULL)
+		return entry;
+
+	entry = calloc(1, sizeof(struct oval_sysctl_entry));
+	if (entry == NULL)
+		return NULL;
+	entry->path = path != NULL ? strdup(path) : NULL;
+	if (!oscap_htable_add(sysctl_table, mib, entry)) {
+		oval_sysctl_entry_free(entry);
+		return NULL;
+	}
+	return entry;
+}
+
+/*
+ * Collect the files under the directory, following the symlinks like the
+ * walk of the probe did. The name of a sysctl is its path relative to
+ * /proc/sys with the slashes replaced by dots.
+ */
+static void oval_sysctl_walk(char *path, size_t path_len, int depth, oval_sysctl_names_t *names)
+{
+	struct dirent *ent;
+	DIR *d;
+
+	d = opendir(path);
+	if (d == NULL)
+		return;
+
+	while ((ent = readdir(d)) != NULL) {
+		struct stat st;
+		size_t name_len;
+
+		if (ent->d_name[0] == '.' && (ent->d_name[1] == '\0' ||
+		    (ent->d_name[1] == '.' && ent->d_name[2] == '\0')))
+			continue;
+		name_len = strlen(ent->d_name);
+		if (path_len + 1 + name_len >= PATH_MAX)
+			continue;
+		path[path_len] = '/';
+		memcpy(path + path_len + 1, ent->d_name, name_len + 1);
+
+		if (stat(path, &st) == -1) {
+			dD("Stat failed on %s: %u, %s", path, errno, strerror(errno));
+		} else if (S_ISDIR(st.st_mode)) {
+			if (depth < PROC_SYS_MAXDEPTH)
+				oval_sysctl_walk(path, path_len + 1 + name_len, depth + 1, names);
+		} else {
+			char *mib = strdup(path + strlen(PROC_SYS_DIR) + 1), *c;
+
+			for (c = mib; c != NULL && *c != '\0'; ++c) {
+				if (*c == '/')
+					*c = '.';
+			}
+			if (mib != NULL && names->count == names->alloc) {
+				char **new_mibs = realloc(names->mibs, (names->alloc + 512) * sizeof(char *));
+
+				if (new_mibs == NULL) {
+					free(mib);
+					mib = NULL;
+				} else {
+					names->mibs = new_mibs;
+					names->alloc += 512;
+				}
+			}
+			if (mib != NULL) {
+				names->mibs[names->count++] = mib;
+				pthread_mutex_lock(&sysctl_lock);
+				oval_sysctl_entry_add(mib, path);
+				pthread_mutex_unlock(&sysctl_lock);
+			}
+		}
+		path[path_len] = '\0';
+	}
+	closedir(d);
+}
+
+oval_sysctl_names_t *oval_sysctl_cache_names(void)
+{
+	oval_sysctl_names_t *names;
+	char path[PATH_MAX];
+
+	pthread_mutex_lock(&sysctl_lock);
+	if (sysctl_names != NULL) {
+		names = sysctl_names;
+		names->refs++;
+		pthread_mutex_unlock(&sysctl_lock);
+		return names;
+	}
+	pthread_mutex_unlock(&sysctl_lock);
+
+	names = calloc(1, sizeof(oval_sysctl_names_t));
+	if (names == NULL)
+		return NULL;
+	strcpy(path, PROC_SYS_DIR);
+	oval_sysctl_walk(path, strlen(path), 1, names);
+	if (names->count == 0) {
+		dE("No sysctls found in %s.", PROC_SYS_DIR);
+		oval_sysctl_names_free(names);
+		return NULL;
+	}
+	dD("Found %zu sysctls in %s.", names->count, PROC_SYS_DIR);
+
+	pthread_mutex_lock(&sysctl_lock);
+	if (sysctl_names == NULL) {
+		/* one reference is held by the cache */
+		names->refs = 2;
+		sysctl_names = names;
+	} else {
+		/* walked by another thread meanwhile */
+		oval_sysctl_names_free(names);
+		names = sysctl_names;
+		names->refs++;
+	}
+	pthread_mutex_unlock(&sysctl_lock);
+
+	return names;
+}
+
+const char *oval_sysctl_cache_name(const oval_sysctl_names_t *names, size_t i)
+{
+	return i < names->count ? names->mibs[i] : NULL;
+}
+
+void oval_sysctl_cache_names_release(oval_sysctl_names_t *names)
+{
+	bool last;
+
+	if (names == NULL)
+		return;
+
+	pthread_mutex_lock(&sysctl_lock);
+	last = --names->refs == 0;
+	pthread_mutex_unlock(&sysctl_lock);
+
+	if (last)
+		oval_sysctl_names_free(names);
+}
+
+/* the path of a name with no dots in the components, NULL if it has none */
+static char *oval_sysctl_path(const char *mib)
+{
+	char path[PATH_MAX], *c;
+	int depth = 0;
+
+	if (*mib == '\0' || *mib == '.' || strstr(mib, "..") != NULL ||
+	    strchr(mib, '/') != NULL)
+		return NULL;
+	if (snprintf(path, sizeof(path), "%s/%s", PROC_SYS_DIR, mib) >= (int)sizeof(path))
+		return NULL;
+	for (c = path + strlen(PROC_SYS_DIR) + 1; *c != '\0'; ++c) {
+		if (*c == '.') {
+			*c = '/';
+			++depth;
+		}
+	}
+
+	return depth < PROC_SYS_MAXDEPTH ? strdup(path) : NULL;
+}
+
+/* read the value like sysctl(8), see oval_sysctl_cache_value */
+static int oval_sysctl_read(const char *path, char *buf, size_t *len, int *err)
+{
+	struct stat st;
+	FILE *fp;
+	size_t l;
+
+	*len = 0;
+	*err = 0;
+
+	if (stat(path, &st) == -1 || S_ISDIR(st.st_mode))
+		return 1;
+	/* the sysctl utility uses same condition in sysctl.c in ReadSetting() */
+	if ((st.st_mode & S_IRUSR) == 0) {
+		dD("Skipping write-only file %s", path);
+		return 1;
+	}
+
+	fp = fopen(path, "r");
+	if (fp == NULL) {
+		*err = errno;
+		dE("Can't read sysctl value from \"%s\": %u, %s", path, errno, strerror(errno));
+		return -1;
+	}
+	l = fread(buf, 1, OVAL_SYSCTL_VALUE_MAX, fp);
+	if (ferror(fp)) {
+		const char *file = strrchr(path, '/') + 1;
+
+		*err = errno;
+		fclose(fp);
+		/* Linux 4.1.0 introduced a per-NIC IPv6 stable_secret file.
+		 * The stable_secret file cannot be read until it is set,
+		 * so we skip it when it is not readable. Otherwise we collect it.
+		 */
+		if (strncmp(path, PROC_SYS_DIR "/net/ipv6/conf/", strlen(PROC_SYS_DIR "/net/ipv6/conf/")) == 0 &&
+		    strcmp(file, "stable_secret") == 0) {
+			dD("Skipping file %s", path);
+			return 1;
+		}
+		dE("An error ocured when reading from \"%s\": l=%zu, %u, %s",
+		   path, l, *err, strerror(*err));
+		return -1;
+	}
+	fclose(fp);
+
+	*len = l;
+	return 0;
+}
+
+int oval_sysctl_cache_value(const char *mib, char *buf, size_t *len)
+{
+	struct oval_sysctl_entry *entry;
+	char *path;
+	int ret, err;
+
+	pthread_mutex_lock(&sysctl_lock);
+	entry = sysctl_table != NULL ? oscap_htable_get(sysctl_table, mib) : NULL;
+	if (entry != NULL && entry->loaded) {
+		ret = entry->ret;
+		err = entry->err;
+		*len = entry->len;
+		if (entry->len > 0)
+			memcpy(buf, entry->value, entry->len);
+		pthread_mutex_unlock(&sysctl_lock);
+		errno = err;
+		return ret;
+	}
+	path = entry != NULL && entry->path != NULL ? strdup(entry->path) : NULL;
+	pthread_mutex_unlock(&sysctl_lock);
+
+	if (entry == NULL) {
+		/* the name maps directly to a path unless some component has a dot */
+		path = oval_sysctl_path(mib);
+		if (path != NULL) {
+			struct stat st;
+
+			if (stat(path, &st) == -1 || S_ISDIR(st.st_mode)) {
+				free(path);
+				path = NULL;
+			}
+		}
+		if (path == NULL) {
+			oval_sysctl_names_t *names = oval_sysctl_cache_names();
+
+			oval_sysctl_cache_names_release(names);
+			pthread_mutex_lock(&sysctl_lock);
+			entry = sysctl_table != NULL ? oscap_htable_get(sysctl_table, mib) : NULL;
+			path = entry != NULL && entry->path != NULL ? strdup(entry->path) : NULL;
+			pthread_mutex_unlock(&sysctl_lock);
+		}
+	}
+
+	if (path != NULL) {
+		ret = oval_sysctl_read(path, buf, len, &err);
+	} else {
+		ret = 1;
+		err = 0;
+		*len = 0;
+	}
+
+	pthread_mutex_lock(&sysctl_lock);
+	entry = oval_sysctl_entry_add(mib, path);
+	if (entry != NULL && !entry->loaded) {
+		entry->value = *len > 0 ? malloc(*len) : NULL;
+		if (*len == 0 || entry->value != NULL) {
+			if (*len > 0)
+				memcpy(entry->value, buf, *len);
+			entry->len = *len;
+			entry->ret = ret;
+			entry->err = err;
+			entry->loaded = true;
+		}
+	}
+	pthread_mutex_unlock(&sysctl_lock);
+	free(path);
+
+	errno = err;
+	return ret;
+}
+
+void oval_sysctl_cache_reset(void)
+{
+	oval_sysctl_names_t *names;
+
+	pthread_mutex_lock(&sysctl_lock);
+	oscap_htable_free(sysctl_table, oval_sysctl_entry_free);
+	sysctl_table = NULL;
+	names = sysctl_names;
+	sysctl_names = NULL;
+	pthread_mutex_unlock(&sysctl_lock);
+
+	oval_sysctl_cache_names_release(names);
+}
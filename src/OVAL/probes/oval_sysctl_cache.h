@@ -0,0 +1,71 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+#ifndef OVAL_SYSCTL_CACHE_H
+#define OVAL_SYSCTL_CACHE_H
+
+#include <stddef.h>
+
+/*
+ * Snapshot of /proc/sys for the sysctl objects of one scan. A name is
+ * looked up by turning its dots into slashes, so objects naming one
+ * sysctl read that one file. The tree is walked only for names this
+ * doesn't find (e.g. interfaces with a dot in their name) and for the
+ * objects comparing the names with other operations, and only once per
+ * scan. Values are read once and kept. Everything is dropped after each
+ * remediation fix and when the last probe session ends.
+ */
+
+typedef struct oval_sysctl_names oval_sysctl_names_t;
+
+/* largest value kept, longer ones are truncated */
+#define OVAL_SYSCTL_VALUE_MAX 8191
+
+/**
+ * Get the names of all the sysctls, walking /proc/sys on the first call.
+ * The list has to be released by oval_sysctl_cache_names_release.
+ * @return the list or NULL if /proc/sys can't be read
+ */
+oval_sysctl_names_t *oval_sysctl_cache_names(void);
+
+/**
+ * Get the i-th name of the list.
+ * @return the name or NULL past the last one
+ */
+const char *oval_sysctl_cache_name(const oval_sysctl_names_t *names, size_t i);
+
+void oval_sysctl_cache_names_release(oval_sysctl_names_t *names);
+
+/**
+ * Get the value of a sysctl.
+ * @param mib the dotted name, e.g. net.ipv4.ip_forward
+ * @param buf buffer of at least OVAL_SYSCTL_VALUE_MAX + 1 bytes, the value
+ * is not NUL terminated
+ * @param len length of the value, 0 if it is empty
+ * @return 0 on success, 1 if there is no such sysctl or it should be
+ * skipped like sysctl(8) does (write-only, unset stable_secret), -1 with
+ * errno set if it can't be read
+ */
+int oval_sysctl_cache_value(const char *mib, char *buf, size_t *len);
+
+/**
+ * Drop the snapshot. Name lists still held are freed on release.
+ */
+void oval_sysctl_cache_reset(void);
+
+#endif /* OVAL_SYSCTL_CACHE_H */
@@ -0,0 +1,222 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "common/debug_priv.h"
+#include "oval_throttle.h"
+
+/* largest read issued with an I/O limit */
+#define OVAL_THROTTLE_IO_CHUNK      (64 * 1024)
+/* a bucket holds the tokens for this long at most, which bounds bursts */
+#define OVAL_THROTTLE_BURST_NS      (100 * 1000000ULL)
+/* how often the CPU time of the process is sampled */
+#define OVAL_THROTTLE_CPU_PERIOD_NS (10 * 1000000ULL)
+
+struct oval_throttle_bucket {
+	double   rate;    /* tokens per nanosecond, 0 if there is no limit */
+	double   burst;   /* capacity */
+	double   tokens;  /* negative while in debt */
+	uint64_t last_ns; /* when the tokens were last refilled */
+};
+
+static pthread_once_t throttle_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t throttle_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct oval_throttle_bucket io_bucket;  /* bytes */
+static struct oval_throttle_bucket cpu_bucket; /* CPU nanoseconds */
+static uint64_t cpu_used_ns;   /* CPU time of the process at the last sample */
+static uint64_t cpu_sample_ns; /* when the last sample was taken */
+
+static uint64_t oval_throttle_clock(clockid_t clock)
+{
+	struct timespec ts;
+
+	if (clock_gettime(clock, &ts) != 0)
+		return 0;
+
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t oval_throttle_cpu_time(void)
+{
+#if defined(CLOCK_PROCESS_CPUTIME_ID)
+	return oval_throttle_clock(CLOCK_PROCESS_CPUTIME_ID);
+#else
+	return 0;
+#endif
+}
+
+/* bytes per second with an optional K, M or G suffix, 0 if invalid */
+static uint64_t oval_throttle_parse_rate(const char *str)
+{
+	unsigned long long rate;
+	char *end;
+
+	errno = 0;
+	rate = strtoull(str, &end, 10);
+	if (errno != 0 || end == str)
+		return 0;
+
+	switch (*end) {
+	case 'G': case 'g': rate *= 1024;
+	/* fall through */
+	case 'M': case 'm': rate *= 1024;
+	/* fall through */
+	case 'K': case 'k': rate *= 1024;
+		++end;
+		break;
+	}
+
+	return *end == '\0' ? rate : 0;
+}
+
+static void oval_throttle_bucket_init(struct oval_throttle_bucket *bucket, double per_second, double min_burst)
+{
+	bucket->rate = per_second / 1e9;
+	bucket->burst = bucket->rate * OVAL_THROTTLE_BURST_NS;
+	if (bucket->burst < min_burst)
+		bucket->burst = min_burst;
+	bucket->tokens = bucket->burst;
+	bucket->last_ns = oval_throttle_clock(CLOCK_MONOTONIC);
+}
+
+static void oval_throttle_init(void)
+{
+	const char *str;
+
+	str = getenv("OSCAP_MAX_IO_RATE");
+	if (str != NULL && *str != '\0') {
+		uint64_t rate = oval_throttle_parse_rate(str);
+
+		if (rate == 0) {
+			dW("Invalid OSCAP_MAX_IO_RATE value '%s'.", str);
+		} else {
+			oval_throttle_bucket_init(&io_bucket, rate, OVAL_THROTTLE_IO_CHUNK);
+			dI("Limiting reads of the probes to %" PRIu64 " bytes per second.", rate);
+		}
+	}
+
+	str = getenv("OSCAP_MAX_CPU");
+	if (str != NULL && *str != '\0') {
+		char *end;
+		long percent = strtol(str, &end, 10);
+
+		if (*end != '\0' || percent <= 0) {
+			dW("Invalid OSCAP_MAX_CPU value '%s'.", str);
+		} else if (oval_throttle_cpu_time() == 0) {
+			dW("OSCAP_MAX_CPU is not supported, the CPU time of the process is not available.");
+		} else {
+			oval_throttle_bucket_init(&cpu_bucket, percent / 100.0 * 1e9, OVAL_THROTTLE_CPU_PERIOD_NS);
+			cpu_used_ns = oval_throttle_cpu_time();
+			cpu_sample_ns = cpu_bucket.last_ns;
+			dI("Limiting the CPU time of the scan to %ld %% of one CPU.", percent);
+		}
+	}
+}
+
+/*
+ * Refill the bucket up to now and take the amount from it.
+ * Has to be called with throttle_lock held.
+ * @return nanoseconds to wait until the bucket is out of debt
+ */
+static uint64_t oval_throttle_take(struct oval_throttle_bucket *bucket, double amount, uint64_t now)
+{
+	if (now > bucket->last_ns) {
+		bucket->tokens += (now - bucket->last_ns) * bucket->rate;
+		if (bucket->tokens > bucket->burst)
+			bucket->tokens = bucket->burst;
+		bucket->last_ns = now;
+	}
+	bucket->tokens -= amount;
+
+	return bucket->tokens < 0 ? (uint64_t)(-bucket->tokens / bucket->rate) : 0;
+}
+
+static void oval_throttle_sleep(uint64_t ns)
+{
+	struct timespec ts;
+
+	if (ns == 0)
+		return;
+
+	ts.tv_sec = ns / 1000000000ULL;
+	ts.tv_nsec = ns % 1000000000ULL;
+	while (nanosleep(&ts, &ts) == -1 && errno == EINTR)
+		;
+}
+
+size_t oval_throttle_io_size(size_t size)
+{
+	pthread_once(&throttle_once, oval_throttle_init);
+
+	if (io_bucket.rate == 0 || size <= OVAL_THROTTLE_IO_CHUNK)
+		return size;
+
+	return OVAL_THROTTLE_IO_CHUNK;
+}
+
+void oval_throttle_io(size_t bytes)
+{
+	uint64_t wait;
+
+	pthread_once(&throttle_once, oval_throttle_init);
+	if (io_bucket.rate == 0 || bytes == 0)
+		return;
+
+	pthread_mutex_lock(&throttle_lock);
+	wait = oval_throttle_take(&io_bucket, bytes, oval_throttle_clock(CLOCK_MONOTONIC));
+	pthread_mutex_unlock(&throttle_lock);
+
+	oval_throttle_sleep(wait);
+}
+
+void oval_throttle_cpu(void)
+{
+	uint64_t now, wait;
+	double used = 0;
+
+	pthread_once(&throttle_once, oval_throttle_init);
+	if (cpu_bucket.rate == 0)
+		return;
+
+	now = oval_throttle_clock(CLOCK_MONOTONIC);
+
+	pthread_mutex_lock(&throttle_lock);
+	/* between the samples only the debt of the last one is waited for */
+	if (now >= cpu_sample_ns + OVAL_THROTTLE_CPU_PERIOD_NS) {
+		uint64_t cpu_ns = oval_throttle_cpu_time();
+
+		used = cpu_ns - cpu_used_ns;
+		cpu_used_ns = cpu_ns;
+		cpu_sample_ns = now;
+	}
+	wait = oval_throttle_take(&cpu_bucket, used, now);
+	pthread_mutex_unlock(&throttle_lock);
+
+	oval_throttle_sleep(wait);
+}
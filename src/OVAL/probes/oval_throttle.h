@@ -0,0 +1,61 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+#ifndef OVAL_THROTTLE_H
+#define OVAL_THROTTLE_H
+
+#include <stddef.h>
+
+/*
+ * Limits of the resources used by the probes, for scans of production
+ * hosts which should take longer rather than compete with the workload.
+ * The limits are read from the environment on the first use:
+ *
+ *   OSCAP_MAX_IO_RATE  bytes read from files and directories per second,
+ *                      with an optional K, M or G suffix (powers of 1024)
+ *   OSCAP_MAX_CPU      CPU time used by the process in percent of one CPU
+ *
+ * Both are token buckets shared by all the threads of the process. A thread
+ * which runs out of tokens sleeps until the bucket is refilled; the debt it
+ * left makes the next threads wait their turn, so the rate holds however
+ * many threads read at once. Probes running in separate worker processes
+ * (OSCAP_PROBE_PROCESSES) each have their own buckets.
+ */
+
+/**
+ * Largest read the caller should issue so that the I/O limit is enforced
+ * smoothly, the given size if there is no limit.
+ */
+size_t oval_throttle_io_size(size_t size);
+
+/**
+ * Account bytes read by the calling thread and sleep if the I/O limit
+ * was exceeded. No-op without a limit.
+ */
+void oval_throttle_io(size_t bytes);
+
+/**
+ * Sleep if the process used more CPU time than the CPU limit allows.
+ * Meant to be called often, e.g. for each file walked or task run, the
+ * CPU time of the process is sampled at most every 10 ms. Once the limit
+ * is exceeded every calling thread sleeps until the debt is paid off.
+ * No-op without a limit.
+ */
+void oval_throttle_cpu(void);
+
+#endif /* OVAL_THROTTLE_H */
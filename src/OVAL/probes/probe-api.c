@@ -37,6 +37,7 @@
 #include <string.h>
 #include <stdbool.h>
 #include <errno.h>
+#include <pthread.h>
 #ifdef OS_WINDOWS
 #include <winsock2.h>
 #include <in6addr.h>
@@ -54,6 +55,8 @@
 #include "probe/probe.h"
 #include "SEAP/generic/strto.h"
 #include "oscap_helpers.h"
+#include "../results/oval_cmp_basic_impl.h"
+#include "../results/oval_cmp_evr_string_impl.h"
 
 extern probe_rcache_t  *OSCAP_GSYM(pcache);
 extern probe_ncache_t  *OSCAP_GSYM(ncache);
@@ -61,6 +64,22 @@ extern struct id_desc_t OSCAP_GSYM(id_desc);
 extern probe_option_t *OSCAP_GSYM(probe_optdef);
 extern size_t OSCAP_GSYM(probe_optdef_count);
 
+/*
+ * Attribute names are shared through the name cache like entity names.
+ * Valued attributes are stored with a leading colon (":name").
+ */
+static SEXP_t *probe_attr_name(const char *name, bool valued)
+{
+	char buf[64];
+
+	if (!valued)
+		return probe_ncache_ref(OSCAP_GSYM(ncache), name);
+	if (snprintf(buf, sizeof buf, ":%s", name) >= (int)sizeof buf)
+		return SEXP_string_newf(":%s", name);
+
+	return probe_ncache_ref(OSCAP_GSYM(ncache), buf);
+}
+
 /*
  * items
  */
@@ -69,6 +88,7 @@ SEXP_t *probe_item_creat(const char *name, SEXP_t * attrs, ...)
 	va_list ap;
 	SEXP_t *itm, *ns, *val, *ent;
 
+	SEXP_local_begin();
 	va_start(ap, attrs);
 
 	itm = probe_item_new(name, attrs);
@@ -104,6 +124,7 @@ SEXP_t *probe_item_creat(const char *name, SEXP_t * attrs, ...)
 	}
 
 	va_end(ap);
+	SEXP_local_end(itm);
 
 	return (itm);
 }
@@ -138,10 +159,7 @@ SEXP_t *probe_item_attr_add(SEXP_t * item, const char *name, SEXP_t * val)
 {
 	SEXP_t *n_ref, *ns;
 
-	if (val == NULL)
-		ns = SEXP_string_new(name, strlen(name));
-	else
-		ns = SEXP_string_newf(":%s", name);
+	ns = probe_attr_name(name, val != NULL);
 
 	n_ref = SEXP_listref_first(item);
 
@@ -304,6 +322,268 @@ bool probe_item_filtered(const SEXP_t *item, const SEXP_t *filters)
 	return filtered;
 }
 
+/*
+ * Filters compiled for probe_filters_reject: the state entities with
+ * a single value of a simple datatype are decoded once, the others can't
+ * be decided on probe-native fields and are left unknown.
+ */
+struct probe_filter_ent {
+	char *name;
+	oval_datatype_t datatype;
+	oval_operation_t operation;
+	bool known;           /**< false if the entity can't be decided before the item is built */
+	union {
+		char *str;
+		int64_t integer;
+		double flt;
+		bool boolean;
+	} value;
+};
+
+struct probe_filter {
+	oval_filter_action_t action;
+	oval_operator_t operator;
+	size_t count;
+	struct probe_filter_ent *ents;
+};
+
+struct probe_filter_set {
+	size_t count;
+	struct probe_filter *filters;
+};
+
+static void probe_filter_ent_compile(struct probe_filter_ent *fent, SEXP_t *ent)
+{
+	SEXP_t *val, *r0;
+
+	fent->name = probe_ent_getname(ent);
+	fent->datatype = probe_ent_getdatatype(ent);
+	fent->operation = probe_ent_getoperation(ent, OVAL_OPERATION_EQUALS);
+	fent->known = false;
+
+	if (probe_ent_attrexists(ent, "var_ref") || probe_ent_getvals(ent, NULL) != 1)
+		return;
+
+	r0 = probe_ent_getattrval(ent, "entity_check");
+	if (r0 != NULL) {
+		oval_check_t ochk = SEXP_number_geti_32(r0);
+
+		SEXP_free(r0);
+		/* one item entity decides these checks the same way as its comparison */
+		if (ochk != OVAL_CHECK_ALL && ochk != OVAL_CHECK_AT_LEAST_ONE && ochk != OVAL_CHECK_ONLY_ONE)
+			return;
+	}
+
+	val = probe_ent_getval(ent);
+	if (val == NULL)
+		return;
+
+	switch (fent->datatype) {
+	case OVAL_DATATYPE_STRING:
+	case OVAL_DATATYPE_EVR_STRING:
+	case OVAL_DATATYPE_DEBIAN_EVR_STRING:
+	case OVAL_DATATYPE_VERSION:
+		if (SEXP_stringp(val)) {
+			fent->value.str = SEXP_string_cstr(val);
+			fent->known = fent->value.str != NULL;
+		}
+		break;
+	case OVAL_DATATYPE_INTEGER:
+		if (SEXP_numberp(val)) {
+			fent->value.integer = SEXP_number_geti_64(val);
+			fent->known = true;
+		}
+		break;
+	case OVAL_DATATYPE_FLOAT:
+		if (SEXP_numberp(val)) {
+			fent->value.flt = SEXP_number_getf(val);
+			fent->known = true;
+		}
+		break;
+	case OVAL_DATATYPE_BOOLEAN:
+		if (SEXP_numberp(val)) {
+			fent->value.boolean = SEXP_number_geti_32(val) != 0;
+			fent->known = true;
+		}
+		break;
+	default:
+		break;
+	}
+	SEXP_free(val);
+}
+
+struct probe_filter_set *probe_filter_set_new(const SEXP_t *filters)
+{
+	struct probe_filter_set *set;
+	SEXP_t *filter, *ste, *ent, *r0;
+	size_t i = 0;
+
+	set = calloc(1, sizeof(struct probe_filter_set));
+	set->count = SEXP_list_length(filters);
+	if (set->count == 0)
+		return set;
+	set->filters = calloc(set->count, sizeof(struct probe_filter));
+
+	SEXP_list_foreach(filter, filters) {
+		struct probe_filter *f = &set->filters[i++];
+
+		r0 = SEXP_list_first(filter);
+		f->action = SEXP_number_getu(r0);
+		SEXP_free(r0);
+
+		ste = SEXP_list_nth(filter, 2);
+		r0 = probe_ent_getattrval(ste, "operator");
+		f->operator = r0 != NULL ? SEXP_number_geti_32(r0) : OVAL_OPERATOR_AND;
+		SEXP_free(r0);
+
+		f->ents = calloc(SEXP_list_length(ste), sizeof(struct probe_filter_ent));
+		SEXP_sublist_foreach(ent, ste, 2, SEXP_LIST_END) {
+			probe_filter_ent_compile(&f->ents[f->count++], ent);
+		}
+		SEXP_free(ste);
+	}
+
+	return set;
+}
+
+void probe_filter_set_free(struct probe_filter_set *set)
+{
+	if (set == NULL)
+		return;
+
+	for (size_t i = 0; i < set->count; ++i) {
+		struct probe_filter *f = &set->filters[i];
+
+		for (size_t j = 0; j < f->count; ++j) {
+			free(f->ents[j].name);
+			if (f->ents[j].known && f->ents[j].value.str != NULL
+			    && (f->ents[j].datatype == OVAL_DATATYPE_STRING
+				|| f->ents[j].datatype == OVAL_DATATYPE_EVR_STRING
+				|| f->ents[j].datatype == OVAL_DATATYPE_DEBIAN_EVR_STRING
+				|| f->ents[j].datatype == OVAL_DATATYPE_VERSION))
+				free(f->ents[j].value.str);
+		}
+		free(f->ents);
+	}
+	free(set->filters);
+	free(set);
+}
+
+/* Same comparisons as probe_entste_cmp does on the item entity */
+static oval_result_t probe_filter_ent_cmp(const struct probe_filter_ent *fent, const probe_field_t *field)
+{
+	switch (fent->datatype) {
+	case OVAL_DATATYPE_STRING:
+		return field->value.str != NULL ? oval_string_cmp(fent->value.str, field->value.str, fent->operation) : OVAL_RESULT_UNKNOWN;
+	case OVAL_DATATYPE_EVR_STRING:
+		return field->value.str != NULL ? oval_evr_string_cmp(fent->value.str, field->value.str, fent->operation) : OVAL_RESULT_UNKNOWN;
+	case OVAL_DATATYPE_DEBIAN_EVR_STRING:
+		return field->value.str != NULL ? oval_debian_evr_string_cmp(fent->value.str, field->value.str, fent->operation) : OVAL_RESULT_UNKNOWN;
+	case OVAL_DATATYPE_VERSION:
+		return field->value.str != NULL ? oval_versiontype_cmp(fent->value.str, field->value.str, fent->operation) : OVAL_RESULT_UNKNOWN;
+	case OVAL_DATATYPE_INTEGER:
+		return oval_int_cmp(fent->value.integer, field->value.integer, fent->operation);
+	case OVAL_DATATYPE_FLOAT:
+		return oval_float_cmp(fent->value.flt, field->value.flt, fent->operation);
+	case OVAL_DATATYPE_BOOLEAN:
+		return oval_boolean_cmp(fent->value.boolean, field->value.boolean, fent->operation);
+	default:
+		return OVAL_RESULT_UNKNOWN;
+	}
+}
+
+static oval_result_t probe_filter_ent_eval(const struct probe_filter_ent *fent, const probe_field_t *fields, size_t count)
+{
+	if (!fent->known)
+		return OVAL_RESULT_UNKNOWN;
+
+	for (size_t i = 0; i < count; ++i) {
+		if (strcmp(fent->name, fields[i].name) != 0)
+			continue;
+		if (fent->datatype != fields[i].datatype)
+			return OVAL_RESULT_UNKNOWN;
+
+		oval_result_t ores = probe_filter_ent_cmp(fent, &fields[i]);
+		/* errors are left for probe_item_filtered to report */
+		return (ores == OVAL_RESULT_TRUE || ores == OVAL_RESULT_FALSE) ? ores : OVAL_RESULT_UNKNOWN;
+	}
+
+	return OVAL_RESULT_UNKNOWN;
+}
+
+/*
+ * The result of the state on the fields, OVAL_RESULT_UNKNOWN if the
+ * entities which couldn't be decided may change it.
+ */
+static oval_result_t probe_filter_eval(const struct probe_filter *f, const probe_field_t *fields, size_t count)
+{
+	size_t t = 0, fl = 0;
+
+	for (size_t i = 0; i < f->count; ++i) {
+		switch (probe_filter_ent_eval(&f->ents[i], fields, count)) {
+		case OVAL_RESULT_TRUE:
+			++t;
+			break;
+		case OVAL_RESULT_FALSE:
+			++fl;
+			break;
+		default:
+			break;
+		}
+	}
+
+	switch (f->operator) {
+	case OVAL_OPERATOR_AND:
+		if (fl > 0)
+			return OVAL_RESULT_FALSE;
+		break;
+	case OVAL_OPERATOR_OR:
+		if (t > 0)
+			return OVAL_RESULT_TRUE;
+		break;
+	default:
+		break;
+	}
+
+	if (f->count == 0 || t + fl < f->count)
+		return OVAL_RESULT_UNKNOWN;
+
+	switch (f->operator) {
+	case OVAL_OPERATOR_AND:
+		return OVAL_RESULT_TRUE;
+	case OVAL_OPERATOR_OR:
+		return OVAL_RESULT_FALSE;
+	case OVAL_OPERATOR_ONE:
+		return t == 1 ? OVAL_RESULT_TRUE : OVAL_RESULT_FALSE;
+	case OVAL_OPERATOR_XOR:
+		return (t % 2) == 1 ? OVAL_RESULT_TRUE : OVAL_RESULT_FALSE;
+	default:
+		return OVAL_RESULT_UNKNOWN;
+	}
+}
+
+bool probe_filters_active(probe_ctx *ctx)
+{
+	return ctx->cfilters != NULL && ctx->cfilters->count > 0;
+}
+
+bool probe_filters_reject(probe_ctx *ctx, const probe_field_t *fields, size_t count)
+{
+	if (!probe_filters_active(ctx))
+		return false;
+
+	for (size_t i = 0; i < ctx->cfilters->count; ++i) {
+		const struct probe_filter *f = &ctx->cfilters->filters[i];
+		oval_result_t ores = probe_filter_eval(f, fields, count);
+
+		if ((ores == OVAL_RESULT_TRUE && f->action == OVAL_FILTER_ACTION_EXCLUDE)
+		    || (ores == OVAL_RESULT_FALSE && f->action == OVAL_FILTER_ACTION_INCLUDE))
+			return true;
+	}
+
+	return false;
+}
+
 /*
  * attributes
  */
@@ -318,11 +598,11 @@ SEXP_t *probe_attr_creat(const char *name, const SEXP_t * val, ...)
 
 	while (name != NULL) {
 		if (val == NULL) {
-			ns = SEXP_string_new(name, strlen(name));
+			ns = probe_attr_name(name, false);
 			SEXP_list_add(list, ns);
 			SEXP_free(ns);
 		} else {
-			ns = SEXP_string_newf(":%s", name);
+			ns = probe_attr_name(name, true);
 			SEXP_list_add(list, ns);
 			SEXP_list_add(list, val);
 			SEXP_free(ns);
@@ -498,6 +778,35 @@ oval_schema_version_t probe_obj_get_platform_schema_version(const SEXP_t *obj)
 
 
 
+bool probe_obj_wants_itement(const SEXP_t *obj, const char *name)
+{
+	SEXP_t *sexp_ents;
+	char *ents, *tok, *save;
+	bool wanted;
+
+	sexp_ents = probe_obj_getattrval(obj, "item_entities");
+	if (!SEXP_stringp(sexp_ents)) {
+		SEXP_free(sexp_ents);
+		return true;
+	}
+
+	ents = SEXP_string_cstr(sexp_ents);
+	SEXP_free(sexp_ents);
+	if (ents == NULL)
+		return true;
+
+	wanted = false;
+	for (tok = strtok_r(ents, " ", &save); tok != NULL; tok = strtok_r(NULL, " ", &save)) {
+		if (strcmp(tok, name) == 0) {
+			wanted = true;
+			break;
+		}
+	}
+	free(ents);
+
+	return wanted;
+}
+
 SEXP_t *probe_obj_getattrval(const SEXP_t * obj, const char *name)
 {
 	SEXP_t *obj_name;
@@ -1073,6 +1382,35 @@ SEXP_t *probe_ent_getval(const SEXP_t * ent)
 	}
 }
 
+SEXP_t *probe_ent_select_val(const SEXP_t * ent, uint32_t idx)
+{
+	SEXP_t *r0, *r1, *r2, *r3, *r4, *r5, *name_lst, *res;
+
+	if (!probe_ent_attrexists(ent, "var_ref"))
+		return SEXP_ref(ent);
+
+	/* the first :val_idx attribute is the one that is used */
+	r0 = SEXP_list_first(ent);
+	r1 = SEXP_list_first(r0);
+	r2 = SEXP_list_rest(r0);
+	r3 = SEXP_list_new(r1, r4 = SEXP_string_new(":val_idx", 8),
+			   r5 = SEXP_number_newu(idx), NULL);
+	name_lst = SEXP_list_join(r3, r2);
+	SEXP_free(r0);
+	SEXP_free(r1);
+	SEXP_free(r2);
+	SEXP_free(r3);
+	SEXP_free(r4);
+	SEXP_free(r5);
+
+	r0 = SEXP_list_nth(ent, 2);
+	res = SEXP_list_new(name_lst, r0, NULL);
+	SEXP_free(r0);
+	SEXP_free(name_lst);
+
+	return res;
+}
+
 SEXP_t *probe_ent_getattrval(const SEXP_t * ent, const char *name)
 {
 	SEXP_t *attrs;
@@ -1410,10 +1748,8 @@ static SEXP_t *probe_item_optimize(const SEXP_t *item)
  * e.g. 3rd to 5th arguments matters. If you change ordering of those tuples,
  * it will have consequences.
  */
-SEXP_t *probe_item_create(oval_subtype_t item_subtype, probe_elmatr_t *item_attributes[],
-                          /* const char *value_name, oval_datatype_t value_type, void *value, */ ...)
+static SEXP_t *probe_item_vcreate(oval_subtype_t item_subtype, probe_elmatr_t *item_attributes[], va_list ap)
 {
-        va_list ap;
 	SEXP_t *item, *name_sexp, *value_sexp = NULL, *entity;
         SEXP_t value_sexp_mem, entity_mem;
 	const char *value_name, *subtype_name, *family_name;
@@ -1440,8 +1776,6 @@ SEXP_t *probe_item_create(oval_subtype_t item_subtype, probe_elmatr_t *item_attr
 	family_name = oval_family_get_text(family);
 	snprintf(item_name, sizeof(item_name), "%s:%s_item", family_name, subtype_name);
 
-	va_start(ap, item_attributes);
-
 	item       = probe_item_new(item_name, NULL);
 	value_name = va_arg(ap, const char *);
 
@@ -1458,7 +1792,7 @@ SEXP_t *probe_item_create(oval_subtype_t item_subtype, probe_elmatr_t *item_attr
                         if (value_str == NULL)
                                 goto skip;
 
-                        value_sexp = SEXP_string_new_r(&value_sexp_mem, value_str, strlen(value_str));
+                        value_sexp = probe_ncache_value_r(OSCAP_GSYM(ncache), &value_sexp_mem, value_str);
                         break;
                 case OVAL_DATATYPE_STRING_M:
                         value_type = OVAL_DATATYPE_STRING;
@@ -1475,7 +1809,7 @@ SEXP_t *probe_item_create(oval_subtype_t item_subtype, probe_elmatr_t *item_attr
                         value_sexp = malloc(sizeof(SEXP_t) * multiply);
 
                         for (value_i = 0; value_i < multiply; ++value_i)
-                                SEXP_string_new_r(value_sexp + value_i, value_stra[value_i], strlen(value_stra[value_i]));
+                                probe_ncache_value_r(OSCAP_GSYM(ncache), value_sexp + value_i, value_stra[value_i]);
 
                         value_i = 0;
                         break;
@@ -1523,7 +1857,6 @@ SEXP_t *probe_item_create(oval_subtype_t item_subtype, probe_elmatr_t *item_attr
 			   value_type, oval_datatype_get_text(value_type), value_name);
                         SEXP_free(item);
 
-			va_end(ap);
                         return (NULL);
                 }
 
@@ -1544,7 +1877,6 @@ SEXP_t *probe_item_create(oval_subtype_t item_subtype, probe_elmatr_t *item_attr
                                                 free(value_sexp);
                                 }
 
-				va_end(ap);
                                 return (NULL);
                         }
 
@@ -1568,7 +1900,25 @@ SEXP_t *probe_item_create(oval_subtype_t item_subtype, probe_elmatr_t *item_attr
 		free_value = true;
         }
 
-	va_end(ap);
+        return (item);
+}
+
+SEXP_t *probe_item_create(oval_subtype_t item_subtype, probe_elmatr_t *item_attributes[],
+                          /* const char *value_name, oval_datatype_t value_type, void *value, */ ...)
+{
+        va_list ap;
+        SEXP_t *item;
+
+        /*
+         * The item is built by the calling thread only, so the values
+         * can use plain reference counting until it is returned.
+         */
+        SEXP_local_begin();
+        va_start(ap, item_attributes);
+        item = probe_item_vcreate(item_subtype, item_attributes, ap);
+        va_end(ap);
+        SEXP_local_end(item);
+
         return (item);
 }
 
@@ -1796,4 +2146,111 @@ SEXP_t *probe_obj_getmask(SEXP_t *obj)
     SEXP_free(objents);
     return (mask);
 }
+
+struct probe_memo {
+	char *name;
+	void *value;
+	void (*destroy)(void *);
+	unsigned int refs;
+	struct probe_memo *next;
+};
+
+static pthread_mutex_t probe_memo_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct probe_memo *probe_memos = NULL;
+
+/* must be called with probe_memo_lock held */
+static struct probe_memo *probe_memo_find(const char *name)
+{
+	struct probe_memo *memo;
+
+	for (memo = probe_memos; memo != NULL; memo = memo->next) {
+		if (strcmp(memo->name, name) == 0)
+			return memo;
+	}
+	return NULL;
+}
+
+probe_memo_t *probe_memo_acquire(const char *name, void *(*build)(void *), void *arg, void (*destroy)(void *))
+{
+	struct probe_memo *memo, *other;
+	void *value;
+
+	pthread_mutex_lock(&probe_memo_lock);
+	memo = probe_memo_find(name);
+	if (memo != NULL) {
+		memo->refs++;
+		pthread_mutex_unlock(&probe_memo_lock);
+		return memo;
+	}
+	pthread_mutex_unlock(&probe_memo_lock);
+
+	value = build(arg);
+	if (value == NULL)
+		return NULL;
+	memo = malloc(sizeof(struct probe_memo));
+	if (memo == NULL) {
+		destroy(value);
+		return NULL;
+	}
+	memo->name = strdup(name);
+	memo->value = value;
+	memo->destroy = destroy;
+
+	pthread_mutex_lock(&probe_memo_lock);
+	other = probe_memo_find(name);
+	if (other != NULL) {
+		/* built by another thread meanwhile */
+		other->refs++;
+		pthread_mutex_unlock(&probe_memo_lock);
+		destroy(value);
+		free(memo->name);
+		free(memo);
+		return other;
+	}
+	/* one reference is held by the list */
+	memo->refs = 2;
+	memo->next = probe_memos;
+	probe_memos = memo;
+	pthread_mutex_unlock(&probe_memo_lock);
+
+	return memo;
+}
+
+void *probe_memo_value(probe_memo_t *memo)
+{
+	return memo->value;
+}
+
+void probe_memo_release(probe_memo_t *memo)
+{
+	bool last;
+
+	if (memo == NULL)
+		return;
+
+	pthread_mutex_lock(&probe_memo_lock);
+	last = --memo->refs == 0;
+	pthread_mutex_unlock(&probe_memo_lock);
+
+	if (last) {
+		memo->destroy(memo->value);
+		free(memo->name);
+		free(memo);
+	}
+}
+
+void probe_memo_reset(void)
+{
+	struct probe_memo *memo, *next;
+
+	pthread_mutex_lock(&probe_memo_lock);
+	memo = probe_memos;
+	probe_memos = NULL;
+	pthread_mutex_unlock(&probe_memo_lock);
+
+	for (; memo != NULL; memo = next) {
+		next = memo->next;
+		probe_memo_release(memo);
+	}
+}
 /// @}
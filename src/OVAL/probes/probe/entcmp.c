@@ -160,6 +160,20 @@ oval_result_t probe_ent_cmp_string(SEXP_t * val1, SEXP_t * val2, oval_operation_
 	oval_result_t result = OVAL_RESULT_ERROR;
 	char *s1, *s2;
 
+	/* Interned strings are equal without copying them out */
+	if (SEXP_eq(val1, val2)) {
+		switch (op) {
+		case OVAL_OPERATION_EQUALS:
+		case OVAL_OPERATION_CASE_INSENSITIVE_EQUALS:
+			return OVAL_RESULT_TRUE;
+		case OVAL_OPERATION_NOT_EQUAL:
+		case OVAL_OPERATION_CASE_INSENSITIVE_NOT_EQUAL:
+			return OVAL_RESULT_FALSE;
+		default:
+			break;
+		}
+	}
+
 	s1 = SEXP_string_cstr(val1);
 	s2 = SEXP_string_cstr(val2);
 
@@ -430,6 +444,52 @@ oval_result_t probe_entste_cmp(SEXP_t * ent_ste, SEXP_t * ent_itm)
 	return ores;
 }
 
+char **probe_entobj_equal_strings(SEXP_t * ent_obj)
+{
+	SEXP_t *val;
+	char **strs;
+	int i, j, n, val_cnt;
+
+	val = probe_ent_getattrval(ent_obj, "operation");
+	if (val != NULL) {
+		oval_operation_t op = (oval_operation_t) SEXP_number_geti_32(val);
+
+		SEXP_free(val);
+		if (op != OVAL_OPERATION_EQUALS)
+			return NULL;
+	}
+
+	val_cnt = probe_ent_getvals(ent_obj, NULL);
+	strs = calloc((val_cnt > 0 ? val_cnt : 1) + 1, sizeof(char *));
+	if (strs == NULL)
+		return NULL;
+
+	for (i = 0, n = 0; i == 0 || i < val_cnt; ++i) {
+		SEXP_t *sel = probe_ent_select_val(ent_obj, i);
+		char *str;
+
+		val = probe_ent_getval(sel);
+		SEXP_free(sel);
+		str = val != NULL ? SEXP_string_cstr(val) : NULL;
+		SEXP_free(val);
+
+		if (str == NULL) {
+			while (n > 0)
+				free(strs[--n]);
+			free(strs);
+			return NULL;
+		}
+		for (j = 0; j < n && strcmp(strs[j], str) != 0; ++j)
+			;
+		if (j < n)
+			free(str);
+		else
+			strs[n++] = str;
+	}
+
+	return strs;
+}
+
 oval_result_t probe_entobj_cmp(SEXP_t * ent_obj, SEXP_t * val)
 {
 	oval_result_t ores;
@@ -60,6 +60,17 @@ oval_result_t probe_ent_result_byopr(SEXP_t * res_lst, oval_operator_t operator)
  */
 oval_result_t probe_entobj_cmp(SEXP_t * ent_obj, SEXP_t * val);
 
+/**
+ * Get the strings an object entity with the equals operation can match,
+ * so that they can be looked up directly instead of comparing every
+ * candidate. All the values of a variable are returned, the values found
+ * still have to be checked by probe_entobj_cmp because of var_check.
+ * @param ent_obj object entity
+ * @return NULL terminated array of the distinct values to be freed with
+ * the strings, NULL if the operation is not equals
+ */
+char **probe_entobj_equal_strings(SEXP_t * ent_obj);
+
 /**
  * Compare state entity's content with a item entity's value.
  * The result depends on the operation attribute,
@@ -28,20 +28,25 @@
 #include <sexp.h>
 #include <errno.h>
 #include <string.h>
+#include <time.h>
 #include <inttypes.h>
 #include <stdlib.h>
+#include <stdbool.h>
 
 #if defined(OS_FREEBSD)
 #include <pthread_np.h>
 #endif
 
-#include "../SEAP/generic/rbt/rbt.h"
 #include "probe-api.h"
+#include "oscap_helpers.h"
 #include "common/debug_priv.h"
-#include "common/memusage.h"
+#include "common/stats_priv.h"
+#include "common/trace_priv.h"
+#include "oval_deadline.h"
 
 #include "probe.h"
 #include "icache.h"
+#include "membudget.h"
 #include "_sexp-ID.h"
 
 static volatile uint32_t next_ID = 0;
@@ -92,84 +97,161 @@ static void probe_icache_item_setID(SEXP_t *item, SEXP_ID_t item_ID)
         return;
 }
 
-static int icache_lookup(rbt_t *tree, int64_t item_id, probe_iqpair_t *pair) {
+static int icache_table_init(probe_ctable_t *table, size_t capacity)
+{
+	table->slot = calloc(capacity, sizeof(probe_citem_t));
+	if (table->slot == NULL) {
+		return -1;
+	}
+	table->capacity = capacity;
+	table->count = 0;
+	return 0;
+}
 
-	probe_citem_t *cached = NULL;
+/*
+ * Double the capacity of the table. The hashes are stored in the slots
+ * so the items don't need to be rehashed, only moved to their new position.
+ */
+static int icache_table_grow(probe_ctable_t *table)
+{
+	size_t i, j, mask;
+	size_t new_capacity = table->capacity << 1;
+	probe_citem_t *new_slot;
 
-	if (rbt_i64_get(tree, item_id, (void**)&cached) != 0) {
+	new_slot = calloc(new_capacity, sizeof(probe_citem_t));
+	if (new_slot == NULL) {
 		return -1;
 	}
 
-	/*
-	* Maybe a cache HIT
-	*/
-	dD("cache HIT #1");
-
-	register uint16_t i;
-	for (i = 0; i < cached->count; ++i) {
-		SEXP_t rest1;
-		SEXP_t* rest_r1 = SEXP_list_rest_r(&rest1, pair->p.item);
-
-		SEXP_t rest2;
-		SEXP_t* rest_r2 = SEXP_list_rest_r(&rest2, cached->item[i]);
-
-		if (SEXP_deepcmp(rest_r1, rest_r2)) {
-			SEXP_free_r(&rest1);
-			SEXP_free_r(&rest2);
-			break;
+	mask = new_capacity - 1;
+
+	for (i = 0; i < table->capacity; ++i) {
+		if (table->slot[i].item == NULL) {
+			continue;
 		}
+		j = (size_t)table->slot[i].hash & mask;
 
-		SEXP_free_r(&rest1);
-		SEXP_free_r(&rest2);
+		while (new_slot[j].item != NULL) {
+			j = (j + 1) & mask;
+		}
+		new_slot[j] = table->slot[i];
 	}
 
-	if (i == cached->count) {
-		/*
-		* Cache MISS
-		*/
-		dD("cache MISS");
+	free(table->slot);
+	table->slot = new_slot;
+	table->capacity = new_capacity;
 
-		void *new_item = realloc(cached->item, sizeof(SEXP_t *) * (cached->count + 1));
-		if (new_item == NULL) {
+	return 0;
+}
+
+static void icache_table_free(probe_ctable_t *table)
+{
+	size_t i;
+
+	for (i = 0; i < table->capacity; ++i) {
+		if (table->slot[i].item != NULL) {
+			SEXP_free(table->slot[i].item);
+		}
+	}
+	free(table->slot);
+	table->slot = NULL;
+	table->capacity = 0;
+	table->count = 0;
+}
+
+/*
+ * Lookup the item in the cache. If a semantically equal item is already
+ * cached, the item in the pair is freed and replaced by the cached one.
+ * Otherwise the item is stored in the cache and assigned an unique ID.
+ *
+ * Returns 1 on a cache hit, 0 when the item was added and -1 if the table
+ * could not be resized.
+ */
+static int icache_lookup(probe_ctable_t *table, SEXP_ID_t item_ID, probe_iqpair_t *pair)
+{
+	size_t i, mask;
+	SEXP_t rest_mem, *rest = NULL;
+
+	/* Keep the load factor below 3/4 */
+	if ((table->count + 1) * 4 > table->capacity * 3) {
+		if (icache_table_grow(table) != 0) {
 			dE("Unable to re-allocate memory for cache");
 			return -1;
 		}
-		cached->count++;
-		cached->item = new_item;
-		cached->item[cached->count - 1] = pair->p.item;
-
-		/* Assign an unique item ID */
-		probe_icache_item_setID(pair->p.item, item_id);
-	} else {
-		/*
-		* Cache HIT
-		*/
-		dD("cache HIT #2 -> real HIT");
-		SEXP_free(pair->p.item);
-		pair->p.item = cached->item[i];
 	}
-	return 0;
-}
 
-static void icache_add_to_tree(rbt_t *tree, int64_t item_id, probe_iqpair_t *pair) {
+	mask = table->capacity - 1;
+	i = (size_t)item_ID & mask;
+
+	while (table->slot[i].item != NULL) {
+		if (table->slot[i].hash == item_ID) {
+			SEXP_t rest_cached, *rest_r;
+			bool equal;
 
-	probe_citem_t *cached = malloc(sizeof(probe_citem_t));
-	cached->item = malloc(sizeof(SEXP_t *));
-	cached->item[0] = pair->p.item;
-	cached->count = 1;
+			/*
+			 * Maybe a cache HIT, compare the content of the items
+			 * without the item name and attributes (item ID).
+			 */
+			dD("cache HIT #1");
+
+			if (rest == NULL) {
+				rest = SEXP_list_rest_r(&rest_mem, pair->p.item);
+			}
+			rest_r = SEXP_list_rest_r(&rest_cached, table->slot[i].item);
+			equal  = SEXP_deepcmp(rest, rest_r);
+			SEXP_free_r(&rest_cached);
+
+			if (equal) {
+				dD("cache HIT #2 -> real HIT");
+				SEXP_free_r(&rest_mem);
+				SEXP_free(pair->p.item);
+				pair->p.item = table->slot[i].item;
+				return 1;
+			}
+		}
+		i = (i + 1) & mask;
+	}
+
+	if (rest != NULL) {
+		SEXP_free_r(&rest_mem);
+	}
+
+	/*
+	 * Cache MISS
+	 */
+	dD("cache MISS");
+
+	table->slot[i].hash = item_ID;
+	table->slot[i].item = pair->p.item;
+	++table->count;
 
 	/* Assign an unique item ID */
-	probe_icache_item_setID(pair->p.item, item_id);
+	probe_icache_item_setID(pair->p.item, item_ID);
 
-	if (rbt_i64_add(tree, (int64_t)item_id, (void **)cached, NULL) != 0) {
-		dE("Can't add item (k=%"PRIi64" to the cache (%p)", item_id, tree);
+	return 0;
+}
 
-		free(cached->item);
-		free(cached);
+/*
+ * Lock the queue mutex, the time spent waiting for it when it's held by
+ * another thread is counted in the icache_lock_wait* statistics. The
+ * uncontended path costs only the trylock.
+ */
+static int probe_icache_lock(probe_icache_t *cache)
+{
+	struct timespec start, end;
+	int ret;
 
-		/* now what? */
-		abort();
-	}
+	if ((ret = pthread_mutex_trylock(&cache->queue_mutex)) != EBUSY)
+		return ret;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	ret = pthread_mutex_lock(&cache->queue_mutex);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	oscap_stats_add(OSCAP_STATS_ICACHE_LOCK_WAITS, 1);
+	oscap_stats_add(OSCAP_STATS_ICACHE_LOCK_WAIT_NS,
+	                (uint64_t)(end.tv_sec - start.tv_sec) * 1000000000ULL + end.tv_nsec - start.tv_nsec);
+	return ret;
 }
 
 static void *probe_icache_worker(void *arg)
@@ -281,12 +363,20 @@ const char* thread_name = "icache_worker";
                         item_ID = SEXP_ID_v(pair->p.item);
                         dD("item ID=%"PRIu64"", item_ID);
 
-                        if (icache_lookup(cache->tree, item_ID, pair) != 0) {
-                                /*
-                                 * Cache MISS
-                                 */
-                                dD("cache MISS");
-                                icache_add_to_tree(cache->tree, item_ID, pair);
+                        switch (icache_lookup(&cache->table, item_ID, pair)) {
+                        case 1:
+                                ++cache->hits;
+                                ++cache->lookups;
+                                oscap_stats_add(OSCAP_STATS_ICACHE_HITS, 1);
+                                break;
+                        case 0:
+                                ++cache->lookups;
+                                oscap_stats_add(OSCAP_STATS_ICACHE_MISSES, 1);
+                                break;
+                        default:
+                                dE("Can't add item (k=%"PRIu64") to the cache (%p)", item_ID, cache);
+                                /* now what? */
+                                abort();
                         }
 
                         if (probe_cobj_add_item(pair->cobj, pair->p.item) != 0) {
@@ -294,7 +384,7 @@ const char* thread_name = "icache_worker";
                         }
                 }
 
-                if (pthread_mutex_lock(&cache->queue_mutex) != 0) {
+                if (probe_icache_lock(cache) != 0) {
                         dE("An error ocured while re-locking the queue mutex: %u, %s",
                            errno, strerror(errno));
                         abort();
@@ -309,7 +399,15 @@ const char* thread_name = "icache_worker";
 probe_icache_t *probe_icache_new(void)
 {
         probe_icache_t *cache = malloc(sizeof(probe_icache_t));
-        cache->tree = rbt_i64_new();
+
+        if (cache == NULL)
+                return (NULL);
+
+        if (icache_table_init(&cache->table, PROBE_ICACHE_INITIAL_CAPACITY) != 0) {
+                dE("Can't allocate the icache table");
+                free(cache);
+                return (NULL);
+        }
 
         if (pthread_mutex_init(&cache->queue_mutex, NULL) != 0) {
                 dE("Can't initialize icache mutex: %u, %s", errno, strerror(errno));
@@ -320,6 +418,8 @@ probe_icache_t *probe_icache_new(void)
         cache->queue_end = 0;
         cache->queue_cnt = 0;
         cache->queue_max = PROBE_IQUEUE_CAPACITY;
+        cache->lookups = 0;
+        cache->hits = 0;
 
         if (pthread_cond_init(&cache->queue_notempty, NULL) != 0) {
                 dE("Can't initialize icache queue condition variable (notempty): %u, %s",
@@ -342,8 +442,7 @@ probe_icache_t *probe_icache_new(void)
 
         return (cache);
 fail:
-        if (cache->tree != NULL)
-                rbt_i64_free(cache->tree);
+        icache_table_free(&cache->table);
 
         pthread_mutex_destroy(&cache->queue_mutex);
         pthread_cond_destroy(&cache->queue_notempty);
@@ -380,8 +479,16 @@ retry:
                         cache->queue_end = 0;
         } else {
                 /*
-                 * The queue is full, we have to wait
+                 * The queue is full, we have to wait. Make sure the worker
+                 * is awake, a batch could have filled the queue without
+                 * signaling it.
                  */
+                if (pthread_cond_signal(&cache->queue_notempty) != 0) {
+                        dE("An error ocured while signaling the `notempty' condition: %u, %s",
+                           errno, strerror(errno));
+                        return (-1);
+                }
+
                 if (pthread_cond_wait(&cache->queue_notfull, &cache->queue_mutex) == 0)
                         goto retry;
                 else {
@@ -401,7 +508,7 @@ int probe_icache_add(probe_icache_t *cache, SEXP_t *cobj, SEXP_t *item)
         if (cache == NULL || cobj == NULL || item == NULL)
                 return (-1); /* XXX: EFAULT */
 
-        if (pthread_mutex_lock(&cache->queue_mutex) != 0) {
+        if (probe_icache_lock(cache) != 0) {
                 dE("An error ocured while locking the queue mutex: %u, %s",
                    errno, strerror(errno));
                 return (-1);
@@ -427,18 +534,86 @@ int probe_icache_add(probe_icache_t *cache, SEXP_t *cobj, SEXP_t *item)
         return (0);
 }
 
-int probe_icache_nop(probe_icache_t *cache)
+void probe_ibatch_init(probe_ibatch_t *batch)
+{
+        batch->cobj  = NULL;
+        batch->count = 0;
+}
+
+static int __probe_icache_add_batch_nolock(probe_icache_t *cache, probe_ibatch_t *batch)
+{
+        uint16_t i;
+
+        for (i = 0; i < batch->count; ++i) {
+                if (__probe_icache_add_nolock(cache, batch->cobj, batch->item[i], NULL) != 0) {
+                        dE("Can't add item (%p) to the item cache (%p)", batch->item[i], cache);
+                        /*
+                         * Free the items that weren't handed over to the worker
+                         */
+                        for (; i < batch->count; ++i)
+                                SEXP_free(batch->item[i]);
+
+                        batch->count = 0;
+                        return (-1);
+                }
+        }
+
+        batch->count = 0;
+        return (0);
+}
+
+int probe_icache_add_batch(probe_icache_t *cache, probe_ibatch_t *batch)
+{
+        int ret;
+
+        if (cache == NULL || batch == NULL)
+                return (-1);
+
+        if (batch->count == 0)
+                return (0);
+
+        if (probe_icache_lock(cache) != 0) {
+                dE("An error ocured while locking the queue mutex: %u, %s",
+                   errno, strerror(errno));
+                return (-1);
+        }
+
+        ret = __probe_icache_add_batch_nolock(cache, batch);
+
+        if (pthread_cond_signal(&cache->queue_notempty) != 0) {
+                dE("An error ocured while signaling the `notempty' condition: %u, %s",
+                   errno, strerror(errno));
+                return (-1);
+        }
+
+        if (pthread_mutex_unlock(&cache->queue_mutex) != 0) {
+                dE("An error ocured while unlocking the queue mutex: %u, %s",
+                   errno, strerror(errno));
+                abort();
+        }
+
+        return (ret);
+}
+
+int probe_icache_sync(probe_icache_t *cache, probe_ibatch_t *batch)
 {
         pthread_cond_t cond;
+        int ret = 0;
 
         dD("NOP");
 
-        if (pthread_mutex_lock(&cache->queue_mutex) != 0) {
+        if (probe_icache_lock(cache) != 0) {
                 dE("An error ocured while locking the queue mutex: %u, %s",
                    errno, strerror(errno));
                 return (-1);
         }
 
+        /*
+         * Queue the pending items first so that the NOP is handled after them
+         */
+        if (batch != NULL && batch->count > 0)
+                ret = __probe_icache_add_batch_nolock(cache, batch);
+
         if (pthread_cond_init(&cond, NULL) != 0) {
                 dE("Can't initialize icache queue condition variable (NOP): %u, %s",
                    errno, strerror(errno));
@@ -484,40 +659,44 @@ int probe_icache_nop(probe_icache_t *cache)
 
         pthread_cond_destroy(&cond);
 
-        return (0);
+        return (ret);
 }
 
-#define PROBE_RESULT_MEMCHECK_CTRESHOLD  1000  /* item count */
+int probe_icache_nop(probe_icache_t *cache)
+{
+        return probe_icache_sync(cache, NULL);
+}
 
-/**
- * Returns 0 if the memory constraints are not reached. Otherwise, 1 is returned.
- * In case of an error, -1 is returned.
+/*
+ * Flag the collected object as incomplete, the items collected so far
+ * are kept. The message is added only once.
  */
-static int probe_cobj_memcheck(size_t item_cnt, double max_ratio)
+static int probe_item_incomplete(struct probe_ctx *ctx, char *message)
 {
-	if (item_cnt > PROBE_RESULT_MEMCHECK_CTRESHOLD) {
-		struct proc_memusage mu_proc;
-		struct sys_memusage  mu_sys;
-		double c_ratio;
+	SEXP_t *msg;
 
-		if (oscap_proc_memusage (&mu_proc) != 0)
-			return (-1);
+	if (probe_cobj_get_flag(ctx->probe_out) == SYSCHAR_FLAG_INCOMPLETE)
+		return 0;
 
-		if (oscap_sys_memusage (&mu_sys) != 0)
-			return (-1);
+	/* sync with the icache thread before modifying the collected object */
+	if (probe_icache_sync(ctx->icache, &ctx->ibatch) != 0)
+		return -1;
 
-		c_ratio = (double)mu_proc.mu_rss/(double)(mu_sys.mu_total);
+	msg = probe_msg_creat(OVAL_MESSAGE_LEVEL_WARNING, message);
+	probe_cobj_add_msg(ctx->probe_out, msg);
+	probe_cobj_set_flag(ctx->probe_out, SYSCHAR_FLAG_INCOMPLETE);
+	SEXP_free(msg);
 
-		if (c_ratio > max_ratio) {
-			dW("Memory usage ratio limit reached! limit=%f, current=%f, used=%ld MB, free=%ld MB, total=%ld MB, count of items=%ld",
-			max_ratio, c_ratio, mu_proc.mu_rss / 1024, mu_sys.mu_realfree / 1024, mu_sys.mu_total / 1024, item_cnt);
-			errno = ENOMEM;
-			return (1);
-		}
+	return 0;
+}
 
-	}
+int probe_item_expired(struct probe_ctx *ctx)
+{
+	char *message = oscap_sprintf("Object is incomplete because %s.", oval_deadline_reason());
+	int ret = probe_item_incomplete(ctx, message);
 
-	return (0);
+	free(message);
+	return ret;
 }
 
 /**
@@ -528,8 +707,10 @@ static int probe_cobj_memcheck(size_t item_cnt, double max_ratio)
  * Returns:
  * 0 ... the item was succesfully added to the collected object
  * 1 ... the item was filtered out
- * 2 ... the item was not added because of memory constraints
- *       and the collected object was flagged as incomplete
+ * 2 ... the item was not added because of memory constraints or
+ *       a deadline (see oval_deadline_expired()) and the collected
+ *       object was flagged as incomplete, also after the items which
+ *       decide the tests of the object were collected
  *-1 ... unexpected/internal error
  *
  * The caller must not free the item, it's freed automatically
@@ -545,39 +726,38 @@ int probe_item_collect(struct probe_ctx *ctx, SEXP_t *item)
 		return -1;
 	}
 
+	/*
+	 * Flush the items of a different collected object, e.g. when the
+	 * probe main function is run for another variable binding.
+	 */
+	if (ctx->ibatch.count > 0 && ctx->ibatch.cobj != ctx->probe_out) {
+		if (probe_icache_add_batch(ctx->icache, &ctx->ibatch) != 0) {
+			SEXP_free(item);
+			return -1;
+		}
+	}
+
 	cobj_content = SEXP_listref_nth(ctx->probe_out, 3);
-	cobj_itemcnt = SEXP_list_length(cobj_content);
+	cobj_itemcnt = SEXP_list_length(cobj_content) + ctx->ibatch.count;
 	SEXP_free(cobj_content);
+	OSCAP_TRACE2(item__collect, ctx->probe_out, cobj_itemcnt);
 
-	memcheck_ret = probe_cobj_memcheck(cobj_itemcnt, ctx->max_mem_ratio);
+	if (oval_deadline_expired()) {
+		SEXP_free(item);
+		if (probe_item_expired(ctx) != 0)
+			return -1;
+		return 2;
+	}
+
+	memcheck_ret = probe_membudget_check(&ctx->membudget, cobj_itemcnt);
 	if (memcheck_ret == -1) {
 		dE("Failed to check available memory");
 		return -1;
 	}
 	if (memcheck_ret == 1) {
-
-		/*
-		 * Don't set the message again if the collected object is
-		 * already flagged as incomplete.
-		 */
-		if (probe_cobj_get_flag(ctx->probe_out) != SYSCHAR_FLAG_INCOMPLETE) {
-			SEXP_t *msg;
-			/*
-			 * Sync with the icache thread before modifying the
-			 * collected object.
-			 */
-			if (probe_icache_nop(ctx->icache) != 0)
-				return -1;
-
-			msg = probe_msg_creat(OVAL_MESSAGE_LEVEL_WARNING,
-			                      "Object is incomplete due to memory constraints.");
-
-			probe_cobj_add_msg(ctx->probe_out, msg);
-			probe_cobj_set_flag(ctx->probe_out, SYSCHAR_FLAG_INCOMPLETE);
-
-			SEXP_free(msg);
-		}
-
+		oscap_stats_add(OSCAP_STATS_MEMCHECK_REJECTIONS, 1);
+		if (probe_item_incomplete(ctx, "Object is incomplete due to memory constraints.") != 0)
+			return -1;
 		return 2;
 	}
 
@@ -586,26 +766,20 @@ int probe_item_collect(struct probe_ctx *ctx, SEXP_t *item)
 		return (1);
         }
 
-        if (probe_icache_add(ctx->icache, ctx->probe_out, item) != 0) {
-                dE("Can't add item (%p) to the item cache (%p)", item, ctx->icache);
-                SEXP_free(item);
-                return (-1);
-        }
-
-        return (0);
-}
+	/* the next checkpoint stops the probe, the item is still collected */
+	if (ctx->item_limit > 0 && probe_ent_getstatus(item) == SYSCHAR_STATUS_EXISTS &&
+	    ++ctx->item_exists >= ctx->item_limit)
+		oval_deadline_object_stop();
 
-static void probe_icache_free_node(struct rbt_i64_node *n)
-{
-        probe_citem_t *ci = (probe_citem_t *)n->data;
+        ctx->ibatch.cobj = ctx->probe_out;
+        ctx->ibatch.item[ctx->ibatch.count++] = item;
 
-	for ( ; ci->count > 0 ; --ci->count ) {
-		SEXP_free(ci->item[ci->count - 1]);
-	}
+        if (ctx->ibatch.count == PROBE_IBATCH_CAPACITY) {
+                if (probe_icache_add_batch(ctx->icache, &ctx->ibatch) != 0)
+                        return (-1);
+        }
 
-        free(ci->item);
-        free(ci);
-        return;
+        return (0);
 }
 
 void probe_icache_free(probe_icache_t *cache)
@@ -618,7 +792,7 @@ void probe_icache_free(probe_icache_t *cache)
         pthread_cond_destroy(&cache->queue_notempty);
         pthread_cond_destroy(&cache->queue_notfull);
 
-        rbt_i64_free_cb(cache->tree, &probe_icache_free_node);
+        icache_table_free(&cache->table);
         free(cache);
         return;
 }
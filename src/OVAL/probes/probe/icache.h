@@ -23,13 +23,22 @@
 #define ICACHE_H
 
 #include <stddef.h>
+#include <stdint.h>
 #include <sexp.h>
-#include "../SEAP/generic/rbt/rbt.h"
+#include "_sexp-ID.h"
 
 #ifndef PROBE_IQUEUE_CAPACITY
 #define PROBE_IQUEUE_CAPACITY 1024
 #endif
 
+#ifndef PROBE_IBATCH_CAPACITY
+#define PROBE_IBATCH_CAPACITY 64
+#endif
+
+#ifndef PROBE_ICACHE_INITIAL_CAPACITY
+#define PROBE_ICACHE_INITIAL_CAPACITY 1024 /* must be a power of 2 */
+#endif
+
 typedef struct {
         SEXP_t *cobj;
         union {
@@ -38,9 +47,25 @@ typedef struct {
         } p;
 } probe_iqpair_t;
 
+/*
+ * Cached item slot. Slots are stored inline in an open-addressing
+ * table indexed by the content hash of the item, items with colliding
+ * hashes occupy consecutive slots (linear probing).
+ */
+typedef struct {
+        SEXP_ID_t hash; /* content hash of the item (SEXP_ID_v) */
+        SEXP_t   *item; /* NULL if the slot is empty */
+} probe_citem_t;
+
 typedef struct {
-        rbt_t    *tree; /* XXX: rewrite to extensible or linear hashing */
-        pthread_t thid;
+        probe_citem_t *slot;
+        size_t         capacity; /* number of slots, always a power of 2 */
+        size_t         count;    /* number of occupied slots */
+} probe_ctable_t;
+
+typedef struct {
+        probe_ctable_t table;
+        pthread_t      thid;
 
         pthread_mutex_t queue_mutex;
         pthread_cond_t  queue_notempty;
@@ -51,16 +76,33 @@ typedef struct {
         uint16_t        queue_end;
         uint16_t        queue_cnt;
         uint16_t        queue_max;
+
+        uint64_t        lookups; /* number of items looked up, updated by the worker */
+        uint64_t        hits;    /* number of items found in the cache */
 } probe_icache_t;
 
+/*
+ * Per-worker buffer of items waiting to be handed over to the icache
+ * worker thread. All items in the buffer belong to the same collected
+ * object and are queued in one go, under a single lock of the queue.
+ */
 typedef struct {
-        SEXP_t  **item;
-        uint16_t  count;
-} probe_citem_t;
+        SEXP_t  *cobj;
+        SEXP_t  *item[PROBE_IBATCH_CAPACITY];
+        uint16_t count;
+} probe_ibatch_t;
 
 probe_icache_t *probe_icache_new(void);
 int probe_icache_add(probe_icache_t *cache, SEXP_t *cobj, SEXP_t *item);
 int probe_icache_nop(probe_icache_t *cache);
+
+void probe_ibatch_init(probe_ibatch_t *batch);
+int probe_icache_add_batch(probe_icache_t *cache, probe_ibatch_t *batch);
+/*
+ * Queue all pending items of the batch and wait until the icache worker
+ * thread handles them, i.e. probe_icache_nop() semantics for the batch.
+ */
+int probe_icache_sync(probe_icache_t *cache, probe_ibatch_t *batch);
 void probe_icache_free(probe_icache_t *cache);
 
 #endif /* ICACHE_H */
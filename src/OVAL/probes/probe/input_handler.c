@@ -38,24 +38,96 @@
 #include "../SEAP/generic/rbt/rbt.h"
 #include "probe.h"
 #include "worker.h"
+#include "pool.h"
 #include "rcache.h"
 #include "input_handler.h"
 #include "common/compat_pthread_barrier.h"
 
-static void pthread_attr_cleanup_handler(void *arg)
+/*
+ * Look up the result for probe_in in the result cache. Objects with the
+ * `skip_eval' attribute get an empty collected object with the requested
+ * flag. Returns NULL if the object has to be evaluated by a worker.
+ */
+static SEXP_t *probe_input_lookup(probe_t *probe, SEXP_t *probe_in, SEXP_t *oid)
 {
-	pthread_attr_destroy(arg);
+	SEXP_t *probe_out, *skip_flag, *obj_mask;
+	oval_syschar_collection_flag_t cobj_flag;
+
+	probe_out = probe_rcache_sexp_get(probe->rcache, oid);
+
+	if (probe_out != NULL)
+		return (probe_out);
+
+	skip_flag = probe_obj_getattrval(probe_in, "skip_eval");
+
+	if (skip_flag == NULL)
+		return (NULL);
+
+	obj_mask = probe_obj_getmask(probe_in);
+	cobj_flag = SEXP_number_geti_32(skip_flag);
+	probe_out = probe_cobj_new(cobj_flag, NULL, NULL, obj_mask);
+
+	if (probe_rcache_sexp_add(probe->rcache, oid, probe_out) != 0) {
+		/* TODO */
+		abort();
+	}
+
+	SEXP_free(skip_flag);
+	SEXP_free(obj_mask);
+
+	return (probe_out);
+}
+
+/*
+ * Accept an object passed directly by the library (see sch_queue_call). The
+ * lookup is the same as for SEAP requests, only the result is handed back
+ * through the call instead of a reply message.
+ */
+int probe_input_call(void *arg, sch_queue_call_t *call)
+{
+	probe_t *probe = (probe_t *)arg;
+	probe_pwpair_t *pair;
+	SEXP_t *oid, *probe_out;
+
+	oid = probe_obj_getattrval(call->obj, "id");
+
+	if (oid == NULL) {
+		dE("No `id' attribute");
+		sch_queue_call_done(call, NULL, PROBE_ENOATTR);
+		return (0);
+	}
+
+	probe_out = probe_input_lookup(probe, call->obj, oid);
+	SEXP_free(oid);
+
+	if (probe_out != NULL) {
+		sch_queue_call_done(call, probe_out, 0);
+		return (0);
+	}
+
+	pair = malloc(sizeof(probe_pwpair_t));
+	pair->probe = probe;
+	pair->pth = probe_worker_new();
+	pair->pth->call = call;
+
+	if (probe_pool_submit(probe, &probe_worker_runfn, pair) != 0) {
+		dW("Cannot queue the direct call for a worker thread: %d, %s.", errno, strerror(errno));
+		free(pair->pth);
+		free(pair);
+		return (-1);
+	}
+
+	return (0);
 }
 
 /*
  * The input handler waits for incomming eval requests and either returns
- * a result immediately if it is found in the result cache or spawns a new
- * worker thread which takes care of evaluating the request, caching the
- * result and sending it to the requestee.
+ * a result immediately if it is found in the result cache or queues the
+ * request for the worker pool. The worker takes care of evaluating the
+ * request, caching the result and sending it to the requestee.
  */
 void *probe_input_handler(void *arg)
 {
-        pthread_attr_t pth_attr;
         probe_t       *probe = (probe_t *)arg;
 
         int probe_ret, cstate; /* XXX */
@@ -75,16 +147,6 @@ void *probe_input_handler(void *arg)
 
         TH_CANCEL_OFF;
 
-        if (pthread_attr_init(&pth_attr))
-                return (NULL);
-
-        if (pthread_attr_setdetachstate(&pth_attr, PTHREAD_CREATE_JOINABLE)) {
-                pthread_attr_destroy(&pth_attr);
-                return (NULL);
-        }
-
-	pthread_cleanup_push(pthread_attr_cleanup_handler, (void *)&pth_attr);
-        
         switch (errno = pthread_barrier_wait(&OSCAP_GSYM(th_barrier)))
         {
         case 0:
@@ -126,87 +188,59 @@ void *probe_input_handler(void *arg)
 
 		if (oid != NULL) {
 			SEXP_VALIDATE(oid);
-			probe_out = probe_rcache_sexp_get(probe->rcache, oid);
+			probe_out = probe_input_lookup(probe, probe_in, oid);
+			SEXP_free(oid);
+			SEXP_free(probe_in);
+			probe_in = NULL;
 
 			if (probe_out == NULL) { /* cache miss */
-				SEXP_t *skip_flag, *obj_mask;
-
-				skip_flag = probe_obj_getattrval(probe_in, "skip_eval");
-				obj_mask = probe_obj_getmask(probe_in);
-				SEXP_free(probe_in);
-				probe_in = NULL;
-
-				if (skip_flag != NULL) {
-					oval_syschar_collection_flag_t cobj_flag;
-
-					cobj_flag = SEXP_number_geti_32(skip_flag);
-					probe_out = probe_cobj_new(cobj_flag, NULL, NULL, obj_mask);
-
-					if (probe_rcache_sexp_add(probe->rcache, oid, probe_out) != 0) {
-						/* TODO */
-						abort();
-					}
-
-					probe_ret = 0;
-					SEXP_free(oid);
-					SEXP_free(skip_flag);
-					SEXP_free(obj_mask);
+				probe_pwpair_t *pair = malloc(sizeof(probe_pwpair_t));
+				pair->probe = probe;
+				pair->pth = probe_worker_new();
+				pair->pth->sid = SEAP_msg_id(seap_request);
+				pair->pth->msg = seap_request;
+				pair->pth->msg_handler = &probe_worker;
+
+				if (rbt_i32_add(probe->workers, pair->pth->sid, pair->pth, NULL) != 0) {
+					/*
+						* Getting here means that there is already a
+						* thread handling the message with the given
+						* ID.
+						*/
+					dW("Attempt to evaluate an object "
+						"(ID=%u) " // TODO: 64b IDs
+						"which is already being evaluated by another thread.", pair->pth->sid);
+
+					free(pair->pth);
+					free(pair);
+					SEAP_msg_free(seap_request);
 				} else {
+					/* OK */
 
-					SEXP_free(oid);
-					SEXP_free(skip_flag);
-					SEXP_free(obj_mask);
-
-					probe_pwpair_t *pair = malloc(sizeof(probe_pwpair_t));
-					pair->probe = probe;
-					pair->pth = probe_worker_new();
-					pair->pth->sid = SEAP_msg_id(seap_request);
-					pair->pth->msg = seap_request;
-					pair->pth->msg_handler = &probe_worker;
-
-					if (rbt_i32_add(probe->workers, pair->pth->sid, pair->pth, NULL) != 0) {
-						/*
-							* Getting here means that there is already a
-							* thread handling the message with the given
-							* ID.
-							*/
-						dW("Attempt to evaluate an object "
-							"(ID=%u) " // TODO: 64b IDs
-							"which is already being evaluated by another thread.", pair->pth->sid);
+					if (probe_pool_submit(probe, &probe_worker_runfn, pair) != 0)
+					{
+						dE("Cannot queue the request for a worker thread: %d, %s.", errno, strerror(errno));
 
+						if (rbt_i32_del(probe->workers, pair->pth->sid, NULL) != 0)
+							dE("rbt_i32_del: failed to remove worker thread (ID=%u)", pair->pth->sid);
+
+						SEAP_msg_free(pair->pth->msg);
 						free(pair->pth);
 						free(pair);
-						SEAP_msg_free(seap_request);
-					} else {
-						/* OK */
-
-						if (pthread_create(&pair->pth->tid, &pth_attr, &probe_worker_runfn, pair))
-						{
-							dE("Cannot start a new worker thread: %d, %s.", errno, strerror(errno));
-
-							if (rbt_i32_del(probe->workers, pair->pth->sid, NULL) != 0)
-								dE("rbt_i32_del: failed to remove worker thread (ID=%u)", pair->pth->sid);
-
-							SEAP_msg_free(pair->pth->msg);
-							free(pair->pth);
-							free(pair);
 
-							probe_ret = PROBE_EUNKNOWN;
-							probe_out = NULL;
+						probe_ret = PROBE_EUNKNOWN;
+						probe_out = NULL;
 
-							goto __error_reply;
-						}
+						goto __error_reply;
 					}
-
-					seap_request = NULL;
-					continue;
 				}
-			} else {
-				/* cache hit */
-				SEXP_free(oid);
-				SEXP_free(probe_in);
-				probe_ret = 0;
+
+				seap_request = NULL;
+				continue;
 			}
+
+			/* cache hit */
+			probe_ret = 0;
 		} else {
                         /* the `id' was not found in the input object */
                         dE("No `id' attribute");
@@ -250,6 +284,5 @@ void *probe_input_handler(void *arg)
 		SEAP_msg_free(seap_request);
 	} /* main loop */
 
-        pthread_cleanup_pop(1);
         return (NULL);
 }
@@ -23,5 +23,6 @@
 #define INPUT_HANDLER
 
 void *probe_input_handler(void *arg);
+int probe_input_call(void *arg, sch_queue_call_t *call);
 
 #endif /* INPUT_HANDLER */
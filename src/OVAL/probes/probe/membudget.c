@@ -0,0 +1,251 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <pthread.h>
+#include <fcntl.h>
+#ifndef OS_WINDOWS
+#include <unistd.h>
+#endif
+
+#include "common/debug_priv.h"
+#include "common/memusage.h"
+#include "_sexp-value.h"
+
+#include "membudget.h"
+
+#define MEMBUDGET_PROC_STATM       "/proc/self/statm"
+
+static pthread_once_t membudget_once = PTHREAD_ONCE_INIT;
+
+static struct {
+	int    statm_fd;      /* /proc/self/statm */
+	size_t mem_total;     /* MemTotal (bytes) */
+	size_t page_size;
+} membudget = { -1, 0, 0 };
+
+#if defined(OS_LINUX)
+static int membudget_pread_sizet(int fd, size_t *value, size_t field)
+{
+	char buf[128], *beg, *end;
+	ssize_t len;
+
+	len = pread(fd, buf, sizeof buf - 1, 0);
+	if (len <= 0)
+		return (-1);
+
+	buf[len] = '\0';
+	beg = buf;
+
+	for (;;) {
+		errno = 0;
+		*value = strtoull(beg, &end, 10);
+
+		if (end == beg || errno == ERANGE)
+			return (-1);
+		if (field-- == 0)
+			return (0);
+
+		beg = end;
+	}
+}
+
+#endif /* OS_LINUX */
+
+static void membudget_init_once(void)
+{
+#if defined(OS_LINUX)
+	struct sys_memusage mu_sys;
+	struct cgroup_memusage mu_cg;
+
+	if (oscap_sys_memusage(&mu_sys) != 0) {
+		dW("Can't read the system memory usage, using the default memory check");
+		return;
+	}
+
+	membudget.mem_total = mu_sys.mu_total * 1024;
+	membudget.page_size = (size_t)sysconf(_SC_PAGESIZE);
+	membudget.statm_fd  = open(MEMBUDGET_PROC_STATM, O_RDONLY | O_CLOEXEC);
+
+	if (membudget.statm_fd == -1) {
+		dW("Can't open %s: %s, using the default memory check",
+		   MEMBUDGET_PROC_STATM, strerror(errno));
+		return;
+	}
+
+	/* opens the cgroup files before the probes change their root */
+	if (oscap_cgroup_memusage(&mu_cg) == 0 && mu_cg.mu_limit != 0)
+		dD("Using the cgroup memory limit of %zu MB", mu_cg.mu_limit >> 20);
+#endif
+}
+
+void probe_membudget_global_init(void)
+{
+	pthread_once(&membudget_once, membudget_init_once);
+}
+
+void probe_membudget_init(probe_membudget_t *budget, double max_ratio)
+{
+	memset(budget, 0, sizeof(probe_membudget_t));
+
+	budget->max_ratio  = max_ratio;
+	budget->sexp_start = SEXP_val_memusage();
+}
+
+/*
+ * Sample the RSS of the process and the amount of memory available to it.
+ */
+static int membudget_sample(probe_membudget_t *budget)
+{
+#if defined(OS_LINUX)
+	if (membudget.statm_fd != -1) {
+		size_t rss_pages;
+		struct cgroup_memusage mu_cg;
+
+		if (membudget_pread_sizet(membudget.statm_fd, &rss_pages, 1) != 0)
+			return (-1);
+
+		budget->rss   = rss_pages * membudget.page_size;
+		budget->total = membudget.mem_total;
+
+		if (oscap_cgroup_memusage(&mu_cg) == 0 &&
+		    mu_cg.mu_limit != 0 && mu_cg.mu_limit < budget->total)
+			budget->total = mu_cg.mu_limit;
+	} else
+#endif
+	{
+		struct proc_memusage mu_proc;
+		struct sys_memusage  mu_sys;
+
+		if (oscap_proc_memusage(&mu_proc) != 0)
+			return (-1);
+
+		if (oscap_sys_memusage(&mu_sys) != 0)
+			return (-1);
+
+		budget->rss   = mu_proc.mu_rss * 1024;
+		budget->total = mu_sys.mu_total * 1024;
+
+		struct cgroup_memusage mu_cg;
+		if (oscap_cgroup_memusage(&mu_cg) == 0 &&
+		    mu_cg.mu_limit != 0 && mu_cg.mu_limit < budget->total)
+			budget->total = mu_cg.mu_limit;
+	}
+
+	budget->sexp_sample = SEXP_val_memusage();
+	budget->items   = 0;
+	budget->sampled = 1;
+#if defined(HAVE_CLOCK_GETTIME)
+	clock_gettime(CLOCK_MONOTONIC, &budget->ts);
+#endif
+	return (0);
+}
+
+static int membudget_sample_expired(probe_membudget_t *budget)
+{
+	if (budget->items >= PROBE_MEMBUDGET_SAMPLE_ITEMS)
+		return (1);
+#if defined(HAVE_CLOCK_GETTIME)
+	/* don't ask for the time on every item */
+	if ((budget->items & 0x3f) == 0) {
+		struct timespec now;
+		int64_t msec;
+
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		msec = (int64_t)(now.tv_sec - budget->ts.tv_sec) * 1000 +
+		       (now.tv_nsec - budget->ts.tv_nsec) / 1000000;
+
+		return (msec >= PROBE_MEMBUDGET_SAMPLE_MSEC);
+	}
+#endif
+	return (0);
+}
+
+/*
+ * Estimate the current RSS from the last sample and the number of bytes
+ * allocated (or released) by the S-exp allocator since then.
+ */
+static size_t membudget_estimate(probe_membudget_t *budget)
+{
+	size_t sexp_now = SEXP_val_memusage();
+
+	if (sexp_now > budget->sexp_sample)
+		return (budget->rss + (sexp_now - budget->sexp_sample));
+
+	return (budget->rss);
+}
+
+int probe_membudget_check(probe_membudget_t *budget, size_t item_cnt)
+{
+	double c_ratio;
+
+	if (item_cnt <= PROBE_MEMBUDGET_THRESHOLD)
+		return (0);
+
+	++budget->items;
+
+	if (!budget->sampled || membudget_sample_expired(budget)) {
+		if (membudget_sample(budget) != 0)
+			return (-1);
+	}
+
+	c_ratio = (double)membudget_estimate(budget)/(double)(budget->total);
+
+	if (c_ratio <= budget->max_ratio)
+		return (0);
+
+	/*
+	 * The estimate is over the limit, confirm it with a fresh sample
+	 * unless we just took one.
+	 */
+	if (budget->items > 0) {
+		if (membudget_sample(budget) != 0)
+			return (-1);
+
+		c_ratio = (double)budget->rss/(double)(budget->total);
+
+		if (c_ratio <= budget->max_ratio)
+			return (0);
+	}
+
+	size_t cg_current = 0;
+	struct cgroup_memusage mu_cg;
+
+	if (oscap_cgroup_memusage(&mu_cg) == 0)
+		cg_current = mu_cg.mu_current;
+
+	dW("Memory usage ratio limit reached! limit=%f, current=%f, used=%zu MB, total=%zu MB, "
+	   "cgroup=%zu MB, object=%zu MB, count of items=%zu",
+	   budget->max_ratio, c_ratio, budget->rss >> 20, budget->total >> 20,
+	   cg_current >> 20, (budget->sexp_sample > budget->sexp_start ?
+	                      budget->sexp_sample - budget->sexp_start : 0) >> 20,
+	   item_cnt);
+
+	errno = ENOMEM;
+	return (1);
+}
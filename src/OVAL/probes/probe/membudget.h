@@ -0,0 +1,79 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+#ifndef MEMBUDGET_H
+#define MEMBUDGET_H
+
+#include <stddef.h>
+#include <time.h>
+
+#ifndef PROBE_MEMBUDGET_THRESHOLD
+#define PROBE_MEMBUDGET_THRESHOLD 1000 /* item count */
+#endif
+
+#ifndef PROBE_MEMBUDGET_SAMPLE_ITEMS
+#define PROBE_MEMBUDGET_SAMPLE_ITEMS 1024 /* items between two RSS samples */
+#endif
+
+#ifndef PROBE_MEMBUDGET_SAMPLE_MSEC
+#define PROBE_MEMBUDGET_SAMPLE_MSEC 500 /* max time between two RSS samples */
+#endif
+
+/**
+ * Memory budget of one collected object.
+ *
+ * The resident set size of the process is sampled only once in a while,
+ * in between the samples the memory usage is estimated from the number
+ * of bytes allocated by the S-exp allocator since the last sample.
+ */
+typedef struct {
+	double max_ratio;     /**< maximal allowed RSS to memory size ratio */
+	size_t items;         /**< number of checks since the last sample */
+	size_t rss;           /**< RSS at the last sample (bytes) */
+	size_t total;         /**< available memory at the last sample (bytes) */
+	size_t sexp_sample;   /**< S-exp allocator usage at the last sample */
+	size_t sexp_start;    /**< S-exp allocator usage when the budget was created */
+	struct timespec ts;   /**< time of the last sample */
+	int sampled;          /**< whether the fields above are valid */
+} probe_membudget_t;
+
+/**
+ * Open the files used for memory sampling. The files are kept open for
+ * the lifetime of the process so that sampling is cheap and works even
+ * if the probe changes its root directory (offline mode). Safe to call
+ * multiple times.
+ */
+void probe_membudget_global_init(void);
+
+/**
+ * Initialize the memory budget of a new collected object.
+ * @param budget budget
+ * @param max_ratio maximal allowed ratio of RSS to the available memory
+ */
+void probe_membudget_init(probe_membudget_t *budget, double max_ratio);
+
+/**
+ * Check the memory budget.
+ * @param budget budget
+ * @param item_cnt number of items in the collected object
+ * @return 0 if the memory constraints are not reached, 1 if they are
+ *         (errno is set to ENOMEM) and -1 on error
+ */
+int probe_membudget_check(probe_membudget_t *budget, size_t item_cnt);
+
+#endif /* MEMBUDGET_H */
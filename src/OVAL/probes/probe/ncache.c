@@ -25,183 +25,150 @@
 #endif
 
 #include <stddef.h>
+#include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
-#include <pthread.h>
 #include <sexp.h>
 
-#include "common/bfind.h"
+#include "MurmurHash3.h"
 
 #include "ncache.h"
 
-/**
- * Lock cache for reading.
- * @param c element name cache
- * @param r return value on failure
- */
-#define PROBE_NCACHE_RLOCK(c,r)                                      \
-        do {                                                    \
-                if (pthread_rwlock_rdlock (&(c)->lock) != 0)    \
-                        return (r);                             \
-        } while (0)
-
-/**
- * Unlock cache which was previously locked for reading.
- * @param c element name cache
- * @return this function calls abort(3) if it is unable to
- *         unlock the cache so as to prevent a deadlock.
- */
-#define PROBE_NCACHE_RUNLOCK(c)                                      \
-        do {                                                    \
-                if (pthread_rwlock_unlock (&(c)->lock) != 0)    \
-                        abort ();                               \
-        } while (0)
-
-/**
- * Lock cache for writing.
- * @param c element name cache
- * @param r return value on failure
- */
-#define PROBE_NCACHE_WLOCK(c,r)                                      \
-        do {                                                    \
-                if (pthread_rwlock_wrlock (&(c)->lock) != 0)    \
-                        return (r);                             \
-        } while (0)
-
-/**
- * Unlock cache which was previously locked for writing.
- * @param c element name cache
- * @return this function calls abort(3) if it is unable to
- *         unlock the cache so as to prevent a deadlock.
- */
-#define PROBE_NCACHE_WUNLOCK(c) PROBE_NCACHE_RUNLOCK(c)
+#define PROBE_NCACHE_SEED 0x4f56414c
 
-probe_ncache_t *probe_ncache_new (void)
+static uint32_t probe_ncache_hash (const char *name, size_t len)
 {
-        probe_ncache_t *cache = malloc(sizeof(probe_ncache_t));
+        uint32_t hash;
 
-        if (pthread_rwlock_init (&cache->lock, NULL) != 0) {
-                free (cache);
-                return (NULL);
-        }
+        MurmurHash3_x86_32(name, (int)len, PROBE_NCACHE_SEED, &hash);
+
+        return (hash);
+}
 
-        cache->name = calloc (PROBE_NCACHE_INIT_SIZE, sizeof (SEXP_t *));
-        cache->size = PROBE_NCACHE_INIT_SIZE;
-        cache->real = 0;
+static struct probe_ncache_node *probe_ncache_find (struct probe_ncache_node *node,
+                                                    const char *name, size_t len, uint32_t hash)
+{
+        for (; node != NULL; node = node->next) {
+                if (node->hash == hash && node->len == len &&
+                    SEXP_strcmp (node->sexp, name) == 0)
+                        return (node);
+        }
 
-        return (cache);
+        return (NULL);
 }
 
-void probe_ncache_free (probe_ncache_t *cache)
+/*
+ * Find `name' in the cache or insert it. The new node is published with
+ * a compare-and-swap on the bucket head; if that fails, some other thread
+ * has changed the chain and it has to be searched again because the name
+ * may have been inserted meanwhile.
+ */
+static struct probe_ncache_node *probe_ncache_intern (probe_ncache_t *cache,
+                                                      const char *name, size_t len,
+                                                      bool create, bool *inserted)
 {
-        size_t i;
+        uint32_t hash = probe_ncache_hash (name, len);
+        struct probe_ncache_node **bucket = &cache->bucket[hash & (PROBE_NCACHE_BUCKETS - 1)];
+        struct probe_ncache_node *head, *node, *new_node = NULL;
 
-	if (cache == NULL) {
-		return;
-	}
+        for (;;) {
+                head = *(struct probe_ncache_node * volatile *)bucket;
+                node = probe_ncache_find (head, name, len, hash);
 
-        for (i = 0; i < cache->real; ++i)
-                if (cache->name[i] != NULL)
-                        SEXP_free (cache->name[i]);
+                if (node != NULL || !create)
+                        break;
 
-        free (cache->name);
-        pthread_rwlock_destroy (&cache->lock);
-        free (cache);
+                if (new_node == NULL) {
+                        new_node = malloc (sizeof (struct probe_ncache_node));
 
-        return;
-}
+                        if (new_node == NULL)
+                                return (NULL);
 
-void probe_ncache_clear (probe_ncache_t *cache)
-{
-        size_t i;
+                        new_node->hash = hash;
+                        new_node->len  = len;
+                        new_node->sexp = SEXP_string_new (name, len);
 
-        if (cache == NULL)
-                return;
-
-        if (pthread_rwlock_wrlock(&(cache)->lock))
-                return;
-        for (i = 0; i < cache->real; ++i)
-                if (cache->name[i] != NULL)
-                        SEXP_free(cache->name[i]);
-        cache->real = 0;
-        if (pthread_rwlock_unlock(&(cache)->lock))
-                abort();
-}
+                        if (new_node->sexp == NULL) {
+                                free (new_node);
+                                return (NULL);
+                        }
 
-static int probe_ncache_cmp1 (const char *name, const SEXP_t **sexp)
-{
-        return ((-1) * SEXP_strcmp (*sexp, name));
+                        /* the node is visible to every thread once it's linked */
+                        SEXP_local_share (new_node->sexp);
+                }
+
+                new_node->next = head;
+
+                if (__sync_bool_compare_and_swap (bucket, head, new_node)) {
+                        if (inserted != NULL)
+                                *inserted = true;
+                        return (new_node);
+                }
+        }
+
+        if (new_node != NULL) {
+                SEXP_free (new_node->sexp);
+                free (new_node);
+        }
+
+        return (node);
 }
 
-static int probe_ncache_cmp2 (const SEXP_t **a, const SEXP_t **b)
+probe_ncache_t *probe_ncache_new (void)
 {
-        return SEXP_string_cmp (*a, *b);
+        return calloc (1, sizeof (probe_ncache_t));
 }
 
-SEXP_t *probe_ncache_add (probe_ncache_t *cache, const char *name)
+void probe_ncache_free (probe_ncache_t *cache)
 {
-        SEXP_t *ref;
+        struct probe_ncache_node *node, *next;
+        size_t i;
 
-	if (cache == NULL || name == NULL) {
-		return NULL;
+	if (cache == NULL) {
+		return;
 	}
 
-        ref = SEXP_string_new (name, strlen (name));
-
-        if (ref == NULL)
-                return (NULL);
-
-        PROBE_NCACHE_WLOCK(cache, NULL);
-
-        if (cache->size <= cache->real) {
-                void *new_name = realloc (cache->name, sizeof (SEXP_t *) * (cache->size + PROBE_NCACHE_ADD_SIZE));
-                if (new_name == NULL) {
-                        SEXP_free(ref);
-                        PROBE_NCACHE_WUNLOCK(cache);
-                        return NULL;
+        for (i = 0; i < PROBE_NCACHE_BUCKETS; ++i) {
+                for (node = cache->bucket[i]; node != NULL; node = next) {
+                        next = node->next;
+                        SEXP_free (node->sexp);
+                        free (node);
                 }
-                cache->name  = new_name;
-                cache->size += PROBE_NCACHE_ADD_SIZE;
         }
 
-        cache->name[cache->real] = ref;
-        ++cache->real;
-
-        ref = SEXP_ref (ref);
-        qsort (cache->name, cache->real, sizeof (SEXP_t *), (int (*)(const void *, const void *)) &probe_ncache_cmp2);
-
-        PROBE_NCACHE_WUNLOCK(cache);
+        free (cache);
 
-        return (ref);
+        return;
 }
 
-SEXP_t *probe_ncache_get (probe_ncache_t *cache, const char *name)
+SEXP_t *probe_ncache_add (probe_ncache_t *cache, const char *name)
 {
-        SEXP_t **ref = NULL;
+        struct probe_ncache_node *node;
 
 	if (cache == NULL || name == NULL) {
 		return NULL;
 	}
 
-        PROBE_NCACHE_RLOCK(cache, NULL);
+        node = probe_ncache_intern (cache, name, strlen (name), true, NULL);
 
-        if (cache->real > 0) {
-                ref = (SEXP_t **)oscap_bfind (cache->name, cache->real, sizeof (SEXP_t *),
-                                              (void *)name, (int (*)(void *, void *))&probe_ncache_cmp1);
+        return (node != NULL ? SEXP_ref (node->sexp) : NULL);
+}
 
-                if (ref != NULL)
-                        ref = (SEXP_t **)SEXP_ref (*ref);
-        }
+SEXP_t *probe_ncache_get (probe_ncache_t *cache, const char *name)
+{
+        struct probe_ncache_node *node;
 
-        PROBE_NCACHE_RUNLOCK(cache);
+	if (cache == NULL || name == NULL) {
+		return NULL;
+	}
+
+        node = probe_ncache_intern (cache, name, strlen (name), false, NULL);
 
-        return ((SEXP_t *)(ref));
+        return (node != NULL ? SEXP_ref (node->sexp) : NULL);
 }
 
 SEXP_t *probe_ncache_ref (probe_ncache_t *cache, const char *name)
 {
-        SEXP_t *ref;
-
 	if (name == NULL) {
 		return NULL;
 	}
@@ -209,10 +176,36 @@ SEXP_t *probe_ncache_ref (probe_ncache_t *cache, const char *name)
         if (cache == NULL)
                 return SEXP_string_new (name, strlen (name));
 
-        ref = probe_ncache_get (cache, name);
+        return probe_ncache_add (cache, name);
+}
+
+SEXP_t *probe_ncache_value_r (probe_ncache_t *cache, SEXP_t *sexp_mem, const char *value)
+{
+        struct probe_ncache_node *node;
+        bool inserted = false;
+        size_t len;
+
+        if (value == NULL)
+                return (NULL);
+
+        len = strlen (value);
+
+        if (cache == NULL || len > PROBE_NCACHE_VALUE_MAXLEN)
+                return SEXP_string_new_r (sexp_mem, value, len);
+
+        /*
+         * Once the pool is full only the values which are already
+         * cached are shared. The limit is approximate, concurrent
+         * insertions may overshoot it by the number of threads.
+         */
+        node = probe_ncache_intern (cache, value, len,
+                                    cache->values < PROBE_NCACHE_VALUE_MAXCNT, &inserted);
+
+        if (node == NULL)
+                return SEXP_string_new_r (sexp_mem, value, len);
 
-        if (ref == NULL)
-                ref = probe_ncache_add (cache, name);
+        if (inserted)
+                __sync_fetch_and_add (&cache->values, 1);
 
-        return (ref);
+        return SEXP_ref_r (sexp_mem, node->sexp);
 }
@@ -23,21 +23,37 @@
 #define PROBE_NCACHE_H
 
 #include <stddef.h>
-#include <pthread.h>
+#include <stdint.h>
 #include <sexp.h>
 
-#define PROBE_NCACHE_INIT_SIZE 24
-#define PROBE_NCACHE_ADD_SIZE  8
+/** Number of hash buckets, has to be a power of two */
+#define PROBE_NCACHE_BUCKETS      1024
+/** Longest string value which is interned by probe_ncache_value_r */
+#define PROBE_NCACHE_VALUE_MAXLEN 32
+/** Maximum number of interned string values */
+#define PROBE_NCACHE_VALUE_MAXCNT 8192
+
+struct probe_ncache_node {
+        struct probe_ncache_node *next;
+        uint32_t hash;
+        size_t   len;
+        SEXP_t  *sexp;
+};
 
 /**
- * Element name cache structure. This structure contains an array
- * of cached string S-exps representing the names of elements.
+ * Interned string cache. This structure contains a hash table of
+ * cached string S-exps representing the names of elements and
+ * attributes and a bounded pool of frequent short values.
+ *
+ * Lookups don't take any lock. New names are pushed to the head
+ * of their bucket with an atomic compare-and-swap and cached names
+ * are never removed until the cache is freed, so all the probe
+ * threads can share one cache and compare interned names by their
+ * value pointers.
  */
 typedef struct {
-        pthread_rwlock_t lock; /**< pthread read-write lock */
-        SEXP_t **name; /**< array of S-exp refs */
-        size_t   real; /**< number of cached names */
-        size_t   size; /**< pre-allocated size */
+        struct probe_ncache_node *bucket[PROBE_NCACHE_BUCKETS]; /**< hash chains */
+        uint32_t values; /**< number of strings interned as values */
 } probe_ncache_t;
 
 /**
@@ -52,27 +68,19 @@ probe_ncache_t *probe_ncache_new (void);
  * also freed. However, if they are referenced
  * somewhere else, the memory won't be freed, just
  * the reference count will be decremented.
+ * The cache must not be used by any other thread
+ * at this point.
  * @param cache the cache to be freed
  */
 void probe_ncache_free (probe_ncache_t *cache);
 
-/**
- * Mark memory used by the element name cache as
- * free, effectively emptying the cache (but not
- * altering the amount of memomory allocated for it).
- * The S-exp objects stored in the cache are
- * also freed. However, if they are referenced
- * somewhere else, the memory won't be freed, just
- * the reference count will be decremented.
- * @param cache the cache to be emptied
- */
-void probe_ncache_clear (probe_ncache_t *cache);
-
 /**
  * Add a name to the cache. This will create a new S-exp
  * object and return a reference to it. Reference count
  * of such object will be 2 because the cache hold it's
- * own reference to the object.
+ * own reference to the object. If another thread added
+ * the same name meanwhile, a reference to its object
+ * is returned instead.
  * @param cache element name cache
  * @param name name string
  * @return S-exp reference to the name string
@@ -99,4 +107,16 @@ SEXP_t *probe_ncache_get (probe_ncache_t *cache, const char *name);
  */
 SEXP_t *probe_ncache_ref (probe_ncache_t *cache, const char *name);
 
+/**
+ * Initialize `sexp_mem' as a string S-exp holding `value'. Short
+ * values are interned as long as the pool of values isn't full,
+ * longer ones get their own copy. The reference has to be released
+ * using SEXP_free_r.
+ * @param cache element name cache
+ * @param sexp_mem memory for the S-exp reference
+ * @param value value string
+ * @return `sexp_mem' or NULL on failure
+ */
+SEXP_t *probe_ncache_value_r (probe_ncache_t *cache, SEXP_t *sexp_mem, const char *value);
+
 #endif /* PROBE_NCACHE_H */
@@ -0,0 +1,378 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <pthread.h>
+#ifdef OS_WINDOWS
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#if defined(OS_FREEBSD)
+#include <pthread_np.h>
+#endif
+
+#include "common/debug_priv.h"
+#include "oval_definitions.h"
+#include "pool.h"
+#if !defined(OS_WINDOWS)
+#include "oval_throttle.h"
+#include "common/oscap_threadpool.h"
+#endif
+
+typedef struct probe_task {
+	void *(*func)(void *);
+	void              *arg;
+	probe_t           *probe;
+	struct probe_task *prev;
+	struct probe_task *next;
+} probe_task_t;
+
+typedef struct {
+	pthread_mutex_t lock;
+	probe_task_t   *head;
+	probe_task_t   *tail;
+} probe_deque_t;
+
+/*
+ * The pool lock protects the counters below. Tasks are pushed to a deque
+ * before nqueued is incremented, so a thread which decremented nqueued is
+ * guaranteed to find a task in one of the deques.
+ */
+static struct {
+	pthread_mutex_t lock;
+	pthread_cond_t  work;     /* a task was queued or the pool is stopping */
+	pthread_cond_t  done;     /* a thread has exited */
+	probe_deque_t  *deque;
+	size_t          ndeques;
+	size_t          target;   /* number of threads available for tasks */
+	size_t          nthreads; /* number of running threads */
+	size_t          nbusy;    /* threads executing a task */
+	size_t          nblocked; /* threads executing a task waiting for the library */
+	size_t          nqueued;  /* tasks waiting in the deques */
+	size_t          nspawned; /* used to assign home deques */
+	size_t          users;
+	bool            stop;
+} pool = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.work = PTHREAD_COND_INITIALIZER,
+	.done = PTHREAD_COND_INITIALIZER,
+};
+
+static pthread_once_t pool_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t  pool_key;
+
+static void probe_pool_key_init(void)
+{
+	(void)pthread_key_create(&pool_key, NULL);
+}
+
+static size_t probe_pool_size(void)
+{
+	return oscap_threadpool_jobs("OSCAP_PROBE_JOBS", 0, PROBE_POOL_MAX_THREADS);
+}
+
+static void probe_deque_push(probe_deque_t *dq, probe_task_t *task)
+{
+	pthread_mutex_lock(&dq->lock);
+	task->next = NULL;
+	task->prev = dq->tail;
+	if (dq->tail != NULL)
+		dq->tail->next = task;
+	else
+		dq->head = task;
+	dq->tail = task;
+	pthread_mutex_unlock(&dq->lock);
+}
+
+static void probe_deque_unlink(probe_deque_t *dq, probe_task_t *task)
+{
+	if (task->prev != NULL)
+		task->prev->next = task->next;
+	else
+		dq->head = task->next;
+	if (task->next != NULL)
+		task->next->prev = task->prev;
+	else
+		dq->tail = task->prev;
+}
+
+/*
+ * The owner of the deque takes the oldest task, other threads steal
+ * the newest one so that the requests stay with their home thread as
+ * long as it keeps up.
+ */
+static probe_task_t *probe_deque_take(probe_deque_t *dq, bool steal)
+{
+	probe_task_t *task;
+
+	pthread_mutex_lock(&dq->lock);
+	task = steal ? dq->tail : dq->head;
+	if (task != NULL)
+		probe_deque_unlink(dq, task);
+	pthread_mutex_unlock(&dq->lock);
+
+	return task;
+}
+
+/* called with the pool lock held and nqueued already decremented */
+static probe_task_t *probe_pool_take(size_t home)
+{
+	probe_task_t *task;
+	size_t i;
+
+	for (;;) {
+		for (i = 0; i < pool.ndeques; ++i) {
+			task = probe_deque_take(&pool.deque[(home + i) % pool.ndeques], i != 0);
+			if (task != NULL)
+				return task;
+		}
+	}
+}
+
+static void *probe_pool_thread(void *arg)
+{
+	size_t home = (size_t)(uintptr_t)arg;
+	probe_task_t *task;
+
+#if defined(HAVE_PTHREAD_SETNAME_NP)
+# if defined(OS_APPLE)
+	pthread_setname_np("probe_worker");
+# else
+	pthread_setname_np(pthread_self(), "probe_worker");
+# endif
+#endif
+	pthread_setspecific(pool_key, &pool);
+
+	pthread_mutex_lock(&pool.lock);
+	for (;;) {
+		while (pool.nqueued == 0 && !pool.stop)
+			pthread_cond_wait(&pool.work, &pool.lock);
+		if (pool.stop)
+			break;
+
+		--pool.nqueued;
+		++pool.nbusy;
+		task = probe_pool_take(home);
+		pthread_mutex_unlock(&pool.lock);
+
+#if !defined(OS_WINDOWS)
+		oval_throttle_cpu();
+#endif
+		dD("Running a task of the %s probe.", oval_subtype_get_text(task->probe->subtype));
+		task->func(task->arg);
+		free(task);
+
+		pthread_mutex_lock(&pool.lock);
+		--pool.nbusy;
+		/* retire the threads started in place of blocked ones */
+		if (pool.nthreads - pool.nblocked > pool.target)
+			break;
+	}
+
+	--pool.nthreads;
+	pthread_cond_broadcast(&pool.done);
+	pthread_mutex_unlock(&pool.lock);
+
+	return NULL;
+}
+
+/* called with the pool lock held */
+static int probe_pool_spawn(void)
+{
+	pthread_attr_t attr;
+	pthread_t tid;
+	int ret;
+
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	ret = pthread_create(&tid, &attr, &probe_pool_thread,
+			     (void *)(uintptr_t)(pool.nspawned % pool.ndeques));
+	pthread_attr_destroy(&attr);
+
+	if (ret != 0) {
+		dE("Cannot start a new worker thread: %d, %s.", ret, strerror(ret));
+		errno = ret;
+		return -1;
+	}
+
+	++pool.nthreads;
+	++pool.nspawned;
+
+	return 0;
+}
+
+int probe_pool_acquire(void)
+{
+	int ret = 0;
+
+	pthread_once(&pool_key_once, probe_pool_key_init);
+	pthread_mutex_lock(&pool.lock);
+
+	if (pool.users++ == 0) {
+		if (pool.deque == NULL) {
+			pool.target = probe_pool_size();
+			pool.ndeques = pool.target;
+			pool.deque = calloc(pool.ndeques, sizeof(probe_deque_t));
+			for (size_t i = 0; i < pool.ndeques; ++i)
+				pthread_mutex_init(&pool.deque[i].lock, NULL);
+			dI("Starting a pool of %zu probe worker threads.", pool.target);
+		}
+		pool.stop = false;
+
+		while (pool.nthreads - pool.nblocked < pool.target) {
+			if (probe_pool_spawn() != 0)
+				break;
+		}
+
+		if (pool.nthreads == pool.nblocked) {
+			--pool.users;
+			ret = -1;
+		}
+	}
+
+	pthread_mutex_unlock(&pool.lock);
+	return ret;
+}
+
+void probe_pool_release(void)
+{
+	pthread_mutex_lock(&pool.lock);
+
+	if (pool.users == 0 || --pool.users > 0) {
+		pthread_mutex_unlock(&pool.lock);
+		return;
+	}
+
+	/*
+	 * Wait for the idle threads only, a busy thread exits when
+	 * its task is finished.
+	 */
+	pool.stop = true;
+	pthread_cond_broadcast(&pool.work);
+	while (pool.nthreads > pool.nbusy)
+		pthread_cond_wait(&pool.done, &pool.lock);
+
+	if (pool.nthreads == 0) {
+		for (size_t i = 0; i < pool.ndeques; ++i)
+			pthread_mutex_destroy(&pool.deque[i].lock);
+		free(pool.deque);
+		pool.deque = NULL;
+		pool.ndeques = 0;
+	}
+
+	pthread_mutex_unlock(&pool.lock);
+}
+
+int probe_pool_submit(probe_t *probe, void *(*func)(void *), void *arg)
+{
+	probe_task_t *task;
+
+	task = malloc(sizeof(probe_task_t));
+	if (task == NULL)
+		return -1;
+
+	task->func = func;
+	task->arg = arg;
+	task->probe = probe;
+
+	pthread_mutex_lock(&pool.lock);
+	if (pool.deque == NULL || pool.stop) {
+		pthread_mutex_unlock(&pool.lock);
+		free(task);
+		errno = ECANCELED;
+		return -1;
+	}
+	pthread_mutex_unlock(&pool.lock);
+
+	probe_deque_push(&pool.deque[probe->subtype % pool.ndeques], task);
+
+	pthread_mutex_lock(&pool.lock);
+	++pool.nqueued;
+	pthread_cond_signal(&pool.work);
+	pthread_mutex_unlock(&pool.lock);
+
+	return 0;
+}
+
+size_t probe_pool_cancel(probe_t *probe, void (*dtor)(void *))
+{
+	probe_task_t *task, *next;
+	size_t count = 0;
+
+	pthread_mutex_lock(&pool.lock);
+
+	for (size_t i = 0; i < pool.ndeques; ++i) {
+		probe_deque_t *dq = &pool.deque[i];
+
+		pthread_mutex_lock(&dq->lock);
+		for (task = dq->head; task != NULL; task = next) {
+			next = task->next;
+			if (task->probe != probe)
+				continue;
+			probe_deque_unlink(dq, task);
+			if (dtor != NULL)
+				dtor(task->arg);
+			free(task);
+			++count;
+		}
+		pthread_mutex_unlock(&dq->lock);
+	}
+	pool.nqueued -= count;
+
+	pthread_mutex_unlock(&pool.lock);
+
+	if (count > 0)
+		dD("Removed %zu queued tasks of the %s probe.", count, oval_subtype_get_text(probe->subtype));
+
+	return count;
+}
+
+void probe_pool_block_begin(void)
+{
+	pthread_once(&pool_key_once, probe_pool_key_init);
+	if (pthread_getspecific(pool_key) == NULL)
+		return;
+
+	pthread_mutex_lock(&pool.lock);
+	++pool.nblocked;
+	if (!pool.stop && pool.nthreads - pool.nblocked < pool.target &&
+	    pool.nthreads < PROBE_POOL_MAX_THREADS)
+		(void)probe_pool_spawn();
+	pthread_mutex_unlock(&pool.lock);
+}
+
+void probe_pool_block_end(void)
+{
+	if (pthread_getspecific(pool_key) == NULL)
+		return;
+
+	pthread_mutex_lock(&pool.lock);
+	--pool.nblocked;
+	pthread_mutex_unlock(&pool.lock);
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+#ifndef PROBE_POOL_H
+#define PROBE_POOL_H
+
+#include "probe.h"
+
+#ifndef PROBE_POOL_MAX_THREADS
+#define PROBE_POOL_MAX_THREADS 256 /* including threads started in place of blocked ones */
+#endif
+
+/*
+ * Process-wide pool of worker threads shared by all the probes.
+ *
+ * The pool runs as many threads as there are online CPUs, or as set by
+ * the OSCAP_PROBE_JOBS environment variable. Every probe type has a home
+ * deque which its requests are queued to, a thread takes requests from
+ * its own deque first and steals from the other deques when it's empty.
+ */
+
+/**
+ * Start the pool if it isn't running yet. Each call has to be paired
+ * with a call to probe_pool_release.
+ * @return 0 on success, -1 on failure (errno is set)
+ */
+int probe_pool_acquire(void);
+
+/**
+ * Stop the pool when it's not used by any probe anymore.
+ */
+void probe_pool_release(void);
+
+/**
+ * Queue a task for execution by the pool.
+ * @param probe probe the task belongs to
+ * @param func task function
+ * @param arg argument of the task function
+ * @return 0 on success, -1 on failure
+ */
+int probe_pool_submit(probe_t *probe, void *(*func)(void *), void *arg);
+
+/**
+ * Remove all the tasks of the probe which haven't started yet.
+ * @param dtor called for the argument of each removed task
+ * @return number of the removed tasks
+ */
+size_t probe_pool_cancel(probe_t *probe, void (*dtor)(void *));
+
+/**
+ * Mark the beginning and the end of a section in which a task waits for
+ * the library. The library can send more requests meanwhile, so another
+ * thread is started if there would be less than the configured number of
+ * threads available to run them. Surplus threads exit once the blocked
+ * tasks continue. No-op when called outside of the pool.
+ */
+void probe_pool_block_begin(void);
+void probe_pool_block_end(void);
+
+#endif /* PROBE_POOL_H */
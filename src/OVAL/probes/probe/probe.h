@@ -38,6 +38,7 @@
 #include "ncache.h"
 #include "rcache.h"
 #include "icache.h"
+#include "membudget.h"
 #include "probe-common.h"
 #include "option.h"
 #include "common/util.h"
@@ -54,6 +55,7 @@ typedef struct {
 
 	SEAP_CTX_t *SEAP_ctx; /**< SEAP context */
 	int         sd;       /**< SEAP descriptor */
+	sch_queuedata_t *queuedata; /**< queue shared with the library */
 
 	pthread_t th_input;
 	pthread_t th_signal;
@@ -73,19 +75,28 @@ typedef struct {
 	int selected_offline_mode;
 	oval_subtype_t subtype;
 
-	int real_root_fd;
-	int real_cwd_fd;
 } probe_t;
 
 struct probe_ctx {
         SEXP_t         *probe_in;  /**< S-exp representation of the input object */
         SEXP_t         *probe_out; /**< collected object */
         SEXP_t         *filters;   /**< object filters (OVAL 5.8 and higher) */
+	struct probe_filter_set *cfilters; /**< filters compiled for probe_filters_reject */
         probe_icache_t *icache;    /**< item cache */
+        probe_ibatch_t  ibatch;    /**< items not yet handed over to the item cache */
 	int offline_mode;
-	double max_mem_ratio;
+	probe_membudget_t membudget; /**< memory budget of the collected object */
+	uint32_t item_limit;  /**< existing items which decide the tests, 0 if all are needed */
+	uint32_t item_exists; /**< existing items collected for all the variable bindings */
 };
 
+/**
+ * Flag the collected object as incomplete after a checkpoint stopped its
+ * collection, with the reason given by oval_deadline_reason().
+ * @return 0 on success, -1 on error
+ */
+int probe_item_expired(struct probe_ctx *ctx);
+
 typedef enum {
 	PROBE_OFFLINE_NONE = 0x00,
 	PROBE_OFFLINE_CHROOT = 0x01,
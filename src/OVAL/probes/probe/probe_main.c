@@ -39,11 +39,14 @@
 #include "rcache.h"
 #include "icache.h"
 #include "worker.h"
+#include "pool.h"
+#include "registry.h"
 #include "input_handler.h"
 #include "probe-api.h"
 #include "option.h"
 #include <oscap_debug.h>
 #include "debug_priv.h"
+#include "profiling_priv.h"
 
 #if defined(OS_FREEBSD)
 #include <pthread_np.h>
@@ -87,10 +90,8 @@ static SEXP_t *probe_reset(SEXP_t *arg0, void *arg1)
          * FIXME: implement main loop locking & worker waiting
          */
 	probe_rcache_free(probe->rcache);
-        probe_ncache_free(probe->ncache);
-
         probe->rcache = probe_rcache_new();
-        probe->ncache = probe_ncache_new();
+        /* the name cache is shared by all probes and stays valid */
 
         return(NULL);
 }
@@ -143,6 +144,10 @@ static void probe_common_main_cleanup(void *arg)
 	dD("probe_common_main_cleanup started");
 
 	probe_t *probe = (probe_t *)arg;
+
+	/* Stop accepting direct calls from the library */
+	sch_queue_call_register(probe->queuedata, NULL, NULL);
+
 	/* Cancel probe_input_handler thread */
 	if (pthread_cancel(probe->th_input) != 0) {
 		dE("Cannot cancel the probe input thread.");
@@ -156,12 +161,14 @@ static void probe_common_main_cleanup(void *arg)
 	}
 	dD("probe_input_handler thread has joined with status %ld", (long) status);
 
-	probe_fini_function_t fini_function = probe_table_get_fini_function(probe->subtype);
-	if (fini_function != NULL) {
-		fini_function(probe->probe_arg);
-	}
+	probe_pool_cancel(probe, &probe_worker_discard);
+	probe_pool_release();
+
+	probe_registry_release(probe->subtype, probe->probe_arg);
 
 	probe_rcache_free(probe->rcache);
+	oscap_profiling_add_icache(oval_subtype_get_text(probe->subtype),
+	                           probe->icache->lookups, probe->icache->hits);
 	probe_icache_free(probe->icache);
 	rbt_i32_free(probe->workers);
 	SEAP_CTX_free(probe->SEAP_ctx);
@@ -178,8 +185,6 @@ void *probe_common_main(void *arg)
 	sch_queuedata_t *data = probe_argument->queuedata;
 	oval_subtype_t subtype = probe_argument->subtype;
 	probe.subtype = subtype;
-	probe.real_root_fd = -1;
-	probe.real_cwd_fd = -1;
 
 #if defined(HAVE_PTHREAD_SETNAME_NP)
 # if defined(OS_APPLE)
@@ -219,7 +224,7 @@ void *probe_common_main(void *arg)
 	 */
 	probe.rcache = probe_rcache_new();
 	probe.icache = probe_icache_new();
-	probe_ncache_clear(OSCAP_GSYM(ncache));
+	probe_membudget_global_init();
 	probe.ncache = OSCAP_GSYM(ncache);
 
 	/*
@@ -244,13 +249,24 @@ void *probe_common_main(void *arg)
 	 */
         probe.workers   = rbt_i32_new();
 
-	probe_init_function_t init_function = probe_table_get_init_function(probe.subtype);
-	if (init_function != NULL) {
-		probe.probe_arg = init_function();
-	}
+	/*
+	 * The probe state is shared with previous and later sessions in
+	 * this process, see registry.h
+	 */
+	probe.probe_arg = probe_registry_acquire(probe.subtype);
+
+	if (probe_pool_acquire() != 0)
+		fail(errno, "probe_pool_acquire", __LINE__ - 1);
 
 	pthread_cleanup_push(probe_common_main_cleanup, (void *) &probe);
 
+	/*
+	 * Objects which don't need anything from the library while being
+	 * evaluated may be passed to us directly, bypassing SEAP
+	 */
+	probe.queuedata = data;
+	sch_queue_call_register(data, &probe_input_call, &probe);
+
 	pthread_attr_init(&th_attr);
 
 	if (pthread_create(&probe.th_input, &th_attr, &probe_input_handler, &probe))
@@ -0,0 +1,168 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "common/debug_priv.h"
+#include "oval_definitions.h"
+#include "probe-table.h"
+#include "registry.h"
+
+typedef struct probe_state {
+	oval_subtype_t      subtype;
+	void               *arg;   /* value returned by the init function */
+	char               *root;  /* OSCAP_PROBE_ROOT at init time, NULL if unset */
+	unsigned int        users;
+	struct probe_state *next;
+} probe_state_t;
+
+static pthread_mutex_t registry_lock = PTHREAD_MUTEX_INITIALIZER;
+static probe_state_t  *registry = NULL;
+
+static const char *probe_registry_root(void)
+{
+	const char *root = getenv("OSCAP_PROBE_ROOT");
+
+	return (root != NULL && root[0] != '\0') ? root : NULL;
+}
+
+static bool probe_registry_root_eq(const char *a, const char *b)
+{
+	if (a == NULL || b == NULL)
+		return a == b;
+
+	return strcmp(a, b) == 0;
+}
+
+static void probe_state_fini(probe_state_t *state)
+{
+	probe_fini_function_t fini_function = probe_table_get_fini_function(state->subtype);
+
+	if (fini_function != NULL)
+		fini_function(state->arg);
+}
+
+void *probe_registry_acquire(oval_subtype_t subtype)
+{
+	probe_init_function_t init_function = probe_table_get_init_function(subtype);
+	const char *root = probe_registry_root();
+	probe_state_t *state;
+	void *arg;
+
+	if (init_function == NULL)
+		return NULL;
+
+	pthread_mutex_lock(&registry_lock);
+
+	for (state = registry; state != NULL; state = state->next) {
+		if (state->subtype == subtype)
+			break;
+	}
+
+	if (state != NULL && !probe_registry_root_eq(state->root, root)) {
+		if (state->users > 0) {
+			/*
+			 * Another session uses the probe with a different
+			 * root, this one gets a state of its own which isn't
+			 * kept after release.
+			 */
+			pthread_mutex_unlock(&registry_lock);
+			return init_function();
+		}
+
+		dI("Probe root has changed, reinitializing the %s probe.", oval_subtype_get_text(subtype));
+		probe_state_fini(state);
+		free(state->root);
+		state->root = root != NULL ? strdup(root) : NULL;
+		state->arg = init_function();
+	} else if (state == NULL) {
+		state = malloc(sizeof(probe_state_t));
+		state->subtype = subtype;
+		state->root = root != NULL ? strdup(root) : NULL;
+		state->users = 0;
+		state->arg = init_function();
+		state->next = registry;
+		registry = state;
+	} else {
+		dD("Reusing the initialized state of the %s probe.", oval_subtype_get_text(subtype));
+	}
+
+	state->users++;
+	arg = state->arg;
+
+	pthread_mutex_unlock(&registry_lock);
+
+	return arg;
+}
+
+void probe_registry_release(oval_subtype_t subtype, void *arg)
+{
+	probe_state_t *state;
+
+	if (probe_table_get_init_function(subtype) == NULL)
+		return;
+
+	pthread_mutex_lock(&registry_lock);
+
+	for (state = registry; state != NULL; state = state->next) {
+		if (state->subtype == subtype && state->arg == arg && state->users > 0) {
+			state->users--;
+			pthread_mutex_unlock(&registry_lock);
+			return;
+		}
+	}
+
+	pthread_mutex_unlock(&registry_lock);
+
+	/* not registered, see probe_registry_acquire */
+	probe_fini_function_t fini_function = probe_table_get_fini_function(subtype);
+
+	if (fini_function != NULL)
+		fini_function(arg);
+}
+
+void probe_registry_cleanup(void)
+{
+	probe_state_t **prev, *state;
+
+	pthread_mutex_lock(&registry_lock);
+
+	prev = &registry;
+	while ((state = *prev) != NULL) {
+		if (state->users > 0) {
+			dW("The %s probe is still running, its state is kept.", oval_subtype_get_text(state->subtype));
+			prev = &state->next;
+			continue;
+		}
+
+		*prev = state->next;
+		probe_state_fini(state);
+		free(state->root);
+		free(state);
+	}
+
+	pthread_mutex_unlock(&registry_lock);
+}
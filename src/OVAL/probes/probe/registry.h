@@ -0,0 +1,52 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+#ifndef PROBE_REGISTRY_H
+#define PROBE_REGISTRY_H
+
+#include "oval_types.h"
+
+/*
+ * Process-wide registry of initialized probe states.
+ *
+ * The state created by the init function of a probe (open rpmdb handles,
+ * filesystem tables, ...) is kept here when the probe thread exits, so that
+ * the next probe session in the same process can reuse it. A state is
+ * thrown away and initialized again when OSCAP_PROBE_ROOT differs from
+ * the value it was created with.
+ */
+
+/**
+ * Get the initialized state of a probe, calling its init function if there
+ * is no usable one. Each call has to be paired with probe_registry_release.
+ * @return the probe argument, NULL if the probe has no init function
+ */
+void *probe_registry_acquire(oval_subtype_t subtype);
+
+/**
+ * Give back a state obtained by probe_registry_acquire. The state stays
+ * initialized for later use.
+ */
+void probe_registry_release(oval_subtype_t subtype, void *arg);
+
+/**
+ * Finalize all the states which are not used by any probe.
+ */
+void probe_registry_cleanup(void);
+
+#endif /* PROBE_REGISTRY_H */
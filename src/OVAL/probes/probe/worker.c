@@ -45,10 +45,17 @@ extern int chroot(const char *);
 #endif
 
 #include "probe-api.h"
+#include "_sexp-ID.h"
 #include "common/debug_priv.h"
+#include "common/profiling_priv.h"
+#include "common/stats_priv.h"
+#include "common/trace_priv.h"
 #include "entcmp.h"
+#include "../_probe-api.h"
+#include "oval_deadline.h"
 
 #include "worker.h"
+#include "pool.h"
 #include "probe-table.h"
 #include "probe.h"
 
@@ -76,6 +83,107 @@ static void preload_libraries_before_chroot()
 	pthread_join(t, NULL);
 }
 
+/*
+ * Count the collected items, see stats_priv.h, and record the time spent
+ * evaluating an object, see profiling_priv.h
+ */
+static void probe_worker_profile(probe_t *probe, const struct oscap_profiling_mark *mark, SEXP_t *obj, SEXP_t *res)
+{
+	SEXP_t *oid, *items;
+	char *oid_str;
+	uint64_t count = 0;
+
+	items = res != NULL ? probe_cobj_get_items(res) : NULL;
+	if (items != NULL)
+		count = SEXP_list_length(items);
+	SEXP_free(items);
+
+	if (count > 0)
+		oscap_stats_add_probe_items(oval_subtype_get_text(probe->subtype), count);
+
+	if (!oscap_profiling_get_enabled())
+		return;
+
+	oid = probe_obj_getattrval(obj, "id");
+	oid_str = oid != NULL ? SEXP_string_cstr(oid) : NULL;
+
+	oscap_profiling_stop(mark, OSCAP_PROFILING_OBJECT, oid_str, oval_subtype_get_text(probe->subtype), count);
+
+	free(oid_str);
+	SEXP_free(oid);
+}
+
+/*
+ * The ID of the object for the object__begin and object__end markers, see
+ * trace_priv.h, NULL if no tracer is attached to them.
+ */
+static char *probe_worker_trace_begin(probe_t *probe, SEXP_t *obj)
+{
+	SEXP_t *oid;
+	char *oid_str;
+
+	if (!OSCAP_TRACE_ENABLED(object__begin) && !OSCAP_TRACE_ENABLED(object__end))
+		return NULL;
+
+	oid = probe_obj_getattrval(obj, "id");
+	oid_str = oid != NULL ? SEXP_string_cstr(oid) : NULL;
+	SEXP_free(oid);
+
+	OSCAP_TRACE2(object__begin, oval_subtype_get_text(probe->subtype), oid_str);
+	return oid_str;
+}
+
+static void probe_worker_trace_end(probe_t *probe, char *oid_str, SEXP_t *res, int ret)
+{
+	if (OSCAP_TRACE_ENABLED(object__end)) {
+		SEXP_t *items = res != NULL ? probe_cobj_get_items(res) : NULL;
+		size_t count = items != NULL ? SEXP_list_length(items) : 0;
+
+		SEXP_free(items);
+		OSCAP_TRACE4(object__end, oval_subtype_get_text(probe->subtype), oid_str, count, ret);
+	}
+	free(oid_str);
+}
+
+/*
+ * Evaluate an object handed over by the library through a direct call. The
+ * result is cached the same way as for SEAP requests and passed back by
+ * reference.
+ */
+static void probe_worker_runcall(probe_pwpair_t *pair)
+{
+	sch_queue_call_t *call = pair->pth->call;
+	SEXP_t *probe_res, *oid;
+	int     probe_ret;
+	char   *trace_oid;
+
+	struct oscap_profiling_mark mark;
+
+	probe_ret = -1;
+	trace_oid = probe_worker_trace_begin(pair->probe, call->obj);
+	oscap_profiling_start(&mark);
+	probe_res = probe_worker_obj(pair->probe, call->obj, &probe_ret);
+	probe_worker_profile(pair->probe, &mark, call->obj, probe_res);
+	probe_worker_trace_end(pair->probe, trace_oid, probe_res, probe_ret);
+	dD("handler result = %p, return code = %d", probe_res, probe_ret);
+
+	if (probe_res != NULL) {
+		oid = probe_obj_getattrval(call->obj, "id");
+
+		/* the object may have been evaluated meanwhile as a prefetched set member */
+		if (probe_rcache_sexp_add(pair->probe->rcache, oid, probe_res) != 0)
+			dD("The result is already cached.");
+		SEXP_free(oid);
+	}
+
+	if (probe_ret != 0 || probe_res == NULL) {
+		SEXP_free(probe_res);
+		sch_queue_call_done(call, NULL, probe_ret != 0 ? probe_ret : PROBE_EUNKNOWN);
+	} else {
+		sch_queue_call_done(call, probe_res, 0);
+	}
+}
+
 void *probe_worker_runfn(void *arg)
 {
 	dD("probe_worker_runfn has started");
@@ -83,18 +191,29 @@ void *probe_worker_runfn(void *arg)
 
 	SEXP_t *probe_res, *obj, *oid;
 	int     probe_ret;
+	char   *trace_oid;
+	struct oscap_profiling_mark mark;
+
+	if (pair->pth->call != NULL) {
+		dD("handling direct call %p", pair->pth->call);
+		probe_worker_runcall(pair);
+		free(pair->pth);
+		free(pair);
+
+		dD("probe_worker_runfn has finished");
+		return (NULL);
+	}
 
-#if defined(HAVE_PTHREAD_SETNAME_NP)
-# if defined(OS_APPLE)
-	pthread_setname_np("probe_worker");
-# else
-	pthread_setname_np(pthread_self(), "probe_worker");
-# endif
-#endif
 	dD("handling SEAP message ID %u", pair->pth->sid);
 	//
 	probe_ret = -1;
+	obj = SEAP_msg_get(pair->pth->msg);
+	trace_oid = probe_worker_trace_begin(pair->probe, obj);
+	oscap_profiling_start(&mark);
 	probe_res = pair->pth->msg_handler(pair->probe, pair->pth->msg, &probe_ret);
+	probe_worker_profile(pair->probe, &mark, obj, probe_res);
+	probe_worker_trace_end(pair->probe, trace_oid, probe_res, probe_ret);
+	SEXP_free(obj);
 	//
 	dD("handler result = %p, return code = %d", probe_res, probe_ret);
 
@@ -114,23 +233,14 @@ void *probe_worker_runfn(void *arg)
 		dD("probe_worker_runfn has finished");
                 return (NULL);
 	} else {
-                SEXP_t *items;
-
 		dD("probe thread deleted");
 
 		obj = SEAP_msg_get(pair->pth->msg);
 		oid = probe_obj_getattrval(obj, "id");
-                items = probe_cobj_get_items(probe_res);
-
-                if (items != NULL) {
-                        SEXP_list_sort(items, SEXP_refcmp);
-                        SEXP_free(items);
-                }
 
-		if (probe_rcache_sexp_add(pair->probe->rcache, oid, probe_res) != 0) {
-			/* TODO */
-			abort();
-		}
+		/* the object may have been evaluated meanwhile as a prefetched set member */
+		if (probe_rcache_sexp_add(pair->probe->rcache, oid, probe_res) != 0)
+			dD("The result is already cached.");
 		SEXP_free(obj);
 		SEXP_free(oid);
 	}
@@ -174,22 +284,39 @@ void *probe_worker_runfn(void *arg)
         SEAP_msg_free(pair->pth->msg);
         free(pair->pth);
 	free(pair);
-	pthread_detach(pthread_self());
 
 	dD("probe_worker_runfn has finished");
 	return (NULL);
 }
 
+void probe_worker_discard(void *arg)
+{
+	probe_pwpair_t *pair = (probe_pwpair_t *)arg;
+
+	if (pair->pth->call != NULL) {
+		dD("discarding direct call %p", pair->pth->call);
+		sch_queue_call_done(pair->pth->call, NULL, PROBE_EUNKNOWN);
+		free(pair->pth);
+		free(pair);
+		return;
+	}
+
+	dD("discarding SEAP message ID %u", pair->pth->sid);
+	rbt_i32_del(pair->probe->workers, pair->pth->sid, NULL);
+
+	SEAP_msg_free(pair->pth->msg);
+	free(pair->pth);
+	free(pair);
+}
+
 probe_worker_t *probe_worker_new(void)
 {
 	probe_worker_t *pth = malloc(sizeof(probe_worker_t));
 
 	pth->sid = 0;
-#ifndef OS_WINDOWS
-	pth->tid = 0;
-#endif
 	pth->msg_handler = NULL;
 	pth->msg = NULL;
+	pth->call = NULL;
 
 	return (pth);
 }
@@ -198,6 +325,7 @@ struct probe_varref_ctx {
 	SEXP_t *pi2;
 	unsigned int ent_cnt;
 	struct probe_varref_ctx_ent *ent_lst;
+	bool multival; /* some entities are not iterated */
 };
 
 struct probe_varref_ctx_ent {
@@ -208,9 +336,28 @@ struct probe_varref_ctx_ent {
 
 static void probe_varref_destroy_ctx(struct probe_varref_ctx *ctx);
 
-static int probe_varref_create_ctx(const SEXP_t *probe_in, SEXP_t *varrefs, struct probe_varref_ctx **octx)
+static bool probe_varref_multival(const SEXP_t *name, const char *const *multival)
+{
+	if (multival == NULL)
+		return false;
+
+	for (; *multival != NULL; ++multival) {
+		if (SEXP_strcmp(name, *multival) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * The entities listed in multival get all the values of the variable at once
+ * and are not included in the iteration. The number of the remaining entities
+ * is stored in ctx->ent_cnt, it may be zero.
+ */
+static int probe_varref_create_ctx(const SEXP_t *probe_in, SEXP_t *varrefs, const char *const *multival, struct probe_varref_ctx **octx)
 {
-	unsigned int i, ent_cnt, val_cnt;
+	unsigned int i, n, ent_cnt, val_cnt;
+	bool native;
 	SEXP_t *ent_name, *ent, *varref, *val_lst;
 	SEXP_t *r0, *r1, *r2, *r3;
 	SEXP_t *vid, *vidx_name, *vidx_val;
@@ -221,14 +368,15 @@ static int probe_varref_create_ctx(const SEXP_t *probe_in, SEXP_t *varrefs, stru
 
 	struct probe_varref_ctx *ctx = malloc(sizeof(struct probe_varref_ctx));
 	ctx->pi2 = SEXP_softref((SEXP_t *)probe_in);
-	ctx->ent_cnt = ent_cnt;
+	ctx->ent_cnt = 0;
+	ctx->multival = false;
 	ctx->ent_lst = malloc(ent_cnt * sizeof (ctx->ent_lst[0]));
 
 	vidx_name = SEXP_string_new(":val_idx", 8);
 	vidx_val = SEXP_number_newu(0);
 
 	/* entities that use var_refs are stored at the begining of an object */
-	for (i = 0; i < ent_cnt; ++i) {
+	for (i = 0, n = 0; i < ent_cnt; ++i) {
 		/*
 		 * add variable values to entities and insert
 		 * them into the new probe_in object
@@ -237,15 +385,20 @@ static int probe_varref_create_ctx(const SEXP_t *probe_in, SEXP_t *varrefs, stru
 		vid = probe_ent_getattrval(r0, "var_ref");
 		r1 = SEXP_list_first(r0);
 		r2 = SEXP_list_first(r1);
-
-		r3 = SEXP_list_new(r2, vidx_name, vidx_val, NULL);
-		SEXP_free(r0);
-		r0 = SEXP_list_rest(r1);
-		ent_name = SEXP_list_join(r3, r0);
 		SEXP_free(r0);
+
+		native = probe_varref_multival(r2, multival);
+		if (native) {
+			ent_name = SEXP_ref(r1);
+		} else {
+			r3 = SEXP_list_new(r2, vidx_name, vidx_val, NULL);
+			r0 = SEXP_list_rest(r1);
+			ent_name = SEXP_list_join(r3, r0);
+			SEXP_free(r0);
+			SEXP_free(r3);
+		}
 		SEXP_free(r1);
 		SEXP_free(r2);
-		SEXP_free(r3);
 
 		SEXP_sublist_foreach(varref, varrefs, 4, SEXP_LIST_END) {
 			r0 = SEXP_list_first(varref);
@@ -284,11 +437,17 @@ static int probe_varref_create_ctx(const SEXP_t *probe_in, SEXP_t *varrefs, stru
 		SEXP_free(r0);
 		SEXP_free(ent);
 
+		if (native) {
+			ctx->multival = true;
+			continue;
+		}
+
 		r0 = SEXP_listref_nth(ctx->pi2, i + 2);
-		ctx->ent_lst[i].ent_name_sref = SEXP_listref_first(r0);
+		ctx->ent_lst[n].ent_name_sref = SEXP_listref_first(r0);
 		SEXP_free(r0);
-		ctx->ent_lst[i].val_cnt = val_cnt;
-		ctx->ent_lst[i].next_val_idx = 0;
+		ctx->ent_lst[n].val_cnt = val_cnt;
+		ctx->ent_lst[n].next_val_idx = 0;
+		ctx->ent_cnt = ++n;
 	}
 
 	SEXP_free(vidx_name);
@@ -324,6 +483,9 @@ static int probe_varref_iterate_ctx(struct probe_varref_ctx *ctx)
 	SEXP_t *r0, *r1, *r2;
 	struct probe_varref_ctx_ent *ent, *ent_end;
 
+	if (ctx->ent_cnt == 0)
+		return 0;
+
 	ent = ctx->ent_lst;
 	ent_end = ent + ctx->ent_cnt;
 	val_cnt = ent->val_cnt;
@@ -379,7 +541,9 @@ static SEXP_t *probe_ste_fetch(probe_t *probe, SEXP_t *id_list)
 	if (i_len == 0)
 		return SEXP_list_new(NULL);
 
+	probe_pool_block_begin();
 	res = SEAP_cmd_exec(probe->SEAP_ctx, probe->sd, 0, PROBECMD_STE_FETCH, id_list, SEAP_CMDTYPE_SYNC, NULL, NULL);
+	probe_pool_block_end();
 
 	r_len = SEXP_list_length(res);
 
@@ -396,12 +560,17 @@ static SEXP_t *probe_ste_fetch(probe_t *probe, SEXP_t *id_list)
 		_A(ste != NULL);
 
 		if (probe_rcache_sexp_add(probe->rcache, id, ste) != 0) {
+			/* the state may have been prefetched meanwhile */
+			SEXP_t *cached = probe_rcache_sexp_get(probe->rcache, id);
 
-			SEXP_free(res);
-			SEXP_free(ste);
-			SEXP_free(id);
+			if (cached == NULL) {
+				SEXP_free(res);
+				SEXP_free(ste);
+				SEXP_free(id);
 
-			return (NULL);
+				return (NULL);
+			}
+			SEXP_free(cached);
 		}
 
 		SEXP_free(ste);
@@ -415,7 +584,7 @@ static SEXP_t *probe_ste_fetch(probe_t *probe, SEXP_t *id_list)
  * Evaluate an OVAL object identified by its id. Using a remote
  * synchronous SEAP command, this function executes evaluation of an
  * OVAL object which results weren't found in the probe cache. This
- * indirectly spawns a new thread in the probe process which evaluates
+ * indirectly queues a new request for the worker pool which evaluates
  * the object and stores the result in the probe cache. That result is
  * not send to the library because it doesn't know how to handle
  * it. Instead, the result is fetched by this function from the cache
@@ -427,7 +596,9 @@ static SEXP_t *probe_obj_eval(probe_t *probe, SEXP_t *id)
 {
 	SEXP_t *res, *rid;
 
+	probe_pool_block_begin();
 	res = SEAP_cmd_exec(probe->SEAP_ctx, probe->sd, 0, PROBECMD_OBJ_EVAL, id, SEAP_CMDTYPE_SYNC, NULL, NULL);
+	probe_pool_block_end();
 
 	rid = SEXP_list_first(res);
 	if (SEXP_string_cmp(id, rid) != 0) {
@@ -484,8 +655,89 @@ static SEXP_t *probe_prepare_filters(probe_t *probe, SEXP_t *obj)
 	return filters;
 }
 
+/*
+ * Set of items keyed by their content hash (SEXP_ID_v). Slots are stored
+ * inline in an open-addressing table with linear probing. The table is
+ * sized for the number of items up front and never grows. The items are
+ * not referenced by the set.
+ */
+typedef struct {
+	SEXP_ID_t hash;
+	SEXP_t   *item; /* NULL if the slot is empty */
+	bool      used; /* the item has already been matched */
+} probe_iset_slot_t;
+
+typedef struct {
+	probe_iset_slot_t *slot;
+	size_t             mask; /* number of slots - 1, a power of 2 - 1 */
+} probe_iset_t;
+
+static int probe_iset_init(probe_iset_t *set, size_t count)
+{
+	size_t capacity = 16;
+
+	while (capacity < 2 * count)
+		capacity <<= 1;
+
+	set->slot = calloc(capacity, sizeof(probe_iset_slot_t));
+	set->mask = capacity - 1;
+
+	return set->slot != NULL ? 0 : -1;
+}
+
+static void probe_iset_free(probe_iset_t *set)
+{
+	free(set->slot);
+	set->slot = NULL;
+}
+
+/*
+ * Find the slot of the item or of the empty slot where it belongs.
+ */
+static probe_iset_slot_t *probe_iset_lookup(probe_iset_t *set, SEXP_t *item, SEXP_ID_t hash)
+{
+	size_t i = (size_t)hash & set->mask;
+
+	while (set->slot[i].item != NULL) {
+		if (set->slot[i].hash == hash
+		    && (SEXP_refcmp(set->slot[i].item, item) == 0 || SEXP_deepcmp(set->slot[i].item, item)))
+			break;
+		i = (i + 1) & set->mask;
+	}
+
+	return &set->slot[i];
+}
+
+/*
+ * Add the item to the set.
+ * @return true if the item was added, false if it already was in the set
+ */
+static bool probe_iset_add(probe_iset_t *set, SEXP_t *item)
+{
+	SEXP_ID_t hash = SEXP_ID_v(item);
+	probe_iset_slot_t *slot = probe_iset_lookup(set, item, hash);
+
+	if (slot->item != NULL)
+		return false;
+
+	slot->hash = hash;
+	slot->item = item;
+	slot->used = false;
+
+	return true;
+}
+
+static probe_iset_slot_t *probe_iset_get(probe_iset_t *set, SEXP_t *item)
+{
+	probe_iset_slot_t *slot = probe_iset_lookup(set, item, SEXP_ID_v(item));
+
+	return slot->item != NULL ? slot : NULL;
+}
+
 /**
- * Combine two collections of items using an operation.
+ * Combine two collections of items using an operation. The items are
+ * matched by their content hash, the order of the items in the result
+ * follows the order in the input collections.
  * @param cobj1 item collection
  * @param cobj2 item collection
  * @param op operation
@@ -493,10 +745,11 @@ static SEXP_t *probe_prepare_filters(probe_t *probe, SEXP_t *obj)
  */
 static SEXP_t *probe_set_combine(SEXP_t *cobj0, SEXP_t *cobj1, oval_setobject_operation_t op)
 {
-        SEXP_t *set0, *set1, *res_cobj, *cobj0_mask, *cobj1_mask, *res_mask;
-        register int cmp;
-        register SEXP_t *item0, *item1, *res;
-        register SEXP_list_it *sit0, *sit1;
+	SEXP_t *set0, *set1, *res_cobj, *cobj0_mask, *cobj1_mask, *res_mask;
+	SEXP_t *item, *res;
+	SEXP_list_it *sit;
+	probe_iset_t iset;
+	probe_iset_slot_t *slot;
 	oval_syschar_collection_flag_t res_flag;
 
 	if (cobj0 == NULL)
@@ -504,98 +757,71 @@ static SEXP_t *probe_set_combine(SEXP_t *cobj0, SEXP_t *cobj1, oval_setobject_op
 	if (cobj1 == NULL)
 		return SEXP_ref(cobj0);
 
-        set0 = probe_cobj_get_items(cobj0);
-        set1 = probe_cobj_get_items(cobj1);
-        cobj0_mask = probe_cobj_get_mask(cobj0);
-        cobj1_mask = probe_cobj_get_mask(cobj1);
-
-        /* prepare storage for results */
-        res = SEXP_list_new(NULL);
-        res_flag = probe_cobj_combine_flags(probe_cobj_get_flag(cobj0),
-                                            probe_cobj_get_flag(cobj1), op);
-        res_mask = SEXP_list_join(cobj0_mask, cobj1_mask);
-
-        /* prepare iterators & first items */
-        sit0  = SEXP_list_it_new(set0);
-        sit1  = SEXP_list_it_new(set1);
-        item0 = SEXP_list_it_next(sit0);
-        item1 = SEXP_list_it_next(sit1);
-
-        /* perform the set operation */
-        switch(op) {
-        case OVAL_SET_OPERATION_UNION:
-                while (item0 != NULL && item1 != NULL) {
-                        cmp = SEXP_refcmp(item0, item1);
-
-                        if (cmp < 0) {
-                                SEXP_list_add(res, item0);
-                                item0 = SEXP_list_it_next(sit0);
-                        } else if (cmp > 0) {
-                                SEXP_list_add(res, item1);
-                                item1 = SEXP_list_it_next(sit1);
-                        } else {
-                                SEXP_list_add(res, item0);
-                                item0 = SEXP_list_it_next(sit0);
-                                item1 = SEXP_list_it_next(sit1);
-                        }
-                }
+	set0 = probe_cobj_get_items(cobj0);
+	set1 = probe_cobj_get_items(cobj1);
+	cobj0_mask = probe_cobj_get_mask(cobj0);
+	cobj1_mask = probe_cobj_get_mask(cobj1);
 
-                if (item0 != NULL) {
-                        do {
-                                SEXP_list_add(res, item0);
-                        } while((item0 = SEXP_list_it_next(sit0)) != NULL);
-                } else if (item1 != NULL) {
-                        do {
-                                SEXP_list_add(res, item1);
-                        } while((item1 = SEXP_list_it_next(sit1)) != NULL);
-                }
+	/* prepare storage for results */
+	res = SEXP_list_new(NULL);
+	res_flag = probe_cobj_combine_flags(probe_cobj_get_flag(cobj0),
+					    probe_cobj_get_flag(cobj1), op);
+	res_mask = SEXP_list_join(cobj0_mask, cobj1_mask);
 
-                break;
-        case OVAL_SET_OPERATION_INTERSECTION:
-                while (item0 != NULL && item1 != NULL) {
-                        cmp = SEXP_refcmp(item0, item1);
-
-                        if (cmp < 0)
-                                item0 = SEXP_list_it_next(sit0);
-                        else if (cmp > 0)
-                                item1 = SEXP_list_it_next(sit1);
-                        else {
-                                SEXP_list_add(res, item0);
-                                item0 = SEXP_list_it_next(sit0);
-                                item1 = SEXP_list_it_next(sit1);
-                        }
-                }
+	if (probe_iset_init(&iset, SEXP_list_length(set1) +
+			   (op == OVAL_SET_OPERATION_UNION ? SEXP_list_length(set0) : 0)) != 0) {
+		dE("Can't allocate the item set");
+		abort();
+	}
 
-                break;
-        case OVAL_SET_OPERATION_COMPLEMENT:
-                while (item0 != NULL && item1 != NULL) {
-                        cmp = SEXP_refcmp(item0, item1);
-
-                        if (cmp < 0) {
-                                SEXP_list_add(res, item0);
-                                item0 = SEXP_list_it_next(sit0);
-                        } else if (cmp > 0) {
-                                item1 = SEXP_list_it_next(sit1);
-                        } else {
-                                item0 = SEXP_list_it_next(sit0);
-                                item1 = SEXP_list_it_next(sit1);
-                        }
-                }
+	/* perform the set operation */
+	switch(op) {
+	case OVAL_SET_OPERATION_UNION:
+		sit = SEXP_list_it_new(set0);
+		while ((item = SEXP_list_it_next(sit)) != NULL) {
+			if (probe_iset_add(&iset, item))
+				SEXP_list_add(res, item);
+		}
+		SEXP_list_it_free(sit);
 
-                if (item0 != NULL) {
-                        do {
-                                SEXP_list_add(res, item0);
-                        } while((item0 = SEXP_list_it_next(sit0)) != NULL);
-                }
+		sit = SEXP_list_it_new(set1);
+		while ((item = SEXP_list_it_next(sit)) != NULL) {
+			if (probe_iset_add(&iset, item))
+				SEXP_list_add(res, item);
+		}
+		SEXP_list_it_free(sit);
+
+		break;
+	case OVAL_SET_OPERATION_INTERSECTION:
+	case OVAL_SET_OPERATION_COMPLEMENT:
+		sit = SEXP_list_it_new(set1);
+		while ((item = SEXP_list_it_next(sit)) != NULL)
+			probe_iset_add(&iset, item);
+		SEXP_list_it_free(sit);
+
+		sit = SEXP_list_it_new(set0);
+		while ((item = SEXP_list_it_next(sit)) != NULL) {
+			slot = probe_iset_get(&iset, item);
+
+			if (op == OVAL_SET_OPERATION_INTERSECTION) {
+				/* each matched item is reported once */
+				if (slot != NULL && !slot->used) {
+					slot->used = true;
+					SEXP_list_add(res, item);
+				}
+			} else if (slot == NULL) {
+				SEXP_list_add(res, item);
+			}
+		}
+		SEXP_list_it_free(sit);
 
-                break;
-        default:
-                dE("Unknown set operation: %d", op);
-                abort();
-        }
+		break;
+	default:
+		dE("Unknown set operation: %d", op);
+		abort();
+	}
 
-        SEXP_list_it_free(sit0);
-        SEXP_list_it_free(sit1);
+	probe_iset_free(&iset);
 
 	/*
 	 * If the collected information is complete but all the items are
@@ -619,64 +845,122 @@ static SEXP_t *probe_set_combine(SEXP_t *cobj0, SEXP_t *cobj1, oval_setobject_op
 }
 
 /**
- * Apply a set of filters to a collected object.
+ * Apply a set of filters to a collected object. If no item is removed the
+ * input collection is returned (with a new reference) instead of a copy.
  * @param cobj item collection
  * @param filter set (list) of filters
  * @return collection of items without items that match any of the filters in the input set
  */
+/*
+ * Remove the repeated items from the collected object, the order of the
+ * remaining items is kept.
+ */
+static void probe_cobj_dedup(SEXP_t *cobj)
+{
+	SEXP_t *items, *res, *item, *r0;
+	SEXP_list_it *sit;
+	probe_iset_t iset;
+
+	items = probe_cobj_get_items(cobj);
+
+	if (probe_iset_init(&iset, SEXP_list_length(items)) != 0) {
+		dE("Can't allocate the item set");
+		abort();
+	}
+
+	res = SEXP_list_new(NULL);
+	sit = SEXP_list_it_new(items);
+	while ((item = SEXP_list_it_next(sit)) != NULL) {
+		if (probe_iset_add(&iset, item))
+			SEXP_list_add(res, item);
+	}
+	SEXP_list_it_free(sit);
+	probe_iset_free(&iset);
+
+	if (SEXP_list_length(res) != SEXP_list_length(items)) {
+		r0 = SEXP_list_replace(cobj, 3, res);
+		SEXP_free(r0);
+	}
+
+	SEXP_free(res);
+	SEXP_free(items);
+}
+
 static SEXP_t *probe_set_apply_filters(SEXP_t *cobj, SEXP_t *filters)
 {
 	SEXP_t *result_items, *items, *item, *mask;
+	SEXP_list_it *sit;
 	oval_syschar_status_t item_status;
 	oval_syschar_collection_flag_t flag;
+	uint32_t kept;
 
-	result_items = SEXP_list_new(NULL);
+	result_items = NULL;
+	kept = 0;
 	flag = probe_cobj_get_flag(cobj);
 	items = probe_cobj_get_items(cobj);
-        mask = probe_cobj_get_mask(cobj);
 
-	SEXP_list_foreach(item, items) {
+	sit = SEXP_list_it_new(items);
+	while ((item = SEXP_list_it_next(sit)) != NULL) {
+		bool drop;
+
 		item_status = probe_ent_getstatus(item);
 
 		switch (item_status) {
-		case SYSCHAR_STATUS_DOES_NOT_EXIST:
-			continue;
-		case SYSCHAR_STATUS_ERROR:
-			break;
 		case SYSCHAR_STATUS_NOT_COLLECTED:
 			{
 				SEXP_t *r0, *r1;
 
-                                r0 = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR,
-                                                      "Supplied item has an invalid status: %d.", item_status);
+				r0 = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR,
+						      "Supplied item has an invalid status: %d.", item_status);
 				r1 = SEXP_list_new(r0, NULL);
 				cobj = probe_cobj_new(SYSCHAR_FLAG_ERROR, r1, NULL, NULL);
+				SEXP_list_it_free(sit);
 				SEXP_free(items);
-				SEXP_free(item);
 				SEXP_free(result_items);
 				SEXP_free(r0);
 				SEXP_free(r1);
-				SEXP_free(mask);
 				return cobj;
 			}
+		case SYSCHAR_STATUS_DOES_NOT_EXIST:
+			drop = true;
+			break;
 		default:
+			drop = probe_item_filtered(item, filters);
 			break;
 		}
 
-		if (!probe_item_filtered(item, filters)) {
-			SEXP_list_add(result_items, item);
+		if (drop && result_items == NULL) {
+			/* first removed item, copy the items kept so far */
+			SEXP_list_it *kit = SEXP_list_it_new(items);
+
+			result_items = SEXP_list_new(NULL);
+			for (uint32_t i = 0; i < kept; ++i)
+				SEXP_list_add(result_items, SEXP_list_it_next(kit));
+			SEXP_list_it_free(kit);
+		}
+
+		if (!drop) {
+			if (result_items != NULL)
+				SEXP_list_add(result_items, item);
+			++kept;
 		}
 	}
+	SEXP_list_it_free(sit);
 
 	/*
 	 * If the collected information is complete but all the items are
 	 * filtered out, the flag is set to SYSCHAR_FLAG_DOES_NOT_EXIST
 	 */
-	if (flag == SYSCHAR_FLAG_COMPLETE
-	    && SEXP_list_length(result_items) == 0)
+	if (flag == SYSCHAR_FLAG_COMPLETE && kept == 0)
 		flag = SYSCHAR_FLAG_DOES_NOT_EXIST;
 
-	cobj = probe_cobj_new(flag, NULL, result_items, mask);
+	if (result_items == NULL && flag == probe_cobj_get_flag(cobj)) {
+		SEXP_free(items);
+		return SEXP_ref(cobj);
+	}
+
+	mask = probe_cobj_get_mask(cobj);
+	cobj = probe_cobj_new(flag, NULL, result_items != NULL ? result_items : items, mask);
 	SEXP_free(items);
 	SEXP_free(result_items);
 	SEXP_free(mask);
@@ -973,15 +1257,111 @@ static SEXP_t *probe_set_eval(probe_t *probe, SEXP_t *set, size_t depth)
 	return result;
 }
 
+#ifndef OS_WINDOWS
+/*
+ * The probes in the PROBE_OFFLINE_OWN mode resolve the paths inside of the
+ * root by themselves and collect at the same time. A probe which needs the
+ * PROBE_OFFLINE_CHROOT mode changes the root of the whole process, so it
+ * runs alone.
+ */
+static pthread_rwlock_t probe_offline_lock = PTHREAD_RWLOCK_INITIALIZER;
+
+struct probe_offline_root {
+	bool locked;
+	int real_root_fd;
+	int real_cwd_fd;
+};
+
+static int probe_offline_enter(int offline_mode, const char *rootdir, struct probe_offline_root *root)
+{
+	root->locked = false;
+	root->real_root_fd = -1;
+	root->real_cwd_fd = -1;
+
+	if (offline_mode == PROBE_OFFLINE_OWN) {
+		pthread_rwlock_rdlock(&probe_offline_lock);
+		root->locked = true;
+	} else if (offline_mode == PROBE_OFFLINE_CHROOT) {
+		pthread_rwlock_wrlock(&probe_offline_lock);
+		root->locked = true;
+
+		root->real_root_fd = open("/", O_RDONLY);
+		if (root->real_root_fd == -1) {
+			dE("open(\"/\") failed: %s", strerror(errno));
+			goto fail;
+		}
+		root->real_cwd_fd = open(".", O_RDONLY);
+		if (root->real_cwd_fd == -1) {
+			dE("open(\".\") failed: %s", strerror(errno));
+			goto fail;
+		}
+		if (chdir(rootdir) != 0) {
+			dE("chdir failed: %s", strerror(errno));
+		}
+		if (chroot(rootdir) != 0) {
+			dE("chroot failed: %s", strerror(errno));
+			goto fail;
+		}
+		dI("Entering chroot mode");
+	}
+	return 0;
+fail:
+	if (root->real_root_fd != -1) {
+		if (fchdir(root->real_root_fd) != 0)
+			dE("fchdir failed: %s", strerror(errno));
+		close(root->real_root_fd);
+	}
+	if (root->real_cwd_fd != -1) {
+		if (fchdir(root->real_cwd_fd) != 0)
+			dE("fchdir failed: %s", strerror(errno));
+		close(root->real_cwd_fd);
+	}
+	pthread_rwlock_unlock(&probe_offline_lock);
+	root->locked = false;
+	return -1;
+}
+
+static int probe_offline_leave(struct probe_offline_root *root)
+{
+	int ret = 0;
+
+	if (root->real_root_fd != -1) {
+		dI("Leaving chroot mode");
+		if (fchdir(root->real_root_fd) != 0) {
+			dE("fchdir failed: %s", strerror(errno));
+			ret = -1;
+		} else if (chroot(".") == -1) {
+			dE("chroot(\".\") failed: %s", strerror(errno));
+			ret = -1;
+		} else if (fchdir(root->real_cwd_fd) != 0) {
+			dE("fchdir failed: %s", strerror(errno));
+			ret = -1;
+		}
+		close(root->real_root_fd);
+		close(root->real_cwd_fd);
+		root->real_root_fd = -1;
+		root->real_cwd_fd = -1;
+	}
+	if (root->locked) {
+		pthread_rwlock_unlock(&probe_offline_lock);
+		root->locked = false;
+	}
+	return ret;
+}
+#endif
+
 /**
- * Worker thread function. This functions handles the evalution of objects and sets.
- * @param msg_in SEAP message with the request which contains the object to be evaluated
+ * Evaluate an object or a set. This is the part of the worker shared by the
+ * SEAP message handler and by direct calls from the library.
+ * @param probe_in the object to be evaluated, the caller keeps its reference
  * @param ret pointer to the return code storage
  */
-SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret)
+SEXP_t *probe_worker_obj(probe_t *probe, SEXP_t *probe_in, int *ret)
 {
+	int offline_mode = PROBE_OFFLINE_NONE;
 #ifndef OS_WINDOWS
 	char *rootdir = NULL;
+	struct probe_offline_root offline_root;
 	probe_offline_mode_function_t offline_mode_function = probe_table_get_offline_mode_function(probe->subtype);
 	if (offline_mode_function != NULL) {
 		probe->supported_offline_mode = offline_mode_function();
@@ -1003,50 +1383,27 @@ SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret)
 
 		} else if (probe->supported_offline_mode & PROBE_OFFLINE_OWN) {
 			dI("Switching probe to PROBE_OFFLINE_OWN mode.");
-			probe->offline_mode = true;
-			probe->selected_offline_mode = PROBE_OFFLINE_OWN;
+			offline_mode = PROBE_OFFLINE_OWN;
 
 		} else if (probe->supported_offline_mode & PROBE_OFFLINE_CHROOT) {
-			probe->real_root_fd = open("/", O_RDONLY);
-			if (probe->real_root_fd == -1) {
-				dE("open(\"/\") failed: %s", strerror(errno));
-				return NULL;
-			}
-			probe->real_cwd_fd = open(".", O_RDONLY);
-			if (probe->real_cwd_fd == -1) {
-				close(probe->real_root_fd);
-				dE("open(\".\") failed: %s", strerror(errno));
-				return NULL;
-			}
-			if (chdir(rootdir) != 0) {
-				dE("chdir failed: %s", strerror(errno));
-			}
-
-			if (chroot(rootdir) != 0) {
-				dE("chroot failed: %s", strerror(errno));
-			}
-			/* NOTE: We're running in a different root directory.
-			 * Unless /proc, /sys are somehow emulated for the new
-			 * environment, they are not relevant and so are other
-			 * runtime only things (e.g. getenv, uname, ...).
-			 * Switch to offline mode. We may add a separate
-			 * mechanism to control this behaviour in the future.
+			/* NOTE: The probe will run in a different root directory,
+			 * see probe_offline_enter. Unless /proc, /sys are somehow
+			 * emulated for the new environment, they are not relevant
+			 * and so are other runtime only things (e.g. getenv,
+			 * uname, ...). Switch to offline mode. We may add a
+			 * separate mechanism to control this behaviour in the
+			 * future.
 			 */
 			dI("Switching probe to PROBE_OFFLINE_CHROOT mode.");
-			probe->offline_mode = true;
-			probe->selected_offline_mode = PROBE_OFFLINE_CHROOT;
+			offline_mode = PROBE_OFFLINE_CHROOT;
 		}
+		probe->offline_mode = true;
+		probe->selected_offline_mode = offline_mode;
 	}
 #endif
 
-	SEXP_t *probe_in, *probe_out, *set;
-
-	if (msg_in == NULL) {
-		*ret = PROBE_EINVAL;
-		return (NULL);
-	}
+	SEXP_t *probe_out, *set;
 
-	probe_in  = SEAP_msg_get(msg_in);
 	probe_out = NULL;
 
 	if (probe_in == NULL) {
@@ -1065,20 +1422,29 @@ SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret)
 	} else {
                 struct probe_ctx pctx;
 		SEXP_t *varrefs, *mask;
+		double max_mem_ratio;
+
+		pctx.offline_mode = offline_mode;
 
-		pctx.offline_mode = probe->selected_offline_mode;
+		/* set by the library when the tests of the object need only its first items */
+		SEXP_t *item_limit = probe_obj_getattrval(probe_in, "item_limit");
+		pctx.item_limit = item_limit != NULL ? SEXP_number_getu_32(item_limit) : 0;
+		pctx.item_exists = 0;
+		SEXP_free(item_limit);
 
-		pctx.max_mem_ratio = OSCAP_PROBE_MEMORY_USAGE_RATIO_DEFAULT;
+		max_mem_ratio = OSCAP_PROBE_MEMORY_USAGE_RATIO_DEFAULT;
 		char *max_ratio_str = getenv("OSCAP_PROBE_MEMORY_USAGE_RATIO");
 		if (max_ratio_str != NULL) {
 			double max_ratio = strtod(max_ratio_str, NULL);
 			if (max_ratio > 0)
-				pctx.max_mem_ratio = max_ratio;
+				max_mem_ratio = max_ratio;
 		}
 
 		/* simple object */
                 pctx.icache  = probe->icache;
+		probe_ibatch_init(&pctx.ibatch);
 		pctx.filters = probe_prepare_filters(probe, probe_in);
+		pctx.cfilters = probe_filter_set_new(pctx.filters);
                 mask = probe_obj_getmask(probe_in);
 
 		if (OSCAP_GSYM(varref_handling))
@@ -1090,6 +1456,18 @@ SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret)
 		probe_main_function_t probe_main_function = probe_table_get_main_function(subtype);
 		const char *subtype_str = oval_subtype_get_text(subtype);
 
+#ifndef OS_WINDOWS
+		/* only around the probe, the sub-objects of the sets are evaluated by other threads */
+		if (probe_offline_enter(offline_mode, rootdir, &offline_root) != 0) {
+			SEXP_free(varrefs);
+			SEXP_free(pctx.filters);
+			probe_filter_set_free(pctx.cfilters);
+			SEXP_free(mask);
+			*ret = PROBE_EUNKNOWN;
+			return (NULL);
+		}
+#endif
+
 		if (varrefs == NULL || !OSCAP_GSYM(varref_handling)) {
                         /*
                          * Prepare the collected object
@@ -1099,6 +1477,7 @@ SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret)
 			
                         pctx.probe_in  = probe_in;
                         pctx.probe_out = probe_out;
+			probe_membudget_init(&pctx.membudget, max_mem_ratio);
 
                         /*
                          * Run the main function of the probe implementation. Set thread
@@ -1111,14 +1490,20 @@ SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret)
 
 
 			dI("I will run %s_probe_main:", subtype_str);
+			oval_deadline_object_begin();
 			*ret = probe_main_function(&pctx, probe->probe_arg);
 
 			pthread_setcanceltype(PTHREAD_CANCEL_DEFERRED, &__unused_oldstate);
 
+			/* a checkpoint which stopped the probe left the object incomplete */
+			if (oval_deadline_object_stopped())
+				probe_item_expired(&pctx);
+			oval_deadline_object_end();
+
                         /*
                          * Synchronize
                          */
-                        probe_icache_nop(probe->icache);
+                        probe_icache_sync(probe->icache, &pctx.ibatch);
 
 			probe_cobj_compute_flag(probe_out);
 		} else {
@@ -1127,13 +1512,19 @@ SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret)
 			 * create ctx, iterate through all variable combinations
 			 */
 			struct probe_varref_ctx *ctx;
+			const char *const *multival;
 
 			dD("handling varrefs in object");
 
-			if (probe_varref_create_ctx(probe_in, varrefs, &ctx) != 0) {
+			multival = probe_table_get_multival_entities(subtype);
+
+			if (probe_varref_create_ctx(probe_in, varrefs, multival, &ctx) != 0) {
+#ifndef OS_WINDOWS
+				probe_offline_leave(&offline_root);
+#endif
 				SEXP_free(varrefs);
 				SEXP_free(pctx.filters);
-				SEXP_free(probe_in);
+				probe_filter_set_free(pctx.cfilters);
 				SEXP_free(mask);
 				*ret = PROBE_EUNKNOWN;
 				return (NULL);
@@ -1141,6 +1532,8 @@ SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret)
 
 			SEXP_free(varrefs);
 
+			/* the timeout is shared by all the variable bindings */
+			oval_deadline_object_begin();
 			do {
 				SEXP_t *cobj, *r0;
                                 /*
@@ -1150,16 +1543,20 @@ SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret)
 
                                 pctx.probe_in  = ctx->pi2;
                                 pctx.probe_out = cobj;
+				probe_membudget_init(&pctx.membudget, max_mem_ratio);
                                 /*
                                  * Run the main function of the probe implementation
                                  */
 			dI("I will run %s_probe_main:", subtype_str);
 			*ret = probe_main_function(&pctx, probe->probe_arg);
 
+				if (oval_deadline_object_stopped())
+					probe_item_expired(&pctx);
+
                                 /*
                                  * Synchronize
                                  */
-                                probe_icache_nop(probe->icache);
+                                probe_icache_sync(probe->icache, &pctx.ibatch);
 
 				probe_cobj_compute_flag(cobj);
 				r0 = probe_out;
@@ -1167,52 +1564,103 @@ SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret)
 				SEXP_free(cobj);
 				SEXP_free(r0);
 			} while (*ret == 0
+				 && !oval_deadline_object_stopped()
 				 && probe_varref_iterate_ctx(ctx));
+			oval_deadline_object_end();
+
+			/* a single run over several values may collect an item more than once */
+			if (ctx->multival && probe_out != NULL)
+				probe_cobj_dedup(probe_out);
 
 			SEXP_free(mask);
 			probe_varref_destroy_ctx(ctx);
 		}
 
                 SEXP_free(pctx.filters);
-	}
-
-	SEXP_free(probe_in);
+                probe_filter_set_free(pctx.cfilters);
 
 #ifndef OS_WINDOWS
-	/* Revert chroot */
-	if (probe->real_root_fd != -1) {
-		if (fchdir(probe->real_root_fd) != 0) {
-			dE("fchdir failed: %s", strerror(errno));
-			close(probe->real_root_fd);
-			close(probe->real_cwd_fd);
-			probe->real_root_fd = -1;
-			probe->real_cwd_fd = -1;
+		if (probe_offline_leave(&offline_root) != 0) {
 			SEXP_free(probe_out);
 			return NULL;
 		}
-		close(probe->real_root_fd);
-		probe->real_root_fd = -1;
-		dI("Leaving chroot mode");
-		if (chroot(".") == -1) {
-			dE("chroot(\".\") failed: %s", strerror(errno));
-			close(probe->real_cwd_fd);
-			probe->real_cwd_fd = -1;
-			SEXP_free(probe_out);
-			return NULL;
-		}
-		if (fchdir(probe->real_cwd_fd) != 0) {
-			dE("fchdir failed: %s", strerror(errno));
-			close(probe->real_cwd_fd);
-			probe->real_cwd_fd = -1;
-			SEXP_free(probe_out);
-			return NULL;
-		}
-		close(probe->real_cwd_fd);
-		probe->real_cwd_fd = -1;
-	}
 #endif
+	}
 
 	SEXP_VALIDATE(probe_out);
 
 	return (probe_out);
 }
+
+/*
+ * Cache the states and evaluate the set sub-objects sent by the library along
+ * with an object, the list is ((ste ...) (obj ...)). The sub-objects come after
+ * the objects they reference, so probe_set_eval finds everything it needs in
+ * the result cache instead of asking the library for each id. A sub-object
+ * that fails to evaluate is left to the usual PROBECMD_OBJ_EVAL path.
+ */
+static void probe_worker_prefetch(probe_t *probe, SEXP_t *prefetch)
+{
+	SEXP_t *stes, *objs, *ste, *obj, *id, *res;
+	int ret;
+
+	stes = SEXP_list_first(prefetch);
+	objs = SEXP_list_nth(prefetch, 2);
+
+	SEXP_list_foreach(ste, stes) {
+		id = probe_obj_getattrval(ste, "id");
+
+		/* fails if the state is already cached */
+		if (id != NULL)
+			(void)probe_rcache_sexp_add(probe->rcache, id, ste);
+		SEXP_free(id);
+	}
+
+	SEXP_list_foreach(obj, objs) {
+		id = probe_obj_getattrval(obj, "id");
+		if (id == NULL)
+			continue;
+
+		res = probe_rcache_sexp_get(probe->rcache, id);
+		if (res == NULL) {
+			ret = 0;
+			res = probe_worker_obj(probe, obj, &ret);
+
+			if (res != NULL && ret == 0)
+				(void)probe_rcache_sexp_add(probe->rcache, id, res);
+		}
+
+		SEXP_free(res);
+		SEXP_free(id);
+	}
+
+	SEXP_free(stes);
+	SEXP_free(objs);
+}
+
+/**
+ * Worker thread function. This functions handles the evalution of objects and sets.
+ * @param msg_in SEAP message with the request which contains the object to be evaluated
+ * @param ret pointer to the return code storage
+ */
+SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret)
+{
+	SEXP_t *probe_in, *probe_out, *prefetch;
+
+	if (msg_in == NULL) {
+		*ret = PROBE_EINVAL;
+		return (NULL);
+	}
+
+	prefetch = SEAP_msgattr_get(msg_in, "prefetch");
+	if (prefetch != NULL) {
+		probe_worker_prefetch(probe, prefetch);
+		SEXP_free(prefetch);
+	}
+
+	probe_in = SEAP_msg_get(msg_in);
+	probe_out = probe_worker_obj(probe, probe_in, ret);
+	SEXP_free(probe_in);
+
+	return (probe_out);
+}
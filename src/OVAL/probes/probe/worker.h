@@ -37,9 +37,9 @@
 
 typedef struct {
 	SEAP_msgid_t sid; /**< SEAP message handled by this thread */
-	pthread_t    tid; /**< thread ID */
 	SEXP_t * (*msg_handler)(probe_t *, SEAP_msg_t *, int *); /**< input message (object) handler */
 	SEAP_msg_t  *msg; /**< the message being handled */
+	sch_queue_call_t *call; /**< direct call being handled instead of msg */
 } probe_worker_t;
 
 typedef struct {
@@ -49,6 +49,8 @@ typedef struct {
 
 probe_worker_t *probe_worker_new(void);
 void *probe_worker_runfn(void *arg);
+void probe_worker_discard(void *arg);
+SEXP_t *probe_worker_obj(probe_t *probe, SEXP_t *probe_in, int *ret);
 SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret);
 
 #endif /* WORKER_H */
@@ -327,6 +327,17 @@ OSCAP_API SEXP_t *probe_ent_getval(const SEXP_t * ent);
  */
 OSCAP_API int probe_ent_getvals(const SEXP_t * ent, SEXP_t ** res);
 
+/**
+ * Select one of the values of an entity.
+ * Probes that handle all values of a var_ref entity in one run use this
+ * to iterate over them. The returned entity has the same values and
+ * attributes, but probe_ent_getval returns the value at the given index.
+ * @param ent the entity
+ * @param idx index of the value
+ * @return a new entity or a new reference to ent if it doesn't use var_ref
+ */
+OSCAP_API SEXP_t *probe_ent_select_val(const SEXP_t * ent, uint32_t idx);
+
 /**
  * Get the value of an entity's attribute.
  * @param ent the queried entity
@@ -444,6 +455,43 @@ typedef struct probe_ctx probe_ctx;
 
 OSCAP_API bool probe_item_filtered(const SEXP_t *item, const SEXP_t *filters);
 
+/**
+ * Value of an item entity as the probe has it before building the item.
+ * The value member is selected by the datatype: str for the string
+ * datatypes (string, evr_string, debian_evr_string, version), integer,
+ * flt and boolean for the others.
+ */
+typedef struct {
+	const char *name;          /**< name of the item entity */
+	oval_datatype_t datatype;  /**< datatype of the item entity */
+	union {
+		const char *str;
+		int64_t integer;
+		double flt;
+		bool boolean;
+	} value;
+} probe_field_t;
+
+/**
+ * Check whether the object has filters which probe_filters_reject may
+ * decide, so that the probe can skip preparing the fields otherwise.
+ */
+OSCAP_API bool probe_filters_active(probe_ctx *ctx);
+
+/**
+ * Decide the filters of the object on the fields of a candidate item
+ * before the item is built. Only the entities which the item would have
+ * exactly once and which exist may be given, entities not given or
+ * state entities which can't be compared on them leave the filter
+ * undecided. The candidate is rejected only if a filter is decided to
+ * drop it, probe_item_collect still applies all the filters to the items
+ * which are not rejected.
+ * @param fields fields of the candidate
+ * @param count number of the fields
+ * @return true if the candidate would be filtered out of the object
+ */
+OSCAP_API bool probe_filters_reject(probe_ctx *ctx, const probe_field_t *fields, size_t count);
+
 /**
  * Collect generated item (i.e. add it to the collected object)
  * The function takes ownership of the item reference and takes
@@ -538,4 +586,13 @@ OSCAP_API oval_schema_version_t probe_obj_get_platform_schema_version(const SEXP
  */
 OSCAP_API SEXP_t *probe_obj_getmask(SEXP_t *obj);
 
+/**
+ * Check whether the definitions use an entity of the collected items.
+ * Probes may leave out costly entities no state, filter or variable looks
+ * at. All of them are used unless the library listed them in the object.
+ * @param obj the collected object
+ * @param name the name of the item entity
+ */
+OSCAP_API bool probe_obj_wants_itement(const SEXP_t *obj, const char *name);
+
 /// @}
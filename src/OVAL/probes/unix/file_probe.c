@@ -158,6 +158,7 @@ static SEXP_t *se_filetype(struct gr_sexps *s, mode_t mode)
 struct cbargs {
         probe_ctx *ctx;
 	int     error;
+	bool    want_acl; /* some state looks at has_extended_acl */
 };
 
 struct ID_cache {
@@ -288,6 +289,46 @@ static bool MODEP(struct stat *statp, unsigned int bit)
 	return (statp->st_mode & bit);
 }
 
+/*
+ * Decide the object filters on the stat data of the file, so that the
+ * files they drop are not turned into items at all.
+ */
+static bool file_filtered(probe_ctx *ctx, struct gr_sexps *grs, const char *p, const char *f, const char *st_path,
+                          struct stat *st, oval_schema_version_t over)
+{
+	char type[32];
+	size_t count = 0;
+	probe_field_t fields[20];
+
+	SEXP_string_cstr_r(se_filetype(grs, st->st_mode), type, sizeof type);
+
+	fields[count++] = (probe_field_t) { "path", OVAL_DATATYPE_STRING, .value.str = p };
+	fields[count++] = (probe_field_t) { "filename", OVAL_DATATYPE_STRING, .value.str = f == NULL ? "" : f };
+	fields[count++] = (probe_field_t) { "type", OVAL_DATATYPE_STRING, .value.str = type };
+	fields[count++] = (probe_field_t) { "size", OVAL_DATATYPE_INTEGER, .value.integer = (int64_t)st->st_size };
+	if (f != NULL && oval_schema_version_cmp(over, OVAL_SCHEMA_VERSION(5.6)) >= 0)
+		fields[count++] = (probe_field_t) { "filepath", OVAL_DATATYPE_STRING, .value.str = st_path };
+	/* the ids are strings before OVAL 5.8, see ID_cache_get, and are left to probe_item_collect */
+	if (oval_schema_version_cmp(over, OVAL_SCHEMA_VERSION(5.8)) >= 0) {
+		fields[count++] = (probe_field_t) { "user_id", OVAL_DATATYPE_INTEGER, .value.integer = st->st_uid };
+		fields[count++] = (probe_field_t) { "group_id", OVAL_DATATYPE_INTEGER, .value.integer = st->st_gid };
+	}
+	fields[count++] = (probe_field_t) { "suid", OVAL_DATATYPE_BOOLEAN, .value.boolean = MODEP(st, S_ISUID) };
+	fields[count++] = (probe_field_t) { "sgid", OVAL_DATATYPE_BOOLEAN, .value.boolean = MODEP(st, S_ISGID) };
+	fields[count++] = (probe_field_t) { "sticky", OVAL_DATATYPE_BOOLEAN, .value.boolean = MODEP(st, S_ISVTX) };
+	fields[count++] = (probe_field_t) { "uread", OVAL_DATATYPE_BOOLEAN, .value.boolean = MODEP(st, S_IRUSR) };
+	fields[count++] = (probe_field_t) { "uwrite", OVAL_DATATYPE_BOOLEAN, .value.boolean = MODEP(st, S_IWUSR) };
+	fields[count++] = (probe_field_t) { "uexec", OVAL_DATATYPE_BOOLEAN, .value.boolean = MODEP(st, S_IXUSR) };
+	fields[count++] = (probe_field_t) { "gread", OVAL_DATATYPE_BOOLEAN, .value.boolean = MODEP(st, S_IRGRP) };
+	fields[count++] = (probe_field_t) { "gwrite", OVAL_DATATYPE_BOOLEAN, .value.boolean = MODEP(st, S_IWGRP) };
+	fields[count++] = (probe_field_t) { "gexec", OVAL_DATATYPE_BOOLEAN, .value.boolean = MODEP(st, S_IXGRP) };
+	fields[count++] = (probe_field_t) { "oread", OVAL_DATATYPE_BOOLEAN, .value.boolean = MODEP(st, S_IROTH) };
+	fields[count++] = (probe_field_t) { "owrite", OVAL_DATATYPE_BOOLEAN, .value.boolean = MODEP(st, S_IWOTH) };
+	fields[count++] = (probe_field_t) { "oexec", OVAL_DATATYPE_BOOLEAN, .value.boolean = MODEP(st, S_IXOTH) };
+
+	return probe_filters_reject(ctx, fields, count);
+}
+
 static SEXP_t *has_extended_acl(const char *path)
 {
 #if defined(HAVE_ACL_EXTENDED_FILE)
@@ -326,7 +367,7 @@ static int file_cb(const char *prefix, const char *p, const char *f, void *ptr,
 	}
 
 	char *st_path_with_prefix = oscap_path_join(prefix, st_path);
-	if (lstat(st_path_with_prefix, &st) == -1) {
+	if (oval_fts_cache_lstat(st_path_with_prefix, &st) == -1) {
                 dD("lstat failed when processing %s: errno=%u, %s.", st_path, errno, strerror (errno));
 		/*
 		 * Whatever the reason of this lstat error (for example the file may
@@ -336,6 +377,12 @@ static int file_cb(const char *prefix, const char *p, const char *f, void *ptr,
 		free(st_path_with_prefix);
 		return 0;
         } else {
+		if (probe_filters_active(args->ctx)
+		    && file_filtered(args->ctx, grs, p, f, st_path, &st, over)) {
+			free(st_path_with_prefix);
+			return 0;
+		}
+
                 SEXP_t *se_usr_id, *se_grp_id;
                 SEXP_t  se_atime_mem, se_ctime_mem, se_mtime_mem, se_size_mem;
 		SEXP_t *se_filepath, *se_acl;
@@ -358,7 +405,7 @@ static int file_cb(const char *prefix, const char *p, const char *f, void *ptr,
 		} else
 			SEXP_string_new_r(gr_lastpath, p, strlen(p));
 
-		if (oval_schema_version_cmp(over, OVAL_SCHEMA_VERSION(5.7)) < 0) {
+		if (oval_schema_version_cmp(over, OVAL_SCHEMA_VERSION(5.7)) < 0 || !args->want_acl) {
 			se_acl = NULL;
 		} else {
 			se_acl = has_extended_acl(st_path_with_prefix);
@@ -390,12 +437,12 @@ static int file_cb(const char *prefix, const char *p, const char *f, void *ptr,
 				"oexec", OVAL_DATATYPE_BOOLEAN, MODEP(&st, S_IXOTH),
 				"has_extended_acl", OVAL_DATATYPE_SEXP, se_acl,
                                          NULL);
-		if (se_acl == NULL) {
+		if (se_acl == NULL && args->want_acl) {
 			SEXP_t *sexp_true = SEXP_number_newb(true);
 			probe_item_ent_add(item, "has_extended_acl", NULL, sexp_true);
 			SEXP_free(sexp_true);
 			probe_itement_setstatus(item, "has_extended_acl", 1, SYSCHAR_STATUS_DOES_NOT_EXIST);
-		} else {
+		} else if (se_acl != NULL) {
 			SEXP_free(se_acl);
 		}
 
@@ -418,6 +465,8 @@ static int file_cb(const char *prefix, const char *p, const char *f, void *ptr,
 }
 
 
+const char *const file_probe_multival_entities[] = { "path", "filename", "filepath", NULL };
+
 int file_probe_offline_mode_supported()
 {
 	return PROBE_OFFLINE_OWN;
@@ -436,10 +485,6 @@ void *file_probe_init(void)
 		free(file_probe_mutex);
                 dD("Can't initialize mutex: errno=%u, %s.", errno, strerror (errno));
         }
-#if 0
-	probe_setoption(PROBEOPT_VARREF_HANDLING, false, "path");
-	probe_setoption(PROBEOPT_VARREF_HANDLING, false, "filename");
-#endif
         return (NULL);
 }
 
@@ -455,7 +500,9 @@ void file_probe_fini(void *arg)
 int file_probe_main(probe_ctx *ctx, void *mutex)
 {
         SEXP_t *path, *filename, *behaviors, *filepath, *probe_in;
-	int err;
+	SEXP_t *val_ent, *sel;
+	int err, i, val_cnt;
+	bool stop;
         struct cbargs cbargs;
 	OVAL_FTS    *ofts;
 	OVAL_FTSENT *ofts_ent;
@@ -500,6 +547,8 @@ int file_probe_main(probe_ctx *ctx, void *mutex)
 
         cbargs.ctx     = ctx;
 	cbargs.error   = 0;
+	/* reading the ACL costs a syscall per file */
+	cbargs.want_acl = probe_obj_wants_itement(probe_in, "has_extended_acl");
 
 	const char *prefix = getenv("OSCAP_PROBE_ROOT");
 	SEXP_t gr_lastpath;
@@ -507,10 +556,26 @@ int file_probe_main(probe_ctx *ctx, void *mutex)
 	struct ID_cache *cache = ID_cache_init(10000);
 	struct gr_sexps *grs = gr_sexps_init();
 
-	if ((ofts = oval_fts_open_prefixed(prefix, path, filename, filepath, behaviors, probe_ctx_getresult(ctx))) != NULL) {
+	/* the filename is matched against all of its values, the walk is done for each path */
+	val_ent = (filepath != NULL) ? filepath : path;
+	val_cnt = probe_ent_getvals(val_ent, NULL);
+
+	for (i = 0, stop = false; !stop && (i == 0 || i < val_cnt); ++i) {
+		sel = probe_ent_select_val(val_ent, i);
+
+		if (filepath != NULL)
+			ofts = oval_fts_open_prefixed(prefix, path, filename, sel, behaviors, probe_ctx_getresult(ctx));
+		else
+			ofts = oval_fts_open_prefixed(prefix, sel, filename, filepath, behaviors, probe_ctx_getresult(ctx));
+		SEXP_free(sel);
+
+		if (ofts == NULL)
+			continue;
+
 		while ((ofts_ent = oval_fts_read(ofts)) != NULL) {
 			if (file_cb(prefix, ofts_ent->path, ofts_ent->file, &cbargs, over, cache, grs, &gr_lastpath) != 0) {
 				oval_ftsent_free(ofts_ent);
+				stop = true;
 				break;
 			}
 			oval_ftsent_free(ofts_ent);
@@ -29,5 +29,6 @@ int file_probe_offline_mode_supported(void);
 void *file_probe_init(void);
 int file_probe_main(probe_ctx *ctx, void *arg);
 void file_probe_fini(void *arg);
+extern const char *const file_probe_multival_entities[];
 
 #endif /* OPENSCAP_FILE_PROBE_H */
@@ -39,6 +39,8 @@
 #include <pthread.h>
 #include <errno.h>
 #include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include <sys/types.h>
 #if defined(HAVE_SYS_XATTR_H)
@@ -66,14 +68,39 @@
 #define llistxattr(path, buf, size)   listxattr((path), (buf), (size), XATTR_NOFOLLOW)
 #define lgetxattr(path, name, value, size)   getxattr((path), (name), (value), (size), 0, XATTR_NOFOLLOW)
 #define lsetxattr(path, name, value, size, flags) setxattr((path), (name), (value), (size), 0, (flags) | XATTR_NOFOLLOW)
+#define flistxattr(fd, buf, size)   flistxattr((fd), (buf), (size), 0)
+#define fgetxattr(fd, name, value, size)   fgetxattr((fd), (name), (value), (size), 0, 0)
 #endif
 
+#ifndef ENOATTR
+#define ENOATTR ENODATA
+#endif
+
+#ifndef O_NOATIME
+#define O_NOATIME 0
+#endif
+
+/* initial size of the buffers, they grow to the largest list or value seen */
+#define XATTR_BUFSIZE 1024
+
 #define FILE_SEPARATOR '/'
 
+struct xattr_probe_arg {
+	pthread_mutex_t mutex;
+	/* reused by the objects, the mutex serializes them */
+	char  *names;
+	size_t names_size;
+	char  *value;
+	size_t value_size;
+};
+
 struct cbargs {
 	probe_ctx *ctx;
 	int        error;
 	SEXP_t    *attr_ent;
+	char     **attr_names;  /* the names to look up if they're given, NULL to list them */
+	unsigned int fts_info;
+	struct xattr_probe_arg *arg;
 };
 
 #if defined(OS_FREEBSD)
@@ -205,16 +232,115 @@ static int file_cb(const char *prefix, const char *p, const char *f, void *ptr,
 }
 
 #else
+struct xattr_file {
+	int fd;            /* -1 if the path is used */
+	const char *path;
+};
+
+static ssize_t xattr_list(const struct xattr_file *xf, char *buf, size_t size)
+{
+	if (xf->fd != -1)
+		return flistxattr(xf->fd, buf, size);
+	return llistxattr(xf->path, buf, size);
+}
+
+static ssize_t xattr_get(const struct xattr_file *xf, const char *name, char *buf, size_t size)
+{
+	if (xf->fd != -1)
+		return fgetxattr(xf->fd, name, buf, size);
+	return lgetxattr(xf->path, name, buf, size);
+}
+
+/*
+ * Read the list of names (name == NULL) or the value of an attribute into
+ * the buffer. The size is asked for only if the buffer is too small, one
+ * byte is always left for the terminating '\0'.
+ */
+static ssize_t xattr_read(const struct xattr_file *xf, const char *name, char **buf, size_t *size)
+{
+	ssize_t len;
+
+	for (;;) {
+		len = name == NULL ? xattr_list(xf, *buf, *size - 1) : xattr_get(xf, name, *buf, *size - 1);
+		if (len >= 0 || errno != ERANGE)
+			return len;
+
+		len = name == NULL ? xattr_list(xf, NULL, 0) : xattr_get(xf, name, NULL, 0);
+		if (len < 0)
+			return len;
+
+		size_t new_size = *size;
+		while (new_size <= (size_t)len) {
+			if (new_size > SIZE_MAX / 2) {
+				dE("Attribute is too long.");
+				errno = ENOMEM;
+				return -1;
+			}
+			new_size *= 2;
+		}
+		void *new_buf = realloc(*buf, new_size);
+		if (new_buf == NULL) {
+			dE("Failed to re-allocate memory for the xattr buffer");
+			errno = ENOMEM;
+			return -1;
+		}
+		*buf = new_buf;
+		*size = new_size;
+		/* the attribute may have grown meanwhile, ERANGE again then */
+	}
+}
+
+static void xattr_collect(struct cbargs *args, const struct xattr_file *xf, const char *name,
+                          const char *st_path, const char *f, SEXP_t *gr_lastpath)
+{
+	struct xattr_probe_arg *arg = args->arg;
+	SEXP_t *item, xattr_name;
+	ssize_t xattr_vallen;
+
+	SEXP_string_new_r(&xattr_name, name, strlen(name));
+
+	if (probe_entobj_cmp(args->attr_ent, &xattr_name) != OVAL_RESULT_TRUE) {
+		SEXP_free_r(&xattr_name);
+		return;
+	}
+
+	xattr_vallen = xattr_read(xf, name, &arg->value, &arg->value_size);
+
+	if (xattr_vallen >= 0) {
+		arg->value[xattr_vallen] = '\0';
+
+		item = probe_item_create(OVAL_UNIX_FILEEXTENDEDATTRIBUTE, NULL,
+		                        "filepath", OVAL_DATATYPE_STRING, f == NULL ? NULL : st_path,
+		                        "path",     OVAL_DATATYPE_SEXP, gr_lastpath,
+		                        "filename", OVAL_DATATYPE_STRING, f == NULL ? "" : f,
+		                        "attribute_name", OVAL_DATATYPE_SEXP,   &xattr_name,
+		                        "value",          OVAL_DATATYPE_STRING, arg->value,
+		                        NULL);
+	} else if (args->attr_names != NULL && errno == ENOATTR) {
+		/* a name looked up directly which the file doesn't have */
+		SEXP_free_r(&xattr_name);
+		return;
+	} else {
+		dD("FAIL: getxattr(%s, %s): errno=%u, %s", xf->path, name, errno, strerror(errno));
+
+		item = probe_item_create(OVAL_UNIX_FILEEXTENDEDATTRIBUTE, NULL, NULL);
+		probe_item_setstatus(item, SYSCHAR_STATUS_ERROR);
+	}
+
+	probe_item_collect(args->ctx, item); /* XXX: handle ENOMEM */
+	SEXP_free_r(&xattr_name);
+}
+
 static int file_cb(const char *prefix, const char *p, const char *f, void *ptr, SEXP_t *gr_lastpath)
 {
 	char path_buffer[PATH_MAX];
-	SEXP_t *item, xattr_name;
 	struct cbargs *args = (struct cbargs *) ptr;
+	struct xattr_probe_arg *arg = args->arg;
+	struct xattr_file xf;
 	const char *st_path;
 
 	ssize_t xattr_count = -1;
-	char   *xattr_buf = NULL;
-	size_t  xattr_buflen = 0, i;
+	size_t  i;
 
 	if (f == NULL) {
 		st_path = p;
@@ -229,42 +355,38 @@ static int file_cb(const char *prefix, const char *p, const char *f, void *ptr,
 		st_path = path_buffer;
 	}
 
-	SEXP_init(&xattr_name);
-
 	char *st_path_with_prefix = oscap_path_join(prefix, st_path);
-	do {
-		/* estimate the size of the buffer */
-		xattr_count = llistxattr(st_path_with_prefix, NULL, 0);
 
-		if (xattr_count == 0) {
-			goto exit;
+	/*
+	 * Resolve the path once for all the calls. Only regular files and
+	 * directories are opened, opening devices or fifos may have side
+	 * effects; the others are queried by the path without following it.
+	 */
+	xf.fd = -1;
+	xf.path = st_path_with_prefix;
+	if (args->fts_info == FTS_F || args->fts_info == FTS_D) {
+		struct stat st;
+
+		xf.fd = open(st_path_with_prefix, O_RDONLY | O_NOFOLLOW | O_NONBLOCK | O_NOCTTY | O_CLOEXEC | O_NOATIME);
+		if (xf.fd == -1 && errno == EPERM) /* O_NOATIME needs the ownership */
+			xf.fd = open(st_path_with_prefix, O_RDONLY | O_NOFOLLOW | O_NONBLOCK | O_NOCTTY | O_CLOEXEC);
+		if (xf.fd != -1 && (fstat(xf.fd, &st) != 0 || !(S_ISREG(st.st_mode) || S_ISDIR(st.st_mode)))) {
+			close(xf.fd);
+			xf.fd = -1;
 		}
+	}
 
-		if (xattr_count < 0) {
-			dD("FAIL: llistxattr(%s, %p, %zu): errno=%u, %s", st_path_with_prefix, NULL, (size_t)0, errno, strerror(errno));
+	if (args->attr_names == NULL) {
+		xattr_count = xattr_read(&xf, NULL, &arg->names, &arg->names_size);
+
+		if (xattr_count == 0)
 			goto exit;
-		}
 
-		/* allocate space for xattr names */
-		xattr_buflen = xattr_count;
-		void *new_xattr_buf = realloc(xattr_buf, sizeof(char) * xattr_buflen);
-		if (new_xattr_buf == NULL) {
-			dE("Failed to re-allocate memory for xattr_buf");
+		if (xattr_count < 0) {
+			dD("FAIL: listxattr(%s): errno=%u, %s", st_path_with_prefix, errno, strerror(errno));
 			goto exit;
 		}
-		xattr_buf = new_xattr_buf;
-
-		/* fill the buffer */
-		xattr_count = llistxattr(st_path_with_prefix, xattr_buf, xattr_buflen);
-
-		/* check & retry if needed */
-	} while (errno == ERANGE);
-
-	if (xattr_count < 0) {
-		dD("FAIL: llistxattr(%s, %p, %zu): errno=%u, %s", st_path_with_prefix, xattr_buf, xattr_buflen, errno, strerror(errno));
-		free(st_path_with_prefix);
-		free(xattr_buf);
-		return 0;
+		arg->names[xattr_count] = '\0';
 	}
 
 	/* update lastpath if needed */
@@ -277,75 +399,20 @@ static int file_cb(const char *prefix, const char *p, const char *f, void *ptr,
 		SEXP_string_new_r(gr_lastpath, p, strlen(p));
 	}
 
-	i = 0;
 	/* collect */
-	do {
-		SEXP_string_new_r(&xattr_name, xattr_buf + i, strlen(xattr_buf +i));
-
-		if (probe_entobj_cmp(args->attr_ent, &xattr_name) == OVAL_RESULT_TRUE) {
-			ssize_t xattr_vallen = -1;
-			char   *xattr_val = NULL;
-
-			xattr_vallen = lgetxattr(st_path_with_prefix, xattr_buf + i, NULL, 0);
-		retry_value:
-			if (xattr_vallen >= 0) {
-				// Check possible buffer overflow
-				if (sizeof(char) * (xattr_vallen + 1) <= sizeof(char) * xattr_vallen) {
-					dE("Attribute is too long.");
-					free(xattr_val);
-					goto exit;
-				}
-
-				// Allocate buffer, '+1' is for trailing '\0'
-				void *new_xattr_val = realloc(xattr_val, sizeof(char) * (xattr_vallen + 1));
-				if (new_xattr_val == NULL) {
-					dE("Failed to allocate memory for xattr_val");
-					free(xattr_val);
-					goto exit;
-				}
-				xattr_val = new_xattr_val;
-
-				// we don't want to override space for '\0' by call of 'lgetxattr'
-				// we pass only 'xattr_vallen' instead of 'xattr_vallen + 1'
-				xattr_vallen = lgetxattr(st_path_with_prefix, xattr_buf + i, xattr_val, xattr_vallen);
-
-				if (xattr_vallen < 0 || errno == ERANGE)
-					goto retry_value;
-
-				xattr_val[xattr_vallen] = '\0';
-
-				item = probe_item_create(OVAL_UNIX_FILEEXTENDEDATTRIBUTE, NULL,
-				                        "filepath", OVAL_DATATYPE_STRING, f == NULL ? NULL : st_path,
-				                        "path",     OVAL_DATATYPE_SEXP, gr_lastpath,
-				                        "filename", OVAL_DATATYPE_STRING, f == NULL ? "" : f,
-				                        "attribute_name", OVAL_DATATYPE_SEXP,   &xattr_name,
-				                        "value",          OVAL_DATATYPE_STRING, xattr_val,
-				                        NULL);
-
-				free(xattr_val);
-			} else {
-				dD("FAIL: lgetxattr(%s, %s, NULL, 0): errno=%u, %s", st_path_with_prefix, xattr_buf + i, errno, strerror(errno));
-
-				item = probe_item_create(OVAL_UNIX_FILEEXTENDEDATTRIBUTE, NULL, NULL);
-				probe_item_setstatus(item, SYSCHAR_STATUS_ERROR);
-
-				if (xattr_val != NULL)
-					free(xattr_val);
-			}
-
-			probe_item_collect(args->ctx, item); /* XXX: handle ENOMEM */
+	if (args->attr_names != NULL) {
+		for (i = 0; args->attr_names[i] != NULL; ++i)
+			xattr_collect(args, &xf, args->attr_names[i], st_path, f, gr_lastpath);
+	} else {
+		for (i = 0; i < (size_t)xattr_count; i += strlen(arg->names + i) + 1) {
+			if (arg->names[i] != '\0')
+				xattr_collect(args, &xf, arg->names + i, st_path, f, gr_lastpath);
 		}
-
-		SEXP_free_r(&xattr_name);
-
-		/* skip to next name */
-		while (i < xattr_buflen && xattr_buf[i] != '\0')
-			++i;
-		++i;
-	} while (xattr_buf + i < xattr_buf + xattr_buflen - 1);
+	}
 
 exit:
-	free(xattr_buf);
+	if (xf.fd != -1)
+		close(xf.fd);
 	free(st_path_with_prefix);
 	return 0;
 }
@@ -358,35 +425,54 @@ int fileextendedattribute_probe_offline_mode_supported()
 
 void *fileextendedattribute_probe_init(void)
 {
+	struct xattr_probe_arg *arg = calloc(1, sizeof(struct xattr_probe_arg));
+
+	if (arg == NULL)
+		return NULL;
+
 	/*
 	 * Initialize mutex.
 	 */
-	pthread_mutex_t *mutex = malloc(sizeof(pthread_mutex_t));
-	switch (pthread_mutex_init(mutex, NULL)) {
-	case 0:
-		return (void *)mutex;
-	default:
+	if (pthread_mutex_init(&arg->mutex, NULL) != 0) {
 		dD("Can't initialize mutex: errno=%u, %s.", errno, strerror(errno));
-		free(mutex);
+		free(arg);
+		return NULL;
+	}
+
+	arg->names = malloc(XATTR_BUFSIZE);
+	arg->names_size = XATTR_BUFSIZE;
+	arg->value = malloc(XATTR_BUFSIZE);
+	arg->value_size = XATTR_BUFSIZE;
+	if (arg->names == NULL || arg->value == NULL) {
+		fileextendedattribute_probe_fini(arg);
+		return NULL;
 	}
 #if 0
 	probe_setoption(PROBEOPT_VARREF_HANDLING, false, "path");
 	probe_setoption(PROBEOPT_VARREF_HANDLING, false, "filename");
 #endif
-	return NULL;
+	return arg;
 }
 
-void fileextendedattribute_probe_fini(void *arg)
+void fileextendedattribute_probe_fini(void *probe_arg)
 {
+	struct xattr_probe_arg *arg = probe_arg;
+
+	if (arg == NULL)
+		return;
+
 	/*
 	 * Destroy mutex.
 	 */
-	(void) pthread_mutex_destroy((pthread_mutex_t *)arg);
+	(void) pthread_mutex_destroy(&arg->mutex);
+	free(arg->names);
+	free(arg->value);
 	free(arg);
 }
 
-int fileextendedattribute_probe_main(probe_ctx *ctx, void *mutex)
+int fileextendedattribute_probe_main(probe_ctx *ctx, void *probe_arg)
 {
+	struct xattr_probe_arg *arg = probe_arg;
 	SEXP_t *path, *filename, *behaviors;
 	SEXP_t *filepath, *attribute_, *probe_in;
 	int err;
@@ -395,7 +481,7 @@ int fileextendedattribute_probe_main(probe_ctx *ctx, void *mutex)
 	OVAL_FTSENT *ofts_ent;
 	SEXP_t gr_lastpath;
 
-	if (mutex == NULL)
+	if (arg == NULL)
 		return PROBE_EINIT;
 
 	probe_in  = probe_ctx_getobject(ctx);
@@ -419,11 +505,11 @@ int fileextendedattribute_probe_main(probe_ctx *ctx, void *mutex)
 
 	probe_filebehaviors_canonicalize(&behaviors);
 
-	switch (pthread_mutex_lock(mutex)) {
+	switch (pthread_mutex_lock(&arg->mutex)) {
 	case 0:
 		break;
 	default:
-		dD("Can't lock mutex(%p): %u, %s.", mutex, errno, strerror(errno));
+		dD("Can't lock mutex(%p): %u, %s.", &arg->mutex, errno, strerror(errno));
 		SEXP_free(path);
 		SEXP_free(filename);
 		SEXP_free(filepath);
@@ -435,12 +521,16 @@ int fileextendedattribute_probe_main(probe_ctx *ctx, void *mutex)
 	cbargs.ctx      = ctx;
 	cbargs.error    = 0;
 	cbargs.attr_ent = attribute_;
+	cbargs.arg      = arg;
+	/* names compared for equality are looked up directly instead of listing them all */
+	cbargs.attr_names = probe_entobj_equal_strings(attribute_);
 
 	const char *prefix = getenv("OSCAP_PROBE_ROOT");
 	SEXP_init(&gr_lastpath);
 
 	if ((ofts = oval_fts_open_prefixed(prefix, path, filename, filepath, behaviors, probe_ctx_getresult(ctx))) != NULL) {
 		while ((ofts_ent = oval_fts_read(ofts)) != NULL) {
+			cbargs.fts_info = ofts_ent->fts_info;
 			file_cb(prefix, ofts_ent->path, ofts_ent->file, &cbargs, &gr_lastpath);
 			oval_ftsent_free(ofts_ent);
 		}
@@ -450,6 +540,14 @@ int fileextendedattribute_probe_main(probe_ctx *ctx, void *mutex)
 	if (!SEXP_emptyp(&gr_lastpath))
 		SEXP_free_r(&gr_lastpath);
 
+	if (cbargs.attr_names != NULL) {
+		size_t i;
+
+		for (i = 0; cbargs.attr_names[i] != NULL; ++i)
+			free(cbargs.attr_names[i]);
+		free(cbargs.attr_names);
+	}
+
 	err = 0;
 
 	SEXP_free(path);
@@ -458,11 +556,11 @@ int fileextendedattribute_probe_main(probe_ctx *ctx, void *mutex)
 	SEXP_free(behaviors);
 	SEXP_free(attribute_);
 
-	switch (pthread_mutex_unlock(mutex)) {
+	switch (pthread_mutex_unlock(&arg->mutex)) {
 	case 0:
 		break;
 	default:
-		dD("Can't unlock mutex(%p): %u, %s.", mutex, errno, strerror(errno));
+		dD("Can't unlock mutex(%p): %u, %s.", &arg->mutex, errno, strerror(errno));
 		return PROBE_EFATAL;
 	}
 
@@ -79,6 +79,30 @@
 #include <net/if_arp.h>
 #include <arpa/inet.h>
 
+#if defined(OS_LINUX)
+#include "oval_net_cache.h"
+
+static const char *get_l2_type(unsigned short hw_type)
+{
+	switch (hw_type) {
+	case ARPHRD_ETHER:
+		return "ARPHRD_ETHER";
+	case ARPHRD_FDDI:
+		return "ARPHRD_FDDI";
+	case ARPHRD_LOOPBACK:
+		return "ARPHRD_LOOPBACK";
+	case ARPHRD_PPP:
+		return "ARPHRD_PPP";
+	case ARPHRD_PRONET:
+		return "ARPHRD_PRONET";
+	case ARPHRD_SLIP:
+		return "ARPHRD_SLIP";
+	case ARPHRD_VOID:
+		return "ARPHRD_VOID";
+	}
+	return "";
+}
+#elif defined(OS_FREEBSD)
 static void get_l2_info(const struct ifaddrs *ifa, char **mp, char **tp, int fd)
 {
 	struct ifreq ifr;
@@ -91,37 +115,6 @@ static void get_l2_info(const struct ifaddrs *ifa, char **mp, char **tp, int fd)
 	memset(&ifr, 0, sizeof(struct ifreq));
 	strcpy(ifr.ifr_name, ifa->ifa_name);
 
-#if defined(OS_LINUX)
-	if (ioctl(fd, SIOCGIFHWADDR, &ifr) >= 0) {
-		memcpy(mac, ifr.ifr_hwaddr.sa_data, sizeof(mac));
-		snprintf(mac_buf, sizeof(mac_buf),
-			"%02X:%02X:%02X:%02X:%02X:%02X",
-			mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
-		switch (ifr.ifr_hwaddr.sa_family) {
-
-		case ARPHRD_ETHER:
-			*tp = "ARPHRD_ETHER";
-			break;
-		case ARPHRD_FDDI:
-			*tp = "ARPHRD_FDDI";
-			break;
-		case ARPHRD_LOOPBACK:
-			*tp = "ARPHRD_LOOPBACK";
-			break;
-		case ARPHRD_PPP:
-			*tp = "ARPHRD_PPP";
-			break;
-		case ARPHRD_PRONET:
-			*tp = "ARPHRD_PRONET";
-			break;
-		case ARPHRD_SLIP:
-			*tp = "ARPHRD_SLIP";
-			break;
-		case ARPHRD_VOID:
-			*tp = "ARPHRD_VOID";
-			break;
-		}
-#elif defined(OS_FREEBSD)
 	if (ioctl(fd, SIOCGHWADDR, &ifr) >= 0) {
 		memcpy(mac, ifr.ifr_addr.sa_data, sizeof(mac));
 		snprintf(mac_buf, sizeof(mac_buf),
@@ -136,86 +129,84 @@ static void get_l2_info(const struct ifaddrs *ifa, char **mp, char **tp, int fd)
 			*tp = "ARPHDR_INFINIBAND";
 			break;
 		}
-#endif
 	} else
 		mac_buf[0] = 0;
 }
+#endif
 
 #if defined(OS_LINUX)
-static void get_flags(const struct ifaddrs *ifa, char ***fp) {
+static void get_flags(unsigned int ifa_flags, char ***fp) {
 	static char *flags_buf[17];
 	int i = 0;
 
 	*fp = flags_buf;
 
-	if (ifa != NULL) {
-		/* follow values from net/if.h */
-		if (ifa->ifa_flags & IFF_UP) {
-			flags_buf[i] = "UP";
-			i++;
-		}
-		if (ifa->ifa_flags & IFF_BROADCAST) {
-			flags_buf[i] = "BROADCAST";
-			i++;
-		}
-		if (ifa->ifa_flags & IFF_DEBUG) {
-			flags_buf[i] = "DEBUG";
-			i++;
-		}
-		if (ifa->ifa_flags & IFF_LOOPBACK) {
-			flags_buf[i] = "LOOPBACK";
-			i++;
-		}
-		if (ifa->ifa_flags & IFF_POINTOPOINT) {
-			flags_buf[i] = "POINTOPOINT";
-			i++;
-		}
-		if (ifa->ifa_flags & IFF_NOTRAILERS) {
-			flags_buf[i] = "NOTRAILERS";
-			i++;
-		}
-		if (ifa->ifa_flags & IFF_RUNNING) {
-			flags_buf[i] = "RUNNING";
-			i++;
-		}
-		if (ifa->ifa_flags & IFF_NOARP) {
-			flags_buf[i] = "NOAPP";
-			i++;
-		}
-		if (ifa->ifa_flags & IFF_PROMISC) {
-			flags_buf[i] = "PROMISC";
-			i++;
-		}
-		if (ifa->ifa_flags & IFF_ALLMULTI) {
-			flags_buf[i] = "ALLMULTI";
-			i++;
-		}
-		if (ifa->ifa_flags & IFF_MASTER) {
-			flags_buf[i] = "MASTER";
-			i++;
-		}
-		if (ifa->ifa_flags & IFF_SLAVE) {
-			flags_buf[i] = "SLAVE";
-			i++;
-		}
-		if (ifa->ifa_flags & IFF_MULTICAST) {
-			flags_buf[i] = "MULTICAST";
-			i++;
-		}
-		if (ifa->ifa_flags & IFF_PORTSEL) {
-			flags_buf[i] = "PORTSEL";
-			i++;
-		}
-		if (ifa->ifa_flags & IFF_AUTOMEDIA) {
-			flags_buf[i] = "AUTOMEDIA";
-			i++;
-		}
-		if (ifa->ifa_flags & IFF_DYNAMIC) {
-			flags_buf[i] = "DYNAMIC";
-			i++;
-		}
+	/* follow values from net/if.h */
+	if (ifa_flags & IFF_UP) {
+		flags_buf[i] = "UP";
+		i++;
 	}
-	flags_buf[i] = NULL;
+	if (ifa_flags & IFF_BROADCAST) {
+		flags_buf[i] = "BROADCAST";
+		i++;
+	}
+	if (ifa_flags & IFF_DEBUG) {
+		flags_buf[i] = "DEBUG";
+		i++;
+	}
+	if (ifa_flags & IFF_LOOPBACK) {
+		flags_buf[i] = "LOOPBACK";
+		i++;
+	}
+	if (ifa_flags & IFF_POINTOPOINT) {
+		flags_buf[i] = "POINTOPOINT";
+		i++;
+	}
+	if (ifa_flags & IFF_NOTRAILERS) {
+		flags_buf[i] = "NOTRAILERS";
+		i++;
+	}
+	if (ifa_flags & IFF_RUNNING) {
+		flags_buf[i] = "RUNNING";
+		i++;
+	}
+	if (ifa_flags & IFF_NOARP) {
+		flags_buf[i] = "NOAPP";
+		i++;
+	}
+	if (ifa_flags & IFF_PROMISC) {
+		flags_buf[i] = "PROMISC";
+		i++;
+	}
+	if (ifa_flags & IFF_ALLMULTI) {
+		flags_buf[i] = "ALLMULTI";
+		i++;
+	}
+	if (ifa_flags & IFF_MASTER) {
+		flags_buf[i] = "MASTER";
+		i++;
+	}
+	if (ifa_flags & IFF_SLAVE) {
+		flags_buf[i] = "SLAVE";
+		i++;
+	}
+	if (ifa_flags & IFF_MULTICAST) {
+		flags_buf[i] = "MULTICAST";
+		i++;
+	}
+	if (ifa_flags & IFF_PORTSEL) {
+		flags_buf[i] = "PORTSEL";
+		i++;
+	}
+	if (ifa_flags & IFF_AUTOMEDIA) {
+		flags_buf[i] = "AUTOMEDIA";
+		i++;
+	}
+	if (ifa_flags & IFF_DYNAMIC) {
+		flags_buf[i] = "DYNAMIC";
+		i++;
+	}
+flags_buf[i] = NULL;
 
 }
 #elif defined(OS_FREEBSD)
@@ -306,6 +297,93 @@ static void get_flags(const struct ifaddrs *ifa, char ***fp) {
 }
 #endif /* end of #ifdef for get_flags */
 
+#if defined(OS_LINUX)
+static int get_ifs(SEXP_t *name_ent, probe_ctx *ctx, oval_schema_version_t over)
+{
+	oval_net_cache_t *net;
+	const struct oval_net_addr *addr;
+	char host[NI_MAXHOST], broad[NI_MAXHOST], mask[NI_MAXHOST], mac[20], **flags;
+	const char *type;
+	oval_datatype_t address_type;
+	SEXP_t *item;
+	bool include_type, use_ipstring;
+	size_t i;
+
+	net = oval_net_cache_acquire(OVAL_NET_CACHE_ADDRS);
+	if (net == NULL) {
+		SEXP_t *msg;
+
+		msg = probe_msg_creat(OVAL_MESSAGE_LEVEL_ERROR, "Can't list the network interfaces.");
+		probe_cobj_add_msg(probe_ctx_getresult(ctx), msg);
+		SEXP_free(msg);
+		probe_cobj_set_flag(probe_ctx_getresult(ctx), SYSCHAR_FLAG_ERROR);
+
+		return 1;
+	}
+
+	include_type = oval_schema_version_cmp(over, OVAL_SCHEMA_VERSION(5.6)) >= 0;
+	use_ipstring = oval_schema_version_cmp(over, OVAL_SCHEMA_VERSION(5.8)) >= 0;
+
+	for (i = 0; (addr = oval_net_cache_addr(net, i)) != NULL; ++i) {
+		SEXP_t *sname;
+
+		sname = SEXP_string_newf("%s", addr->name);
+		if (probe_entobj_cmp(name_ent, sname) != OVAL_RESULT_TRUE) {
+			SEXP_free(sname);
+			continue;
+		}
+		SEXP_free(sname);
+
+		snprintf(mac, sizeof(mac), "%02X:%02X:%02X:%02X:%02X:%02X",
+			 addr->hw_addr[0], addr->hw_addr[1], addr->hw_addr[2],
+			 addr->hw_addr[3], addr->hw_addr[4], addr->hw_addr[5]);
+		type = get_l2_type(addr->hw_type);
+		get_flags(addr->flags, &flags);
+
+/* The inet_addr entity is the IP address of the specific interface.
+ * Note that the IP address can be IPv4 or IPv6. If the IP address is an IPv6 address,
+ * this entity should be expressed as an IPv6 address prefix using CIDR notation and
+ * the netmask entity should not be collected.
+ */
+		if (addr->family == AF_INET) {
+			struct in_addr netmask;
+
+			netmask.s_addr = htonl(addr->prefixlen > 0 ? 0xffffffffU << (32 - addr->prefixlen) : 0);
+			inet_ntop(AF_INET, &addr->addr.in, host, sizeof(host));
+			inet_ntop(AF_INET, &netmask, mask, sizeof(mask));
+			address_type = use_ipstring ? OVAL_DATATYPE_IPV4ADDR : OVAL_DATATYPE_STRING;
+
+			if ((addr->flags & IFF_BROADCAST) && addr->has_broadcast)
+				inet_ntop(AF_INET, &addr->broadcast, broad, sizeof(broad));
+			else
+				*broad = '\0';
+		} else {
+			char host_tmp[INET6_ADDRSTRLEN];
+
+			inet_ntop(AF_INET6, &addr->addr.in6, host_tmp, sizeof(host_tmp));
+			snprintf(host, sizeof(host), "%s/%u", host_tmp, addr->prefixlen);
+			address_type = use_ipstring ? OVAL_DATATYPE_IPV6ADDR : OVAL_DATATYPE_STRING;
+			*mask = '\0';
+			*broad = '\0';
+		}
+
+		item = probe_item_create(OVAL_UNIX_INTERFACE, NULL,
+					 "name",           OVAL_DATATYPE_STRING, addr->name,
+					 "type",           OVAL_DATATYPE_STRING, include_type ? type : NULL,
+					 "hardware_addr",  OVAL_DATATYPE_STRING, mac,
+					 "inet_addr",      address_type, host,
+					 "broadcast_addr", address_type, broad,
+					 "netmask",        address_type, mask,
+					 "flag",           OVAL_DATATYPE_STRING_M, flags,
+					 NULL);
+
+		probe_item_collect(ctx, item);
+	}
+
+	oval_net_cache_release(net);
+	return 0;
+}
+#else
 static int get_ifs(SEXP_t *name_ent, probe_ctx *ctx, oval_schema_version_t over)
 {
 	struct ifaddrs *ifaddr, *ifa;
@@ -426,16 +504,6 @@ static int get_ifs(SEXP_t *name_ent, probe_ctx *ctx, oval_schema_version_t over)
 			/* count prefix */
 			sin6p = (struct sockaddr_in6 *) ifa->ifa_netmask;
 
-#if defined(OS_LINUX)
-			for (byte = 0; byte < 4 && sin6p->sin6_addr.s6_addr32[byte] == 0xffffffff; byte++) {
-			        prefix += 32;
-			}
-			if (byte < 4) {
-			        tmp = ntohl(sin6p->sin6_addr.s6_addr32[byte]);
-			        for (bit = 31; tmp & (1 << bit); bit--)
-			                prefix++;
-			}
-#elif defined(OS_FREEBSD)
 			for (byte = 0; byte < 4 && sin6p->sin6_addr.__u6_addr.__u6_addr32[byte] == 0xffffffff; byte++) {
 				prefix += 32;
 			}
@@ -444,7 +512,6 @@ static int get_ifs(SEXP_t *name_ent, probe_ctx *ctx, oval_schema_version_t over)
 				for (bit = 31; tmp & (1 << bit); bit--)
 					prefix++;
 			}
-#endif
 			host_len = strlen(host);
 			if (host_len + 1 + 11 >= NI_MAXHOST) {
 				/*
@@ -502,6 +569,7 @@ leave1:
 	freeifaddrs(ifaddr);
 	return rc;
 }
+#endif /* OS_LINUX */
 #else
 static int get_ifs(SEXP_t *name_ent, probe_ctx *ctx, oval_schema_version_t over)
 {
@@ -6,6 +6,7 @@
 #include <cstring>
 #include <iostream>
 #include <stdlib.h>
+#include <sys/stat.h>
 
 #include <apt-pkg/init.h>
 #include <apt-pkg/error.h>
@@ -13,7 +14,6 @@
 #include <apt-pkg/fileutl.h>
 #include <apt-pkg/mmap.h>
 #include <apt-pkg/pkgcache.h>
-#include <apt-pkg/pkgrecords.h>
 #include <apt-pkg/pkgsystem.h>
 #include <apt-pkg/cachefile.h>
 
@@ -26,6 +26,30 @@ static pkgCacheFile *cgCache = NULL;
 
 static MMap *dpkg_mmap = NULL;
 
+/* the dpkg status file as it was when the cache was opened */
+static struct stat status_st;
+
+static void statusstat (struct stat *st) {
+        string status = _config->FindFile("Dir::State::status");
+
+        if (stat(status.c_str(), st) != 0)
+                memset(st, 0, sizeof(struct stat));
+}
+
+static int readcache (void) {
+        /* before reading, so that a change done meanwhile reopens it again */
+        statusstat(&status_st);
+
+        if (!cgCache->ReadOnlyOpen(NULL)) return 0;
+
+        if (_error->PendingError () == true) {
+                _error->DumpErrors ();
+                return 0;
+        }
+
+        return 1;
+}
+
 static int opencache (void) {
         if (pkgInitConfig (*_config) == false) return 0;
 
@@ -37,22 +61,41 @@ static int opencache (void) {
 
         if (pkgInitSystem (*_config, _system) == false) return 0;
 
-        if (!cgCache->ReadOnlyOpen(NULL)) return 0;
+        return readcache();
+}
 
-        if (_error->PendingError () == true) {
-                _error->DumpErrors ();
-                return 0;
-        }
+/*
+ * The probe state outlives a scan, reopen the cache if dpkg changed the
+ * status file since then, so installed packages are not reported stale.
+ */
+static int refreshcache (void) {
+        struct stat st;
 
-        return 1;
+        statusstat(&st);
+        if (st.st_dev == status_st.st_dev && st.st_ino == status_st.st_ino &&
+            st.st_size == status_st.st_size &&
+            st.st_mtim.tv_sec == status_st.st_mtim.tv_sec &&
+            st.st_mtim.tv_nsec == status_st.st_mtim.tv_nsec &&
+            cgCache->GetPkgCache() != NULL)
+                return 1;
+
+        cgCache->Close();
+
+        return readcache();
 }
 
 struct dpkginfo_reply_t * dpkginfo_get_by_name(const char *name, int *err)
 {
-        pkgCache &cache = *cgCache->GetPkgCache();
-        pkgRecords Recs (cache);
         struct dpkginfo_reply_t *reply = NULL;
 
+        if (refreshcache() != 1) {
+                if (err) *err = -1;
+                return NULL;
+        }
+
+        /* the package names are hashed in the cache, no records are read */
+        pkgCache &cache = *cgCache->GetPkgCache();
+
         // Locate the package
         pkgCache::PkgIterator Pkg = cache.FindPkg(name);
         if (Pkg.end() == true) {
@@ -68,7 +111,6 @@ struct dpkginfo_reply_t * dpkginfo_get_by_name(const char *name, int *err)
                 if (err) *err = 0;
                 return NULL;
         }
-        pkgRecords::Parser &P = Recs.Lookup(V1.FileList());
 
         /* split epoch, version and release */
         string evr = V1.VerStr();
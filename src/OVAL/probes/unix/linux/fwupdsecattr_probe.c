@@ -60,15 +60,21 @@
 #include <probe/option.h>
 #include "probe/entcmp.h"
 #include "common/debug_priv.h"
+#include "_probe-api.h"
 
 #include "fwupdsecattr_probe.h"
 #include "systemdshared.h"
 
 
-static struct cachehed hsi_result_cache;
+/* the HSI attributes reported by fwupd, fetched once per scan */
+struct hsi_snapshot {
+	const char *error;	/* message if they couldn't be fetched */
+	struct cachehed cache;
+};
 
-static void hsicache_callback(char *name, const uint32_t value)
+static void hsicache_callback(char *name, const uint32_t value, void *cbarg)
 {
+	struct hsi_snapshot *snapshot = cbarg;
 	struct secattr_cache *entry;
 
 	if (name == NULL)
@@ -82,14 +88,14 @@ static void hsicache_callback(char *name, const uint32_t value)
 	entry->name = oscap_strdup(name);
 	entry->hsi_result = value;
 	dD("HSI cache add name: %s value: %d\n", entry->name, entry->hsi_result);
-	LIST_INSERT_HEAD(&hsi_result_cache, entry, entries);
+	LIST_INSERT_HEAD(&snapshot->cache, entry, entries);
 }
 
-static uint32_t hsicache_get(const char *key)
+static uint32_t hsicache_get(struct hsi_snapshot *snapshot, const char *key)
 {
 	struct secattr_cache *next;
 
-	LIST_FOREACH(next, &hsi_result_cache, entries) {
+	LIST_FOREACH(next, &snapshot->cache, entries) {
 		dD("HSI search key: %s (name: %s value: %d)\n", key, next->name, next->hsi_result);
 		if (!strncmp(next->name, key, strlen(next->name))) {
 			return next->hsi_result;
@@ -100,7 +106,7 @@ static uint32_t hsicache_get(const char *key)
 	return UINT32_MAX;
 }
 
-static int get_all_security_attributes(DBusConnection *conn, void(*callback)(char *name, const uint32_t value), void *cbarg)
+static int get_all_security_attributes(DBusConnection *conn, void(*callback)(char *name, const uint32_t value, void *cbarg), void *cbarg)
 {
 	int ret = 1;
 	DBusMessage *msg = NULL;
@@ -221,7 +227,7 @@ static int get_all_security_attributes(DBusConnection *conn, void(*callback)(cha
 			}
 			free(property_name);
 		} while (dbus_message_iter_next(&array_entry));
-		callback(appstream_name, hsi_flags);
+		callback(appstream_name, hsi_flags, cbarg);
 	}
 	while (dbus_message_iter_next(&property_iter));
 
@@ -285,17 +291,50 @@ fwupd_security_attr_result_to_string(FwupdSecurityAttrResult result)
 	return "invalid-hsi-result";
 }
 
+static void hsi_snapshot_free(void *ptr)
+{
+	struct hsi_snapshot *snapshot = ptr;
+	struct secattr_cache *entry;
+
+	while ((entry = LIST_FIRST(&snapshot->cache)) != NULL) {
+		LIST_REMOVE(entry, entries);
+		free(entry->name);
+		free(entry);
+	}
+	free(snapshot);
+}
+
+/* failures are kept too, fwupd isn't asked again in the same scan */
+static void *hsi_snapshot_new(void *arg)
+{
+	struct hsi_snapshot *snapshot = calloc(1, sizeof(struct hsi_snapshot));
+	DBusConnection *dbus_conn;
+
+	if (snapshot == NULL)
+		return NULL;
+	LIST_INIT(&snapshot->cache);
+
+	dbus_conn = connect_dbus();
+	if (dbus_conn == NULL) {
+		snapshot->error = "D-Bus connection failed, could not identify fwupd.";
+		return snapshot;
+	}
+
+	if (get_all_security_attributes(dbus_conn, hsicache_callback, snapshot) != 0)
+		snapshot->error = "The fwupd service is not properly installed or configured.";
+	disconnect_dbus(dbus_conn);
+
+	return snapshot;
+}
+
 int fwupdsecattr_probe_main(probe_ctx *ctx, void *arg)
 {
 	SEXP_t *val, *item, *ent, *probe_in;
 	char *stream_id = NULL;
 	const char *hsi_result_str;
 	uint64_t hsi_result = UINT64_MAX;
-
-	/* arg is NULL if regex compilation failed */
-	if (arg == NULL) {
-		return PROBE_EINIT;
-	}
+	struct hsi_snapshot *snapshot;
+	probe_memo_t *memo;
 
 	probe_in = probe_ctx_getobject(ctx);
 	if (probe_in == NULL)
@@ -315,36 +354,22 @@ int fwupdsecattr_probe_main(probe_ctx *ctx, void *arg)
 	SEXP_free(val);
 	SEXP_free(ent);
 
-	if (LIST_EMPTY(&hsi_result_cache)) {
-		DBusError dbus_error;
-		DBusConnection *dbus_conn;
-
-		dbus_error_init(&dbus_error);
-		dbus_conn = connect_dbus();
-
-		if (dbus_conn == NULL) {
-			dbus_error_free(&dbus_error);
-			SEXP_t *msg = probe_msg_creat(OVAL_MESSAGE_LEVEL_INFO, "D-Bus connection failed, could not identify fwupd.");
-			probe_cobj_set_flag(probe_ctx_getresult(ctx), SYSCHAR_FLAG_ERROR);
-			probe_cobj_add_msg(probe_ctx_getresult(ctx), msg);
-			SEXP_free(msg);
-			return 0;
-		}
-
-		int res = get_all_security_attributes(dbus_conn, hsicache_callback, NULL);
-		disconnect_dbus(dbus_conn);
+	memo = probe_memo_acquire("fwupdsecattr", hsi_snapshot_new, NULL, hsi_snapshot_free);
+	if (memo == NULL) {
+		free(stream_id);
+		return PROBE_ENOMEM;
+	}
+	snapshot = probe_memo_value(memo);
 
-		if (res) {
-			dbus_error_free(&dbus_error);
-			SEXP_t *msg = probe_msg_creat(OVAL_MESSAGE_LEVEL_INFO, "The fwupd service is not properly installed or configured.");
-			probe_cobj_set_flag(probe_ctx_getresult(ctx), SYSCHAR_FLAG_ERROR);
-			probe_cobj_add_msg(probe_ctx_getresult(ctx), msg);
-			SEXP_free(msg);
-			return 0;
-		}
+	if (snapshot->error != NULL) {
+		SEXP_t *msg = probe_msg_creat(OVAL_MESSAGE_LEVEL_INFO, (char *)snapshot->error);
+		probe_cobj_set_flag(probe_ctx_getresult(ctx), SYSCHAR_FLAG_ERROR);
+		probe_cobj_add_msg(probe_ctx_getresult(ctx), msg);
+		SEXP_free(msg);
+		goto exit;
 	}
 
-	hsi_result = hsicache_get(stream_id);
+	hsi_result = hsicache_get(snapshot, stream_id);
 
 	if (hsi_result == UINT32_MAX) {
 		item = probe_item_create(OVAL_LINUX_FWUPDSECATTR, NULL,
@@ -362,6 +387,7 @@ int fwupdsecattr_probe_main(probe_ctx *ctx, void *arg)
 	probe_item_collect(ctx, item);
 
 exit:
+	probe_memo_release(memo);
 	free(stream_id);
 	return 0;
 }
@@ -59,12 +59,19 @@
 #include <netdb.h>
 #include <arpa/inet.h>
 #include <regex.h>
+#include <stdbool.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/sock_diag.h>
+#include <linux/inet_diag.h>
 
 #include "_seap.h"
 #include "probe-api.h"
 #include "probe/entcmp.h"
 #include "common/debug_priv.h"
 #include "inetlisteningservers_probe.h"
+#include "oval_proc_cache.h"
+#include "SEAP/generic/rbt/rbt.h"
 
 /* This structure contains the information OVAL is asking or requesting */
 struct server_info {
@@ -88,219 +95,70 @@ typedef struct _lnode {
   pid_t pid;            // process ID
   uid_t uid;            // effective user ID
   char *cmd;            // command run by user
-  unsigned long inode;  // inode of socket
-  struct _lnode* next;  // Next node pointer
 } lnode;
 
-/* This is the linked list head. Only data elements go here. */
-typedef struct {
-  lnode *head;          // List head
-  lnode *cur;           // Pointer to current node
-} llist;
-
-/* Function prototypes */
-static inline lnode *list_get_cur(llist *l) { return l->cur; }
-static void list_create(llist *l);
-static void list_append(llist *l, lnode *node);
-static void list_clear(llist* l);
-static lnode *list_find_inode(llist *l, unsigned long i);
-
-
-static void list_create(llist *l)
+static void lnode_free(struct rbt_i64_node *n)
 {
-	l->head = NULL;
-	l->cur = NULL;
-}
+	lnode *node = n->data;
 
-static void list_append(llist *l, lnode *node)
-{
-	lnode* newnode;
-
-	if (node == NULL || l == NULL)
-		return;
-
-	newnode = malloc(sizeof(lnode));
-	if (newnode == NULL)
-		return;
-
-	newnode->pid = node->pid;
-	newnode->uid = node->uid;
-	newnode->inode = node->inode;
-	// Take custody of the memory
-	newnode->cmd = node->cmd;
-	newnode->next = NULL;
-
-	// if we are at top, fix this up
-	if (l->head == NULL)
-		l->head = newnode;
-	else	// Otherwise add pointer to newnode
-		l->cur->next = newnode;
-
-	// make newnode current
-	l->cur = newnode;
+	free(node->cmd);
+	free(node);
 }
 
-static void list_clear(llist* l)
-{
-	lnode* nextnode;
-	register lnode* cur;
-
-	cur = l->head;
-	while (cur) {
-		nextnode=cur->next;
-		free(cur->cmd);
-		free(cur);
-		cur=nextnode;
-	}
-	l->head = NULL;
-	l->cur = NULL;
-}
-
-static lnode *list_find_inode(llist *l, unsigned long i)
-{
-        register lnode* cur;
-
-       	cur = l->head;	/* start at the beginning */
-	while (cur) {
-		if (cur->inode == i) {
-			l->cur = cur;
-			return cur;
-		} else
-			cur = cur->next;
-	}
-	return NULL;
-}
-
-static int collect_process_info(llist *l)
+/*
+ * Map the socket inodes to the processes which have them open, the first
+ * process found wins.
+ */
+static int collect_process_info(rbt_t *procs)
 {
-	DIR *d, *f;
-	struct dirent *ent;
+	int *pids;
+	size_t pid_count, i, j;
 
-	d = opendir("/proc");
-	if (d == NULL)
+	// The processes are listed once per scan, shared with process58
+	if (oval_proc_cache_pids(&pids, &pid_count) != 0)
 		return 1;
 
-	while (( ent = readdir(d) )) {
-		FILE *sf;
-		int pid, ppid;
-		char buf[100];
-		char *tmp, cmd[16], state, *text = NULL;
-		int fd, len, euid = 0;
-
-		// Skip non-process dir entries
-		if(*ent->d_name<'0' || *ent->d_name>'9')
-			continue;
-		errno = 0;
-		pid = strtol(ent->d_name, NULL, 10);
-		if (errno)
-			continue;
+	for (i = 0; i < pid_count; ++i) {
+		int pid = pids[i], ruid, euid = 0;
+		struct oval_proc_stat st;
+		unsigned long *inodes;
+		size_t inode_count;
 
 		// Parse up the stat file for the proc
-		snprintf(buf, 32, "/proc/%d/stat", pid);
-		fd = open(buf, O_RDONLY, 0);
-		if (fd < 0)
-			continue;
-		len = read(fd, buf, sizeof buf - 1);
-		close(fd);
-		if (len < 40)
-			continue;
-		buf[len] = 0;
-		tmp = strrchr(buf, ')');
-		if (tmp)
-			*tmp = 0;
-		else
+		if (oval_proc_cache_stat(pid, &st) != 0)
 			continue;
-		memset(cmd, 0, sizeof(cmd));
-		sscanf(buf, "%d (%15c", &ppid, cmd);
-		sscanf(tmp+2, "%c %d", &state, &ppid);
 
 		// Skip kthreads
-		if (pid == 2 || ppid == 2)
+		if (pid == 2 || st.ppid == 2)
 			continue;
 
 		// Get the effective uid
-		snprintf(buf, 32, "/proc/%d/status", pid);
-		sf = fopen(buf, "rt");
-		if (sf) {
-			int line = 0;
-			__fsetlocking(sf, FSETLOCKING_BYCALLER);
-			while (fgets(buf, sizeof(buf), sf)) {
-				if (line == 0) {
-					line++;
-					continue;
-				}
-				if (memcmp(buf, "Uid:", 4) == 0) {
-					int id;
-					sscanf(buf, "Uid: %d %d",
-						&id, &euid);
-					break;
-				}
-			}
-			fclose(sf);
-		}
+		oval_proc_cache_uids(pid, &ruid, &euid);
 
 		// Now lets get the inodes each process has open
-		snprintf(buf, 32, "/proc/%d/fd", pid);
-		f = opendir(buf);
-		if (f == NULL) {
+		if (oval_proc_cache_socket_inodes(pid, &inodes, &inode_count) != 0) {
 			// Process might have ended or we don;t have access - ignore it
-			free(text);
+			free(inodes);
 			continue;
 		}
-		// For each file in the fd dir...
-		while (( ent = readdir(f) )) {
-			char line[256], *s, *e;
-			unsigned long inode;
-			lnode node;
-			int lnlen;
-
-			if (ent->d_name[0] == '.')
-				continue;
-			int pathname_len = snprintf(NULL, 0, "%s/%s", buf, ent->d_name);
-			if (pathname_len < 0) {
-				continue;
-			}
-			pathname_len++; // +1 for terminating '\0'
-			char *pathname = malloc(pathname_len);
-			snprintf(pathname, pathname_len, "%s/%s", buf, ent->d_name);
-			lnlen = readlink(pathname, line, sizeof(line) - 1);
-			free(pathname);
-			if (lnlen < 0) {
-				continue;
-			}
-			line[lnlen] = 0;
-
-			// Only look at the socket entries
-			if (memcmp(line, "socket:", 7) == 0) {
-				// Type 1 sockets
-				s = strchr(line+7, '[');
-				if (s == NULL)
-					continue;
-				s++;
-				e = strchr(s, ']');
-				if (e == NULL)
-					continue;
-				*e = 0;
-			} else if (memcmp(line, "[0000]:", 7) == 0) {
-				// Type 2 sockets
-				s = line + 8;
-			} else
-				continue;
-			errno = 0;
-			inode = strtoul(s, NULL, 10);
-			if (errno)
-				continue;
-			node.pid = pid;
-			node.uid = euid;
-			node.cmd = strdup(cmd);
-			node.inode = inode;
+		for (j = 0; j < inode_count; ++j) {
+			lnode *node;
+
+			node = malloc(sizeof(lnode));
+			if (node == NULL)
+				break;
+			node->pid = pid;
+			node->uid = euid < 0 ? 0 : euid;
+			node->cmd = strdup(st.comm);
 			// We make one entry for each socket inode
-			list_append(l, &node);
+			if (rbt_i64_add(procs, inodes[j], node, NULL) != 0) {
+				free(node->cmd);
+				free(node);
+			}
 		}
-		closedir(f);
-		free(text);
+		free(inodes);
 	}
-	closedir(d);
+	free(pids);
 	return 0;
 }
 
@@ -333,15 +191,10 @@ static int eval_data(const char *type, const char *local_address,
 	return 1;
 }
 
-static void report_finding(struct result_info *res, llist *l, probe_ctx *ctx)
+static void report_finding(struct result_info *res, lnode *n, probe_ctx *ctx)
 {
         SEXP_t *item;
         SEXP_t se_lport_mem, se_rport_mem, se_lfull_mem, se_ffull_mem, *se_uid_mem = NULL;
-	lnode *n = NULL;
-
-	if (l) {
-		n = list_get_cur(l);
-	}
 
 	if (n) {
                 item = probe_item_create(OVAL_LINUX_INET_LISTENING_SERVER, NULL,
@@ -396,8 +249,102 @@ static void addr_convert(const char *src, char *dest, int size)
 	}
 }
 
+static lnode *find_inode(rbt_t *procs, unsigned long inode)
+{
+	lnode *n = NULL;
+
+	if (inode == 0 || rbt_i64_get(procs, inode, (void **)&n) != 0)
+		return NULL;
+
+	return n;
+}
 
-static int read_tcp(const char *proc, const char *type, llist *l, probe_ctx *ctx, struct server_info *req)
+#if defined(SOCK_DIAG_BY_FAMILY)
+/*
+ * Dump the sockets of a family and protocol with NETLINK_SOCK_DIAG, which
+ * saves formatting and parsing the /proc/net text tables.
+ * @return 0 on success, -1 if nothing could be dumped, the caller falls
+ * back to /proc/net then
+ */
+static int read_sock_diag(int family, int protocol, const char *type, rbt_t *procs, probe_ctx *ctx, struct server_info *req)
+{
+	struct {
+		struct nlmsghdr nlh;
+		struct inet_diag_req_v2 r;
+	} diag_req;
+	struct sockaddr_nl nladdr;
+	char buf[32768];
+	bool done = false, received = false;
+	int fd;
+
+	fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_SOCK_DIAG);
+	if (fd == -1)
+		return -1;
+
+	memset(&nladdr, 0, sizeof(nladdr));
+	nladdr.nl_family = AF_NETLINK;
+	memset(&diag_req, 0, sizeof(diag_req));
+	diag_req.nlh.nlmsg_len = sizeof(diag_req);
+	diag_req.nlh.nlmsg_type = SOCK_DIAG_BY_FAMILY;
+	diag_req.nlh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+	diag_req.nlh.nlmsg_seq = 1;
+	diag_req.r.sdiag_family = family;
+	diag_req.r.sdiag_protocol = protocol;
+	diag_req.r.idiag_states = ~0U; // all of them, like /proc/net does
+
+	if (sendto(fd, &diag_req, sizeof(diag_req), 0, (struct sockaddr *)&nladdr, sizeof(nladdr)) == -1) {
+		close(fd);
+		return -1;
+	}
+
+	while (!done) {
+		struct nlmsghdr *h;
+		ssize_t len = recv(fd, buf, sizeof(buf), 0);
+
+		if (len == -1 && errno == EINTR)
+			continue;
+		if (len <= 0)
+			break;
+
+		for (h = (struct nlmsghdr *)buf; NLMSG_OK(h, (size_t)len); h = NLMSG_NEXT(h, len)) {
+			struct inet_diag_msg *m;
+			char src[NI_MAXHOST], dest[NI_MAXHOST];
+			unsigned local_port;
+
+			if (h->nlmsg_type == NLMSG_DONE) {
+				received = true;
+				done = true;
+				break;
+			}
+			if (h->nlmsg_type == NLMSG_ERROR) {
+				// e.g. the diag module of the protocol is not loaded
+				done = true;
+				break;
+			}
+			received = true;
+			m = NLMSG_DATA(h);
+			inet_ntop(family, m->id.idiag_src, src, sizeof(src));
+			inet_ntop(family, m->id.idiag_dst, dest, sizeof(dest));
+			local_port = ntohs(m->id.idiag_sport);
+			dI("Have %s port: %s:%u", type, src, local_port);
+			if (eval_data(type, src, local_port, req)) {
+				struct result_info r;
+				r.proto = type;
+				r.laddr = src;
+				r.lport = local_port;
+				r.raddr = dest;
+				r.rport = ntohs(m->id.idiag_dport);
+				report_finding(&r, find_inode(procs, m->idiag_inode), ctx);
+			}
+		}
+	}
+	close(fd);
+
+	return received ? 0 : -1;
+}
+#endif
+
+static int read_tcp(const char *proc, const char *type, rbt_t *procs, probe_ctx *ctx, struct server_info *req)
 {
 	int line = 0;
 	FILE *f;
@@ -438,18 +385,14 @@ static int read_tcp(const char *proc, const char *type, llist *l, probe_ctx *ctx
 			r.lport = local_port;
 			r.raddr = dest;
 			r.rport = rem_port;
-			if (list_find_inode(l, inode)) {
-				report_finding(&r, l, ctx);
-			} else {
-				report_finding(&r, NULL, ctx);
-			}
+			report_finding(&r, find_inode(procs, inode), ctx);
 		}
 	}
 	fclose(f);
 	return 0;
 }
 
-static int read_udp(const char *proc, const char *type, llist *l, probe_ctx *ctx, struct server_info *req)
+static int read_udp(const char *proc, const char *type, rbt_t *procs, probe_ctx *ctx, struct server_info *req)
 {
 	int line = 0;
 	FILE *f;
@@ -489,18 +432,14 @@ static int read_udp(const char *proc, const char *type, llist *l, probe_ctx *ctx
 			r.lport = local_port;
 			r.raddr = dest;
 			r.rport = rem_port;
-			if (list_find_inode(l, inode)) {
-				report_finding(&r, l, ctx);
-			} else {
-				report_finding(&r, NULL, ctx);
-			}
+			report_finding(&r, find_inode(procs, inode), ctx);
 		}
 	}
 	fclose(f);
 	return 0;
 }
 
-static int read_raw(const char *proc, const char *type, llist *l, probe_ctx *ctx, struct server_info *req)
+static int read_raw(const char *proc, const char *type, rbt_t *procs, probe_ctx *ctx, struct server_info *req)
 {
 	int line = 0;
 	FILE *f;
@@ -540,11 +479,7 @@ static int read_raw(const char *proc, const char *type, llist *l, probe_ctx *ctx
 			r.lport = local_port;
 			r.raddr = dest;
 			r.rport = rem_port;
-			if (list_find_inode(l, inode)) {
-				report_finding(&r, l, ctx);
-			} else {
-				report_finding(&r, NULL, ctx);
-			}
+			report_finding(&r, find_inode(procs, inode), ctx);
 		}
 	}
 	fclose(f);
@@ -555,7 +490,7 @@ int inetlisteningservers_probe_main(probe_ctx *ctx, void *arg)
 {
         SEXP_t *object;
 	int err;
-	llist ll;
+	rbt_t *procs;
 
         object = probe_ctx_getobject(ctx);
 	struct server_info *req = malloc(sizeof(struct server_info));
@@ -578,8 +513,8 @@ int inetlisteningservers_probe_main(probe_ctx *ctx, void *arg)
 	}
 
 	// Now start collecting the info
-	list_create(&ll);
-	if (collect_process_info(&ll)) {
+	procs = rbt_i64_new();
+	if (collect_process_info(procs)) {
 		SEXP_t *msg;
 
 		msg = probe_msg_creat(OVAL_MESSAGE_LEVEL_ERROR, "Permission error.");
@@ -587,24 +522,37 @@ int inetlisteningservers_probe_main(probe_ctx *ctx, void *arg)
 		SEXP_free(msg);
 		probe_cobj_set_flag(probe_ctx_getresult(ctx), SYSCHAR_FLAG_ERROR);
 
+		rbt_i64_free_cb(procs, &lnode_free);
 		err = 0;
 		goto cleanup;
 	}
 
 	// Now we check the tcp socket list...
-	read_tcp("/proc/net/tcp", "tcp", &ll, ctx, req);
-	read_tcp("/proc/net/tcp6", "tcp", &ll, ctx, req);
+#if defined(SOCK_DIAG_BY_FAMILY)
+	if (read_sock_diag(AF_INET, IPPROTO_TCP, "tcp", procs, ctx, req) != 0)
+#endif
+		read_tcp("/proc/net/tcp", "tcp", procs, ctx, req);
+#if defined(SOCK_DIAG_BY_FAMILY)
+	if (read_sock_diag(AF_INET6, IPPROTO_TCP, "tcp", procs, ctx, req) != 0)
+#endif
+		read_tcp("/proc/net/tcp6", "tcp", procs, ctx, req);
 
 	// Next udp sockets...
-	read_udp("/proc/net/udp", "udp", &ll, ctx, req);
-	read_udp("/proc/net/udp6", "udp", &ll, ctx, req);
+#if defined(SOCK_DIAG_BY_FAMILY)
+	if (read_sock_diag(AF_INET, IPPROTO_UDP, "udp", procs, ctx, req) != 0)
+#endif
+		read_udp("/proc/net/udp", "udp", procs, ctx, req);
+#if defined(SOCK_DIAG_BY_FAMILY)
+	if (read_sock_diag(AF_INET6, IPPROTO_UDP, "udp", procs, ctx, req) != 0)
+#endif
+		read_udp("/proc/net/udp6", "udp", procs, ctx, req);
 
 	// Next, raw sockets...not exactly part of standard yet. They
 	// can be used to send datagrams, so we will pretend they are udp
-	read_raw("/proc/net/raw", "udp", &ll, ctx, req);
-	read_raw("/proc/net/raw6", "udp", &ll, ctx, req);
+	read_raw("/proc/net/raw", "udp", procs, ctx, req);
+	read_raw("/proc/net/raw6", "udp", procs, ctx, req);
 
-	list_clear(&ll);
+	rbt_i64_free_cb(procs, &lnode_free);
 
 	err = 0;
  cleanup:
@@ -64,18 +64,19 @@
 #include <probe/option.h>
 #include <mntent.h>
 #include <pcre.h>
+#include <pthread.h>
+#include <stdbool.h>
 
 #include "common/debug_priv.h"
+#include "common/util.h"
+#include "common/list.h"
+#include "fsdev.h"
 #include "partition_probe.h"
 
 #ifndef MTAB_PATH
 # define MTAB_PATH "/proc/mounts"
 #endif
 
-#ifndef MTAB_LINE_MAX
-# define MTAB_LINE_MAX 4096
-#endif
-
 const char *__OVAL_fs_types[][2] = {
 	{ "adfs",       "ADFS_SUPER_MAGIC" },
 	{ "affs",       "AFFS_SUPER_MAGIC" },
@@ -127,7 +128,7 @@ const char *__OVAL_fs_types[][2] = {
 	{ "sockfs",     "SOCKFS_MAGIC" }
 };
 
-static const char *correct_fstype(char *type)
+static const char *correct_fstype(const char *type)
 {
 	register size_t i;
 
@@ -150,43 +151,111 @@ static uint8_t add_mnt_opt(char ***mnt_opts, uint8_t mnt_ocnt, char *opt)
 	return mnt_ocnt + 1;
 }
 
+struct partition_probe_arg {
+	pthread_mutex_t lock;
+#if defined(HAVE_BLKID_GET_TAG_VALUE)
+	blkid_cache blkcache;         /* NULL until the first UUID is asked for */
+	struct oscap_htable *uuids;   /* device -> UUID, "" if it has none */
+#endif
+};
+
+void *partition_probe_init(void)
+{
+	struct partition_probe_arg *arg = calloc(1, sizeof(struct partition_probe_arg));
+
+	if (arg == NULL)
+		return (NULL);
+	pthread_mutex_init(&arg->lock, NULL);
+#if defined(HAVE_BLKID_GET_TAG_VALUE)
+	arg->blkcache = NULL;
+	arg->uuids = oscap_htable_new();
+#endif
+	return (arg);
+}
+
+void partition_probe_fini(void *probe_arg)
+{
+	struct partition_probe_arg *arg = probe_arg;
+
+	if (arg == NULL)
+		return;
 #if defined(HAVE_BLKID_GET_TAG_VALUE)
-static int collect_item(probe_ctx *ctx, oval_schema_version_t over, struct mntent *mnt_ent, blkid_cache blkcache)
-#else
-static int collect_item(probe_ctx *ctx, oval_schema_version_t over, struct mntent *mnt_ent)
+	if (arg->blkcache != NULL)
+		blkid_put_cache(arg->blkcache);
+	oscap_htable_free(arg->uuids, free);
 #endif
+	pthread_mutex_destroy(&arg->lock);
+	free(arg);
+}
+
+#if defined(HAVE_BLKID_GET_TAG_VALUE)
+/*
+ * Get the UUID of a device, the device is probed once per session.
+ * Returns a copy of the UUID, "" if the device has none, NULL if the
+ * blkid cache can't be read.
+ */
+static char *partition_uuid(struct partition_probe_arg *arg, const char *device)
+{
+	char *uuid;
+
+	pthread_mutex_lock(&arg->lock);
+	uuid = oscap_htable_get(arg->uuids, device);
+	if (uuid == NULL) {
+		if (arg->blkcache == NULL && blkid_get_cache(&arg->blkcache, NULL) != 0) {
+			arg->blkcache = NULL;
+			pthread_mutex_unlock(&arg->lock);
+			return (NULL);
+		}
+		uuid = blkid_get_tag_value(arg->blkcache, "UUID", device);
+		if (uuid == NULL)
+			uuid = strdup("");
+		if (uuid != NULL && !oscap_htable_add(arg->uuids, device, uuid)) {
+			free(uuid);
+			uuid = NULL;
+		}
+	}
+	uuid = strdup(uuid != NULL ? uuid : "");
+	pthread_mutex_unlock(&arg->lock);
+
+	return (uuid);
+}
+#endif
+
+/*
+ * Collect the i-th entry of the mount table snapshot. The uuid is NULL
+ * if it's not collected.
+ */
+static int collect_item(probe_ctx *ctx, oval_schema_version_t over, fsdev_mounts_t *mounts, size_t i, const char *prefix, const char *uuid)
 {
         SEXP_t *item;
-        char   *uuid = "", *tok, *save = NULL, **mnt_opts = NULL;
-        char path[PATH_MAX];
+        char   *tok, *save = NULL, **mnt_opts = NULL, *opts;
+        const char *fs_type;
+        const struct mntent *mnt_ent;
         uint8_t mnt_ocnt;
         struct statvfs stvfs;
 
+        mnt_ent = fsdev_mounts_entry(mounts, i);
+
         /*
-         * Get FS stats
+         * Get FS stats, they are taken once per snapshot
          */
-        const char *prefix = getenv("OSCAP_PROBE_ROOT");
-        snprintf(path, PATH_MAX, "%s%s", prefix ? prefix : "", mnt_ent->mnt_dir);
-        if (statvfs(path, &stvfs) != 0) {
-                dE("Can't statvfs %s: errno=%d, %s.", path, errno, strerror(errno));
+        if (fsdev_mounts_statvfs(mounts, i, prefix, &stvfs) != 0) {
+                dE("Can't statvfs %s%s: errno=%d, %s.", prefix ? prefix : "",
+                   mnt_ent->mnt_dir, errno, strerror(errno));
                 return (-1);
         }
 
         /*
-         * Get UUID
-         */
-#if defined(HAVE_BLKID_GET_TAG_VALUE)
-        uuid = blkid_get_tag_value(blkcache, "UUID", mnt_ent->mnt_fsname);
-        if (uuid == NULL) {
-		uuid = strdup("");
-        }
-#endif
-        /*
-         * Create a NULL-terminated array from the mount options
+         * Create a NULL-terminated array from the mount options, the
+         * entry is shared so the options are split in a copy
          */
+        opts = strdup(mnt_ent->mnt_opts);
+        if (opts == NULL)
+                return (-1);
+
         mnt_ocnt = 0;
 
-        tok = strtok_r(mnt_ent->mnt_opts, ",", &save);
+        tok = strtok_r(opts, ",", &save);
 
         do {
             mnt_ocnt = add_mnt_opt(&mnt_opts, mnt_ocnt, tok);
@@ -213,8 +282,9 @@ static int collect_item(probe_ctx *ctx, oval_schema_version_t over, struct mnten
 	 * "Correct" the type (this won't be (hopefully) needed in a later version
 	 * of OVAL)
 	 */
+        fs_type = mnt_ent->mnt_type;
         if (oval_schema_version_cmp(over, OVAL_SCHEMA_VERSION(5.10)) < 0)
-	        mnt_ent->mnt_type = (char *)correct_fstype(mnt_ent->mnt_type);
+	        fs_type = correct_fstype(mnt_ent->mnt_type);
 
         /*
          * Create the item
@@ -222,8 +292,8 @@ static int collect_item(probe_ctx *ctx, oval_schema_version_t over, struct mnten
         item = probe_item_create(OVAL_LINUX_PARTITION, NULL,
                                  "mount_point",   OVAL_DATATYPE_STRING,   mnt_ent->mnt_dir,
                                  "device",        OVAL_DATATYPE_STRING,   mnt_ent->mnt_fsname,
-                                 "uuid",          OVAL_DATATYPE_STRING,   uuid,
-                                 "fs_type",       OVAL_DATATYPE_STRING,   mnt_ent->mnt_type,
+                                 "uuid",          OVAL_DATATYPE_STRING,   uuid != NULL ? uuid : "",
+                                 "fs_type",       OVAL_DATATYPE_STRING,   fs_type,
                                  "mount_options", OVAL_DATATYPE_STRING_M, mnt_opts,
                                  "total_space",   OVAL_DATATYPE_INTEGER, (int64_t)stvfs.f_blocks,
                                  "space_used",    OVAL_DATATYPE_INTEGER, (int64_t)(stvfs.f_blocks - stvfs.f_bfree),
@@ -236,23 +306,21 @@ static int collect_item(probe_ctx *ctx, oval_schema_version_t over, struct mnten
             SEXP_free(block_size);
         }
 
-#if defined(HAVE_BLKID_GET_TAG_VALUE)
-        /*
-         * If the partition doesn't have an UUID assigned, set the uuid entity status to
-         * "does not exist" which means that the value was collected but does not exist
-         * on the system.
-         */
-        if (strcmp(uuid, "") == 0) {
+        if (uuid == NULL) {
+	        /* Compiled without blkid library or no state looks at it */
+	        probe_itement_setstatus(item, "uuid", 1, SYSCHAR_STATUS_NOT_COLLECTED);
+        } else if (strcmp(uuid, "") == 0) {
+	        /*
+	         * If the partition doesn't have an UUID assigned, set the uuid entity status to
+	         * "does not exist" which means that the value was collected but does not exist
+	         * on the system.
+	         */
 	        probe_itement_setstatus(item, "uuid", 1, SYSCHAR_STATUS_DOES_NOT_EXIST);
         }
-	free(uuid);
-#else
-	/* Compiled without blkid library, we don't collect UUID */
-	probe_itement_setstatus(item, "uuid", 1, SYSCHAR_STATUS_NOT_COLLECTED);
-#endif /* HAVE_BLKID_GET_TAG_VALUE */
 
         probe_item_collect(ctx, item);
         free(mnt_opts);
+        free(opts);
 
         return (0);
 }
@@ -268,56 +336,49 @@ int partition_probe_main(probe_ctx *ctx, void *probe_arg)
         SEXP_t *mnt_entity, *mnt_opval, *mnt_entval, *probe_in;
         char    mnt_path[PATH_MAX];
         oval_operation_t mnt_op;
-        FILE *mnt_fp;
         oval_schema_version_t obj_over;
+        fsdev_mounts_t *mounts;
+        const struct mntent *mnt_entp;
+        bool want_uuid;
+        size_t i;
 
         const char *prefix = getenv("OSCAP_PROBE_ROOT");
-        snprintf(mnt_path, PATH_MAX, "%s"MTAB_PATH, prefix ? prefix : "");
 
+        if (prefix != NULL) {
+                /* the mount table of an offline system is read for each object */
+                snprintf(mnt_path, PATH_MAX, "%s"MTAB_PATH, prefix);
 #if defined(OS_LINUX)
-        int   mnt_fd;
-        struct statfs stfs;
-
-        mnt_fd = open(mnt_path, O_RDONLY);
-
-        if (mnt_fd < 0) {
-                if (!prefix)
-                        dE("Can't open %s: errno=%d, %s.", mnt_path, errno, strerror(errno));
-                return (prefix ? PROBE_ESUCCESS : PROBE_ESYSTEM);
-        }
-
-        if (fstatfs(mnt_fd, &stfs) != 0) {
-                close(mnt_fd);
-                return (prefix ? PROBE_ESUCCESS : PROBE_ESYSTEM);
-        }
-
-        if (stfs.f_type != PROC_SUPER_MAGIC) {
-                close(mnt_fd);
-                return (prefix ? PROBE_ESUCCESS : PROBE_EFATAL);
-        }
-
-        mnt_fp = fdopen(mnt_fd, "r");
-
-        if (mnt_fp == NULL) {
+                int   mnt_fd;
+                struct statfs stfs;
+
+                mnt_fd = open(mnt_path, O_RDONLY);
+                if (mnt_fd < 0)
+                        return (PROBE_ESUCCESS);
+                if (fstatfs(mnt_fd, &stfs) != 0 || stfs.f_type != PROC_SUPER_MAGIC) {
+                        close(mnt_fd);
+                        return (PROBE_ESUCCESS);
+                }
                 close(mnt_fd);
-                return (prefix ? PROBE_ESUCCESS : PROBE_ESYSTEM);
-        }
-#else
-        mnt_fp = fopen(mnt_path, "r");
+#endif
 
-        if (mnt_fp == NULL) {
-                if (!prefix)
-                        dE("Can't open %s: errno=%d, %s.", mnt_path, errno, strerror(errno));
-                return (prefix ? PROBE_ESUCCESS : PROBE_ESYSTEM);
+                mounts = fsdev_mounts_read(mnt_path);
+                if (mounts == NULL)
+                        return (PROBE_ESUCCESS);
+        } else {
+                /* the snapshot is shared with fsdev and taken again when the mounts change */
+                mounts = fsdev_mounts_get();
+                if (mounts == NULL) {
+                        dE("Can't read the mount table: errno=%d, %s.", errno, strerror(errno));
+                        return (PROBE_ESYSTEM);
+                }
         }
-#endif
 
         probe_in   = probe_ctx_getobject(ctx);
         obj_over   = probe_obj_get_platform_schema_version(probe_in);
         mnt_entity = probe_obj_getent(probe_in, "mount_point", 1);
 
         if (mnt_entity == NULL) {
-                fclose(mnt_fp);
+                fsdev_mounts_put(mounts);
                 return (PROBE_ENOENT);
         }
 
@@ -334,7 +395,7 @@ int partition_probe_main(probe_ctx *ctx, void *probe_arg)
         if (!SEXP_stringp(mnt_entval)) {
                 SEXP_free(mnt_entval);
                 SEXP_free(mnt_entity);
-		fclose(mnt_fp);
+                fsdev_mounts_put(mounts);
                 return (PROBE_EINVAL);
         }
 
@@ -342,87 +403,65 @@ int partition_probe_main(probe_ctx *ctx, void *probe_arg)
         SEXP_free(mnt_entval);
         SEXP_free(mnt_entity);
 
-        if (mnt_fp != NULL) {
-                char buffer[MTAB_LINE_MAX];
-                struct mntent mnt_ent, *mnt_entp;
+        /* probing the devices for the UUID may block, skip it if nothing looks at it */
+        want_uuid = probe_obj_wants_itement(probe_in, "uuid");
 
-                pcre *re = NULL;
-                const char *estr = NULL;
-                int eoff = -1;
-#if defined(HAVE_BLKID_GET_TAG_VALUE)
-                blkid_cache blkcache;
+        pcre *re = NULL;
+        pcre_extra *re_extra = NULL;
+        const char *estr = NULL;
+        int eoff = -1;
 
-                if (blkid_get_cache(&blkcache, NULL) != 0) {
-                        endmntent(mnt_fp);
-                        return (PROBE_EUNKNOWN);
-                }
-#endif
-                if (mnt_op == OVAL_OPERATION_PATTERN_MATCH) {
-                        re = pcre_compile(mnt_path, PCRE_UTF8, &estr, &eoff, NULL);
+        if (mnt_op == OVAL_OPERATION_PATTERN_MATCH) {
+                re = oscap_pcre_compile(mnt_path, PCRE_UTF8, &estr, &eoff, &re_extra);
 
-                        if (re == NULL) {
-                                endmntent(mnt_fp);
-#if defined(HAVE_BLKID_GET_TAG_VALUE)
-                                blkid_put_cache(blkcache);
-#endif
-                                return (PROBE_EINVAL);
-                        }
+                if (re == NULL) {
+                        fsdev_mounts_put(mounts);
+                        return (PROBE_EINVAL);
                 }
+        }
 
-                while ((mnt_entp = getmntent_r(mnt_fp, &mnt_ent,
-                                               buffer, sizeof buffer)) != NULL)
-                {
-			if (strcmp(mnt_entp->mnt_type, "rootfs") == 0)
-			    continue;
-
-                        if (mnt_op == OVAL_OPERATION_EQUALS) {
-                                if (strcmp(mnt_entp->mnt_dir, mnt_path) == 0) {
-#if defined(HAVE_BLKID_GET_TAG_VALUE)
-	                                collect_item(ctx, obj_over, mnt_entp, blkcache);
-#else
-	                                collect_item(ctx, obj_over, mnt_entp);
-#endif
-                                        break;
-                                }
-			} else if (mnt_op == OVAL_OPERATION_NOT_EQUAL) {
-				if (strcmp(mnt_entp->mnt_dir, mnt_path) != 0) {
-					if (
-#if defined(HAVE_BLKID_GET_TAG_VALUE)
-						collect_item(ctx, obj_over, mnt_entp, blkcache)
-#else
-						collect_item(ctx, obj_over, mnt_entp)
-#endif
-					!= 0)
-						break;
-                                }
-                        } else if (mnt_op == OVAL_OPERATION_PATTERN_MATCH) {
-                                int rc;
-
-                                rc = pcre_exec(re, NULL, mnt_entp->mnt_dir,
-                                               strlen(mnt_entp->mnt_dir), 0, 0, NULL, 0);
+        for (i = 0; (mnt_entp = fsdev_mounts_entry(mounts, i)) != NULL; ++i) {
+                bool match = false;
+                char *uuid = NULL;
+
+                if (strcmp(mnt_entp->mnt_type, "rootfs") == 0)
+                        continue;
+
+                if (mnt_op == OVAL_OPERATION_EQUALS) {
+                        match = strcmp(mnt_entp->mnt_dir, mnt_path) == 0;
+                } else if (mnt_op == OVAL_OPERATION_NOT_EQUAL) {
+                        match = strcmp(mnt_entp->mnt_dir, mnt_path) != 0;
+                } else if (mnt_op == OVAL_OPERATION_PATTERN_MATCH) {
+                        match = pcre_exec(re, re_extra, mnt_entp->mnt_dir,
+                                          strlen(mnt_entp->mnt_dir), 0, 0, NULL, 0) == 0;
+                        /* XXX: check for pcre_exec error */
+                }
+                if (!match)
+                        continue;
 
-                                if (rc == 0) {
-	                                if (
 #if defined(HAVE_BLKID_GET_TAG_VALUE)
-		                                collect_item(ctx, obj_over, mnt_entp, blkcache)
-#else
-		                                collect_item(ctx, obj_over, mnt_entp)
-#endif
-                                        != 0)
-		                                break;
-                                }
-                                /* XXX: check for pcre_exec error */
+                if (want_uuid) {
+                        uuid = partition_uuid(probe_arg, mnt_entp->mnt_fsname);
+                        if (uuid == NULL) {
+                                probe_ret = PROBE_EUNKNOWN;
+                                break;
                         }
                 }
-
-                endmntent(mnt_fp);
-
-                if (mnt_op == OVAL_OPERATION_PATTERN_MATCH)
-                        pcre_free(re);
-#if defined(HAVE_BLKID_GET_TAG_VALUE)
-                blkid_put_cache(blkcache);
 #endif
+                if (collect_item(ctx, obj_over, mounts, i, prefix, uuid) != 0 &&
+                    mnt_op != OVAL_OPERATION_EQUALS) {
+                        free(uuid);
+                        break;
+                }
+                free(uuid);
+
+                if (mnt_op == OVAL_OPERATION_EQUALS)
+                        break;
         }
 
+        if (mnt_op == OVAL_OPERATION_PATTERN_MATCH)
+                oscap_pcre_free(re, re_extra);
+        fsdev_mounts_put(mounts);
+
         return (probe_ret);
 }
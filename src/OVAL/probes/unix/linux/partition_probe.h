@@ -27,6 +27,10 @@
 
 int patition_probe_offline_mode_supported(void);
 
+void *partition_probe_init(void);
+
+void partition_probe_fini(void *arg);
+
 int partition_probe_main(probe_ctx *ctx, void *arg);
 
 #endif /* OPENSCAP_PARTITION_PROBE_H */
@@ -24,6 +24,74 @@
 #include <config.h>
 #endif
 
+#include <limits.h>
+#include <regex.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include "common/list.h"
+
+/* packages of the same name */
+struct rpm_index_name {
+	size_t *pkgs; /**< indexes into rpm_index.pkgs */
+	size_t count;
+};
+
+/* files of the rpmdb which change when a package is (un)installed */
+static const char *rpm_index_db_files[] = {
+	".", "Packages", "Packages.db", "rpmdb.sqlite", "rpmdb.sqlite-wal"
+};
+
+#define RPM_INDEX_DB_FILES (sizeof(rpm_index_db_files) / sizeof(rpm_index_db_files[0]))
+
+/*
+ * The rpmdb files are checked for changes at most once per this many
+ * seconds, objects queried meanwhile (e.g. hundreds of packages which
+ * should not be installed) are answered without any system call.
+ */
+#define RPM_INDEX_RECHECK 1
+
+struct rpm_index_dbstat {
+	struct {
+		dev_t dev;
+		ino_t ino;
+		off_t size;
+		time_t mtime;
+		long mtime_nsec;
+	} f[RPM_INDEX_DB_FILES];
+};
+
+/*
+ * All the installed packages are read once into this index, the rpm
+ * probes answer their queries from it instead of reading the rpmdb
+ * each on its own. The index is rebuilt when the rpmdb changes, e.g.
+ * between two scans done by one process.
+ */
+static struct rpm_index {
+	pthread_mutex_t ref_mutex;
+	unsigned int refs;
+	pthread_rwlock_t lock;
+	pthread_mutex_t header_mutex;
+	bool built;
+	char *root;
+	char *dbpath;
+	struct rpm_index_dbstat dbstat;
+	pthread_mutex_t check_mutex;
+	time_t checked; /**< CLOCK_MONOTONIC seconds of the last dbstat check */
+	bool stale;     /**< rebuild on the next acquire, see rpm_index_invalidate() */
+	struct rpm_index_pkg *pkgs; /**< in the rpmdb order */
+	size_t pkgs_count;
+	struct oscap_htable *names; /**< name -> struct rpm_index_name */
+} g_rpm_index = {
+	.ref_mutex = PTHREAD_MUTEX_INITIALIZER,
+	.lock = PTHREAD_RWLOCK_INITIALIZER,
+	.header_mutex = PTHREAD_MUTEX_INITIALIZER,
+	.check_mutex = PTHREAD_MUTEX_INITIALIZER,
+};
+
 #ifdef RPM46_FOUND
 int rpmErrorCb (rpmlogRec rec, rpmlogCallbackData data)
 {
@@ -51,3 +119,328 @@ void rpmLibsPreload()
 	const char* rcfiles = "";
 	rpmReadConfigFiles(rcfiles, NULL);
 }
+
+static void rpm_index_name_free(struct rpm_index_name *name)
+{
+	free(name->pkgs);
+	free(name);
+}
+
+static void rpm_index_clear(struct rpm_index *idx)
+{
+	for (size_t i = 0; i < idx->pkgs_count; i++) {
+		headerFree(idx->pkgs[i].h);
+		free(idx->pkgs[i].name);
+	}
+	free(idx->pkgs);
+	idx->pkgs = NULL;
+	idx->pkgs_count = 0;
+	oscap_htable_free(idx->names, (oscap_destruct_func) rpm_index_name_free);
+	idx->names = NULL;
+	free(idx->root);
+	idx->root = NULL;
+	free(idx->dbpath);
+	idx->dbpath = NULL;
+	idx->built = false;
+}
+
+static void rpm_index_dbstat(const char *dbpath, struct rpm_index_dbstat *dbstat)
+{
+	char path[PATH_MAX];
+	struct stat st;
+
+	memset(dbstat, 0, sizeof(struct rpm_index_dbstat));
+	if (dbpath == NULL)
+		return;
+
+	for (size_t i = 0; i < RPM_INDEX_DB_FILES; i++) {
+		snprintf(path, sizeof(path), "%s/%s", dbpath, rpm_index_db_files[i]);
+		if (stat(path, &st) != 0)
+			continue;
+		dbstat->f[i].dev = st.st_dev;
+		dbstat->f[i].ino = st.st_ino;
+		dbstat->f[i].size = st.st_size;
+		dbstat->f[i].mtime = st.st_mtim.tv_sec;
+		dbstat->f[i].mtime_nsec = st.st_mtim.tv_nsec;
+	}
+}
+
+static time_t rpm_index_now(void)
+{
+	struct timespec now;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &now) != 0)
+		return 0;
+
+	return now.tv_sec;
+}
+
+static void rpm_index_set_checked(struct rpm_index *idx, time_t now)
+{
+	pthread_mutex_lock(&idx->check_mutex);
+	idx->checked = now;
+	pthread_mutex_unlock(&idx->check_mutex);
+}
+
+static const char *rpm_index_root(struct rpm_probe_global *g_rpm)
+{
+	const char *root = rpmtsRootDir(g_rpm->rpmts);
+
+	return root != NULL ? root : "/";
+}
+
+/* whether the index is built from the rpmdb g_rpm would read now */
+static bool rpm_index_is_current(struct rpm_index *idx, struct rpm_probe_global *g_rpm)
+{
+	struct rpm_index_dbstat dbstat;
+	time_t now = rpm_index_now();
+	bool stale, recent;
+
+	if (!idx->built || !oscap_streq(idx->root, rpm_index_root(g_rpm)))
+		return false;
+
+	pthread_mutex_lock(&idx->check_mutex);
+	stale = idx->stale;
+	recent = now != 0 && now - idx->checked < RPM_INDEX_RECHECK;
+	pthread_mutex_unlock(&idx->check_mutex);
+	if (stale)
+		return false;
+	if (recent)
+		return true;
+
+	rpm_index_dbstat(idx->dbpath, &dbstat);
+	if (memcmp(&dbstat, &idx->dbstat, sizeof(dbstat)) != 0)
+		return false;
+	rpm_index_set_checked(idx, now);
+
+	return true;
+}
+
+static int rpm_index_add_name(struct rpm_index *idx, const char *name, size_t pkg)
+{
+	struct rpm_index_name *entry;
+	size_t *pkgs;
+
+	entry = oscap_htable_get(idx->names, name);
+	if (entry == NULL) {
+		entry = calloc(1, sizeof(struct rpm_index_name));
+		if (entry == NULL)
+			return -1;
+		if (!oscap_htable_add(idx->names, name, entry)) {
+			free(entry);
+			return -1;
+		}
+	}
+	pkgs = realloc(entry->pkgs, sizeof(size_t) * (entry->count + 1));
+	if (pkgs == NULL)
+		return -1;
+	pkgs[entry->count++] = pkg;
+	entry->pkgs = pkgs;
+
+	return 0;
+}
+
+/* must be called with the index write-locked */
+static int rpm_index_build(struct rpm_index *idx, struct rpm_probe_global *g_rpm)
+{
+	rpmdbMatchIterator match;
+	Header pkgh;
+	errmsg_t rpmerr;
+	size_t pkgs_size = 0;
+	int ret = 0;
+
+	rpm_index_clear(idx);
+	idx->names = oscap_htable_new1(strcmp, 4099);
+	if (idx->names == NULL)
+		return -1;
+
+	RPM_MUTEX_LOCK(&g_rpm->mutex);
+
+	idx->root = strdup(rpm_index_root(g_rpm));
+	idx->dbpath = rpmGetPath(idx->root, "%{_dbpath}", NULL);
+	/* before reading, the packages installed meanwhile trigger a rebuild */
+	rpm_index_dbstat(idx->dbpath, &idx->dbstat);
+	rpm_index_set_checked(idx, rpm_index_now());
+	pthread_mutex_lock(&idx->check_mutex);
+	idx->stale = false;
+	pthread_mutex_unlock(&idx->check_mutex);
+
+	match = rpmtsInitIterator(g_rpm->rpmts, RPMDBI_PACKAGES, NULL, 0);
+	while (match != NULL && (pkgh = rpmdbNextIterator(match)) != NULL) {
+		struct rpm_index_pkg *pkg;
+
+		if (idx->pkgs_count == pkgs_size) {
+			size_t new_size = pkgs_size > 0 ? 2 * pkgs_size : 1024;
+			void *new_pkgs = realloc(idx->pkgs, sizeof(struct rpm_index_pkg) * new_size);
+
+			if (new_pkgs == NULL) {
+				ret = -1;
+				break;
+			}
+			idx->pkgs = new_pkgs;
+			pkgs_size = new_size;
+		}
+		pkg = &idx->pkgs[idx->pkgs_count];
+		pkg->name = headerFormat(pkgh, "%{NAME}", &rpmerr);
+		if (pkg->name == NULL) {
+			ret = -1;
+			break;
+		}
+		pkg->h = headerLink(pkgh);
+		idx->pkgs_count++;
+
+		if (rpm_index_add_name(idx, pkg->name, idx->pkgs_count - 1) != 0) {
+			ret = -1;
+			break;
+		}
+	}
+	match = rpmdbFreeIterator(match);
+
+	RPM_MUTEX_UNLOCK(&g_rpm->mutex);
+
+	if (ret != 0 || idx->root == NULL) {
+		dE("Failed to index the installed packages.");
+		rpm_index_clear(idx);
+		return -1;
+	}
+	idx->built = true;
+	dI("Indexed %zu installed packages.", idx->pkgs_count);
+
+	return 0;
+}
+
+void rpm_index_ref(void)
+{
+	pthread_mutex_lock(&g_rpm_index.ref_mutex);
+	g_rpm_index.refs++;
+	pthread_mutex_unlock(&g_rpm_index.ref_mutex);
+}
+
+void rpm_index_unref(void)
+{
+	pthread_mutex_lock(&g_rpm_index.ref_mutex);
+	if (g_rpm_index.refs > 0 && --g_rpm_index.refs == 0) {
+		pthread_rwlock_wrlock(&g_rpm_index.lock);
+		rpm_index_clear(&g_rpm_index);
+		pthread_rwlock_unlock(&g_rpm_index.lock);
+	}
+	pthread_mutex_unlock(&g_rpm_index.ref_mutex);
+}
+
+void rpm_index_invalidate(void)
+{
+	pthread_mutex_lock(&g_rpm_index.check_mutex);
+	g_rpm_index.stale = true;
+	pthread_mutex_unlock(&g_rpm_index.check_mutex);
+}
+
+int rpm_index_acquire(struct rpm_probe_global *g_rpm)
+{
+	struct rpm_index *idx = &g_rpm_index;
+	int ret = 0;
+
+	pthread_rwlock_rdlock(&idx->lock);
+	if (rpm_index_is_current(idx, g_rpm))
+		return 0;
+	pthread_rwlock_unlock(&idx->lock);
+
+	pthread_rwlock_wrlock(&idx->lock);
+	/* another probe thread may have rebuilt it meanwhile */
+	if (!rpm_index_is_current(idx, g_rpm))
+		ret = rpm_index_build(idx, g_rpm);
+	pthread_rwlock_unlock(&idx->lock);
+	if (ret != 0)
+		return -1;
+
+	pthread_rwlock_rdlock(&idx->lock);
+	if (!idx->built) {
+		pthread_rwlock_unlock(&idx->lock);
+		return -1;
+	}
+
+	return 0;
+}
+
+void rpm_index_release(void)
+{
+	pthread_rwlock_unlock(&g_rpm_index.lock);
+}
+
+static int rpm_index_pkg_cmp(const void *a, const void *b)
+{
+	const struct rpm_index_pkg *pa = *(const struct rpm_index_pkg **) a;
+	const struct rpm_index_pkg *pb = *(const struct rpm_index_pkg **) b;
+
+	return (pa > pb) - (pa < pb);
+}
+
+int rpm_index_match(oval_operation_t op, const char *name, struct rpm_index_pkg ***pkgs)
+{
+	struct rpm_index *idx = &g_rpm_index;
+	struct rpm_index_name *entry;
+	struct oscap_htable_iterator *hit;
+	regex_t name_regex;
+	size_t count = 0;
+
+	*pkgs = NULL;
+	switch (op) {
+	case OVAL_OPERATION_EQUALS:
+		entry = oscap_htable_get(idx->names, name);
+		if (entry == NULL)
+			return 0;
+		*pkgs = malloc(sizeof(struct rpm_index_pkg *) * entry->count);
+		if (*pkgs == NULL)
+			return -1;
+		for (size_t i = 0; i < entry->count; i++)
+			(*pkgs)[count++] = &idx->pkgs[entry->pkgs[i]];
+		break;
+	case OVAL_OPERATION_PATTERN_MATCH:
+		/* the same as RPMMIRE_REGEX of the rpmdb iterators */
+		if (regcomp(&name_regex, name, REG_EXTENDED | REG_NOSUB) != 0)
+			return -1;
+		if (idx->pkgs_count == 0) {
+			regfree(&name_regex);
+			return 0;
+		}
+		*pkgs = malloc(sizeof(struct rpm_index_pkg *) * idx->pkgs_count);
+		if (*pkgs == NULL) {
+			regfree(&name_regex);
+			return -1;
+		}
+		hit = oscap_htable_iterator_new(idx->names);
+		while (oscap_htable_iterator_has_more(hit)) {
+			const char *key;
+
+			oscap_htable_iterator_next_kv(hit, &key, (void **) &entry);
+			if (entry == NULL || regexec(&name_regex, key, 0, NULL, 0) != 0)
+				continue;
+			for (size_t i = 0; i < entry->count; i++)
+				(*pkgs)[count++] = &idx->pkgs[entry->pkgs[i]];
+		}
+		oscap_htable_iterator_free(hit);
+		regfree(&name_regex);
+		qsort(*pkgs, count, sizeof(struct rpm_index_pkg *), rpm_index_pkg_cmp);
+		break;
+	default:
+		/* all the packages, the names are compared by the caller */
+		if (idx->pkgs_count == 0)
+			return 0;
+		*pkgs = malloc(sizeof(struct rpm_index_pkg *) * idx->pkgs_count);
+		if (*pkgs == NULL)
+			return -1;
+		for (size_t i = 0; i < idx->pkgs_count; i++)
+			(*pkgs)[count++] = &idx->pkgs[i];
+	}
+
+	return (int) count;
+}
+
+void rpm_index_header_lock(void)
+{
+	pthread_mutex_lock(&g_rpm_index.header_mutex);
+}
+
+void rpm_index_header_unlock(void)
+{
+	pthread_mutex_unlock(&g_rpm_index.header_mutex);
+}
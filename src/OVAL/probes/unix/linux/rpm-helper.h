@@ -34,6 +34,7 @@
 #include <rpm/header.h>
 
 #include <pthread.h>
+#include <oval_definitions.h>
 #include "common/util.h"
 #include "common/debug_priv.h"
 #include "pthread.h"
@@ -93,6 +94,58 @@ int rpmVerifyFile(const rpmts ts, const rpmfi fi,
                 rpmVerifyAttrs * res, rpmVerifyAttrs omitMask);
 #endif
 
+/**
+ * Installed package from the index shared by the rpm probes
+ */
+struct rpm_index_pkg {
+	Header h;   /**< the header, see rpm_index_header_lock() */
+	char *name; /**< package name */
+};
+
+/**
+ * Take a reference of the package index shared by all the rpm probes
+ * of the process. Called from the probe init functions, the index
+ * is freed when the last probe releases it by rpm_index_unref().
+ */
+void rpm_index_ref(void);
+void rpm_index_unref(void);
+
+/**
+ * Read-lock the package index, build it first by reading the rpmdb
+ * of g_rpm->rpmts if it is not built yet or if the rpmdb or the root
+ * directory have changed since. Must not be called with g_rpm->mutex
+ * held. Every successful call must be paired with rpm_index_release().
+ * @return 0 on success, -1 on failure
+ */
+int rpm_index_acquire(struct rpm_probe_global *g_rpm);
+void rpm_index_release(void);
+
+/**
+ * Rebuild the package index on the next rpm_index_acquire() whatever
+ * the rpmdb files look like, e.g. after a remediation fix which may have
+ * installed or removed packages within the recheck interval.
+ */
+void rpm_index_invalidate(void);
+
+/**
+ * Find the packages whose name matches. OVAL_OPERATION_EQUALS and
+ * OVAL_OPERATION_PATTERN_MATCH are evaluated, all the packages are
+ * returned for any other operation. The packages are in the rpmdb
+ * order and belong to the index.
+ * @param pkgs allocated array of the matching packages, free it with free()
+ * @return number of packages in *pkgs or -1 on failure
+ */
+int rpm_index_match(oval_operation_t op, const char *name, struct rpm_index_pkg ***pkgs);
+
+/**
+ * The headers of the index are shared by the probe threads, they have
+ * to be accessed with this lock held only. Files of a package should
+ * be read by rpmfiNew() with RPMFI_NOHEADER, the returned rpmfi can
+ * then be used without the lock.
+ */
+void rpm_index_header_lock(void);
+void rpm_index_header_unlock(void);
+
 /**
  * Preload libraries required by rpm
  * It destroy error callback!
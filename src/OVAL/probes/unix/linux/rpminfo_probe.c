@@ -57,6 +57,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <stdlib.h>
 #include <regex.h>
 
 /* RPM headers */
@@ -69,6 +70,7 @@
 #include <probe/option.h>
 #include "probe/entcmp.h"
 #include "common/debug_priv.h"
+#include "oval_deadline.h"
 #include "rpminfo_probe.h"
 
 
@@ -88,9 +90,14 @@ struct rpminfo_rep {
 	char extended_name[1024];
 };
 
-#define RPMINFO_LOCK	RPM_MUTEX_LOCK(&g_rpm->mutex)
+struct rpminfo_global {
+	struct rpm_probe_global rpm;
+	regex_t keyid_regex;
+};
 
-#define RPMINFO_UNLOCK	RPM_MUTEX_UNLOCK(&g_rpm->mutex)
+#define RPMINFO_LOCK	RPM_MUTEX_LOCK(&g_rpm->rpm.mutex)
+
+#define RPMINFO_UNLOCK	RPM_MUTEX_UNLOCK(&g_rpm->rpm.mutex)
 
 static const char g_keyid_regex_string[] = "Key ID [a-fA-F0-9]{16}";
 
@@ -162,124 +169,31 @@ static void pkgh2rep(Header h, struct rpminfo_rep *r, regex_t *keyid_regex)
 
 /*
  * req - Structure containing the name of the package.
- * rep - Pointer to rpminfo_rep structure pointer. An
- *       array of rpminfo_rep structures will be allocated
- *       here.
+ * rep - Pointer to an array of package pointers which will be
+ *       allocated here. The packages belong to the shared index
+ *       of the installed packages, see rpm_index_acquire().
  *
  * The return value on error is -1. Otherwise the number of
- * rpminfo_rep structures allocated in *rep is returned.
+ * packages in *rep is returned.
  */
-static int get_rpminfo(struct rpminfo_req *req, struct rpminfo_rep **rep, struct rpm_probe_global *g_rpm)
+static int get_rpminfo(struct rpminfo_req *req, struct rpm_index_pkg ***rep)
 {
-	rpmdbMatchIterator match;
-	Header pkgh;
-	int ret = 0, i;
-	regex_t keyid_regex;
-
-	if (regcomp(&keyid_regex, g_keyid_regex_string, REG_EXTENDED) != 0) {
-		dE("regcomp(%s) failed.", g_keyid_regex_string);
+	switch (req->op) {
+	case OVAL_OPERATION_EQUALS:
+	case OVAL_OPERATION_NOT_EQUAL:
+	case OVAL_OPERATION_PATTERN_MATCH:
+		return rpm_index_match(req->op, req->name, rep);
+	default:
+		/* not supported */
 		return -1;
 	}
-
-        RPMINFO_LOCK;
-
-        ret = -1;
-
-        switch (req->op) {
-        case OVAL_OPERATION_EQUALS:
-		match = rpmtsInitIterator(g_rpm->rpmts, RPMTAG_NAME, (const void *)req->name, 0);
-
-                if (match == NULL) {
-                        ret = 0;
-                        goto ret;
-                }
-
-                ret = rpmdbGetIteratorCount (match);
-
-                break;
-	case OVAL_OPERATION_NOT_EQUAL:
-		match = rpmtsInitIterator(g_rpm->rpmts, RPMDBI_PACKAGES, NULL, 0);
-                if (match == NULL) {
-                        ret = 0;
-                        goto ret;
-                }
-
-                if (rpmdbSetIteratorRE (match, RPMTAG_NAME, RPMMIRE_GLOB, "*") != 0)
-                {
-                        ret = -1;
-                        goto ret;
-                }
-
-                break;
-        case OVAL_OPERATION_PATTERN_MATCH:
-		match = rpmtsInitIterator(g_rpm->rpmts, RPMDBI_PACKAGES, NULL, 0);
-
-                if (match == NULL) {
-                        ret = 0;
-                        goto ret;
-                }
-
-                if (rpmdbSetIteratorRE (match, RPMTAG_NAME, RPMMIRE_REGEX,
-                                        (const char *)req->name) != 0)
-                {
-                        ret = -1;
-                        goto ret;
-                }
-
-                break;
-        default:
-                /* not supported */
-                ret = -1;
-                goto ret;
-        }
-
-        if (ret != -1) {
-                /*
-                 * We can allocate all memory needed now because we know the number
-                 * of results.
-                 */
-                void *new_rep = realloc (*rep, sizeof (struct rpminfo_rep) * ret);
-                if (new_rep == NULL) {
-                        ret = -2;
-                        goto ret;
-                }
-                (*rep) = new_rep;
-                for (i = 0; i < ret; ++i) {
-                        pkgh = rpmdbNextIterator (match);
-
-                        if (pkgh != NULL)
-			pkgh2rep(pkgh, (*rep) + i, &keyid_regex);
-                        else {
-                                /* XXX: emit warning */
-                                memset((*rep) + i, 0, sizeof(struct rpminfo_rep));
-                                break;
-                        }
-                }
-        } else {
-                ret = 0;
-
-                while ((pkgh = rpmdbNextIterator (match)) != NULL) {
-                        void *new_rep = realloc (*rep, sizeof (struct rpminfo_rep) * ++ret);
-                        if (new_rep == NULL) {
-                                ret = -2;
-                                goto ret;
-                        }
-                        (*rep) = new_rep;
-                        pkgh2rep(pkgh, (*rep) + (ret - 1), &keyid_regex);
-                }
-        }
-
-	match = rpmdbFreeIterator (match);
-ret:
-        RPMINFO_UNLOCK;
-
-	regfree(&keyid_regex);
-        return (ret);
 }
 
+const char *const rpminfo_probe_multival_entities[] = { "name", NULL };
+
 int rpminfo_probe_offline_mode_supported()
 {
-	return PROBE_OFFLINE_CHROOT;
+	return PROBE_OFFLINE_OWN;
 }
 
 void *rpminfo_probe_init(void)
@@ -287,10 +201,16 @@ void *rpminfo_probe_init(void)
 #ifdef RPM46_FOUND
 	rpmlogSetCallback(rpmErrorCb, NULL);
 #endif
-	struct rpm_probe_global *g_rpm = malloc(sizeof(struct rpm_probe_global));
+	struct rpminfo_global *g_rpm = calloc(1, sizeof(struct rpminfo_global));
+	if (regcomp(&g_rpm->keyid_regex, g_keyid_regex_string, REG_EXTENDED) != 0) {
+		dE("regcomp(%s) failed.", g_keyid_regex_string);
+		g_rpm->rpm.rpmts = NULL;
+		return ((void *)g_rpm);
+	}
 	if (rpmReadConfigFiles ((const char *)NULL, (const char *)NULL) != 0) {
 		dD("rpmReadConfigFiles failed: %u, %s.", errno, strerror (errno));
-		g_rpm->rpmts = NULL;
+		regfree(&g_rpm->keyid_regex);
+		g_rpm->rpm.rpmts = NULL;
 		return ((void *)g_rpm);
         }
 
@@ -305,15 +225,17 @@ void *rpminfo_probe_init(void)
         */
         rpmPushMacro(NULL, "_dbpath", NULL, "/var/lib/rpm", RMIL_CMDLINE);
 
-	g_rpm->rpmts = rpmtsCreate();
-	pthread_mutex_init (&(g_rpm->mutex), NULL);
+	g_rpm->rpm.rpmts = rpmtsCreate();
+	pthread_mutex_init (&(g_rpm->rpm.mutex), NULL);
+	/* the index is built by the first query, see rpm_index_acquire */
+	rpm_index_ref();
 
 	return ((void *)g_rpm);
 }
 
 void rpminfo_probe_fini (void *ptr)
 {
-        struct rpm_probe_global *r = (struct rpm_probe_global *)ptr;
+        struct rpminfo_global *r = (struct rpminfo_global *)ptr;
 
 	rpmFreeCrypto();
 	rpmFreeRpmrc();
@@ -324,181 +246,76 @@ void rpminfo_probe_fini (void *ptr)
 		return;
 
 
-	if (r->rpmts == NULL)
+	if (r->rpm.rpmts == NULL)
 		return;
 
-        rpmtsFree(r->rpmts);
-        pthread_mutex_destroy (&(r->mutex));
+	rpm_index_unref();
+	regfree(&r->keyid_regex);
+        rpmtsFree(r->rpm.rpmts);
+        pthread_mutex_destroy (&(r->rpm.mutex));
 
 	free(r);
         return;
 }
 
-static int collect_rpm_files(SEXP_t *item, const struct rpminfo_rep *rep, struct rpm_probe_global *g_rpm)
+static int collect_rpm_files(SEXP_t *item, const struct rpm_index_pkg *pkg, struct rpminfo_global *g_rpm)
 {
-	SEXP_t *value;
-	rpmdbMatchIterator ts;
-	Header pkgh;
 	rpmfi fi;
 	rpmTag tag[2] = { RPMTAG_BASENAMES, RPMTAG_DIRNAMES };
-	int i, ret = 0;
+	SEXP_t *value;
+	int i;
 
-	ts = rpmtsInitIterator(g_rpm->rpmts, RPMDBI_PACKAGES, NULL, 0);
-	if (ts == NULL) {
-		return -1;
-	}
+	RPMINFO_LOCK;
 
-	if (rpmdbSetIteratorRE(ts, RPMTAG_NAME, RPMMIRE_STRCMP, rep->name) != 0) {
-		ret = -1;
-		goto cleanup;
-	}
-	char *epoch_override = oscap_streq(rep->epoch, "(none)") ? "0" : rep->epoch;
-	if (rpmdbSetIteratorRE(ts, RPMTAG_EPOCH, RPMMIRE_STRCMP, epoch_override) != 0) {
-		ret = -1;
-		goto cleanup;
-	}
-	if (rpmdbSetIteratorRE(ts, RPMTAG_VERSION, RPMMIRE_STRCMP, rep->version) != 0) {
-		ret = -1;
-		goto cleanup;
-	}
-	if (rpmdbSetIteratorRE(ts, RPMTAG_RELEASE, RPMMIRE_STRCMP, rep->release) != 0) {
-		ret = -1;
-		goto cleanup;
-	}
-	if (rpmdbSetIteratorRE(ts, RPMTAG_ARCH, RPMMIRE_STRCMP, rep->arch) != 0) {
-		ret = -1;
-		goto cleanup;
-	}
+	/*
+	 * Inspect package files & directories
+	 */
+	for (i = 0; i < 2; ++i) {
+		rpm_index_header_lock();
+		fi = rpmfiNew(g_rpm->rpm.rpmts, pkg->h, tag[i], 1);
+		rpm_index_header_unlock();
 
-	while ((pkgh = rpmdbNextIterator(ts)) != NULL) {
-		/*
-		 * Inspect package files & directories
-		 */
-		for (i = 0; i < 2; ++i) {
-			fi = rpmfiNew(g_rpm->rpmts, pkgh, tag[i], 1);
-
-			while (rpmfiNext(fi) != -1) {
-				const char *filepath;
-				filepath = rpmfiFN(fi);
-				value = probe_entval_from_cstr(
-						OVAL_DATATYPE_STRING,
-						filepath,
-						strlen(filepath)
-						);
-				if (value != NULL) {
-					probe_item_ent_add(item, "filepath", NULL, value);
-					SEXP_free(value);
-				}
+		while (rpmfiNext(fi) != -1) {
+			const char *filepath = rpmfiFN(fi);
+
+			value = probe_entval_from_cstr(
+					OVAL_DATATYPE_STRING,
+					filepath,
+					strlen(filepath)
+					);
+			if (value != NULL) {
+				probe_item_ent_add(item, "filepath", NULL, value);
+				SEXP_free(value);
 			}
-			rpmfiFree(fi);
 		}
-
+		rpmfiFree(fi);
 	}
-cleanup:
-	ts = rpmdbFreeIterator(ts);
-	return ret;
+
+	RPMINFO_UNLOCK;
+
+	return 0;
 }
 
-int rpminfo_probe_main(probe_ctx *ctx, void *arg)
+/* look up the packages named by request_st->name and collect those that match ent */
+static int rpminfo_probe_collect(probe_ctx *ctx, struct rpminfo_global *g_rpm, SEXP_t *probe_in,
+				 oval_schema_version_t over, SEXP_t *ent, struct rpminfo_req *request_st)
 {
-	SEXP_t *val, *item, *ent, *probe_in;
-	oval_schema_version_t over;
+	SEXP_t *item;
 	int rpmret, i;
-
-        struct rpminfo_req request_st;
-        struct rpminfo_rep *reply_st;
-
-	// arg is NULL if regex compilation failed
-	if (arg == NULL) {
-		return PROBE_EINIT;
-	}
-
-	struct rpm_probe_global *g_rpm = (struct rpm_probe_global *)arg;
-
-	// There was no rpm config files
-	if (g_rpm->rpmts == NULL) {
-		probe_cobj_set_flag(probe_ctx_getresult(ctx), SYSCHAR_FLAG_NOT_APPLICABLE);
-		return 0;
-	}
-
-	if (ctx->offline_mode & PROBE_OFFLINE_OWN) {
-		const char* root = getenv("OSCAP_PROBE_ROOT");
-		rpmtsSetRootDir(g_rpm->rpmts, root);
-	}
-
-	probe_in = probe_ctx_getobject(ctx);
-	if (probe_in == NULL)
-		return PROBE_ENOOBJ;
-
-	over = probe_obj_get_platform_schema_version(probe_in);
-
-        ent = probe_obj_getent (probe_in, "name", 1);
-
-        if (ent == NULL) {
-                return (PROBE_ENOENT);
-        }
-
-        val = probe_ent_getval (ent);
-
-        if (val == NULL) {
-                dD("%s: no value", "name");
-                SEXP_free (ent);
-                return (PROBE_ENOVAL);
-        }
-
-        request_st.name = SEXP_string_cstr (val);
-        SEXP_free (val);
-
-        val = probe_ent_getattrval (ent, "operation");
-
-        if (val == NULL) {
-                request_st.op = OVAL_OPERATION_EQUALS;
-        } else {
-                request_st.op = (oval_operation_t) SEXP_number_geti_32 (val);
-
-                switch (request_st.op) {
-                case OVAL_OPERATION_EQUALS:
-		case OVAL_OPERATION_NOT_EQUAL:
-                case OVAL_OPERATION_PATTERN_MATCH:
-                        break;
-                default:
-                        SEXP_free (val);
-                        SEXP_free (ent);
-                        free (request_st.name);
-                        return (PROBE_EOPNOTSUPP);
-                }
-
-                SEXP_free (val);
-        }
-
-        if (request_st.name == NULL) {
-		SEXP_free (ent);
-                switch (errno) {
-                case EINVAL:
-                        dD("%s: invalid value type", "name");
-			return PROBE_EINVAL;
-                        break;
-                case EFAULT:
-                        dD("%s: element not found", "name");
-			return PROBE_ENOELM;
-                        break;
-		default:
-			return PROBE_EUNKNOWN;
-                }
-        }
+        struct rpm_index_pkg **reply_st;
 
         reply_st  = NULL;
 
-        /* get info from RPM db */
-	switch (rpmret = get_rpminfo(&request_st, &reply_st, g_rpm)) {
+        /* get info from the index of the RPM db */
+	switch (rpmret = get_rpminfo(request_st, &reply_st)) {
         case 0: /* Not found */
-                dI("Package \"%s\" not found.", request_st.name);
+                dI("Package \"%s\" not found.", request_st->name);
                 break;
         case -1: /* Error */
                 dD("get_rpminfo failed");
 
                 item = probe_item_create(OVAL_LINUX_RPM_INFO, NULL,
-                                         "name", OVAL_DATATYPE_STRING, request_st.name,
+                                         "name", OVAL_DATATYPE_STRING, request_st->name,
                                          NULL);
 
                 probe_item_setstatus (item, SYSCHAR_STATUS_ERROR);
@@ -510,22 +327,54 @@ int rpminfo_probe_main(probe_ctx *ctx, void *arg)
                 {
                         SEXP_t *name;
 
-                        for (i = 0; i < rpmret; ++i) {
-				name = SEXP_string_newf("%s", reply_st[i].name);
+                        for (i = 0; i < rpmret && !oval_deadline_expired(); ++i) {
+				struct rpminfo_rep reply;
+				struct rpminfo_rep *rep = &reply;
+
+				name = SEXP_string_newf("%s", reply_st[i]->name);
 
 				if (probe_entobj_cmp(ent, name) != OVAL_RESULT_TRUE) {
 					SEXP_free(name);
 					continue;
 				}
 
+				rpm_index_header_lock();
+				pkgh2rep(reply_st[i]->h, rep, &g_rpm->keyid_regex);
+				rpm_index_header_unlock();
+
+				/* the filters are decided before the files of the package are read */
+				if (probe_filters_active(ctx)) {
+					probe_field_t fields[] = {
+						{ "name",    OVAL_DATATYPE_STRING, .value.str = reply_st[i]->name },
+						{ "arch",    OVAL_DATATYPE_STRING, .value.str = rep->arch },
+						{ "epoch",   OVAL_DATATYPE_STRING, .value.str = rep->epoch },
+						{ "release", OVAL_DATATYPE_STRING, .value.str = rep->release },
+						{ "version", OVAL_DATATYPE_STRING, .value.str = rep->version },
+						{ "evr",     OVAL_DATATYPE_EVR_STRING, .value.str = rep->evr },
+						{ "signature_keyid", OVAL_DATATYPE_STRING, .value.str = rep->signature_keyid },
+						{ "extended_name", OVAL_DATATYPE_STRING, .value.str = rep->extended_name },
+					};
+					size_t count = sizeof(fields) / sizeof(fields[0]);
+
+					/* extended_name is in the items since OVAL 5.10 */
+					if (oval_schema_version_cmp(over, OVAL_SCHEMA_VERSION(5.10)) < 0)
+						--count;
+
+					if (probe_filters_reject(ctx, fields, count)) {
+						SEXP_free(name);
+						__rpminfo_rep_free(rep);
+						continue;
+					}
+				}
+
                                 item = probe_item_create(OVAL_LINUX_RPM_INFO, NULL,
                                                          "name",    OVAL_DATATYPE_SEXP, name,
-                                                         "arch",    OVAL_DATATYPE_STRING, reply_st[i].arch,
-                                                         "epoch",   OVAL_DATATYPE_STRING, reply_st[i].epoch,
-                                                         "release", OVAL_DATATYPE_STRING, reply_st[i].release,
-                                                         "version", OVAL_DATATYPE_STRING, reply_st[i].version,
-                                                         "evr",     OVAL_DATATYPE_EVR_STRING, reply_st[i].evr,
-                                                         "signature_keyid", OVAL_DATATYPE_STRING, reply_st[i].signature_keyid,
+                                                         "arch",    OVAL_DATATYPE_STRING, rep->arch,
+                                                         "epoch",   OVAL_DATATYPE_STRING, rep->epoch,
+                                                         "release", OVAL_DATATYPE_STRING, rep->release,
+                                                         "version", OVAL_DATATYPE_STRING, rep->version,
+                                                         "evr",     OVAL_DATATYPE_EVR_STRING, rep->evr,
+                                                         "signature_keyid", OVAL_DATATYPE_STRING, rep->signature_keyid,
                                                          NULL);
 
 				/* OVAL 5.10 added extended_name and filepaths behavior */
@@ -533,8 +382,8 @@ int rpminfo_probe_main(probe_ctx *ctx, void *arg)
 					SEXP_t *value, *bh_value;
 					value = probe_entval_from_cstr(
 							OVAL_DATATYPE_STRING,
-							reply_st[i].extended_name,
-							strlen(reply_st[i].extended_name)
+							rep->extended_name,
+							strlen(rep->extended_name)
 					);
 					probe_item_ent_add(item, "extended_name", NULL, value);
 					SEXP_free(value);
@@ -548,7 +397,7 @@ int rpminfo_probe_main(probe_ctx *ctx, void *arg)
 						if (bh_value != NULL) {
 							if (SEXP_strcmp(bh_value, "true") == 0) {
 								/* collect package files */
-								collect_rpm_files(item, &reply_st[i], g_rpm);
+								collect_rpm_files(item, reply_st[i], g_rpm);
 
 							}
 							SEXP_free(bh_value);
@@ -560,10 +409,10 @@ int rpminfo_probe_main(probe_ctx *ctx, void *arg)
 
 
 				SEXP_free(name);
-                                __rpminfo_rep_free (&(reply_st[i]));
+				__rpminfo_rep_free(rep);
 
 				if (probe_item_collect(ctx, item) < 0) {
-					SEXP_free(ent);
+					free(reply_st);
 					return PROBE_EUNKNOWN;
 				}
                         }
@@ -572,8 +421,118 @@ int rpminfo_probe_main(probe_ctx *ctx, void *arg)
                 }
         }
 
+	return 0;
+}
+
+int rpminfo_probe_main(probe_ctx *ctx, void *arg)
+{
+	SEXP_t *val, *ent, *probe_in;
+	oval_schema_version_t over;
+	int ret, i, val_cnt;
+
+        struct rpminfo_req request_st;
+
+	// arg is NULL if regex compilation failed
+	if (arg == NULL) {
+		return PROBE_EINIT;
+	}
+
+	struct rpminfo_global *g_rpm = (struct rpminfo_global *)arg;
+
+	// There was no rpm config files
+	if (g_rpm->rpm.rpmts == NULL) {
+		probe_cobj_set_flag(probe_ctx_getresult(ctx), SYSCHAR_FLAG_NOT_APPLICABLE);
+		return 0;
+	}
+
+	if (ctx->offline_mode & PROBE_OFFLINE_OWN) {
+		const char* root = getenv("OSCAP_PROBE_ROOT");
+		RPMINFO_LOCK;
+		// plugins of the scanned system must not be loaded
+		DISABLE_PLUGINS(g_rpm->rpm.rpmts);
+		rpmtsSetRootDir(g_rpm->rpm.rpmts, root);
+		RPMINFO_UNLOCK;
+	}
+
+	probe_in = probe_ctx_getobject(ctx);
+	if (probe_in == NULL)
+		return PROBE_ENOOBJ;
+
+	over = probe_obj_get_platform_schema_version(probe_in);
+
+        ent = probe_obj_getent (probe_in, "name", 1);
+
+        if (ent == NULL) {
+                return (PROBE_ENOENT);
+        }
+
+        val = probe_ent_getattrval (ent, "operation");
+
+        if (val == NULL) {
+                request_st.op = OVAL_OPERATION_EQUALS;
+        } else {
+                request_st.op = (oval_operation_t) SEXP_number_geti_32 (val);
+
+                switch (request_st.op) {
+                case OVAL_OPERATION_EQUALS:
+		case OVAL_OPERATION_NOT_EQUAL:
+                case OVAL_OPERATION_PATTERN_MATCH:
+                        break;
+                default:
+                        SEXP_free (val);
+                        SEXP_free (ent);
+                        return (PROBE_EOPNOTSUPP);
+                }
+
+                SEXP_free (val);
+        }
+
+	if (rpm_index_acquire(&g_rpm->rpm) != 0) {
+		SEXP_free(ent);
+		return PROBE_EUNKNOWN;
+	}
+
+	/* all values of a name which references a variable are looked up in this call */
+	val_cnt = probe_ent_getvals(ent, NULL);
+	ret = 0;
+
+	for (i = 0; ret == 0 && (i == 0 || i < val_cnt); ++i) {
+		SEXP_t *sel = probe_ent_select_val(ent, i);
+
+		val = probe_ent_getval(sel);
+		SEXP_free(sel);
+
+		if (val == NULL) {
+			dD("%s: no value", "name");
+			ret = PROBE_ENOVAL;
+			break;
+		}
+
+		request_st.name = SEXP_string_cstr(val);
+		SEXP_free(val);
+
+		if (request_st.name == NULL) {
+			switch (errno) {
+			case EINVAL:
+				dD("%s: invalid value type", "name");
+				ret = PROBE_EINVAL;
+				break;
+			case EFAULT:
+				dD("%s: element not found", "name");
+				ret = PROBE_ENOELM;
+				break;
+			default:
+				ret = PROBE_EUNKNOWN;
+			}
+			break;
+		}
+
+		ret = rpminfo_probe_collect(ctx, g_rpm, probe_in, over, ent, &request_st);
+		free(request_st.name);
+	}
+
+	rpm_index_release();
 	SEXP_free(ent);
-        free(request_st.name);
 
-        return 0;
+        return ret;
 }
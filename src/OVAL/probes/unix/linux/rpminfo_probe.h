@@ -29,5 +29,6 @@ int rpminfo_probe_offline_mode_supported(void);
 void *rpminfo_probe_init(void);
 int rpminfo_probe_main(probe_ctx *ctx, void *arg);
 void rpminfo_probe_fini(void *arg);
+extern const char *const rpminfo_probe_multival_entities[];
 
 #endif /* OPENSCAP_RPMINFO_PROBE_H */
@@ -50,7 +50,9 @@
 /* SEAP */
 #include <probe-api.h>
 #include "debug_priv.h"
+#include "common/util.h"
 #include "probe/entcmp.h"
+#include "oval_deadline.h"
 
 #include <probe/probe.h>
 #include <probe/option.h>
@@ -80,9 +82,9 @@ static int rpmverify_collect(probe_ctx *ctx,
 		void (*callback)(probe_ctx *, struct rpmverify_res *),
 		struct rpm_probe_global *g_rpm)
 {
-	rpmdbMatchIterator match;
+	struct rpm_index_pkg **pkgs;
+	int pkgs_count;
         rpmVerifyAttrs omit = (rpmVerifyAttrs)(flags & RPMVERIFY_RPMATTRMASK);
-	Header pkgh;
         pcre *re = NULL;
 	int  ret = -1;
 
@@ -91,7 +93,7 @@ static int rpmverify_collect(probe_ctx *ctx,
                 const char *errmsg;
                 int erroff;
 
-                re = pcre_compile(file, PCRE_UTF8, &errmsg,  &erroff, NULL);
+                re = oscap_pcre_compile(file, PCRE_UTF8, &errmsg,  &erroff, NULL);
 
                 if (re == NULL) {
                         /* TODO */
@@ -99,71 +101,45 @@ static int rpmverify_collect(probe_ctx *ctx,
                 }
         }
 
-        RPMVERIFY_LOCK;
-
         switch (name_op) {
         case OVAL_OPERATION_EQUALS:
-		match = rpmtsInitIterator(g_rpm->rpmts, RPMTAG_NAME, (const void *)name, 0);
-
-                if (match == NULL) {
-                        ret = 0;
-                        goto ret;
-                }
-
-                ret = rpmdbGetIteratorCount (match);
-
-                break;
 	case OVAL_OPERATION_NOT_EQUAL:
-		match = rpmtsInitIterator(g_rpm->rpmts, RPMDBI_PACKAGES, NULL, 0);
-
-                if (match == NULL) {
-                        ret = 0;
-                        goto ret;
-                }
-
-                if (rpmdbSetIteratorRE (match, RPMTAG_NAME, RPMMIRE_GLOB, "*") != 0)
-                {
-                        ret = -1;
-                        goto ret;
-                }
-
-                break;
         case OVAL_OPERATION_PATTERN_MATCH:
-		match = rpmtsInitIterator(g_rpm->rpmts, RPMDBI_PACKAGES, NULL, 0);
-
-                if (match == NULL) {
-                        ret = 0;
-                        goto ret;
-                }
-
-                if (rpmdbSetIteratorRE (match, RPMTAG_NAME, RPMMIRE_REGEX,
-                                        (const char *)name) != 0)
-                {
-                        ret = -1;
-                        goto ret;
-                }
-
                 break;
         default:
                 /* not supported */
                 dE("package name: operation not supported");
-                ret = -1;
-                goto ret;
+                oscap_pcre_free(re, NULL);
+                return (-1);
         }
 
 	if (RPMTAG_BASENAMES == 0 || RPMTAG_DIRNAMES == 0) {
+		oscap_pcre_free(re, NULL);
 		return -1;
 	}
 
-        while ((pkgh = rpmdbNextIterator (match)) != NULL) {
+	if (rpm_index_acquire(g_rpm) != 0) {
+		oscap_pcre_free(re, NULL);
+		return (-1);
+	}
+
+	pkgs_count = rpm_index_match(name_op, name, &pkgs);
+	if (pkgs_count < 0) {
+		rpm_index_release();
+		oscap_pcre_free(re, NULL);
+		return (-1);
+	}
+
+	RPMVERIFY_LOCK;
+
+	for (size_t p = 0; p < (size_t) pkgs_count && !oval_deadline_expired(); p++) {
                 rpmfi  fi;
 		rpmTag tag[2] = { RPMTAG_BASENAMES, RPMTAG_DIRNAMES };
                 struct rpmverify_res res;
-                errmsg_t rpmerr;
 		int i;
 		SEXP_t *name_sexp;
 
-                res.name = headerFormat(pkgh, "%{NAME}", &rpmerr);
+                res.name = pkgs[p]->name;
 
 		name_sexp = SEXP_string_newf("%s", res.name);
 		if (probe_entobj_cmp(name_ent, name_sexp) != OVAL_RESULT_TRUE) {
@@ -176,7 +152,9 @@ static int rpmverify_collect(probe_ctx *ctx,
                  * Inspect package files & directories
                  */
 		for (i = 0; i < 2; ++i) {
-			fi = rpmfiNew(g_rpm->rpmts, pkgh, tag[i], 1);
+			rpm_index_header_lock();
+			fi = rpmfiNew(g_rpm->rpmts, pkgs[p]->h, tag[i], 1);
+			rpm_index_header_unlock();
 
 		  while (rpmfiNext(fi) != -1) {
 		    SEXP_t *filepath_sexp;
@@ -209,13 +187,12 @@ static int rpmverify_collect(probe_ctx *ctx,
 		}
 	}
 
-	match = rpmdbFreeIterator (match);
         ret   = 0;
-ret:
-        if (re != NULL)
-                pcre_free(re);
+        oscap_pcre_free(re, NULL);
 
         RPMVERIFY_UNLOCK;
+	free(pkgs);
+	rpm_index_release();
         return (ret);
 }
 
@@ -250,6 +227,7 @@ void *rpmverify_probe_init(void)
 	g_rpm->rpmts = rpmtsCreate();
 
 	pthread_mutex_init(&(g_rpm->mutex), NULL);
+	rpm_index_ref();
         return ((void *)g_rpm);
 }
 
@@ -266,6 +244,7 @@ void rpmverify_probe_fini(void *ptr)
 	if (r == NULL)
 		return;
 
+	rpm_index_unref();
 	rpmtsFree(r->rpmts);
 	pthread_mutex_destroy (&(r->mutex));
 	free(r);
@@ -322,6 +301,21 @@ const rpmverify_bhmap_t rpmverify_bhmap[] = {
         { "noghostfiles",  RPMVERIFY_SKIP_GHOST       }
 };
 
+/* item entities with the attributes they need verified */
+const rpmverify_bhmap_t rpmverify_entmap[] = {
+        { "size_differs",        (uint64_t)RPMVERIFY_FILESIZE },
+        { "mode_differs",        (uint64_t)RPMVERIFY_MODE     },
+        { "md5_differs",         (uint64_t)RPMVERIFY_MD5      },
+        { "device_differs",      (uint64_t)RPMVERIFY_RDEV     },
+        { "link_mismatch",       (uint64_t)RPMVERIFY_LINKTO   },
+        { "ownership_differs",   (uint64_t)RPMVERIFY_USER     },
+        { "group_differs",       (uint64_t)RPMVERIFY_GROUP    },
+        { "mtime_differs",       (uint64_t)RPMVERIFY_MTIME    },
+#ifndef HAVE_LIBRPM44
+        { "capabilities_differ", (uint64_t)RPMVERIFY_CAPS     },
+#endif
+};
+
 int rpmverify_probe_main(probe_ctx *ctx, void *arg)
 {
         SEXP_t *probe_in, *name_ent, *file_ent, *bh_ent;
@@ -406,6 +400,19 @@ int rpmverify_probe_main(probe_ctx *ctx, void *arg)
                 SEXP_free(bh_ent);
         }
 
+        /*
+         * Attributes no state, filter or variable looks at aren't verified,
+         * the file digest needs the whole file read.
+         */
+        uint64_t wanted_flags = 0, entity_flags = 0;
+
+        for (i = 0; i < sizeof rpmverify_entmap/sizeof(rpmverify_bhmap_t); ++i) {
+                entity_flags |= rpmverify_entmap[i].a_flag;
+                if (probe_obj_wants_itement(probe_in, rpmverify_entmap[i].a_name))
+                        wanted_flags |= rpmverify_entmap[i].a_flag;
+        }
+        collect_flags |= entity_flags & ~wanted_flags;
+
         dI("Collecting rpmverify data, query: n=\"%s\" (%d), f=\"%s\" (%d)",
            name, name_op, file, file_op);
 
@@ -41,14 +41,20 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
 #include <pcre.h>
 
 #include "rpm-helper.h"
 #include "oscap_helpers.h"
+#include "common/util.h"
 
 /* Individual RPM headers */
 #include <rpm/rpmfi.h>
 #include <rpm/rpmcli.h>
+#include <rpm/rpmpgp.h>
 
 /* SEAP */
 #include <probe-api.h>
@@ -57,7 +63,11 @@
 
 #include <probe/probe.h>
 #include <probe/option.h>
+#include "oval_digest_cache.h"
+#include "oval_realpath_cache.h"
+#include "oval_deadline.h"
 #include "rpmverifyfile_probe.h"
+#include "common/oscap_threadpool.h"
 
 struct rpmverify_res {
 	char *name;  /**< package name */
@@ -76,6 +86,66 @@ struct rpmverify_res {
 #define RPMVERIFY_SKIP_GHOST  0x2000000000000000
 #define RPMVERIFY_RPMATTRMASK 0x00000000ffffffff
 
+#ifndef RPMVERIFY_MAX_JOBS
+#define RPMVERIFY_MAX_JOBS 16
+#endif
+/* packages queued per verifying thread */
+#define RPMVERIFY_QUEUE_FACTOR 4
+
+/* verification result of one file of a package */
+struct rpmverify_file {
+	char *file;
+	rpmVerifyAttrs vflags;
+	rpmfileAttrs   fflags;
+};
+
+/* a package to verify, the res fields are those of the package */
+struct rpmverify_job {
+	Header pkgh;
+	struct rpmverify_res res;
+	struct rpmverify_file *files;
+	size_t files_count;
+	int ret;
+	bool done;
+};
+
+struct rpmverify_pool;
+
+struct rpmverify_worker {
+	struct rpmverify_pool *pool;
+	rpmts rpmts;
+	pthread_t thread;
+};
+
+/*
+ * Packages are verified by a pool of threads, each with its own rpmts,
+ * the items are collected by the probe thread in the order the packages
+ * were queued.
+ */
+struct rpmverify_pool {
+	struct rpm_probe_global *g_rpm;
+	const char *file;
+	oval_operation_t file_op;
+	uint64_t flags;
+
+	pthread_mutex_t lock;
+	pthread_cond_t work_cond;
+	pthread_cond_t done_cond;
+	bool stop;
+	bool failed;
+
+	struct rpmverify_job **queue;
+	size_t queue_size;
+	size_t queued;	/* counters of jobs ever queued, taken by a thread, */
+	size_t taken;	/* and turned into items; the slot of the job n is */
+	size_t emitted;	/* n % queue_size */
+
+	bool started;
+	size_t threads_max;
+	size_t threads_count;
+	struct rpmverify_worker workers[RPMVERIFY_MAX_JOBS];
+};
+
 /* In rmplib older than 4.7 some of the enum values aren't defined.
  * We need to provide fallback definitions.
  */
@@ -96,33 +166,17 @@ struct rpmverify_res {
 
 static int rpmverify_additem(probe_ctx *ctx, struct rpmverify_res *res);
 
-/* modify passed-in iterator to test also given entity */
-static int adjust_filter(rpmdbMatchIterator iterator, SEXP_t *ent, rpmTag rpm_tag) {
-	oval_operation_t ent_op;
-	char ent_str[1024];
-	int ret = 0;
-
-	if (ent) {
-		ent_op = probe_ent_getoperation(ent, OVAL_OPERATION_EQUALS);
-		PROBE_ENT_STRVAL(ent, ent_str, sizeof ent_str, /* void */, strcpy(ent_str, ""););
-
-		switch (ent_op) {
-		case OVAL_OPERATION_EQUALS:
-			if (rpmdbSetIteratorRE (iterator, rpm_tag, RPMMIRE_STRCMP, ent_str) != 0)
-				ret = -1;
-
-			break;
-		case OVAL_OPERATION_PATTERN_MATCH:
-			if (rpmdbSetIteratorRE (iterator, rpm_tag, RPMMIRE_REGEX,
-						(const char *)ent_str) != 0)
-				ret = -1;
+/* find the packages of the shared index matching the given name entity */
+static int match_name(SEXP_t *name_ent, struct rpm_index_pkg ***pkgs) {
+	oval_operation_t ent_op = OVAL_OPERATION_UNKNOWN;
+	char ent_str[1024] = "";
 
-			break;
-		default:
-			ret = 0;
-		}
+	if (name_ent) {
+		ent_op = probe_ent_getoperation(name_ent, OVAL_OPERATION_EQUALS);
+		PROBE_ENT_STRVAL(name_ent, ent_str, sizeof ent_str, /* void */, strcpy(ent_str, ""););
 	}
-	return ret;
+	/* unless it is equals or pattern match, the names are compared by the caller */
+	return rpm_index_match(ent_op, ent_str, pkgs);
 }
 
 /*
@@ -134,8 +188,8 @@ static int _compare_file_with_current_file(oval_operation_t file_op, const char
 {
 	int ret = 0;
 
-	char *file_realpath = oscap_realpath(file, NULL);
-	char *current_file_realpath = oscap_realpath(current_file, NULL);
+	char *file_realpath = oval_realpath_cache_resolve(file, NULL);
+	char *current_file_realpath = oval_realpath_cache_resolve(current_file, NULL);
 
 	if (file_op == OVAL_OPERATION_EQUALS) {
 		if (strcmp(current_file, file) != 0 &&
@@ -156,14 +210,14 @@ static int _compare_file_with_current_file(oval_operation_t file_op, const char
 	} else if (file_op == OVAL_OPERATION_PATTERN_MATCH) {
 		const char *errmsg;
 		int erroff;
-		pcre *re = pcre_compile(file, PCRE_UTF8, &errmsg,  &erroff, NULL);
+		pcre *re = oscap_pcre_compile(file, PCRE_UTF8, &errmsg,  &erroff, NULL);
 		if (re == NULL) {
 			dE("pcre_compile pattern='%s': %s", file, errmsg);
 			ret = -1;
 			goto cleanup;
 		}
 		int pcre_ret = pcre_exec(re, NULL, current_file, strlen(current_file), 0, 0, NULL, 0);
-		pcre_free(re);
+		oscap_pcre_free(re, NULL);
 		if (pcre_ret == 0) {
 			/* match */
 			*result_file = oscap_strdup(current_file);
@@ -190,25 +244,133 @@ cleanup:
 	return ret;
 }
 
-static int rpmverify_collect_package_files_or_directories(
-		struct rpm_probe_global *g_rpm, probe_ctx *ctx, Header pkgh,
-		const char *file, oval_operation_t file_op, rpmTag tag,
-		struct rpmverify_res *res, uint64_t flags)
+/*
+ * Verify the digest of a regular file through the digest cache, so rpm
+ * doesn't have to read the files which didn't change since the last scan.
+ * Returns 0 and sets differs if the digest was verified, -1 if rpm has to
+ * verify it itself.
+ */
+static int rpmverify_file_digest(rpmfi fi, bool *differs)
+{
+	const unsigned char *expected;
+	size_t expected_len;
+	int algo;
+	crapi_alg_t alg;
+	uint8_t digest[64];
+	size_t digest_len = sizeof(digest);
+	void *dst = digest;
+	size_t *size = &digest_len;
+	struct stat st;
+	int fd, ret;
+
+	/* files of an offline root are verified relative to it by rpm */
+	if (!oval_digest_cache_enabled() || getenv("OSCAP_PROBE_ROOT") != NULL)
+		return -1;
+	if (!S_ISREG(rpmfiFMode(fi)))
+		return -1;
+	expected = rpmfiFDigest(fi, &algo, &expected_len);
+	if (expected == NULL || expected_len > sizeof(digest))
+		return -1;
+
+	switch (algo) {
+#ifdef OPENSCAP_ENABLE_MD5
+	case PGPHASHALGO_MD5:
+		alg = CRAPI_DIGEST_MD5;
+		break;
+#endif
+#ifdef OPENSCAP_ENABLE_SHA1
+	case PGPHASHALGO_SHA1:
+		alg = CRAPI_DIGEST_SHA1;
+		break;
+#endif
+	case PGPHASHALGO_SHA224:
+		alg = CRAPI_DIGEST_SHA224;
+		break;
+	case PGPHASHALGO_SHA256:
+		alg = CRAPI_DIGEST_SHA256;
+		break;
+	case PGPHASHALGO_SHA384:
+		alg = CRAPI_DIGEST_SHA384;
+		break;
+	case PGPHASHALGO_SHA512:
+		alg = CRAPI_DIGEST_SHA512;
+		break;
+	default:
+		return -1;
+	}
+
+	fd = open(rpmfiFN(fi), O_RDONLY | O_NOFOLLOW);
+	if (fd == -1)
+		return -1;
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+		close(fd);
+		return -1;
+	}
+	ret = oval_digest_cache_fdv(fd, 1, &alg, &dst, &size);
+	close(fd);
+
+	if (ret != 0 || digest_len != expected_len)
+		return -1;
+	*differs = memcmp(digest, expected, expected_len) != 0;
+
+	return 0;
+}
+
+static void rpmverify_job_free(struct rpmverify_job *job)
+{
+	for (size_t i = 0; i < job->files_count; i++)
+		free(job->files[i].file);
+	free(job->files);
+	free(job->res.name);
+	free(job->res.epoch);
+	free(job->res.version);
+	free(job->res.release);
+	free(job->res.arch);
+	rpm_index_header_lock();
+	headerFree(job->pkgh);
+	rpm_index_header_unlock();
+	free(job);
+}
+
+static int rpmverify_job_add_file(struct rpmverify_job *job, char *file, rpmVerifyAttrs vflags, rpmfileAttrs fflags)
+{
+	struct rpmverify_file *files;
+
+	files = realloc(job->files, sizeof(struct rpmverify_file) * (job->files_count + 1));
+	if (files == NULL)
+		return -1;
+	job->files = files;
+	job->files[job->files_count].file = file;
+	job->files[job->files_count].vflags = vflags;
+	job->files[job->files_count].fflags = fflags;
+	job->files_count++;
+
+	return 0;
+}
+
+static int rpmverify_job_verify_files_or_directories(struct rpmverify_pool *pool,
+		struct rpmverify_job *job, rpmts ts, rpmTag tag)
 {
 	int ret = 0;
+	uint64_t flags = pool->flags;
 	rpmVerifyAttrs omit = (rpmVerifyAttrs)(flags & RPMVERIFY_RPMATTRMASK);
-	rpmfi fi = rpmfiNew(g_rpm->rpmts, pkgh, tag, 1);
+	rpmfi fi;
+
+	rpm_index_header_lock();
+	fi = rpmfiNew(ts, job->pkgh, tag, 1);
+	rpm_index_header_unlock();
 
 	while (rpmfiNext(fi) != -1) {
 		const char *current_file = rpmfiFN(fi);
-		res->fflags = rpmfiFFlags(fi);
-		res->oflags = omit;
+		rpmfileAttrs fflags = rpmfiFFlags(fi);
+		rpmVerifyAttrs vflags = 0;
+		char *result_file = NULL;
 
-		if (((res->fflags & RPMFILE_CONFIG) && (flags & RPMVERIFY_SKIP_CONFIG)) ||
-				((res->fflags & RPMFILE_GHOST)  && (flags & RPMVERIFY_SKIP_GHOST))) {
+		if (((fflags & RPMFILE_CONFIG) && (flags & RPMVERIFY_SKIP_CONFIG)) ||
+				((fflags & RPMFILE_GHOST)  && (flags & RPMVERIFY_SKIP_GHOST))) {
 			continue;
 		}
-		int cmp_res = _compare_file_with_current_file(file_op, file, current_file, &res->file);
+		int cmp_res = _compare_file_with_current_file(pool->file_op, pool->file, current_file, &result_file);
 		if (cmp_res == 1) {
 			/* no match */
 			continue;
@@ -218,16 +380,23 @@ static int rpmverify_collect_package_files_or_directories(
 			goto cleanup;
 		}
 
-		if (rpmVerifyFile(g_rpm->rpmts, fi, &res->vflags, omit) != 0) {
-			res->vflags = RPMVERIFY_FAILURES;
+		rpmVerifyAttrs file_omit = omit;
+		bool digest_differs = false;
+
+		if (!(omit & RPMVERIFY_FILEDIGEST) && rpmverify_file_digest(fi, &digest_differs) == 0)
+			file_omit |= RPMVERIFY_FILEDIGEST;
+
+		if (rpmVerifyFile(ts, fi, &vflags, file_omit) != 0) {
+			vflags = RPMVERIFY_FAILURES;
+		} else if (digest_differs) {
+			vflags |= RPMVERIFY_FILEDIGEST;
 		}
 
-		if (rpmverify_additem(ctx, res) != 0) {
+		if (rpmverify_job_add_file(job, result_file, vflags, fflags) != 0) {
+			free(result_file);
 			ret = -1;
-			free(res->file);
 			goto cleanup;
 		}
-		free(res->file);
 	}
 
 cleanup:
@@ -235,6 +404,238 @@ cleanup:
 	return ret;
 }
 
+/* verify the files of the package, runs without the pool lock */
+static void rpmverify_job_verify(struct rpmverify_pool *pool, struct rpmverify_job *job, rpmts ts)
+{
+	if (rpmverify_job_verify_files_or_directories(pool, job, ts, RPMTAG_BASENAMES) != 0 ||
+			rpmverify_job_verify_files_or_directories(pool, job, ts, RPMTAG_DIRNAMES) != 0) {
+		job->ret = -1;
+	}
+}
+
+static void *rpmverify_pool_thread(void *arg)
+{
+	struct rpmverify_worker *worker = arg;
+	struct rpmverify_pool *pool = worker->pool;
+	struct rpmverify_job *job;
+
+	pthread_mutex_lock(&pool->lock);
+	for (;;) {
+		while (!pool->stop && pool->taken == pool->queued)
+			pthread_cond_wait(&pool->work_cond, &pool->lock);
+		if (pool->taken == pool->queued)
+			break;
+
+		job = pool->queue[pool->taken++ % pool->queue_size];
+		pthread_mutex_unlock(&pool->lock);
+
+		rpmverify_job_verify(pool, job, worker->rpmts);
+
+		pthread_mutex_lock(&pool->lock);
+		job->done = true;
+		pthread_cond_broadcast(&pool->done_cond);
+	}
+	pthread_mutex_unlock(&pool->lock);
+
+	return NULL;
+}
+
+static size_t rpmverify_pool_jobs(void)
+{
+	return oscap_threadpool_jobs("OSCAP_RPMVERIFY_JOBS", 0, RPMVERIFY_MAX_JOBS);
+}
+
+static int rpmverify_pool_init(struct rpmverify_pool *pool, struct rpm_probe_global *g_rpm,
+		const char *file, oval_operation_t file_op, uint64_t flags)
+{
+	memset(pool, 0, sizeof(struct rpmverify_pool));
+	pool->g_rpm = g_rpm;
+	pool->file = file;
+	pool->file_op = file_op;
+	pool->flags = flags;
+	pool->threads_max = rpmverify_pool_jobs();
+	pool->queue_size = pool->threads_max * RPMVERIFY_QUEUE_FACTOR;
+	pool->queue = calloc(pool->queue_size, sizeof(struct rpmverify_job *));
+	if (pool->queue == NULL)
+		return -1;
+
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->work_cond, NULL);
+	pthread_cond_init(&pool->done_cond, NULL);
+
+	return 0;
+}
+
+/*
+ * The threads are started once there is more than one package to verify.
+ * Called with the pool lock and the probe mutex held.
+ */
+static void rpmverify_pool_start(struct rpmverify_pool *pool)
+{
+	const char *root = rpmtsRootDir(pool->g_rpm->rpmts);
+
+	pool->started = true;
+	if (pool->threads_max < 2)
+		return;
+
+	for (size_t i = 0; i < pool->threads_max; i++) {
+		struct rpmverify_worker *worker = &pool->workers[pool->threads_count];
+		int err;
+
+		worker->pool = pool;
+		worker->rpmts = rpmtsCreate();
+		if (root != NULL)
+			rpmtsSetRootDir(worker->rpmts, root);
+
+		err = pthread_create(&worker->thread, NULL, rpmverify_pool_thread, worker);
+		if (err != 0) {
+			dW("Can't start a verifying thread: %s.", strerror(err));
+			rpmtsFree(worker->rpmts);
+			break;
+		}
+		pool->threads_count++;
+	}
+}
+
+static void rpmverify_collect_job(struct rpmverify_pool *pool, struct rpmverify_job *job, probe_ctx *ctx)
+{
+	struct rpmverify_res *res = &job->res;
+
+	if (job->ret != 0) {
+		pool->failed = true;
+		return;
+	}
+
+	res->oflags = (rpmVerifyAttrs)(pool->flags & RPMVERIFY_RPMATTRMASK);
+	for (size_t i = 0; i < job->files_count && !pool->failed; i++) {
+		res->file = job->files[i].file;
+		res->vflags = job->files[i].vflags;
+		res->fflags = job->files[i].fflags;
+		if (rpmverify_additem(ctx, res) != 0)
+			pool->failed = true;
+	}
+	res->file = NULL;
+}
+
+/* wait for the oldest job and turn it into items, called with the lock held */
+static void rpmverify_pool_emit(struct rpmverify_pool *pool, probe_ctx *ctx)
+{
+	struct rpmverify_job *job = pool->queue[pool->emitted % pool->queue_size];
+
+	if (pool->threads_count == 0) {
+		/* no threads, verify in the probe thread */
+		pool->taken++;
+		pthread_mutex_unlock(&pool->lock);
+		rpmverify_job_verify(pool, job, pool->g_rpm->rpmts);
+	} else {
+		while (!job->done)
+			pthread_cond_wait(&pool->done_cond, &pool->lock);
+		pthread_mutex_unlock(&pool->lock);
+	}
+
+	if (!pool->failed)
+		rpmverify_collect_job(pool, job, ctx);
+	rpmverify_job_free(job);
+
+	pthread_mutex_lock(&pool->lock);
+	pool->queue[pool->emitted++ % pool->queue_size] = NULL;
+}
+
+static void rpmverify_pool_push(struct rpmverify_pool *pool, struct rpmverify_job *job, probe_ctx *ctx)
+{
+	pthread_mutex_lock(&pool->lock);
+	if (!pool->started && pool->queued > 0)
+		rpmverify_pool_start(pool);
+	while (pool->queued - pool->emitted == pool->queue_size)
+		rpmverify_pool_emit(pool, ctx);
+	pool->queue[pool->queued++ % pool->queue_size] = job;
+	pthread_cond_signal(&pool->work_cond);
+	pthread_mutex_unlock(&pool->lock);
+}
+
+/* returns -1 if verifying or collecting of any package failed */
+static int rpmverify_pool_finish(struct rpmverify_pool *pool, probe_ctx *ctx)
+{
+	pthread_mutex_lock(&pool->lock);
+	while (pool->emitted < pool->queued)
+		rpmverify_pool_emit(pool, ctx);
+	pool->stop = true;
+	pthread_cond_broadcast(&pool->work_cond);
+	pthread_mutex_unlock(&pool->lock);
+
+	for (size_t i = 0; i < pool->threads_count; i++) {
+		pthread_join(pool->workers[i].thread, NULL);
+		rpmtsFree(pool->workers[i].rpmts);
+	}
+
+	pthread_cond_destroy(&pool->done_cond);
+	pthread_cond_destroy(&pool->work_cond);
+	pthread_mutex_destroy(&pool->lock);
+	free(pool->queue);
+
+	return pool->failed ? -1 : 0;
+}
+
+/* queue the package for verification if it matches the object */
+static int rpmverify_collect_package(probe_ctx *ctx, struct rpmverify_pool *pool, Header pkgh,
+			     SEXP_t *name_ent, SEXP_t *epoch_ent, SEXP_t *version_ent, SEXP_t *release_ent, SEXP_t *arch_ent)
+{
+	SEXP_t *ent;
+	struct rpmverify_job *job;
+	struct rpmverify_res res;
+	errmsg_t rpmerr;
+
+	memset(&res, 0, sizeof(res));
+	rpm_index_header_lock();
+	res.name = headerFormat(pkgh, "%{NAME}", &rpmerr);
+	res.epoch = headerFormat(pkgh, "%{EPOCH}", &rpmerr);
+	res.version = headerFormat(pkgh, "%{VERSION}", &rpmerr);
+	res.release = headerFormat(pkgh, "%{RELEASE}", &rpmerr);
+	res.arch = headerFormat(pkgh, "%{ARCH}", &rpmerr);
+	rpm_index_header_unlock();
+
+#define COMPARE_ENT(XXX) \
+	if (XXX ## _ent != NULL) { \
+		ent = probe_entval_from_cstr( \
+			probe_ent_getdatatype(XXX ## _ent), res.XXX, strlen(res.XXX) \
+		); \
+		if (ent != NULL && probe_entobj_cmp(XXX ## _ent, ent) != OVAL_RESULT_TRUE) { \
+			SEXP_free(ent); \
+			goto skip; \
+		} \
+		SEXP_free(ent); \
+	}
+
+	COMPARE_ENT(name);
+	COMPARE_ENT(epoch);
+	COMPARE_ENT(version);
+	COMPARE_ENT(release);
+	COMPARE_ENT(arch);
+	snprintf(res.extended_name, 1024, "%s-%s:%s-%s.%s", res.name,
+		oscap_streq(res.epoch, "(none)") ? "0" : res.epoch,
+		res.version, res.release, res.arch);
+
+	job = calloc(1, sizeof(struct rpmverify_job));
+	if (job == NULL)
+		goto skip;
+	job->res = res;
+	/* the rpmdb iterator headers are valid only until their next iteration */
+	rpm_index_header_lock();
+	job->pkgh = headerLink(pkgh);
+	rpm_index_header_unlock();
+
+	rpmverify_pool_push(pool, job, ctx);
+	return pool->failed ? -1 : 0;
+
+skip:
+	free(res.name);
+	free(res.epoch);
+	free(res.version);
+	free(res.release);
+	free(res.arch);
+	return 0;
+}
+
 static int rpmverify_collect(probe_ctx *ctx,
 			     const char *file, oval_operation_t file_op,
 			     SEXP_t *name_ent, SEXP_t *epoch_ent, SEXP_t *version_ent, SEXP_t *release_ent, SEXP_t *arch_ent,
@@ -243,98 +644,59 @@ static int rpmverify_collect(probe_ctx *ctx,
 {
 	rpmdbMatchIterator match;
 	Header pkgh;
-	int  ret = -1;
+	struct rpm_index_pkg **pkgs;
+	struct rpmverify_pool pool;
+	int  pkgs_count, ret = -1;
 
-	RPMVERIFY_LOCK;
+	if (rpmverify_pool_init(&pool, g_rpm, file, file_op, flags) != 0)
+		return (-1);
 
 	if (file != NULL && file_op == OVAL_OPERATION_EQUALS) {
+		RPMVERIFY_LOCK;
+
 		/*
 		 * When we know the exact file path we look for, we don't need to
 		 * filter all RPM packages, but we can ask the rpmdb directly for
 		 * the package which provides this file, similar to `rpm -q -f`.
 		 */
 		match = rpmtsInitIterator(g_rpm->rpmts, RPMDBI_INSTFILENAMES, file, 0);
-	} else {
-		match = rpmtsInitIterator(g_rpm->rpmts, RPMDBI_PACKAGES, NULL, 0);
-	}
-	if (match == NULL) {
-		ret = 0;
-		goto ret;
-	}
-
-	if ((ret = adjust_filter(match, name_ent, RPMTAG_NAME)) == -1) {
-		dE("can't adjust filter with name");
-		goto ret;
-	}
-	if ((ret = adjust_filter(match, epoch_ent, RPMTAG_EPOCH)) == -1) {
-		dE("can't adjust filter with epoch");
-		goto ret;
-	}
-	if ((ret = adjust_filter(match, version_ent, RPMTAG_VERSION)) == -1) {
-		dE("can't adjust filter with version");
-		goto ret;
-	}
-	if ((ret = adjust_filter(match, release_ent, RPMTAG_RELEASE)) == -1) {
-		dE("can't adjust filter with version");
-		goto ret;
-	}
-	if ((ret = adjust_filter(match, arch_ent, RPMTAG_ARCH)) == -1) {
-		dE("can't adjust filter with version");
-		goto ret;
-	}
-
-	while ((pkgh = rpmdbNextIterator (match)) != NULL) {
-		SEXP_t *ent;
-		struct rpmverify_res res;
-		errmsg_t rpmerr;
-
-#define COMPARE_ENT(XXX) \
-		if (XXX ## _ent != NULL) { \
-			ent = probe_entval_from_cstr( \
-				probe_ent_getdatatype(XXX ## _ent), res.XXX, strlen(res.XXX) \
-			); \
-			if (ent != NULL && probe_entobj_cmp(XXX ## _ent, ent) != OVAL_RESULT_TRUE) { \
-				SEXP_free(ent); \
-				continue; \
-			} \
-			SEXP_free(ent); \
+		while (match != NULL && !oval_deadline_expired() && (pkgh = rpmdbNextIterator (match)) != NULL) {
+			if (rpmverify_collect_package(ctx, &pool, pkgh,
+					name_ent, epoch_ent, version_ent, release_ent, arch_ent) != 0)
+				break;
 		}
+		match = rpmdbFreeIterator(match);
+		ret = rpmverify_pool_finish(&pool, ctx);
 
-		res.name = headerFormat(pkgh, "%{NAME}", &rpmerr);
-		COMPARE_ENT(name);
+		RPMVERIFY_UNLOCK;
+		return (ret);
+	}
 
-		res.epoch = headerFormat(pkgh, "%{EPOCH}", &rpmerr);
-		COMPARE_ENT(epoch);
+	/* otherwise the packages come from the index shared by the rpm probes */
+	if (rpm_index_acquire(g_rpm) != 0) {
+		rpmverify_pool_finish(&pool, ctx);
+		return (-1);
+	}
 
-		res.version = headerFormat(pkgh, "%{VERSION}", &rpmerr);
-		COMPARE_ENT(version);
-		res.release = headerFormat(pkgh, "%{RELEASE}", &rpmerr);
-		COMPARE_ENT(release);
-		res.arch = headerFormat(pkgh, "%{ARCH}", &rpmerr);
-		COMPARE_ENT(arch);
-		snprintf(res.extended_name, 1024, "%s-%s:%s-%s.%s", res.name,
-			oscap_streq(res.epoch, "(none)") ? "0" : res.epoch,
-			res.version, res.release, res.arch);
+	if ((pkgs_count = match_name(name_ent, &pkgs)) == -1) {
+		dE("can't match the package name");
+		rpm_index_release();
+		rpmverify_pool_finish(&pool, ctx);
+		return (-1);
+	}
 
-		if (rpmverify_collect_package_files_or_directories(g_rpm, ctx, pkgh, file, file_op, RPMTAG_BASENAMES, &res, flags) != 0 ||
-				rpmverify_collect_package_files_or_directories(g_rpm, ctx, pkgh, file, file_op, RPMTAG_DIRNAMES, &res, flags) != 0) {
-			ret = -1;
-		}
+	RPMVERIFY_LOCK;
 
-		free(res.name);
-		free(res.epoch);
-		free(res.version);
-		free(res.release);
-		free(res.arch);
-		if (ret == -1) {
-			goto ret;
-		}
+	for (int i = 0; i < pkgs_count && !oval_deadline_expired(); i++) {
+		if (rpmverify_collect_package(ctx, &pool, pkgs[i]->h,
+				name_ent, epoch_ent, version_ent, release_ent, arch_ent) != 0)
+			break;
 	}
+	ret = rpmverify_pool_finish(&pool, ctx);
 
-	ret   = 0;
-ret:
-	match = rpmdbFreeIterator(match);
 	RPMVERIFY_UNLOCK;
+	free(pkgs);
+	rpm_index_release();
 	return (ret);
 }
 
@@ -370,6 +732,7 @@ void *rpmverifyfile_probe_init(void)
 	g_rpm->rpmts = rpmtsCreate();
 
 	pthread_mutex_init(&(g_rpm->mutex), NULL);
+	rpm_index_ref();
 
 	return ((void *)g_rpm);
 }
@@ -387,6 +750,7 @@ void rpmverifyfile_probe_fini(void *ptr)
 	if (r == NULL)
 		return;
 
+	rpm_index_unref();
 	rpmtsFree(r->rpmts);
 	pthread_mutex_destroy (&(r->mutex));
 	free(r);
@@ -479,6 +843,20 @@ const rpmverifyfile_bhmap_t rpmverifyfile_bhmap[] = {
 	{ "nocaps", (uint64_t)RPMVERIFY_CAPS }
 };
 
+/* item entities with the attributes they need verified */
+const rpmverifyfile_bhmap_t rpmverifyfile_entmap[] = {
+	{ "size_differs",        (uint64_t)RPMVERIFY_FILESIZE   },
+	{ "mode_differs",        (uint64_t)RPMVERIFY_MODE       },
+	{ "md5_differs",         (uint64_t)RPMVERIFY_MD5        },
+	{ "filedigest_differs",  (uint64_t)RPMVERIFY_FILEDIGEST },
+	{ "device_differs",      (uint64_t)RPMVERIFY_RDEV       },
+	{ "link_mismatch",       (uint64_t)RPMVERIFY_LINKTO     },
+	{ "ownership_differs",   (uint64_t)RPMVERIFY_USER       },
+	{ "group_differs",       (uint64_t)RPMVERIFY_GROUP      },
+	{ "mtime_differs",       (uint64_t)RPMVERIFY_MTIME      },
+	{ "capabilities_differ", (uint64_t)RPMVERIFY_CAPS       }
+};
+
 int rpmverifyfile_probe_main(probe_ctx *ctx, void *arg)
 {
 	SEXP_t *probe_in, *file_ent, *bh_ent;
@@ -561,6 +939,20 @@ int rpmverifyfile_probe_main(probe_ctx *ctx, void *arg)
 		SEXP_free(bh_ent);
 	}
 
+	/*
+	 * Attributes no state, filter or variable looks at aren't verified,
+	 * most importantly the file digest, which needs the whole file read.
+	 * md5_differs and filedigest_differs share the digest.
+	 */
+	uint64_t wanted_flags = 0, entity_flags = 0;
+
+	for (i = 0; i < sizeof rpmverifyfile_entmap/sizeof(rpmverifyfile_bhmap_t); ++i) {
+		entity_flags |= rpmverifyfile_entmap[i].a_flag;
+		if (probe_obj_wants_itement(probe_in, rpmverifyfile_entmap[i].a_name))
+			wanted_flags |= rpmverifyfile_entmap[i].a_flag;
+	}
+	collect_flags |= entity_flags & ~wanted_flags;
+
 	dD("Collecting rpmverifyfile data, query: f=\"%s\" (%d)",
 	   file, file_op);
 
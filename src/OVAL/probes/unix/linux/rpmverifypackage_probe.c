@@ -33,6 +33,7 @@
 #include <config.h>
 #endif
 
+#include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
 #include <errno.h>
@@ -114,36 +115,17 @@ static struct poptOption optionsTable[] = {
 
 #define CHROOT_PATH() probe_chroot_get_path(&g_rpm->chr)
 
-/* modify passed-in iterator to test also given entity */
-static int adjust_filter(rpmdbMatchIterator iterator, SEXP_t *ent, rpmTag rpm_tag) {
-	oval_operation_t ent_op;
+/* find the packages of the shared index matching the given name entity */
+static int match_name(SEXP_t *name_ent, struct rpm_index_pkg ***pkgs) {
+	oval_operation_t ent_op = OVAL_OPERATION_UNKNOWN;
 	char ent_str[1024] = "";
-	int ret = 0;
 
-	if (ent) {
-		ent_op = probe_ent_getoperation(ent, OVAL_OPERATION_EQUALS);
-		PROBE_ENT_STRVAL(ent, ent_str, sizeof ent_str, /* void */, strcpy(ent_str, ""););
-		if (rpm_tag == RPMTAG_EPOCH && strcmp(ent_str, "(none)") == 0) {
-			return ret;
-		}
-
-		switch (ent_op) {
-		case OVAL_OPERATION_EQUALS:
-			if (rpmdbSetIteratorRE (iterator, rpm_tag, RPMMIRE_STRCMP, ent_str) != 0)
-				ret = -1;
-
-			break;
-		case OVAL_OPERATION_PATTERN_MATCH:
-			if (rpmdbSetIteratorRE (iterator, rpm_tag, RPMMIRE_REGEX,
-						(const char *)ent_str) != 0)
-				ret = -1;
-
-			break;
-		default:
-			ret = 0;
-		}
+	if (name_ent) {
+		ent_op = probe_ent_getoperation(name_ent, OVAL_OPERATION_EQUALS);
+		PROBE_ENT_STRVAL(name_ent, ent_str, sizeof ent_str, /* void */, strcpy(ent_str, ""););
 	}
-	return ret;
+	/* unless it is equals or pattern match, the names are compared by the caller */
+	return rpm_index_match(ent_op, ent_str, pkgs);
 }
 
 static int rpmverify_collect(probe_ctx *ctx,
@@ -152,52 +134,36 @@ static int rpmverify_collect(probe_ctx *ctx,
 			int (*callback)(probe_ctx *, struct rpmverify_res *),
 			struct verifypackage_global *g_rpm)
 {
-	rpmdbMatchIterator match;
+	struct rpm_index_pkg **pkgs = NULL;
 	Header pkgh;
-	int  ret = -1;
+	int  pkgs_count, p, ret = -1;
+	bool stop = false;
 	unsigned int i, j, rpmcli_argc = 0;
 	const char * rpmcli_argv[10];
 	poptContext rpmcli_context;
 	QVA_t qva;
 
-	RPMVERIFY_LOCK;
-
-	match = rpmtsInitIterator (g_rpm->rpm.rpmts, RPMDBI_PACKAGES, NULL, 0);
-	if (match == NULL) {
-		ret = 0;
-		goto ret;
+	if (RPMTAG_BASENAMES == 0 || RPMTAG_DIRNAMES == 0) {
+		return -1;
 	}
 
-	if ((ret = adjust_filter(match, name_ent, RPMTAG_NAME)) == -1) {
-		dE("can't adjust filter with name");
-		goto ret;
-	}
-	if ((ret = adjust_filter(match, epoch_ent, RPMTAG_EPOCH)) == -1) {
-		dE("can't adjust filter with epoch");
-		goto ret;
-	}
-	if ((ret = adjust_filter(match, version_ent, RPMTAG_VERSION)) == -1) {
-		dE("can't adjust filter with version");
-		goto ret;
-	}
-	if ((ret = adjust_filter(match, release_ent, RPMTAG_RELEASE)) == -1) {
-		dE("can't adjust filter with version");
-		goto ret;
-	}
-	if ((ret = adjust_filter(match, arch_ent, RPMTAG_ARCH)) == -1) {
-		dE("can't adjust filter with version");
-		goto ret;
-	}
+	/* the packages come from the index shared by the rpm probes */
+	if (rpm_index_acquire(&g_rpm->rpm) != 0)
+		return -1;
 
-	if (RPMTAG_BASENAMES == 0 || RPMTAG_DIRNAMES == 0) {
+	if ((pkgs_count = match_name(name_ent, &pkgs)) == -1) {
+		dE("can't match the package name");
+		rpm_index_release();
 		return -1;
 	}
 
+	RPMVERIFY_LOCK;
+
 	rpmcli_argv[0] = "probe_rpmverifypackage";
 	rpmcli_argv[1] = "--quiet";
 	rpmcli_argv[2] = "--nofiles";
 
-	while ((pkgh = rpmdbNextIterator (match)) != NULL) {
+	for (p = 0; p < pkgs_count; p++) {
 		SEXP_t *ent;
 		struct rpmverify_res res;
 		errmsg_t rpmerr;
@@ -209,22 +175,24 @@ static int rpmverify_collect(probe_ctx *ctx,
 			); \
 			if (ent != NULL && probe_entobj_cmp(XXX ## _ent, ent) != OVAL_RESULT_TRUE) { \
 				SEXP_free(ent); \
-				continue; \
+				goto next; \
 			} \
 			SEXP_free(ent); \
 		}
 
+		pkgh = pkgs[p]->h;
+		rpm_index_header_lock();
 		res.name = headerFormat(pkgh, "%{NAME}", &rpmerr);
-		COMPARE_ENT(name);
-
 		res.epoch = headerFormat(pkgh, "%{EPOCH}", &rpmerr);
-		COMPARE_ENT(epoch);
-
 		res.version = headerFormat(pkgh, "%{VERSION}", &rpmerr);
-		COMPARE_ENT(version);
 		res.release = headerFormat(pkgh, "%{RELEASE}", &rpmerr);
-		COMPARE_ENT(release);
 		res.arch = headerFormat(pkgh, "%{ARCH}", &rpmerr);
+		rpm_index_header_unlock();
+
+		COMPARE_ENT(name);
+		COMPARE_ENT(epoch);
+		COMPARE_ENT(version);
+		COMPARE_ENT(release);
 		COMPARE_ENT(arch);
 		snprintf(res.extended_name, 1024, "%s-%s:%s-%s.%s", res.name,
 			oscap_streq(res.epoch, "(none)") ? "0" : res.epoch,
@@ -303,21 +271,24 @@ static int rpmverify_collect(probe_ctx *ctx,
 				res.vresults |= rpmverifypackage_bhmap[i].a_flag;
 
 		}
-		if (callback(ctx, &res)) {
-			ret = 1;
-			goto ret;
-		}
+		stop = callback(ctx, &res) != 0;
+next:
 		free(res.name);
 		free(res.epoch);
 		free(res.version);
 		free(res.release);
 		free(res.arch);
+		if (stop) {
+			ret = 1;
+			goto ret;
+		}
 	}
 
-	match = rpmdbFreeIterator (match);
 	ret   = 0;
 ret:
 	RPMVERIFY_UNLOCK;
+	free(pkgs);
+	rpm_index_release();
 	return (ret);
 }
 
@@ -379,6 +350,7 @@ void *rpmverifypackage_probe_init(void)
 	}
 
 	pthread_mutex_init(&(g_rpm->rpm.mutex), NULL);
+	rpm_index_ref();
 	return ((void *)g_rpm);
 }
 
@@ -402,6 +374,7 @@ void rpmverifypackage_probe_fini(void *ptr)
 	if (r->rpm.rpmts == NULL)
 		return;
 
+	rpm_index_unref();
 	rpmtsFree(r->rpm.rpmts);
 	pthread_mutex_destroy (&(r->rpm.mutex));
 
@@ -491,6 +464,12 @@ int rpmverifypackage_probe_main(probe_ctx *ctx, void *arg)
 		SEXP_free(bh_ent);
 	}
 
+	/* each check verifies the whole package, skip those nothing looks at */
+	if (!probe_obj_wants_itement(probe_in, "dependency_check_passed"))
+		collect_flags |= VERIFY_DEPS;
+	if (!probe_obj_wants_itement(probe_in, "verification_script_successful"))
+		collect_flags |= VERIFY_SCRIPT;
+
 	if (rpmverify_collect(ctx, name_ent, epoch_ent, version_ent, release_ent,
 			arch_ent, collect_flags, rpmverifypackage_additem, g_rpm) != 0)
 	{
@@ -51,6 +51,7 @@
 #include <selinux/context.h>
 
 #include "oval_fts.h"
+#include "oval_selinux_cache.h"
 #include "util.h"
 #include "common/debug_priv.h"
 #include "probe/probe.h"
@@ -191,7 +192,7 @@ static int selinuxsecuritycontext_process_cb (SEXP_t *pid_ent, probe_ctx *ctx) {
 		pid_sexp = SEXP_number_newi_32(pid_number);
 		if (probe_entobj_cmp(pid_ent, pid_sexp) == OVAL_RESULT_TRUE) {
 
-			if (getpidcon(pid_number, &pid_context) == -1) {
+			if (oval_selinux_cache_pidcon(pid_number, &pid_context) == -1) {
 				/* error getting pid selinux context */
 				dW("Can't get selinux context for process %d", pid_number);
 				SEXP_free(pid_sexp);
@@ -219,7 +220,7 @@ static int selinuxsecuritycontext_process_cb (SEXP_t *pid_ent, probe_ctx *ctx) {
 			probe_item_collect(ctx, item);
 
 			context_free(context);
-			freecon(pid_context);
+			free(pid_context);
 		}
 		SEXP_free(pid_sexp);
 	}
@@ -236,8 +237,8 @@ static int selinuxsecuritycontext_file_cb(const char *prefix, const char *p, con
 	char   pbuf[PATH_MAX+1];
 	size_t plen, flen;
 
-	char *file_context;
-	int file_context_size;
+	char *file_context = NULL;
+	int file_context_ret;
 	context_t context;
 	const char *user, *role, *type, *range;
 	int err = 0;
@@ -274,9 +275,9 @@ static int selinuxsecuritycontext_file_cb(const char *prefix, const char *p, con
 		free(path_with_prefix);
 		return 0;
 	}
-	file_context_size = getfilecon(path_with_prefix, &file_context);
+	file_context_ret = oval_selinux_cache_filecon(path_with_prefix, &file_context);
 	free(path_with_prefix);
-	if (file_context_size == -1) {
+	if (file_context_ret == -1) {
 		dD("Can't get context for %s: %s", pbuf, strerror(errno));
 
 		item = probe_item_create(OVAL_LINUX_SELINUXSECURITYCONTEXT, NULL,
@@ -317,8 +318,7 @@ static int selinuxsecuritycontext_file_cb(const char *prefix, const char *p, con
 	}
 	probe_item_collect(ctx, item);
 
-	if (file_context != NULL)
-		freecon(file_context);
+	free(file_context);
 
 	return (err);
 }
@@ -0,0 +1,588 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "common/list.h"
+#include "systemdshared.h"
+#include "systemd-cache.h"
+
+/* calls in flight at once */
+#define SYSTEMD_CACHE_BATCH 64
+#define SYSTEMD_CACHE_HSIZE 4099
+
+enum systemd_unit_state {
+	SYSTEMD_UNIT_NEW = 0,
+	SYSTEMD_UNIT_LOADED,
+	SYSTEMD_UNIT_FAILED
+};
+
+struct systemd_unit_entry {
+	enum systemd_unit_state state;
+	char *path;                       /* object path from LoadUnit */
+	size_t prop_count;
+	size_t prop_alloc;
+	struct systemd_property *props;
+	char **dependencies;              /* NULL until computed */
+};
+
+struct systemd_cache {
+	unsigned int refs;
+	pthread_mutex_t lock;
+	DBusConnection *conn;
+	size_t unit_count;
+	size_t unit_alloc;
+	char **units;
+	struct oscap_htable *entries;     /* unit name -> struct systemd_unit_entry */
+};
+
+static pthread_mutex_t systemd_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static systemd_cache_t *systemd_cache_current = NULL;
+
+static void systemd_unit_entry_free(void *ptr)
+{
+	struct systemd_unit_entry *entry = ptr;
+	size_t i;
+
+	for (i = 0; i < entry->prop_count; ++i) {
+		free(entry->props[i].name);
+		free(entry->props[i].value);
+	}
+	free(entry->props);
+	if (entry->dependencies != NULL) {
+		for (i = 0; entry->dependencies[i] != NULL; ++i)
+			free(entry->dependencies[i]);
+		free(entry->dependencies);
+	}
+	free(entry->path);
+	free(entry);
+}
+
+static void systemd_cache_free(systemd_cache_t *cache)
+{
+	size_t i;
+
+	for (i = 0; i < cache->unit_count; ++i)
+		free(cache->units[i]);
+	free(cache->units);
+	oscap_htable_free(cache->entries, systemd_unit_entry_free);
+	pthread_mutex_destroy(&cache->lock);
+	disconnect_dbus(cache->conn);
+	free(cache);
+}
+
+static int systemd_cache_unit_callback(const char *unit, void *cbarg)
+{
+	systemd_cache_t *cache = cbarg;
+
+	if (cache->unit_count == cache->unit_alloc) {
+		char **units = realloc(cache->units, (cache->unit_alloc + 256) * sizeof(char *));
+
+		if (units == NULL)
+			return 1;
+		cache->units = units;
+		cache->unit_alloc += 256;
+	}
+	cache->units[cache->unit_count++] = oscap_strdup(unit);
+
+	return 0;
+}
+
+systemd_cache_t *systemd_cache_acquire(void)
+{
+	systemd_cache_t *cache;
+	DBusConnection *conn;
+
+	pthread_mutex_lock(&systemd_cache_lock);
+	if (systemd_cache_current != NULL) {
+		cache = systemd_cache_current;
+		cache->refs++;
+		pthread_mutex_unlock(&systemd_cache_lock);
+		return cache;
+	}
+	pthread_mutex_unlock(&systemd_cache_lock);
+
+	conn = connect_dbus();
+	if (conn == NULL)
+		return NULL;
+
+	cache = calloc(1, sizeof(systemd_cache_t));
+	if (cache == NULL) {
+		disconnect_dbus(conn);
+		return NULL;
+	}
+	pthread_mutex_init(&cache->lock, NULL);
+	cache->conn = conn;
+	cache->entries = oscap_htable_new1(strcmp, SYSTEMD_CACHE_HSIZE);
+	get_all_systemd_units(conn, systemd_cache_unit_callback, cache);
+	dD("Listed %zu systemd units.", cache->unit_count);
+
+	pthread_mutex_lock(&systemd_cache_lock);
+	if (systemd_cache_current == NULL) {
+		/* one reference is held by the session */
+		cache->refs = 2;
+		systemd_cache_current = cache;
+	} else {
+		/* listed by another thread meanwhile */
+		systemd_cache_free(cache);
+		cache = systemd_cache_current;
+		cache->refs++;
+	}
+	pthread_mutex_unlock(&systemd_cache_lock);
+
+	return cache;
+}
+
+void systemd_cache_release(systemd_cache_t *cache)
+{
+	bool last;
+
+	if (cache == NULL)
+		return;
+
+	pthread_mutex_lock(&systemd_cache_lock);
+	last = --cache->refs == 0;
+	pthread_mutex_unlock(&systemd_cache_lock);
+
+	if (last)
+		systemd_cache_free(cache);
+}
+
+const char *systemd_cache_unit(const systemd_cache_t *cache, size_t i)
+{
+	return i < cache->unit_count ? cache->units[i] : NULL;
+}
+
+/* must be called with cache->lock held */
+static struct systemd_unit_entry *systemd_cache_entry(systemd_cache_t *cache, const char *unit)
+{
+	struct systemd_unit_entry *entry = oscap_htable_get(cache->entries, unit);
+
+	if (entry != NULL)
+		return entry;
+
+	entry = calloc(1, sizeof(struct systemd_unit_entry));
+	if (entry == NULL)
+		return NULL;
+	if (!oscap_htable_add(cache->entries, unit, entry)) {
+		free(entry);
+		return NULL;
+	}
+	return entry;
+}
+
+static DBusPendingCall *systemd_cache_call(DBusConnection *conn, const char *path, const char *interface, const char *method, const char *arg)
+{
+	DBusMessage *msg;
+	DBusMessageIter args;
+	DBusPendingCall *pending = NULL;
+
+	msg = dbus_message_new_method_call("org.freedesktop.systemd1", path, interface, method);
+	if (msg == NULL) {
+		dD("Failed to create dbus_message via dbus_message_new_method_call!");
+		return NULL;
+	}
+
+	dbus_message_iter_init_append(msg, &args);
+	if (!dbus_message_iter_append_basic(&args, DBUS_TYPE_STRING, &arg)) {
+		dD("Failed to append '%s' string parameter to dbus message!", arg);
+	} else if (!dbus_connection_send_with_reply(conn, msg, &pending, -1) || pending == NULL) {
+		dD("Failed to send message via dbus!");
+		pending = NULL;
+	}
+	dbus_message_unref(msg);
+
+	return pending;
+}
+
+static DBusMessage *systemd_cache_reply(DBusPendingCall *pending)
+{
+	DBusMessage *msg;
+
+	dbus_pending_call_block(pending);
+	msg = dbus_pending_call_steal_reply(pending);
+	dbus_pending_call_unref(pending);
+	if (msg == NULL)
+		dD("Failed to steal dbus pending call reply.");
+
+	return msg;
+}
+
+static void systemd_cache_add_property(struct systemd_unit_entry *entry, const char *name, char *value)
+{
+	if (entry->prop_count == entry->prop_alloc) {
+		struct systemd_property *props = realloc(entry->props, (entry->prop_alloc + 64) * sizeof(struct systemd_property));
+
+		if (props == NULL) {
+			free(value);
+			return;
+		}
+		entry->props = props;
+		entry->prop_alloc += 64;
+	}
+	entry->props[entry->prop_count].name = oscap_strdup(name);
+	entry->props[entry->prop_count].value = value;
+	entry->prop_count++;
+}
+
+static void systemd_cache_parse_properties(DBusMessage *msg, struct systemd_unit_entry *entry)
+{
+	DBusMessageIter args, property_iter;
+
+	if (!dbus_message_iter_init(msg, &args)) {
+		dD("Failed to initialize iterator over received dbus message.");
+		return;
+	}
+
+	if (dbus_message_iter_get_arg_type(&args) != DBUS_TYPE_ARRAY && dbus_message_iter_get_element_type(&args) != DBUS_TYPE_DICT_ENTRY) {
+		dD("Expected array of dict_entry argument in reply. Instead received: %s.", dbus_message_type_to_string(dbus_message_iter_get_arg_type(&args)));
+		return;
+	}
+
+	dbus_message_iter_recurse(&args, &property_iter);
+	do {
+		DBusMessageIter dict_entry, value_variant;
+		dbus_message_iter_recurse(&property_iter, &dict_entry);
+
+		if (dbus_message_iter_get_arg_type(&dict_entry) != DBUS_TYPE_STRING) {
+			dD("Expected string as key in dict_entry. Instead received: %s.", dbus_message_type_to_string(dbus_message_iter_get_arg_type(&dict_entry)));
+			return;
+		}
+
+		_DBusBasicValue value;
+		dbus_message_iter_get_basic(&dict_entry, &value);
+		const char *property_name = value.str;
+
+		if (dbus_message_iter_next(&dict_entry) == false) {
+			dW("Expected another field in dict_entry.");
+			return;
+		}
+
+		if (dbus_message_iter_get_arg_type(&dict_entry) != DBUS_TYPE_VARIANT) {
+			dD("Expected variant as value in dict_entry. Instead received: %s.", dbus_message_type_to_string(dbus_message_iter_get_arg_type(&dict_entry)));
+			return;
+		}
+
+		dbus_message_iter_recurse(&dict_entry, &value_variant);
+
+		// DBUS_TYPE_ARRAY is a special case, we keep each element as one value
+		if (dbus_message_iter_get_arg_type(&value_variant) == DBUS_TYPE_ARRAY) {
+			DBusMessageIter array;
+			dbus_message_iter_recurse(&value_variant, &array);
+
+			do {
+				char *element = dbus_value_to_string(&array);
+				if (element == NULL)
+					continue;
+
+				systemd_cache_add_property(entry, property_name, element);
+			}
+			while (dbus_message_iter_next(&array));
+		}
+		else {
+			systemd_cache_add_property(entry, property_name, dbus_value_to_string(&value_variant));
+		}
+	}
+	while (dbus_message_iter_next(&property_iter));
+}
+
+/*
+ * Send LoadUnit for a batch of units, then GetAll for those which have a
+ * path, and collect the replies after each round was sent.
+ * Must be called with cache->lock held.
+ */
+static void systemd_cache_load_batch(systemd_cache_t *cache, struct systemd_unit_entry **entries, const char **units, size_t count)
+{
+	DBusPendingCall *pending[SYSTEMD_CACHE_BATCH];
+	size_t i;
+
+	for (i = 0; i < count; ++i) {
+		pending[i] = systemd_cache_call(cache->conn, "/org/freedesktop/systemd1", "org.freedesktop.systemd1.Manager",
+		                                // LoadUnit is similar to GetUnit except it will load the unit file
+		                                // if it hasn't been loaded yet.
+		                                "LoadUnit", units[i]);
+	}
+	dbus_connection_flush(cache->conn);
+
+	for (i = 0; i < count; ++i) {
+		DBusMessage *msg;
+		DBusMessageIter args;
+
+		entries[i]->state = SYSTEMD_UNIT_FAILED;
+		if (pending[i] == NULL || (msg = systemd_cache_reply(pending[i])) == NULL)
+			continue;
+
+		if (!dbus_message_iter_init(msg, &args)) {
+			dD("Failed to initialize iterator over received dbus message.");
+		} else if (dbus_message_iter_get_arg_type(&args) != DBUS_TYPE_OBJECT_PATH) {
+			dD("Expected string argument in reply. Instead received: %s.", dbus_message_type_to_string(dbus_message_iter_get_arg_type(&args)));
+		} else {
+			_DBusBasicValue path;
+
+			dbus_message_iter_get_basic(&args, &path);
+			entries[i]->path = oscap_strdup(path.str);
+		}
+		dbus_message_unref(msg);
+	}
+
+	for (i = 0; i < count; ++i) {
+		pending[i] = NULL;
+		if (entries[i]->path != NULL)
+			pending[i] = systemd_cache_call(cache->conn, entries[i]->path, "org.freedesktop.DBus.Properties",
+			                                "GetAll", "org.freedesktop.systemd1.Unit");
+	}
+	dbus_connection_flush(cache->conn);
+
+	for (i = 0; i < count; ++i) {
+		DBusMessage *msg;
+
+		if (entries[i]->path == NULL)
+			continue;
+		/* the unit exists even if its properties can't be read */
+		if (entries[i]->props == NULL) {
+			entries[i]->props = calloc(1, sizeof(struct systemd_property));
+			if (entries[i]->props == NULL)
+				continue;
+			entries[i]->prop_alloc = 1;
+		}
+		entries[i]->state = SYSTEMD_UNIT_LOADED;
+		if (pending[i] == NULL || (msg = systemd_cache_reply(pending[i])) == NULL)
+			continue;
+		systemd_cache_parse_properties(msg, entries[i]);
+		dbus_message_unref(msg);
+	}
+}
+
+/* must be called with cache->lock held */
+static void systemd_cache_load_locked(systemd_cache_t *cache, const char *const *units, size_t count)
+{
+	struct systemd_unit_entry *entries[SYSTEMD_CACHE_BATCH];
+	const char *names[SYSTEMD_CACHE_BATCH];
+	size_t i, n = 0;
+
+	for (i = 0; i < count; ++i) {
+		struct systemd_unit_entry *entry = systemd_cache_entry(cache, units[i]);
+
+		if (entry == NULL || entry->state != SYSTEMD_UNIT_NEW)
+			continue;
+		/* mark it so that a duplicate name isn't sent twice */
+		entry->state = SYSTEMD_UNIT_FAILED;
+		entries[n] = entry;
+		names[n] = units[i];
+		if (++n == SYSTEMD_CACHE_BATCH) {
+			systemd_cache_load_batch(cache, entries, names, n);
+			n = 0;
+		}
+	}
+	if (n > 0)
+		systemd_cache_load_batch(cache, entries, names, n);
+}
+
+void systemd_cache_load(systemd_cache_t *cache, const char *const *units, size_t count)
+{
+	pthread_mutex_lock(&cache->lock);
+	systemd_cache_load_locked(cache, units, count);
+	pthread_mutex_unlock(&cache->lock);
+}
+
+const struct systemd_property *systemd_cache_properties(systemd_cache_t *cache, const char *unit, size_t *count)
+{
+	struct systemd_unit_entry *entry;
+	const struct systemd_property *props = NULL;
+
+	pthread_mutex_lock(&cache->lock);
+	systemd_cache_load_locked(cache, &unit, 1);
+	entry = oscap_htable_get(cache->entries, unit);
+	if (entry != NULL && entry->state == SYSTEMD_UNIT_LOADED) {
+		props = entry->props;
+		*count = entry->prop_count;
+	}
+	pthread_mutex_unlock(&cache->lock);
+
+	return props;
+}
+
+static bool is_unit_name_a_target(const char *unit)
+{
+	const char *suffix = ".target";
+	const size_t suffix_len = strlen(suffix);
+
+	if (!unit || strcmp(unit, "(null)") == 0)
+		return false;
+
+	const size_t len = strlen(unit);
+	if (suffix_len >  len)
+		return false;
+
+	return strncmp(unit + len - suffix_len, suffix, suffix_len) == 0;
+}
+
+static const char *const systemd_dependency_properties[] = { "Requires", "Wants", NULL };
+
+/*
+ * Load the target units reachable from the unit level by level, so that
+ * the units of one level are fetched in batches.
+ * Must be called with cache->lock held.
+ */
+static void systemd_cache_load_graph(systemd_cache_t *cache, const char *unit)
+{
+	const char **level = NULL, **next = NULL;
+	size_t level_count = 0, next_count = 0, next_alloc = 0, i, j, k;
+
+	if (!is_unit_name_a_target(unit))
+		return;
+	level = malloc(sizeof(char *));
+	if (level == NULL)
+		return;
+	level[level_count++] = unit;
+
+	while (level_count > 0) {
+		systemd_cache_load_locked(cache, level, level_count);
+
+		for (i = 0; i < level_count; ++i) {
+			struct systemd_unit_entry *entry = oscap_htable_get(cache->entries, level[i]);
+
+			if (entry == NULL || entry->state != SYSTEMD_UNIT_LOADED)
+				continue;
+			for (j = 0; j < entry->prop_count; ++j) {
+				const struct systemd_property *prop = &entry->props[j];
+				struct systemd_unit_entry *dep;
+
+				for (k = 0; systemd_dependency_properties[k] != NULL; ++k) {
+					if (strcmp(prop->name, systemd_dependency_properties[k]) == 0)
+						break;
+				}
+				if (systemd_dependency_properties[k] == NULL || !is_unit_name_a_target(prop->value))
+					continue;
+				dep = oscap_htable_get(cache->entries, prop->value);
+				if (dep != NULL && dep->state != SYSTEMD_UNIT_NEW)
+					continue;
+				if (next_count == next_alloc) {
+					const char **new_next = realloc(next, (next_alloc + 64) * sizeof(char *));
+
+					if (new_next == NULL)
+						break;
+					next = new_next;
+					next_alloc += 64;
+				}
+				next[next_count++] = prop->value;
+			}
+		}
+
+		free(level);
+		level = next;
+		level_count = next_count;
+		next = NULL;
+		next_count = next_alloc = 0;
+	}
+	free(level);
+}
+
+struct systemd_dependency_list {
+	char **names;
+	size_t count;
+	size_t alloc;
+	struct oscap_htable *visited;
+};
+
+/* must be called with cache->lock held, the graph of the unit is loaded */
+static void systemd_cache_collect_dependencies(systemd_cache_t *cache, const char *unit, struct systemd_dependency_list *list)
+{
+	struct systemd_unit_entry *entry;
+	size_t i, j;
+
+	// systemctl list-dependencies only recurses into target units
+	if (!is_unit_name_a_target(unit))
+		return;
+
+	entry = oscap_htable_get(cache->entries, unit);
+	if (entry == NULL || entry->state != SYSTEMD_UNIT_LOADED)
+		return;
+
+	for (i = 0; systemd_dependency_properties[i] != NULL; ++i) {
+		for (j = 0; j < entry->prop_count; ++j) {
+			const char *dependency = entry->props[j].value;
+
+			if (strcmp(entry->props[j].name, systemd_dependency_properties[i]) != 0 ||
+			    dependency == NULL || *dependency == '\0')
+				continue;
+			if (oscap_htable_get(list->visited, dependency) != NULL)
+				continue;
+			oscap_htable_add(list->visited, dependency, (void *) true);
+
+			if (list->count + 1 >= list->alloc) {
+				char **names = realloc(list->names, (list->alloc + 64) * sizeof(char *));
+
+				if (names == NULL)
+					return;
+				list->names = names;
+				list->alloc += 64;
+			}
+			list->names[list->count++] = oscap_strdup(dependency);
+			list->names[list->count] = NULL;
+
+			systemd_cache_collect_dependencies(cache, dependency, list);
+		}
+	}
+}
+
+const char *const *systemd_cache_dependencies(systemd_cache_t *cache, const char *unit)
+{
+	struct systemd_unit_entry *entry;
+	const char *const *dependencies = NULL;
+
+	pthread_mutex_lock(&cache->lock);
+	entry = systemd_cache_entry(cache, unit);
+	if (entry != NULL && entry->dependencies == NULL) {
+		struct systemd_dependency_list list = { NULL, 0, 0, NULL };
+
+		systemd_cache_load_graph(cache, unit);
+		list.visited = oscap_htable_new();
+		systemd_cache_collect_dependencies(cache, unit, &list);
+		oscap_htable_free(list.visited, NULL);
+		if (list.names == NULL)
+			list.names = calloc(1, sizeof(char *));
+		entry->dependencies = list.names;
+	}
+	if (entry != NULL)
+		dependencies = (const char *const *)entry->dependencies;
+	pthread_mutex_unlock(&cache->lock);
+
+	return dependencies;
+}
+
+void systemd_cache_reset(void)
+{
+	systemd_cache_t *cache;
+
+	pthread_mutex_lock(&systemd_cache_lock);
+	cache = systemd_cache_current;
+	systemd_cache_current = NULL;
+	pthread_mutex_unlock(&systemd_cache_lock);
+
+	systemd_cache_release(cache);
+}
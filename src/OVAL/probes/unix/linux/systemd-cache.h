@@ -0,0 +1,84 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+#ifndef OPENSCAP_OVAL_PROBES_SYSTEMD_CACHE_H_
+#define OPENSCAP_OVAL_PROBES_SYSTEMD_CACHE_H_
+
+#include <stddef.h>
+
+/*
+ * Units of systemd and their properties shared by the systemdunitproperty
+ * and systemdunitdependency objects of one scan. The units are listed once,
+ * the properties of the units are fetched with LoadUnit and GetAll calls
+ * which are sent in batches before any reply is waited for, and each unit
+ * is asked once. The dependencies of a unit are computed once from the
+ * cached Requires and Wants properties. Everything is dropped after each
+ * remediation fix and when the last probe session ends.
+ */
+
+typedef struct systemd_cache systemd_cache_t;
+
+/* a property value, array properties have one per element */
+struct systemd_property {
+	char *name;
+	char *value; /* may be NULL if the type isn't supported */
+};
+
+/**
+ * Get the cache, connecting to the system bus and listing the units on
+ * the first call. It has to be released by systemd_cache_release.
+ * @return the cache or NULL if the connection failed
+ */
+systemd_cache_t *systemd_cache_acquire(void);
+
+void systemd_cache_release(systemd_cache_t *cache);
+
+/**
+ * Get the name of the i-th unit.
+ * @return the name or NULL past the last one
+ */
+const char *systemd_cache_unit(const systemd_cache_t *cache, size_t i);
+
+/**
+ * Fetch the properties of the units which are not cached yet, all the
+ * calls of a batch are in flight at once.
+ */
+void systemd_cache_load(systemd_cache_t *cache, const char *const *units, size_t count);
+
+/**
+ * Get the properties of a unit in the order systemd reports them, loading
+ * them if needed. The array is valid until the cache is released.
+ * @return the properties or NULL if the unit couldn't be loaded
+ */
+const struct systemd_property *systemd_cache_properties(systemd_cache_t *cache, const char *unit, size_t *count);
+
+/**
+ * Get the units a unit depends on like systemctl list-dependencies does,
+ * recursing into the Requires and Wants of target units. The array is
+ * valid until the cache is released.
+ * @return NULL terminated array of the unit names, NULL on failure
+ */
+const char *const *systemd_cache_dependencies(systemd_cache_t *cache, const char *unit);
+
+/**
+ * Drop the cache. Caches still held are freed on release.
+ */
+void systemd_cache_reset(void);
+
+#endif /* OPENSCAP_OVAL_PROBES_SYSTEMD_CACHE_H_ */
@@ -31,146 +31,15 @@
 #endif
 
 #include <probe-api.h>
+#include <stdlib.h>
 #include <string.h>
 #include <probe/probe.h>
 
 #include "probe/entcmp.h"
-#include "systemdshared.h"
+#include "systemd-cache.h"
 #include "systemdunitproperty_probe.h"
 
-static int get_all_properties_by_unit_path(DBusConnection *conn, const char *unit_path, int(*callback)(const char *name, const char *value, void *arg), void *cbarg)
-{
-	int ret = 1;
-	DBusMessage *msg = NULL;
-	DBusPendingCall *pending = NULL;
-
-	msg = dbus_message_new_method_call(
-		"org.freedesktop.systemd1",
-		unit_path,
-		"org.freedesktop.DBus.Properties",
-		"GetAll"
-	);
-	if (msg == NULL) {
-		dD("Failed to create dbus_message via dbus_message_new_method_call!");
-		goto cleanup;
-	}
-
-	DBusMessageIter args, property_iter;
-
-	const char *interface = "org.freedesktop.systemd1.Unit";
-
-	dbus_message_iter_init_append(msg, &args);
-	if (!dbus_message_iter_append_basic(&args, DBUS_TYPE_STRING, &interface)) {
-		dD("Failed to append interface '%s' string parameter to dbus message!", interface);
-		goto cleanup;
-	}
-
-	if (!dbus_connection_send_with_reply(conn, msg, &pending, -1)) {
-		dD("Failed to send message via dbus!");
-		goto cleanup;
-	}
-	if (pending == NULL) {
-		dD("Invalid dbus pending call!");
-		goto cleanup;
-	}
-
-	dbus_connection_flush(conn);
-	dbus_message_unref(msg); msg = NULL;
-
-	dbus_pending_call_block(pending);
-	msg = dbus_pending_call_steal_reply(pending);
-	if (msg == NULL) {
-		dD("Failed to steal dbus pending call reply.");
-		goto cleanup;
-	}
-	dbus_pending_call_unref(pending); pending = NULL;
-
-	if (!dbus_message_iter_init(msg, &args)) {
-		dD("Failed to initialize iterator over received dbus message.");
-		goto cleanup;
-	}
-
-	if (dbus_message_iter_get_arg_type(&args) != DBUS_TYPE_ARRAY && dbus_message_iter_get_element_type(&args) != DBUS_TYPE_DICT_ENTRY) {
-		dD("Expected array of dict_entry argument in reply. Instead received: %s.", dbus_message_type_to_string(dbus_message_iter_get_arg_type(&args)));
-		goto cleanup;
-	}
-
-	dbus_message_iter_recurse(&args, &property_iter);
-	do {
-		DBusMessageIter dict_entry, value_variant;
-		dbus_message_iter_recurse(&property_iter, &dict_entry);
-
-		if (dbus_message_iter_get_arg_type(&dict_entry) != DBUS_TYPE_STRING) {
-			dD("Expected string as key in dict_entry. Instead received: %s.", dbus_message_type_to_string(dbus_message_iter_get_arg_type(&dict_entry)));
-			goto cleanup;
-		}
-
-		_DBusBasicValue value;
-		dbus_message_iter_get_basic(&dict_entry, &value);
-		char *property_name = oscap_strdup(value.str);
-
-		if (dbus_message_iter_next(&dict_entry) == false) {
-			dW("Expected another field in dict_entry.");
-			free(property_name);
-			goto cleanup;
-		}
-
-		if (dbus_message_iter_get_arg_type(&dict_entry) != DBUS_TYPE_VARIANT) {
-			dD("Expected variant as value in dict_entry. Instead received: %s.", dbus_message_type_to_string(dbus_message_iter_get_arg_type(&dict_entry)));
-			free(property_name);
-			goto cleanup;
-		}
-
-		dbus_message_iter_recurse(&dict_entry, &value_variant);
-
-		int cbret = 0;
-		const int arg_type = dbus_message_iter_get_arg_type(&value_variant);
-		// DBUS_TYPE_ARRAY is a special case, we report each element as one value entry
-		if (arg_type == DBUS_TYPE_ARRAY) {
-			DBusMessageIter array;
-			dbus_message_iter_recurse(&value_variant, &array);
-
-			do {
-				char *element = dbus_value_to_string(&array);
-				if (element == NULL)
-					continue;
-
-				const int elementcbret = callback(property_name, element, cbarg);
-				if (elementcbret > cbret)
-					cbret = elementcbret;
-
-				free(element);
-			}
-			while (dbus_message_iter_next(&array));
-		}
-		else {
-			char *property_value = dbus_value_to_string(&value_variant);
-			cbret = callback(property_name, property_value, cbarg);
-			free(property_value);
-		}
-
-		free(property_name);
-		if (cbret != 0) {
-			goto cleanup;
-		}
-	}
-	while (dbus_message_iter_next(&property_iter));
-
-	dbus_message_unref(msg); msg = NULL;
-	ret = 0;
-
-cleanup:
-	if (pending != NULL)
-		dbus_pending_call_unref(pending);
-
-	if (msg != NULL)
-		dbus_message_unref(msg);
-
-	return ret;
-}
-
 struct unit_callback_vars {
-	DBusConnection *dbus_conn;
 	probe_ctx *ctx;
 	SEXP_t *unit_entity;
 	SEXP_t *property_entity;
@@ -219,30 +88,22 @@ static int property_callback(const char *property, const char *value, void *cbar
 	return 0;
 }
 
-static int unit_callback(const char *unit, void *cbarg)
+static int unit_callback(systemd_cache_t *cache, const char *unit, struct unit_callback_vars *vars)
 {
-	struct unit_callback_vars *vars = (struct unit_callback_vars *)cbarg;
-	SEXP_t *se_unit = SEXP_string_new(unit, strlen(unit));
+	const struct systemd_property *props;
+	size_t i, prop_count;
 
-	if (probe_entobj_cmp(vars->unit_entity, se_unit) != OVAL_RESULT_TRUE) {
-		/* Do nothing, continue with the next unit */
-		SEXP_free(se_unit);
-		return 0;
+	props = systemd_cache_properties(cache, unit, &prop_count);
+	if (props == NULL) {
+		return 1;
 	}
 
-	vars->se_unit = se_unit;
+	vars->se_unit = SEXP_string_new(unit, strlen(unit));
 	vars->se_property = NULL;
 	vars->item = NULL;
 
-	char *unit_path = get_path_by_unit(vars->dbus_conn, unit);
-
-	if (unit_path == NULL) {
-		return 1;
-	}
-
-	get_all_properties_by_unit_path(vars->dbus_conn, unit_path,
-					property_callback, vars);
-	free(unit_path);
+	for (i = 0; i < prop_count; ++i)
+		property_callback(props[i].name, props[i].value, vars);
 
 	if (vars->item != NULL) {
 		probe_item_collect(vars->ctx, vars->item);
@@ -251,7 +112,7 @@ static int unit_callback(const char *unit, void *cbarg)
 		vars->se_property = NULL;
 	}
 
-	SEXP_free(se_unit);
+	SEXP_free(vars->se_unit);
 	return 0;
 }
 
@@ -273,14 +134,15 @@ int systemdunitproperty_probe_main(probe_ctx *ctx, void *probe_arg)
 		return PROBE_EOPNOTSUPP;
 	}
 
-	DBusError dbus_error;
-	DBusConnection *dbus_conn;
+	systemd_cache_t *cache;
+	const char **units;
+	size_t unit_count = 0, i;
+	const char *unit;
 
-	dbus_error_init(&dbus_error);
-	dbus_conn = connect_dbus();
+	// the units and their properties are shared by all objects of the scan
+	cache = systemd_cache_acquire();
 
-	if (dbus_conn == NULL) {
-		dbus_error_free(&dbus_error);
+	if (cache == NULL) {
 		SEXP_t *msg = probe_msg_creat(OVAL_MESSAGE_LEVEL_INFO, "DBus connection failed, could not identify systemd units.");
 		probe_cobj_set_flag(probe_ctx_getresult(ctx), ctx->offline_mode == PROBE_OFFLINE_NONE ? SYSCHAR_FLAG_ERROR : SYSCHAR_FLAG_NOT_COLLECTED);
 		probe_cobj_add_msg(probe_ctx_getresult(ctx), msg);
@@ -293,17 +155,34 @@ int systemdunitproperty_probe_main(probe_ctx *ctx, void *probe_arg)
 
 	struct unit_callback_vars vars;
 
-	vars.dbus_conn = dbus_conn;
 	vars.ctx = ctx;
 	vars.unit_entity = unit_entity;
 	vars.property_entity = property_entity;
 
-	get_all_systemd_units(dbus_conn, unit_callback, &vars);
+	for (i = 0; systemd_cache_unit(cache, i) != NULL; ++i)
+		;
+	units = malloc((i > 0 ? i : 1) * sizeof(char *));
+
+	for (i = 0; units != NULL && (unit = systemd_cache_unit(cache, i)) != NULL; ++i) {
+		SEXP_t *se_unit = SEXP_string_new(unit, strlen(unit));
+
+		if (probe_entobj_cmp(unit_entity, se_unit) == OVAL_RESULT_TRUE)
+			units[unit_count++] = unit;
+		SEXP_free(se_unit);
+	}
+
+	// fetch the properties of all the matching units at once
+	systemd_cache_load(cache, units, unit_count);
+
+	for (i = 0; i < unit_count; ++i) {
+		if (unit_callback(cache, units[i], &vars) != 0)
+			break;
+	}
 
+	free(units);
 	SEXP_free(unit_entity);
 	SEXP_free(property_entity);
-	dbus_error_free(&dbus_error);
-	disconnect_dbus(dbus_conn);
+	systemd_cache_release(cache);
 
 	return 0;
 }
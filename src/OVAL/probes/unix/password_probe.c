@@ -65,6 +65,7 @@
 #include "common/debug_priv.h"
 #include <probe/probe.h>
 #include <probe/option.h>
+#include "oval_account_cache.h"
 #include "password_probe.h"
 
 /* Convenience structure for the results being reported */
@@ -168,7 +169,7 @@ int password_probe_offline_mode_supported()
 }
 
 #else
-static void _process_struct_passwd(struct passwd *pw, const char *lastlog, SEXP_t *un_ent, probe_ctx *ctx, oval_schema_version_t over)
+static void _process_struct_passwd(const struct passwd *pw, FILE *ll_fp, SEXP_t *un_ent, probe_ctx *ctx, oval_schema_version_t over)
 {
         SEXP_t *un;
         struct result_info r;
@@ -189,17 +190,12 @@ static void _process_struct_passwd(struct passwd *pw, const char *lastlog, SEXP_
         r.login_shell = pw->pw_shell;
         r.last_login = -1;
 
-        if (oval_schema_version_cmp(over, OVAL_SCHEMA_VERSION(5.10)) >= 0) {
-                FILE *ll_fp = fopen(lastlog, "r");
-
-                if (ll_fp != NULL) {
-                        struct lastlog ll;
+        if (ll_fp != NULL) {
+                struct lastlog ll;
 
-                        if (fseeko(ll_fp, (off_t)pw->pw_uid * sizeof(ll), SEEK_SET) == 0)
-                                if (fread((char *)&ll, sizeof(ll), 1, ll_fp) == 1)
-                                        r.last_login = (int64_t)ll.ll_time;
-                        fclose(ll_fp);
-                }
+                if (fseeko(ll_fp, (off_t)pw->pw_uid * sizeof(ll), SEEK_SET) == 0)
+                        if (fread((char *)&ll, sizeof(ll), 1, ll_fp) == 1)
+                                r.last_login = (int64_t)ll.ll_time;
         }
 
         report_finding(&r, ctx, over);
@@ -208,33 +204,53 @@ static void _process_struct_passwd(struct passwd *pw, const char *lastlog, SEXP_
 
 static int read_password(SEXP_t *un_ent, probe_ctx *ctx, oval_schema_version_t over)
 {
-        struct passwd *pw;
+        const struct passwd *pw;
+        const char *root = NULL;
+        oval_account_db_t *db;
+        FILE *ll_fp = NULL;
+        char **names;
+        size_t i;
 
 	if (ctx->offline_mode & PROBE_OFFLINE_OWN) {
-		const char *root = getenv("OSCAP_PROBE_ROOT");
+		root = getenv("OSCAP_PROBE_ROOT");
 		if (root == NULL)
 			return 1;
-		char *passwd_file_path = oscap_path_join(root, "/etc/passwd");
-		char *lastlog_file_path = oscap_path_join(root, _PATH_LASTLOG);
-		FILE *fp = fopen(passwd_file_path, "r");
-		if (fp == NULL) {
-			free(passwd_file_path);
+	}
+
+	/* the accounts are enumerated once per scan */
+	db = oval_account_cache_passwd(root);
+	if (db == NULL)
+		return 1;
+
+	if (oval_schema_version_cmp(over, OVAL_SCHEMA_VERSION(5.10)) >= 0) {
+		if (root != NULL) {
+			char *lastlog_file_path = oscap_path_join(root, _PATH_LASTLOG);
+			ll_fp = fopen(lastlog_file_path, "r");
 			free(lastlog_file_path);
-			return 1;
+		} else {
+			ll_fp = fopen(_PATH_LASTLOG, "r");
 		}
-		while ((pw = fgetpwent(fp))) {
-			_process_struct_passwd(pw, lastlog_file_path, un_ent, ctx, over);
+	}
+
+	names = probe_entobj_equal_strings(un_ent);
+	if (names != NULL) {
+		/* direct lookup for the "equals" op */
+		for (i = 0; names[i] != NULL; ++i) {
+			pw = oval_account_cache_passwd_by_name(db, names[i]);
+			if (pw != NULL)
+				_process_struct_passwd(pw, ll_fp, un_ent, ctx, over);
+			free(names[i]);
 		}
-		fclose(fp);
-		free(passwd_file_path);
-		free(lastlog_file_path);
+		free(names);
 	} else {
-		while ((pw = getpwent())) {
-			_process_struct_passwd(pw, _PATH_LASTLOG, un_ent, ctx, over);
-		}
-		endpwent();
+		for (i = 0; (pw = oval_account_cache_passwd_at(db, i)) != NULL; ++i)
+			_process_struct_passwd(pw, ll_fp, un_ent, ctx, over);
 	}
 
+	if (ll_fp != NULL)
+		fclose(ll_fp);
+	oval_account_cache_release(db);
+
         return 0;
 }
 
@@ -75,6 +75,7 @@
 #ifdef SELINUX_FOUND
 #include <selinux/selinux.h>
 #include <selinux/context.h>
+#include "oval_selinux_cache.h"
 #endif
 #ifdef CAP_FOUND
 #include <ctype.h>
@@ -102,11 +103,9 @@ extern char const *_cap_names[];
 #include "probe/entcmp.h"
 #include "common/debug_priv.h"
 #include <ctype.h>
-#include "common/oscap_buffer.h"
 #include "process58_probe.h"
 #include "oscap_helpers.h"
-
-#define CHUNK_SIZE 1024
+#include "oval_proc_cache.h"
 
 /* Convenience structure for the results being reported */
 struct result_info {
@@ -189,30 +188,11 @@ static int get_uids(int pid, struct result_info *r)
 	char buf[PATH_MAX];
 	FILE *sf;
 
-	r->ruid = -1;
-	r->user_id = -1;
 	r->loginuid = -1;
+	oval_proc_cache_uids(pid, &r->ruid, &r->user_id);
 
 	const char *prefix = getenv("OSCAP_PROBE_ROOT");
 
-	snprintf(buf, sizeof(buf), "%s/proc/%d/status", prefix ? prefix : "", pid);
-	sf = fopen(buf, "rt");
-	if (sf) {
-		int line = 0;
-		__fsetlocking(sf, FSETLOCKING_BYCALLER);
-		while (fgets(buf, sizeof(buf), sf)) {
-			if (line == 0) {
-				line++;
-				continue;
-			}
-			if (memcmp(buf, "Uid:", 4) == 0) {
-				sscanf(buf, "Uid: %d %d", &r->ruid, &r->user_id);
-				break;
-			}
-		}
-		fclose(sf);
-	}
-
 	snprintf(buf, sizeof(buf), "%s/proc/%d/loginuid", prefix ? prefix : "", pid);
 	sf = fopen(buf, "rt");
 	if (sf) {
@@ -250,7 +230,7 @@ static char *get_selinux_label(int pid) {
 	context_t context;
 
 	if (is_selinux_enabled() == 1) {
-		if (getpidcon(pid, &pid_context) == -1) {
+		if (oval_selinux_cache_pidcon(pid, &pid_context) == -1) {
 			/* error getting pid selinux context */
 			dW("Can't get selinux context for process %d", pid);
 			return NULL;
@@ -260,12 +240,12 @@ static char *get_selinux_label(int pid) {
 			// There must be 3 or 4 colon-separated components and no
 			// whitespace in any component other than the MLS
 			// component.
-			freecon(pid_context);
+			free(pid_context);
 			return NULL;
 		}
 		selinux_label = strdup(context_type_get(context));
 		context_free(context);
-		freecon(pid_context);
+		free(pid_context);
 		return selinux_label;
 	} else {
 		return NULL;
@@ -392,70 +372,6 @@ static int get_exec_shield_status(int pid) {
 	return ret;
 }
 
-/**
- * Parse /proc/%d/cmdline file
- * @param filepath Path to file ~ use preallocated buffer for the path
- * @param buffer output buffer with non-zero size
- * @return ps-like command info or NULL
- */
-static inline bool get_process_cmdline(const char* filepath, struct oscap_buffer* const buffer){
-
-	int fd = open(filepath, O_RDONLY, 0);
-
-	if (fd < 0) {
-		return false;
-	}
-
-	oscap_buffer_clear(buffer);
-
-
-
-	for(;;) {
-		char chunk[CHUNK_SIZE];
-		// Read data, store to buffer
-		ssize_t read_size = read(fd, chunk, CHUNK_SIZE);
-		if (read_size < 0) {
-			close(fd);
-			return false;
-		}
-		oscap_buffer_append_binary_data(buffer, chunk, read_size);
-
-		// If reach end of file, then end the loop
-		if (CHUNK_SIZE != read_size) {
-			break;
-		}
-	}
-
-	close(fd);
-
-	int length = oscap_buffer_get_length(buffer);
-	char* buffer_mem = oscap_buffer_get_raw(buffer);
-
-	if ( length == 0 ) { // empty file
-		return false;
-	} else {
-
-		// Skip multiple trailing zeros
-		int i = length - 1;
-		while ( (i > 0) && (buffer_mem[i] == '\0') ) {
-			--i;
-		}
-
-		// Program and args are separated by '\0'
-		// Replace them with spaces ' '
-		while( i >= 0 ){
-			char chr = buffer_mem[i];
-			if ( ( chr == '\0') || ( chr == '\n' ) ) {
-				buffer_mem[i] = ' ';
-			} else if ( !isprint(chr) ) { // "ps" replace non-printable characters with '.' (LC_ALL=C)
-				buffer_mem[i] = '.';
-			}
-			--i;
-		}
-	}
-	return true;
-}
-
 /**
  * Make "[%s] <defunct>" from cmd string - inplace
  * @param cmd_buffer @see read_process() > cmd_buffer
@@ -471,16 +387,15 @@ static inline char *make_defunc_str(char* const cmd_buffer){
 
 static int read_process(SEXP_t *cmd_ent, SEXP_t *pid_ent, probe_ctx *ctx)
 {
-	char buf[PATH_MAX];
 	int max_cap_id;
-	DIR *d;
-	struct dirent *ent;
+	int *pids;
+	size_t pid_count, i;
 	oval_schema_version_t oval_version;
 
+	// The processes are listed once per scan for all the process58,
+	// environmentvariable58 and inetlisteningservers objects
 	const char *prefix = getenv("OSCAP_PROBE_ROOT");
-	snprintf(buf, PATH_MAX, "%s/proc", prefix ? prefix : "");
-	d = opendir(buf);
-	if (d == NULL) {
+	if (oval_proc_cache_pids(&pids, &pid_count) != 0) {
 		return prefix ? PROBE_ESUCCESS : PROBE_EACCESS;
 	}
 
@@ -495,69 +410,39 @@ static int read_process(SEXP_t *cmd_ent, SEXP_t *pid_ent, probe_ctx *ctx)
 		max_cap_id = OVAL_5_11_MAX_CAP_ID;
 	}
 
-	struct oscap_buffer *cmdline_buffer = oscap_buffer_new();
-	
 	char cmd_buffer[1 + 15 + 11 + 1]; // Format:" [ cmd:15 ] <defunc>"
 	cmd_buffer[0] = '[';
 
-	// Scan the directories
+	// Scan the processes
 	bool any_pid_dir_found = false;
-	while (( ent = readdir(d) )) {
-		int fd, len;
-		char *tmp, state, tty_dev[128];
-		int pid, ppid, pgrp, session, tty_nr, tpgid;
-		unsigned flags, sched_policy;
-		unsigned long minflt, cminflt, majflt, cmajflt, uutime, ustime;
-		long cutime, cstime, priority, cnice, nthreads, itrealvalue;
-		unsigned long long start;
+	for (i = 0; i < pid_count; ++i) {
+		char tty_dev[128], *cmdline = NULL;
+		int pid = pids[i];
+		unsigned sched_policy;
+		struct oval_proc_stat st;
 		SEXP_t *cmd_sexp = NULL, *pid_sexp = NULL;
 
-		// Skip non-process58 dir entries
-		if(*ent->d_name<'0' || *ent->d_name>'9')
-			continue;
-		errno = 0;
-		pid = strtol(ent->d_name, NULL, 10);
-		if (errno || pid == 2) // skip err & kthreads
+		if (pid == 2) // skip kthreads
 			continue;
 
 		// Parse up the stat file for the proc
-		snprintf(buf, PATH_MAX, "%s/proc/%d/stat", prefix ? prefix : "", pid);
-		fd = open(buf, O_RDONLY, 0);
-		if (fd < 0)
-			continue;
-		len = read(fd, buf, sizeof buf - 1);
-		close(fd);
-		if (len < 40)
-			continue;
-		buf[len] = 0;
-		tmp = strrchr(buf, ')');
-		if (tmp)
-			*tmp = 0;
-		else
+		if (oval_proc_cache_stat(pid, &st) != 0)
 			continue;
-		memset(cmd_buffer + 1, 0, sizeof(cmd_buffer)-1); // clear cmd after starting '['
-		sscanf(buf, "%d (%15c", &ppid, cmd_buffer + 1);
-		sscanf(tmp+2,	"%c %d %d %d %d %d "
-				"%u %lu %lu %lu %lu "
-				"%lu %lu %lu %ld %ld "
-				"%ld %ld %ld %llu",
-			&state, &ppid, &pgrp, &session, &tty_nr, &tpgid,
-			&flags, &minflt, &cminflt, &majflt, &cmajflt,
-			&uutime, &ustime, &cutime, &cstime, &priority,
-			&cnice, &nthreads, &itrealvalue, &start
-		);
 
 		// Skip kthreads
-		if (ppid == 2)
+		if (st.ppid == 2)
 			continue;
 
+		memset(cmd_buffer + 1, 0, sizeof(cmd_buffer)-1); // clear cmd after starting '['
+		memcpy(cmd_buffer + 1, st.comm, sizeof(st.comm) - 1);
+
 		const char* cmd;
-		if (state == 'Z') { // zombie
+		if (st.state == 'Z') { // zombie
 			cmd = make_defunc_str(cmd_buffer);
 		} else {
-			snprintf(buf, PATH_MAX, "%s/proc/%d/cmdline", prefix ? prefix : "", pid);
-			if (get_process_cmdline(buf, cmdline_buffer)) {
-				cmd = oscap_buffer_get_raw(cmdline_buffer); // use full cmdline
+			cmdline = oval_proc_cache_cmdline(pid);
+			if (cmdline != NULL) {
+				cmd = cmdline; // use full cmdline
 			} else {
 				cmd = cmd_buffer + 1;
 			}
@@ -570,13 +455,31 @@ static int read_process(SEXP_t *cmd_ent, SEXP_t *pid_ent, probe_ctx *ctx)
 		    (pid_sexp == NULL || probe_entobj_cmp(pid_ent, pid_sexp) == OVAL_RESULT_TRUE)
 		) {
 			struct result_info r;
-			unsigned long t = uutime/ticks + ustime/ticks;
+			unsigned long t = st.utime/ticks + st.stime/ticks;
 			char tbuf[32], sbuf[32], *selinux_domain_label, **posix_capabilities;
 			int tday,tyear;
 			time_t s_time;
 			struct tm *proc, *now;
 			const char *fmt;
 
+			/* the filters are decided before the labels and capabilities are read */
+			if (probe_filters_active(ctx)) {
+				probe_field_t fields[] = {
+					{ "command_line", OVAL_DATATYPE_STRING, .value.str = cmd },
+					{ "pid",          OVAL_DATATYPE_INTEGER, .value.integer = pid },
+					{ "ppid",         OVAL_DATATYPE_INTEGER, .value.integer = st.ppid },
+					{ "priority",     OVAL_DATATYPE_INTEGER, .value.integer = st.priority },
+					{ "session_id",   OVAL_DATATYPE_INTEGER, .value.integer = st.session },
+				};
+
+				if (probe_filters_reject(ctx, fields, sizeof(fields) / sizeof(fields[0]))) {
+					SEXP_free(cmd_sexp);
+					SEXP_free(pid_sexp);
+					free(cmdline);
+					continue;
+				}
+			}
+
 			// Now get scheduler policy
 			sched_policy = sched_getscheduler(pid);
 			switch (sched_policy) {
@@ -607,7 +510,7 @@ static int read_process(SEXP_t *cmd_ent, SEXP_t *pid_ent, probe_ctx *ctx)
 			now = localtime(&s_time);
 			tyear = now->tm_year;
 			tday = now->tm_yday;
-			s_time = boot + (start / ticks);
+			s_time = boot + (st.start / ticks);
 			proc = localtime(&s_time);
 
 			// Select format based on how long we've been running
@@ -626,11 +529,11 @@ static int read_process(SEXP_t *cmd_ent, SEXP_t *pid_ent, probe_ctx *ctx)
 			r.command_line = cmd;
 			r.exec_time = convert_time(t, tbuf, sizeof(tbuf));
 			r.pid = pid;
-			r.ppid = ppid;
-			r.priority = priority;
+			r.ppid = st.ppid;
+			r.priority = st.priority;
 			r.start_time = sbuf;
 
-			dev_to_tty(tty_dev, sizeof(tty_dev), (dev_t) tty_nr, pid, ABBREV_DEV);
+			dev_to_tty(tty_dev, sizeof(tty_dev), (dev_t) st.tty_nr, pid, ABBREV_DEV);
 			r.tty = tty_dev;
 
 			r.exec_shield = (get_exec_shield_status(pid) > 0);
@@ -641,7 +544,7 @@ static int read_process(SEXP_t *cmd_ent, SEXP_t *pid_ent, probe_ctx *ctx)
 			posix_capabilities = get_posix_capability(pid, max_cap_id);
 			r.posix_capability = posix_capabilities;
 
-			r.session_id = session;
+			r.session_id = st.session;
 
 			get_uids(pid, &r);
 			report_finding(&r, ctx);
@@ -658,12 +561,12 @@ static int read_process(SEXP_t *cmd_ent, SEXP_t *pid_ent, probe_ctx *ctx)
 		}
 		SEXP_free(cmd_sexp);
 		SEXP_free(pid_sexp);
+		free(cmdline);
 	}
-        closedir(d);
-	oscap_buffer_free(cmdline_buffer);
+	free(pids);
 
 	if (!any_pid_dir_found) {
-		dW("No data about processes could be read from '%s'.", buf);
+		dW("No data about processes could be read from '%s/proc'.", prefix ? prefix : "");
 	}
 	// In offline mode, empty /proc might be a normal situation and doesn't
 	// have to mean permissions problems
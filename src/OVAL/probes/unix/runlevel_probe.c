@@ -53,6 +53,7 @@
 #undef _DEFAULT_SOURCE
 #define _DEFAULT_SOURCE
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
 #include <errno.h>
@@ -69,6 +70,8 @@
 #include <probe/entcmp.h>
 #include <probe/option.h>
 #include "common/debug_priv.h"
+#include "_probe-api.h"
+#include "oval_root.h"
 #include "runlevel_probe.h"
 
 #define RELEASENAME_MAX_SIZE	256
@@ -87,90 +90,124 @@ struct runlevel_rep {
 	struct runlevel_rep *next;
 };
 
-static int get_runlevel (struct runlevel_req *req, struct runlevel_rep **rep);
+/* all the services in all the runlevels, read once per scan */
+struct runlevel_snapshot {
+	int ret;	/* of get_runlevel */
+	struct runlevel_rep *rep;
+};
+
+static int get_runlevel (struct runlevel_rep **rep);
 
 #if defined(OS_LINUX) || defined(OS_SOLARIS)
-static int get_runlevel_sysv (struct runlevel_req *req, struct runlevel_rep **rep, bool suse, const char *init_path, const char *rc_path)
+/* the files are read inside of the root in the offline mode */
+static const char *runlevel_root(void)
+{
+	return getenv("OSCAP_PROBE_ROOT");
+}
+
+/* stat(2) of the entry name of the directory path, the links are followed inside of the root */
+static int runlevel_stat_entry(const char *path, const char *name, struct stat *st)
+{
+	char pathbuf[PATH_MAX];
+
+	if (snprintf(pathbuf, sizeof(pathbuf), "%s/%s", path, name) >= (int)sizeof(pathbuf)) {
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+	return oval_root_stat(runlevel_root(), pathbuf, st);
+}
+
+struct runlevel_link {
+	ino_t ino;
+	char type;	/* first character of the name */
+};
+
+/* the entries of a rcX.d directory in the readdir order */
+static struct runlevel_link *read_rc_dir(const char *path, size_t *count)
+{
+	DIR *rc_dir;
+	struct dirent *rc_dp;
+	struct stat rc_st;
+	struct runlevel_link *links = NULL;
+	size_t alloc = 0;
+
+	*count = 0;
+	rc_dir = oval_root_opendir(runlevel_root(), path);
+	if (rc_dir == NULL) {
+		dD("Can't open directory \"%s\": errno=%d, %s.",
+		   path, errno, strerror (errno));
+		return NULL;
+	}
+
+	while ((rc_dp = readdir(rc_dir)) != NULL) {
+		if (runlevel_stat_entry(path, rc_dp->d_name, &rc_st) != 0) {
+			dD("Can't stat file %s/%s: errno=%d, %s.",
+			   path, rc_dp->d_name, errno, strerror(errno));
+			continue;
+		}
+		if (*count == alloc) {
+			struct runlevel_link *new_links = realloc(links, (alloc + 32) * sizeof(struct runlevel_link));
+
+			if (new_links == NULL)
+				break;
+			links = new_links;
+			alloc += 32;
+		}
+		links[*count].ino = rc_st.st_ino;
+		links[*count].type = rc_dp->d_name[0];
+		(*count)++;
+	}
+	closedir(rc_dir);
+
+	/* an empty directory still counts as read */
+	return links != NULL ? links : malloc(sizeof(struct runlevel_link));
+}
+
+static int get_runlevel_sysv (struct runlevel_rep **rep, bool suse, const char *init_path, const char *rc_path)
 {
 	const char runlevel_list[] = {'0', '1', '2', '3', '4', '5', '6'};
+#define RUNLEVEL_COUNT (sizeof (runlevel_list) / sizeof (runlevel_list[0]))
 
 	char pathbuf[PATH_MAX];
-	DIR *init_dir, *rc_dir, *orig_dir;
-	struct dirent *init_dp, *rc_dp;
-	struct stat init_st, rc_st;
+	DIR *init_dir;
+	struct dirent *init_dp;
+	struct stat init_st;
 	struct runlevel_rep *rep_lst = NULL;
+	struct runlevel_link *rc_links[RUNLEVEL_COUNT];
+	size_t rc_counts[RUNLEVEL_COUNT];
+	unsigned int i;
 
-	_A(req != NULL);
 	_A(rep != NULL);
 
-	orig_dir = opendir(".");
-	if (orig_dir == NULL) {
-		dD("Can't open directory \".\": errno=%d, %s.", errno, strerror(errno));
-		return -1;
-	}
-	init_dir = opendir(init_path);
+	init_dir = oval_root_opendir(runlevel_root(), init_path);
 	if (init_dir == NULL) {
 		dD("Can't open directory \"%s\": errno=%d, %s.",
 		   init_path, errno, strerror (errno));
-		closedir(orig_dir);
 		return (-1);
 	}
 
-	while ((init_dp = readdir(init_dir)) != NULL) {
-		char *service_name;
-		unsigned int i;
-		SEXP_t *r0;
-
-		// Ensure that we are in the expected directory before
-		// touching relative paths
-		if (fchdir(dirfd(init_dir)) != 0) {
-			dD("Can't fchdir to \"%s\": errno=%d, %s.",
-			   init_path, errno, strerror (errno));
-			closedir(init_dir);
-			closedir(orig_dir);
-			return -1;
-		}
+	/* each rcX.d directory is read once, not once per service */
+	for (i = 0; i < RUNLEVEL_COUNT; ++i) {
+		snprintf(pathbuf, sizeof (pathbuf), rc_path, runlevel_list[i]);
+		rc_links[i] = read_rc_dir(pathbuf, &rc_counts[i]);
+	}
 
-		if (stat(init_dp->d_name, &init_st) != 0) {
+	while ((init_dp = readdir(init_dir)) != NULL) {
+		if (runlevel_stat_entry(init_path, init_dp->d_name, &init_st) != 0) {
 			dD("Can't stat file %s/%s: errno=%d, %s.",
 			   init_path, init_dp->d_name, errno, strerror(errno));
 			continue;
 		}
 
-		r0 = SEXP_string_newf("%s", init_dp->d_name);
-		if (probe_entobj_cmp(req->service_name_ent, r0) != OVAL_RESULT_TRUE) {
-			SEXP_free(r0);
-			continue;
-		}
-		SEXP_free(r0);
-		service_name = init_dp->d_name;
-
-		for (i = 0; i < (sizeof (runlevel_list) / sizeof (runlevel_list[0])); ++i) {
+		for (i = 0; i < RUNLEVEL_COUNT; ++i) {
 			char runlevel[2] = {'\0', '\0'};
 			bool start, kill;
+			size_t j;
 
-			r0 = SEXP_string_newf("%c", runlevel_list[i]);
-			if (probe_entobj_cmp(req->runlevel_ent, r0) != OVAL_RESULT_TRUE) {
-				SEXP_free(r0);
+			if (rc_links[i] == NULL)
 				continue;
-			}
-			SEXP_free(r0);
 			runlevel[0] = runlevel_list[i];
 
-			snprintf(pathbuf, sizeof (pathbuf), rc_path, runlevel_list[i]);
-			rc_dir = opendir(pathbuf);
-			if (rc_dir == NULL) {
-				dD("Can't open directory \"%s\": errno=%d, %s.",
-				   rc_path, errno, strerror (errno));
-				continue;
-			}
-			if (chdir(pathbuf) != 0) {
-				dD("Can't fchdir to \"%s\": errno=%d, %s.",
-				   rc_path, errno, strerror (errno));
-				closedir(rc_dir);
-				continue;
-			}
-
 			// On SUSE, the presence of a symbolic link to the init.d/<service> in
 			// a runlevel directory rcx.d implies that the sevice is started on x.
 
@@ -181,17 +218,13 @@ static int get_runlevel_sysv (struct runlevel_req *req, struct runlevel_rep **re
 			else
 				start = kill = false;
 
-			while ((rc_dp = readdir(rc_dir)) != NULL) {
-				if (stat(rc_dp->d_name, &rc_st) != 0) {
-					dD("Can't stat file %s/%s: errno=%d, %s.",
-					   rc_path, rc_dp->d_name, errno, strerror(errno));
-					continue;
-				}
+			for (j = 0; j < rc_counts[i]; ++j) {
+				const struct runlevel_link *link = &rc_links[i][j];
 
-				if (init_st.st_ino == rc_st.st_ino) {
+				if (init_st.st_ino == link->ino) {
 
 					if (suse) {
-						if (rc_dp->d_name[0] == 'S') {
+						if (link->type == 'S') {
 
 							start = true;
 							kill = false;
@@ -200,20 +233,19 @@ static int get_runlevel_sysv (struct runlevel_req *req, struct runlevel_rep **re
 						}
 					}
 					else {
-						if (rc_dp->d_name[0] == 'S') {
+						if (link->type == 'S') {
 							start = true;
 							break;
-						} else if (rc_dp->d_name[0] == 'K') {
+						} else if (link->type == 'K') {
 							kill = true;
 							break;
 						} else {
-							dD("Unexpected character in filename: %c, %s/%s.",
-							   rc_dp->d_name[0], pathbuf, rc_dp->d_name);
+							dD("Unexpected character in filename: %c, runlevel %c.",
+							   link->type, runlevel_list[i]);
 						}
 					}
 				}
 			}
-			closedir(rc_dir);
 
 			if (rep_lst == NULL) {
 				rep_lst = *rep = malloc(sizeof (struct runlevel_rep));
@@ -222,7 +254,7 @@ static int get_runlevel_sysv (struct runlevel_req *req, struct runlevel_rep **re
 				rep_lst = rep_lst->next;
 			}
 
-			rep_lst->service_name = strdup(service_name);
+			rep_lst->service_name = strdup(init_dp->d_name);
 			rep_lst->runlevel = strdup(runlevel);
 			rep_lst->start = start;
 			rep_lst->kill = kill;
@@ -231,16 +263,14 @@ static int get_runlevel_sysv (struct runlevel_req *req, struct runlevel_rep **re
 	}
 	closedir(init_dir);
 
-	if (fchdir(dirfd(orig_dir)) == -1) {
-		dE("Can't fchdir back to original working directory: errno=%d, %s.", errno, strerror(errno));
-		return -1;
-	}
-	closedir(orig_dir);
+	for (i = 0; i < RUNLEVEL_COUNT; ++i)
+		free(rc_links[i]);
+#undef RUNLEVEL_COUNT
 
 	return (1);
 }
 
-static int get_runlevel_redhat (struct runlevel_req *req, struct runlevel_rep **rep)
+static int get_runlevel_redhat (struct runlevel_rep **rep)
 {
 #if defined(OS_LINUX)
 	const char *init_path = "/etc/rc.d/init.d";
@@ -250,49 +280,49 @@ static int get_runlevel_redhat (struct runlevel_req *req, struct runlevel_rep **
 	const char *rc_path = "/etc/rc%c.d";
 
 	bool suse = false;
-	return (get_runlevel_sysv (req, rep, suse, init_path, rc_path));
+	return (get_runlevel_sysv (rep, suse, init_path, rc_path));
 }
 
-static int get_runlevel_debian (struct runlevel_req *req, struct runlevel_rep **rep)
+static int get_runlevel_debian (struct runlevel_rep **rep)
 {
         return (-1);
 }
 
-static int get_runlevel_slack (struct runlevel_req *req, struct runlevel_rep **rep)
+static int get_runlevel_slack (struct runlevel_rep **rep)
 {
         return (-1);
 }
 
-static int get_runlevel_gentoo (struct runlevel_req *req, struct runlevel_rep **rep)
+static int get_runlevel_gentoo (struct runlevel_rep **rep)
 {
         return (-1);
 }
 
-static int get_runlevel_arch (struct runlevel_req *req, struct runlevel_rep **rep)
+static int get_runlevel_arch (struct runlevel_rep **rep)
 {
         return (-1);
 }
 
-static int get_runlevel_mandriva (struct runlevel_req *req, struct runlevel_rep **rep)
+static int get_runlevel_mandriva (struct runlevel_rep **rep)
 {
         return (-1);
 }
 
-static int get_runlevel_suse (struct runlevel_req *req, struct runlevel_rep **rep)
+static int get_runlevel_suse (struct runlevel_rep **rep)
 {
 	const char *init_path = "/etc/init.d";
 	const char *rc_path = "/etc/init.d/rc%c.d";
 
 	bool suse = true;
-	return (get_runlevel_sysv (req, rep, suse, init_path, rc_path));
+	return (get_runlevel_sysv (rep, suse, init_path, rc_path));
 }
 
-static int get_runlevel_wrlinux (struct runlevel_req *req, struct runlevel_rep **rep)
+static int get_runlevel_wrlinux (struct runlevel_rep **rep)
 {
         return (-1);
 }
 
-static int get_runlevel_common (struct runlevel_req *req, struct runlevel_rep **rep)
+static int get_runlevel_common (struct runlevel_rep **rep)
 {
         return (-1);
 }
@@ -313,7 +343,7 @@ static int get_runlevel_common (struct runlevel_req *req, struct runlevel_rep **
  */
 static int parse_os_release(const char *cpe)
 {
-	FILE *osrelease = fopen("/etc/os-release", "r");
+	FILE *osrelease = oval_root_fopen(runlevel_root(), "/etc/os-release");
 	if (osrelease == NULL)
 		// we cound't match the CPE because we couldn't open the file
 		return 0;
@@ -344,58 +374,58 @@ done:
 static int is_redhat (void)
 {
         struct stat st;
-        return (stat ("/etc/redhat-release", &st) == 0);
+        return (oval_root_stat(runlevel_root(), "/etc/redhat-release", &st) == 0);
 }
 
 static int is_debian (void)
 {
         struct stat st;
-        return (stat ("/etc/debian_version", &st) == 0 ||
-                stat ("/etc/debian_release", &st) == 0);
+        return (oval_root_stat(runlevel_root(), "/etc/debian_version", &st) == 0 ||
+                oval_root_stat(runlevel_root(), "/etc/debian_release", &st) == 0);
 }
 
 static int is_slack (void)
 {
         struct stat st;
-        return (stat ("/etc/slackware-release", &st) == 0);
+        return (oval_root_stat(runlevel_root(), "/etc/slackware-release", &st) == 0);
 }
 
 static int is_gentoo (void)
 {
         struct stat st;
-        return (stat ("/etc/gentoo-release", &st) == 0);
+        return (oval_root_stat(runlevel_root(), "/etc/gentoo-release", &st) == 0);
 }
 
 static int is_arch (void)
 {
         struct stat st;
-        return (stat ("/etc/arch-release", &st) == 0);
+        return (oval_root_stat(runlevel_root(), "/etc/arch-release", &st) == 0);
 }
 
 static int is_mandriva (void)
 {
         struct stat st;
-        return (stat ("/etc/mandriva-release", &st) == 0);
+        return (oval_root_stat(runlevel_root(), "/etc/mandriva-release", &st) == 0);
 }
 
 static int is_suse (void)
 {
         struct stat st;
-        return (stat ("/etc/SuSE-release", &st)   == 0 ||
-                stat ("/etc/sles-release", &st)   == 0 ||
-                stat ("/etc/novell-release", &st) == 0);
+        return (oval_root_stat(runlevel_root(), "/etc/SuSE-release", &st)   == 0 ||
+                oval_root_stat(runlevel_root(), "/etc/sles-release", &st)   == 0 ||
+                oval_root_stat(runlevel_root(), "/etc/novell-release", &st) == 0);
 }
 
 static int is_solaris (void)
 {
         struct stat st;
-        return (stat ("/etc/release", &st)   == 0);
+        return (oval_root_stat(runlevel_root(), "/etc/release", &st)   == 0);
 }
 
 static int is_oracle (void)
 {
         struct stat st;
-        return (stat ("/etc/oracle-release", &st)   == 0);
+        return (oval_root_stat(runlevel_root(), "/etc/oracle-release", &st)   == 0);
 }
 
 static int is_wrlinux(void)
@@ -410,7 +440,7 @@ static int is_common (void)
 
 typedef struct {
         int (*distrop)(void);
-        int (*get_runlevel)(struct runlevel_req *, struct runlevel_rep **);
+        int (*get_runlevel)(struct runlevel_rep **);
 } distro_tbl_t;
 
 const distro_tbl_t distro_tbl[] = {
@@ -429,16 +459,15 @@ const distro_tbl_t distro_tbl[] = {
 
 #define DISTRO_TBL_SIZE ((sizeof distro_tbl)/sizeof (distro_tbl_t))
 
-static int get_runlevel_generic (struct runlevel_req *req, struct runlevel_rep **rep)
+static int get_runlevel_generic (struct runlevel_rep **rep)
 {
         uint16_t i;
 
-        _A(req != NULL);
         _A(rep != NULL);
 
         for (i = 0; i < DISTRO_TBL_SIZE; ++i)
                 if (distro_tbl[i].distrop ())
-                        return distro_tbl[i].get_runlevel (req, rep);
+                        return distro_tbl[i].get_runlevel (rep);
 
         abort ();
 
@@ -448,18 +477,16 @@ static int get_runlevel_generic (struct runlevel_req *req, struct runlevel_rep *
 #endif
 
 #define CONCAT(a, b) a ## b
-#define GET_RUNLEVEL(d, q, p) CONCAT(get_runlevel_, d) (q, p)
+#define GET_RUNLEVEL(d, p) CONCAT(get_runlevel_, d) (p)
 
-static int get_runlevel (struct runlevel_req *req, struct runlevel_rep **rep)
+static int get_runlevel (struct runlevel_rep **rep)
 {
-        _A(req != NULL);
         _A(rep != NULL);
-        return GET_RUNLEVEL(LINUX_DISTRO, req, rep);
+        return GET_RUNLEVEL(LINUX_DISTRO, rep);
 }
 #elif defined(OS_FREEBSD)
-static int get_runlevel (struct runlevel_req *req, struct runlevel_rep **rep)
+static int get_runlevel (struct runlevel_rep **rep)
 {
-        _A(req != NULL);
         _A(rep != NULL);
         return (-1);
 }
@@ -469,14 +496,49 @@ static int get_runlevel (struct runlevel_req *req, struct runlevel_rep **rep)
 
 int runlevel_probe_offline_mode_supported()
 {
-	return PROBE_OFFLINE_CHROOT;
+	return PROBE_OFFLINE_OWN;
+}
+
+static void runlevel_snapshot_free(void *ptr)
+{
+	struct runlevel_snapshot *snapshot = ptr;
+	struct runlevel_rep *next_rep;
+
+	while (snapshot->rep != NULL) {
+		next_rep = snapshot->rep->next;
+		free(snapshot->rep->service_name);
+		free(snapshot->rep->runlevel);
+		free(snapshot->rep);
+		snapshot->rep = next_rep;
+	}
+	free(snapshot);
+}
+
+static void *runlevel_snapshot_new(void *arg)
+{
+	struct runlevel_snapshot *snapshot = calloc(1, sizeof(struct runlevel_snapshot));
+
+	if (snapshot == NULL)
+		return NULL;
+	snapshot->ret = get_runlevel(&snapshot->rep);
+	return snapshot;
+}
+
+static bool runlevel_matches(SEXP_t *ent, const char *value)
+{
+	SEXP_t *r0 = SEXP_string_new(value, strlen(value));
+	bool match = probe_entobj_cmp(ent, r0) == OVAL_RESULT_TRUE;
+
+	SEXP_free(r0);
+	return match;
 }
 
 int runlevel_probe_main(probe_ctx *ctx, void *arg)
 {
         SEXP_t *object;
         struct runlevel_req request_st;
-        struct runlevel_rep *reply_st = NULL;
+        struct runlevel_snapshot *snapshot;
+        probe_memo_t *memo;
 
         object = probe_ctx_getobject(ctx);
 
@@ -495,7 +557,11 @@ int runlevel_probe_main(probe_ctx *ctx, void *arg)
 		return PROBE_ENOELM;
 	}
 
-	if (get_runlevel(&request_st, &reply_st) == -1) {
+	/* the services are listed once, the objects only filter the list */
+	memo = probe_memo_acquire("runlevel", runlevel_snapshot_new, NULL, runlevel_snapshot_free);
+	snapshot = memo != NULL ? probe_memo_value(memo) : NULL;
+
+	if (snapshot == NULL || snapshot->ret == -1) {
 		SEXP_t *msg;
 
 		msg = probe_msg_creat(OVAL_MESSAGE_LEVEL_ERROR, "get_runlevel failed.");
@@ -503,10 +569,14 @@ int runlevel_probe_main(probe_ctx *ctx, void *arg)
 		SEXP_free(msg);
 		probe_cobj_set_flag(probe_ctx_getresult(ctx), SYSCHAR_FLAG_ERROR);
 	} else {
-		struct runlevel_rep *next_rep;
+		const struct runlevel_rep *reply_st;
 		SEXP_t *item;
 
-		while (reply_st != NULL) {
+		for (reply_st = snapshot->rep; reply_st != NULL; reply_st = reply_st->next) {
+			if (!runlevel_matches(request_st.service_name_ent, reply_st->service_name) ||
+			    !runlevel_matches(request_st.runlevel_ent, reply_st->runlevel))
+				continue;
+
 			dD("get_runlevel: [0]=\"%s\", [1]=\"%s\", [2]=\"%d\", [3]=\"%d\"",
 			   reply_st->service_name, reply_st->runlevel, reply_st->start, reply_st->kill);
 
@@ -518,14 +588,9 @@ int runlevel_probe_main(probe_ctx *ctx, void *arg)
                                                  NULL);
 
                         probe_item_collect(ctx, item);
-
-			next_rep = reply_st->next;
-			free(reply_st->service_name);
-			free(reply_st->runlevel);
-			free(reply_st);
-			reply_st = next_rep;
 		}
         }
+        probe_memo_release(memo);
 
         SEXP_free(request_st.runlevel_ent);
         SEXP_free(request_st.service_name_ent);
@@ -77,6 +77,7 @@ int shadow_probe_main(probe_ctx *ctx, void *arg)
 #else
 /* shadow.h is present */
 #include <shadow.h>
+#include "oval_account_cache.h"
 
 static oval_schema_version_t over;
 
@@ -177,36 +178,63 @@ static void report_finding(struct result_info *res, probe_ctx *ctx)
         SEXP_free_r(&se_flg_mem);
 }
 
+static void process_shadow(const struct spwd *pw, SEXP_t *un_ent, probe_ctx *ctx)
+{
+	SEXP_t *un;
+
+	dI("Have user: %s", pw->sp_namp);
+	un = SEXP_string_newf("%s", pw->sp_namp);
+	if (probe_entobj_cmp(un_ent, un) == OVAL_RESULT_TRUE) {
+		struct result_info r;
+
+		r.username = pw->sp_namp;
+		r.password = pw->sp_pwdp;
+		r.chg_lst = pw->sp_lstchg;
+		r.chg_allow = pw->sp_min;
+		r.chg_req = pw->sp_max;
+		r.exp_warn = pw->sp_warn;
+		r.exp_inact = pw->sp_inact;
+		r.exp_date = pw->sp_expire;
+		r.flag = pw->sp_flag;
+
+		report_finding(&r, ctx);
+	}
+	SEXP_free(un);
+}
+
 static int read_shadow(SEXP_t *un_ent, probe_ctx *ctx)
 {
-	int err = 1;
-	struct spwd *pw;
-
-	while ((pw = getspent())) {
-		SEXP_t *un;
-
-		dI("Have user: %s", pw->sp_namp);
-		err = 0;
-		un = SEXP_string_newf("%s", pw->sp_namp);
-		if (probe_entobj_cmp(un_ent, un) == OVAL_RESULT_TRUE) {
-			struct result_info r;
-
-			r.username = pw->sp_namp;
-			r.password = pw->sp_pwdp;
-			r.chg_lst = pw->sp_lstchg;
-			r.chg_allow = pw->sp_min;
-			r.chg_req = pw->sp_max;
-			r.exp_warn = pw->sp_warn;
-			r.exp_inact = pw->sp_inact;
-			r.exp_date = pw->sp_expire;
-			r.flag = pw->sp_flag;
-
-			report_finding(&r, ctx);
+	const struct spwd *pw;
+	oval_account_db_t *db;
+	char **names;
+	size_t i;
+
+	/* the accounts are enumerated once per scan */
+	db = oval_account_cache_shadow(NULL);
+	if (db == NULL)
+		return 1;
+	if (oval_account_cache_shadow_at(db, 0) == NULL) {
+		oval_account_cache_release(db);
+		return 1;
+	}
+
+	names = probe_entobj_equal_strings(un_ent);
+	if (names != NULL) {
+		/* direct lookup for the "equals" op */
+		for (i = 0; names[i] != NULL; ++i) {
+			pw = oval_account_cache_shadow_by_name(db, names[i]);
+			if (pw != NULL)
+				process_shadow(pw, un_ent, ctx);
+			free(names[i]);
 		}
-		SEXP_free(un);
+		free(names);
+	} else {
+		for (i = 0; (pw = oval_account_cache_shadow_at(db, i)) != NULL; ++i)
+			process_shadow(pw, un_ent, ctx);
 	}
-	endspent();
-	return err;
+	oval_account_cache_release(db);
+
+	return 0;
 }
 
 int shadow_probe_main(probe_ctx *ctx, void *arg)
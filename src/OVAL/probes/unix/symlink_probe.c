@@ -40,6 +40,8 @@
 #include <limits.h>
 #include <stdlib.h>
 #include "oscap_helpers.h"
+#include "oval_realpath_cache.h"
+#include "oval_root.h"
 
 #include <probe/probe.h>
 #include <probe/option.h>
@@ -51,6 +53,7 @@ static int collect_symlink(SEXP_t *ent, probe_ctx *ctx)
 	struct stat sb;
 	char *linkname;
 	char resolved_name[PATH_MAX];
+	const char *root = getenv("OSCAP_PROBE_ROOT");
 
 	ent_val = probe_ent_getval(ent);
 	char *pathname = SEXP_string_cstr(ent_val);
@@ -59,7 +62,7 @@ static int collect_symlink(SEXP_t *ent, probe_ctx *ctx)
 		return PROBE_EINVAL;
 	}
 
-	if (lstat(pathname, &sb) == -1) {
+	if (oval_root_lstat(root, pathname, &sb) == -1) {
 		if (errno == ENOENT) {
 			/* File does not exist.
 			 * Resulting item should have a status of "does not exist". */
@@ -87,7 +90,8 @@ static int collect_symlink(SEXP_t *ent, probe_ctx *ctx)
 		return 0;
 	}
 
-	linkname = oscap_realpath(pathname, resolved_name);
+	/* the links shared by the objects are read once */
+	linkname = oval_realpath_cache_resolve_in(root != NULL && *root != '\0' ? root : NULL, pathname, resolved_name);
 	if (linkname == NULL) {
 		if (errno == ENOENT) {
 			msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR,
@@ -118,7 +122,7 @@ static int collect_symlink(SEXP_t *ent, probe_ctx *ctx)
 
 int symlink_probe_offline_mode_supported()
 {
-	return PROBE_OFFLINE_CHROOT;
+	return PROBE_OFFLINE_OWN;
 }
 
 int symlink_probe_main(probe_ctx *ctx, void *probe_arg)
@@ -34,6 +34,9 @@
 #include "probe/entcmp.h"
 #include "sysctl_probe.h"
 
+/* the name is compared with all of its values, one walk serves them all */
+const char *const sysctl_probe_multival_entities[] = { "name", NULL };
+
 #if defined(OS_FREEBSD)
 #include <stdio.h>
 #include <stdlib.h>
@@ -49,234 +52,142 @@
 #if defined(OS_LINUX)
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 #include <errno.h>
-#include <limits.h>
-#include "oval_fts.h"
+#include "oval_sysctl_cache.h"
 #include "common/debug_priv.h"
 
-#define PROC_SYS_DIR "/proc/sys"
-#define PROC_SYS_MAXDEPTH 7
-
-int sysctl_probe_main(probe_ctx *ctx, void *probe_arg)
+static void collect_sysctl(probe_ctx *ctx, SEXP_t *name_entity, const char *mib, int over_cmp)
 {
-        OVAL_FTS    *ofts;
-        OVAL_FTSENT *ofts_ent;
-
-        SEXP_t *name_entity, *probe_in;
-        SEXP_t *r0, *r1, *r2, *r3;
-        SEXP_t *ent_attrs, *bh_entity, *path_entity, *filename_entity;
-        oval_schema_version_t over;
-        int over_cmp;
+        SEXP_t *se_mib, *item;
+        char    sysval[OVAL_SYSCTL_VALUE_MAX + 1];
+        char   *sysvals[512];
+        size_t  i, l, s;
+        int     ret;
 
-	const char *ipv6_conf_path = "/proc/sys/net/ipv6/conf/";
-	size_t ipv6_conf_path_len = strlen(ipv6_conf_path);
+        dD("MIB: %s", mib);
+        se_mib = SEXP_string_new(mib, strlen(mib));
 
-        probe_in    = probe_ctx_getobject(ctx);
-        name_entity = probe_obj_getent(probe_in, "name", 1);
-        over        = probe_obj_get_platform_schema_version(probe_in);
-        over_cmp    = oval_schema_version_cmp(over, OVAL_SCHEMA_VERSION(5.10));
-
-        if (name_entity == NULL) {
-                dE("Missing \"name\" entity in the input object");
-                return (PROBE_ENOENT);
+        if (probe_entobj_cmp(name_entity, se_mib) != OVAL_RESULT_TRUE) {
+                SEXP_free(se_mib);
+                return;
         }
 
-        /*
-         * prepare behaviors
-         */
-        ent_attrs = probe_attr_creat("max_depth",           r0 = SEXP_string_newf("%d", PROC_SYS_MAXDEPTH),
-                                     "recurse_direction",   r1 = SEXP_string_new("down", 4),
-                                     "recurse_file_system", r2 = SEXP_string_new("all", 3),
-                                     "recurse", r3 = SEXP_string_new("symlinks and directories", 24),
-                                     NULL);
-        bh_entity = probe_ent_creat1("behaviors", ent_attrs, NULL);
-	SEXP_free(r0);
-	SEXP_free(r1);
-	SEXP_free(r2);
-	SEXP_free(r3);
-	SEXP_free(ent_attrs);
+        dD("MIB match");
 
         /*
-         * prepare path, filename
+         * read sysctl value, once per scan
          */
-        ent_attrs = probe_attr_creat("operation", r0 = SEXP_number_newi(OVAL_OPERATION_EQUALS),
-                                     NULL);
-        path_entity = probe_ent_creat1("path", ent_attrs, r1 = SEXP_string_new(PROC_SYS_DIR, strlen(PROC_SYS_DIR)));
-	SEXP_free(r0);
-	SEXP_free(r1);
-	SEXP_free(ent_attrs);
-
-        ent_attrs = probe_attr_creat("operation", r0 = SEXP_number_newi(OVAL_OPERATION_PATTERN_MATCH),
-                                     NULL);
-        filename_entity = probe_ent_creat1("filename", ent_attrs, r1 = SEXP_string_new(".*", 2));
-	SEXP_free(r0);
-	SEXP_free(r1);
-	SEXP_free(ent_attrs);
+        ret = oval_sysctl_cache_value(mib, sysval, &l);
+
+        if (ret < 0) {
+		item = probe_item_create(OVAL_UNIX_SYSCTL, NULL, NULL);
+                probe_item_setstatus(item, SYSCHAR_STATUS_ERROR);
+                probe_item_collect(ctx, item);
+                SEXP_free(se_mib);
+                return;
+        }
+
+	/* Skip empty values as sysctl tool does.
+	 * See https://bugzilla.redhat.com/show_bug.cgi?id=1473207
+	 */
+	if (ret > 0 || l == 0) {
+		dD("Skipping sysctl '%s' because it has no value.", mib);
+		SEXP_free(se_mib);
+		return;
+	}
 
         /*
-         * collect sysctls
-         *  XXX: use direct access for the "equals" op
+         * sanitize the value
+         *  - only printable and whitespace chars allowed
+         *  - remove the last '\n'
          */
-        ofts = oval_fts_open_prefixed(NULL, path_entity, filename_entity, NULL, bh_entity, probe_ctx_getresult(ctx));
-
-        if (ofts == NULL) {
-                dE("oval_fts_open_prefixed(%s, %s) failed", PROC_SYS_DIR, ".\\+");
-		SEXP_free(path_entity);
-		SEXP_free(filename_entity);
-		SEXP_free(bh_entity);
-		SEXP_free(name_entity);
+        sysvals[0] = sysval;
+
+        for(s = 0, i = 0; i < l && s < sizeof sysvals/sizeof(char *) - 1; ++i) {
+                if ((!isprint(sysval[i]) && !isspace(sysval[i]))
+                    || (over_cmp >= 0 && sysval[i] == '\n' /* OVAL 5.10 and above */))
+                {
+                        sysval[i] = '\0';
+                        sysvals[++s] = sysval + i + 1;
+                }
+        }
 
-                return (PROBE_EFATAL);
+        if (sysval[l - 1] == '\n')
+                sysval[l - 1] = '\0';
+        else
+                sysval[l] = '\0';
+
+        if (strlen(sysvals[s]) == 0)
+                sysvals[s] = NULL;
+        else
+                sysvals[++s] = NULL;
+
+        if (over_cmp >= 0) {
+                /* Only in OVAL 5.10 and above */
+                item = probe_item_create(OVAL_UNIX_SYSCTL, NULL,
+                                         "name",  OVAL_DATATYPE_SEXP,   se_mib,
+                                         "value", OVAL_DATATYPE_STRING_M, sysvals,
+                                         NULL);
+        } else {
+                item = probe_item_create(OVAL_UNIX_SYSCTL, NULL,
+                                         "name",  OVAL_DATATYPE_SEXP,   se_mib,
+                                         "value", OVAL_DATATYPE_STRING, sysval,
+                                         NULL);
         }
 
-        while ((ofts_ent = oval_fts_read(ofts)) != NULL) {
-                SEXP_t *se_mib;
-                char    mibpath[PATH_MAX], *mib;
-                size_t  miblen;
-		struct stat file_stat;
+        probe_item_collect(ctx, item);
+        SEXP_free(se_mib);
+}
 
-                snprintf(mibpath, sizeof mibpath, "%s/%s", ofts_ent->path, ofts_ent->file);
+int sysctl_probe_main(probe_ctx *ctx, void *probe_arg)
+{
+        SEXP_t *name_entity, *probe_in;
+        oval_schema_version_t over;
+        int over_cmp;
+        char **mibs;
 
-		/* Skip write-only files, eg. /proc/sys/net/ipv4/route/flush */
-		if (stat(mibpath, &file_stat) == -1) {
-			dE("Stat failed on %s: %u, %s", mibpath, errno, strerror(errno));
-			oval_ftsent_free(ofts_ent);
-			continue;
-		}
-		/* the sysctl utility uses same condition in sysctl.c in ReadSetting() */
-		if ((file_stat.st_mode & S_IRUSR) == 0) {
-			dD("Skipping write-only file %s", mibpath);
-			oval_ftsent_free(ofts_ent);
-			continue;
-		}
+        probe_in    = probe_ctx_getobject(ctx);
+        name_entity = probe_obj_getent(probe_in, "name", 1);
+        over        = probe_obj_get_platform_schema_version(probe_in);
+        over_cmp    = oval_schema_version_cmp(over, OVAL_SCHEMA_VERSION(5.10));
 
-                mib    = strdup(mibpath + strlen(PROC_SYS_DIR) + 1);
-                miblen = strlen(mib);
+        if (name_entity == NULL) {
+                dE("Missing \"name\" entity in the input object");
+                return (PROBE_ENOENT);
+        }
 
-                while (miblen > 0) {
-                        if(mib[miblen - 1] == '/')
-                                mib[miblen - 1] = '.';
-                        --miblen;
+        mibs = probe_entobj_equal_strings(name_entity);
+        if (mibs != NULL) {
+                /* direct access for the "equals" op */
+                size_t i;
+
+                for (i = 0; mibs[i] != NULL; ++i)
+                        collect_sysctl(ctx, name_entity, mibs[i], over_cmp);
+                for (i = 0; mibs[i] != NULL; ++i)
+                        free(mibs[i]);
+                free(mibs);
+        } else {
+                /* all the sysctls, walked once per scan */
+                oval_sysctl_names_t *names = oval_sysctl_cache_names();
+                const char *mib;
+                size_t i;
+
+                if (names == NULL) {
+                        dE("Can't read the sysctls from /proc/sys");
+                        SEXP_free(name_entity);
+
+                        return (PROBE_EFATAL);
                 }
 
-                dD("MIB: %s", mib);
-                se_mib = SEXP_string_new(mib, strlen(mib));
-                free(mib);
-
-                if (probe_entobj_cmp(name_entity, se_mib) == OVAL_RESULT_TRUE) {
-                        FILE   *fp;
-                        SEXP_t *item;
-                        char    sysval[8192];
-                        char   *sysvals[512];
-                        long i, l;
-                        size_t s;
-
-                        dD("MIB match");
-
-                        /*
-                         * read sysctl value
-                         */
-                        fp = fopen(mibpath, "r");
-
-                        if (fp == NULL) {
-                                dE("Can't read sysctl value from \"%s\": %u, %s",
-                                   mibpath, errno, strerror(errno));
-                                goto fail_item;
-                        }
-
-                        l = fread(sysval, 1, sizeof sysval - 1, fp);
-
-                        if (ferror(fp)) {
-				/* Linux 4.1.0 introduced a per-NIC IPv6 stable_secret file.
-				 * The stable_secret file cannot be read until it is set,
-				 * so we skip it when it is not readable. Otherwise we collect it.
-				 */
-				if (strncmp(ofts_ent->path, ipv6_conf_path, ipv6_conf_path_len) == 0 &&
-						strcmp(ofts_ent->file, "stable_secret") == 0) {
-					dD("Skipping file %s", mibpath);
-					oval_ftsent_free(ofts_ent);
-					SEXP_free(se_mib);
-					fclose(fp);
-					continue;
-				} else {
-					dE("An error ocured when reading from \"%s\" (fp=%p): l=%ld, %u, %s",
-						mibpath, fp, l, errno, strerror(errno));
-					goto fail_item;
-				}
-                        }
-
-                        fclose(fp);
-
-			/* Skip empty values as sysctl tool does.
-			 * See https://bugzilla.redhat.com/show_bug.cgi?id=1473207
-			 */
-			if (l == 0) {
-				dD("Skipping file '%s' because it has no value.", mibpath);
-				oval_ftsent_free(ofts_ent);
-				SEXP_free(se_mib);
-				continue;
-			}
-
-                        /*
-                         * sanitize the value
-                         *  - only printable and whitespace chars allowed
-                         *  - remove the last '\n'
-                         */
-                        sysvals[0] = sysval;
-
-                        for(s = 0, i = 0; i < l && s < sizeof sysvals/sizeof(char *) - 1; ++i) {
-	                        if ((!isprint(sysval[i]) && !isspace(sysval[i]))
-	                            || (over_cmp >= 0 && sysval[i] == '\n' /* OVAL 5.10 and above */))
-                                {
-                                        sysval[i] = '\0';
-                                        sysvals[++s] = sysval + i + 1;
-                                }
-                        }
-
-                        if (sysval[l - 1] == '\n')
-                                sysval[l - 1] = '\0';
-                        else
-                                sysval[l] = '\0';
-
-                        if (strlen(sysvals[s]) == 0)
-                                sysvals[s] = NULL;
-                        else
-                                sysvals[++s] = NULL;
-
-                        if (over_cmp >= 0) {
-	                        /* Only in OVAL 5.10 and above */
-	                        item = probe_item_create(OVAL_UNIX_SYSCTL, NULL,
-	                                                 "name",  OVAL_DATATYPE_SEXP,   se_mib,
-	                                                 "value", OVAL_DATATYPE_STRING_M, sysvals,
-	                                                 NULL);
-                        } else {
-	                        item = probe_item_create(OVAL_UNIX_SYSCTL, NULL,
-	                                                 "name",  OVAL_DATATYPE_SEXP,   se_mib,
-	                                                 "value", OVAL_DATATYPE_STRING, sysval,
-	                                                 NULL);
-                        }
-
-                        goto add_item;
-                fail_item:
-                        if (fp != NULL)
-                                fclose(fp);
-
-			item = probe_item_create(OVAL_UNIX_SYSCTL, NULL, NULL);
-                        probe_item_setstatus(item, SYSCHAR_STATUS_ERROR);
-                add_item:
-                        probe_item_collect(ctx, item);
-                }
+                for (i = 0; (mib = oval_sysctl_cache_name(names, i)) != NULL; ++i)
+                        collect_sysctl(ctx, name_entity, mib, over_cmp);
 
-                oval_ftsent_free(ofts_ent);
-                SEXP_free(se_mib);
+                oval_sysctl_cache_names_release(names);
         }
 
-        oval_fts_close(ofts);
-	SEXP_free(path_entity);
-	SEXP_free(filename_entity);
-	SEXP_free(bh_entity);
 	SEXP_free(name_entity);
 
         return (0);
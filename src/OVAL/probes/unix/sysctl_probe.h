@@ -26,5 +26,6 @@
 #include "probe-api.h"
 
 int sysctl_probe_main(probe_ctx *ctx, void *arg);
+extern const char *const sysctl_probe_multival_entities[];
 
 #endif /* OPENSCAP_SYSCTL_PROBE_H */
@@ -52,16 +52,21 @@
 #include <bfind.h>
 #include <common/debug_priv.h>
 #include <netdb.h>
+#include <pthread.h>
 
 #if defined(OS_FREEBSD)
 #include <arpa/inet.h>
 #endif
 
 #include "../SEAP/generic/rbt/rbt.h"
+#include "oval_root.h"
 #include "xinetd_probe.h"
 
 #define PATH_SEPARATOR '/'
 
+/* the configuration is read inside of the root in the offline mode */
+#define XINETD_ROOT getenv("OSCAP_PROBE_ROOT")
+
 /*
  * the code bellow implements a minimal xinetd configuration parser
  */
@@ -195,11 +200,14 @@ typedef struct {
 	rbt_t            *stree; /**< service tree */
 	rbt_t            *ttree; /**< service name & protocol to ID(s) tree */
 	xiconf_service_t *defaults; /**< parsed defaults for services */
+	char            **dpath; /**< included directories */
+	time_t           *dmtime; /**< modification times of the included directories */
+	size_t            dcount; /**< number of included directories */
 } xiconf_t;
 
 xiconf_t *xiconf_parse(const char *path, unsigned int max_depth);
 void xiconf_free(xiconf_t *xiconf);
-int xiconf_update(xiconf_t *xiconf);
+bool xiconf_changed(const xiconf_t *xiconf);
 int xiconf_parse_section(xiconf_t *xiconf, xiconf_file_t *xifile, int type, char *name);
 int xiconf_parse_service(xiconf_file_t *file, xiconf_service_t *service);
 int xiconf_parse_defaults(xiconf_file_t *file, xiconf_service_t *defaults, rbt_t *stree);
@@ -370,6 +378,9 @@ static xiconf_t *xiconf_new(void)
 	xiconf->stree = rbt_str_new();
 	xiconf->ttree = rbt_str_new();
 	xiconf->defaults = NULL;
+	xiconf->dpath = NULL;
+	xiconf->dmtime = NULL;
+	xiconf->dcount = 0;
 
 	return (xiconf);
 }
@@ -462,6 +473,11 @@ void xiconf_free(xiconf_t *xiconf)
 
 	free(xiconf->cfile);
 
+	for (i = 0; i < xiconf->dcount; ++i)
+		free(xiconf->dpath[i]);
+	free(xiconf->dpath);
+	free(xiconf->dmtime);
+
         rbt_str_free_cb(xiconf->stree, xiconf_stree_free_cb);
         rbt_str_free_cb(xiconf->ttree, xiconf_ttree_free_cb);
 
@@ -480,7 +496,7 @@ static xiconf_file_t *xiconf_read(const char *path, int flags)
 	int fd;
 	struct stat st;
 
-	fd = open(path, O_RDONLY);
+	fd = oval_root_open(XINETD_ROOT, path, O_RDONLY);
 
 	if (fd < 0)
 		return (NULL);
@@ -586,6 +602,34 @@ static int xiconf_add_cfile(xiconf_t *xiconf, const char *path, int depth)
 	return (0);
 }
 
+/*
+ * Remember the modification time of an included directory so that files
+ * added to it or removed from it are noticed by xiconf_changed
+ */
+static void xiconf_add_dir(xiconf_t *xiconf, const char *path, DIR *dirfp)
+{
+	struct stat st;
+	char  **dpath;
+	time_t *dmtime;
+
+	if (fstat(dirfd(dirfp), &st) != 0)
+		return;
+
+	dpath  = realloc(xiconf->dpath, sizeof(char *) * (xiconf->dcount + 1));
+	if (dpath == NULL)
+		return;
+	xiconf->dpath = dpath;
+	dmtime = realloc(xiconf->dmtime, sizeof(time_t) * (xiconf->dcount + 1));
+	if (dmtime == NULL)
+		return;
+	xiconf->dmtime = dmtime;
+
+	xiconf->dpath[xiconf->dcount]  = strdup(path);
+	xiconf->dmtime[xiconf->dcount] = st.st_mtime;
+	if (xiconf->dpath[xiconf->dcount] != NULL)
+		++xiconf->dcount;
+}
+
 #define tmpbuf_def(size) char __tmpbuf[size]
 #define tmpbuf_get(size) (((sizeof __tmpbuf)/sizeof(char))<(size)?malloc(sizeof(char)*(size)):__tmpbuf)
 #define tmpbuf_free(ptr) do { if ((ptr) != __tmpbuf) free(ptr); (ptr) = NULL; } while(0)
@@ -760,13 +804,14 @@ xiconf_t *xiconf_parse(const char *path, unsigned int max_depth)
 					struct dirent *dent = NULL;
 
 					dD("includedir open: %s", inclarg);
-					dirfp = opendir (inclarg);
+					dirfp = oval_root_opendir(XINETD_ROOT, inclarg);
 
 					if (dirfp == NULL) {
 						dW("Can't open includedir: %s; %d, %s.", inclarg, errno, strerror (errno));
 						break;
 					}
 
+					xiconf_add_dir(xiconf, inclarg, dirfp);
 					strcpy (pathbuf, inclarg);
 					incllen = strlen(inclarg);
 
@@ -825,10 +870,34 @@ xiconf_t *xiconf_parse(const char *path, unsigned int max_depth)
 	return (xiconf);
 }
 
-int xiconf_update(xiconf_t *xiconf)
+/*
+ * Check whether some of the parsed files or included directories was
+ * modified or removed since the configuration was parsed
+ */
+bool xiconf_changed(const xiconf_t *xiconf)
 {
-	dD("Not implemented yet.");
-	return (0);
+	struct stat st;
+	register size_t i;
+
+	for (i = 0; i < xiconf->count; ++i) {
+		if (oval_root_stat(XINETD_ROOT, xiconf->cfile[i]->cpath, &st) != 0 ||
+		    st.st_mtime != xiconf->cfile[i]->mtime)
+		{
+			dD("Configuration file changed: %s", xiconf->cfile[i]->cpath);
+			return (true);
+		}
+	}
+
+	for (i = 0; i < xiconf->dcount; ++i) {
+		if (oval_root_stat(XINETD_ROOT, xiconf->dpath[i], &st) != 0 ||
+		    st.st_mtime != xiconf->dmtime[i])
+		{
+			dD("Included directory changed: %s", xiconf->dpath[i]);
+			return (true);
+		}
+	}
+
+	return (false);
 }
 
 static int xiconf_service_merge_defaults(xiconf_service_t *dst, xiconf_service_t *def)
@@ -1653,18 +1722,112 @@ static void xiservice_process_query(probe_ctx *ctx, SEXP_t *service_name, SEXP_t
 
 int xinetd_probe_offline_mode_supported()
 {
-	return PROBE_OFFLINE_CHROOT;
+	return PROBE_OFFLINE_OWN;
+}
+
+/*
+ * The configuration is parsed once and kept for the lifetime of the probe,
+ * it's parsed again only if some of its files or directories changed
+ */
+struct xinetd_global {
+	pthread_mutex_t mutex;
+	xiconf_t       *xcfg;
+	time_t          conf_mtime; /**< of XINETD_CONFPATH when it wasn't parsed; -1 if it's missing */
+};
+
+static void xinetd_global_parse(struct xinetd_global *g)
+{
+	struct stat st;
+
+	if (g->xcfg != NULL) {
+		if (!xiconf_changed(g->xcfg))
+			return;
+		dD("Updating xinetd configuration cache");
+		xiconf_free(g->xcfg);
+	} else {
+		time_t mtime = oval_root_stat(XINETD_ROOT, XINETD_CONFPATH, &st) == 0 ? st.st_mtime : (time_t)-1;
+
+		/* don't try to parse a missing or broken configuration over and over */
+		if (mtime == g->conf_mtime)
+			return;
+		g->conf_mtime = mtime;
+	}
+
+	g->xcfg = xiconf_parse(XINETD_CONFPATH, XINETD_CONFDEPTH);
 }
 
 void *xinetd_probe_init(void)
 {
-	return xiconf_parse(XINETD_CONFPATH, XINETD_CONFDEPTH);
+	struct xinetd_global *g = malloc(sizeof(struct xinetd_global));
+
+	if (g == NULL)
+		return (NULL);
+
+	pthread_mutex_init(&g->mutex, NULL);
+	g->xcfg = NULL;
+	g->conf_mtime = 0;
+	xinetd_global_parse(g);
+
+	return (g);
 }
 
 void xinetd_probe_fini(void *arg)
 {
-	if (arg != NULL)
-		xiconf_free(arg);
+	struct xinetd_global *g = arg;
+
+	if (g == NULL)
+		return;
+
+	xiconf_free(g->xcfg);
+	pthread_mutex_destroy(&g->mutex);
+	free(g);
+}
+
+/*
+ * Collect the services the object names directly if both entities use the
+ * equals operation, the (service_name, protocol) pairs are looked up in the
+ * translation tree instead of comparing all the services
+ */
+static bool xiservice_lookup(probe_ctx *ctx, SEXP_t *service_name, SEXP_t *protocol, xiconf_t *xcfg)
+{
+	char **names, **prots;
+	register size_t i, j;
+	register uint32_t l;
+	xiconf_strans_t *xres;
+
+	names = probe_entobj_equal_strings(service_name);
+	if (names == NULL)
+		return (false);
+	prots = probe_entobj_equal_strings(protocol);
+	if (prots == NULL) {
+		for (i = 0; names[i] != NULL; ++i)
+			free(names[i]);
+		free(names);
+		return (false);
+	}
+
+	for (i = 0; names[i] != NULL; ++i) {
+		for (j = 0; prots[j] != NULL; ++j) {
+			xres = xiconf_getservice(xcfg, names[i], prots[j]);
+			if (xres == NULL)
+				continue;
+			for (l = 0; l < xres->cnt; ++l) {
+				/* the key is the concatenation of the name and the protocol */
+				if (strcmp(xres->srv[l]->name, names[i]) == 0 &&
+				    strcmp(xres->srv[l]->protocol, prots[j]) == 0)
+					xiservice_process_query(ctx, service_name, protocol, xres->srv[l]);
+			}
+		}
+	}
+
+	for (i = 0; names[i] != NULL; ++i)
+		free(names[i]);
+	free(names);
+	for (j = 0; prots[j] != NULL; ++j)
+		free(prots[j]);
+	free(prots);
+
+	return (true);
 }
 
 int xinetd_probe_main(probe_ctx *ctx, void *arg)
@@ -1676,12 +1839,10 @@ int xinetd_probe_main(probe_ctx *ctx, void *arg)
 
 	xiconf_service_t *xsrv;
 	xiconf_strans_t  *xres;
-	xiconf_t         *xcfg = (xiconf_t *)arg;
+	struct xinetd_global *g = arg;
 
-	if (arg == NULL) {
-		probe_cobj_set_flag(probe_ctx_getresult(ctx), SYSCHAR_FLAG_NOT_APPLICABLE);
-		return (0);
-	}
+	if (g == NULL)
+		return (PROBE_EINIT);
 
         object = probe_ctx_getobject(ctx);
 
@@ -1723,14 +1884,21 @@ int xinetd_probe_main(probe_ctx *ctx, void *arg)
 
 	SEXP_free (eval);
 
-	dD("Updating xinetd configuration cache");
+	pthread_mutex_lock(&g->mutex);
+	xinetd_global_parse(g);
 
-	if (xiconf_update(arg) != 0) {
-		err = PROBE_EUNKNOWN;
-		goto fail;
+	if (g->xcfg == NULL) {
+		pthread_mutex_unlock(&g->mutex);
+		SEXP_free(service_name);
+		SEXP_free(protocol);
+		probe_cobj_set_flag(probe_ctx_getresult(ctx), SYSCHAR_FLAG_NOT_APPLICABLE);
+		return (0);
 	}
 
-	xres = xiconf_dump(xcfg);
+	if (xiservice_lookup(ctx, service_name, protocol, g->xcfg))
+		xres = NULL;
+	else
+		xres = xiconf_dump(g->xcfg);
 
 	if (xres != NULL) {
 		register unsigned int l;
@@ -1746,6 +1914,7 @@ int xinetd_probe_main(probe_ctx *ctx, void *arg)
 		free(xres);
 
 	}
+	pthread_mutex_unlock(&g->mutex);
 	SEXP_free(service_name);
 	SEXP_free(protocol);
 
@@ -24,8 +24,11 @@
 #include <config.h>
 #endif
 
+#include <stdbool.h>
 #include <string.h>
+#include <pthread.h>
 #include <windows.h>
+#include "common/list.h"
 #include "debug_priv.h"
 #include "_seap.h"
 #include "probe-api.h"
@@ -36,11 +39,47 @@
 
 #define UNLIMITED_DEPTH -1
 
+#define REGISTRY_HANDLES_HSIZE 1021
+#define REGISTRY_HANDLES_MAX   4096   /* keys kept open, others are closed after use */
+#define REGISTRY_WALK_MAX      262144 /* keys of a hive remembered for pattern matching */
+
+/*
+ * Registry state shared by the objects of one scan. Opened keys are kept by
+ * path so that objects naming the same keys, their parents when recursing
+ * up and the keys matched by patterns are opened once, and a key is opened
+ * relative to its opened parent. The keys of a hive are listed on the first
+ * pattern matched object, the later ones only match the list.
+ */
+struct registry_probe_arg {
+	pthread_mutex_t lock;
+	struct oscap_htable *handles; /* view\hive[\key] -> struct registry_handle */
+	size_t handles_count;
+	struct oscap_htable *walks;   /* view\hive -> struct registry_walk */
+};
+
+struct registry_handle {
+	HKEY handle;
+	LONG err;
+};
+
+/* paths of all the keys of a hive in the order they are collected */
+struct registry_walk {
+	size_t count;
+	size_t alloc;
+	char **keys;
+};
+
 struct ent_info {
 	SEXP_t *behaviors_ent;
 	SEXP_t *hive_ent;
 	SEXP_t *key_ent;
 	SEXP_t *name_ent;
+	struct registry_probe_arg *arg;
+	/* buffers for RegEnumValueW, reused for all the values of the object */
+	WCHAR *name_buf;
+	DWORD name_buf_len;
+	BYTE *value_buf;
+	DWORD value_buf_len;
 };
 
 struct registry_key_info {
@@ -219,13 +258,14 @@ static REGSAM get_access_rights(int windows_view)
 	return access_rights;
 }
 
-static struct ent_info *ent_info_new(SEXP_t *probe_in)
+static struct ent_info *ent_info_new(SEXP_t *probe_in, struct registry_probe_arg *arg)
 {
-	struct ent_info *ei = malloc(sizeof(struct ent_info));
+	struct ent_info *ei = calloc(1, sizeof(struct ent_info));
 	ei->behaviors_ent = probe_obj_getent(probe_in, "behaviors", 1);
 	ei->hive_ent = probe_obj_getent(probe_in, "hive", 1);
 	ei->key_ent = probe_obj_getent(probe_in, "key", 1);
 	ei->name_ent = probe_obj_getent(probe_in, "name", 1);
+	ei->arg = arg;
 	return ei;
 }
 
@@ -235,9 +275,138 @@ static void ent_info_free(struct ent_info *ei)
 	SEXP_free(ei->hive_ent);
 	SEXP_free(ei->key_ent);
 	SEXP_free(ei->name_ent);
+	free(ei->name_buf);
+	free(ei->value_buf);
 	free(ei);
 }
 
+static void registry_handle_free(void *ptr)
+{
+	struct registry_handle *rh = ptr;
+
+	if (rh->err == ERROR_SUCCESS)
+		RegCloseKey(rh->handle);
+	free(rh);
+}
+
+static void registry_walk_free(void *ptr)
+{
+	struct registry_walk *walk = ptr;
+
+	if (walk == NULL)
+		return;
+	for (size_t i = 0; i < walk->count; i++)
+		free(walk->keys[i]);
+	free(walk->keys);
+	free(walk);
+}
+
+void *registry_probe_init(void)
+{
+	struct registry_probe_arg *arg = calloc(1, sizeof(struct registry_probe_arg));
+
+	if (arg == NULL)
+		return NULL;
+	pthread_mutex_init(&arg->lock, NULL);
+	arg->handles = oscap_htable_new1(strcmp, REGISTRY_HANDLES_HSIZE);
+	arg->walks = oscap_htable_new();
+	return arg;
+}
+
+void registry_probe_fini(void *ptr)
+{
+	struct registry_probe_arg *arg = ptr;
+
+	if (arg == NULL)
+		return;
+	oscap_htable_free(arg->handles, registry_handle_free);
+	oscap_htable_free(arg->walks, registry_walk_free);
+	pthread_mutex_destroy(&arg->lock);
+	free(arg);
+}
+
+static char *registry_key_id(const char *hive_str, const char *key_str, int windows_view)
+{
+	if (key_str == NULL) {
+		return oscap_sprintf("%d\\%s", windows_view, hive_str);
+	} else {
+		return oscap_sprintf("%d\\%s\\%s", windows_view, hive_str, key_str);
+	}
+}
+
+/*
+ * Open a key, the handle is kept by the probe if cached is set and must not
+ * be closed then. Use registry_key_release.
+ */
+static LONG registry_key_open(struct registry_probe_arg *arg, const char *hive_str, const char *key_str, int windows_view, HKEY *handle, bool *cached)
+{
+	struct registry_handle *rh;
+	HKEY parent = NULL;
+	const char *path = key_str;
+	char *id = registry_key_id(hive_str, key_str, windows_view);
+	LONG err;
+
+	*cached = false;
+	pthread_mutex_lock(&arg->lock);
+	rh = oscap_htable_get(arg->handles, id);
+	if (rh != NULL) {
+		pthread_mutex_unlock(&arg->lock);
+		free(id);
+		*handle = rh->handle;
+		*cached = true;
+		return rh->err;
+	}
+	if (key_str != NULL) {
+		/* the id of the parent is a prefix of the id, the hive for top keys */
+		char *delimiter = strrchr(id, '\\');
+		*delimiter = '\0';
+		rh = oscap_htable_get(arg->handles, id);
+		*delimiter = '\\';
+		if (rh != NULL && rh->err == ERROR_SUCCESS) {
+			parent = rh->handle;
+			path = delimiter + 1;
+		}
+	}
+	pthread_mutex_unlock(&arg->lock);
+
+	/* cached handles stay open until the probe ends */
+	WCHAR *path_wstr = oscap_windows_str_to_wstr(path);
+	err = RegOpenKeyExW(parent != NULL ? parent : get_hive_from_str(hive_str),
+		path_wstr, 0, get_access_rights(windows_view), handle);
+	free(path_wstr);
+
+	pthread_mutex_lock(&arg->lock);
+	rh = oscap_htable_get(arg->handles, id);
+	if (rh != NULL) {
+		/* opened by another thread meanwhile */
+		if (err == ERROR_SUCCESS)
+			RegCloseKey(*handle);
+		*handle = rh->handle;
+		err = rh->err;
+		*cached = true;
+	} else if (arg->handles_count < REGISTRY_HANDLES_MAX) {
+		rh = malloc(sizeof(struct registry_handle));
+		rh->handle = err == ERROR_SUCCESS ? *handle : NULL;
+		rh->err = err;
+		if (oscap_htable_add(arg->handles, id, rh)) {
+			arg->handles_count++;
+			*cached = true;
+		} else {
+			free(rh);
+		}
+	}
+	pthread_mutex_unlock(&arg->lock);
+	free(id);
+
+	return err;
+}
+
+static void registry_key_release(HKEY handle, bool cached)
+{
+	if (!cached)
+		RegCloseKey(handle);
+}
+
 static int registry_behaviors_get_max_depth(SEXP_t *behaviors_ent)
 {
 	int max_depth = UNLIMITED_DEPTH; // default behavior value
@@ -292,20 +461,17 @@ static int registry_behaviors_get_windows_view(SEXP_t *behaviors_ent)
 }
 
 
-static void collect_registry_value(probe_ctx *ctx, struct registry_key_info *ki, DWORD index, SEXP_t *name_ent)
+static void collect_registry_value(probe_ctx *ctx, struct ent_info *ei, struct registry_key_info *ki, DWORD index)
 {
-	DWORD name_buffer_len = ki->max_name_len + 1; // +1 for terminating null byte
-	WCHAR *name_wstr = malloc(name_buffer_len * sizeof(WCHAR));
+	WCHAR *name_wstr = ei->name_buf;
 	name_wstr[0] = '\0';
-	DWORD name_len = name_buffer_len;
+	DWORD name_len = ei->name_buf_len;
 	DWORD type;
-	BYTE *value = malloc(ki->max_value_len);
-	DWORD value_len = ki->max_value_len;
+	BYTE *value = ei->value_buf;
+	DWORD value_len = ei->value_buf_len;
 
 	int ret = RegEnumValueW(ki->opened_key_handle, index, name_wstr, &name_len, NULL, &type, value, &value_len);
 	if (ret != ERROR_SUCCESS) {
-		free(value);
-		free(name_wstr);
 		return;
 	}
 
@@ -319,10 +485,8 @@ static void collect_registry_value(probe_ctx *ctx, struct registry_key_info *ki,
 	}
 
 	SEXP_t *tmp = SEXP_string_new(name_str, strlen(name_str));
-	if (probe_entobj_cmp(name_ent, tmp) != OVAL_RESULT_TRUE) {
+	if (probe_entobj_cmp(ei->name_ent, tmp) != OVAL_RESULT_TRUE) {
 		SEXP_free(tmp);
-		free(value);
-		free(name_wstr);
 		free(name_str);
 		return;
 	}
@@ -374,126 +538,272 @@ static void collect_registry_value(probe_ctx *ctx, struct registry_key_info *ki,
 	}
 	SEXP_free(tmp);
 	free(name_str);
-	free(value);
-	free(name_wstr);
 }
 
-static int collect_registry_key(probe_ctx *ctx, const char *hive_str, const char *key_str, SEXP_t *name_ent, int windows_view)
+/* grow the enumeration buffers to hold the longest name and value of a key */
+static int ent_info_reserve(struct ent_info *ei, DWORD max_name_len, DWORD max_value_len)
 {
-	HKEY hive = get_hive_from_str(hive_str);
-	HKEY opened_key_handle;
-	REGSAM access_rights = get_access_rights(windows_view);
-	WCHAR *key_wstr = oscap_windows_str_to_wstr(key_str);
-	LONG err = RegOpenKeyExW(hive, key_wstr, 0, access_rights, &opened_key_handle);
-	free(key_wstr);
-	if (err != ERROR_SUCCESS) {
-		char *error_message = oscap_windows_error_message(err);
-		dD("Can't open registry key '%s': RegOpenKeyExW error: %s", key_str, error_message);
-		free(error_message);
-		return 1;
+	if (ei->name_buf_len < max_name_len + 1) { // +1 for terminating null byte
+		WCHAR *name_buf = realloc(ei->name_buf, (max_name_len + 1) * sizeof(WCHAR));
+		if (name_buf == NULL)
+			return -1;
+		ei->name_buf = name_buf;
+		ei->name_buf_len = max_name_len + 1;
+	}
+	if (ei->value_buf == NULL || ei->value_buf_len < max_value_len) {
+		BYTE *value_buf = realloc(ei->value_buf, max_value_len > 0 ? max_value_len : 1);
+		if (value_buf == NULL)
+			return -1;
+		ei->value_buf = value_buf;
+		ei->value_buf_len = max_value_len;
 	}
+	return 0;
+}
 
+static void collect_registry_values(probe_ctx *ctx, struct ent_info *ei, const char *hive_str, const char *key_str, HKEY opened_key_handle, int windows_view)
+{
 	DWORD subkeys_count, max_subkey_len, values_count, max_name_len, max_value_len;
 	FILETIME last_write_time;
 	DWORD ret = RegQueryInfoKeyW(opened_key_handle, NULL, NULL, NULL,
 		&subkeys_count, &max_subkey_len, NULL, &values_count, &max_name_len,
 		&max_value_len, NULL, &last_write_time);
 
-	SEXP_t *name_sexp_val = probe_ent_getval(name_ent);
+	SEXP_t *name_sexp_val = probe_ent_getval(ei->name_ent);
 	if (key_str == NULL) {
 		report_finding(ctx, hive_str, NULL, NULL, last_write_time, REG_NONE, NULL, windows_view);
-		RegCloseKey(opened_key_handle);
-		return 0;
+		SEXP_free(name_sexp_val);
+		return;
 	}
 
 	if (name_sexp_val == NULL) {
 		/* Collect the key itself */
 		report_finding(ctx, hive_str, key_str, NULL, last_write_time, REG_NONE, NULL, windows_view);
-		RegCloseKey(opened_key_handle);
-		return 0;
+		return;
+	}
+	SEXP_free(name_sexp_val);
+
+	if (ent_info_reserve(ei, max_name_len, max_value_len) != 0) {
+		return;
 	}
 
-	struct registry_key_info *ki = malloc(sizeof(struct registry_key_info));
-	ki->hive_str = hive_str;
-	ki->key_str = key_str;
-	ki->max_value_len = max_value_len;
-	ki->max_name_len = max_name_len;
-	ki->opened_key_handle = opened_key_handle;
-	ki->last_write_time = last_write_time;
-	ki->windows_view = windows_view;
+	struct registry_key_info ki = {
+		.hive_str = hive_str,
+		.key_str = key_str,
+		.max_value_len = max_value_len,
+		.max_name_len = max_name_len,
+		.opened_key_handle = opened_key_handle,
+		.last_write_time = last_write_time,
+		.windows_view = windows_view
+	};
 
 	/* Enumerate the key values */
 	for (DWORD i = 0; i < values_count; i++) {
-		collect_registry_value(ctx, ki, i, name_ent);
+		collect_registry_value(ctx, ei, &ki, i);
 	}
-
-	free(ki);
-
-	RegCloseKey(opened_key_handle);
-	return 0;
 }
 
-static int registry_recurse_down(probe_ctx *ctx, struct ent_info *ei, char *hive_str, char *key_str, int depth, int max_depth, oval_operation_t operation, int windows_view)
+static int collect_registry_key(probe_ctx *ctx, struct ent_info *ei, const char *hive_str, const char *key_str, int windows_view)
 {
 	HKEY opened_key_handle;
-	HKEY hive = get_hive_from_str(hive_str);
-	REGSAM access_rights = get_access_rights(windows_view);
-	WCHAR *key_wstr = oscap_windows_str_to_wstr(key_str);
-	LONG err = RegOpenKeyExW(hive, key_wstr, 0, access_rights, &opened_key_handle);
-	free(key_wstr);
+	bool cached;
+	LONG err = registry_key_open(ei->arg, hive_str, key_str, windows_view, &opened_key_handle, &cached);
 	if (err != ERROR_SUCCESS) {
 		char *error_message = oscap_windows_error_message(err);
 		dD("Can't open registry key '%s': RegOpenKeyExW error: %s", key_str, error_message);
 		free(error_message);
-		return 0;
+		return 1;
 	}
 
+	collect_registry_values(ctx, ei, hive_str, key_str, opened_key_handle, windows_view);
+
+	registry_key_release(opened_key_handle, cached);
+	return 0;
+}
+
+typedef void (*registry_walk_func)(void *data, char *key_str, HKEY opened_key_handle);
+
+/*
+ * Call the function for the subkeys up to max_depth levels below the key,
+ * and then for the key itself unless it is the hive. The subkeys are
+ * opened relative to their parent and closed when done.
+ */
+static void registry_walk(HKEY opened_key_handle, char *key_str, int depth, int max_depth, REGSAM access_rights, registry_walk_func func, void *data)
+{
 	DWORD subkeys_count, max_subkey_len;
 	DWORD ret = RegQueryInfoKeyW(opened_key_handle, NULL, NULL, NULL,
 		&subkeys_count, &max_subkey_len, NULL, NULL, NULL,
 		NULL, NULL, NULL);
 
-	if ((max_depth == UNLIMITED_DEPTH || depth < max_depth) && subkeys_count > 0) {
+	if (ret == ERROR_SUCCESS && (max_depth == UNLIMITED_DEPTH || depth < max_depth) && subkeys_count > 0) {
 		DWORD subkey_buffer_len = max_subkey_len + 1; // +1 for terminating null character
 		WCHAR *subkey = malloc(subkey_buffer_len * sizeof(WCHAR));
 		for (DWORD i = 0; i < subkeys_count; i++) {
 			DWORD subkey_len = subkey_buffer_len;
+			HKEY subkey_handle;
 			ret = RegEnumKeyExW(opened_key_handle, i, subkey, &subkey_len, NULL, NULL, NULL, NULL);
-			if (ret == ERROR_SUCCESS) {
-				char *subkey_str = oscap_windows_wstr_to_str(subkey);
-				char *subkey_path = build_subkey_path(key_str, subkey_str);
-				registry_recurse_down(ctx, ei, hive_str, subkey_path, depth + 1, max_depth, operation, windows_view);
-				free(subkey_path);
-				free(subkey_str);
+			if (ret != ERROR_SUCCESS) {
+				continue;
 			}
+			char *subkey_str = oscap_windows_wstr_to_str(subkey);
+			char *subkey_path = build_subkey_path(key_str, subkey_str);
+			LONG err = RegOpenKeyExW(opened_key_handle, subkey, 0, access_rights, &subkey_handle);
+			if (err == ERROR_SUCCESS) {
+				registry_walk(subkey_handle, subkey_path, depth + 1, max_depth, access_rights, func, data);
+				RegCloseKey(subkey_handle);
+			} else {
+				char *error_message = oscap_windows_error_message(err);
+				dD("Can't open registry key '%s': RegOpenKeyExW error: %s", subkey_path, error_message);
+				free(error_message);
+			}
+			free(subkey_path);
+			free(subkey_str);
 		}
 		free(subkey);
 	}
 
 	if (key_str != NULL) {
-		SEXP_t *tmp = SEXP_string_new(key_str, strlen(key_str));
-		if (operation == OVAL_OPERATION_EQUALS || operation == OVAL_OPERATION_CASE_INSENSITIVE_EQUALS || probe_entobj_cmp(ei->key_ent, tmp) == OVAL_RESULT_TRUE) {
-			collect_registry_key(ctx, hive_str, key_str, ei->name_ent, windows_view);
+		func(data, key_str, opened_key_handle);
+	}
+}
+
+struct registry_walk_data {
+	probe_ctx *ctx;
+	struct ent_info *ei;
+	const char *hive_str;
+	int windows_view;
+	struct registry_walk *walk; /* keys seen, NULL if there are too many */
+};
+
+static void registry_walk_collect(void *data, char *key_str, HKEY opened_key_handle)
+{
+	struct registry_walk_data *wd = data;
+
+	collect_registry_values(wd->ctx, wd->ei, wd->hive_str, key_str, opened_key_handle, wd->windows_view);
+}
+
+static void registry_walk_match(void *data, char *key_str, HKEY opened_key_handle)
+{
+	struct registry_walk_data *wd = data;
+	struct registry_walk *walk = wd->walk;
+
+	if (walk != NULL && walk->count == walk->alloc) {
+		size_t alloc = walk->alloc > 0 ? walk->alloc * 2 : 1024;
+		char **keys = alloc <= REGISTRY_WALK_MAX ? realloc(walk->keys, alloc * sizeof(char *)) : NULL;
+		if (keys == NULL) {
+			registry_walk_free(walk);
+			walk = wd->walk = NULL;
+		} else {
+			walk->keys = keys;
+			walk->alloc = alloc;
+		}
+	}
+	if (walk != NULL) {
+		walk->keys[walk->count] = strdup(key_str);
+		if (walk->keys[walk->count] != NULL) {
+			walk->count++;
+		} else {
+			registry_walk_free(walk);
+			wd->walk = NULL;
 		}
-		SEXP_free(tmp);
 	}
 
-	RegCloseKey(opened_key_handle);
-	return 0;
+	SEXP_t *tmp = SEXP_string_new(key_str, strlen(key_str));
+	if (probe_entobj_cmp(wd->ei->key_ent, tmp) == OVAL_RESULT_TRUE) {
+		collect_registry_values(wd->ctx, wd->ei, wd->hive_str, key_str, opened_key_handle, wd->windows_view);
+	}
+	SEXP_free(tmp);
+}
+
+static void registry_recurse_down(probe_ctx *ctx, struct ent_info *ei, char *hive_str, char *key_str, int max_depth, int windows_view)
+{
+	HKEY opened_key_handle;
+	bool cached;
+	LONG err = registry_key_open(ei->arg, hive_str, key_str, windows_view, &opened_key_handle, &cached);
+	if (err != ERROR_SUCCESS) {
+		char *error_message = oscap_windows_error_message(err);
+		dD("Can't open registry key '%s': RegOpenKeyExW error: %s", key_str, error_message);
+		free(error_message);
+		return;
+	}
+
+	struct registry_walk_data wd = {
+		.ctx = ctx,
+		.ei = ei,
+		.hive_str = hive_str,
+		.windows_view = windows_view,
+		.walk = NULL
+	};
+	registry_walk(opened_key_handle, key_str, 0, max_depth, get_access_rights(windows_view), registry_walk_collect, &wd);
 
+	registry_key_release(opened_key_handle, cached);
+}
+
+static void registry_match_keys(probe_ctx *ctx, struct ent_info *ei, char *hive_str, int windows_view)
+{
+	struct registry_probe_arg *arg = ei->arg;
+	struct registry_walk *walk;
+	char *walk_id = registry_key_id(hive_str, NULL, windows_view);
+
+	pthread_mutex_lock(&arg->lock);
+	walk = oscap_htable_get(arg->walks, walk_id);
+	pthread_mutex_unlock(&arg->lock);
+
+	if (walk != NULL) {
+		/* the list isn't changed once it was added */
+		for (size_t i = 0; i < walk->count; i++) {
+			SEXP_t *tmp = SEXP_string_new(walk->keys[i], strlen(walk->keys[i]));
+			if (probe_entobj_cmp(ei->key_ent, tmp) == OVAL_RESULT_TRUE) {
+				collect_registry_key(ctx, ei, hive_str, walk->keys[i], windows_view);
+			}
+			SEXP_free(tmp);
+		}
+		free(walk_id);
+		return;
+	}
+
+	HKEY opened_key_handle;
+	bool cached;
+	LONG err = registry_key_open(arg, hive_str, NULL, windows_view, &opened_key_handle, &cached);
+	if (err != ERROR_SUCCESS) {
+		char *error_message = oscap_windows_error_message(err);
+		dD("Can't open registry hive '%s': RegOpenKeyExW error: %s", hive_str, error_message);
+		free(error_message);
+		free(walk_id);
+		return;
+	}
+
+	struct registry_walk_data wd = {
+		.ctx = ctx,
+		.ei = ei,
+		.hive_str = hive_str,
+		.windows_view = windows_view,
+		.walk = calloc(1, sizeof(struct registry_walk))
+	};
+	registry_walk(opened_key_handle, NULL, 0, UNLIMITED_DEPTH, get_access_rights(windows_view), registry_walk_match, &wd);
+	registry_key_release(opened_key_handle, cached);
+
+	if (wd.walk != NULL) {
+		pthread_mutex_lock(&arg->lock);
+		if (!oscap_htable_add(arg->walks, walk_id, wd.walk)) {
+			/* listed by another thread meanwhile */
+			registry_walk_free(wd.walk);
+		}
+		pthread_mutex_unlock(&arg->lock);
+	}
+	free(walk_id);
 }
 
 static int registry_recurse_up(probe_ctx *ctx, struct ent_info *ei, char *hive_str, char *key_str, int max_depth, int windows_view)
 {
 	int depth = 0;
 	do {
-		int ret = collect_registry_key(ctx, hive_str, key_str, ei->name_ent, windows_view);
+		int ret = collect_registry_key(ctx, ei, hive_str, key_str, windows_view);
 		if (ret != 0) {
 			break;
 		}
 		char *delimiter = strrchr(key_str, '\\');
 		if (delimiter == NULL) {
-			collect_registry_key(ctx, hive_str, NULL, ei->name_ent, windows_view);
+			collect_registry_key(ctx, ei, hive_str, NULL, windows_view);
 			break;
 		}
 		*delimiter = '\0';
@@ -504,8 +814,12 @@ static int registry_recurse_up(probe_ctx *ctx, struct ent_info *ei, char *hive_s
 
 int registry_probe_main(probe_ctx *ctx, void *arg)
 {
+	if (arg == NULL) {
+		return PROBE_EINIT;
+	}
+
 	SEXP_t *probe_in = probe_ctx_getobject(ctx);
-	struct ent_info *ei = ent_info_new(probe_in);
+	struct ent_info *ei = ent_info_new(probe_in, arg);
 
 	SEXP_t *hive_val = probe_ent_getval(ei->hive_ent);
 	char *hive_str = SEXP_string_cstr(hive_val);
@@ -523,17 +837,15 @@ int registry_probe_main(probe_ctx *ctx, void *arg)
 		SEXP_free(key_val);
 		if (recurse_direction == REGISTRY_RECURSE_DIRECTION_NONE || max_depth == 0) {
 			/* max_depth == 0 means no recursion no matter what recurse_direction was set in behaviors */
-			collect_registry_key(ctx, hive_str, key_str, ei->name_ent, windows_view);
+			collect_registry_key(ctx, ei, hive_str, key_str, windows_view);
 		} else if (recurse_direction == REGISTRY_RECURSE_DIRECTION_DOWN) {
-			HKEY hive = get_hive_from_str(hive_str);
-			registry_recurse_down(ctx, ei, hive_str, key_str, 0, max_depth, key_operation, windows_view);
+			registry_recurse_down(ctx, ei, hive_str, key_str, max_depth, windows_view);
 		} else if (recurse_direction == REGISTRY_RECURSE_DIRECTION_UP) {
 			registry_recurse_up(ctx, ei, hive_str, key_str, max_depth, windows_view);
 		}
 		free(key_str);
 	} else { /* pattern match, not equal, ... */
-		HKEY hive = get_hive_from_str(hive_str);
-		registry_recurse_down(ctx, ei, hive_str, NULL, 0, UNLIMITED_DEPTH, key_operation, windows_view);
+		registry_match_keys(ctx, ei, hive_str, windows_view);
 	}
 
 	free(hive_str);
@@ -25,6 +25,8 @@
 
 #include "probe-api.h"
 
+void *registry_probe_init(void);
 int registry_probe_main(probe_ctx *ctx, void *arg);
+void registry_probe_fini(void *arg);
 
 #endif /* OPENSCAP_REGISTRY_PROBE_H */
@@ -25,6 +25,7 @@
 #endif
 
 #include <string.h>
+#include <pthread.h>
 #include <wbemidl.h>
 #include <WMIUtils.h>
 #include <windows.h>
@@ -40,6 +41,124 @@
 #include "wmi57_probe.h"
 #include "oscap_helpers.h"
 
+/*
+ * WMI connections shared by the objects of one scan. Connecting to a
+ * namespace takes long, so each namespace is connected once and the
+ * connection is kept until the probe ends. The connections live in the
+ * multithreaded apartment, which is kept alive by the probe, so any
+ * thread can use them.
+ */
+struct wmi57_probe_arg {
+	pthread_mutex_t lock;
+	CO_MTA_USAGE_COOKIE mta_cookie;
+	IWbemLocator *locator;
+	struct oscap_htable *services; /* namespace -> IWbemServices */
+};
+
+static void wmi57_services_release(void *ptr)
+{
+	IWbemServices *services = ptr;
+
+	services->lpVtbl->Release(services);
+}
+
+void *wmi57_probe_init(void)
+{
+	HRESULT ret;
+	struct wmi57_probe_arg *arg = calloc(1, sizeof(struct wmi57_probe_arg));
+
+	if (arg == NULL)
+		return NULL;
+
+	ret = CoIncrementMTAUsage(&arg->mta_cookie);
+	if (FAILED(ret)) {
+		dE("Cannot initialize the COM library.");
+		free(arg);
+		return NULL;
+	}
+	ret = CoInitializeEx(0, COINIT_MULTITHREADED);
+	if (FAILED(ret)) {
+		dE("Cannot initialize the COM library.");
+		CoDecrementMTAUsage(arg->mta_cookie);
+		free(arg);
+		return NULL;
+	}
+	/* process wide, RPC_E_TOO_LATE means it was already done */
+	ret = CoInitializeSecurity(NULL, -1, NULL, NULL, RPC_C_AUTHN_LEVEL_DEFAULT, RPC_C_IMP_LEVEL_IMPERSONATE, NULL, EOAC_NONE, NULL);
+	if (FAILED(ret) && ret != RPC_E_TOO_LATE) {
+		dE("Cannot initialize security for the COM library.");
+	}
+	ret = CoCreateInstance(&CLSID_WbemLocator, 0, CLSCTX_INPROC_SERVER, &IID_IWbemLocator, (LPVOID *)&arg->locator);
+	if (FAILED(ret)) {
+		dE("Cannot create any instance of IWbemLocator object.");
+		arg->locator = NULL;
+	}
+	CoUninitialize();
+
+	pthread_mutex_init(&arg->lock, NULL);
+	arg->services = oscap_htable_new();
+	return arg;
+}
+
+void wmi57_probe_fini(void *ptr)
+{
+	struct wmi57_probe_arg *arg = ptr;
+
+	if (arg == NULL)
+		return;
+	oscap_htable_free(arg->services, wmi57_services_release);
+	if (arg->locator != NULL)
+		arg->locator->lpVtbl->Release(arg->locator);
+	CoDecrementMTAUsage(arg->mta_cookie);
+	pthread_mutex_destroy(&arg->lock);
+	free(arg);
+}
+
+/*
+ * Get the connection to a namespace, connecting on the first use. The
+ * reference has to be released by the caller.
+ */
+static IWbemServices *wmi57_services_get(struct wmi57_probe_arg *arg, const char *namespace_str, WCHAR *wmi_namespace)
+{
+	IWbemServices *services;
+	HRESULT ret;
+
+	if (arg->locator == NULL)
+		return NULL;
+
+	pthread_mutex_lock(&arg->lock);
+	services = oscap_htable_get(arg->services, namespace_str);
+	if (services == NULL) {
+		BSTR resource = SysAllocString(wmi_namespace);
+		ret = arg->locator->lpVtbl->ConnectServer(arg->locator, resource, NULL, NULL, NULL, 0, NULL, NULL, &services);
+		SysFreeString(resource);
+		if (FAILED(ret)) {
+			dE("Cannot connect to WMI namespace '%S'.", wmi_namespace);
+			services = NULL;
+		} else if (!oscap_htable_add(arg->services, namespace_str, services)) {
+			/* not kept, the reference is handed to the caller */
+			pthread_mutex_unlock(&arg->lock);
+			return services;
+		}
+	}
+	if (services != NULL)
+		services->lpVtbl->AddRef(services);
+	pthread_mutex_unlock(&arg->lock);
+
+	return services;
+}
+
+/* forget a connection which stopped working */
+static void wmi57_services_drop(struct wmi57_probe_arg *arg, const char *namespace_str, IWbemServices *services)
+{
+	pthread_mutex_lock(&arg->lock);
+	if (oscap_htable_get(arg->services, namespace_str) == services) {
+		oscap_htable_detach(arg->services, namespace_str);
+		services->lpVtbl->Release(services);
+	}
+	pthread_mutex_unlock(&arg->lock);
+}
+
 static struct oscap_list *get_wql_fields(WCHAR *wql)
 {
 	HRESULT hr = 0;
@@ -78,6 +197,7 @@ static struct oscap_list *get_wql_fields(WCHAR *wql)
 				query->lpVtbl->FreeMemory(query, wql_analysis);
 				/* free the memory that the parser is holding */
 				query->lpVtbl->Empty(query);
+				query->lpVtbl->Release(query);
 				oscap_list_free(fields_list, free);
 				return NULL;
 			}
@@ -88,6 +208,7 @@ static struct oscap_list *get_wql_fields(WCHAR *wql)
 	query->lpVtbl->FreeMemory(query, wql_analysis);
 	/* free the memory that the parser is holding */
 	query->lpVtbl->Empty(query);
+	query->lpVtbl->Release(query);
 
 	return fields_list;
 }
@@ -209,14 +330,12 @@ static int collect_value(probe_ctx *ctx, WCHAR *wmi_namespace, WCHAR *wql_query,
 	return 0;
 }
 
-static int query_wmi(probe_ctx *ctx, WCHAR *wmi_namespace, WCHAR *wql_query)
+static int query_wmi(probe_ctx *ctx, struct wmi57_probe_arg *arg, const char *namespace_str, WCHAR *wmi_namespace, WCHAR *wql_query)
 {
 	HRESULT ret = 0;
-	IWbemLocator *locator = NULL;
 	IWbemServices *services = NULL;
 	IEnumWbemClassObject *results = NULL;
 
-	BSTR resource = SysAllocString(wmi_namespace);
 	BSTR language = SysAllocString(L"WQL");
 
 	BSTR query = SysAllocString(wql_query);
@@ -226,78 +345,78 @@ static int query_wmi(probe_ctx *ctx, WCHAR *wmi_namespace, WCHAR *wql_query)
 		dE("Cannot initialize the COM library.");
 		goto cleanup;
 	}
-	ret = CoInitializeSecurity(NULL, -1, NULL, NULL, RPC_C_AUTHN_LEVEL_DEFAULT, RPC_C_IMP_LEVEL_IMPERSONATE, NULL, EOAC_NONE, NULL);
-	if (FAILED(ret)) {
-		dE("Cannot initialize security for the COM library.");
-		goto cleanup;
-	}
 
-	ret = CoCreateInstance(&CLSID_WbemLocator, 0, CLSCTX_INPROC_SERVER, &IID_IWbemLocator, (LPVOID *)&locator);
-	if (FAILED(ret)) {
-		dE("Cannot create any instance of IWbemLocator object.");
-		goto cleanup;
-	}
-	ret = locator->lpVtbl->ConnectServer(locator, resource, NULL, NULL, NULL, 0, NULL, NULL, &services);
-	if (FAILED(ret)) {
-		locator->lpVtbl->Release(locator);
-		dE("Cannot connect to WMI namespace '%S'.", wmi_namespace);
+	struct oscap_list *wql_fields = get_wql_fields(wql_query);
+	if (wql_fields == NULL) {
 		goto cleanup;
 	}
 
-	ret = services->lpVtbl->ExecQuery(services, language, query, WBEM_FLAG_BIDIRECTIONAL, NULL, &results);
-	if (FAILED(ret)) {
-		locator->lpVtbl->Release(locator);
-		services->lpVtbl->Release(services);
-		dE("Cannot execute WQL query '%S'.", wql_query);
-		goto cleanup;
+	/*
+	 * Semi-synchronous forward-only enumeration, the objects are returned
+	 * as they arrive and are not kept by the enumerator once read.
+	 */
+	for (int attempt = 0; attempt < 2 && results == NULL; attempt++) {
+		services = wmi57_services_get(arg, namespace_str, wmi_namespace);
+		if (services == NULL) {
+			break;
+		}
+		ret = services->lpVtbl->ExecQuery(services, language, query,
+			WBEM_FLAG_FORWARD_ONLY | WBEM_FLAG_RETURN_IMMEDIATELY, NULL, &results);
+		if (FAILED(ret)) {
+			/* the connection may have been lost, connect once more */
+			results = NULL;
+			wmi57_services_drop(arg, namespace_str, services);
+			services->lpVtbl->Release(services);
+			services = NULL;
+		}
 	}
-
-	struct oscap_list *wql_fields = get_wql_fields(wql_query);
-	if (wql_fields == NULL) {
-		locator->lpVtbl->Release(locator);
-		services->lpVtbl->Release(services);
-		results->lpVtbl->Release(results);
+	if (results == NULL) {
+		dE("Cannot execute WQL query '%S'.", wql_query);
+		oscap_list_free(wql_fields, free);
 		goto cleanup;
 	}
 
-	if (results != NULL) {
-		IWbemClassObject *result = NULL;
-		ULONG returnedCount = 0;
+	IWbemClassObject *result = NULL;
+	ULONG returnedCount = 0;
 
-		while ((ret = results->lpVtbl->Next(results, WBEM_INFINITE, 1, &result, &returnedCount)) == S_OK) {
-			VARIANT variant;
-			CIMTYPE type;
+	while ((ret = results->lpVtbl->Next(results, WBEM_INFINITE, 1, &result, &returnedCount)) == S_OK) {
+		VARIANT variant;
+		CIMTYPE type;
 
-			struct oscap_iterator *it = oscap_iterator_new(wql_fields);
-			while (oscap_iterator_has_more(it)) {
-				WCHAR *field_name = oscap_iterator_next(it);
+		struct oscap_iterator *it = oscap_iterator_new(wql_fields);
+		while (oscap_iterator_has_more(it)) {
+			WCHAR *field_name = oscap_iterator_next(it);
 
-				ret = result->lpVtbl->Get(result, field_name, 0, &variant, &type, 0);
+			ret = result->lpVtbl->Get(result, field_name, 0, &variant, &type, 0);
+			if (SUCCEEDED(ret)) {
 				collect_value(ctx, wmi_namespace, wql_query, field_name, &variant, type);
+				VariantClear(&variant);
 			}
-
-			oscap_iterator_free(it);
-			result->lpVtbl->Release(result);
 		}
+
+		oscap_iterator_free(it);
+		result->lpVtbl->Release(result);
 	}
 
 	oscap_list_free(wql_fields, free);
 
 	results->lpVtbl->Release(results);
 	services->lpVtbl->Release(services);
-	locator->lpVtbl->Release(locator);
 
 cleanup:
 	CoUninitialize(); // must be called even if CoInitializeEx fails
 	SysFreeString(query);
 	SysFreeString(language);
-	SysFreeString(resource);
 
 	return 0;
 }
 
 int wmi57_probe_main(probe_ctx *ctx, void *arg)
 {
+	if (arg == NULL) {
+		return PROBE_EINIT;
+	}
+
 	SEXP_t *probe_in = probe_ctx_getobject(ctx);
 	SEXP_t *namespace_ent = probe_obj_getent(probe_in, "namespace", 1);
 	SEXP_t *wql_ent = probe_obj_getent(probe_in, "wql", 1);
@@ -308,7 +427,7 @@ int wmi57_probe_main(probe_ctx *ctx, void *arg)
 	WCHAR *namespace_wstr = oscap_windows_str_to_wstr(namespace_str);
 	WCHAR *wql_wstr = oscap_windows_str_to_wstr(wql_str);
 
-	query_wmi(ctx, namespace_wstr, wql_wstr);
+	query_wmi(ctx, arg, namespace_str, namespace_wstr, wql_wstr);
 
 	free(wql_wstr);
 	free(namespace_wstr);
@@ -25,6 +25,8 @@
 
 #include "probe-api.h"
 
+void *wmi57_probe_init(void);
 int wmi57_probe_main(probe_ctx *ctx, void *arg);
+void wmi57_probe_fini(void *arg);
 
 #endif /* OPENSCAP_WMI57_PROBE_H */
@@ -79,6 +79,17 @@ OSCAP_API void oval_agent_set_product_name(oval_agent_session_t *, char *);
  */
 OSCAP_API int oval_agent_eval_definition(oval_agent_session_t *, const char *);
 
+/**
+ * Probe the system for all the objects needed by the given definitions at
+ * once, without evaluating them. The collected items are kept in the
+ * session and used by the subsequent evaluation of the definitions. The
+ * objects depending on external variables are left for the evaluation as
+ * their values may be bound only then.
+ * @param ids IDs of the definitions, all the definitions of the session if NULL
+ * @return 0 on success; -1 error
+ */
+OSCAP_API int oval_agent_collect_definitions(oval_agent_session_t *ag_sess, struct oscap_stringlist *ids);
+
 /**
  * Get the OVAL result of a definition from an agent session
  * @return 0 on success; -1 error
@@ -627,6 +627,29 @@ OSCAP_API struct oval_definition_model *oval_definition_model_new(void);
  */
 OSCAP_API struct oval_definition_model *oval_definition_model_import_source(struct oscap_source *source);
 
+/**
+ * Merge an updated version of the definitions into a loaded model, e.g. the
+ * next release of a vulnerability feed or a document with the changes only.
+ * Definitions, tests, objects, states and variables not in the model are
+ * added. Those with another version attribute are parsed again and replace
+ * the content of the ones in the model, so the references to them stay
+ * valid. Those with the same version are skipped without being parsed.
+ * Computed values of local variables are dropped.
+ *
+ * The collected objects of agent sessions using the model are not updated,
+ * the sessions have to be reset. Collected object caches are keyed by the
+ * content of the objects, so only the changed objects are collected again.
+ * @memberof oval_definition_model
+ * @param model the model to update
+ * @param source the document to merge
+ * @param updated if not NULL, the IDs of the added and replaced elements are added to it
+ * @returns 0 on success, 1 if the model can't be updated in place and has to
+ * be imported again (a variable changed its type or an object used by a set
+ * with filters changed) in which case the model is left as it was, -1 on
+ * error in which case the model is in an undefined state
+ */
+OSCAP_API int oval_definition_model_merge_source(struct oval_definition_model *model, struct oscap_source *source, struct oscap_stringlist *updated);
+
 /**
  * Copy an oval_definition_model.
  * @return A copy of the specified @ref oval_definition_model.
@@ -50,19 +50,31 @@ OSCAP_API void oval_probe_session_reinit(oval_probe_session_t *sess, struct oval
 /**
  * Destroy probe session. All state information created during the lifetime
  * of the session is freed, resources used by probes are freed using the probe
- * handler API.
+ * handler API. The caches of the probes are shared by all the sessions of the
+ * process, they are dropped with the last live session.
  * @param sess pointer to the probe session structure
  */
 OSCAP_API void oval_probe_session_destroy(oval_probe_session_t *sess);
 
 /**
  * Reset the session. All state information created during the lifetime of the
- * session is freed and reset to its initial state. All cached results are lost.
+ * session is freed and reset to its initial state. All cached results are lost,
+ * the caches of the probes are dropped for all the sessions of the process.
  * @param sess pointer to the probe session structure
  * @param sysch pointer to a new syschar model or NULL
  */
 OSCAP_API int oval_probe_session_reset(oval_probe_session_t *sess, struct oval_syschar_model *sysch);
 
+/**
+ * Drop what the probes have read from the system so far, e.g. after the
+ * system was changed by a remediation. The objects which weren't collected
+ * by the session yet are read from the system as it is now; the collected
+ * ones are kept. The caches of the probes are shared by all the sessions of
+ * the process, they are dropped for all of them.
+ * @param sess pointer to the probe session structure
+ */
+OSCAP_API void oval_probe_session_flush_caches(oval_probe_session_t *sess);
+
 /**
  * Abort the session.
  */
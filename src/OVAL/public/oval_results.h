@@ -502,6 +502,8 @@ OSCAP_API int oval_result_test_get_instance(struct oval_result_test *);
  */
 OSCAP_API struct oval_message_iterator *oval_result_test_get_messages(struct oval_result_test *);
 /**
+ * Get the tested items. The items are not kept after the evaluation
+ * if the directives of the results model request thin content only.
  * @memberof oval_result_test
  */
 OSCAP_API struct oval_result_item_iterator *oval_result_test_get_items(struct oval_result_test *);
@@ -86,6 +86,20 @@ OSCAP_API void oval_session_set_variables(struct oval_session *session, const ch
  */
 OSCAP_API void oval_session_set_directives(struct oval_session *session, const char *filename);
 
+/**
+ * Set recorded OVAL System Characteristics.
+ *
+ * The definitions are evaluated against the System Characteristics instead
+ * of probing the system, e.g. to evaluate a scan done on another machine.
+ * Pass NULL as filename to probe the system again. Validation of the format
+ * will be performed when the \ref oval_session_load is called.
+ *
+ * @memberof oval_session
+ * @param session an \ref oval_session
+ * @param filename a path to an OVAL System Characteristics file
+ */
+OSCAP_API void oval_session_set_system_characteristics(struct oval_session *session, const char *filename);
+
 /**
  * Set XSD validation level.
  *
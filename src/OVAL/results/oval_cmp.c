@@ -161,3 +161,144 @@ oval_result_t oval_str_cmp_str(char *state_data, oval_datatype_t state_data_type
 	oscap_seterr(OSCAP_EFAMILY_OVAL, "Invalid OVAL data type: %d.", state_data_type);
 	return OVAL_RESULT_ERROR;
 }
+
+static oval_result_t oval_cmp_operand_text(const struct oval_cmp_operand *operand, const char *sys_data)
+{
+	return oval_str_cmp_str(operand->text, operand->datatype, sys_data, operand->operation);
+}
+
+static oval_result_t oval_cmp_operand_string(const struct oval_cmp_operand *operand, const char *sys_data)
+{
+	return operand->kernel.string(operand->text, sys_data ? sys_data : "");
+}
+
+static oval_result_t oval_cmp_operand_integer(const struct oval_cmp_operand *operand, const char *sys_data)
+{
+	intmax_t syschar_val;
+
+	if (!cstr_to_intmax(sys_data, &syschar_val)) {
+		dW(
+			"Conversion of the string \"%s\" to an integer (%zu bits) failed: %s",
+			sys_data, sizeof(intmax_t)*8, strerror(errno));
+		return OVAL_RESULT_ERROR;
+	}
+	return operand->kernel.integer(operand->value.integer, syschar_val);
+}
+
+static oval_result_t oval_cmp_operand_float(const struct oval_cmp_operand *operand, const char *sys_data)
+{
+	double sys_val;
+
+	if (!cstr_to_double(sys_data, &sys_val)) {
+		dW(
+			"Conversion of the string \"%s\" to a floating type (double) failed: %s",
+			sys_data, strerror(errno));
+		return OVAL_RESULT_ERROR;
+	}
+	return operand->kernel.flt(operand->value.flt, sys_val);
+}
+
+static oval_result_t oval_cmp_operand_boolean(const struct oval_cmp_operand *operand, const char *sys_data)
+{
+	int sys_int;
+
+	sys_int = (((strcmp(sys_data, "true")) == 0) || ((strcmp(sys_data, "1")) == 0)) ? 1 : 0;
+	return operand->kernel.integer(operand->value.boolean, sys_int);
+}
+
+static oval_result_t oval_cmp_operand_ipaddr(const struct oval_cmp_operand *operand, const char *sys_data)
+{
+	return oval_ipaddr_cmp_parsed(&operand->value.ipaddr, sys_data, operand->operation);
+}
+
+static oval_result_t oval_cmp_operand_binary(const struct oval_cmp_operand *operand, const char *sys_data)
+{
+	return oval_binary_cmp(operand->text, sys_data, operand->operation);
+}
+
+static oval_result_t oval_cmp_operand_evr_string(const struct oval_cmp_operand *operand, const char *sys_data)
+{
+	return oval_evr_string_cmp(operand->text, sys_data, operand->operation);
+}
+
+static oval_result_t oval_cmp_operand_debian_evr_string(const struct oval_cmp_operand *operand, const char *sys_data)
+{
+	return oval_debian_evr_string_cmp(operand->text, sys_data, operand->operation);
+}
+
+static oval_result_t oval_cmp_operand_version(const struct oval_cmp_operand *operand, const char *sys_data)
+{
+	return oval_versiontype_cmp(operand->text, sys_data, operand->operation);
+}
+
+void oval_cmp_operand_init(struct oval_cmp_operand *operand, char *state_data, oval_datatype_t state_data_type, oval_operation_t operation)
+{
+	operand->text = state_data;
+	operand->datatype = state_data_type;
+	operand->operation = operation;
+	operand->cmp = &oval_cmp_operand_text;
+
+	/* Operations not valid for the data type are left to oval_str_cmp_str to report */
+	switch (state_data_type) {
+	case OVAL_DATATYPE_STRING:
+		if ((operand->kernel.string = oval_string_cmp_get(operation)) != NULL)
+			operand->cmp = &oval_cmp_operand_string;
+		break;
+	case OVAL_DATATYPE_INTEGER:
+		if ((operand->kernel.integer = oval_int_cmp_get(operation)) != NULL
+				&& cstr_to_intmax(state_data, &operand->value.integer))
+			operand->cmp = &oval_cmp_operand_integer;
+		break;
+	case OVAL_DATATYPE_FLOAT:
+		if ((operand->kernel.flt = oval_float_cmp_get(operation)) != NULL
+				&& cstr_to_double(state_data, &operand->value.flt))
+			operand->cmp = &oval_cmp_operand_float;
+		break;
+	case OVAL_DATATYPE_BOOLEAN:
+		/* booleans are only equal or not, as integers 0 and 1 */
+		if (operation == OVAL_OPERATION_EQUALS || operation == OVAL_OPERATION_NOT_EQUAL) {
+			operand->kernel.integer = oval_int_cmp_get(operation);
+			operand->value.boolean = (strcmp(state_data, "true") == 0 || strcmp(state_data, "1") == 0);
+			operand->cmp = &oval_cmp_operand_boolean;
+		}
+		break;
+	case OVAL_DATATYPE_IPV4ADDR:
+		if (oval_ipaddr_parse(AF_INET, state_data, &operand->value.ipaddr) == 0)
+			operand->cmp = &oval_cmp_operand_ipaddr;
+		break;
+	case OVAL_DATATYPE_IPV6ADDR:
+		if (oval_ipaddr_parse(AF_INET6, state_data, &operand->value.ipaddr) == 0)
+			operand->cmp = &oval_cmp_operand_ipaddr;
+		break;
+	case OVAL_DATATYPE_BINARY:
+		operand->cmp = &oval_cmp_operand_binary;
+		break;
+	case OVAL_DATATYPE_EVR_STRING:
+		operand->cmp = &oval_cmp_operand_evr_string;
+		break;
+	case OVAL_DATATYPE_DEBIAN_EVR_STRING:
+		operand->cmp = &oval_cmp_operand_debian_evr_string;
+		break;
+	case OVAL_DATATYPE_VERSION:
+		operand->cmp = &oval_cmp_operand_version;
+		break;
+	default:
+		break;
+	}
+}
+
+bool oval_cmp_operand_cmp_integer(const struct oval_cmp_operand *operand, intmax_t sys_data, oval_result_t *result)
+{
+	if (operand->cmp != &oval_cmp_operand_integer)
+		return false;
+	*result = operand->kernel.integer(operand->value.integer, sys_data);
+	return true;
+}
+
+bool oval_cmp_operand_cmp_boolean(const struct oval_cmp_operand *operand, bool sys_data, oval_result_t *result)
+{
+	if (operand->cmp != &oval_cmp_operand_boolean)
+		return false;
+	*result = operand->kernel.integer(operand->value.boolean, sys_data);
+	return true;
+}
@@ -32,6 +32,7 @@
 #include "oval_types.h"
 #include "common/_error.h"
 #include "common/debug_priv.h"
+#include "common/stats_priv.h"
 #include "oval_cmp_basic_impl.h"
 
 oval_result_t oval_boolean_cmp(const bool state, const bool syschar, oval_operation_t operation)
@@ -47,29 +48,79 @@ oval_result_t oval_boolean_cmp(const bool state, const bool syschar, oval_operat
 	return OVAL_RESULT_ERROR;
 }
 
-oval_result_t oval_int_cmp(const intmax_t state, const intmax_t syschar, oval_operation_t operation)
+static oval_result_t oval_int_equals(intmax_t state, intmax_t syschar)
+{
+	return state == syschar ? OVAL_RESULT_TRUE : OVAL_RESULT_FALSE;
+}
+
+static oval_result_t oval_int_not_equal(intmax_t state, intmax_t syschar)
+{
+	return state != syschar ? OVAL_RESULT_TRUE : OVAL_RESULT_FALSE;
+}
+
+static oval_result_t oval_int_greater_than(intmax_t state, intmax_t syschar)
+{
+	return syschar > state ? OVAL_RESULT_TRUE : OVAL_RESULT_FALSE;
+}
+
+static oval_result_t oval_int_greater_than_or_equal(intmax_t state, intmax_t syschar)
+{
+	return syschar >= state ? OVAL_RESULT_TRUE : OVAL_RESULT_FALSE;
+}
+
+static oval_result_t oval_int_less_than(intmax_t state, intmax_t syschar)
+{
+	return syschar < state ? OVAL_RESULT_TRUE : OVAL_RESULT_FALSE;
+}
+
+static oval_result_t oval_int_less_than_or_equal(intmax_t state, intmax_t syschar)
+{
+	return syschar <= state ? OVAL_RESULT_TRUE : OVAL_RESULT_FALSE;
+}
+
+static oval_result_t oval_int_bitwise_and(intmax_t state, intmax_t syschar)
+{
+	return (syschar & state) == state ? OVAL_RESULT_TRUE : OVAL_RESULT_FALSE;
+}
+
+static oval_result_t oval_int_bitwise_or(intmax_t state, intmax_t syschar)
+{
+	return (syschar | state) == state ? OVAL_RESULT_TRUE : OVAL_RESULT_FALSE;
+}
+
+oval_int_cmp_fn oval_int_cmp_get(oval_operation_t operation)
 {
 	switch (operation) {
 	case OVAL_OPERATION_EQUALS:
-		return state == syschar ? OVAL_RESULT_TRUE : OVAL_RESULT_FALSE;
+		return &oval_int_equals;
 	case OVAL_OPERATION_NOT_EQUAL:
-		return state != syschar ? OVAL_RESULT_TRUE : OVAL_RESULT_FALSE;
+		return &oval_int_not_equal;
 	case OVAL_OPERATION_GREATER_THAN:
-		return syschar > state ? OVAL_RESULT_TRUE : OVAL_RESULT_FALSE;
+		return &oval_int_greater_than;
 	case OVAL_OPERATION_GREATER_THAN_OR_EQUAL:
-		return syschar >= state ? OVAL_RESULT_TRUE : OVAL_RESULT_FALSE;
+		return &oval_int_greater_than_or_equal;
 	case OVAL_OPERATION_LESS_THAN:
-		return syschar < state ? OVAL_RESULT_TRUE : OVAL_RESULT_FALSE;
+		return &oval_int_less_than;
 	case OVAL_OPERATION_LESS_THAN_OR_EQUAL:
-		return syschar <= state ? OVAL_RESULT_TRUE : OVAL_RESULT_FALSE;
+		return &oval_int_less_than_or_equal;
 	case OVAL_OPERATION_BITWISE_AND:
-		return (syschar & state) == state ? OVAL_RESULT_TRUE : OVAL_RESULT_FALSE;
+		return &oval_int_bitwise_and;
 	case OVAL_OPERATION_BITWISE_OR:
-		return (syschar | state) == state ? OVAL_RESULT_TRUE : OVAL_RESULT_FALSE;
+		return &oval_int_bitwise_or;
 	default:
+		return NULL;
+	}
+}
+
+oval_result_t oval_int_cmp(const intmax_t state, const intmax_t syschar, oval_operation_t operation)
+{
+	oval_int_cmp_fn cmp = oval_int_cmp_get(operation);
+
+	if (cmp == NULL) {
 		oscap_seterr(OSCAP_EFAMILY_OVAL, "Invalid type of operation in integer evaluation: %d.", operation);
+		return OVAL_RESULT_ERROR;
 	}
-	return OVAL_RESULT_ERROR;
+	return cmp(state, syschar);
 }
 
 static inline int cmp_float(double a, double b)
@@ -91,24 +142,65 @@ static inline int cmp_float(double a, double b)
 	return r;
 }
 
+static oval_result_t oval_float_equals(double state_val, double sys_val)
+{
+	return cmp_float(sys_val, state_val) == 0 ? OVAL_RESULT_TRUE : OVAL_RESULT_FALSE;
+}
+
+static oval_result_t oval_float_not_equal(double state_val, double sys_val)
+{
+	return cmp_float(sys_val, state_val) != 0 ? OVAL_RESULT_TRUE : OVAL_RESULT_FALSE;
+}
+
+static oval_result_t oval_float_greater_than(double state_val, double sys_val)
+{
+	return cmp_float(sys_val, state_val) == 1 ? OVAL_RESULT_TRUE : OVAL_RESULT_FALSE;
+}
+
+static oval_result_t oval_float_greater_than_or_equal(double state_val, double sys_val)
+{
+	return cmp_float(sys_val, state_val) >= 0 ? OVAL_RESULT_TRUE : OVAL_RESULT_FALSE;
+}
+
+static oval_result_t oval_float_less_than(double state_val, double sys_val)
+{
+	return cmp_float(sys_val, state_val) == -1 ? OVAL_RESULT_TRUE : OVAL_RESULT_FALSE;
+}
+
+static oval_result_t oval_float_less_than_or_equal(double state_val, double sys_val)
+{
+	return cmp_float(sys_val, state_val) <= 0 ? OVAL_RESULT_TRUE : OVAL_RESULT_FALSE;
+}
+
+oval_float_cmp_fn oval_float_cmp_get(oval_operation_t operation)
+{
+	switch (operation) {
+	case OVAL_OPERATION_EQUALS:
+		return &oval_float_equals;
+	case OVAL_OPERATION_NOT_EQUAL:
+		return &oval_float_not_equal;
+	case OVAL_OPERATION_GREATER_THAN:
+		return &oval_float_greater_than;
+	case OVAL_OPERATION_GREATER_THAN_OR_EQUAL:
+		return &oval_float_greater_than_or_equal;
+	case OVAL_OPERATION_LESS_THAN:
+		return &oval_float_less_than;
+	case OVAL_OPERATION_LESS_THAN_OR_EQUAL:
+		return &oval_float_less_than_or_equal;
+	default:
+		return NULL;
+	}
+}
+
 oval_result_t oval_float_cmp(const double state_val, const double sys_val, oval_operation_t operation)
 {
-	if (operation == OVAL_OPERATION_EQUALS) {
-		return ((cmp_float(sys_val, state_val) == 0) ? OVAL_RESULT_TRUE : OVAL_RESULT_FALSE);
-	} else if (operation == OVAL_OPERATION_NOT_EQUAL) {
-		return ((cmp_float(sys_val, state_val) != 0) ? OVAL_RESULT_TRUE : OVAL_RESULT_FALSE);
-	} else if (operation == OVAL_OPERATION_GREATER_THAN) {
-		return ((cmp_float(sys_val, state_val) == 1) ? OVAL_RESULT_TRUE : OVAL_RESULT_FALSE);
-	} else if (operation == OVAL_OPERATION_GREATER_THAN_OR_EQUAL) {
-		return ((cmp_float(sys_val, state_val) >= 0) ? OVAL_RESULT_TRUE : OVAL_RESULT_FALSE);
-	} else if (operation == OVAL_OPERATION_LESS_THAN) {
-		return ((cmp_float(sys_val, state_val) == -1) ? OVAL_RESULT_TRUE : OVAL_RESULT_FALSE);
-	} else if (operation == OVAL_OPERATION_LESS_THAN_OR_EQUAL) {
-		return ((cmp_float(sys_val, state_val) <= 0) ? OVAL_RESULT_TRUE : OVAL_RESULT_FALSE);
-	} else {
+	oval_float_cmp_fn cmp = oval_float_cmp_get(operation);
+
+	if (cmp == NULL) {
 		oscap_seterr(OSCAP_EFAMILY_OVAL, "Invalid type of operation in float evaluation: %s.", oval_operation_get_text(operation));
 		return OVAL_RESULT_ERROR;
 	}
+	return cmp(state_val, sys_val);
 }
 
 static int istrcmp(const char *st1, const char *st2)
@@ -124,18 +216,20 @@ static oval_result_t strregcomp(const char *pattern, const char *test_str)
 {
 	int ret;
 	oval_result_t result = OVAL_RESULT_ERROR;
-	pcre *re;
+	struct oscap_pcre_cached *re;
 	const char *err;
 	int errofs;
 
-	re = pcre_compile(pattern, PCRE_UTF8, &err, &errofs, NULL);
+	/* the same state pattern is usually matched against many items */
+	re = oscap_pcre_cache_get(pattern, PCRE_UTF8, &err, &errofs);
 	if (re == NULL) {
 		dE("Unable to compile regex pattern '%s', "
 				"pcre_compile() returned error (offset: %d): '%s'.\n", pattern, errofs, err);
 		return OVAL_RESULT_ERROR;
 	}
 
-	ret = pcre_exec(re, NULL, test_str, strlen(test_str), 0, 0, NULL, 0);
+	oscap_stats_add(OSCAP_STATS_REGEX_EXECUTIONS, 1);
+	ret = pcre_exec(re->re, re->extra, test_str, strlen(test_str), 0, 0, NULL, 0);
 	if (ret > -1 ) {
 		result = OVAL_RESULT_TRUE;
 	} else if (ret == -1) {
@@ -146,28 +240,57 @@ static oval_result_t strregcomp(const char *pattern, const char *test_str)
 		result = OVAL_RESULT_ERROR;
 	}
 
-	pcre_free(re);
+	oscap_pcre_cache_release(re);
 	return result;
 }
 
-oval_result_t oval_string_cmp(const char *state, const char *syschar, oval_operation_t operation)
+static oval_result_t oval_string_equals(const char *state, const char *syschar)
+{
+	return oscap_strcmp(state, syschar) ? OVAL_RESULT_FALSE : OVAL_RESULT_TRUE;
+}
+
+static oval_result_t oval_string_case_insensitive_equals(const char *state, const char *syschar)
+{
+	return istrcmp(state, syschar) ? OVAL_RESULT_FALSE : OVAL_RESULT_TRUE;
+}
+
+static oval_result_t oval_string_not_equal(const char *state, const char *syschar)
+{
+	return oscap_strcmp(state, syschar) ? OVAL_RESULT_TRUE : OVAL_RESULT_FALSE;
+}
+
+static oval_result_t oval_string_case_insensitive_not_equal(const char *state, const char *syschar)
+{
+	return istrcmp(state, syschar) ? OVAL_RESULT_TRUE : OVAL_RESULT_FALSE;
+}
+
+oval_string_cmp_fn oval_string_cmp_get(oval_operation_t operation)
 {
-	syschar = syschar ? syschar : "";
 	switch (operation) {
 	case OVAL_OPERATION_EQUALS:
-		return oscap_strcmp(state, syschar) ? OVAL_RESULT_FALSE : OVAL_RESULT_TRUE;
+		return &oval_string_equals;
 	case OVAL_OPERATION_CASE_INSENSITIVE_EQUALS:
-		return istrcmp(state, syschar) ? OVAL_RESULT_FALSE : OVAL_RESULT_TRUE;
+		return &oval_string_case_insensitive_equals;
 	case OVAL_OPERATION_NOT_EQUAL:
-		return oscap_strcmp(state, syschar) ? OVAL_RESULT_TRUE : OVAL_RESULT_FALSE;
+		return &oval_string_not_equal;
 	case OVAL_OPERATION_CASE_INSENSITIVE_NOT_EQUAL:
-		return istrcmp(state, syschar) ? OVAL_RESULT_TRUE : OVAL_RESULT_FALSE;
+		return &oval_string_case_insensitive_not_equal;
 	case OVAL_OPERATION_PATTERN_MATCH:
-		return strregcomp(state, syschar);
+		return &strregcomp;
 	default:
+		return NULL;
+	}
+}
+
+oval_result_t oval_string_cmp(const char *state, const char *syschar, oval_operation_t operation)
+{
+	oval_string_cmp_fn cmp = oval_string_cmp_get(operation);
+
+	if (cmp == NULL) {
 		oscap_seterr(OSCAP_EFAMILY_OVAL, "Invalid type of operation in string evaluation: %d.", operation);
+		return OVAL_RESULT_ERROR;
 	}
-	return OVAL_RESULT_ERROR;
+	return cmp(state, syschar ? syschar : "");
 }
 
 oval_result_t oval_binary_cmp(const char *state, const char *syschar, oval_operation_t operation)
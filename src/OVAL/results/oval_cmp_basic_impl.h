@@ -30,6 +30,20 @@
 
 oval_result_t oval_boolean_cmp(const bool state, const bool syschar, oval_operation_t operation);
 
+/*
+ * Comparisons of a state value with a system value by a single operation,
+ * resolved once for values compared many times. The getters return NULL
+ * if the operation isn't valid for the data type.
+ */
+typedef oval_result_t (*oval_int_cmp_fn)(intmax_t state, intmax_t syschar);
+typedef oval_result_t (*oval_float_cmp_fn)(double state_val, double sys_val);
+typedef oval_result_t (*oval_string_cmp_fn)(const char *state, const char *syschar);
+
+oval_int_cmp_fn oval_int_cmp_get(oval_operation_t operation);
+oval_float_cmp_fn oval_float_cmp_get(oval_operation_t operation);
+/* syschar must not be NULL */
+oval_string_cmp_fn oval_string_cmp_get(oval_operation_t operation);
+
 oval_result_t oval_int_cmp(const intmax_t state, const intmax_t syschar, oval_operation_t operation);
 
 oval_result_t oval_float_cmp(const double state_val, const double sys_val, oval_operation_t operation);
@@ -56,9 +56,25 @@ static int risdigit(int c) {
 }
 #endif
 
+/* component of an EVR string, str is NULL if the component is missing */
+struct evr_part {
+	const char *str;
+	size_t len;
+};
+
+/* EVR string split in place, without copying it */
+struct evr {
+	struct evr_part epoch;
+	struct evr_part version;
+	struct evr_part release;
+};
+
+/* components up to this size are compared without a heap allocation */
+#define EVR_PART_BUFSZ 256
+
 static inline int rpmevrcmp(const char *a, const char *b);
-static int compare_values(const char *str1, const char *str2);
-static void parseEVR(char *evr, const char **ep, const char **vp, const char **rp);
+static int compare_values(const struct evr_part *part1, const struct evr_part *part2);
+static void parseEVR(const char *evr, struct evr *out);
 
 oval_result_t oval_evr_string_cmp(const char *state, const char *sys, oval_operation_t operation)
 {
@@ -90,79 +106,108 @@ static inline int rpmevrcmp(const char *a, const char *b)
 	/* This mimics rpmevrcmp which is not exported by rpmlib version 4.
 	 * Code inspired by rpm.labelCompare() from rpm4/python/header-py.c
 	 */
-	const char *a_epoch, *a_version, *a_release;
-	const char *b_epoch, *b_version, *b_release;
-	char *a_copy, *b_copy;
+	struct evr a_evr, b_evr;
 	int result;
 
-	a_copy = oscap_strdup(a);
-	b_copy = oscap_strdup(b);
-	parseEVR(a_copy, &a_epoch, &a_version, &a_release);
-	parseEVR(b_copy, &b_epoch, &b_version, &b_release);
+	parseEVR(a, &a_evr);
+	parseEVR(b, &b_evr);
 
-	result = compare_values(a_epoch, b_epoch);
+	result = compare_values(&a_evr.epoch, &b_evr.epoch);
 	if (!result) {
-		result = compare_values(a_version, b_version);
+		result = compare_values(&a_evr.version, &b_evr.version);
 		if (!result)
-			result = compare_values(a_release, b_release);
+			result = compare_values(&a_evr.release, &b_evr.release);
 	}
 
-	free(a_copy);
-	free(b_copy);
 	return result;
 }
 
-static int compare_values(const char *str1, const char *str2)
+/* NUL terminated copy of the component in buf, or on the heap if it doesn't fit */
+static char *evr_part_cstr(const struct evr_part *part, char *buf, size_t size)
+{
+	char *str = part->len < size ? buf : malloc(part->len + 1);
+
+	if (str == NULL)
+		return NULL;
+	memcpy(str, part->str, part->len);
+	str[part->len] = '\0';
+
+	return str;
+}
+
+static int compare_values(const struct evr_part *part1, const struct evr_part *part2)
 {
 	/*
 	 * Code copied from rpm4/python/header-py.c
 	 */
-	if (!str1 && !str2)
+	char buf1[EVR_PART_BUFSZ], buf2[EVR_PART_BUFSZ];
+	char *str1, *str2;
+	int result;
+
+	if (!part1->str && !part2->str)
 		return 0;
-	else if (str1 && !str2)
+	else if (part1->str && !part2->str)
 		return 1;
-	else if (!str1 && str2)
+	else if (!part1->str && part2->str)
 		return -1;
-	return rpmvercmp(str1, str2);
+
+	/* identical versions compare equal in rpmvercmp() too */
+	if (part1->len == part2->len && memcmp(part1->str, part2->str, part1->len) == 0)
+		return 0;
+
+	str1 = evr_part_cstr(part1, buf1, sizeof(buf1));
+	str2 = evr_part_cstr(part2, buf2, sizeof(buf2));
+	if (str1 == NULL || str2 == NULL) {
+		result = strcmp(str1 ? str1 : "", str2 ? str2 : "");
+	} else {
+		result = rpmvercmp(str1, str2);
+	}
+	if (str1 != buf1)
+		free(str1);
+	if (str2 != buf2)
+		free(str2);
+
+	return result;
 }
 
-static void parseEVR(char *evr, const char **ep, const char **vp, const char **rp)
+static void parseEVR(const char *evr, struct evr *out)
 {
 	/*
-	 * Code copied from rpm4/lib/rpmds.c
+	 * Code copied from rpm4/lib/rpmds.c, it splits the string by
+	 * pointers and lengths instead of writing terminators into a copy
 	 */
-	const char *epoch;
-	const char *version;			/* assume only version is present */
-	const char *release;
-	char *s, *se;
+	const char *s, *se = NULL, *end;
 
+	memset(out, 0, sizeof(struct evr));
 	if (!evr)
 		return;
 
 	s = evr;
 	while (*s && risdigit(*s)) s++;		/* s points to epoch terminator */
-	se = strrchr(s, '-');			/* se points to version terminator */
+	for (end = s; *end; end++) {		/* se points to version terminator */
+		if (*end == '-')
+			se = end;
+	}
 
 	if (*s == ':') {
-		epoch = evr;
-		*s++ = '\0';
-		version = s;
-		if (*epoch == '\0')
-			epoch = "0";
+		out->epoch.str = evr;
+		out->epoch.len = s - evr;
+		if (out->epoch.len == 0) {
+			out->epoch.str = "0";
+			out->epoch.len = 1;
+		}
+		out->version.str = s + 1;
 	} else {
-		epoch = NULL;			/* XXX disable epoch compare if missing */
-		version = evr;
+		/* XXX disable epoch compare if missing */
+		out->version.str = evr;
 	}
 	if (se) {
-		*se++ = '\0';
-		release = se;
+		out->version.len = se - out->version.str;
+		out->release.str = se + 1;
+		out->release.len = end - out->release.str;
 	} else {
-		release = NULL;
+		out->version.len = end - out->version.str;
 	}
-
-	if (ep) *ep = epoch;
-	if (vp) *vp = version;
-	if (rp) *rp = release;
 }
 
 #ifndef HAVE_RPMVERCMP
@@ -317,21 +362,25 @@ static int order(int c)
 
 /*
  * based on code from dpkg: lib/dpkg/version.c
- * Minor changes to use isdigit()
+ * Minor changes to use isdigit() and to compare strings of given lengths
  */
-static int verrevcmp(const char *a, const char *b)
+static int verrevcmp(const char *a, size_t alen, const char *b, size_t blen)
 {
+	const char *aend, *bend;
+
 	if (a == NULL)
 		a = "";
 	if (b == NULL)
 		b = "";
+	aend = a + alen;
+	bend = b + blen;
 
-	while (*a || *b) {
+	while (a < aend || b < bend) {
 		int first_diff = 0;
 
-		while ((*a && !isdigit(*a)) || (*b && !isdigit(*b))) {
-			int ac = order(*a);
-			int bc = order(*b);
+		while ((a < aend && !isdigit(*a)) || (b < bend && !isdigit(*b))) {
+			int ac = a < aend ? order(*a) : 0;
+			int bc = b < bend ? order(*b) : 0;
 
 			if (ac != bc)
 				return ac - bc;
@@ -339,20 +388,20 @@ static int verrevcmp(const char *a, const char *b)
 			a++;
 			b++;
 		}
-		while (*a == '0')
+		while (a < aend && *a == '0')
 			a++;
-		while (*b == '0')
+		while (b < bend && *b == '0')
 			b++;
-		while (isdigit(*a) && isdigit(*b)) {
+		while (a < aend && b < bend && isdigit(*a) && isdigit(*b)) {
 			if (!first_diff)
 				first_diff = *a - *b;
 			a++;
 			b++;
 		}
 
-		if (isdigit(*a))
+		if (a < aend && isdigit(*a))
 			return 1;
-		if (isdigit(*b))
+		if (b < bend && isdigit(*b))
 			return -1;
 		if (first_diff)
 			return first_diff;
@@ -388,55 +437,50 @@ static int dpkg_version_compare(struct dpkg_version *a, struct dpkg_version *b)
 	if (a->epoch < b->epoch)
 		return -1;
 
-	rc = verrevcmp(a->version, b->version);
+	rc = verrevcmp(a->version, a->version_len, b->version, b->version_len);
 	if (rc)
 		return rc;
 
-	return verrevcmp(a->revision, b->revision);
+	return verrevcmp(a->revision, a->revision_len, b->revision, b->revision_len);
+}
+
+/* the epoch consists of digits only, a missing one is 0 */
+static int dpkg_epoch(const struct evr_part *part, unsigned int *epoch)
+{
+	long aux = 0;
+
+	for (size_t i = 0; part->str != NULL && i < part->len; i++) {
+		aux = aux * 10 + (part->str[i] - '0');
+		if (aux > INT_MAX)
+			return -1;
+	}
+	*epoch = (unsigned int) aux;
+
+	return 0;
 }
 
 oval_result_t oval_debian_evr_string_cmp(const char *state, const char *sys, oval_operation_t operation)
 {
 	struct dpkg_version a, b;
-	const char *a_epoch, *a_version, *a_release;
-	const char *b_epoch, *b_version, *b_release;
-	char *a_copy, *b_copy;
-	long aux;
-
-	a_copy = oscap_strdup(sys);
-	b_copy = oscap_strdup(state);
-	parseEVR(a_copy, &a_epoch, &a_version, &a_release);
-	parseEVR(b_copy, &b_epoch, &b_version, &b_release);
-
-	if (!a_epoch)
-		a_epoch = "0";
-	if (!b_epoch)
-		b_epoch = "0";
-
-	aux = strtol(a_epoch, NULL, 10);
-	if (aux < INT_MIN || aux > INT_MAX) {
-		free(a_copy);
-		free(b_copy);
-		return OVAL_RESULT_ERROR; // Outside int range
-	}
-	a.epoch = (int) aux;
+	struct evr a_evr, b_evr;
 
-	aux = strtol(b_epoch, NULL, 10);
-	if (aux < INT_MIN || aux > INT_MAX) {
-		free(a_copy);
-		free(b_copy);
+	parseEVR(sys, &a_evr);
+	parseEVR(state, &b_evr);
+
+	if (dpkg_epoch(&a_evr.epoch, &a.epoch) != 0 ||
+	    dpkg_epoch(&b_evr.epoch, &b.epoch) != 0)
 		return OVAL_RESULT_ERROR; // Outside int range
-	}
-	b.epoch = (int) aux;
 
-	a.version = a_version;
-	a.revision = a_release;
-	b.version = b_version;
-	b.revision = b_release;
+	a.version = a_evr.version.str;
+	a.version_len = a_evr.version.len;
+	a.revision = a_evr.release.str;
+	a.revision_len = a_evr.release.len;
+	b.version = b_evr.version.str;
+	b.version_len = b_evr.version.len;
+	b.revision = b_evr.release.str;
+	b.revision_len = b_evr.release.len;
 	int result = dpkg_version_compare(&a, &b);
 
-	free(a_copy);
-	free(b_copy);
 	switch (operation) {
 	case OVAL_OPERATION_EQUALS:
 		return ((result == 0) ? OVAL_RESULT_TRUE : OVAL_RESULT_FALSE);
@@ -59,8 +59,10 @@ struct dpkg_version {
 	unsigned int epoch;
 	/** The upstream part of the version. */
 	const char *version;
+	size_t version_len;
 	/** The Debian revision part of the version. */
 	const char *revision;
+	size_t revision_len;
 };
 
 #endif
@@ -27,6 +27,8 @@
 #include "oval_definitions.h"
 #include "oval_types.h"
 #include "oval_system_characteristics.h"
+#include "oval_cmp_ip_address_impl.h"
+#include "oval_cmp_basic_impl.h"
 
 
 /**
@@ -40,5 +42,68 @@
  */
 oval_result_t oval_str_cmp_str(char *state_data, oval_datatype_t state_data_type, const char *sys_data, oval_operation_t operation);
 
+struct oval_cmp_operand;
+
+typedef oval_result_t (*oval_cmp_operand_fn)(const struct oval_cmp_operand *operand, const char *sys_data);
+
+/**
+ * State value decoded once for repeated comparisons with data collected
+ * from system by a fixed operation. The comparator and the kernel are
+ * chosen for the data type and the operation by oval_cmp_operand_init,
+ * the structure holds no allocated memory.
+ */
+struct oval_cmp_operand {
+	char *text;                 ///< value as defined by state or variable
+	oval_datatype_t datatype;   ///< data type of the value
+	oval_operation_t operation; ///< comparison type operation
+	oval_cmp_operand_fn cmp;    ///< comparator for the data type
+	union {
+		oval_int_cmp_fn integer;
+		oval_float_cmp_fn flt;
+		oval_string_cmp_fn string;
+	} kernel;                   ///< comparison for the operation, depends on the comparator
+	union {
+		intmax_t integer;
+		double flt;
+		bool boolean;
+		struct oval_ipaddr ipaddr;
+	} value;                    ///< decoded value, depends on the comparator
+};
+
+/**
+ * Decode state entity (or variable/value) for oval_cmp_operand_cmp_str.
+ * Values which can not be decoded are compared as oval_str_cmp_str does,
+ * including the reported errors.
+ * @param operand Operand to initialize
+ * @param state_data Value defined within state/entity/value or variable/value
+ * @param state_data_type Data type of the value
+ * @param operation Comparison type operation
+ */
+void oval_cmp_operand_init(struct oval_cmp_operand *operand, char *state_data, oval_datatype_t state_data_type, oval_operation_t operation);
+
+/**
+ * Compare decoded state value to data collected from system.
+ * The result is the same as of oval_str_cmp_str.
+ */
+static inline oval_result_t oval_cmp_operand_cmp_str(const struct oval_cmp_operand *operand, const char *sys_data)
+{
+	return operand->cmp(operand, sys_data);
+}
+
+/**
+ * Compare decoded state value to an integer collected from system without
+ * its text. The result is the same as of oval_cmp_operand_cmp_str on the
+ * integer's decimal text.
+ * @returns false if the operand is not a decoded integer, result is left unset
+ */
+bool oval_cmp_operand_cmp_integer(const struct oval_cmp_operand *operand, intmax_t sys_data, oval_result_t *result);
+
+/**
+ * Compare decoded state value to a boolean collected from system without
+ * its text, as oval_cmp_operand_cmp_integer does.
+ * @returns false if the operand is not a decoded boolean, result is left unset
+ */
+bool oval_cmp_operand_cmp_boolean(const struct oval_cmp_operand *operand, bool sys_data, oval_result_t *result);
+
 
 #endif
@@ -90,26 +90,19 @@ static inline int ipaddr_parse(int af, const char *oval_ip_string, uint32_t *mas
 	return ipv6addr_parse(oval_ip_string, mask_out, ip_out);
 }
 
-oval_result_t oval_ipaddr_cmp(int af, const char *s1, const char *s2, oval_operation_t op)
+static oval_result_t ipaddr_cmp_op(int af, void *addr1, uint32_t mask1, void *addr2, uint32_t mask2, oval_operation_t op)
 {
 	oval_result_t result = OVAL_RESULT_ERROR;
-	uint32_t mask1 = 0, mask2 = 0;
-	char addr1[INET6_ADDRSTRLEN];
-	char addr2[INET6_ADDRSTRLEN];
-
-	if (ipaddr_parse(af, s1, &mask1, &addr1) || ipaddr_parse(af, s2, &mask2, &addr2)) {
-		return result;
-	}
 
 	switch (op) {
 	case OVAL_OPERATION_EQUALS:
-		if (!ipaddr_cmp(af, &addr1, &addr2) && mask1 == mask2)
+		if (!ipaddr_cmp(af, addr1, addr2) && mask1 == mask2)
 			result = OVAL_RESULT_TRUE;
 		else
 			result = OVAL_RESULT_FALSE;
 		break;
 	case OVAL_OPERATION_NOT_EQUAL:
-		if (ipaddr_cmp(af, &addr1, &addr2) || mask1 != mask2)
+		if (ipaddr_cmp(af, addr1, addr2) || mask1 != mask2)
 			result = OVAL_RESULT_TRUE;
 		else
 			result = OVAL_RESULT_FALSE;
@@ -126,9 +119,9 @@ oval_result_t oval_ipaddr_cmp(int af, const char *s1, const char *s2, oval_opera
 		}
 
 		/* Otherwise, compare the first bits defined by mask1 */
-		ipaddr_mask(af, &addr1, mask1);
-		ipaddr_mask(af, &addr2, mask1);
-		if (ipaddr_cmp(af, &addr1, &addr2) == 0)
+		ipaddr_mask(af, addr1, mask1);
+		ipaddr_mask(af, addr2, mask1);
+		if (ipaddr_cmp(af, addr1, addr2) == 0)
 			result = OVAL_RESULT_TRUE;
 		else
 			result = OVAL_RESULT_FALSE;
@@ -137,9 +130,9 @@ oval_result_t oval_ipaddr_cmp(int af, const char *s1, const char *s2, oval_opera
 		if (mask1 != mask2) {
 			return OVAL_RESULT_ERROR;
 		}
-		ipaddr_mask(af, &addr1, mask1);
-		ipaddr_mask(af, &addr2, mask2);
-		if (ipaddr_cmp(af, &addr1, &addr2) < 0)
+		ipaddr_mask(af, addr1, mask1);
+		ipaddr_mask(af, addr2, mask2);
+		if (ipaddr_cmp(af, addr1, addr2) < 0)
 			result = OVAL_RESULT_TRUE;
 		else
 			result = OVAL_RESULT_FALSE;
@@ -148,9 +141,9 @@ oval_result_t oval_ipaddr_cmp(int af, const char *s1, const char *s2, oval_opera
 		if (mask1 != mask2) {
 			return OVAL_RESULT_ERROR;
 		}
-		ipaddr_mask(af, &addr1, mask1);
-		ipaddr_mask(af, &addr2, mask2);
-		if (ipaddr_cmp(af, &addr1, &addr2) <= 0)
+		ipaddr_mask(af, addr1, mask1);
+		ipaddr_mask(af, addr2, mask2);
+		if (ipaddr_cmp(af, addr1, addr2) <= 0)
 			result = OVAL_RESULT_TRUE;
 		else
 			result = OVAL_RESULT_FALSE;
@@ -167,9 +160,9 @@ oval_result_t oval_ipaddr_cmp(int af, const char *s1, const char *s2, oval_opera
 		}
 
 		/* Otherwise, compare the first bits defined by mask2 */
-		ipaddr_mask(af, &addr1, mask2);
-		ipaddr_mask(af, &addr2, mask2);
-		if (ipaddr_cmp(af, &addr1, &addr2) == 0)
+		ipaddr_mask(af, addr1, mask2);
+		ipaddr_mask(af, addr2, mask2);
+		if (ipaddr_cmp(af, addr1, addr2) == 0)
 			result = OVAL_RESULT_TRUE;
 		else
 			result = OVAL_RESULT_FALSE;
@@ -178,9 +171,9 @@ oval_result_t oval_ipaddr_cmp(int af, const char *s1, const char *s2, oval_opera
 		if (mask1 != mask2) {
 			return OVAL_RESULT_ERROR;
 		}
-		ipaddr_mask(af, &addr1, mask1);
-		ipaddr_mask(af, &addr2, mask2);
-		if (ipaddr_cmp(af, &addr1, &addr2) > 0)
+		ipaddr_mask(af, addr1, mask1);
+		ipaddr_mask(af, addr2, mask2);
+		if (ipaddr_cmp(af, addr1, addr2) > 0)
 			result = OVAL_RESULT_TRUE;
 		else
 			result = OVAL_RESULT_FALSE;
@@ -189,9 +182,9 @@ oval_result_t oval_ipaddr_cmp(int af, const char *s1, const char *s2, oval_opera
 		if (mask1 != mask2) {
 			return OVAL_RESULT_ERROR;
 		}
-		ipaddr_mask(af, &addr1, mask1);
-		ipaddr_mask(af, &addr2, mask2);
-		if (ipaddr_cmp(af, &addr1, &addr2) >= 0)
+		ipaddr_mask(af, addr1, mask1);
+		ipaddr_mask(af, addr2, mask2);
+		if (ipaddr_cmp(af, addr1, addr2) >= 0)
 			result = OVAL_RESULT_TRUE;
 		else
 			result = OVAL_RESULT_FALSE;
@@ -204,6 +197,41 @@ oval_result_t oval_ipaddr_cmp(int af, const char *s1, const char *s2, oval_opera
 	return result;
 }
 
+oval_result_t oval_ipaddr_cmp(int af, const char *s1, const char *s2, oval_operation_t op)
+{
+	uint32_t mask1 = 0, mask2 = 0;
+	char addr1[INET6_ADDRSTRLEN];
+	char addr2[INET6_ADDRSTRLEN];
+
+	if (ipaddr_parse(af, s1, &mask1, &addr1) || ipaddr_parse(af, s2, &mask2, &addr2)) {
+		return OVAL_RESULT_ERROR;
+	}
+
+	return ipaddr_cmp_op(af, addr1, mask1, addr2, mask2, op);
+}
+
+int oval_ipaddr_parse(int af, const char *s, struct oval_ipaddr *ip_out)
+{
+	ip_out->af = af;
+	ip_out->mask = 0;
+	return ipaddr_parse(af, s, &ip_out->mask, ip_out->addr);
+}
+
+oval_result_t oval_ipaddr_cmp_parsed(const struct oval_ipaddr *ip1, const char *s2, oval_operation_t op)
+{
+	uint32_t mask2 = 0;
+	char addr1[INET6_ADDRSTRLEN];
+	char addr2[INET6_ADDRSTRLEN];
+
+	if (ipaddr_parse(ip1->af, s2, &mask2, &addr2)) {
+		return OVAL_RESULT_ERROR;
+	}
+
+	/* The operation masks its operands in place */
+	memcpy(addr1, ip1->addr, sizeof(ip1->addr));
+	return ipaddr_cmp_op(ip1->af, addr1, ip1->mask, addr2, mask2, op);
+}
+
 static inline int ipv4addr_parse(const char *oval_ipv4_string, uint32_t *netmask_out, struct in_addr *ip_out)
 {
 	char *s, *pfx;
@@ -31,11 +31,20 @@
 #ifndef OSCAP_OVAL_IP_ADDRESS_IMPL_H_
 #define OSCAP_OVAL_IP_ADDRESS_IMPL_H_
 
+#include <stdint.h>
 #include "common/util.h"
 
 #include "oval_definitions.h"
 #include "oval_types.h"
 
+/**
+ * IP address or address set (CIDR) decoded by oval_ipaddr_parse.
+ */
+struct oval_ipaddr {
+	int af;                 ///< AF_INET or AF_INET6
+	uint32_t mask;          ///< netmask (IPv4) or prefix length (IPv6)
+	unsigned char addr[16]; ///< struct in_addr or struct in6_addr
+};
 
 /**
  * Compare two IP address or address sets (CIDR). The format of input string
@@ -49,5 +58,20 @@
  */
 oval_result_t oval_ipaddr_cmp(int af, const char *s1, const char *s2, oval_operation_t op);
 
+/**
+ * Decode IP address or address set (CIDR) for repeated comparisons
+ * with oval_ipaddr_cmp_parsed.
+ * @param af Internet address family (AF_INET or AF_INET6)
+ * @param s address as defined by state element
+ * @param ip_out decoded address
+ * @returns 0 on success, -1 if the address cannot be parsed
+ */
+int oval_ipaddr_parse(int af, const char *s, struct oval_ipaddr *ip_out);
+
+/**
+ * Same as oval_ipaddr_cmp, the state address is already decoded.
+ */
+oval_result_t oval_ipaddr_cmp_parsed(const struct oval_ipaddr *ip1, const char *s2, oval_operation_t op);
+
 
 #endif
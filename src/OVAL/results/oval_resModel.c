@@ -116,6 +116,21 @@ struct oval_results_model *oval_results_model_clone(struct oval_results_model *o
 	return new_resmodel;
 }
 
+void oval_results_model_clear(struct oval_results_model *model)
+{
+	struct oval_collection *old_systems = model->systems;
+	struct oval_iterator *it = oval_collection_iterator(old_systems);
+
+	model->systems = oval_collection_new();
+	while (oval_collection_iterator_has_more(it)) {
+		struct oval_result_system *old_system = oval_collection_iterator_next(it);
+		oval_result_system_new(model, oval_result_system_get_syschar_model(old_system));
+	}
+	oval_collection_iterator_free(it);
+	oval_collection_free_items(old_systems, (oscap_destruct_func) oval_result_system_free);
+	oval_generator_update_timestamp(model->generator);
+}
+
 void oval_results_model_set_export_system_characteristics(struct oval_results_model *model, bool export)
 {
 	model->export_sys_chars = export;
@@ -207,6 +222,7 @@ int oval_results_model_import_source(struct oval_results_model *model, struct os
 	context.results_model = model;
 	context.definition_model = oval_results_model_get_definition_model(model);
 	context.user_data = NULL;
+	context.id_filter = NULL;
 	oscap_setxmlerr(xmlGetLastError());
 	/* jump into document */
 	xmlTextReaderRead(context.reader);
@@ -284,6 +300,7 @@ static xmlNode *oval_results_to_dom(struct oval_results_model *results_model,
 		struct oval_definition_model *definition_model = oval_results_model_get_definition_model(results_model);
 		oval_definition_model_to_dom(definition_model, doc, root_node);
 	}
+	oscap_xml_stream_flush(doc, root_node);
 
 	xmlNode *results_node = xmlNewTextChild(root_node, ns_results, BAD_CAST "results", NULL);
 	struct oval_result_system_iterator *systems = oval_results_model_get_systems(results_model);
@@ -314,12 +331,23 @@ int oval_results_model_export(struct oval_results_model *results_model,
 			      struct oval_directives_model *directives_model,
 			      const char *file)
 {
-	struct oscap_source *source = oval_results_model_export_source(results_model, directives_model, file);
-	if (source == NULL) {
+	__attribute__nonnull__(results_model);
+
+	xmlDocPtr doc = xmlNewDoc(BAD_CAST "1.0");
+	if (doc == NULL) {
+		oscap_setxmlerr(xmlGetLastError());
 		return -1;
 	}
-	int ret = oscap_source_save_as(source, NULL);
-	oscap_source_free(source);
+
+	/* The results are written as they are built, see oscap_xml_stream_flush */
+	struct oscap_xml_stream *stream = oscap_xml_stream_new(file, doc);
+	if (stream == NULL) {
+		xmlFreeDoc(doc);
+		return -1;
+	}
+	oval_results_to_dom(results_model, directives_model, doc, NULL);
+	int ret = oscap_xml_stream_finish(stream);
+	xmlFreeDoc(doc);
 	return ret;
 }
 
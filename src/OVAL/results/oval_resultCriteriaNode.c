@@ -41,6 +41,7 @@
 #include "results/oval_results_impl.h"
 #include "adt/oval_collection_impl.h"
 #include "common/util.h"
+#include "common/memtag_priv.h"
 #include "common/debug_priv.h"
 
 typedef struct oval_result_criteria_node {
@@ -140,6 +141,7 @@ struct oval_result_criteria_node *oval_result_criteria_node_new(struct oval_resu
 		dE("Unsupported criteria node type: %d.", type);
 		return NULL;
 	}
+	oscap_memtag_alloc(OSCAP_MEMTAG_RESULTS, node, sizeof(oval_result_criteria_node_t));
 	node->sys = sys;
 	node->negate = negate;
 	node->applicability_check = applicability_check;
@@ -231,6 +233,7 @@ void oval_result_criteria_node_free(struct oval_result_criteria_node *node)
 	}
 	node->result = OVAL_RESULT_UNKNOWN;
 	node->type = OVAL_NODETYPE_UNKNOWN;
+	oscap_memtag_free(OSCAP_MEMTAG_RESULTS, node, sizeof(oval_result_criteria_node_t));
 	free(node);
 }
 
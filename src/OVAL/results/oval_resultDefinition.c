@@ -41,6 +41,7 @@
 #include "adt/oval_collection_impl.h"
 #include "public/oval_agent_api.h"
 #include "common/util.h"
+#include "common/memtag_priv.h"
 #include "common/debug_priv.h"
 
 typedef struct oval_result_definition {
@@ -56,6 +57,7 @@ typedef struct oval_result_definition {
 struct oval_result_definition *oval_result_definition_new(struct oval_result_system *sys, char *definition_id) {
 	oval_result_definition_t *definition = (oval_result_definition_t *)
 	    malloc(sizeof(oval_result_definition_t));
+	    oscap_memtag_alloc(OSCAP_MEMTAG_RESULTS, definition, sizeof(oval_result_definition_t));
 	if (definition == NULL)
 		return NULL;
 
@@ -110,6 +112,7 @@ void oval_result_definition_free(struct oval_result_definition *definition)
 	definition->messages = NULL;
 	definition->result = OVAL_RESULT_NOT_EVALUATED;
 	definition->instance = 1;
+	oscap_memtag_free(OSCAP_MEMTAG_RESULTS, definition, sizeof(oval_result_definition_t));
 	free(definition);
 }
 
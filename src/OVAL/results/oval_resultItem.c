@@ -39,6 +39,7 @@
 #include "adt/oval_collection_impl.h"
 #include "oval_system_characteristics_impl.h"
 #include "common/util.h"
+#include "common/memtag_priv.h"
 #include "common/debug_priv.h"
 
 typedef struct oval_result_item {
@@ -51,6 +52,7 @@ typedef struct oval_result_item {
 struct oval_result_item *oval_result_item_new(struct oval_result_system *sys, char *item_id) {
 	oval_result_item_t *item = (oval_result_item_t *)
 	    malloc(sizeof(oval_result_item_t));
+	    oscap_memtag_alloc(OSCAP_MEMTAG_RESULTS, item, sizeof(oval_result_item_t));
 	if (item == NULL)
 		return NULL;
 
@@ -94,6 +96,7 @@ void oval_result_item_free(struct oval_result_item *item)
 	item->result = OVAL_RESULT_NOT_EVALUATED;
 	item->sysitem = NULL;
 
+	oscap_memtag_free(OSCAP_MEMTAG_RESULTS, item, sizeof(oval_result_item_t));
 	free(item);
 }
 
@@ -36,6 +36,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <pthread.h>
 
 #include "oval_definitions.h"
 #include "oval_agent_api.h"
@@ -49,6 +50,7 @@
 
 #include "common/debug_priv.h"
 #include "common/_error.h"
+#include "common/elements.h"
 #include "common/util.h"
 #include "common/list.h"
 
@@ -57,6 +59,7 @@ typedef struct oval_result_system {
 	struct oval_smc *definitions;			///< Map contains lists of oval_result_definition
 	struct oval_smc *tests;				///< Map contains lists of oval_result_test
 	struct oval_syschar_model *syschar_model;
+	pthread_mutex_t lock;				///< Guards the maps when the tests are evaluated concurrently
 } oval_result_system_t;
 
 
@@ -117,6 +120,7 @@ struct oval_result_system *oval_result_system_new(struct oval_results_model *mod
 	sys->tests = oval_smc_new();
 	sys->syschar_model = syschar_model;
 	sys->model = model;
+	pthread_mutex_init(&sys->lock, NULL);
 
 	oval_results_model_add_system(model, sys);
 
@@ -150,6 +154,7 @@ void oval_result_system_free(struct oval_result_system *sys)
 	sys->syschar_model = NULL;
 	sys->tests = NULL;
 
+	pthread_mutex_destroy(&sys->lock);
 	free(sys);
 }
 
@@ -183,7 +188,12 @@ struct oval_result_definition *oval_result_system_get_definition(struct oval_res
 
 	// Previously, this structure used to hold only one result_definition per given ID.
 	// Now we need to return the very last one from a list.
-	return oval_smc_get_last(sys->definitions, id);
+	struct oval_result_definition *definition;
+
+	pthread_mutex_lock(&sys->lock);
+	definition = oval_smc_get_last(sys->definitions, id);
+	pthread_mutex_unlock(&sys->lock);
+	return definition;
 }
 
 struct oval_result_test *oval_result_system_get_test(struct oval_result_system *sys, char *id) {
@@ -191,7 +201,12 @@ struct oval_result_test *oval_result_system_get_test(struct oval_result_system *
 
 	// Previously, this structure used to hold only one result_test per given ID.
 	// Now we need to return the very last one from a list.
-	return oval_smc_get_last(sys->tests, id);
+	struct oval_result_test *test;
+
+	pthread_mutex_lock(&sys->lock);
+	test = oval_smc_get_last(sys->tests, id);
+	pthread_mutex_unlock(&sys->lock);
+	return test;
 }
 
 struct oval_result_definition *oval_result_system_get_new_definition
@@ -271,7 +286,9 @@ void oval_result_system_add_definition(struct oval_result_system *sys, struct ov
 	__attribute__nonnull__(sys);
 	if (definition) {
 		const char *id = oval_result_definition_get_id(definition);
+		pthread_mutex_lock(&sys->lock);
 		oval_smc_put_last(sys->definitions, id, definition);
+		pthread_mutex_unlock(&sys->lock);
 	}
 }
 
@@ -280,7 +297,9 @@ void oval_result_system_add_test(struct oval_result_system *sys, struct oval_res
 	__attribute__nonnull__(sys);
 	if (test) {
 		const char *id = oval_result_test_get_id(test);
+		pthread_mutex_lock(&sys->lock);
 		oval_smc_put_last(sys->tests, id, test);
+		pthread_mutex_unlock(&sys->lock);
 	}
 }
 
@@ -473,6 +492,7 @@ xmlNode *oval_result_system_to_dom(struct oval_result_system * sys,
 					_oval_result_definition_to_dom_based_on_directives(rslt_definition, directives, doc, definitions_node, tstmap);
 				}
 			}
+			oscap_xml_stream_flush(doc, definitions_node);
 		}
 	}
 	oval_definition_iterator_free(oval_definitions);
@@ -491,6 +511,7 @@ xmlNode *oval_result_system_to_dom(struct oval_result_system * sys,
 			struct oval_result_test *result_test = oval_smc_iterator_next(result_tests);
 			/* report the test */
 			oval_result_test_to_dom(result_test, doc, tests_node);
+			oscap_xml_stream_flush(doc, tests_node);
 			struct oval_test *oval_test = oval_result_test_get_test(result_test);
 			/* collect the objects that are referenced from reported test */
 			/* look for objects in path: test->object ...  */
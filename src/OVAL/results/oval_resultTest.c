@@ -35,7 +35,9 @@
 
 #include <string.h>
 #include <ctype.h>
+#include <pthread.h>
 #include "oval_agent_api_impl.h"
+#include "oval_directives_impl.h"
 #ifdef OVAL_PROBES_ENABLED
 #include "oval_probe_impl.h"
 #endif
@@ -47,7 +49,9 @@
 #include "collectVarRefs_impl.h"
 #include "public/oval_types.h"
 #include "common/util.h"
+#include "common/memtag_priv.h"
 #include "common/debug_priv.h"
+#include "common/profiling_priv.h"
 #include "common/_error.h"
 
 typedef struct oval_result_test {
@@ -65,6 +69,7 @@ struct oval_result_test *oval_result_test_new(struct oval_result_system *sys, ch
 {
 	oval_result_test_t *test = (oval_result_test_t *)
 	    malloc(sizeof(oval_result_test_t));
+	    oscap_memtag_alloc(OSCAP_MEMTAG_RESULTS, test, sizeof(oval_result_test_t));
 	if (test == NULL)
 		return NULL;
 
@@ -139,6 +144,7 @@ void oval_result_test_free(struct oval_result_test *test)
 	test->items = NULL;
 	test->bindings = NULL;
 	test->instance = 1;
+	oscap_memtag_free(OSCAP_MEMTAG_RESULTS, test, sizeof(oval_result_test_t));
 	free(test);
 }
 
@@ -190,7 +196,93 @@ void ores_clear(struct oresults *ores)
 	memset(ores, 0, sizeof (*ores));
 }
 
+/*
+ * The results of checks and operators depend only on whether each counter
+ * is zero, and for the true counter on whether it is 0, 1, or an even or
+ * odd number above. The class of the counters indexes tables of results
+ * computed once by the _ores_get_result_* functions below.
+ */
+#define ORES_TRUE_MASK     0x03
+#define ORES_FALSE_BIT     0x04
+#define ORES_ERROR_BIT     0x08
+#define ORES_UNKNOWN_BIT   0x10
+#define ORES_NOTEVAL_BIT   0x20
+#define ORES_NOTAPPL_BIT   0x40
+#define ORES_CLASS_COUNT   0x80
+
+static inline int ores_class(const struct oresults *ores)
+{
+	int cls;
+
+	if (ores->true_cnt < 2)
+		cls = ores->true_cnt;
+	else
+		cls = 2 + ores->true_cnt % 2;
+	if (ores->false_cnt > 0)
+		cls |= ORES_FALSE_BIT;
+	if (ores->error_cnt > 0)
+		cls |= ORES_ERROR_BIT;
+	if (ores->unknown_cnt > 0)
+		cls |= ORES_UNKNOWN_BIT;
+	if (ores->noteval_cnt > 0)
+		cls |= ORES_NOTEVAL_BIT;
+	if (ores->notappl_cnt > 0)
+		cls |= ORES_NOTAPPL_BIT;
+	return cls;
+}
+
+static oval_result_t _ores_get_result_bychk(struct oresults *ores, oval_check_t check);
+static oval_result_t _ores_get_result_byopr(struct oresults *ores, oval_operator_t op);
+
+static oval_result_t ores_bychk_table[OVAL_CHECK_ONLY_ONE + 1][ORES_CLASS_COUNT];
+static oval_result_t ores_byopr_table[OVAL_OPERATOR_XOR + 1][ORES_CLASS_COUNT];
+static pthread_once_t ores_tables_once = PTHREAD_ONCE_INIT;
+
+static void ores_tables_init(void)
+{
+	for (int cls = 0; cls < ORES_CLASS_COUNT; ++cls) {
+		struct oresults ores = {
+			.true_cnt = cls & ORES_TRUE_MASK,
+			.false_cnt = (cls & ORES_FALSE_BIT) != 0,
+			.error_cnt = (cls & ORES_ERROR_BIT) != 0,
+			.unknown_cnt = (cls & ORES_UNKNOWN_BIT) != 0,
+			.noteval_cnt = (cls & ORES_NOTEVAL_BIT) != 0,
+			.notappl_cnt = (cls & ORES_NOTAPPL_BIT) != 0,
+		};
+
+		for (int check = OVAL_CHECK_ALL; check <= OVAL_CHECK_ONLY_ONE; ++check)
+			ores_bychk_table[check][cls] = _ores_get_result_bychk(&ores, check);
+		for (int op = OVAL_OPERATOR_AND; op <= OVAL_OPERATOR_XOR; ++op)
+			ores_byopr_table[op][cls] = _ores_get_result_byopr(&ores, op);
+	}
+}
+
 oval_result_t ores_get_result_bychk(struct oresults *ores, oval_check_t check)
+{
+	int cls;
+
+	if (check < OVAL_CHECK_ALL || check > OVAL_CHECK_ONLY_ONE)
+		return _ores_get_result_bychk(ores, check);
+
+	cls = ores_class(ores);
+	if (check == OVAL_CHECK_NONE_EXIST && (cls & ~ORES_NOTAPPL_BIT) != 0)
+		dW("The 'none exist' CheckEnumeration value has been deprecated. "
+		   "Converted to check='none satisfy'.");
+
+	pthread_once(&ores_tables_once, ores_tables_init);
+	return ores_bychk_table[check][cls];
+}
+
+oval_result_t ores_get_result_byopr(struct oresults *ores, oval_operator_t op)
+{
+	if (op < OVAL_OPERATOR_AND || op > OVAL_OPERATOR_XOR)
+		return _ores_get_result_byopr(ores, op);
+
+	pthread_once(&ores_tables_once, ores_tables_init);
+	return ores_byopr_table[op][ores_class(ores)];
+}
+
+static oval_result_t _ores_get_result_bychk(struct oresults *ores, oval_check_t check)
 {
 	oval_result_t result = OVAL_RESULT_ERROR;
 
@@ -238,9 +330,6 @@ oval_result_t ores_get_result_bychk(struct oresults *ores, oval_check_t check)
 		}
 		break;
 	case OVAL_CHECK_NONE_EXIST:
-		dW("The 'none exist' CheckEnumeration value has been deprecated. "
-		   "Converted to check='none satisfy'.");
-		/* FALLTHROUGH */
 	case OVAL_CHECK_NONE_SATISFY:
 		if (ores->true_cnt > 0) {
 			result = OVAL_RESULT_FALSE;
@@ -279,7 +368,27 @@ oval_result_t ores_get_result_bychk(struct oresults *ores, oval_check_t check)
 	return result;
 }
 
-oval_result_t ores_get_result_byopr(struct oresults *ores, oval_operator_t op)
+/*
+ * Whether the result of ores_get_result_bychk can not be changed by any
+ * further results, e.g. check='all' with a false result.
+ */
+static bool ores_is_final_bychk(struct oresults *ores, oval_check_t check)
+{
+	switch (check) {
+	case OVAL_CHECK_ALL:
+		return ores->false_cnt > 0;
+	case OVAL_CHECK_AT_LEAST_ONE:
+	case OVAL_CHECK_NONE_EXIST:
+	case OVAL_CHECK_NONE_SATISFY:
+		return ores->true_cnt > 0;
+	case OVAL_CHECK_ONLY_ONE:
+		return ores->true_cnt > 1;
+	default:
+		return false;
+	}
+}
+
+static oval_result_t _ores_get_result_byopr(struct oresults *ores, oval_operator_t op)
 {
 	oval_result_t result = OVAL_RESULT_ERROR;
 
@@ -509,85 +618,72 @@ static oval_result_t _evaluate_sysent_record(struct oval_syschar_model *syschar_
 	return ores_get_result_byopr(&record_ores, OVAL_OPERATOR_AND);
 }
 
-static inline oval_result_t _evaluate_sysent(struct oval_syschar_model *syschar_model, struct oval_sysent *item_entity, struct oval_entity *state_entity, oval_operation_t state_entity_operation, struct oval_state_content *content)
-{
-	if (oval_sysent_get_status(item_entity) == SYSCHAR_STATUS_DOES_NOT_EXIST) {
-		return OVAL_RESULT_FALSE;
-	} else if (oval_entity_get_varref_type(state_entity) == OVAL_ENTITY_VARREF_ATTRIBUTE) {
-		struct oval_variable *state_entity_var;
-		if ((state_entity_var = oval_entity_get_variable(state_entity)) == NULL) {
-			oscap_seterr(OSCAP_EFAMILY_OVAL, "OVAL internal error: found NULL variable");
-			return -1;
-		}
-		const char *sys_data = oval_sysent_get_value(item_entity);
-		oval_check_t var_check = oval_state_content_get_var_check(content);
-
-		return _evaluate_sysent_with_variable(syschar_model,
-				state_entity_var, sys_data,
-				state_entity_operation, var_check);
-	} else {
-		struct oval_value *state_entity_val;
-		char *state_entity_val_text;
-		oval_datatype_t state_entity_val_datatype;
-
-		oval_datatype_t state_entity_type = oval_entity_get_datatype(state_entity);
-		if (state_entity_type == OVAL_DATATYPE_RECORD) {
-			if (state_entity_operation != OVAL_OPERATION_EQUALS) {
-				dE("The only allowed operation for comparing record types is 'equals'.");
-				return OVAL_RESULT_ERROR;
-			}
-			return _evaluate_sysent_record(syschar_model, content, item_entity);
-		} else {
-			if ((state_entity_val = oval_entity_get_value(state_entity)) == NULL) {
-				oscap_seterr(OSCAP_EFAMILY_OVAL, "OVAL internal error: found NULL entity value");
-				return -1;
-			}
-			if ((state_entity_val_text = oval_value_get_text(state_entity_val)) == NULL) {
-				oscap_seterr(OSCAP_EFAMILY_OVAL, "OVAL internal error: found NULL entity value text");
-				return -1;
-			}
-			state_entity_val_datatype = oval_value_get_datatype(state_entity_val);
+/*
+ * State compiled for evaluation of all the items of a test. The entities
+ * are resolved and their values decoded once, so that the comparison
+ * of an item does not need to walk the state contents again.
+ */
+struct state_prog_ent {
+	struct oval_state_content *content;
+	struct oval_entity *entity;
+	const char *name;
+	const char *error;              ///< internal error reported on evaluation
+	oval_operation_t operation;
+	oval_check_t ent_check;
+	oval_existence_t check_existence;
+	bool mask;
+	bool record;
+	struct oval_cmp_operand operand;
+	/* entity referring to a variable */
+	struct oval_variable *var;
+	oval_check_t var_check;
+	bool var_compiled;
+	bool var_null_text;
+	oval_syschar_collection_flag_t var_flag;
+	int var_count;
+	struct oval_cmp_operand *var_operands;
+};
 
-			const char *sys_data = oval_sysent_get_value(item_entity);
-			return oval_str_cmp_str(state_entity_val_text, state_entity_val_datatype, sys_data, state_entity_operation);
-		}
-	}
-}
+struct state_prog {
+	struct oval_state *state;
+	oval_operator_t operator;
+	bool error;                     ///< the state is malformed, entities after the error are missing
+	int count;
+	struct state_prog_ent *ents;
+};
 
-static oval_result_t eval_item(struct oval_syschar_model *syschar_model, struct oval_sysitem *cur_sysitem, struct oval_state *state)
+static void state_prog_init(struct state_prog *prog, struct oval_state *state)
 {
 	struct oval_state_content_iterator *state_contents_itr;
-	struct oresults ste_ores;
-	oval_operator_t operator;
-	oval_result_t result = OVAL_RESULT_ERROR;
+	int size = 0;
 
-	ores_clear(&ste_ores);
+	prog->state = state;
+	prog->operator = oval_state_get_operator(state);
+	prog->error = false;
+	prog->count = 0;
+	prog->ents = NULL;
 
 	state_contents_itr = oval_state_get_contents(state);
 	while (oval_state_content_iterator_has_more(state_contents_itr)) {
 		struct oval_state_content *content;
 		struct oval_entity *state_entity;
 		char *state_entity_name;
-		oval_operation_t state_entity_operation;
-		oval_check_t entity_check;
-		oval_existence_t check_existence;
-		oval_result_t ste_ent_res;
-		struct oval_sysent_iterator *item_entities_itr;
-		struct oresults ent_ores;
-		struct oval_status_counter counter;
-		bool found_matching_item;
+		struct state_prog_ent *ent;
 
 		if ((content = oval_state_content_iterator_next(state_contents_itr)) == NULL) {
 			oscap_seterr(OSCAP_EFAMILY_OVAL, "OVAL internal error: found NULL state content");
-			goto fail;
+			prog->error = true;
+			break;
 		}
 		if ((state_entity = oval_state_content_get_entity(content)) == NULL) {
 			oscap_seterr(OSCAP_EFAMILY_OVAL, "OVAL internal error: found NULL entity");
-			goto fail;
+			prog->error = true;
+			break;
 		}
 		if ((state_entity_name = oval_entity_get_name(state_entity)) == NULL) {
 			oscap_seterr(OSCAP_EFAMILY_OVAL, "OVAL internal error: found NULL entity name");
-			goto fail;
+			prog->error = true;
+			break;
 		}
 
 		if (oscap_streq(state_entity_name, "line") &&
@@ -605,9 +701,189 @@ static oval_result_t eval_item(struct oval_syschar_model *syschar_model, struct
 			}
 		}
 
-		entity_check = oval_state_content_get_ent_check(content);
-		check_existence = oval_state_content_get_check_existence(content);
-		state_entity_operation = oval_entity_get_operation(state_entity);
+		if (prog->count == size) {
+			size = size ? size * 2 : 4;
+			prog->ents = realloc(prog->ents, size * sizeof(struct state_prog_ent));
+		}
+		ent = &prog->ents[prog->count++];
+		memset(ent, 0, sizeof(struct state_prog_ent));
+
+		ent->content = content;
+		ent->entity = state_entity;
+		ent->name = state_entity_name;
+		ent->operation = oval_entity_get_operation(state_entity);
+		ent->ent_check = oval_state_content_get_ent_check(content);
+		ent->check_existence = oval_state_content_get_check_existence(content);
+		ent->mask = oval_entity_get_mask(state_entity);
+
+		if (oval_entity_get_varref_type(state_entity) == OVAL_ENTITY_VARREF_ATTRIBUTE) {
+			if ((ent->var = oval_entity_get_variable(state_entity)) == NULL)
+				ent->error = "OVAL internal error: found NULL variable";
+			ent->var_check = oval_state_content_get_var_check(content);
+		} else if (oval_entity_get_datatype(state_entity) == OVAL_DATATYPE_RECORD) {
+			ent->record = true;
+		} else {
+			struct oval_value *state_entity_val;
+			char *state_entity_val_text;
+
+			if ((state_entity_val = oval_entity_get_value(state_entity)) == NULL) {
+				ent->error = "OVAL internal error: found NULL entity value";
+			} else if ((state_entity_val_text = oval_value_get_text(state_entity_val)) == NULL) {
+				ent->error = "OVAL internal error: found NULL entity value text";
+			} else {
+				oval_cmp_operand_init(&ent->operand, state_entity_val_text,
+						oval_value_get_datatype(state_entity_val), ent->operation);
+			}
+		}
+	}
+	oval_state_content_iterator_free(state_contents_itr);
+}
+
+static void state_prog_clear(struct state_prog *prog)
+{
+	for (int i = 0; i < prog->count; ++i)
+		free(prog->ents[i].var_operands);
+	free(prog->ents);
+	prog->ents = NULL;
+	prog->count = 0;
+}
+
+/* The variable is computed on the first comparison which needs it, as it would be without the program */
+static int state_prog_ent_compile_variable(struct oval_syschar_model *syschar_model, struct state_prog_ent *ent)
+{
+	struct oval_value_iterator *val_itr;
+	int size = 0;
+
+	if (ent->var_compiled)
+		return 0;
+
+	if (0 != oval_syschar_model_compute_variable(syschar_model, ent->var)) {
+		return -1;
+	}
+
+	ent->var_flag = oval_variable_get_collection_flag(ent->var);
+	if (ent->var_flag == SYSCHAR_FLAG_COMPLETE || ent->var_flag == SYSCHAR_FLAG_INCOMPLETE) {
+		val_itr = oval_variable_get_values(ent->var);
+		while (oval_value_iterator_has_more(val_itr)) {
+			struct oval_value *var_val;
+			char *state_entity_val_text;
+
+			var_val = oval_value_iterator_next(val_itr);
+			state_entity_val_text = oval_value_get_text(var_val);
+			if (state_entity_val_text == NULL) {
+				ent->var_null_text = true;
+				break;
+			}
+			if (ent->var_count == size) {
+				size = size ? size * 2 : 4;
+				ent->var_operands = realloc(ent->var_operands, size * sizeof(struct oval_cmp_operand));
+			}
+			oval_cmp_operand_init(&ent->var_operands[ent->var_count++],
+					state_entity_val_text, oval_value_get_datatype(var_val), ent->operation);
+		}
+		oval_value_iterator_free(val_itr);
+	}
+
+	ent->var_compiled = true;
+	return 0;
+}
+
+static oval_result_t state_prog_ent_eval_variable(struct oval_syschar_model *syschar_model, struct state_prog_ent *ent, const char *sys_data)
+{
+	oval_result_t ent_val_res;
+
+	if (state_prog_ent_compile_variable(syschar_model, ent) != 0)
+		return -1;
+
+	switch (ent->var_flag) {
+	case SYSCHAR_FLAG_COMPLETE:
+	case SYSCHAR_FLAG_INCOMPLETE:{
+		struct oresults var_ores;
+
+		ores_clear(&var_ores);
+		for (int i = 0; i < ent->var_count; ++i) {
+			oval_result_t var_val_res;
+
+			var_val_res = oval_cmp_operand_cmp_str(&ent->var_operands[i], sys_data);
+			if (var_val_res == OVAL_RESULT_ERROR) {
+				dW("Can't compare variable '%s' value = '%s' with collected item entity = '%s'",
+					oval_variable_get_id(ent->var), ent->var_operands[i].text, sys_data);
+			}
+			ores_add_res(&var_ores, var_val_res);
+		}
+		if (ent->var_null_text) {
+			dE("Found NULL variable value text.");
+			ores_add_res(&var_ores, OVAL_RESULT_ERROR);
+		}
+
+		ent_val_res = ores_get_result_bychk(&var_ores, ent->var_check);
+		} break;
+	case SYSCHAR_FLAG_ERROR:
+	case SYSCHAR_FLAG_DOES_NOT_EXIST:
+	case SYSCHAR_FLAG_NOT_COLLECTED:
+	case SYSCHAR_FLAG_NOT_APPLICABLE:
+		ent_val_res = OVAL_RESULT_ERROR;
+		break;
+	default:
+		ent_val_res = -1;
+	}
+
+	return ent_val_res;
+}
+
+static oval_result_t _evaluate_sysent_value(const struct oval_cmp_operand *operand, struct oval_sysent *item_entity)
+{
+	char buf[OVAL_SYSENT_VALUE_BUFSIZE];
+	oval_result_t result;
+	intmax_t integer;
+	bool boolean;
+
+	/* values collected as numbers are compared without their text */
+	if (oval_sysent_get_integer(item_entity, &integer)
+			&& oval_cmp_operand_cmp_integer(operand, integer, &result))
+		return result;
+	if (oval_sysent_get_boolean(item_entity, &boolean)
+			&& oval_cmp_operand_cmp_boolean(operand, boolean, &result))
+		return result;
+
+	return oval_cmp_operand_cmp_str(operand, oval_sysent_get_value_text(item_entity, buf, sizeof(buf)));
+}
+
+static inline oval_result_t _evaluate_sysent(struct oval_syschar_model *syschar_model, struct oval_sysent *item_entity, struct state_prog_ent *ent)
+{
+	if (oval_sysent_get_status(item_entity) == SYSCHAR_STATUS_DOES_NOT_EXIST) {
+		return OVAL_RESULT_FALSE;
+	} else if (ent->error != NULL) {
+		oscap_seterr(OSCAP_EFAMILY_OVAL, "%s", ent->error);
+		return -1;
+	} else if (ent->var != NULL) {
+		return state_prog_ent_eval_variable(syschar_model, ent, oval_sysent_get_value(item_entity));
+	} else if (ent->record) {
+		if (ent->operation != OVAL_OPERATION_EQUALS) {
+			dE("The only allowed operation for comparing record types is 'equals'.");
+			return OVAL_RESULT_ERROR;
+		}
+		return _evaluate_sysent_record(syschar_model, ent->content, item_entity);
+	} else {
+		return _evaluate_sysent_value(&ent->operand, item_entity);
+	}
+}
+
+static oval_result_t eval_item(struct oval_syschar_model *syschar_model, struct oval_sysitem *cur_sysitem, struct state_prog *prog)
+{
+	struct oval_state *state = prog->state;
+	struct oresults ste_ores;
+	oval_result_t result = OVAL_RESULT_ERROR;
+
+	ores_clear(&ste_ores);
+
+	for (int i = 0; i < prog->count; ++i) {
+		struct state_prog_ent *ent = &prog->ents[i];
+		oval_result_t ste_ent_res;
+		struct oval_sysent_iterator *item_entities_itr;
+		struct oresults ent_ores;
+		struct oval_status_counter counter;
+		bool found_matching_item;
 
 		ores_clear(&ent_ores);
 		found_matching_item = false;
@@ -624,23 +900,22 @@ static oval_result_t eval_item(struct oval_syschar_model *syschar_model, struct
 			if (item_entity == NULL) {
 				oscap_seterr(OSCAP_EFAMILY_OVAL, "OVAL internal error: found NULL sysent");
 				oval_sysent_iterator_free(item_entities_itr);
-				goto fail;
+				return OVAL_RESULT_ERROR;
 			}
 			item_status = oval_sysent_get_status(item_entity);
 			oval_status_counter_add_status(&counter, item_status);
 
 			item_entity_name = oval_sysent_get_name(item_entity);
-			if (strcmp(item_entity_name, state_entity_name))
+			if (strcmp(item_entity_name, ent->name))
 				continue;
 
 			found_matching_item = true;
 
 			/* copy mask attribute from state to item */
-			if (oval_entity_get_mask(state_entity))
+			if (ent->mask)
 				oval_sysent_set_mask(item_entity,1);
 
-			ent_val_res = _evaluate_sysent(syschar_model, item_entity, state_entity,
-					state_entity_operation, content);
+			ent_val_res = _evaluate_sysent(syschar_model, item_entity, ent);
 			if (ent_val_res == OVAL_RESULT_TRUE) {
 				dI("Entity '%s'='%s' of item '%s' matches corresponding entity in state '%s'.",
 						oval_sysent_get_name(item_entity),
@@ -655,7 +930,7 @@ static oval_result_t eval_item(struct oval_syschar_model *syschar_model, struct
 			}
 			if (((signed) ent_val_res) == -1) {
 				oval_sysent_iterator_free(item_entities_itr);
-				goto fail;
+				return OVAL_RESULT_ERROR;
 			}
 
 			ores_add_res(&ent_ores, ent_val_res);
@@ -664,31 +939,27 @@ static oval_result_t eval_item(struct oval_syschar_model *syschar_model, struct
 
 		if (!found_matching_item)
 			dW("Entity name '%s' from state (id: '%s') not found in item (id: '%s').",
-			   state_entity_name, oval_state_get_id(state), oval_sysitem_get_id(cur_sysitem));
+			   ent->name, oval_state_get_id(state), oval_sysitem_get_id(cur_sysitem));
 
-		oval_result_t cres = oval_status_counter_get_result(&counter, check_existence);
+		oval_result_t cres = oval_status_counter_get_result(&counter, ent->check_existence);
 		/* The entity check results are only relevant when the check existence is satisfied */
 		if (cres == OVAL_RESULT_TRUE) {
-			ste_ent_res = ores_get_result_bychk(&ent_ores, entity_check);
+			ste_ent_res = ores_get_result_bychk(&ent_ores, ent->ent_check);
 			ores_add_res(&ste_ores, ste_ent_res);
 		} else {
 			ores_add_res(&ste_ores, cres);
 		}
 	}
-	oval_state_content_iterator_free(state_contents_itr);
 
-	operator = oval_state_get_operator(state);
-	result = ores_get_result_byopr(&ste_ores, operator);
+	if (prog->error)
+		return OVAL_RESULT_ERROR;
+
+	result = ores_get_result_byopr(&ste_ores, prog->operator);
 	dI("Item '%s' compared to state '%s' with result %s.",
 			   oval_sysitem_get_id(cur_sysitem), oval_state_get_id(state),
 			   oval_result_get_text(result));
 
 	return result;
-
- fail:
-	oval_state_content_iterator_free(state_contents_itr);
-
-	return OVAL_RESULT_ERROR;
 }
 
 #define ITEMMAP (struct oval_string_map    *)args[2]
@@ -715,12 +986,22 @@ static oval_result_t eval_check_state(struct oval_test *test, void **args)
 	oval_result_t result;
 	oval_check_t ste_check;
 	oval_operator_t ste_opr;
+	struct oval_state_iterator *ste_itr;
+	struct state_prog *progs = NULL;
+	int progs_cnt = 0, progs_size = 0;
+	struct oval_results_model *results_model;
+	bool short_circuit;
 
 	ste_check = oval_test_get_check(test);
 	ste_opr = oval_test_get_state_operator(test);
 	syschar_model = oval_result_system_get_syschar_model(SYSTEM);
 	ores_clear(&item_ores);
 
+	/* Results of the individual items are exported only with full content,
+	 * otherwise the evaluation can stop as soon as the test result is known. */
+	results_model = oval_result_system_get_results_model(SYSTEM);
+	short_circuit = oval_directives_model_is_thin(oval_results_model_get_directives_model(results_model));
+
 	char *state_names = oval_test_get_state_names(test);
 	if (state_names) {
 		dI("In test '%s' %s of the collected items must satisfy these states: %s.",
@@ -728,15 +1009,33 @@ static oval_result_t eval_check_state(struct oval_test *test, void **args)
 		free(state_names);
 	}
 
+	/* Compile the states once for all the items */
+	ste_itr = oval_test_get_states(test);
+	while (oval_state_iterator_has_more(ste_itr)) {
+		struct oval_state *ste = oval_state_iterator_next(ste_itr);
+
+		if (progs_cnt == progs_size) {
+			progs_size = progs_size ? progs_size * 2 : 2;
+			progs = realloc(progs, progs_size * sizeof(struct state_prog));
+		}
+		state_prog_init(&progs[progs_cnt++], ste);
+	}
+	oval_state_iterator_free(ste_itr);
+
 	ritems_itr = oval_result_test_get_items(TEST);
 	while (oval_result_item_iterator_has_more(ritems_itr)) {
 		struct oval_result_item *ritem;
 		struct oval_sysitem *item;
 		oval_syschar_status_t item_status;
 		struct oresults ste_ores;
-		struct oval_state_iterator *ste_itr;
 		oval_result_t item_res;
 
+		if (short_circuit && ores_is_final_bychk(&item_ores, ste_check)) {
+			dI("Result of test '%s' is determined, remaining items are not evaluated.",
+				oval_test_get_id(test));
+			break;
+		}
+
 		ritem = oval_result_item_iterator_next(ritems_itr);
 		item = oval_result_item_get_sysitem(ritem);
 
@@ -759,16 +1058,12 @@ static oval_result_t eval_check_state(struct oval_test *test, void **args)
 
 		ores_clear(&ste_ores);
 
-		ste_itr = oval_test_get_states(test);
-		while (oval_state_iterator_has_more(ste_itr)) {
-			struct oval_state *ste;
+		for (int i = 0; i < progs_cnt; ++i) {
 			oval_result_t ste_res;
 
-			ste = oval_state_iterator_next(ste_itr);
-			ste_res = eval_item(syschar_model, item, ste);
+			ste_res = eval_item(syschar_model, item, &progs[i]);
 			ores_add_res(&ste_ores, ste_res);
 		}
-		oval_state_iterator_free(ste_itr);
 
 		item_res = ores_get_result_byopr(&ste_ores, ste_opr);
 		ores_add_res(&item_ores, item_res);
@@ -776,6 +1071,10 @@ static oval_result_t eval_check_state(struct oval_test *test, void **args)
 	}
 	oval_result_item_iterator_free(ritems_itr);
 
+	for (int i = 0; i < progs_cnt; ++i)
+		state_prog_clear(&progs[i]);
+	free(progs);
+
 	result = ores_get_result_bychk(&item_ores, ste_check);
 
 	return result;
@@ -1006,8 +1305,9 @@ _oval_result_test_evaluate_items(struct oval_test *test, struct oval_syschar *sy
 	return result;
 }
 
-/* this function will gather all the necessary ingredients and call 'evaluate_items' when it finds them */
-static oval_result_t _oval_result_test_result(struct oval_result_test *rtest, void **args)
+/* this function will gather all the necessary ingredients and call 'evaluate_items' when it finds them,
+ * the object is probed only if 'probe' is set, otherwise it has to be collected already */
+static oval_result_t _oval_result_test_result(struct oval_result_test *rtest, void **args, bool probe)
 {
 	__attribute__nonnull__(rtest);
 
@@ -1026,7 +1326,7 @@ static oval_result_t _oval_result_test_result(struct oval_result_test *rtest, vo
 	struct oval_result_system *sys = oval_result_test_get_system(rtest);
 	struct oval_results_model *results_model = oval_result_system_get_results_model(sys);
 	struct oval_probe_session *probe_session = oval_results_model_get_probe_session(results_model);
-	if (probe_session != NULL) {
+	if (probe && probe_session != NULL) {
 		/* probe test */
 		int ret = oval_probe_query_test(probe_session, test);
 		if (ret != 0) {
@@ -1134,10 +1434,66 @@ static void _oval_result_test_initialize_bindings(struct oval_result_test *rslt_
 	rslt_test->bindings_initialized = true;
 }
 
-oval_result_t oval_result_test_eval(struct oval_result_test *rtest)
+int oval_result_test_collect(struct oval_result_test *rtest)
 {
 	__attribute__nonnull__(rtest);
 
+	struct oval_test *test = oval_result_test_get_test(rtest);
+
+	if (rtest->result != OVAL_RESULT_NOT_EVALUATED || oval_test_get_subtype(test) == OVAL_INDEPENDENT_UNKNOWN)
+		return 0;
+
+#if defined(OVAL_PROBES_ENABLED)
+	struct oval_result_system *sys = oval_result_test_get_system(rtest);
+	struct oval_results_model *results_model = oval_result_system_get_results_model(sys);
+	struct oval_probe_session *probe_session = oval_results_model_get_probe_session(results_model);
+	if (probe_session != NULL && oval_probe_query_test(probe_session, test) != 0)
+		return -1;
+
+	/* the variables of the states are otherwise computed on the first comparison */
+	struct oval_syschar_model *syschar_model = oval_result_system_get_syschar_model(sys);
+	struct oval_state_iterator *ste_itr = oval_test_get_states(test);
+	int ret = 0;
+	while (ret == 0 && oval_state_iterator_has_more(ste_itr)) {
+		struct oval_state *ste = oval_state_iterator_next(ste_itr);
+		struct oval_state_content_iterator *contents = oval_state_get_contents(ste);
+
+		while (ret == 0 && oval_state_content_iterator_has_more(contents)) {
+			struct oval_state_content *content = oval_state_content_iterator_next(contents);
+			struct oval_entity *entity = oval_state_content_get_entity(content);
+			struct oval_variable *var;
+
+			if (entity == NULL || oval_entity_get_varref_type(entity) != OVAL_ENTITY_VARREF_ATTRIBUTE)
+				continue;
+			if ((var = oval_entity_get_variable(entity)) != NULL)
+				ret = oval_syschar_model_compute_variable(syschar_model, var);
+		}
+		oval_state_content_iterator_free(contents);
+	}
+	oval_state_iterator_free(ste_itr);
+
+	return ret;
+#else
+	return 0;
+#endif
+}
+
+/* The tested items are exported only in the full content of a definition,
+ * with thin results they would just be kept until the end of the session. */
+static void _oval_result_test_drop_unreported_items(struct oval_result_test *rtest)
+{
+	struct oval_results_model *results_model = oval_result_system_get_results_model(rtest->system);
+
+	if (!oval_directives_model_is_thin(oval_results_model_get_directives_model(results_model)))
+		return;
+
+	oval_collection_free_items(rtest->items, (oscap_destruct_func) oval_result_item_free);
+	rtest->items = oval_collection_new();
+}
+
+static oval_result_t _oval_result_test_eval(struct oval_result_test *rtest, bool probe)
+{
+
 	struct oval_test *test = oval_result_test_get_test(rtest);
 	const char *type = oval_subtype_get_text(oval_test_get_subtype(test));
 	const char *test_id = oval_test_get_id(test);
@@ -1148,14 +1504,18 @@ oval_result_t oval_result_test_eval(struct oval_result_test *rtest)
 		if (oval_test_get_subtype(oval_result_test_get_test(rtest)) != OVAL_INDEPENDENT_UNKNOWN) {
 			struct oval_string_map *tmp_map = oval_string_map_new();
 			void *args[] = { rtest->system, rtest, tmp_map };
+			struct oscap_profiling_mark mark;
 			dIndent(1);
-			rtest->result = _oval_result_test_result(rtest, args);
+			oscap_profiling_start(&mark);
+			rtest->result = _oval_result_test_result(rtest, args, probe);
+			oscap_profiling_stop(&mark, OSCAP_PROFILING_TEST, test_id, NULL, 0);
 			dIndent(-1);
 			oval_string_map_free(tmp_map, NULL);
 
 			if (!rtest->bindings_initialized) {
 				_oval_result_test_initialize_bindings(rtest);
 			}
+			_oval_result_test_drop_unreported_items(rtest);
 		}
 		else
 			rtest->result = OVAL_RESULT_UNKNOWN;
@@ -1166,6 +1526,20 @@ oval_result_t oval_result_test_eval(struct oval_result_test *rtest)
 	return rtest->result;
 }
 
+oval_result_t oval_result_test_eval(struct oval_result_test *rtest)
+{
+	__attribute__nonnull__(rtest);
+
+	return _oval_result_test_eval(rtest, true);
+}
+
+oval_result_t oval_result_test_eval_collected(struct oval_result_test *rtest)
+{
+	__attribute__nonnull__(rtest);
+
+	return _oval_result_test_eval(rtest, false);
+}
+
 oval_result_t oval_result_test_get_result(struct oval_result_test * rtest)
 {
 	__attribute__nonnull__(rtest);
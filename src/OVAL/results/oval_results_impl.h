@@ -97,6 +97,11 @@ oval_result_t ores_get_result_byopr(struct oresults *ores, oval_operator_t op);
 struct oval_results_model *oval_results_model_new_with_probe_session(struct oval_definition_model *definition_model, struct oval_syschar_model **syschar_models, struct oval_probe_session *probe_session);
 #endif
 struct oval_probe_session *oval_results_model_get_probe_session(struct oval_results_model *model);
+/**
+ * Drop the results of all the systems, the systems are kept with their
+ * system characteristics models and the directives are kept too.
+ */
+void oval_results_model_clear(struct oval_results_model *model);
 void oval_results_model_add_system(struct oval_results_model *, struct oval_result_system *);
 
 struct oval_result_definition_iterator *oval_result_definition_iterator_new(struct oval_smc *mapping);
@@ -104,6 +109,18 @@ struct oval_result_test_iterator *oval_result_test_iterator_new(struct oval_smc
 
 const char *oval_result_test_get_id(const struct oval_result_test *test);
 
+/**
+ * Probe the object of the test and compute the variables referenced by its states,
+ * so that the test can be evaluated by oval_result_test_eval_collected().
+ * @return 0 on success, otherwise the test has to be evaluated by oval_result_test_eval()
+ */
+int oval_result_test_collect(struct oval_result_test *rtest);
+/**
+ * Evaluate a test prepared by oval_result_test_collect(). The probe session is not used,
+ * distinct tests of a result system can be evaluated by concurrent threads.
+ */
+oval_result_t oval_result_test_eval_collected(struct oval_result_test *rtest);
+
 
 struct oval_result_definition *oval_result_system_prepare_definition(struct oval_result_system *sys, const char *id);
 
@@ -61,6 +61,8 @@
 #include <limits.h>
 #include <unistd.h>
 #include <libgen.h>
+#include <poll.h>
+#include <pthread.h>
 
 #define SCE_SCRIPT "oscap-run-sce-script"
 
@@ -217,12 +219,14 @@ void sce_check_result_export(struct sce_check_result* v, const char* target_file
 struct sce_session
 {
 	struct oscap_list* results;
+	pthread_mutex_t lock; // scripts of several rules can be run at once
 };
 
 struct sce_session* sce_session_new(void)
 {
 	struct sce_session* ret = malloc(sizeof(struct sce_session));
 	ret->results = oscap_list_new();
+	pthread_mutex_init(&ret->lock, NULL);
 
 	return ret;
 }
@@ -233,6 +237,7 @@ void sce_session_free(struct sce_session* s)
 		return;
 
 	oscap_list_free(s->results, (oscap_destruct_func) sce_check_result_free);
+	pthread_mutex_destroy(&s->lock);
 	free(s);
 }
 
@@ -244,7 +249,9 @@ void sce_session_reset(struct sce_session* s)
 
 void sce_session_add_check_result(struct sce_session* s, struct sce_check_result* result)
 {
+	pthread_mutex_lock(&s->lock);
 	oscap_list_push(s->results, result);
+	pthread_mutex_unlock(&s->lock);
 }
 
 OSCAP_ITERATOR_GEN(sce_check_result)
@@ -326,17 +333,18 @@ void sce_parameters_allocate_session(struct sce_parameters* v)
 
 static void _pipe_try_read_into_string(int fd, struct oscap_string *string, bool *eof)
 {
-	// FIXME: Read by larger chunks in the future
-	char readbuf;
+	char readbuf[4096];
 	while (true) {
-		const int read_status = read(fd, &readbuf, 1);
-		if (read_status == 1) {  // successful read
-			if (readbuf == '&') {
-				// & is a special case, we have to "escape" it manually
-				// (all else will eventually get handled by libxml)
-				oscap_string_append_string(string, "&amp;");
-			} else {
-				oscap_string_append_char(string, readbuf);
+		const ssize_t read_status = read(fd, readbuf, sizeof(readbuf));
+		if (read_status > 0) {  // successful read
+			for (ssize_t i = 0; i < read_status; ++i) {
+				if (readbuf[i] == '&') {
+					// & is a special case, we have to "escape" it manually
+					// (all else will eventually get handled by libxml)
+					oscap_string_append_string(string, "&amp;");
+				} else {
+					oscap_string_append_char(string, readbuf[i]);
+				}
 			}
 		}
 		else if (read_status == 0) {  // EOF
@@ -344,7 +352,7 @@ static void _pipe_try_read_into_string(int fd, struct oscap_string *string, bool
 			break;
 		}
 		else {
-			if (errno == EAGAIN) {
+			if (errno == EAGAIN || errno == EINTR) {
 				// NOOP, we are waiting for more input
 				break;
 			}
@@ -526,30 +534,38 @@ xccdf_test_result_type_t sce_engine_eval_rule(struct xccdf_policy *policy, const
 		free_env_values(env_values, index_of_first_env_value_not_compiled_in, env_value_count);
 		return XCCDF_RESULT_ERROR;
 	}
+	// scripts of other rules may be forked concurrently, they must not inherit our pipes
+	// otherwise we wouldn't see the end of file until they finish too
+	fcntl(stdout_pipefd[0], F_SETFD, FD_CLOEXEC);
+	fcntl(stdout_pipefd[1], F_SETFD, FD_CLOEXEC);
+	fcntl(stderr_pipefd[0], F_SETFD, FD_CLOEXEC);
+	fcntl(stderr_pipefd[1], F_SETFD, FD_CLOEXEC);
 
 	// FIXME: We definitely want to impose security restrictions in the forked child process in the future.
 	//        This would prevent scripts from writing to files or deleting them.
 
+	// printed by the child if the exec fails, it can't format anything after vfork
+	char *exec_error = oscap_sprintf("Unexpected error when executing script '%s'.\n", href);
+
+#if defined(OS_LINUX)
+	// the child shares our memory until it execs, so copying the page tables
+	// of the whole process isn't paid for each script
+	int fork_result = vfork();
+#else
 	int fork_result = fork();
+#endif
 	if (fork_result >= 0)
 	{
 		// fork successful
 
 		if (fork_result == 0)
 		{
-			// we won't read from the pipes, so close the reading fd
-			close(stdout_pipefd[0]);
-			close(stderr_pipefd[0]);
+			// after vfork only system calls are safe here, the memory belongs to the parent
 
-			// forward stdout and stderr to our custom opened pipes
-			dup2(stdout_pipefd[1], fileno(stdout));
-			dup2(stderr_pipefd[1], fileno(stderr));
-
-			// we duplicated the file descriptors twice, we can close the original
-			// ones now, stdout and stderr will be closed properly after the execved
-			// script/executable finishes
-			close(stdout_pipefd[1]);
-			close(stderr_pipefd[1]);
+			// forward stdout and stderr to our custom opened pipes, the originals
+			// are closed on exec
+			dup2(stdout_pipefd[1], STDOUT_FILENO);
+			dup2(stderr_pipefd[1], STDERR_FILENO);
 
 			// before we execute the script, lets make sure we get SIGTERM when
 			// oscap is killed, crashes or otherwise terminates
@@ -581,17 +597,18 @@ xccdf_test_result_type_t sce_engine_eval_rule(struct xccdf_policy *policy, const
 				execve(tmp_href, argvp, env_values);
 			}
 
-			free_env_values(env_values, index_of_first_env_value_not_compiled_in, env_value_count);
-
 			// no need to check the return value of execve, if it returned at all we are in trouble
-			printf("Unexpected error when executing script '%s'. Error message follows.\n", href);
-			perror("execve");
+			if (write(STDOUT_FILENO, exec_error, strlen(exec_error)) < 0) {
+				// nothing else to report it to
+			}
 
 			// the parent process considers us a script check, we have to return a value that will mean XCCDF_RESULT_ERROR
-			exit(103);
+			_exit(103);
 		}
 		else
 		{
+			free(exec_error);
+
 			// we won't write to the pipes, so close the writing fd
 			close(stdout_pipefd[1]);
 			close(stderr_pipefd[1]);
@@ -636,15 +653,25 @@ xccdf_test_result_type_t sce_engine_eval_rule(struct xccdf_policy *policy, const
 			bool stdout_eof = false;
 			bool stderr_eof = false;
 
+			struct pollfd fds[2];
+
 			while (!stdout_eof || !stderr_eof) {
-				if (!stdout_eof)
+				// negative descriptors are ignored by poll
+				fds[0].fd = stdout_eof ? -1 : stdout_pipefd[0];
+				fds[0].events = POLLIN;
+				fds[1].fd = stderr_eof ? -1 : stderr_pipefd[0];
+				fds[1].events = POLLIN;
+				if (poll(fds, 2, -1) == -1) {
+					if (errno == EINTR)
+						continue;
+					break;
+				}
+
+				if (!stdout_eof && fds[0].revents != 0)
 					_pipe_try_read_into_string(stdout_pipefd[0], stdout_string, &stdout_eof);
 
-				if (!stderr_eof)
+				if (!stderr_eof && fds[1].revents != 0)
 					_pipe_try_read_into_string(stderr_pipefd[0], stderr_string, &stderr_eof);
-
-				// sleep for 10ms to avoid wasting CPU
-				usleep(10 * 1000);
 			}
 
 			close(stdout_pipefd[0]);
@@ -714,6 +741,7 @@ xccdf_test_result_type_t sce_engine_eval_rule(struct xccdf_policy *policy, const
 	}
 	else
 	{
+		free(exec_error);
 		free_env_values(env_values, index_of_first_env_value_not_compiled_in, env_value_count);
 
 		close(stdout_pipefd[0]);
@@ -726,6 +754,10 @@ xccdf_test_result_type_t sce_engine_eval_rule(struct xccdf_policy *policy, const
 
 bool xccdf_policy_model_register_engine_sce(struct xccdf_policy_model * model, struct sce_parameters *parameters)
 {
-	return xccdf_policy_model_register_engine_and_query_callback(model,
-		"http://open-scap.org/page/SCE", sce_engine_eval_rule, (void*)parameters, NULL);
+	if (!xccdf_policy_model_register_engine_and_query_callback(model,
+		"http://open-scap.org/page/SCE", sce_engine_eval_rule, (void*)parameters, NULL))
+		return false;
+	// each script runs in its own process, the session results are guarded by a lock
+	xccdf_policy_model_set_engine_thread_safe(model, "http://open-scap.org/page/SCE", true);
+	return true;
 }
@@ -32,6 +32,7 @@
 #include "xccdf_impl.h"
 #include "common/_error.h"
 #include "common/debug_priv.h"
+#include "common/memtag_priv.h"
 #include "common/elements.h"
 #include "source/public/oscap_source.h"
 #include "source/oscap_source_priv.h"
@@ -51,12 +52,14 @@ struct xccdf_backref {
 	char *id;		// id
 };
 
-struct xccdf_benchmark *xccdf_benchmark_import_source(struct oscap_source *source)
+static struct xccdf_benchmark *_xccdf_benchmark_import_source(struct oscap_source *source, bool defer_texts)
 {
 	xmlTextReader *reader = oscap_source_get_xmlTextReader(source);
 
 	while (xmlTextReaderRead(reader) == 1 && xmlTextReaderNodeType(reader) != XML_READER_TYPE_ELEMENT) ;
 	struct xccdf_benchmark *benchmark = xccdf_benchmark_new();
+	if (defer_texts)
+		XITEM(benchmark)->sub.benchmark.texts_source = source;
 	const bool parse_result = xccdf_benchmark_parse(XITEM(benchmark), reader);
 	xmlFreeTextReader(reader);
 
@@ -85,6 +88,93 @@ struct xccdf_benchmark *xccdf_benchmark_import_source(struct oscap_source *sourc
 	return benchmark;
 }
 
+struct xccdf_benchmark *xccdf_benchmark_import_source(struct oscap_source *source)
+{
+	return _xccdf_benchmark_import_source(source, false);
+}
+
+struct xccdf_benchmark *xccdf_benchmark_import_source_deferred_texts(struct oscap_source *source)
+{
+	return _xccdf_benchmark_import_source(source, true);
+}
+
+int xccdf_benchmark_load_texts(struct xccdf_benchmark *benchmark)
+{
+	struct xccdf_item *bench = XITEM(benchmark);
+	struct oscap_source *source = bench->sub.benchmark.texts_source;
+	struct xccdf_item **owners = NULL;
+	int owners_size = 0;
+
+	if (source == NULL)
+		return 0;
+	/* the texts are read once, even if this fails */
+	bench->sub.benchmark.texts_source = NULL;
+
+	xmlTextReader *reader = oscap_source_get_xmlTextReader(source);
+	if (reader == NULL)
+		return -1;
+
+	/* owners[depth] is the item of the element last started at that depth */
+	int ret = xmlTextReaderRead(reader);
+	while (ret == 1) {
+		if (xmlTextReaderNodeType(reader) != XML_READER_TYPE_ELEMENT) {
+			ret = xmlTextReaderRead(reader);
+			continue;
+		}
+
+		int depth = xmlTextReaderDepth(reader);
+		if (depth >= owners_size) {
+			owners_size = depth + 16;
+			owners = realloc(owners, owners_size * sizeof(struct xccdf_item *));
+		}
+		struct xccdf_item *owner = depth > 0 ? owners[depth - 1] : NULL;
+		const char *id = xccdf_attribute_get(reader, XCCDFA_ID);
+
+		owners[depth] = NULL;
+		switch (xccdf_element_get(reader)) {
+		case XCCDFE_BENCHMARK:
+			owners[depth] = bench;
+			break;
+		case XCCDFE_PROFILE:
+			owners[depth] = id ? xccdf_benchmark_get_member(benchmark, XCCDF_PROFILE, id) : NULL;
+			break;
+		case XCCDFE_GROUP:
+			owners[depth] = id ? xccdf_benchmark_get_member(benchmark, XCCDF_GROUP, id) : NULL;
+			break;
+		case XCCDFE_RULE:
+			owners[depth] = id ? xccdf_benchmark_get_member(benchmark, XCCDF_RULE, id) : NULL;
+			break;
+		case XCCDFE_VALUE:
+			owners[depth] = id ? xccdf_benchmark_get_member(benchmark, XCCDF_VALUE, id) : NULL;
+			break;
+		case XCCDFE_DESCRIPTION:
+			if (owner != NULL)
+				oscap_list_add(owner->item.description, oscap_text_new_parse(XCCDF_TEXT_HTMLSUB, reader));
+			break;
+		case XCCDFE_WARNING:
+			if (owner != NULL)
+				oscap_list_add(owner->item.warnings, xccdf_warning_new_parse(reader));
+			break;
+		case XCCDFE_REFERENCE:
+			if (owner != NULL)
+				oscap_list_add(owner->item.references, oscap_reference_new_parse(reader));
+			break;
+		case XCCDFE_RATIONALE:
+			if (owner != NULL)
+				oscap_list_add(owner->item.rationale, oscap_text_new_parse(XCCDF_TEXT_HTMLSUB, reader));
+			break;
+		default:
+			break;
+		}
+		ret = xmlTextReaderRead(reader);
+	}
+	free(owners);
+	xmlFreeTextReader(reader);
+
+	dI("Loaded the descriptive texts of benchmark '%s'.", xccdf_benchmark_get_id(benchmark));
+	return ret == 0 ? 0 : -1;
+}
+
 struct xccdf_benchmark *xccdf_benchmark_new(void)
 {
 	struct xccdf_item *bench = xccdf_item_new(XCCDF_BENCHMARK, NULL);
@@ -101,6 +191,7 @@ struct xccdf_benchmark *xccdf_benchmark_new(void)
 	bench->sub.benchmark.cpe_lang_model = NULL;
 	bench->sub.benchmark.profiles = oscap_list_new();
 	bench->sub.benchmark.results = oscap_list_new();
+	bench->sub.benchmark.texts_source = NULL;
     // hash tables
 	bench->sub.benchmark.items_dict = oscap_htable_new();
 	bench->sub.benchmark.profiles_dict = oscap_htable_new();
@@ -117,7 +208,10 @@ struct xccdf_benchmark *xccdf_benchmark_new(void)
 
 struct xccdf_benchmark *xccdf_benchmark_clone(const struct xccdf_benchmark *old_benchmark)
 {
+	xccdf_benchmark_load_texts(XBENCHMARK(old_benchmark));
+
 	struct xccdf_item *new_benchmark = calloc(1, sizeof(struct xccdf_item) + sizeof(struct xccdf_benchmark_item));
+	oscap_memtag_alloc(OSCAP_MEMTAG_XCCDF, new_benchmark, sizeof(struct xccdf_item) + sizeof(struct xccdf_benchmark_item));
 	struct xccdf_item *old = XITEM(old_benchmark);
     xccdf_item_base_clone(&new_benchmark->item, &old->item);
 	new_benchmark->type = old->type;
@@ -143,6 +237,9 @@ bool xccdf_benchmark_parse(struct xccdf_item * benchmark, xmlTextReaderPtr reade
     benchmark->sub.benchmark.lang = (char *) xmlTextReaderXmlLang(reader);
 	if (xccdf_attribute_has(reader, XCCDFA_RESOLVED))
 		benchmark->item.flags.resolved = xccdf_attribute_get_bool(reader, XCCDFA_RESOLVED);
+	/* texts of the items which extend others are completed by the resolution */
+	if (!benchmark->item.flags.resolved)
+		benchmark->sub.benchmark.texts_source = NULL;
 
 	int depth = oscap_element_depth(reader) + 1;
 
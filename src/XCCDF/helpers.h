@@ -162,6 +162,29 @@
         XCCDF_TITERATOR_GETTER(value,MNAME,item.MNAME) \
         XCCDF_TITERATOR_GETTER(group,MNAME,item.MNAME) \
         XCCDF_TITERATOR_GETTER(result,MNAME,item.MNAME)
+/* getters of the descriptive texts, these may still have to be loaded */
+#define XCCDF_DEFERRED_TITERATOR_GETTER(TNAME,MNAME,MEMBER) \
+        struct oscap_text_iterator* xccdf_##TNAME##_get_##MNAME(const struct xccdf_##TNAME* item) \
+        { xccdf_item_load_texts(XITEM(item)); return oscap_iterator_new(XITEM(item)->MEMBER); }
+#define XCCDF_DEFERRED_ITERATOR_GETTER(ITYPE,TNAME,MNAME,MEMBER) \
+        struct xccdf_##ITYPE##_iterator* xccdf_##TNAME##_get_##MNAME(const struct xccdf_##TNAME* item) \
+        { xccdf_item_load_texts(XITEM(item)); return oscap_iterator_new(XITEM(item)->MEMBER); }
+#define XCCDF_ITEM_DEFERRED_TIGETTER(MNAME) \
+        XCCDF_DEFERRED_TITERATOR_GETTER(item,MNAME,item.MNAME) \
+        XCCDF_DEFERRED_TITERATOR_GETTER(benchmark,MNAME,item.MNAME) \
+        XCCDF_DEFERRED_TITERATOR_GETTER(profile,MNAME,item.MNAME) \
+        XCCDF_DEFERRED_TITERATOR_GETTER(rule,MNAME,item.MNAME) \
+        XCCDF_DEFERRED_TITERATOR_GETTER(value,MNAME,item.MNAME) \
+        XCCDF_DEFERRED_TITERATOR_GETTER(group,MNAME,item.MNAME) \
+        XCCDF_DEFERRED_TITERATOR_GETTER(result,MNAME,item.MNAME)
+#define XCCDF_ITEM_DEFERRED_IGETTER(RTYPE,MNAME) \
+        XCCDF_DEFERRED_ITERATOR_GETTER(RTYPE,item,MNAME,item.MNAME) \
+        XCCDF_DEFERRED_ITERATOR_GETTER(RTYPE,benchmark,MNAME,item.MNAME) \
+        XCCDF_DEFERRED_ITERATOR_GETTER(RTYPE,profile,MNAME,item.MNAME) \
+        XCCDF_DEFERRED_ITERATOR_GETTER(RTYPE,rule,MNAME,item.MNAME) \
+        XCCDF_DEFERRED_ITERATOR_GETTER(RTYPE,value,MNAME,item.MNAME) \
+        XCCDF_DEFERRED_ITERATOR_GETTER(RTYPE,group,MNAME,item.MNAME) \
+        XCCDF_DEFERRED_ITERATOR_GETTER(RTYPE,result,MNAME,item.MNAME)
 #define XCCDF_FLAG_SETTER(SNAME, FNAME) \
         bool xccdf_##SNAME##_set_##FNAME(struct xccdf_##SNAME *item, bool newval) \
         { assert(item != NULL); XITEM(item)->item.flags.FNAME = newval; return true; }
@@ -203,6 +226,14 @@
         XCCDF_ITEM_ADDER_ONE(group,MNAME,MNAMES,MTYPE,) XCCDF_ITEM_ADDER_ONE(rule,MNAME,MNAMES,MTYPE,) \
         XCCDF_ITEM_ADDER_ONE(value,MNAME,MNAMES,MTYPE,) XCCDF_ITEM_ADDER_ONE(result,MNAME,MNAMES,MTYPE,)
 
+#define XCCDF_ITEM_DEFERRED_ADDER_ONE(STYPE,MNAME,SINGNAME,MTYPE) \
+		bool xccdf_##STYPE##_add_##SINGNAME(struct xccdf_##STYPE* item, MTYPE newval) \
+		{ xccdf_item_load_texts(XITEM(item)); return oscap_list_add(XITEM(item)->item.MNAME, newval); }
+#define XCCDF_ITEM_DEFERRED_ADDER(MTYPE,MNAMES,MNAME) XCCDF_ITEM_DEFERRED_ADDER_ONE(item,MNAME,MNAMES,MTYPE) \
+        XCCDF_ITEM_DEFERRED_ADDER_ONE(benchmark,MNAME,MNAMES,MTYPE) XCCDF_ITEM_DEFERRED_ADDER_ONE(profile,MNAME,MNAMES,MTYPE) \
+        XCCDF_ITEM_DEFERRED_ADDER_ONE(group,MNAME,MNAMES,MTYPE) XCCDF_ITEM_DEFERRED_ADDER_ONE(rule,MNAME,MNAMES,MTYPE) \
+        XCCDF_ITEM_DEFERRED_ADDER_ONE(value,MNAME,MNAMES,MTYPE) XCCDF_ITEM_DEFERRED_ADDER_ONE(result,MNAME,MNAMES,MTYPE)
+
 #define XCCDF_ITEM_ADDER_REG(STYPE, MTYPE, MNAME) \
 	bool xccdf_##STYPE##_add_##MTYPE(struct xccdf_##STYPE *STYPE, struct xccdf_##MTYPE *item) \
 	{ return xccdf_add_item(XITEM(STYPE)->sub.STYPE.MNAME, XITEM(STYPE), XITEM(item), #MTYPE "-"); }
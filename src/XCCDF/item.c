@@ -41,6 +41,7 @@
 #include "helpers.h"
 #include "xccdf_impl.h"
 #include "common/util.h"
+#include "common/memtag_priv.h"
 #include "oscap_helpers.h"
 
 /* According to `man 3 pcreapi`, the number passed in ovecsize should always
@@ -125,6 +126,7 @@ struct xccdf_item *xccdf_item_new(xccdf_type_t type, struct xccdf_item *parent)
 	}
 
 	item = calloc(1, size);
+	oscap_memtag_alloc(OSCAP_MEMTAG_XCCDF, item, size);
 	item->type = type;
 	item->item.title = oscap_list_new();
 	item->item.description = oscap_list_new();
@@ -145,7 +147,10 @@ struct xccdf_item *xccdf_item_new(xccdf_type_t type, struct xccdf_item *parent)
 
 struct xccdf_item *xccdf_item_clone(const struct xccdf_item *old_item)
 {
+	xccdf_item_load_texts(XITEM(old_item));
+
 	struct xccdf_item *new_item = calloc(1, sizeof(struct xccdf_item));
+	oscap_memtag_alloc(OSCAP_MEMTAG_XCCDF, new_item, sizeof(struct xccdf_item));
 
     xccdf_item_base_clone(&new_item->item, &(old_item->item));
 	new_item->type = old_item->type;
@@ -250,6 +255,7 @@ void xccdf_item_release(struct xccdf_item *item)
 		free(item->item.extends);
 		oscap_stringlist_free((struct oscap_stringlist*)(item->item.metadata));
 
+		oscap_memtag_free(OSCAP_MEMTAG_XCCDF, item, sizeof(struct xccdf_item));
 		free(item);
 	}
 }
@@ -302,6 +308,7 @@ void xccdf_item_dump(struct xccdf_item *item, int depth)
 void xccdf_item_print(struct xccdf_item *item, int depth)
 {
 	if (item) {
+		xccdf_item_load_texts(item);
 		if (item->item.parent) {
 			xccdf_print_depth(depth);
 			printf("parent  : %s\n", item->item.parent->item.id);
@@ -797,10 +804,37 @@ void xccdf_item_add_applicable_platform(struct xccdf_item *item, xmlTextReaderPt
 	oscap_list_add(item->item.platforms, platform_idref);
 }
 
+/* the benchmark being parsed leaves the descriptive texts in its source */
+static bool xccdf_item_defers_texts(struct xccdf_item *item)
+{
+	struct xccdf_item *bench = xccdf_item_get_benchmark_internal(item);
+	return bench != NULL && bench->sub.benchmark.texts_source != NULL;
+}
+
+void xccdf_item_load_texts(struct xccdf_item *item)
+{
+	struct xccdf_item *bench = xccdf_item_get_benchmark_internal(item);
+	if (bench != NULL && bench->sub.benchmark.texts_source != NULL)
+		xccdf_benchmark_load_texts(XBENCHMARK(bench));
+}
+
 bool xccdf_item_process_element(struct xccdf_item * item, xmlTextReaderPtr reader)
 {
 	xccdf_element_t el = xccdf_element_get(reader);
 
+	switch (el) {
+	case XCCDFE_DESCRIPTION:
+	case XCCDFE_WARNING:
+	case XCCDFE_REFERENCE:
+	case XCCDFE_RATIONALE:
+		/* skipped now, xccdf_item_load_texts() reads them on demand */
+		if (xccdf_item_defers_texts(item))
+			return true;
+		break;
+	default:
+		break;
+	}
+
 	switch (el) {
 	case XCCDFE_TITLE:
         oscap_list_add(item->item.title, oscap_text_new_parse(XCCDF_TEXT_PLAINSUB, reader));
@@ -816,9 +850,11 @@ bool xccdf_item_process_element(struct xccdf_item * item, xmlTextReaderPtr reade
 		return true;
 	case XCCDFE_STATUS:{
         const char *date = xccdf_attribute_get(reader, XCCDFA_DATE);
-        char *str = oscap_element_string_copy(reader);
-        struct xccdf_status *status = xccdf_status_new_fill(str, date);
-        free(str);
+        struct oscap_strbuf str;
+        oscap_strbuf_init(&str);
+        struct xccdf_status *status = oscap_element_string_append(reader, &str) ?
+                xccdf_status_new_fill(oscap_strbuf_get(&str), date) : NULL;
+        oscap_strbuf_release(&str);
         if (status) {
             oscap_list_add(item->item.statuses, status);
             return true;
@@ -914,13 +950,13 @@ XCCDF_ABSTRACT_GETTER(xccdf_type_t, item, type, type)
 XCCDF_ITEM_GETTER(const char *, id)
 
 XCCDF_ITEM_TIGETTER(question);
-XCCDF_ITEM_TIGETTER(rationale);
+XCCDF_ITEM_DEFERRED_TIGETTER(rationale);
 XCCDF_ITEM_TIGETTER(title);
-XCCDF_ITEM_TIGETTER(description);
+XCCDF_ITEM_DEFERRED_TIGETTER(description);
 XCCDF_ITEM_ADDER(struct oscap_text *, question, question)
 XCCDF_ITEM_ADDER(struct oscap_text *, title, title)
-XCCDF_ITEM_ADDER(struct oscap_text *, description, description)
-XCCDF_ITEM_ADDER(struct oscap_text *, rationale, rationale)
+XCCDF_ITEM_DEFERRED_ADDER(struct oscap_text *, description, description)
+XCCDF_ITEM_DEFERRED_ADDER(struct oscap_text *, rationale, rationale)
 
 XCCDF_ITEM_GETTER(const char *, version)
 XCCDF_ITEM_GETTER(const char *, cluster_id)
@@ -946,10 +982,10 @@ XCCDF_FLAG_GETTER(abstract)
 XCCDF_FLAG_GETTER(interactive)
 XCCDF_ITEM_SIGETTER(platforms)
 XCCDF_ITEM_ADDER_STRING(platform, platforms)
-XCCDF_ITEM_IGETTER(warning, warnings)
+XCCDF_ITEM_DEFERRED_IGETTER(warning, warnings)
 XCCDF_ITEM_IGETTER(status, statuses)
-XCCDF_ITEM_ADDER(struct oscap_reference *, reference, references)
-XCCDF_ITEM_ADDER(struct xccdf_warning *, warning, warnings)
+XCCDF_ITEM_DEFERRED_ADDER(struct oscap_reference *, reference, references)
+XCCDF_ITEM_DEFERRED_ADDER(struct xccdf_warning *, warning, warnings)
 XCCDF_ITEM_ADDER(struct xccdf_status *, status, statuses)
 XCCDF_ITEM_ADDER(struct oscap_reference *, dc_status, dc_statuses)
 XCCDF_ITERATOR_GEN_S(item) XCCDF_ITERATOR_GEN_S(status)
@@ -969,17 +1005,17 @@ XCCDF_SETTER_ID(item) XCCDF_SETTER_ID(benchmark) XCCDF_SETTER_ID(profile)
 XCCDF_SETTER_ID(rule) XCCDF_SETTER_ID(group) XCCDF_SETTER_ID(value) XCCDF_SETTER_ID(result)
 #undef XCCDF_SETTER_ID
 
-struct oscap_reference_iterator *xccdf_item_get_references(const struct xccdf_item *item) { return oscap_iterator_new(item->item.references); }
+struct oscap_reference_iterator *xccdf_item_get_references(const struct xccdf_item *item) { xccdf_item_load_texts(XITEM(item)); return oscap_iterator_new(item->item.references); }
 struct oscap_reference_iterator *xccdf_item_get_dc_statuses(const struct xccdf_item *item) { return oscap_iterator_new(item->item.dc_statuses); }
-struct oscap_reference_iterator *xccdf_benchmark_get_references(const struct xccdf_benchmark *item) { return oscap_iterator_new(XITEM(item)->item.references); }
+struct oscap_reference_iterator *xccdf_benchmark_get_references(const struct xccdf_benchmark *item) { xccdf_item_load_texts(XITEM(item)); return oscap_iterator_new(XITEM(item)->item.references); }
 struct oscap_reference_iterator *xccdf_benchmark_get_dc_statuses(const struct xccdf_benchmark *item) { return oscap_iterator_new(XITEM(item)->item.dc_statuses); }
-struct oscap_reference_iterator *xccdf_value_get_references(const struct xccdf_value *item) { return oscap_iterator_new(XITEM(item)->item.references); }
+struct oscap_reference_iterator *xccdf_value_get_references(const struct xccdf_value *item) { xccdf_item_load_texts(XITEM(item)); return oscap_iterator_new(XITEM(item)->item.references); }
 struct oscap_reference_iterator *xccdf_value_get_dc_statuses(const struct xccdf_value *item) { return oscap_iterator_new(XITEM(item)->item.dc_statuses); }
-struct oscap_reference_iterator *xccdf_group_get_references(const struct xccdf_group *item) { return oscap_iterator_new(XITEM(item)->item.references); }
+struct oscap_reference_iterator *xccdf_group_get_references(const struct xccdf_group *item) { xccdf_item_load_texts(XITEM(item)); return oscap_iterator_new(XITEM(item)->item.references); }
 struct oscap_reference_iterator *xccdf_group_get_dc_statuses(const struct xccdf_group *item) { return oscap_iterator_new(XITEM(item)->item.dc_statuses); }
-struct oscap_reference_iterator *xccdf_rule_get_references(const struct xccdf_rule *item) { return oscap_iterator_new(XITEM(item)->item.references); }
+struct oscap_reference_iterator *xccdf_rule_get_references(const struct xccdf_rule *item) { xccdf_item_load_texts(XITEM(item)); return oscap_iterator_new(XITEM(item)->item.references); }
 struct oscap_reference_iterator *xccdf_rule_get_dc_statuses(const struct xccdf_rule *item) { return oscap_iterator_new(XITEM(item)->item.dc_statuses); }
-struct oscap_reference_iterator *xccdf_profile_get_references(const struct xccdf_profile *item) { return oscap_iterator_new(XITEM(item)->item.references); }
+struct oscap_reference_iterator *xccdf_profile_get_references(const struct xccdf_profile *item) { xccdf_item_load_texts(XITEM(item)); return oscap_iterator_new(XITEM(item)->item.references); }
 struct oscap_reference_iterator *xccdf_profile_get_dc_statuses(const struct xccdf_profile *item) { return oscap_iterator_new(XITEM(item)->item.dc_statuses); }
 
 struct xccdf_item_iterator *xccdf_item_get_content(const struct xccdf_item *item)
@@ -1284,6 +1320,7 @@ struct xccdf_instance * xccdf_instance_clone(const struct xccdf_instance * insta
 struct xccdf_rule_result * xccdf_rule_result_clone(const struct xccdf_rule_result * result)
 {
 	struct xccdf_rule_result * clone = calloc(1, sizeof(struct xccdf_rule_result));
+	oscap_memtag_alloc(OSCAP_MEMTAG_XCCDF, clone, sizeof(struct xccdf_rule_result));
 	clone->idref = oscap_strdup(result->idref);
 	clone->role = result->role;
 	clone->time = oscap_strdup(result->time);
@@ -1332,13 +1369,9 @@ void xccdf_result_item_clone(struct xccdf_result_item *clone, const struct xccdf
 
 void xccdf_reparent_list(struct oscap_list * item_list, struct xccdf_item * parent)
 {
-	struct oscap_iterator *it = oscap_iterator_new(item_list);
-	while(oscap_iterator_has_more(it))
-	{
-		struct xccdf_item * item = oscap_iterator_next(it);
+	struct xccdf_item *item;
+	OSCAP_LIST_FOREACH(item, item_list)
 		xccdf_reparent_item(item, parent);
-	}
-    oscap_iterator_free(it);
 }
 
 void xccdf_reparent_item(struct xccdf_item * item, struct xccdf_item * parent)
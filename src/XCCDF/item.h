@@ -215,6 +215,8 @@ struct xccdf_benchmark_item {
 	struct oscap_list *values;
 	struct oscap_list *content;
 	struct oscap_list *results;
+
+	struct oscap_source *texts_source;		/* descriptive texts not loaded yet are read from here (not owned) */
 };
 
 struct xccdf_item {
@@ -436,6 +438,15 @@ void xccdf_item_print(struct xccdf_item *item, int depth);
 void xccdf_item_dump(struct xccdf_item *item, int depth);
 struct xccdf_item* xccdf_item_get_benchmark_internal(struct xccdf_item* item);
 bool xccdf_benchmark_parse(struct xccdf_item *benchmark, xmlTextReaderPtr reader);
+/**
+ * Import a benchmark without the descriptions, rationales, warnings and
+ * references of its items. These are read from the source when any of
+ * them is accessed for the first time, the source has to outlive the
+ * benchmark. Benchmarks which are not resolved are imported fully.
+ */
+struct xccdf_benchmark *xccdf_benchmark_import_source_deferred_texts(struct oscap_source *source);
+int xccdf_benchmark_load_texts(struct xccdf_benchmark *benchmark);
+void xccdf_item_load_texts(struct xccdf_item *item);
 void xccdf_benchmark_dump(struct xccdf_benchmark *benchmark);
 int xccdf_benchmark_include_tailored_profiles(struct xccdf_benchmark *benchmark);
 struct oscap_htable_iterator *xccdf_benchmark_get_cluster_items(struct xccdf_benchmark *benchmark, const char *cluster_id);
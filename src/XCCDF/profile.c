@@ -207,6 +207,7 @@ struct xccdf_profile *xccdf_profile_clone (const struct xccdf_profile *old_profi
 {
 	struct xccdf_item *new_profile = calloc(1, sizeof(struct xccdf_item) + sizeof(struct xccdf_profile_item));
 	struct xccdf_item *old = XITEM(old_profile);
+	xccdf_item_load_texts(old);
     xccdf_item_base_clone(&new_profile->item, &(old->item));
 	new_profile->type = old->type;
     xccdf_profile_item_clone(&new_profile->sub.profile, &old->sub.profile);
@@ -53,7 +53,13 @@ typedef enum {
 	XCCDF_SESSION_LOAD_CPE = 1 << 1,
 	XCCDF_SESSION_LOAD_OVAL = 1 << 2,
 	XCCDF_SESSION_LOAD_CHECK_ENGINE_PLUGINS = 1 << 3,
-	XCCDF_SESSION_LOAD_ALL = XCCDF_SESSION_LOAD_XCCDF | XCCDF_SESSION_LOAD_CPE | XCCDF_SESSION_LOAD_OVAL | XCCDF_SESSION_LOAD_CHECK_ENGINE_PLUGINS
+	XCCDF_SESSION_LOAD_ALL = XCCDF_SESSION_LOAD_XCCDF | XCCDF_SESSION_LOAD_CPE | XCCDF_SESSION_LOAD_OVAL | XCCDF_SESSION_LOAD_CHECK_ENGINE_PLUGINS,
+	/**
+	 * Read descriptions, rationales, warnings and references of the XCCDF
+	 * items only when they are accessed, e.g. by an export. Not part of
+	 * XCCDF_SESSION_LOAD_ALL.
+	 */
+	XCCDF_SESSION_LOAD_TEXTS_ON_DEMAND = 1 << 4
 } xccdf_session_loading_flags_t;
 
 /**
@@ -159,6 +165,30 @@ OSCAP_API void xccdf_session_set_signature_enforcement(struct xccdf_session *ses
  */
 OSCAP_API void xccdf_session_set_thin_results(struct xccdf_session *session, bool thin_result);
 
+/**
+ * Set whether only the OVAL definitions used by the selected rules shall be
+ * loaded. The OVAL files are only indexed by @ref xccdf_session_load_oval and
+ * the definitions referenced by the selected rules are built right before the
+ * evaluation. OVAL results then contain only these definitions.
+ * @memberof xccdf_session
+ * @param session XCCDF Session
+ * @param lazy_loading true to load the OVAL definitions on demand, default is false
+ */
+OSCAP_API void xccdf_session_set_oval_lazy_loading(struct xccdf_session *session, bool lazy_loading);
+
+/**
+ * Set whether the probes may skip the item entities which no OVAL state,
+ * filter or variable uses, e.g. the extended ACL of files when only the
+ * permissions are checked, and stop collecting an object once the items
+ * found decide its tests without a state. The collected items are
+ * incomplete then, so this must only be enabled when the system
+ * characteristics are not exported.
+ * @memberof xccdf_session
+ * @param session XCCDF Session
+ * @param referenced_only true to collect only the used entities, default is false
+ */
+OSCAP_API void xccdf_session_set_referenced_entities_only(struct xccdf_session *session, bool referenced_only);
+
 /**
  * Set requested datastream_id for this session. This datastream_id is later
  * passed down to @ref ds_sds_index_select_checklist to determine target component.
@@ -360,6 +390,33 @@ OSCAP_API bool xccdf_session_set_xccdf_stig_viewer_export(struct xccdf_session *
  */
 OSCAP_API bool xccdf_session_set_arf_export(struct xccdf_session *session, const char *arf_file);
 
+/**
+ * Set whether the exported ARF shall reference the source data stream by its
+ * SHA-256 digest instead of embedding it. The report-request of the ARF then
+ * holds only the paths and digests of the source data stream and the tailoring
+ * file, use @ref ds_rds_inflate to get the complete ARF. The HTML report is
+ * not affected. Default is false.
+ * @memberof xccdf_session
+ * @param session XCCDF Session
+ * @param sds_reference whether to reference the source data stream
+ */
+OSCAP_API void xccdf_session_set_arf_sds_reference(struct xccdf_session *session, bool sds_reference);
+
+/**
+ * Set where to export the results as JSON lines, a compact alternative to ARF
+ * for machine consumers. Each line is one JSON object: the TestResult, each
+ * selected rule result with its check references, each evaluated OVAL
+ * definition and test, and each tested item. Tests refer to the items by ID
+ * and every item is written only once. Items are left out when system
+ * characteristics are not exported. NULL value means to not export at all,
+ * "-" means standard output.
+ * @memberof xccdf_session
+ * @param session XCCDF Session
+ * @param jsonl_file path to JSON lines file
+ * @returns true on success
+ */
+OSCAP_API bool xccdf_session_set_results_jsonl_export(struct xccdf_session *session, const char *jsonl_file);
+
 /**
  * Set where to export HTML Report file. NULL value means to not export at all.
  * @memberof xccdf_session
@@ -388,6 +445,27 @@ OSCAP_API bool xccdf_session_set_profile_id(struct xccdf_session *session, const
  */
 OSCAP_API int xccdf_session_set_profile_id_by_suffix(struct xccdf_session *session, const char *profile_suffix);
 
+/**
+ * Add an XCCDF Profile to be evaluated along with the selected one. Each of the
+ * profiles gets its own TestResult while the collected system characteristics
+ * are shared by all of them, so the system is probed only once.
+ * @memberof xccdf_session
+ * @param session XCCDF Session
+ * @param profile_id ID of profile to add
+ * @returns true on success
+ */
+OSCAP_API bool xccdf_session_add_profile_id(struct xccdf_session *session, const char *profile_id);
+
+/**
+ * Add an XCCDF Profile to be evaluated along with the selected one with only
+ * profile suffix as input. Reports error if multiple profiles match the suffix.
+ * @memberof xccdf_session
+ * @param session XCCDF Session
+ * @param profile_suffix unique profile ID or suffix of the ID of the profile to add
+ * @returns 0 on success, 1 if profile is not found, and 2 if multiple matches are found.
+ */
+OSCAP_API int xccdf_session_add_profile_id_by_suffix(struct xccdf_session *session, const char *profile_suffix);
+
 /**
  * Retrieves ID of the profile that we will evaluate with, or NULL.
  * @memberof xccdf_session
@@ -523,6 +601,15 @@ OSCAP_API int xccdf_session_export_check_engine_plugins(struct xccdf_session *se
  */
 OSCAP_API int xccdf_session_export_arf(struct xccdf_session *session);
 
+/**
+ * Export results as JSON lines (if enabled by @ref xccdf_session_set_results_jsonl_export).
+ * This is done by @ref xccdf_session_export_all as well.
+ * @memberof xccdf_session
+ * @param session XCCDF Session
+ * @returns zero on success
+ */
+OSCAP_API int xccdf_session_export_results_jsonl(struct xccdf_session *session);
+
 /**
  * Get policy_model of the session. The @ref xccdf_session_load_xccdf shall be run
  * before this to parse XCCDF file to the policy_model.
@@ -614,7 +701,18 @@ OSCAP_API int xccdf_session_add_report_from_source(struct xccdf_session *session
 OSCAP_API int xccdf_session_generate_guide(struct xccdf_session *session, const char *outfile);
 
 /**
- * Export XCCDF results, ARF results and HTML report from the given XCCDF
+ * Drop the results of the last evaluation, so that the session can evaluate
+ * the system again. The loaded content and the running OVAL probes are kept,
+ * the collected system characteristics are dropped. The export settings
+ * are not changed.
+ * @memberof xccdf_session
+ * @param session XCCDF Session
+ * @returns zero on success
+ */
+OSCAP_API int xccdf_session_reset_results(struct xccdf_session *session);
+
+/**
+ * Export XCCDF results, ARF results, JSON lines results and HTML report from the given XCCDF
  * session based on values set in the XCCDF session. This is a destructive
  * operation that modifies the oscap_source structures, specifically the XML
  * trees. Callers must not perform any operation with the session after this
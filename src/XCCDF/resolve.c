@@ -32,6 +32,8 @@
 #include "oscap_helpers.h"
 
 typedef void (*xccdf_textresolve_func)(void *child, void *parent);
+// returns the string identifying a list member, NULL is the same as ""
+typedef const char *(*xccdf_resolve_key_func)(void *member);
 
 static void xccdf_resolve_item(struct xccdf_item *item, struct xccdf_tailoring *tailoring);
 static void xccdf_resolve_cleanup(struct xccdf_item *item);
@@ -89,7 +91,7 @@ bool xccdf_benchmark_resolve(struct xccdf_benchmark *benchmark)
 
 // prototypes
 static void xccdf_resolve_textlist(struct oscap_list *child_list, struct oscap_list *parent_list, xccdf_textresolve_func more);
-static void xccdf_resolve_appendlist(struct oscap_list **child_list, struct oscap_list *parent_list, oscap_cmp_func item_compare, oscap_clone_func cloner, bool prepend);
+static void xccdf_resolve_appendlist(struct oscap_list **child_list, struct oscap_list *parent_list, xccdf_resolve_key_func key, oscap_clone_func cloner, bool prepend);
 static void xccdf_resolve_value_instance(struct xccdf_value_instance *child, struct xccdf_value_instance *parent);
 static void xccdf_resolve_profile(struct xccdf_item *child, struct xccdf_item *parent);
 static void xccdf_resolve_group(struct xccdf_item *child, struct xccdf_item *parent);
@@ -173,6 +175,8 @@ static void xccdf_resolve_item(struct xccdf_item *item, struct xccdf_tailoring *
 	}
 
 	// resolve textual elements
+	xccdf_item_load_texts(item);
+	xccdf_item_load_texts(parent);
 	xccdf_resolve_textlist(item->item.title,       parent->item.title,       NULL);
 	xccdf_resolve_textlist(item->item.description, parent->item.description, NULL);
 	xccdf_resolve_textlist(item->item.question,    parent->item.question,    NULL);
@@ -200,10 +204,11 @@ static void xccdf_resolve_item(struct xccdf_item *item, struct xccdf_tailoring *
 // resolve textlists
 static void xccdf_resolve_textlist(struct oscap_list *child_list, struct oscap_list *parent_list, xccdf_textresolve_func more)
 {
-	OSCAP_FOR(oscap_text, child, oscap_iterator_new(child_list)) {
+	struct oscap_text *child, *parent;
+	OSCAP_LIST_FOREACH(child, child_list) {
 		if (oscap_text_get_overrides(child)) continue;
 
-		OSCAP_FOR(oscap_text, parent, oscap_iterator_new(parent_list)) {
+		OSCAP_LIST_FOREACH(parent, parent_list) {
 			if (oscap_streq(oscap_text_get_lang(child), oscap_text_get_lang(parent))) {
 				char *text = oscap_sprintf("%s%s", oscap_text_get_text(parent), oscap_text_get_text(child));
 				oscap_text_set_text(child, text);
@@ -212,40 +217,55 @@ static void xccdf_resolve_textlist(struct oscap_list *child_list, struct oscap_l
 				break;
 			}
 		}
-		oscap_text_iterator_free(parent_iter);
 	}
 }
 
+/*
+ * Add clones of the parent members the child doesn't have. The keys of the
+ * child are hashed first, a profile extending a profile compares thousands
+ * of selects. Members without a key function are always added.
+ */
 static void xccdf_resolve_appendlist(struct oscap_list **child_list, struct oscap_list *parent_list,
-                                                   oscap_cmp_func item_compare, oscap_clone_func cloner, bool prepend)
+                                                   xccdf_resolve_key_func key, oscap_clone_func cloner, bool prepend)
 {
-	struct oscap_iterator *parent_iter = oscap_iterator_new(parent_list);
 	struct oscap_list *to_add = oscap_list_new();
-	while (oscap_iterator_has_more(parent_iter)) {
-		void *parent = oscap_iterator_next(parent_iter);
-		struct oscap_iterator *child_iter = oscap_iterator_new(*child_list);
-		bool found = false;
-		while (oscap_iterator_has_more(child_iter))
-			if (item_compare(parent, oscap_iterator_next(child_iter)))
-				found = true;
-		if (!found) oscap_list_add(to_add, cloner(parent));
-		oscap_iterator_free(child_iter);
+	struct oscap_htable *child_keys = NULL;
+	void *parent, *child;
+
+	if (key != NULL && oscap_list_get_itemcount(parent_list) > 0) {
+		child_keys = oscap_htable_new();
+		OSCAP_LIST_FOREACH(child, *child_list) {
+			const char *child_key = key(child);
+			oscap_htable_add(child_keys, child_key != NULL ? child_key : "", child);
+		}
 	}
-	oscap_iterator_free(parent_iter);
+
+	OSCAP_LIST_FOREACH(parent, parent_list) {
+		if (key != NULL) {
+			const char *parent_key = key(parent);
+			if (oscap_htable_get(child_keys, parent_key != NULL ? parent_key : "") != NULL)
+				continue;
+		}
+		oscap_list_add(to_add, cloner(parent));
+	}
+	oscap_htable_free0(child_keys);
 	*child_list = (prepend ? oscap_list_destructive_join(*child_list, to_add) : oscap_list_destructive_join(to_add, *child_list));
 }
 
-static bool xccdf_select_idcmp(void *s1, void *s2) {
-	return oscap_streq(((struct xccdf_select*)s1)->item, ((struct xccdf_select*)s2)->item);
+static const char *xccdf_select_key(void *s) {
+	return ((struct xccdf_select*)s)->item;
+}
+static const char *xccdf_setvalue_key(void *s) {
+	return ((struct xccdf_setvalue*)s)->item;
 }
-static bool xccdf_setvalue_idcmp(void *s1, void *s2) {
-	return oscap_streq(((struct xccdf_setvalue*)s1)->item, ((struct xccdf_setvalue*)s2)->item);
+static const char *xccdf_refine_rule_key(void *s) {
+	return ((struct xccdf_refine_rule*)s)->item;
 }
-static bool xccdf_refine_rule_idcmp(void *s1, void *s2) {
-	return oscap_streq(((struct xccdf_refine_rule*)s1)->item, ((struct xccdf_refine_rule*)s2)->item);
+static const char *xccdf_refine_value_key(void *s) {
+	return ((struct xccdf_refine_value*)s)->item;
 }
-static bool xccdf_refine_value_idcmp(void *s1, void *s2) {
-	return oscap_streq(((struct xccdf_refine_value*)s1)->item, ((struct xccdf_refine_value*)s2)->item);
+static const char *xccdf_string_key(void *s) {
+	return s;
 }
 
 static void xccdf_resolve_profile(struct xccdf_item *child, struct xccdf_item *parent)
@@ -256,10 +276,10 @@ static void xccdf_resolve_profile(struct xccdf_item *child, struct xccdf_item *p
 		free(note_tag);
 	}
 
-	xccdf_resolve_appendlist(&child->sub.profile.selects,       parent->sub.profile.selects,       xccdf_select_idcmp,       (oscap_clone_func)xccdf_select_clone, false);
-	xccdf_resolve_appendlist(&child->sub.profile.setvalues,     parent->sub.profile.setvalues,     xccdf_setvalue_idcmp,     (oscap_clone_func)xccdf_setvalue_clone, false);
-	xccdf_resolve_appendlist(&child->sub.profile.refine_rules,  parent->sub.profile.refine_rules,  xccdf_refine_rule_idcmp,  (oscap_clone_func)xccdf_refine_rule_clone, false);
-	xccdf_resolve_appendlist(&child->sub.profile.refine_values, parent->sub.profile.refine_values, xccdf_refine_value_idcmp, (oscap_clone_func)xccdf_refine_value_clone, false);
+	xccdf_resolve_appendlist(&child->sub.profile.selects,       parent->sub.profile.selects,       xccdf_select_key,       (oscap_clone_func)xccdf_select_clone, false);
+	xccdf_resolve_appendlist(&child->sub.profile.setvalues,     parent->sub.profile.setvalues,     xccdf_setvalue_key,     (oscap_clone_func)xccdf_setvalue_clone, false);
+	xccdf_resolve_appendlist(&child->sub.profile.refine_rules,  parent->sub.profile.refine_rules,  xccdf_refine_rule_key,  (oscap_clone_func)xccdf_refine_rule_clone, false);
+	xccdf_resolve_appendlist(&child->sub.profile.refine_values, parent->sub.profile.refine_values, xccdf_refine_value_key, (oscap_clone_func)xccdf_refine_value_clone, false);
 }
 
 static struct xccdf_item *xccdf_resolve_copy_item(struct xccdf_item *src)
@@ -279,14 +299,13 @@ static struct xccdf_item *xccdf_resolve_copy_item(struct xccdf_item *src)
 	return clone;
 }
 
-static bool xccdf_incomparable(void *i1, void *i2) { return false; }
 //static void *xccdf_strlist_clone(void *l) { return oscap_list_clone(l, (oscap_clone_func)oscap_strdup); }
 
 static void xccdf_resolve_group(struct xccdf_item *child, struct xccdf_item *parent)
 {
 	// TODO: resolve requires properly (how?)
-	//xccdf_resolve_appendlist(&child->sub.group.requires, parent->sub.group.requires, xccdf_incomparable, xccdf_strlist_clone, false);
-	xccdf_resolve_appendlist(&child->sub.group.conflicts, parent->sub.group.conflicts, (oscap_cmp_func)oscap_streq, (oscap_clone_func)oscap_strdup, false);
+	//xccdf_resolve_appendlist(&child->sub.group.requires, parent->sub.group.requires, NULL, xccdf_strlist_clone, false);
+	xccdf_resolve_appendlist(&child->sub.group.conflicts, parent->sub.group.conflicts, xccdf_string_key, (oscap_clone_func)oscap_strdup, false);
 	
 	OSCAP_FOR(xccdf_item, item, xccdf_group_get_content(XGROUP(parent)))
 		xccdf_group_add_content(XGROUP(child), xccdf_resolve_copy_item(item));
@@ -294,8 +313,8 @@ static void xccdf_resolve_group(struct xccdf_item *child, struct xccdf_item *par
 		xccdf_group_add_value(XGROUP(child), xccdf_item_to_value(xccdf_resolve_copy_item(XITEM(val))));
 }
 
-static bool xccdf_ident_idcmp(void *s1, void *s2) {
-	return oscap_streq(((struct xccdf_ident*)s1)->id, ((struct xccdf_ident*)s2)->id);
+static const char *xccdf_ident_key(void *s) {
+	return ((struct xccdf_ident*)s)->id;
 }
 static void xccdf_resolve_profile_note(void *p1, void *p2) {
 	if (xccdf_profile_note_get_reftag(p1) == NULL)
@@ -313,10 +332,10 @@ static void xccdf_resolve_fixtext(struct xccdf_fixtext *t1, struct xccdf_fixtext
 static void xccdf_resolve_rule(struct xccdf_item *child, struct xccdf_item *parent)
 {
 	// TODO: resolve requires properly (how?)
-	//xccdf_resolve_appendlist(&child->sub.rule.requires, parent->sub.rule.requires, xccdf_incomparable, xccdf_strlist_clone);
-	xccdf_resolve_appendlist(&child->sub.rule.conflicts, parent->sub.rule.conflicts, (oscap_cmp_func)oscap_streq, (oscap_clone_func)oscap_strdup, false);
-	xccdf_resolve_appendlist(&child->sub.rule.idents, parent->sub.rule.idents, (oscap_cmp_func)xccdf_ident_idcmp, (oscap_clone_func)xccdf_ident_clone, false);
-	xccdf_resolve_appendlist(&child->sub.rule.fixes, parent->sub.rule.fixes, (oscap_cmp_func)xccdf_incomparable, (oscap_clone_func)xccdf_fix_clone, false);
+	//xccdf_resolve_appendlist(&child->sub.rule.requires, parent->sub.rule.requires, NULL, xccdf_strlist_clone);
+	xccdf_resolve_appendlist(&child->sub.rule.conflicts, parent->sub.rule.conflicts, xccdf_string_key, (oscap_clone_func)oscap_strdup, false);
+	xccdf_resolve_appendlist(&child->sub.rule.idents, parent->sub.rule.idents, xccdf_ident_key, (oscap_clone_func)xccdf_ident_clone, false);
+	xccdf_resolve_appendlist(&child->sub.rule.fixes, parent->sub.rule.fixes, NULL, (oscap_clone_func)xccdf_fix_clone, false);
 
 	if (oscap_list_get_itemcount(child->sub.rule.checks) == 0 && oscap_list_get_itemcount(parent->sub.rule.checks) > 0) {
 		oscap_list_free(child->sub.rule.checks, NULL);
@@ -76,6 +76,7 @@
 #include "common/_error.h"
 #include "oscap_text.h"
 #include "common/debug_priv.h"
+#include "common/memtag_priv.h"
 #include "source/oscap_source_priv.h"
 #include "oscap_helpers.h"
 
@@ -597,6 +598,7 @@ void xccdf_result_fill_sysinfo(struct xccdf_result *result)
 struct xccdf_rule_result *xccdf_rule_result_new(void)
 {
 	struct xccdf_rule_result *rr = calloc(1, sizeof(struct xccdf_rule_result));
+	oscap_memtag_alloc(OSCAP_MEMTAG_XCCDF, rr, sizeof(struct xccdf_rule_result));
 	oscap_create_lists(&rr->overrides, &rr->idents, &rr->messages,
 		&rr->instances, &rr->fixes, &rr->checks, NULL);
 	return rr;
@@ -616,6 +618,7 @@ void xccdf_rule_result_free(struct xccdf_rule_result *rr)
 		oscap_list_free(rr->fixes, (oscap_destruct_func) xccdf_fix_free);
 		oscap_list_free(rr->checks, (oscap_destruct_func) xccdf_check_free);
 
+		oscap_memtag_free(OSCAP_MEMTAG_XCCDF, rr, sizeof(struct xccdf_rule_result));
 		free(rr);
 	}
 }
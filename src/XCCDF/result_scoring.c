@@ -54,61 +54,81 @@ struct xccdf_flat_score {
 
 };
 
-static struct xccdf_default_score * xccdf_item_get_default_score(struct xccdf_item * item, struct xccdf_result * test_result)
+/**
+ * Scores of an item in all the supported XCCDF Score models
+ */
+struct xccdf_score_totals {
+	struct xccdf_default_score def;
+	struct xccdf_flat_score flat;
+	struct xccdf_flat_score flat_unweighted;
+};
+
+static bool _rule_result_is_scored(struct xccdf_rule_result *rule_result)
 {
-	// Implements algorithm as described in NISTIR-7275-r4
+	if (xccdf_rule_result_get_role(rule_result) == XCCDF_ROLE_UNSCORED)
+		return false;
+
+	/* Ignore these rules */
+	switch (xccdf_rule_result_get_result(rule_result)) {
+	case XCCDF_RESULT_NOT_SELECTED:
+	case XCCDF_RESULT_NOT_APPLICABLE:
+	case XCCDF_RESULT_INFORMATIONAL:
+	case XCCDF_RESULT_NOT_CHECKED:
+		return false;
+	default:
+		return true;
+	}
+}
+
+/*
+ * Compute the scores of the item in all the models in a single traversal.
+ * Returns false for the items which can't be processed, these are skipped
+ * by their parents in every model.
+ */
+static bool xccdf_item_get_score_totals(struct xccdf_item *item, struct oscap_htable *rule_results, struct xccdf_score_totals *score)
+{
+	// Implements algorithms as described in NISTIR-7275-r4
 	// Table 40: Default Model Algorithm Sub-Steps
-	struct xccdf_default_score *score;
-	struct xccdf_default_score *ch_score;
+	// Table 41: Flat Model Algorithm Sub-Steps
+	struct xccdf_score_totals ch_score;
 	struct xccdf_rule_result *rule_result;
 	struct xccdf_item *child;
 
+	memset(score, 0, sizeof(*score));
 	xccdf_type_t itype = xccdf_item_get_type(item);
 
 	switch (itype) {
 	case XCCDF_RULE: {
 		/* Rule */
 		const char *rule_id = xccdf_rule_get_id((const struct xccdf_rule *) item);
-		rule_result = xccdf_result_get_rule_result_by_id(test_result, rule_id);
+		rule_result = oscap_htable_get(rule_results, rule_id);
 		if (rule_result == NULL) {
 			dE("Rule result ID(%s) not fount", rule_id);
-			return NULL;
+			return false;
 		}
-		if (xccdf_rule_result_get_role(rule_result) == XCCDF_ROLE_UNSCORED) {
-			return NULL;
-		}
-
-		/* Ignore these rules */
-		if ((xccdf_rule_result_get_result(rule_result) == XCCDF_RESULT_NOT_SELECTED) ||
-				(xccdf_rule_result_get_result(rule_result) == XCCDF_RESULT_NOT_APPLICABLE) ||
-				(xccdf_rule_result_get_result(rule_result) == XCCDF_RESULT_INFORMATIONAL) ||
-				(xccdf_rule_result_get_result(rule_result) == XCCDF_RESULT_NOT_CHECKED))
-			return NULL;
+		if (!_rule_result_is_scored(rule_result))
+			return false;
 
-		score = malloc(sizeof(struct xccdf_default_score));
+		float weight = xccdf_item_get_weight(item);
+		bool pass = (xccdf_rule_result_get_result(rule_result) == XCCDF_RESULT_PASS) ||
+			(xccdf_rule_result_get_result(rule_result) == XCCDF_RESULT_FIXED);
 
 		/* Count with this rule */
-		score->count = 1;
-
+		score->def.count = 1;
 		/* If the test result is 'pass', assign the node a score of 100, otherwise assign a score of 0 */
-		if ((xccdf_rule_result_get_result(rule_result) == XCCDF_RESULT_PASS) ||
-				(xccdf_rule_result_get_result(rule_result) == XCCDF_RESULT_FIXED))
-			score->score = 100.0;
-		else
-			score->score = 0.0;
-
+		score->def.score = pass ? 100.0 : 0.0;
 		/* Default weight */
-		score->weight_score = score->score * xccdf_item_get_weight(item);
+		score->def.weight_score = score->def.score * weight;
+
+		/* max possible score = sum of weights, score = sum of weights of rules that pass */
+		score->flat.weight = weight;
+		score->flat.score = pass ? weight : 0.0;
+		score->flat_unweighted.weight = 1.0;
+		score->flat_unweighted.score = pass ? 1.0 : 0.0;
 	} break;
 
 	case XCCDF_BENCHMARK:
 	case XCCDF_GROUP: {
-		/* Init */
-		score = malloc(sizeof(struct xccdf_default_score));
-		score->count = 0;
-		score->score = 0.0;
-		score->accumulator = 0.0;
-
 		/* Recurse */
 		struct xccdf_item_iterator * child_it;
 		if (itype == XCCDF_GROUP)
@@ -118,161 +138,80 @@ static struct xccdf_default_score * xccdf_item_get_default_score(struct xccdf_it
 
 		while (xccdf_item_iterator_has_more(child_it)) {
 			child = xccdf_item_iterator_next(child_it);
-			ch_score = xccdf_item_get_default_score(child, test_result);
-
-			if (ch_score == NULL) /* we got item that can't be processed */
-				continue;
-
-			if (ch_score->count == 0) { /* we got item that has no selected items */
-				free(ch_score);
-				continue;
-			}
+			if (!xccdf_item_get_score_totals(child, rule_results, &ch_score))
+				continue; /* we got item that can't be processed */
 
 			/* If child's count value is not 0, then add the child's wighted score to this node's score */
-			score->score += ch_score->weight_score;
-			score->count++;
-			score->accumulator += xccdf_item_get_weight(child);
-
-			free(ch_score);
+			if (ch_score.def.count != 0) {
+				score->def.score += ch_score.def.weight_score;
+				score->def.count++;
+				score->def.accumulator += xccdf_item_get_weight(child);
+			}
+			/* Items with no selected items have no weight in the flat models */
+			if (ch_score.flat.weight != 0) {
+				score->flat.score += ch_score.flat.score;
+				score->flat.weight += ch_score.flat.weight;
+			}
+			if (ch_score.flat_unweighted.weight != 0) {
+				score->flat_unweighted.score += ch_score.flat_unweighted.score;
+				score->flat_unweighted.weight += ch_score.flat_unweighted.weight;
+			}
 		}
+		xccdf_item_iterator_free(child_it);
 
 		/* Normalize */
-		if (score->count && score->accumulator)
-			score->score = score->score / score->accumulator;
+		if (score->def.count && score->def.accumulator)
+			score->def.score = score->def.score / score->def.accumulator;
 		/* Default weight */
-		score->weight_score = score->score * xccdf_item_get_weight(item);
-
-		xccdf_item_iterator_free(child_it);
+		score->def.weight_score = score->def.score * xccdf_item_get_weight(item);
 	} break;
 
 	default: {
 		dE("Unsupported item type: %d", itype);
-		score=NULL;
+		return false;
 	} break;
 
 	} /* switch */
-	return score;
+	return true;
 }
 
-static struct xccdf_flat_score * xccdf_item_get_flat_score(struct xccdf_item * item, struct xccdf_result * test_result, bool unweighted)
+struct xccdf_score_totals *xccdf_result_score_totals_new(struct xccdf_result *test_result, struct xccdf_item *benchmark)
 {
-	// Implements algorithm as described in NISTIR-7275-r4
-	// Table 41: Flat Model Algorithm Sub-Steps
-	struct xccdf_flat_score *score;
-	struct xccdf_flat_score *ch_score;
-	struct xccdf_rule_result *rule_result;
-	struct xccdf_item *child;
-
-	xccdf_type_t itype = xccdf_item_get_type(item);
-
-	switch (itype) {
-	case XCCDF_RULE:{
-		/* Rule */
-		const char *rule_id = xccdf_rule_get_id((const struct xccdf_rule *) item);
-		rule_result = xccdf_result_get_rule_result_by_id(test_result, rule_id);
-		if (rule_result == NULL) {
-			dE("Rule result ID(%s) not fount", rule_id);
-			return NULL;
-		}
-		if (xccdf_rule_result_get_role(rule_result) == XCCDF_ROLE_UNSCORED) {
-			return NULL;
-		}
-
-		/* Ignore these rules */
-		if ((xccdf_rule_result_get_result(rule_result) == XCCDF_RESULT_NOT_SELECTED) ||
-				(xccdf_rule_result_get_result(rule_result) == XCCDF_RESULT_NOT_APPLICABLE) ||
-				(xccdf_rule_result_get_result(rule_result) == XCCDF_RESULT_INFORMATIONAL) ||
-				(xccdf_rule_result_get_result(rule_result) == XCCDF_RESULT_NOT_CHECKED))
-			return NULL;
-
-		score = malloc(sizeof(struct xccdf_flat_score));
-
-		/* max possible score = sum of weights*/
-		if (unweighted)
-			score->weight = 1.0;
-		else score->weight =
-			xccdf_item_get_weight(item);
-
-		/* score = sum of weights of rules that pass */
-		if ((xccdf_rule_result_get_result(rule_result) == XCCDF_RESULT_PASS) ||
-				(xccdf_rule_result_get_result(rule_result) == XCCDF_RESULT_FIXED)) {
-			if (unweighted)
-				score->score = 1.0;
-			else
-				score->score = xccdf_item_get_weight(item);
-		} else
-			score->score = 0.0;	/* fail */
-	} break;
-	case XCCDF_BENCHMARK:
-	case XCCDF_GROUP:{
-		/* Init */
-		score = malloc(sizeof(struct xccdf_flat_score));
-		score->score = 0;
-		score->weight = 0.0;
-
-		/* Recurse */
-		struct xccdf_item_iterator * child_it;
-		if (itype == XCCDF_GROUP)
-			child_it = xccdf_group_get_content((const struct xccdf_group *)item);
-		else
-			child_it = xccdf_benchmark_get_content((const struct xccdf_benchmark *)item);
-
-		while (xccdf_item_iterator_has_more(child_it)) {
-			child = xccdf_item_iterator_next(child_it);
-			ch_score = xccdf_item_get_flat_score(child, test_result, unweighted);
-
-			if (ch_score == NULL) /* we got item that can't be processed */
-				continue;
-
-			if (ch_score->weight == 0) { /* we got item that has no selected items */
-				free(ch_score);
-				continue;
-			}
-
-			/* If child's count value is not 0, then add the child's wighted score to this node's score */
-			score->score += ch_score->score;
-			score->weight += ch_score->weight;
-
-			free(ch_score);
-		}
-
-		xccdf_item_iterator_free(child_it);
-	} break;
-
-	default: {
-		dE("Unsupported item type: %d", itype);
-		score=NULL;
-	} break;
+	struct xccdf_score_totals *totals = malloc(sizeof(struct xccdf_score_totals));
+	struct oscap_htable *rule_results = oscap_htable_new();
+
+	/* The first rule-result of the rule is used */
+	struct xccdf_rule_result_iterator *rr_it = xccdf_result_get_rule_results(test_result);
+	while (xccdf_rule_result_iterator_has_more(rr_it)) {
+		struct xccdf_rule_result *rule_result = xccdf_rule_result_iterator_next(rr_it);
+		const char *idref = xccdf_rule_result_get_idref(rule_result);
+		if (idref != NULL && oscap_htable_get(rule_results, idref) == NULL)
+			oscap_htable_add(rule_results, idref, rule_result);
+	}
+	xccdf_rule_result_iterator_free(rr_it);
 
-	} /* switch */
-	return score;
+	xccdf_item_get_score_totals(benchmark, rule_results, totals);
+	oscap_htable_free0(rule_results);
+	return totals;
 }
 
-struct xccdf_score *xccdf_result_calculate_score(struct xccdf_result *test_result, struct xccdf_item *benchmark, const char *score_system)
+struct xccdf_score *xccdf_score_totals_get_score(const struct xccdf_score_totals *totals, const char *score_system)
 {
 	struct xccdf_score *score = xccdf_score_new();
 	xccdf_score_set_system(score, score_system);
 	if (oscap_streq(score_system, "urn:xccdf:scoring:default")) {
-		struct xccdf_default_score * item_score = xccdf_item_get_default_score(benchmark, test_result);
-		xccdf_score_set_score(score, item_score->score);
-		free(item_score);
+		xccdf_score_set_score(score, totals->def.score);
 	} else if (oscap_streq(score_system, "urn:xccdf:scoring:flat")) {
-		struct xccdf_flat_score * item_score = xccdf_item_get_flat_score(benchmark, test_result, false);
-		xccdf_score_set_maximum(score, item_score->weight);
-		xccdf_score_set_score(score, item_score->score);
-		free(item_score);
+		xccdf_score_set_maximum(score, totals->flat.weight);
+		xccdf_score_set_score(score, totals->flat.score);
 	} else if (oscap_streq(score_system, "urn:xccdf:scoring:flat-unweighted")) {
-		struct xccdf_flat_score * item_score = xccdf_item_get_flat_score(benchmark, test_result, true);
-		xccdf_score_set_maximum(score, item_score->weight);
-		xccdf_score_set_score(score, item_score->score);
-		free(item_score);
+		xccdf_score_set_maximum(score, totals->flat_unweighted.weight);
+		xccdf_score_set_score(score, totals->flat_unweighted.score);
 	} else if (oscap_streq(score_system, "urn:xccdf:scoring:absolute")) {
 		int absolute;
-		struct xccdf_flat_score * item_score = xccdf_item_get_flat_score(benchmark, test_result, false);
-		xccdf_score_set_maximum(score, item_score->weight);
-		absolute = (item_score->score == item_score->weight);
+		xccdf_score_set_maximum(score, totals->flat.weight);
+		absolute = (totals->flat.score == totals->flat.weight);
 		xccdf_score_set_score(score, absolute);
-		free(item_score);
 	} else {
 		xccdf_score_free(score);
 		dE("Scoring system \"%s\" is not supported.", score_system);
@@ -281,22 +220,37 @@ struct xccdf_score *xccdf_result_calculate_score(struct xccdf_result *test_resul
 	return score;
 }
 
+void xccdf_score_totals_free(struct xccdf_score_totals *totals)
+{
+	free(totals);
+}
+
+struct xccdf_score *xccdf_result_calculate_score(struct xccdf_result *test_result, struct xccdf_item *benchmark, const char *score_system)
+{
+	struct xccdf_score_totals *totals = xccdf_result_score_totals_new(test_result, benchmark);
+	struct xccdf_score *score = xccdf_score_totals_get_score(totals, score_system);
+	xccdf_score_totals_free(totals);
+	return score;
+}
+
 int xccdf_result_recalculate_scores(struct xccdf_result *result, struct xccdf_item *benchmark)
 {
 	struct oscap_list *new_scores = oscap_list_new();
+	struct xccdf_score_totals *totals = xccdf_result_score_totals_new(result, benchmark);
 	struct xccdf_score_iterator *score_it = xccdf_result_get_scores(result);
 	while (xccdf_score_iterator_has_more(score_it)) {
 		struct xccdf_score *old = xccdf_score_iterator_next(score_it);
-		struct xccdf_score *new = xccdf_result_calculate_score(result, benchmark,
-			xccdf_score_get_system(old));
+		struct xccdf_score *new = xccdf_score_totals_get_score(totals, xccdf_score_get_system(old));
 		if (new == NULL) {
 			oscap_list_free(new_scores, (oscap_destruct_func) xccdf_score_free);
 			xccdf_score_iterator_free(score_it);
+			xccdf_score_totals_free(totals);
 			return 1;
 		}
 		oscap_list_add(new_scores, new);
 	}
 	xccdf_score_iterator_free(score_it);
+	xccdf_score_totals_free(totals);
 	oscap_list_free(((struct xccdf_item *)result)->sub.result.scores, (oscap_destruct_func) xccdf_score_free);
         ((struct xccdf_item *)result)->sub.result.scores = new_scores;
 	return 0;
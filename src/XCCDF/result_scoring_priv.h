@@ -41,4 +41,27 @@
  */
 struct xccdf_score *xccdf_result_calculate_score(struct xccdf_result *test_result, struct xccdf_item *benchmark, const char *score_system);
 
+/**
+ * Scores of an XCCDF TestResult in all the supported Scoring Models.
+ * These are computed by a single traversal of the Benchmark, use them
+ * when more than one score of the same TestResult is needed.
+ */
+struct xccdf_score_totals;
+
+/**
+ * Calculate the scores of given xccdf:TestResult in all the Scoring Models
+ * @param test_result XCCDF TestResult
+ * @param benchmark XCCDF Benchmark which is origin of given XCCDF TestResult
+ */
+struct xccdf_score_totals *xccdf_result_score_totals_new(struct xccdf_result *test_result, struct xccdf_item *benchmark);
+
+/**
+ * Create new XCCDF Score of given Scoring Model from the computed scores
+ * @param score_system Scoring Model URI as described in XCCDF standard.
+ * @returns NULL if the Scoring Model isn't supported
+ */
+struct xccdf_score *xccdf_score_totals_get_score(const struct xccdf_score_totals *totals, const char *score_system);
+
+void xccdf_score_totals_free(struct xccdf_score_totals *totals);
+
 #endif
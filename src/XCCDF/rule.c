@@ -197,6 +197,7 @@ struct xccdf_group * xccdf_group_clone(const struct xccdf_group * group)
 {
 	struct xccdf_item *new_group = calloc(1, sizeof(struct xccdf_item) + sizeof(struct xccdf_group_item));
 	struct xccdf_item *old = XITEM(group);
+	xccdf_item_load_texts(old);
     xccdf_item_base_clone(&new_group->item, &(old->item));
 	new_group->type = old->type;
     xccdf_group_item_clone(new_group, &(old->sub.group));
@@ -297,6 +298,7 @@ struct xccdf_rule *xccdf_rule_clone(const struct xccdf_rule * rule)
 {
 	struct xccdf_item *new_rule = calloc(1, sizeof(struct xccdf_item) + sizeof(struct xccdf_rule_item));
 	struct xccdf_item *old = XITEM(rule);
+	xccdf_item_load_texts(old);
     xccdf_item_base_clone(&new_rule->item, &(old->item));
 	new_rule->type = old->type;
     xccdf_rule_item_clone(&new_rule->sub.rule, &old->sub.rule);
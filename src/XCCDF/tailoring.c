@@ -156,9 +156,11 @@ struct xccdf_tailoring *xccdf_tailoring_parse(xmlTextReaderPtr reader, struct xc
 		}
 		case XCCDFE_STATUS: {
 			const char *date = xccdf_attribute_get(reader, XCCDFA_DATE);
-			char *str = oscap_element_string_copy(reader);
-			struct xccdf_status *status = xccdf_status_new_fill(str, date);
-			free(str);
+			struct oscap_strbuf str;
+			oscap_strbuf_init(&str);
+			struct xccdf_status *status = oscap_element_string_append(reader, &str) ?
+				xccdf_status_new_fill(oscap_strbuf_get(&str), date) : NULL;
+			oscap_strbuf_release(&str);
 			oscap_list_add(tailoring->statuses, status);
 			break;
 		}
@@ -60,6 +60,7 @@ struct xccdf_value * xccdf_value_clone(const struct xccdf_value * value)
 {
 	struct xccdf_item *new_value = calloc(1, sizeof(struct xccdf_item) + sizeof(struct xccdf_value_item));
 	struct xccdf_item *old = XITEM(value);
+	xccdf_item_load_texts(old);
     xccdf_item_base_clone(&new_value->item, &old->item);
 	new_value->type = old->type;
     xccdf_value_item_clone(&new_value->sub.value, &XITEM(value)->sub.value);
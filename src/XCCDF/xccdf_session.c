@@ -42,6 +42,7 @@
 #include "common/oscapxml.h"
 #include "common/_error.h"
 #include "common/debug_priv.h"
+#include "common/profiling_priv.h"
 #include "CPE/cpe_session_priv.h"
 #include "DS/public/scap_ds.h"
 #include "DS/public/ds_sds_session.h"
@@ -49,13 +50,17 @@
 #include "DS/rds_priv.h"
 #include "DS/sds_priv.h"
 #include "OVAL/results/oval_results_impl.h"
+#include "OVAL/oval_object_cache_impl.h"
+#include "source/oscap_source_priv.h"
 #include "source/xslt_priv.h"
 #include "source/signature_priv.h"
+#include "source/validate_priv.h"
 #include "XCCDF/xccdf_impl.h"
 #include "XCCDF_POLICY/public/xccdf_policy.h"
 #include "XCCDF_POLICY/xccdf_policy_priv.h"
 #include "XCCDF_POLICY/xccdf_policy_model_priv.h"
 #include "item.h"
+#include "result_scoring_priv.h"
 #include "public/xccdf_session.h"
 #include "XCCDF_POLICY/public/check_engine_plugin.h"
 #include "oscap_helpers.h"
@@ -71,12 +76,15 @@ struct xccdf_session {
 	struct oscap_list *rules;
 	struct oscap_list *skip_rules;
 	struct oscap_source *source;                    ///< Main source assigned with the main file (SDS or XCCDF)
+	xmlDict *dict;					///< Strings shared by the documents parsed by the session
 	char *temp_dir;					///< Temp directory used for decomposed component files.
 	struct {
 		struct oscap_source *source;            ///< oscap_source representing the XCCDF file
 		struct xccdf_policy_model *policy_model;///< Active policy model.
 		char *profile_id;			///< Last selected profile.
 		struct xccdf_result *result;		///< XCCDF Result model.
+		struct oscap_list *extra_profile_ids;	///< Profiles evaluated along with the selected one.
+		struct oscap_list *extra_results;	///< XCCDF Result models of the extra profiles.
 		float base_score;			///< Basec score of the latest evaluation.
 		struct oscap_source *result_source;     ///< oscap_source for the exported XCCDF result
 	} xccdf;
@@ -99,17 +107,22 @@ struct xccdf_session {
 		struct oscap_htable *result_sources;    ///< mapping 'filepath' to oscap_source for OVAL results
 		struct oscap_htable *results_mapping;    ///< mapping OVAL filename to filepath for OVAL results
 		struct oscap_htable *arf_report_mapping;    ///< mapping OVAL filename to ARF report ID for OVAL results
+		struct oval_object_cache *object_cache;	///< Collected objects shared by all OVAL agents
+		bool lazy_loading;			///< Load only the OVAL definitions used by the selected rules
+		bool referenced_entities_only;		///< Collect only the item entities the definitions use
 	} oval;
 	struct {
 		char *arf_file;				///< Path to ARF file to export
 		char *xccdf_file;			///< Path to XCCDF file to export
 		char *xccdf_stig_viewer_file;		///< Path to STIG Viewer XCCDF file to export
 		char *report_file;			///< Path to HTML file to export
+		char *results_jsonl_file;		///< Path to JSON lines results file to export
 		bool oval_results;			///< Shall be the OVAL results files exported?
 		bool oval_variables;			///< Shall be the OVAL variable files exported?
 		bool check_engine_plugins_results;	///< Shall the check engine plugins results be exported?
 		bool without_sys_chars;			///< Shall system characteristics be exported?
 		bool thin_results;			///< Shall OVAL/ARF results be exported as THIN? Default is FULL
+		bool arf_sds_reference;			///< Shall ARF reference the source data stream instead of embedding it?
 	} export;					///< Settings of Session export
 	char *user_cpe;					///< Path to CPE dictionary required by user
 	struct {
@@ -142,6 +155,8 @@ struct xccdf_session *xccdf_session_new_from_source(struct oscap_source *source)
 	const char *filename = oscap_source_get_filepath(source);
 	struct xccdf_session *session = (struct xccdf_session *) calloc(1, sizeof(struct xccdf_session));
 	session->source = source;
+	session->dict = xmlDictCreate();
+	oscap_source_set_dict(session->source, session->dict);
 	oscap_document_type_t document_type = oscap_source_get_scap_type(session->source);
 	if (document_type == OSCAP_DOCUMENT_UNKNOWN) {
 		xccdf_session_free(session);
@@ -162,10 +177,13 @@ struct xccdf_session *xccdf_session_new_from_source(struct oscap_source *source)
 	session->signature_ctx = oscap_signature_ctx_new();
 	session->xccdf.base_score = 0;
 	session->oval.progress = download_progress_empty_calllback;
+	session->oval.object_cache = oval_object_cache_new();
 	session->check_engine_plugins = oscap_list_new();
 	session->loading_flags = XCCDF_SESSION_LOAD_ALL;
 	session->rules = oscap_list_new();
 	session->skip_rules = oscap_list_new();
+	session->xccdf.extra_profile_ids = oscap_list_new();
+	session->xccdf.extra_results = oscap_list_new();
 
 	// We now have to switch up the oscap_sources in case we were given XCCDF tailoring
 
@@ -226,6 +244,7 @@ static int _xccdf_session_autonegotiate_tailoring_file(struct xccdf_session *ses
 		return -1;
 	}
 
+	oscap_source_set_dict(real_source, session->dict);
 	session->tailoring.user_file = session->source;
 	session->source = real_source;
 
@@ -256,7 +275,91 @@ static struct oscap_source* xccdf_session_create_arf_source(struct xccdf_session
 	return session->oval.arf_report;
 }
 
-static struct oscap_source *xccdf_session_extract_arf_source(struct xccdf_session *session)
+/*
+ * Get the timestamp of the tailoring component from the modification time
+ * of the tailoring file, timestamp is left NULL if the file can't be stat'ed.
+ */
+static int _xccdf_session_tailoring_timestamp(const char *tailoring_filepath, char **timestamp)
+{
+	struct stat file_stat;
+
+	*timestamp = NULL;
+	if (stat(tailoring_filepath, &file_stat) != 0)
+		return 0;
+
+	const size_t max_timestamp_len = 32;
+	*timestamp = malloc(max_timestamp_len);
+	if (*timestamp == NULL) {
+		oscap_seterr(OSCAP_EFAMILY_GLIBC, "Failed to allocate %zu bytes for tailoring_doc_timestamp: %s", max_timestamp_len, strerror(errno));
+		return 1;
+	}
+	struct tm *tm_mtime = malloc(sizeof(struct tm));
+#ifdef OS_WINDOWS
+	localtime_s(tm_mtime, &file_stat.st_mtime);
+#else
+	localtime_r(&file_stat.st_mtime, tm_mtime);
+#endif
+	strftime(*timestamp, max_timestamp_len, "%Y-%m-%dT%H:%M:%S", tm_mtime);
+	free(tm_mtime);
+	return 0;
+}
+
+/*
+ * Write the ARF report referencing the source data stream by its digest, the
+ * session source is left as it is.
+ */
+static int xccdf_session_write_arf_sds_reference(struct xccdf_session *session)
+{
+	struct ds_rds_sds_reference sds_reference;
+	char *digest = NULL;
+	char *tailoring_digest = NULL;
+	char *tailoring_timestamp = NULL;
+	int ret = 1;
+
+	memset(&sds_reference, 0, sizeof(sds_reference));
+	sds_reference.href = oscap_source_get_filepath(session->source);
+	if (sds_reference.href == NULL) {
+		oscap_seterr(OSCAP_EFAMILY_OSCAP, "The ARF can reference only a source data stream read from a file.");
+		goto cleanup;
+	}
+	digest = ds_rds_file_digest(sds_reference.href);
+	if (digest == NULL)
+		goto cleanup;
+	sds_reference.digest = digest;
+
+	if (session->tailoring.user_file != NULL) {
+		sds_reference.tailoring_href = oscap_source_get_filepath(session->tailoring.user_file);
+		tailoring_digest = ds_rds_file_digest(sds_reference.tailoring_href);
+		if (tailoring_digest == NULL)
+			goto cleanup;
+		sds_reference.tailoring_digest = tailoring_digest;
+		if (_xccdf_session_tailoring_timestamp(sds_reference.tailoring_href, &tailoring_timestamp) != 0)
+			goto cleanup;
+		sds_reference.tailoring_timestamp = tailoring_timestamp;
+	}
+
+	xmlDoc *result_file_doc = oscap_source_get_xmlDoc(session->xccdf.result_source);
+	if (result_file_doc == NULL)
+		goto cleanup;
+
+	if (ds_rds_write_sds_reference(session->export.arf_file, &sds_reference, result_file_doc,
+			session->oval.result_sources, session->oval.results_mapping,
+			session->oval.arf_report_mapping) == 0)
+		ret = 0;
+
+cleanup:
+	free(digest);
+	free(tailoring_digest);
+	free(tailoring_timestamp);
+	return ret;
+}
+
+/*
+ * Build the ARF report from the session, the session source is consumed.
+ * With write_file the report is written to the ARF export file as it is
+ * assembled, and the returned source refers to the written file.
+ */
+static struct oscap_source *xccdf_session_extract_arf_source(struct xccdf_session *session, bool write_file)
 {
 	struct oscap_source *rds_source = NULL;
 	char *tailoring_doc_timestamp = NULL;
@@ -287,24 +390,18 @@ static struct oscap_source *xccdf_session_extract_arf_source(struct xccdf_sessio
 			goto cleanup;
 		}
 		tailoring_filepath = oscap_source_get_filepath(session->tailoring.user_file);
-		struct stat file_stat;
-		if (stat(tailoring_filepath, &file_stat) == 0) {
-			const size_t max_timestamp_len = 32;
-			tailoring_doc_timestamp = malloc(max_timestamp_len);
-			if (tailoring_doc_timestamp == NULL) {
-				oscap_seterr(OSCAP_EFAMILY_GLIBC, "Failed to allocate %zu bytes for tailoring_doc_timestamp: %s", max_timestamp_len, strerror(errno));
-				goto cleanup;
-			}
-			struct tm *tm_mtime = malloc(sizeof(struct tm));
-#ifdef OS_WINDOWS
-			localtime_s(tm_mtime, &file_stat.st_mtime);
-#else
-			localtime_r(&file_stat.st_mtime, tm_mtime);
-#endif
-			strftime(tailoring_doc_timestamp, max_timestamp_len,
-					"%Y-%m-%dT%H:%M:%S", tm_mtime);
-			free(tm_mtime);
+		if (_xccdf_session_tailoring_timestamp(tailoring_filepath, &tailoring_doc_timestamp) != 0)
+			goto cleanup;
+	}
+
+	if (write_file) {
+		if (ds_rds_write_from_dom(session->export.arf_file, sds_doc, tailoring_doc,
+				tailoring_filepath, tailoring_doc_timestamp, result_file_doc,
+				session->oval.result_sources, session->oval.results_mapping,
+				session->oval.arf_report_mapping) == 0) {
+			rds_source = oscap_source_new_from_file(session->export.arf_file);
 		}
+		goto cleanup;
 	}
 
 	xmlDocPtr rds_doc = NULL;
@@ -329,10 +426,14 @@ void xccdf_session_free(struct xccdf_session *session)
 	if (session == NULL)
 		return;
 	free(session->xccdf.profile_id);
+	oscap_list_free(session->xccdf.extra_profile_ids, (oscap_destruct_func) free);
+	/* the results are owned by their policies */
+	oscap_list_free0(session->xccdf.extra_results);
 	free(session->export.xccdf_file);
 	free(session->export.xccdf_stig_viewer_file);
 	free(session->export.report_file);
 	free(session->export.arf_file);
+	free(session->export.results_jsonl_file);
 	_xccdf_session_free_oval_result_sources(session);
 	xccdf_session_unload_check_engine_plugins(session);
 	oscap_list_free0(session->check_engine_plugins);
@@ -359,9 +460,79 @@ void xccdf_session_free(struct xccdf_session *session)
 	oscap_signature_ctx_free(session->signature_ctx);
 	oscap_list_free(session->rules, (oscap_destruct_func) free);
 	oscap_list_free(session->skip_rules, (oscap_destruct_func) free);
+	oval_object_cache_free(session->oval.object_cache);
+	if (session->dict != NULL)
+		xmlDictFree(session->dict);
 	free(session);
 }
 
+static bool _xccdf_session_is_evaluated_result(struct xccdf_session *session, const char *result_id)
+{
+	if (session->xccdf.result != NULL && oscap_streq(xccdf_result_get_id(session->xccdf.result), result_id))
+		return true;
+	bool found = false;
+	struct oscap_iterator *it = oscap_iterator_new(session->xccdf.extra_results);
+	while (!found && oscap_iterator_has_more(it))
+		found = oscap_streq(xccdf_result_get_id(oscap_iterator_next(it)), result_id);
+	oscap_iterator_free(it);
+	return found;
+}
+
+int xccdf_session_reset_results(struct xccdf_session *session)
+{
+	int ret = 0;
+
+	/* the copies of the TestResults added to the benchmark by the export */
+	struct xccdf_benchmark *benchmark = xccdf_policy_model_get_benchmark(session->xccdf.policy_model);
+	if (benchmark != NULL) {
+		struct xccdf_result_iterator *rit = xccdf_benchmark_get_results(benchmark);
+		while (xccdf_result_iterator_has_more(rit)) {
+			struct xccdf_result *result = xccdf_result_iterator_next(rit);
+			if (_xccdf_session_is_evaluated_result(session, xccdf_result_get_id(result)))
+				xccdf_result_iterator_remove(rit);
+		}
+		xccdf_result_iterator_free(rit);
+	}
+
+	/* the TestResults are owned by their policies */
+	struct xccdf_policy_iterator *pit = xccdf_policy_model_get_policies(session->xccdf.policy_model);
+	while (xccdf_policy_iterator_has_more(pit)) {
+		struct xccdf_result_iterator *rit = xccdf_policy_get_results(xccdf_policy_iterator_next(pit));
+		while (xccdf_result_iterator_has_more(rit)) {
+			xccdf_result_iterator_next(rit);
+			xccdf_result_iterator_remove(rit);
+		}
+		xccdf_result_iterator_free(rit);
+	}
+	xccdf_policy_iterator_free(pit);
+	session->xccdf.result = NULL;
+	session->xccdf.base_score = 0;
+	oscap_list_free0(session->xccdf.extra_results);
+	session->xccdf.extra_results = oscap_list_new();
+
+	oscap_source_free(session->xccdf.result_source);
+	session->xccdf.result_source = NULL;
+	oscap_source_free(session->oval.arf_report);
+	session->oval.arf_report = NULL;
+	_xccdf_session_free_oval_result_sources(session);
+	oscap_htable_free(session->oval.results_mapping, (oscap_destruct_func) free);
+	session->oval.results_mapping = NULL;
+	oscap_htable_free(session->oval.arf_report_mapping, (oscap_destruct_func) free);
+	session->oval.arf_report_mapping = NULL;
+
+	/* The objects are collected again by the running probes. The CPE
+	 * applicability of the platforms isn't evaluated again. */
+	oval_object_cache_free(session->oval.object_cache);
+	session->oval.object_cache = oval_object_cache_new();
+	cpe_session_set_object_cache(xccdf_policy_model_get_cpe_session(session->xccdf.policy_model), session->oval.object_cache);
+	for (int i = 0; session->oval.agents != NULL && session->oval.agents[i]; i++) {
+		if (oval_agent_clear_session(session->oval.agents[i]) != 0)
+			ret = 1;
+		oval_agent_set_object_cache(session->oval.agents[i], session->oval.object_cache);
+	}
+	return ret;
+}
+
 const char *xccdf_session_get_filename(const struct xccdf_session *session)
 {
 	return oscap_source_readable_origin(session->source);
@@ -410,6 +581,18 @@ void xccdf_session_set_thin_results(struct xccdf_session *session, bool thin_res
 	session->export.thin_results = thin_results;
 }
 
+void xccdf_session_set_oval_lazy_loading(struct xccdf_session *session, bool lazy_loading)
+{
+	session->oval.lazy_loading = lazy_loading;
+}
+
+void xccdf_session_set_referenced_entities_only(struct xccdf_session *session, bool referenced_only)
+{
+	session->oval.referenced_entities_only = referenced_only;
+	for (int i = 0; session->oval.agents != NULL && session->oval.agents[i]; i++)
+		oval_agent_set_referenced_entities_only(session->oval.agents[i], referenced_only);
+}
+
 void xccdf_session_set_datastream_id(struct xccdf_session *session, const char *datastream_id)
 {
 	free(session->ds.user_datastream_id);
@@ -465,6 +648,7 @@ void xccdf_session_set_user_tailoring_file(struct xccdf_session *session, const
 	oscap_source_free(session->tailoring.user_file);
 	session->tailoring.user_file = user_tailoring_file != NULL ?
 		oscap_source_new_from_file(user_tailoring_file) : NULL;
+	oscap_source_set_dict(session->tailoring.user_file, session->dict);
 }
 
 void xccdf_session_set_user_tailoring_cid(struct xccdf_session *session, const char *user_tailoring_cid)
@@ -512,6 +696,18 @@ bool xccdf_session_set_arf_export(struct xccdf_session *session, const char *arf
 	return true;
 }
 
+bool xccdf_session_set_results_jsonl_export(struct xccdf_session *session, const char *jsonl_file)
+{
+	free(session->export.results_jsonl_file);
+	session->export.results_jsonl_file = oscap_strdup(jsonl_file);
+	return true;
+}
+
+void xccdf_session_set_arf_sds_reference(struct xccdf_session *session, bool sds_reference)
+{
+	session->export.arf_sds_reference = sds_reference;
+}
+
 bool xccdf_session_set_xccdf_export(struct xccdf_session *session, const char *xccdf_file)
 {
 	free(session->export.xccdf_file);
@@ -587,7 +783,7 @@ const char *xccdf_benchmark_match_profile_id(struct xccdf_benchmark *bench, cons
 	return xccdf_profiles_match_profile_id(profile_it, profile_suffix, match_status);
 }
 
-int xccdf_session_set_profile_id_by_suffix(struct xccdf_session *session, const char *profile_suffix)
+static const char *_xccdf_session_match_profile_id(struct xccdf_session *session, const char *profile_suffix, int *match_status)
 {
 	const char *full_profile_id = NULL;
 	struct xccdf_benchmark *bench = xccdf_policy_model_get_benchmark(session->xccdf.policy_model);
@@ -621,6 +817,15 @@ int xccdf_session_set_profile_id_by_suffix(struct xccdf_session *session, const
 		full_profile_id = xccdf_benchmark_match_profile_id(bench, profile_suffix, &return_code);
 	}
 
+	*match_status = return_code;
+	return return_code == OSCAP_PROFILE_MATCH_OK ? full_profile_id : NULL;
+}
+
+int xccdf_session_set_profile_id_by_suffix(struct xccdf_session *session, const char *profile_suffix)
+{
+	int return_code;
+	const char *full_profile_id = _xccdf_session_match_profile_id(session, profile_suffix, &return_code);
+
 	if (return_code == OSCAP_PROFILE_MATCH_OK) {
 		if (!xccdf_session_set_profile_id(session, full_profile_id)) {
 			return_code = OSCAP_PROFILE_NO_MATCH;
@@ -629,6 +834,31 @@ int xccdf_session_set_profile_id_by_suffix(struct xccdf_session *session, const
 	return return_code;
 }
 
+bool xccdf_session_add_profile_id(struct xccdf_session *session, const char *profile_id)
+{
+	if (profile_id == NULL)
+		return false;
+	if (xccdf_policy_model_get_policy_by_id(session->xccdf.policy_model, profile_id) == NULL)
+		return false;
+	if (!oscap_list_contains(session->xccdf.extra_profile_ids, (void *) profile_id, (oscap_cmp_func) oscap_streq))
+		oscap_list_add(session->xccdf.extra_profile_ids, oscap_strdup(profile_id));
+	return true;
+}
+
+int xccdf_session_add_profile_id_by_suffix(struct xccdf_session *session, const char *profile_suffix)
+{
+	int return_code;
+	const char *full_profile_id = _xccdf_session_match_profile_id(session, profile_suffix, &return_code);
+
+	if (return_code == OSCAP_PROFILE_MATCH_OK) {
+		if (!xccdf_session_add_profile_id(session, full_profile_id)) {
+			return_code = OSCAP_PROFILE_NO_MATCH;
+		}
+	}
+	return return_code;
+}
+
+
 const char *xccdf_session_get_profile_id(struct xccdf_session *session)
 {
 	return session->xccdf.profile_id;
@@ -688,7 +918,7 @@ struct ds_sds_index *xccdf_session_get_sds_idx(struct xccdf_session *session)
 	return ds_sds_session_get_sds_idx(xccdf_session_get_ds_sds_session(session));
 }
 
-int xccdf_session_load(struct xccdf_session *session)
+static int _xccdf_session_load(struct xccdf_session *session)
 {
 	int ret = 0;
 
@@ -702,7 +932,12 @@ int xccdf_session_load(struct xccdf_session *session)
 			return ret;
 	}
 	if (flags & XCCDF_SESSION_LOAD_CPE) {
-		if ((ret = xccdf_session_load_cpe(session)) != 0) {
+		struct oscap_profiling_mark mark;
+
+		oscap_profiling_start(&mark);
+		ret = xccdf_session_load_cpe(session);
+		oscap_profiling_stop(&mark, OSCAP_PROFILING_PHASE, "cpe", NULL, 0);
+		if (ret != 0) {
 			return ret;
 		}
 	}
@@ -721,12 +956,32 @@ int xccdf_session_load(struct xccdf_session *session)
 	return ret;
 }
 
+int xccdf_session_load(struct xccdf_session *session)
+{
+	struct oscap_profiling_mark mark;
+	int ret;
+
+	oscap_profiling_start(&mark);
+	ret = _xccdf_session_load(session);
+	oscap_profiling_stop(&mark, OSCAP_PROFILING_PHASE, "load", NULL, 0);
+
+	return ret;
+}
+
 static int _reporter(const char *file, int line, const char *msg, void *arg)
 {
 	oscap_seterr(OSCAP_EFAMILY_OSCAP, "File '%s' line %d: %s", file, line, msg);
 	return 0;
 }
 
+static int _xccdf_session_validate_file(const char *filepath)
+{
+	struct oscap_source *source = oscap_source_new_from_file(filepath);
+	int ret = oscap_source_validate(source, _reporter, NULL) != 0;
+	oscap_source_free(source);
+	return ret;
+}
+
 static inline int _xccdf_session_load_xccdf_benchmark(struct xccdf_session *session)
 {
 	if (session->xccdf.policy_model != NULL) {
@@ -746,7 +1001,9 @@ static inline int _xccdf_session_load_xccdf_benchmark(struct xccdf_session *sess
 	}
 
 	/* Load XCCDF model and XCCDF Policy model */
-	struct xccdf_benchmark *benchmark = xccdf_benchmark_import_source(session->xccdf.source);
+	struct xccdf_benchmark *benchmark = (session->loading_flags & XCCDF_SESSION_LOAD_TEXTS_ON_DEMAND) ?
+		xccdf_benchmark_import_source_deferred_texts(session->xccdf.source) :
+		xccdf_benchmark_import_source(session->xccdf.source);
 	if (benchmark == NULL) {
 		return 1;
 	}
@@ -793,6 +1050,7 @@ static int _acquire_xccdf_checklist_from_tailoring(struct xccdf_session* session
 		}
 
 		struct oscap_source *external_file = oscap_source_new_from_file(filename);
+		oscap_source_set_dict(external_file, session->dict);
 		if (oscap_source_get_scap_type(external_file) == OSCAP_DOCUMENT_SDS) {
 			if (component_ref == NULL) {
 				oscap_seterr(OSCAP_EFAMILY_OSCAP,
@@ -894,10 +1152,12 @@ int xccdf_session_load_cpe(struct xccdf_session *session)
 	// to apply the thin results settings to them.
 	struct cpe_session *cpe_session = xccdf_policy_model_get_cpe_session(session->xccdf.policy_model);
 	cpe_session_set_thin_results(cpe_session, session->export.thin_results);
+	cpe_session_set_object_cache(cpe_session, session->oval.object_cache);
 
 	/* Use custom CPE dict if given */
 	if (session->user_cpe != NULL) {
 		struct oscap_source *source = oscap_source_new_from_file(session->user_cpe);
+		oscap_source_set_dict(source, session->dict);
 		if (oscap_source_validate(source, _reporter, NULL) != 0) {
 			oscap_source_free(source);
 			return 1;
@@ -987,6 +1247,7 @@ void xccdf_session_set_custom_oval_files(struct xccdf_session *session, char **o
 		resources[i] = malloc(sizeof(struct oval_content_resource));
 		resources[i]->href = oscap_basename(oval_filenames[i]);
 		resources[i]->source = oscap_source_new_from_file(oval_filenames[i]);
+		oscap_source_set_dict(resources[i]->source, session->dict);
 		resources[i]->source_owned = true;
 		i++;
 		resources[i] = NULL;
@@ -994,6 +1255,38 @@ void xccdf_session_set_custom_oval_files(struct xccdf_session *session, char **o
 	session->oval.custom_resources = resources;
 }
 
+/*
+ * Download the remote OVAL files referenced from XCCDF at once, before
+ * they are loaded one by one.
+ */
+static void _xccdf_session_prefetch_oval(struct xccdf_session *session, struct oscap_file_entry_list *files)
+{
+	struct oscap_file_entry_iterator *files_it = oscap_file_entry_list_get_files(files);
+	const char **urls = NULL;
+	size_t count = 0;
+
+	while (oscap_file_entry_iterator_has_more(files_it)) {
+		struct oscap_file_entry *file_entry = (struct oscap_file_entry *) oscap_file_entry_iterator_next(files_it);
+		const char *file_path = oscap_file_entry_get_file(file_entry);
+
+		if (strcmp(oscap_file_entry_get_system(file_entry), oval_sysname) != 0
+		    || !oscap_acquire_url_is_supported(file_path))
+			continue;
+		// components of the data stream are downloaded by the ds session
+		if (xccdf_session_get_ds_sds_session(session) != NULL &&
+		    ds_sds_session_get_component_by_href(xccdf_session_get_ds_sds_session(session), file_path) != NULL)
+			continue;
+
+		urls = realloc(urls, (count + 1) * sizeof(char *));
+		urls[count++] = file_path;
+	}
+	oscap_file_entry_iterator_free(files_it);
+
+	if (count > 1)
+		oscap_acquire_url_prefetch(urls, count);
+	free(urls);
+}
+
 static int _xccdf_session_get_oval_from_model(struct xccdf_session *session)
 {
 	struct oval_content_resource **resources = NULL;
@@ -1016,6 +1309,8 @@ static int _xccdf_session_get_oval_from_model(struct xccdf_session *session)
 	resources[idx] = NULL;
 
 	files = xccdf_policy_model_get_systems_and_files(session->xccdf.policy_model);
+	if (session->oval.fetch_remote_resources)
+		_xccdf_session_prefetch_oval(session, files);
 	files_it = oscap_file_entry_list_get_files(files);
 	while (oscap_file_entry_iterator_has_more(files_it)) {
 		struct oscap_file_entry *file_entry;
@@ -1048,6 +1343,7 @@ static int _xccdf_session_get_oval_from_model(struct xccdf_session *session)
 		} else {
 			if (stat(tmp_path, &sb) == 0) {
 				source = oscap_source_new_from_file(tmp_path);
+				oscap_source_set_dict(source, session->dict);
 				source_owned = true;
 			}
 		}
@@ -1154,20 +1450,28 @@ int xccdf_session_load_oval(struct xccdf_session *session)
 	 * or if full validation was explicitly requested.
 	 */
 	if (session->validate && (!xccdf_session_is_sds(session) || session->full_validation)) {
-		for (int idx=0; contents[idx]; idx++) {
-			if (oscap_source_validate(contents[idx]->source, _reporter, NULL) != 0) {
-				oscap_seterr(OSCAP_EFAMILY_OSCAP, "Invalid %s (%s) content in %s",
-						oscap_document_type_to_string(oscap_source_get_scap_type(session->source)),
-						oscap_source_get_schema_version(session->source),
-						contents[idx]->href);
-				return 1;
-			}
+		size_t count = 0;
+		while (contents[count])
+			count++;
+		struct oscap_source **sources = malloc(count * sizeof(struct oscap_source *));
+		for (size_t idx = 0; idx < count; idx++)
+			sources[idx] = contents[idx]->source;
+		size_t invalid = oscap_source_validate_all(sources, count, _reporter, NULL);
+		free(sources);
+		if (invalid < count) {
+			oscap_seterr(OSCAP_EFAMILY_OSCAP, "Invalid %s (%s) content in %s",
+					oscap_document_type_to_string(oscap_source_get_scap_type(session->source)),
+					oscap_source_get_schema_version(session->source),
+					contents[invalid]->href);
+			return 1;
 		}
 	}
 
 	for (int idx=0; contents[idx]; idx++) {
 		/* file -> def_model */
-		struct oval_definition_model *tmp_def_model = oval_definition_model_import_source(contents[idx]->source);
+		struct oval_definition_model *tmp_def_model = session->oval.lazy_loading ?
+			oval_definition_model_import_source_deferred(contents[idx]->source) :
+			oval_definition_model_import_source(contents[idx]->source);
 		if (tmp_def_model == NULL) {
 			oscap_seterr(OSCAP_EFAMILY_OSCAP, "Failed to create OVAL definition model from: '%s'.",
 				oscap_source_readable_origin(contents[idx]->source));
@@ -1195,6 +1499,10 @@ int xccdf_session_load_oval(struct xccdf_session *session)
 							OVAL_DIRECTIVE_CONTENT_THIN);
 		}
 
+		/* share collected objects with the other OVAL components */
+		oval_agent_set_object_cache(tmp_sess, session->oval.object_cache);
+		oval_agent_set_referenced_entities_only(tmp_sess, session->oval.referenced_entities_only);
+
 		/* store our name in the generated documents */
 		oval_agent_set_product_name(tmp_sess, session->oval.product_cpe != NULL ?
 				session->oval.product_cpe : (char *) oscap_productname);
@@ -1330,13 +1638,131 @@ int xccdf_session_load_tailoring(struct xccdf_session *session)
 	return xccdf_policy_model_set_tailoring(session->xccdf.policy_model, tailoring) ? 0 : 1;
 }
 
-int xccdf_session_evaluate(struct xccdf_session *session)
+/* Collect names of the OVAL definitions referenced by the check, per href.
+ * Files referenced without a name or by a multi-check are needed whole. */
+static void _xccdf_session_collect_oval_refs(const struct xccdf_check *check, struct oscap_htable *names, struct oscap_htable *whole)
 {
-	struct xccdf_policy *policy = xccdf_session_get_xccdf_policy(session);
-	if (policy == NULL) {
-		oscap_seterr(OSCAP_EFAMILY_OSCAP, "Cannot build xccdf_policy.");
-		return 1;
+	if (xccdf_check_get_complex(check)) {
+		struct xccdf_check_iterator *child_it = xccdf_check_get_children(check);
+		while (xccdf_check_iterator_has_more(child_it))
+			_xccdf_session_collect_oval_refs(xccdf_check_iterator_next(child_it), names, whole);
+		xccdf_check_iterator_free(child_it);
+		return;
+	}
+
+	if (oscap_strcmp(xccdf_check_get_system(check), oval_sysname) != 0)
+		return;
+
+	struct xccdf_check_content_ref_iterator *ref_it = xccdf_check_get_content_refs(check);
+	while (xccdf_check_content_ref_iterator_has_more(ref_it)) {
+		struct xccdf_check_content_ref *ref = xccdf_check_content_ref_iterator_next(ref_it);
+		const char *href = xccdf_check_content_ref_get_href(ref);
+		const char *name = xccdf_check_content_ref_get_name(ref);
+
+		if (href == NULL)
+			continue;
+		if (name == NULL || xccdf_check_get_multicheck(check)) {
+			oscap_htable_add(whole, href, (void *) true);
+			continue;
+		}
+
+		struct oscap_stringlist *list = oscap_htable_get(names, href);
+		if (list == NULL) {
+			list = oscap_stringlist_new();
+			oscap_htable_add(names, href, list);
+		}
+		oscap_stringlist_add_string(list, name);
+	}
+	xccdf_check_content_ref_iterator_free(ref_it);
+}
+
+static void _xccdf_session_collect_selected_oval_refs(struct xccdf_policy *policy, struct xccdf_item *item, bool parent_selected,
+						      struct oscap_htable *names, struct oscap_htable *whole)
+{
+	const char *id = xccdf_item_get_id(item);
+	bool is_selected = parent_selected && xccdf_policy_is_item_selected(policy, id);
+
+	/* the checks of the rules which aren't applicable are never evaluated,
+	 * a group which isn't applicable is skipped as a whole */
+	if (!xccdf_policy_model_item_is_applicable(policy->model, item))
+		return;
+
+	if (xccdf_item_get_type(item) == XCCDF_GROUP) {
+		struct xccdf_item_iterator *child_it = xccdf_group_get_content((const struct xccdf_group *) item);
+		while (xccdf_item_iterator_has_more(child_it))
+			_xccdf_session_collect_selected_oval_refs(policy, xccdf_item_iterator_next(child_it), is_selected, names, whole);
+		xccdf_item_iterator_free(child_it);
+		return;
+	}
+
+	if (xccdf_item_get_type(item) != XCCDF_RULE)
+		return;
+	if (oscap_htable_get(policy->skip_rules, id) != NULL)
+		return;
+	/* the rules given by the user are evaluated regardless of the selection */
+	if (oscap_htable_itemcount(policy->rules) > 0)
+		is_selected = oscap_htable_get(policy->rules, id) != NULL;
+	if (!is_selected)
+		return;
+
+	struct xccdf_check_iterator *check_it = xccdf_rule_get_checks((struct xccdf_rule *) item);
+	while (xccdf_check_iterator_has_more(check_it))
+		_xccdf_session_collect_oval_refs(xccdf_check_iterator_next(check_it), names, whole);
+	xccdf_check_iterator_free(check_it);
+}
+
+/* Collect the OVAL definitions used by the applicable rules selected in the policy */
+static void _xccdf_session_plan_oval_refs(struct xccdf_session *session, struct xccdf_policy *policy,
+					  struct oscap_htable *names, struct oscap_htable *whole)
+{
+	struct xccdf_benchmark *benchmark = xccdf_policy_model_get_benchmark(session->xccdf.policy_model);
+
+	struct xccdf_item_iterator *item_it = xccdf_benchmark_get_content(benchmark);
+	while (xccdf_item_iterator_has_more(item_it))
+		_xccdf_session_collect_selected_oval_refs(policy, xccdf_item_iterator_next(item_it), true, names, whole);
+	xccdf_item_iterator_free(item_it);
+}
+
+/* Build the OVAL definitions used by the rules selected in the policy */
+static int _xccdf_session_load_oval_definitions(struct xccdf_session *session, struct oscap_htable *names, struct oscap_htable *whole)
+{
+	int ret = 0;
+
+	for (int i = 0; ret == 0 && session->oval.agents[i]; i++) {
+		const char *href = oval_agent_get_filename(session->oval.agents[i]);
+		struct oval_definition_model *def_model = oval_agent_get_definition_model(session->oval.agents[i]);
+		struct oscap_stringlist *list = oscap_htable_get(names, href);
+
+		if (oscap_htable_get(whole, href) != NULL)
+			ret = oval_definition_model_load_definitions(def_model, NULL);
+		else if (list != NULL)
+			ret = oval_definition_model_load_definitions(def_model, list);
+		if (ret != 0)
+			oscap_seterr(OSCAP_EFAMILY_OSCAP, "Failed to load OVAL definitions from: '%s'.", href);
 	}
+
+	return ret;
+}
+
+/* Probe the objects of all the OVAL definitions used by the selected rules
+ * before the first rule is evaluated, so the probes get all the requests of
+ * a file at once instead of one definition at a time. The items are kept in
+ * the agent sessions, a failure here is reported again by the evaluation. */
+static void _xccdf_session_collect_oval_objects(struct xccdf_session *session, struct oscap_htable *names, struct oscap_htable *whole)
+{
+	for (int i = 0; session->oval.agents[i]; i++) {
+		const char *href = oval_agent_get_filename(session->oval.agents[i]);
+		struct oscap_stringlist *list = oscap_htable_get(names, href);
+
+		if (oscap_htable_get(whole, href) != NULL)
+			oval_agent_collect_definitions(session->oval.agents[i], NULL);
+		else if (list != NULL)
+			oval_agent_collect_definitions(session->oval.agents[i], list);
+	}
+}
+
+static void _xccdf_session_add_policy_rules(struct xccdf_session *session, struct xccdf_policy *policy)
+{
 	struct oscap_iterator *it = oscap_iterator_new(session->rules);
 	while (oscap_iterator_has_more(it)) {
 		const char *rule_id = oscap_iterator_next(it);
@@ -1349,35 +1775,143 @@ int xccdf_session_evaluate(struct xccdf_session *session)
 		oscap_htable_add(policy->skip_rules, rule_id, (void *)true);
 	}
 	oscap_iterator_free(sit);
+}
 
-	session->xccdf.result = xccdf_policy_evaluate(policy);
-	if (session->xccdf.result == NULL)
-		return 1;
+/* Evaluate the policy and write the results into its XCCDF Test Result model */
+static struct xccdf_result *_xccdf_session_evaluate_policy(struct xccdf_session *session, struct xccdf_policy *policy, float *base_score)
+{
+	struct xccdf_result *result = xccdf_policy_evaluate(policy);
+	if (result == NULL)
+		return NULL;
 
-	/* Write results into XCCDF Test Result model */
-	xccdf_result_set_benchmark_uri(session->xccdf.result, oscap_source_readable_origin(session->source));
+	xccdf_result_set_benchmark_uri(result, oscap_source_readable_origin(session->source));
 	struct oscap_text *title = oscap_text_new();
 	oscap_text_set_text(title, "OSCAP Scan Result");
-	xccdf_result_add_title(session->xccdf.result, title);
+	xccdf_result_add_title(result, title);
 	struct xccdf_benchmark *benchmark = xccdf_policy_get_benchmark(policy);
-	xccdf_result_set_version(session->xccdf.result,
+	xccdf_result_set_version(result,
 			benchmark != NULL ? xccdf_benchmark_get_version(benchmark) : NULL);
 
-	xccdf_result_fill_sysinfo(session->xccdf.result);
+	xccdf_result_fill_sysinfo(result);
 
-	struct xccdf_model_iterator *model_it = xccdf_benchmark_get_models(xccdf_policy_model_get_benchmark(session->xccdf.policy_model));
+	/* all the scores are computed by a single traversal of the benchmark */
+	benchmark = xccdf_policy_model_get_benchmark(session->xccdf.policy_model);
+	struct xccdf_score_totals *totals = xccdf_result_score_totals_new(result, (struct xccdf_item *) benchmark);
+	struct xccdf_model_iterator *model_it = xccdf_benchmark_get_models(benchmark);
 	while (xccdf_model_iterator_has_more(model_it)) {
 		struct xccdf_model *model = xccdf_model_iterator_next(model_it);
 		const char *score_model = xccdf_model_get_system(model);
-		struct xccdf_score *score = xccdf_policy_get_score(policy, session->xccdf.result, score_model);
-		xccdf_result_add_score(session->xccdf.result, score);
+		struct xccdf_score *score = xccdf_score_totals_get_score(totals, score_model);
+		xccdf_result_add_score(result, score);
 
 		/* record default base score for later use */
-		if (!strcmp(score_model, "urn:xccdf:scoring:default"))
-			session->xccdf.base_score = xccdf_score_get_score(score);
+		if (base_score != NULL && !strcmp(score_model, "urn:xccdf:scoring:default"))
+			*base_score = xccdf_score_get_score(score);
 	}
 	xccdf_model_iterator_free(model_it);
-	return 0;
+	xccdf_score_totals_free(totals);
+	return result;
+}
+
+static int _xccdf_session_evaluate(struct xccdf_session *session)
+{
+	struct xccdf_policy *policy = xccdf_session_get_xccdf_policy(session);
+	if (policy == NULL) {
+		oscap_seterr(OSCAP_EFAMILY_OSCAP, "Cannot build xccdf_policy.");
+		return 1;
+	}
+
+	/* The extra profiles are evaluated by their own policies over the same
+	 * checking engines, so the objects collected for one of them are reused
+	 * by the others and only the evaluation is repeated. */
+	struct oscap_list *policies = oscap_list_new();
+	oscap_list_add(policies, policy);
+	struct oscap_iterator *pit = oscap_iterator_new(session->xccdf.extra_profile_ids);
+	while (oscap_iterator_has_more(pit)) {
+		const char *profile_id = oscap_iterator_next(pit);
+		struct xccdf_policy *extra_policy = xccdf_policy_model_get_policy_by_id(session->xccdf.policy_model, profile_id);
+		if (extra_policy == NULL) {
+			oscap_seterr(OSCAP_EFAMILY_OSCAP, "Cannot build xccdf_policy for profile '%s'.", profile_id);
+			oscap_iterator_free(pit);
+			oscap_list_free0(policies);
+			return 1;
+		}
+		if (extra_policy != policy)
+			oscap_list_add(policies, extra_policy);
+	}
+	oscap_iterator_free(pit);
+
+	struct oscap_profiling_mark mark;
+	oscap_profiling_start(&mark);
+	struct oscap_iterator *it = oscap_iterator_new(policies);
+	while (oscap_iterator_has_more(it)) {
+		struct xccdf_policy *cur_policy = oscap_iterator_next(it);
+		_xccdf_session_add_policy_rules(session, cur_policy);
+		/* prune the groups which aren't applicable before any object is collected */
+		xccdf_policy_resolve_applicability(cur_policy);
+	}
+	oscap_iterator_free(it);
+	oscap_profiling_stop(&mark, OSCAP_PROFILING_PHASE, "cpe", NULL, 0);
+
+	if (session->oval.agents != NULL) {
+		struct oscap_htable *names = oscap_htable_new();
+		struct oscap_htable *whole = oscap_htable_new();
+		int ret = 0;
+
+		it = oscap_iterator_new(policies);
+		while (oscap_iterator_has_more(it))
+			_xccdf_session_plan_oval_refs(session, oscap_iterator_next(it), names, whole);
+		oscap_iterator_free(it);
+		if (session->oval.lazy_loading)
+			ret = _xccdf_session_load_oval_definitions(session, names, whole);
+		if (ret == 0) {
+			oscap_profiling_start(&mark);
+			_xccdf_session_collect_oval_objects(session, names, whole);
+			oscap_profiling_stop(&mark, OSCAP_PROFILING_PHASE, "collect", NULL, 0);
+		}
+
+		oscap_htable_free(names, (oscap_destruct_func) oscap_stringlist_free);
+		oscap_htable_free0(whole);
+		if (ret != 0) {
+			oscap_list_free0(policies);
+			return 1;
+		}
+	}
+
+	oscap_list_free0(session->xccdf.extra_results);
+	session->xccdf.extra_results = oscap_list_new();
+
+	int ret = 0;
+	it = oscap_iterator_new(policies);
+	while (ret == 0 && oscap_iterator_has_more(it)) {
+		struct xccdf_policy *cur_policy = oscap_iterator_next(it);
+		struct xccdf_result *result;
+
+		if (cur_policy == policy) {
+			result = session->xccdf.result = _xccdf_session_evaluate_policy(session, policy, &session->xccdf.base_score);
+		} else {
+			result = _xccdf_session_evaluate_policy(session, cur_policy, NULL);
+			if (result != NULL)
+				oscap_list_add(session->xccdf.extra_results, result);
+		}
+		if (result == NULL)
+			ret = 1;
+	}
+	oscap_iterator_free(it);
+	oscap_list_free0(policies);
+	return ret;
+}
+
+int xccdf_session_evaluate(struct xccdf_session *session)
+{
+	struct oscap_profiling_mark mark;
+	int ret;
+
+	oscap_profiling_start(&mark);
+	ret = _xccdf_session_evaluate(session);
+	oscap_profiling_stop(&mark, OSCAP_PROFILING_PHASE, "evaluate", NULL, 0);
+
+	return ret;
 }
 
 static size_t _paramlist_size(const char **p) { size_t s = 0; if (!p) return s; while (p[s]) s += 2; return s; }
@@ -1427,6 +1961,22 @@ static inline int _xccdf_gen_report(struct oscap_source *infile, const char *id,
 	return _app_xslt(infile, "xccdf-report.xsl", outfile, params);
 }
 
+/* Add the results of the extra profiles before the result of the selected
+ * profile, which stays the last TestResult and is used by the report. */
+static void _xccdf_session_add_extra_results(struct xccdf_session *session, struct xccdf_benchmark *benchmark)
+{
+	struct oscap_iterator *it = oscap_iterator_new(session->xccdf.extra_results);
+	while (oscap_iterator_has_more(it)) {
+		struct xccdf_result *cloned_result = xccdf_result_clone(oscap_iterator_next(it));
+		if (xccdf_session_is_sds(session)) {
+			struct ds_sds_session *sds_session = xccdf_session_get_ds_sds_session(session);
+			xccdf_result_set_benchmark_uri(cloned_result, ds_sds_session_get_checklist_uri(sds_session));
+		}
+		xccdf_benchmark_add_result(benchmark, cloned_result);
+	}
+	oscap_iterator_free(it);
+}
+
 static int _build_xccdf_result_source(struct xccdf_session *session)
 {
 	if (session->xccdf.result_source != NULL) {
@@ -1445,6 +1995,7 @@ static int _build_xccdf_result_source(struct xccdf_session *session)
 
 		if (session->export.xccdf_file != NULL) {
 			struct xccdf_benchmark *cloned_benchmark = xccdf_benchmark_clone(benchmark);
+			_xccdf_session_add_extra_results(session, cloned_benchmark);
 			struct xccdf_result *cloned_result = xccdf_result_clone(session->xccdf.result);
 			xccdf_benchmark_add_result(cloned_benchmark, cloned_result);
 			struct oscap_source *xccdf_result_source = xccdf_benchmark_export_source(cloned_benchmark, session->export.xccdf_file);
@@ -1476,6 +2027,7 @@ static int _build_xccdf_result_source(struct xccdf_session *session)
 			oscap_source_free(stig_result);
 		}
 
+		_xccdf_session_add_extra_results(session, benchmark);
 		struct xccdf_result *cloned_result = xccdf_result_clone(session->xccdf.result);
 		if (xccdf_session_is_sds(session)) {
 			struct ds_sds_session *sds_session = xccdf_session_get_ds_sds_session(session);
@@ -1707,7 +2259,7 @@ static int _build_oval_result_sources(struct xccdf_session *session)
 	return 0;
 }
 
-int xccdf_session_export_oval(struct xccdf_session *session)
+static int _xccdf_session_export_oval(struct xccdf_session *session)
 {
 	if (_build_oval_result_sources(session) != 0) {
 		return 1;
@@ -1760,6 +2312,18 @@ int xccdf_session_export_oval(struct xccdf_session *session)
 	return 0;
 }
 
+int xccdf_session_export_oval(struct xccdf_session *session)
+{
+	struct oscap_profiling_mark mark;
+	int ret;
+
+	oscap_profiling_start(&mark);
+	ret = _xccdf_session_export_oval(session);
+	oscap_profiling_stop(&mark, OSCAP_PROFILING_PHASE, "export", NULL, 0);
+
+	return ret;
+}
+
 int xccdf_session_export_check_engine_plugins(struct xccdf_session *session)
 {
 	if (!session->export.check_engine_plugins_results)
@@ -1786,7 +2350,12 @@ int xccdf_session_export_check_engine_plugins(struct xccdf_session *session)
 
 int xccdf_session_export_arf(struct xccdf_session *session)
 {
-	if (session->export.arf_file != NULL) {
+	if (session->export.arf_file != NULL && session->export.arf_sds_reference) {
+		if (xccdf_session_write_arf_sds_reference(session) != 0)
+			return 1;
+		if (session->full_validation)
+			return _xccdf_session_validate_file(session->export.arf_file);
+	} else if (session->export.arf_file != NULL) {
 		struct oscap_source* arf_source = xccdf_session_create_arf_source(session);
 		if (arf_source == NULL) {
 			return 1;
@@ -1807,6 +2376,199 @@ int xccdf_session_export_arf(struct xccdf_session *session)
 	return 0;
 }
 
+static void _jsonl_string(FILE *fp, const char *str)
+{
+	if (str == NULL) {
+		fputs("null", fp);
+		return;
+	}
+	fputc('"', fp);
+	for (; *str != '\0'; ++str) {
+		unsigned char c = (unsigned char)*str;
+
+		if (c == '"' || c == '\\')
+			fprintf(fp, "\\%c", c);
+		else if (c < 0x20)
+			fprintf(fp, "\\u%04x", c);
+		else
+			fputc(c, fp);
+	}
+	fputc('"', fp);
+}
+
+static void _jsonl_export_rule_result(FILE *fp, struct xccdf_rule_result *rule_result)
+{
+	fputs("{\"type\":\"rule\",\"rule\":", fp);
+	_jsonl_string(fp, xccdf_rule_result_get_idref(rule_result));
+	fputs(",\"result\":", fp);
+	_jsonl_string(fp, xccdf_test_result_type_get_text(xccdf_rule_result_get_result(rule_result)));
+	fputs(",\"time\":", fp);
+	_jsonl_string(fp, xccdf_rule_result_get_time(rule_result));
+
+	/* the checks refer to the OVAL definitions written below by their names */
+	fputs(",\"checks\":[", fp);
+	bool first = true;
+	struct xccdf_check_iterator *checks = xccdf_rule_result_get_checks(rule_result);
+	while (xccdf_check_iterator_has_more(checks)) {
+		struct xccdf_check *check = xccdf_check_iterator_next(checks);
+		struct xccdf_check_content_ref_iterator *refs = xccdf_check_get_content_refs(check);
+		while (xccdf_check_content_ref_iterator_has_more(refs)) {
+			struct xccdf_check_content_ref *ref = xccdf_check_content_ref_iterator_next(refs);
+			fputs(first ? "{\"system\":" : ",{\"system\":", fp);
+			_jsonl_string(fp, xccdf_check_get_system(check));
+			fputs(",\"href\":", fp);
+			_jsonl_string(fp, xccdf_check_content_ref_get_href(ref));
+			fputs(",\"name\":", fp);
+			_jsonl_string(fp, xccdf_check_content_ref_get_name(ref));
+			fputc('}', fp);
+			first = false;
+		}
+		xccdf_check_content_ref_iterator_free(refs);
+	}
+	xccdf_check_iterator_free(checks);
+	fputs("]}\n", fp);
+}
+
+static void _jsonl_export_sysitem(FILE *fp, const char *oval_file, struct oval_sysitem *item)
+{
+	fputs("{\"type\":\"item\",\"oval\":", fp);
+	_jsonl_string(fp, oval_file);
+	fputs(",\"id\":", fp);
+	_jsonl_string(fp, oval_sysitem_get_id(item));
+	fprintf(fp, ",\"name\":\"%s_item\",\"status\":", oval_subtype_get_text(oval_sysitem_get_subtype(item)));
+	_jsonl_string(fp, oval_syschar_status_get_text(oval_sysitem_get_status(item)));
+
+	/* [name, value] pairs, an entity may repeat */
+	fputs(",\"entities\":[", fp);
+	struct oval_sysent_iterator *sysents = oval_sysitem_get_sysents(item);
+	for (bool first = true; oval_sysent_iterator_has_more(sysents); first = false) {
+		struct oval_sysent *sysent = oval_sysent_iterator_next(sysents);
+		fputs(first ? "[" : ",[", fp);
+		_jsonl_string(fp, oval_sysent_get_name(sysent));
+		fputc(',', fp);
+		if (oval_sysent_get_mask(sysent) || oval_sysent_get_status(sysent) != SYSCHAR_STATUS_EXISTS)
+			fputs("null", fp);
+		else
+			_jsonl_string(fp, oval_sysent_get_value(sysent));
+		fputc(']', fp);
+	}
+	oval_sysent_iterator_free(sysents);
+	fputs("]}\n", fp);
+}
+
+static void _jsonl_export_oval_system(FILE *fp, const char *oval_file, struct oval_result_system *sys, bool with_items)
+{
+	struct oval_result_definition_iterator *definitions = oval_result_system_get_definitions(sys);
+	while (oval_result_definition_iterator_has_more(definitions)) {
+		struct oval_result_definition *definition = oval_result_definition_iterator_next(definitions);
+		oval_result_t result = oval_result_definition_get_result(definition);
+
+		if (result == OVAL_RESULT_NOT_EVALUATED)
+			continue;
+		fputs("{\"type\":\"definition\",\"oval\":", fp);
+		_jsonl_string(fp, oval_file);
+		fputs(",\"id\":", fp);
+		_jsonl_string(fp, oval_result_definition_get_id(definition));
+		fputs(",\"result\":", fp);
+		_jsonl_string(fp, oval_result_get_text(result));
+		fputs("}\n", fp);
+	}
+	oval_result_definition_iterator_free(definitions);
+
+	/* the tests refer to their items by ID, each item is written once after them */
+	struct oscap_htable *written = oscap_htable_new();
+	struct oscap_list *items = oscap_list_new();
+	struct oval_result_test_iterator *tests = oval_result_system_get_tests(sys);
+	while (oval_result_test_iterator_has_more(tests)) {
+		struct oval_result_test *test = oval_result_test_iterator_next(tests);
+
+		fputs("{\"type\":\"test\",\"oval\":", fp);
+		_jsonl_string(fp, oval_file);
+		fputs(",\"id\":", fp);
+		_jsonl_string(fp, oval_test_get_id(oval_result_test_get_test(test)));
+		fputs(",\"result\":", fp);
+		_jsonl_string(fp, oval_result_get_text(oval_result_test_get_result(test)));
+		fputs(",\"items\":[", fp);
+		struct oval_result_item_iterator *ritems = oval_result_test_get_items(test);
+		for (bool first = true; oval_result_item_iterator_has_more(ritems); first = false) {
+			struct oval_sysitem *item = oval_result_item_get_sysitem(oval_result_item_iterator_next(ritems));
+			const char *item_id = oval_sysitem_get_id(item);
+
+			if (!first)
+				fputc(',', fp);
+			_jsonl_string(fp, item_id);
+			if (with_items && oscap_htable_add(written, item_id, item))
+				oscap_list_add(items, item);
+		}
+		oval_result_item_iterator_free(ritems);
+		fputs("]}\n", fp);
+	}
+	oval_result_test_iterator_free(tests);
+
+	struct oscap_iterator *it = oscap_iterator_new(items);
+	while (oscap_iterator_has_more(it))
+		_jsonl_export_sysitem(fp, oval_file, oscap_iterator_next(it));
+	oscap_iterator_free(it);
+	oscap_list_free0(items);
+	oscap_htable_free0(written);
+}
+
+int xccdf_session_export_results_jsonl(struct xccdf_session *session)
+{
+	if (session->export.results_jsonl_file == NULL)
+		return 0;
+	if (session->xccdf.result == NULL) {
+		oscap_seterr(OSCAP_EFAMILY_OSCAP, "No XCCDF results to export.");
+		return 1;
+	}
+
+	bool to_stdout = strcmp(session->export.results_jsonl_file, "-") == 0;
+	FILE *fp = to_stdout ? stdout : fopen(session->export.results_jsonl_file, "w");
+	if (fp == NULL) {
+		oscap_seterr(OSCAP_EFAMILY_GLIBC, "Could not open %s: %s", session->export.results_jsonl_file, strerror(errno));
+		return 1;
+	}
+
+	struct xccdf_result *result = session->xccdf.result;
+	fputs("{\"type\":\"test-result\",\"id\":", fp);
+	_jsonl_string(fp, xccdf_result_get_id(result));
+	fputs(",\"benchmark\":", fp);
+	_jsonl_string(fp, xccdf_result_get_benchmark_uri(result));
+	fputs(",\"profile\":", fp);
+	_jsonl_string(fp, xccdf_result_get_profile(result));
+	fputs(",\"start\":", fp);
+	_jsonl_string(fp, xccdf_result_get_start_time(result));
+	fputs(",\"end\":", fp);
+	_jsonl_string(fp, xccdf_result_get_end_time(result));
+	fputs("}\n", fp);
+
+	struct xccdf_rule_result_iterator *rule_results = xccdf_result_get_rule_results(result);
+	while (xccdf_rule_result_iterator_has_more(rule_results)) {
+		struct xccdf_rule_result *rule_result = xccdf_rule_result_iterator_next(rule_results);
+
+		if (xccdf_rule_result_get_result(rule_result) != XCCDF_RESULT_NOT_SELECTED)
+			_jsonl_export_rule_result(fp, rule_result);
+	}
+	xccdf_rule_result_iterator_free(rule_results);
+
+	for (int i = 0; session->oval.agents != NULL && session->oval.agents[i] != NULL; i++) {
+		const char *oval_file = oval_agent_get_filename(session->oval.agents[i]);
+		struct oval_results_model *res_model = oval_agent_get_results_model(session->oval.agents[i]);
+		struct oval_result_system_iterator *systems = oval_results_model_get_systems(res_model);
+		while (oval_result_system_iterator_has_more(systems))
+			_jsonl_export_oval_system(fp, oval_file, oval_result_system_iterator_next(systems),
+					!session->export.without_sys_chars);
+		oval_result_system_iterator_free(systems);
+	}
+
+	int ret = 0;
+	if (ferror(fp) || (to_stdout ? fflush(fp) : fclose(fp)) != 0) {
+		oscap_seterr(OSCAP_EFAMILY_GLIBC, "Could not write %s: %s", session->export.results_jsonl_file, strerror(errno));
+		ret = 1;
+	}
+	return ret;
+}
+
 OSCAP_GENERIC_GETTER(struct xccdf_policy_model *, xccdf_session, policy_model, xccdf.policy_model)
 OSCAP_GENERIC_GETTER(float, xccdf_session, base_score, xccdf.base_score);
 
@@ -1846,9 +2608,9 @@ unsigned int xccdf_session_get_cpe_oval_agents_count(const struct xccdf_session
 	return i;
 }
 
-bool xccdf_session_contains_fail_result(const struct xccdf_session *session)
+static bool _xccdf_result_contains_fail_result(struct xccdf_result *result)
 {
-	struct xccdf_rule_result_iterator *res_it = xccdf_result_get_rule_results(session->xccdf.result);
+	struct xccdf_rule_result_iterator *res_it = xccdf_result_get_rule_results(result);
 	while (xccdf_rule_result_iterator_has_more(res_it)) {
 		struct xccdf_rule_result *res = xccdf_rule_result_iterator_next(res_it);
 		xccdf_test_result_type_t rule_result = xccdf_rule_result_get_result(res);
@@ -1863,6 +2625,19 @@ bool xccdf_session_contains_fail_result(const struct xccdf_session *session)
 	return false;
 }
 
+bool xccdf_session_contains_fail_result(const struct xccdf_session *session)
+{
+	if (_xccdf_result_contains_fail_result(session->xccdf.result))
+		return true;
+
+	bool ret = false;
+	struct oscap_iterator *it = oscap_iterator_new(session->xccdf.extra_results);
+	while (!ret && oscap_iterator_has_more(it))
+		ret = _xccdf_result_contains_fail_result(oscap_iterator_next(it));
+	oscap_iterator_free(it);
+	return ret;
+}
+
 int xccdf_session_remediate(struct xccdf_session *session)
 {
 	int res = 0;
@@ -1877,6 +2652,10 @@ int xccdf_session_remediate(struct xccdf_session *session)
 	xccdf_policy_model_unregister_engines(session->xccdf.policy_model, oval_sysname);
 	if ((res = xccdf_session_load_oval(session)) != 0)
 		return res;
+	/* Each fix may change what the previous checks collected, the checks
+	 * verifying the fixes collect their objects again */
+	for (int i = 0; session->oval.agents != NULL && session->oval.agents[i]; i++)
+		oval_agent_set_object_cache(session->oval.agents[i], NULL);
 	struct xccdf_benchmark *benchmark = xccdf_policy_get_benchmark(xccdf_session_get_xccdf_policy(session));
 	xccdf_result_set_version(session->xccdf.result,
 			benchmark != NULL ? xccdf_benchmark_get_version(benchmark) : NULL);
@@ -1972,7 +2751,7 @@ int xccdf_session_generate_guide(struct xccdf_session *session, const char *outf
 	return 0;
 }
 
-int xccdf_session_export_all(struct xccdf_session *session)
+static int _xccdf_session_export_all(struct xccdf_session *session)
 {
 	int ret = 0;
 	struct oscap_source *arf_source = NULL;
@@ -1982,17 +2761,46 @@ int xccdf_session_export_all(struct xccdf_session *session)
 		goto cleanup;
 	}
 
-	if (session->export.report_file == NULL && session->export.arf_file == NULL) {
+	if (xccdf_session_export_results_jsonl(session)) {
+		ret = 1;
 		goto cleanup;
 	}
 
-	arf_source = xccdf_session_extract_arf_source(session);
+	/* The ARF without the source data stream, the full one is built only for the report */
+	bool save_arf = session->export.arf_file != NULL;
+	if (save_arf && session->export.arf_sds_reference) {
+		if (xccdf_session_write_arf_sds_reference(session) != 0 ||
+		    (session->full_validation && _xccdf_session_validate_file(session->export.arf_file) != 0)) {
+			ret = 1;
+			goto cleanup;
+		}
+		save_arf = false;
+	}
+
+	if (session->export.report_file == NULL && !save_arf) {
+		goto cleanup;
+	}
+
+	/* Without the HTML report the ARF DOM is not needed, write it as it is assembled */
+	bool write_arf = session->export.report_file == NULL && strcmp(session->export.arf_file, "-") != 0;
+	arf_source = xccdf_session_extract_arf_source(session, write_arf);
 	if (arf_source == NULL) {
 		ret = 1;
 		goto cleanup;
 	}
 
+	if (save_arf) {
+		if (!write_arf && oscap_source_save_as(arf_source, NULL) != 0) {
+			ret = 1;
+		} else if (session->full_validation) {
+			if (oscap_source_validate(arf_source, _reporter, NULL) != 0)
+				ret = 1;
+		}
+	}
+
 	if (session->export.report_file != NULL) {
+		/* The ARF has been written, drop what the report does not use */
+		ds_rds_prune_for_report(oscap_source_get_xmlDoc(arf_source));
 		/* generate report */
 		_xccdf_gen_report(arf_source,
 				xccdf_result_get_id(session->xccdf.result),
@@ -2003,20 +2811,19 @@ int xccdf_session_export_all(struct xccdf_session *session)
 		);
 	}
 
-	if (session->export.arf_file != NULL) {
-		if (oscap_source_save_as(arf_source, NULL) != 0) {
-			ret = 1;
-			goto cleanup;
-		}
-		if (session->full_validation) {
-			if (oscap_source_validate(arf_source, _reporter, NULL) != 0) {
-				ret = 1;
-				goto cleanup;
-			}
-		}
-	}
-
 cleanup:
 	oscap_source_free(arf_source);
 	return ret;
 }
+
+int xccdf_session_export_all(struct xccdf_session *session)
+{
+	struct oscap_profiling_mark mark;
+	int ret;
+
+	oscap_profiling_start(&mark);
+	ret = _xccdf_session_export_all(session);
+	oscap_profiling_stop(&mark, OSCAP_PROFILING_PHASE, "export", NULL, 0);
+
+	return ret;
+}
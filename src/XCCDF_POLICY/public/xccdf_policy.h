@@ -72,6 +72,7 @@ struct xccdf_policy_iterator;
 typedef enum {
 	POLICY_ENGINE_QUERY_NAMES_FOR_HREF = 1,		/// Considering xccdf:check-content-ref, what are possible @name attributes for given href?
 	POLICY_ENGINE_QUERY_OVAL_DEFS_FOR_HREF = 2,	/// Considering xccdf:check-content-ref, what are OVAL definitions for given href?
+	POLICY_ENGINE_QUERY_SYSTEM_CHANGED = 3,		/// The system was changed by a fix, forget what was read from it.
 } xccdf_policy_engine_query_t;
 
 /**
@@ -84,10 +85,12 @@ typedef enum {
  * dependent on query and defined as follows:
  *  - (const char *)href -- for POLICY_ENGINE_QUERY_NAMES_FOR_HREF
  *  - (const char *)href -- for POLICY_ENGINE_QUERY_OVAL_DEFS_FOR_HREF
+ *  - NULL -- for POLICY_ENGINE_QUERY_SYSTEM_CHANGED
  *
  * Expected return type depends also on query as follows:
  *  - (struct oscap_stringlist *) -- for POLICY_ENGINE_QUERY_NAMES_FOR_HREF
  *  - (struct oscap_list *) -- for POLICY_ENGINE_QUERY_OVAL_DEFS_FOR_HREF
+ *  - NULL -- for POLICY_ENGINE_QUERY_SYSTEM_CHANGED
  *  - NULL shall be returned if the function doesn't understand the query.
  */
 typedef void *(*xccdf_policy_engine_query_fn) (void *, xccdf_policy_engine_query_t, void *);
@@ -102,6 +105,44 @@ typedef void *(*xccdf_policy_engine_query_fn) (void *, xccdf_policy_engine_query
  */
 typedef xccdf_test_result_type_t (*xccdf_policy_engine_eval_fn) (struct xccdf_policy *policy, const char *rule_id, const char *definition_id, const char *href_if, struct xccdf_value_binding_iterator *value_binding_it, struct xccdf_check_import_iterator *check_imports_it, void *user_data);
 
+/**
+ * A check handed over to an asynchronous checking engine.
+ *
+ * The engine completes the task exactly once with xccdf_policy_engine_task_complete(),
+ * the task must not be used afterwards.
+ */
+struct xccdf_policy_engine_task;
+
+/**
+ * Type of function which starts a check of an asynchronous checking engine.
+ *
+ * The function starts the evaluation and returns, the result is handed over later by
+ * xccdf_policy_engine_task_complete(), either from a thread of the engine, from the
+ * xccdf_policy_engine_poll_fn of the engine or even before this function returns.
+ * The iterators stay valid until the task is completed, the check imports may be
+ * filled in until then.
+ * @return 0 if the check was started, non-zero if it wasn't and the task won't be completed
+ */
+typedef int (*xccdf_policy_engine_eval_async_fn) (struct xccdf_policy *policy, const char *rule_id, const char *definition_id, const char *href_id, struct xccdf_value_binding_iterator *value_binding_it, struct xccdf_check_import_iterator *check_imports_it, struct xccdf_policy_engine_task *task, void *user_data);
+
+/**
+ * Type of function which lets an asynchronous checking engine make progress.
+ *
+ * It is called by the thread waiting for the checks of the engine to complete. It may
+ * complete any of the started tasks and should return after a short while even if it
+ * didn't, e.g. after a poll() of the engine's descriptors with a timeout.
+ */
+typedef void (*xccdf_policy_engine_poll_fn) (void *user_data);
+
+/**
+ * Hand over the result of a check started by an xccdf_policy_engine_eval_async_fn.
+ * It can be called from any thread. XCCDF_RESULT_NOT_CHECKED makes the policy try
+ * the next engine or check-content-ref, as with the synchronous engines.
+ * @param task the task of the check, it is freed by the policy
+ * @param result result of the check
+ */
+OSCAP_API void xccdf_policy_engine_task_complete(struct xccdf_policy_engine_task *task, xccdf_test_result_type_t result);
+
 /************************************************************/
 
 /**
@@ -239,6 +280,39 @@ OSCAP_API struct oscap_htable_iterator *xccdf_policy_model_get_cpe_oval_sessions
  */
 OSCAP_API bool xccdf_policy_model_register_engine_and_query_callback(struct xccdf_policy_model *model, char *sys, xccdf_policy_engine_eval_fn eval_fn, void *usr, xccdf_policy_engine_query_fn query_fn);
 
+/**
+ * Register an asynchronous checking engine for the checking system.
+ *
+ * The policy keeps up to max_in_flight checks of the engine started at once and
+ * reports the rules in document order once their checks are completed. The checks of
+ * complex checks and multi-checks, and of the checking systems which also have
+ * synchronous engines registered, are started one at a time and waited for.
+ * @param model XCCDF Policy Model
+ * @param sys String representing given checking system
+ * @param eval_fn function starting a check
+ * @param poll_fn optional function called while waiting for the checks to complete,
+ * NULL if the engine completes them from its own threads
+ * @param usr optional parameter for passing user data to the functions
+ * @param query_fn optional xccdf_policy_engine_query_fn implementation for given system
+ * @param max_in_flight maximum number of checks started at once, at least 1
+ * @memberof xccdf_policy_model
+ * @return true if the engine was registered successfully, false otherwise
+ */
+OSCAP_API bool xccdf_policy_model_register_async_engine(struct xccdf_policy_model *model, char *sys, xccdf_policy_engine_eval_async_fn eval_fn, xccdf_policy_engine_poll_fn poll_fn, void *usr, xccdf_policy_engine_query_fn query_fn, unsigned int max_in_flight);
+
+/**
+ * Declare that the checking engines registered for the given checking system can evaluate
+ * several checks at once, i.e. their eval_fn can be called by concurrent threads.
+ * Such checks are evaluated in parallel by xccdf_policy_evaluate when the OSCAP_XCCDF_EVAL_JOBS
+ * environment variable is set to more than 1, the rule results are reported in document order.
+ * @param model XCCDF Policy Model
+ * @param sys String representing given checking system
+ * @param thread_safe true if the engines are thread-safe
+ * @memberof xccdf_policy_model
+ * @return true if an engine is registered for the checking system, false otherwise
+ */
+OSCAP_API bool xccdf_policy_model_set_engine_thread_safe(struct xccdf_policy_model *model, const char *sys, bool thread_safe);
+
 typedef int (*policy_reporter_output)(struct xccdf_rule_result *, void *);
 
 /**
@@ -30,6 +30,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <pthread.h>
 
 #include "xccdf_policy_priv.h"
 #include "xccdf_policy_model_priv.h"
@@ -51,10 +52,13 @@
 #include "common/list.h"
 #include "common/_error.h"
 #include "common/debug_priv.h"
+#include "common/profiling_priv.h"
 #include "common/text_priv.h"
 #include "XCCDF/result_scoring_priv.h"
 #include "xccdf_policy_resolve.h"
 #include "oscap_helpers.h"
+#include "common/oscap_threadpool.h"
+#include "common/trace_priv.h"
 
 /* Macros to generate iterators, getters and setters */
 OSCAP_GETTER(struct xccdf_benchmark *, xccdf_policy_model, benchmark)
@@ -131,7 +135,54 @@ static struct oscap_iterator *_xccdf_policy_get_engines_by_sysname(struct xccdf_
 	return oscap_iterator_new_filter(policy->model->engines, (oscap_filter_func) xccdf_policy_engine_filter, (void *) sysname);
 }
 
-char *xccdf_policy_get_readable_item_title(struct xccdf_policy *policy, struct xccdf_item *item, const char *preferred_lang)
+/**
+ * Get the cache of readable texts of the policy, it is emptied when the profile
+ * gets a setvalue or refine-value which could change the substituted values.
+ */
+static struct oscap_htable *_xccdf_policy_get_readable_texts(struct xccdf_policy *policy)
+{
+	xccdf_policy_index_values(policy);
+	if (policy->readable_texts != NULL &&
+	    policy->readable_texts_setvalues == policy->setvalues_indexed &&
+	    policy->readable_texts_refine_values == policy->refine_values_indexed)
+		return policy->readable_texts;
+
+	oscap_htable_free(policy->readable_texts, free);
+	policy->readable_texts = oscap_htable_new();
+	policy->readable_texts_setvalues = policy->setvalues_indexed;
+	policy->readable_texts_refine_values = policy->refine_values_indexed;
+	return policy->readable_texts;
+}
+
+typedef char *(*xccdf_policy_readable_text_func)(struct xccdf_policy *, struct xccdf_item *, const char *);
+
+/* Resolve the text of the item once for each language, the caller gets its own copy */
+static char *_xccdf_policy_get_readable_text(struct xccdf_policy *policy, struct xccdf_item *item, const char *preferred_lang,
+					     const char *kind, xccdf_policy_readable_text_func resolve)
+{
+	const char *id = xccdf_item_get_id(item);
+	if (policy == NULL || id == NULL)
+		return resolve(policy, item, preferred_lang);
+
+	struct oscap_htable *texts = _xccdf_policy_get_readable_texts(policy);
+	char *key = oscap_sprintf("%s %s %s", kind, preferred_lang != NULL ? preferred_lang : "", id);
+	const char *cached = oscap_htable_get(texts, key);
+	if (cached != NULL) {
+		free(key);
+		return oscap_strdup(cached);
+	}
+
+	char *resolved = resolve(policy, item, preferred_lang);
+	if (resolved != NULL) {
+		char *copy = oscap_strdup(resolved);
+		if (!oscap_htable_add(texts, key, copy))
+			free(copy);
+	}
+	free(key);
+	return resolved;
+}
+
+static char *_xccdf_policy_resolve_item_title(struct xccdf_policy *policy, struct xccdf_item *item, const char *preferred_lang)
 {
 	struct oscap_text_iterator *title_it = xccdf_item_get_title(item);
 	char *unresolved = oscap_textlist_get_preferred_plaintext(title_it, preferred_lang);
@@ -143,7 +194,7 @@ char *xccdf_policy_get_readable_item_title(struct xccdf_policy *policy, struct x
 	return resolved;
 }
 
-char *xccdf_policy_get_readable_item_description(struct xccdf_policy *policy, struct xccdf_item *item, const char *preferred_lang)
+static char *_xccdf_policy_resolve_item_description(struct xccdf_policy *policy, struct xccdf_item *item, const char *preferred_lang)
 {
 	/* Get description in prefered language */
 	struct oscap_text_iterator *description_it = xccdf_item_get_description(item);
@@ -160,6 +211,43 @@ char *xccdf_policy_get_readable_item_description(struct xccdf_policy *policy, st
 	return plaintext;
 }
 
+char *xccdf_policy_get_readable_item_title(struct xccdf_policy *policy, struct xccdf_item *item, const char *preferred_lang)
+{
+	return _xccdf_policy_get_readable_text(policy, item, preferred_lang, "title", _xccdf_policy_resolve_item_title);
+}
+
+char *xccdf_policy_get_readable_item_description(struct xccdf_policy *policy, struct xccdf_item *item, const char *preferred_lang)
+{
+	return _xccdf_policy_get_readable_text(policy, item, preferred_lang, "description", _xccdf_policy_resolve_item_description);
+}
+
+typedef const char *(*xccdf_policy_index_key_func)(const void *);
+
+/**
+ * Map the IDs of the items refined by the entries of a profile list to the
+ * last entry for each of them. The index is kept while the list doesn't grow.
+ */
+static struct oscap_htable *_xccdf_policy_index_profile_list(struct oscap_htable *index, int *indexed,
+							     struct oscap_list *list, xccdf_policy_index_key_func get_item)
+{
+	int count = oscap_list_get_itemcount(list);
+	if (index != NULL && *indexed == count)
+		return index;
+
+	oscap_htable_free0(index);
+	index = oscap_htable_new();
+	void *entry;
+	OSCAP_LIST_FOREACH(entry, list) {
+		const char *id = get_item(entry);
+		if (id == NULL)
+			continue;
+		oscap_htable_detach(index, id);
+		oscap_htable_add(index, id, entry);
+	}
+	*indexed = count;
+	return index;
+}
+
 /**
  * Get last setvalue from policy that match specified id
  */
@@ -172,9 +260,7 @@ static struct xccdf_setvalue * xccdf_policy_get_setvalue(struct xccdf_policy * p
     if (id == NULL) return NULL;
     if (policy == NULL) return NULL;
 
-    struct xccdf_setvalue_iterator  * s_value_it;
-    struct xccdf_setvalue           * s_value;
-    struct xccdf_profile            * profile = xccdf_policy_get_profile(policy);;
+    struct xccdf_profile            * profile = xccdf_policy_get_profile(policy);
 
     /* If profile is NULL we don't have setvalue's
      * and we return NULL, otherwise we could cause SIGSEG
@@ -182,22 +268,14 @@ static struct xccdf_setvalue * xccdf_policy_get_setvalue(struct xccdf_policy * p
      */
     if (profile == NULL) return NULL;
 
-    /* We need to return *LAST* setvalue in Profile.
-     * and iterate to the end of setvalue list
-     */
-    struct xccdf_setvalue * final = NULL;
-    s_value_it = xccdf_profile_get_setvalues(profile);
-    while (xccdf_setvalue_iterator_has_more(s_value_it)) {
-        s_value = xccdf_setvalue_iterator_next(s_value_it);
-        if (!strcmp(id, xccdf_setvalue_get_item(s_value))) {
-            final = s_value;
-        }
-    }
-    xccdf_setvalue_iterator_free(s_value_it);
-
-    return final;
+    policy->setvalues_index = _xccdf_policy_index_profile_list(policy->setvalues_index, &policy->setvalues_indexed,
+		    XITEM(profile)->sub.profile.setvalues, (xccdf_policy_index_key_func) xccdf_setvalue_get_item);
+    return oscap_htable_get(policy->setvalues_index, id);
 }
 
+/**
+ * Get last refine-value from policy that match specified id
+ */
 static struct xccdf_refine_value * xccdf_policy_get_refine_value(struct xccdf_policy * policy, const char * id)
 {
     /* return NULL if id or policy is NULL but don't use
@@ -207,30 +285,23 @@ static struct xccdf_refine_value * xccdf_policy_get_refine_value(struct xccdf_po
     if (id == NULL) return NULL;
     if (policy == NULL) return NULL;
 
-    struct xccdf_refine_value_iterator  * r_value_it;
-    struct xccdf_refine_value           * r_value;
-    struct xccdf_profile            * profile = xccdf_policy_get_profile(policy);;
+    struct xccdf_profile            * profile = xccdf_policy_get_profile(policy);
 
-    /* If profile is NULL we don't have setvalue's
+    /* If profile is NULL we don't have refine-value's
      * and we return NULL, otherwise we could cause SIGSEG
      * with accessing NULL structure
      */
     if (profile == NULL) return NULL;
 
-    /* We need to return *LAST* setvalue in Profile.
-     * and iterate to the end of setvalue list
-     */
-    struct xccdf_refine_value * final = NULL;
-    r_value_it = xccdf_profile_get_refine_values(profile);
-    while (xccdf_refine_value_iterator_has_more(r_value_it)) {
-        r_value = xccdf_refine_value_iterator_next(r_value_it);
-        if (!strcmp(id, xccdf_refine_value_get_item(r_value))) {
-            final = r_value;
-        }
-    }
-    xccdf_refine_value_iterator_free(r_value_it);
+    policy->refine_values_index = _xccdf_policy_index_profile_list(policy->refine_values_index, &policy->refine_values_indexed,
+		    XITEM(profile)->sub.profile.refine_values, (xccdf_policy_index_key_func) xccdf_refine_value_get_item);
+    return oscap_htable_get(policy->refine_values_index, id);
+}
 
-    return final;
+void xccdf_policy_index_values(struct xccdf_policy *policy)
+{
+	xccdf_policy_get_setvalue(policy, "");
+	xccdf_policy_get_refine_value(policy, "");
 }
 
 /**
@@ -402,6 +473,16 @@ static struct oscap_list *_xccdf_policy_get_oval_definitions_for_href(struct xcc
 	return result;
 }
 
+void xccdf_policy_system_changed(struct xccdf_policy *policy)
+{
+	struct oscap_iterator *cb_it = oscap_iterator_new(policy->model->engines);
+	while (oscap_iterator_has_more(cb_it)) {
+		struct xccdf_policy_engine *engine = (struct xccdf_policy_engine *) oscap_iterator_next(cb_it);
+		xccdf_policy_engine_query(engine, POLICY_ENGINE_QUERY_SYSTEM_CHANGED, NULL);
+	}
+	oscap_iterator_free(cb_it);
+}
+
 int xccdf_policy_report_cb(struct xccdf_policy *policy, const char *sysname, void *rule)
 {
     int retval = 0;
@@ -495,6 +576,8 @@ int xccdf_policy_check_evaluate(struct xccdf_policy * policy, struct xccdf_check
     int                                       ret = 0;
     int                                       ret2 = 0;
 
+    OSCAP_TRACE2(check__begin, xccdf_check_get_system(check), xccdf_check_get_id(check));
+
     /* At least one of check-content or check-content-ref must
         * appear in each check element. */
     if (xccdf_check_get_complex(check)) { /* we have complex subtree */
@@ -504,6 +587,7 @@ int xccdf_policy_check_evaluate(struct xccdf_policy * policy, struct xccdf_check
                 ret2 = xccdf_policy_check_evaluate(policy, child);
                 if (ret2 == -1) {
                     xccdf_check_iterator_free(child_it);
+                    OSCAP_TRACE2(check__end, xccdf_check_get_system(check), -1);
                     return -1;
 		}
                 if (ret == 0) ret = ret2;
@@ -520,6 +604,7 @@ int xccdf_policy_check_evaluate(struct xccdf_policy * policy, struct xccdf_check
             bindings = xccdf_policy_check_get_value_bindings(policy, xccdf_check_get_exports(check));
             if (bindings == NULL) {
                 xccdf_check_content_ref_iterator_free(content_it);
+                OSCAP_TRACE2(check__end, system_name, XCCDF_RESULT_UNKNOWN);
                 return XCCDF_RESULT_UNKNOWN;
 	    }
             while (xccdf_check_content_ref_iterator_has_more(content_it)) {
@@ -545,6 +630,7 @@ int xccdf_policy_check_evaluate(struct xccdf_policy * policy, struct xccdf_check
     }
     /* Negate only once */
     ret = _resolve_negate(ret, check);
+    OSCAP_TRACE2(check__end, xccdf_check_get_system(check), ret);
     return ret;
 }
 
@@ -717,6 +803,7 @@ static int _xccdf_policy_report_rule_result(struct xccdf_policy *policy,
 	if (res == -1)
 		return res;
 
+	OSCAP_TRACE2(rule__result, xccdf_rule_get_id(rule), res);
 	if (result != NULL) {
 		/* Add result to policy */
 		/* TODO: instance */
@@ -787,20 +874,19 @@ static char *_cpe_get_oval_href(struct cpe_dict_model *dict, struct cpe_lang_mod
 	return oval_href;
 }
 
-static bool _xccdf_policy_cpe_check_cb(const char* sys, const char* href, const char* name, void* usr)
-{
-	// FIXME: Check that sys is OVAL
-
-	struct cpe_check_cb_usr* cb_usr = (struct cpe_check_cb_usr*)usr;
+static bool CPE_TRUE = true;
+static bool CPE_FALSE = false;
 
-	struct xccdf_policy_model* model = cb_usr->model;
+static bool _xccdf_policy_cpe_check_eval(struct xccdf_policy_model *model, const char *prefixed_href, const char *name)
+{
+	// with a cached result the CPE OVAL content isn't even loaded
+	bool cached = false;
+	if (cpe_session_cached_result(model->cpe, prefixed_href, name, &cached))
+		return cached;
 
-	char* prefixed_href = _cpe_get_oval_href(cb_usr->dict, cb_usr->lang_model, href);
 	struct oval_agent_session *session = cpe_session_lookup_oval_session(model->cpe, prefixed_href);
-	free(prefixed_href);
-	if (session == NULL) {
+	if (session == NULL)
 		return false;
-	}
 
 	oval_agent_eval_definition(session, name);
 	oval_result_t result = OVAL_RESULT_NOT_EVALUATED;
@@ -808,10 +894,37 @@ static bool _xccdf_policy_cpe_check_cb(const char* sys, const char* href, const
 	{
 		// error message should already be set in the function
 	}
+	if (result == OVAL_RESULT_TRUE || result == OVAL_RESULT_FALSE)
+		cpe_session_cache_result(model->cpe, prefixed_href, name, result == OVAL_RESULT_TRUE);
 
 	return result == OVAL_RESULT_TRUE;
 }
 
+static bool _xccdf_policy_cpe_check_cb(const char* sys, const char* href, const char* name, void* usr)
+{
+	// FIXME: Check that sys is OVAL
+
+	struct cpe_check_cb_usr* cb_usr = (struct cpe_check_cb_usr*)usr;
+
+	struct xccdf_policy_model* model = cb_usr->model;
+
+	// The same checks are referenced by many platforms and dictionary
+	// items, each one is evaluated once per session.
+	char* prefixed_href = _cpe_get_oval_href(cb_usr->dict, cb_usr->lang_model, href);
+	char *key = oscap_sprintf("%s#%s", prefixed_href ? prefixed_href : "", name ? name : "");
+	const bool *memo = oscap_htable_get(model->cpe->check_results, key);
+	bool ret;
+	if (memo != NULL) {
+		ret = *memo;
+	} else {
+		ret = _xccdf_policy_cpe_check_eval(model, prefixed_href, name);
+		oscap_htable_add(model->cpe->check_results, key, ret ? &CPE_TRUE : &CPE_FALSE);
+	}
+	free(key);
+	free(prefixed_href);
+	return ret;
+}
+
 static bool _xccdf_policy_cpe_dict_cb(struct cpe_name* name, void* usr)
 {
 	struct cpe_check_cb_usr* cb_usr = (struct cpe_check_cb_usr*)usr;
@@ -822,14 +935,19 @@ static bool _xccdf_policy_cpe_dict_cb(struct cpe_name* name, void* usr)
 	struct xccdf_policy_model* model = cb_usr->model;
 	struct xccdf_benchmark* benchmark = xccdf_policy_model_get_benchmark(model);
 
+	char *key = cpe_name_get_as_str(name);
+	const bool *memo = key != NULL ? oscap_htable_get(model->cpe->name_results, key) : NULL;
+	if (memo != NULL) {
+		free(key);
+		return *memo;
+	}
+
 	bool ret = false;
 
 	struct cpe_dict_model* embedded_dict = xccdf_benchmark_get_cpe_list(benchmark);
 	if (embedded_dict != NULL) {
 		ret = cpe_name_applicable_dict(name, embedded_dict, (cpe_check_fn) _xccdf_policy_cpe_check_cb, usr);
 	}
-	if (ret)
-		return true;
 
 	struct oscap_iterator* dicts = oscap_iterator_new(model->cpe->dicts);
 	while (!ret && oscap_iterator_has_more(dicts)) {
@@ -837,94 +955,67 @@ static bool _xccdf_policy_cpe_dict_cb(struct cpe_name* name, void* usr)
 		ret = cpe_name_applicable_dict(name, dict, (cpe_check_fn) _xccdf_policy_cpe_check_cb, usr);
 	}
 	oscap_iterator_free(dicts);
+
+	if (key != NULL)
+		oscap_htable_add(model->cpe->name_results, key, ret ? &CPE_TRUE : &CPE_FALSE);
+	free(key);
 	return ret;
 }
 
-static bool xccdf_policy_model_platforms_are_applicable_dict(struct xccdf_policy_model *model, struct cpe_dict_model *dict, struct oscap_string_iterator *platforms)
+static bool xccdf_policy_model_platform_is_applicable_dict(struct xccdf_policy_model *model, struct cpe_dict_model *dict, const char *platform)
 {
-	// at this point we know that the item has 1 or more platforms specified
-	bool ret = false;
-
-	while (oscap_string_iterator_has_more(platforms))
-	{
-		const char* platform = oscap_string_iterator_next(platforms);
-		// Platform could be a reference to CPE2 platform, skip the ones
-		// that aren't valid CPE names.
-		if (!cpe_name_check(platform))
-			continue;
-
-		struct cpe_name* name = cpe_name_new(platform);
-
-		struct cpe_check_cb_usr* usr = malloc(sizeof(struct cpe_check_cb_usr));
-		usr->model = model;
-		usr->dict = dict;
-		usr->lang_model = NULL;
-		const bool applicable = cpe_name_applicable_dict(name, dict, (cpe_check_fn) _xccdf_policy_cpe_check_cb, usr);
-		free(usr);
+	// Platform could be a reference to CPE2 platform, skip the ones
+	// that aren't valid CPE names.
+	if (!cpe_name_check(platform))
+		return false;
 
-		cpe_name_free(name);
+	struct cpe_name* name = cpe_name_new(platform);
 
-		if (applicable)
-		{
-			ret = true;
-
-			if (oscap_htable_get(model->cpe->applicable_platforms, platform) == NULL) {
-				oscap_htable_add(model->cpe->applicable_platforms, platform, 0);
-			}
-		}
-	}
-	oscap_string_iterator_reset(platforms);
+	struct cpe_check_cb_usr* usr = malloc(sizeof(struct cpe_check_cb_usr));
+	usr->model = model;
+	usr->dict = dict;
+	usr->lang_model = NULL;
+	const bool applicable = cpe_name_applicable_dict(name, dict, (cpe_check_fn) _xccdf_policy_cpe_check_cb, usr);
+	free(usr);
 
-	return ret;
+	cpe_name_free(name);
+	return applicable;
 }
 
-static bool xccdf_policy_model_platforms_are_applicable_lang_model(struct xccdf_policy_model *model, struct cpe_lang_model *lang_model, struct oscap_string_iterator *platforms)
+static bool xccdf_policy_model_platform_is_applicable_lang_model(struct xccdf_policy_model *model, struct cpe_lang_model *lang_model, const char *platform)
 {
-	// at this point we know that the item has 1 or more platforms specified
-	bool ret = false;
+	// Specification says that platform should begin with "#" if it is
+	// a reference to a CPE2 platform. However content exists where this
+	// is not strictly followed so we support both with and without "#"
+	// references.
 
-	while (oscap_string_iterator_has_more(platforms))
+	const char* platform_shifted = platform;
+	if (strlen(platform_shifted) >= 1 && *platform_shifted == '#')
 	{
-		const char* platform = oscap_string_iterator_next(platforms);
-		// Specification says that platform should begin with "#" if it is
-		// a reference to a CPE2 platform. However content exists where this
-		// is not strictly followed so we support both with and without "#"
-		// references.
-
-		const char* platform_shifted = platform;
-		if (strlen(platform_shifted) >= 1 && *platform_shifted == '#')
-		{
-			// skip the "#" character
-			platform_shifted++;
-		}
-
-		struct cpe_check_cb_usr* usr = malloc(sizeof(struct cpe_check_cb_usr));
-		usr->model = model;
-		usr->dict = NULL;
-		usr->lang_model = lang_model;
-		const bool applicable = cpe_platform_applicable_lang_model(platform_shifted, lang_model, (cpe_check_fn)_xccdf_policy_cpe_check_cb, (cpe_dict_fn)_xccdf_policy_cpe_dict_cb, usr);
-		free(usr);
-
-		if (applicable)
-		{
-			ret = true;
-
-			if (oscap_htable_get(model->cpe->applicable_platforms, platform) == NULL) {
-				oscap_htable_add(model->cpe->applicable_platforms, platform, 0);
-			}
-		}
+		// skip the "#" character
+		platform_shifted++;
 	}
-	oscap_string_iterator_reset(platforms);
 
-	return ret;
+	struct cpe_check_cb_usr* usr = malloc(sizeof(struct cpe_check_cb_usr));
+	usr->model = model;
+	usr->dict = NULL;
+	usr->lang_model = lang_model;
+	const bool applicable = cpe_platform_applicable_lang_model(platform_shifted, lang_model, (cpe_check_fn)_xccdf_policy_cpe_check_cb, (cpe_dict_fn)_xccdf_policy_cpe_dict_cb, usr);
+	free(usr);
+
+	return applicable;
 }
 
-bool xccdf_policy_model_platforms_are_applicable(struct xccdf_policy_model *model, struct oscap_string_iterator *platforms)
+static bool xccdf_policy_model_platform_is_applicable(struct xccdf_policy_model *model, const char *platform)
 {
-	// we have to check whether the item has any platforms at all, if it has none
-	// it should be applicable to all platforms
-	if (!oscap_string_iterator_has_more(platforms))
-		return true;
+	static bool TRUE0 = true;
+	static bool FALSE0 = false;
+
+	// The same few platforms are usually shared by many items, the result
+	// of each platform is computed once and kept in the CPE session.
+	const bool *cached = oscap_htable_get(model->cpe->platform_results, platform);
+	if (cached != NULL)
+		return *cached;
 
 	bool ret = false;
 	// We do not check whether the platform entries are valid platform refs
@@ -935,51 +1026,135 @@ bool xccdf_policy_model_platforms_are_applicable(struct xccdf_policy_model *mode
 	struct xccdf_benchmark* benchmark = xccdf_policy_model_get_benchmark(model);
 	struct cpe_lang_model *embedded_lang_model = xccdf_benchmark_get_cpe_lang_model(benchmark);
 	if (embedded_lang_model != NULL) {
-		if (xccdf_policy_model_platforms_are_applicable_lang_model(model, embedded_lang_model, platforms))
+		if (xccdf_policy_model_platform_is_applicable_lang_model(model, embedded_lang_model, platform))
 			ret = true;
 	}
 
 	struct oscap_iterator *lang_models = oscap_iterator_new(model->cpe->lang_models);
 	while (oscap_iterator_has_more(lang_models)) {
 		struct cpe_lang_model *lang_model = (struct cpe_lang_model *) oscap_iterator_next(lang_models);
-		if (xccdf_policy_model_platforms_are_applicable_lang_model(model, lang_model, platforms))
+		if (xccdf_policy_model_platform_is_applicable_lang_model(model, lang_model, platform))
 			ret = true;
 	}
 	oscap_iterator_free(lang_models);
 
 	struct cpe_dict_model *embedded_dict = xccdf_benchmark_get_cpe_list(benchmark);
 	if (embedded_dict != NULL) {
-		if (xccdf_policy_model_platforms_are_applicable_dict(model, embedded_dict, platforms))
+		if (xccdf_policy_model_platform_is_applicable_dict(model, embedded_dict, platform))
 			ret = true;
 	}
 
 	struct oscap_iterator *dicts = oscap_iterator_new(model->cpe->dicts);
 	while (oscap_iterator_has_more(dicts)) {
 		struct cpe_dict_model *dict = (struct cpe_dict_model *) oscap_iterator_next(dicts);
-		if (xccdf_policy_model_platforms_are_applicable_dict(model, dict, platforms))
+		if (xccdf_policy_model_platform_is_applicable_dict(model, dict, platform))
 			ret = true;
 	}
 	oscap_iterator_free(dicts);
 
+	if (ret && oscap_htable_get(model->cpe->applicable_platforms, platform) == NULL)
+		oscap_htable_add(model->cpe->applicable_platforms, platform, 0);
+	oscap_htable_add(model->cpe->platform_results, platform, ret ? &TRUE0 : &FALSE0);
+
 	return ret;
 }
 
+bool xccdf_policy_model_platforms_are_applicable(struct xccdf_policy_model *model, struct oscap_string_iterator *platforms)
+{
+	// we have to check whether the item has any platforms at all, if it has none
+	// it should be applicable to all platforms
+	if (!oscap_string_iterator_has_more(platforms))
+		return true;
+
+	// All the platforms are checked so that each applicable one is recorded
+	bool ret = false;
+	while (oscap_string_iterator_has_more(platforms)) {
+		const char *platform = oscap_string_iterator_next(platforms);
+		if (xccdf_policy_model_platform_is_applicable(model, platform))
+			ret = true;
+	}
+	oscap_string_iterator_reset(platforms);
+
+	return ret;
+}
+
+/* A new dictionary or lang model may make more items applicable */
+static void _xccdf_policy_model_reset_item_results(struct xccdf_policy_model *model)
+{
+	if (oscap_htable_itemcount(model->item_results) == 0)
+		return;
+	oscap_htable_free(model->item_results, NULL);
+	model->item_results = oscap_htable_new();
+}
+
+static bool _xccdf_policy_model_item_platforms_are_applicable(struct xccdf_policy_model *model, struct xccdf_item *item)
+{
+	struct oscap_string_iterator* platforms = xccdf_item_get_platforms(item);
+	bool ret = xccdf_policy_model_platforms_are_applicable(model, platforms);
+	oscap_string_iterator_free(platforms);
+	return ret;
+}
+
+static void _xccdf_policy_model_set_item_result(struct xccdf_policy_model *model, struct xccdf_item *item, bool applicable)
+{
+	static bool TRUE0 = true;
+	static bool FALSE0 = false;
+
+	const char *id = xccdf_item_get_id(item);
+	if (id != NULL && oscap_htable_get(model->item_results, id) == NULL)
+		oscap_htable_add(model->item_results, id, applicable ? &TRUE0 : &FALSE0);
+}
+
 bool xccdf_policy_model_item_is_applicable(struct xccdf_policy_model *model, struct xccdf_item *item)
 {
+	const char *id = xccdf_item_get_id(item);
+	const bool *cached = id != NULL ? oscap_htable_get(model->item_results, id) : NULL;
+	if (cached != NULL)
+		return *cached;
+
 	struct xccdf_item* parent = xccdf_item_get_parent(item);
-	if (!parent || xccdf_policy_model_item_is_applicable(model, parent))
-	{
-		struct oscap_string_iterator* platforms = xccdf_item_get_platforms(item);
-		bool ret = xccdf_policy_model_platforms_are_applicable(model, platforms);
-		oscap_string_iterator_free(platforms);
+	// parent is not applicable
+	bool ret = (!parent || xccdf_policy_model_item_is_applicable(model, parent)) &&
+		_xccdf_policy_model_item_platforms_are_applicable(model, item);
+	_xccdf_policy_model_set_item_result(model, item, ret);
+	return ret;
+}
 
-		return ret;
-	}
-	else
-	{
-		// parent is not applicable
-		return false;
+static void _xccdf_policy_resolve_item_applicability(struct xccdf_policy *policy, struct xccdf_item *item, bool parent_applicable)
+{
+	struct xccdf_policy_model *model = policy->model;
+	const char *id = xccdf_item_get_id(item);
+
+	if (xccdf_item_get_type(item) == XCCDF_RULE) {
+		// The platforms of the rules which won't be evaluated aren't needed
+		if (parent_applicable && !xccdf_policy_is_item_selected(policy, id) &&
+		    oscap_htable_get(policy->rules, id) == NULL)
+			return;
+		_xccdf_policy_model_set_item_result(model, item, parent_applicable && _xccdf_policy_model_item_platforms_are_applicable(model, item));
+		return;
 	}
+	if (xccdf_item_get_type(item) != XCCDF_GROUP)
+		return;
+
+	const bool applicable = parent_applicable && _xccdf_policy_model_item_platforms_are_applicable(model, item);
+	_xccdf_policy_model_set_item_result(model, item, applicable);
+	struct xccdf_item_iterator *child_it = xccdf_group_get_content((const struct xccdf_group *) item);
+	while (xccdf_item_iterator_has_more(child_it))
+		_xccdf_policy_resolve_item_applicability(policy, xccdf_item_iterator_next(child_it), applicable);
+	xccdf_item_iterator_free(child_it);
+}
+
+void xccdf_policy_resolve_applicability(struct xccdf_policy *policy)
+{
+	struct xccdf_benchmark *benchmark = xccdf_policy_get_benchmark(policy);
+	if (benchmark == NULL)
+		return;
+
+	const bool applicable = xccdf_policy_model_item_is_applicable(policy->model, XITEM(benchmark));
+	struct xccdf_item_iterator *item_it = xccdf_benchmark_get_content(benchmark);
+	while (xccdf_item_iterator_has_more(item_it))
+		_xccdf_policy_resolve_item_applicability(policy, xccdf_item_iterator_next(item_it), applicable);
+	xccdf_item_iterator_free(item_it);
 }
 
 static bool _xccdf_policy_item_is_in_conflict(struct xccdf_policy *policy, const struct xccdf_item *item) {
@@ -1037,27 +1212,28 @@ static void _warn_about_required_rules(const struct xccdf_policy *policy, const
  * This duplication is needed to handle @multi-check correctly,
  * which is (in general) not predictable in any way.
  */
-static inline int
-_xccdf_policy_rule_evaluate(struct xccdf_policy * policy, const struct xccdf_rule *rule, struct xccdf_result *result, bool parent_selected)
+/**
+ * Resolve the selection of the rule, the document order matters because of
+ * --rule mode and of the requires/conflicts of the rules.
+ * @return true if the rule shall be evaluated, false if it is notselected
+ */
+static bool
+_xccdf_policy_rule_select(struct xccdf_policy *policy, const struct xccdf_rule *rule, bool parent_selected)
 {
 	const char* rule_id = xccdf_rule_get_id(rule);
 	const bool is_selected = xccdf_policy_is_item_selected(policy, rule_id);
-	const char *message = NULL;
-	int report = 0;
 
 	/* If the rule is requested to be skipped by the user using --skip-rule on
 	 * the command line we will skip the evaluation of this rule. */
-	if (oscap_htable_get(policy->skip_rules, rule_id) != NULL) {
-		return _xccdf_policy_report_rule_result(policy, result, rule, NULL, XCCDF_RESULT_NOT_SELECTED, NULL);
-	}
+	if (oscap_htable_get(policy->skip_rules, rule_id) != NULL)
+		return false;
 
 	/* If user wants to evaluate only specific rules and the rule currently
 	 * being evaluated is not among these rules, do not evaluate it and mark it
 	 * as notselected. */
 	if (_user_specified_rule_mode(policy) > 0) {
-		if (oscap_htable_get(policy->rules, rule_id) == NULL) {
-			return _xccdf_policy_report_rule_result(policy, result, rule, NULL, XCCDF_RESULT_NOT_SELECTED, NULL);
-		}
+		if (oscap_htable_get(policy->rules, rule_id) == NULL)
+			return false;
 		oscap_htable_add(policy->rules_found, rule_id, (void *)true);
 		_xccdf_policy_modify_selected_final(policy, rule_id, true);
 		_warn_about_required_rules(policy, rule);
@@ -1065,14 +1241,23 @@ _xccdf_policy_rule_evaluate(struct xccdf_policy * policy, const struct xccdf_rul
 	} else {
 		/* solve selects only when in --rule mode */
 		if (!is_selected || !parent_selected)
-			return _xccdf_policy_report_rule_result(policy, result, rule, NULL, XCCDF_RESULT_NOT_SELECTED, NULL);
+			return false;
 
 		// See section 7.2.3.3.2 (<xccdf:requires> and <xccdf:conflicts> Elements) of the XCCDF specification.
 		if (_xccdf_policy_item_is_in_conflict(policy, XITEM(rule)) || !_xccdf_policy_item_has_all_requirements(policy, XITEM(rule))) {
 			xccdf_policy_resolve_item(policy, XITEM(rule), false);
-			return _xccdf_policy_report_rule_result(policy, result, rule, NULL, XCCDF_RESULT_NOT_SELECTED, NULL);
+			return false;
 		}
 	}
+	return true;
+}
+
+static inline int
+_xccdf_policy_rule_evaluate_selected(struct xccdf_policy * policy, const struct xccdf_rule *rule, struct xccdf_result *result)
+{
+	const char* rule_id = xccdf_rule_get_id(rule);
+	const char *message = NULL;
+	int report = 0;
 
 	/* Otherwise start reporting */
 	report = xccdf_policy_report_cb(policy, XCCDF_POLICY_OUTCB_START, (void *) rule);
@@ -1199,6 +1384,416 @@ _xccdf_policy_rule_evaluate(struct xccdf_policy * policy, const struct xccdf_rul
 	return _xccdf_policy_report_rule_result(policy, result, rule, check, ret, message);
 }
 
+static inline int
+_xccdf_policy_rule_evaluate(struct xccdf_policy * policy, const struct xccdf_rule *rule, struct xccdf_result *result, bool parent_selected)
+{
+	if (!_xccdf_policy_rule_select(policy, rule, parent_selected))
+		return _xccdf_policy_report_rule_result(policy, result, rule, NULL, XCCDF_RESULT_NOT_SELECTED, NULL);
+	return _xccdf_policy_rule_evaluate_selected(policy, rule, result);
+}
+
+#define XCCDF_POLICY_EVAL_MAX_JOBS 64
+
+/**
+ * A rule waiting to be reported when the checks are evaluated concurrently.
+ * The check of the rule is either evaluated by the pool of threads, started by
+ * its asynchronous checking engines or, if its checking engine is neither
+ * thread-safe nor asynchronous, evaluated when the rule is reported.
+ */
+struct xccdf_policy_rule_step {
+	const struct xccdf_rule *rule;
+	bool selected;
+	xccdf_role_t role;
+	struct xccdf_check *check;      ///< check evaluated ahead, NULL if the rule is evaluated when reported
+	struct oscap_list *bindings;
+	int ret;
+	bool async;                     ///< the check is started by asynchronous engines
+	struct xccdf_check_content_ref_iterator *content_it; ///< alternatives left to an asynchronous check
+	const struct xccdf_check_content_ref *content;       ///< the alternative being tried
+	struct oscap_iterator *engine_it;                    ///< engines left to try for the content
+	struct xccdf_policy_engine *engine;                  ///< the engine to start the check with
+	struct xccdf_check_import_iterator *import_it;       ///< imports of the started check
+};
+
+struct xccdf_policy_eval_pool {
+	struct xccdf_policy *policy;
+	struct xccdf_policy_rule_step **steps;
+	size_t count;
+	size_t next;                    ///< first step which isn't taken by a thread
+	pthread_mutex_t lock;
+};
+
+static void _xccdf_policy_rule_step_free(struct xccdf_policy_rule_step *step)
+{
+	if (step->import_it != NULL)
+		xccdf_check_import_iterator_free(step->import_it);
+	if (step->engine_it != NULL)
+		oscap_iterator_free(step->engine_it);
+	if (step->content_it != NULL)
+		xccdf_check_content_ref_iterator_free(step->content_it);
+	xccdf_check_free(step->check);
+	oscap_list_free(step->bindings, (oscap_destruct_func) xccdf_value_binding_free);
+	free(step);
+}
+
+/* Number of threads evaluating the checks, the rules are evaluated one by one if it is 1 */
+static size_t _xccdf_policy_eval_jobs(void)
+{
+	return oscap_threadpool_jobs("OSCAP_XCCDF_EVAL_JOBS", 1, XCCDF_POLICY_EVAL_MAX_JOBS);
+}
+
+/* True if all the checking engines of the system have the property, or if any engine has when sysname is NULL */
+static bool _xccdf_policy_engines_are(struct xccdf_policy *policy, const char *sysname, bool (*property)(const struct xccdf_policy_engine *))
+{
+	struct oscap_iterator *cb_it;
+	bool has = false;
+
+	if (sysname == NULL)
+		cb_it = oscap_iterator_new(policy->model->engines);
+	else
+		cb_it = _xccdf_policy_get_engines_by_sysname(policy, sysname);
+	while (oscap_iterator_has_more(cb_it)) {
+		struct xccdf_policy_engine *engine = (struct xccdf_policy_engine *) oscap_iterator_next(cb_it);
+
+		has = property(engine);
+		if (has == (sysname == NULL))
+			break;
+	}
+	oscap_iterator_free(cb_it);
+
+	return has;
+}
+
+static bool _xccdf_policy_engines_are_thread_safe(struct xccdf_policy *policy, const char *sysname)
+{
+	return _xccdf_policy_engines_are(policy, sysname, xccdf_policy_engine_is_thread_safe);
+}
+
+static bool _xccdf_policy_engines_are_async(struct xccdf_policy *policy, const char *sysname)
+{
+	return _xccdf_policy_engines_are(policy, sysname, xccdf_policy_engine_is_async);
+}
+
+/**
+ * Prepare the check of a selected rule to be evaluated by the pool of threads
+ * or started by asynchronous engines. Only a single simple check without
+ * multi-check of an applicable rule qualifies, its checking engines have to be
+ * thread-safe or all of them asynchronous.
+ */
+static void _xccdf_policy_rule_step_prepare(struct xccdf_policy *policy, struct xccdf_policy_rule_step *step)
+{
+	const struct xccdf_rule *rule = step->rule;
+	struct xccdf_refine_rule_internal *r_rule = oscap_htable_get(policy->refine_rules_internal, xccdf_rule_get_id(rule));
+	const struct xccdf_check *orig_check;
+	struct oscap_list *bindings;
+
+	step->role = xccdf_get_final_role(rule, r_rule);
+	if (step->role == XCCDF_ROLE_UNCHECKED)
+		return;
+
+	orig_check = _xccdf_policy_rule_get_applicable_check(policy, XITEM(rule));
+	if (orig_check == NULL || xccdf_check_get_complex(orig_check) || xccdf_check_get_multicheck(orig_check))
+		return;
+	step->async = _xccdf_policy_engines_are_async(policy, xccdf_check_get_system(orig_check));
+	if (!step->async && (_xccdf_policy_eval_jobs() < 2 || !_xccdf_policy_engines_are_thread_safe(policy, xccdf_check_get_system(orig_check))))
+		return;
+	if (!xccdf_policy_model_item_is_applicable(policy->model, XITEM(rule)))
+		return;
+
+	bindings = xccdf_policy_check_get_value_bindings(policy, xccdf_check_get_exports(orig_check));
+	if (bindings == NULL)
+		return;
+
+	// we need to clone the check to avoid changing the original content
+	step->check = xccdf_check_clone(orig_check);
+	step->bindings = bindings;
+	step->ret = XCCDF_RESULT_NOT_CHECKED;
+	if (step->async)
+		step->content_it = xccdf_check_get_content_refs(step->check);
+}
+
+/**
+ * Queue the rule to be reported in document order. The selection is resolved
+ * right away, as it would be when the rules are evaluated one by one.
+ */
+static int _xccdf_policy_rule_defer(struct xccdf_policy *policy, const struct xccdf_rule *rule, bool parent_selected)
+{
+	struct xccdf_policy_rule_step *step = calloc(1, sizeof(struct xccdf_policy_rule_step));
+
+	if (step == NULL)
+		return -1;
+	step->rule = rule;
+	step->selected = _xccdf_policy_rule_select(policy, rule, parent_selected);
+	if (step->selected)
+		_xccdf_policy_rule_step_prepare(policy, step);
+	oscap_list_add(policy->rule_steps, step);
+
+	return 0;
+}
+
+/* Evaluate the check of the step, the check-content-refs are alternatives as in _xccdf_policy_rule_evaluate_selected */
+static void _xccdf_policy_rule_step_eval(struct xccdf_policy *policy, struct xccdf_policy_rule_step *step)
+{
+	const char *system_name = xccdf_check_get_system(step->check);
+	struct xccdf_check_content_ref_iterator *content_it = xccdf_check_get_content_refs(step->check);
+	int ret = XCCDF_RESULT_NOT_CHECKED;
+
+	OSCAP_TRACE1(rule__begin, xccdf_rule_get_id(step->rule));
+	while (xccdf_check_content_ref_iterator_has_more(content_it)) {
+		struct xccdf_check_content_ref *content = xccdf_check_content_ref_iterator_next(content_it);
+		const char *content_name = xccdf_check_content_ref_get_name(content);
+		const char *href = xccdf_check_content_ref_get_href(content);
+
+		struct xccdf_check_import_iterator *check_import_it = xccdf_check_get_imports(step->check);
+		ret = xccdf_policy_evaluate_cb(policy, system_name, content_name, href, step->bindings, check_import_it);
+		xccdf_check_import_iterator_free(check_import_it);
+
+		if ((xccdf_test_result_type_t) ret != XCCDF_RESULT_NOT_CHECKED) {
+			xccdf_check_inject_content_ref(step->check, content, NULL);
+			break;
+		}
+	}
+	xccdf_check_content_ref_iterator_free(content_it);
+	step->ret = ret;
+	OSCAP_TRACE1(rule__end, xccdf_rule_get_id(step->rule));
+}
+
+static void *_xccdf_policy_eval_thread(void *arg)
+{
+	struct xccdf_policy_eval_pool *pool = arg;
+	struct xccdf_policy_rule_step *step;
+
+	for (;;) {
+		pthread_mutex_lock(&pool->lock);
+		if (pool->next == pool->count) {
+			pthread_mutex_unlock(&pool->lock);
+			break;
+		}
+		step = pool->steps[pool->next++];
+		pthread_mutex_unlock(&pool->lock);
+
+		_xccdf_policy_rule_step_eval(pool->policy, step);
+	}
+
+	return NULL;
+}
+
+/* Pick the next engine to try for the asynchronous check, the check-content-refs are alternatives */
+static bool _xccdf_policy_rule_step_next_engine(struct xccdf_policy *policy, struct xccdf_policy_rule_step *step)
+{
+	while (step->engine_it == NULL || !oscap_iterator_has_more(step->engine_it)) {
+		if (step->engine_it != NULL) {
+			oscap_iterator_free(step->engine_it);
+			step->engine_it = NULL;
+		}
+		if (!xccdf_check_content_ref_iterator_has_more(step->content_it))
+			return false;
+		step->content = xccdf_check_content_ref_iterator_next(step->content_it);
+		step->engine_it = _xccdf_policy_get_engines_by_sysname(policy, xccdf_check_get_system(step->check));
+	}
+	step->engine = oscap_iterator_next(step->engine_it);
+	return true;
+}
+
+/* The alternatives of the asynchronous check are exhausted or one of them gave a result */
+static void _xccdf_policy_rule_step_finish(struct xccdf_policy_rule_step *step)
+{
+	if (step->import_it != NULL) {
+		xccdf_check_import_iterator_free(step->import_it);
+		step->import_it = NULL;
+	}
+	if ((xccdf_test_result_type_t) step->ret != XCCDF_RESULT_NOT_CHECKED)
+		xccdf_check_inject_content_ref(step->check, step->content, NULL);
+	if (step->engine_it != NULL) {
+		oscap_iterator_free(step->engine_it);
+		step->engine_it = NULL;
+	}
+	xccdf_check_content_ref_iterator_free(step->content_it);
+	step->content_it = NULL;
+	step->engine = NULL;
+	OSCAP_TRACE1(rule__end, xccdf_rule_get_id(step->rule));
+}
+
+/**
+ * Start the asynchronous check with the next engine which takes it.
+ * @returns 1 if it was started, 0 if the engine to try has as many checks started
+ * as it allows, -1 if no alternative is left and the step is finished
+ */
+static int _xccdf_policy_rule_step_start(struct xccdf_policy *policy, struct xccdf_policy_rule_step *step, struct xccdf_policy_engine_queue *queue)
+{
+	for (;;) {
+		if (step->engine == NULL && !_xccdf_policy_rule_step_next_engine(policy, step)) {
+			_xccdf_policy_rule_step_finish(step);
+			return -1;
+		}
+		if (xccdf_policy_engine_is_busy(step->engine))
+			return 0;
+
+		if (step->import_it != NULL)
+			xccdf_check_import_iterator_free(step->import_it);
+		step->import_it = xccdf_check_get_imports(step->check);
+		if (xccdf_policy_engine_eval_start(step->engine, policy, xccdf_rule_get_id(step->rule),
+				xccdf_check_content_ref_get_name(step->content), xccdf_check_content_ref_get_href(step->content),
+				step->bindings, step->import_it, queue, step) == 0)
+			return 1;
+		/* not started, the same as not checked */
+		step->engine = NULL;
+	}
+}
+
+/**
+ * Keep the checks of the asynchronous engines started, as many at once as the engines
+ * allow, in document order. A check which comes back not checked is tried with the
+ * next engine or check-content-ref before the checks not started yet.
+ */
+static void _xccdf_policy_eval_async_steps(struct xccdf_policy *policy, struct xccdf_policy_rule_step **steps, size_t count)
+{
+	struct xccdf_policy_engine_queue *queue;
+	struct xccdf_policy_rule_step **retry;
+	size_t i, next = 0, retry_head = 0, retry_count = 0;
+
+	queue = xccdf_policy_engine_queue_new(policy->model->engines);
+	/* each step is queued for a retry at most once at a time */
+	retry = malloc(count * sizeof(struct xccdf_policy_rule_step *));
+	if (queue == NULL || retry == NULL) {
+		xccdf_policy_engine_queue_free(queue);
+		free(retry);
+		return;
+	}
+	dI("Starting %zu checks of asynchronous checking engines.", count);
+	for (i = 0; i < count; i++)
+		OSCAP_TRACE1(rule__begin, xccdf_rule_get_id(steps[i]->rule));
+
+	for (;;) {
+		struct xccdf_policy_rule_step *step;
+		xccdf_test_result_type_t result;
+
+		/* start the checks until the engine of the next one is busy */
+		for (;;) {
+			bool from_retry = retry_count > 0;
+
+			if (from_retry)
+				step = retry[retry_head];
+			else if (next < count)
+				step = steps[next];
+			else
+				break;
+			if (_xccdf_policy_rule_step_start(policy, step, queue) == 0)
+				break;
+			if (from_retry) {
+				retry_head = (retry_head + 1) % count;
+				retry_count--;
+			} else {
+				next++;
+			}
+		}
+		if (xccdf_policy_engine_queue_pending(queue) == 0)
+			break;
+
+		step = xccdf_policy_engine_queue_wait(queue, &result);
+		step->ret = result;
+		step->engine = NULL;
+		if (result != XCCDF_RESULT_NOT_CHECKED)
+			_xccdf_policy_rule_step_finish(step);
+		else
+			retry[(retry_head + retry_count++) % count] = step;
+	}
+
+	xccdf_policy_engine_queue_free(queue);
+	free(retry);
+}
+
+static void _xccdf_policy_eval_steps(struct xccdf_policy *policy, struct oscap_list *rule_steps, size_t jobs)
+{
+	struct xccdf_policy_eval_pool pool;
+	pthread_t threads[XCCDF_POLICY_EVAL_MAX_JOBS];
+	struct xccdf_policy_rule_step **async_steps;
+	struct oscap_iterator *it;
+	size_t i, started = 0, async_count = 0;
+
+	memset(&pool, 0, sizeof(pool));
+	pool.policy = policy;
+	if (oscap_list_get_itemcount(rule_steps) == 0)
+		return;
+	pool.steps = malloc(oscap_list_get_itemcount(rule_steps) * sizeof(struct xccdf_policy_rule_step *));
+	async_steps = malloc(oscap_list_get_itemcount(rule_steps) * sizeof(struct xccdf_policy_rule_step *));
+	if (pool.steps == NULL || async_steps == NULL) {
+		free(pool.steps);
+		free(async_steps);
+		return;
+	}
+
+	it = oscap_iterator_new(rule_steps);
+	while (oscap_iterator_has_more(it)) {
+		struct xccdf_policy_rule_step *step = oscap_iterator_next(it);
+		if (step->check == NULL)
+			continue;
+		if (step->async)
+			async_steps[async_count++] = step;
+		else
+			pool.steps[pool.count++] = step;
+	}
+	oscap_iterator_free(it);
+
+	if (jobs > pool.count)
+		jobs = pool.count;
+	if (pool.count > 0)
+		dI("Evaluating %zu checks using %zu threads.", pool.count, jobs);
+
+	pthread_mutex_init(&pool.lock, NULL);
+	for (i = 1; i < jobs; i++) {
+		int err = pthread_create(&threads[started], NULL, _xccdf_policy_eval_thread, &pool);
+
+		if (err != 0) {
+			dW("Can't start a check evaluation thread: %s.", strerror(err));
+			break;
+		}
+		started++;
+	}
+	/* the calling thread starts the asynchronous checks meanwhile */
+	if (async_count > 0)
+		_xccdf_policy_eval_async_steps(policy, async_steps, async_count);
+	/* and takes part then */
+	_xccdf_policy_eval_thread(&pool);
+
+	for (i = 0; i < started; i++)
+		pthread_join(threads[i], NULL);
+	pthread_mutex_destroy(&pool.lock);
+	free(pool.steps);
+	free(async_steps);
+}
+
+/* Report the rule, the results of the checks evaluated by the threads are finished as in _xccdf_policy_rule_evaluate_selected */
+static int _xccdf_policy_rule_step_report(struct xccdf_policy *policy, struct xccdf_policy_rule_step *step, struct xccdf_result *result)
+{
+	const struct xccdf_rule *rule = step->rule;
+	struct xccdf_check *check = step->check;
+	const char *message = NULL;
+	int ret, report;
+
+	if (!step->selected)
+		return _xccdf_policy_report_rule_result(policy, result, rule, NULL, XCCDF_RESULT_NOT_SELECTED, NULL);
+	if (check == NULL)
+		return _xccdf_policy_rule_evaluate_selected(policy, rule, result);
+
+	report = xccdf_policy_report_cb(policy, XCCDF_POLICY_OUTCB_START, (void *) rule);
+	if (report)
+		return report;
+
+	/* the check is handed over to the rule result */
+	step->check = NULL;
+	ret = step->ret;
+	if ((xccdf_test_result_type_t) ret == XCCDF_RESULT_NOT_CHECKED)
+		message = "None of the check-content-ref elements was resolvable.";
+
+	if (step->role == XCCDF_ROLE_UNSCORED)
+		ret = XCCDF_RESULT_INFORMATIONAL;
+
+	/* Negate only once */
+	ret = _resolve_negate(ret, check);
+	return _xccdf_policy_report_rule_result(policy, result, rule, check, ret, message);
+}
+
 /** 
  * Evaluate the XCCDF item. If it is group, start recursive cycle, otherwise get XCCDF check
  * and evaluate it.
@@ -1214,7 +1809,17 @@ static int xccdf_policy_item_evaluate(struct xccdf_policy * policy, struct xccdf
 
     switch (itype) {
         case XCCDF_RULE:{
-			return _xccdf_policy_rule_evaluate(policy, (struct xccdf_rule *) item, result, parent_selected);
+			struct oscap_profiling_mark mark;
+
+			if (policy->rule_steps != NULL)
+				return _xccdf_policy_rule_defer(policy, (struct xccdf_rule *) item, parent_selected);
+
+			OSCAP_TRACE1(rule__begin, xccdf_item_get_id(item));
+			oscap_profiling_start(&mark);
+			ret = _xccdf_policy_rule_evaluate(policy, (struct xccdf_rule *) item, result, parent_selected);
+			oscap_profiling_stop(&mark, OSCAP_PROFILING_RULE, xccdf_item_get_id(item), NULL, 0);
+			OSCAP_TRACE1(rule__end, xccdf_item_get_id(item));
+			return ret;
         } break;
 
         case XCCDF_GROUP:{
@@ -1593,6 +2198,7 @@ bool xccdf_policy_model_add_cpe_dict_source(struct xccdf_policy_model * model, s
 	__attribute__nonnull__(model);
 	__attribute__nonnull__(source);
 
+	_xccdf_policy_model_reset_item_results(model);
 	return cpe_session_add_cpe_dict_source(model->cpe, source);
 }
 
@@ -1601,6 +2207,7 @@ bool xccdf_policy_model_add_cpe_dict(struct xccdf_policy_model *model, const cha
 		__attribute__nonnull__(model);
 		__attribute__nonnull__(cpe_dict);
 
+	_xccdf_policy_model_reset_item_results(model);
 	struct oscap_source *source = oscap_source_new_from_file(cpe_dict);
 	bool ret = cpe_session_add_cpe_dict_source(model->cpe, source);
 	oscap_source_free(source);
@@ -1612,6 +2219,7 @@ bool xccdf_policy_model_add_cpe_lang_model_source(struct xccdf_policy_model *mod
 	__attribute__nonnull__(model);
 	__attribute__nonnull__(source);
 
+	_xccdf_policy_model_reset_item_results(model);
 	return cpe_session_add_cpe_lang_model_source(model->cpe, source);
 }
 
@@ -1620,6 +2228,7 @@ bool xccdf_policy_model_add_cpe_autodetect_source(struct xccdf_policy_model *mod
 	__attribute__nonnull__(model);
 	__attribute__nonnull__(source);
 
+	_xccdf_policy_model_reset_item_results(model);
 	return cpe_session_add_cpe_autodetect_source(model->cpe, source);
 }
 
@@ -1651,6 +2260,29 @@ xccdf_policy_model_register_engine_and_query_callback(struct xccdf_policy_model
 	return oscap_list_add(model->engines, engine);
 }
 
+bool xccdf_policy_model_register_async_engine(struct xccdf_policy_model *model, char *sys, xccdf_policy_engine_eval_async_fn eval_fn, xccdf_policy_engine_poll_fn poll_fn, void *usr, xccdf_policy_engine_query_fn query_fn, unsigned int max_in_flight)
+{
+	__attribute__nonnull__(model);
+	if (eval_fn == NULL)
+		return false;
+	struct xccdf_policy_engine *engine = xccdf_policy_engine_new_async(sys, eval_fn, poll_fn, usr, query_fn, max_in_flight);
+	return oscap_list_add(model->engines, engine);
+}
+
+bool xccdf_policy_model_set_engine_thread_safe(struct xccdf_policy_model *model, const char *sys, bool thread_safe)
+{
+	__attribute__nonnull__(model);
+	bool found = false;
+	struct oscap_iterator *cb_it = oscap_iterator_new_filter(model->engines, (oscap_filter_func) xccdf_policy_engine_filter, (void *) sys);
+	while (oscap_iterator_has_more(cb_it)) {
+		struct xccdf_policy_engine *engine = oscap_iterator_next(cb_it);
+		xccdf_policy_engine_set_thread_safe(engine, thread_safe);
+		found = true;
+	}
+	oscap_iterator_free(cb_it);
+	return found;
+}
+
 void xccdf_policy_model_unregister_engines(struct xccdf_policy_model *model, const char *sys)
 {
 	__attribute__nonnull__(model);
@@ -1741,6 +2373,7 @@ struct xccdf_policy_model * xccdf_policy_model_new(struct xccdf_benchmark * benc
 	model->engines = oscap_list_new();
 
 	model->cpe = cpe_session_new();
+	model->item_results = oscap_htable_new();
 
         /* Resolve document */
         xccdf_benchmark_resolve(benchmark);
@@ -2127,20 +2760,49 @@ struct xccdf_result * xccdf_policy_evaluate(struct xccdf_policy * policy)
 
 	/** We need to process document top-down order.
 	 * See conflicts/requires and Item Processing Algorithm */
+	/* The checks of thread-safe checking engines may be evaluated concurrently and
+	 * those of asynchronous engines kept in flight, the selection is still resolved
+	 * and the rules are reported in this order. */
+	size_t jobs = _xccdf_policy_eval_jobs();
+	if ((jobs > 1 && _xccdf_policy_engines_are_thread_safe(policy, NULL)) || _xccdf_policy_engines_are_async(policy, NULL))
+		policy->rule_steps = oscap_list_new();
+
 	struct xccdf_item_iterator *item_it = xccdf_benchmark_get_content(benchmark);
 	while (xccdf_item_iterator_has_more(item_it)) {
 		struct xccdf_item *item = xccdf_item_iterator_next(item_it);
 		ret = xccdf_policy_item_evaluate(policy, item, result, true);
-		if (ret == -1) {
-			xccdf_item_iterator_free(item_it);
-			xccdf_result_free(result);
-			return NULL;
-		}
 		if (ret != 0)
 			break;
 	}
 	xccdf_item_iterator_free(item_it);
 
+	if (policy->rule_steps != NULL) {
+		struct oscap_list *rule_steps = policy->rule_steps;
+
+		policy->rule_steps = NULL;
+		if (ret == 0) {
+			_xccdf_policy_eval_steps(policy, rule_steps, jobs);
+
+			struct oscap_iterator *step_it = oscap_iterator_new(rule_steps);
+			while (oscap_iterator_has_more(step_it)) {
+				struct xccdf_policy_rule_step *step = oscap_iterator_next(step_it);
+				struct oscap_profiling_mark mark;
+
+				oscap_profiling_start(&mark);
+				ret = _xccdf_policy_rule_step_report(policy, step, result);
+				oscap_profiling_stop(&mark, OSCAP_PROFILING_RULE, xccdf_rule_get_id(step->rule), NULL, 0);
+				if (ret != 0)
+					break;
+			}
+			oscap_iterator_free(step_it);
+		}
+		oscap_list_free(rule_steps, (oscap_destruct_func) _xccdf_policy_rule_step_free);
+	}
+	if (ret == -1) {
+		xccdf_result_free(result);
+		return NULL;
+	}
+
 	struct oscap_htable_iterator *rit = oscap_htable_iterator_new(policy->rules);
 	while (oscap_htable_iterator_has_more(rit)) {
 		const char *rule_id = oscap_htable_iterator_next_key(rit);
@@ -2188,28 +2850,14 @@ const char *xccdf_policy_get_value_of_item(struct xccdf_policy * policy, struct
 
 	if (profile != NULL) {
 		/* Get set_value for this item */
-		struct xccdf_setvalue *s_value = NULL;
-		struct xccdf_setvalue *last_s_value = NULL;
-		struct xccdf_setvalue_iterator *s_value_it = xccdf_profile_get_setvalues(profile);
-		while (xccdf_setvalue_iterator_has_more(s_value_it)) {
-			s_value = xccdf_setvalue_iterator_next(s_value_it);
-			if (strcmp(xccdf_setvalue_get_item(s_value), xccdf_value_get_id((struct xccdf_value *) item)) == 0)
-				last_s_value = s_value;
-		}
-		xccdf_setvalue_iterator_free(s_value_it);
-		if (last_s_value != NULL)
-			return xccdf_setvalue_get_value(last_s_value);
+		struct xccdf_setvalue *s_value = xccdf_policy_get_setvalue(policy, xccdf_value_get_id((struct xccdf_value *) item));
+		if (s_value != NULL)
+			return xccdf_setvalue_get_value(s_value);
 
 		/* We don't have set-value in profile, look for refine-value */
-		struct xccdf_refine_value_iterator *r_value_it = xccdf_profile_get_refine_values(profile);
-		while (xccdf_refine_value_iterator_has_more(r_value_it)) {
-			struct xccdf_refine_value *r_value = xccdf_refine_value_iterator_next(r_value_it);
-			if (!strcmp(xccdf_refine_value_get_item(r_value), xccdf_value_get_id((struct xccdf_value *) item))) {
-				selector = xccdf_refine_value_get_selector(r_value);
-				break;
-			}
-		}
-		xccdf_refine_value_iterator_free(r_value_it);
+		struct xccdf_refine_value *r_value = xccdf_policy_get_refine_value(policy, xccdf_value_get_id((struct xccdf_value *) item));
+		if (r_value != NULL)
+			selector = xccdf_refine_value_get_selector(r_value);
 	}
 
 	struct xccdf_value_instance *instance = xccdf_value_get_instance_by_selector((struct xccdf_value *) item, selector);
@@ -2250,6 +2898,7 @@ void xccdf_policy_model_free(struct xccdf_policy_model * model) {
 	xccdf_tailoring_free(model->tailoring);
         xccdf_benchmark_free(model->benchmark);
 	cpe_session_free(model->cpe);
+	oscap_htable_free(model->item_results, NULL);
         free(model);
 }
 
@@ -2278,6 +2927,9 @@ void xccdf_policy_free(struct xccdf_policy * policy) {
 	oscap_htable_free0(policy->selected_internal);
 	oscap_htable_free0(policy->selected_final);
 	oscap_htable_free(policy->refine_rules_internal, (oscap_destruct_func) xccdf_refine_rule_internal_free);
+	oscap_htable_free0(policy->setvalues_index);
+	oscap_htable_free0(policy->refine_values_index);
+	oscap_htable_free(policy->readable_texts, free);
         free(policy);
 }
 
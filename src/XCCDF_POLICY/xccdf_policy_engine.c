@@ -24,6 +24,9 @@
 #include <config.h>
 #endif
 
+#include <stdlib.h>
+#include <pthread.h>
+
 #include "common/util.h"
 #include "common/list.h"
 #include "common/_error.h"
@@ -35,6 +38,28 @@ struct xccdf_policy_engine {
 	xccdf_policy_engine_eval_fn callback;   ///< format of callback function
 	void * usr;                             ///< User data structure
 	xccdf_policy_engine_query_fn query_fn;  ///< query callback function
+	bool thread_safe;                       ///< eval function can be called by concurrent threads
+	xccdf_policy_engine_eval_async_fn async_fn; ///< starts the checks of an asynchronous engine
+	xccdf_policy_engine_poll_fn poll_fn;    ///< lets an asynchronous engine make progress, optional
+	unsigned int max_in_flight;             ///< checks of an asynchronous engine started at once
+	unsigned int in_flight;                 ///< started checks not taken from their queue yet
+};
+
+struct xccdf_policy_engine_task {
+	struct xccdf_policy_engine_queue *queue;
+	struct xccdf_policy_engine *engine;
+	struct xccdf_value_binding_iterator *binding_it;
+	xccdf_test_result_type_t result;
+	void *arg;
+	struct xccdf_policy_engine_task *next;  ///< next completed task in the queue
+};
+
+struct xccdf_policy_engine_queue {
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	struct xccdf_policy_engine_task *head, *tail; ///< completed tasks
+	size_t pending;                         ///< started tasks not taken from the queue yet
+	struct oscap_list *engines;             ///< engines polled while waiting
 };
 
 struct xccdf_policy_engine *xccdf_policy_engine_new(char *sys, xccdf_policy_engine_eval_fn eval_fn, void *usr, xccdf_policy_engine_query_fn query_fn)
@@ -45,6 +70,22 @@ struct xccdf_policy_engine *xccdf_policy_engine_new(char *sys, xccdf_policy_engi
 		engine->callback = eval_fn;
 		engine->usr = usr;
 		engine->query_fn = query_fn;
+		engine->thread_safe = false;
+		engine->async_fn = NULL;
+		engine->poll_fn = NULL;
+		engine->max_in_flight = 0;
+		engine->in_flight = 0;
+	}
+	return engine;
+}
+
+struct xccdf_policy_engine *xccdf_policy_engine_new_async(char *sys, xccdf_policy_engine_eval_async_fn eval_fn, xccdf_policy_engine_poll_fn poll_fn, void *usr, xccdf_policy_engine_query_fn query_fn, unsigned int max_in_flight)
+{
+	struct xccdf_policy_engine *engine = xccdf_policy_engine_new(sys, NULL, usr, query_fn);
+	if (engine != NULL) {
+		engine->async_fn = eval_fn;
+		engine->poll_fn = poll_fn;
+		engine->max_in_flight = max_in_flight > 0 ? max_in_flight : 1;
 	}
 	return engine;
 }
@@ -54,12 +95,159 @@ bool xccdf_policy_engine_filter(struct xccdf_policy_engine *engine, const char *
 	return oscap_strcmp(engine->system, sysname) == 0;
 }
 
+void xccdf_policy_engine_set_thread_safe(struct xccdf_policy_engine *engine, bool thread_safe)
+{
+	engine->thread_safe = thread_safe;
+}
+
+bool xccdf_policy_engine_is_thread_safe(const struct xccdf_policy_engine *engine)
+{
+	return engine->thread_safe;
+}
+
+bool xccdf_policy_engine_is_async(const struct xccdf_policy_engine *engine)
+{
+	return engine->async_fn != NULL;
+}
+
+bool xccdf_policy_engine_is_busy(const struct xccdf_policy_engine *engine)
+{
+	return engine->async_fn != NULL && engine->in_flight >= engine->max_in_flight;
+}
+
+struct xccdf_policy_engine_queue *xccdf_policy_engine_queue_new(struct oscap_list *engines)
+{
+	struct xccdf_policy_engine_queue *queue = calloc(1, sizeof(struct xccdf_policy_engine_queue));
+	if (queue == NULL)
+		return NULL;
+	pthread_mutex_init(&queue->lock, NULL);
+	pthread_cond_init(&queue->cond, NULL);
+	queue->engines = engines;
+	return queue;
+}
+
+void xccdf_policy_engine_queue_free(struct xccdf_policy_engine_queue *queue)
+{
+	if (queue == NULL)
+		return;
+	/* all started tasks have to be taken before */
+	pthread_cond_destroy(&queue->cond);
+	pthread_mutex_destroy(&queue->lock);
+	free(queue);
+}
+
+size_t xccdf_policy_engine_queue_pending(const struct xccdf_policy_engine_queue *queue)
+{
+	return queue->pending;
+}
+
+int xccdf_policy_engine_eval_start(struct xccdf_policy_engine *engine, struct xccdf_policy *policy, const char *rule_id, const char *definition_id, const char *href_id, struct oscap_list *value_bindings, struct xccdf_check_import_iterator *check_import_it, struct xccdf_policy_engine_queue *queue, void *arg)
+{
+	struct xccdf_policy_engine_task *task = calloc(1, sizeof(struct xccdf_policy_engine_task));
+	if (task == NULL)
+		return -1;
+	task->queue = queue;
+	task->engine = engine;
+	task->arg = arg;
+	task->binding_it = (struct xccdf_value_binding_iterator *) oscap_iterator_new(value_bindings);
+
+	/* counted before the start, the task may be completed before the function returns */
+	engine->in_flight++;
+	queue->pending++;
+	if (engine->async_fn(policy, rule_id, definition_id, href_id, task->binding_it, check_import_it, task, engine->usr) != 0) {
+		engine->in_flight--;
+		queue->pending--;
+		if (task->binding_it != NULL)
+			xccdf_value_binding_iterator_free(task->binding_it);
+		free(task);
+		return -1;
+	}
+	return 0;
+}
+
+void xccdf_policy_engine_task_complete(struct xccdf_policy_engine_task *task, xccdf_test_result_type_t result)
+{
+	struct xccdf_policy_engine_queue *queue = task->queue;
+
+	pthread_mutex_lock(&queue->lock);
+	task->result = result;
+	task->next = NULL;
+	if (queue->tail != NULL)
+		queue->tail->next = task;
+	else
+		queue->head = task;
+	queue->tail = task;
+	pthread_cond_signal(&queue->cond);
+	pthread_mutex_unlock(&queue->lock);
+}
+
+/* Let the engines with started checks make progress, false if none of them can be polled */
+static bool _xccdf_policy_engine_queue_poll(struct xccdf_policy_engine_queue *queue)
+{
+	bool polled = false;
+	struct oscap_iterator *it = oscap_iterator_new(queue->engines);
+	while (oscap_iterator_has_more(it)) {
+		struct xccdf_policy_engine *engine = oscap_iterator_next(it);
+		if (engine->in_flight > 0 && engine->poll_fn != NULL) {
+			engine->poll_fn(engine->usr);
+			polled = true;
+		}
+	}
+	oscap_iterator_free(it);
+	return polled;
+}
+
+void *xccdf_policy_engine_queue_wait(struct xccdf_policy_engine_queue *queue, xccdf_test_result_type_t *result)
+{
+	struct xccdf_policy_engine_task *task;
+	void *arg;
+
+	if (queue->pending == 0)
+		return NULL;
+
+	pthread_mutex_lock(&queue->lock);
+	while (queue->head == NULL) {
+		pthread_mutex_unlock(&queue->lock);
+		bool polled = _xccdf_policy_engine_queue_poll(queue);
+		pthread_mutex_lock(&queue->lock);
+		/* the engines which can't be polled complete their checks from their threads */
+		if (queue->head == NULL && !polled)
+			pthread_cond_wait(&queue->cond, &queue->lock);
+	}
+	task = queue->head;
+	queue->head = task->next;
+	if (queue->head == NULL)
+		queue->tail = NULL;
+	pthread_mutex_unlock(&queue->lock);
+
+	queue->pending--;
+	task->engine->in_flight--;
+	*result = task->result;
+	arg = task->arg;
+	if (task->binding_it != NULL)
+		xccdf_value_binding_iterator_free(task->binding_it);
+	free(task);
+	return arg;
+}
+
 xccdf_test_result_type_t xccdf_policy_engine_eval(struct xccdf_policy_engine *engine, struct xccdf_policy *policy, const char *definition_id, const char *href_id, struct oscap_list *value_bindings, struct xccdf_check_import_iterator *check_import_it)
 {
 	xccdf_test_result_type_t ret = XCCDF_RESULT_NOT_CHECKED;
 	if (engine == NULL) {
 		oscap_seterr(OSCAP_EFAMILY_XCCDF, "Unknown callback for given checking system. Set callback first");
 	}
+	else if (engine->async_fn != NULL) {
+		/* a check of an asynchronous engine is started and waited for */
+		struct oscap_list *engines = oscap_list_new();
+		struct xccdf_policy_engine_queue *queue;
+
+		oscap_list_add(engines, engine);
+		queue = xccdf_policy_engine_queue_new(engines);
+		if (queue != NULL && xccdf_policy_engine_eval_start(engine, policy, NULL, definition_id, href_id, value_bindings, check_import_it, queue, NULL) == 0)
+			xccdf_policy_engine_queue_wait(queue, &ret);
+		xccdf_policy_engine_queue_free(queue);
+		oscap_list_free0(engines);
+	}
 	else {
 		struct xccdf_value_binding_iterator * binding_it = (struct xccdf_value_binding_iterator *) oscap_iterator_new(value_bindings);
 		ret = engine->callback(policy, NULL, definition_id, href_id, binding_it, check_import_it, engine->usr);
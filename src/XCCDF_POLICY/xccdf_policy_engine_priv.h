@@ -47,12 +47,86 @@ struct xccdf_policy_engine;
  */
 struct xccdf_policy_engine *xccdf_policy_engine_new(char *sys, xccdf_policy_engine_eval_fn eval_fn, void *usr, xccdf_policy_engine_query_fn query_fn);
 
+/**
+ * Create new asynchronous checking engine structure
+ * @param sys System name of the checking engine
+ * @param eval_fn The function starting the checks
+ * @param poll_fn The function letting the engine make progress, optional
+ * @param usr User data structure
+ * @param query_fn The query function of newly created checking engine
+ * @param max_in_flight Maximum number of checks started at once
+ * @returns newly created checking engine
+ */
+struct xccdf_policy_engine *xccdf_policy_engine_new_async(char *sys, xccdf_policy_engine_eval_async_fn eval_fn, xccdf_policy_engine_poll_fn poll_fn, void *usr, xccdf_policy_engine_query_fn query_fn, unsigned int max_in_flight);
+
 /**
  * Filter function returning true if given callback is for the given checking engine,
  * false otherwise.
  */
 bool xccdf_policy_engine_filter(struct xccdf_policy_engine *cb, const char *sysname);
 
+/**
+ * Declare whether the eval function of the checking engine can be called by concurrent threads
+ * @memberof xccdf_policy_engine
+ */
+void xccdf_policy_engine_set_thread_safe(struct xccdf_policy_engine *engine, bool thread_safe);
+
+/**
+ * Return true if the eval function of the checking engine can be called by concurrent threads
+ * @memberof xccdf_policy_engine
+ */
+bool xccdf_policy_engine_is_thread_safe(const struct xccdf_policy_engine *engine);
+
+/**
+ * Return true if the checks of the checking engine are started and completed later
+ * @memberof xccdf_policy_engine
+ */
+bool xccdf_policy_engine_is_async(const struct xccdf_policy_engine *engine);
+
+/**
+ * Return true if the asynchronous checking engine has as many checks started as it allows
+ * @memberof xccdf_policy_engine
+ */
+bool xccdf_policy_engine_is_busy(const struct xccdf_policy_engine *engine);
+
+/**
+ * Queue of the completed checks of asynchronous checking engines. The checks are
+ * started and taken from the queue by a single thread, the engines complete them
+ * from any thread.
+ */
+struct xccdf_policy_engine_queue;
+
+/**
+ * Create a queue for the checks of asynchronous engines
+ * @param engines the engines polled while waiting, not owned by the queue
+ */
+struct xccdf_policy_engine_queue *xccdf_policy_engine_queue_new(struct oscap_list *engines);
+
+/**
+ * Free the queue, all the started checks have to be taken from it before
+ */
+void xccdf_policy_engine_queue_free(struct xccdf_policy_engine_queue *queue);
+
+/**
+ * Return the number of started checks which weren't taken from the queue yet
+ */
+size_t xccdf_policy_engine_queue_pending(const struct xccdf_policy_engine_queue *queue);
+
+/**
+ * Start a check of the asynchronous checking engine, its completion is taken
+ * from the queue by xccdf_policy_engine_queue_wait.
+ * @param arg returned by xccdf_policy_engine_queue_wait for the check
+ * @returns 0 if the check was started, -1 otherwise
+ */
+int xccdf_policy_engine_eval_start(struct xccdf_policy_engine *engine, struct xccdf_policy *policy, const char *rule_id, const char *definition_id, const char *href_id, struct oscap_list *value_bindings, struct xccdf_check_import_iterator *check_import_it, struct xccdf_policy_engine_queue *queue, void *arg);
+
+/**
+ * Wait until a started check is completed, polling the engines which can be polled
+ * @param result result of the check
+ * @returns arg of the completed check, NULL if there is no started check
+ */
+void *xccdf_policy_engine_queue_wait(struct xccdf_policy_engine_queue *queue, xccdf_test_result_type_t *result);
+
 /**
  * Execute the eval function of the given checking engine
  * @memberof xccdf_policy_engine
@@ -62,7 +136,7 @@ bool xccdf_policy_engine_filter(struct xccdf_policy_engine *cb, const char *sysn
  * @param href_id The @href attribute of check-content-ref
  * @param value_bindings Value binding
  * @param check_import_it Check imports
- * @returns result of checking engine evaluation
+ * @returns result of checking engine evaluation, a check of an asynchronous engine is waited for
  */
 xccdf_test_result_type_t xccdf_policy_engine_eval(struct xccdf_policy_engine *engine, struct xccdf_policy *policy, const char *definition_id, const char *href_id, struct oscap_list *value_bindings, struct xccdf_check_import_iterator *check_import_it);
 
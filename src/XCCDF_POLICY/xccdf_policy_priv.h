@@ -44,6 +44,7 @@ struct xccdf_policy_model {
 	struct oscap_list       * engines;      ///< Callbacks for checking engines (see xccdf_policy_engine)
 
 	struct cpe_session *cpe;
+	struct oscap_htable *item_results;      ///< Caches applicability of items [item id -> bool]
 };
 
 /**
@@ -72,6 +73,19 @@ struct xccdf_policy {
 	struct oscap_htable		*selected_final;
 	/* The hash-table contains the latest refine-rule for specified item-id. */
 	struct oscap_htable		*refine_rules_internal;
+	/* Rules to be reported in document order once their checks are evaluated concurrently. */
+	struct oscap_list		*rule_steps;
+	/* The latest setvalue and refine-value of the profile for given value-id,
+	 * built on the first lookup and again when the profile lists grow. */
+	struct oscap_htable		*setvalues_index;
+	struct oscap_htable		*refine_values_index;
+	int				setvalues_indexed;
+	int				refine_values_indexed;
+	/* Readable titles and descriptions of items with the substitutions resolved,
+	 * dropped when the values of the profile are refined further. */
+	struct oscap_htable		*readable_texts;
+	int				readable_texts_setvalues;
+	int				readable_texts_refine_values;
 };
 
 
@@ -110,6 +124,14 @@ int xccdf_policy_rule_result_remediate(struct xccdf_policy *policy, struct xccdf
  */
 int xccdf_policy_check_evaluate(struct xccdf_policy * policy, struct xccdf_check * check);
 
+/**
+ * Tell all the checking engines that the system was changed, e.g. by a fix,
+ * so that the checks evaluated next don't use what was read before.
+ * @memberof xccdf_policy
+ * @param policy XCCDF Policy
+ */
+void xccdf_policy_system_changed(struct xccdf_policy *policy);
+
 /**
  * Remediate all rule-results in the given result, with settings of given policy.
  * @memberof xccdf_policy
@@ -136,5 +158,22 @@ int xccdf_policy_report_cb(struct xccdf_policy *policy, const char *sysname, voi
  */
 struct xccdf_benchmark *xccdf_policy_get_benchmark(const struct xccdf_policy *policy);
 
+/**
+ * Build the lookup tables of the profile setvalues and refine-values in advance,
+ * so that the values of the policy may be resolved by several threads at once.
+ * @memberof xccdf_policy
+ * @param policy XCCDF Policy
+ */
+void xccdf_policy_index_values(struct xccdf_policy *policy);
+
+/**
+ * Decide the applicability of the groups and of the rules to be evaluated
+ * before the scan. The items of a group which isn't applicable are not
+ * applicable either, their platforms are never evaluated.
+ * @memberof xccdf_policy
+ * @param policy XCCDF Policy
+ */
+void xccdf_policy_resolve_applicability(struct xccdf_policy *policy);
+
 
 #endif
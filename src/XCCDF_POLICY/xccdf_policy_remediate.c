@@ -34,9 +34,11 @@
 #ifdef OS_WINDOWS
 #include <io.h>
 #else
+#include <fcntl.h>
 #include <unistd.h>
 #endif
 
+#include <pthread.h>
 #include <libxml/tree.h>
 #include <pcre.h>
 
@@ -48,6 +50,7 @@
 #include "xccdf_policy_model_priv.h"
 #include "public/xccdf_policy.h"
 #include "oscap_helpers.h"
+#include "common/oscap_threadpool.h"
 
 static int _rule_add_info_message(struct xccdf_rule_result *rr, ...)
 {
@@ -386,6 +389,13 @@ static inline int _xccdf_fix_decode_xml(struct xccdf_fix *fix, char **result)
 }
 
 #if defined(unix) || defined(__unix__) || defined(__unix)
+/*
+ * The fixes may be executed by several threads at once. The descriptors of
+ * the temporary file and of the pipe are created and marked close-on-exec
+ * under the lock, so that they aren't inherited by the fix of another thread.
+ */
+static pthread_mutex_t _xccdf_fix_fork_lock = PTHREAD_MUTEX_INITIALIZER;
+
 static inline int _xccdf_fix_execute(struct xccdf_rule_result *rr, struct xccdf_fix *fix)
 {
 	if (rr == NULL) {
@@ -418,16 +428,20 @@ static inline int _xccdf_fix_execute(struct xccdf_rule_result *rr, struct xccdf_
 	// TODO: Directory and files shall be labeled with SELinux to prevent
 	// confined processes with less priviledges to transit to oscap domain
 	// and become basically unconfined.
+	pthread_mutex_lock(&_xccdf_fix_fork_lock);
 	char *temp_file = NULL;
 	int fd = oscap_acquire_temp_file(temp_dir, "fix-XXXXXXXX", &temp_file);
 	if (fd == -1) {
+		pthread_mutex_unlock(&_xccdf_fix_fork_lock);
 		_rule_add_info_message(rr, "mkstemp failed: %s", strerror(errno));
 		goto cleanup;
 	}
 
 	if (_write_text_to_fd(fd, fix_text) != 0) {
+		pthread_mutex_unlock(&_xccdf_fix_fork_lock);
 		_rule_add_info_message(rr, "Could not write to the temp file: %s", strerror(errno));
 		(void) close(fd);
+		free(temp_file);
 		goto cleanup;
 	}
 
@@ -436,11 +450,16 @@ static inline int _xccdf_fix_execute(struct xccdf_rule_result *rr, struct xccdf_
 
 	int pipefd[2];
 	if (pipe(pipefd) == -1) {
+		pthread_mutex_unlock(&_xccdf_fix_fork_lock);
 		_rule_add_info_message(rr, "Could not create pipe: %s", strerror(errno));
+		free(temp_file);
 		goto cleanup;
 	}
+	(void) fcntl(pipefd[0], F_SETFD, FD_CLOEXEC);
+	(void) fcntl(pipefd[1], F_SETFD, FD_CLOEXEC);
 
 	int fork_result = fork();
+	pthread_mutex_unlock(&_xccdf_fix_fork_lock);
 	if (fork_result >= 0) {
 		/* fork succeded */
 		if (fork_result == 0) {
@@ -508,54 +527,51 @@ static inline int _xccdf_fix_execute(struct xccdf_rule_result *rr, struct xccdf_
 }
 #endif
 
-int xccdf_policy_rule_result_remediate(struct xccdf_policy *policy, struct xccdf_rule_result *rr, struct xccdf_fix *fix, struct xccdf_result *test_result)
+/* Choose the fix of a failed rule-result and resolve its text, NULL if there is no fix to execute */
+static struct xccdf_fix *_xccdf_policy_rule_result_prepare_fix(struct xccdf_policy *policy, struct xccdf_rule_result *rr, struct xccdf_fix *fix, struct xccdf_result *test_result)
 {
-	if (policy == NULL || rr == NULL)
-		return 1;
-	if (xccdf_rule_result_get_result(rr) != XCCDF_RESULT_FAIL)
-		return 0;
-
-	// if a miscellaneous error happens (fix unsuitable or if we want to skip it for any reason
-	// we set misc_error to one, and the fix will be reported as error (and not skipped without log like before)
-	int misc_error=0;
-
 	if (fix == NULL) {
 		fix = _find_suitable_fix(policy, rr);
 		if (fix == NULL) {
 			// We want to append xccdf:message about missing fix.
 			_rule_add_info_message(rr, "No suitable fix found.");
 			xccdf_rule_result_set_result(rr, XCCDF_RESULT_FAIL);
-			misc_error=1;
+			return NULL;
 		}
 	}
 
+	/* Initialize the fix. */
+	struct xccdf_fix *cfix = xccdf_fix_clone(fix);
+	int res = xccdf_policy_resolve_fix_substitution(policy, cfix, rr, test_result);
+	xccdf_rule_result_add_fix(rr, cfix);
+	if (res != 0) {
+		_rule_add_info_message(rr, "Fix execution was aborted: Text substitution failed.");
+		xccdf_rule_result_set_result(rr, XCCDF_RESULT_ERROR);
+		return NULL;
+	}
+	return cfix;
+}
+
+static bool _xccdf_policy_rule_result_execute_fix(struct xccdf_rule_result *rr, struct xccdf_fix *cfix)
+{
+	/* Execute the fix. */
+	if (_xccdf_fix_execute(rr, cfix) != 0) {
+		_rule_add_info_message(rr, "Fix was not executed. Execution was aborted.");
+		xccdf_rule_result_set_result(rr, XCCDF_RESULT_ERROR);
+		return false;
+	}
+	return true;
+}
+
+/* Report the rule and verify the executed fix by evaluating the check of the rule again */
+static int _xccdf_policy_rule_result_verify_fix(struct xccdf_policy *policy, struct xccdf_rule_result *rr, bool executed)
+{
 	struct xccdf_check *check = NULL;
 	struct xccdf_check_iterator *check_it = xccdf_rule_result_get_checks(rr);
 	while (xccdf_check_iterator_has_more(check_it))
 		check = xccdf_check_iterator_next(check_it);
 	xccdf_check_iterator_free(check_it);
 
-	if(misc_error == 0){
-		/* Initialize the fix. */
-		struct xccdf_fix *cfix = xccdf_fix_clone(fix);
-		int res = xccdf_policy_resolve_fix_substitution(policy, cfix, rr, test_result);
-		xccdf_rule_result_add_fix(rr, cfix);
-		if (res != 0) {
-			_rule_add_info_message(rr, "Fix execution was aborted: Text substitution failed.");
-			xccdf_rule_result_set_result(rr, XCCDF_RESULT_ERROR);
-			misc_error=1;
-		}else{
-
-			/* Execute the fix. */
-			res = _xccdf_fix_execute(rr, cfix);
-			if (res != 0) {
-				_rule_add_info_message(rr, "Fix was not executed. Execution was aborted.");
-				xccdf_rule_result_set_result(rr, XCCDF_RESULT_ERROR);
-				misc_error=1;
-			}
-		}
-	}
-
 	/* We report rule during remediation even if fix isn't executed due to a miscellaneous error */
 	int report = 0;
 	struct xccdf_rule *rule = _lookup_rule_by_rule_result(policy, rr);
@@ -569,7 +585,7 @@ int xccdf_policy_rule_result_remediate(struct xccdf_policy *policy, struct xccdf
 			return report;
 	}
 
-	if(misc_error == 0){
+	if (executed) {
 		/* Verify fix if applied by calling OVAL again */
 		if (check == NULL) {
 			xccdf_rule_result_set_result(rr, XCCDF_RESULT_ERROR);
@@ -590,9 +606,289 @@ int xccdf_policy_rule_result_remediate(struct xccdf_policy *policy, struct xccdf
 	return rule == NULL ? 0 : xccdf_policy_report_cb(policy, XCCDF_POLICY_OUTCB_END, (void *) rr);
 }
 
+int xccdf_policy_rule_result_remediate(struct xccdf_policy *policy, struct xccdf_rule_result *rr, struct xccdf_fix *fix, struct xccdf_result *test_result)
+{
+	if (policy == NULL || rr == NULL)
+		return 1;
+	if (xccdf_rule_result_get_result(rr) != XCCDF_RESULT_FAIL)
+		return 0;
+
+	// if a miscellaneous error happens (fix unsuitable or if we want to skip it for any reason
+	// the fix will be reported as error (and not skipped without log like before)
+	struct xccdf_fix *cfix = _xccdf_policy_rule_result_prepare_fix(policy, rr, fix, test_result);
+	bool executed = cfix != NULL && _xccdf_policy_rule_result_execute_fix(rr, cfix);
+	if (executed)
+		xccdf_policy_system_changed(policy);
+
+	return _xccdf_policy_rule_result_verify_fix(policy, rr, executed);
+}
+
+#define XCCDF_POLICY_REMEDIATE_MAX_JOBS 64
+
+/**
+ * A fix of a failed rule-result in a batch of fixes executed at once. The fixes
+ * of a batch don't mention the same paths, the rules are reported and the fixes
+ * verified in document order once the whole batch is executed.
+ */
+struct xccdf_policy_fix_run {
+	struct xccdf_rule_result *rr;
+	struct xccdf_fix *fix;          ///< resolved fix, NULL if there is no fix to execute
+	struct oscap_list *paths;       ///< paths mentioned by the fix, NULL if the fix has to be executed alone
+	bool executed;
+};
+
+struct xccdf_policy_remediate_pool {
+	struct xccdf_policy_fix_run **runs;
+	size_t count;
+	size_t size;
+	size_t next;                    ///< first run which isn't taken by a thread
+	pthread_mutex_t lock;
+};
+
+/* Number of fixes executed at once by oscap xccdf eval --remediate, the fixes are executed one by one if it is 1 */
+static size_t _xccdf_policy_remediate_jobs(void)
+{
+	return oscap_threadpool_jobs("OSCAP_REMEDIATE_JOBS", 1, XCCDF_POLICY_REMEDIATE_MAX_JOBS);
+}
+
+/**
+ * Only the fixes which don't need a reboot, declare low disruption and aren't
+ * complex may be executed together with other fixes. Installing packages and
+ * updates is left to run alone, the package managers take a global lock.
+ */
+static bool _xccdf_fix_is_concurrent(const struct xccdf_fix *fix)
+{
+	if (xccdf_fix_get_reboot(fix))
+		return false;
+
+	xccdf_level_t disruption = xccdf_fix_get_disruption(fix);
+	if (disruption != XCCDF_LOW && disruption != XCCDF_INFO)
+		return false;
+
+	xccdf_level_t complexity = xccdf_fix_get_complexity(fix);
+	if (complexity == XCCDF_MEDIUM || complexity == XCCDF_HIGH)
+		return false;
+
+	switch (xccdf_fix_get_strategy(fix)) {
+	case XCCDF_STRATEGY_PATCH:
+	case XCCDF_STRATEGY_UPDATE:
+	case XCCDF_STRATEGY_COMBINATION:
+		return false;
+	default:
+		return true;
+	}
+}
+
+static inline bool _is_path_char(char c)
+{
+	return isalnum((unsigned char) c) || strchr("._-+@%~:", c) != NULL;
+}
+
+/* Paths of the executables and devices are only read by the fixes */
+static const char *const _shared_path_prefixes[] = {
+	"/dev/", "/proc/", "/bin/", "/sbin/", "/usr/bin/", "/usr/sbin/", NULL
+};
+
+/* Absolute paths written literally in the script of the fix */
+static struct oscap_list *_xccdf_fix_get_paths(const struct xccdf_fix *fix)
+{
+	struct oscap_list *paths = oscap_list_new();
+	const char *text = xccdf_fix_get_content(fix);
+	if (text == NULL)
+		return paths;
+
+	for (const char *p = text; *p != '\0'; p++) {
+		// Paths following a variable expansion or a relative path are skipped
+		if (*p != '/' || (p > text && (_is_path_char(p[-1]) || strchr("/$})", p[-1]) != NULL)))
+			continue;
+		size_t len = 1;
+		while (p[len] == '/' || _is_path_char(p[len]))
+			len++;
+		const char *end = p + len;
+		while (len > 1 && p[len - 1] == '/')
+			len--;
+
+		bool shared = (len == 1);
+		for (int i = 0; !shared && _shared_path_prefixes[i] != NULL; i++)
+			shared = strncmp(p, _shared_path_prefixes[i], strlen(_shared_path_prefixes[i])) == 0;
+		if (!shared) {
+			char *path = malloc(len + 1);
+			memcpy(path, p, len);
+			path[len] = '\0';
+			oscap_list_add(paths, path);
+		}
+		p = end - 1;
+	}
+	return paths;
+}
+
+/* The paths conflict if they are the same or one of them is a directory containing the other */
+static bool _paths_conflict(const char *a, const char *b)
+{
+	size_t a_len = strlen(a);
+	size_t b_len = strlen(b);
+	if (a_len > b_len)
+		return _paths_conflict(b, a);
+	return strncmp(a, b, a_len) == 0 && (b[a_len] == '\0' || b[a_len] == '/');
+}
+
+static bool _xccdf_policy_fix_run_conflicts(const struct xccdf_policy_remediate_pool *batch, const struct xccdf_policy_fix_run *run)
+{
+	bool conflict = false;
+	struct oscap_iterator *it = oscap_iterator_new(run->paths);
+	while (!conflict && oscap_iterator_has_more(it)) {
+		const char *path = oscap_iterator_next(it);
+		for (size_t i = 0; !conflict && i < batch->count; i++) {
+			if (batch->runs[i]->paths == NULL)
+				continue;
+			struct oscap_iterator *batch_it = oscap_iterator_new(batch->runs[i]->paths);
+			while (!conflict && oscap_iterator_has_more(batch_it))
+				conflict = _paths_conflict(path, oscap_iterator_next(batch_it));
+			oscap_iterator_free(batch_it);
+		}
+	}
+	oscap_iterator_free(it);
+	return conflict;
+}
+
+static void *_xccdf_policy_remediate_thread(void *arg)
+{
+	struct xccdf_policy_remediate_pool *pool = arg;
+	struct xccdf_policy_fix_run *run;
+
+	for (;;) {
+		pthread_mutex_lock(&pool->lock);
+		if (pool->next == pool->count) {
+			pthread_mutex_unlock(&pool->lock);
+			break;
+		}
+		run = pool->runs[pool->next++];
+		pthread_mutex_unlock(&pool->lock);
+
+		if (run->fix != NULL)
+			run->executed = _xccdf_policy_rule_result_execute_fix(run->rr, run->fix);
+	}
+
+	return NULL;
+}
+
+/* Execute the fixes of the batch at once, then report and verify them one by one */
+static void _xccdf_policy_remediate_batch(struct xccdf_policy *policy, struct xccdf_policy_remediate_pool *batch, size_t jobs)
+{
+	pthread_t threads[XCCDF_POLICY_REMEDIATE_MAX_JOBS];
+	size_t i, started = 0;
+
+	if (batch->count == 0)
+		return;
+	if (jobs > batch->count)
+		jobs = batch->count;
+	dI("Executing %zu fixes using %zu threads.", batch->count, jobs);
+
+	batch->next = 0;
+	pthread_mutex_init(&batch->lock, NULL);
+	for (i = 1; i < jobs; i++) {
+		int err = pthread_create(&threads[started], NULL, _xccdf_policy_remediate_thread, batch);
+
+		if (err != 0) {
+			dW("Can't start a fix execution thread: %s.", strerror(err));
+			break;
+		}
+		started++;
+	}
+	/* the calling thread takes part too */
+	_xccdf_policy_remediate_thread(batch);
+
+	for (i = 0; i < started; i++)
+		pthread_join(threads[i], NULL);
+	pthread_mutex_destroy(&batch->lock);
+
+	for (i = 0; i < batch->count; i++) {
+		if (batch->runs[i]->executed) {
+			xccdf_policy_system_changed(policy);
+			break;
+		}
+	}
+	for (i = 0; i < batch->count; i++) {
+		struct xccdf_policy_fix_run *run = batch->runs[i];
+		_xccdf_policy_rule_result_verify_fix(policy, run->rr, run->executed);
+		oscap_list_free(run->paths, free);
+		free(run);
+	}
+	batch->count = 0;
+}
+
+static int _xccdf_policy_remediate_batch_add(struct xccdf_policy_remediate_pool *batch, struct xccdf_policy_fix_run *run)
+{
+	if (batch->count == batch->size) {
+		size_t size = batch->size == 0 ? 16 : batch->size * 2;
+		struct xccdf_policy_fix_run **runs = realloc(batch->runs, size * sizeof(struct xccdf_policy_fix_run *));
+		if (runs == NULL)
+			return -1;
+		batch->runs = runs;
+		batch->size = size;
+	}
+	batch->runs[batch->count++] = run;
+	return 0;
+}
+
+/**
+ * Split the fixes into batches in document order. A fix which has to be
+ * executed alone or which mentions a path of a fix already in the batch
+ * starts a new batch.
+ */
+static void _xccdf_policy_remediate_concurrently(struct xccdf_policy *policy, struct xccdf_result *result, size_t jobs)
+{
+	struct xccdf_policy_remediate_pool batch;
+
+	memset(&batch, 0, sizeof(batch));
+	struct xccdf_rule_result_iterator *rr_it = xccdf_result_get_rule_results(result);
+	while (xccdf_rule_result_iterator_has_more(rr_it)) {
+		struct xccdf_rule_result *rr = xccdf_rule_result_iterator_next(rr_it);
+		if (xccdf_rule_result_get_result(rr) != XCCDF_RESULT_FAIL)
+			continue;
+
+		struct xccdf_policy_fix_run *run = calloc(1, sizeof(struct xccdf_policy_fix_run));
+		if (run == NULL) {
+			xccdf_policy_rule_result_remediate(policy, rr, NULL, result);
+			continue;
+		}
+		run->rr = rr;
+		run->fix = _xccdf_policy_rule_result_prepare_fix(policy, rr, NULL, result);
+		if (run->fix == NULL)
+			run->paths = oscap_list_new();
+		else if (_xccdf_fix_is_concurrent(run->fix))
+			run->paths = _xccdf_fix_get_paths(run->fix);
+
+		if (run->paths == NULL || _xccdf_policy_fix_run_conflicts(&batch, run))
+			_xccdf_policy_remediate_batch(policy, &batch, jobs);
+		if (_xccdf_policy_remediate_batch_add(&batch, run) != 0) {
+			_xccdf_policy_remediate_batch(policy, &batch, jobs);
+			run->executed = run->fix != NULL && _xccdf_policy_rule_result_execute_fix(rr, run->fix);
+			if (run->executed)
+				xccdf_policy_system_changed(policy);
+			_xccdf_policy_rule_result_verify_fix(policy, rr, run->executed);
+			oscap_list_free(run->paths, free);
+			free(run);
+			continue;
+		}
+		if (run->paths == NULL)
+			_xccdf_policy_remediate_batch(policy, &batch, jobs);
+	}
+	xccdf_rule_result_iterator_free(rr_it);
+	_xccdf_policy_remediate_batch(policy, &batch, jobs);
+	free(batch.runs);
+}
+
 int xccdf_policy_remediate(struct xccdf_policy *policy, struct xccdf_result *result)
 {
 	__attribute__nonnull__(result);
+	size_t jobs = _xccdf_policy_remediate_jobs();
+	if (jobs > 1) {
+		_xccdf_policy_remediate_concurrently(policy, result, jobs);
+		xccdf_result_set_end_time_current(result);
+		return 0;
+	}
+
 	struct xccdf_rule_result_iterator *rr_it = xccdf_result_get_rule_results(result);
 	while (xccdf_rule_result_iterator_has_more(rr_it)) {
 		struct xccdf_rule_result *rr = xccdf_rule_result_iterator_next(rr_it);
@@ -658,52 +954,52 @@ static int _write_fix_missing_warning_to_fd(const char *sys, int output_fd, stru
 	}
 }
 
-struct blueprint_entries {
-	const char *pattern;
-	struct oscap_list *list;
-	pcre *re;
+/* Patterns splitting the osbuild blueprint fixes, the capture group is added to the list of the same index */
+static const char *const _blueprint_patterns[] = {
+	"\\[customizations\\.services\\]\\s+enabled[=\\s]+\\[([^\\]]+)\\]\\s+",
+	"\\[customizations\\.services\\]\\s+disabled[=\\s]+\\[([^\\]]+)\\]\\s+",
+	"\\[customizations\\.kernel\\]\\s+append[=\\s\"]+([^\"]+)[\\s\"]+",
+	// We do this only to pop the 'distro' entry to the top of the generic list,
+	// effectively placing it to the root of the TOML document.
+	"\\s+(distro[=\\s\"]+[^\"]+[\\s\"]+)",
 };
+#define BLUEPRINT_PATTERNS (sizeof(_blueprint_patterns) / sizeof(_blueprint_patterns[0]))
 
-static inline int _parse_blueprint_fix(const char *fix_text, struct oscap_list *generic, struct oscap_list *services_enable, struct oscap_list *services_disable, struct oscap_list *kernel_append)
+// TODO: Tolerate different indentation styles in this regex
+static const char *const _ansible_variable_pattern =
+	"- name: XCCDF Value [^ ]+ # promote to variable\n  set_fact:\n"
+	"    ([^:]+): (.+)\n  tags:\n    - always\n";
+
+/* The patterns are compiled once for all fixes of the generated document */
+static pcre *_compile_fix_pattern(const char *pattern)
 {
 	const char *err;
 	int errofs;
-	int ret = 0;
 
-	struct blueprint_entries tab[] = {
-		{"\\[customizations\\.services\\]\\s+enabled[=\\s]+\\[([^\\]]+)\\]\\s+", services_enable, NULL},
-		{"\\[customizations\\.services\\]\\s+disabled[=\\s]+\\[([^\\]]+)\\]\\s+", services_disable, NULL},
-		{"\\[customizations\\.kernel\\]\\s+append[=\\s\"]+([^\"]+)[\\s\"]+", kernel_append, NULL},
-		// We do this only to pop the 'distro' entry to the top of the generic list,
-		// effectively placing it to the root of the TOML document.
-		{"\\s+(distro[=\\s\"]+[^\"]+[\\s\"]+)", generic, NULL},
-		{NULL, NULL, NULL}
-	};
+	pcre *re = pcre_compile(pattern, PCRE_UTF8, &err, &errofs, NULL);
+	if (re == NULL)
+		dE("Unable to compile /%s/ regex pattern, pcre_compile() returned error (offset: %d): '%s'.\n", pattern, errofs, err);
+	return re;
+}
 
-	for (int i = 0; tab[i].pattern != NULL; i++) {
-		tab[i].re = pcre_compile(tab[i].pattern, PCRE_UTF8, &err, &errofs, NULL);
-		if (tab[i].re == NULL) {
-			dE("Unable to compile /%s/ regex pattern, pcre_compile() returned error (offset: %d): '%s'.\n", tab[i].pattern, errofs, err);
-			ret = 1;
-			goto exit;
-		}
-	}
+static inline int _parse_blueprint_fix(pcre *const *patterns, const char *fix_text, struct oscap_list *generic, struct oscap_list *services_enable, struct oscap_list *services_disable, struct oscap_list *kernel_append)
+{
+	struct oscap_list *lists[BLUEPRINT_PATTERNS] = {services_enable, services_disable, kernel_append, generic};
 
 	const size_t fix_text_len = strlen(fix_text);
 	size_t start_offset = 0;
 	int ovector[6] = {0};
 
-	for (int i = 0; tab[i].pattern != NULL; i++) {
+	for (size_t i = 0; i < BLUEPRINT_PATTERNS; i++) {
 		while (true) {
-			const int match = pcre_exec(tab[i].re, NULL, fix_text, fix_text_len, start_offset,
+			const int match = pcre_exec(patterns[i], NULL, fix_text, fix_text_len, start_offset,
 			                            0, ovector, sizeof(ovector) / sizeof(ovector[0]));
 			if (match == -1)
 				break;
 
 			if (match != 2) {
 				dE("Expected 1 capture group matches per entry. Found %i!", match - 1);
-				ret = 1;
-				goto exit;
+				return 1;
 			}
 
 			char *val = malloc((ovector[3] - ovector[2] + 1) * sizeof(char));
@@ -711,7 +1007,7 @@ static inline int _parse_blueprint_fix(const char *fix_text, struct oscap_list *
 			val[ovector[3] - ovector[2]] = '\0';
 
 			if (!oscap_list_contains(kernel_append, val, (oscap_cmp_func) oscap_streq)) {
-				oscap_list_prepend(tab[i].list, val);
+				oscap_list_prepend(lists[i], val);
 			} else {
 				free(val);
 			}
@@ -724,29 +1020,11 @@ static inline int _parse_blueprint_fix(const char *fix_text, struct oscap_list *
 		oscap_list_add(generic, strdup(fix_text + start_offset));
 	}
 
-exit:
-	for (int i = 0; tab[i].pattern != NULL; i++)
-		pcre_free(tab[i].re);
-
-	return ret;
+	return 0;
 }
 
-static inline int _parse_ansible_fix(const char *fix_text, struct oscap_list *variables, struct oscap_list *tasks)
+static inline int _parse_ansible_fix(const pcre *re, const char *fix_text, struct oscap_list *variables, struct oscap_list *tasks)
 {
-	// TODO: Tolerate different indentation styles in this regex
-	const char *pattern =
-		"- name: XCCDF Value [^ ]+ # promote to variable\n  set_fact:\n"
-		"    ([^:]+): (.+)\n  tags:\n    - always\n";
-	const char *err;
-	int errofs;
-
-	pcre *re = pcre_compile(pattern, PCRE_UTF8, &err, &errofs, NULL);
-	if (re == NULL) {
-		dE("Unable to compile regex pattern, "
-				"pcre_compile() returned error (offset: %d): '%s'.\n", errofs, err);
-		return 1;
-	}
-
 	// ovector sizing:
 	// 2 elements are used for the whole needle,
 	// 4 elements are used for the 2 capture groups
@@ -765,7 +1043,6 @@ static inline int _parse_ansible_fix(const char *fix_text, struct oscap_list *va
 		if (match != 3) {
 			dE("Expected 2 capture group matches per XCCDF variable. Found %i!",
 				match - 1);
-			pcre_free(re);
 			return 1;
 		}
 
@@ -807,24 +1084,28 @@ static inline int _parse_ansible_fix(const char *fix_text, struct oscap_list *va
 		oscap_list_add(tasks, remediation_part);
 	}
 
-	pcre_free(re);
 	return 0;
 }
 
-static int _xccdf_policy_rule_get_fix_text(struct xccdf_policy *policy, struct xccdf_rule *rule, const char *template, char **fix_text)
+static const struct xccdf_fix *_xccdf_policy_rule_find_fix(struct xccdf_policy *policy, struct xccdf_rule *rule, const char *template)
 {
 	// Ensure that given Rule is selected and applicable (CPE).
 	const bool is_selected = xccdf_policy_is_item_selected(policy, xccdf_rule_get_id(rule));
 	if (!is_selected) {
 		dI("Skipping unselected Rule/@id=\"%s\"", xccdf_rule_get_id(rule));
-		return 0;
+		return NULL;
 	}
 	// Find the most suitable fix.
 	const struct xccdf_fix *fix = _find_fix_for_template(policy, rule, template);
 	if (fix == NULL) {
 		dI("No fix element was found for Rule/@id=\"%s\"", xccdf_rule_get_id(rule));
-		return 0;
+		return NULL;
 	}
+	return fix;
+}
+
+static int _xccdf_policy_rule_render_fix(struct xccdf_policy *policy, struct xccdf_rule *rule, const struct xccdf_fix *fix, char **fix_text)
+{
 	dI("Processing a fix for Rule/@id=\"%s\"", xccdf_rule_get_id(rule));
 
 	// Process Text Substitute within the fix
@@ -847,47 +1128,157 @@ static int _xccdf_policy_rule_get_fix_text(struct xccdf_policy *policy, struct x
 	return 0;
 }
 
-static int _xccdf_policy_rule_generate_fix(struct xccdf_policy *policy, struct xccdf_rule *rule, const char *template, int output_fd, unsigned int current, unsigned int total)
+#define XCCDF_POLICY_FIX_MAX_JOBS 64
+
+/**
+ * A fix of a rule waiting to be written in the order of the rules. The fix
+ * is chosen right away, its text is rendered by the pool of threads.
+ */
+struct xccdf_policy_fix_step {
+	struct xccdf_rule *rule;
+	const struct xccdf_fix *fix;    ///< NULL if the rule isn't selected or there is no fix for the template
+	char *fix_text;
+	int ret;
+	char *error;                    ///< errors of the rendering thread, raised again when the fix is written
+};
+
+struct xccdf_policy_fix_pool {
+	struct xccdf_policy *policy;
+	struct xccdf_policy_fix_step *steps;
+	size_t count;
+	size_t next;                    ///< first step which isn't taken by a thread
+	pthread_mutex_t lock;
+};
+
+/* Number of threads rendering the fixes, the fixes are rendered one by one if it is 1 */
+static size_t _xccdf_policy_fix_jobs(void)
+{
+	return oscap_threadpool_jobs("OSCAP_XCCDF_FIX_JOBS", 0, XCCDF_POLICY_FIX_MAX_JOBS);
+}
+
+/* The error queue is per thread, the errors of the other threads are kept with the step */
+static void _xccdf_policy_fix_pool_run(struct xccdf_policy_fix_pool *pool, bool worker)
 {
-	int ret = _write_fix_header_to_fd(template, output_fd, rule, current, total);
-	if (ret != 0) {
-		return ret;
+	struct xccdf_policy_fix_step *step;
+
+	for (;;) {
+		pthread_mutex_lock(&pool->lock);
+		if (pool->next == pool->count) {
+			pthread_mutex_unlock(&pool->lock);
+			break;
+		}
+		step = &pool->steps[pool->next++];
+		pthread_mutex_unlock(&pool->lock);
+
+		if (step->fix == NULL)
+			continue;
+		step->ret = _xccdf_policy_rule_render_fix(pool->policy, step->rule, step->fix, &step->fix_text);
+		if (worker && oscap_err())
+			step->error = oscap_err_get_full_error();
 	}
-	char *fix_text = NULL;
-	ret = _xccdf_policy_rule_get_fix_text(policy, rule, template, &fix_text);
-	if (fix_text == NULL || ret != 0) {
-		ret = _write_fix_missing_warning_to_fd(template, output_fd, rule);
-	} else {
-		ret = _write_remediation_to_fd_and_free(output_fd, template, fix_text);
+}
+
+static void *_xccdf_policy_fix_thread(void *arg)
+{
+	_xccdf_policy_fix_pool_run(arg, true);
+	return NULL;
+}
+
+/**
+ * Choose the fixes of the rules one by one and render their texts by the pool
+ * of threads. The returned steps are in the order of the rules.
+ */
+static struct xccdf_policy_fix_step *_xccdf_policy_render_fixes(struct xccdf_policy *policy, struct oscap_list *rules_to_fix, const char *template, size_t *count)
+{
+	struct xccdf_policy_fix_pool pool;
+	pthread_t threads[XCCDF_POLICY_FIX_MAX_JOBS];
+	size_t i, jobs, fixes = 0, started = 0;
+
+	memset(&pool, 0, sizeof(pool));
+	pool.policy = policy;
+	pool.steps = calloc(oscap_list_get_itemcount(rules_to_fix) + 1, sizeof(struct xccdf_policy_fix_step));
+	if (pool.steps == NULL)
+		return NULL;
+
+	// CPE applicability and the lookup tables of the values are cached on first use,
+	// they are resolved here so that the threads only read them.
+	struct oscap_iterator *rules_to_fix_it = oscap_iterator_new(rules_to_fix);
+	while (oscap_iterator_has_more(rules_to_fix_it)) {
+		struct xccdf_policy_fix_step *step = &pool.steps[pool.count++];
+		step->rule = (struct xccdf_rule *) oscap_iterator_next(rules_to_fix_it);
+		step->fix = _xccdf_policy_rule_find_fix(policy, step->rule, template);
+		if (step->fix != NULL)
+			fixes++;
 	}
-	if (ret != 0) {
-		return ret;
+	oscap_iterator_free(rules_to_fix_it);
+	xccdf_policy_index_values(policy);
+
+	jobs = _xccdf_policy_fix_jobs();
+	if (jobs > fixes)
+		jobs = fixes;
+	dI("Rendering %zu fixes using %zu threads.", fixes, jobs);
+
+	pthread_mutex_init(&pool.lock, NULL);
+	for (i = 1; i < jobs; i++) {
+		int err = pthread_create(&threads[started], NULL, _xccdf_policy_fix_thread, &pool);
+
+		if (err != 0) {
+			dW("Can't start a fix rendering thread: %s.", strerror(err));
+			break;
+		}
+		started++;
 	}
-	ret = _write_fix_footer_to_fd(template, output_fd, rule);
-	return ret;
+	/* the calling thread takes part too */
+	_xccdf_policy_fix_pool_run(&pool, false);
+
+	for (i = 0; i < started; i++)
+		pthread_join(threads[i], NULL);
+	pthread_mutex_destroy(&pool.lock);
+
+	*count = pool.count;
+	return pool.steps;
 }
 
-static int _xccdf_policy_rule_generate_blueprint_fix(struct xccdf_policy *policy, struct xccdf_rule *rule, const char *template, struct oscap_list *generic, struct oscap_list *services_enable, struct oscap_list *services_disable, struct oscap_list *kernel_append)
+/* Take the rendered text of the step, the errors of the rendering thread are raised in the calling thread */
+static int _xccdf_policy_fix_step_take(struct xccdf_policy_fix_step *step, char **fix_text)
 {
-	char *fix_text = NULL;
-	int ret = _xccdf_policy_rule_get_fix_text(policy, rule, template, &fix_text);
-	if (fix_text == NULL) {
-		return ret;
+	if (step->error != NULL) {
+		oscap_seterr(OSCAP_EFAMILY_OSCAP, "%s", step->error);
+		free(step->error);
+		step->error = NULL;
+	}
+	*fix_text = step->fix_text;
+	step->fix_text = NULL;
+	return step->ret;
+}
+
+static void _xccdf_policy_fix_steps_free(struct xccdf_policy_fix_step *steps, size_t count)
+{
+	for (size_t i = 0; i < count; i++) {
+		free(steps[i].fix_text);
+		free(steps[i].error);
 	}
-	ret = _parse_blueprint_fix(fix_text, generic, services_enable, services_disable, kernel_append);
-	free(fix_text);
-	return ret;
+	free(steps);
 }
 
-static int _xccdf_policy_rule_generate_ansible_fix(struct xccdf_policy *policy, struct xccdf_rule *rule, const char *template, struct oscap_list *variables, struct oscap_list *tasks)
+static int _xccdf_policy_rule_generate_fix(struct xccdf_policy_fix_step *step, const char *template, int output_fd, unsigned int current, unsigned int total)
 {
+	int ret = _write_fix_header_to_fd(template, output_fd, step->rule, current, total);
+	if (ret != 0) {
+		return ret;
+	}
 	char *fix_text = NULL;
-	int ret = _xccdf_policy_rule_get_fix_text(policy, rule, template, &fix_text);
-	if (fix_text == NULL) {
+	ret = _xccdf_policy_fix_step_take(step, &fix_text);
+	if (fix_text == NULL || ret != 0) {
+		free(fix_text);
+		ret = _write_fix_missing_warning_to_fd(template, output_fd, step->rule);
+	} else {
+		ret = _write_remediation_to_fd_and_free(output_fd, template, fix_text);
+	}
+	if (ret != 0) {
 		return ret;
 	}
-	ret = _parse_ansible_fix(fix_text, variables, tasks);
-	free(fix_text);
+	ret = _write_fix_footer_to_fd(template, output_fd, step->rule);
 	return ret;
 }
 
@@ -1158,14 +1549,29 @@ static int _xccdf_policy_generate_fix_blueprint(struct oscap_list *rules_to_fix,
 	struct oscap_list *services_enable = oscap_list_new();
 	struct oscap_list *services_disable = oscap_list_new();
 	struct oscap_list *kernel_append = oscap_list_new();
-	struct oscap_iterator *rules_to_fix_it = oscap_iterator_new(rules_to_fix);
-	while (oscap_iterator_has_more(rules_to_fix_it)) {
-		struct xccdf_rule *rule = (struct xccdf_rule*)oscap_iterator_next(rules_to_fix_it);
-		ret = _xccdf_policy_rule_generate_blueprint_fix(policy, rule, sys, generic, services_enable, services_disable, kernel_append);
+	pcre *patterns[BLUEPRINT_PATTERNS] = {NULL};
+	for (size_t i = 0; i < BLUEPRINT_PATTERNS; i++) {
+		patterns[i] = _compile_fix_pattern(_blueprint_patterns[i]);
+		if (patterns[i] == NULL)
+			ret = 1;
+	}
+	size_t count = 0;
+	struct xccdf_policy_fix_step *steps = ret == 0 ? _xccdf_policy_render_fixes(policy, rules_to_fix, sys, &count) : NULL;
+	if (steps == NULL)
+		ret = 1;
+	for (size_t i = 0; i < count; i++) {
+		char *fix_text = NULL;
+		ret = _xccdf_policy_fix_step_take(&steps[i], &fix_text);
+		if (fix_text != NULL) {
+			ret = _parse_blueprint_fix(patterns, fix_text, generic, services_enable, services_disable, kernel_append);
+			free(fix_text);
+		}
 		if (ret != 0)
 			break;
 	}
-	oscap_iterator_free(rules_to_fix_it);
+	_xccdf_policy_fix_steps_free(steps, count);
+	for (size_t i = 0; i < BLUEPRINT_PATTERNS; i++)
+		pcre_free(patterns[i]);
 
 	struct oscap_iterator *generic_it = oscap_iterator_new(generic);
 	while(oscap_iterator_has_more(generic_it)) {
@@ -1221,14 +1627,23 @@ static int _xccdf_policy_generate_fix_ansible(struct oscap_list *rules_to_fix, s
 	int ret = 0;
 	struct oscap_list *variables = oscap_list_new();
 	struct oscap_list *tasks = oscap_list_new();
-	struct oscap_iterator *rules_to_fix_it = oscap_iterator_new(rules_to_fix);
-	while (oscap_iterator_has_more(rules_to_fix_it)) {
-		struct xccdf_rule *rule = (struct xccdf_rule*)oscap_iterator_next(rules_to_fix_it);
-		ret = _xccdf_policy_rule_generate_ansible_fix(policy, rule, sys, variables, tasks);
+	pcre *re = _compile_fix_pattern(_ansible_variable_pattern);
+	size_t count = 0;
+	struct xccdf_policy_fix_step *steps = re != NULL ? _xccdf_policy_render_fixes(policy, rules_to_fix, sys, &count) : NULL;
+	if (steps == NULL)
+		ret = 1;
+	for (size_t i = 0; i < count; i++) {
+		char *fix_text = NULL;
+		ret = _xccdf_policy_fix_step_take(&steps[i], &fix_text);
+		if (fix_text != NULL) {
+			ret = _parse_ansible_fix(re, fix_text, variables, tasks);
+			free(fix_text);
+		}
 		if (ret != 0)
 			break;
 	}
-	oscap_iterator_free(rules_to_fix_it);
+	_xccdf_policy_fix_steps_free(steps, count);
+	pcre_free(re);
 
 	_write_text_to_fd(output_fd, "  vars:\n");
 	struct oscap_iterator *variables_it = oscap_iterator_new(variables);
@@ -1254,15 +1669,16 @@ static int _xccdf_policy_generate_fix_other(struct oscap_list *rules_to_fix, str
 {
 	int ret = 0;
 	const unsigned int total = oscap_list_get_itemcount(rules_to_fix);
-	unsigned int current = 1;
-	struct oscap_iterator *rules_to_fix_it = oscap_iterator_new(rules_to_fix);
-	while (oscap_iterator_has_more(rules_to_fix_it)) {
-		struct xccdf_rule *rule = (struct xccdf_rule *) oscap_iterator_next(rules_to_fix_it);
-		ret = _xccdf_policy_rule_generate_fix(policy, rule, sys, output_fd, current++, total);
+	size_t count = 0;
+	struct xccdf_policy_fix_step *steps = _xccdf_policy_render_fixes(policy, rules_to_fix, sys, &count);
+	if (steps == NULL)
+		return 1;
+	for (size_t i = 0; i < count; i++) {
+		ret = _xccdf_policy_rule_generate_fix(&steps[i], sys, output_fd, i + 1, total);
 		if (ret != 0)
 			break;
 	}
-	oscap_iterator_free(rules_to_fix_it);
+	_xccdf_policy_fix_steps_free(steps, count);
 	return ret;
 }
 
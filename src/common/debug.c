@@ -133,6 +133,11 @@ oscap_verbosity_levels oscap_verbosity_level_from_cstr(const char *level_name)
 	return oscap_string_to_enum(OSCAP_VERBOSITY_LEVELS, level_name);
 }
 
+bool oscap_debug_enabled(oscap_verbosity_levels level)
+{
+	return __debuglog_fp != NULL && __debuglog_level >= level;
+}
+
 bool oscap_set_verbose(const char *verbosity_level, const char *filename)
 {
 	if (verbosity_level == NULL) {
@@ -187,11 +192,226 @@ static const char *__oscap_path_rstrip(const char *path)
 }
 
 
-static void debug_message_start(int level, int indent)
+/* A message formatted in memory before it is written */
+struct debug_message {
+	char *data;
+	size_t len;
+	size_t alloc;
+	char stack[1024];
+};
+
+static void debug_message_init(struct debug_message *msg)
 {
-	char  l;
+	msg->data = msg->stack;
+	msg->len = 0;
+	msg->alloc = sizeof(msg->stack);
+}
 
-	__LOCK_FP;
+static void debug_message_release(struct debug_message *msg)
+{
+	if (msg->data != msg->stack)
+		free(msg->data);
+}
+
+static void debug_message_vprintf(struct debug_message *msg, const char *fmt, va_list ap)
+{
+	va_list ap2;
+
+	va_copy(ap2, ap);
+	int n = vsnprintf(msg->data + msg->len, msg->alloc - msg->len, fmt, ap2);
+	va_end(ap2);
+	if (n < 0)
+		return;
+	if ((size_t)n >= msg->alloc - msg->len) {
+		size_t alloc = msg->len + n + 1;
+		char *data = msg->data == msg->stack ? malloc(alloc) : realloc(msg->data, alloc);
+
+		if (data == NULL)
+			return;
+		if (msg->data == msg->stack)
+			memcpy(data, msg->stack, msg->len);
+		msg->data = data;
+		msg->alloc = alloc;
+		vsnprintf(msg->data + msg->len, msg->alloc - msg->len, fmt, ap);
+	}
+	msg->len += n;
+}
+
+static void debug_message_printf(struct debug_message *msg, const char *fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	debug_message_vprintf(msg, fmt, ap);
+	va_end(ap);
+}
+
+#if defined(OSCAP_THREAD_SAFE)
+/*
+ * With INFO and DEVEL verbosity the messages are formatted by the calling
+ * thread and copied to a ring buffer, a background thread writes them to
+ * the log. The threads logging don't wait for each other while formatting
+ * nor for the log file, only for the copy. Messages are written whole and
+ * in the order they were queued; the queue is drained at exit and before
+ * an object is dumped. Less verbose runs write synchronously, so warnings
+ * and errors keep their order with the other output of the program.
+ */
+#define DEBUG_RING_SIZE (1024 * 1024)
+
+static struct debug_ring {
+	pthread_mutex_t lock;
+	pthread_cond_t not_empty;
+	pthread_cond_t drained;         ///< signalled whenever the writer frees space
+	char *buf;
+	size_t head;                    ///< where the next message is copied
+	size_t len;                     ///< bytes not written yet
+	bool writing;                   ///< the writer holds a chunk of the buffer
+	bool started;
+	bool disabled;                  ///< the writer can't run, e.g. in a forked child
+	bool stop;
+	pthread_t thread;
+} debug_ring = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.not_empty = PTHREAD_COND_INITIALIZER,
+	.drained = PTHREAD_COND_INITIALIZER,
+};
+
+static void *debug_ring_writer(void *arg)
+{
+	struct debug_ring *ring = arg;
+
+	pthread_mutex_lock(&ring->lock);
+	for (;;) {
+		while (ring->len == 0 && !ring->stop)
+			pthread_cond_wait(&ring->not_empty, &ring->lock);
+		if (ring->len == 0)
+			break;
+
+		size_t tail = (ring->head + DEBUG_RING_SIZE - ring->len) % DEBUG_RING_SIZE;
+		size_t n = ring->len < DEBUG_RING_SIZE - tail ? ring->len : DEBUG_RING_SIZE - tail;
+		ring->writing = true;
+		pthread_mutex_unlock(&ring->lock);
+
+		__LOCK_FP;
+		fwrite(ring->buf + tail, 1, n, __debuglog_fp);
+		__UNLOCK_FP;
+
+		pthread_mutex_lock(&ring->lock);
+		ring->len -= n;
+		ring->writing = false;
+		pthread_cond_broadcast(&ring->drained);
+	}
+	pthread_mutex_unlock(&ring->lock);
+	return NULL;
+}
+
+/* Wait until the queued messages are written, must be called with the ring locked */
+static void debug_ring_drain(struct debug_ring *ring)
+{
+	while (ring->started && (ring->len > 0 || ring->writing))
+		pthread_cond_wait(&ring->drained, &ring->lock);
+}
+
+static void debug_ring_stop(void)
+{
+	pthread_mutex_lock(&debug_ring.lock);
+	if (!debug_ring.started || debug_ring.disabled) {
+		pthread_mutex_unlock(&debug_ring.lock);
+		return;
+	}
+	debug_ring.stop = true;
+	pthread_cond_signal(&debug_ring.not_empty);
+	pthread_mutex_unlock(&debug_ring.lock);
+
+	pthread_join(debug_ring.thread, NULL);
+	debug_ring.started = false;
+}
+
+static void debug_ring_atfork_prepare(void)
+{
+	pthread_mutex_lock(&debug_ring.lock);
+}
+
+static void debug_ring_atfork_parent(void)
+{
+	pthread_mutex_unlock(&debug_ring.lock);
+}
+
+/* the writer doesn't exist in the child, the queued messages are the parent's to write */
+static void debug_ring_atfork_child(void)
+{
+	pthread_mutex_init(&debug_ring.lock, NULL);
+	pthread_cond_init(&debug_ring.not_empty, NULL);
+	pthread_cond_init(&debug_ring.drained, NULL);
+	debug_ring.len = 0;
+	debug_ring.writing = false;
+	debug_ring.started = false;
+	debug_ring.disabled = true;
+}
+
+/* Must be called with the ring locked */
+static bool debug_ring_start(struct debug_ring *ring)
+{
+	if (ring->started)
+		return true;
+	if (ring->disabled)
+		return false;
+
+	if (ring->buf == NULL) {
+		ring->buf = malloc(DEBUG_RING_SIZE);
+		if (ring->buf == NULL) {
+			ring->disabled = true;
+			return false;
+		}
+		pthread_atfork(debug_ring_atfork_prepare, debug_ring_atfork_parent, debug_ring_atfork_child);
+		atexit(debug_ring_stop);
+	}
+	if (pthread_create(&ring->thread, NULL, debug_ring_writer, ring) != 0) {
+		ring->disabled = true;
+		return false;
+	}
+	ring->started = true;
+	ring->stop = false;
+	return true;
+}
+
+/* Queue the message for the writer, false if it has to be written by the caller */
+static bool debug_ring_push(const char *data, size_t len)
+{
+	struct debug_ring *ring = &debug_ring;
+
+	if (len > DEBUG_RING_SIZE)
+		return false;
+
+	pthread_mutex_lock(&ring->lock);
+	if (!debug_ring_start(ring)) {
+		pthread_mutex_unlock(&ring->lock);
+		return false;
+	}
+	while (DEBUG_RING_SIZE - ring->len < len)
+		pthread_cond_wait(&ring->drained, &ring->lock);
+
+	size_t n = len < DEBUG_RING_SIZE - ring->head ? len : DEBUG_RING_SIZE - ring->head;
+	memcpy(ring->buf + ring->head, data, n);
+	memcpy(ring->buf, data + n, len - n);
+	ring->head = (ring->head + len) % DEBUG_RING_SIZE;
+	ring->len += len;
+	pthread_cond_signal(&ring->not_empty);
+	pthread_mutex_unlock(&ring->lock);
+	return true;
+}
+
+static void debug_ring_flush(void)
+{
+	pthread_mutex_lock(&debug_ring.lock);
+	debug_ring_drain(&debug_ring);
+	pthread_mutex_unlock(&debug_ring.lock);
+}
+#endif /* OSCAP_THREAD_SAFE */
+
+static void debug_message_start(struct debug_message *msg, int level, int indent)
+{
+	char  l;
 
 	switch (level) {
 	case DBG_E:
@@ -209,13 +429,13 @@ static void debug_message_start(int level, int indent)
 	default:
 		l = '0';
 	}
-	fprintf(__debuglog_fp, "%c: %s: ", l, GET_PROGRAM_NAME);
+	debug_message_printf(msg, "%c: %s: ", l, GET_PROGRAM_NAME);
 	for (int i = 0; i < indent; i++) {
-		fprintf(__debuglog_fp, "  ");
+		debug_message_printf(msg, "  ");
 	}
 }
 
-static void debug_message_devel_metadata(const char *file, const char *fn, size_t line)
+static void debug_message_devel_metadata(struct debug_message *msg, const char *file, const char *fn, size_t line)
 {
 	const char *f = __oscap_path_rstrip(file);
 #if defined(OSCAP_THREAD_SAFE)
@@ -232,25 +452,34 @@ static void debug_message_devel_metadata(const char *file, const char *fn, size_
 	/* XXX: non-portable usage of pthread_t */
 	unsigned long long tid = (unsigned long long) thread;
 #endif
-	fprintf(__debuglog_fp, " [%s(%ld):%s(%llx):%s:%zu:%s]",
+	debug_message_printf(msg, " [%s(%ld):%s(%llx):%s:%zu:%s]",
 		GET_PROGRAM_NAME, (long) getpid(), thread_name,
 		tid, f, line, fn);
 #else
-	fprintf(__debuglog_fp, " [%ld:%s:%zu:%s]", (long) getpid(),
+	debug_message_printf(msg, " [%ld:%s:%zu:%s]", (long) getpid(),
 		f, line, fn);
 #endif
 }
 
-static void debug_message_end()
+static void debug_message_end(struct debug_message *msg)
 {
-	fputc('\n', __debuglog_fp);
+	debug_message_printf(msg, "\n");
+#if defined(OSCAP_THREAD_SAFE)
+	if (__debuglog_level >= DBG_I && debug_ring_push(msg->data, msg->len)) {
+		debug_message_release(msg);
+		return;
+	}
+#endif
+	__LOCK_FP;
+	fwrite(msg->data, 1, msg->len, __debuglog_fp);
 	__UNLOCK_FP;
-	return;
+	debug_message_release(msg);
 }
 
 void __oscap_dlprintf(int level, const char *file, const char *fn, size_t line, int delta_indent, const char *fmt, ...)
 {
 	static int indent = 0;
+	struct debug_message msg;
 	va_list ap;
 
 	if (__debuglog_fp == NULL) {
@@ -263,25 +492,35 @@ void __oscap_dlprintf(int level, const char *file, const char *fn, size_t line,
 	if (__debuglog_level < level) {
 		return;
 	}
+	debug_message_init(&msg);
+	debug_message_start(&msg, level, indent);
 	va_start(ap, fmt);
-	debug_message_start(level, indent);
-	vfprintf(__debuglog_fp, fmt, ap);
+	debug_message_vprintf(&msg, fmt, ap);
+	va_end(ap);
 	if (__debuglog_level == DBG_D) {
-		debug_message_devel_metadata(file, fn, line);
+		debug_message_devel_metadata(&msg, file, fn, line);
 	}
-	debug_message_end();
-	va_end(ap);
+	debug_message_end(&msg);
 }
 
 void __oscap_debuglog_object (const char *file, const char *fn, size_t line, int objtype, void *obj)
 {
+	struct debug_message msg;
+
 	if (__debuglog_fp == NULL) {
 		return;
 	}
 	if (__debuglog_level < DBG_D) {
 		return;
 	}
-	debug_message_start(DBG_D, 0);
+#if defined(OSCAP_THREAD_SAFE)
+	/* the object is printed straight to the log, after the queued messages */
+	debug_ring_flush();
+#endif
+	debug_message_init(&msg);
+	debug_message_start(&msg, DBG_D, 0);
+	__LOCK_FP;
+	fwrite(msg.data, 1, msg.len, __debuglog_fp);
 	switch (objtype) {
 	case OSCAP_DEBUGOBJ_SEXP:
 #if defined(OVAL_PROBES_ENABLED)
@@ -291,6 +530,10 @@ void __oscap_debuglog_object (const char *file, const char *fn, size_t line, int
 	default:
 		fprintf(__debuglog_fp, "Attempt to dump a not supported object.");
 	}
-	debug_message_devel_metadata(file, fn, line);
-	debug_message_end();
+	msg.len = 0;
+	debug_message_devel_metadata(&msg, file, fn, line);
+	debug_message_printf(&msg, "\n");
+	fwrite(msg.data, 1, msg.len, __debuglog_fp);
+	__UNLOCK_FP;
+	debug_message_release(&msg);
 }
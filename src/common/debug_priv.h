@@ -33,6 +33,7 @@
 #include <stdlib.h>
 #include <stddef.h>
 #include <stdarg.h>
+#include <stdio.h>
 #include "util.h"
 #include "public/oscap_debug.h"
 
@@ -51,7 +52,9 @@
  * need to be specified. The __FILE__, __PRETTY_FUNCTION__ and __LINE__ macros
  * are used for the first three arguments.
  */
-# define oscap_dlprintf(l, ...) __dlprintf_wrapper (l, __VA_ARGS__)
+/* Messages above the verbosity level are dropped before their arguments are evaluated */
+# define oscap_dlprintf(l, ...) \
+	(oscap_debug_enabled(l) ? __dlprintf_wrapper (l, __VA_ARGS__) : (void)0)
 
 void __oscap_debuglog_object (const char *file, const char *fn, size_t line, int objtype, void *obj);
 
@@ -44,6 +44,7 @@
 #include "debug_priv.h"
 #include "elements.h"
 #include "oscap_helpers.h"
+#include "source/compress_priv.h"
 
 
 const struct oscap_string_map OSCAP_BOOL_MAP[] = {
@@ -88,34 +89,39 @@ void oscap_text_consumer(char *text, void *user)
 }
 
 /* -1 error; 0 OK */
-int oscap_parser_text_value(xmlTextReaderPtr reader, oscap_xml_value_consumer consumer, void *user)
+int oscap_parser_text_append(xmlTextReaderPtr reader, struct oscap_strbuf *text)
 {
 	int depth = xmlTextReaderDepth(reader);
-	bool has_value = false;
-	int ret = 0;
 
 	if (xmlTextReaderIsEmptyElement(reader)) {
-		return ret;
+		return 0;
 	}
 
 	xmlTextReaderRead(reader);
 	while (xmlTextReaderDepth(reader) > depth) {
 		int nodetype = xmlTextReaderNodeType(reader);
-		if (nodetype == XML_READER_TYPE_CDATA || nodetype == XML_READER_TYPE_TEXT) {
-			char *value = (char *)xmlTextReaderValue(reader);
-			(*consumer) (value, user);
-			free(value);
-			has_value = true;
-		}
-		if (xmlTextReaderRead(reader) != 1) {
-			ret = -1;
-			break;
-		}
+		if (nodetype == XML_READER_TYPE_CDATA || nodetype == XML_READER_TYPE_TEXT)
+			oscap_strbuf_append_string(text, (const char *)xmlTextReaderConstValue(reader));
+		if (xmlTextReaderRead(reader) != 1)
+			return -1;
 	}
+	return 0;
+}
 
-	if (!has_value)
-		(*consumer) ("", user);
+/* -1 error; 0 OK */
+int oscap_parser_text_value(xmlTextReaderPtr reader, oscap_xml_value_consumer consumer, void *user)
+{
+	struct oscap_strbuf text;
 
+	if (xmlTextReaderIsEmptyElement(reader)) {
+		return 0;
+	}
+
+	oscap_strbuf_init(&text);
+	int ret = oscap_parser_text_append(reader, &text);
+	// The consumers copy the value, it's never modified
+	(*consumer) ((char *)oscap_strbuf_get(&text), user);
+	oscap_strbuf_release(&text);
 	return ret;
 }
 
@@ -135,6 +141,21 @@ char *oscap_element_string_copy(xmlTextReaderPtr reader)
 		return (char *) calloc(1,1);
 }
 
+bool oscap_element_string_append(xmlTextReaderPtr reader, struct oscap_strbuf *text)
+{
+	int t;
+
+	if (xmlTextReaderIsEmptyElement(reader))
+		return false;
+
+	t = xmlTextReaderNodeType(reader);
+	if (t == XML_ELEMENT_NODE || t == XML_ATTRIBUTE_NODE)
+		xmlTextReaderRead(reader);
+	if (xmlTextReaderHasValue(reader))
+		oscap_strbuf_append_string(text, (const char *)xmlTextReaderConstValue(reader));
+	return true;
+}
+
 const char *oscap_element_string_get(xmlTextReaderPtr reader)
 {
 	if (xmlTextReaderNodeType(reader) == XML_READER_TYPE_ELEMENT ||
@@ -226,6 +247,13 @@ int oscap_xml_save_filename(const char *filename, xmlDocPtr doc)
 	if (strcmp(filename, "-") == 0) {
 		xmlCode = xmlSaveFormatFileEnc(filename, doc, "UTF-8", 1);
 	}
+	else if (oscap_compress_by_filename(filename) != OSCAP_COMPRESS_NONE) {
+		/* The buffer closes the file */
+		buff = oscap_compress_output_open(filename);
+		if (buff == NULL)
+			return -1;
+		xmlCode = xmlSaveFormatFileTo(buff, doc, "UTF-8", 1);
+	}
 	else {
 		int fd = oscap_open_writable(filename);
 		if (fd == -1)
@@ -268,3 +296,249 @@ xmlNs *lookup_xsi_ns(xmlDoc *doc)
 	}
 	return ns_xsi;
 }
+
+struct oscap_xml_stream_element {
+	xmlNodePtr node;
+	xmlNsPtr ns_written;	///< last namespace declared in the start tag
+	bool filled;	///< some content was written after the start tag
+};
+
+struct oscap_xml_stream {
+	xmlDocPtr doc;
+	xmlOutputBufferPtr out;
+	xmlTextWriterPtr writer;
+	char *filename;
+	int fd;
+	bool error;
+	/* Elements with written start tags, from the root down */
+	struct oscap_xml_stream_element *open;
+	size_t open_count;
+	size_t open_size;
+};
+
+struct oscap_xml_stream *oscap_xml_stream_new(const char *filename, xmlDocPtr doc)
+{
+	int fd = -1;
+	xmlOutputBufferPtr out = NULL;
+
+	if (strcmp(filename, "-") == 0) {
+		out = xmlOutputBufferCreateFd(STDOUT_FILENO, NULL);
+	} else if (oscap_compress_by_filename(filename) != OSCAP_COMPRESS_NONE) {
+		out = oscap_compress_output_open(filename);
+		if (out == NULL)
+			return NULL;
+	} else {
+		fd = oscap_open_writable(filename);
+		if (fd == -1)
+			return NULL;
+		out = xmlOutputBufferCreateFd(fd, NULL);
+	}
+	if (out == NULL) {
+		if (fd != -1)
+			close(fd);
+		oscap_seterr(OSCAP_EFAMILY_XML, "Could not open '%s' for writing.", filename);
+		return NULL;
+	}
+
+	/* The writer takes the ownership of the output buffer */
+	xmlTextWriterPtr writer = xmlNewTextWriter(out);
+	if (writer == NULL) {
+		xmlOutputBufferClose(out);
+		if (fd != -1)
+			close(fd);
+		oscap_setxmlerr(xmlGetLastError());
+		return NULL;
+	}
+
+	struct oscap_xml_stream *stream = calloc(1, sizeof(struct oscap_xml_stream));
+	stream->doc = doc;
+	stream->out = out;
+	stream->writer = writer;
+	stream->filename = oscap_strdup(filename);
+	stream->fd = fd;
+	stream->error = xmlTextWriterStartDocument(writer, NULL, "UTF-8", NULL) < 0;
+	doc->_private = stream;
+	return stream;
+}
+
+static char *_oscap_xml_stream_qname(xmlNsPtr ns, const xmlChar *name)
+{
+	if (ns != NULL && ns->prefix != NULL)
+		return oscap_sprintf("%s:%s", (const char *) ns->prefix, (const char *) name);
+	return oscap_strdup((const char *) name);
+}
+
+/* Start a new line indented the same way as xmlSaveFormatFile does */
+static void _oscap_xml_stream_newline(struct oscap_xml_stream *stream, size_t level)
+{
+	if (stream->open_count > 0)
+		stream->open[stream->open_count - 1].filled = true;
+	if (stream->open_count > 0 && xmlTextWriterWriteRaw(stream->writer, BAD_CAST "\n") < 0)
+		stream->error = true;
+	for (size_t i = 0; i < level && !stream->error; ++i) {
+		if (xmlTextWriterWriteRaw(stream->writer, BAD_CAST "  ") < 0)
+			stream->error = true;
+	}
+}
+
+static void _oscap_xml_stream_open(struct oscap_xml_stream *stream, xmlNodePtr node)
+{
+	_oscap_xml_stream_newline(stream, stream->open_count);
+	char *qname = _oscap_xml_stream_qname(node->ns, node->name);
+	if (!stream->error && xmlTextWriterStartElement(stream->writer, BAD_CAST qname) < 0)
+		stream->error = true;
+	free(qname);
+
+	for (xmlNsPtr ns = node->nsDef; ns != NULL && !stream->error; ns = ns->next) {
+		char *attr_name = ns->prefix != NULL ? oscap_sprintf("xmlns:%s", (const char *) ns->prefix) : oscap_strdup("xmlns");
+		if (xmlTextWriterWriteAttribute(stream->writer, BAD_CAST attr_name, ns->href) < 0)
+			stream->error = true;
+		free(attr_name);
+	}
+	for (xmlAttrPtr attr = node->properties; attr != NULL && !stream->error; attr = attr->next) {
+		char *attr_name = _oscap_xml_stream_qname(attr->ns, attr->name);
+		xmlChar *value = xmlNodeGetContent((xmlNodePtr) attr);
+		if (xmlTextWriterWriteAttribute(stream->writer, BAD_CAST attr_name, value != NULL ? value : BAD_CAST "") < 0)
+			stream->error = true;
+		xmlFree(value);
+		free(attr_name);
+	}
+
+	if (stream->open_count == stream->open_size) {
+		stream->open_size = stream->open_size ? stream->open_size * 2 : 16;
+		stream->open = realloc(stream->open, stream->open_size * sizeof(struct oscap_xml_stream_element));
+	}
+	xmlNsPtr ns_written = node->nsDef;
+	while (ns_written != NULL && ns_written->next != NULL)
+		ns_written = ns_written->next;
+	stream->open[stream->open_count].node = node;
+	stream->open[stream->open_count].ns_written = ns_written;
+	stream->open[stream->open_count].filled = false;
+	++stream->open_count;
+}
+
+static bool _oscap_xml_stream_ns_used(xmlNodePtr node, xmlNsPtr ns)
+{
+	if (node->ns == ns)
+		return true;
+	for (xmlAttrPtr attr = node->properties; attr != NULL; attr = attr->next) {
+		if (attr->ns == ns)
+			return true;
+	}
+	for (xmlNodePtr child = node->children; child != NULL; child = child->next) {
+		if (child->type == XML_ELEMENT_NODE && _oscap_xml_stream_ns_used(child, ns))
+			return true;
+	}
+	return false;
+}
+
+/*
+ * Namespaces declared on an open element after its start tag was written
+ * are declared again on the node about to be dumped if it uses them.
+ */
+static void _oscap_xml_stream_declare_late_ns(struct oscap_xml_stream *stream, xmlNodePtr node)
+{
+	if (node->type != XML_ELEMENT_NODE)
+		return;
+	for (size_t i = 0; i < stream->open_count; ++i) {
+		struct oscap_xml_stream_element *element = &stream->open[i];
+		xmlNsPtr ns = element->ns_written != NULL ? element->ns_written->next : element->node->nsDef;
+		for (; ns != NULL; ns = ns->next) {
+			if (_oscap_xml_stream_ns_used(node, ns))
+				xmlNewNs(node, ns->href, ns->prefix);
+		}
+	}
+}
+
+/* Write and release the children of an open element which precede the stop node */
+static void _oscap_xml_stream_dump_children(struct oscap_xml_stream *stream, xmlNodePtr parent, xmlNodePtr stop)
+{
+	xmlNodePtr child = parent->children;
+	while (child != stop && !stream->error) {
+		xmlNodePtr next = child->next;
+		_oscap_xml_stream_newline(stream, stream->open_count);
+		/* Pass the writer's data on before dumping */
+		if (xmlTextWriterFlush(stream->writer) < 0) {
+			stream->error = true;
+			break;
+		}
+		_oscap_xml_stream_declare_late_ns(stream, child);
+		xmlNodeDumpOutput(stream->out, stream->doc, child, stream->open_count, 1, "UTF-8");
+		if (stream->out->error != 0)
+			stream->error = true;
+		xmlUnlinkNode(child);
+		xmlFreeNode(child);
+		child = next;
+	}
+}
+
+static void _oscap_xml_stream_close(struct oscap_xml_stream *stream)
+{
+	xmlNodePtr node = stream->open[stream->open_count - 1].node;
+	_oscap_xml_stream_dump_children(stream, node, NULL);
+	if (stream->open[stream->open_count - 1].filled)
+		_oscap_xml_stream_newline(stream, stream->open_count - 1);
+	--stream->open_count;
+	if (!stream->error && xmlTextWriterEndElement(stream->writer) < 0)
+		stream->error = true;
+	if (node->parent != NULL && node->parent->type == XML_ELEMENT_NODE) {
+		xmlUnlinkNode(node);
+		xmlFreeNode(node);
+	}
+}
+
+void oscap_xml_stream_flush(xmlDocPtr doc, xmlNode *parent)
+{
+	struct oscap_xml_stream *stream = doc->_private;
+	if (stream == NULL || stream->error)
+		return;
+
+	size_t depth = 0;
+	for (xmlNodePtr cur = parent; cur != NULL && cur->type == XML_ELEMENT_NODE; cur = cur->parent)
+		++depth;
+	xmlNodePtr *path = malloc(depth * sizeof(xmlNodePtr));
+	size_t i = depth;
+	for (xmlNodePtr cur = parent; i > 0; cur = cur->parent)
+		path[--i] = cur;
+
+	/* Close the elements the parent is not nested in */
+	size_t common = 0;
+	while (common < stream->open_count && common < depth && stream->open[common].node == path[common])
+		++common;
+	while (stream->open_count > common)
+		_oscap_xml_stream_close(stream);
+
+	for (i = 0; i < depth; ++i) {
+		if (i >= stream->open_count)
+			_oscap_xml_stream_open(stream, path[i]);
+		_oscap_xml_stream_dump_children(stream, path[i], i + 1 < depth ? path[i + 1] : NULL);
+	}
+	free(path);
+}
+
+int oscap_xml_stream_finish(struct oscap_xml_stream *stream)
+{
+	xmlNodePtr root = xmlDocGetRootElement(stream->doc);
+	if (root != NULL)
+		oscap_xml_stream_flush(stream->doc, root);
+	while (stream->open_count > 0)
+		_oscap_xml_stream_close(stream);
+	if (!stream->error && xmlTextWriterEndDocument(stream->writer) < 0)
+		stream->error = true;
+	if (xmlTextWriterFlush(stream->writer) < 0 || oscap_compress_output_finish(stream->out) != 0)
+		stream->error = true;
+	xmlFreeTextWriter(stream->writer);
+	if (stream->fd != -1)
+		close(stream->fd);
+
+	int ret = 0;
+	if (stream->error) {
+		oscap_seterr(OSCAP_EFAMILY_XML, "Could not write the XML document to '%s'.", stream->filename);
+		ret = -1;
+	}
+	stream->doc->_private = NULL;
+	free(stream->open);
+	free(stream->filename);
+	free(stream);
+	return ret;
+}
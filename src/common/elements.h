@@ -33,6 +33,7 @@
 #include <time.h>
 #include "public/oscap.h"
 #include "util.h"
+#include "oscap_buffer.h"
 
 #define OSCAP_XMLNS_XSI BAD_CAST "http://www.w3.org/2001/XMLSchema-instance"
 
@@ -40,13 +41,18 @@
 extern const struct oscap_string_map OSCAP_BOOL_MAP[];
 
 typedef void (*oscap_xml_value_consumer) (char *, void *);
+/// pass the whole text of current element to the consumer at once
 int oscap_parser_text_value(xmlTextReaderPtr reader, oscap_xml_value_consumer consumer, void *user);
+/// append the text and CDATA of current element to the builder, -1 error; 0 OK
+int oscap_parser_text_append(xmlTextReaderPtr reader, struct oscap_strbuf *text);
 void oscap_text_consumer(char *text, void *user);
 
 /// find starting element at given depth (returns false if none found)
 bool oscap_to_start_element(xmlTextReaderPtr reader, int depth);
 /// get a copy of a string contained by current element
 char *oscap_element_string_copy(xmlTextReaderPtr reader);
+/// append a string contained by current element to the builder, false if the element is empty
+bool oscap_element_string_append(xmlTextReaderPtr reader, struct oscap_strbuf *text);
 /// get a string contained by current element
 const char *oscap_element_string_get(xmlTextReaderPtr reader);
 /// get depth of current element
@@ -78,4 +84,34 @@ int oscap_xml_save_filename_free(const char *filename, xmlDocPtr doc);
 
 xmlNs *lookup_xsi_ns(xmlDoc *doc);
 
+/**
+ * Incremental serialization of a document built by the *_to_dom functions.
+ * While a document is streamed, oscap_xml_stream_flush writes the children
+ * of an element and releases them, so that only the elements on the path
+ * from the root to the element being built are kept in memory. Namespaces
+ * have to be declared on an element before the first flush below it, and
+ * an element is complete (and released) once a flush happens outside it.
+ */
+struct oscap_xml_stream;
+
+/**
+ * Start streaming the (empty) document to the file of the given filename.
+ * A filename ending with ".gz" is compressed, "-" is the standard output.
+ * @return the stream, NULL on failure (oscap_seterr is set appropriately).
+ */
+struct oscap_xml_stream *oscap_xml_stream_new(const char *filename, xmlDocPtr doc);
+
+/**
+ * Write and release the children of the element, all of them have to be
+ * complete. Does nothing if the document is not streamed.
+ */
+void oscap_xml_stream_flush(xmlDocPtr doc, xmlNode *parent);
+
+/**
+ * Write the rest of the document and dispose the stream, the document
+ * itself is left to the caller.
+ * @return 0 on success, -1 on failure (oscap_seterr is set appropriately).
+ */
+int oscap_xml_stream_finish(struct oscap_xml_stream *stream);
+
 #endif
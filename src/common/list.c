@@ -208,17 +208,11 @@ void* oscap_list_find(struct oscap_list *list, void *what, oscap_cmp_func compar
 	if (list == NULL) return false;
 	if (compare == NULL) compare = oscap_ptr_cmp;
 
-	struct oscap_iterator *it = oscap_iterator_new(list);
-
-	while (_oscap_iterator_has_more_internal(it)) {
-		void *item = oscap_iterator_next(it);
-		if (compare(item, what)) {
-			oscap_iterator_free(it);
+	void *item;
+	OSCAP_LIST_FOREACH(item, list) {
+		if (compare(item, what))
 			return item;
-		}
 	}
-
-	oscap_iterator_free(it);
 	return NULL;
 }
 
@@ -391,14 +385,40 @@ OSCAP_ITERATOR_REMOVE(oscap_stringlist, oscap_stringlist_free)
     /*OSCAP_ITERATOR_RESET(oscap_string)*/
 
 
-#define OSCAP_DEFAULT_HSIZE 389
-static inline unsigned int oscap_htable_hash(const char *str, size_t htable_size)
+#define OSCAP_DEFAULT_HSIZE 64
+#define OSCAP_HTABLE_MIN_HSIZE 8
+
+static inline uint64_t oscap_htable_mix(uint64_t k)
 {
-	unsigned h = 0;
-	unsigned char *p;
-	for (p = (unsigned char *)str; *p != '\0'; p++)
-		h = (97 * h) + *p;
-	return h % htable_size;
+	k ^= k >> 33;
+	k *= 0xff51afd7ed558ccdULL;
+	k ^= k >> 33;
+	k *= 0xc4ceb9fe1a85ec53ULL;
+	k ^= k >> 33;
+	return k;
+}
+
+/*
+ * The key is hashed 8 bytes at a time and every block goes through the
+ * finalizer of MurmurHash3, so keys sharing long prefixes (e.g. the IDs
+ * of the rules of a benchmark) are spread over the whole table.
+ */
+static inline uint64_t oscap_htable_hash(const char *str)
+{
+	const unsigned char *p = (const unsigned char *)str;
+	size_t len = strlen(str);
+	uint64_t h = 0x9e3779b97f4a7c15ULL ^ len;
+	uint64_t k;
+
+	for (; len >= sizeof(k); p += sizeof(k), len -= sizeof(k)) {
+		memcpy(&k, p, sizeof(k));
+		h ^= oscap_htable_mix(k);
+		h = ((h << 27) | (h >> 37)) * 5 + 0x52dce729;
+	}
+	k = 0;
+	memcpy(&k, p, len);
+	h ^= oscap_htable_mix(k);
+	return oscap_htable_mix(h);
 }
 
 struct oscap_htable *oscap_htable_new1(oscap_compare_func cmp, size_t hsize)
@@ -410,9 +430,13 @@ struct oscap_htable *oscap_htable_new1(oscap_compare_func cmp, size_t hsize)
 	t = malloc(sizeof(struct oscap_htable));
 	if (t == NULL)
 		return NULL;
-	t->hsize = hsize;
+	/* a power of two, so the bucket is given by the low bits of the hash */
+	t->hsize = OSCAP_HTABLE_MIN_HSIZE;
+	while (t->hsize < hsize)
+		t->hsize <<= 1;
 	t->itemcount = 0;
-	t->table = calloc(hsize, sizeof(struct oscap_htable_item *));
+	t->first = t->last = NULL;
+	t->table = calloc(t->hsize, sizeof(struct oscap_htable_item *));
 	if (t->table == NULL) {
 		free(t);
 		return NULL;
@@ -421,20 +445,38 @@ struct oscap_htable *oscap_htable_new1(oscap_compare_func cmp, size_t hsize)
 	return t;
 }
 
+/* Double the number of buckets, the items keep their hashes */
+static void oscap_htable_grow(struct oscap_htable *htable)
+{
+	size_t hsize = htable->hsize << 1;
+	struct oscap_htable_item **table = calloc(hsize, sizeof(struct oscap_htable_item *));
+	if (table == NULL)
+		return; // the chains just get longer
+
+	for (size_t i = 0; i < htable->hsize; ++i) {
+		struct oscap_htable_item *item = htable->table[i];
+		while (item != NULL) {
+			struct oscap_htable_item *next = item->next;
+			size_t idx = item->hash & (hsize - 1);
+			item->next = table[idx];
+			table[idx] = item;
+			item = next;
+		}
+	}
+	free(htable->table);
+	htable->table = table;
+	htable->hsize = hsize;
+}
+
 struct oscap_htable * oscap_htable_clone(const struct oscap_htable * table, oscap_clone_func cloner)
 {
 	struct oscap_htable *t = oscap_htable_new();
 	if (t == NULL)
 		return NULL;
 
-	for (size_t i = 0; i < table->hsize; ++i) {
-		struct oscap_htable_item *item = table->table[i];
-		while (item != NULL) {
-			oscap_htable_add(t, item->key, (void *) cloner(item->value));
-			item = item->next;
-		}
-	}
-	
+	for (struct oscap_htable_item *item = table->first; item != NULL; item = item->succ)
+		oscap_htable_add(t, item->key, (void *) cloner(item->value));
+
 	return t;
 }
 
@@ -452,15 +494,12 @@ struct oscap_htable *oscap_htable_new(void)
 	return oscap_htable_new1(oscap_htable_cmp, OSCAP_DEFAULT_HSIZE);
 }
 
-static struct oscap_htable_item *oscap_htable_lookup(struct oscap_htable *htable, const char *key)
+static struct oscap_htable_item *oscap_htable_lookup(struct oscap_htable *htable, const char *key, uint64_t hash)
 {
 	__attribute__nonnull__(htable);
-	if (key == NULL)
-		return NULL;
-	unsigned int hashcode = oscap_htable_hash(key, htable->hsize);
-	struct oscap_htable_item *htitem = htable->table[hashcode];
+	struct oscap_htable_item *htitem = htable->table[hash & (htable->hsize - 1)];
 	while (htitem != NULL) {
-		if (htable->cmp(htitem->key, key) == 0)
+		if (htitem->hash == hash && htable->cmp(htitem->key, key) == 0)
 			return htitem;
 		htitem = htitem->next;
 	}
@@ -470,40 +509,61 @@ static struct oscap_htable_item *oscap_htable_lookup(struct oscap_htable *htable
 bool oscap_htable_add(struct oscap_htable * htable, const char *key, void *item)
 {
 	__attribute__nonnull__(htable);
-	/*
-	   unsigned int hashcode = oscap_htable_hash(key, htable->hsize);
-	   struct oscap_htable_item* htitem = htable->table[hashcode];
-	   while(htitem != NULL)
-	   {
-	   if( (*(htable->cmp))(htitem->key, key) == 0) return false;
-	   if(htitem->next == NULL) break;
-	   htitem = htitem->next;
-	   }
-	   // htitem points to the last item
-	 */
-	if (oscap_htable_lookup(htable, key) != NULL)
+	if (key == NULL)
+		return false;
+	uint64_t hash = oscap_htable_hash(key);
+	if (oscap_htable_lookup(htable, key, hash) != NULL)
 		return false;
-	unsigned int hashcode = oscap_htable_hash(key, htable->hsize);
+	/* keep the load factor under 3/4 */
+	if ((htable->itemcount + 1) * 4 > htable->hsize * 3)
+		oscap_htable_grow(htable);
+	size_t idx = hash & (htable->hsize - 1);
 	struct oscap_htable_item *newhtitem;
 	newhtitem = malloc(sizeof(struct oscap_htable_item));
+	if (newhtitem == NULL)
+		return false;
 	newhtitem->key = oscap_strdup(key);
 	newhtitem->value = item;
-	newhtitem->next = htable->table[hashcode];
-	htable->table[hashcode] = newhtitem;
+	newhtitem->hash = hash;
+	newhtitem->next = htable->table[idx];
+	htable->table[idx] = newhtitem;
+	/* the iterators follow the order of insertion */
+	newhtitem->succ = NULL;
+	newhtitem->pred = htable->last;
+	if (htable->last != NULL)
+		htable->last->succ = newhtitem;
+	else
+		htable->first = newhtitem;
+	htable->last = newhtitem;
 	htable->itemcount++;
 	return true;
 }
 
 void *oscap_htable_detach(struct oscap_htable *htable, const char *key)
 {
-	struct oscap_htable_item *htitem = oscap_htable_lookup(htable, key);
-	if (htitem) {
-		void *val = htitem->value;
-		free(htitem->key);
-		htitem->key = NULL;
-		htitem->value = NULL;
-		htable->itemcount--;
-		return val;
+	if (key == NULL)
+		return NULL;
+	uint64_t hash = oscap_htable_hash(key);
+	struct oscap_htable_item **link = &htable->table[hash & (htable->hsize - 1)];
+	while (*link != NULL) {
+		struct oscap_htable_item *htitem = *link;
+		if (htitem->hash == hash && htable->cmp(htitem->key, key) == 0) {
+			void *val = htitem->value;
+			*link = htitem->next;
+			if (htitem->pred != NULL)
+				htitem->pred->succ = htitem->succ;
+			else
+				htable->first = htitem->succ;
+			if (htitem->succ != NULL)
+				htitem->succ->pred = htitem->pred;
+			else
+				htable->last = htitem->pred;
+			free(htitem->key);
+			free(htitem);
+			htable->itemcount--;
+			return val;
+		}
+		link = &htitem->next;
 	}
 	return NULL;
 }
@@ -511,7 +571,9 @@ void *oscap_htable_detach(struct oscap_htable *htable, const char *key)
 void *oscap_htable_get(struct oscap_htable *htable, const char *key)
 {
 	__attribute__nonnull__(htable);
-	struct oscap_htable_item *htitem = oscap_htable_lookup(htable, key);
+	if (key == NULL)
+		return NULL;
+	struct oscap_htable_item *htitem = oscap_htable_lookup(htable, key, oscap_htable_hash(key));
 	return htitem ? htitem->value : NULL;
 }
 
@@ -529,34 +591,24 @@ void oscap_htable_dump(struct oscap_htable *htable, oscap_dump_func dumper, int
 		return;
 	}
 	printf(" (hash table, %u item%s)\n", (unsigned)htable->itemcount, (htable->itemcount == 1 ? "" : "s"));
-	int i;
-	for (i = 0; i < (int)htable->hsize; ++i) {
-		struct oscap_htable_item *item = htable->table[i];
-		while (item) {
-			oscap_print_depth(depth);
-			printf("'%s':\n", item->key);
-			dumper(item->value, depth + 1);
-			item = item->next;
-		}
+	for (struct oscap_htable_item *item = htable->first; item != NULL; item = item->succ) {
+		oscap_print_depth(depth);
+		printf("'%s':\n", item->key);
+		dumper(item->value, depth + 1);
 	}
 }
 
 void oscap_htable_free(struct oscap_htable *htable, oscap_destruct_func destructor)
 {
 	if (htable) {
-		size_t ht;
 		struct oscap_htable_item *cur, *next;
 
-		for (ht = 0; ht < htable->hsize; ++ht) {
-			cur = htable->table[ht];
-			while (cur) {
-				next = cur->next;
-				free(cur->key);
-				if (destructor)
-					destructor(cur->value);
-				free(cur);
-				cur = next;
-			}
+		for (cur = htable->first; cur != NULL; cur = next) {
+			next = cur->succ;
+			free(cur->key);
+			if (destructor)
+				destructor(cur->value);
+			free(cur);
 		}
 
 		free(htable->table);
@@ -571,8 +623,7 @@ void oscap_htable_free0(struct oscap_htable *htable)
 
 struct oscap_htable_iterator {
 	struct oscap_htable *htable;	// Table we iterate through
-	struct oscap_htable_item *cur;	// The current item
-	size_t hpos;			// Line on which we are now
+	struct oscap_htable_item *next;	// The item returned next
 };
 
 struct oscap_htable_iterator *
@@ -580,8 +631,7 @@ oscap_htable_iterator_new(struct oscap_htable *htable)
 {
 	struct oscap_htable_iterator *hit = calloc(1, sizeof(struct oscap_htable_iterator));
 	hit->htable = htable;
-	hit->cur = NULL;
-	hit->hpos = 0;
+	hit->next = htable != NULL ? htable->first : NULL;
 	return hit;
 }
 
@@ -589,50 +639,20 @@ bool
 oscap_htable_iterator_has_more(struct oscap_htable_iterator *hit)
 {
 	__attribute__nonnull__(hit);
-	if (hit->htable == NULL)
-		return false;
-	size_t i = hit->hpos;
-	if (hit->cur != NULL) {
-		if (hit->cur->next != NULL)
-			return true;
-		if (i + 1 >= hit->htable->hsize)
-			return false;
-		i++;
-	}
-	for (; i < hit->htable->hsize; i++) {
-		if (hit->htable->table[i] == NULL)
-			continue;
-		if (i != hit->hpos)
-			hit->hpos = i - 1;
-		return true;
-	}
-	hit->hpos = i;
-	return false;
+	return hit->next != NULL;
 }
 
 const struct oscap_htable_item *
 oscap_htable_iterator_next(struct oscap_htable_iterator *hit)
 {
 	__attribute__nonnull__(hit);
-	if (hit->cur != NULL) {
-		if (hit->cur->next != NULL) {
-			hit->cur = hit->cur->next;
-			return hit->cur;
-		}
-		if (hit->hpos + 1 >= hit->htable->hsize) {
-			assert(false);
-			return NULL;
-		}
-		hit->hpos++;
-	}
-	for (; hit->hpos < hit->htable->hsize; hit->hpos++) {
-		if (hit->htable->table[hit->hpos] == NULL)
-			continue;
-		hit->cur = hit->htable->table[hit->hpos];
-		return hit->cur;
+	const struct oscap_htable_item *item = hit->next;
+	if (item == NULL) {
+		assert(false); // no more item found
+		return NULL;
 	}
-	assert(false); // no more item found
-	return NULL;
+	hit->next = item->succ;
+	return item;
 }
 
 const char *
@@ -663,8 +683,7 @@ void
 oscap_htable_iterator_reset(struct oscap_htable_iterator *hit)
 {
 	__attribute__nonnull__(hit);
-	hit->cur = NULL;
-	hit->hpos = 0;
+	hit->next = hit->htable != NULL ? hit->htable->first : NULL;
 }
 
 void
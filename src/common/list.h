@@ -30,6 +30,7 @@
 
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "util.h"
 #include "public/oscap.h"
@@ -100,6 +101,19 @@ void oscap_iterator_free(struct oscap_iterator *it);
 
 void *oscap_list_find(struct oscap_list *list, void *what, oscap_cmp_func compare);
 
+/**
+ * Iterate over the items of a list in place, without allocating an iterator.
+ * The variable @a val has to be declared by the caller, an item variable
+ * named VAL_item is added to the scope of the loop. It is safe to use break,
+ * return or goto inside the loop, the list must not be modified in it.
+ * @param val name of a variable the item data will be sequentially stored in
+ * @param list list to iterate through, may be NULL
+ */
+#define OSCAP_LIST_FOREACH(val, list)                                                    \
+    for (struct oscap_list_item *val##_item = (list) != NULL ? (list)->first : NULL;    \
+         val##_item != NULL && ((val = val##_item->data), true);                        \
+         val##_item = val##_item->next)
+
 /**
  * Iterate over an array, given an iterator.
  * Execute @a code for each array member stored in @a val.
@@ -170,9 +184,12 @@ void *oscap_list_find(struct oscap_list *list, void *what, oscap_cmp_func compar
 typedef int (*oscap_compare_func) (const char *, const char *);
 // Hash table item.
 struct oscap_htable_item {
-	struct oscap_htable_item *next;	// Next item.
+	struct oscap_htable_item *next;	// Next item in the bucket.
+	struct oscap_htable_item *succ;	// Next item in the order of insertion.
+	struct oscap_htable_item *pred;	// Previous item in the order of insertion.
 	char *key;		// Item key.
 	void *value;		// Item value.
+	uint64_t hash;		// Hash of the key, compared before the keys.
 };
 
 // Hash table.
@@ -180,13 +197,15 @@ struct oscap_htable {
 	size_t hsize;		// Size of the hash table.
 	size_t itemcount;	// Number of elements in the hash table.
 	struct oscap_htable_item **table;	// The table itself.
+	struct oscap_htable_item *first;	// The first item added, iterators start here.
+	struct oscap_htable_item *last;	// The last item added.
 	oscap_compare_func cmp;	// Funcion used to compare keys (e.g. strcmp).
 };
 
 /*
  * Create a new hash table.
  * @param cmp Pointer to a function used as the key comparator.
- * @hsize Size of the hash table.
+ * @hsize Initial size of the hash table, rounded up to a power of two.
  * @internal
  * @return new hash table
  */
@@ -227,6 +246,12 @@ void *oscap_htable_get(struct oscap_htable *htable, const char *key);
  */
 size_t oscap_htable_itemcount(struct oscap_htable *htable);
 
+/*
+ * Remove an item from the hash table without disposing it.
+ * An iterator through the table stays valid unless the removed item is
+ * the next one it would return.
+ * @return The removed item, NULL if the key is not present in the hash table.
+ */
 void *oscap_htable_detach(struct oscap_htable *htable, const char *key);
 
 void oscap_htable_dump(struct oscap_htable *htable, oscap_dump_func dumper, int depth);
@@ -250,7 +275,8 @@ void oscap_htable_free0(struct oscap_htable *htable);
 struct oscap_htable_iterator;
 
 /**
- * Create new iterator through hash table. No ordering is defined for items.
+ * Create new iterator through hash table. The items are returned in the order
+ * they were added.
  * @param htable Hash table to iterate through.
  * @return the iterator
  */
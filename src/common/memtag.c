@@ -0,0 +1,155 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#if defined(HAVE_MALLOC_USABLE_SIZE)
+#include <malloc.h>
+#endif
+
+#include <libxml/xmlmemory.h>
+
+#include "debug_priv.h"
+#include "memtag_priv.h"
+
+bool oscap_memtag_enabled = false;
+
+static int64_t memtag_current[OSCAP_MEMTAG_COUNT];
+static int64_t memtag_peak[OSCAP_MEMTAG_COUNT];
+#if !defined(HAVE_ATOMIC_BUILTINS)
+static pthread_mutex_t memtag_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static const char *memtag_names[OSCAP_MEMTAG_COUNT] = {
+	[OSCAP_MEMTAG_SEXP]       = "sexp",
+	[OSCAP_MEMTAG_OVAL_MODEL] = "oval_model",
+	[OSCAP_MEMTAG_SYSCHAR]    = "syschar",
+	[OSCAP_MEMTAG_RESULTS]    = "results",
+	[OSCAP_MEMTAG_XCCDF]      = "xccdf",
+	[OSCAP_MEMTAG_XML]        = "xml"
+};
+
+void oscap_memtag_account(oscap_memtag_t tag, int64_t bytes)
+{
+#if defined(HAVE_ATOMIC_BUILTINS)
+	int64_t now = __sync_add_and_fetch(&memtag_current[tag], bytes);
+	int64_t peak = memtag_peak[tag];
+
+	while (now > peak) {
+		if (__sync_bool_compare_and_swap(&memtag_peak[tag], peak, now))
+			break;
+		peak = memtag_peak[tag];
+	}
+#else
+	pthread_mutex_lock(&memtag_lock);
+	memtag_current[tag] += bytes;
+	if (memtag_current[tag] > memtag_peak[tag])
+		memtag_peak[tag] = memtag_current[tag];
+	pthread_mutex_unlock(&memtag_lock);
+#endif
+}
+
+/* not const, the block may be uninitialized, its contents aren't read */
+size_t oscap_memtag_block_size(void *ptr, size_t size)
+{
+#if defined(HAVE_MALLOC_USABLE_SIZE)
+	return malloc_usable_size(ptr);
+#else
+	return size;
+#endif
+}
+
+#if defined(HAVE_MALLOC_USABLE_SIZE)
+/*
+ * libxml2 doesn't tell the size of a block it frees, malloc_usable_size()
+ * does. Blocks allocated before the wrappers were installed are freed by
+ * them as well, they can make the XML counter a bit lower than it is.
+ */
+static void *memtag_xml_malloc(size_t size)
+{
+	void *ptr = malloc(size);
+	oscap_memtag_alloc(OSCAP_MEMTAG_XML, ptr, size);
+	return ptr;
+}
+
+static void *memtag_xml_realloc(void *ptr, size_t size)
+{
+	size_t old_size = ptr != NULL ? malloc_usable_size(ptr) : 0;
+	void *new_ptr = realloc(ptr, size);
+
+	if (new_ptr != NULL)
+		oscap_memtag_account(OSCAP_MEMTAG_XML, (int64_t)malloc_usable_size(new_ptr) - (int64_t)old_size);
+	return new_ptr;
+}
+
+static void memtag_xml_free(void *ptr)
+{
+	oscap_memtag_free(OSCAP_MEMTAG_XML, ptr, 0);
+	free(ptr);
+}
+
+static char *memtag_xml_strdup(const char *str)
+{
+	size_t len = strlen(str) + 1;
+	char *copy = memtag_xml_malloc(len);
+
+	if (copy != NULL)
+		memcpy(copy, str, len);
+	return copy;
+}
+#endif
+
+void oscap_memtag_init(void)
+{
+	const char *env = getenv("OSCAP_MEMORY_ACCOUNTING");
+
+	if (oscap_memtag_enabled || env == NULL || *env == '\0' || !strcmp(env, "0"))
+		return;
+
+	oscap_memtag_enabled = true;
+#if defined(HAVE_MALLOC_USABLE_SIZE)
+	if (xmlMemSetup(memtag_xml_free, memtag_xml_malloc, memtag_xml_realloc, memtag_xml_strdup) != 0)
+		dW("Can't install the libxml2 allocator, XML memory won't be accounted.");
+#else
+	dW("malloc_usable_size() isn't available, XML memory won't be accounted.");
+#endif
+}
+
+int64_t oscap_memtag_current(oscap_memtag_t tag)
+{
+	if (!oscap_memtag_enabled)
+		return -1;
+	/* blocks allocated before accounting started can take it below zero */
+	return memtag_current[tag] > 0 ? memtag_current[tag] : 0;
+}
+
+int64_t oscap_memtag_peak(oscap_memtag_t tag)
+{
+	return oscap_memtag_enabled ? memtag_peak[tag] : -1;
+}
+
+const char *oscap_memtag_name(oscap_memtag_t tag)
+{
+	return memtag_names[tag];
+}
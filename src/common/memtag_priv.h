@@ -0,0 +1,79 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef OSCAP_MEMTAG_PRIV_H
+#define OSCAP_MEMTAG_PRIV_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Memory accounting by subsystem. When OSCAP_MEMORY_ACCOUNTING is set in
+ * the environment at oscap_init() time, the current and peak bytes held by
+ * each subsystem are tracked and written to the --profiling output. The
+ * SEXP and XML tags count every allocation of the subsystem, the others
+ * count the blocks of their main structures, not the strings hanging off
+ * them. Sizes are taken from malloc_usable_size() where available.
+ */
+typedef enum {
+	OSCAP_MEMTAG_SEXP = 0,   /* S-expression values and list blocks */
+	OSCAP_MEMTAG_OVAL_MODEL, /* OVAL definitions, tests, objects, states and entities */
+	OSCAP_MEMTAG_SYSCHAR,    /* collected objects, items and item entities */
+	OSCAP_MEMTAG_RESULTS,    /* OVAL result definitions, criteria, tests and items */
+	OSCAP_MEMTAG_XCCDF,      /* XCCDF items and rule results */
+	OSCAP_MEMTAG_XML,        /* libxml2 allocations: documents, DOMs of the results, readers */
+	OSCAP_MEMTAG_COUNT
+} oscap_memtag_t;
+
+extern bool oscap_memtag_enabled;
+
+/**
+ * Read OSCAP_MEMORY_ACCOUNTING and install the libxml2 allocator wrappers
+ * if it is set. Has to be called before the XML parser is initialized.
+ */
+void oscap_memtag_init(void);
+
+void oscap_memtag_account(oscap_memtag_t tag, int64_t bytes);
+size_t oscap_memtag_block_size(void *ptr, size_t size);
+
+/**
+ * Current and peak bytes of a tag, -1 if accounting is disabled.
+ */
+int64_t oscap_memtag_current(oscap_memtag_t tag);
+int64_t oscap_memtag_peak(oscap_memtag_t tag);
+const char *oscap_memtag_name(oscap_memtag_t tag);
+
+/*
+ * Account a block of size bytes just allocated at ptr, or one which is
+ * about to be freed. The size is evaluated only when accounting is enabled.
+ */
+#define oscap_memtag_alloc(tag, ptr, size) \
+	do { \
+		if (oscap_memtag_enabled && (ptr) != NULL) \
+			oscap_memtag_account((tag), (int64_t)oscap_memtag_block_size((ptr), (size))); \
+	} while (0)
+
+#define oscap_memtag_free(tag, ptr, size) \
+	do { \
+		if (oscap_memtag_enabled && (ptr) != NULL) \
+			oscap_memtag_account((tag), -(int64_t)oscap_memtag_block_size((ptr), (size))); \
+	} while (0)
+
+#endif /* OSCAP_MEMTAG_PRIV_H */
@@ -26,12 +26,23 @@
 #endif
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <string.h>
 #include <ctype.h>
 #include <errno.h>
 #include <stdint.h>
 
+#if defined(OS_LINUX)
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+#endif
+
 #if defined(OS_FREEBSD)
 #include <fcntl.h>
 #include <kvm.h>
@@ -93,10 +104,11 @@ static int cmpkey (const char *a, const struct stat_parser *b)
 	return strcmp(a, b->keyword);
 }
 
-static int read_status(const char *source, void *base, struct stat_parser *spt, size_t spt_size)
+/* parse the "key: value" lines of the text */
+static int read_status(char *text, void *base, struct stat_parser *spt, size_t spt_size)
 {
-	FILE *fp;
 	size_t processed;
+	char *linebuf, *next;
 
 #ifndef NDEBUG
 	/* check whether spt is sorted */
@@ -112,67 +124,235 @@ static int read_status(const char *source, void *base, struct stat_parser *spt,
 		}
 	}
 #endif
-	fp = fopen(source, "r");
+	processed = 0;
 
-	if (fp == NULL)
-		return -1;
-	else {
-		char linebuf[256];
+	for (linebuf = text; *linebuf != '\0'; linebuf = next) {
 		char *strval;
 		struct stat_parser *sp;
 
-		processed = 0;
+		next = strchr(linebuf, '\n');
+		if (next == NULL) {
+			/* the text was truncated, something is wrong */
+			dE("Line \"%s\" is not terminated", linebuf);
+			return (-1);
+		}
+		*next++ = '\0';
 
-		while (fgets(linebuf, sizeof linebuf - 1, fp) != NULL) {
-			strval = strchr(linebuf, ':');
+		strval = strchr(linebuf, ':');
 
-			if (strval == NULL) {
-				fclose (fp);
-				return (-1);
-			}
+		if (strval == NULL)
+			return (-1);
 
-			*strval++ = '\0';
-
-			while(isspace(*strval))
-				++strval;
-
-			sp = oscap_bfind(spt, spt_size, sizeof(struct stat_parser),
-			                 linebuf, (int(*)(void *, void *))&cmpkey);
-
-			if (sp == NULL) {
-				/* drop end of unread line */
-				while (strchr(strval, '\n') == NULL) {
-					linebuf[0] = '\n';
-					if (fgets(linebuf, sizeof linebuf - 1, fp) == NULL) {
-						fclose(fp);
-						return (-1);
-					}
-					strval = linebuf;
-				}
-				continue;
-			}
+		*strval++ = '\0';
 
-			/* line is too long, somthing is wrong */
-			if (strchr(strval, '\n') == NULL) {
-				dE("value for %s key is too long", linebuf);
-				fclose(fp);
-				return (-1);
-			}
+		while(isspace(*strval))
+			++strval;
 
-			if (sp->storval((void *)((uintptr_t)(base) + sp->offset), strval) != 0) {
-				fclose (fp);
-				return (-1);
-			}
+		sp = oscap_bfind(spt, spt_size, sizeof(struct stat_parser),
+		                 linebuf, (int(*)(void *, void *))&cmpkey);
 
-			++processed;
-		}
+		if (sp == NULL)
+			continue;
+
+		if (sp->storval((void *)((uintptr_t)(base) + sp->offset), strval) != 0)
+			return (-1);
 
-		fclose(fp);
+		++processed;
 	}
 
 	return processed == spt_size ? 0 : 1;
 }
 
+#endif /* OS_LINUX || __FreeBSD__ || OS_SOLARIS */
+
+#if defined(OS_LINUX)
+/*
+ * The files are opened once and read with pread(), so a sample costs a
+ * single system call and works after the probes change their root
+ * directory. A forked process reopens the files, /proc/self would still
+ * be its parent otherwise.
+ */
+#define MEMUSAGE_BUFSIZE      4096
+#define MEMUSAGE_CACHE_MSEC   100 /* system and cgroup usage are cached this long */
+#define MEMUSAGE_CGROUP_DEPTH 32
+#define MEMUSAGE_PROC_CGROUP  "/proc/self/cgroup"
+#define MEMUSAGE_CGROUP_MOUNT "/sys/fs/cgroup"
+/* cgroup v1 reports an unlimited group as a huge page aligned number */
+#define MEMUSAGE_CGROUP_V1_UNLIMITED ((size_t)1 << 62)
+
+struct memusage_file {
+	const char *path;
+	int fd;
+	pid_t pid;
+};
+
+static pthread_mutex_t memusage_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct memusage_file memusage_sys_file  = { MEMUSAGE_LINUX_SYS_STATUS, -1, 0 };
+static struct memusage_file memusage_proc_file = { MEMUSAGE_LINUX_PROC_STATUS, -1, 0 };
+
+static struct {
+	struct sys_memusage sys;
+	int64_t sys_msec;        /* time of the sys sample, 0 if there is none */
+	struct cgroup_memusage cgroup;
+	int64_t cgroup_msec;
+} memusage_cache;
+
+static struct {
+	bool initialized;
+	pid_t pid;
+	int current_fd;                        /* usage of the cgroup of the process */
+	int max_fds[MEMUSAGE_CGROUP_DEPTH];    /* limits of the cgroup and its parents */
+	size_t max_count;
+} memusage_cgroup = { false, 0, -1, { 0 }, 0 };
+
+static int64_t memusage_msec(void)
+{
+	struct timespec ts;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0)
+		return 0;
+	return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static bool memusage_cache_valid(int64_t sampled, int64_t now)
+{
+	return sampled != 0 && now - sampled < MEMUSAGE_CACHE_MSEC;
+}
+
+/* must be called with memusage_lock held */
+static int memusage_pread(struct memusage_file *file, char *buf, size_t size)
+{
+	ssize_t len;
+	pid_t pid = getpid();
+
+	if (file->fd != -1 && file->pid != pid) {
+		close(file->fd);
+		file->fd = -1;
+	}
+	if (file->fd == -1) {
+		file->fd = open(file->path, O_RDONLY | O_CLOEXEC);
+		if (file->fd == -1)
+			return (-1);
+		file->pid = pid;
+	}
+
+	len = pread(file->fd, buf, size - 1, 0);
+	if (len < 0)
+		return (-1);
+	buf[len] = '\0';
+	return (0);
+}
+
+static int memusage_pread_sizet(int fd, size_t *value)
+{
+	char buf[64], *end;
+	ssize_t len;
+
+	len = pread(fd, buf, sizeof buf - 1, 0);
+	if (len <= 0)
+		return (-1);
+	buf[len] = '\0';
+
+	errno = 0;
+	*value = strtoull(buf, &end, 10);
+	if (end == buf || errno == ERANGE)
+		return (-1); /* e.g. "max" */
+	return (0);
+}
+
+static void memusage_cgroup_close(void)
+{
+	size_t i;
+
+	if (memusage_cgroup.current_fd != -1)
+		close(memusage_cgroup.current_fd);
+	for (i = 0; i < memusage_cgroup.max_count; ++i)
+		close(memusage_cgroup.max_fds[i]);
+	memusage_cgroup.current_fd = -1;
+	memusage_cgroup.max_count = 0;
+}
+
+/* open the usage of the cgroup and the limits of the cgroup and of its parents */
+static void memusage_cgroup_open(const char *mount, char *cgpath, const char *current, const char *max)
+{
+	char path[PATH_MAX];
+	char *slash;
+
+	if (snprintf(path, sizeof path, "%s%s/%s", mount, cgpath, current) < (int)sizeof path)
+		memusage_cgroup.current_fd = open(path, O_RDONLY | O_CLOEXEC);
+
+	for (;;) {
+		if (memusage_cgroup.max_count < MEMUSAGE_CGROUP_DEPTH &&
+		    snprintf(path, sizeof path, "%s%s/%s", mount, cgpath, max) < (int)sizeof path) {
+			int fd = open(path, O_RDONLY | O_CLOEXEC);
+
+			if (fd != -1)
+				memusage_cgroup.max_fds[memusage_cgroup.max_count++] = fd;
+		}
+		slash = strrchr(cgpath, '/');
+		if (slash == NULL || cgpath[0] == '\0')
+			break;
+		*slash = '\0';
+	}
+}
+
+/* must be called with memusage_lock held */
+static void memusage_cgroup_init(void)
+{
+	char line[PATH_MAX + 64], *nl, *controllers, *cgpath;
+	char v1path[PATH_MAX + 64] = "";
+	FILE *fp;
+
+	if (memusage_cgroup.initialized && memusage_cgroup.pid == getpid())
+		return;
+	memusage_cgroup_close();
+	memusage_cgroup.initialized = true;
+	memusage_cgroup.pid = getpid();
+
+	fp = fopen(MEMUSAGE_PROC_CGROUP, "r");
+	if (fp == NULL)
+		return;
+
+	/* "0::<path>" is the cgroup v2 hierarchy, "<id>:<controllers>:<path>" the v1 ones */
+	while (fgets(line, sizeof line, fp) != NULL) {
+		nl = strchr(line, '\n');
+		if (nl != NULL)
+			*nl = '\0';
+		controllers = strchr(line, ':');
+		if (controllers == NULL)
+			continue;
+		cgpath = strchr(++controllers, ':');
+		if (cgpath == NULL)
+			continue;
+		*cgpath++ = '\0';
+
+		if (strcmp(line, "0:") == 0 && *controllers == '\0') {
+			memusage_cgroup_open(MEMUSAGE_CGROUP_MOUNT, cgpath, "memory.current", "memory.max");
+			if (memusage_cgroup.max_count > 0 || memusage_cgroup.current_fd != -1)
+				break;
+		} else {
+			char *ctl, *saveptr = NULL;
+
+			for (ctl = strtok_r(controllers, ",", &saveptr); ctl != NULL; ctl = strtok_r(NULL, ",", &saveptr)) {
+				if (strcmp(ctl, "memory") == 0)
+					snprintf(v1path, sizeof v1path, "%s", cgpath);
+			}
+		}
+	}
+	fclose(fp);
+
+	/* the v2 hierarchy has no memory controller, fall back to v1 */
+	if (memusage_cgroup.max_count == 0 && memusage_cgroup.current_fd == -1 && v1path[0] != '\0') {
+		memusage_cgroup_open(MEMUSAGE_CGROUP_MOUNT "/memory", v1path,
+		                     "memory.usage_in_bytes", "memory.limit_in_bytes");
+	}
+
+	if (memusage_cgroup.max_count > 0)
+		dD("Using the memory limits of %zu cgroups", memusage_cgroup.max_count);
+}
+#endif /* OS_LINUX */
+
+#if defined(OS_LINUX) || defined(__FreeBSD__) || defined(OS_SOLARIS)
 #define stat_sizet_field(name, stype, sfield)                           \
 	{ (name), &read_common_sizet, (ptrdiff_t)offsetof(stype, sfield) }
 
@@ -294,14 +474,27 @@ int oscap_sys_memusage(struct sys_memusage *mu)
 	if (mu == NULL)
 		return -1;
 #if defined(OS_LINUX)
-	if (read_status(MEMUSAGE_LINUX_SYS_STATUS,
-	                mu, __sys_stat_ptable,
+	char buf[MEMUSAGE_BUFSIZE];
+	int64_t now = memusage_msec();
+
+	pthread_mutex_lock(&memusage_lock);
+	if (memusage_cache_valid(memusage_cache.sys_msec, now)) {
+		*mu = memusage_cache.sys;
+		pthread_mutex_unlock(&memusage_lock);
+		return 0;
+	}
+	if (memusage_pread(&memusage_sys_file, buf, sizeof buf) != 0 ||
+	    read_status(buf, mu, __sys_stat_ptable,
 	                (sizeof __sys_stat_ptable)/sizeof(struct stat_parser)) != 0)
 	{
+		pthread_mutex_unlock(&memusage_lock);
 		return -1;
 	}
 
 	mu->mu_realfree = mu->mu_free + mu->mu_cached + mu->mu_buffers;
+	memusage_cache.sys = *mu;
+	memusage_cache.sys_msec = now;
+	pthread_mutex_unlock(&memusage_lock);
 #elif defined(OS_FREEBSD)
 	if (freebsd_sys_memusage(mu))
 		return -1;
@@ -317,8 +510,14 @@ int oscap_proc_memusage(struct proc_memusage *mu)
 	if (mu == NULL)
 		return -1;
 #if defined(OS_LINUX)
-	if (read_status(MEMUSAGE_LINUX_PROC_STATUS,
-	                mu,  __proc_stat_ptable,
+	char buf[MEMUSAGE_BUFSIZE];
+	int ret;
+
+	pthread_mutex_lock(&memusage_lock);
+	ret = memusage_pread(&memusage_proc_file, buf, sizeof buf);
+	pthread_mutex_unlock(&memusage_lock);
+	if (ret != 0 ||
+	    read_status(buf, mu,  __proc_stat_ptable,
 	                (sizeof __proc_stat_ptable)/sizeof(struct stat_parser)) != 0)
 	{
 		return -1;
@@ -332,3 +531,43 @@ int oscap_proc_memusage(struct proc_memusage *mu)
 #endif
 	return 0;
 }
+
+int oscap_cgroup_memusage(struct cgroup_memusage *mu)
+{
+	if (mu == NULL)
+		return -1;
+#if defined(OS_LINUX)
+	int64_t now = memusage_msec();
+	size_t i, value;
+
+	pthread_mutex_lock(&memusage_lock);
+	memusage_cgroup_init();
+	if (memusage_cgroup.max_count == 0 && memusage_cgroup.current_fd == -1) {
+		pthread_mutex_unlock(&memusage_lock);
+		errno = ENOENT;
+		return -1;
+	}
+	if (!memusage_cache_valid(memusage_cache.cgroup_msec, now)) {
+		memusage_cache.cgroup.mu_limit = 0;
+		memusage_cache.cgroup.mu_current = 0;
+
+		/* the lowest limit on the way to the root applies */
+		for (i = 0; i < memusage_cgroup.max_count; ++i) {
+			if (memusage_pread_sizet(memusage_cgroup.max_fds[i], &value) == 0 &&
+			    value < MEMUSAGE_CGROUP_V1_UNLIMITED &&
+			    (memusage_cache.cgroup.mu_limit == 0 || value < memusage_cache.cgroup.mu_limit))
+				memusage_cache.cgroup.mu_limit = value;
+		}
+		if (memusage_cgroup.current_fd != -1 &&
+		    memusage_pread_sizet(memusage_cgroup.current_fd, &value) == 0)
+			memusage_cache.cgroup.mu_current = value;
+		memusage_cache.cgroup_msec = now;
+	}
+	*mu = memusage_cache.cgroup;
+	pthread_mutex_unlock(&memusage_lock);
+#else
+	errno = EOPNOTSUPP;
+	return -1;
+#endif
+	return 0;
+}
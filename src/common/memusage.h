@@ -30,7 +30,23 @@ struct sys_memusage {
 	size_t mu_inactive;
 };
 
+/* memory of the cgroup of the process, in bytes */
+struct cgroup_memusage {
+	size_t mu_limit;     /* lowest limit of the cgroup and its parents, 0 if there is none */
+	size_t mu_current;   /* memory charged to the cgroup, 0 if unknown */
+};
+
 int oscap_proc_memusage(struct proc_memusage *mu);
 int oscap_sys_memusage(struct sys_memusage *mu);
 
+/**
+ * Get the memory limit and usage of the cgroup of the process, from the
+ * cgroup v2 memory.max and memory.current files or the cgroup v1 memory
+ * controller. The files are kept open, so the first call should happen
+ * before the process changes its root directory. System and cgroup usage
+ * are cached for a short while.
+ * @return 0 on success, -1 if the process has no memory cgroup
+ */
+int oscap_cgroup_memusage(struct cgroup_memusage *mu);
+
 #endif /* MEMUSAGE_H */
@@ -24,6 +24,8 @@
 
 #include <string.h>
 #include <errno.h>
+#include <inttypes.h>
+#include <pthread.h>
 #ifdef OS_WINDOWS
 #include <io.h>
 #include <direct.h>
@@ -42,9 +44,11 @@
 
 #include <curl/curl.h>
 #include <curl/easy.h>
+#include <curl/multi.h>
 
 #include "oscap_acquire.h"
 #include "common/util.h"
+#include "common/list.h"
 #include "common/oscap_buffer.h"
 #include "common/_error.h"
 #include "oscap_string.h"
@@ -317,105 +321,404 @@ static int _curl_trace(CURL *handle, curl_infotype type, char *data, size_t size
 	return 0;
 }
 
-char* oscap_acquire_url_download(const char *url, size_t* memory_size)
+/* at most this many connections are open at once by oscap_acquire_url_prefetch */
+#define OSCAP_ACQUIRE_PARALLEL 8
+
+struct oscap_download {
+	char *url;
+	struct oscap_buffer *buffer;
+	struct curl_slist *headers;  ///< conditional request headers
+	char *cache_path;            ///< NULL without OSCAP_DOWNLOAD_CACHE
+	char *cached;                ///< contents of the cache file
+	const char *cached_body;
+	size_t cached_size;
+	char *etag;                  ///< validators of the response
+	char *last_modified;
+	char *data;                  ///< downloaded data, NULL on error
+	size_t size;
+	char *error;
+};
+
+static pthread_mutex_t acquire_lock = PTHREAD_MUTEX_INITIALIZER;
+/* reused by the downloads one at a time, so that it keeps the connections open */
+static CURL *acquire_curl = NULL;
+/* url -> struct oscap_download finished by oscap_acquire_url_prefetch */
+static struct oscap_htable *acquire_prefetched = NULL;
+
+static void _download_free(void *ptr)
 {
-	CURL *curl;
-	curl = curl_easy_init();
-	if (curl == NULL) {
-		oscap_seterr(OSCAP_EFAMILY_NET, "Failed to initialize libcurl.");
-		return NULL;
+	struct oscap_download *dl = ptr;
+
+	if (dl == NULL)
+		return;
+	free(dl->url);
+	oscap_buffer_free(dl->buffer);
+	curl_slist_free_all(dl->headers);
+	free(dl->cache_path);
+	free(dl->cached);
+	free(dl->etag);
+	free(dl->last_modified);
+	free(dl->data);
+	free(dl->error);
+	free(dl);
+}
+
+/* FNV-1a, names the cache file of the url */
+static uint64_t _download_url_hash(const char *url)
+{
+	uint64_t hash = 14695981039346656037ULL;
+
+	for (; *url != '\0'; ++url) {
+		hash ^= (unsigned char)*url;
+		hash *= 1099511628211ULL;
 	}
+	return hash;
+}
 
-	CURLcode res;
+/* take the next line of the cache file header */
+static char *_download_cache_line(char **pos, const char *end)
+{
+	char *line = *pos, *eol = memchr(line, '\n', end - line);
 
-	/* CURLOPT_FAILONERROR - request failure on HTTP response >= 400 */
-	res = curl_easy_setopt(curl, CURLOPT_FAILONERROR, true);
-	if (res != 0) {
-		curl_easy_cleanup(curl);
-		oscap_seterr(OSCAP_EFAMILY_NET, "Failed to set CURLOPT_FAILONERROR: %s", curl_easy_strerror(res));
+	if (eol == NULL)
 		return NULL;
+	*eol = '\0';
+	*pos = eol + 1;
+	return line;
+}
+
+/*
+ * The cache file holds the url, the ETag and the Last-Modified validators
+ * on separate lines, an empty line and the data.
+ */
+static void _download_cache_load(struct oscap_download *dl)
+{
+	char *pos, *end, *url, *etag, *last_modified;
+	struct stat st;
+	FILE *fp;
+
+	fp = fopen(dl->cache_path, "rb");
+	if (fp == NULL)
+		return;
+	if (fstat(fileno(fp), &st) != 0 || !S_ISREG(st.st_mode)) {
+		fclose(fp);
+		return;
+	}
+	dl->cached = malloc(st.st_size + 1);
+	if (dl->cached == NULL || fread(dl->cached, 1, st.st_size, fp) != (size_t)st.st_size) {
+		fclose(fp);
+		free(dl->cached);
+		dl->cached = NULL;
+		return;
 	}
+	fclose(fp);
+	dl->cached[st.st_size] = '\0';
+
+	pos = dl->cached;
+	end = dl->cached + st.st_size;
+	url = _download_cache_line(&pos, end);
+	etag = _download_cache_line(&pos, end);
+	last_modified = _download_cache_line(&pos, end);
+	if (url == NULL || etag == NULL || last_modified == NULL
+	    || _download_cache_line(&pos, end) == NULL || strcmp(url, dl->url) != 0) {
+		/* another url with the same hash or a damaged file */
+		free(dl->cached);
+		dl->cached = NULL;
+		return;
+	}
+	dl->cached_body = pos;
+	dl->cached_size = end - pos;
 
-	res = curl_easy_setopt(curl, CURLOPT_URL, url);
-	if (res != 0) {
-		curl_easy_cleanup(curl);
-		oscap_seterr(OSCAP_EFAMILY_NET, "Failed to set CURLOPT_URL to '%s': %s", url, curl_easy_strerror(res));
-		return NULL;
+	if (*etag != '\0') {
+		char *header = oscap_sprintf("If-None-Match: %s", etag);
+		dl->headers = curl_slist_append(dl->headers, header);
+		free(header);
 	}
+	if (*last_modified != '\0') {
+		char *header = oscap_sprintf("If-Modified-Since: %s", last_modified);
+		dl->headers = curl_slist_append(dl->headers, header);
+		free(header);
+	}
+}
 
-	res = curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_to_memory_callback);
-	if (res != 0) {
-		curl_easy_cleanup(curl);
-		oscap_seterr(OSCAP_EFAMILY_NET, "Failed to set CURLOPT_WRITEFUNCTION to write_to_memory_callback: %s", curl_easy_strerror(res));
-		return NULL;
+static void _download_cache_store(const struct oscap_download *dl)
+{
+#ifndef OS_WINDOWS
+	char *tmp_path, *dir_copy, *dir;
+	FILE *fp;
+	int fd;
+
+	dir_copy = oscap_strdup(dl->cache_path);
+	dir = oscap_dirname(dir_copy);
+	free(dir_copy);
+	tmp_path = oscap_sprintf("%s/.download.XXXXXX", dir);
+	free(dir);
+
+	fd = mkstemp(tmp_path);
+	if (fd == -1) {
+		dW("Can't store the download of '%s' in the cache: %s", dl->url, strerror(errno));
+		free(tmp_path);
+		return;
+	}
+	fp = fdopen(fd, "wb");
+	if (fp == NULL || fprintf(fp, "%s\n%s\n%s\n\n", dl->url,
+	                          dl->etag != NULL ? dl->etag : "",
+	                          dl->last_modified != NULL ? dl->last_modified : "") < 0
+	    || fwrite(dl->data, 1, dl->size, fp) != dl->size || fclose(fp) != 0) {
+		dW("Can't store the download of '%s' in the cache: %s", dl->url, strerror(errno));
+		if (fp == NULL)
+			close(fd);
+		unlink(tmp_path);
+		free(tmp_path);
+		return;
 	}
+	if (rename(tmp_path, dl->cache_path) != 0) {
+		dW("Can't store the download of '%s' in the cache: %s", dl->url, strerror(errno));
+		unlink(tmp_path);
+	}
+	free(tmp_path);
+#endif
+}
 
-	res = curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "");
-	if (res != 0) {
-		curl_easy_cleanup(curl);
-		oscap_seterr(OSCAP_EFAMILY_NET, "Failed to set CURLOPT_ACCEPT_ENCODING to an empty string: %s", curl_easy_strerror(res));
-		return NULL;
+static struct oscap_download *_download_new(const char *url)
+{
+	struct oscap_download *dl = calloc(1, sizeof(struct oscap_download));
+	const char *cache_dir = getenv("OSCAP_DOWNLOAD_CACHE");
+
+	dl->url = oscap_strdup(url);
+	dl->buffer = oscap_buffer_new();
+	if (cache_dir != NULL && *cache_dir != '\0') {
+		dl->cache_path = oscap_sprintf("%s/%016" PRIx64, cache_dir, _download_url_hash(url));
+		_download_cache_load(dl);
 	}
 
-	res = curl_easy_setopt(curl, CURLOPT_TRANSFER_ENCODING, true);
-	if (res != 0) {
-		curl_easy_cleanup(curl);
-		oscap_seterr(OSCAP_EFAMILY_NET, "Failed to set CURLOPT_TRANSFER_ENCODING to true: %s", curl_easy_strerror(res));
-		return NULL;
+	return dl;
+}
+
+/* copy the value of the header if its name matches */
+static void _download_header_value(const char *name, const char *line, size_t len, char **value)
+{
+	size_t name_len = strlen(name);
+
+	if (len <= name_len || oscap_strncasecmp(line, name, name_len) != 0)
+		return;
+	line += name_len;
+	len -= name_len;
+	while (len > 0 && (*line == ' ' || *line == '\t')) {
+		++line;
+		--len;
 	}
+	while (len > 0 && (line[len - 1] == '\r' || line[len - 1] == '\n' || line[len - 1] == ' '))
+		--len;
 
-	res = curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, true);
-	if (res != 0) {
-		curl_easy_cleanup(curl);
-		oscap_seterr(OSCAP_EFAMILY_NET, "Failed to set CURLOPT_FOLLOWLOCATION to true: %s", curl_easy_strerror(res));
-		return NULL;
+	free(*value);
+	*value = malloc(len + 1);
+	memcpy(*value, line, len);
+	(*value)[len] = '\0';
+}
+
+static size_t _download_header_callback(char *buffer, size_t size, size_t nitems, void *userdata)
+{
+	struct oscap_download *dl = userdata;
+	size_t len = size * nitems;
+
+	/* only the validators of the last response count, e.g. after a redirect */
+	if (len > 5 && strncmp(buffer, "HTTP/", 5) == 0) {
+		free(dl->etag);
+		free(dl->last_modified);
+		dl->etag = NULL;
+		dl->last_modified = NULL;
 	}
+	_download_header_value("ETag:", buffer, len, &dl->etag);
+	_download_header_value("Last-Modified:", buffer, len, &dl->last_modified);
 
-	res = curl_easy_setopt(curl, CURLOPT_VERBOSE, true);
-	if (res != 0) {
-		curl_easy_cleanup(curl);
-		oscap_seterr(OSCAP_EFAMILY_NET, "Failed to set CURLOPT_VERBOSE to true: %s", curl_easy_strerror(res));
-		return NULL;
+	return len;
+}
+
+static int _download_setup(CURL *curl, struct oscap_download *dl)
+{
+	CURLcode res;
+
+	/* CURLOPT_FAILONERROR - request failure on HTTP response >= 400 */
+	if ((res = curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L)) != CURLE_OK
+	    || (res = curl_easy_setopt(curl, CURLOPT_URL, dl->url)) != CURLE_OK
+	    || (res = curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_to_memory_callback)) != CURLE_OK
+	    || (res = curl_easy_setopt(curl, CURLOPT_WRITEDATA, dl->buffer)) != CURLE_OK
+	    || (res = curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, _download_header_callback)) != CURLE_OK
+	    || (res = curl_easy_setopt(curl, CURLOPT_HEADERDATA, dl)) != CURLE_OK
+	    || (res = curl_easy_setopt(curl, CURLOPT_HTTPHEADER, dl->headers)) != CURLE_OK
+	    || (res = curl_easy_setopt(curl, CURLOPT_PRIVATE, dl)) != CURLE_OK
+	    /* an empty string enables all the encodings curl can decode */
+	    || (res = curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "")) != CURLE_OK
+	    || (res = curl_easy_setopt(curl, CURLOPT_TRANSFER_ENCODING, 1L)) != CURLE_OK
+	    || (res = curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L)) != CURLE_OK
+	    || (res = curl_easy_setopt(curl, CURLOPT_VERBOSE, 1L)) != CURLE_OK
+	    || (res = curl_easy_setopt(curl, CURLOPT_DEBUGFUNCTION, _curl_trace)) != CURLE_OK) {
+		dl->error = oscap_sprintf("Failed to set up the download of '%s': %s", dl->url, curl_easy_strerror(res));
+		return -1;
 	}
 
-	res = curl_easy_setopt(curl, CURLOPT_DEBUGFUNCTION, _curl_trace);
-	if (res != 0) {
-		curl_easy_cleanup(curl);
-		oscap_seterr(OSCAP_EFAMILY_NET, "Failed to set CURLOPT_DEBUGFUNCTION to _curl_trace: %s", curl_easy_strerror(res));
-		return NULL;
+	return 0;
+}
+
+static void _download_finish(CURL *curl, struct oscap_download *dl, CURLcode res)
+{
+	long http_code = 0;
+
+	curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+	if (res != CURLE_OK) {
+		if (res == CURLE_HTTP_RETURNED_ERROR)
+			dl->error = oscap_sprintf("Download failed: %s: %ld", curl_easy_strerror(res), http_code);
+		else
+			dl->error = oscap_sprintf("Download failed: %s", curl_easy_strerror(res));
+		return;
 	}
 
-	struct oscap_buffer *buffer = oscap_buffer_new();
-	res = curl_easy_setopt(curl, CURLOPT_WRITEDATA, buffer);
-	if (res != 0) {
-		curl_easy_cleanup(curl);
-		oscap_seterr(OSCAP_EFAMILY_NET, "Failed to set CURLOPT_WRITEDATA as buffer: %s", curl_easy_strerror(res));
-		oscap_buffer_free(buffer);
-		return NULL;
+	if (http_code == 304 && dl->cached != NULL) {
+		dI("Using the cached copy of '%s', it was not modified.", dl->url);
+		dl->data = malloc(dl->cached_size + 1);
+		memcpy(dl->data, dl->cached_body, dl->cached_size);
+		dl->data[dl->cached_size] = '\0';
+		dl->size = dl->cached_size;
+		return;
 	}
 
-	res = curl_easy_perform(curl);
+	dl->size = oscap_buffer_get_length(dl->buffer);
+	dl->data = oscap_buffer_bequeath(dl->buffer); // get data and free buffer struct
+	dl->buffer = NULL;
+	/* a response without validators can't be revalidated */
+	if (dl->cache_path != NULL && (dl->etag != NULL || dl->last_modified != NULL))
+		_download_cache_store(dl);
+}
 
-	if (res != 0) {
-		if (res == CURLE_HTTP_RETURNED_ERROR) {
-			long http_code = 0;
-			curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
-			oscap_seterr(OSCAP_EFAMILY_NET, "Download failed: %s: %ld", curl_easy_strerror(res), http_code);
-		} else {
-			oscap_seterr(OSCAP_EFAMILY_NET, "Download failed: %s", curl_easy_strerror(res));
+void oscap_acquire_url_prefetch(const char **urls, size_t count)
+{
+	struct oscap_htable *prefetched, *old;
+	CURL **handles;
+	CURLMsg *msg;
+	CURLM *multi;
+	int running, pending;
+
+	if (count == 0)
+		return;
+	multi = curl_multi_init();
+	if (multi == NULL)
+		return;
+	prefetched = oscap_htable_new();
+	handles = calloc(count, sizeof(CURL *));
+	curl_multi_setopt(multi, CURLMOPT_MAX_TOTAL_CONNECTIONS, (long)OSCAP_ACQUIRE_PARALLEL);
+#ifdef CURLPIPE_MULTIPLEX
+	curl_multi_setopt(multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+#endif
+
+	for (size_t i = 0; i < count; ++i) {
+		struct oscap_download *dl;
+		CURL *curl;
+
+		if (oscap_htable_get(prefetched, urls[i]) != NULL)
+			continue;
+		dl = _download_new(urls[i]);
+		oscap_htable_add(prefetched, urls[i], dl);
+
+		curl = curl_easy_init();
+		if (curl == NULL) {
+			dl->error = oscap_strdup("Failed to initialize libcurl.");
+			continue;
 		}
-		curl_easy_cleanup(curl);
-		oscap_buffer_free(buffer);
-		return NULL;
+		if (_download_setup(curl, dl) != 0 || curl_multi_add_handle(multi, curl) != CURLM_OK) {
+			if (dl->error == NULL)
+				dl->error = oscap_sprintf("Failed to start the download of '%s'.", dl->url);
+			curl_easy_cleanup(curl);
+			continue;
+		}
+		handles[i] = curl;
 	}
 
-	curl_easy_cleanup(curl);
+	dI("Downloading %zu remote resources in parallel.", oscap_htable_itemcount(prefetched));
+	curl_multi_perform(multi, &running);
+	while (running > 0) {
+		if (curl_multi_wait(multi, NULL, 0, 1000, NULL) != CURLM_OK)
+			break;
+		curl_multi_perform(multi, &running);
+	}
+
+	while ((msg = curl_multi_info_read(multi, &pending)) != NULL) {
+		struct oscap_download *dl = NULL;
+
+		if (msg->msg != CURLMSG_DONE)
+			continue;
+		curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char **)&dl);
+		_download_finish(msg->easy_handle, dl, msg->data.result);
+	}
+	/* unfinished downloads are repeated by oscap_acquire_url_download */
+	for (size_t i = 0; i < count; ++i) {
+		if (handles[i] == NULL)
+			continue;
+		curl_multi_remove_handle(multi, handles[i]);
+		curl_easy_cleanup(handles[i]);
+	}
+	free(handles);
+	curl_multi_cleanup(multi);
+
+	/* the results nobody asked for since the last prefetch are dropped */
+	pthread_mutex_lock(&acquire_lock);
+	old = acquire_prefetched;
+	acquire_prefetched = prefetched;
+	pthread_mutex_unlock(&acquire_lock);
+	oscap_htable_free(old, _download_free);
+}
 
-	*memory_size = oscap_buffer_get_length(buffer);
-	char* data = oscap_buffer_bequeath(buffer); // get data and free buffer struct
+char* oscap_acquire_url_download(const char *url, size_t* memory_size)
+{
+	struct oscap_download *dl = NULL;
+	char *data;
+
+	pthread_mutex_lock(&acquire_lock);
+	if (acquire_prefetched != NULL)
+		dl = oscap_htable_detach(acquire_prefetched, url);
+	if (dl != NULL && dl->data == NULL && dl->error == NULL) {
+		_download_free(dl);
+		dl = NULL;
+	}
+
+	if (dl == NULL) {
+		dl = _download_new(url);
+		if (acquire_curl == NULL)
+			acquire_curl = curl_easy_init();
+		else
+			curl_easy_reset(acquire_curl);
+
+		if (acquire_curl == NULL)
+			dl->error = oscap_strdup("Failed to initialize libcurl.");
+		else if (_download_setup(acquire_curl, dl) == 0)
+			_download_finish(acquire_curl, dl, curl_easy_perform(acquire_curl));
+	}
+	pthread_mutex_unlock(&acquire_lock);
+
+	if (dl->error != NULL) {
+		oscap_seterr(OSCAP_EFAMILY_NET, "%s", dl->error);
+		_download_free(dl);
+		return NULL;
+	}
+
+	*memory_size = dl->size;
+	data = dl->data;
+	dl->data = NULL;
+	_download_free(dl);
 	return data;
 }
 
+void oscap_acquire_cleanup(void)
+{
+	pthread_mutex_lock(&acquire_lock);
+	if (acquire_curl != NULL)
+		curl_easy_cleanup(acquire_curl);
+	acquire_curl = NULL;
+	oscap_htable_free(acquire_prefetched, _download_free);
+	acquire_prefetched = NULL;
+	pthread_mutex_unlock(&acquire_lock);
+}
+
 size_t write_to_memory_callback(char *ptr, size_t size, size_t nmemb, void *userdata)
 {
 	size_t new_received_size = size * nmemb; // total size of newly received data
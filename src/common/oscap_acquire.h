@@ -75,6 +75,25 @@ char *oscap_acquire_url_to_filename(const char *url);
 char *
 oscap_acquire_url_download(const char *url, size_t* memory_size);
 
+/**
+ * Download the given urls in parallel over shared connections. The results
+ * are kept in memory until they are taken by oscap_acquire_url_download,
+ * which reports the errors, or until the next prefetch.
+ *
+ * If the OSCAP_DOWNLOAD_CACHE environment variable names a directory, the
+ * downloads are stored there along with their ETag and Last-Modified
+ * validators, and the next downloads of the same url are conditional
+ * requests, so unmodified resources are not transferred again.
+ * @param urls The urls to acquire
+ * @param count Number of the urls
+ */
+void oscap_acquire_url_prefetch(const char **urls, size_t count);
+
+/**
+ * Close the connections kept open and drop the prefetched downloads.
+ */
+void oscap_acquire_cleanup(void);
+
 /**
  * Guess how the realpath of given file may look like. Do your best!
  * Unlike realpath() this works for non-existent files.
@@ -44,6 +44,15 @@ struct oscap_buffer {
 	size_t capacity;
 };
 
+static size_t oscap_buffer_grow(size_t capacity, size_t needed)
+{
+	if (capacity < INITIAL_CAPACITY)
+		capacity = INITIAL_CAPACITY;
+	while (capacity < needed)
+		capacity *= 2;
+	return capacity;
+}
+
 struct oscap_buffer *oscap_buffer_new()
 {
 	struct oscap_buffer *s;
@@ -80,19 +89,16 @@ void oscap_buffer_append_binary_data(struct oscap_buffer *s, const char *data, c
 	if (s == NULL || data == NULL)
 		return;
 	if (s->length + append_length + 1 > s->capacity)  {
-		/* Aligning allocated memory to multiples of INITIAL_CAPACITY.
-		 * We pass to realloc the nearest greater muliple of INITIAL_CAPACITY
-		 * rather than only needed capacity in order to not fragment
-		 * the memory.
+		/* The capacity at least doubles, appending a long text piece by
+		 * piece takes a logarithmic number of reallocations. It stays
+		 * a multiple of INITIAL_CAPACITY not to fragment the memory.
 		 */
-		size_t current_capacity = s->capacity;
-		s->capacity = ((s->capacity + append_length - 1) / INITIAL_CAPACITY + 1) * INITIAL_CAPACITY;
-		void *new_data = realloc(s->data, s->capacity);
-		if (new_data == NULL) {
-			s->capacity = current_capacity;
+		size_t new_capacity = oscap_buffer_grow(s->capacity, s->length + append_length + 1);
+		void *new_data = realloc(s->data, new_capacity);
+		if (new_data == NULL)
 			return;
-		}
 		s->data = new_data;
+		s->capacity = new_capacity;
 	}
 
 	memcpy(s->data + s->length, data, append_length);
@@ -117,4 +123,71 @@ size_t oscap_buffer_get_length(const struct oscap_buffer *s){
 	return s->length;
 }
 
+void oscap_strbuf_init(struct oscap_strbuf *b)
+{
+	b->data = b->inline_data;
+	b->data[0] = '\0';
+	b->length = 0;
+	b->capacity = OSCAP_STRBUF_INLINE_SIZE;
+}
+
+void oscap_strbuf_release(struct oscap_strbuf *b)
+{
+	if (b->data != b->inline_data)
+		free(b->data);
+	oscap_strbuf_init(b);
+}
+
+void oscap_strbuf_clear(struct oscap_strbuf *b)
+{
+	b->data[0] = '\0';
+	b->length = 0;
+}
+
+void oscap_strbuf_append(struct oscap_strbuf *b, const char *data, size_t length)
+{
+	if (data == NULL || length == 0)
+		return;
+	if (b->length + length + 1 > b->capacity) {
+		size_t new_capacity = oscap_buffer_grow(b->capacity, b->length + length + 1);
+		char *new_data;
+		if (b->data == b->inline_data) {
+			new_data = malloc(new_capacity);
+			if (new_data != NULL)
+				memcpy(new_data, b->data, b->length + 1);
+		} else {
+			new_data = realloc(b->data, new_capacity);
+		}
+		if (new_data == NULL)
+			return;
+		b->data = new_data;
+		b->capacity = new_capacity;
+	}
+	memcpy(b->data + b->length, data, length);
+	b->length += length;
+	b->data[b->length] = '\0';
+}
+
+void oscap_strbuf_append_string(struct oscap_strbuf *b, const char *t)
+{
+	if (t != NULL)
+		oscap_strbuf_append(b, t, strlen(t));
+}
 
+const char *oscap_strbuf_get(const struct oscap_strbuf *b)
+{
+	return b->data;
+}
+
+size_t oscap_strbuf_get_length(const struct oscap_strbuf *b)
+{
+	return b->length;
+}
+
+char *oscap_strbuf_strdup(const struct oscap_strbuf *b)
+{
+	char *ret = malloc(b->length + 1);
+	if (ret != NULL)
+		memcpy(ret, b->data, b->length + 1);
+	return ret;
+}
@@ -88,5 +88,69 @@ char *oscap_buffer_get_raw(const struct oscap_buffer *s);
  */
 size_t oscap_buffer_get_length(const struct oscap_buffer *s);
 
+/**
+ * String builder living on the stack of the caller. Short strings are kept
+ * in the builder itself and only longer ones are moved to the heap, so the
+ * usual element texts and attribute values are built without allocating.
+ * The content is always NUL terminated. The builder points into itself,
+ * it must not be copied.
+ */
+#define OSCAP_STRBUF_INLINE_SIZE 128
+struct oscap_strbuf {
+	char *data;
+	size_t length;
+	size_t capacity;
+	char inline_data[OSCAP_STRBUF_INLINE_SIZE];
+};
+
+/**
+ * Initialize an empty builder.
+ * @param b builder
+ */
+void oscap_strbuf_init(struct oscap_strbuf *b);
+
+/**
+ * Free the heap memory of the builder, if any. The builder can be
+ * initialized again afterwards.
+ * @param b builder
+ */
+void oscap_strbuf_release(struct oscap_strbuf *b);
+
+/**
+ * Erase the content, the memory is kept for the next use.
+ * @param b builder
+ */
+void oscap_strbuf_clear(struct oscap_strbuf *b);
+
+/**
+ * Append data at the end of the builder. The capacity grows geometrically.
+ * @param b builder
+ * @param data to append
+ * @param length of the data
+ */
+void oscap_strbuf_append(struct oscap_strbuf *b, const char *data, size_t length);
+
+/**
+ * Append a NUL terminated string, NULL is ignored.
+ * @param b builder
+ * @param t to append
+ */
+void oscap_strbuf_append_string(struct oscap_strbuf *b, const char *t);
+
+/**
+ * Get the content, it is valid until the builder is modified or released.
+ * @param b builder
+ */
+const char *oscap_strbuf_get(const struct oscap_strbuf *b);
+
+size_t oscap_strbuf_get_length(const struct oscap_strbuf *b);
+
+/**
+ * Get a heap copy of the content, allocated to fit.
+ * @param b builder
+ * @return copy to be freed by the caller
+ */
+char *oscap_strbuf_strdup(const struct oscap_strbuf *b);
+
 
 #endif
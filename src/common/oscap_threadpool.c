@@ -0,0 +1,209 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#if defined(OS_WINDOWS)
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "_error.h"
+#include "debug_priv.h"
+#include "oscap_threadpool.h"
+
+struct oscap_threadpool_loop {
+	oscap_threadpool_func func;
+	void *arg;
+	char **errors;                  ///< errors of the other threads, raised again by the caller
+	size_t count;
+	size_t next;                    ///< first index which isn't taken by a thread
+	pthread_mutex_t lock;
+};
+
+static pthread_once_t threadpool_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t threadpool_lock = PTHREAD_MUTEX_INITIALIZER;
+static size_t threadpool_limit = 0;     ///< OSCAP_JOBS, 0 if it isn't set
+static size_t threadpool_busy = 0;      ///< threads started by the running loops
+
+static long threadpool_parse(const char *env)
+{
+	const char *jobs_str;
+	long jobs = 0;
+
+	if (env == NULL)
+		return 0;
+	jobs_str = getenv(env);
+	if (jobs_str != NULL) {
+		char *end;
+
+		jobs = strtol(jobs_str, &end, 10);
+		if (*end != '\0' || jobs <= 0) {
+			dW("Invalid %s value '%s'.", env, jobs_str);
+			jobs = 0;
+		}
+	}
+	return jobs;
+}
+
+static void threadpool_init(void)
+{
+	threadpool_limit = (size_t)threadpool_parse("OSCAP_JOBS");
+}
+
+static size_t threadpool_cpus(void)
+{
+	long cpus = 0;
+
+#if defined(OS_WINDOWS)
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	cpus = info.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+	cpus = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	return cpus > 0 ? (size_t)cpus : 1;
+}
+
+size_t oscap_threadpool_jobs(const char *env, size_t default_jobs, size_t max_jobs)
+{
+	size_t jobs;
+
+	pthread_once(&threadpool_once, threadpool_init);
+
+	jobs = (size_t)threadpool_parse(env);
+	if (jobs == 0)
+		jobs = default_jobs;
+	if (jobs == 0)
+		jobs = threadpool_cpus();
+	if (threadpool_limit > 0 && jobs > threadpool_limit)
+		jobs = threadpool_limit;
+	if (jobs > max_jobs)
+		jobs = max_jobs;
+	if (jobs < 1)
+		jobs = 1;
+
+	return jobs;
+}
+
+/* Take up to wanted threads from the budget of OSCAP_JOBS */
+static size_t threadpool_reserve(size_t wanted)
+{
+	size_t granted = wanted;
+
+	if (threadpool_limit == 0)
+		return wanted;
+
+	pthread_mutex_lock(&threadpool_lock);
+	/* the calling threads of the loops aren't counted */
+	if (threadpool_busy + 1 >= threadpool_limit)
+		granted = 0;
+	else if (granted > threadpool_limit - 1 - threadpool_busy)
+		granted = threadpool_limit - 1 - threadpool_busy;
+	threadpool_busy += granted;
+	pthread_mutex_unlock(&threadpool_lock);
+
+	return granted;
+}
+
+static void threadpool_release(size_t count)
+{
+	if (threadpool_limit == 0 || count == 0)
+		return;
+
+	pthread_mutex_lock(&threadpool_lock);
+	threadpool_busy -= count;
+	pthread_mutex_unlock(&threadpool_lock);
+}
+
+static void threadpool_loop_run(struct oscap_threadpool_loop *loop, bool worker)
+{
+	size_t i;
+
+	for (;;) {
+		pthread_mutex_lock(&loop->lock);
+		if (loop->next == loop->count) {
+			pthread_mutex_unlock(&loop->lock);
+			break;
+		}
+		i = loop->next++;
+		pthread_mutex_unlock(&loop->lock);
+
+		loop->func(loop->arg, i);
+		if (worker && loop->errors != NULL && oscap_err())
+			loop->errors[i] = oscap_err_get_full_error();
+	}
+}
+
+static void *threadpool_thread(void *arg)
+{
+	threadpool_loop_run(arg, true);
+	return NULL;
+}
+
+size_t oscap_threadpool_run(size_t jobs, size_t count, oscap_threadpool_func func, void *arg, char **errors)
+{
+	struct oscap_threadpool_loop loop;
+	pthread_t *threads = NULL;
+	size_t i, reserved, started = 0;
+
+	pthread_once(&threadpool_once, threadpool_init);
+
+	memset(&loop, 0, sizeof(loop));
+	loop.func = func;
+	loop.arg = arg;
+	loop.errors = errors;
+	loop.count = count;
+
+	if (jobs > count)
+		jobs = count;
+	reserved = jobs > 1 ? threadpool_reserve(jobs - 1) : 0;
+	if (reserved > 0)
+		threads = malloc(reserved * sizeof(pthread_t));
+	if (threads == NULL)
+		reserved = 0;
+
+	pthread_mutex_init(&loop.lock, NULL);
+	for (i = 0; i < reserved; i++) {
+		int err = pthread_create(&threads[started], NULL, threadpool_thread, &loop);
+
+		if (err != 0) {
+			dW("Can't start a thread: %s.", strerror(err));
+			break;
+		}
+		started++;
+	}
+	/* the calling thread takes part too */
+	threadpool_loop_run(&loop, false);
+
+	for (i = 0; i < started; i++)
+		pthread_join(threads[i], NULL);
+	pthread_mutex_destroy(&loop.lock);
+	threadpool_release(reserved);
+	free(threads);
+
+	return started + 1;
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef OSCAP_THREADPOOL_H
+#define OSCAP_THREADPOOL_H
+
+#include <stddef.h>
+
+/*
+ * Threads shared by the parallel loops of the library. A loop calls a
+ * function for each index of a range, the threads take the next index
+ * which isn't taken yet, so a thread finishing early takes over the rest
+ * of the work. The calling thread takes part, the loop always makes
+ * progress even if no other thread is available.
+ *
+ * OSCAP_JOBS limits the number of threads of every loop and, if set, the
+ * number of threads of all the loops running at once in the process.
+ */
+
+typedef void (*oscap_threadpool_func)(void *arg, size_t index);
+
+/**
+ * Get the number of threads of a loop from an environment variable.
+ * @param env name of the variable, e.g. OSCAP_VALIDATION_JOBS, or NULL
+ * @param default_jobs number of threads if the variable isn't set or is
+ * invalid, 0 for the number of online CPUs
+ * @param max_jobs upper bound of the result
+ * @return number of threads, at least 1, at most OSCAP_JOBS if it is set
+ */
+size_t oscap_threadpool_jobs(const char *env, size_t default_jobs, size_t max_jobs);
+
+/**
+ * Call func for each index below count using up to jobs threads including
+ * the calling one. Returns when all the calls are done. The error queue is
+ * per thread, the errors raised by the other threads are kept in errors
+ * if it isn't NULL, to be raised again by the caller.
+ * @param errors array of count entries set to the full error of the index
+ * or left NULL, the caller frees them
+ * @return number of the threads which took part
+ */
+size_t oscap_threadpool_run(size_t jobs, size_t count, oscap_threadpool_func func, void *arg, char **errors);
+
+#endif /* OSCAP_THREADPOOL_H */
@@ -47,12 +47,14 @@
 #include "list.h"
 #include "elements.h"
 #include "debug_priv.h"
+#include "memtag_priv.h"
 #include "oscap_source.h"
 #include "oscapxml.h"
 #include "source/schematron_priv.h"
 #include "source/validate_priv.h"
 #include "source/xslt_priv.h"
 #include "oscap_helpers.h"
+#include "oscap_acquire.h"
 
 const char *const OSCAP_SCHEMA_PATH = OSCAP_DEFAULT_SCHEMA_PATH;
 const char *const OSCAP_XSLT_PATH = OSCAP_DEFAULT_XSLT_PATH;
@@ -111,6 +113,7 @@ const char * oscap_path_to_cpe() {
 
 void oscap_init(void)
 {
+    oscap_memtag_init();
     xmlInitParser();
     xsltInit();
     exsltRegisterAll();
@@ -119,6 +122,9 @@ void oscap_init(void)
 void oscap_cleanup(void)
 {
 	oscap_clearerr();
+	oscap_schema_cache_free();
+	oscap_xslt_cache_free();
+	oscap_acquire_cleanup();
 	xsltCleanupGlobals();
 	xmlCleanupParser();
 }
@@ -0,0 +1,504 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "oscap_platforms.h"
+#ifndef OS_WINDOWS
+#include <sys/resource.h>
+#endif
+
+#include "_error.h"
+#include "list.h"
+#include "debug_priv.h"
+#include "profiling_priv.h"
+#include "memtag_priv.h"
+
+struct oscap_profiling_entry {
+	char    *probe;       /* probe name of an object */
+	uint64_t count;       /* number of recorded sections */
+	uint64_t wall_ns;
+	uint64_t cpu_ns;
+	uint64_t bytes_read;
+	uint64_t items;
+	uint64_t icache_lookups;
+	uint64_t icache_hits;
+	uint64_t start_ns;    /* start of the first section since profiling_epoch_ns */
+	uint64_t end_ns;      /* end of the last section since profiling_epoch_ns */
+};
+
+static const char *profiling_kind_name[OSCAP_PROFILING_KIND_COUNT] = {
+	[OSCAP_PROFILING_OBJECT] = "objects",
+	[OSCAP_PROFILING_PROBE]  = "probes",
+	[OSCAP_PROFILING_TEST]   = "tests",
+	[OSCAP_PROFILING_RULE]   = "rules",
+	[OSCAP_PROFILING_PHASE]  = "phases"
+};
+
+static volatile bool profiling_enabled = false;
+static uint64_t profiling_epoch_ns = 0;
+static pthread_mutex_t profiling_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct oscap_htable *profiling_table[OSCAP_PROFILING_KIND_COUNT];
+
+static void oscap_profiling_entry_free(void *ptr)
+{
+	struct oscap_profiling_entry *entry = ptr;
+
+	if (entry != NULL) {
+		free(entry->probe);
+		free(entry);
+	}
+}
+
+/* Has to be called with profiling_lock held */
+static struct oscap_profiling_entry *oscap_profiling_entry_get(oscap_profiling_kind_t kind, const char *id)
+{
+	struct oscap_profiling_entry *entry;
+
+	if (profiling_table[kind] == NULL)
+		profiling_table[kind] = oscap_htable_new();
+
+	entry = oscap_htable_get(profiling_table[kind], id);
+	if (entry == NULL) {
+		entry = calloc(1, sizeof(struct oscap_profiling_entry));
+		if (!oscap_htable_add(profiling_table[kind], id, entry)) {
+			free(entry);
+			return NULL;
+		}
+	}
+
+	return entry;
+}
+
+static uint64_t oscap_profiling_clock(clockid_t clock)
+{
+	struct timespec ts;
+
+	if (clock_gettime(clock, &ts) != 0)
+		return 0;
+
+	return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+/*
+ * Number of bytes the calling thread has read so far. Only available on
+ * Linux, and not in a chroot without /proc.
+ */
+static uint64_t oscap_profiling_bytes_read(void)
+{
+	uint64_t rchar = 0;
+#if defined(OS_LINUX)
+	char line[64];
+	FILE *fp = fopen("/proc/thread-self/io", "r");
+
+	if (fp == NULL)
+		return 0;
+
+	while (fgets(line, sizeof line, fp) != NULL) {
+		if (sscanf(line, "rchar: %" SCNu64, &rchar) == 1)
+			break;
+	}
+	fclose(fp);
+#endif
+	return rchar;
+}
+
+/* Peak resident set size of the process in kilobytes, 0 if unknown */
+static uint64_t oscap_profiling_peak_rss(void)
+{
+#ifndef OS_WINDOWS
+	struct rusage usage;
+
+	if (getrusage(RUSAGE_SELF, &usage) == 0) {
+# if defined(OS_APPLE)
+		return (uint64_t)usage.ru_maxrss / 1024; /* bytes */
+# else
+		return (uint64_t)usage.ru_maxrss;
+# endif
+	}
+#endif
+	return 0;
+}
+
+void oscap_profiling_set_enabled(bool enable)
+{
+	if (enable && profiling_epoch_ns == 0)
+		profiling_epoch_ns = oscap_profiling_clock(CLOCK_MONOTONIC);
+	profiling_enabled = enable;
+}
+
+bool oscap_profiling_get_enabled(void)
+{
+	return profiling_enabled;
+}
+
+void oscap_profiling_start(struct oscap_profiling_mark *mark)
+{
+	if (!profiling_enabled) {
+		memset(mark, 0, sizeof(struct oscap_profiling_mark));
+		return;
+	}
+
+	mark->wall_ns = oscap_profiling_clock(CLOCK_MONOTONIC);
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+	mark->cpu_ns = oscap_profiling_clock(CLOCK_THREAD_CPUTIME_ID);
+#else
+	mark->cpu_ns = 0;
+#endif
+	mark->bytes_read = oscap_profiling_bytes_read();
+}
+
+void oscap_profiling_stop(const struct oscap_profiling_mark *mark, oscap_profiling_kind_t kind,
+                          const char *id, const char *probe, uint64_t items)
+{
+	struct oscap_profiling_entry *entry;
+	uint64_t end_ns, wall_ns, cpu_ns = 0, bytes_read;
+
+	/* not started, or started before profiling was enabled */
+	if (!profiling_enabled || mark->wall_ns == 0 || id == NULL)
+		return;
+
+	end_ns = oscap_profiling_clock(CLOCK_MONOTONIC);
+	wall_ns = end_ns - mark->wall_ns;
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+	cpu_ns = oscap_profiling_clock(CLOCK_THREAD_CPUTIME_ID) - mark->cpu_ns;
+#endif
+	bytes_read = oscap_profiling_bytes_read();
+	bytes_read = bytes_read > mark->bytes_read ? bytes_read - mark->bytes_read : 0;
+
+	pthread_mutex_lock(&profiling_lock);
+
+	entry = oscap_profiling_entry_get(kind, id);
+	if (entry != NULL) {
+		if (entry->count == 0)
+			entry->start_ns = mark->wall_ns - profiling_epoch_ns;
+		entry->end_ns = end_ns - profiling_epoch_ns;
+		entry->count++;
+		entry->wall_ns += wall_ns;
+		entry->cpu_ns += cpu_ns;
+		entry->bytes_read += bytes_read;
+		entry->items += items;
+		if (probe != NULL && entry->probe == NULL)
+			entry->probe = strdup(probe);
+	}
+
+	/* objects are summed up per probe as well */
+	if (kind == OSCAP_PROFILING_OBJECT && probe != NULL) {
+		entry = oscap_profiling_entry_get(OSCAP_PROFILING_PROBE, probe);
+		if (entry != NULL) {
+			entry->count++;
+			entry->wall_ns += wall_ns;
+			entry->cpu_ns += cpu_ns;
+			entry->bytes_read += bytes_read;
+			entry->items += items;
+		}
+	}
+
+	pthread_mutex_unlock(&profiling_lock);
+}
+
+void oscap_profiling_add_icache(const char *probe, uint64_t lookups, uint64_t hits)
+{
+	struct oscap_profiling_entry *entry;
+
+	if (!profiling_enabled || lookups == 0)
+		return;
+
+	pthread_mutex_lock(&profiling_lock);
+
+	entry = oscap_profiling_entry_get(OSCAP_PROFILING_PROBE, probe);
+	if (entry != NULL) {
+		entry->icache_lookups += lookups;
+		entry->icache_hits += hits;
+	}
+
+	pthread_mutex_unlock(&profiling_lock);
+}
+
+static void oscap_profiling_json_string(FILE *fp, const char *str)
+{
+	fputc('"', fp);
+	for (; *str != '\0'; ++str) {
+		unsigned char c = (unsigned char)*str;
+
+		if (c == '"' || c == '\\')
+			fprintf(fp, "\\%c", c);
+		else if (c < 0x20)
+			fprintf(fp, "\\u%04x", c);
+		else
+			fputc(c, fp);
+	}
+	fputc('"', fp);
+}
+
+static void oscap_profiling_json_entry(FILE *fp, oscap_profiling_kind_t kind, const struct oscap_profiling_entry *entry)
+{
+	fprintf(fp, "{");
+	if (entry->probe != NULL) {
+		fprintf(fp, "\"probe\": ");
+		oscap_profiling_json_string(fp, entry->probe);
+		fprintf(fp, ", ");
+	}
+	fprintf(fp, "\"count\": %" PRIu64 ", \"wall_time\": %.6f, \"cpu_time\": %.6f",
+		entry->count, entry->wall_ns / 1e9, entry->cpu_ns / 1e9);
+
+	if (kind == OSCAP_PROFILING_RULE || kind == OSCAP_PROFILING_PHASE) {
+		fprintf(fp, ", \"start\": %.6f, \"end\": %.6f",
+			entry->start_ns / 1e9, entry->end_ns / 1e9);
+	}
+
+	if (kind == OSCAP_PROFILING_OBJECT || kind == OSCAP_PROFILING_PROBE) {
+		fprintf(fp, ", \"items\": %" PRIu64 ", \"bytes_read\": %" PRIu64,
+			entry->items, entry->bytes_read);
+	}
+	if (kind == OSCAP_PROFILING_PROBE) {
+		fprintf(fp, ", \"icache_lookups\": %" PRIu64 ", \"icache_hits\": %" PRIu64 ", \"icache_hit_rate\": %.4f",
+			entry->icache_lookups, entry->icache_hits,
+			entry->icache_lookups > 0 ? (double)entry->icache_hits / entry->icache_lookups : 0.0);
+	}
+	fprintf(fp, "}");
+}
+
+int oscap_profiling_export(const char *path)
+{
+	FILE *fp;
+	int kind;
+
+	fp = fopen(path, "w");
+	if (fp == NULL) {
+		oscap_seterr(OSCAP_EFAMILY_GLIBC, "Can't open '%s' for writing: %s", path, strerror(errno));
+		return -1;
+	}
+
+	pthread_mutex_lock(&profiling_lock);
+
+	fprintf(fp, "{\n");
+	for (kind = 0; kind < OSCAP_PROFILING_KIND_COUNT; ++kind) {
+		fprintf(fp, "  \"%s\": {", profiling_kind_name[kind]);
+
+		if (profiling_table[kind] != NULL) {
+			struct oscap_htable_iterator *hit = oscap_htable_iterator_new(profiling_table[kind]);
+			bool first = true;
+
+			while (oscap_htable_iterator_has_more(hit)) {
+				const char *id;
+				void *entry;
+
+				oscap_htable_iterator_next_kv(hit, &id, &entry);
+				fprintf(fp, first ? "\n    " : ",\n    ");
+				oscap_profiling_json_string(fp, id);
+				fprintf(fp, ": ");
+				oscap_profiling_json_entry(fp, kind, entry);
+				first = false;
+			}
+			oscap_htable_iterator_free(hit);
+
+			if (!first)
+				fprintf(fp, "\n  ");
+		}
+
+		fprintf(fp, "},\n");
+	}
+	if (oscap_memtag_enabled) {
+		fprintf(fp, "  \"memory\": {");
+		for (int tag = 0; tag < OSCAP_MEMTAG_COUNT; ++tag) {
+			fprintf(fp, "%s\n    \"%s\": {\"current\": %" PRId64 ", \"peak\": %" PRId64 "}",
+				tag > 0 ? "," : "", oscap_memtag_name(tag),
+				oscap_memtag_current(tag), oscap_memtag_peak(tag));
+		}
+		fprintf(fp, "\n  },\n");
+	}
+	fprintf(fp, "  \"process\": {\"peak_rss\": %" PRIu64 "}\n", oscap_profiling_peak_rss());
+	fprintf(fp, "}\n");
+
+	pthread_mutex_unlock(&profiling_lock);
+
+	if (fclose(fp) != 0) {
+		oscap_seterr(OSCAP_EFAMILY_GLIBC, "Can't write '%s': %s", path, strerror(errno));
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * Reads back the quoted ID at the beginning of an entry line written by
+ * oscap_profiling_export, the \u escapes of control characters are not
+ * expected in IDs and are kept as they are.
+ */
+static char *oscap_profiling_json_id(const char *str, const char **end)
+{
+	char *id = malloc(strlen(str) + 1);
+	size_t len = 0;
+
+	for (++str; *str != '\0' && *str != '"'; ++str) {
+		if (*str == '\\' && str[1] != '\0')
+			++str;
+		id[len++] = *str;
+	}
+	if (*str != '"') {
+		free(id);
+		return NULL;
+	}
+	id[len] = '\0';
+	*end = str + 1;
+
+	return id;
+}
+
+struct oscap_htable *oscap_profiling_import_times(const char *path, oscap_profiling_kind_t kind)
+{
+	char line[4096], header[64];
+	struct oscap_htable *times;
+	bool in_section = false;
+	FILE *fp;
+
+	fp = fopen(path, "r");
+	if (fp == NULL) {
+		oscap_seterr(OSCAP_EFAMILY_GLIBC, "Can't open '%s' for reading: %s", path, strerror(errno));
+		return NULL;
+	}
+
+	snprintf(header, sizeof(header), "  \"%s\": {", profiling_kind_name[kind]);
+	times = oscap_htable_new();
+
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		if (!in_section) {
+			in_section = strncmp(line, header, strlen(header)) == 0 &&
+				     line[strlen(header)] == '\n';
+			continue;
+		}
+		if (strncmp(line, "    \"", 5) != 0)
+			break;
+
+		const char *rest;
+		char *id = oscap_profiling_json_id(line + 4, &rest);
+		const char *wall = id != NULL ? strstr(rest, "\"wall_time\": ") : NULL;
+		if (wall == NULL) {
+			free(id);
+			continue;
+		}
+
+		double *seconds = malloc(sizeof(double));
+		*seconds = strtod(wall + strlen("\"wall_time\": "), NULL);
+		if (!oscap_htable_add(times, id, seconds))
+			free(seconds);
+		free(id);
+	}
+	fclose(fp);
+
+	return times;
+}
+
+struct oscap_profiling_item {
+	const char *id;
+	const struct oscap_profiling_entry *entry;
+};
+
+static int oscap_profiling_item_cmp(const void *a, const void *b)
+{
+	const struct oscap_profiling_item *ia = a, *ib = b;
+
+	if (ia->entry->wall_ns != ib->entry->wall_ns)
+		return ia->entry->wall_ns < ib->entry->wall_ns ? 1 : -1;
+	return strcmp(ia->id, ib->id);
+}
+
+/* Has to be called with profiling_lock held, the caller frees the array */
+static struct oscap_profiling_item *oscap_profiling_sorted(oscap_profiling_kind_t kind, size_t *count)
+{
+	struct oscap_profiling_item *items;
+	struct oscap_htable_iterator *hit;
+	size_t n = 0;
+
+	*count = 0;
+	if (profiling_table[kind] == NULL)
+		return NULL;
+
+	items = malloc((oscap_htable_itemcount(profiling_table[kind]) + 1) * sizeof(struct oscap_profiling_item));
+	if (items == NULL)
+		return NULL;
+
+	hit = oscap_htable_iterator_new(profiling_table[kind]);
+	while (oscap_htable_iterator_has_more(hit)) {
+		void *entry;
+
+		oscap_htable_iterator_next_kv(hit, &items[n].id, &entry);
+		items[n++].entry = entry;
+	}
+	oscap_htable_iterator_free(hit);
+
+	qsort(items, n, sizeof(struct oscap_profiling_item), oscap_profiling_item_cmp);
+	*count = n;
+	return items;
+}
+
+void oscap_profiling_log_summary(size_t count)
+{
+	struct oscap_profiling_item *items;
+	size_t n, i;
+
+	pthread_mutex_lock(&profiling_lock);
+
+	items = oscap_profiling_sorted(OSCAP_PROFILING_PHASE, &n);
+	for (i = 0; i < n; ++i) {
+		dI("Phase '%s': %.3f s (%.3f s CPU)", items[i].id,
+		   items[i].entry->wall_ns / 1e9, items[i].entry->cpu_ns / 1e9);
+	}
+	free(items);
+
+	items = oscap_profiling_sorted(OSCAP_PROFILING_RULE, &n);
+	if (n > 0)
+		dI("Slowest rules:");
+	for (i = 0; i < n && i < count; ++i) {
+		dI("  %.3f s  %s", items[i].entry->wall_ns / 1e9, items[i].id);
+	}
+	free(items);
+
+	pthread_mutex_unlock(&profiling_lock);
+
+	if (oscap_memtag_enabled) {
+		for (int tag = 0; tag < OSCAP_MEMTAG_COUNT; ++tag) {
+			dI("Memory of '%s': %.1f MiB peak, %.1f MiB held", oscap_memtag_name(tag),
+			   oscap_memtag_peak(tag) / 1048576.0, oscap_memtag_current(tag) / 1048576.0);
+		}
+	}
+}
+
+void oscap_profiling_reset(void)
+{
+	int kind;
+
+	pthread_mutex_lock(&profiling_lock);
+	for (kind = 0; kind < OSCAP_PROFILING_KIND_COUNT; ++kind) {
+		oscap_htable_free(profiling_table[kind], oscap_profiling_entry_free);
+		profiling_table[kind] = NULL;
+	}
+	pthread_mutex_unlock(&profiling_lock);
+}
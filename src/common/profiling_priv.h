@@ -0,0 +1,73 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef OSCAP_PROFILING_PRIV_H
+#define OSCAP_PROFILING_PRIV_H
+
+#include <stdint.h>
+#include "public/oscap_profiling.h"
+
+typedef enum {
+	OSCAP_PROFILING_OBJECT = 0,
+	OSCAP_PROFILING_PROBE,
+	OSCAP_PROFILING_TEST,
+	OSCAP_PROFILING_RULE,
+	OSCAP_PROFILING_PHASE, /* loading, evaluation and export of a session */
+	OSCAP_PROFILING_KIND_COUNT
+} oscap_profiling_kind_t;
+
+/*
+ * Values sampled at the beginning of a measured section.
+ * All of them are zero if profiling is disabled.
+ */
+struct oscap_profiling_mark {
+	uint64_t wall_ns;
+	uint64_t cpu_ns;     /* CPU time of the calling thread */
+	uint64_t bytes_read; /* bytes read by the calling thread, if known */
+};
+
+/**
+ * Start measuring a section on the calling thread.
+ */
+void oscap_profiling_start(struct oscap_profiling_mark *mark);
+
+/**
+ * Finish the section started by oscap_profiling_start on the same thread
+ * and add it to the statistics of the given ID.
+ * @param kind what the ID refers to
+ * @param id OVAL object/test ID, XCCDF rule ID, probe or phase name
+ * @param probe probe name the object belongs to, NULL for other kinds
+ * @param items number of collected items, 0 for other kinds
+ */
+void oscap_profiling_stop(const struct oscap_profiling_mark *mark, oscap_profiling_kind_t kind,
+                          const char *id, const char *probe, uint64_t items);
+
+/**
+ * Add item cache counters of a probe.
+ */
+void oscap_profiling_add_icache(const char *probe, uint64_t lookups, uint64_t hits);
+
+/**
+ * Read the total wall time of each ID of the given kind from a file
+ * written by oscap_profiling_export.
+ * @return table of IDs to their times in seconds (double), NULL on failure (error is set)
+ */
+struct oscap_htable *oscap_profiling_import_times(const char *path, oscap_profiling_kind_t kind);
+
+#endif /* OSCAP_PROFILING_PRIV_H */
@@ -46,6 +46,13 @@ typedef enum {
  */
 OSCAP_API void __oscap_dlprintf(int level, const char *file, const char *fn, size_t line, int delta_indent, const char *fmt, ...);
 
+/**
+ * Check whether messages of the level are logged.
+ * @param level debug level
+ * @return true if a log is open and its verbosity includes the level
+ */
+OSCAP_API bool oscap_debug_enabled(oscap_verbosity_levels level);
+
 /**
  * Turn on debugging information
  * @param verbosity_level Verbosity level
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Evaluation profiling. When enabled, the library records wall time, CPU
+ * time and other counters for every collected OVAL object, evaluated OVAL
+ * test and XCCDF rule of the process. The data can be exported as JSON.
+ */
+
+#ifndef OSCAP_PROFILING_H
+#define OSCAP_PROFILING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "oscap_export.h"
+
+/**
+ * Switch recording of the evaluation profile on or off.
+ * Recording is off by default.
+ * @param enable true to start recording
+ */
+OSCAP_API void oscap_profiling_set_enabled(bool enable);
+
+/**
+ * @return true if the evaluation profile is being recorded
+ */
+OSCAP_API bool oscap_profiling_get_enabled(void);
+
+/**
+ * Write the recorded evaluation profile into a file as a JSON object with
+ * "objects", "probes", "tests" and "rules" members keyed by their IDs, the
+ * "phases" member with time spent loading, resolving CPE applicability,
+ * collecting, evaluating and exporting, and the "process" member with the
+ * peak resident set size. Rules and phases carry the monotonic start of
+ * their first and the end of their last run, in seconds since recording
+ * was first switched on.
+ * @param path target file
+ * @return 0 on success, -1 on failure (error is set)
+ */
+OSCAP_API int oscap_profiling_export(const char *path);
+
+/**
+ * Log the time of each phase and the given number of the slowest rules
+ * at the INFO verbosity level.
+ * @param count maximal number of rules logged
+ */
+OSCAP_API void oscap_profiling_log_summary(size_t count);
+
+/**
+ * Drop all the recorded data.
+ */
+OSCAP_API void oscap_profiling_reset(void);
+
+#endif /* OSCAP_PROFILING_H */
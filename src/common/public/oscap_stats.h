@@ -0,0 +1,70 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Runtime statistics. The library counts the work done by its caches,
+ * probes, filesystem walks, regular expressions and probe messages for the
+ * whole process. The counters are always on and can be read by name or
+ * exported as JSON or in the Prometheus text format.
+ */
+
+#ifndef OSCAP_STATS_H
+#define OSCAP_STATS_H
+
+#include <stdint.h>
+#include "oscap_export.h"
+
+typedef enum {
+	OSCAP_STATS_FORMAT_JSON = 0,
+	OSCAP_STATS_FORMAT_PROMETHEUS  /**< text format read by the node_exporter textfile collector */
+} oscap_stats_format_t;
+
+/**
+ * Get the value of a counter.
+ * @param name counter name as it appears in the JSON export, e.g.
+ * "icache_hits" or "regex_executions"
+ * @return the value, 0 if the name is unknown
+ */
+OSCAP_API uint64_t oscap_stats_get(const char *name);
+
+/**
+ * Get the number of items collected by a probe.
+ * @param probe probe name, e.g. "file"
+ */
+OSCAP_API uint64_t oscap_stats_get_probe_items(const char *probe);
+
+/**
+ * Write all the counters into a file. The JSON export is an object with
+ * the "counters" member keyed by the counter names and the "probe_items"
+ * member keyed by the probe names. The Prometheus export names the
+ * counters oscap_<name>_total and labels the probe items with the probe.
+ * The file is replaced at once, a reader never sees it half written.
+ * @param path target file
+ * @param format format of the file
+ * @return 0 on success, -1 on failure (error is set)
+ */
+OSCAP_API int oscap_stats_export(const char *path, oscap_stats_format_t format);
+
+/**
+ * Start counting from zero.
+ */
+OSCAP_API void oscap_stats_reset(void);
+
+#endif /* OSCAP_STATS_H */
@@ -0,0 +1,350 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <pthread.h>
+
+#include "_error.h"
+#include "list.h"
+#include "oscap_helpers.h"
+#include "debug_priv.h"
+#include "stats_priv.h"
+
+#if defined(_MSC_VER)
+# define OSCAP_STATS_THREAD_LOCAL __declspec(thread)
+#else
+# define OSCAP_STATS_THREAD_LOCAL __thread
+#endif
+
+struct oscap_stats_counter_info {
+	const char *name;
+	const char *help;
+};
+
+static const struct oscap_stats_counter_info stats_counter_info[OSCAP_STATS_COUNTER_COUNT] = {
+	[OSCAP_STATS_ICACHE_HITS]         = { "icache_hits", "Collected items found in the probe item cache." },
+	[OSCAP_STATS_ICACHE_MISSES]       = { "icache_misses", "Collected items added to the probe item cache." },
+	[OSCAP_STATS_ICACHE_LOCK_WAITS]   = { "icache_lock_waits", "Locks of the probe item cache queue which had to wait for another thread." },
+	[OSCAP_STATS_ICACHE_LOCK_WAIT_NS] = { "icache_lock_wait_ns", "Nanoseconds spent waiting for the probe item cache queue lock." },
+	[OSCAP_STATS_MEMCHECK_REJECTIONS] = { "memcheck_rejections", "Items not collected because of the memory budget of the probes." },
+	[OSCAP_STATS_FTS_ENTRIES]         = { "fts_entries", "Filesystem entries returned by the filesystem walks." },
+	[OSCAP_STATS_FTS_DIR_BYTES]       = { "fts_dir_bytes", "Bytes of directory entries read by the filesystem walks." },
+	[OSCAP_STATS_REGEX_COMPILES]      = { "regex_compiles", "Regular expressions compiled." },
+	[OSCAP_STATS_REGEX_EXECUTIONS]    = { "regex_executions", "Regular expression matches run." },
+	[OSCAP_STATS_SEAP_SENT]           = { "seap_packets_sent", "SEAP packets (messages, commands and errors) sent." },
+	[OSCAP_STATS_SEAP_RECEIVED]       = { "seap_packets_received", "SEAP packets (messages, commands and errors) received." },
+};
+
+/*
+ * Counters of one thread. Only the owning thread writes them, the readers
+ * sum up the shards of all the threads under stats_lock.
+ */
+struct oscap_stats_shard {
+	volatile uint64_t counter[OSCAP_STATS_COUNTER_COUNT];
+	struct oscap_stats_shard *prev;
+	struct oscap_stats_shard *next;
+};
+
+static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t stats_once = PTHREAD_ONCE_INIT;
+static pthread_key_t stats_key;
+static OSCAP_STATS_THREAD_LOCAL struct oscap_stats_shard *stats_shard = NULL;
+static struct oscap_stats_shard *stats_shards = NULL;          ///< shards of the running threads
+static uint64_t stats_retired[OSCAP_STATS_COUNTER_COUNT];     ///< counted by the threads which exited
+static uint64_t stats_base[OSCAP_STATS_COUNTER_COUNT];        ///< sums at the last reset
+static struct oscap_htable *stats_probe_items = NULL;         ///< probe name -> uint64_t
+
+/* Fold the shard of an exiting thread into the retired counters */
+static void oscap_stats_shard_retire(void *ptr)
+{
+	struct oscap_stats_shard *shard = ptr;
+	int i;
+
+	pthread_mutex_lock(&stats_lock);
+	for (i = 0; i < OSCAP_STATS_COUNTER_COUNT; ++i)
+		stats_retired[i] += shard->counter[i];
+	if (shard->prev != NULL)
+		shard->prev->next = shard->next;
+	else
+		stats_shards = shard->next;
+	if (shard->next != NULL)
+		shard->next->prev = shard->prev;
+	pthread_mutex_unlock(&stats_lock);
+
+	stats_shard = NULL;
+	free(shard);
+}
+
+static void oscap_stats_key_init(void)
+{
+	(void)pthread_key_create(&stats_key, oscap_stats_shard_retire);
+}
+
+static struct oscap_stats_shard *oscap_stats_shard_new(void)
+{
+	struct oscap_stats_shard *shard;
+
+	pthread_once(&stats_once, oscap_stats_key_init);
+
+	shard = calloc(1, sizeof(struct oscap_stats_shard));
+	if (shard == NULL)
+		return NULL;
+
+	pthread_mutex_lock(&stats_lock);
+	shard->next = stats_shards;
+	if (stats_shards != NULL)
+		stats_shards->prev = shard;
+	stats_shards = shard;
+	pthread_mutex_unlock(&stats_lock);
+
+	pthread_setspecific(stats_key, shard);
+	stats_shard = shard;
+
+	return shard;
+}
+
+void oscap_stats_add(oscap_stats_counter_t counter, uint64_t n)
+{
+	struct oscap_stats_shard *shard = stats_shard;
+
+	if (shard == NULL && (shard = oscap_stats_shard_new()) == NULL)
+		return;
+
+	shard->counter[counter] += n;
+}
+
+void oscap_stats_add_probe_items(const char *probe, uint64_t n)
+{
+	uint64_t *items;
+
+	if (probe == NULL)
+		return;
+
+	pthread_mutex_lock(&stats_lock);
+	if (stats_probe_items == NULL)
+		stats_probe_items = oscap_htable_new();
+
+	items = oscap_htable_get(stats_probe_items, probe);
+	if (items == NULL) {
+		items = calloc(1, sizeof(uint64_t));
+		if (items != NULL && !oscap_htable_add(stats_probe_items, probe, items)) {
+			free(items);
+			items = NULL;
+		}
+	}
+	if (items != NULL)
+		*items += n;
+	pthread_mutex_unlock(&stats_lock);
+}
+
+/* Has to be called with stats_lock held */
+static void oscap_stats_sum(uint64_t sum[OSCAP_STATS_COUNTER_COUNT])
+{
+	struct oscap_stats_shard *shard;
+	int i;
+
+	for (i = 0; i < OSCAP_STATS_COUNTER_COUNT; ++i)
+		sum[i] = stats_retired[i];
+	for (shard = stats_shards; shard != NULL; shard = shard->next) {
+		for (i = 0; i < OSCAP_STATS_COUNTER_COUNT; ++i)
+			sum[i] += shard->counter[i];
+	}
+	for (i = 0; i < OSCAP_STATS_COUNTER_COUNT; ++i)
+		sum[i] -= stats_base[i];
+}
+
+uint64_t oscap_stats_get(const char *name)
+{
+	uint64_t sum[OSCAP_STATS_COUNTER_COUNT];
+	int i;
+
+	if (name == NULL)
+		return 0;
+
+	for (i = 0; i < OSCAP_STATS_COUNTER_COUNT; ++i) {
+		if (strcmp(stats_counter_info[i].name, name) == 0)
+			break;
+	}
+	if (i == OSCAP_STATS_COUNTER_COUNT)
+		return 0;
+
+	pthread_mutex_lock(&stats_lock);
+	oscap_stats_sum(sum);
+	pthread_mutex_unlock(&stats_lock);
+
+	return sum[i];
+}
+
+uint64_t oscap_stats_get_probe_items(const char *probe)
+{
+	uint64_t *items = NULL;
+	uint64_t n;
+
+	if (probe == NULL)
+		return 0;
+
+	pthread_mutex_lock(&stats_lock);
+	if (stats_probe_items != NULL)
+		items = oscap_htable_get(stats_probe_items, probe);
+	n = items != NULL ? *items : 0;
+	pthread_mutex_unlock(&stats_lock);
+
+	return n;
+}
+
+void oscap_stats_reset(void)
+{
+	uint64_t sum[OSCAP_STATS_COUNTER_COUNT];
+	int i;
+
+	pthread_mutex_lock(&stats_lock);
+	/* the shards are written by their threads only, remember the sums instead */
+	oscap_stats_sum(sum);
+	for (i = 0; i < OSCAP_STATS_COUNTER_COUNT; ++i)
+		stats_base[i] += sum[i];
+	oscap_htable_free(stats_probe_items, free);
+	stats_probe_items = NULL;
+	pthread_mutex_unlock(&stats_lock);
+}
+
+static void oscap_stats_json_string(FILE *fp, const char *str)
+{
+	fputc('"', fp);
+	for (; *str != '\0'; ++str) {
+		unsigned char c = (unsigned char)*str;
+
+		if (c == '"' || c == '\\')
+			fprintf(fp, "\\%c", c);
+		else if (c < 0x20)
+			fprintf(fp, "\\u%04x", c);
+		else
+			fputc(c, fp);
+	}
+	fputc('"', fp);
+}
+
+/* Has to be called with stats_lock held */
+static void oscap_stats_write_json(FILE *fp, const uint64_t sum[OSCAP_STATS_COUNTER_COUNT])
+{
+	int i;
+
+	fprintf(fp, "{\n  \"counters\": {");
+	for (i = 0; i < OSCAP_STATS_COUNTER_COUNT; ++i) {
+		fprintf(fp, "%s\n    \"%s\": %" PRIu64, i > 0 ? "," : "",
+			stats_counter_info[i].name, sum[i]);
+	}
+	fprintf(fp, "\n  },\n  \"probe_items\": {");
+
+	if (stats_probe_items != NULL) {
+		struct oscap_htable_iterator *hit = oscap_htable_iterator_new(stats_probe_items);
+		bool first = true;
+
+		while (oscap_htable_iterator_has_more(hit)) {
+			const char *probe;
+			void *items;
+
+			oscap_htable_iterator_next_kv(hit, &probe, &items);
+			fprintf(fp, first ? "\n    " : ",\n    ");
+			oscap_stats_json_string(fp, probe);
+			fprintf(fp, ": %" PRIu64, *(uint64_t *)items);
+			first = false;
+		}
+		oscap_htable_iterator_free(hit);
+
+		if (!first)
+			fprintf(fp, "\n  ");
+	}
+	fprintf(fp, "}\n}\n");
+}
+
+/* Has to be called with stats_lock held */
+static void oscap_stats_write_prometheus(FILE *fp, const uint64_t sum[OSCAP_STATS_COUNTER_COUNT])
+{
+	int i;
+
+	for (i = 0; i < OSCAP_STATS_COUNTER_COUNT; ++i) {
+		fprintf(fp, "# HELP oscap_%s_total %s\n", stats_counter_info[i].name, stats_counter_info[i].help);
+		fprintf(fp, "# TYPE oscap_%s_total counter\n", stats_counter_info[i].name);
+		fprintf(fp, "oscap_%s_total %" PRIu64 "\n", stats_counter_info[i].name, sum[i]);
+	}
+
+	fprintf(fp, "# HELP oscap_probe_items_total Items collected by the probes.\n");
+	fprintf(fp, "# TYPE oscap_probe_items_total counter\n");
+	if (stats_probe_items != NULL) {
+		struct oscap_htable_iterator *hit = oscap_htable_iterator_new(stats_probe_items);
+
+		while (oscap_htable_iterator_has_more(hit)) {
+			const char *probe;
+			void *items;
+
+			/* the probe names are plain identifiers, nothing to escape */
+			oscap_htable_iterator_next_kv(hit, &probe, &items);
+			fprintf(fp, "oscap_probe_items_total{probe=\"%s\"} %" PRIu64 "\n", probe, *(uint64_t *)items);
+		}
+		oscap_htable_iterator_free(hit);
+	}
+}
+
+int oscap_stats_export(const char *path, oscap_stats_format_t format)
+{
+	uint64_t sum[OSCAP_STATS_COUNTER_COUNT];
+	char *tmp_path;
+	FILE *fp;
+
+	/* written next to the target and renamed, the collectors may read it any time */
+	tmp_path = oscap_sprintf("%s.tmp", path);
+	fp = fopen(tmp_path, "w");
+	if (fp == NULL) {
+		oscap_seterr(OSCAP_EFAMILY_GLIBC, "Can't open '%s' for writing: %s", tmp_path, strerror(errno));
+		free(tmp_path);
+		return -1;
+	}
+
+	pthread_mutex_lock(&stats_lock);
+	oscap_stats_sum(sum);
+	if (format == OSCAP_STATS_FORMAT_PROMETHEUS)
+		oscap_stats_write_prometheus(fp, sum);
+	else
+		oscap_stats_write_json(fp, sum);
+	pthread_mutex_unlock(&stats_lock);
+
+	if (fclose(fp) != 0) {
+		oscap_seterr(OSCAP_EFAMILY_GLIBC, "Can't write '%s': %s", tmp_path, strerror(errno));
+		remove(tmp_path);
+		free(tmp_path);
+		return -1;
+	}
+	if (rename(tmp_path, path) != 0) {
+		oscap_seterr(OSCAP_EFAMILY_GLIBC, "Can't rename '%s' to '%s': %s", tmp_path, path, strerror(errno));
+		remove(tmp_path);
+		free(tmp_path);
+		return -1;
+	}
+
+	free(tmp_path);
+	return 0;
+}
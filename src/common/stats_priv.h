@@ -0,0 +1,54 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef OSCAP_STATS_PRIV_H
+#define OSCAP_STATS_PRIV_H
+
+#include <stdint.h>
+#include "public/oscap_stats.h"
+
+typedef enum {
+	OSCAP_STATS_ICACHE_HITS = 0,     /* collected items already in the item cache */
+	OSCAP_STATS_ICACHE_MISSES,       /* collected items added to the item cache */
+	OSCAP_STATS_ICACHE_LOCK_WAITS,   /* item cache queue locks which had to wait */
+	OSCAP_STATS_ICACHE_LOCK_WAIT_NS, /* nanoseconds spent waiting for them */
+	OSCAP_STATS_MEMCHECK_REJECTIONS, /* items dropped because of the memory budget */
+	OSCAP_STATS_FTS_ENTRIES,         /* entries returned by oval_fts_read */
+	OSCAP_STATS_FTS_DIR_BYTES,       /* bytes of directory entries read by the fts cache */
+	OSCAP_STATS_REGEX_COMPILES,
+	OSCAP_STATS_REGEX_EXECUTIONS,
+	OSCAP_STATS_SEAP_SENT,           /* SEAP packets sent */
+	OSCAP_STATS_SEAP_RECEIVED,       /* SEAP packets received */
+	OSCAP_STATS_COUNTER_COUNT
+} oscap_stats_counter_t;
+
+/**
+ * Add to a counter. Each thread has its own copy of the counters, the
+ * copies are summed up when the counters are read, so it's cheap enough
+ * for hot paths.
+ */
+void oscap_stats_add(oscap_stats_counter_t counter, uint64_t n);
+
+/**
+ * Add items collected by a probe. It takes a lock, call it once per
+ * collected object rather than once per item.
+ */
+void oscap_stats_add_probe_items(const char *probe, uint64_t n);
+
+#endif /* OSCAP_STATS_PRIV_H */
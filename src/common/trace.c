@@ -0,0 +1,47 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "trace_priv.h"
+
+#if defined(HAVE_SYS_SDT_H)
+
+/*
+ * The tracer increments the semaphore of a marker while it is attached,
+ * they have to live in the .probes section.
+ */
+#define OSCAP_TRACE_DEFINE(name) \
+	unsigned short OSCAP_TRACE_SEMAPHORE(name) __attribute__((section(".probes"))) = 0
+
+OSCAP_TRACE_DEFINE(rule__begin);
+OSCAP_TRACE_DEFINE(rule__end);
+OSCAP_TRACE_DEFINE(rule__result);
+OSCAP_TRACE_DEFINE(check__begin);
+OSCAP_TRACE_DEFINE(check__end);
+OSCAP_TRACE_DEFINE(object__begin);
+OSCAP_TRACE_DEFINE(object__end);
+OSCAP_TRACE_DEFINE(item__collect);
+OSCAP_TRACE_DEFINE(seap__send);
+OSCAP_TRACE_DEFINE(seap__recv);
+OSCAP_TRACE_DEFINE(fts__entry);
+
+#endif
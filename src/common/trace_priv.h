@@ -0,0 +1,84 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef OSCAP_TRACE_PRIV_H
+#define OSCAP_TRACE_PRIV_H
+
+/*
+ * USDT (SystemTap/DTrace static) markers of the "openscap" provider. They
+ * are compiled in when <sys/sdt.h> is available and cost a nop each while
+ * no tracer is attached. They are listed with
+ *
+ *   bpftrace -l 'usdt:/usr/lib64/libopenscap.so:openscap:*'
+ *
+ * rule__begin(rule_id), rule__end(rule_id)
+ *   evaluation of the check of an XCCDF rule, on the evaluating thread
+ * rule__result(rule_id, result)
+ *   result of a rule as it is reported, an xccdf_test_result_type_t
+ * check__begin(system, check_id), check__end(system, result)
+ *   xccdf_policy_check_evaluate(), system is NULL for a complex check
+ * object__begin(probe, object_id), object__end(probe, object_id, items, status)
+ *   collection of an OVAL object by a probe worker
+ * item__collect(collected_object, items)
+ *   probe_item_collect(), items already collected for the object
+ * seap__send(sd, packet_type), seap__recv(sd, packet_type)
+ *   SEAP packets between the library and the probes
+ * fts__entry(path, fts_info)
+ *   each entry returned by oval_fts_read()
+ *
+ * Arguments which are expensive to compute are computed only when
+ * OSCAP_TRACE_ENABLED() says a tracer is attached to the marker.
+ */
+
+#if defined(HAVE_SYS_SDT_H)
+
+#define _SDT_HAS_SEMAPHORES 1
+#include <sys/sdt.h>
+
+#define OSCAP_TRACE_SEMAPHORE(name) openscap_##name##_semaphore
+
+extern unsigned short openscap_rule__begin_semaphore;
+extern unsigned short openscap_rule__end_semaphore;
+extern unsigned short openscap_rule__result_semaphore;
+extern unsigned short openscap_check__begin_semaphore;
+extern unsigned short openscap_check__end_semaphore;
+extern unsigned short openscap_object__begin_semaphore;
+extern unsigned short openscap_object__end_semaphore;
+extern unsigned short openscap_item__collect_semaphore;
+extern unsigned short openscap_seap__send_semaphore;
+extern unsigned short openscap_seap__recv_semaphore;
+extern unsigned short openscap_fts__entry_semaphore;
+
+#define OSCAP_TRACE_ENABLED(name) __builtin_expect(OSCAP_TRACE_SEMAPHORE(name) != 0, 0)
+#define OSCAP_TRACE1(name, a1) STAP_PROBE1(openscap, name, a1)
+#define OSCAP_TRACE2(name, a1, a2) STAP_PROBE2(openscap, name, a1, a2)
+#define OSCAP_TRACE4(name, a1, a2, a3, a4) STAP_PROBE4(openscap, name, a1, a2, a3, a4)
+
+#else
+
+/* the arguments are not evaluated, but count as used */
+#define OSCAP_TRACE_ENABLED(name) 0
+#define OSCAP_TRACE1(name, a1) do { (void)sizeof(a1); } while (0)
+#define OSCAP_TRACE2(name, a1, a2) do { (void)sizeof(a1); (void)sizeof(a2); } while (0)
+#define OSCAP_TRACE4(name, a1, a2, a3, a4) \
+	do { (void)sizeof(a1); (void)sizeof(a2); (void)sizeof(a3); (void)sizeof(a4); } while (0)
+
+#endif
+
+#endif /* OSCAP_TRACE_PRIV_H */
@@ -27,17 +27,79 @@
 #include <config.h>
 #endif
 
+#include <stdint.h>
+
 #include "tsort.h"
 
+enum {
+	OSCAP_TSORT_ON_STACK = 1,
+	OSCAP_TSORT_DONE
+};
+
+/*
+ * State of the nodes compared by pointers. It's an open addressing table,
+ * so that a visit doesn't walk the list of all the nodes visited so far.
+ */
+struct oscap_tsort_states {
+	void **nodes;
+	unsigned char *states;
+	size_t size;	// power of two
+	size_t count;
+};
+
 struct oscap_tsort_context {
 	struct oscap_list *visited;
 	struct oscap_list *cur_stack;
 	struct oscap_list *result;
+	struct oscap_tsort_states states;
 	oscap_tsort_edge_func edge_func;
 	oscap_cmp_func cmp_func;
 	void *userdata;
 };
 
+static size_t oscap_tsort_hash(const void *node, size_t size)
+{
+	uintptr_t h = (uintptr_t) node >> 4;
+	h *= (uintptr_t) 0x9E3779B97F4A7C15ULL;
+	return (size_t) (h ^ (h >> 29)) & (size - 1);
+}
+
+static void oscap_tsort_states_grow(struct oscap_tsort_states *st)
+{
+	struct oscap_tsort_states old = *st;
+
+	st->size = old.size ? old.size * 2 : 64;
+	st->nodes = calloc(st->size, sizeof(void *));
+	st->states = calloc(st->size, sizeof(unsigned char));
+	for (size_t i = 0; i < old.size; ++i) {
+		if (old.states[i] == 0)
+			continue;
+		size_t j = oscap_tsort_hash(old.nodes[i], st->size);
+		while (st->states[j] != 0)
+			j = (j + 1) & (st->size - 1);
+		st->nodes[j] = old.nodes[i];
+		st->states[j] = old.states[i];
+	}
+	free(old.nodes);
+	free(old.states);
+}
+
+// returns the state slot of the node, a new node gets a zero state
+static unsigned char *oscap_tsort_state(struct oscap_tsort_states *st, void *node)
+{
+	if (2 * (st->count + 1) > st->size)
+		oscap_tsort_states_grow(st);
+	size_t i = oscap_tsort_hash(node, st->size);
+	while (st->states[i] != 0) {
+		if (st->nodes[i] == node)
+			return &st->states[i];
+		i = (i + 1) & (st->size - 1);
+	}
+	st->nodes[i] = node;
+	st->count++;
+	return &st->states[i];
+}
+
 static struct oscap_tsort_context *oscap_tsort_context_new(oscap_tsort_edge_func edge_func, oscap_cmp_func cmp_func, void *userdata)
 {
 	struct oscap_tsort_context *ctx = calloc(1, sizeof(struct oscap_tsort_context));
@@ -56,6 +118,8 @@ static void oscap_tsort_context_free(struct oscap_tsort_context *ctx)
 		oscap_list_free(ctx->visited, NULL);
 		oscap_list_free(ctx->cur_stack, NULL);
 		oscap_list_free(ctx->result, NULL);
+		free(ctx->states.nodes);
+		free(ctx->states.states);
 		free(ctx);
 	}
 }
@@ -80,14 +144,24 @@ inline static bool oscap_tsort_visit_all(struct oscap_list *nodelist, struct osc
 
 static bool oscap_tsort_visit(void *node, struct oscap_tsort_context* ctx)
 {
-	// loop detection
-	if (oscap_list_contains(ctx->cur_stack, node, ctx->cmp_func)) return false;
-
-	// skip already visited node
-	if (oscap_list_contains(ctx->visited, node, ctx->cmp_func)) return true;
+	unsigned char *state = NULL;
+
+	if (ctx->cmp_func == oscap_ptr_cmp) {
+		state = oscap_tsort_state(&ctx->states, node);
+		// loop detection
+		if (*state == OSCAP_TSORT_ON_STACK) return false;
+		// skip already visited node
+		if (*state == OSCAP_TSORT_DONE) return true;
+		*state = OSCAP_TSORT_ON_STACK;
+	} else {
+		// loop detection
+		if (oscap_list_contains(ctx->cur_stack, node, ctx->cmp_func)) return false;
+		// skip already visited node
+		if (oscap_list_contains(ctx->visited, node, ctx->cmp_func)) return true;
+		oscap_list_add(ctx->visited, node);
+	}
 
-	// mark as visited & update stack
-	oscap_list_add(ctx->visited, node);
+	// update stack
 	oscap_list_push(ctx->cur_stack, node);
 
 	// visit all next nodes (dependencies)
@@ -96,7 +170,12 @@ static bool oscap_tsort_visit(void *node, struct oscap_tsort_context* ctx)
 	oscap_list_free(next, NULL);
 
 	// update stack & add node to result
-	if (ret) oscap_list_pop(ctx->cur_stack, NULL);
+	if (ret) {
+		oscap_list_pop(ctx->cur_stack, NULL);
+		// the table may have been grown by the dependencies
+		if (state != NULL)
+			*oscap_tsort_state(&ctx->states, node) = OSCAP_TSORT_DONE;
+	}
 	oscap_list_add(ctx->result, node);
 
 	return ret;
@@ -39,6 +39,7 @@
 #include "oscap.h"
 #include "oscap_helpers.h"
 #include "debug_priv.h"
+#include "stats_priv.h"
 
 #ifdef OS_WINDOWS
 #include <stdlib.h>
@@ -46,10 +47,14 @@
 #else
 #include <libgen.h>
 #include <strings.h>
+#include <pthread.h>
 #endif
 
 #define PATH_SEPARATOR '/'
 #define OSCAP_PCRE_EXEC_RECURSION_LIMIT_DEFAULT 3500
+/* stack of the JIT compiled patterns, grows up to the maximum on demand */
+#define OSCAP_PCRE_JIT_STACK_START (32 * 1024)
+#define OSCAP_PCRE_JIT_STACK_MAX   (1024 * 1024)
 
 int oscap_string_to_enum(const struct oscap_string_map *map, const char *str)
 {
@@ -361,32 +366,321 @@ char *oscap_path_join(const char *path1, const char *path2)
 	return joined_path;
 }
 
-int oscap_get_substrings(char *str, int *ofs, pcre *re, int want_substrs, char ***substrings) {
-	int i, ret, rc;
-	int ovector[60], ovector_len = sizeof (ovector) / sizeof (ovector[0]);
-	char **substrs;
+static unsigned long oscap_pcre_recursion_limit(void)
+{
+	unsigned long limit = OSCAP_PCRE_EXEC_RECURSION_LIMIT_DEFAULT;
+	char *limit_str = getenv("OSCAP_PCRE_EXEC_RECURSION_LIMIT");
+	if (limit_str != NULL) {
+		unsigned long value;
+		if (sscanf(limit_str, "%lu", &value) == 1) {
+			limit = value;
+		}
+	}
+	return limit;
+}
 
-	// todo: max match count check
+#if defined(PCRE_STUDY_JIT_COMPILE) && !defined(OS_WINDOWS)
+static pthread_key_t oscap_pcre_jit_stack_key;
+static pthread_once_t oscap_pcre_jit_stack_once = PTHREAD_ONCE_INIT;
+
+static void oscap_pcre_jit_stack_free(void *stack)
+{
+	pcre_jit_stack_free(stack);
+}
+
+static void oscap_pcre_jit_stack_key_init(void)
+{
+	pthread_key_create(&oscap_pcre_jit_stack_key, oscap_pcre_jit_stack_free);
+}
+
+/* Called by pcre_exec() in the matching thread, every thread gets its own
+ * stack allocated on the first match and reused by all the patterns. When
+ * the allocation fails PCRE falls back to its small machine stack. */
+static pcre_jit_stack *oscap_pcre_jit_stack(void *unused)
+{
+	pcre_jit_stack *stack;
+
+	pthread_once(&oscap_pcre_jit_stack_once, oscap_pcre_jit_stack_key_init);
+	stack = pthread_getspecific(oscap_pcre_jit_stack_key);
+	if (stack == NULL) {
+		stack = pcre_jit_stack_alloc(OSCAP_PCRE_JIT_STACK_START, OSCAP_PCRE_JIT_STACK_MAX);
+		if (stack != NULL)
+			pthread_setspecific(oscap_pcre_jit_stack_key, stack);
+	}
+	return stack;
+}
+#endif
+
+pcre_extra *oscap_pcre_study(pcre *re, int options)
+{
+	const char *err = NULL;
+	pcre_extra *extra;
+
+#if defined(PCRE_STUDY_JIT_COMPILE)
+	options |= PCRE_STUDY_JIT_COMPILE;
+#endif
+#if defined(PCRE_STUDY_EXTRA_NEEDED)
+	options |= PCRE_STUDY_EXTRA_NEEDED;
+#endif
+	extra = pcre_study(re, options, &err);
+	if (extra == NULL) {
+		if (err != NULL) {
+			dW("Function pcre_study() failed: %s.", err);
+		}
+		/* nothing learned from the pattern, callers still get the data to fill in */
+		extra = pcre_malloc(sizeof(pcre_extra));
+		if (extra == NULL) {
+			return NULL;
+		}
+		memset(extra, 0, sizeof(pcre_extra));
+	}
+
+#if defined(PCRE_STUDY_JIT_COMPILE) && !defined(OS_WINDOWS)
+	if (extra->flags & PCRE_EXTRA_EXECUTABLE_JIT) {
+		pcre_assign_jit_stack(extra, oscap_pcre_jit_stack, NULL);
+	}
+#endif
+	return extra;
+}
+
+pcre *oscap_pcre_compile(const char *pattern, int options, const char **errptr, int *erroffset, pcre_extra **extra)
+{
+	pcre *re = pcre_compile(pattern, options, errptr, erroffset, NULL);
+
+	oscap_stats_add(OSCAP_STATS_REGEX_COMPILES, 1);
+	if (extra != NULL) {
+		*extra = re != NULL ? oscap_pcre_study(re, 0) : NULL;
+	}
+	return re;
+}
+
+void oscap_pcre_free(pcre *re, pcre_extra *extra)
+{
+	if (extra != NULL) {
+#if defined(PCRE_STUDY_JIT_COMPILE)
+		pcre_free_study(extra);
+#else
+		pcre_free(extra);
+#endif
+	}
+	if (re != NULL) {
+		pcre_free(re);
+	}
+}
+
+/*
+ * Compiled pattern cache. The entries are reference counted, an entry
+ * pushed out of the cache (or flushed) is freed when the last user
+ * releases it. The patterns are compiled outside of the lock.
+ */
+#define OSCAP_PCRE_CACHE_SIZE    256
+#define OSCAP_PCRE_CACHE_BUCKETS 512
+
+struct oscap_pcre_cache_entry {
+	struct oscap_pcre_cached cached; /* has to be the first member */
+	char *pattern;
+	int options;
+	unsigned int hash;
+	unsigned int refs;
+	struct oscap_pcre_cache_entry *next;     /* bucket */
+	struct oscap_pcre_cache_entry *lru_prev;
+	struct oscap_pcre_cache_entry *lru_next;
+};
+
+static void oscap_pcre_cache_entry_free(struct oscap_pcre_cache_entry *entry)
+{
+	oscap_pcre_free(entry->cached.re, entry->cached.extra);
+	free(entry->pattern);
+	free(entry);
+}
+
+#ifndef OS_WINDOWS
+static struct {
+	pthread_mutex_t lock;
+	struct oscap_pcre_cache_entry *bucket[OSCAP_PCRE_CACHE_BUCKETS];
+	struct oscap_pcre_cache_entry *lru_head; /* most recently used */
+	struct oscap_pcre_cache_entry *lru_tail;
+	size_t count;
+} oscap_pcre_cache = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static unsigned int oscap_pcre_cache_hash(const char *pattern, int options)
+{
+	unsigned int hash = 2166136261U ^ (unsigned int)options;
+
+	while (*pattern != '\0') {
+		hash ^= (unsigned char)*pattern++;
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+static void oscap_pcre_cache_lru_unlink(struct oscap_pcre_cache_entry *entry)
+{
+	if (entry->lru_prev != NULL)
+		entry->lru_prev->lru_next = entry->lru_next;
+	else
+		oscap_pcre_cache.lru_head = entry->lru_next;
+	if (entry->lru_next != NULL)
+		entry->lru_next->lru_prev = entry->lru_prev;
+	else
+		oscap_pcre_cache.lru_tail = entry->lru_prev;
+}
+
+static void oscap_pcre_cache_lru_push(struct oscap_pcre_cache_entry *entry)
+{
+	entry->lru_prev = NULL;
+	entry->lru_next = oscap_pcre_cache.lru_head;
+	if (oscap_pcre_cache.lru_head != NULL)
+		oscap_pcre_cache.lru_head->lru_prev = entry;
+	else
+		oscap_pcre_cache.lru_tail = entry;
+	oscap_pcre_cache.lru_head = entry;
+}
+
+static struct oscap_pcre_cache_entry *oscap_pcre_cache_find(const char *pattern, int options, unsigned int hash)
+{
+	struct oscap_pcre_cache_entry *entry;
+
+	for (entry = oscap_pcre_cache.bucket[hash % OSCAP_PCRE_CACHE_BUCKETS]; entry != NULL; entry = entry->next) {
+		if (entry->hash == hash && entry->options == options && strcmp(entry->pattern, pattern) == 0)
+			return entry;
+	}
+	return NULL;
+}
+
+/* Drop the reference held by the cache, called with the lock held */
+static void oscap_pcre_cache_remove(struct oscap_pcre_cache_entry *entry)
+{
+	struct oscap_pcre_cache_entry **link = &oscap_pcre_cache.bucket[entry->hash % OSCAP_PCRE_CACHE_BUCKETS];
+
+	while (*link != entry)
+		link = &(*link)->next;
+	*link = entry->next;
+
+	oscap_pcre_cache_lru_unlink(entry);
+	--oscap_pcre_cache.count;
+
+	if (--entry->refs == 0)
+		oscap_pcre_cache_entry_free(entry);
+}
+#endif
+
+struct oscap_pcre_cached *oscap_pcre_cache_get(const char *pattern, int options, const char **errptr, int *erroffset)
+{
+	struct oscap_pcre_cache_entry *entry;
+#ifndef OS_WINDOWS
+	struct oscap_pcre_cache_entry *found;
+	unsigned int hash = oscap_pcre_cache_hash(pattern, options);
+
+	pthread_mutex_lock(&oscap_pcre_cache.lock);
+	entry = oscap_pcre_cache_find(pattern, options, hash);
+	if (entry != NULL) {
+		++entry->refs;
+		oscap_pcre_cache_lru_unlink(entry);
+		oscap_pcre_cache_lru_push(entry);
+		pthread_mutex_unlock(&oscap_pcre_cache.lock);
+		return &entry->cached;
+	}
+	pthread_mutex_unlock(&oscap_pcre_cache.lock);
+#endif
+
+	entry = calloc(1, sizeof(struct oscap_pcre_cache_entry));
+	if (entry == NULL)
+		return NULL;
+
+	entry->cached.re = oscap_pcre_compile(pattern, options, errptr, erroffset, &entry->cached.extra);
+	if (entry->cached.re == NULL) {
+		free(entry);
+		return NULL;
+	}
+	entry->pattern = oscap_strdup(pattern);
+	entry->options = options;
+	entry->refs = 1;
+
+#ifndef OS_WINDOWS
+	entry->hash = hash;
+
+	pthread_mutex_lock(&oscap_pcre_cache.lock);
+	/* another thread could have compiled the same pattern meanwhile */
+	found = oscap_pcre_cache_find(pattern, options, hash);
+	if (found != NULL) {
+		++found->refs;
+		pthread_mutex_unlock(&oscap_pcre_cache.lock);
+		oscap_pcre_cache_entry_free(entry);
+		return &found->cached;
+	}
+
+	++entry->refs; /* the reference of the cache */
+	entry->next = oscap_pcre_cache.bucket[hash % OSCAP_PCRE_CACHE_BUCKETS];
+	oscap_pcre_cache.bucket[hash % OSCAP_PCRE_CACHE_BUCKETS] = entry;
+	oscap_pcre_cache_lru_push(entry);
+
+	if (++oscap_pcre_cache.count > OSCAP_PCRE_CACHE_SIZE)
+		oscap_pcre_cache_remove(oscap_pcre_cache.lru_tail);
+	pthread_mutex_unlock(&oscap_pcre_cache.lock);
+#endif
+
+	return &entry->cached;
+}
+
+void oscap_pcre_cache_release(struct oscap_pcre_cached *cached)
+{
+	struct oscap_pcre_cache_entry *entry = (struct oscap_pcre_cache_entry *)cached;
+	unsigned int refs;
+
+	if (entry == NULL)
+		return;
+
+#ifndef OS_WINDOWS
+	pthread_mutex_lock(&oscap_pcre_cache.lock);
+	refs = --entry->refs;
+	pthread_mutex_unlock(&oscap_pcre_cache.lock);
+#else
+	refs = --entry->refs;
+#endif
+	if (refs == 0)
+		oscap_pcre_cache_entry_free(entry);
+}
+
+void oscap_pcre_cache_flush(void)
+{
+#ifndef OS_WINDOWS
+	pthread_mutex_lock(&oscap_pcre_cache.lock);
+	while (oscap_pcre_cache.lru_tail != NULL)
+		oscap_pcre_cache_remove(oscap_pcre_cache.lru_tail);
+	pthread_mutex_unlock(&oscap_pcre_cache.lock);
+#endif
+}
+
+int oscap_match_substrings(const char *str, size_t str_len, int *ofs, pcre *re, const pcre_extra *extra, int *ovector, int ovector_len)
+{
+	return oscap_match_substrings_opts(str, str_len, ofs, re, extra, 0, ovector, ovector_len);
+}
+
+int oscap_match_substrings_opts(const char *str, size_t str_len, int *ofs, pcre *re, const pcre_extra *extra, int exec_opts, int *ovector, int ovector_len)
+{
+	int i, rc;
 
 	for (i = 0; i < ovector_len; ++i) {
 		ovector[i] = -1;
 	}
 
-	struct pcre_extra extra;
-	extra.match_limit_recursion = OSCAP_PCRE_EXEC_RECURSION_LIMIT_DEFAULT;
-	char *limit_str = getenv("OSCAP_PCRE_EXEC_RECURSION_LIMIT");
-	if (limit_str != NULL) {
-		unsigned long limit;
-		if (sscanf(limit_str, "%lu", &limit) == 1) {
-			extra.match_limit_recursion = limit;
-		}
+	/* the study data are shared, the limit is set on a copy */
+	struct pcre_extra limit_extra;
+	if (extra != NULL) {
+		limit_extra = *extra;
+	} else {
+		memset(&limit_extra, 0, sizeof(limit_extra));
 	}
-	extra.flags = PCRE_EXTRA_MATCH_LIMIT_RECURSION;
-	size_t str_len = strlen(str);
+	limit_extra.match_limit_recursion = oscap_pcre_recursion_limit();
+	limit_extra.flags |= PCRE_EXTRA_MATCH_LIMIT_RECURSION;
+	oscap_stats_add(OSCAP_STATS_REGEX_EXECUTIONS, 1);
 #if defined(OS_SOLARIS)
-	rc = pcre_exec(re, &extra, str, str_len, *ofs, PCRE_NO_UTF8_CHECK, ovector, ovector_len);
+	rc = pcre_exec(re, &limit_extra, str, str_len, *ofs, exec_opts | PCRE_NO_UTF8_CHECK, ovector, ovector_len);
 #else
-	rc = pcre_exec(re, &extra, str, str_len, *ofs, 0, ovector, ovector_len);
+	rc = pcre_exec(re, &limit_extra, str, str_len, *ofs, exec_opts, ovector, ovector_len);
 #endif
 
 	if (rc < -1) {
@@ -402,18 +696,33 @@ int oscap_get_substrings(char *str, int *ofs, pcre *re, int want_substrs, char *
 
 	*ofs = (*ofs == ovector[1]) ? ovector[1] + 1 : ovector[1];
 
-	if (!want_substrs) {
-		/* just report successful match */
-		return 1;
-	}
-
-	ret = 0;
 	if (rc == 0) {
 		/* vector too small */
 		// todo: report partial results
 		rc = ovector_len / 3;
 	}
 
+	return rc;
+}
+
+int oscap_get_substrings(char *str, int *ofs, pcre *re, const pcre_extra *extra, int want_substrs, char ***substrings) {
+	int i, ret, rc;
+	int ovector[60], ovector_len = sizeof (ovector) / sizeof (ovector[0]);
+	char **substrs;
+
+	// todo: max match count check
+
+	rc = oscap_match_substrings(str, strlen(str), ofs, re, extra, ovector, ovector_len);
+	if (rc <= 0) {
+		return rc;
+	}
+
+	if (!want_substrs) {
+		/* just report successful match */
+		return 1;
+	}
+
+	ret = 0;
 	substrs = malloc(rc * sizeof (char *));
 	for (i = 0; i < rc; ++i) {
 		int len;
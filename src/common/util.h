@@ -469,18 +469,105 @@ int oscap_strncasecmp(const char *s1, const char *s2, size_t n);
  */
 char *oscap_strerror_r(int errnum, char *buf, size_t buflen);
 
+/**
+ * Study a compiled regular expression, JIT compiling it if PCRE supports it.
+ * A JIT compiled pattern uses the JIT stack shared by all the patterns
+ * matched in the calling thread.
+ * @param re compiled regular expression
+ * @param options additional pcre_study() options
+ * @return study data to be passed to pcre_exec()
+ * NULL on failure
+ */
+pcre_extra *oscap_pcre_study(pcre *re, int options);
+
+/**
+ * Compile a regular expression, see pcre_compile().
+ * Patterns matched against many subjects should be studied as well.
+ * @param pattern the regular expression
+ * @param options pcre_compile() options
+ * @param errptr error message on failure
+ * @param erroffset offset of the error in the pattern
+ * @param extra if not NULL, study data from oscap_pcre_study() are stored here
+ * @return compiled regular expression
+ * NULL on failure
+ */
+pcre *oscap_pcre_compile(const char *pattern, int options, const char **errptr, int *erroffset, pcre_extra **extra);
+
+/**
+ * Free a regular expression and its study data, both can be NULL.
+ */
+void oscap_pcre_free(pcre *re, pcre_extra *extra);
+
+/**
+ * Regular expression compiled and studied by oscap_pcre_cache_get().
+ */
+struct oscap_pcre_cached {
+	pcre *re;
+	pcre_extra *extra;
+};
+
+/**
+ * Get a compiled and studied regular expression from the process-wide
+ * cache of the recently used patterns, compiling it on a miss. The
+ * pattern can be matched from any thread until it is released.
+ * @param pattern the regular expression
+ * @param options pcre_compile() options
+ * @param errptr error message on failure
+ * @param erroffset offset of the error in the pattern
+ * @return the compiled pattern, release it by oscap_pcre_cache_release()
+ * NULL on failure
+ */
+struct oscap_pcre_cached *oscap_pcre_cache_get(const char *pattern, int options, const char **errptr, int *erroffset);
+
+/**
+ * Release a pattern returned by oscap_pcre_cache_get().
+ */
+void oscap_pcre_cache_release(struct oscap_pcre_cached *cached);
+
+/**
+ * Drop all the cached patterns, the ones still in use are freed when
+ * they are released.
+ */
+void oscap_pcre_cache_flush(void);
+
+/**
+ * Match a regular expression and return offsets of the substrings.
+ * The offsets of the whole match and of the subexpressions are stored in
+ * pairs in the ovector, unset subexpressions have both set to -1.
+ * @param str subject string
+ * @param str_len length of the subject
+ * @param ofs starting offset in str, moved past the match
+ * @param re compiled regular expression
+ * @param extra study data from oscap_pcre_study(), might be NULL
+ * @param ovector offsets of the substrings
+ * @param ovector_len size of ovector, a multiple of 3
+ * @return count of the ovector pairs set, 0 if no match
+ * negative value on failure
+ */
+int oscap_match_substrings(const char *str, size_t str_len, int *ofs, pcre *re, const pcre_extra *extra, int *ovector, int ovector_len);
+
+/**
+ * Same as oscap_match_substrings() with options of pcre_exec(), like
+ * PCRE_NOTBOL and PCRE_NOTEOL for a subject which is a part of a text.
+ * @param exec_opts options of pcre_exec()
+ */
+int oscap_match_substrings_opts(const char *str, size_t str_len, int *ofs, pcre *re, const pcre_extra *extra, int exec_opts, int *ovector, int ovector_len);
+
 /**
  * Match a regular expression and return substrings.
+ * The match recursion limit can be set by the OSCAP_PCRE_EXEC_RECURSION_LIMIT
+ * environment variable.
  * Caller is responsible for freeing the returned array.
  * @param str subject string
  * @param ofs starting offset in str
  * @param re compiled regular expression
+ * @param extra study data from oscap_pcre_study(), might be NULL
  * @param want_substrs if non-zero, substrings will be returned
  * @param substrings contains returned substrings
  * @return count of matched substrings, 0 if no match
  * negative value on failure
  */
-int oscap_get_substrings(char *str, int *ofs, pcre *re, int want_substrs, char ***substrings);
+int oscap_get_substrings(char *str, int *ofs, pcre *re, const pcre_extra *extra, int want_substrs, char ***substrings);
 
 
 #ifndef OS_WINDOWS
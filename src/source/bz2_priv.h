@@ -28,6 +28,7 @@
 #include "common/public/oscap.h"
 #include "common/util.h"
 #include <libxml/tree.h>
+#include <libxml/xmlreader.h>
 
 
 #ifdef BZIP2_FOUND
@@ -47,6 +48,22 @@ xmlDoc *bz2_fd_read_doc(int fd);
  */
 xmlDoc *bz2_mem_read_doc(const char *buffer, size_t size);
 
+/**
+ * Stream *.xml.bz2 file through xmlTextReader without building DOM.
+ * The reader decompresses the file as it goes.
+ * @param fd The file descriptor to bz2 file, it is closed with the reader
+ * @returns reader of the decompressed XML or NULL
+ */
+xmlTextReader *bz2_fd_read_reader(int fd);
+
+/**
+ * Stream bzip2ed memory through xmlTextReader without building DOM.
+ * @param buffer data in memory to process (contains bzip2ed XML), it has to be kept while the reader is used
+ * @param size length of data
+ * @returns reader of the decompressed XML or NULL
+ */
+xmlTextReader *bz2_mem_read_reader(const char *buffer, size_t size);
+
 #endif // BZIP2_FOUND
 
 /**
@@ -0,0 +1,406 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef OS_WINDOWS
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "compress_priv.h"
+#include "common/_error.h"
+#include "common/util.h"
+#include "common/debug_priv.h"
+
+#ifdef ZLIB_FOUND
+#include <zlib.h>
+#endif
+#ifdef BZIP2_FOUND
+#include <bzlib.h>
+#endif
+#ifdef ZSTD_FOUND
+#include <zstd.h>
+#endif
+
+/* Serialized data are handed over to the compressing thread in chunks */
+#define OSCAP_COMPRESS_CHUNK_SIZE (256 * 1024)
+/* At most this many chunks wait for the compression, the serialization waits then */
+#define OSCAP_COMPRESS_QUEUE_LENGTH 8
+#define OSCAP_COMPRESS_OUT_SIZE (128 * 1024)
+
+struct oscap_compress_chunk {
+	struct oscap_compress_chunk *next;
+	size_t size;
+	char data[];
+};
+
+struct oscap_compress_output {
+	oscap_compress_t format;
+	int fd;
+	char *filename;
+
+	pthread_t thread;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	struct oscap_compress_chunk *head;	///< the oldest queued chunk
+	struct oscap_compress_chunk *tail;
+	size_t queued;
+	bool done;		///< nothing more will be queued
+	bool joined;
+	int error;		///< errno or -1 when the compressing thread failed
+
+	struct oscap_compress_chunk *current;	///< chunk being filled by the writer
+	char out[OSCAP_COMPRESS_OUT_SIZE];	///< compressed data, used by the thread only
+	union {
+#ifdef ZLIB_FOUND
+		z_stream gz;
+#endif
+#ifdef BZIP2_FOUND
+		bz_stream bz;
+#endif
+#ifdef ZSTD_FOUND
+		ZSTD_CStream *zstd;
+#endif
+		int none;
+	} stream;
+};
+
+oscap_compress_t oscap_compress_by_filename(const char *filename)
+{
+	if (filename == NULL)
+		return OSCAP_COMPRESS_NONE;
+	if (oscap_str_endswith(filename, ".gz"))
+		return OSCAP_COMPRESS_GZIP;
+	if (oscap_str_endswith(filename, ".bz2"))
+		return OSCAP_COMPRESS_BZIP2;
+	if (oscap_str_endswith(filename, ".zst"))
+		return OSCAP_COMPRESS_ZSTD;
+	return OSCAP_COMPRESS_NONE;
+}
+
+static int _write_all(struct oscap_compress_output *output, size_t size)
+{
+	const char *data = output->out;
+
+	while (size > 0) {
+		ssize_t written = write(output->fd, data, size);
+		if (written < 0) {
+			if (errno == EINTR)
+				continue;
+			return errno;
+		}
+		data += written;
+		size -= written;
+	}
+	return 0;
+}
+
+/* Compress the data, with last the stream is finished */
+static int _compress(struct oscap_compress_output *output, const char *data, size_t size, bool last)
+{
+	int ret = 0;
+
+	switch (output->format) {
+#ifdef ZLIB_FOUND
+	case OSCAP_COMPRESS_GZIP: {
+		z_stream *gz = &output->stream.gz;
+		int res;
+		gz->next_in = (Bytef *) data;
+		gz->avail_in = size;
+		do {
+			gz->next_out = (Bytef *) output->out;
+			gz->avail_out = OSCAP_COMPRESS_OUT_SIZE;
+			res = deflate(gz, last ? Z_FINISH : Z_NO_FLUSH);
+			if (res == Z_STREAM_ERROR)
+				return -1;
+			ret = _write_all(output, OSCAP_COMPRESS_OUT_SIZE - gz->avail_out);
+		} while (ret == 0 && (last ? res != Z_STREAM_END : gz->avail_out == 0));
+		break;
+	}
+#endif
+#ifdef BZIP2_FOUND
+	case OSCAP_COMPRESS_BZIP2: {
+		bz_stream *bz = &output->stream.bz;
+		int res;
+		bz->next_in = (char *) data;
+		bz->avail_in = size;
+		do {
+			bz->next_out = output->out;
+			bz->avail_out = OSCAP_COMPRESS_OUT_SIZE;
+			res = BZ2_bzCompress(bz, last ? BZ_FINISH : BZ_RUN);
+			if (res < 0)
+				return -1;
+			ret = _write_all(output, OSCAP_COMPRESS_OUT_SIZE - bz->avail_out);
+		} while (ret == 0 && (last ? res != BZ_STREAM_END : bz->avail_in > 0));
+		break;
+	}
+#endif
+#ifdef ZSTD_FOUND
+	case OSCAP_COMPRESS_ZSTD: {
+		ZSTD_inBuffer in = { data, size, 0 };
+		size_t remaining;
+		do {
+			ZSTD_outBuffer out = { output->out, OSCAP_COMPRESS_OUT_SIZE, 0 };
+			remaining = ZSTD_compressStream2(output->stream.zstd, &out, &in, last ? ZSTD_e_end : ZSTD_e_continue);
+			if (ZSTD_isError(remaining))
+				return -1;
+			ret = _write_all(output, out.pos);
+		} while (ret == 0 && (last ? remaining != 0 : in.pos < in.size));
+		break;
+	}
+#endif
+	default:
+		return -1;
+	}
+	return ret;
+}
+
+static void *_oscap_compress_thread(void *arg)
+{
+	struct oscap_compress_output *output = arg;
+	int error = 0;
+
+	for (;;) {
+		pthread_mutex_lock(&output->mutex);
+		while (output->head == NULL && !output->done)
+			pthread_cond_wait(&output->cond, &output->mutex);
+		struct oscap_compress_chunk *chunk = output->head;
+		if (chunk != NULL) {
+			output->head = chunk->next;
+			if (output->head == NULL)
+				output->tail = NULL;
+			output->queued--;
+			/* the writer may be waiting for room in the queue */
+			pthread_cond_broadcast(&output->cond);
+		}
+		pthread_mutex_unlock(&output->mutex);
+
+		if (chunk == NULL)
+			break;
+		if (error == 0)
+			error = _compress(output, chunk->data, chunk->size, false);
+		free(chunk);
+	}
+	if (error == 0)
+		error = _compress(output, NULL, 0, true);
+
+	pthread_mutex_lock(&output->mutex);
+	output->error = error;
+	pthread_mutex_unlock(&output->mutex);
+	return NULL;
+}
+
+static void _oscap_compress_queue(struct oscap_compress_output *output)
+{
+	struct oscap_compress_chunk *chunk = output->current;
+
+	output->current = NULL;
+	pthread_mutex_lock(&output->mutex);
+	while (output->queued >= OSCAP_COMPRESS_QUEUE_LENGTH)
+		pthread_cond_wait(&output->cond, &output->mutex);
+	if (output->tail != NULL)
+		output->tail->next = chunk;
+	else
+		output->head = chunk;
+	output->tail = chunk;
+	output->queued++;
+	pthread_cond_broadcast(&output->cond);
+	pthread_mutex_unlock(&output->mutex);
+}
+
+// xmlOutputWriteCallback
+static int oscap_compress_output_write(void *context, const char *buffer, int len)
+{
+	struct oscap_compress_output *output = context;
+	int written = 0;
+
+	/* closing the buffer flushes it, also after oscap_compress_output_finish */
+	if (len == 0)
+		return 0;
+	if (output->done)
+		return -1;
+	while (written < len) {
+		if (output->current == NULL) {
+			output->current = malloc(sizeof(struct oscap_compress_chunk) + OSCAP_COMPRESS_CHUNK_SIZE);
+			output->current->next = NULL;
+			output->current->size = 0;
+		}
+		size_t room = OSCAP_COMPRESS_CHUNK_SIZE - output->current->size;
+		size_t size = (size_t) (len - written) < room ? (size_t) (len - written) : room;
+		memcpy(output->current->data + output->current->size, buffer + written, size);
+		output->current->size += size;
+		written += size;
+		if (output->current->size == OSCAP_COMPRESS_CHUNK_SIZE)
+			_oscap_compress_queue(output);
+	}
+	return written;
+}
+
+static int _oscap_compress_finish(struct oscap_compress_output *output)
+{
+	if (output->joined)
+		return output->error == 0 ? 0 : -1;
+
+	if (output->current != NULL && output->current->size > 0)
+		_oscap_compress_queue(output);
+	free(output->current);
+	output->current = NULL;
+
+	pthread_mutex_lock(&output->mutex);
+	output->done = true;
+	pthread_cond_broadcast(&output->cond);
+	pthread_mutex_unlock(&output->mutex);
+	pthread_join(output->thread, NULL);
+	output->joined = true;
+
+	if (close(output->fd) != 0 && output->error == 0)
+		output->error = errno;
+	output->fd = -1;
+	if (output->error != 0) {
+		if (output->error > 0)
+			oscap_seterr(OSCAP_EFAMILY_GLIBC, "Could not write '%s': %s", output->filename, strerror(output->error));
+		else
+			oscap_seterr(OSCAP_EFAMILY_OSCAP, "Could not compress '%s'.", output->filename);
+		return -1;
+	}
+	return 0;
+}
+
+static void _oscap_compress_output_free(struct oscap_compress_output *output)
+{
+	switch (output->format) {
+#ifdef ZLIB_FOUND
+	case OSCAP_COMPRESS_GZIP:
+		deflateEnd(&output->stream.gz);
+		break;
+#endif
+#ifdef BZIP2_FOUND
+	case OSCAP_COMPRESS_BZIP2:
+		BZ2_bzCompressEnd(&output->stream.bz);
+		break;
+#endif
+#ifdef ZSTD_FOUND
+	case OSCAP_COMPRESS_ZSTD:
+		ZSTD_freeCStream(output->stream.zstd);
+		break;
+#endif
+	default:
+		break;
+	}
+	pthread_mutex_destroy(&output->mutex);
+	pthread_cond_destroy(&output->cond);
+	free(output->filename);
+	free(output);
+}
+
+// xmlOutputCloseCallback
+static int oscap_compress_output_close(void *context)
+{
+	struct oscap_compress_output *output = context;
+	int ret = _oscap_compress_finish(output);
+	_oscap_compress_output_free(output);
+	return ret;
+}
+
+static bool _oscap_compress_init(struct oscap_compress_output *output)
+{
+	switch (output->format) {
+#ifdef ZLIB_FOUND
+	case OSCAP_COMPRESS_GZIP:
+		/* 16 adds the gzip header */
+		return deflateInit2(&output->stream.gz, 6, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+#endif
+#ifdef BZIP2_FOUND
+	case OSCAP_COMPRESS_BZIP2:
+		return BZ2_bzCompressInit(&output->stream.bz, 9, 0, 0) == BZ_OK;
+#endif
+#ifdef ZSTD_FOUND
+	case OSCAP_COMPRESS_ZSTD:
+		output->stream.zstd = ZSTD_createCStream();
+		return output->stream.zstd != NULL &&
+			!ZSTD_isError(ZSTD_CCtx_setParameter(output->stream.zstd, ZSTD_c_compressionLevel, ZSTD_CLEVEL_DEFAULT));
+#endif
+	default:
+		return false;
+	}
+}
+
+xmlOutputBufferPtr oscap_compress_output_open(const char *filename)
+{
+#ifndef ZLIB_FOUND
+	/* libxml2 may still write gzip itself, without a separate thread */
+	if (oscap_compress_by_filename(filename) == OSCAP_COMPRESS_GZIP) {
+		xmlOutputBufferPtr out = xmlOutputBufferCreateFilename(filename, NULL, 6);
+		if (out == NULL)
+			oscap_seterr(OSCAP_EFAMILY_XML, "Could not open '%s' for writing.", filename);
+		return out;
+	}
+#endif
+	struct oscap_compress_output *output = calloc(1, sizeof(struct oscap_compress_output));
+	output->format = oscap_compress_by_filename(filename);
+	output->filename = oscap_strdup(filename);
+	output->fd = -1;
+	if (!_oscap_compress_init(output)) {
+		oscap_seterr(OSCAP_EFAMILY_OSCAP, "Could not write '%s': the compression is not supported.", filename);
+		free(output->filename);
+		free(output);
+		return NULL;
+	}
+	pthread_mutex_init(&output->mutex, NULL);
+	pthread_cond_init(&output->cond, NULL);
+
+	output->fd = oscap_open_writable(filename);
+	if (output->fd == -1) {
+		_oscap_compress_output_free(output);
+		return NULL;
+	}
+	if (pthread_create(&output->thread, NULL, _oscap_compress_thread, output) != 0) {
+		oscap_seterr(OSCAP_EFAMILY_GLIBC, "Could not start the compression of '%s'.", filename);
+		close(output->fd);
+		_oscap_compress_output_free(output);
+		return NULL;
+	}
+
+	xmlOutputBufferPtr out = xmlOutputBufferCreateIO(oscap_compress_output_write,
+			oscap_compress_output_close, output, NULL);
+	if (out == NULL) {
+		oscap_setxmlerr(xmlGetLastError());
+		_oscap_compress_finish(output);
+		_oscap_compress_output_free(output);
+		return NULL;
+	}
+	return out;
+}
+
+int oscap_compress_output_finish(xmlOutputBufferPtr out)
+{
+	if (out->writecallback != oscap_compress_output_write)
+		return 0;
+	return _oscap_compress_finish(out->context);
+}
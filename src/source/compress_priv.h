@@ -0,0 +1,65 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+#ifndef OSCAP_SOURCE_COMPRESS_H
+#define OSCAP_SOURCE_COMPRESS_H
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <libxml/xmlIO.h>
+
+typedef enum {
+	OSCAP_COMPRESS_NONE,
+	OSCAP_COMPRESS_GZIP,	///< *.gz
+	OSCAP_COMPRESS_BZIP2,	///< *.bz2
+	OSCAP_COMPRESS_ZSTD	///< *.zst
+} oscap_compress_t;
+
+/**
+ * Get the compression of the file from its extension.
+ * @param filename path to the output file
+ * @returns the compression or OSCAP_COMPRESS_NONE
+ */
+oscap_compress_t oscap_compress_by_filename(const char *filename);
+
+/**
+ * Open an output buffer writing into the file compressed as given by
+ * the extension of the file name, see oscap_compress_by_filename.
+ * The data are compressed and written by a separate thread, so that
+ * compression overlaps with serialization. The file is closed and
+ * the thread joined when the buffer is closed.
+ * @param filename path to the output file
+ * @returns the output buffer or NULL if the file can't be opened or
+ * the compression isn't supported by this build
+ */
+xmlOutputBufferPtr oscap_compress_output_open(const char *filename);
+
+/**
+ * Wait until everything written to the output buffer so far is
+ * compressed and written out, nothing may be written afterwards.
+ * Needed where the buffer is closed by the caller which doesn't check
+ * the result, like xmlFreeTextWriter. Flush the buffer first.
+ * @param out output buffer, may be one not opened by oscap_compress_output_open
+ * @returns 0 on success, -1 if the output couldn't be written
+ */
+int oscap_compress_output_finish(xmlOutputBufferPtr out);
+
+#endif
@@ -0,0 +1,187 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <libxml/tree.h>
+#include <libxml/xmlreader.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef OS_WINDOWS
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "gz_priv.h"
+#include "common/_error.h"
+
+#ifdef ZLIB_FOUND
+
+#include <zlib.h>
+
+static gzFile gz_fd_open(int fd)
+{
+	// gzclose() closes the descriptor, the caller keeps its own
+	int fd_dup = dup(fd);
+	if (fd_dup == -1) {
+		oscap_seterr(OSCAP_EFAMILY_GLIBC, "Could not duplicate file descriptor of gzip file");
+		return NULL;
+	}
+	gzFile file = gzdopen(fd_dup, "rb");
+	if (file == NULL) {
+		oscap_seterr(OSCAP_EFAMILY_OSCAP, "Could not build gzFile");
+		close(fd_dup);
+	}
+	return file;
+}
+
+// xmlInputReadCallback
+static int gz_file_read(void *file, char *buffer, int len)
+{
+	int size = gzread((gzFile) file, buffer, len);
+	if (size < 0) {
+		int errnum;
+		oscap_seterr(OSCAP_EFAMILY_OSCAP, "Could not read from gzFile: %s", gzerror((gzFile) file, &errnum));
+		return -1;
+	}
+	return size;
+}
+
+// xmlInputCloseCallback
+static int gz_file_close(void *file)
+{
+	return gzclose((gzFile) file) == Z_OK ? 0 : -1;
+}
+
+xmlDoc *gz_fd_read_doc(int fd)
+{
+	gzFile file = gz_fd_open(fd);
+	if (file == NULL) {
+		return NULL;
+	}
+	return xmlReadIO(gz_file_read, gz_file_close, file, "url", NULL, XML_PARSE_PEDANTIC);
+}
+
+xmlTextReader *gz_fd_read_reader(int fd)
+{
+	gzFile file = gz_fd_open(fd);
+	if (file == NULL) {
+		return NULL;
+	}
+	return xmlReaderForIO(gz_file_read, gz_file_close, file, "url", NULL, XML_PARSE_PEDANTIC);
+}
+
+struct gz_mem {
+	z_stream stream;
+	bool eof;
+};
+
+static struct gz_mem *gz_mem_open(const char *buffer, size_t size)
+{
+	struct gz_mem *g = calloc(1, sizeof(struct gz_mem));
+	g->stream.next_in = (Bytef *) buffer;
+	g->stream.avail_in = size;
+	// 32 enables the detection of gzip header
+	int zerror = inflateInit2(&g->stream, MAX_WBITS + 32);
+	if (zerror != Z_OK) {
+		oscap_seterr(OSCAP_EFAMILY_OSCAP, "Could not build z_stream from memory buffer: inflateInit2 returns %d", zerror);
+		free(g);
+		return NULL;
+	}
+	return g;
+}
+
+// xmlInputReadCallback
+static int gz_mem_read(void *ctx, char *buffer, int len)
+{
+	struct gz_mem *gzmem = ctx;
+	if (len < 1 || gzmem->eof) {
+		return 0;
+	}
+	gzmem->stream.next_out = (Bytef *) buffer;
+	gzmem->stream.avail_out = len;
+	while (gzmem->stream.avail_out > 0) {
+		int zerror = inflate(&gzmem->stream, Z_NO_FLUSH);
+		if (zerror == Z_STREAM_END) {
+			// Concatenated gzip members make a single stream
+			if (gzmem->stream.avail_in == 0 || inflateReset(&gzmem->stream) != Z_OK) {
+				gzmem->eof = true;
+				break;
+			}
+		} else if (zerror == Z_BUF_ERROR && gzmem->stream.avail_in == 0) {
+			oscap_seterr(OSCAP_EFAMILY_OSCAP, "Could not read from z_stream: unexpected end of gzip data");
+			return -1;
+		} else if (zerror != Z_OK) {
+			oscap_seterr(OSCAP_EFAMILY_OSCAP, "Could not read from z_stream: inflate returns %d", zerror);
+			return -1;
+		}
+	}
+	return len - gzmem->stream.avail_out;
+}
+
+// xmlInputCloseCallback
+static int gz_mem_close(void *ctx)
+{
+	struct gz_mem *gzmem = ctx;
+	int zerror = inflateEnd(&gzmem->stream);
+	free(gzmem);
+	return zerror == Z_OK ? 0 : -1;
+}
+
+xmlDoc *gz_mem_read_doc(const char *buffer, size_t size)
+{
+	struct gz_mem *gzmem = gz_mem_open(buffer, size);
+	if (gzmem == NULL) {
+		return NULL;
+	}
+	return xmlReadIO(gz_mem_read, gz_mem_close, gzmem, "url", NULL, XML_PARSE_PEDANTIC);
+}
+
+xmlTextReader *gz_mem_read_reader(const char *buffer, size_t size)
+{
+	struct gz_mem *gzmem = gz_mem_open(buffer, size);
+	if (gzmem == NULL) {
+		return NULL;
+	}
+	return xmlReaderForIO(gz_mem_read, gz_mem_close, gzmem, "url", NULL, XML_PARSE_PEDANTIC);
+}
+
+#endif
+
+static const unsigned char magic_number[] = {0x1f, 0x8b};
+
+bool gz_memory_is_gzip(const char *memory, const size_t size)
+{
+	if (size < sizeof(magic_number)) {
+		return false; // Cannot read magic number
+	}
+	return memcmp(memory, magic_number, sizeof(magic_number)) == 0;
+}
+
+bool gz_fd_is_gzip(int fd)
+{
+	unsigned char header[sizeof(magic_number)];
+	ssize_t size = read(fd, header, sizeof(header));
+	lseek(fd, 0, SEEK_SET);
+	return size == (ssize_t) sizeof(header) && memcmp(header, magic_number, sizeof(magic_number)) == 0;
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+#ifndef OSCAP_SOURCE_GZIP_H
+#define OSCAP_SOURCE_GZIP_H
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "common/public/oscap.h"
+#include "common/util.h"
+#include <libxml/tree.h>
+#include <libxml/xmlreader.h>
+
+
+#ifdef ZLIB_FOUND
+
+/**
+ * Parse *.xml.gz file to XML DOM
+ * @param fd The file descriptor to gzip file, it is left open
+ * @returns DOM representation of the file
+ */
+xmlDoc *gz_fd_read_doc(int fd);
+
+/**
+ * Parse gzipped memory to XML DOM.
+ * @param buffer data in memory to process (contains gzipped XML)
+ * @param size length of data
+ * @returns DOM representation of the data
+ */
+xmlDoc *gz_mem_read_doc(const char *buffer, size_t size);
+
+/**
+ * Stream *.xml.gz file through xmlTextReader without building DOM.
+ * @param fd The file descriptor to gzip file, it is left open
+ * @returns reader of the decompressed XML or NULL
+ */
+xmlTextReader *gz_fd_read_reader(int fd);
+
+/**
+ * Stream gzipped memory through xmlTextReader without building DOM.
+ * @param buffer data in memory to process (contains gzipped XML), it has to be kept while the reader is used
+ * @param size length of data
+ * @returns reader of the decompressed XML or NULL
+ */
+xmlTextReader *gz_mem_read_reader(const char *buffer, size_t size);
+
+#endif // ZLIB_FOUND
+
+/**
+ * Recognize whether the file is gzipped. Do not close the file.
+ * @param file descriptor to opened file
+ * @returns true if it starts with the gzip magic number
+ */
+bool gz_fd_is_gzip(int fd);
+
+/**
+ * Recognize whether the memory is gzipped.
+ * @param memory Raw memory with file content
+ * @param size Size of memory
+ * @return true if it starts with the gzip magic number
+ */
+bool gz_memory_is_gzip(const char *memory, const size_t size);
+
+
+#endif // OSCAP_SOURCE_GZIP_H
@@ -30,8 +30,12 @@
 #include <io.h>
 #else
 #include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
 #endif
+#include <pthread.h>
 #include <libxml/parser.h>
+#include <libxml/parserInternals.h>
 #include <libxml/xmlreader.h>
 #include <libxml/xmlerror.h>
 
@@ -50,6 +54,8 @@
 #include "OVAL/oval_parser_impl.h"
 #include "OVAL/public/oval_definitions.h"
 #include "source/bz2_priv.h"
+#include "source/gz_priv.h"
+#include "source/zstd_priv.h"
 #include "source/schematron_priv.h"
 #include "source/validate_priv.h"
 #include "XCCDF/elements.h"
@@ -63,20 +69,110 @@ typedef enum oscap_source_type {
 	// TODO: downloaded from an http address (XCCDF can refer to remote sources)
 } oscap_source_type_t;
 
+/*
+ * Content of the source shared between the clones. The buffer is either
+ * allocated on the heap or it is a read-only mapping of the file the source
+ * originated from, so that large data streams are parsed in place.
+ */
+struct oscap_source_buffer {
+	char *data;
+	size_t size;
+	bool mapped;                                    ///< data is mapped by mmap(2)
+	unsigned int refcount;
+};
+
+static struct oscap_source_buffer *oscap_source_buffer_new(char *data, size_t size, bool mapped)
+{
+	struct oscap_source_buffer *buffer = malloc(sizeof(struct oscap_source_buffer));
+	buffer->data = data;
+	buffer->size = size;
+	buffer->mapped = mapped;
+	buffer->refcount = 1;
+	return buffer;
+}
+
+static struct oscap_source_buffer *oscap_source_buffer_ref(struct oscap_source_buffer *buffer)
+{
+	if (buffer != NULL)
+		__sync_fetch_and_add(&buffer->refcount, 1);
+	return buffer;
+}
+
+static void oscap_source_buffer_unref(struct oscap_source_buffer *buffer)
+{
+	if (buffer == NULL || __sync_sub_and_fetch(&buffer->refcount, 1) > 0)
+		return;
+#ifndef OS_WINDOWS
+	if (buffer->mapped)
+		munmap(buffer->data, buffer->size);
+	else
+#endif
+		free(buffer->data);
+	free(buffer);
+}
+
 struct oscap_source {
 	oscap_document_type_t scap_type;                ///< Type of SCAP document (XCCDF, OVAL, ...)
 	struct {
 		oscap_source_type_t type;               ///< Internal type of the oscap_source
 		char *version;                          ///< Version of the particular document type
 		char *filepath;                         ///< Filepath (if originated from file)
-		char *memory;                           ///< Memory buffer (if originated from memory)
-		size_t memory_size;                     ///< Size of the memory buffer (if originated from memory)
+		char *memory;                           ///< Memory buffer (if originated from memory or mapped from file)
+		size_t memory_size;                     ///< Size of the memory buffer (if originated from memory or mapped from file)
+		struct oscap_source_buffer *buffer;     ///< Owner of the memory buffer
 	} origin;                                       ///
 	struct {
 		xmlDoc *doc;                            /// DOM
+		xmlDict *dict;                          ///< Dictionary shared with other sources or NULL
 	} xml;
 };
 
+/*
+ * libxml2 dictionaries aren't safe to be added to from several threads,
+ * the parses with a shared dictionary take turns.
+ */
+static pthread_mutex_t oscap_source_dict_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+void oscap_source_dict_lock(void)
+{
+	pthread_mutex_lock(&oscap_source_dict_mutex);
+}
+
+void oscap_source_dict_unlock(void)
+{
+	pthread_mutex_unlock(&oscap_source_dict_mutex);
+}
+
+void oscap_source_ctxt_set_dict(xmlParserCtxt *ctxt, xmlDict *dict)
+{
+	if (ctxt == NULL || dict == NULL || ctxt->dict == dict)
+		return;
+	xmlDictFree(ctxt->dict);
+	xmlDictReference(dict);
+	ctxt->dict = dict;
+	ctxt->dictNames = 1;
+	// The parser compares these by pointer
+	ctxt->str_xml = xmlDictLookup(dict, BAD_CAST "xml", 3);
+	ctxt->str_xmlns = xmlDictLookup(dict, BAD_CAST "xmlns", 5);
+	ctxt->str_xml_ns = xmlDictLookup(dict, XML_XML_NAMESPACE, 36);
+}
+
+void oscap_source_set_dict(struct oscap_source *source, xmlDict *dict)
+{
+	if (source == NULL || source->xml.dict == dict)
+		return;
+	if (dict != NULL)
+		xmlDictReference(dict);
+	if (source->xml.dict != NULL)
+		xmlDictFree(source->xml.dict);
+	source->xml.dict = dict;
+}
+
+xmlDict *oscap_source_get_dict(const struct oscap_source *source)
+{
+	return source->xml.dict;
+}
+
 struct oscap_source *oscap_source_new_from_file(const char *filepath)
 {
 	/* TODO: At the end of the day, this shall be the only place in
@@ -88,6 +184,44 @@ struct oscap_source *oscap_source_new_from_file(const char *filepath)
 	return source;
 }
 
+/**
+ * Map the file the source originated from into memory. Sources which
+ * already have a memory buffer, files which are not regular or are empty
+ * and platforms without mmap are left to be read through a descriptor.
+ * @return true if origin.memory is available
+ */
+static bool _oscap_source_map_file(struct oscap_source *source)
+{
+	if (source->origin.memory != NULL)
+		return true;
+#ifdef OS_WINDOWS
+	return false;
+#else
+	if (source->origin.type != OSCAP_SRC_FROM_USER_XML_FILE || source->origin.filepath == NULL)
+		return false;
+	int fd = open(source->origin.filepath, O_RDONLY);
+	if (fd == -1)
+		return false;
+	struct stat st;
+	if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode) || st.st_size <= 0) {
+		close(fd);
+		return false;
+	}
+	void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		dD("Unable to map file '%s', it will be read instead: %s", source->origin.filepath, strerror(errno));
+		return false;
+	}
+	// The content is parsed from the beginning to the end
+	posix_madvise(data, st.st_size, POSIX_MADV_SEQUENTIAL);
+	source->origin.buffer = oscap_source_buffer_new(data, st.st_size, true);
+	source->origin.memory = data;
+	source->origin.memory_size = st.st_size;
+	return true;
+#endif
+}
+
 struct oscap_source *oscap_source_clone(struct oscap_source *old)
 {
 	struct oscap_source *new = (struct oscap_source *) calloc(1, sizeof(struct oscap_source));
@@ -95,9 +229,13 @@ struct oscap_source *oscap_source_clone(struct oscap_source *old)
 	new->origin.type = old->origin.type;
 	new->origin.version = oscap_strdup(old->origin.version);
 	new->origin.filepath = oscap_strdup(old->origin.filepath);
-	new->origin.memory = oscap_strdup(old->origin.memory);
+	// The clones share the content, it is never modified
+	_oscap_source_map_file(old);
+	new->origin.buffer = oscap_source_buffer_ref(old->origin.buffer);
+	new->origin.memory = old->origin.memory;
 	new->origin.memory_size = old->origin.memory_size;
 	new->xml.doc = xmlCopyDoc(old->xml.doc, true);
+	oscap_source_set_dict(new, old->xml.dict);
 	return new;
 }
 
@@ -121,6 +259,7 @@ struct oscap_source *oscap_source_new_from_memory(const char *buffer, size_t siz
 	struct oscap_source *source = _create_oscap_source(size, filepath);
 	source->origin.memory = calloc(1, size);
 	memcpy(source->origin.memory, buffer, size);
+	source->origin.buffer = oscap_source_buffer_new(source->origin.memory, size, false);
 	return source;
 }
 
@@ -128,6 +267,7 @@ struct oscap_source *oscap_source_new_take_memory(char *buffer, size_t size, con
 {
 	struct oscap_source* source = _create_oscap_source(size, filepath);
 	source->origin.memory = buffer;
+	source->origin.buffer = oscap_source_buffer_new(buffer, size, false);
 	return source;
 }
 
@@ -144,10 +284,12 @@ void oscap_source_free(struct oscap_source *source)
 {
 	if (source != NULL) {
 		free(source->origin.filepath);
-		free(source->origin.memory);
+		oscap_source_buffer_unref(source->origin.buffer);
 		if (source->xml.doc != NULL) {
 			xmlFreeDoc(source->xml.doc);
 		}
+		if (source->xml.dict != NULL)
+			xmlDictFree(source->xml.dict);
 		free(source->origin.version);
 		free(source);
 	}
@@ -173,8 +315,104 @@ const char *oscap_source_readable_origin(const struct oscap_source *source)
 	return source->origin.filepath;
 }
 
+static bool memory_file_is_executable(const char* memory, const size_t size)
+{
+	if (size < 2){
+		return false; // Cannot read SHEBANG
+	}
+
+	// Check that file in memory starts with SHEBANG
+	if ( memory[0] != '#' ) return false;
+	if ( memory[1] != '!' ) return false;
+	return true;
+}
+
+static bool memory_is_compressed(const char *memory, size_t size)
+{
+	return bz2_memory_is_bzip(memory, size) || gz_memory_is_gzip(memory, size) || zstd_memory_is_zstd(memory, size);
+}
+
+/**
+ * Stream the origin of the source through the reader without building DOM.
+ * Plain content is read in place from the memory buffer, compressed content
+ * is decompressed as it is read. Sets streamed to false if the origin can't
+ * be streamed, the DOM is built then.
+ */
+static xmlTextReader *_oscap_source_get_streamed_reader(struct oscap_source *source, bool *streamed)
+{
+	xmlTextReader *reader = NULL;
+	*streamed = true;
+
+	if (_oscap_source_map_file(source)) {
+		const char *memory = source->origin.memory;
+		size_t size = source->origin.memory_size;
+#ifdef BZIP2_FOUND
+		if (bz2_memory_is_bzip(memory, size))
+			return bz2_mem_read_reader(memory, size);
+#endif
+#ifdef ZLIB_FOUND
+		if (gz_memory_is_gzip(memory, size))
+			return gz_mem_read_reader(memory, size);
+#endif
+#ifdef ZSTD_FOUND
+		if (zstd_memory_is_zstd(memory, size))
+			return zstd_mem_read_reader(memory, size);
+#endif
+		if (!memory_is_compressed(memory, size) && !memory_file_is_executable(memory, size))
+			return xmlReaderForMemory(memory, size, NULL, NULL, 0);
+		*streamed = false;
+		return NULL;
+	}
+
+	int fd = source->origin.filepath != NULL ? open(source->origin.filepath, O_RDONLY) : -1;
+	if (fd == -1) {
+		// The error is reported when DOM is built
+		*streamed = false;
+		return NULL;
+	}
+#ifdef BZIP2_FOUND
+	if (bz2_fd_is_bzip(fd)) {
+		// bz2 reader closes the descriptor given
+		int fd_dup = dup(fd);
+		if (fd_dup != -1)
+			reader = bz2_fd_read_reader(fd_dup);
+		close(fd);
+		return reader;
+	}
+#endif
+#ifdef ZLIB_FOUND
+	if (gz_fd_is_gzip(fd)) {
+		reader = gz_fd_read_reader(fd);
+		close(fd);
+		return reader;
+	}
+#endif
+#ifdef ZSTD_FOUND
+	if (zstd_fd_is_zstd(fd)) {
+		reader = zstd_fd_read_reader(fd);
+		close(fd);
+		return reader;
+	}
+#endif
+	close(fd);
+	*streamed = false;
+	return reader;
+}
+
 xmlTextReader *oscap_source_get_xmlTextReader(struct oscap_source *source)
 {
+	if (source->xml.doc == NULL) {
+		bool streamed;
+		xmlTextReader *reader = _oscap_source_get_streamed_reader(source, &streamed);
+		if (streamed) {
+			if (reader == NULL) {
+				oscap_seterr(OSCAP_EFAMILY_XML, "Unable to create xmlTextReader for %s", oscap_source_readable_origin(source));
+				oscap_setxmlerr(xmlGetLastError());
+			}
+			return reader;
+		}
+	}
+
 	xmlDoc *doc = oscap_source_get_xmlDoc(source);
 	if (doc == NULL) {
 		return NULL;
@@ -248,36 +486,67 @@ static bool fd_file_is_executable(int fd)
 	return is_exec;
 }
 
-static bool memory_file_is_executable(const char* memory, const size_t size)
+static xmlDoc *_oscap_source_read_memory(struct oscap_source *source)
 {
-	if (size < 2){
-		return false; // Cannot read SHEBANG
-	}
+	if (source->xml.dict == NULL)
+		return xmlReadMemory(source->origin.memory, source->origin.memory_size, NULL, NULL, 0);
+	xmlParserCtxt *ctxt = xmlNewParserCtxt();
+	if (ctxt == NULL)
+		return NULL;
+	oscap_source_dict_lock();
+	oscap_source_ctxt_set_dict(ctxt, source->xml.dict);
+	xmlDoc *doc = xmlCtxtReadMemory(ctxt, source->origin.memory, source->origin.memory_size, NULL, NULL, 0);
+	xmlFreeParserCtxt(ctxt);
+	oscap_source_dict_unlock();
+	return doc;
+}
 
-	// Check that file in memory starts with SHEBANG
-	if ( memory[0] != '#' ) return false;
-	if ( memory[1] != '!' ) return false;
-	return true;
+static xmlDoc *_oscap_source_read_fd(struct oscap_source *source, int fd)
+{
+	if (source->xml.dict == NULL)
+		return xmlReadFd(fd, NULL, NULL, 0);
+	xmlParserCtxt *ctxt = xmlNewParserCtxt();
+	if (ctxt == NULL)
+		return NULL;
+	oscap_source_dict_lock();
+	oscap_source_ctxt_set_dict(ctxt, source->xml.dict);
+	xmlDoc *doc = xmlCtxtReadFd(ctxt, fd, NULL, NULL, 0);
+	xmlFreeParserCtxt(ctxt);
+	oscap_source_dict_unlock();
+	return doc;
 }
 
 xmlDoc *oscap_source_get_xmlDoc(struct oscap_source *source)
 {
 	// We check origin.memory first because even with it being non-NULL
 	// filepath will be non-NULL, it will contain the filepath hint.
+	// Regular files are mapped to origin.memory and parsed in place.
 	struct oscap_string *xml_error_string = oscap_string_new();
 	xmlSetGenericErrorFunc(xml_error_string, (xmlGenericErrorFunc)xmlErrorCb);
 
 	if (source->xml.doc == NULL) {
-		if (source->origin.memory != NULL) {
+		if (_oscap_source_map_file(source)) {
 			if (bz2_memory_is_bzip(source->origin.memory, source->origin.memory_size)) {
 #ifdef BZIP2_FOUND
 				source->xml.doc = bz2_mem_read_doc(source->origin.memory, source->origin.memory_size);
 #else
 				oscap_seterr(OSCAP_EFAMILY_OSCAP, "Unable to unpack bz2 from buffer memory '%s'. Please compile OpenSCAP with bz2 support.", oscap_source_readable_origin(source));
+#endif
+			} else if (gz_memory_is_gzip(source->origin.memory, source->origin.memory_size)) {
+#ifdef ZLIB_FOUND
+				source->xml.doc = gz_mem_read_doc(source->origin.memory, source->origin.memory_size);
+#else
+				oscap_seterr(OSCAP_EFAMILY_OSCAP, "Unable to unpack gzip from buffer memory '%s'. Please compile OpenSCAP with zlib support.", oscap_source_readable_origin(source));
+#endif
+			} else if (zstd_memory_is_zstd(source->origin.memory, source->origin.memory_size)) {
+#ifdef ZSTD_FOUND
+				source->xml.doc = zstd_mem_read_doc(source->origin.memory, source->origin.memory_size);
+#else
+				oscap_seterr(OSCAP_EFAMILY_OSCAP, "Unable to unpack zstd from buffer memory '%s'. Please compile OpenSCAP with zstd support.", oscap_source_readable_origin(source));
 #endif
 			} else
 			{
-				source->xml.doc = xmlReadMemory(source->origin.memory, source->origin.memory_size, NULL, NULL, 0);
+				source->xml.doc = _oscap_source_read_memory(source);
 				if (source->xml.doc == NULL) {
 					if (memory_file_is_executable(source->origin.memory, source->origin.memory_size)) {
 						dI("oscap-source in memory was detected as executable file '%s'. Skipped XML parsing", oscap_source_readable_origin(source));
@@ -285,7 +554,10 @@ xmlDoc *oscap_source_get_xmlDoc(struct oscap_source *source)
 					} else {
 						oscap_setxmlerr(xmlGetLastError());
 						const char *error_msg = oscap_string_get_cstr(xml_error_string);
-						oscap_seterr(OSCAP_EFAMILY_XML, "%sUnable to parse XML from user memory buffer", error_msg);
+						if (source->origin.type == OSCAP_SRC_FROM_USER_XML_FILE)
+							oscap_seterr(OSCAP_EFAMILY_XML, "%sUnable to parse XML at: '%s'", error_msg, oscap_source_readable_origin(source));
+						else
+							oscap_seterr(OSCAP_EFAMILY_XML, "%sUnable to parse XML from user memory buffer", error_msg);
 						oscap_string_clear(xml_error_string);
 					}
 				}
@@ -303,10 +575,24 @@ xmlDoc *oscap_source_get_xmlDoc(struct oscap_source *source)
 #else
 					source->xml.doc = NULL;
 					oscap_seterr(OSCAP_EFAMILY_OSCAP, "Unable to unpack bz2 file '%s'. Please compile OpenSCAP with bz2 support.", oscap_source_readable_origin(source));
+#endif
+				} else if (gz_fd_is_gzip(fd)) {
+#ifdef ZLIB_FOUND
+					source->xml.doc = gz_fd_read_doc(fd);
+#else
+					source->xml.doc = NULL;
+					oscap_seterr(OSCAP_EFAMILY_OSCAP, "Unable to unpack gzip file '%s'. Please compile OpenSCAP with zlib support.", oscap_source_readable_origin(source));
+#endif
+				} else if (zstd_fd_is_zstd(fd)) {
+#ifdef ZSTD_FOUND
+					source->xml.doc = zstd_fd_read_doc(fd);
+#else
+					source->xml.doc = NULL;
+					oscap_seterr(OSCAP_EFAMILY_OSCAP, "Unable to unpack zstd file '%s'. Please compile OpenSCAP with zstd support.", oscap_source_readable_origin(source));
 #endif
 				} else
 				{
-					source->xml.doc = xmlReadFd(fd, NULL, NULL, 0);
+					source->xml.doc = _oscap_source_read_fd(source, fd);
 					if (source->xml.doc == NULL) {
 						if (fd_file_is_executable(fd)) {
 							dI("oscap-source file was detected as executable file '%s'. Skipped XML parsing", oscap_source_readable_origin(source));
@@ -460,9 +746,24 @@ int oscap_source_save_as(struct oscap_source *source, const char *filename)
 	return oscap_xml_save_filename(target, doc) == 1 ? 0 : -1;
 }
 
+int oscap_source_get_memory(struct oscap_source *source, const char **buffer, size_t *size)
+{
+	if (source->xml.doc != NULL || !_oscap_source_map_file(source) ||
+	    memory_is_compressed(source->origin.memory, source->origin.memory_size))
+		return -1;
+	*buffer = source->origin.memory;
+	*size = source->origin.memory_size;
+	return 0;
+}
+
 int oscap_source_get_raw_memory(struct oscap_source *source, char **buffer, size_t *size)
 {
-	if (source->origin.memory != NULL) {
+	// Plain files are copied straight from the mapping, compressed files
+	// are returned decompressed
+	bool raw = _oscap_source_map_file(source) &&
+		(source->origin.type != OSCAP_SRC_FROM_USER_XML_FILE ||
+		 !memory_is_compressed(source->origin.memory, source->origin.memory_size));
+	if (raw) {
 		char *ret = (char*)malloc(source->origin.memory_size);
 		memcpy(ret, source->origin.memory, source->origin.memory_size);
 		*buffer = ret;
@@ -85,4 +85,38 @@ xmlDoc *oscap_source_get_xmlDoc(struct oscap_source *source);
  */
 xmlDoc *oscap_source_pop_xmlDoc(struct oscap_source *source);
 
+/**
+ * Get the content of this resource in memory without copying it. Files are
+ * mapped into memory. The buffer is still owned by oscap_source and it is
+ * shared by its clones.
+ * @memberof oscap_source
+ * @param source Resource to get the content of
+ * @param buffer Will be filled with a pointer to the content
+ * @param size Will be filled with size of the content
+ * @returns 0 on success, -1 if the content is not available in memory, is
+ * compressed or the DOM representation has been already built (and it may
+ * differ from the content)
+ */
+int oscap_source_get_memory(struct oscap_source *source, const char **buffer, size_t *size);
+
+/**
+ * Share a string dictionary with other sources. The DOM of the source is
+ * parsed with the dictionary, so that the element names, namespaces and
+ * attribute values repeated in the documents of a session are stored once.
+ * The source holds a reference to the dictionary, NULL stops sharing.
+ * Documents parsed before keep the dictionary they were parsed with.
+ * @memberof oscap_source
+ */
+void oscap_source_set_dict(struct oscap_source *source, xmlDict *dict);
+xmlDict *oscap_source_get_dict(const struct oscap_source *source);
+
+/**
+ * Make a parser context intern the names in the shared dictionary. The
+ * dictionary isn't thread safe, hold oscap_source_dict_lock() from
+ * before this call until the context is freed.
+ */
+void oscap_source_ctxt_set_dict(xmlParserCtxt *ctxt, xmlDict *dict);
+void oscap_source_dict_lock(void);
+void oscap_source_dict_unlock(void);
+
 #endif
@@ -29,8 +29,7 @@
 #include <unistd.h>
 #endif
 
-#include <libxml/xpath.h>
-#include <libxml/xpathInternals.h>
+#include <libxml/tree.h>
 #include "common/_error.h"
 #include "common/debug_priv.h"
 #include "common/list.h"
@@ -141,7 +140,159 @@ static int _validate_sds_components(struct oscap_source *source, FILE *outfile_f
 	return ret;
 }
 
-static char *_xcf_resolve_in_catalog(xmlNodePtr resolver_node, const char *uri, xmlXPathContextPtr context)
+#define SRC_DS_NS "http://scap.nist.gov/schema/scap/source/1.2"
+#define SRC_XCCDF_NS "http://checklists.nist.gov/xccdf/1.2"
+#define SRC_XLINK_NS "http://www.w3.org/1999/xlink"
+#define SRC_OVAL_DEF_NS "http://oval.mitre.org/XMLSchema/oval-definitions-5"
+#define SRC_OCIL_NS "http://scap.nist.gov/schema/ocil/2.0"
+#define SRC_OCIL_SYSTEM "http://scap.nist.gov/schema/ocil/2"
+
+/*
+ * The SRC requirements below look up components, component-refs and the
+ * checks referenced by every rule. The lookups use tables built in a single
+ * pass over the document instead of evaluating XPath queries for every rule.
+ */
+struct _src_component {
+	struct oscap_htable *oval_definitions;     ///< oval-def:definition id -> node
+	struct oscap_htable *oval_compliance;      ///< compliance or patch oval-def:definition id -> node
+	struct oscap_htable *ocil_questionnaires;  ///< ocil:questionnaire id -> node
+	struct oscap_list *rules;                  ///< xccdf:Rule nodes in document order
+};
+
+struct _src_data_stream {
+	xmlNodePtr node;
+	struct oscap_htable *component_refs;       ///< ds:component-ref id -> node
+};
+
+struct _src_index {
+	struct oscap_htable *components;           ///< ds:component id -> node
+	struct oscap_htable *component_content;    ///< ds:component id -> struct _src_component
+	struct oscap_list *data_streams;           ///< struct _src_data_stream in document order
+	struct _src_data_stream *data_stream;      ///< data stream being checked
+};
+
+/* Marks a key shared by multiple elements, such a key resolves to nothing */
+static char _src_ambiguous;
+
+static bool _src_node_is(xmlNodePtr node, const char *ns, const char *name)
+{
+	return node->type == XML_ELEMENT_NODE && node->ns != NULL &&
+		xmlStrcmp(node->name, BAD_CAST name) == 0 &&
+		xmlStrcmp(node->ns->href, BAD_CAST ns) == 0;
+}
+
+static void _src_table_add(struct oscap_htable *table, xmlNodePtr node, bool unique)
+{
+	char *id = (char *) xmlGetProp(node, BAD_CAST "id");
+	if (id == NULL)
+		return;
+	if (!oscap_htable_add(table, id, node) && unique) {
+		oscap_htable_detach(table, id);
+		oscap_htable_add(table, id, &_src_ambiguous);
+	}
+	free(id);
+}
+
+static xmlNodePtr _src_table_get(struct oscap_htable *table, const char *id)
+{
+	void *node = id != NULL ? oscap_htable_get(table, id) : NULL;
+	return node == &_src_ambiguous ? NULL : node;
+}
+
+static struct _src_component *_src_component_new(void)
+{
+	struct _src_component *component = malloc(sizeof(struct _src_component));
+	component->oval_definitions = oscap_htable_new();
+	component->oval_compliance = oscap_htable_new();
+	component->ocil_questionnaires = oscap_htable_new();
+	component->rules = oscap_list_new();
+	return component;
+}
+
+static void _src_component_free(struct _src_component *component)
+{
+	if (component == NULL)
+		return;
+	oscap_htable_free0(component->oval_definitions);
+	oscap_htable_free0(component->oval_compliance);
+	oscap_htable_free0(component->ocil_questionnaires);
+	oscap_list_free0(component->rules);
+	free(component);
+}
+
+static void _src_data_stream_free(struct _src_data_stream *data_stream)
+{
+	if (data_stream == NULL)
+		return;
+	oscap_htable_free0(data_stream->component_refs);
+	free(data_stream);
+}
+
+static void _src_index_walk(struct _src_index *index, xmlNodePtr node, struct _src_component *component, struct _src_data_stream *data_stream)
+{
+	for (; node != NULL; node = node->next) {
+		if (node->type != XML_ELEMENT_NODE)
+			continue;
+
+		if (component != NULL) {
+			if (_src_node_is(node, SRC_XCCDF_NS, "Rule")) {
+				oscap_list_add(component->rules, node);
+			} else if (_src_node_is(node, SRC_OVAL_DEF_NS, "definition")) {
+				_src_table_add(component->oval_definitions, node, false);
+				char *class = (char *) xmlGetProp(node, BAD_CAST "class");
+				if (class != NULL && (strcmp(class, "compliance") == 0 || strcmp(class, "patch") == 0))
+					_src_table_add(component->oval_compliance, node, false);
+				free(class);
+			} else if (_src_node_is(node, SRC_OCIL_NS, "questionnaire")) {
+				_src_table_add(component->ocil_questionnaires, node, false);
+			}
+			_src_index_walk(index, node->children, component, data_stream);
+		} else if (_src_node_is(node, SRC_DS_NS, "component")) {
+			struct _src_component *content = _src_component_new();
+			char *id = (char *) xmlGetProp(node, BAD_CAST "id");
+			_src_table_add(index->components, node, true);
+			if (id == NULL || !oscap_htable_add(index->component_content, id, content)) {
+				_src_component_free(content);
+				content = NULL;
+			}
+			free(id);
+			if (content != NULL)
+				_src_index_walk(index, node->children, content, data_stream);
+		} else if (_src_node_is(node, SRC_DS_NS, "data-stream")) {
+			struct _src_data_stream *stream = malloc(sizeof(struct _src_data_stream));
+			stream->node = node;
+			stream->component_refs = oscap_htable_new();
+			oscap_list_add(index->data_streams, stream);
+			_src_index_walk(index, node->children, NULL, stream);
+		} else {
+			if (data_stream != NULL && _src_node_is(node, SRC_DS_NS, "component-ref"))
+				_src_table_add(data_stream->component_refs, node, true);
+			_src_index_walk(index, node->children, NULL, data_stream);
+		}
+	}
+}
+
+static struct _src_index *_src_index_new(xmlDocPtr doc)
+{
+	struct _src_index *index = calloc(1, sizeof(struct _src_index));
+	index->components = oscap_htable_new();
+	index->component_content = oscap_htable_new();
+	index->data_streams = oscap_list_new();
+	_src_index_walk(index, xmlDocGetRootElement(doc), NULL, NULL);
+	return index;
+}
+
+static void _src_index_free(struct _src_index *index)
+{
+	if (index == NULL)
+		return;
+	oscap_htable_free0(index->components);
+	oscap_htable_free(index->component_content, (oscap_destruct_func) _src_component_free);
+	oscap_list_free(index->data_streams, (oscap_destruct_func) _src_data_stream_free);
+	free(index);
+}
+
+static char *_xcf_resolve_in_catalog(xmlNodePtr resolver_node, const char *uri)
 {
 	if (*uri == '#') {
 		return oscap_strdup(uri);
@@ -157,7 +308,7 @@ static char *_xcf_resolve_in_catalog(xmlNodePtr resolver_node, const char *uri,
 			return resolver_node_uri;
 		} else {
 			free(name);
-			return _xcf_resolve_in_catalog(resolver_node->next, uri, context);
+			return _xcf_resolve_in_catalog(resolver_node->next, uri);
 		}
 	} else if (strcmp((char *)resolver_node->name, "rewriteURI") == 0) {
 		char *uri_start_string = (char *) xmlGetProp(resolver_node, BAD_CAST "uriStartString");
@@ -169,48 +320,40 @@ static char *_xcf_resolve_in_catalog(xmlNodePtr resolver_node, const char *uri,
 			return concat;
 		} else {
 			free(uri_start_string);
-			return _xcf_resolve_in_catalog(resolver_node->next, uri, context);
+			return _xcf_resolve_in_catalog(resolver_node->next, uri);
 		}
 	}
 	return NULL;
 }
 
-static xmlNodePtr _xcf_get_component_ref(xmlNodePtr catalog, const char *uri, xmlXPathContextPtr context)
+static xmlNodePtr _xcf_get_component_ref(xmlNodePtr catalog, const char *uri, struct _src_index *index)
 {
-	char *component_ref_uri = _xcf_resolve_in_catalog(catalog->children->next, uri, context);
+	char *component_ref_uri = _xcf_resolve_in_catalog(catalog->children->next, uri);
 	if (component_ref_uri == NULL) {
 		dD("Can't get component_ref URI using check-content-ref href='%s'", uri);
 		return NULL;
 	}
+	/* ancestor::ds:data-stream//ds:component-ref[@id=$cref] */
 	char *cref = component_ref_uri + 1;
-	xmlNodePtr component_ref_node = NULL;
-	char *xpath = oscap_sprintf("ancestor::ds:data-stream//ds:component-ref[@id='%s']", cref);
-	xmlXPathObjectPtr component_refs = xmlXPathNodeEval(catalog, BAD_CAST xpath, context);
-	if (component_refs != NULL && component_refs->nodesetval != NULL && component_refs->nodesetval->nodeNr == 1) {
-		component_ref_node = component_refs->nodesetval->nodeTab[0];
-	}
+	xmlNodePtr component_ref_node = _src_table_get(index->data_stream->component_refs, cref);
 	if (component_ref_node == NULL) {
 		dD("component-ref '%s' not found", cref);
 	}
-	xmlXPathFreeObject(component_refs);
-	free(xpath);
 	free(component_ref_uri);
 
 	return component_ref_node;
 }
 
-static xmlNodePtr _xcf_get_component(xmlNodePtr component_ref_node, xmlXPathContextPtr context)
+static struct _src_component *_xcf_get_component(xmlNodePtr component_ref_node, struct _src_index *index, xmlNodePtr *component_node)
 {
-	char *xlink_href = (char *) xmlGetNsProp(component_ref_node, BAD_CAST "href", BAD_CAST "http://www.w3.org/1999/xlink");
-	char *xpath = oscap_sprintf("ancestor::ds:data-stream-collection//ds:component[@id='%s']", xlink_href + 1);
+	/* ancestor::ds:data-stream-collection//ds:component[@id=$href] */
+	char *xlink_href = (char *) xmlGetNsProp(component_ref_node, BAD_CAST "href", BAD_CAST SRC_XLINK_NS);
+	const char *id = xlink_href != NULL && *xlink_href != '\0' ? xlink_href + 1 : NULL;
+	xmlNodePtr node = _src_table_get(index->components, id);
+	struct _src_component *component = node != NULL ? oscap_htable_get(index->component_content, id) : NULL;
 	free(xlink_href);
-	xmlXPathObjectPtr components = xmlXPathNodeEval(component_ref_node, BAD_CAST xpath, context);
-	xmlNodePtr component = NULL;
-	if (components != NULL && components->nodesetval != NULL && components->nodesetval->nodeNr == 1) {
-		component = components->nodesetval->nodeTab[0];
-	}
-	free(xpath);
-	xmlXPathFreeObject(components);
+	if (component_node != NULL)
+		*component_node = node;
 	return component;
 }
 
@@ -229,12 +372,12 @@ static xmlNodePtr _find_catalog(xmlNodePtr component_ref_node)
 	return catalog;
 }
 
-static bool _xcf_is_external_ref(xmlNodePtr catalog, const char *uri, xmlXPathContextPtr context)
+static bool _xcf_is_external_ref(xmlNodePtr catalog, const char *uri, struct _src_index *index)
 {
-	xmlNodePtr comp_ref = _xcf_get_component_ref(catalog, uri, context);
+	xmlNodePtr comp_ref = _xcf_get_component_ref(catalog, uri, index);
 	bool res = false;
 	if (comp_ref != NULL) {
-		char *xlink_href = (char *) xmlGetNsProp(comp_ref, BAD_CAST "href", BAD_CAST "http://www.w3.org/1999/xlink");
+		char *xlink_href = (char *) xmlGetNsProp(comp_ref, BAD_CAST "href", BAD_CAST SRC_XLINK_NS);
 		if (!oscap_str_startswith(xlink_href, "#"))
 			res = true;
 		free(xlink_href);
@@ -242,58 +385,46 @@ static bool _xcf_is_external_ref(xmlNodePtr catalog, const char *uri, xmlXPathCo
 	return res;
 }
 
-static bool _req_src_236_2_sub6(xmlNodePtr component, xmlXPathContextPtr context, const char *name, const char *rule_id)
+static bool _src_is_check_system(xmlNodePtr check_node, bool with_ocil)
 {
-	bool exists_ocil = false;
-	char *ocil_xpath = oscap_sprintf(".//ocil:questionnaire[@id='%s']", name);
-	xmlXPathObjectPtr ocil_questionnaires = xmlXPathNodeEval(component, BAD_CAST ocil_xpath, context);
-	if (ocil_questionnaires == NULL || ocil_questionnaires->nodesetval == NULL)
-		goto cleanup;
-	for (int m = 0; m < ocil_questionnaires->nodesetval->nodeNr; m++) {
-		xmlNodePtr ocil_questionnaire = ocil_questionnaires->nodesetval->nodeTab[m];
-		char *ocil_questionnaire_id = (char *) xmlGetProp(ocil_questionnaire, BAD_CAST "id");
-		dD("Found OCIL questionnaire id='%s' for rule id='%s'", ocil_questionnaire_id, rule_id);
-		free(ocil_questionnaire_id);
-		exists_ocil = true;
-	}
-cleanup:
-	free(ocil_xpath);
-	xmlXPathFreeObject(ocil_questionnaires);
-	return exists_ocil;
+	if (!_src_node_is(check_node, SRC_XCCDF_NS, "check"))
+		return false;
+	char *system = (char *) xmlGetProp(check_node, BAD_CAST "system");
+	bool res = system != NULL && (strcmp(system, SRC_OVAL_DEF_NS) == 0 ||
+		(with_ocil && strcmp(system, SRC_OCIL_SYSTEM) == 0));
+	free(system);
+	return res;
 }
 
-static bool _req_src_236_2_sub5(xmlNodePtr component, xmlXPathContextPtr context, const char *name, const char *rule_id)
+static bool _req_src_236_2_sub6(struct _src_component *component, const char *name, const char *rule_id)
+{
+	/* exists(...//ocil:questionnaire[@id eq $o/@name]) */
+	if (oscap_htable_get(component->ocil_questionnaires, name) == NULL)
+		return false;
+	dD("Found OCIL questionnaire id='%s' for rule id='%s'", name, rule_id);
+	return true;
+}
+
+static bool _req_src_236_2_sub5(struct _src_component *component, const char *name, const char *rule_id)
 {
 	/* exists(xcf:get-component(xcf:get-component-ref($m/cat:catalog, $o/@href))//oval-def:definition[@id eq $o/@name and matches(@class, '^(compliance|patch)$')]) */
-	bool exists_oval = false;
-	char *oval_xpath = oscap_sprintf(".//oval-def:definition[@id='%s' and (@class='compliance' or @class='patch')]", name);
-	xmlXPathObjectPtr oval_definitions = xmlXPathNodeEval(component, BAD_CAST oval_xpath, context);
-	if (oval_definitions == NULL || oval_definitions->nodesetval == NULL)
-		goto cleanup;
-	for (int m = 0; m < oval_definitions->nodesetval->nodeNr; m++) {
-		xmlNodePtr oval_definition = oval_definitions->nodesetval->nodeTab[m];
-		char *oval_def_id = (char *) xmlGetProp(oval_definition, BAD_CAST "id");
-		dD("Found OVAL definition id='%s' for rule id='%s'", oval_def_id, rule_id);
-		free(oval_def_id);
-		exists_oval = true;
-	}
-cleanup:
-	free(oval_xpath);
-	xmlXPathFreeObject(oval_definitions);
-	return exists_oval;
-}
-
-static bool _req_src_236_2_sub4(xmlNodePtr check_content_ref_node, xmlNodePtr catalog, xmlXPathContextPtr context, const char *rule_id)
+	if (oscap_htable_get(component->oval_compliance, name) == NULL)
+		return false;
+	dD("Found OVAL definition id='%s' for rule id='%s'", name, rule_id);
+	return true;
+}
+
+static bool _req_src_236_2_sub4(xmlNodePtr check_content_ref_node, xmlNodePtr catalog, struct _src_index *index, const char *rule_id)
 {
 	char *href = (char *) xmlGetProp(check_content_ref_node, BAD_CAST "href");
 	/* xcf:get-component(xcf:get-component-ref($m/cat:catalog, $o/@href) */
-	xmlNodePtr component_ref =  _xcf_get_component_ref(catalog, href, context);
+	xmlNodePtr component_ref =  _xcf_get_component_ref(catalog, href, index);
 	free(href);
 	if (component_ref == NULL) {
 		dD("component_ref not found");
 		return false;
 	}
-	xmlNodePtr component = _xcf_get_component(component_ref, context);
+	struct _src_component *component = _xcf_get_component(component_ref, index, NULL);
 	if (component == NULL) {
 		dD("component not found\n");
 		return false;
@@ -302,113 +433,104 @@ static bool _req_src_236_2_sub4(xmlNodePtr check_content_ref_node, xmlNodePtr ca
 	char *name = (char *) xmlGetProp(check_content_ref_node, BAD_CAST "name");
 
 	/* exists(xcf:get-component(xcf:get-component-ref($m/cat:catalog, $o/@href))//oval-def:definition[@id eq $o/@name and matches(@class, '^(compliance|patch)$')]) or exists(xcf:get-component(xcf:get-component-ref($m/cat:catalog, $o/@href))//ocil:questionnaire[@id eq $o/@name])) */
-	bool res = (_req_src_236_2_sub5(component, context, name, rule_id) || _req_src_236_2_sub6(component, context, name, rule_id));
+	bool res = (_req_src_236_2_sub5(component, name, rule_id) || _req_src_236_2_sub6(component, name, rule_id));
 
 	free(name);
 	return res;
 }
 
-static bool _req_src_236_2_sub3(xmlNodePtr rule_node, xmlNodePtr catalog, xmlXPathContextPtr context)
+static bool _req_src_236_2_sub3(xmlNodePtr rule_node, xmlNodePtr catalog, struct _src_index *index)
 {
-	bool res = true;
 	char *rule_id = (char *) xmlGetProp(rule_node, BAD_CAST "id");
 
 	/* note: $n is an xccdf:Rule */
 	/* if(exists($n/xccdf:check[@system eq 'http://oval.mitre.org/XMLSchema/oval-definitions-5' or @system eq 'http://scap.nist.gov/schema/ocil/2']/xccdf:check-content-ref[exists(@name) and not(xcf:is-external-ref($m/cat:catalog, @href) cast as xsd:boolean)])) then ... else true() */
-	xmlXPathObjectPtr check_content_refs = xmlXPathNodeEval(rule_node, BAD_CAST "xccdf:check[@system='http://oval.mitre.org/XMLSchema/oval-definitions-5' or @system='http://scap.nist.gov/schema/ocil/2']/xccdf:check-content-ref[@name]", context);
-	/* TODO: external refs check */
-	if (check_content_refs == NULL || check_content_refs->nodesetval == NULL) {
-		dD("Rule '%s' has no suitable check-content-refs", rule_id);
-		free(rule_id);
-		xmlXPathFreeObject(check_content_refs);
-		return true;
-	}
-
 	/* ... then some $o in $n/xccdf:check[@system eq 'http://oval.mitre.org/XMLSchema/oval-definitions-5' or @system eq 'http://scap.nist.gov/schema/ocil/2']/xccdf:check-content-ref[exists(@name) and not(xcf:is-external-ref($m/cat:catalog, @href) cast as xsd:boolean)] satisfies ... */
+	bool exists = false;
 	bool found = false;
-	for (int l = 0; l < check_content_refs->nodesetval->nodeNr; l++) {
-		xmlNodePtr check_content_ref_node = check_content_refs->nodesetval->nodeTab[l];
-		char *href = (char *) xmlGetProp(check_content_ref_node, BAD_CAST "href");
-		if (_xcf_is_external_ref(catalog, href, context)) {
-			free(href);
+	for (xmlNodePtr check = rule_node->children; check != NULL && !found; check = check->next) {
+		if (!_src_is_check_system(check, true))
 			continue;
+		for (xmlNodePtr check_content_ref_node = check->children; check_content_ref_node != NULL; check_content_ref_node = check_content_ref_node->next) {
+			if (!_src_node_is(check_content_ref_node, SRC_XCCDF_NS, "check-content-ref") ||
+					!xmlHasProp(check_content_ref_node, BAD_CAST "name"))
+				continue;
+			exists = true;
+			char *href = (char *) xmlGetProp(check_content_ref_node, BAD_CAST "href");
+			if (_xcf_is_external_ref(catalog, href, index)) {
+				free(href);
+				continue;
+			}
+			free(href);
+			if (_req_src_236_2_sub4(check_content_ref_node, catalog, index, rule_id)) {
+				found = true;
+				break;
+			}
 		}
-		free(href);
-		if (_req_src_236_2_sub4(check_content_ref_node, catalog, context, rule_id)) {
-			found = true;
-			break;
-		}
-	}
-	if (!found) {
-		res = false;
 	}
+	if (!exists)
+		dD("Rule '%s' has no suitable check-content-refs", rule_id);
 	free(rule_id);
-	xmlXPathFreeObject(check_content_refs);
-	return res;
+	return !exists || found;
 }
 
-static bool _req_src_236_2_sub2(xmlNodePtr component_ref_node, xmlNodePtr catalog, xmlXPathContextPtr context)
+static bool _req_src_236_2_sub2(xmlNodePtr component_ref_node, xmlNodePtr catalog, struct _src_index *index)
 {
 	bool res = true;
 	/* every $n in xcf:get-component($m)//xccdf:Rule satisfies ... */
-	xmlNodePtr component_node = _xcf_get_component(component_ref_node, context);
-	if (component_node == NULL) {
-		char *xlink_href = (char *) xmlGetNsProp(component_ref_node, BAD_CAST "href", BAD_CAST "http://www.w3.org/1999/xlink");
+	struct _src_component *component = _xcf_get_component(component_ref_node, index, NULL);
+	if (component == NULL) {
+		char *xlink_href = (char *) xmlGetNsProp(component_ref_node, BAD_CAST "href", BAD_CAST SRC_XLINK_NS);
 		dD("Can't find component using component-ref '%s'", xlink_href);
 		free(xlink_href);
 		return false;
 	}
-	xmlXPathObjectPtr rules = xmlXPathNodeEval(component_node, BAD_CAST ".//xccdf:Rule", context);
-	if (rules == NULL || rules->nodesetval == NULL) {
-		xmlXPathFreeObject(rules);
-		return res;
-	}
-	for (int i = 0; i < rules->nodesetval->nodeNr; i++) {
-		xmlNodePtr rule_node = rules->nodesetval->nodeTab[i];
+	struct oscap_iterator *rules = oscap_iterator_new(component->rules);
+	while (oscap_iterator_has_more(rules)) {
+		xmlNodePtr rule_node = oscap_iterator_next(rules);
 		char *rule_id = (char *) xmlGetProp(rule_node, BAD_CAST "id");
 		dD("Checking xccdf:Rule id='%s'", rule_id);
 		free(rule_id);
-		if (!_req_src_236_2_sub3(rule_node, catalog, context)) {
+		if (!_req_src_236_2_sub3(rule_node, catalog, index)) {
 			res = false;
 			break;
 		}
 	}
-	xmlXPathFreeObject(rules);
+	oscap_iterator_free(rules);
 	return res;
 }
 
-static bool _req_src_236_2_sub1(xmlNodePtr data_stream_node, xmlXPathContextPtr context)
+static bool _req_src_236_2_sub1(xmlNodePtr data_stream_node, struct _src_index *index)
 {
 	int res = true;
 	/* every $m in ds:checklists/ds:component-ref satisfies ... */
-	xmlXPathObjectPtr component_refs = xmlXPathNodeEval(data_stream_node, BAD_CAST "ds:checklists/ds:component-ref", context);
-	if (component_refs == NULL || component_refs->nodesetval == NULL) {
-		xmlXPathFreeObject(component_refs);
-		return res;
-	}
-	for (int i = 0; i < component_refs->nodesetval->nodeNr; i++) {
-		xmlNodePtr component_ref_node = component_refs->nodesetval->nodeTab[i];
-		char *component_ref_id = (char *) xmlGetProp(component_ref_node, BAD_CAST "id");
-		dD("Checking ds:component-ref id='%s'", component_ref_id);
-		free(component_ref_id);
-
-		/* find $m/catalog */
-		xmlNodePtr catalog = _find_catalog(component_ref_node);
-		if (catalog == NULL) {
-			res = false;
-			break;
-		}
-
-		if (!_req_src_236_2_sub2(component_ref_node, catalog, context)) {
-			res = false;
-			break;
+	for (xmlNodePtr checklists = data_stream_node->children; checklists != NULL && res; checklists = checklists->next) {
+		if (!_src_node_is(checklists, SRC_DS_NS, "checklists"))
+			continue;
+		for (xmlNodePtr component_ref_node = checklists->children; component_ref_node != NULL; component_ref_node = component_ref_node->next) {
+			if (!_src_node_is(component_ref_node, SRC_DS_NS, "component-ref"))
+				continue;
+			char *component_ref_id = (char *) xmlGetProp(component_ref_node, BAD_CAST "id");
+			dD("Checking ds:component-ref id='%s'", component_ref_id);
+			free(component_ref_id);
+
+			/* find $m/catalog */
+			xmlNodePtr catalog = _find_catalog(component_ref_node);
+			if (catalog == NULL) {
+				res = false;
+				break;
+			}
+
+			if (!_req_src_236_2_sub2(component_ref_node, catalog, index)) {
+				res = false;
+				break;
+			}
 		}
 	}
-	xmlXPathFreeObject(component_refs);
 	return res;
 }
 
-static bool _req_src_236_2(xmlXPathContextPtr context, FILE *outfile_fd)
+static bool _req_src_236_2(struct _src_index *index, FILE *outfile_fd)
 {
 	/*
 	 * This function implements the check for SCAPVAL requirement SRC-236-2
@@ -420,17 +542,19 @@ static bool _req_src_236_2(xmlXPathContextPtr context, FILE *outfile_fd)
 
 	bool res = true;
 	/* The parent rule element in the schematron matches all scap:data-stream elements */
-	xmlXPathObjectPtr data_streams = xmlXPathEval(BAD_CAST "//scap:data-stream", context);
-	for (int i = 0; i < data_streams->nodesetval->nodeNr; i++) {
-		xmlNodePtr data_stream_node = data_streams->nodesetval->nodeTab[i];
+	struct oscap_iterator *data_streams = oscap_iterator_new(index->data_streams);
+	while (oscap_iterator_has_more(data_streams)) {
+		index->data_stream = oscap_iterator_next(data_streams);
+		xmlNodePtr data_stream_node = index->data_stream->node;
 		/* The assert applies only to configuration use cases */
 		/* if(@use-case eq 'CONFIGURATION') then ...  else true() */
 		char *use_case = (char *) xmlGetProp(data_stream_node, BAD_CAST "use-case");
 		if (use_case == NULL || strcmp(use_case, "CONFIGURATION") != 0) {
+			free(use_case);
 			continue;
 		}
 		free(use_case);
-		if (!_req_src_236_2_sub1(data_stream_node, context)) {
+		if (!_req_src_236_2_sub1(data_stream_node, index)) {
 			char *data_stream_id = (char *) xmlGetProp(data_stream_node, BAD_CAST "id");
 			fprintf(outfile_fd, "Error: SRC-236-2|scap:data-stream %s\n", data_stream_id);
 			free(data_stream_id);
@@ -438,44 +562,33 @@ static bool _req_src_236_2(xmlXPathContextPtr context, FILE *outfile_fd)
 			break;
 		}
 	}
-	xmlXPathFreeObject(data_streams);
+	oscap_iterator_free(data_streams);
+	index->data_stream = NULL;
 	return res;
 }
 
 
-static bool _req_src_346_1_sub5(xmlNodePtr component, xmlXPathContextPtr context, const char *name)
+static bool _req_src_346_1_sub5(struct _src_component *component, const char *name)
 {
 	/* .//oval-def:definition[@id eq $n/@name]) */
-	bool exists_oval = false;
-	char *oval_xpath = oscap_sprintf(".//oval-def:definition[@id='%s']", name);
-	xmlXPathObjectPtr oval_definitions = xmlXPathNodeEval(component, BAD_CAST oval_xpath, context);
-	if (oval_definitions == NULL || oval_definitions->nodesetval == NULL)
-		goto cleanup;
-	for (int m = 0; m < oval_definitions->nodesetval->nodeNr; m++) {
-		xmlNodePtr oval_definition = oval_definitions->nodesetval->nodeTab[m];
-		char *oval_def_id = (char *) xmlGetProp(oval_definition, BAD_CAST "id");
-		dD("Found OVAL definition id='%s'", oval_def_id);
-		free(oval_def_id);
-		exists_oval = true;
-	}
-cleanup:
-	free(oval_xpath);
-	xmlXPathFreeObject(oval_definitions);
-	return exists_oval;
+	if (oscap_htable_get(component->oval_definitions, name) == NULL)
+		return false;
+	dD("Found OVAL definition id='%s'", name);
+	return true;
 }
 
-static bool _req_src_346_1_sub4(xmlNodePtr check_content_ref_node, xmlNodePtr catalog, xmlXPathContextPtr context)
+static bool _req_src_346_1_sub4(xmlNodePtr check_content_ref_node, xmlNodePtr catalog, struct _src_index *index)
 {
 
 	char *href = (char *) xmlGetProp(check_content_ref_node, BAD_CAST "href");
 	/* xcf:get-component(xcf:get-component-ref($m/cat:catalog, $o/@href) */
-	xmlNodePtr component_ref =  _xcf_get_component_ref(catalog, href, context);
+	xmlNodePtr component_ref =  _xcf_get_component_ref(catalog, href, index);
 	free(href);
 	if (component_ref == NULL) {
 		dD("component_ref not found");
 		return false;
 	}
-	xmlNodePtr component = _xcf_get_component(component_ref, context);
+	struct _src_component *component = _xcf_get_component(component_ref, index, NULL);
 	if (component == NULL) {
 		dD("component not found\n");
 		return false;
@@ -485,96 +598,90 @@ static bool _req_src_346_1_sub4(xmlNodePtr check_content_ref_node, xmlNodePtr ca
 	char *name = (char *) xmlGetProp(check_content_ref_node, BAD_CAST "name");
 	bool res = true;
 	if(name != NULL) {
-		res = _req_src_346_1_sub5(component, context, name);
+		res = _req_src_346_1_sub5(component, name);
 	}
 
 	free(name);
 	return res;
 }
 
-static bool _req_src_346_1_sub3(xmlNodePtr rule_node, xmlNodePtr catalog, xmlXPathContextPtr context)
+static bool _req_src_346_1_sub3(struct _src_component *component, xmlNodePtr catalog, struct _src_index *index)
 {
-	bool res = true;
-
 	/* xccdf:check[@system eq 'http://oval.mitre.org/XMLSchema/oval-definitions-5']//xccdf:check-content-ref[not(xcf:is-external-ref($m/cat:catalog, @href) cast as xsd:boolean)] */
-	xmlXPathObjectPtr check_content_refs = xmlXPathNodeEval(rule_node, BAD_CAST ".//xccdf:Rule/xccdf:check[@system='http://oval.mitre.org/XMLSchema/oval-definitions-5']/xccdf:check-content-ref", context);
-
-	if (check_content_refs == NULL || check_content_refs->nodesetval == NULL) {
-		dD("There are no check-content-refs elements to be checked.");
-		xmlXPathFreeObject(check_content_refs);
-		return true;
-	}
-
 	/* ... (not(exists($n/@name)) or exists(xcf:get-component(xcf:get-component-ref($m/cat:catalog, $n/@href))//oval-def:definition[@id eq $n/@name])) */
 	bool found = true;
-	for (int l = 0; l < check_content_refs->nodesetval->nodeNr; l++) {
-		xmlNodePtr check_content_ref_node = check_content_refs->nodesetval->nodeTab[l];
-		char *href = (char *) xmlGetProp(check_content_ref_node, BAD_CAST "href");
-		if (_xcf_is_external_ref(catalog, href, context)) {
-			free(href);
-			continue;
+	struct oscap_iterator *rules = oscap_iterator_new(component->rules);
+	while (found && oscap_iterator_has_more(rules)) {
+		xmlNodePtr rule_node = oscap_iterator_next(rules);
+		for (xmlNodePtr check = rule_node->children; check != NULL && found; check = check->next) {
+			if (!_src_is_check_system(check, false))
+				continue;
+			for (xmlNodePtr check_content_ref_node = check->children; check_content_ref_node != NULL; check_content_ref_node = check_content_ref_node->next) {
+				if (!_src_node_is(check_content_ref_node, SRC_XCCDF_NS, "check-content-ref"))
+					continue;
+				char *href = (char *) xmlGetProp(check_content_ref_node, BAD_CAST "href");
+				bool external = _xcf_is_external_ref(catalog, href, index);
+				free(href);
+				if (external)
+					continue;
+				if (!_req_src_346_1_sub4(check_content_ref_node, catalog, index)) {
+					found = false;
+					break;
+				}
+			}
 		}
-		if (!_req_src_346_1_sub4(check_content_ref_node, catalog, context)) {
-			found = false;
-			break;
-		}
-	}
-	if (!found) {
-		res = false;
 	}
-	xmlXPathFreeObject(check_content_refs);
-	return res;
+	oscap_iterator_free(rules);
+	return found;
 }
 
-static bool _req_src_346_1_sub2(xmlNodePtr component_ref_node, xmlNodePtr catalog, xmlXPathContextPtr context)
+static bool _req_src_346_1_sub2(xmlNodePtr component_ref_node, xmlNodePtr catalog, struct _src_index *index)
 {
 	/* every $n in xcf:get-component($m)//xccdf:check satisfies ... */
-	xmlNodePtr component_node = _xcf_get_component(component_ref_node, context);
-	if (component_node == NULL) {
-		char *xlink_href = (char *) xmlGetNsProp(component_ref_node, BAD_CAST "href", BAD_CAST "http://www.w3.org/1999/xlink");
+	struct _src_component *component = _xcf_get_component(component_ref_node, index, NULL);
+	if (component == NULL) {
+		char *xlink_href = (char *) xmlGetNsProp(component_ref_node, BAD_CAST "href", BAD_CAST SRC_XLINK_NS);
 		dD("Can't find component using component-ref '%s'", xlink_href);
 		free(xlink_href);
 		return false;
 	}
-	if (!_req_src_346_1_sub3(component_node, catalog, context)) {
+	if (!_req_src_346_1_sub3(component, catalog, index)) {
 		return false;
 	}
 	return true;
 }
 
-static bool _req_src_346_1_sub1(xmlNodePtr data_stream_node, xmlXPathContextPtr context)
+static bool _req_src_346_1_sub1(xmlNodePtr data_stream_node, struct _src_index *index)
 {
 	int res = true;
 	/* every $m in ds:checklists/ds:component-ref satisfies ... */
-	xmlXPathObjectPtr component_refs = xmlXPathNodeEval(data_stream_node, BAD_CAST "ds:checklists/ds:component-ref", context);
-	if (component_refs == NULL || component_refs->nodesetval == NULL) {
-		if (component_refs != NULL)
-			xmlXPathFreeObject(component_refs);
-		return res;
-	}
-	for (int i = 0; i < component_refs->nodesetval->nodeNr; i++) {
-		xmlNodePtr component_ref_node = component_refs->nodesetval->nodeTab[i];
-		char *component_ref_id = (char *) xmlGetProp(component_ref_node, BAD_CAST "id");
-		dD("Checking ds:component-ref id='%s'", component_ref_id);
-		free(component_ref_id);
-
-		/* find $m/catalog */
-		xmlNodePtr catalog = _find_catalog(component_ref_node);
-		if (catalog == NULL) {
-			res = false;
-			break;
-		}
-
-		if (!_req_src_346_1_sub2(component_ref_node, catalog, context)) {
-			res = false;
-			break;
+	for (xmlNodePtr checklists = data_stream_node->children; checklists != NULL && res; checklists = checklists->next) {
+		if (!_src_node_is(checklists, SRC_DS_NS, "checklists"))
+			continue;
+		for (xmlNodePtr component_ref_node = checklists->children; component_ref_node != NULL; component_ref_node = component_ref_node->next) {
+			if (!_src_node_is(component_ref_node, SRC_DS_NS, "component-ref"))
+				continue;
+			char *component_ref_id = (char *) xmlGetProp(component_ref_node, BAD_CAST "id");
+			dD("Checking ds:component-ref id='%s'", component_ref_id);
+			free(component_ref_id);
+
+			/* find $m/catalog */
+			xmlNodePtr catalog = _find_catalog(component_ref_node);
+			if (catalog == NULL) {
+				res = false;
+				break;
+			}
+
+			if (!_req_src_346_1_sub2(component_ref_node, catalog, index)) {
+				res = false;
+				break;
+			}
 		}
 	}
-	xmlXPathFreeObject(component_refs);
 	return res;
 }
 
-static bool _req_src_346_1(xmlXPathContextPtr context, FILE *outfile_fd)
+static bool _req_src_346_1(struct _src_index *index, FILE *outfile_fd)
 {
 	/*
 	 * This function implements the check for SCAPVAL requirement SRC-346-1
@@ -586,10 +693,11 @@ static bool _req_src_346_1(xmlXPathContextPtr context, FILE *outfile_fd)
 
 	bool res = true;
 	/* The parent rule element in the schematron matches all scap:data-stream elements */
-	xmlXPathObjectPtr data_streams = xmlXPathEval(BAD_CAST "//scap:data-stream", context);
-	for (int i = 0; i < data_streams->nodesetval->nodeNr; i++) {
-		xmlNodePtr data_stream_node = data_streams->nodesetval->nodeTab[i];
-		if (!_req_src_346_1_sub1(data_stream_node, context)) {
+	struct oscap_iterator *data_streams = oscap_iterator_new(index->data_streams);
+	while (oscap_iterator_has_more(data_streams)) {
+		index->data_stream = oscap_iterator_next(data_streams);
+		xmlNodePtr data_stream_node = index->data_stream->node;
+		if (!_req_src_346_1_sub1(data_stream_node, index)) {
 			char *data_stream_id = (char *) xmlGetProp(data_stream_node, BAD_CAST "id");
 			fprintf(outfile_fd, "Error: SRC-346-1|scap:data-stream %s\n", data_stream_id);
 			free(data_stream_id);
@@ -597,34 +705,27 @@ static bool _req_src_346_1(xmlXPathContextPtr context, FILE *outfile_fd)
 			break;
 		}
 	}
-	xmlXPathFreeObject(data_streams);
+	oscap_iterator_free(data_streams);
+	index->data_stream = NULL;
 	return res;
 }
 
 static int _additional_schematron_checks(struct oscap_source *source, FILE *outfile_fd)
 {
 	xmlDocPtr doc = oscap_source_get_xmlDoc(source);
-	xmlXPathContextPtr context = xmlXPathNewContext(doc);
-	if (context == NULL) {
-		oscap_seterr(OSCAP_EFAMILY_XML, "Error in xmlXPathNewContext");
+	if (doc == NULL)
 		return -1;
-	}
-	xmlXPathRegisterNs(context, BAD_CAST "xccdf",  BAD_CAST "http://checklists.nist.gov/xccdf/1.2");
-	xmlXPathRegisterNs(context, BAD_CAST "scap", BAD_CAST "http://scap.nist.gov/schema/scap/source/1.2");
-	xmlXPathRegisterNs(context, BAD_CAST "ds", BAD_CAST "http://scap.nist.gov/schema/scap/source/1.2");
-	xmlXPathRegisterNs(context, BAD_CAST "xlink", BAD_CAST "http://www.w3.org/1999/xlink");
-	xmlXPathRegisterNs(context, BAD_CAST "oval-def", BAD_CAST "http://oval.mitre.org/XMLSchema/oval-definitions-5");
-	xmlXPathRegisterNs(context, BAD_CAST "ocil", BAD_CAST "http://scap.nist.gov/schema/ocil/2.0");
+	struct _src_index *index = _src_index_new(doc);
 
 	int res = 0;
 	/* Assert ID: scap-use-case-conf-verification-benchmark-one-rule-ref-oval-ocil */
-	if (!_req_src_236_2(context, outfile_fd))
+	if (!_req_src_236_2(index, outfile_fd))
 		res = 1;
 	/* Assert ID: scap-general-scap-content-xccdf-check-content-ref-name-not-req */
-	if (!_req_src_346_1(context, outfile_fd))
+	if (!_req_src_346_1(index, outfile_fd))
 		res = 1;
 
-	xmlXPathFreeContext(context);
+	_src_index_free(index);
 	return res;
 }
 
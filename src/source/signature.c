@@ -27,10 +27,14 @@
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <ctype.h>
 
 #include <libxml/tree.h>
 #include <libxml/xmlmemory.h>
 #include <libxml/parser.h>
+#include <libxml/c14n.h>
+
+#include <openssl/evp.h>
 
 #include <libxslt/xslt.h>
 #include <libxslt/security.h>
@@ -42,9 +46,11 @@
 
 #include "common/_error.h"
 #include "common/debug_priv.h"
+#include "common/oscap_threadpool.h"
 #include "oscap_source.h"
 #include "oscap_source_priv.h"
 #include "signature_priv.h"
+#include "validate_priv.h"
 
 struct oscap_signature_ctx {
 	const char *pubkey_pem; // path to the public key file in PEM format
@@ -111,6 +117,219 @@ static int _mark_sds_id_elements(xmlDocPtr doc)
 	return 0;
 }
 
+/*
+ * The digests of the references in the manifest, one for each signed
+ * component, are computed by a pool of threads before the signature is
+ * verified. Only the plain form used for data streams is handled: a same
+ * document reference with a single canonicalization transform. If all the
+ * digests match, xmlsec skips the manifest. Otherwise xmlsec processes it
+ * as usual and reports the result.
+ */
+struct oscap_signature_ref {
+	xmlNodePtr target;              ///< referenced element
+	int c14n_mode;
+	const EVP_MD *md;
+	char *digest_value;             ///< expected digest, base64 without whitespace
+	bool valid;
+};
+
+struct oscap_signature_pool {
+	xmlDocPtr doc;
+	struct oscap_signature_ref *refs;
+	size_t count;
+};
+
+static int _c14n_mode(const char *algorithm)
+{
+	if (algorithm == NULL)
+		return -1;
+	if (strcmp(algorithm, "http://www.w3.org/TR/2001/REC-xml-c14n-20010315") == 0)
+		return XML_C14N_1_0;
+	if (strcmp(algorithm, "http://www.w3.org/2006/12/xml-c14n11") == 0)
+		return XML_C14N_1_1;
+	if (strcmp(algorithm, "http://www.w3.org/2001/10/xml-exc-c14n#") == 0)
+		return XML_C14N_EXCLUSIVE_1_0;
+	return -1;
+}
+
+static const EVP_MD *_digest_md(const char *algorithm)
+{
+	if (algorithm == NULL)
+		return NULL;
+	if (strcmp(algorithm, "http://www.w3.org/2000/09/xmldsig#sha1") == 0)
+		return EVP_sha1();
+	if (strcmp(algorithm, "http://www.w3.org/2001/04/xmlenc#sha256") == 0)
+		return EVP_sha256();
+	if (strcmp(algorithm, "http://www.w3.org/2001/04/xmldsig-more#sha384") == 0)
+		return EVP_sha384();
+	if (strcmp(algorithm, "http://www.w3.org/2001/04/xmlenc#sha512") == 0)
+		return EVP_sha512();
+	return NULL;
+}
+
+static bool _ref_init(struct oscap_signature_ref *ref, xmlDocPtr doc, xmlNodePtr reference)
+{
+	bool ret = false;
+	char *uri = (char *) xmlGetProp(reference, xmlSecAttrURI);
+	char *c14n_algorithm = NULL;
+	char *digest_algorithm = NULL;
+
+	memset(ref, 0, sizeof(*ref));
+	if (uri == NULL || uri[0] != '#' || strchr(uri, '(') != NULL)
+		goto cleanup;
+	xmlAttrPtr id_attr = xmlGetID(doc, BAD_CAST (uri + 1));
+	if (id_attr == NULL || id_attr->parent == NULL)
+		goto cleanup;
+	ref->target = id_attr->parent;
+
+	xmlNodePtr transforms = xmlSecGetNextElementNode(reference->children);
+	if (transforms == NULL || !xmlSecCheckNodeName(transforms, xmlSecNodeTransforms, xmlSecDSigNs))
+		goto cleanup;
+	xmlNodePtr transform = xmlSecGetNextElementNode(transforms->children);
+	if (transform == NULL || xmlSecGetNextElementNode(transform->next) != NULL ||
+	    xmlSecGetNextElementNode(transform->children) != NULL)
+		goto cleanup;
+	c14n_algorithm = (char *) xmlGetProp(transform, xmlSecAttrAlgorithm);
+	ref->c14n_mode = _c14n_mode(c14n_algorithm);
+	if (ref->c14n_mode < 0)
+		goto cleanup;
+
+	xmlNodePtr digest_method = xmlSecGetNextElementNode(transforms->next);
+	if (digest_method == NULL || !xmlSecCheckNodeName(digest_method, xmlSecNodeDigestMethod, xmlSecDSigNs))
+		goto cleanup;
+	digest_algorithm = (char *) xmlGetProp(digest_method, xmlSecAttrAlgorithm);
+	ref->md = _digest_md(digest_algorithm);
+	if (ref->md == NULL)
+		goto cleanup;
+
+	xmlNodePtr digest_value = xmlSecGetNextElementNode(digest_method->next);
+	if (digest_value == NULL || !xmlSecCheckNodeName(digest_value, xmlSecNodeDigestValue, xmlSecDSigNs))
+		goto cleanup;
+	char *value = (char *) xmlNodeGetContent(digest_value);
+	if (value == NULL)
+		goto cleanup;
+	char *dst = value;
+	for (char *src = value; *src != '\0'; src++) {
+		if (!isspace((unsigned char) *src))
+			*dst++ = *src;
+	}
+	*dst = '\0';
+	ref->digest_value = value;
+	ret = true;
+
+cleanup:
+	xmlFree(uri);
+	xmlFree(c14n_algorithm);
+	xmlFree(digest_algorithm);
+	return ret;
+}
+
+/* The referenced element with its descendants, attributes and namespaces */
+static int _ref_node_visible(void *user_data, xmlNodePtr node, xmlNodePtr parent)
+{
+	xmlNodePtr target = user_data;
+	xmlNodePtr cur = node;
+
+	if (node == NULL || node->type == XML_NAMESPACE_DECL)
+		cur = parent;
+	for (; cur != NULL; cur = cur->parent) {
+		if (cur == target)
+			return 1;
+	}
+	return 0;
+}
+
+static int _ref_digest_write(void *context, const char *buffer, int len)
+{
+	return EVP_DigestUpdate(context, buffer, len) ? len : -1;
+}
+
+static void _ref_verify(xmlDocPtr doc, struct oscap_signature_ref *ref)
+{
+	unsigned char md_value[EVP_MAX_MD_SIZE];
+	unsigned int md_len = 0;
+	char encoded[4 * ((EVP_MAX_MD_SIZE + 2) / 3) + 1];
+
+	EVP_MD_CTX *mdctx = EVP_MD_CTX_new();
+	if (mdctx == NULL || !EVP_DigestInit_ex(mdctx, ref->md, NULL)) {
+		EVP_MD_CTX_free(mdctx);
+		return;
+	}
+	xmlOutputBufferPtr buf = xmlOutputBufferCreateIO(_ref_digest_write, NULL, mdctx, NULL);
+	int written = buf ? xmlC14NExecute(doc, _ref_node_visible, ref->target, ref->c14n_mode, NULL, 0, buf) : -1;
+	if (buf != NULL && xmlOutputBufferClose(buf) < 0)
+		written = -1;
+	if (written >= 0 && EVP_DigestFinal_ex(mdctx, md_value, &md_len)) {
+		EVP_EncodeBlock((unsigned char *) encoded, md_value, md_len);
+		ref->valid = strcmp(encoded, ref->digest_value) == 0;
+	}
+	EVP_MD_CTX_free(mdctx);
+}
+
+static void _ref_pool_run(void *arg, size_t i)
+{
+	struct oscap_signature_pool *pool = arg;
+
+	_ref_verify(pool->doc, &pool->refs[i]);
+}
+
+/**
+ * Verify the digests of the manifest references of the signature.
+ * @return number of the references if there are some and all are valid, -1 otherwise
+ */
+static int _verify_manifest_refs(xmlDocPtr doc, xmlNodePtr signature)
+{
+	struct oscap_signature_pool pool;
+	size_t i, jobs, capacity = 0, threads;
+	int ret = -1;
+
+	memset(&pool, 0, sizeof(pool));
+	pool.doc = doc;
+	for (xmlNodePtr object = xmlSecGetNextElementNode(signature->children); object != NULL;
+	     object = xmlSecGetNextElementNode(object->next)) {
+		if (!xmlSecCheckNodeName(object, xmlSecNodeObject, xmlSecDSigNs))
+			continue;
+		for (xmlNodePtr manifest = xmlSecGetNextElementNode(object->children); manifest != NULL;
+		     manifest = xmlSecGetNextElementNode(manifest->next)) {
+			if (!xmlSecCheckNodeName(manifest, xmlSecNodeManifest, xmlSecDSigNs))
+				continue;
+			for (xmlNodePtr reference = xmlSecGetNextElementNode(manifest->children); reference != NULL;
+			     reference = xmlSecGetNextElementNode(reference->next)) {
+				if (pool.count == capacity) {
+					capacity = capacity ? 2 * capacity : 16;
+					pool.refs = realloc(pool.refs, capacity * sizeof(struct oscap_signature_ref));
+				}
+				if (!xmlSecCheckNodeName(reference, xmlSecNodeReference, xmlSecDSigNs) ||
+				    !_ref_init(&pool.refs[pool.count], doc, reference)) {
+					dI("Manifest reference not supported, leaving the manifest to xmlsec");
+					goto cleanup;
+				}
+				pool.count++;
+			}
+		}
+	}
+	if (pool.count == 0)
+		goto cleanup;
+
+	jobs = oscap_validation_jobs();
+	threads = oscap_threadpool_run(jobs, pool.count, _ref_pool_run, &pool, NULL);
+
+	size_t good = 0;
+	for (i = 0; i < pool.count; i++) {
+		if (pool.refs[i].valid)
+			good++;
+	}
+	dI("Manifest references digested by %zu threads.", threads);
+	if (good == pool.count)
+		ret = pool.count;
+
+cleanup:
+	for (i = 0; i < pool.count; i++)
+		xmlFree(pool.refs[i].digest_value);
+	free(pool.refs);
+	return ret;
+}
+
 static int _oscap_signature_validate_doc(xmlDocPtr doc, oscap_document_type_t scap_type, struct oscap_signature_ctx *ctx, bool enforce_signature)
 {
 	int res = -1;
@@ -118,6 +337,7 @@ static int _oscap_signature_validate_doc(xmlDocPtr doc, oscap_document_type_t sc
 	xmlSecDSigCtxPtr dsigCtx = NULL;
 	xmlSecKeysMngrPtr mngr = NULL;
 	xsltSecurityPrefsPtr xsltSecPrefs = NULL;
+	int manifest_refs = -1;
 
 	dI("Validating XML signature.");
 
@@ -193,6 +413,12 @@ static int _oscap_signature_validate_doc(xmlDocPtr doc, oscap_document_type_t sc
 		oscap_seterr(OSCAP_EFAMILY_XML, "failed to create signature context");
 		goto cleanup;
 	}
+	/* The signed components have been digested already, only the
+	 * digest of the manifest itself is left to xmlsec */
+	if (scap_type == OSCAP_DOCUMENT_SDS)
+		manifest_refs = _verify_manifest_refs(doc, node);
+	if (manifest_refs >= 0)
+		dsigCtx->flags |= XMLSEC_DSIG_FLAGS_IGNORE_MANIFESTS;
 
 	/* Verify signature */
 	if (xmlSecDSigCtxVerify(dsigCtx, node) < 0) {
@@ -237,6 +463,8 @@ static int _oscap_signature_validate_doc(xmlDocPtr doc, oscap_document_type_t sc
 		if (dsigRefCtx->status == xmlSecDSigStatusSucceeded)
 			good++;
 	}
+	if (manifest_refs >= 0)
+		good = size = manifest_refs;
 	dI("Manifests references (ok/all): %d/%d", good, size);
 	if (good != size) {
 		res = 1;
@@ -25,7 +25,14 @@
 #include <libxml/parser.h>
 #include <libxml/xmlerror.h>
 #include <libxml/xmlschemas.h>
+#include <openssl/evp.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
 #ifdef OS_WINDOWS
 #include <io.h>
 #else
@@ -33,6 +40,9 @@
 #endif
 
 #include "common/_error.h"
+#include "common/debug_priv.h"
+#include "common/oscap_threadpool.h"
+#include "common/list.h"
 #include "common/util.h"
 #include "oscap.h"
 #include "oscap_source.h"
@@ -83,13 +93,173 @@ static void oscap_xml_validity_handler(void *user, xmlErrorPtr error)
 	context->reporter(file, error->line, error->message, context->arg);
 }
 
+/*
+ * Content which passed the validation is recorded in the directory given by
+ * OSCAP_VALIDATION_CACHE. The entry of the content is named by SHA-256 of the
+ * content and holds the digest, version of OpenSCAP and the schema used, so
+ * that the validation of the same content against the same schema is skipped
+ * in later runs. Entries of other versions or schemas are ignored.
+ */
+#define OSCAP_VALIDATION_CACHE_MAGIC "openscap-validation-cache-1"
+
+static char *oscap_validation_cache_digest(struct oscap_source *source)
+{
+	const char *memory;
+	size_t size;
+	unsigned char digest[EVP_MAX_MD_SIZE];
+	unsigned int digest_len;
+
+	if (oscap_source_get_memory(source, &memory, &size) != 0)
+		return NULL;
+	if (EVP_Digest(memory, size, digest, &digest_len, EVP_sha256(), NULL) != 1)
+		return NULL;
+
+	char *hex = malloc(2 * digest_len + 1);
+	for (unsigned int i = 0; i < digest_len; i++)
+		sprintf(hex + 2 * i, "%02x", digest[i]);
+	return hex;
+}
+
+/**
+ * Get path of the entry of the content in the validation cache.
+ * @returns the path or NULL if the cache is not enabled or usable
+ */
+static char *oscap_validation_cache_entry(struct oscap_source *source, char **digest)
+{
+	*digest = NULL;
+#ifdef OS_WINDOWS
+	return NULL;
+#else
+	const char *dir = getenv("OSCAP_VALIDATION_CACHE");
+	if (dir == NULL || *dir == '\0')
+		return NULL;
+
+	struct stat st;
+	if (mkdir(dir, 0700) != 0 && errno != EEXIST) {
+		dW("Can't create the validation cache '%s': %s.", dir, strerror(errno));
+		return NULL;
+	}
+	// entries anybody else can write would skip the validation of any content
+	if (stat(dir, &st) != 0 || !S_ISDIR(st.st_mode) || st.st_uid != geteuid()
+	    || (st.st_mode & (S_IWGRP | S_IWOTH)) != 0) {
+		dW("Ignoring the validation cache '%s', it's not a directory "
+		   "writable only by its owner.", dir);
+		return NULL;
+	}
+
+	*digest = oscap_validation_cache_digest(source);
+	if (*digest == NULL)
+		return NULL;
+	return oscap_sprintf("%s/%s", dir, *digest);
+#endif
+}
+
+static char *oscap_validation_cache_record(const char *digest, const char *schemapath)
+{
+	// schemas modified in place invalidate the entries
+	struct stat st;
+	long long mtime = stat(schemapath, &st) == 0 ? (long long) st.st_mtime : 0;
+	return oscap_sprintf(OSCAP_VALIDATION_CACHE_MAGIC " %s %s %s %lld\n", digest, OPENSCAP_VERSION, schemapath, mtime);
+}
+
+static bool oscap_validation_cache_lookup(const char *entry, const char *record)
+{
+#ifdef OS_WINDOWS
+	return false;
+#else
+	struct stat st;
+	char line[4096];
+	bool found = false;
+
+	int fd = open(entry, O_RDONLY | O_NOFOLLOW);
+	if (fd == -1)
+		return false;
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_uid != geteuid()
+	    || (st.st_mode & (S_IWGRP | S_IWOTH)) != 0) {
+		close(fd);
+		return false;
+	}
+	FILE *fp = fdopen(fd, "r");
+	if (fp == NULL) {
+		close(fd);
+		return false;
+	}
+	found = fgets(line, sizeof(line), fp) != NULL && strcmp(line, record) == 0;
+	fclose(fp);
+	return found;
+#endif
+}
+
+static void oscap_validation_cache_store(const char *entry, const char *record)
+{
+#ifndef OS_WINDOWS
+	char *tmp_path = oscap_sprintf("%s.XXXXXX", entry);
+	int fd = mkstemp(tmp_path);
+	if (fd == -1) {
+		dW("Can't write the validation cache entry '%s': %s.", entry, strerror(errno));
+		free(tmp_path);
+		return;
+	}
+	size_t len = strlen(record);
+	bool written = write(fd, record, len) == (ssize_t) len;
+	if (close(fd) != 0 || !written || rename(tmp_path, entry) != 0) {
+		dW("Can't write the validation cache entry '%s': %s.", entry, strerror(errno));
+		unlink(tmp_path);
+	}
+	free(tmp_path);
+#endif
+}
+
+/*
+ * Compiled schemas are kept for the lifetime of the process. Once compiled
+ * a schema is only read by the validation contexts, which may run in
+ * parallel.
+ */
+static struct oscap_htable *oscap_schema_cache = NULL;
+static pthread_mutex_t oscap_schema_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static xmlSchemaPtr oscap_schema_cache_get(const char *schemapath, struct ctxt *context)
+{
+	pthread_mutex_lock(&oscap_schema_cache_lock);
+	if (oscap_schema_cache == NULL)
+		oscap_schema_cache = oscap_htable_new();
+
+	xmlSchemaPtr schema = oscap_htable_get(oscap_schema_cache, schemapath);
+	if (schema == NULL) {
+		xmlSchemaParserCtxtPtr parser_ctxt = xmlSchemaNewParserCtxt(schemapath);
+		if (parser_ctxt == NULL) {
+			oscap_seterr(OSCAP_EFAMILY_XML, "Could not create parser context for validation");
+		} else {
+			xmlSchemaSetParserStructuredErrors(parser_ctxt, oscap_xml_validity_handler, context);
+			schema = xmlSchemaParse(parser_ctxt);
+			xmlSchemaFreeParserCtxt(parser_ctxt);
+			if (schema == NULL)
+				oscap_seterr(OSCAP_EFAMILY_XML, "Could not parse XML schema");
+			else
+				oscap_htable_add(oscap_schema_cache, schemapath, schema);
+		}
+	}
+	pthread_mutex_unlock(&oscap_schema_cache_lock);
+	return schema;
+}
+
+void oscap_schema_cache_free(void)
+{
+	pthread_mutex_lock(&oscap_schema_cache_lock);
+	oscap_htable_free(oscap_schema_cache, (oscap_destruct_func) xmlSchemaFree);
+	oscap_schema_cache = NULL;
+	pthread_mutex_unlock(&oscap_schema_cache_lock);
+}
+
 static inline int oscap_validate_xml(struct oscap_source *source, const char *schemafile, xml_reporter reporter, void *arg)
 {
 	int result = -1;
-	xmlSchemaParserCtxtPtr parser_ctxt = NULL;
 	xmlSchemaPtr schema = NULL;
 	xmlSchemaValidCtxtPtr ctxt = NULL;
 	xmlDocPtr doc = NULL;
+	char *cache_entry = NULL;
+	char *cache_digest = NULL;
+	char *cache_record = NULL;
 
 	struct ctxt context = { reporter, arg, (void*) oscap_source_readable_origin(source)};
 
@@ -105,19 +275,20 @@ static inline int oscap_validate_xml(struct oscap_source *source, const char *sc
 		goto cleanup;
 	}
 
-	parser_ctxt = xmlSchemaNewParserCtxt(schemapath);
-	if (parser_ctxt == NULL) {
-		oscap_seterr(OSCAP_EFAMILY_XML, "Could not create parser context for validation");
-		goto cleanup;
+	cache_entry = oscap_validation_cache_entry(source, &cache_digest);
+	if (cache_entry != NULL) {
+		cache_record = oscap_validation_cache_record(cache_digest, schemapath);
+		if (oscap_validation_cache_lookup(cache_entry, cache_record)) {
+			dI("Content of '%s' has already passed the validation against '%s'.",
+				oscap_source_readable_origin(source), schemapath);
+			result = 0;
+			goto cleanup;
+		}
 	}
 
-	xmlSchemaSetParserStructuredErrors(parser_ctxt, oscap_xml_validity_handler, &context);
-
-	schema = xmlSchemaParse(parser_ctxt);
-	if (schema == NULL) {
-		oscap_seterr(OSCAP_EFAMILY_XML, "Could not parse XML schema");
+	schema = oscap_schema_cache_get(schemapath, &context);
+	if (schema == NULL)
 		goto cleanup;
-	}
 
 	ctxt = xmlSchemaNewValidCtxt(schema);
 	if (ctxt == NULL) {
@@ -140,6 +311,8 @@ static inline int oscap_validate_xml(struct oscap_source *source, const char *sc
 	 */
 	if (result != 0)
 		result = 1;
+	else if (cache_entry != NULL)
+		oscap_validation_cache_store(cache_entry, cache_record);
 	/* This would be nicer
 	 * if (result ==  -1)
 	 *	oscap_setxmlerr(xmlGetLastError());
@@ -148,10 +321,9 @@ static inline int oscap_validate_xml(struct oscap_source *source, const char *sc
 cleanup:
 	if (ctxt)
 		xmlSchemaFreeValidCtxt(ctxt);
-	if (schema)
-		xmlSchemaFree(schema);
-	if (parser_ctxt)
-		xmlSchemaFreeParserCtxt(parser_ctxt);
+	free(cache_entry);
+	free(cache_digest);
+	free(cache_record);
 	free(schemapath);
 
 	return result;
@@ -260,3 +432,57 @@ int oscap_source_validate_priv(struct oscap_source *source, oscap_document_type_
 	oscap_seterr(OSCAP_EFAMILY_OSCAP, "Schema file not found when trying to validate '%s'", oscap_source_readable_origin(source));
 	return -1;
 }
+
+struct oscap_validation_pool {
+	struct oscap_source **sources;
+	int *results;
+	xml_reporter reporter;
+	void *user;
+};
+
+size_t oscap_validation_jobs(void)
+{
+	return oscap_threadpool_jobs("OSCAP_VALIDATION_JOBS", 0, OSCAP_VALIDATION_MAX_JOBS);
+}
+
+static void oscap_validation_pool_run(void *arg, size_t i)
+{
+	struct oscap_validation_pool *pool = arg;
+
+	pool->results[i] = oscap_source_validate(pool->sources[i], pool->reporter, pool->user);
+}
+
+size_t oscap_source_validate_all(struct oscap_source **sources, size_t count, xml_reporter reporter, void *user)
+{
+	struct oscap_validation_pool pool;
+	size_t i, jobs;
+	char **errors;
+
+	memset(&pool, 0, sizeof(pool));
+	pool.sources = sources;
+	pool.reporter = reporter;
+	pool.user = user;
+	pool.results = calloc(count, sizeof(int));
+	errors = calloc(count, sizeof(char *));
+
+	jobs = oscap_validation_jobs();
+	if (jobs > count)
+		jobs = count;
+	dI("Validating %zu documents using %zu threads.", count, jobs);
+	oscap_threadpool_run(jobs, count, oscap_validation_pool_run, &pool, errors);
+
+	/* as if the sources were validated one by one until the first invalid one */
+	for (i = 0; i < count; i++) {
+		if (errors[i] != NULL)
+			oscap_seterr(OSCAP_EFAMILY_OSCAP, "%s", errors[i]);
+		if (pool.results[i] != 0)
+			break;
+	}
+	size_t invalid = i;
+
+	for (i = 0; i < count; i++)
+		free(errors[i]);
+	free(errors);
+	free(pool.results);
+	return invalid;
+}
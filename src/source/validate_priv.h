@@ -42,4 +42,26 @@ struct oscap_schema_table_entry {
  */
 int oscap_source_validate_priv(struct oscap_source *source, oscap_document_type_t doc_type, const char *version, xml_reporter reporter, void *user);
 
+#define OSCAP_VALIDATION_MAX_JOBS 64
+
+/**
+ * Number of threads validating documents, from OSCAP_VALIDATION_JOBS.
+ * The documents are validated one by one if it is 1.
+ */
+size_t oscap_validation_jobs(void);
+
+/**
+ * Validate the sources by a pool of OSCAP_VALIDATION_JOBS threads. The
+ * reporter may be called from any of the threads. The errors are raised in
+ * the calling thread as if the sources were validated one by one until the
+ * first one which is not valid.
+ * @return index of the first source which is not valid, count if all are valid
+ */
+size_t oscap_source_validate_all(struct oscap_source **sources, size_t count, xml_reporter reporter, void *user);
+
+/**
+ * Free the compiled schemas kept by the validation.
+ */
+void oscap_schema_cache_free(void);
+
 #endif
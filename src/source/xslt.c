@@ -29,6 +29,7 @@
 #include <libxslt/xsltutils.h>
 #include <libexslt/exslt.h>
 #include <string.h>
+#include <pthread.h>
 
 #ifdef OS_WINDOWS
 #include <io.h>
@@ -37,6 +38,7 @@
 #endif
 
 #include "common/_error.h"
+#include "common/list.h"
 #include "common/util.h"
 #include "oscap.h"
 #include "oscap_source.h"
@@ -107,6 +109,37 @@ static inline int save_stylesheet_result_to_file(xmlDoc *resulting_doc, xsltStyl
 	return ret;
 }
 
+static struct oscap_htable *oscap_xslt_cache = NULL;
+static pthread_mutex_t oscap_xslt_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * Compiled stylesheets are kept for the lifetime of the library, the
+ * Schematron and report stylesheets are applied many times in one run.
+ */
+static xsltStylesheet *oscap_xslt_cache_get(const char *xsltpath)
+{
+	pthread_mutex_lock(&oscap_xslt_cache_lock);
+	if (oscap_xslt_cache == NULL)
+		oscap_xslt_cache = oscap_htable_new();
+
+	xsltStylesheet *stylesheet = oscap_htable_get(oscap_xslt_cache, xsltpath);
+	if (stylesheet == NULL) {
+		stylesheet = xsltParseStylesheetFile(BAD_CAST xsltpath);
+		if (stylesheet != NULL)
+			oscap_htable_add(oscap_xslt_cache, xsltpath, stylesheet);
+	}
+	pthread_mutex_unlock(&oscap_xslt_cache_lock);
+	return stylesheet;
+}
+
+void oscap_xslt_cache_free(void)
+{
+	pthread_mutex_lock(&oscap_xslt_cache_lock);
+	oscap_htable_free(oscap_xslt_cache, (oscap_destruct_func) xsltFreeStylesheet);
+	oscap_xslt_cache = NULL;
+	pthread_mutex_unlock(&oscap_xslt_cache_lock);
+}
+
 static xmlDoc *apply_xslt_path_internal(struct oscap_source *source, const char *xsltfile, const char **params, const char *path_to_xslt, xsltStylesheet **stylesheet)
 {
 	xmlDoc *doc = oscap_source_get_xmlDoc(source);
@@ -148,7 +181,7 @@ static xmlDoc *apply_xslt_path_internal(struct oscap_source *source, const char
 			ns_workaround = true;
 	}
 
-	*stylesheet = xsltParseStylesheetFile(BAD_CAST xsltpath);
+	*stylesheet = oscap_xslt_cache_get(xsltpath);
 	if (*stylesheet == NULL) {
 		oscap_seterr(OSCAP_EFAMILY_OSCAP, "Could not parse XSLT file '%s'", xsltpath);
 		free(xsltpath);
@@ -160,7 +193,6 @@ static xmlDoc *apply_xslt_path_internal(struct oscap_source *source, const char
 			oscap_seterr(OSCAP_EFAMILY_OSCAP, "Had problems employing XCCDF XSLT namespace workaround for XML document '%s'",
 				oscap_source_readable_origin(source));
 			free(xsltpath);
-			xsltFreeStylesheet(*stylesheet);
 			*stylesheet = NULL;
 			return NULL;
 		}
@@ -182,7 +214,6 @@ static xmlDoc *apply_xslt_path_internal(struct oscap_source *source, const char
 		oscap_seterr(OSCAP_EFAMILY_OSCAP, "Could not apply XSLT %s to XML file: %s", xsltpath,
 			oscap_source_readable_origin(source));
 		free(xsltpath);
-		xsltFreeStylesheet(*stylesheet);
 		*stylesheet = NULL;
 		return NULL;
 	}
@@ -199,7 +230,6 @@ int oscap_source_apply_xslt_path(struct oscap_source *source, const char *xsltfi
 		return -1;
 	}
 	int ret = save_stylesheet_result_to_file(transformed, stylesheet, outfile);
-	xsltFreeStylesheet(stylesheet);
 	xmlFreeDoc(transformed);
 	return ret;
 }
@@ -219,5 +249,6 @@ char *oscap_source_apply_xslt_path_mem(struct oscap_source *source, const char *
 		free(result);
 		result = NULL;
 	}
+	xmlFreeDoc(transformed);
 	return (char *)result;
 }
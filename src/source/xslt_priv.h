@@ -55,4 +55,9 @@ int oscap_source_apply_xslt_path(struct oscap_source *source, const char *xsltfi
  */
 char *oscap_source_apply_xslt_path_mem(struct oscap_source *source, const char *xsltfile, const char **params, const char *path_to_xslt);
 
+/**
+ * Free the stylesheets compiled by the oscap_source_apply_xslt_path* functions.
+ */
+void oscap_xslt_cache_free(void);
+
 #endif
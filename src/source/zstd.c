@@ -0,0 +1,214 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <libxml/tree.h>
+#include <libxml/xmlreader.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef OS_WINDOWS
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "zstd_priv.h"
+#include "common/_error.h"
+
+#ifdef ZSTD_FOUND
+
+#include <zstd.h>
+
+/*
+ * Both the file and the memory are decompressed by the same stream,
+ * the input of a file is refilled from the descriptor as it is consumed.
+ */
+struct zstd_input {
+	ZSTD_DStream *stream;
+	ZSTD_inBuffer in;
+	int fd;                 ///< owned descriptor of the file, -1 for memory
+	void *buffer;           ///< input read from the file
+	size_t buffer_size;
+	bool eof;               ///< no more input
+	size_t hint;            ///< 0 once the last frame is complete
+};
+
+static void zstd_input_free(struct zstd_input *input)
+{
+	ZSTD_freeDStream(input->stream);
+	if (input->fd != -1)
+		close(input->fd);
+	free(input->buffer);
+	free(input);
+}
+
+static struct zstd_input *zstd_input_new(void)
+{
+	struct zstd_input *input = calloc(1, sizeof(struct zstd_input));
+	input->fd = -1;
+	input->stream = ZSTD_createDStream();
+	if (input->stream == NULL) {
+		oscap_seterr(OSCAP_EFAMILY_OSCAP, "Could not create ZSTD_DStream");
+		free(input);
+		return NULL;
+	}
+	size_t ret = ZSTD_initDStream(input->stream);
+	if (ZSTD_isError(ret)) {
+		oscap_seterr(OSCAP_EFAMILY_OSCAP, "Could not initialize ZSTD_DStream: %s", ZSTD_getErrorName(ret));
+		zstd_input_free(input);
+		return NULL;
+	}
+	return input;
+}
+
+static struct zstd_input *zstd_fd_open(int fd)
+{
+	// The input is closed with the parser, the caller keeps its own descriptor
+	int fd_dup = dup(fd);
+	if (fd_dup == -1) {
+		oscap_seterr(OSCAP_EFAMILY_GLIBC, "Could not duplicate file descriptor of zstd file");
+		return NULL;
+	}
+	struct zstd_input *input = zstd_input_new();
+	if (input == NULL) {
+		close(fd_dup);
+		return NULL;
+	}
+	input->fd = fd_dup;
+	input->buffer_size = ZSTD_DStreamInSize();
+	input->buffer = malloc(input->buffer_size);
+	return input;
+}
+
+static struct zstd_input *zstd_mem_open(const char *buffer, size_t size)
+{
+	struct zstd_input *input = zstd_input_new();
+	if (input == NULL) {
+		return NULL;
+	}
+	input->in.src = buffer;
+	input->in.size = size;
+	input->eof = true;
+	return input;
+}
+
+// xmlInputReadCallback
+static int zstd_input_read(void *ctx, char *buffer, int len)
+{
+	struct zstd_input *input = ctx;
+	ZSTD_outBuffer out = { buffer, len < 0 ? 0 : len, 0 };
+
+	while (out.pos < out.size) {
+		if (input->in.pos == input->in.size) {
+			if (input->eof)
+				break;
+			ssize_t size = read(input->fd, input->buffer, input->buffer_size);
+			if (size < 0) {
+				oscap_seterr(OSCAP_EFAMILY_GLIBC, "Could not read zstd file: %s", strerror(errno));
+				return -1;
+			}
+			if (size == 0) {
+				input->eof = true;
+				break;
+			}
+			input->in.src = input->buffer;
+			input->in.size = size;
+			input->in.pos = 0;
+		}
+		size_t ret = ZSTD_decompressStream(input->stream, &out, &input->in);
+		if (ZSTD_isError(ret)) {
+			oscap_seterr(OSCAP_EFAMILY_OSCAP, "Could not read from ZSTD_DStream: %s", ZSTD_getErrorName(ret));
+			return -1;
+		}
+		input->hint = ret;
+	}
+	if (out.pos == 0 && input->hint != 0) {
+		oscap_seterr(OSCAP_EFAMILY_OSCAP, "Could not read from ZSTD_DStream: unexpected end of zstd data");
+		return -1;
+	}
+	return out.pos;
+}
+
+// xmlInputCloseCallback
+static int zstd_input_close(void *ctx)
+{
+	zstd_input_free(ctx);
+	return 0;
+}
+
+xmlDoc *zstd_fd_read_doc(int fd)
+{
+	struct zstd_input *input = zstd_fd_open(fd);
+	if (input == NULL) {
+		return NULL;
+	}
+	return xmlReadIO(zstd_input_read, zstd_input_close, input, "url", NULL, XML_PARSE_PEDANTIC);
+}
+
+xmlTextReader *zstd_fd_read_reader(int fd)
+{
+	struct zstd_input *input = zstd_fd_open(fd);
+	if (input == NULL) {
+		return NULL;
+	}
+	return xmlReaderForIO(zstd_input_read, zstd_input_close, input, "url", NULL, XML_PARSE_PEDANTIC);
+}
+
+xmlDoc *zstd_mem_read_doc(const char *buffer, size_t size)
+{
+	struct zstd_input *input = zstd_mem_open(buffer, size);
+	if (input == NULL) {
+		return NULL;
+	}
+	return xmlReadIO(zstd_input_read, zstd_input_close, input, "url", NULL, XML_PARSE_PEDANTIC);
+}
+
+xmlTextReader *zstd_mem_read_reader(const char *buffer, size_t size)
+{
+	struct zstd_input *input = zstd_mem_open(buffer, size);
+	if (input == NULL) {
+		return NULL;
+	}
+	return xmlReaderForIO(zstd_input_read, zstd_input_close, input, "url", NULL, XML_PARSE_PEDANTIC);
+}
+
+#endif
+
+static const unsigned char magic_number[] = {0x28, 0xb5, 0x2f, 0xfd};
+
+bool zstd_memory_is_zstd(const char *memory, const size_t size)
+{
+	if (size < sizeof(magic_number)) {
+		return false; // Cannot read magic number
+	}
+	return memcmp(memory, magic_number, sizeof(magic_number)) == 0;
+}
+
+bool zstd_fd_is_zstd(int fd)
+{
+	unsigned char header[sizeof(magic_number)];
+	ssize_t size = read(fd, header, sizeof(header));
+	lseek(fd, 0, SEEK_SET);
+	return size == (ssize_t) sizeof(header) && memcmp(header, magic_number, sizeof(magic_number)) == 0;
+}
@@ -38,11 +38,43 @@
 
 /* Definitions for PYTHON */
 
-%exception xccdf_policy_evaluate {
+/* Long running calls release the GIL, so that other Python threads run
+ * meanwhile. The callbacks they call back into Python take it again. */
+%define OSCAP_RELEASE_GIL(func)
+%exception func {
     Py_BEGIN_ALLOW_THREADS
     $action
     Py_END_ALLOW_THREADS
 }
+%enddef
+
+OSCAP_RELEASE_GIL(xccdf_policy_evaluate)
+OSCAP_RELEASE_GIL(xccdf_benchmark_import_source)
+OSCAP_RELEASE_GIL(xccdf_session_load)
+OSCAP_RELEASE_GIL(xccdf_session_load_xccdf)
+OSCAP_RELEASE_GIL(xccdf_session_load_cpe)
+OSCAP_RELEASE_GIL(xccdf_session_load_oval)
+OSCAP_RELEASE_GIL(xccdf_session_load_check_engine_plugins)
+OSCAP_RELEASE_GIL(xccdf_session_load_tailoring)
+OSCAP_RELEASE_GIL(xccdf_session_evaluate)
+OSCAP_RELEASE_GIL(xccdf_session_remediate)
+OSCAP_RELEASE_GIL(xccdf_session_export_xccdf)
+OSCAP_RELEASE_GIL(xccdf_session_export_oval)
+OSCAP_RELEASE_GIL(xccdf_session_export_check_engine_plugins)
+OSCAP_RELEASE_GIL(xccdf_session_export_arf)
+OSCAP_RELEASE_GIL(xccdf_session_export_all)
+OSCAP_RELEASE_GIL(xccdf_session_generate_guide)
+OSCAP_RELEASE_GIL(oval_definition_model_import_source)
+OSCAP_RELEASE_GIL(oval_syschar_model_import_source)
+OSCAP_RELEASE_GIL(oval_results_model_import_source)
+OSCAP_RELEASE_GIL(oval_results_model_export)
+OSCAP_RELEASE_GIL(oval_agent_eval_system)
+OSCAP_RELEASE_GIL(oval_agent_eval_definition)
+OSCAP_RELEASE_GIL(oval_session_load)
+OSCAP_RELEASE_GIL(oval_session_evaluate)
+OSCAP_RELEASE_GIL(oval_session_export)
+OSCAP_RELEASE_GIL(ds_rds_create)
+OSCAP_RELEASE_GIL(oscap_source_validate)
 
 %typemap(in) time_t
 {
@@ -546,7 +578,78 @@ int oval_agent_eval_system_py(oval_agent_session_t * asess, PyObject * func, PyO
     new_usrdata->func = func;
     new_usrdata->usr = usr;
 
-    return oval_agent_eval_system(asess, agent_reporter_callback_wrapper, (void *) new_usrdata);
+    int ret;
+    Py_BEGIN_ALLOW_THREADS
+    ret = oval_agent_eval_system(asess, agent_reporter_callback_wrapper, (void *) new_usrdata);
+    Py_END_ALLOW_THREADS
+    return ret;
+}
+
+/* All rule results of the last TestResult of the session in one list of
+ * (idref, result, severity, weight) tuples, without a wrapper object for
+ * each of them. */
+PyObject *xccdf_session_get_rule_results_py(struct xccdf_session *sess) {
+    struct xccdf_policy *policy = xccdf_session_get_xccdf_policy(sess);
+    struct xccdf_result *result = NULL;
+    PyObject *list = PyList_New(0);
+    if (list == NULL)
+        return NULL;
+    if (policy == NULL)
+        return list;
+
+    struct xccdf_result_iterator *res_it = xccdf_policy_get_results(policy);
+    while (xccdf_result_iterator_has_more(res_it))
+        result = xccdf_result_iterator_next(res_it);
+    xccdf_result_iterator_free(res_it);
+    if (result == NULL)
+        return list;
+
+    struct xccdf_rule_result_iterator *rr_it = xccdf_result_get_rule_results(result);
+    while (xccdf_rule_result_iterator_has_more(rr_it)) {
+        struct xccdf_rule_result *rr = xccdf_rule_result_iterator_next(rr_it);
+        PyObject *item = Py_BuildValue("(siid)", xccdf_rule_result_get_idref(rr),
+                (int) xccdf_rule_result_get_result(rr), (int) xccdf_rule_result_get_severity(rr),
+                (double) xccdf_rule_result_get_weight(rr));
+        if (item == NULL || PyList_Append(list, item) != 0) {
+            Py_XDECREF(item);
+            Py_DECREF(list);
+            list = NULL;
+            break;
+        }
+        Py_DECREF(item);
+    }
+    xccdf_rule_result_iterator_free(rr_it);
+    return list;
+}
+
+/* All definition results of the agent session in one list of
+ * (definition id, result) tuples. */
+PyObject *oval_agent_get_definition_results_py(oval_agent_session_t *asess) {
+    struct oval_results_model *res_model = oval_agent_get_results_model(asess);
+    PyObject *list = PyList_New(0);
+    if (list == NULL || res_model == NULL)
+        return list;
+
+    struct oval_result_system_iterator *sys_it = oval_results_model_get_systems(res_model);
+    while (list != NULL && oval_result_system_iterator_has_more(sys_it)) {
+        struct oval_result_system *sys = oval_result_system_iterator_next(sys_it);
+        struct oval_result_definition_iterator *def_it = oval_result_system_get_definitions(sys);
+        while (oval_result_definition_iterator_has_more(def_it)) {
+            struct oval_result_definition *def = oval_result_definition_iterator_next(def_it);
+            PyObject *item = Py_BuildValue("(si)", oval_result_definition_get_id(def),
+                    (int) oval_result_definition_get_result(def));
+            if (item == NULL || PyList_Append(list, item) != 0) {
+                Py_XDECREF(item);
+                Py_DECREF(list);
+                list = NULL;
+                break;
+            }
+            Py_DECREF(item);
+        }
+        oval_result_definition_iterator_free(def_it);
+    }
+    oval_result_system_iterator_free(sys_it);
+    return list;
 }
 
 /* we only recopy the first part of the struct, in order to free the rule property
@@ -405,6 +405,11 @@ class OSCAP_Object(object):
             if rule == rr.get_idref():
                 return rr
 
+    # all rule results of the last evaluation as (idref, result, severity, weight)
+    # tuples, much cheaper than walking the rule result objects
+    def xccdf_session_get_rule_results(self):
+        return OSCAP.xccdf_session_get_rule_results_py(self)
+
     def xccdf_session_free(self):
         OSCAP.xccdf_session_free_py(self)
 
@@ -448,6 +453,13 @@ class OSCAP_Object(object):
                 "Wrong call of oval_agent_eval_system function on %s" % (self.object,))
         return OSCAP.oval_agent_eval_system_py(sess.instance, self.__output_callback, (cb, usr))
 
+    # all definition results of the session as (definition id, result) tuples
+    def agent_get_definition_results(self, sess):
+        if self.object != "oval":
+            raise TypeError(
+                "Wrong call of oval_agent_get_definition_results function on %s" % (self.object,))
+        return OSCAP.oval_agent_get_definition_results_py(sess.instance)
+
     def query_sysinfo(self):
         if self.object != "oval_probe_session_t":
             raise TypeError(
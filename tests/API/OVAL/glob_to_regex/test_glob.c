@@ -0,0 +1,111 @@
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "OVAL/oval_glob_to_regex.h"
+#include "OVAL/oval_glob.h"
+
+/* Test vectors */
+/* ATTENTION: The backslash must be escaped in C strings */
+static const struct {
+	const char *glob;
+	const char *str;
+	int match;
+} matches[] = {
+	{ "list.?", "list.c", 1 },
+	{ "list.?", "list.", 0 },
+	{ "list.?", "list./", 0 },
+	{ "list.?", "list.\xc3\xa9", 1 },
+	{ "*old", "bold", 1 },
+	{ "*old", ".old", 0 },
+	{ "*old", "old", 1 },
+	{ "*.*", "a.b.c", 1 },
+	{ "*", "", 0 },
+	{ "*", "\n", 1 },
+	{ "?", ".", 0 },
+	{ "type*.[ch]", "type_x.h", 1 },
+	{ "type*.[ch]", "type_x.o", 0 },
+	{ "type*.[ch]", "type/x.c", 0 },
+	{ "x[[:digit:]]*", "x1abc", 1 },
+	{ "x[[:digit:]]*", "xa", 0 },
+	{ "[!/a]", "b", 1 },
+	{ "[!/a]", "\xc3\xa9", 1 },
+	{ "[!/a]", "a", 0 },
+	{ "\\*", "*", 1 },
+	{ "\\*", "a", 0 },
+	{ "/etc/*.conf", "/etc/yum.conf", 1 },
+	{ "/etc/*.conf", "/etc/.yum.conf", 0 },
+	{ "/etc/*.conf", "/etc/yum/yum.conf", 0 },
+	{ "/etc/*.conf", "/etc/yum.conf\n", 1 },
+	{ "/etc/**/*.conf", "/etc/yum/yum.conf", 1 },
+	{ "/etc/**.conf", "/etc/yum/yum.conf", 0 },
+	{ "*/x", "/x", 1 },
+	{ "*/x", "./x", 0 },
+	{ "/usr/lib", "/usr/lib", 1 },
+	{ "/usr/lib", "/usr/lib64", 0 },
+	{ "a*b*c", "aXbYbZc", 1 },
+	{ "a*b*c", "aXbYbZ", 0 },
+	{ "docs/?b", "docs/ab", 1 },
+	{ "docs/?b", "docs/.b", 0 },
+};
+
+static const struct {
+	const char *glob;
+	const char *dir;
+	int below;
+} belows[] = {
+	{ "/etc/*/*.conf", "/", 1 },
+	{ "/etc/*/*.conf", "/etc", 1 },
+	{ "/etc/*/*.conf", "/etc/yum", 1 },
+	{ "/etc/*/*.conf", "/etc/.git", 0 },
+	{ "/etc/*/*.conf", "/etc/yum/repos", 0 },
+	{ "/etc/*/*.conf", "/usr", 0 },
+	{ "/etc/*.conf", "/etc/", 1 },
+};
+
+int main(int argc, char *argv[])
+{
+	int retval = 0;
+
+	for (size_t i = 0; i < sizeof(matches) / sizeof(matches[0]); i++) {
+		char *regex = oval_glob_to_regex(matches[i].glob, 0);
+		struct oval_glob *glob = oval_glob_from_regex(regex);
+		int match = glob != NULL ? oval_glob_match(glob, matches[i].str, strlen(matches[i].str)) : -2;
+
+		printf("\t%s\t%s\t%s\t%d\t%d\n", match == matches[i].match ? "PASS" : "FAIL",
+		       matches[i].glob, regex, match, matches[i].match);
+		if (match != matches[i].match)
+			retval = 1;
+		oval_glob_free(glob);
+		free(regex);
+	}
+
+	for (size_t i = 0; i < sizeof(belows) / sizeof(belows[0]); i++) {
+		char *regex = oval_glob_to_regex(belows[i].glob, 0);
+		struct oval_glob *glob = oval_glob_from_regex(regex);
+		int below = glob != NULL ? oval_glob_match_below(glob, belows[i].dir, strlen(belows[i].dir)) : -2;
+
+		printf("\t%s\t%s\t%s\t%d\t%d\n", below == belows[i].below ? "PASS" : "FAIL",
+		       belows[i].glob, belows[i].dir, below, belows[i].below);
+		if (below != belows[i].below)
+			retval = 1;
+		oval_glob_free(glob);
+		free(regex);
+	}
+
+	/* patterns which aren't globs are left to PCRE */
+	const char *regexes[] = { "^/etc/.*$", "^a|b$", "^abc", "^[^a]$", "^a+$", "^\\d$" };
+	for (size_t i = 0; i < sizeof(regexes) / sizeof(regexes[0]); i++) {
+		struct oval_glob *glob = oval_glob_from_regex(regexes[i]);
+
+		printf("\t%s\t%s\tnot a glob\n", glob == NULL ? "PASS" : "FAIL", regexes[i]);
+		if (glob != NULL)
+			retval = 1;
+		oval_glob_free(glob);
+	}
+
+	return retval;
+}
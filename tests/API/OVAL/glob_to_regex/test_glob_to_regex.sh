@@ -16,12 +16,17 @@ function test_glob_to_regex {
     ./test_glob_to_regex
 }
 
+function test_glob {
+    ./test_glob
+}
+
 # Testing.
 
 test_init
 
 if [ -z ${CUSTOM_OSCAP+x} ] ; then
     test_run "test_glob_to_regex" test_glob_to_regex
+    test_run "test_glob" test_glob
 fi
 
 test_exit
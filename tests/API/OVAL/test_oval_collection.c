@@ -0,0 +1,177 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "OVAL/adt/oval_collection_impl.h"
+
+/* more items than the initial array holds */
+#define ITEMS 1000
+
+static int items[ITEMS];
+static int freed[ITEMS], freed_count;
+
+static struct oval_collection *fill_collection(void)
+{
+	struct oval_collection *collection = oval_collection_new();
+
+	for (int i = 0; i < ITEMS; i++)
+		oval_collection_add(collection, &items[i]);
+	return collection;
+}
+
+/* the items are returned in the order they were added */
+static int test_order(void)
+{
+	struct oval_collection *collection = fill_collection();
+	struct oval_iterator *it;
+	int i, ret = 0;
+
+	for (int round = 0; round < 2; round++) {
+		it = oval_collection_iterator(collection);
+		for (i = 0; oval_collection_iterator_has_more(it); i++) {
+			if (oval_collection_iterator_remaining(it) != ITEMS - i) {
+				fprintf(stderr, "%d items remaining instead of %d\n",
+					oval_collection_iterator_remaining(it), ITEMS - i);
+				ret = 1;
+				break;
+			}
+			if (i >= ITEMS || oval_collection_iterator_next(it) != &items[i]) {
+				fprintf(stderr, "Item %d out of order\n", i);
+				ret = 1;
+				break;
+			}
+		}
+		if (ret == 0 && (i != ITEMS || oval_collection_iterator_next(it) != NULL)) {
+			fprintf(stderr, "%d items iterated instead of %d\n", i, ITEMS);
+			ret = 1;
+		}
+		oval_collection_iterator_free(it);
+	}
+	oval_collection_free(collection);
+	return ret;
+}
+
+/* the items added during the iteration are not returned */
+static int test_add_while_iterating(void)
+{
+	struct oval_collection *collection = oval_collection_new();
+	struct oval_iterator *it, *all;
+	int i, ret = 0;
+
+	oval_collection_add(collection, &items[0]);
+	oval_collection_add(collection, &items[1]);
+	it = oval_collection_iterator(collection);
+	for (i = 0; oval_collection_iterator_has_more(it); i++) {
+		oval_collection_iterator_next(it);
+		/* the array is reallocated meanwhile */
+		for (int j = 2; j < ITEMS; j++)
+			oval_collection_add(collection, &items[j]);
+	}
+	oval_collection_iterator_free(it);
+	if (i != 2) {
+		fprintf(stderr, "%d items iterated instead of the 2 items which existed\n", i);
+		ret = 1;
+	}
+
+	all = oval_collection_iterator(collection);
+	if (oval_collection_iterator_remaining(all) != 2 * (ITEMS - 2) + 2) {
+		fprintf(stderr, "%d items in the collection instead of %d\n",
+			oval_collection_iterator_remaining(all), 2 * (ITEMS - 2) + 2);
+		ret = 1;
+	}
+	oval_collection_iterator_free(all);
+	oval_collection_free(collection);
+	return ret;
+}
+
+/* the items added to a standalone iterator are returned last added first */
+static int test_standalone_iterator(void)
+{
+	struct oval_iterator *it = oval_collection_iterator_new();
+	int i, ret = 0;
+
+	if (oval_collection_iterator_has_more(it)) {
+		fprintf(stderr, "An empty iterator has more items\n");
+		ret = 1;
+	}
+	for (i = 0; i < ITEMS; i++)
+		oval_collection_iterator_add(it, &items[i]);
+	for (i = 0; oval_collection_iterator_has_more(it); i++) {
+		if (i >= ITEMS || oval_collection_iterator_next(it) != &items[ITEMS - 1 - i]) {
+			fprintf(stderr, "Iterator item %d out of order\n", i);
+			ret = 1;
+			break;
+		}
+	}
+	if (ret == 0 && i != ITEMS) {
+		fprintf(stderr, "%d iterator items instead of %d\n", i, ITEMS);
+		ret = 1;
+	}
+	oval_collection_iterator_free(it);
+	return ret;
+}
+
+static void free_item(void *item)
+{
+	freed[freed_count++] = (int *)item - items;
+}
+
+/* the items are freed last added first */
+static int test_free_items(void)
+{
+	struct oval_collection *collection = fill_collection();
+	struct oval_collection *empty = oval_collection_new();
+	int ret = 0;
+
+	if (oval_collection_is_empty(collection) || !oval_collection_is_empty(empty)) {
+		fprintf(stderr, "The collections aren't empty as expected\n");
+		ret = 1;
+	}
+	oval_collection_free_items(empty, free_item);
+	freed_count = 0;
+	oval_collection_free_items(collection, free_item);
+	if (freed_count != ITEMS) {
+		fprintf(stderr, "%d items freed instead of %d\n", freed_count, ITEMS);
+		return 1;
+	}
+	for (int i = 0; i < ITEMS; i++) {
+		if (freed[i] != ITEMS - 1 - i) {
+			fprintf(stderr, "Item %d freed in place of %d\n", freed[i], ITEMS - 1 - i);
+			return 1;
+		}
+	}
+	return ret;
+}
+
+int main(void)
+{
+	int ret = 0;
+
+	ret |= test_order();
+	ret |= test_add_while_iterating();
+	ret |= test_standalone_iterator();
+	ret |= test_free_items();
+
+	return ret;
+}
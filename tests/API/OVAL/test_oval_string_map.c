@@ -0,0 +1,233 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "OVAL/adt/oval_string_map_impl.h"
+
+#define KEYS 1000
+#define READERS 4
+
+static char keys[KEYS][16];
+
+/* the keys are inserted in the reverse order of their sort order */
+static struct oval_string_map *fill_map(void)
+{
+	struct oval_string_map *map = oval_string_map_new();
+
+	for (int i = KEYS - 1; i >= 0; i--)
+		oval_string_map_put(map, keys[i], keys[i]);
+	return map;
+}
+
+static int test_put_get(void)
+{
+	struct oval_string_map *map = fill_map();
+	int ret = 0;
+
+	for (int i = 0; i < KEYS; i++) {
+		if (oval_string_map_get_value(map, keys[i]) != keys[i]) {
+			fprintf(stderr, "%s: not found after growing the map\n", keys[i]);
+			ret = 1;
+		}
+	}
+	if (oval_string_map_get_value(map, "missing") != NULL) {
+		fprintf(stderr, "A missing key was found\n");
+		ret = 1;
+	}
+
+	/* the first value of a key is kept */
+	oval_string_map_put(map, keys[0], "other");
+	if (oval_string_map_get_value(map, keys[0]) != keys[0]) {
+		fprintf(stderr, "%s: value replaced by a second put\n", keys[0]);
+		ret = 1;
+	}
+	oval_string_map_free(map, NULL);
+	return ret;
+}
+
+static int test_put_string(void)
+{
+	struct oval_string_map *map = oval_string_map_new();
+	char value[] = "value";
+	const char *stored;
+	int ret = 0;
+
+	oval_string_map_put_string(map, "key", value);
+	value[0] = 'V';
+	stored = oval_string_map_get_value(map, "key");
+	if (stored == NULL || strcmp(stored, "value") != 0) {
+		fprintf(stderr, "The string was not copied by the map\n");
+		ret = 1;
+	}
+	oval_string_map_free_string(map);
+	return ret;
+}
+
+static int test_ordered(void)
+{
+	struct oval_string_map *map = fill_map();
+	struct oval_collection *collection;
+	struct oval_iterator *it;
+	int i, ret = 0;
+
+	/* the keys, values and collections are ordered by key, the iterators
+	 * return the last added item first, and the lookups keep working
+	 * after the map was listed */
+	for (int round = 0; round < 2; round++) {
+		it = oval_string_map_keys(map);
+		for (i = 0; oval_collection_iterator_has_more(it); i++) {
+			const char *key = oval_collection_iterator_next(it);
+			if (i >= KEYS || strcmp(key, keys[KEYS - 1 - i]) != 0) {
+				fprintf(stderr, "Key %d out of order: %s\n", i, key);
+				ret = 1;
+				break;
+			}
+		}
+		oval_collection_iterator_free(it);
+
+		it = oval_string_map_values(map);
+		for (i = 0; oval_collection_iterator_has_more(it); i++) {
+			if (i >= KEYS || oval_collection_iterator_next(it) != keys[KEYS - 1 - i]) {
+				fprintf(stderr, "Value %d out of order\n", i);
+				ret = 1;
+				break;
+			}
+		}
+		oval_collection_iterator_free(it);
+		if (i != KEYS) {
+			fprintf(stderr, "%d values listed instead of %d\n", i, KEYS);
+			ret = 1;
+		}
+	}
+
+	collection = oval_string_map_collect_values(map, NULL);
+	it = oval_collection_iterator(collection);
+	for (i = 0; oval_collection_iterator_has_more(it); i++) {
+		if (i >= KEYS || oval_collection_iterator_next(it) != keys[i]) {
+			fprintf(stderr, "Collected value %d out of order\n", i);
+			ret = 1;
+			break;
+		}
+	}
+	oval_collection_iterator_free(it);
+	oval_collection_free(collection);
+
+	for (i = 0; i < KEYS; i++) {
+		if (oval_string_map_get_value(map, keys[i]) != keys[i]) {
+			fprintf(stderr, "%s: not found after listing the map\n", keys[i]);
+			ret = 1;
+		}
+	}
+	oval_string_map_free(map, NULL);
+	return ret;
+}
+
+static int test_empty(void)
+{
+	struct oval_string_map *map = oval_string_map_new();
+	struct oval_iterator *it;
+	int ret = 0;
+
+	if (oval_string_map_get_value(map, "key") != NULL || oval_string_map_get_value(NULL, "key") != NULL) {
+		fprintf(stderr, "A key was found in an empty map\n");
+		ret = 1;
+	}
+	it = oval_string_map_keys(map);
+	if (oval_collection_iterator_has_more(it)) {
+		fprintf(stderr, "An empty map has keys\n");
+		ret = 1;
+	}
+	oval_collection_iterator_free(it);
+	oval_string_map_free(map, NULL);
+	return ret;
+}
+
+struct reader {
+	struct oval_string_map *map;
+	int missed;
+};
+
+static void *reader_thread(void *arg)
+{
+	struct reader *r = arg;
+
+	for (int round = 0; round < 10; round++) {
+		for (int i = 0; i < KEYS; i++) {
+			if (oval_string_map_get_value(r->map, keys[i]) != keys[i])
+				r->missed++;
+		}
+	}
+	return NULL;
+}
+
+/* listing a map must not disturb the lookups of other threads */
+static int test_concurrent_readers(void)
+{
+	struct reader readers[READERS];
+	pthread_t threads[READERS];
+	int ret = 0;
+
+	for (int round = 0; round < 20 && ret == 0; round++) {
+		struct oval_string_map *map = fill_map();
+		struct oval_iterator *it;
+		int started = 0;
+
+		for (int i = 0; i < READERS; i++) {
+			readers[i].map = map;
+			readers[i].missed = 0;
+			if (pthread_create(&threads[started], NULL, reader_thread, &readers[i]) != 0)
+				break;
+			started++;
+		}
+		it = oval_string_map_keys(map);
+		oval_collection_iterator_free(it);
+		for (int i = 0; i < started; i++) {
+			pthread_join(threads[i], NULL);
+			if (readers[i].missed != 0) {
+				fprintf(stderr, "Reader %d missed %d lookups\n", i, readers[i].missed);
+				ret = 1;
+			}
+		}
+		oval_string_map_free(map, NULL);
+	}
+	return ret;
+}
+
+int main(void)
+{
+	int ret = 0;
+
+	for (int i = 0; i < KEYS; i++)
+		snprintf(keys[i], sizeof(keys[i]), "key%05d", i);
+
+	ret |= test_put_get();
+	ret |= test_put_string();
+	ret |= test_ordered();
+	ret |= test_empty();
+	ret |= test_concurrent_readers();
+
+	return ret;
+}
@@ -0,0 +1,124 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "oval_definitions.h"
+#include "oval_system_characteristics.h"
+#include "OVAL/oval_system_characteristics_impl.h"
+
+/*
+ * The items of equal content are stored once in the model, whatever their
+ * ids. The ids of the items which were merged refer to the stored item.
+ */
+
+static struct oval_sysitem *new_item(struct oval_syschar_model *model, const char *id,
+	const char *value, const char *message)
+{
+	struct oval_sysitem *item = oval_sysitem_new_unbound(model, id);
+	struct oval_sysent *ent = oval_sysent_new(model);
+
+	oval_sysitem_set_subtype(item, OVAL_INDEPENDENT_ENVIRONMENT_VARIABLE);
+	oval_sysitem_set_status(item, SYSCHAR_STATUS_EXISTS);
+	oval_sysent_set_name(ent, strdup("name"));
+	oval_sysent_set_value(ent, (char *)value);
+	oval_sysent_set_datatype(ent, OVAL_DATATYPE_STRING);
+	oval_sysent_set_status(ent, SYSCHAR_STATUS_EXISTS);
+	oval_sysitem_add_sysent(item, ent);
+	if (message != NULL) {
+		struct oval_message *msg = oval_message_new();
+
+		oval_message_set_text(msg, (char *)message);
+		oval_message_set_level(msg, OVAL_MESSAGE_LEVEL_INFO);
+		oval_sysitem_add_message(item, msg);
+	}
+	return oval_syschar_model_intern_sysitem(model, item);
+}
+
+static int check_item(struct oval_syschar_model *model, const char *id, struct oval_sysitem *expected)
+{
+	struct oval_sysitem *item = oval_syschar_model_get_sysitem(model, id);
+
+	if (item != expected) {
+		fprintf(stderr, "Item %s: refers to the item %s instead of %s\n", id,
+			item != NULL ? oval_sysitem_get_id(item) : "(none)",
+			expected != NULL ? oval_sysitem_get_id(expected) : "(none)");
+		return 1;
+	}
+	return 0;
+}
+
+static int test_intern(struct oval_syschar_model *model)
+{
+	struct oval_sysitem *a, *b, *c, *d;
+	int ret = 0;
+
+	a = new_item(model, "1", "PATH", NULL);
+	b = new_item(model, "2", "HOME", NULL);
+	/* collected again with other ids */
+	ret |= new_item(model, "3", "PATH", NULL) != a;
+	ret |= new_item(model, "4", "HOME", NULL) != b;
+	/* the messages are a part of the content */
+	c = new_item(model, "5", "PATH", "message");
+	d = new_item(model, "6", "PATH", "other message");
+	ret |= new_item(model, "7", "PATH", "message") != c;
+	if (ret != 0)
+		fprintf(stderr, "An equal item wasn't returned\n");
+	if (a == b || a == c || c == d) {
+		fprintf(stderr, "Different items were merged\n");
+		ret = 1;
+	}
+
+	ret |= check_item(model, "1", a);
+	ret |= check_item(model, "2", b);
+	ret |= check_item(model, "3", a);
+	ret |= check_item(model, "4", b);
+	ret |= check_item(model, "5", c);
+	ret |= check_item(model, "6", d);
+	ret |= check_item(model, "7", c);
+	ret |= check_item(model, "8", NULL);
+	if (strcmp(oval_sysitem_get_id(a), "1") != 0 || strcmp(oval_sysitem_get_id(c), "5") != 0) {
+		fprintf(stderr, "The stored items don't keep the first id\n");
+		ret = 1;
+	}
+	return ret;
+}
+
+int main(void)
+{
+	struct oval_definition_model *definition_model = oval_definition_model_new();
+	struct oval_syschar_model *model = oval_syschar_model_new(definition_model);
+	int ret = 0;
+
+	ret |= test_intern(model);
+
+	/* the aliases are dropped with the items */
+	oval_syschar_model_reset(model);
+	ret |= check_item(model, "3", NULL);
+	ret |= test_intern(model);
+
+	oval_syschar_model_free(model);
+	oval_definition_model_free(definition_model);
+	return ret;
+}
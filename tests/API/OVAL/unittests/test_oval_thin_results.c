@@ -0,0 +1,121 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "oval_agent_api.h"
+#include "oval_results.h"
+#include "oval_directives.h"
+#include "oscap.h"
+#include "oscap_debug.h"
+#include "oscap_source.h"
+
+/*
+ * Evaluate the system characteristics like oval analyse does, except that
+ * the directives are given to the results model before the evaluation,
+ * as the XCCDF session does with thin results. The number of the tested
+ * items kept in the results model after the evaluation is printed.
+ */
+static int count_tested_items(struct oval_results_model *model)
+{
+	struct oval_result_system_iterator *systems = oval_results_model_get_systems(model);
+	int count = 0;
+
+	while (oval_result_system_iterator_has_more(systems)) {
+		struct oval_result_system *sys = oval_result_system_iterator_next(systems);
+		struct oval_result_test_iterator *tests = oval_result_system_get_tests(sys);
+
+		while (oval_result_test_iterator_has_more(tests)) {
+			struct oval_result_item_iterator *items =
+				oval_result_test_get_items(oval_result_test_iterator_next(tests));
+
+			while (oval_result_item_iterator_has_more(items)) {
+				oval_result_item_iterator_next(items);
+				count++;
+			}
+			oval_result_item_iterator_free(items);
+		}
+		oval_result_test_iterator_free(tests);
+	}
+	oval_result_system_iterator_free(systems);
+	return count;
+}
+
+int main(int argc, char *argv[])
+{
+	struct oval_definition_model *def_model;
+	struct oval_syschar_model *sys_model;
+	struct oval_syschar_model *sys_models[2];
+	struct oval_results_model *res_model;
+	struct oscap_source *source;
+	int ret = 0;
+
+	if (argc != 4 && argc != 5) {
+		printf("Invalid arguments, usage: ./test_oval_thin_results DEFINITIONS SYSCHAR RESULTS [DIRECTIVES]\n");
+		return 2;
+	}
+	oscap_set_verbose("INFO", NULL);
+
+	source = oscap_source_new_from_file(argv[1]);
+	def_model = oval_definition_model_import_source(source);
+	oscap_source_free(source);
+	if (def_model == NULL) {
+		fprintf(stderr, "Failed to import the OVAL Definitions from '%s'.\n", argv[1]);
+		return 1;
+	}
+
+	sys_model = oval_syschar_model_new(def_model);
+	source = oscap_source_new_from_file(argv[2]);
+	if (oval_syschar_model_import_source(sys_model, source) == -1) {
+		fprintf(stderr, "Failed to import the System Characteristics from '%s'.\n", argv[2]);
+		ret = 1;
+	}
+	oscap_source_free(source);
+
+	sys_models[0] = sys_model;
+	sys_models[1] = NULL;
+	res_model = oval_results_model_new(def_model, sys_models);
+	if (ret == 0 && argc == 5) {
+		source = oscap_source_new_from_file(argv[4]);
+		if (oval_directives_model_import_source(oval_results_model_get_directives_model(res_model), source) != 0) {
+			fprintf(stderr, "Failed to import the OVAL Directives from '%s'.\n", argv[4]);
+			ret = 1;
+		}
+		oscap_source_free(source);
+	}
+
+	if (ret == 0) {
+		oval_results_model_eval(res_model);
+		printf("%d tested items\n", count_tested_items(res_model));
+		if (oval_results_model_export(res_model, NULL, argv[3]) < 0) {
+			fprintf(stderr, "Failed to export the OVAL Results to '%s'.\n", argv[3]);
+			ret = 1;
+		}
+	}
+
+	oval_results_model_free(res_model);
+	oval_syschar_model_free(sys_model);
+	oval_definition_model_free(def_model);
+	oscap_cleanup();
+	return ret;
+}
@@ -0,0 +1,45 @@
+#!/usr/bin/env bash
+
+# With thin results the items of a test are evaluated only until the test
+# result is determined, the results must stay the same. The directives are
+# given to the results model before the evaluation, as the XCCDF session does,
+# oscap oval analyse applies them only to the export.
+
+. $builddir/tests/test_common.sh
+
+set -e -o pipefail
+
+name=$(basename $0 .sh)
+content=test_filecontent_line
+result=$(mktemp ${name}.out.XXXXXX)
+stdout=$(mktemp ${name}.stdout.XXXXXX)
+stderr=$(mktemp ${name}.err.XXXXXX)
+
+# the second of the three items satisfies the state
+./test_oval_thin_results $srcdir/$content.oval.xml $srcdir/$content.syschar.xml \
+	$result $srcdir/$name.directives.xml > $stdout 2> $stderr
+
+grep -q "Result of test 'oval:x:tst:1' is determined, remaining items are not evaluated." $stderr
+# a single item satisfying the state doesn't determine "only one"
+grep -q "Result of test 'oval:x:tst:2' is determined" $stderr && false
+# the tested items aren't reported, they aren't kept either
+grep -q "^0 tested items$" $stdout
+
+assert_exists 1 '/oval_results/directives/definition_true[@reported="true" and @content="thin"]'
+assert_exists 2 '/oval_results/results/system/definitions/definition'
+assert_exists 1 '/oval_results/results/system/definitions/definition[@definition_id="oval:x:def:1"][@result="false"]'
+assert_exists 1 '/oval_results/results/system/definitions/definition[@definition_id="oval:x:def:2"][@result="true"]'
+assert_exists 0 '/oval_results/results/system/definitions/definition/criteria'
+
+# full results evaluate all the items
+:> $stderr
+./test_oval_thin_results $srcdir/$content.oval.xml $srcdir/$content.syschar.xml \
+	$result > $stdout 2> $stderr
+
+grep -q "is determined, remaining items are not evaluated" $stderr && false
+grep -q "^6 tested items$" $stdout
+assert_exists 3 '/oval_results/results/system/tests/test[@test_id="oval:x:tst:1"]/tested_item'
+assert_exists 1 '/oval_results/results/system/definitions/definition[@definition_id="oval:x:def:1"][@result="false"]'
+assert_exists 1 '/oval_results/results/system/definitions/definition[@definition_id="oval:x:def:2"][@result="true"]'
+
+rm $result $stdout $stderr
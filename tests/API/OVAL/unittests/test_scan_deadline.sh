@@ -0,0 +1,28 @@
+#!/usr/bin/env bash
+. $builddir/tests/test_common.sh
+
+set -e -o pipefail
+
+probecheck "textfilecontent" || exit 255
+
+result=$(mktemp test_scan_deadline.out.XXXXXX)
+echo "result file: $result"
+profiling=$(mktemp test_scan_deadline.json.XXXXXX)
+echo "profiling file: $profiling"
+
+echo "Collecting the object with the times of a previous scan."
+$OSCAP oval eval --profiling $profiling --results $result $srcdir/test_filecontent_line.oval.xml
+grep -q '"oval:x:obj:1"' $profiling
+$OSCAP oval eval --schedule-from $profiling --results $result $srcdir/test_filecontent_line.oval.xml
+assert_exists 1 '/oval_results/results/system/oval_system_characteristics/collected_objects/object[@id="oval:x:obj:1"][@flag="does not exist"]'
+
+# an unreadable file leaves the objects in their order
+$OSCAP oval eval --schedule-from $profiling.missing --results $result $srcdir/test_filecontent_line.oval.xml
+assert_exists 1 '/oval_results/results/system/oval_system_characteristics/collected_objects/object[@id="oval:x:obj:1"][@flag="does not exist"]'
+
+echo "Collecting the object after the deadline."
+$OSCAP oval eval --deadline 0.000000001 --results $result $srcdir/test_filecontent_line.oval.xml
+assert_exists 1 '/oval_results/results/system/oval_system_characteristics/collected_objects/object[@id="oval:x:obj:1"][@flag="incomplete"]'
+assert_exists 1 '/oval_results/results/system/oval_system_characteristics/collected_objects/object[@id="oval:x:obj:1"]/message[contains(text(), "deadline")]'
+
+rm $result $profiling
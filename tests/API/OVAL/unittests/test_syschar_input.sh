@@ -0,0 +1,35 @@
+#!/usr/bin/env bash
+. $builddir/tests/test_common.sh
+
+set -e -o pipefail
+
+# The recorded system characteristics of test_filecontent_line evaluated by
+# 'oval eval' have to give the same results as 'oval analyse'.
+result=$(mktemp test_syschar_input.out.XXXXXX)
+echo "result file: $result"
+stderr=$(mktemp test_syschar_input.err.XXXXXX)
+echo "stderr file: $stderr"
+
+echo "Evaluating recorded syschar content."
+$OSCAP oval eval --syschar-input $srcdir/test_filecontent_line.syschar.xml \
+	--results $result $srcdir/test_filecontent_line.oval.xml 2> $stderr
+[ -f $stderr ]; [ ! -s $stderr ]; rm $stderr
+[ -f $result ]
+
+assert_exists 1 '/oval_results/generator/oval:product_name[text()="cpe:/a:open-scap:oscap"]'
+assert_exists 2 '/oval_results/results/system/definitions/definition'
+assert_exists 1 '/oval_results/results/system/definitions/definition[@definition_id="oval:x:def:1"][@result="false"]'
+assert_exists 1 '/oval_results/results/system/definitions/definition[@definition_id="oval:x:def:2"][@result="true"]'
+assert_exists 1 '/oval_results/results/system/tests/test[@test_id="oval:x:tst:1"][@result="false"]'
+assert_exists 3 '/oval_results/results/system/tests/test[@test_id="oval:x:tst:1"]/tested_item'
+assert_exists 1 '/oval_results/results/system/tests/test[@test_id="oval:x:tst:2"][@result="true"]'
+assert_exists 3 '/oval_results/results/system/tests/test[@test_id="oval:x:tst:2"]/tested_item'
+# the recorded items are exported, nothing was collected
+assert_exists 1 '/oval_results/results/system/oval_system_characteristics/system_info'
+assert_exists 3 '/oval_results/results/system/oval_system_characteristics/system_data/*'
+
+echo "Evaluating one definition of recorded syschar content."
+$OSCAP oval eval --syschar-input $srcdir/test_filecontent_line.syschar.xml \
+	--id oval:x:def:2 $srcdir/test_filecontent_line.oval.xml | grep -q "Definition oval:x:def:2: true"
+
+rm $result
@@ -0,0 +1,312 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Throughput of the S-expression operations used on the probe hot paths
+ * and of the queue between the library and the probe threads, written as
+ * described in bench_common.h.
+ *
+ * Usage: bench_api_seap [-n ops] [-t max_threads] [-o output]
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sexp.h>
+#include "sch_queue.h"
+#include "bench_common.h"
+
+/*
+ * sch_queue.c is built into the benchmark, the probe thread it would start
+ * is never started.
+ */
+void *probe_common_main(void *arg)
+{
+	return NULL;
+}
+
+static SEXP_t *bench_list(uint32_t length)
+{
+	SEXP_t *list = SEXP_list_new(NULL);
+	for (uint32_t i = 0; i < length; ++i) {
+		SEXP_t *num = SEXP_number_newu_32(i);
+		SEXP_list_add(list, num);
+		SEXP_free(num);
+	}
+	return list;
+}
+
+/* An item as the probes build it: a name and a few entities with attributes */
+static SEXP_t *bench_item(uint32_t n)
+{
+	SEXP_t *item = SEXP_list_new(NULL);
+	SEXP_t *name = SEXP_string_newf("file_item");
+	SEXP_list_add(item, name);
+	SEXP_free(name);
+	for (uint32_t i = 0; i < 8; ++i) {
+		SEXP_t *ent = SEXP_list_new(NULL);
+		SEXP_t *ent_name = SEXP_string_newf("entity_%u", i);
+		SEXP_t *ent_value = SEXP_string_newf("/usr/share/doc/package-%u/file-%u", n, i);
+		SEXP_list_add(ent, ent_name);
+		SEXP_list_add(ent, ent_value);
+		SEXP_list_add(item, ent);
+		SEXP_free(ent_name);
+		SEXP_free(ent_value);
+		SEXP_free(ent);
+	}
+	return item;
+}
+
+static void bench_list_ops(uint64_t ops)
+{
+	struct bench_clock clk;
+	uint32_t length = ops > 100000 ? 100000 : (uint32_t)ops;
+	SEXP_t *num = SEXP_number_newu_32(42);
+
+	SEXP_t *list = SEXP_list_new(NULL);
+	bench_start(&clk);
+	for (uint32_t i = 0; i < length; ++i)
+		SEXP_list_add(list, num);
+	bench_report(&clk, "list_add", 1, length);
+
+	volatile size_t sink = 0;
+	bench_start(&clk);
+	for (uint64_t i = 0; i < ops; ++i) {
+		SEXP_t *memb = SEXP_list_nth(list, (uint32_t)(i % length) + 1);
+		sink += (memb != NULL);
+		SEXP_free(memb);
+	}
+	bench_report(&clk, "list_nth", 1, ops);
+
+	bench_start(&clk);
+	for (uint64_t i = 0; i < ops; ++i)
+		sink += SEXP_list_length(list);
+	bench_report(&clk, "list_length", 1, ops);
+
+	SEXP_free(list);
+	SEXP_free(num);
+}
+
+static void bench_deepcmp(uint64_t ops)
+{
+	struct bench_clock clk;
+	SEXP_t *a = bench_item(1), *b = bench_item(1), *c = bench_item(2);
+	volatile int sink = 0;
+
+	bench_start(&clk);
+	for (uint64_t i = 0; i < ops; ++i)
+		sink += SEXP_deepcmp(a, b);
+	bench_report(&clk, "deepcmp_equal", 1, ops);
+
+	bench_start(&clk);
+	for (uint64_t i = 0; i < ops; ++i)
+		sink += SEXP_deepcmp(a, c);
+	bench_report(&clk, "deepcmp_different", 1, ops);
+
+	SEXP_free(a);
+	SEXP_free(b);
+	SEXP_free(c);
+}
+
+static void bench_strings(uint64_t ops)
+{
+	struct bench_clock clk;
+	static const char path[] = "/usr/lib64/libopenscap.so.25.0.0";
+
+	bench_start(&clk);
+	for (uint64_t i = 0; i < ops; ++i)
+		SEXP_free(SEXP_string_new(path, sizeof(path) - 1));
+	bench_report(&clk, "string_new", 1, ops);
+
+	bench_start(&clk);
+	for (uint64_t i = 0; i < ops; ++i)
+		SEXP_free(SEXP_string_newf("%s.%llu", path, (unsigned long long)i));
+	bench_report(&clk, "string_newf", 1, ops);
+
+	bench_start(&clk);
+	for (uint64_t i = 0; i < ops / 16; ++i)
+		SEXP_free(bench_item((uint32_t)i));
+	bench_report(&clk, "item_build", 1, ops / 16);
+}
+
+struct bench_refs_arg {
+	SEXP_t *shared;
+	uint64_t ops;
+};
+
+static void *bench_refs_thread(void *arg)
+{
+	struct bench_refs_arg *refs = arg;
+	SEXP_t *held[64];
+
+	for (uint64_t i = 0; i < refs->ops; i += 64) {
+		for (int j = 0; j < 64; ++j)
+			held[j] = SEXP_ref(refs->shared);
+		for (int j = 0; j < 64; ++j)
+			SEXP_free(held[j]);
+	}
+	return NULL;
+}
+
+/* Reference counting of one shared S-exp from several threads */
+static void bench_refs(uint64_t ops, int max_threads)
+{
+	struct bench_refs_arg arg = { .shared = bench_item(0), .ops = ops };
+	pthread_t threads[max_threads];
+
+	for (int n = 1; n <= max_threads; n *= 2) {
+		struct bench_clock clk;
+		bench_start(&clk);
+		for (int i = 0; i < n; ++i)
+			pthread_create(&threads[i], NULL, bench_refs_thread, &arg);
+		for (int i = 0; i < n; ++i)
+			pthread_join(threads[i], NULL);
+		bench_report(&clk, "ref_free", n, ops * n);
+	}
+	SEXP_free(arg.shared);
+}
+
+/* The probe side of the queue, it returns every S-exp it gets */
+static void *bench_queue_probe(void *arg)
+{
+	SEAP_desc_t *desc = arg;
+
+	for (;;) {
+		SEXP_t *msg = sch_queue_recvsexp(desc);
+		SEXP_t *obj = SEXP_list_first(msg);
+		SEXP_free(msg);
+		if (SEXP_listp(obj) == false) {
+			SEXP_free(obj);
+			break;
+		}
+		sch_queue_sendsexp(desc, obj, 0);
+		SEXP_free(obj);
+	}
+	return NULL;
+}
+
+static int bench_queue_callfn(void *arg, sch_queue_call_t *call)
+{
+	sch_queue_call_done(call, SEXP_ref(call->obj), 0);
+	return 0;
+}
+
+static void bench_queue(uint64_t ops)
+{
+	struct bench_clock clk;
+	sch_queuedata_t data;
+	SEAP_desc_t desc;
+	pthread_t probe;
+	SEXP_t *obj = bench_item(0);
+
+	memset(&data, 0, sizeof(data));
+	memset(&desc, 0, sizeof(desc));
+	data.to_probe_queue = oscap_queue_new();
+	data.from_probe_queue = oscap_queue_new();
+	pthread_cond_init(&data.to_probe_cond, NULL);
+	pthread_mutex_init(&data.to_probe_mutex, NULL);
+	pthread_cond_init(&data.from_probe_cond, NULL);
+	pthread_mutex_init(&data.from_probe_mutex, NULL);
+	pthread_mutex_init(&data.call_mutex, NULL);
+	data.parent_thread_id = pthread_self();
+	desc.scheme = SCH_QUEUE;
+	desc.scheme_data = &data;
+
+	pthread_create(&probe, NULL, bench_queue_probe, &desc);
+	data.probe_thread_id = probe;
+
+	bench_start(&clk);
+	for (uint64_t i = 0; i < ops; ++i) {
+		sch_queue_sendsexp(&desc, obj, 0);
+		SEXP_free(sch_queue_recvsexp(&desc));
+	}
+	bench_report(&clk, "queue_round_trip", 2, ops);
+
+	/* anything but a list stops the probe thread */
+	SEXP_t *stop = SEXP_number_newu_32(0);
+	sch_queue_sendsexp(&desc, stop, 0);
+	SEXP_free(stop);
+	pthread_join(probe, NULL);
+
+	sch_queue_call_register(&data, bench_queue_callfn, NULL);
+	bench_start(&clk);
+	for (uint64_t i = 0; i < ops; ++i) {
+		SEXP_t *cobj = NULL;
+		sch_queue_call_t *call = sch_queue_call(&desc, obj);
+		if (call != NULL)
+			sch_queue_call_wait(call, &cobj);
+		SEXP_free(cobj);
+	}
+	bench_report(&clk, "queue_direct_call", 1, ops);
+
+	oscap_queue_free(data.to_probe_queue, NULL);
+	oscap_queue_free(data.from_probe_queue, NULL);
+	pthread_mutex_destroy(&data.call_mutex);
+	SEXP_free(obj);
+}
+
+int main(int argc, char *argv[])
+{
+	uint64_t ops = 200000;
+	int max_threads = 8;
+	const char *output = NULL;
+	int c;
+
+	while ((c = getopt(argc, argv, "n:t:o:")) != -1) {
+		switch (c) {
+		case 'n':
+			ops = strtoull(optarg, NULL, 10);
+			break;
+		case 't':
+			max_threads = atoi(optarg);
+			break;
+		case 'o':
+			output = optarg;
+			break;
+		default:
+			fprintf(stderr, "Usage: %s [-n ops] [-t max_threads] [-o output]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (ops < 64 || max_threads < 1) {
+		fprintf(stderr, "At least 64 operations and 1 thread are needed.\n");
+		return 1;
+	}
+
+	if (bench_open(output) != 0)
+		return 1;
+
+	bench_list_ops(ops);
+	bench_deepcmp(ops);
+	bench_strings(ops);
+	bench_refs(ops, max_threads);
+	bench_queue(ops / 10);
+
+	bench_close();
+	return 0;
+}
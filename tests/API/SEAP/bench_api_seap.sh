@@ -0,0 +1,20 @@
+#!/usr/bin/env bash
+
+# SEXP and SEAP microbenchmark.
+#
+# Writes one JSON object per measurement to bench_api_seap.json in the
+# build directory, it doesn't compare the results with anything.
+#
+# Environment:
+#   OSCAP_BENCHMARK_SEAP_OPS      operations per measurement (default: 200000)
+#   OSCAP_BENCHMARK_SEAP_THREADS  most threads of the refcount benchmark (default: 8)
+
+. $builddir/tests/test_common.sh
+
+set -e -o pipefail
+
+output="$builddir/tests/API/SEAP/bench_api_seap.json"
+
+./bench_api_seap -n "${OSCAP_BENCHMARK_SEAP_OPS:-200000}" \
+	-t "${OSCAP_BENCHMARK_SEAP_THREADS:-8}" -o "$output"
+cat "$output"
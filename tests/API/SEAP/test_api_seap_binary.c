@@ -0,0 +1,243 @@
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <sexp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+static char *sexp_text(SEXP_t *s_exp)
+{
+	char *text = NULL;
+	size_t size = 0;
+	FILE *fp = open_memstream(&text, &size);
+
+	if (fp == NULL)
+		return NULL;
+
+	SEXP_fprintfa(fp, s_exp);
+	fclose(fp);
+
+	return text;
+}
+
+static SEXP_t *build_sexp(void)
+{
+	SEXP_t *root, *ent, *attrs, *rec, *v, *n, *e;
+	int i;
+
+	root = SEXP_list_new(NULL);
+
+#define ADD(list, expr) do { v = (expr); SEXP_list_add((list), v); SEXP_free(v); } while (0)
+
+	ADD(root, SEXP_number_newb(true));
+	ADD(root, SEXP_number_newb(false));
+	ADD(root, SEXP_number_newi_8(-128));
+	ADD(root, SEXP_number_newu_8(255));
+	ADD(root, SEXP_number_newi_16(-12345));
+	ADD(root, SEXP_number_newu_16(65535));
+	ADD(root, SEXP_number_newi_32(INT32_MIN));
+	ADD(root, SEXP_number_newu_32(UINT32_MAX));
+	ADD(root, SEXP_number_newi_64(INT64_MIN));
+	ADD(root, SEXP_number_newu_64(UINT64_MAX));
+	ADD(root, SEXP_number_newf(-1.5e300));
+	ADD(root, SEXP_string_new("", 0));
+	ADD(root, SEXP_string_new("a\0b", 3));
+
+	e = SEXP_list_new(NULL);
+	SEXP_list_add(root, e);
+	SEXP_free(e);
+
+	/* items with repeating entity names and values */
+	for (i = 0; i < 100; ++i) {
+		n = SEXP_string_newf("%s", "linux:rpminfo_item");
+		attrs = SEXP_list_new(n, NULL);
+		SEXP_free(n);
+		ADD(attrs, SEXP_string_newf(":id"));
+		ADD(attrs, SEXP_number_newu_32(i));
+		ent = SEXP_list_new(attrs, NULL);
+		SEXP_free(attrs);
+
+		n = SEXP_string_newf("name");
+		v = SEXP_string_newf("package-%d", i % 10);
+		rec = SEXP_list_new(n, v, NULL);
+		SEXP_free(n);
+		SEXP_free(v);
+		SEXP_datatype_set(rec, "string");
+		SEXP_list_add(ent, rec);
+		SEXP_free(rec);
+
+		n = SEXP_string_newf("version");
+		v = SEXP_string_newf("%d.%d", i, i * 7);
+		SEXP_datatype_set(v, "evr_string");
+		rec = SEXP_list_new(n, v, NULL);
+		SEXP_free(n);
+		SEXP_free(v);
+		SEXP_list_add(ent, rec);
+		SEXP_free(rec);
+
+		SEXP_list_add(root, ent);
+		SEXP_free(ent);
+	}
+
+	/* deeply nested list */
+	e = SEXP_list_new(NULL);
+	for (i = 0; i < 200; ++i) {
+		SEXP_t *outer = SEXP_list_new(e, NULL);
+		SEXP_free(e);
+		e = outer;
+	}
+	SEXP_list_add(root, e);
+	SEXP_free(e);
+#undef ADD
+
+	return root;
+}
+
+static int check_roundtrip(SEXP_t *s_exp)
+{
+	void *buf;
+	size_t len, i;
+	SEXP_t *dec;
+	char *t1, *t2;
+	int ret = 0;
+
+	if (SEXP_bin_encode(s_exp, &buf, &len) != 0) {
+		printf("encode failed\n");
+		return 1;
+	}
+
+	dec = SEXP_bin_decode(buf, len);
+	if (dec == NULL) {
+		printf("decode failed\n");
+		free(buf);
+		return 1;
+	}
+
+	if (!SEXP_deepcmp(s_exp, dec)) {
+		printf("decoded S-exp differs\n");
+		ret = 1;
+	}
+
+	t1 = sexp_text(s_exp);
+	t2 = sexp_text(dec);
+	if (t1 == NULL || t2 == NULL || strcmp(t1, t2) != 0) {
+		printf("textual form differs:\n%s\n%s\n", t1, t2);
+		ret = 1;
+	}
+	free(t1);
+	free(t2);
+	SEXP_free(dec);
+
+	/* every truncated encoding has to be rejected */
+	for (i = 0; i < len; ++i) {
+		dec = SEXP_bin_decode(buf, i);
+		if (dec != NULL) {
+			printf("truncated encoding of %zu/%zu bytes was accepted\n", i, len);
+			SEXP_free(dec);
+			ret = 1;
+			break;
+		}
+	}
+
+	free(buf);
+	return ret;
+}
+
+static int count_occurrences(const void *buf, size_t len, const char *str)
+{
+	size_t i, slen = strlen(str);
+	int n = 0;
+
+	for (i = 0; i + slen <= len; ++i) {
+		if (memcmp((const char *)buf + i, str, slen) == 0)
+			++n;
+	}
+
+	return n;
+}
+
+static int check_reader(void)
+{
+	SEXP_t *s_exp, *a, *b;
+	SEXP_bin_reader_t *r;
+	SEXP_bin_token_t tok;
+	void *buf;
+	size_t len;
+	int strings = 0, ret = 0;
+
+	a = SEXP_string_newf("repeated");
+	b = SEXP_string_newf("once");
+	s_exp = SEXP_list_new(a, b, a, NULL);
+	SEXP_free(a);
+	SEXP_free(b);
+
+	if (SEXP_bin_encode(s_exp, &buf, &len) != 0) {
+		SEXP_free(s_exp);
+		return 1;
+	}
+	SEXP_free(s_exp);
+
+	r = SEXP_bin_reader_new(buf, len);
+	if (r == NULL) {
+		free(buf);
+		return 1;
+	}
+
+	if (SEXP_bin_reader_next(r, &tok) != 0 || tok.type != SEXP_BIN_LIST || tok.u.list.length != 3)
+		ret = 1;
+
+	while (ret == 0 && SEXP_bin_reader_next(r, &tok) == 0 && tok.type != SEXP_BIN_END) {
+		if (tok.type != SEXP_BIN_STRING) {
+			ret = 1;
+			break;
+		}
+		/* the strings are views into the buffer */
+		if (tok.u.string.str < (const char *)buf || tok.u.string.str + tok.u.string.len > (const char *)buf + len)
+			ret = 1;
+		++strings;
+	}
+
+	if (strings != 3)
+		ret = 1;
+
+	/* "repeated" is stored only once */
+	if (count_occurrences(buf, len, "repeated") != 1)
+		ret = 1;
+
+	SEXP_bin_reader_free(r);
+	free(buf);
+
+	if (ret != 0)
+		printf("reader check failed\n");
+	return ret;
+}
+
+int main (void)
+{
+	SEXP_t *s_exp;
+	int ret = 0;
+	const char garbage[] = "SEXB\001\000\377\377\377\377\377";
+
+	setbuf(stdout, NULL);
+
+	s_exp = build_sexp();
+	ret |= check_roundtrip(s_exp);
+	SEXP_free(s_exp);
+
+	s_exp = SEXP_string_newf("single");
+	ret |= check_roundtrip(s_exp);
+	SEXP_free(s_exp);
+
+	ret |= check_reader();
+
+	if (SEXP_bin_decode(garbage, sizeof garbage - 1) != NULL ||
+	    SEXP_bin_decode("(1 2 3)", 7) != NULL) {
+		printf("invalid encoding was accepted\n");
+		ret = 1;
+	}
+
+	return ret;
+}
@@ -490,5 +490,77 @@ int main (void)
 		SEXP_free(r3);
         }
 
+	{
+		/* length and last member of long and shared lists */
+		SEXP_t *l1, *l2, *l3, *m;
+		uint32_t i;
+
+		l1 = SEXP_list_new(NULL);
+		for (i = 0; i < 10000; ++i) {
+			m = SEXP_number_newu_32(i);
+			SEXP_list_add(l1, m);
+			SEXP_free(m);
+
+			if (SEXP_list_length(l1) != i + 1)
+				return (1);
+			m = SEXP_list_last(l1);
+			if (SEXP_number_getu_32(m) != i)
+				return (1);
+			SEXP_free(m);
+		}
+
+		l2 = SEXP_list_rest(l1);
+		l3 = SEXP_list_rest(l2);
+		if (SEXP_list_length(l2) != 9999 || SEXP_list_length(l3) != 9998)
+			return (1);
+
+		m = SEXP_number_newu_32(10000);
+		SEXP_list_add(l3, m);
+		SEXP_free(m);
+		m = SEXP_number_newu_32(10001);
+		SEXP_list_add(l1, m);
+		SEXP_free(m);
+
+		m = SEXP_list_last(l2);
+		if (SEXP_number_getu_32(m) != 9999)
+			return (1);
+		SEXP_free(m);
+		m = SEXP_list_last(l3);
+		if (SEXP_number_getu_32(m) != 10000)
+			return (1);
+		SEXP_free(m);
+		m = SEXP_list_nth(l3, 1);
+		if (SEXP_number_getu_32(m) != 2)
+			return (1);
+		SEXP_free(m);
+
+		for (i = 0; i < 3; ++i) {
+			m = SEXP_list_pop(l1);
+			if (SEXP_number_getu_32(m) != i)
+				return (1);
+			SEXP_free(m);
+		}
+		if (SEXP_list_length(l1) != 9998)
+			return (1);
+		m = SEXP_list_last(l1);
+		if (SEXP_number_getu_32(m) != 10001)
+			return (1);
+		SEXP_free(m);
+
+		printf("l1=%zu l2=%zu l3=%zu\n", SEXP_list_length(l1),
+		       SEXP_list_length(l2), SEXP_list_length(l3));
+
+		SEXP_free(l1);
+		SEXP_free(l2);
+		SEXP_free(l3);
+
+		l1 = SEXP_list_new(NULL);
+		l2 = SEXP_list_rest(l1);
+		if (SEXP_list_length(l2) != 0 || SEXP_list_last(l2) != NULL)
+			return (1);
+		SEXP_free(l1);
+		SEXP_free(l2);
+	}
+
         return (0);
 }
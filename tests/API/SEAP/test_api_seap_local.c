@@ -0,0 +1,104 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <sexp.h>
+#include <pthread.h>
+
+#ifndef TEST_REF_COUNT
+#define TEST_REF_COUNT 100000
+#endif
+
+/*
+ * The values built inside a SEXP_local_begin/SEXP_local_end window can
+ * be referenced by other threads once the window is closed, both the
+ * result of the window and the values which escaped it. The owning
+ * thread keeps building new values in other windows meanwhile.
+ */
+
+static void *ref_thread(void *arg)
+{
+	SEXP_t *s_exp = arg;
+
+	for (int i = 0; i < TEST_REF_COUNT; i++)
+		SEXP_free(SEXP_ref(s_exp));
+	return NULL;
+}
+
+static int test_shared(SEXP_t *s_exp, const char *what)
+{
+	pthread_t thread;
+
+	if (pthread_create(&thread, NULL, ref_thread, s_exp) != 0) {
+		fprintf(stderr, "Can't create a thread\n");
+		return 1;
+	}
+	for (int i = 0; i < TEST_REF_COUNT; i++) {
+		SEXP_t *tmp;
+
+		SEXP_local_begin();
+		tmp = SEXP_list_new(s_exp, NULL);
+		SEXP_free(SEXP_ref(s_exp));
+		SEXP_free(tmp);
+		SEXP_local_end(NULL);
+	}
+	pthread_join(thread, NULL);
+
+	if (SEXP_refs(s_exp) != 1) {
+		fprintf(stderr, "%s: %u references instead of 1\n", what, SEXP_refs(s_exp));
+		return 1;
+	}
+	return 0;
+}
+
+int main(void)
+{
+	SEXP_t *result, *escaped, *name;
+	int ret = 0;
+
+	SEXP_local_begin();
+	name = SEXP_string_newf("name");
+	escaped = SEXP_number_newu(123);
+	result = SEXP_list_new(name, NULL);
+	SEXP_free(name);
+	SEXP_local_end(result);
+
+	ret |= test_shared(result, "result");
+	ret |= test_shared(escaped, "escaped value");
+
+	/* nothing escapes the nested windows */
+	SEXP_local_begin();
+	SEXP_local_begin();
+	name = SEXP_string_newf("name");
+	SEXP_local_end(name);
+	SEXP_free(result);
+	result = SEXP_list_new(name, NULL);
+	SEXP_free(name);
+	SEXP_local_end(result);
+
+	ret |= test_shared(result, "nested result");
+
+	SEXP_free(result);
+	SEXP_free(escaped);
+	return ret;
+}
@@ -0,0 +1,36 @@
+#!/usr/bin/env bash
+. $builddir/tests/test_common.sh
+
+set -e
+set -o pipefail
+
+name=$(basename $0 .sh)
+dir=$(mktemp -d -t ${name}.XXXXXX)
+result=$(mktemp -t ${name}.out.XXXXXX)
+stderr=$(mktemp -t ${name}.out.XXXXXX)
+
+# The object finds no line, so the first scan stores an object without items.
+# The second scan must not reuse it once a matching line is appended to the
+# file, although the directory holding the file doesn't change.
+mkdir $dir/etc
+echo "PermitRootLogin no" > $dir/etc/sshd_config
+sed "s|DIRECTORY|$dir/etc|" $srcdir/${name}.oval.xml > $dir/${name}.oval.xml
+cp $srcdir/${name}.xccdf.xml $dir/
+# files changed just before the scan are never stored
+sleep 3
+
+$OSCAP xccdf eval --incremental $dir/state --results $result $dir/${name}.xccdf.xml 2> $stderr
+[ -f $stderr ]; [ ! -s $stderr ]
+[ -s $dir/state ]
+assert_exists 1 '//rule-result/result[text()="pass"]'
+
+echo "PermitRootLogin yes" >> $dir/etc/sshd_config
+
+ret=0
+$OSCAP xccdf eval --incremental $dir/state --results $result $dir/${name}.xccdf.xml 2> $stderr || ret=$?
+[ $ret -eq 2 ]
+[ -f $stderr ]; [ ! -s $stderr ]
+assert_exists 1 '//rule-result/result[text()="fail"]'
+
+rm -rf $dir
+rm $result $stderr
@@ -234,6 +234,157 @@ static void _test_hit_multiple_items1(void)
 	oscap_htable_free0(h);
 }
 
+#define HTABLE_LEN 1000
+
+static void _test_htable_add_get(void)
+{
+	static const char *value = "openscap!";
+	struct oscap_htable *h = oscap_htable_new();
+	oscap_assert(oscap_htable_get(h, "id-12345") == NULL);
+	oscap_assert(oscap_htable_add(h, "id-12345", (char *) value));
+	oscap_assert(oscap_htable_get(h, "id-12345") == value);
+	oscap_assert(oscap_htable_get(h, "id-1234") == NULL);
+	// a key is added only once, the first item is kept
+	oscap_assert(!oscap_htable_add(h, "id-12345", NULL));
+	oscap_assert(oscap_htable_get(h, "id-12345") == value);
+	oscap_assert(!oscap_htable_add(h, NULL, NULL));
+	oscap_assert(oscap_htable_itemcount(h) == 1);
+	oscap_htable_free0(h);
+}
+
+static void _test_htable_detach(void)
+{
+	int values[3] = {0, 1, 2};
+	struct oscap_htable *h = oscap_htable_new1(_htable_cmp, 1);
+	oscap_assert(oscap_htable_add(h, "a", &values[0]));
+	oscap_assert(oscap_htable_add(h, "b", &values[1]));
+	oscap_assert(oscap_htable_add(h, "c", &values[2]));
+
+	// middle, last and first item
+	oscap_assert(oscap_htable_detach(h, "b") == &values[1]);
+	oscap_assert(oscap_htable_detach(h, "b") == NULL);
+	oscap_assert(oscap_htable_get(h, "b") == NULL);
+	oscap_assert(oscap_htable_itemcount(h) == 2);
+	oscap_assert(oscap_htable_detach(h, "c") == &values[2]);
+	oscap_assert(oscap_htable_get(h, "a") == &values[0]);
+	oscap_assert(oscap_htable_detach(h, "a") == &values[0]);
+	oscap_assert(oscap_htable_itemcount(h) == 0);
+	oscap_assert(oscap_htable_detach(h, "missing") == NULL);
+	oscap_assert(oscap_htable_detach(h, NULL) == NULL);
+
+	struct oscap_htable_iterator *hit = oscap_htable_iterator_new(h);
+	oscap_assert(!oscap_htable_iterator_has_more(hit));
+	oscap_htable_iterator_free(hit);
+
+	// a detached key can be added again
+	oscap_assert(oscap_htable_add(h, "b", &values[2]));
+	oscap_assert(oscap_htable_get(h, "b") == &values[2]);
+	oscap_assert(oscap_htable_itemcount(h) == 1);
+	oscap_htable_free0(h);
+}
+
+static void _test_htable_grow(void)
+{
+	static int values[HTABLE_LEN];
+	char key[12];
+	struct oscap_htable *h = oscap_htable_new1(_htable_cmp, 1);
+	for (int i = 0; i < HTABLE_LEN; i++) {
+		snprintf(key, sizeof(key), "%d", i);
+		oscap_assert(oscap_htable_add(h, key, &values[i]));
+	}
+	oscap_assert(oscap_htable_itemcount(h) == HTABLE_LEN);
+	for (int i = 0; i < HTABLE_LEN; i++) {
+		snprintf(key, sizeof(key), "%d", i);
+		oscap_assert(oscap_htable_get(h, key) == &values[i]);
+	}
+
+	// the detached items don't stay in the table
+	for (int i = 0; i < HTABLE_LEN; i += 2) {
+		snprintf(key, sizeof(key), "%d", i);
+		oscap_assert(oscap_htable_detach(h, key) == &values[i]);
+	}
+	oscap_assert(oscap_htable_itemcount(h) == HTABLE_LEN / 2);
+	for (int i = 0; i < HTABLE_LEN; i++) {
+		snprintf(key, sizeof(key), "%d", i);
+		oscap_assert(oscap_htable_get(h, key) == (i % 2 ? &values[i] : NULL));
+	}
+	oscap_htable_free0(h);
+}
+
+static void _test_htable_iterate_in_order(void)
+{
+	static int values[HTABLE_LEN];
+	char key[12];
+	struct oscap_htable *h = oscap_htable_new();
+	for (int i = HTABLE_LEN - 1; i >= 0; i--) {
+		snprintf(key, sizeof(key), "%d", i);
+		oscap_assert(oscap_htable_add(h, key, &values[i]));
+	}
+	oscap_assert(oscap_htable_detach(h, "500") == &values[500]);
+	oscap_assert(oscap_htable_add(h, "500", &values[500]));
+
+	// the items come in the order they were added, whatever the buckets
+	struct oscap_htable_iterator *hit = oscap_htable_iterator_new(h);
+	for (int round = 0; round < 2; round++) {
+		int i = HTABLE_LEN - 1;
+		while (oscap_htable_iterator_has_more(hit)) {
+			const char *k;
+			void *v;
+			oscap_htable_iterator_next_kv(hit, &k, &v);
+			if (i == 500)
+				--i;
+			if (i < 0) {
+				oscap_assert(strcmp(k, "500") == 0 && v == &values[500]);
+			} else {
+				snprintf(key, sizeof(key), "%d", i);
+				oscap_assert(strcmp(k, key) == 0 && v == &values[i]);
+			}
+			--i;
+		}
+		oscap_assert(i == -2);
+		oscap_htable_iterator_reset(hit);
+	}
+	oscap_htable_iterator_free(hit);
+
+	// detaching the item just returned doesn't break the iteration
+	hit = oscap_htable_iterator_new(h);
+	int count = 0;
+	while (oscap_htable_iterator_has_more(hit)) {
+		const char *k = oscap_htable_iterator_next_key(hit);
+		snprintf(key, sizeof(key), "%s", k);
+		oscap_assert(oscap_htable_detach(h, key) != NULL);
+		count++;
+	}
+	oscap_htable_iterator_free(hit);
+	oscap_assert(count == HTABLE_LEN);
+	oscap_assert(oscap_htable_itemcount(h) == 0);
+	oscap_htable_free0(h);
+}
+
+static char *_htable_clone_value(const char *value)
+{
+	return oscap_strdup(value);
+}
+
+static void _test_htable_clone(void)
+{
+	struct oscap_htable *h = oscap_htable_new();
+	oscap_assert(oscap_htable_add(h, "z", "1"));
+	oscap_assert(oscap_htable_add(h, "a", "2"));
+	oscap_assert(oscap_htable_add(h, "m", "3"));
+	oscap_assert(oscap_htable_detach(h, "a") != NULL);
+
+	struct oscap_htable *clone = oscap_htable_clone(h, (oscap_clone_func) _htable_clone_value);
+	oscap_assert(oscap_htable_itemcount(clone) == 2);
+	struct oscap_htable_iterator *hit = oscap_htable_iterator_new(clone);
+	oscap_assert(strcmp(oscap_htable_iterator_next_key(hit), "z") == 0);
+	oscap_assert(strcmp(oscap_htable_iterator_next_value(hit), "3") == 0);
+	oscap_assert(!oscap_htable_iterator_has_more(hit));
+	oscap_htable_iterator_free(hit);
+	oscap_htable_free(clone, free);
+	oscap_htable_free0(h);
+}
+
 static bool _test_list_remove_ptreq(void *a, void *b)
 {
 	return a == b;
@@ -315,6 +466,45 @@ static void _test_list_remove(void)
 	oscap_list_free(list, NULL);
 }
 
+static bool _test_list_find_cmp(void *item, void *what)
+{
+	return *(int *)item == *(int *)what;
+}
+
+static void _test_list_foreach(void)
+{
+	int values[] = {1, 2, 3, 2};
+	int two = 2, five = 5;
+	struct oscap_list *list = oscap_list_new();
+	int *value = NULL;
+	int count = 0;
+
+	OSCAP_LIST_FOREACH(value, list)
+		++count;
+	oscap_assert(count == 0);
+
+	for (int i = 0; i < 4; i++)
+		oscap_assert(oscap_list_add(list, &values[i]));
+	OSCAP_LIST_FOREACH(value, list)
+		oscap_assert(value == &values[count++]);
+	oscap_assert(count == 4);
+
+	// breaking out leaves the item found
+	count = 0;
+	OSCAP_LIST_FOREACH(value, list) {
+		++count;
+		if (*value == 2)
+			break;
+	}
+	oscap_assert(count == 2 && value == &values[1]);
+
+	// the first matching item is found
+	oscap_assert(oscap_list_find(list, &two, (oscap_cmp_func)_test_list_find_cmp) == &values[1]);
+	oscap_assert(oscap_list_find(list, &five, (oscap_cmp_func)_test_list_find_cmp) == NULL);
+
+	oscap_list_free(list, NULL);
+}
+
 int main(int argc, char *argv[])
 {
 	_test_first_item_is_not_skipped();
@@ -329,7 +519,14 @@ int main(int argc, char *argv[])
 	_test_hit_single_item1();
 	_test_hit_multiple_items1();
 
+	_test_htable_add_get();
+	_test_htable_detach();
+	_test_htable_grow();
+	_test_htable_iterate_in_order();
+	_test_htable_clone();
+
 	_test_list_remove();
+	_test_list_foreach();
 
 	return 0;
 }
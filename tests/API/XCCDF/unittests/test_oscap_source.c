@@ -0,0 +1,182 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include "oscap.h"
+#include "oscap_error.h"
+#include "oscap_source.h"
+
+/* no XML declaration, the content differs from a dump of the document */
+#define BENCHMARK "<Benchmark xmlns=\"http://checklists.nist.gov/xccdf/1.2\" id=\"xccdf_org.open-scap_benchmark_test\">  <!-- kept -->  </Benchmark>\n"
+
+static char tmp[PATH_MAX], benchmark[PATH_MAX], empty[PATH_MAX];
+
+static int write_file(const char *path, const char *content)
+{
+	FILE *fp = fopen(path, "w");
+
+	if (fp == NULL)
+		return -1;
+	fputs(content, fp);
+	return fclose(fp);
+}
+
+static int setup(void)
+{
+	strcpy(tmp, "/tmp/test_oscap_source.XXXXXX");
+	if (mkdtemp(tmp) == NULL)
+		return -1;
+	snprintf(benchmark, sizeof(benchmark), "%s/benchmark.xml", tmp);
+	snprintf(empty, sizeof(empty), "%s/empty.xml", tmp);
+	if (write_file(benchmark, BENCHMARK) != 0 || write_file(empty, "") != 0)
+		return -1;
+	return 0;
+}
+
+static void cleanup(void)
+{
+	remove(benchmark);
+	remove(empty);
+	rmdir(tmp);
+}
+
+/* the raw memory is a copy of the exact content of the source */
+static int check_raw_memory(struct oscap_source *source, const char *content, size_t size, const char *what)
+{
+	char *buffer = NULL;
+	size_t buffer_size = 0;
+	int ret = 0;
+
+	for (int round = 0; round < 2 && ret == 0; round++) {
+		if (oscap_source_get_raw_memory(source, &buffer, &buffer_size) != 0) {
+			fprintf(stderr, "%s: can't get the raw memory\n", what);
+			return 1;
+		}
+		if (buffer_size != size || memcmp(buffer, content, size) != 0) {
+			fprintf(stderr, "%s: %zu bytes of raw memory differ from the %zu bytes of content\n",
+				what, buffer_size, size);
+			ret = 1;
+		}
+		/* the caller owns the buffer, the source keeps its content */
+		memset(buffer, 'x', buffer_size);
+		free(buffer);
+	}
+	return ret;
+}
+
+static int test_file(void)
+{
+	struct oscap_source *source = oscap_source_new_from_file(benchmark);
+	int ret = 0;
+
+	ret |= check_raw_memory(source, BENCHMARK, strlen(BENCHMARK), "file");
+	if (oscap_source_get_scap_type(source) != OSCAP_DOCUMENT_XCCDF) {
+		fprintf(stderr, "file: not detected as XCCDF\n");
+		ret = 1;
+	}
+	ret |= check_raw_memory(source, BENCHMARK, strlen(BENCHMARK), "parsed file");
+	oscap_source_free(source);
+	return ret;
+}
+
+/* the clone keeps the shared content when the original is gone */
+static int test_file_clone(void)
+{
+	struct oscap_source *source = oscap_source_new_from_file(benchmark);
+	struct oscap_source *clone = oscap_source_clone(source);
+	int ret = 0;
+
+	oscap_source_free(source);
+	if (oscap_source_get_scap_type(clone) != OSCAP_DOCUMENT_XCCDF) {
+		fprintf(stderr, "file clone: not detected as XCCDF\n");
+		ret = 1;
+	}
+	ret |= check_raw_memory(clone, BENCHMARK, strlen(BENCHMARK), "file clone");
+	if (strcmp(oscap_source_readable_origin(clone), benchmark) != 0) {
+		fprintf(stderr, "file clone: originates from %s\n", oscap_source_readable_origin(clone));
+		ret = 1;
+	}
+	oscap_source_free(clone);
+	return ret;
+}
+
+/* binary content is not cut at the first NUL byte */
+static int test_memory_clone(void)
+{
+	const char content[] = {'a', 'b', '\0', 'c', 'd'};
+	struct oscap_source *source = oscap_source_new_from_memory(content, sizeof(content), "binary");
+	struct oscap_source *clone = oscap_source_clone(source);
+	int ret = 0;
+
+	oscap_source_free(source);
+	ret |= check_raw_memory(clone, content, sizeof(content), "memory clone");
+	oscap_source_free(clone);
+	return ret;
+}
+
+/* an empty file has no content to be mapped */
+static int test_empty(void)
+{
+	struct oscap_source *source = oscap_source_new_from_file(empty);
+	struct oscap_source *clone = oscap_source_clone(source);
+	char *buffer = NULL;
+	size_t size = 0;
+	int ret = 0;
+
+	if (oscap_source_get_scap_type(clone) != OSCAP_DOCUMENT_UNKNOWN) {
+		fprintf(stderr, "empty file: detected as a document\n");
+		ret = 1;
+	}
+	if (oscap_source_get_raw_memory(source, &buffer, &size) == 0) {
+		fprintf(stderr, "empty file: %zu bytes of raw memory\n", size);
+		free(buffer);
+		ret = 1;
+	}
+	oscap_clearerr();
+	oscap_source_free(clone);
+	oscap_source_free(source);
+	return ret;
+}
+
+int main(void)
+{
+	int ret = 0;
+
+	if (setup() != 0) {
+		fprintf(stderr, "Can't create the test files\n");
+		cleanup();
+		return 1;
+	}
+
+	ret |= test_file();
+	ret |= test_file_clone();
+	ret |= test_memory_clone();
+	ret |= test_empty();
+
+	cleanup();
+	return ret;
+}
@@ -0,0 +1,26 @@
+#!/usr/bin/env bash
+. $builddir/tests/test_common.sh
+
+touch not_executable
+
+set -e
+set -o pipefail
+
+name=$(basename $0 .sh)
+content=$srcdir/test_multiple_oval_files_with_same_basename.xccdf.xml
+
+result=$(mktemp -t ${name}.out.XXXXXX)
+stderr=$(mktemp -t ${name}.out.XXXXXX)
+
+# Both OVAL files define the same file_object, the second one is served
+# from the session-wide collected object cache.
+$OSCAP xccdf eval --verbose INFO --results $result $content 2> $stderr
+grep -q "was already collected, using the cached result" $stderr
+
+$OSCAP xccdf validate --skip-schematron $result
+
+assert_exists 8 '//rule-result/result[text()="pass"]'
+assert_exists 1 '//TestResult/score[@system="urn:xccdf:scoring:default"][text()="100.000000"]'
+
+rm $result $stderr
+rm not_executable
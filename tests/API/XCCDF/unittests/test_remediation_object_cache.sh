@@ -0,0 +1,25 @@
+#!/usr/bin/env bash
+. $builddir/tests/test_common.sh
+
+set -e
+set -o pipefail
+
+name=$(basename $0 .sh)
+result=$(mktemp -t ${name}.out.XXXXXX)
+stderr=$(mktemp -t ${name}.out.XXXXXX)
+
+# The check run before the fix collects the file without the fixed line,
+# the check verifying the fix must collect the file again.
+echo broken > test_file_object_cache
+
+$OSCAP xccdf eval --remediate --results $result $srcdir/${name}.xccdf.xml 2> $stderr
+[ -f $stderr ]; [ ! -s $stderr ]; rm $stderr
+
+$OSCAP xccdf validate --skip-schematron $result
+
+assert_exists 1 '//rule-result'
+assert_exists 1 '//rule-result/result[text()="fixed"]'
+assert_exists 1 '//score[text()="100.000000"]'
+
+rm test_file_object_cache
+rm $result
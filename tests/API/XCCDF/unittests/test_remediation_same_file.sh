@@ -0,0 +1,26 @@
+#!/usr/bin/env bash
+. $builddir/tests/test_common.sh
+
+set -e
+set -o pipefail
+
+name=$(basename $0 .sh)
+result=$(mktemp -t ${name}.out.XXXXXX)
+stderr=$(mktemp -t ${name}.out.XXXXXX)
+
+# Both fixes append a line to the same file. The check verifying the first
+# fix reads the file, the check verifying the second one must not be
+# answered from what the probes have read before the second fix.
+echo broken > test_file_same_file
+
+$OSCAP xccdf eval --remediate --results $result $srcdir/${name}.xccdf.xml 2> $stderr
+[ -f $stderr ]; [ ! -s $stderr ]; rm $stderr
+
+$OSCAP xccdf validate --skip-schematron $result
+
+assert_exists 2 '//rule-result'
+assert_exists 2 '//rule-result/result[text()="fixed"]'
+assert_exists 1 '//score[text()="100.000000"]'
+
+rm test_file_same_file
+rm $result
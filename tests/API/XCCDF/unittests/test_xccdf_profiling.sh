@@ -0,0 +1,29 @@
+#!/usr/bin/env bash
+. $builddir/tests/test_common.sh
+
+touch not_executable
+
+set -e
+set -o pipefail
+
+name=$(basename $0 .sh)
+content=$srcdir/test_multiple_oval_files_with_same_basename.xccdf.xml
+
+result=$(mktemp -t ${name}.out.XXXXXX)
+stderr=$(mktemp -t ${name}.out.XXXXXX)
+profiling=$(mktemp -t ${name}.json.XXXXXX)
+
+# The evaluation profile lists the collected objects, the evaluated
+# tests and the evaluated rules.
+$OSCAP xccdf eval --profiling $profiling --results $result $content 2> $stderr
+[ -f $stderr ]; [ ! -s $stderr ]
+
+assert_exists 8 '//rule-result/result[text()="pass"]'
+
+grep -q '"objects": {' $profiling
+grep -q '"oval:moc.elpmaxe.www:obj:1": {"probe": "file", "count": 1,' $profiling
+grep -q '"oval:moc.elpmaxe.www:tst:1": {"count": ' $profiling
+grep -q '"xccdf_moc.elpmaxe.www_rule_1": {"count": 1,' $profiling
+
+rm $result $stderr $profiling
+rm not_executable
@@ -0,0 +1,360 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Cost of the comparators of OVAL values: the results side (oval_*_cmp,
+ * used when states are evaluated) and the probe side (probe_ent_cmp_*,
+ * used to filter collected items by the object entities). Results are
+ * written as described in bench_common.h.
+ *
+ * Usage: bench_cmp [-n ops] [-e evr_file] [-o output]
+ *
+ * evr_file has one EVR string per line, e.g. the output of
+ *   rpm -qa --qf '%{EPOCHNUM}:%{VERSION}-%{RELEASE}\n'
+ * a built-in list is used without it.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include "sexp.h"
+#include "probe-api.h"
+#include "entcmp.h"
+#include "oval_cmp_impl.h"
+#include "oval_cmp_basic_impl.h"
+#include "oval_cmp_evr_string_impl.h"
+#include "oval_cmp_ip_address_impl.h"
+#include "bench_common.h"
+
+static const char *bench_evr_builtin[] = {
+	"0:2.34-60.el9", "0:2.34-60.el9_2.7", "0:2.34-83.el9_3.12", "0:1.1.1k-7.el8_6",
+	"1:1.1.1k-9.el8_7", "1:3.0.7-16.el9_2", "1:3.0.7-24.el9", "0:5.14.0-70.13.1.el9_0",
+	"0:5.14.0-284.11.1.el9_2", "0:5.14.0-362.8.1.el9_3", "0:4.16.1.3-22.el9", "0:4.16.1.3-25.el9",
+	"0:8.7p1-34.el9", "0:8.7p1-34.el9_3.3", "2:9.0.2081-1.el9", "2:8.2.2637-20.el9_1",
+	"0:252-14.el9_2.3", "0:252-18.el9", "0:1.12.20-7.el9_1", "0:2.9.13-5.el9_2",
+	"0:7.76.1-26.el9_3.2", "0:7.76.1-23.el9_2.4", "0:3.9.16-1.el9_2.2", "0:3.9.18-1.el9_3.1",
+	"0:1.20.1-26.el9", "0:1.20.1-27.el9", "0:9.18-2.el9", "32:9.16.23-11.el9_2.2",
+	"0:2.02-149.el9", "1:2.06-70.el9_3.2", "0:4.8.1-1.el9", "0:0.9.9-10.el9",
+	"0:20230209-13.el9", "0:1.0.5-12.el9", "0:3.2.1-1.fc38", "0:3.2.1~rc1-1.fc38",
+	"0:1.0^git20230101.abcdef-1.fc39", "0:1.0-0.1.beta2.fc39", "0:10.0.0-1.fc40", "0:9.99-999.fc40",
+};
+
+static const char *bench_debian_evr[] = {
+	"2.36-9+deb12u4", "2.36-9+deb12u7", "1:2.34-0ubuntu3.2", "1:2.35-0ubuntu3.6",
+	"3.0.11-1~deb12u2", "3.0.2-0ubuntu1.15", "1:9.2p1-2+deb12u2", "1:8.9p1-3ubuntu0.6",
+	"252.22-1~deb12u1", "249.11-0ubuntu3.12", "7.88.1-10+deb12u5", "7.81.0-1ubuntu1.15",
+	"1.22.1~rc1-1", "1.22.1-1", "2:1.0-1", "0.9.8+dfsg-1",
+};
+
+static const char *bench_versions[] = {
+	"1.0", "1.0.1", "1.2.3.4", "2.4.57", "2.4.58", "10.0.0", "9.99.99", "3.11.4",
+	"5.14.0", "6.5.12", "1.1.1", "3.0.7", "0.9.9.10", "20230209", "4.16.1.3", "252",
+};
+
+static const char *bench_paths[] = {
+	"/usr/bin/bash", "/usr/sbin/sshd", "/etc/ssh/sshd_config", "/usr/lib64/libc.so.6",
+	"/usr/share/doc/openssh/README", "/var/log/messages", "/usr/libexec/openssh/sftp-server",
+	"/etc/security/pwquality.conf", "/usr/bin/python3.9", "/usr/lib/systemd/system/sshd.service",
+};
+
+struct bench_corpus {
+	char **items;
+	size_t count;
+};
+
+static void bench_corpus_builtin(struct bench_corpus *corpus, const char **items, size_t count)
+{
+	corpus->items = malloc(count * sizeof(char *));
+	for (size_t i = 0; i < count; ++i)
+		corpus->items[i] = strdup(items[i]);
+	corpus->count = count;
+}
+
+static int bench_corpus_load(struct bench_corpus *corpus, const char *path)
+{
+	FILE *fp = fopen(path, "r");
+	char line[256];
+	size_t size = 0;
+
+	if (fp == NULL) {
+		perror(path);
+		return -1;
+	}
+	corpus->items = NULL;
+	corpus->count = 0;
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		line[strcspn(line, "\r\n")] = '\0';
+		if (line[0] == '\0')
+			continue;
+		if (corpus->count == size) {
+			size = size ? size * 2 : 256;
+			corpus->items = realloc(corpus->items, size * sizeof(char *));
+		}
+		corpus->items[corpus->count++] = strdup(line);
+	}
+	fclose(fp);
+	return corpus->count > 1 ? 0 : -1;
+}
+
+static void bench_corpus_free(struct bench_corpus *corpus)
+{
+	for (size_t i = 0; i < corpus->count; ++i)
+		free(corpus->items[i]);
+	free(corpus->items);
+}
+
+/* Both operands change from one comparison to the next one */
+#define BENCH_PAIR(corpus, i) \
+	(corpus)->items[(i) % (corpus)->count], (corpus)->items[((i) * 7 + 1) % (corpus)->count]
+
+typedef oval_result_t (*bench_str_cmp_fn)(const char *state, const char *sys, oval_operation_t op);
+typedef oval_result_t (*bench_ent_cmp_fn)(SEXP_t *val1, SEXP_t *val2, oval_operation_t op);
+
+static volatile int bench_sink;
+
+static void bench_str(const char *name, bench_str_cmp_fn cmp, const struct bench_corpus *corpus,
+		      oval_operation_t op, uint64_t ops)
+{
+	struct bench_clock clk;
+
+	bench_start(&clk);
+	for (uint64_t i = 0; i < ops; ++i)
+		bench_sink += cmp(BENCH_PAIR(corpus, i), op);
+	bench_report(&clk, name, 1, ops);
+}
+
+static void bench_ent(const char *name, bench_ent_cmp_fn cmp, const struct bench_corpus *corpus,
+		      oval_operation_t op, uint64_t ops)
+{
+	struct bench_clock clk;
+	SEXP_t **vals = malloc(corpus->count * sizeof(SEXP_t *));
+
+	for (size_t i = 0; i < corpus->count; ++i)
+		vals[i] = SEXP_string_newf("%s", corpus->items[i]);
+
+	bench_start(&clk);
+	for (uint64_t i = 0; i < ops; ++i)
+		bench_sink += cmp(vals[i % corpus->count], vals[(i * 7 + 1) % corpus->count], op);
+	bench_report(&clk, name, 1, ops);
+
+	for (size_t i = 0; i < corpus->count; ++i)
+		SEXP_free(vals[i]);
+	free(vals);
+}
+
+static oval_result_t bench_ipv4_cmp(const char *state, const char *sys, oval_operation_t op)
+{
+	return oval_ipaddr_cmp(AF_INET, state, sys, op);
+}
+
+static oval_result_t bench_ipv6_cmp(const char *state, const char *sys, oval_operation_t op)
+{
+	return oval_ipaddr_cmp(AF_INET6, state, sys, op);
+}
+
+/* States are CIDR blocks and the collected values are addresses */
+static void bench_ipaddr(uint64_t ops)
+{
+	struct bench_clock clk;
+	char state[64], sys[64];
+	struct oval_cmp_operand operand;
+
+	bench_start(&clk);
+	for (uint64_t i = 0; i < ops; ++i) {
+		snprintf(state, sizeof(state), "10.%u.0.0/%u", (unsigned)(i % 64), 16 + (unsigned)(i % 9));
+		snprintf(sys, sizeof(sys), "10.%u.%u.%u", (unsigned)((i * 7) % 64), (unsigned)(i % 256), (unsigned)((i / 256) % 256));
+		bench_sink += bench_ipv4_cmp(state, sys, OVAL_OPERATION_SUBSET_OF);
+	}
+	bench_report(&clk, "ipv4_subset_of", 1, ops);
+
+	bench_start(&clk);
+	for (uint64_t i = 0; i < ops; ++i) {
+		snprintf(state, sizeof(state), "fd00:%x::/%u", (unsigned)(i % 64), 32 + (unsigned)(i % 33));
+		snprintf(sys, sizeof(sys), "fd00:%x::%x:%x", (unsigned)((i * 7) % 64), (unsigned)(i % 65536), (unsigned)(i / 65536));
+		bench_sink += bench_ipv6_cmp(state, sys, OVAL_OPERATION_SUBSET_OF);
+	}
+	bench_report(&clk, "ipv6_subset_of", 1, ops);
+
+	/* the state decoded once, as oval_result_test does for each state entity */
+	strcpy(state, "10.0.0.0/8");
+	oval_cmp_operand_init(&operand, state, OVAL_DATATYPE_IPV4ADDR, OVAL_OPERATION_SUBSET_OF);
+	bench_start(&clk);
+	for (uint64_t i = 0; i < ops; ++i) {
+		snprintf(sys, sizeof(sys), "%u.%u.%u.%u", 8 + (unsigned)(i % 4), (unsigned)(i % 256), (unsigned)((i / 256) % 256), 1);
+		bench_sink += oval_cmp_operand_cmp_str(&operand, sys);
+	}
+	bench_report(&clk, "ipv4_subset_of_operand", 1, ops);
+
+	/* probe side, an object entity with the ipv4_address datatype */
+	SEXP_t *val = SEXP_string_newf("10.0.0.0/8");
+	SEXP_t *op_val = SEXP_number_newu_32(OVAL_OPERATION_SUBSET_OF);
+	SEXP_t *attrs = probe_attr_creat("operation", op_val, NULL);
+	SEXP_t *ent = probe_ent_creat1("address", attrs, val);
+	probe_ent_setdatatype(ent, OVAL_DATATYPE_IPV4ADDR);
+	bench_start(&clk);
+	for (uint64_t i = 0; i < ops; ++i) {
+		SEXP_t *item_val = SEXP_string_newf("%u.%u.%u.1", 8 + (unsigned)(i % 4), (unsigned)(i % 256), (unsigned)((i / 256) % 256));
+		bench_sink += probe_entobj_cmp(ent, item_val);
+		SEXP_free(item_val);
+	}
+	bench_report(&clk, "probe_ipv4_subset_of", 1, ops);
+	SEXP_free(ent);
+	SEXP_free(attrs);
+	SEXP_free(op_val);
+	SEXP_free(val);
+}
+
+static void bench_numbers(uint64_t ops)
+{
+	struct bench_clock clk;
+	struct oval_cmp_operand operand;
+	char state[] = "4096", fstate[] = "0.75";
+	char sys[32];
+
+	bench_start(&clk);
+	for (uint64_t i = 0; i < ops; ++i)
+		bench_sink += oval_int_cmp((intmax_t)(i % 8192), (intmax_t)((i * 7) % 8192), OVAL_OPERATION_LESS_THAN);
+	bench_report(&clk, "int", 1, ops);
+
+	bench_start(&clk);
+	for (uint64_t i = 0; i < ops; ++i) {
+		snprintf(sys, sizeof(sys), "%u", (unsigned)(i % 8192));
+		bench_sink += oval_str_cmp_str(state, OVAL_DATATYPE_INTEGER, sys, OVAL_OPERATION_LESS_THAN);
+	}
+	bench_report(&clk, "int_str", 1, ops);
+
+	oval_cmp_operand_init(&operand, state, OVAL_DATATYPE_INTEGER, OVAL_OPERATION_LESS_THAN);
+	bench_start(&clk);
+	for (uint64_t i = 0; i < ops; ++i) {
+		snprintf(sys, sizeof(sys), "%u", (unsigned)(i % 8192));
+		bench_sink += oval_cmp_operand_cmp_str(&operand, sys);
+	}
+	bench_report(&clk, "int_str_operand", 1, ops);
+
+	bench_start(&clk);
+	for (uint64_t i = 0; i < ops; ++i) {
+		snprintf(sys, sizeof(sys), "%u.%02u", (unsigned)(i % 2), (unsigned)(i % 100));
+		bench_sink += oval_str_cmp_str(fstate, OVAL_DATATYPE_FLOAT, sys, OVAL_OPERATION_GREATER_THAN);
+	}
+	bench_report(&clk, "float_str", 1, ops);
+
+	SEXP_t *ste = SEXP_number_newi_64(4096);
+	bench_start(&clk);
+	for (uint64_t i = 0; i < ops; ++i) {
+		SEXP_t *itm = SEXP_number_newi_64((int64_t)(i % 8192));
+		bench_sink += probe_ent_cmp_int(ste, itm, OVAL_OPERATION_LESS_THAN);
+		SEXP_free(itm);
+	}
+	bench_report(&clk, "probe_int", 1, ops);
+	SEXP_free(ste);
+}
+
+static void bench_strings(uint64_t ops)
+{
+	struct bench_corpus paths;
+	char pattern[] = "^/usr/(s)?bin/[^/]+$";
+	SEXP_t *pattern_val = SEXP_string_newf("%s", pattern);
+	SEXP_t **vals;
+	struct bench_clock clk;
+
+	bench_corpus_builtin(&paths, bench_paths, sizeof(bench_paths) / sizeof(bench_paths[0]));
+	bench_str("string_equals", oval_string_cmp, &paths, OVAL_OPERATION_EQUALS, ops);
+
+	bench_start(&clk);
+	for (uint64_t i = 0; i < ops; ++i)
+		bench_sink += oval_string_cmp(pattern, paths.items[i % paths.count], OVAL_OPERATION_PATTERN_MATCH);
+	bench_report(&clk, "string_pattern_match", 1, ops);
+
+	vals = malloc(paths.count * sizeof(SEXP_t *));
+	for (size_t i = 0; i < paths.count; ++i)
+		vals[i] = SEXP_string_newf("%s", paths.items[i]);
+	bench_start(&clk);
+	for (uint64_t i = 0; i < ops; ++i)
+		bench_sink += probe_ent_cmp_string(pattern_val, vals[i % paths.count], OVAL_OPERATION_PATTERN_MATCH);
+	bench_report(&clk, "probe_string_pattern_match", 1, ops);
+
+	for (size_t i = 0; i < paths.count; ++i)
+		SEXP_free(vals[i]);
+	free(vals);
+	SEXP_free(pattern_val);
+	bench_corpus_free(&paths);
+}
+
+int main(int argc, char *argv[])
+{
+	uint64_t ops = 200000;
+	const char *evr_file = NULL, *output = NULL;
+	struct bench_corpus evr, debian_evr, versions;
+	int c;
+
+	while ((c = getopt(argc, argv, "n:e:o:")) != -1) {
+		switch (c) {
+		case 'n':
+			ops = strtoull(optarg, NULL, 10);
+			break;
+		case 'e':
+			evr_file = optarg;
+			break;
+		case 'o':
+			output = optarg;
+			break;
+		default:
+			fprintf(stderr, "Usage: %s [-n ops] [-e evr_file] [-o output]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	if (evr_file != NULL) {
+		if (bench_corpus_load(&evr, evr_file) != 0) {
+			fprintf(stderr, "Can't read EVR strings from '%s'.\n", evr_file);
+			return 1;
+		}
+	} else {
+		bench_corpus_builtin(&evr, bench_evr_builtin, sizeof(bench_evr_builtin) / sizeof(bench_evr_builtin[0]));
+	}
+	bench_corpus_builtin(&debian_evr, bench_debian_evr, sizeof(bench_debian_evr) / sizeof(bench_debian_evr[0]));
+	bench_corpus_builtin(&versions, bench_versions, sizeof(bench_versions) / sizeof(bench_versions[0]));
+
+	if (bench_open(output) != 0)
+		return 1;
+
+	bench_str("evr_string_equals", oval_evr_string_cmp, &evr, OVAL_OPERATION_EQUALS, ops);
+	bench_str("evr_string_less_than", oval_evr_string_cmp, &evr, OVAL_OPERATION_LESS_THAN, ops);
+	bench_str("debian_evr_string_less_than", oval_debian_evr_string_cmp, &debian_evr, OVAL_OPERATION_LESS_THAN, ops);
+	bench_str("version_less_than", oval_versiontype_cmp, &versions, OVAL_OPERATION_LESS_THAN, ops);
+	bench_ent("probe_evr_string_less_than", probe_ent_cmp_evr, &evr, OVAL_OPERATION_LESS_THAN, ops);
+	bench_ent("probe_debian_evr_string_less_than", probe_ent_cmp_debian_evr, &debian_evr, OVAL_OPERATION_LESS_THAN, ops);
+	bench_ent("probe_version_less_than", probe_ent_cmp_version, &versions, OVAL_OPERATION_LESS_THAN, ops);
+	bench_ipaddr(ops);
+	bench_numbers(ops);
+	bench_strings(ops);
+
+	bench_close();
+	bench_corpus_free(&evr);
+	bench_corpus_free(&debian_evr);
+	bench_corpus_free(&versions);
+	return 0;
+}
@@ -0,0 +1,29 @@
+#!/usr/bin/env bash
+
+# Comparator microbenchmark.
+#
+# Writes one JSON object per comparator to bench_cmp.json in the build
+# directory. The EVR strings are taken from the rpm database when rpm is
+# installed, from a built-in list otherwise.
+#
+# Environment:
+#   OSCAP_BENCHMARK_CMP_OPS  comparisons per measurement (default: 200000)
+
+. $builddir/tests/test_common.sh
+
+set -e -o pipefail
+
+output="$builddir/tests/API/probes/bench_cmp.json"
+evr_option=""
+
+if command -v rpm > /dev/null; then
+	evr_file=$(mktemp)
+	rpm -qa --qf '%{EPOCHNUM}:%{VERSION}-%{RELEASE}\n' > "$evr_file" || true
+	if [ $(wc -l < "$evr_file") -gt 1 ]; then
+		evr_option="-e $evr_file"
+	fi
+fi
+
+./bench_cmp -n "${OSCAP_BENCHMARK_CMP_OPS:-200000}" $evr_option -o "$output"
+cat "$output"
+[ -z "$evr_file" ] || rm -f "$evr_file"
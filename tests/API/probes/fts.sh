@@ -242,6 +242,29 @@ test20 \
 "-1" "directories" "down" "local" \
 d1/d11/d111/f1111,
 
+# directories listed from the metadata cache are not reported as files
+test21 \
+"equals" "$ROOT/d1" \
+"pattern match" "^[df]1" \
+'' '' \
+"-1" "symlinks and directories" "none" "all" \
+d1/f11,
+
+# names rejected by the literals of the pattern are not matched, optional characters are not required
+test22 \
+"equals" "$ROOT" \
+"pattern match" "^f11?1$" \
+'' '' \
+"-1" "symlinks and directories" "down" "all" \
+d1/d11/f111,d1/f11,
+
+test23 \
+'' '' \
+'' '' \
+"pattern match" "^$ROOT/d[12]/d[0-9]+/f2.*1$" \
+"-1" "symlinks and directories" "down" "all" \
+d2/d21/f211,
+
 EOF
 
 rm -rf $tmpdir
@@ -0,0 +1,194 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "probe-api.h"
+#include "probe.h"
+#include "icache.h"
+#include "ncache.h"
+
+/* more items than the initial table and the queue can hold */
+#define ITEMS 3000
+
+extern probe_ncache_t *OSCAP_GSYM(ncache);
+
+static SEXP_t *new_item(int i)
+{
+	char value[32];
+
+	snprintf(value, sizeof(value), "value%d", i);
+	return probe_item_create(OVAL_INDEPENDENT_ENVIRONMENT_VARIABLE58, NULL,
+		"pid", OVAL_DATATYPE_INTEGER, (int64_t)i,
+		"name", OVAL_DATATYPE_STRING, "NAME",
+		"value", OVAL_DATATYPE_STRING, value,
+		NULL);
+}
+
+/* the IDs of the collected items, the equal items share the ID */
+static int check_ids(SEXP_t *cobj, size_t expected_items)
+{
+	SEXP_t *items, *item, *id;
+	char **ids;
+	size_t i = 0;
+	int ret = 0;
+
+	items = probe_cobj_get_items(cobj);
+	if (SEXP_list_length(items) != expected_items) {
+		fprintf(stderr, "%zu items collected instead of %zu\n",
+			SEXP_list_length(items), expected_items);
+		SEXP_free(items);
+		return 1;
+	}
+	ids = calloc(expected_items, sizeof(char *));
+	SEXP_list_foreach(item, items) {
+		id = probe_obj_getattrval(item, "id");
+		ids[i++] = id != NULL ? SEXP_string_cstr(id) : NULL;
+		SEXP_free(id);
+	}
+	SEXP_free(items);
+
+	/* the items were added twice, ITEMS distinct ones each time */
+	for (i = 0; i < expected_items; i++) {
+		const char *twin = ids[i % ITEMS + (i < ITEMS ? ITEMS : 0)];
+
+		if (ids[i] == NULL || twin == NULL || strcmp(ids[i], twin) != 0) {
+			fprintf(stderr, "Item %zu: the equal items have different IDs\n", i);
+			ret = 1;
+			break;
+		}
+		if (i > 0 && i < ITEMS && strcmp(ids[i], ids[i - 1]) == 0) {
+			fprintf(stderr, "Item %zu: different items share the ID %s\n", i, ids[i]);
+			ret = 1;
+			break;
+		}
+	}
+	for (i = 0; i < expected_items; i++)
+		free(ids[i]);
+	free(ids);
+	return ret;
+}
+
+static int check_stats(probe_icache_t *cache)
+{
+	if (cache->lookups != 2 * ITEMS || cache->hits != ITEMS) {
+		fprintf(stderr, "%llu lookups and %llu hits instead of %d and %d\n",
+			(unsigned long long)cache->lookups, (unsigned long long)cache->hits,
+			2 * ITEMS, ITEMS);
+		return 1;
+	}
+	if (cache->table.count != ITEMS || cache->table.count * 4 > cache->table.capacity * 3) {
+		fprintf(stderr, "%zu items in a table of %zu slots\n",
+			cache->table.count, cache->table.capacity);
+		return 1;
+	}
+	return 0;
+}
+
+/* every item is handed over alone */
+static int test_add(void)
+{
+	probe_icache_t *cache = probe_icache_new();
+	SEXP_t *cobj = probe_cobj_new(SYSCHAR_FLAG_UNKNOWN, NULL, NULL, NULL);
+	int ret = 0;
+
+	pthread_barrier_wait(&OSCAP_GSYM(th_barrier));
+	for (int round = 0; round < 2; round++) {
+		for (int i = 0; i < ITEMS; i++) {
+			if (probe_icache_add(cache, cobj, new_item(i)) != 0) {
+				fprintf(stderr, "Can't add item %d\n", i);
+				ret = 1;
+			}
+		}
+	}
+	if (probe_icache_nop(cache) != 0) {
+		fprintf(stderr, "Can't sync with the icache worker\n");
+		ret = 1;
+	}
+	ret |= check_ids(cobj, 2 * ITEMS);
+	ret |= check_stats(cache);
+
+	SEXP_free(cobj);
+	probe_icache_free(cache);
+	return ret;
+}
+
+/*
+ * The items are handed over in batches, the batches fill the queue
+ * before the worker is signaled and the last batch is only partial.
+ */
+static int test_batch(void)
+{
+	probe_icache_t *cache = probe_icache_new();
+	SEXP_t *cobj = probe_cobj_new(SYSCHAR_FLAG_UNKNOWN, NULL, NULL, NULL);
+	probe_ibatch_t batch;
+	int ret = 0;
+
+	pthread_barrier_wait(&OSCAP_GSYM(th_barrier));
+	probe_ibatch_init(&batch);
+	for (int round = 0; round < 2; round++) {
+		for (int i = 0; i < ITEMS; i++) {
+			batch.cobj = cobj;
+			batch.item[batch.count++] = new_item(i);
+			if (batch.count == PROBE_IBATCH_CAPACITY && probe_icache_add_batch(cache, &batch) != 0) {
+				fprintf(stderr, "Can't add the batch of item %d\n", i);
+				ret = 1;
+			}
+		}
+	}
+	if (batch.count == 0) {
+		fprintf(stderr, "No partial batch is left to sync\n");
+		ret = 1;
+	}
+	if (probe_icache_sync(cache, &batch) != 0 || batch.count != 0) {
+		fprintf(stderr, "Can't sync the batch with the icache worker\n");
+		ret = 1;
+	}
+	ret |= check_ids(cobj, 2 * ITEMS);
+	ret |= check_stats(cache);
+
+	SEXP_free(cobj);
+	probe_icache_free(cache);
+	return ret;
+}
+
+int main(void)
+{
+	int ret = 0;
+
+	OSCAP_GSYM(ncache) = probe_ncache_new();
+	/* the icache worker waits for the thread which created it */
+	if (pthread_barrier_init(&OSCAP_GSYM(th_barrier), NULL, 2) != 0) {
+		fprintf(stderr, "Can't initialize the barrier\n");
+		return 1;
+	}
+
+	ret |= test_add();
+	ret |= test_batch();
+
+	pthread_barrier_destroy(&OSCAP_GSYM(th_barrier));
+	probe_ncache_free(OSCAP_GSYM(ncache));
+	return ret;
+}
@@ -0,0 +1,11 @@
+#!/usr/bin/env bash
+
+. $builddir/tests/test_common.sh
+
+if [ -n "${CUSTOM_OSCAP+x}" ] ; then
+    exit 255
+fi
+
+# the collected objects hold thousands of items
+export SEXP_VALIDATE_DISABLE="1"
+./test_icache
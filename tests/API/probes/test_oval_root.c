@@ -0,0 +1,182 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "oval_root.h"
+
+/*
+ * The files of the root must be reached whatever the links in the root
+ * point to, the file next to the root must never be.
+ *
+ *   tmp/secret            "outside"
+ *   tmp/root/secret       "inside"
+ *   tmp/root/abs          -> /secret
+ *   tmp/root/dir/up       -> ../../../secret
+ *   tmp/root/dir/host     -> tmp/secret (the host path)
+ */
+
+static char tmp[PATH_MAX], root[PATH_MAX];
+
+static int write_file(const char *path, const char *content)
+{
+	FILE *fp = fopen(path, "w");
+
+	if (fp == NULL)
+		return -1;
+	fputs(content, fp);
+	return fclose(fp);
+}
+
+static int setup(void)
+{
+	char path[PATH_MAX], target[PATH_MAX];
+
+	strcpy(tmp, "/tmp/test_oval_root.XXXXXX");
+	if (mkdtemp(tmp) == NULL)
+		return -1;
+	snprintf(root, sizeof(root), "%s/root", tmp);
+	snprintf(path, sizeof(path), "%s/secret", tmp);
+	if (mkdir(root, 0700) != 0 || write_file(path, "outside") != 0)
+		return -1;
+	snprintf(target, sizeof(target), "%s/secret", tmp);
+	snprintf(path, sizeof(path), "%s/secret", root);
+	if (write_file(path, "inside") != 0)
+		return -1;
+	snprintf(path, sizeof(path), "%s/abs", root);
+	if (symlink("/secret", path) != 0)
+		return -1;
+	snprintf(path, sizeof(path), "%s/dir", root);
+	if (mkdir(path, 0700) != 0)
+		return -1;
+	snprintf(path, sizeof(path), "%s/dir/up", root);
+	if (symlink("../../../secret", path) != 0)
+		return -1;
+	snprintf(path, sizeof(path), "%s/dir/host", root);
+	if (symlink(target, path) != 0)
+		return -1;
+	return 0;
+}
+
+static void cleanup(void)
+{
+	const char *names[] = {"root/dir/host", "root/dir/up", "root/dir", "root/abs", "root/secret", "root", "secret"};
+	char path[PATH_MAX];
+
+	for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+		snprintf(path, sizeof(path), "%s/%s", tmp, names[i]);
+		remove(path);
+	}
+	rmdir(tmp);
+}
+
+/* the path must be read as the file of the root */
+static int test_inside(const char *path)
+{
+	char buf[16] = {0};
+	FILE *fp;
+
+	fp = oval_root_fopen(root, path);
+	if (fp == NULL) {
+		fprintf(stderr, "%s: can't be opened: %s\n", path, strerror(errno));
+		return 1;
+	}
+	if (fgets(buf, sizeof(buf), fp) == NULL || strcmp(buf, "inside") != 0) {
+		fprintf(stderr, "%s: read '%s' instead of 'inside'\n", path, buf);
+		fclose(fp);
+		return 1;
+	}
+	fclose(fp);
+	return 0;
+}
+
+/* the path points out of the root, there is no such file in the root */
+static int test_escape(const char *path)
+{
+	struct stat st;
+	FILE *fp;
+
+	fp = oval_root_fopen(root, path);
+	if (fp != NULL) {
+		fprintf(stderr, "%s: opened a file out of the root\n", path);
+		fclose(fp);
+		return 1;
+	}
+	if (errno != ENOENT) {
+		fprintf(stderr, "%s: %s instead of ENOENT\n", path, strerror(errno));
+		return 1;
+	}
+	if (oval_root_stat(root, path, &st) == 0) {
+		fprintf(stderr, "%s: stat of a file out of the root\n", path);
+		return 1;
+	}
+	return 0;
+}
+
+int main(void)
+{
+	char buf[PATH_MAX];
+	struct stat st;
+	ssize_t len;
+	DIR *dp;
+	int ret = 0;
+
+	if (setup() != 0) {
+		fprintf(stderr, "Can't create the test tree: %s\n", strerror(errno));
+		cleanup();
+		return 1;
+	}
+
+	ret |= test_inside("/secret");
+	ret |= test_inside("/abs");
+	ret |= test_inside("/dir/up");
+	ret |= test_inside("/../secret");
+	ret |= test_inside("/dir/../../secret");
+	ret |= test_escape("/dir/host");
+
+	/* the links themselves are files of the root */
+	if (oval_root_lstat(root, "/dir/host", &st) != 0 || !S_ISLNK(st.st_mode)) {
+		fprintf(stderr, "/dir/host: lstat isn't the link\n");
+		ret = 1;
+	}
+	len = oval_root_readlink(root, "/abs", buf, sizeof(buf) - 1);
+	if (len < 0 || (buf[len] = '\0', strcmp(buf, "/secret") != 0)) {
+		fprintf(stderr, "/abs: readlink isn't the target of the link\n");
+		ret = 1;
+	}
+	dp = oval_root_opendir(root, "/dir/..");
+	if (dp == NULL) {
+		fprintf(stderr, "/dir/..: can't be listed: %s\n", strerror(errno));
+		ret = 1;
+	} else {
+		closedir(dp);
+	}
+
+	cleanup();
+	return ret;
+}
@@ -9,6 +9,7 @@ test_init ds_sds_index.log
 if [ -z ${CUSTOM_OSCAP+x} ] ; then
     test_run "ds_sds_index" ./test_ds_sds_index $srcdir/sds.xml
     test_run "ds_sds_index_multiple" ./test_ds_sds_index_multiple $srcdir/sds_multiple.xml
+    test_run "ds_sds_component_index" ./test_ds_sds_component_index $srcdir/sds.xml
 fi
 
 test_exit
@@ -0,0 +1,210 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <libxml/parser.h>
+#include <libxml/tree.h>
+
+#include "DS/sds_index_priv.h"
+
+/*
+ * The components parsed from their byte ranges must be the same as the
+ * components of the whole document. The namespaces and the entities
+ * declared before a component stay in scope, the first component of an
+ * id is used and the commented out components are not indexed.
+ */
+static const char collection[] =
+	"<?xml version=\"1.0\"?>\n"
+	"<!DOCTYPE ds:data-stream-collection [<!ENTITY product \"Fedora\">]>\n"
+	"<ds:data-stream-collection xmlns:ds=\"http://scap.nist.gov/schema/scap/source/1.2\""
+	" xmlns:xccdf=\"http://checklists.nist.gov/xccdf/1.2\" id=\"collection\">\n"
+	"  <ds:data-stream id=\"stream\"/>\n"
+	"  <ds:component id=\"first\"><xccdf:Benchmark id=\"b1\"><xccdf:title>&product; &lt;1&gt;</xccdf:title></xccdf:Benchmark></ds:component>\n"
+	"  <!-- <ds:component id=\"commented\"/> -->\n"
+	"  <ds:extended-component id=\"extended\"><data><![CDATA[<ds:component id=\"cdata\">]]></data></ds:extended-component>\n"
+	"  <ds:component id=\"first\"><xccdf:Benchmark id=\"b2\"/></ds:component>\n"
+	"</ds:data-stream-collection>\n";
+
+static xmlNode *get_component(xmlDoc *doc, const char *component_id)
+{
+	xmlNode *root = xmlDocGetRootElement(doc);
+
+	for (xmlNode *node = root != NULL ? root->children : NULL; node != NULL; node = node->next) {
+		if (node->type != XML_ELEMENT_NODE)
+			continue;
+		xmlChar *id = xmlGetProp(node, BAD_CAST "id");
+		bool found = id != NULL && strcmp((const char *)id, component_id) == 0;
+		xmlFree(id);
+		if (found)
+			return node;
+	}
+	return NULL;
+}
+
+static char *dump_node(xmlDoc *doc, xmlNode *node)
+{
+	xmlBuffer *buffer = xmlBufferCreate();
+	char *dump;
+
+	xmlNodeDump(buffer, doc, node, 0, 0);
+	dump = strdup((const char *)xmlBufferContent(buffer));
+	xmlBufferFree(buffer);
+	return dump;
+}
+
+static int check_component(struct ds_sds_component_index *index, xmlDoc *full, const char *component_id)
+{
+	xmlDoc *doc = ds_sds_component_index_parse_component(index, component_id);
+	xmlNode *expected = get_component(full, component_id);
+	xmlNode *empty = get_component(ds_sds_component_index_get_xmlDoc(index), component_id);
+	int ret = 0;
+
+	if (doc == NULL || expected == NULL) {
+		fprintf(stderr, "%s: component not found\n", component_id);
+		xmlFreeDoc(doc);
+		return 1;
+	}
+	if (empty == NULL || empty->children != NULL) {
+		fprintf(stderr, "%s: component isn't left empty in the collection\n", component_id);
+		ret = 1;
+	}
+	char *expected_dump = dump_node(full, expected);
+	char *dump = dump_node(doc, get_component(doc, component_id));
+	if (strcmp(dump, expected_dump) != 0) {
+		fprintf(stderr, "%s: parsed as\n%s\ninstead of\n%s\n", component_id, dump, expected_dump);
+		ret = 1;
+	}
+	free(dump);
+	free(expected_dump);
+	xmlFreeDoc(doc);
+	return ret;
+}
+
+static int test_collection(const char *memory, size_t size, const char *filename)
+{
+	struct ds_sds_component_index *index = ds_sds_component_index_parse(memory, size, filename, NULL);
+	xmlDoc *full = xmlReadMemory(memory, size, filename, NULL, 0);
+	int ret = 0;
+
+	if (index == NULL || full == NULL) {
+		fprintf(stderr, "%s: can't be indexed\n", filename);
+		ds_sds_component_index_free(index);
+		xmlFreeDoc(full);
+		return 1;
+	}
+	for (xmlNode *node = xmlDocGetRootElement(full)->children; node != NULL; node = node->next) {
+		if (node->type != XML_ELEMENT_NODE || (strcmp((const char *)node->name, "component") != 0 &&
+		    strcmp((const char *)node->name, "extended-component") != 0))
+			continue;
+		xmlChar *id = xmlGetProp(node, BAD_CAST "id");
+		ret |= check_component(index, full, (const char *)id);
+		xmlFree(id);
+	}
+	if (ds_sds_component_index_parse_component(index, "missing") != NULL) {
+		fprintf(stderr, "%s: a missing component was parsed\n", filename);
+		ret = 1;
+	}
+	ds_sds_component_index_free(index);
+	xmlFreeDoc(full);
+	return ret;
+}
+
+static int test_inline(void)
+{
+	struct ds_sds_component_index *index = ds_sds_component_index_parse(collection, strlen(collection), "inline", NULL);
+	xmlDoc *doc;
+	int ret = 0;
+
+	ret |= test_collection(collection, strlen(collection), "inline");
+	if (index == NULL)
+		return 1;
+	doc = ds_sds_component_index_parse_component(index, "first");
+	if (doc != NULL) {
+		xmlNode *component = get_component(doc, "first");
+		xmlChar *id = component != NULL && component->children != NULL ?
+			xmlGetProp(component->children, BAD_CAST "id") : NULL;
+		if (id == NULL || strcmp((const char *)id, "b1") != 0) {
+			fprintf(stderr, "inline: the first component of the id isn't used\n");
+			ret = 1;
+		}
+		xmlFree(id);
+		xmlFreeDoc(doc);
+	}
+	if (ds_sds_component_index_parse_component(index, "commented") != NULL ||
+	    ds_sds_component_index_parse_component(index, "cdata") != NULL) {
+		fprintf(stderr, "inline: a component out of the markup was indexed\n");
+		ret = 1;
+	}
+	ds_sds_component_index_free(index);
+	return ret;
+}
+
+/* the whole document is parsed when it isn't well formed */
+static int test_malformed(void)
+{
+	const char malformed[] = "<ds:data-stream-collection xmlns:ds=\"http://scap.nist.gov/schema/scap/source/1.2\">"
+		"<ds:component id=\"c\"><unclosed></ds:component></ds:data-stream-collection>";
+	struct ds_sds_component_index *index = ds_sds_component_index_parse(malformed, strlen(malformed), "malformed", NULL);
+
+	if (index != NULL) {
+		fprintf(stderr, "malformed: indexed\n");
+		ds_sds_component_index_free(index);
+		return 1;
+	}
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	char *memory;
+	long size;
+	FILE *fp;
+	int ret = 0;
+
+	if (argc != 2) {
+		printf("Invalid arguments, usage: ./test_ds_sds_component_index FILE");
+		return 2;
+	}
+	fp = fopen(argv[1], "r");
+	if (fp == NULL || fseek(fp, 0, SEEK_END) != 0 || (size = ftell(fp)) <= 0) {
+		fprintf(stderr, "Can't read %s\n", argv[1]);
+		return 1;
+	}
+	rewind(fp);
+	memory = malloc(size);
+	if (fread(memory, 1, size, fp) != (size_t)size) {
+		fprintf(stderr, "Can't read %s\n", argv[1]);
+		return 1;
+	}
+	fclose(fp);
+
+	ret |= test_collection(memory, size, argv[1]);
+	ret |= test_inline();
+	ret |= test_malformed();
+
+	free(memory);
+	return ret;
+}
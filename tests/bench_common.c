@@ -0,0 +1,137 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+
+#include "bench_common.h"
+
+static volatile uint64_t bench_allocs = 0;
+static FILE *bench_out = NULL;
+
+#if defined(__GLIBC__)
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void *__libc_memalign(size_t alignment, size_t size);
+
+void *malloc(size_t size)
+{
+	__sync_fetch_and_add(&bench_allocs, 1);
+	return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size)
+{
+	__sync_fetch_and_add(&bench_allocs, 1);
+	return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+	__sync_fetch_and_add(&bench_allocs, 1);
+	return __libc_realloc(ptr, size);
+}
+
+int posix_memalign(void **memptr, size_t alignment, size_t size)
+{
+	__sync_fetch_and_add(&bench_allocs, 1);
+	*memptr = __libc_memalign(alignment, size);
+	return *memptr != NULL ? 0 : ENOMEM;
+}
+#define BENCH_ALLOCS_COUNTED true
+#else
+#define BENCH_ALLOCS_COUNTED false
+#endif
+
+int bench_open(const char *path)
+{
+	bench_out = stdout;
+	if (path != NULL && (bench_out = fopen(path, "w")) == NULL) {
+		fprintf(stderr, "Can't open '%s': %s\n", path, strerror(errno));
+		return -1;
+	}
+	return 0;
+}
+
+void bench_close(void)
+{
+	if (bench_out != NULL && bench_out != stdout)
+		fclose(bench_out);
+	bench_out = NULL;
+}
+
+static long bench_peak_rss_kb(void)
+{
+	struct rusage usage;
+	return getrusage(RUSAGE_SELF, &usage) == 0 ? usage.ru_maxrss : 0;
+}
+
+void bench_start(struct bench_clock *clk)
+{
+	clk->allocs = bench_allocs;
+	clk->peak_rss_kb = bench_peak_rss_kb();
+	clock_gettime(CLOCK_MONOTONIC, &clk->start);
+}
+
+void bench_report(const struct bench_clock *clk, const char *name, int threads, uint64_t ops)
+{
+	struct timespec end;
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	uint64_t allocs = bench_allocs - clk->allocs;
+	double seconds = (double)(end.tv_sec - clk->start.tv_sec) +
+		(double)(end.tv_nsec - clk->start.tv_nsec) / 1e9;
+	FILE *fp = bench_out != NULL ? bench_out : stdout;
+
+	fprintf(fp, "{\"benchmark\": \"%s\", \"threads\": %d, \"ops\": %llu, "
+		"\"seconds\": %.6f, \"ops_per_sec\": %.1f, \"ns_per_op\": %.1f, ",
+		name, threads, (unsigned long long)ops, seconds,
+		seconds > 0 ? (double)ops / seconds : 0.0,
+		ops ? seconds * 1e9 / ops : 0.0);
+	if (BENCH_ALLOCS_COUNTED)
+		fprintf(fp, "\"allocs_per_op\": %.4f}\n", ops ? (double)allocs / ops : 0.0);
+	else
+		fprintf(fp, "\"allocs_per_op\": null}\n");
+	fflush(fp);
+}
+
+void bench_report_bytes(const struct bench_clock *clk, const char *name, uint64_t bytes)
+{
+	struct timespec end;
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double seconds = (double)(end.tv_sec - clk->start.tv_sec) +
+		(double)(end.tv_nsec - clk->start.tv_nsec) / 1e9;
+	long peak_rss_kb = bench_peak_rss_kb();
+	FILE *fp = bench_out != NULL ? bench_out : stdout;
+
+	fprintf(fp, "{\"benchmark\": \"%s\", \"bytes\": %llu, \"seconds\": %.6f, "
+		"\"mb_per_sec\": %.2f, \"peak_rss_kb\": %ld, \"peak_rss_growth_kb\": %ld}\n",
+		name, (unsigned long long)bytes, seconds,
+		seconds > 0 ? (double)bytes / 1e6 / seconds : 0.0,
+		peak_rss_kb, peak_rss_kb - clk->peak_rss_kb);
+	fflush(fp);
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef OSCAP_BENCH_COMMON_H
+#define OSCAP_BENCH_COMMON_H
+
+#include <stdint.h>
+#include <time.h>
+
+/*
+ * Helpers of the microbenchmarks in C. A measurement is started by
+ * bench_start() and written by bench_report() as one JSON object per line:
+ *
+ *   {"benchmark": "list_add", "threads": 1, "ops": 200000, "seconds": 0.0123,
+ *    "ops_per_sec": 16260162.6, "ns_per_op": 61.5, "allocs_per_op": 0.004}
+ *
+ * Allocations are counted by wrapping the glibc allocator, allocs_per_op is
+ * null elsewhere. Link bench_common.c into the benchmark to use them.
+ *
+ * Measurements of content processing are written by bench_report_bytes()
+ * with the throughput and the peak RSS of the process instead:
+ *
+ *   {"benchmark": "xccdf_import", "bytes": 23068672, "seconds": 1.52,
+ *    "mb_per_sec": 15.2, "peak_rss_kb": 412000, "peak_rss_growth_kb": 398000}
+ *
+ * peak_rss_growth_kb is how much the peak grew during the measurement, run
+ * one measurement per process for it to mean anything.
+ */
+
+struct bench_clock {
+	struct timespec start;
+	uint64_t allocs;
+	long peak_rss_kb;
+};
+
+/* Write the results into the file at path, to stdout if it is NULL */
+int bench_open(const char *path);
+void bench_close(void);
+
+void bench_start(struct bench_clock *clk);
+void bench_report(const struct bench_clock *clk, const char *name, int threads, uint64_t ops);
+void bench_report_bytes(const struct bench_clock *clk, const char *name, uint64_t bytes);
+
+#endif /* OSCAP_BENCH_COMMON_H */
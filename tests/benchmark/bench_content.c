@@ -0,0 +1,210 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Throughput of loading and exporting content, one operation per run so
+ * that the peak RSS belongs to it, written as described in bench_common.h.
+ * The bytes are those of the input file for the imports and those of the
+ * written file for the exports.
+ *
+ * Usage: bench_content [-o output] sds_extract DATASTREAM
+ *        bench_content [-o output] xccdf_import XCCDF
+ *        bench_content [-o output] oval_import OVAL_DEFINITIONS
+ *        bench_content [-o output] oval_results_import OVAL_RESULTS
+ *        bench_content [-o output] oval_results_export OVAL_RESULTS TARGET
+ *        bench_content [-o output] arf_build DATASTREAM XCCDF_RESULT [OVAL_RESULTS...] TARGET
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "oscap.h"
+#include "oscap_error.h"
+#include "oscap_source.h"
+#include "ds_sds_session.h"
+#include "scap_ds.h"
+#include "xccdf_benchmark.h"
+#include "oval_definitions.h"
+#include "oval_results.h"
+#include "bench_common.h"
+
+static uint64_t bench_file_size(const char *path)
+{
+	struct stat st;
+	return stat(path, &st) == 0 ? (uint64_t)st.st_size : 0;
+}
+
+/* Parsing of the data stream and extraction of the checklist with all its dependencies */
+static int bench_sds_extract(const char *path)
+{
+	struct bench_clock clk;
+	int ret = -1;
+
+	bench_start(&clk);
+	struct oscap_source *source = oscap_source_new_from_file(path);
+	struct ds_sds_session *session = ds_sds_session_new_from_source(source);
+	if (session != NULL && ds_sds_session_select_checklist(session, NULL, NULL, NULL) != NULL) {
+		bench_report_bytes(&clk, "sds_extract", bench_file_size(path));
+		ret = 0;
+	}
+	ds_sds_session_free(session);
+	oscap_source_free(source);
+	return ret;
+}
+
+static int bench_xccdf_import(const char *path)
+{
+	struct bench_clock clk;
+
+	bench_start(&clk);
+	struct oscap_source *source = oscap_source_new_from_file(path);
+	struct xccdf_benchmark *benchmark = xccdf_benchmark_import_source(source);
+	if (benchmark != NULL)
+		bench_report_bytes(&clk, "xccdf_import", bench_file_size(path));
+	xccdf_benchmark_free(benchmark);
+	oscap_source_free(source);
+	return benchmark != NULL ? 0 : -1;
+}
+
+static int bench_oval_import(const char *path)
+{
+	struct bench_clock clk;
+
+	bench_start(&clk);
+	struct oscap_source *source = oscap_source_new_from_file(path);
+	struct oval_definition_model *model = oval_definition_model_import_source(source);
+	if (model != NULL)
+		bench_report_bytes(&clk, "oval_import", bench_file_size(path));
+	oval_definition_model_free(model);
+	oscap_source_free(source);
+	return model != NULL ? 0 : -1;
+}
+
+/* Exports the results to target when it isn't NULL, otherwise the import is measured */
+static int bench_oval_results(const char *path, const char *target)
+{
+	struct bench_clock clk;
+	int ret;
+
+	struct oval_definition_model *def_model = oval_definition_model_new();
+	struct oval_results_model *res_model = oval_results_model_new(def_model, NULL);
+	struct oscap_source *source = oscap_source_new_from_file(path);
+
+	bench_start(&clk);
+	ret = oval_results_model_import_source(res_model, source);
+	if (ret == 0 && target == NULL)
+		bench_report_bytes(&clk, "oval_results_import", bench_file_size(path));
+
+	if (ret == 0 && target != NULL) {
+		bench_start(&clk);
+		ret = oval_results_model_export(res_model, NULL, target) < 0 ? -1 : 0;
+		if (ret == 0)
+			bench_report_bytes(&clk, "oval_results_export", bench_file_size(target));
+	}
+
+	oscap_source_free(source);
+	oval_results_model_free(res_model);
+	oval_definition_model_free(def_model);
+	return ret;
+}
+
+static int bench_arf_build(const char *sds, const char *xccdf_result, const char **oval_results, const char *target)
+{
+	struct bench_clock clk;
+
+	bench_start(&clk);
+	if (ds_rds_create(sds, xccdf_result, oval_results, target) != 0)
+		return -1;
+	bench_report_bytes(&clk, "arf_build", bench_file_size(target));
+	return 0;
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr, "Usage: %s [-o output] OPERATION FILE...\n"
+		"Operations: sds_extract, xccdf_import, oval_import, oval_results_import, "
+		"oval_results_export, arf_build\n", name);
+}
+
+int main(int argc, char *argv[])
+{
+	const char *output = NULL;
+	int c, ret = -1;
+
+	while ((c = getopt(argc, argv, "o:")) != -1) {
+		switch (c) {
+		case 'o':
+			output = optarg;
+			break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if (argc - optind < 2) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	const char *operation = argv[optind];
+	char **files = &argv[optind + 1];
+	int nfiles = argc - optind - 1;
+
+	if (bench_open(output) != 0)
+		return 1;
+
+	if (!strcmp(operation, "sds_extract")) {
+		ret = bench_sds_extract(files[0]);
+	} else if (!strcmp(operation, "xccdf_import")) {
+		ret = bench_xccdf_import(files[0]);
+	} else if (!strcmp(operation, "oval_import")) {
+		ret = bench_oval_import(files[0]);
+	} else if (!strcmp(operation, "oval_results_import")) {
+		ret = bench_oval_results(files[0], NULL);
+	} else if (!strcmp(operation, "oval_results_export") && nfiles == 2) {
+		ret = bench_oval_results(files[0], files[1]);
+	} else if (!strcmp(operation, "arf_build") && nfiles >= 3) {
+		const char *target = files[nfiles - 1];
+		/* the OVAL results in between become the NULL terminated list */
+		files[nfiles - 1] = NULL;
+		ret = bench_arf_build(files[0], files[1], (const char **)&files[2], target);
+	} else {
+		usage(argv[0]);
+		bench_close();
+		return 1;
+	}
+
+	if (ret != 0) {
+		char *err = oscap_err_get_full_error();
+		fprintf(stderr, "%s failed: %s\n", operation, err != NULL ? err : "unknown error");
+		free(err);
+	}
+
+	bench_close();
+	oscap_cleanup();
+	return ret != 0 ? 1 : 0;
+}
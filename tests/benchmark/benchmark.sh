@@ -0,0 +1,84 @@
+#!/usr/bin/env bash
+
+# End-to-end scan benchmark.
+#
+# Evaluates full profiles of the data streams in tests/memory against
+# a deterministic synthetic root and compares parse, collection,
+# evaluation and export time and the peak RSS with a baseline.
+#
+# Environment:
+#   OSCAP_BENCHMARK_PROFILE    profile to evaluate (default: ospp)
+#   OSCAP_BENCHMARK_BASELINE   baseline file, written when missing
+#   OSCAP_BENCHMARK_THRESHOLD  allowed regression in percent (default: 25)
+
+. $builddir/tests/test_common.sh
+
+set -e -o pipefail
+
+profile="${OSCAP_BENCHMARK_PROFILE:-xccdf_org.ssgproject.content_profile_ospp}"
+baseline="${OSCAP_BENCHMARK_BASELINE:-$builddir/tests/benchmark/baseline.json}"
+threshold="${OSCAP_BENCHMARK_THRESHOLD:-25}"
+
+function make_root {
+	local root="$1"
+
+	mkdir -p "$root"/{etc/ssh,etc/security,etc/sysconfig,etc/pam.d,etc/audit/rules.d,var/log,usr/bin,usr/sbin,proc,sys}
+	cat > "$root/etc/os-release" <<OS
+NAME="Red Hat Enterprise Linux"
+VERSION="8.0 (Ootpa)"
+ID="rhel"
+VERSION_ID="8.0"
+OS
+	echo "Red Hat Enterprise Linux release 8.0 (Ootpa)" > "$root/etc/redhat-release"
+	echo "root:x:0:0:root:/root:/bin/bash" > "$root/etc/passwd"
+	echo "root:x:0:" > "$root/etc/group"
+	echo "root:*:18000:0:99999:7:::" > "$root/etc/shadow"
+	printf "PermitRootLogin no\nProtocol 2\n" > "$root/etc/ssh/sshd_config"
+	printf "PASS_MAX_DAYS 60\nPASS_MIN_DAYS 1\n" > "$root/etc/login.defs"
+	printf "minlen = 15\n" > "$root/etc/security/pwquality.conf"
+	printf "auth required pam_faillock.so\n" > "$root/etc/pam.d/system-auth"
+	printf -- "-w /etc/passwd -p wa -k identity\n" > "$root/etc/audit/rules.d/audit.rules"
+	for i in $(seq 1 200); do
+		echo "file $i" > "$root/usr/bin/tool$i"
+	done
+	# fixed timestamps, the results must not depend on when the root was built
+	find "$root" -exec touch -h -d "2020-01-01 00:00:00" {} +
+}
+
+function run_benchmark {
+	require "bunzip2" || return 255
+	[ -n "$PREFERRED_PYTHON" ] || return 255
+
+	local tmpdir=$(mktemp -d)
+	local root="$tmpdir/root"
+	local ret=0
+
+	make_root "$root"
+
+	for ds in ssg-rhel7-ds.xml ssg-rhel8-ds.xml; do
+		bunzip2 -c "$top_srcdir/tests/memory/$ds.bz2" > "$tmpdir/$ds"
+
+		OSCAP_PROBE_ROOT="$root" $OSCAP xccdf eval --profile "$profile" \
+			--profiling "$tmpdir/$ds.json" --results "$tmpdir/$ds.results.xml" \
+			"$tmpdir/$ds" > /dev/null 2> "$tmpdir/$ds.stderr" || ret=$?
+		# 2 means some rules failed, which is expected on the synthetic root
+		if [ $ret -ne 0 ] && [ $ret -ne 2 ]; then
+			cat "$tmpdir/$ds.stderr" >&2
+			rm -rf "$tmpdir"
+			return 1
+		fi
+		ret=0
+	done
+
+	$PREFERRED_PYTHON "$srcdir/benchmark_compare.py" --baseline "$baseline" \
+		--threshold "$threshold" "$tmpdir"/*.json || ret=$?
+
+	rm -rf "$tmpdir"
+	return $ret
+}
+
+test_init
+
+test_run "end-to-end scan benchmark" run_benchmark
+
+test_exit
@@ -0,0 +1,76 @@
+#!/usr/bin/env python3
+
+# Summarizes the profiling reports of the end-to-end scan benchmark and
+# compares them with a baseline. The baseline is written if it does not
+# exist yet, delete it to accept new numbers.
+
+import argparse
+import json
+import os
+import sys
+
+
+METRICS = ("parse", "collection", "evaluation", "export", "peak_rss")
+
+
+def summarize(path):
+    with open(path) as f:
+        report = json.load(f)
+
+    def total(kind):
+        return sum(entry["wall_time"] for entry in report.get(kind, {}).values())
+
+    phases = report.get("phases", {})
+    return {
+        "parse": phases.get("load", {}).get("wall_time", 0.0),
+        "collection": total("objects"),
+        "evaluation": total("tests"),
+        "export": phases.get("export", {}).get("wall_time", 0.0),
+        "peak_rss": report.get("process", {}).get("peak_rss", 0),
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--baseline", required=True)
+    parser.add_argument("--threshold", type=float, default=25.0,
+                        help="allowed regression in percent")
+    parser.add_argument("reports", nargs="+")
+    args = parser.parse_args()
+
+    current = {os.path.basename(path): summarize(path) for path in args.reports}
+
+    for name, metrics in sorted(current.items()):
+        print("%s: %s" % (name, ", ".join(
+            "%s=%s" % (m, metrics[m]) for m in METRICS)))
+
+    if not os.path.exists(args.baseline):
+        with open(args.baseline, "w") as f:
+            json.dump(current, f, indent=2, sort_keys=True)
+        print("Baseline written to %s" % args.baseline)
+        return 0
+
+    with open(args.baseline) as f:
+        baseline = json.load(f)
+
+    regressions = 0
+    for name, metrics in sorted(current.items()):
+        if name not in baseline:
+            continue
+        for m in METRICS:
+            old = baseline[name].get(m, 0)
+            new = metrics[m]
+            # ignore noise in phases that are too short to measure
+            if old <= 0 or (m != "peak_rss" and new < 0.1):
+                continue
+            change = (new - old) * 100.0 / old
+            if change > args.threshold:
+                print("%s: %s regressed by %.1f%% (%s -> %s)" % (name, m, change, old, new),
+                      file=sys.stderr)
+                regressions += 1
+
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
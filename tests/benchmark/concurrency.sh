@@ -0,0 +1,124 @@
+#!/usr/bin/env bash
+
+# Probe concurrency scaling benchmark.
+#
+# Collects thousands of small textfilecontent54 and file objects, each of
+# them on its own file of a tree made by make_tree.sh, with a growing
+# number of probe worker threads (OSCAP_PROBE_JOBS). Writes one JSON object
+# per number of threads to tests/benchmark/concurrency.json in the build
+# directory: objects collected per second, the 50th, 90th, 99th percentile
+# and the maximum of the time spent on an object, and how many times and
+# how long the threads waited for the item cache lock.
+#
+# Environment:
+#   OSCAP_BENCHMARK_CONCURRENCY_OBJECTS  number of objects (default: 2000)
+#   OSCAP_BENCHMARK_CONCURRENCY_JOBS     thread counts (default: 1 2 4 8 16 32 64)
+
+. $builddir/tests/test_common.sh
+
+set -e -o pipefail
+
+objects="${OSCAP_BENCHMARK_CONCURRENCY_OBJECTS:-2000}"
+jobs="${OSCAP_BENCHMARK_CONCURRENCY_JOBS:-1 2 4 8 16 32 64}"
+output="$builddir/tests/benchmark/concurrency.json"
+
+# definitions OBJECTS DIRS FILES, objects alternate between the two probes
+# and go through the files of the tree /bench/d<dir>/f<file>.conf
+function definitions {
+	awk -v objects="$1" -v dirs="$2" -v files="$3" 'BEGIN {
+		print "<?xml version=\"1.0\"?>"
+		print "<oval_definitions xmlns=\"http://oval.mitre.org/XMLSchema/oval-definitions-5\" xmlns:oval=\"http://oval.mitre.org/XMLSchema/oval-common-5\" xmlns:unix-def=\"http://oval.mitre.org/XMLSchema/oval-definitions-5#unix\" xmlns:ind-def=\"http://oval.mitre.org/XMLSchema/oval-definitions-5#independent\">"
+		print "  <generator>"
+		print "    <oval:schema_version>5.11</oval:schema_version>"
+		print "    <oval:timestamp>0001-01-01T00:00:00+00:00</oval:timestamp>"
+		print "  </generator>"
+		print "  <definitions>"
+		print "    <definition class=\"compliance\" version=\"1\" id=\"oval:x:def:1\">"
+		print "      <metadata>"
+		print "        <title>concurrency</title>"
+		print "        <description>concurrency benchmark</description>"
+		print "      </metadata>"
+		print "      <criteria operator=\"AND\">"
+		for (i = 1; i <= objects; i++)
+			printf "        <criterion test_ref=\"oval:x:tst:%d\"/>\n", i
+		print "      </criteria>"
+		print "    </definition>"
+		print "  </definitions>"
+		print "  <tests>"
+		for (i = 1; i <= objects; i++) {
+			if (i % 2)
+				printf "    <ind-def:textfilecontent54_test id=\"oval:x:tst:%d\" version=\"1\" check=\"all\" check_existence=\"any_exist\" comment=\"x\">\n      <ind-def:object object_ref=\"oval:x:obj:%d\"/>\n    </ind-def:textfilecontent54_test>\n", i, i
+			else
+				printf "    <unix-def:file_test id=\"oval:x:tst:%d\" version=\"1\" check=\"all\" check_existence=\"any_exist\" comment=\"x\">\n      <unix-def:object object_ref=\"oval:x:obj:%d\"/>\n    </unix-def:file_test>\n", i, i
+		}
+		print "  </tests>"
+		print "  <objects>"
+		for (i = 1; i <= objects; i++) {
+			n = int((i - 1) / 2) % (dirs * files)
+			path = sprintf("/bench/d%d/f%d.conf", int(n / files) + 1, n % files + 1)
+			if (i % 2)
+				printf "    <ind-def:textfilecontent54_object id=\"oval:x:obj:%d\" version=\"1\">\n      <ind-def:filepath>%s</ind-def:filepath>\n      <ind-def:pattern operation=\"pattern match\">^key(\\d+) = (.*)$</ind-def:pattern>\n      <ind-def:instance datatype=\"int\" operation=\"greater than or equal\">1</ind-def:instance>\n    </ind-def:textfilecontent54_object>\n", i, path
+			else
+				printf "    <unix-def:file_object id=\"oval:x:obj:%d\" version=\"1\">\n      <unix-def:filepath>%s</unix-def:filepath>\n    </unix-def:file_object>\n", i, path
+		}
+		print "  </objects>"
+		print "</oval_definitions>"
+	}'
+}
+
+function concurrency_benchmark {
+	[ -n "$PREFERRED_PYTHON" ] || return 255
+	probecheck "file" || return 255
+	probecheck "textfilecontent54" || return 255
+
+	local tmpdir=$(mktemp -d)
+	local files=100
+	local dirs=$(( (objects / 2 + files - 1) / files ))
+
+	"$srcdir/make_tree.sh" -d "$dirs" -f "$files" -l 1 -L 0 "$tmpdir/root"
+	definitions "$objects" "$dirs" "$files" > "$tmpdir/concurrency.xml"
+
+	for n in $jobs; do
+		OSCAP_PROBE_ROOT="$tmpdir/root" OSCAP_PROBE_JOBS="$n" $OSCAP oval eval \
+			--profiling "$tmpdir/profiling.$n.json" --stats "$tmpdir/stats.$n.json" \
+			--skip-valid "$tmpdir/concurrency.xml" > /dev/null
+	done
+
+	$PREFERRED_PYTHON - "$tmpdir" $jobs <<'PY' | tee "$output"
+import json
+import sys
+
+tmpdir = sys.argv[1]
+for jobs in sys.argv[2:]:
+    profiling = json.load(open("%s/profiling.%s.json" % (tmpdir, jobs)))
+    counters = json.load(open("%s/stats.%s.json" % (tmpdir, jobs)))["counters"]
+    latency = sorted(o["wall_time"] for o in profiling["objects"].values())
+    seconds = profiling["phases"]["evaluate"]["wall_time"]
+
+    def percentile(p):
+        return latency[min(len(latency) - 1, int(len(latency) * p))]
+
+    print(json.dumps({
+        "benchmark": "concurrency",
+        "threads": int(jobs),
+        "objects": len(latency),
+        "seconds": seconds,
+        "objects_per_sec": len(latency) / seconds if seconds > 0 else 0,
+        "latency_p50": percentile(0.50),
+        "latency_p90": percentile(0.90),
+        "latency_p99": percentile(0.99),
+        "latency_max": latency[-1],
+        "icache_lock_waits": counters["icache_lock_waits"],
+        "icache_lock_wait_seconds": counters["icache_lock_wait_ns"] / 1e9,
+        "peak_rss": profiling["process"]["peak_rss"],
+    }))
+PY
+
+	rm -rf "$tmpdir"
+}
+
+test_init
+
+test_run "probe concurrency benchmark" concurrency_benchmark
+
+test_exit
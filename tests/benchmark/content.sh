@@ -0,0 +1,130 @@
+#!/usr/bin/env bash
+
+# Content parse and export benchmark.
+#
+# Measures with bench_content the extraction of the checklist from the
+# ssg-rhel8 data stream of tests/memory, the import of its XCCDF and OVAL
+# components, and the import and export of large OVAL results and the
+# building of an ARF report from them. The OVAL results are collected by
+# textfilecontent54 from a tree made by make_tree.sh, the XCCDF TestResult
+# has a rule-result for every rule of the data stream. Every operation runs
+# in its own process, one JSON object per run with its MB/s and peak RSS
+# is written to tests/benchmark/content.json in the build directory.
+#
+# Environment:
+#   OSCAP_BENCHMARK_CONTENT_DS     data stream to load (default: tests/memory/ssg-rhel8-ds.xml.bz2)
+#   OSCAP_BENCHMARK_CONTENT_ITEMS  items in the OVAL results (default: 200000)
+#   OSCAP_BENCHMARK_CONTENT_RUNS   runs of each operation (default: 3)
+
+. $builddir/tests/test_common.sh
+
+set -e -o pipefail
+
+datastream="${OSCAP_BENCHMARK_CONTENT_DS:-$top_srcdir/tests/memory/ssg-rhel8-ds.xml.bz2}"
+items="${OSCAP_BENCHMARK_CONTENT_ITEMS:-200000}"
+runs="${OSCAP_BENCHMARK_CONTENT_RUNS:-3}"
+output="$builddir/tests/benchmark/content.json"
+
+function definitions {
+	cat <<EOF
+<?xml version="1.0"?>
+<oval_definitions xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5" xmlns:oval="http://oval.mitre.org/XMLSchema/oval-common-5" xmlns:ind-def="http://oval.mitre.org/XMLSchema/oval-definitions-5#independent">
+  <generator>
+    <oval:schema_version>5.11</oval:schema_version>
+    <oval:timestamp>0001-01-01T00:00:00+00:00</oval:timestamp>
+  </generator>
+  <definitions>
+    <definition class="compliance" version="1" id="oval:x:def:1">
+      <metadata>
+        <title>content</title>
+        <description>keys have even values</description>
+      </metadata>
+      <criteria>
+        <criterion test_ref="oval:x:tst:1"/>
+      </criteria>
+    </definition>
+  </definitions>
+  <tests>
+    <ind-def:textfilecontent54_test id="oval:x:tst:1" version="1" check="all" comment="x">
+      <ind-def:object object_ref="oval:x:obj:1"/>
+      <ind-def:state state_ref="oval:x:ste:1"/>
+    </ind-def:textfilecontent54_test>
+  </tests>
+  <objects>
+    <ind-def:textfilecontent54_object id="oval:x:obj:1" version="1">
+      <ind-def:path>/bench</ind-def:path>
+      <ind-def:filename operation="pattern match">^large\d+\.conf$</ind-def:filename>
+      <ind-def:pattern operation="pattern match">^key\d+ = value(\d+)$</ind-def:pattern>
+      <ind-def:instance datatype="int" operation="greater than or equal">1</ind-def:instance>
+    </ind-def:textfilecontent54_object>
+  </objects>
+  <states>
+    <ind-def:textfilecontent54_state id="oval:x:ste:1" version="1">
+      <ind-def:subexpression operation="pattern match">[02468]$</ind-def:subexpression>
+    </ind-def:textfilecontent54_state>
+  </states>
+</oval_definitions>
+EOF
+}
+
+# xccdf_result XCCDF, a TestResult passing every rule of the benchmark
+function xccdf_result {
+	echo '<?xml version="1.0"?>'
+	echo '<TestResult xmlns="http://checklists.nist.gov/xccdf/1.2" id="xccdf_org.open-scap_testresult_benchmark" start-time="2020-01-01T00:00:00" end-time="2020-01-01T00:00:00" version="1">'
+	echo '  <target>benchmark</target>'
+	grep -o 'id="xccdf_[^"]*_rule_[^"]*"' "$1" | sort -u | sed 's/^id="\(.*\)"$/\1/' | while read -r rule; do
+		echo "  <rule-result idref=\"$rule\" time=\"2020-01-01T00:00:00\" weight=\"1.000000\"><result>pass</result></rule-result>"
+	done
+	echo '  <score system="urn:xccdf:scoring:default" maximum="100.000000">100.000000</score>'
+	echo '</TestResult>'
+}
+
+# measure OPERATION FILE...
+function measure {
+	for i in $(seq 1 "$runs"); do
+		./bench_content "$@" | tee -a "$output"
+	done
+}
+
+function content_benchmark {
+	case "$datastream" in
+		*.bz2) command -v bzip2 > /dev/null || return 255 ;;
+	esac
+
+	local tmpdir=$(mktemp -d)
+	: > "$output"
+
+	case "$datastream" in
+		*.bz2) bzip2 -dc "$datastream" > "$tmpdir/ds.xml" ;;
+		*) cp "$datastream" "$tmpdir/ds.xml" ;;
+	esac
+
+	$OSCAP ds sds-split "$tmpdir/ds.xml" "$tmpdir/split"
+	local xccdf=$(ls "$tmpdir"/split/*xccdf*.xml | head -n 1)
+	local oval=$(ls "$tmpdir"/split/*oval*.xml | grep -v cpe | head -n 1)
+
+	measure sds_extract "$tmpdir/ds.xml"
+	measure xccdf_import "$xccdf"
+	measure oval_import "$oval"
+
+	# the large results are collected by the textfilecontent54 probe
+	if probecheck "textfilecontent54"; then
+		"$srcdir/make_tree.sh" -d 1 -f 1 -l 1 -s 0 -x 0 -L 4 -n $((items / 4)) "$tmpdir/root"
+		definitions > "$tmpdir/definitions.xml"
+		OSCAP_PROBE_ROOT="$tmpdir/root" $OSCAP oval eval --results "$tmpdir/results.xml" \
+			"$tmpdir/definitions.xml" > /dev/null
+		xccdf_result "$xccdf" > "$tmpdir/xccdf-result.xml"
+
+		measure oval_results_import "$tmpdir/results.xml"
+		measure oval_results_export "$tmpdir/results.xml" "$tmpdir/exported.xml"
+		measure arf_build "$tmpdir/ds.xml" "$tmpdir/xccdf-result.xml" "$tmpdir/results.xml" "$tmpdir/arf.xml"
+	fi
+
+	rm -rf "$tmpdir"
+}
+
+test_init
+
+test_run "content parse and export benchmark" content_benchmark
+
+test_exit
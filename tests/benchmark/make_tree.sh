@@ -0,0 +1,97 @@
+#!/usr/bin/env bash
+
+# Synthetic file system generator.
+#
+# Builds a deterministic tree under ROOT/bench for the probe benchmarks:
+# DIRS directories on each of DEPTH levels, FILES small files in each of
+# them, a symlink to every SYMLINKS-th file, an extended attribute on every
+# XATTRS-th file and LARGE text files of LARGE_LINES lines in the top level
+# directory. The same options always give the same tree, names, contents,
+# attributes and timestamps included.
+#
+# Usage: make_tree.sh [-d dirs] [-f files] [-l depth] [-s symlinks]
+#                     [-x xattrs] [-L large] [-n large_lines] ROOT
+
+set -e -o pipefail
+
+dirs=10
+files=100
+depth=2
+symlinks=10
+xattrs=10
+large=2
+large_lines=100000
+
+function usage {
+	echo "Usage: $(basename $0) [-d dirs] [-f files] [-l depth] [-s symlinks] [-x xattrs] [-L large] [-n large_lines] ROOT" >&2
+	exit 1
+}
+
+while getopts "d:f:l:s:x:L:n:" opt; do
+	case $opt in
+		d) dirs=$OPTARG ;;
+		f) files=$OPTARG ;;
+		l) depth=$OPTARG ;;
+		s) symlinks=$OPTARG ;;
+		x) xattrs=$OPTARG ;;
+		L) large=$OPTARG ;;
+		n) large_lines=$OPTARG ;;
+		*) usage ;;
+	esac
+done
+shift $((OPTIND - 1))
+[ $# -eq 1 ] || usage
+
+root="$1/bench"
+rm -rf "$root"
+mkdir -p "$root"
+
+# xattrs are optional, tmpfs without user_xattr doesn't support them
+set_xattr=""
+if [ "$xattrs" -gt 0 ]; then
+	touch "$root/.xattr_check"
+	if command -v setfattr > /dev/null && setfattr -n user.bench -v 1 "$root/.xattr_check" 2> /dev/null; then
+		set_xattr="setfattr"
+	else
+		echo "Extended attributes are not supported on $root, skipping them." >&2
+	fi
+	rm -f "$root/.xattr_check"
+fi
+
+# directories: d<i> on the first level, d<i>/d<j> on the second one, ...
+level=("$root")
+all_dirs=()
+for l in $(seq 1 "$depth"); do
+	next=()
+	for parent in "${level[@]}"; do
+		for i in $(seq 1 "$dirs"); do
+			next+=("$parent/d$i")
+		done
+	done
+	mkdir -p "${next[@]}"
+	all_dirs+=("${next[@]}")
+	level=("${next[@]}")
+done
+
+n=0
+for dir in "${all_dirs[@]}"; do
+	for i in $(seq 1 "$files"); do
+		n=$((n + 1))
+		file="$dir/f$i.conf"
+		printf "# file %d\nkey%d = value%d\nenabled = %d\n" $n $n $((n * 2)) $((n % 2)) > "$file"
+		if [ "$symlinks" -gt 0 ] && [ $((n % symlinks)) -eq 0 ]; then
+			ln -s "f$i.conf" "$dir/l$i.conf"
+		fi
+		if [ -n "$set_xattr" ] && [ $((n % xattrs)) -eq 0 ]; then
+			setfattr -n user.bench -v "$n" "$file"
+		fi
+	done
+done
+
+for i in $(seq 1 "$large"); do
+	awk -v n="$large_lines" 'BEGIN { for (i = 1; i <= n; i++) printf "key%d = value%d\n", i, i * 2 }' \
+		> "$root/large$i.conf"
+done
+
+# fixed timestamps, the results must not depend on when the tree was built
+find "$root" -exec touch -h -d "2020-01-01 00:00:00" {} +
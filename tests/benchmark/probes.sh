@@ -0,0 +1,122 @@
+#!/usr/bin/env bash
+
+# Probe throughput benchmark.
+#
+# Runs the file, textfilecontent54, filehash58 and fileextendedattribute
+# probes through OSCAP_PROBE_ROOT against a tree made by make_tree.sh and
+# writes one JSON object per probe with the collected items per second,
+# the number of syscalls (when strace is available) and the peak RSS to
+# tests/benchmark/probes.json in the build directory.
+#
+# Environment:
+#   OSCAP_BENCHMARK_TREE  make_tree.sh options (default: -d 10 -f 100 -l 2)
+
+. $builddir/tests/test_common.sh
+
+set -e -o pipefail
+
+tree_options="${OSCAP_BENCHMARK_TREE:--d 10 -f 100 -l 2}"
+output="$builddir/tests/benchmark/probes.json"
+
+# definitions PROBE NAMESPACE OBJECT_CONTENT
+function definitions {
+	cat <<EOF
+<?xml version="1.0"?>
+<oval_definitions xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5" xmlns:oval="http://oval.mitre.org/XMLSchema/oval-common-5">
+  <generator>
+    <oval:schema_version>5.11</oval:schema_version>
+    <oval:timestamp>0001-01-01T00:00:00+00:00</oval:timestamp>
+  </generator>
+  <definitions>
+    <definition class="compliance" version="1" id="oval:x:def:1">
+      <metadata>
+        <title>$1</title>
+        <description>$1 benchmark</description>
+      </metadata>
+      <criteria>
+        <criterion test_ref="oval:x:tst:1"/>
+      </criteria>
+    </definition>
+  </definitions>
+  <tests>
+    <$1_test xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5#$2" id="oval:x:tst:1" version="1" check="all" check_existence="any_exist" comment="x">
+      <object object_ref="oval:x:obj:1"/>
+    </$1_test>
+  </tests>
+  <objects>
+    <$1_object xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5#$2" id="oval:x:obj:1" version="1">
+      <behaviors recurse="directories" recurse_direction="down" max_depth="-1"/>
+      <path>/bench</path>
+      $3
+    </$1_object>
+  </objects>
+</oval_definitions>
+EOF
+}
+
+# run_probe PROBE NAMESPACE OBJECT_CONTENT
+function run_probe {
+	local probe="$1"
+	local input="$tmpdir/$probe.xml"
+	local result="$tmpdir/$probe.results.xml"
+	local rss="" syscalls="null"
+
+	probecheck "$probe" || return 0
+	definitions "$@" > "$input"
+
+	local start=$(date +%s.%N)
+	if [ -x /usr/bin/time ]; then
+		OSCAP_PROBE_ROOT="$root" /usr/bin/time -f "%M" -o "$tmpdir/$probe.rss" \
+			$OSCAP oval eval --results "$result" "$input" > /dev/null
+		rss=$(tail -n 1 "$tmpdir/$probe.rss")
+	else
+		OSCAP_PROBE_ROOT="$root" $OSCAP oval eval --results "$result" "$input" > /dev/null
+	fi
+	local end=$(date +%s.%N)
+
+	# a separate run, strace slows the probes down too much to be timed
+	if command -v strace > /dev/null; then
+		OSCAP_PROBE_ROOT="$root" strace -f -c -o "$tmpdir/$probe.strace" \
+			$OSCAP oval eval "$input" > /dev/null
+		syscalls=$(awk '$NF == "total" { print $(NF - 2) }' "$tmpdir/$probe.strace")
+	fi
+
+	local items=$($XPATH "$result" 'count(/oval_results/results/system/oval_system_characteristics/system_data/*)')
+	awk -v probe="$probe" -v items="$items" -v start="$start" -v end="$end" \
+		-v syscalls="${syscalls:-null}" -v rss="${rss:-null}" 'BEGIN {
+		seconds = end - start
+		printf "{\"benchmark\": \"%s\", \"items\": %d, \"seconds\": %.3f, \"items_per_sec\": %.1f, \"syscalls\": %s, \"peak_rss_kb\": %s}\n",
+			probe, items, seconds, seconds > 0 ? items / seconds : 0, syscalls, rss
+	}' | tee -a "$output"
+}
+
+function probes_benchmark {
+	[ -n "$XPATH" ] || return 255
+
+	tmpdir=$(mktemp -d)
+	root="$tmpdir/root"
+
+	"$srcdir/make_tree.sh" $tree_options "$root"
+	: > "$output"
+
+	run_probe file unix \
+		'<filename operation="pattern match">.*</filename>'
+	run_probe textfilecontent54 independent \
+		'<filename operation="pattern match">\.conf$</filename>
+      <pattern operation="pattern match">^key(\d+) = (.*)$</pattern>
+      <instance datatype="int" operation="greater than or equal">1</instance>'
+	run_probe filehash58 independent \
+		'<filename operation="pattern match">.*</filename>
+      <hash_type>SHA-256</hash_type>'
+	run_probe fileextendedattribute unix \
+		'<filename operation="pattern match">.*</filename>
+      <attribute_name operation="pattern match">.*</attribute_name>'
+
+	rm -rf "$tmpdir"
+}
+
+test_init
+
+test_run "probe throughput benchmark" probes_benchmark
+
+test_exit
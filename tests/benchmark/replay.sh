@@ -0,0 +1,143 @@
+#!/usr/bin/env bash
+
+# Evaluation benchmark replaying recorded system characteristics.
+#
+# Evaluates OVAL definitions against recorded system characteristics using
+# 'oscap oval eval --syschar-input', nothing is probed and the time spent
+# in the evaluate phase depends only on the evaluation engine. By default
+# the system characteristics are recorded first from a tree made by
+# make_tree.sh. Writes one JSON object with the evaluation time to
+# tests/benchmark/replay.json in the build directory.
+#
+# Environment:
+#   OSCAP_BENCHMARK_REPLAY_DEFINITIONS  OVAL definitions to evaluate
+#   OSCAP_BENCHMARK_REPLAY_SYSCHAR      system characteristics recorded for them
+#   OSCAP_BENCHMARK_REPLAY_RUNS         number of evaluations (default: 5)
+#   OSCAP_BENCHMARK_TREE                make_tree.sh options (default: -d 10 -f 100 -l 2)
+
+. $builddir/tests/test_common.sh
+
+set -e -o pipefail
+
+runs="${OSCAP_BENCHMARK_REPLAY_RUNS:-5}"
+tree_options="${OSCAP_BENCHMARK_TREE:--d 10 -f 100 -l 2}"
+output="$builddir/tests/benchmark/replay.json"
+
+function definitions {
+	cat <<EOF
+<?xml version="1.0"?>
+<oval_definitions xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5" xmlns:oval="http://oval.mitre.org/XMLSchema/oval-common-5" xmlns:unix-def="http://oval.mitre.org/XMLSchema/oval-definitions-5#unix" xmlns:ind-def="http://oval.mitre.org/XMLSchema/oval-definitions-5#independent">
+  <generator>
+    <oval:schema_version>5.11</oval:schema_version>
+    <oval:timestamp>0001-01-01T00:00:00+00:00</oval:timestamp>
+  </generator>
+  <definitions>
+    <definition class="compliance" version="1" id="oval:x:def:1">
+      <metadata>
+        <title>files</title>
+        <description>files are owned by root and not world writable</description>
+      </metadata>
+      <criteria>
+        <criterion test_ref="oval:x:tst:1"/>
+        <criterion test_ref="oval:x:tst:2" negate="true"/>
+      </criteria>
+    </definition>
+    <definition class="compliance" version="1" id="oval:x:def:2">
+      <metadata>
+        <title>content</title>
+        <description>keys have even values</description>
+      </metadata>
+      <criteria>
+        <criterion test_ref="oval:x:tst:3"/>
+      </criteria>
+    </definition>
+  </definitions>
+  <tests>
+    <unix-def:file_test id="oval:x:tst:1" version="1" check="all" comment="x">
+      <unix-def:object object_ref="oval:x:obj:1"/>
+      <unix-def:state state_ref="oval:x:ste:1"/>
+    </unix-def:file_test>
+    <unix-def:file_test id="oval:x:tst:2" version="1" check="at least one" comment="x">
+      <unix-def:object object_ref="oval:x:obj:1"/>
+      <unix-def:state state_ref="oval:x:ste:2"/>
+    </unix-def:file_test>
+    <ind-def:textfilecontent54_test id="oval:x:tst:3" version="1" check="all" comment="x">
+      <ind-def:object object_ref="oval:x:obj:2"/>
+      <ind-def:state state_ref="oval:x:ste:3"/>
+    </ind-def:textfilecontent54_test>
+  </tests>
+  <objects>
+    <unix-def:file_object id="oval:x:obj:1" version="1">
+      <unix-def:behaviors recurse="directories" recurse_direction="down" max_depth="-1"/>
+      <unix-def:path>/bench</unix-def:path>
+      <unix-def:filename operation="pattern match">.*</unix-def:filename>
+    </unix-def:file_object>
+    <ind-def:textfilecontent54_object id="oval:x:obj:2" version="1">
+      <ind-def:behaviors recurse="directories" recurse_direction="down" max_depth="-1"/>
+      <ind-def:path>/bench</ind-def:path>
+      <ind-def:filename operation="pattern match">\.conf$</ind-def:filename>
+      <ind-def:pattern operation="pattern match">^key\d+ = value(\d+)$</ind-def:pattern>
+      <ind-def:instance datatype="int" operation="greater than or equal">1</ind-def:instance>
+    </ind-def:textfilecontent54_object>
+  </objects>
+  <states>
+    <unix-def:file_state id="oval:x:ste:1" version="1">
+      <unix-def:user_id datatype="int" operation="equals">0</unix-def:user_id>
+    </unix-def:file_state>
+    <unix-def:file_state id="oval:x:ste:2" version="1">
+      <unix-def:owrite datatype="boolean">true</unix-def:owrite>
+    </unix-def:file_state>
+    <ind-def:textfilecontent54_state id="oval:x:ste:3" version="1">
+      <ind-def:subexpression operation="pattern match">[02468]$</ind-def:subexpression>
+    </ind-def:textfilecontent54_state>
+  </states>
+</oval_definitions>
+EOF
+}
+
+function replay_benchmark {
+	[ -n "$PREFERRED_PYTHON" ] || return 255
+
+	local tmpdir=$(mktemp -d)
+	local defs="$OSCAP_BENCHMARK_REPLAY_DEFINITIONS"
+	local syschar="$OSCAP_BENCHMARK_REPLAY_SYSCHAR"
+
+	if [ -z "$defs" ] || [ -z "$syschar" ]; then
+		probecheck "file" || return 255
+		probecheck "textfilecontent54" || return 255
+
+		defs="$tmpdir/replay.xml"
+		syschar="$tmpdir/replay.syschar.xml"
+		definitions > "$defs"
+		"$srcdir/make_tree.sh" $tree_options "$tmpdir/root"
+		OSCAP_PROBE_ROOT="$tmpdir/root" $OSCAP oval collect --syschar "$syschar" "$defs" > /dev/null
+	fi
+
+	for i in $(seq 1 "$runs"); do
+		$OSCAP oval eval --syschar-input "$syschar" --profiling "$tmpdir/replay.$i.json" \
+			--results "$tmpdir/replay.results.xml" "$defs" > /dev/null
+	done
+
+	$PREFERRED_PYTHON - "$tmpdir"/replay.*.json <<'PY' | tee "$output"
+import json
+import sys
+
+runs = [json.load(open(path)) for path in sys.argv[1:]]
+evaluate = sorted(run["phases"]["evaluate"]["wall_time"] for run in runs)
+print(json.dumps({
+    "benchmark": "replay",
+    "runs": len(runs),
+    "evaluate_min": evaluate[0],
+    "evaluate_median": evaluate[len(evaluate) // 2],
+    "peak_rss": max(run["process"]["peak_rss"] for run in runs),
+}))
+PY
+
+	rm -rf "$tmpdir"
+}
+
+test_init
+
+test_run "replay evaluation benchmark" replay_benchmark
+
+test_exit
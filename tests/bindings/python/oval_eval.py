@@ -19,6 +19,7 @@ Tested functions:
     - oval_result_definition.get_id()
     - oval_result_definition.get_result()
     - oval_result_definition.get_criteria()
+    - oscap.oval.agent_get_definition_results
 
 Tested in oval_helpers.browse_criteria:
     - oval_result_criteria.get_type() + some of associated constants OVAL_NODETYPE_*
@@ -105,6 +106,12 @@ def oval_eval_sample(oval_defs):
         else:
             print(tmp)
 
+    # the bulk access gives the results the callback got
+    for (def_id, result) in oscap.oval.agent_get_definition_results(sess):
+        if def_id + " => " + result2str(result) not in states['results']:
+            raise ValueError("Unexpected bulk result of {0}: {1}"
+                             .format(def_id, result2str(result)))
+
 '''
        ================        MAIN TEST           ====================
 '''
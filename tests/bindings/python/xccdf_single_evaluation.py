@@ -49,5 +49,12 @@ for rule in rules:
         raise ValueError("Result value of {0} should be {1} but is {2}"
                          .format(rule[0], rule[1], rr.get_result()))
 
+    # the same result from the bulk access to the rule results
+    results = dict((idref, result) for (idref, result, severity, weight)
+                   in sess.get_rule_results())
+    if results.get(rule[0]) != rule[1]:
+        raise ValueError("Bulk result of {0} should be {1} but is {2}"
+                         .format(rule[0], rule[1], results.get(rule[0])))
+
 # release session
 sess.free()
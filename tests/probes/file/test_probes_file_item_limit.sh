@@ -0,0 +1,40 @@
+#!/usr/bin/env bash
+
+# Without the system characteristics the objects of the tests with no state
+# are collected only until the items found decide the tests. The objects
+# are incomplete then, the results stay the same.
+
+set -e -o pipefail
+
+. $builddir/tests/test_common.sh
+
+probecheck "file" || exit 255
+
+name=$(basename $0 .sh)
+result=$(mktemp ${name}.out.XXXXXX)
+stderr=$(mktemp ${name}.err.XXXXXX)
+
+rm -rf /tmp/test_probes_file_item_limit
+mkdir -p /tmp/test_probes_file_item_limit
+touch /tmp/test_probes_file_item_limit/{a,b,c,d,e}
+
+$OSCAP xccdf eval --without-syschar --verbose INFO --results $result "$srcdir/$name.xccdf.xml" 2> $stderr
+
+incomplete="Only some of items matching object"
+complete="All items matching object"
+grep -q "$incomplete 'oval:x:obj:1'" $stderr
+grep -q "$incomplete 'oval:x:obj:2'" $stderr
+grep -q "$complete 'oval:x:obj:3'" $stderr
+grep -q "$complete 'oval:x:obj:4'" $stderr
+assert_exists 1 '//rule-result[@idref="xccdf_moc.elpmaxe.www_rule_1"]/result[text()="pass"]'
+
+# all the items are collected for the system characteristics
+:> $stderr
+$OSCAP xccdf eval --verbose INFO --results-arf $result "$srcdir/$name.xccdf.xml" 2> $stderr
+
+grep -q "$incomplete" $stderr && false
+grep -q "$complete 'oval:x:obj:1'" $stderr
+grep -q "$complete 'oval:x:obj:2'" $stderr
+
+rm -rf /tmp/test_probes_file_item_limit
+rm $result $stderr
@@ -0,0 +1,43 @@
+#!/usr/bin/env bash
+
+# The set objects report each item once, whatever the order of the items
+# of the combined objects.
+
+set -e -o pipefail
+
+. $builddir/tests/test_common.sh
+
+probecheck "file" || exit 255
+
+name=$(basename $0 .sh)
+result=$(mktemp ${name}.out.XXXXXX)
+stderr=$(mktemp ${name}.err.XXXXXX)
+
+rm -rf /tmp/test_probes_file_set
+mkdir -p /tmp/test_probes_file_set
+touch /tmp/test_probes_file_set/{a,b,c,d}
+
+$OSCAP oval eval --results $result "$srcdir/$name.xml" 2> $stderr
+[ ! -s $stderr ]
+
+collected="/oval_results/results/system/oval_system_characteristics/collected_objects"
+items="/oval_results/results/system/oval_system_characteristics/system_data/*"
+
+# the items of the object are the given files
+function assert_files {
+	local obj="$1"; shift
+	assert_exists $# "$collected/object[@id=\"$obj\"]/reference"
+	for file in "$@"; do
+		assert_exists 1 "$items[@id = $collected/object[@id=\"$obj\"]/reference/@item_ref][filename=\"$file\"]"
+	done
+}
+
+assert_files "oval:x:obj:10" a b c
+assert_files "oval:x:obj:11" b
+assert_files "oval:x:obj:12" a
+assert_files "oval:x:obj:13" a b
+assert_files "oval:x:obj:14" a b
+assert_exists 1 '/oval_results/results/system/definitions/definition[@definition_id="oval:x:def:1"][@result="true"]'
+
+rm -rf /tmp/test_probes_file_set
+rm $result $stderr
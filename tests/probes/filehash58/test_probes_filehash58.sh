@@ -120,6 +120,46 @@ function test_probes_filehash58_chroot_fail {
 	return $ret_val
 }
 
+# The digests of unchanged files are read from the digest cache.
+function test_probes_filehash58_digest_cache {
+
+    probecheck "filehash58" || return 255
+
+    local DF="$srcdir/check_filehash_simple.xml"
+    local cache="$(pwd)/digest_cache/digests"
+    local sha256_bar="7d865e959b2466918c9863afca942d0fb89d7c9ac0c99bafc3749504ded97730"
+    local result_keyword
+
+    rm -rf cached digest_cache
+    mkdir -p cached
+    echo foo > cached/oval-test
+    absolute_probe_root=$(cd cached && pwd)
+    # digests of files changed in the last seconds are not stored
+    sleep 3
+
+    result_keyword=$(OSCAP_PROBE_ROOT="$absolute_probe_root" $OSCAP oval eval --digest-cache "$cache" "$DF" | grep oval_test_has_hash | grep -o '\w*$')
+    [ "$result_keyword" == "true" ] || return 1
+    [ "$(stat -c %a "$cache")" == "600" ] || return 1
+    head -n 1 "$cache" | grep -q "^# OpenSCAP digest cache" || return 1
+    grep -q " b5bb9d8014a0f9b1d61e21e796d78dccdf1352f23cd32812f4850b878ae4944c$" "$cache" || return 1
+
+    # the digest of the unchanged file is not computed again
+    sed -i "s/ b5bb9d8014a0f9b1d61e21e796d78dccdf1352f23cd32812f4850b878ae4944c$/ $sha256_bar/" "$cache"
+    result_keyword=$(OSCAP_PROBE_ROOT="$absolute_probe_root" $OSCAP oval eval --digest-cache "$cache" "$DF" | grep oval_test_has_hash | grep -o '\w*$')
+    [ "$result_keyword" == "false" ] || return 1
+
+    result_keyword=$(OSCAP_DIGEST_CACHE="$cache" OSCAP_PROBE_ROOT="$absolute_probe_root" $OSCAP oval eval --no-digest-cache "$DF" | grep oval_test_has_hash | grep -o '\w*$')
+    [ "$result_keyword" == "true" ] || return 1
+
+    # the changed file is hashed again
+    echo foo > cached/oval-test
+    result_keyword=$(OSCAP_PROBE_ROOT="$absolute_probe_root" $OSCAP oval eval --digest-cache "$cache" "$DF" | grep oval_test_has_hash | grep -o '\w*$')
+    [ "$result_keyword" == "true" ] || return 1
+
+    rm -rf cached digest_cache
+    return 0
+}
+
 # Testing.
 
 test_init
@@ -134,4 +174,6 @@ test_run "test_probes_filehash58_chroot_fail" test_probes_filehash58_chroot_fail
 
 test_run "test_probes_filehash58_chroot_pass" test_probes_filehash58_chroot_pass
 
+test_run "test_probes_filehash58_digest_cache" test_probes_filehash58_digest_cache
+
 test_exit
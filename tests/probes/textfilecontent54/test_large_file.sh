@@ -0,0 +1,44 @@
+#!/usr/bin/env bash
+. $builddir/tests/test_common.sh
+
+set -e -o pipefail
+
+name=$(basename $0 .sh)
+tmpdir=$(make_temp_dir /tmp ${name})
+tpl=${srcdir}/${name}.xml.tpl
+input=${tmpdir}/${name}.xml
+result=${tmpdir}/${name}.results.xml
+echo "Temp dir: $tmpdir"
+
+# prepare the environment
+sed "s@%PATH%@${tmpdir}@" $tpl > $input
+for i in $(seq 1 5000); do
+	echo "key$i = value$((i * 2))"
+done > "${tmpdir}/large.conf"
+
+for i in $(seq 1 100000); do
+	echo "key$i = value$((i * 2))"
+done > "${tmpdir}/huge.conf"
+
+function check_results {
+	echo "Evaluating content."
+	$OSCAP oval eval --results $result $input || [ $? == 2 ]
+	echo "Validating results."
+	$OSCAP oval validate --results $result
+	echo "Testing results."
+	for i in $(seq 1 6); do
+		[ "$($XPATH $result 'string(/oval_results/results/system/tests/test[@test_id="oval:x:tst:'$i'"]/@result)')" == "true" ]
+	done
+	echo "Testing syschar values."
+	[ "$($XPATH $result 'count(/oval_results/results/system/oval_system_characteristics/collected_objects/object[@id="oval:x:obj:1"]/reference)')" == "5000" ]
+	[ "$($XPATH $result 'count(/oval_results/results/system/oval_system_characteristics/collected_objects/object[@id="oval:x:obj:2"]/reference)')" == "1" ]
+	[ "$($XPATH $result 'count(/oval_results/results/system/oval_system_characteristics/collected_objects/object[@id="oval:x:obj:4"]/reference)')" == "1" ]
+	[ "$($XPATH $result 'count(/oval_results/results/system/oval_system_characteristics/collected_objects/object[@id="oval:x:obj:5"]/reference)')" == "1" ]
+	[ "$($XPATH $result 'count(/oval_results/results/system/oval_system_characteristics/collected_objects/object[@id="oval:x:obj:6"]/reference)')" == "1" ]
+}
+
+check_results
+# the same results when the files are matched in windows of lines
+OSCAP_TEXTFILE_STREAM_SIZE=0 check_results
+
+rm -rf $tmpdir
@@ -0,0 +1,113 @@
+<?xml version="1.0"?>
+<oval_definitions xmlns:oval-def="http://oval.mitre.org/XMLSchema/oval-definitions-5" xmlns:oval="http://oval.mitre.org/XMLSchema/oval-common-5" xmlns:xsi="http://www.w3.org/2001/XMLSchema-instance" xmlns:ind-def="http://oval.mitre.org/XMLSchema/oval-definitions-5#independent" xmlns:unix-def="http://oval.mitre.org/XMLSchema/oval-definitions-5#unix" xmlns:lin-def="http://oval.mitre.org/XMLSchema/oval-definitions-5#linux" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5" xsi:schemaLocation="http://oval.mitre.org/XMLSchema/oval-definitions-5#unix unix-definitions-schema.xsd http://oval.mitre.org/XMLSchema/oval-definitions-5#independent independent-definitions-schema.xsd http://oval.mitre.org/XMLSchema/oval-definitions-5#linux linux-definitions-schema.xsd http://oval.mitre.org/XMLSchema/oval-definitions-5 oval-definitions-schema.xsd http://oval.mitre.org/XMLSchema/oval-common-5 oval-common-schema.xsd">
+    <generator>
+        <oval:schema_version>5.10.1</oval:schema_version>
+        <oval:timestamp>0001-01-01T00:00:00+00:00</oval:timestamp>
+    </generator>
+
+    <definitions>
+        <definition class="compliance" version="1" id="oval:x:def:1">
+            <metadata>
+                <title>x</title>
+                <description>x</description>
+                <affected family="unix">
+                    <platform>x</platform>
+                </affected>
+            </metadata>
+            <criteria comment="x">
+                <criterion test_ref="oval:x:tst:1"/>
+                <criterion test_ref="oval:x:tst:2"/>
+                <criterion test_ref="oval:x:tst:3"/>
+                <criterion test_ref="oval:x:tst:4"/>
+                <criterion test_ref="oval:x:tst:5"/>
+                <criterion test_ref="oval:x:tst:6"/>
+            </criteria>
+        </definition>
+    </definitions>
+
+    <tests>
+        <textfilecontent54_test id="oval:x:tst:1" check="all" check_existence="at_least_one_exists" comment="every line of a file bigger than the initial read is an instance" version="1" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5#independent">
+            <object object_ref="oval:x:obj:1"/>
+        </textfilecontent54_test>
+        <textfilecontent54_test id="oval:x:tst:2" check="all" comment="subexpressions of an instance far in the file" version="1" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5#independent">
+            <object object_ref="oval:x:obj:2"/>
+            <state state_ref="oval:x:ste:2"/>
+        </textfilecontent54_test>
+        <textfilecontent54_test id="oval:x:tst:3" check="all" check_existence="at_least_one_exists" comment="files reporting no size are read too" version="1" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5#independent">
+            <object object_ref="oval:x:obj:3"/>
+        </textfilecontent54_test>
+        <textfilecontent54_test id="oval:x:tst:4" check="all" comment="an instance in a file bigger than the window of lines" version="1" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5#independent">
+            <object object_ref="oval:x:obj:4"/>
+            <state state_ref="oval:x:ste:4"/>
+        </textfilecontent54_test>
+        <textfilecontent54_test id="oval:x:tst:5" check="all" comment="^ matches at the start of the file only" version="1" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5#independent">
+            <object object_ref="oval:x:obj:5"/>
+            <state state_ref="oval:x:ste:5"/>
+        </textfilecontent54_test>
+        <textfilecontent54_test id="oval:x:tst:6" check="all" comment="$ matches at the end of the file only" version="1" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5#independent">
+            <object object_ref="oval:x:obj:6"/>
+            <state state_ref="oval:x:ste:6"/>
+        </textfilecontent54_test>
+    </tests>
+
+    <objects>
+        <textfilecontent54_object id="oval:x:obj:1" version="1" comment="x" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5#independent">
+            <behaviors multiline="true"/>
+            <path datatype="string" operation="equals">%PATH%</path>
+            <filename datatype="string" operation="equals">large.conf</filename>
+            <pattern datatype="string" operation="pattern match">^key(\d+) = value(\d+)$</pattern>
+            <instance datatype="int" operation="greater than or equal">1</instance>
+        </textfilecontent54_object>
+        <textfilecontent54_object id="oval:x:obj:2" version="1" comment="x" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5#independent">
+            <behaviors multiline="true"/>
+            <path datatype="string" operation="equals">%PATH%</path>
+            <filename datatype="string" operation="equals">large.conf</filename>
+            <pattern datatype="string" operation="pattern match">^key(\d+) = value(\d+)$</pattern>
+            <instance datatype="int" operation="equals">4321</instance>
+        </textfilecontent54_object>
+        <textfilecontent54_object id="oval:x:obj:3" version="1" comment="x" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5#independent">
+            <behaviors multiline="true"/>
+            <path datatype="string" operation="equals">/proc/self</path>
+            <filename datatype="string" operation="equals">status</filename>
+            <pattern datatype="string" operation="pattern match">^Name:\s+(\S+)$</pattern>
+            <instance datatype="int" operation="equals">1</instance>
+        </textfilecontent54_object>
+        <textfilecontent54_object id="oval:x:obj:4" version="1" comment="x" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5#independent">
+            <behaviors multiline="true"/>
+            <path datatype="string" operation="equals">%PATH%</path>
+            <filename datatype="string" operation="equals">huge.conf</filename>
+            <pattern datatype="string" operation="pattern match">^key(\d+) = value(\d+)$</pattern>
+            <instance datatype="int" operation="equals">98765</instance>
+        </textfilecontent54_object>
+        <textfilecontent54_object id="oval:x:obj:5" version="1" comment="x" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5#independent">
+            <behaviors multiline="false"/>
+            <path datatype="string" operation="equals">%PATH%</path>
+            <filename datatype="string" operation="equals">huge.conf</filename>
+            <pattern datatype="string" operation="pattern match">^key(\d+) </pattern>
+            <instance datatype="int" operation="greater than or equal">1</instance>
+        </textfilecontent54_object>
+        <textfilecontent54_object id="oval:x:obj:6" version="1" comment="x" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5#independent">
+            <behaviors multiline="false"/>
+            <path datatype="string" operation="equals">%PATH%</path>
+            <filename datatype="string" operation="equals">huge.conf</filename>
+            <pattern datatype="string" operation="pattern match">value(\d+)$</pattern>
+            <instance datatype="int" operation="greater than or equal">1</instance>
+        </textfilecontent54_object>
+    </objects>
+
+    <states>
+        <textfilecontent54_state id="oval:x:ste:2" version="1" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5#independent">
+            <text datatype="string" operation="equals">key4321 = value8642</text>
+            <subexpression datatype="string" operation="equals" entity_check="at least one">4321</subexpression>
+        </textfilecontent54_state>
+        <textfilecontent54_state id="oval:x:ste:4" version="1" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5#independent">
+            <text datatype="string" operation="equals">key98765 = value197530</text>
+        </textfilecontent54_state>
+        <textfilecontent54_state id="oval:x:ste:5" version="1" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5#independent">
+            <subexpression datatype="string" operation="equals" entity_check="all">1</subexpression>
+        </textfilecontent54_state>
+        <textfilecontent54_state id="oval:x:ste:6" version="1" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5#independent">
+            <subexpression datatype="string" operation="equals" entity_check="all">200000</subexpression>
+        </textfilecontent54_state>
+    </states>
+</oval_definitions>
@@ -107,38 +107,17 @@ cleanup:
         return result;
 }
 
-static int app_cve_find(const struct oscap_action *action)
+static int app_cve_find_print(const struct cve_entry *entry, void *arg)
 {
-        struct cve_model *model = NULL;
-        struct cve_entry *entry = NULL;
-	struct cve_entry_iterator *entry_it;
 	const struct cvss_impact *cvss;
         struct cvss_metrics *metrics;
         float base_score;
 	char * vector;
-	int result;
 	struct cve_product_iterator *prod_it;
 	struct cve_product *product;
 
-	model = cve_model_import(action->cve_action->file);
-	if(!model) {
-		result=OSCAP_ERROR;
-		goto cleanup;
-	}
-
-	entry_it = cve_model_get_entries(model);
-	while (cve_entry_iterator_has_more(entry_it)) {
-		entry = cve_entry_iterator_next(entry_it);
-		if (!strcmp(cve_entry_get_id(entry), action->cve_action->cve))
-			break;
-		entry = NULL;
-	}
-	cve_entry_iterator_free(entry_it);
-
-	if (!entry) {
-		result=OSCAP_FAIL;
-		goto cleanup;
-	}
+	if (strcmp(cve_entry_get_id(entry), (const char *) arg))
+		return 0;
 
 	printf("ID: %s\n", cve_entry_get_id(entry));
 
@@ -162,14 +141,29 @@ static int app_cve_find(const struct oscap_action *action)
 	}
 	cve_product_iterator_free(prod_it);
 
-	result=OSCAP_OK;
+	/* found, stop reading the feed */
+	return 1;
+}
+
+static int app_cve_find(const struct oscap_action *action)
+{
+	int result;
+
+	/* the feed is read one entry at a time, only the current one is in memory */
+	switch (cve_model_import_stream(action->cve_action->file, NULL, app_cve_find_print, action->cve_action->cve)) {
+	case 1:
+		result=OSCAP_OK;
+		break;
+	case 0:
+		result=OSCAP_FAIL;
+		break;
+	default:
+		result=OSCAP_ERROR;
+	}
 
-cleanup:
         if (oscap_err())
                 fprintf(stderr, "%s %s\n", OSCAP_ERR_MSG, oscap_err_desc());
 
-        if (model)
-		cve_model_free(model);
         free(action->cve_action);
         return result;
 }
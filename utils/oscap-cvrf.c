@@ -103,13 +103,18 @@ static int app_cvrf_evaluate(const struct oscap_action *action) {
 	if (import_source == NULL)
 		return OSCAP_ERROR;
 
-	int ret = oscap_source_validate(import_source, reporter, (void *) action);
-	if (ret != 0) {
-		result = OSCAP_ERROR;
-		goto cleanup;
+	struct oscap_source *export_source;
+	if (action->cvrf_action->index == 1) {
+		// The index is a plain list of files, the documents are evaluated in parallel
+		export_source = cvrf_index_get_results_source(import_source, os_name);
+	} else {
+		int ret = oscap_source_validate(import_source, reporter, (void *) action);
+		if (ret != 0) {
+			result = OSCAP_ERROR;
+			goto cleanup;
+		}
+		export_source = cvrf_model_get_results_source(import_source, os_name);
 	}
-
-	struct oscap_source *export_source = cvrf_model_get_results_source(import_source, os_name);
 	if (export_source == NULL) {
 		result = OSCAP_ERROR;
 		goto cleanup;
@@ -0,0 +1,406 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/* Standard header files */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef HAVE_GETOPT_H
+#include <getopt.h>
+#endif
+#include <assert.h>
+#include <errno.h>
+#ifndef OS_WINDOWS
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#endif
+#if defined(HAVE_SYSLOG_H)
+#include <syslog.h>
+#endif
+
+#include <oscap.h>
+#include <xccdf_session.h>
+
+#include "oscap-tool.h"
+
+/* Maximal number of sessions, one for each tailoring file, kept loaded */
+#define DAEMON_MAX_SESSIONS 4
+
+static bool getopt_daemon(int argc, char **argv, struct oscap_action *action);
+static int app_daemon(const struct oscap_action *action);
+
+struct oscap_module OSCAP_DAEMON_MODULE = {
+    .name = "daemon",
+    .parent = &OSCAP_ROOT_MODULE,
+    .summary = "Keep the content loaded and evaluate it on request",
+    .usage = "[options] --socket <path> INPUT_FILE",
+    .help =
+		"INPUT_FILE - XCCDF file or a source data stream file\n\n"
+		"Options:\n"
+		"   --socket <path>               - UNIX socket to accept the scan requests on. Only the owner\n"
+		"                                   of the daemon process can connect to it.\n"
+		"   --datastream-id <id>          - ID of the data stream in the collection to use.\n"
+		"                                   (only applicable for source data streams)\n"
+		"   --xccdf-id <id>               - ID of component-ref with XCCDF in the data stream that should be evaluated.\n"
+		"                                   (only applicable for source data streams)\n"
+		"   --benchmark-id <id>           - ID of XCCDF Benchmark in some component in the data stream that should be evaluated.\n"
+		"                                   (only applicable for source data streams)\n"
+		"   --fetch-remote-resources      - Download remote content referenced by XCCDF.\n"
+		"   --local-files <dir>           - Use locally downloaded copies of remote resources stored in the given directory.\n"
+		"   --skip-validation             - Skip validation.\n"
+		"   --skip-signature-validation   - Skip data stream signature validation.\n"
+		"   --enforce-signature           - Process only signed data streams.\n\n"
+		"A scan request is a sequence of lines 'name value' terminated by an empty line.\n"
+		"The names are 'profile', 'tailoring-file', 'results', 'results-arf' and 'report',\n"
+		"they have the same meaning as the options of 'oscap xccdf eval'. The reply is a line\n"
+		"with the exit code 'oscap xccdf eval' would return.",
+    .opt_parser = getopt_daemon,
+    .func = app_daemon
+};
+
+enum oscap_daemon_opts {
+	DAEMON_OPT_SOCKET = 1,
+	DAEMON_OPT_DATASTREAM_ID,
+	DAEMON_OPT_XCCDF_ID,
+	DAEMON_OPT_BENCHMARK_ID,
+	DAEMON_OPT_LOCAL_FILES,
+};
+
+static bool getopt_daemon(int argc, char **argv, struct oscap_action *action)
+{
+	assert(action != NULL);
+
+	action->validate = 1;
+	action->validate_signature = 1;
+
+	const struct option long_options[] = {
+		{"socket",			required_argument, NULL, DAEMON_OPT_SOCKET},
+		{"datastream-id",		required_argument, NULL, DAEMON_OPT_DATASTREAM_ID},
+		{"xccdf-id",			required_argument, NULL, DAEMON_OPT_XCCDF_ID},
+		{"benchmark-id",		required_argument, NULL, DAEMON_OPT_BENCHMARK_ID},
+		{"local-files",			required_argument, NULL, DAEMON_OPT_LOCAL_FILES},
+		{"fetch-remote-resources",	no_argument, &action->remote_resources, 1},
+		{"skip-validation",		no_argument, &action->validate, 0},
+		{"skip-signature-validation",	no_argument, &action->validate_signature, 0},
+		{"enforce-signature",		no_argument, &action->enforce_signature, 1},
+		// end
+		{0, 0, 0, 0}
+	};
+
+	int c;
+	while ((c = getopt_long(argc, argv, "", long_options, NULL)) != -1) {
+		switch (c) {
+		case 0: break;
+		case DAEMON_OPT_SOCKET:		action->f_socket = optarg; break;
+		case DAEMON_OPT_DATASTREAM_ID:	action->f_datastream_id = optarg; break;
+		case DAEMON_OPT_XCCDF_ID:	action->f_xccdf_id = optarg; break;
+		case DAEMON_OPT_BENCHMARK_ID:	action->f_benchmark_id = optarg; break;
+		case DAEMON_OPT_LOCAL_FILES:	action->local_files = optarg; break;
+		default: return oscap_module_usage(action->module, stderr, NULL);
+		}
+	}
+
+	if (action->f_socket == NULL)
+		return oscap_module_usage(action->module, stderr, "The --socket option needs to be specified!");
+	if (optind >= argc)
+		return oscap_module_usage(action->module, stderr, "XCCDF file or a source data stream file needs to be specified!");
+	action->f_xccdf = argv[optind];
+
+	return true;
+}
+
+#ifndef OS_WINDOWS
+
+struct daemon_session {
+	char *tailoring_file;
+	struct xccdf_session *session;
+};
+
+struct daemon_request {
+	char *profile;
+	char *tailoring_file;
+	char *results;
+	char *results_arf;
+	char *report;
+};
+
+static volatile sig_atomic_t daemon_stop = 0;
+
+static void daemon_signal_handler(int sig)
+{
+	daemon_stop = 1;
+}
+
+static struct xccdf_session *daemon_session_load(const struct oscap_action *action, const char *tailoring_file)
+{
+	struct xccdf_session *session = xccdf_session_new(action->f_xccdf);
+	if (session == NULL)
+		return NULL;
+
+	xccdf_session_set_validation(session, action->validate, getenv("OSCAP_FULL_VALIDATION") != NULL);
+	xccdf_session_set_signature_validation(session, action->validate_signature);
+	xccdf_session_set_signature_enforcement(session, action->enforce_signature);
+	if (xccdf_session_is_sds(session)) {
+		xccdf_session_set_datastream_id(session, action->f_datastream_id);
+		xccdf_session_set_component_id(session, action->f_xccdf_id);
+		xccdf_session_set_benchmark_id(session, action->f_benchmark_id);
+	}
+	if (tailoring_file != NULL)
+		xccdf_session_set_user_tailoring_file(session, tailoring_file);
+	xccdf_session_configure_remote_resources(session, action->remote_resources, action->local_files, download_reporting_callback);
+	xccdf_session_set_product_cpe(session, OSCAP_PRODUCTNAME);
+
+	if (xccdf_session_load(session) != 0) {
+		xccdf_session_free(session);
+		return NULL;
+	}
+	return session;
+}
+
+/* The sessions are kept in the order of their last use, the most recent first */
+static struct xccdf_session *daemon_session_get(const struct oscap_action *action, struct daemon_session *sessions, const char *tailoring_file)
+{
+	int i;
+
+	for (i = 0; i < DAEMON_MAX_SESSIONS && sessions[i].session != NULL; i++) {
+		const char *loaded = sessions[i].tailoring_file;
+		if (loaded == tailoring_file || (loaded != NULL && tailoring_file != NULL && strcmp(loaded, tailoring_file) == 0))
+			break;
+	}
+	if (i == DAEMON_MAX_SESSIONS || sessions[i].session == NULL) {
+		struct xccdf_session *session = daemon_session_load(action, tailoring_file);
+		if (session == NULL)
+			return NULL;
+		if (i == DAEMON_MAX_SESSIONS) {
+			i--;
+			xccdf_session_free(sessions[i].session);
+			free(sessions[i].tailoring_file);
+		}
+		sessions[i].session = session;
+		sessions[i].tailoring_file = tailoring_file != NULL ? strdup(tailoring_file) : NULL;
+	}
+
+	struct daemon_session used = sessions[i];
+	memmove(&sessions[1], &sessions[0], i * sizeof(struct daemon_session));
+	sessions[0] = used;
+	return used.session;
+}
+
+static void daemon_session_drop(struct daemon_session *sessions, int i)
+{
+	xccdf_session_free(sessions[i].session);
+	free(sessions[i].tailoring_file);
+	memmove(&sessions[i], &sessions[i + 1], (DAEMON_MAX_SESSIONS - i - 1) * sizeof(struct daemon_session));
+	memset(&sessions[DAEMON_MAX_SESSIONS - 1], 0, sizeof(struct daemon_session));
+}
+
+static int daemon_scan(const struct oscap_action *action, struct daemon_session *sessions, const struct daemon_request *request)
+{
+	int result = OSCAP_ERROR;
+
+#if defined(HAVE_SYSLOG_H)
+	syslog(LOG_NOTICE, "Evaluation started. Content: %s, Profile: %s.", action->f_xccdf, request->profile);
+#endif
+	struct xccdf_session *session = daemon_session_get(action, sessions, request->tailoring_file);
+	if (session == NULL)
+		return OSCAP_ERROR;
+
+	if (!xccdf_session_set_profile_id(session, request->profile)) {
+		if (request->profile == NULL) {
+			fprintf(stderr, "No Policy was found for default profile.\n");
+			goto reset;
+		}
+		if (xccdf_set_profile_or_report_bad_id(session, request->profile, action->f_xccdf) == OSCAP_ERROR)
+			goto reset;
+	}
+
+	xccdf_session_set_arf_export(session, request->results_arf);
+	xccdf_session_set_xccdf_export(session, request->results);
+	xccdf_session_set_report_export(session, request->report);
+
+	if (xccdf_session_evaluate(session) != 0 ||
+	    xccdf_session_export_oval(session) != 0 ||
+	    xccdf_session_export_check_engine_plugins(session) != 0 ||
+	    xccdf_session_export_xccdf(session) != 0 ||
+	    xccdf_session_export_arf(session) != 0)
+		goto reset;
+
+	result = xccdf_session_contains_fail_result(session) ? OSCAP_FAIL : OSCAP_OK;
+#if defined(HAVE_SYSLOG_H)
+	syslog(LOG_NOTICE, "Evaluation finished. Return code: %d, Base score %f.", result, xccdf_session_get_base_score(session));
+#endif
+
+reset:
+	/* only the loaded content is kept for the next request */
+	if (xccdf_session_reset_results(session) != 0)
+		daemon_session_drop(sessions, 0);
+	return result;
+}
+
+static bool daemon_request_set(struct daemon_request *request, char *line)
+{
+	char *value = strchr(line, ' ');
+	if (value == NULL)
+		return false;
+	*value++ = '\0';
+
+	char **field = NULL;
+	if (strcmp(line, "profile") == 0)
+		field = &request->profile;
+	else if (strcmp(line, "tailoring-file") == 0)
+		field = &request->tailoring_file;
+	else if (strcmp(line, "results") == 0)
+		field = &request->results;
+	else if (strcmp(line, "results-arf") == 0)
+		field = &request->results_arf;
+	else if (strcmp(line, "report") == 0)
+		field = &request->report;
+	if (field == NULL)
+		return false;
+
+	free(*field);
+	*field = strdup(value);
+	return true;
+}
+
+static void daemon_request_clear(struct daemon_request *request)
+{
+	free(request->profile);
+	free(request->tailoring_file);
+	free(request->results);
+	free(request->results_arf);
+	free(request->report);
+	memset(request, 0, sizeof(*request));
+}
+
+static void daemon_serve(const struct oscap_action *action, struct daemon_session *sessions, int fd)
+{
+	FILE *stream = fdopen(fd, "r+");
+	if (stream == NULL) {
+		close(fd);
+		return;
+	}
+
+	struct daemon_request request;
+	char *line = NULL;
+	size_t size = 0;
+	ssize_t len;
+	bool valid = true;
+
+	memset(&request, 0, sizeof(request));
+	while ((len = getline(&line, &size, stream)) > 0) {
+		if (line[len - 1] == '\n')
+			line[--len] = '\0';
+		if (len == 0)
+			break;
+		if (!daemon_request_set(&request, line)) {
+			fprintf(stderr, "Invalid scan request line: %s\n", line);
+			valid = false;
+		}
+	}
+	free(line);
+
+	int result = valid ? daemon_scan(action, sessions, &request) : OSCAP_BADARGS;
+	oscap_print_error();
+	fprintf(stream, "%d\n", result);
+	fclose(stream);
+	daemon_request_clear(&request);
+}
+
+static int app_daemon(const struct oscap_action *action)
+{
+	struct daemon_session sessions[DAEMON_MAX_SESSIONS];
+	struct sockaddr_un addr;
+	int result = OSCAP_ERROR;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (strlen(action->f_socket) >= sizeof(addr.sun_path)) {
+		fprintf(stderr, "Socket path is too long: %s\n", action->f_socket);
+		return OSCAP_ERROR;
+	}
+	strcpy(addr.sun_path, action->f_socket);
+
+	/* the content is loaded before the first request */
+	memset(sessions, 0, sizeof(sessions));
+	if (daemon_session_get(action, sessions, NULL) == NULL) {
+		oscap_print_error();
+		return OSCAP_ERROR;
+	}
+
+	int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (sock < 0) {
+		fprintf(stderr, "Can't create socket: %s\n", strerror(errno));
+		goto cleanup;
+	}
+	mode_t old_umask = umask(0077);
+	int ret = bind(sock, (struct sockaddr *) &addr, sizeof(addr));
+	umask(old_umask);
+	if (ret != 0 || listen(sock, 8) != 0) {
+		fprintf(stderr, "Can't listen on socket %s: %s\n", action->f_socket, strerror(errno));
+		close(sock);
+		goto cleanup;
+	}
+
+	struct sigaction sa;
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = daemon_signal_handler;
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+	signal(SIGPIPE, SIG_IGN);
+
+	/* the requests are served one by one */
+	while (!daemon_stop) {
+		int fd = accept(sock, NULL, NULL);
+		if (fd < 0) {
+			if (errno == EINTR)
+				continue;
+			fprintf(stderr, "Can't accept connection: %s\n", strerror(errno));
+			break;
+		}
+		daemon_serve(action, sessions, fd);
+	}
+	result = daemon_stop ? OSCAP_OK : OSCAP_ERROR;
+
+	close(sock);
+	unlink(action->f_socket);
+cleanup:
+	for (int i = 0; i < DAEMON_MAX_SESSIONS; i++) {
+		xccdf_session_free(sessions[i].session);
+		free(sessions[i].tailoring_file);
+	}
+	return result;
+}
+
+#else
+
+static int app_daemon(const struct oscap_action *action)
+{
+	fprintf(stderr, "The daemon mode is not supported on this platform.\n");
+	return OSCAP_UNIMPL;
+}
+
+#endif
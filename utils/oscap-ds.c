@@ -49,7 +49,7 @@
 #include <oscap_debug.h>
 #include "oscap_helpers.h"
 
-#define DS_SUBMODULES_NUM 8 /* See actual DS_SUBMODULES array
+#define DS_SUBMODULES_NUM 9 /* See actual DS_SUBMODULES array
 				initialization below. */
 static struct oscap_module* DS_SUBMODULES[DS_SUBMODULES_NUM];
 bool getopt_ds(int argc, char **argv, struct oscap_action *action);
@@ -60,6 +60,7 @@ int app_ds_sds_validate(const struct oscap_action *action);
 int app_ds_rds_split(const struct oscap_action *action);
 int app_ds_rds_create(const struct oscap_action *action);
 int app_ds_rds_validate(const struct oscap_action *action);
+int app_ds_rds_inflate(const struct oscap_action *action);
 
 struct oscap_module OSCAP_DS_MODULE = {
 	.name = "ds",
@@ -158,6 +159,17 @@ static struct oscap_module DS_RDS_VALIDATE_MODULE = {
 	.func = app_ds_rds_validate
 };
 
+static struct oscap_module DS_RDS_INFLATE_MODULE = {
+	.name = "rds-inflate",
+	.parent = &OSCAP_DS_MODULE,
+	.summary = "Embed the source data stream into a result data stream which references it by digest",
+	.usage = "arf.xml target-arf.xml [sds.xml [tailoring.xml]]",
+	.help = "The source data stream and the tailoring file are read from the paths recorded\n"
+		"in the result data stream unless they are given.\n",
+	.opt_parser = getopt_ds,
+	.func = app_ds_rds_inflate
+};
+
 static struct oscap_module* DS_SUBMODULES[DS_SUBMODULES_NUM] = {
 	&DS_SDS_SPLIT_MODULE,
 	&DS_SDS_COMPOSE_MODULE,
@@ -166,6 +178,7 @@ static struct oscap_module* DS_SUBMODULES[DS_SUBMODULES_NUM] = {
 	&DS_RDS_SPLIT_MODULE,
 	&DS_RDS_CREATE_MODULE,
 	&DS_RDS_VALIDATE_MODULE,
+	&DS_RDS_INFLATE_MODULE,
 	NULL
 };
 
@@ -272,6 +285,18 @@ bool getopt_ds(int argc, char **argv, struct oscap_action *action) {
 		action->ds_action = malloc(sizeof(struct ds_action));
 		action->ds_action->file = argv[optind];
 	}
+	else if (action->module == &DS_RDS_INFLATE_MODULE) {
+		if (argc - optind < 2 || argc - optind > 4) {
+			oscap_module_usage(action->module, stderr, "Wrong number of parameters.\n");
+			return false;
+		}
+		action->ds_action = malloc(sizeof(struct ds_action));
+		action->ds_action->file = argv[optind];
+		action->ds_action->target = argv[optind + 1];
+		/* the source data stream and the tailoring file, both optional */
+		action->ds_action->oval_results = &argv[optind + 2];
+		action->ds_action->oval_result_count = argc - optind - 2;
+	}
 	return true;
 }
 
@@ -566,3 +591,22 @@ cleanup:
 	free(action->ds_action);
 	return ret;
 }
+
+int app_ds_rds_inflate(const struct oscap_action *action) {
+	int ret = OSCAP_ERROR;
+	const char *sds_file = action->ds_action->oval_result_count > 0 ? action->ds_action->oval_results[0] : NULL;
+	const char *tailoring_file = action->ds_action->oval_result_count > 1 ? action->ds_action->oval_results[1] : NULL;
+
+	if (ds_rds_inflate(action->ds_action->file, sds_file, tailoring_file, action->ds_action->target) != 0) {
+		fprintf(stdout, "Failed to inflate the result data stream.\n");
+		goto cleanup;
+	}
+
+	ret = OSCAP_OK;
+
+cleanup:
+	oscap_print_error();
+
+	free(action->ds_action);
+	return ret;
+}
@@ -312,13 +312,45 @@ static void _print_single_benchmark_all(struct xccdf_benchmark *bench, const cha
 	// bench is freed as a side-effect of the function above
 }
 
+/*
+ * Print the profiles of a checklist recorded in the index of the data stream,
+ * which spares extracting the checklist and importing the benchmark.
+ * Returns false if the profiles of the checklist are not indexed.
+ */
+static bool _print_indexed_profiles_only(struct ds_sds_index *sds, struct ds_stream_index *stream, const char *checklist_id)
+{
+	const char *component_id = ds_stream_index_get_component_id(stream, checklist_id);
+	if (component_id == NULL)
+		return false;
+	struct oscap_string_iterator *profile_it = ds_sds_index_get_profiles(sds, component_id);
+	if (profile_it == NULL)
+		return false;
+
+	while (oscap_string_iterator_has_more(profile_it)) {
+		const char *profile_id = oscap_string_iterator_next(profile_it);
+		const char *title = ds_sds_index_get_profile_title(sds, component_id, profile_id);
+		char *cleaned_profile_id = strdup(profile_id);
+		char *profile_title = title != NULL ? strdup(title) : NULL;
+		_remove_occurence_of_character_from_string(cleaned_profile_id, '\n');
+		_remove_occurence_of_character_from_string(profile_title, '\n');
+		printf("%s:%s\n", cleaned_profile_id, profile_title);
+		free(cleaned_profile_id);
+		free(profile_title);
+	}
+	oscap_string_iterator_free(profile_it);
+	return true;
+}
+
 static int app_info_single_ds_profiles_only(struct ds_stream_index_iterator* sds_it, struct ds_sds_session *session, const struct oscap_action *action)
 {
+	struct ds_sds_index *sds = ds_sds_session_get_sds_idx(session);
 	struct ds_stream_index * stream = ds_stream_index_iterator_next(sds_it);
 	struct oscap_string_iterator* checklist_it = ds_stream_index_get_checklists(stream);
 
 	while (oscap_string_iterator_has_more(checklist_it)) {
 		const char * id = oscap_string_iterator_next(checklist_it);
+		if (_print_indexed_profiles_only(sds, stream, id))
+			continue;
 		/* decompose */
 		struct oscap_source *xccdf_source = ds_sds_session_select_checklist(session, ds_stream_index_get_id(stream), id, NULL);
 		if (xccdf_source == NULL) {
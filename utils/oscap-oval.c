@@ -45,6 +45,7 @@
 #include "oscap-tool.h"
 #include "scap_ds.h"
 #include <oscap_debug.h>
+#include <oscap_profiling.h>
 
 #if defined(OVAL_PROBES_ENABLED)
 static int app_collect_oval(const struct oscap_action *action);
@@ -105,9 +106,21 @@ static struct oscap_module OVAL_EVAL = {
 	"   --id <definition-id>          - ID of the definition we want to evaluate.\n"
 	"   --variables <file>            - Provide external variables expected by OVAL Definitions.\n"
 	"   --directives <file>           - Use OVAL Directives content to specify desired results content.\n"
+	"   --syschar-input <file>        - Evaluate recorded OVAL System Characteristics instead of probing the system.\n"
 	"   --without-syschar             - Don't provide system characteristic in result file.\n"
 	"   --results <file>              - Write OVAL Results into file.\n"
 	"   --report <file>               - Create human readable (HTML) report from OVAL Results.\n"
+	"   --profiling <file>            - Write time spent on each OVAL object and test into file (JSON).\n"
+	"   --stats <file>                - Write runtime statistics into file (Prometheus text if it ends with .prom, JSON otherwise).\n"
+	"   --digest-cache <file>         - Reuse file digests of unchanged files stored in file by previous scans.\n"
+	"   --no-digest-cache             - Compute all file digests, even if OSCAP_DIGEST_CACHE is set.\n"
+	"   --max-io-rate <rate>          - Read at most rate bytes per second from files (K, M and G suffixes).\n"
+	"   --max-cpu <percent>           - Use at most percent of one CPU on average, e.g. 50 or 200.\n"
+	"   --nice <n>                    - Run with the given nice value (-20 to 19).\n"
+	"   --io-class <class>            - Run in the 'idle' or 'best-effort' I/O scheduling class.\n"
+	"   --deadline <seconds>          - Leave the objects not collected within seconds incomplete.\n"
+	"   --object-timeout <seconds>    - Leave an object incomplete when it takes longer than seconds.\n"
+	"   --schedule-from <file>        - Start the objects that took longest in the --profiling file first.\n"
 	"   --skip-valid                  - Skip validation.\n"
 	"   --skip-validation\n"
 	"   --datastream-id <id>          - ID of the data stream in the collection to use.\n"
@@ -326,6 +339,12 @@ int app_evaluate_oval(const struct oscap_action *action)
 	oval_result_t eval_result;
 	int ret = OSCAP_ERROR;
 
+	if (action->f_profiling != NULL)
+		oscap_profiling_set_enabled(true);
+	digest_cache_setup(action);
+	if (!throttle_setup(action))
+		return ret;
+
 	/* create a new OVAL session */
 	if ((session = oval_session_new(action->f_oval)) == NULL) {
 		oscap_print_error();
@@ -345,6 +364,9 @@ int app_evaluate_oval(const struct oscap_action *action)
 	/* set OVAL Variables */
 	oval_session_set_variables(session, action->f_variables);
 
+	/* evaluate recorded System Characteristics instead of probing */
+	oval_session_set_system_characteristics(session, action->f_syschar);
+
 	oval_session_configure_remote_resources(session, action->remote_resources, action->local_files, download_reporting_callback);
 	/* load all necesary OVAL Definitions and bind OVAL Variables if provided */
 	if ((oval_session_load(session)) != 0)
@@ -370,6 +392,11 @@ int app_evaluate_oval(const struct oscap_action *action)
 	if (oval_session_export(session) != 0)
 		goto cleanup;
 
+	if (action->f_profiling != NULL && oscap_profiling_export(action->f_profiling) != 0)
+		goto cleanup;
+	if (stats_export(action) != 0)
+		goto cleanup;
+
 	ret = OSCAP_OK;
 
 cleanup:
@@ -501,7 +528,18 @@ enum oval_opt {
     OVAL_OPT_DATASTREAM_ID,
     OVAL_OPT_OVAL_ID,
 	OVAL_OPT_OUTPUT = 'o',
-	OVAL_OPT_LOCAL_FILES
+	OVAL_OPT_LOCAL_FILES,
+	OVAL_OPT_PROFILING,
+	OVAL_OPT_STATS,
+	OVAL_OPT_DIGEST_CACHE,
+	OVAL_OPT_MAX_IO_RATE,
+	OVAL_OPT_MAX_CPU,
+	OVAL_OPT_NICE,
+	OVAL_OPT_IO_CLASS,
+	OVAL_OPT_DEADLINE,
+	OVAL_OPT_OBJECT_TIMEOUT,
+	OVAL_OPT_SCHEDULE_FROM,
+	OVAL_OPT_SYSCHAR_INPUT
 };
 
 #if defined(OVAL_PROBES_ENABLED)
@@ -516,6 +554,7 @@ bool getopt_oval_eval(int argc, char **argv, struct oscap_action *action)
 		{ "id",        	required_argument, NULL, OVAL_OPT_ID           },
 		{ "variables",	required_argument, NULL, OVAL_OPT_VARIABLES    },
 		{ "directives",	required_argument, NULL, OVAL_OPT_DIRECTIVES   },
+		{ "syschar-input",	required_argument, NULL, OVAL_OPT_SYSCHAR_INPUT },
 		{ "without-syschar",	no_argument, &action->without_sys_chars, 1},
 		{ "datastream-id",required_argument, NULL, OVAL_OPT_DATASTREAM_ID},
 		{ "oval-id",    required_argument, NULL, OVAL_OPT_OVAL_ID},
@@ -523,6 +562,17 @@ bool getopt_oval_eval(int argc, char **argv, struct oscap_action *action)
 		{ "skip-validation",	no_argument, &action->validate, 0 },
 		{ "fetch-remote-resources", no_argument, &action->remote_resources, 1},
 		{ "local-files", required_argument, NULL, OVAL_OPT_LOCAL_FILES},
+		{ "profiling",	required_argument, NULL, OVAL_OPT_PROFILING    },
+		{ "stats",	required_argument, NULL, OVAL_OPT_STATS         },
+		{ "digest-cache",	required_argument, NULL, OVAL_OPT_DIGEST_CACHE },
+		{ "no-digest-cache",	no_argument, &action->no_digest_cache, 1},
+		{ "max-io-rate",	required_argument, NULL, OVAL_OPT_MAX_IO_RATE },
+		{ "max-cpu",	required_argument, NULL, OVAL_OPT_MAX_CPU },
+		{ "nice",	required_argument, NULL, OVAL_OPT_NICE },
+		{ "io-class",	required_argument, NULL, OVAL_OPT_IO_CLASS },
+		{ "deadline",	required_argument, NULL, OVAL_OPT_DEADLINE },
+		{ "object-timeout",	required_argument, NULL, OVAL_OPT_OBJECT_TIMEOUT },
+		{ "schedule-from",	required_argument, NULL, OVAL_OPT_SCHEDULE_FROM },
 		{ 0, 0, 0, 0 }
 	};
 
@@ -531,9 +581,20 @@ bool getopt_oval_eval(int argc, char **argv, struct oscap_action *action)
 		switch (c) {
 		case OVAL_OPT_RESULT_FILE: action->f_results = optarg; break;
 		case OVAL_OPT_REPORT_FILE: action->f_report  = optarg; break;
+		case OVAL_OPT_PROFILING: action->f_profiling = optarg; break;
+		case OVAL_OPT_STATS: action->f_stats = optarg; break;
+		case OVAL_OPT_DIGEST_CACHE: action->f_digest_cache = optarg; break;
+		case OVAL_OPT_MAX_IO_RATE: action->max_io_rate = optarg; break;
+		case OVAL_OPT_MAX_CPU: action->max_cpu = optarg; break;
+		case OVAL_OPT_NICE: action->nice = optarg; break;
+		case OVAL_OPT_IO_CLASS: action->io_class = optarg; break;
+		case OVAL_OPT_DEADLINE: action->deadline = optarg; break;
+		case OVAL_OPT_OBJECT_TIMEOUT: action->object_timeout = optarg; break;
+		case OVAL_OPT_SCHEDULE_FROM: action->f_timings = optarg; break;
 		case OVAL_OPT_ID: action->id = optarg; break;
 		case OVAL_OPT_VARIABLES: action->f_variables = optarg; break;
 		case OVAL_OPT_DIRECTIVES: action->f_directives = optarg; break;
+		case OVAL_OPT_SYSCHAR_INPUT: action->f_syschar = optarg; break;
 		case OVAL_OPT_DATASTREAM_ID: action->f_datastream_id = optarg;	break;
 		case OVAL_OPT_OVAL_ID: action->f_oval_id = optarg;	break;
 		case OVAL_OPT_LOCAL_FILES:
@@ -36,12 +36,17 @@
 #include <io.h>
 #else
 #include <unistd.h>
+#include <sys/resource.h>
+#endif
+#if defined(OS_LINUX)
+#include <sys/syscall.h>
 #endif
 #include <stdarg.h>
 #include <errno.h>
 #include <limits.h>
 #include <cvss_score.h>
 #include <oscap_debug.h>
+#include <oscap_stats.h>
 #include "oscap_helpers.h"
 
 #ifndef PATH_MAX
@@ -60,6 +65,7 @@ static void oscap_action_init(struct oscap_action *action)
     action->validate = 1;
     action->schematron = 1;
     action->validate_signature = 1;
+    action->extra_profiles = oscap_stringlist_new();
     action->rules = oscap_stringlist_new();
     action->skip_rules = oscap_stringlist_new();
 }
@@ -69,6 +75,7 @@ static void oscap_action_release(struct oscap_action *action)
 	assert(action != NULL);
 	free(action->f_ovals);
 	cvss_impact_free(action->cvss_impact);
+    oscap_stringlist_free(action->extra_profiles);
     oscap_stringlist_free(action->rules);
     oscap_stringlist_free(action->skip_rules);
 }
@@ -444,3 +451,116 @@ void download_reporting_callback(bool warning, const char *format, ...)
 	va_end(argptr);
 	fflush(dest);
 }
+
+/* the probes find the digest cache file in OSCAP_DIGEST_CACHE */
+void digest_cache_setup(const struct oscap_action *action)
+{
+#ifndef OS_WINDOWS
+	if (action->no_digest_cache)
+		unsetenv("OSCAP_DIGEST_CACHE");
+	else if (action->f_digest_cache != NULL)
+		setenv("OSCAP_DIGEST_CACHE", action->f_digest_cache, 1);
+#endif
+}
+
+/* the collected object cache finds the state of the previous scan in OSCAP_INCREMENTAL_STATE */
+void incremental_setup(const struct oscap_action *action)
+{
+#ifndef OS_WINDOWS
+	if (action->f_incremental != NULL)
+		setenv("OSCAP_INCREMENTAL_STATE", action->f_incremental, 1);
+#endif
+}
+
+/* the CPE session finds the directory of the kept CPE results in OSCAP_CPE_CACHE */
+void cpe_cache_setup(const struct oscap_action *action)
+{
+#ifndef OS_WINDOWS
+	if (action->f_cpe_cache != NULL)
+		setenv("OSCAP_CPE_CACHE", action->f_cpe_cache, 1);
+#endif
+}
+
+#if defined(OS_LINUX) && defined(SYS_ioprio_set)
+#define IOPRIO_WHO_PROCESS 1
+#define IOPRIO_CLASS_SHIFT 13
+#define IOPRIO_CLASS_BE    2
+#define IOPRIO_CLASS_IDLE  3
+#define IOPRIO_BE_LOWEST   7
+#endif
+
+/*
+ * The probes find the I/O and CPU limits in OSCAP_MAX_IO_RATE and
+ * OSCAP_MAX_CPU, the scan deadline in OSCAP_SCAN_DEADLINE, the time limit
+ * of each object in OSCAP_OBJECT_TIMEOUT and the times of the previous
+ * scan in OSCAP_PROBE_TIMINGS. The scheduling and I/O
+ * priorities are set here, before any probe thread or process is started,
+ * which inherit them.
+ */
+bool throttle_setup(const struct oscap_action *action)
+{
+#ifndef OS_WINDOWS
+	if (action->max_io_rate != NULL)
+		setenv("OSCAP_MAX_IO_RATE", action->max_io_rate, 1);
+	if (action->max_cpu != NULL)
+		setenv("OSCAP_MAX_CPU", action->max_cpu, 1);
+	if (action->deadline != NULL)
+		setenv("OSCAP_SCAN_DEADLINE", action->deadline, 1);
+	if (action->object_timeout != NULL)
+		setenv("OSCAP_OBJECT_TIMEOUT", action->object_timeout, 1);
+	if (action->f_timings != NULL)
+		setenv("OSCAP_PROBE_TIMINGS", action->f_timings, 1);
+
+	if (action->nice != NULL) {
+		char *end;
+		long nice = strtol(action->nice, &end, 10);
+
+		if (*end != '\0' || end == action->nice || nice < -20 || nice > 19) {
+			fprintf(stderr, "Invalid nice value '%s', expected a number from -20 to 19.\n", action->nice);
+			return false;
+		}
+		if (setpriority(PRIO_PROCESS, 0, (int)nice) != 0) {
+			fprintf(stderr, "Cannot set the nice value to %ld: %s\n", nice, strerror(errno));
+			return false;
+		}
+	}
+
+	if (action->io_class != NULL) {
+#if defined(OS_LINUX) && defined(SYS_ioprio_set)
+		int ioprio;
+
+		if (strcmp(action->io_class, "idle") == 0) {
+			ioprio = IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT;
+		} else if (strcmp(action->io_class, "best-effort") == 0) {
+			ioprio = IOPRIO_CLASS_BE << IOPRIO_CLASS_SHIFT | IOPRIO_BE_LOWEST;
+		} else {
+			fprintf(stderr, "Invalid I/O scheduling class '%s', expected 'idle' or 'best-effort'.\n", action->io_class);
+			return false;
+		}
+		if (syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, ioprio) != 0) {
+			fprintf(stderr, "Cannot set the I/O scheduling class to '%s': %s\n", action->io_class, strerror(errno));
+			return false;
+		}
+#else
+		fprintf(stderr, "Setting the I/O scheduling class is not supported on this platform.\n");
+		return false;
+#endif
+	}
+#endif
+	return true;
+}
+
+/* Prometheus for the node_exporter textfile collector, which reads *.prom files, JSON otherwise */
+int stats_export(const struct oscap_action *action)
+{
+	const char *path = action->f_stats;
+	size_t len;
+
+	if (path == NULL)
+		return 0;
+
+	len = strlen(path);
+	if (len >= 5 && strcmp(path + len - 5, ".prom") == 0)
+		return oscap_stats_export(path, OSCAP_STATS_FORMAT_PROMETHEUS);
+	return oscap_stats_export(path, OSCAP_STATS_FORMAT_JSON);
+}
@@ -129,11 +129,29 @@ struct oscap_action {
         char *f_results;
 	char *f_results_stig;
 	char *f_results_arf;
+	char *f_results_jsonl;
         char *f_report;
 	char *f_variables;
 	char *f_verbose_log;
+	char *f_profiling;
+	char *f_stats;
+	char *f_digest_cache;
+	char *f_incremental;
+	char *f_cpe_cache;
+	char *f_stream_results;
+	char *f_target_roots;
+	char *f_socket;
+	/* resource limits */
+	char *max_io_rate;
+	char *max_cpu;
+	char *nice;
+	char *io_class;
+	char *deadline;
+	char *object_timeout;
+	char *f_timings;
 	/* others */
         char *profile;
+	struct oscap_stringlist *extra_profiles;
 	struct oscap_stringlist *rules;
 	struct oscap_stringlist *skip_rules;
         char *format;
@@ -154,6 +172,7 @@ struct oscap_action {
 	struct cvrf_action * cvrf_action;
 	char *file;
 
+	int no_digest_cache;
 	int verbosity;
 	int show_profiles_only;
 	int provide_machine_readable_output;
@@ -168,6 +187,8 @@ struct oscap_action {
 	int oval_results;
 	int without_sys_chars;
 	int thin_results;
+	int oval_lazy_loading;
+	int arf_sds_reference;
 	int remediate;
 	char *sce_template;
 	int check_engine_results;
@@ -188,6 +209,11 @@ int oscap_module_call(struct oscap_action *action);
 void oscap_print_error(void);
 bool check_verbose_options(struct oscap_action *action);
 void download_reporting_callback(bool warning, const char *format, ...);
+void digest_cache_setup(const struct oscap_action *action);
+void incremental_setup(const struct oscap_action *action);
+void cpe_cache_setup(const struct oscap_action *action);
+bool throttle_setup(const struct oscap_action *action);
+int stats_export(const struct oscap_action *action);
 
 void report_missing_profile(const char *profile_suffix, const char *source_file);
 void report_multiple_profile_matches(const char *profile_suffix, const char *source_file);
@@ -205,6 +231,7 @@ extern struct oscap_module OSCAP_CVE_MODULE;
 extern struct oscap_module OSCAP_CVRF_MODULE;
 extern struct oscap_module OSCAP_CPE_MODULE;
 extern struct oscap_module OSCAP_INFO_MODULE;
+extern struct oscap_module OSCAP_DAEMON_MODULE;
 
 #ifndef HAVE_GETOPT_H
 
@@ -53,6 +53,10 @@
 #include <windows.h>
 #else
 #include <unistd.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
 #endif
 #if defined(HAVE_SYSLOG_H)
 #include <syslog.h>
@@ -63,6 +67,7 @@
 #include "oscap_source.h"
 #include <oscap_debug.h>
 #include "oscap_helpers.h"
+#include <oscap_profiling.h>
 
 #ifndef O_NOFOLLOW
 #define O_NOFOLLOW 0
@@ -82,6 +87,10 @@ static int app_generate_guide(const struct oscap_action *action);
 #define XCCDF_SUBMODULES_NUM		7
 #define XCCDF_GEN_SUBMODULES_NUM	5 /* See actual arrays
 						initialization below. */
+
+/* Number of rules in the timing summary logged at the INFO verbosity level */
+#define SLOWEST_RULES_LOGGED		10
+
 static struct oscap_module* XCCDF_SUBMODULES[XCCDF_SUBMODULES_NUM];
 static struct oscap_module* XCCDF_GEN_SUBMODULES[XCCDF_GEN_SUBMODULES_NUM];
 
@@ -150,7 +159,8 @@ static struct oscap_module XCCDF_EVAL = {
     .help =
 		"INPUT_FILE - XCCDF file or a source data stream file\n\n"
 		"Options:\n"
-		"   --profile <name>              - The name of Profile to be evaluated.\n"
+		"   --profile <name>              - The name of Profile to be evaluated. Can be given\n"
+		"                                   multiple times, each profile gets its own TestResult.\n"
 		"   --rule <name>                 - The name of a single rule to be evaluated.\n"
 		"   --skip-rule <name>            - The name of the rule to be skipped.\n"
 		"   --tailoring-file <file>       - Use given XCCDF Tailoring file.\n"
@@ -162,11 +172,31 @@ static struct oscap_module XCCDF_EVAL = {
 		"   --export-variables            - Export OVAL external variables provided by XCCDF.\n"
 		"   --results <file>              - Write XCCDF Results into file.\n"
 		"   --results-arf <file>          - Write ARF (result data stream) into file.\n"
+		"   --results-jsonl <file>        - Write rule, OVAL definition, test and item results into file (JSON lines).\n"
+		"   --arf-sds-reference           - Reference the source data stream in ARF by its digest instead of embedding it.\n"
 		"   --stig-viewer <file>          - Writes XCCDF results into FILE in a format readable by DISA STIG Viewer\n"
 		"   --thin-results                - Thin Results provides only minimal amount of information in OVAL/ARF results.\n"
 		"                                   The option --without-syschar is automatically enabled when you use Thin Results.\n"
+		"   --oval-lazy-loading           - Load only the OVAL definitions used by the selected rules.\n"
+		"                                   OVAL/ARF results then contain only these definitions.\n"
 		"   --without-syschar             - Don't provide system characteristic in OVAL/ARF result files.\n"
 		"   --report <file>               - Write HTML report into file.\n"
+		"   --profiling <file>            - Write time spent on each OVAL object, test and rule into file (JSON).\n"
+		"   --stats <file>                - Write runtime statistics into file (Prometheus text if it ends with .prom, JSON otherwise).\n"
+		"   --stream-results <file>       - Write each rule result into file (JSON lines) as soon as it's known.\n"
+		"   --digest-cache <file>         - Reuse file digests of unchanged files stored in file by previous scans.\n"
+		"   --no-digest-cache             - Compute all file digests, even if OSCAP_DIGEST_CACHE is set.\n"
+		"   --incremental <file>          - Reuse objects collected by the previous scan from unchanged files.\n"
+		"   --cpe-cache <dir>             - Reuse CPE applicability results of previous scans of this host.\n"
+		"   --max-io-rate <rate>          - Read at most rate bytes per second from files (K, M and G suffixes).\n"
+		"   --max-cpu <percent>           - Use at most percent of one CPU on average, e.g. 50 or 200.\n"
+		"   --nice <n>                    - Run with the given nice value (-20 to 19).\n"
+		"   --io-class <class>            - Run in the 'idle' or 'best-effort' I/O scheduling class.\n"
+		"   --deadline <seconds>          - Leave the objects not collected within seconds incomplete.\n"
+		"   --object-timeout <seconds>    - Leave an object incomplete when it takes longer than seconds.\n"
+		"   --schedule-from <file>        - Start the objects that took longest in the --profiling file first.\n"
+		"   --target-roots <file>         - Evaluate the content once for each offline root listed in file.\n"
+		"                                   Each line holds a root directory and the ARF file to write for it.\n"
 		"   --skip-valid                  - Skip validation.\n"
 		"   --skip-validation\n"
 		"   --skip-signature-validation   - Skip data stream signature validation.\n"
@@ -493,6 +523,98 @@ static int callback_scr_multicheck(struct oval_definition *definition, void *arg
 	return 0;
 }
 
+static void stream_json_string(FILE *fp, const char *str)
+{
+	fputc('"', fp);
+	for (; *str != '\0'; ++str) {
+		unsigned char c = (unsigned char)*str;
+
+		if (c == '"' || c == '\\')
+			fprintf(fp, "\\%c", c);
+		else if (c < 0x20)
+			fprintf(fp, "\\u%04x", c);
+		else
+			fputc(c, fp);
+	}
+	fputc('"', fp);
+}
+
+/* writes one JSON object per line for each rule result, see --stream-results */
+static int callback_stream_result(struct xccdf_rule_result *rule_result, void *arg)
+{
+	static const char *SEVERITIES[] = { "", "unknown", "info", "low", "medium", "high" };
+	FILE *fp = (FILE *)arg;
+	xccdf_test_result_type_t result = xccdf_rule_result_get_result(rule_result);
+
+	if (result == XCCDF_RESULT_NOT_SELECTED)
+		return 0;
+
+	fputs("{\"rule\":", fp);
+	stream_json_string(fp, xccdf_rule_result_get_idref(rule_result));
+	fputs(",\"result\":", fp);
+	stream_json_string(fp, xccdf_test_result_type_get_text(result));
+	const char *time = xccdf_rule_result_get_time(rule_result);
+	if (time != NULL) {
+		fputs(",\"time\":", fp);
+		stream_json_string(fp, time);
+	}
+	xccdf_level_t severity = xccdf_rule_result_get_severity(rule_result);
+	if (severity >= XCCDF_UNKNOWN && severity <= XCCDF_HIGH)
+		fprintf(fp, ",\"severity\":\"%s\"", SEVERITIES[severity]);
+
+	fputs(",\"idents\":[", fp);
+	struct xccdf_ident_iterator *idents = xccdf_rule_result_get_idents(rule_result);
+	for (bool first = true; xccdf_ident_iterator_has_more(idents); first = false) {
+		const struct xccdf_ident *ident = xccdf_ident_iterator_next(idents);
+		fputs(first ? "{\"system\":" : ",{\"system\":", fp);
+		stream_json_string(fp, xccdf_ident_get_system(ident) != NULL ? xccdf_ident_get_system(ident) : "");
+		fputs(",\"id\":", fp);
+		stream_json_string(fp, xccdf_ident_get_id(ident) != NULL ? xccdf_ident_get_id(ident) : "");
+		fputc('}', fp);
+	}
+	xccdf_ident_iterator_free(idents);
+	fputs("]}\n", fp);
+
+	/* the reader sees each result as soon as it's known, a failed write doesn't stop the scan */
+	fflush(fp);
+	return 0;
+}
+
+/* a file, a FIFO, /dev/fd/N or a listening Unix stream socket */
+static FILE *open_result_stream(const char *path)
+{
+#ifndef OS_WINDOWS
+	struct stat st;
+
+	/* a reader which went away mustn't kill the scan */
+	signal(SIGPIPE, SIG_IGN);
+
+	if (stat(path, &st) == 0 && S_ISSOCK(st.st_mode)) {
+		struct sockaddr_un addr;
+		int fd;
+
+		if (strlen(path) >= sizeof(addr.sun_path)) {
+			errno = ENAMETOOLONG;
+			return NULL;
+		}
+		memset(&addr, 0, sizeof(addr));
+		addr.sun_family = AF_UNIX;
+		strcpy(addr.sun_path, path);
+
+		fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (fd == -1)
+			return NULL;
+		if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+			close(fd);
+			return NULL;
+		}
+		fcntl(fd, F_SETFD, FD_CLOEXEC);
+		return fdopen(fd, "w");
+	}
+#endif
+	return fopen(path, "a");
+}
+
 /*
  * Send XCCDF Rule Results info message to syslog
  *
@@ -590,9 +712,253 @@ int xccdf_set_profile_or_report_bad_id(struct xccdf_session *session, const char
  * @param action OSCAP Action structure
  * @param sess OVAL Agent Session
  */
+#ifndef OS_WINDOWS
+#define TARGET_ROOTS_MAX_JOBS 64
+
+struct target_root {
+	char *root;
+	char *arf;
+	char *env;
+	char *name;
+	pid_t pid;
+};
+
+static void target_roots_free(struct target_root *roots, size_t count)
+{
+	for (size_t i = 0; i < count; ++i) {
+		free(roots[i].root);
+		free(roots[i].arf);
+		free(roots[i].env);
+		free(roots[i].name);
+	}
+	free(roots);
+}
+
+/*
+ * Read the list of targets: each non-empty line which doesn't start with
+ * '#' contains the root directory and the ARF file separated by whitespace,
+ * optionally followed by a file with the environment variables of the
+ * target ('-' if there is none) and by the name of the target, which
+ * takes the rest of the line.
+ */
+static int target_roots_load(const char *path, struct target_root **roots, size_t *count)
+{
+	FILE *fp = fopen(path, "r");
+	if (fp == NULL) {
+		fprintf(stderr, "Cannot open '%s': %s\n", path, strerror(errno));
+		return -1;
+	}
+
+	struct target_root *list = NULL;
+	size_t list_count = 0;
+	char *line = NULL;
+	size_t line_size = 0;
+	unsigned int lineno = 0;
+	int ret = 0;
+
+	while (getline(&line, &line_size, fp) != -1) {
+		char *saveptr = NULL;
+		++lineno;
+		char *root = strtok_r(line, " \t\r\n", &saveptr);
+		if (root == NULL || root[0] == '#')
+			continue;
+		char *arf = strtok_r(NULL, " \t\r\n", &saveptr);
+		if (arf == NULL) {
+			fprintf(stderr, "%s:%u: Expected a root directory and an ARF file.\n", path, lineno);
+			ret = -1;
+			break;
+		}
+		char *env = strtok_r(NULL, " \t\r\n", &saveptr);
+		char *name = strtok_r(NULL, "\r\n", &saveptr);
+		if (name != NULL)
+			name += strspn(name, " \t");
+		struct target_root *tmp = realloc(list, (list_count + 1) * sizeof(*list));
+		if (tmp == NULL) {
+			ret = -1;
+			break;
+		}
+		list = tmp;
+		list[list_count].root = strdup(root);
+		list[list_count].arf = strdup(arf);
+		list[list_count].env = (env != NULL && strcmp(env, "-") != 0) ? strdup(env) : NULL;
+		list[list_count].name = (name != NULL && *name != '\0') ? strdup(name) : NULL;
+		list[list_count].pid = -1;
+		++list_count;
+	}
+	free(line);
+	fclose(fp);
+
+	if (ret == 0 && list_count == 0) {
+		fprintf(stderr, "No target roots found in '%s'.\n", path);
+		ret = -1;
+	}
+	if (ret != 0) {
+		target_roots_free(list, list_count);
+		return ret;
+	}
+	*roots = list;
+	*count = list_count;
+	return 0;
+}
+
+static long target_roots_jobs(size_t count)
+{
+	long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+	const char *jobs_str = getenv("OSCAP_TARGET_ROOTS_JOBS");
+
+	if (jobs_str != NULL) {
+		char *endptr = NULL;
+		long val = strtol(jobs_str, &endptr, 10);
+		if (*jobs_str == '\0' || *endptr != '\0' || val < 1) {
+			fprintf(stderr, "Warning: Invalid value of OSCAP_TARGET_ROOTS_JOBS: '%s'.\n", jobs_str);
+		} else {
+			jobs = val;
+		}
+	}
+	if (jobs < 1)
+		jobs = 1;
+	if (jobs > TARGET_ROOTS_MAX_JOBS)
+		jobs = TARGET_ROOTS_MAX_JOBS;
+	if ((size_t)jobs > count)
+		jobs = count;
+	return jobs;
+}
+
+/* Set OSCAP_CONTAINER_VARS to the content of the environment file */
+static int target_root_load_env(const char *path)
+{
+	FILE *fp = fopen(path, "r");
+	if (fp == NULL) {
+		fprintf(stderr, "Cannot open '%s': %s\n", path, strerror(errno));
+		return -1;
+	}
+
+	char *vars = calloc(1, 1);
+	size_t vars_len = 0;
+	char buf[4096];
+	size_t len;
+	while (vars != NULL && (len = fread(buf, 1, sizeof(buf), fp)) > 0) {
+		char *tmp = realloc(vars, vars_len + len + 1);
+		if (tmp == NULL) {
+			free(vars);
+			vars = NULL;
+			break;
+		}
+		vars = tmp;
+		memcpy(vars + vars_len, buf, len);
+		vars_len += len;
+		vars[vars_len] = '\0';
+	}
+	fclose(fp);
+	if (vars == NULL)
+		return -1;
+
+	int ret = setenv("OSCAP_CONTAINER_VARS", vars, 1);
+	free(vars);
+	return ret;
+}
+
+/* Runs in a child process with the content already loaded by the parent */
+static int target_root_evaluate(struct xccdf_session *session, const struct oscap_action *action, const struct target_root *target)
+{
+	if (setenv("OSCAP_PROBE_ROOT", target->root, 1) != 0)
+		return OSCAP_ERROR;
+	if (target->env != NULL && target_root_load_env(target->env) != 0)
+		return OSCAP_ERROR;
+	if (target->name != NULL && setenv("OSCAP_EVALUATION_TARGET", target->name, 1) != 0)
+		return OSCAP_ERROR;
+	if (xccdf_session_evaluate(session) != 0)
+		return OSCAP_ERROR;
+
+	xccdf_session_set_without_sys_chars_export(session, action->without_sys_chars);
+	xccdf_session_set_arf_export(session, target->arf);
+	if (xccdf_session_export_oval(session) != 0)
+		return OSCAP_ERROR;
+	if (xccdf_session_export_check_engine_plugins(session) != 0)
+		return OSCAP_ERROR;
+
+	int evaluation_result = xccdf_session_contains_fail_result(session) ? OSCAP_FAIL : OSCAP_OK;
+	if (xccdf_session_export_all(session) != 0)
+		return OSCAP_ERROR;
+	return evaluation_result;
+}
+
+/*
+ * Evaluate the loaded session once for every root. The probes take the
+ * target from the process environment and may chroot, so each root is
+ * scanned by a forked child which shares the parsed and resolved content
+ * with the parent instead of loading it again.
+ */
+static int app_evaluate_target_roots(struct xccdf_session *session, const struct oscap_action *action)
+{
+	struct target_root *roots = NULL;
+	size_t count = 0;
+
+	if (target_roots_load(action->f_target_roots, &roots, &count) != 0)
+		return OSCAP_ERROR;
+
+	long jobs = target_roots_jobs(count);
+	size_t next = 0;
+	long running = 0;
+	int result = OSCAP_OK;
+
+	fflush(stdout);
+	fflush(stderr);
+	while (next < count || running > 0) {
+		if (next < count && running < jobs) {
+			struct target_root *target = &roots[next++];
+			pid_t pid = fork();
+			if (pid == 0) {
+				int ret = target_root_evaluate(session, action, target);
+				oscap_print_error();
+				fflush(stdout);
+				fflush(stderr);
+				_exit(ret);
+			} else if (pid < 0) {
+				fprintf(stderr, "Cannot start the evaluation of '%s': %s\n", target->root, strerror(errno));
+				result = OSCAP_ERROR;
+			} else {
+				target->pid = pid;
+				++running;
+			}
+			continue;
+		}
+
+		int status;
+		pid_t pid = waitpid(-1, &status, 0);
+		if (pid < 0) {
+			if (errno == EINTR)
+				continue;
+			fprintf(stderr, "waitpid failed: %s\n", strerror(errno));
+			result = OSCAP_ERROR;
+			break;
+		}
+		for (size_t i = 0; i < next; ++i) {
+			if (roots[i].pid != pid)
+				continue;
+			int ret = WIFEXITED(status) ? WEXITSTATUS(status) : OSCAP_ERROR;
+			if (ret == OSCAP_ERROR)
+				result = OSCAP_ERROR;
+			else if (ret == OSCAP_FAIL && result == OSCAP_OK)
+				result = OSCAP_FAIL;
+			printf("%s: %s\n", roots[i].root,
+			       ret == OSCAP_OK ? "pass" : (ret == OSCAP_FAIL ? "fail" : "error"));
+			fflush(stdout);
+			roots[i].pid = -1;
+			--running;
+			break;
+		}
+	}
+
+	target_roots_free(roots, count);
+	return result;
+}
+#endif
+
 int app_evaluate_xccdf(const struct oscap_action *action)
 {
 	struct xccdf_session *session = NULL;
+	FILE *result_stream = NULL;
 
 	int result = OSCAP_ERROR;
 #if defined(HAVE_SYSLOG_H)
@@ -601,6 +967,17 @@ int app_evaluate_xccdf(const struct oscap_action *action)
 	/* syslog message */
 	syslog(priority, "Evaluation started. Content: %s, Profile: %s.", action->f_xccdf, action->profile);
 #endif
+	/* the slowest rules are logged at the INFO level */
+	const bool log_timing = action->verbosity_level != NULL &&
+		oscap_verbosity_level_from_cstr(action->verbosity_level) >= DBG_I;
+	if (action->f_profiling != NULL || log_timing)
+		oscap_profiling_set_enabled(true);
+	digest_cache_setup(action);
+	incremental_setup(action);
+	cpe_cache_setup(action);
+	if (!throttle_setup(action))
+		return result;
+
 	session = xccdf_session_new(action->f_xccdf);
 	if (session == NULL)
 		goto cleanup;
@@ -611,6 +988,12 @@ int app_evaluate_xccdf(const struct oscap_action *action)
 		xccdf_session_set_thin_results(session, true);
 		xccdf_session_set_without_sys_chars_export(session, true);
 	}
+	if (action->oval_lazy_loading)
+		xccdf_session_set_oval_lazy_loading(session, true);
+	/* the descriptive texts of the rules are only needed by the exports */
+	if (action->f_results == NULL && action->f_results_arf == NULL &&
+	    action->f_report == NULL && action->f_results_stig == NULL)
+		xccdf_session_set_loading_flags(session, XCCDF_SESSION_LOAD_ALL | XCCDF_SESSION_LOAD_TEXTS_ON_DEMAND);
 	if (xccdf_session_is_sds(session)) {
 		xccdf_session_set_datastream_id(session, action->f_datastream_id);
 		xccdf_session_set_component_id(session, action->f_xccdf_id);
@@ -638,6 +1021,11 @@ int app_evaluate_xccdf(const struct oscap_action *action)
 	}
 	oscap_string_iterator_free(sit);
 
+	/* the items are only exported along with the system characteristics */
+	xccdf_session_set_referenced_entities_only(session, action->without_sys_chars || action->thin_results ||
+		(!action->oval_results && action->f_results_arf == NULL &&
+		 action->f_report == NULL && action->f_target_roots == NULL));
+
 	if (xccdf_session_load(session) != 0)
 		goto cleanup;
 
@@ -652,9 +1040,37 @@ int app_evaluate_xccdf(const struct oscap_action *action)
 			goto cleanup;
 		}
 	}
+	struct oscap_string_iterator *pit = oscap_stringlist_get_strings(action->extra_profiles);
+	while (oscap_string_iterator_has_more(pit)) {
+		const char *profile = oscap_string_iterator_next(pit);
+		int suffix_match_result = xccdf_session_add_profile_id_by_suffix(session, profile);
+		if (evaluate_suffix_match_result(suffix_match_result, profile, action->f_xccdf) == OSCAP_ERROR) {
+			oscap_string_iterator_free(pit);
+			goto cleanup;
+		}
+	}
+	oscap_string_iterator_free(pit);
+
+#ifndef OS_WINDOWS
+	if (action->f_target_roots != NULL) {
+		result = app_evaluate_target_roots(session, action);
+		goto cleanup;
+	}
+#endif
 
 	_register_progress_callback(session, action->progress);
 
+	if (action->f_stream_results != NULL) {
+		result_stream = open_result_stream(action->f_stream_results);
+		if (result_stream == NULL) {
+			fprintf(stderr, "Unable to open '%s' for streaming the results: %s\n",
+				action->f_stream_results, strerror(errno));
+			goto cleanup;
+		}
+		xccdf_policy_model_register_output_callback(xccdf_session_get_policy_model(session),
+		                                            callback_stream_result, result_stream);
+	}
+
 	if (action->progress == PROGRESS_OPT_SPARSE) {
 		// Don't pronounce phases in this mode
 	} else if (action->progress == PROGRESS_OPT_FULL) {
@@ -671,6 +1087,7 @@ int app_evaluate_xccdf(const struct oscap_action *action)
 	xccdf_session_set_oval_results_export(session, action->oval_results);
 	xccdf_session_set_oval_variables_export(session, action->export_variables);
 	xccdf_session_set_arf_export(session, action->f_results_arf);
+	xccdf_session_set_arf_sds_reference(session, action->arf_sds_reference);
 
 	if (xccdf_session_export_oval(session) != 0)
 		goto cleanup;
@@ -704,9 +1121,17 @@ int app_evaluate_xccdf(const struct oscap_action *action)
 	xccdf_session_set_xccdf_export(session, action->f_results);
 	xccdf_session_set_xccdf_stig_viewer_export(session, action->f_results_stig);
 	xccdf_session_set_report_export(session, action->f_report);
+	xccdf_session_set_results_jsonl_export(session, action->f_results_jsonl);
 	if (xccdf_session_export_all(session) != 0)
 		goto cleanup;
 
+	if (action->f_profiling != NULL && oscap_profiling_export(action->f_profiling) != 0)
+		goto cleanup;
+	if (log_timing)
+		oscap_profiling_log_summary(SLOWEST_RULES_LOGGED);
+	if (stats_export(action) != 0)
+		goto cleanup;
+
 	if (action->validate && getenv("OSCAP_FULL_VALIDATION") != NULL &&
 		(action->f_results || action->f_report || action->f_results_arf || action->f_results_stig))
 		fprintf(stdout, "XCCDF Results are exported correctly.\n");
@@ -717,6 +1142,8 @@ int app_evaluate_xccdf(const struct oscap_action *action)
 	result = evaluation_result;
 
 cleanup:
+	if (result_stream != NULL)
+		fclose(result_stream);
 	xccdf_session_free(session);
 	oscap_print_error();
 	return result;
@@ -789,6 +1216,10 @@ int app_xccdf_remediate(const struct oscap_action *action)
 {
 	struct xccdf_session *session = NULL;
 	int result = OSCAP_ERROR;
+	if (action->f_profiling != NULL)
+		oscap_profiling_set_enabled(true);
+	digest_cache_setup(action);
+
 	session = xccdf_session_new(action->f_xccdf);
 	if (session == NULL)
 		goto cleanup;
@@ -1197,10 +1628,25 @@ enum oval_opt {
 	XCCDF_OPT_TAILORING_ID,
     XCCDF_OPT_CPE,
     XCCDF_OPT_CPE_DICT,
+	XCCDF_OPT_MAX_IO_RATE,
+	XCCDF_OPT_MAX_CPU,
+	XCCDF_OPT_NICE,
+	XCCDF_OPT_IO_CLASS,
+	XCCDF_OPT_DEADLINE,
+	XCCDF_OPT_OBJECT_TIMEOUT,
+	XCCDF_OPT_SCHEDULE_FROM,
+	XCCDF_OPT_INCREMENTAL,
+	XCCDF_OPT_CPE_CACHE,
+	XCCDF_OPT_STREAM_RESULTS,
+	XCCDF_OPT_RESULT_FILE_JSONL,
+	XCCDF_OPT_STATS,
     XCCDF_OPT_OUTPUT = 'o',
     XCCDF_OPT_RESULT_ID = 'i',
 	XCCDF_OPT_FIX_TYPE,
-	XCCDF_OPT_LOCAL_FILES
+	XCCDF_OPT_LOCAL_FILES,
+	XCCDF_OPT_PROFILING,
+	XCCDF_OPT_DIGEST_CACHE,
+	XCCDF_OPT_TARGET_ROOTS
 };
 
 bool getopt_xccdf(int argc, char **argv, struct oscap_action *action)
@@ -1215,6 +1661,7 @@ bool getopt_xccdf(int argc, char **argv, struct oscap_action *action)
 		{"output",		required_argument, NULL, XCCDF_OPT_OUTPUT},
 		{"results", 		required_argument, NULL, XCCDF_OPT_RESULT_FILE},
 		{"results-arf",		required_argument, NULL, XCCDF_OPT_RESULT_FILE_ARF},
+		{"results-jsonl",	required_argument, NULL, XCCDF_OPT_RESULT_FILE_JSONL},
 		{"stig-viewer", 	required_argument, NULL, XCCDF_OPT_RESULT_FILE_STIG},
 		{"datastream-id",		required_argument, NULL, XCCDF_OPT_DATASTREAM_ID},
 		{"xccdf-id",		required_argument, NULL, XCCDF_OPT_XCCDF_ID},
@@ -1234,8 +1681,23 @@ bool getopt_xccdf(int argc, char **argv, struct oscap_action *action)
 		{"sce-template", 	required_argument, NULL, XCCDF_OPT_SCE_TEMPLATE},
 		{"fix-type", required_argument, NULL, XCCDF_OPT_FIX_TYPE},
 		{"local-files", required_argument, NULL, XCCDF_OPT_LOCAL_FILES},
+		{"profiling",	required_argument, NULL, XCCDF_OPT_PROFILING},
+		{"stats",	required_argument, NULL, XCCDF_OPT_STATS},
+		{"digest-cache",	required_argument, NULL, XCCDF_OPT_DIGEST_CACHE},
+		{"incremental",	required_argument, NULL, XCCDF_OPT_INCREMENTAL},
+		{"cpe-cache",	required_argument, NULL, XCCDF_OPT_CPE_CACHE},
+		{"stream-results",	required_argument, NULL, XCCDF_OPT_STREAM_RESULTS},
+		{"target-roots",	required_argument, NULL, XCCDF_OPT_TARGET_ROOTS},
+		{"max-io-rate",	required_argument, NULL, XCCDF_OPT_MAX_IO_RATE},
+		{"max-cpu",	required_argument, NULL, XCCDF_OPT_MAX_CPU},
+		{"nice",	required_argument, NULL, XCCDF_OPT_NICE},
+		{"io-class",	required_argument, NULL, XCCDF_OPT_IO_CLASS},
+		{"deadline",	required_argument, NULL, XCCDF_OPT_DEADLINE},
+		{"object-timeout",	required_argument, NULL, XCCDF_OPT_OBJECT_TIMEOUT},
+		{"schedule-from",	required_argument, NULL, XCCDF_OPT_SCHEDULE_FROM},
 	// flags
 		{"force",		no_argument, &action->force, 1},
+		{"no-digest-cache",	no_argument, &action->no_digest_cache, 1},
 		{"oval-results",	no_argument, &action->oval_results, 1},
 		{"check-engine-results", no_argument, &action->check_engine_results, 1},
 		{"skip-valid",		no_argument, &action->validate, 0},
@@ -1253,6 +1715,8 @@ bool getopt_xccdf(int argc, char **argv, struct oscap_action *action)
 		{"skip-schematron",     no_argument, &action->schematron, 0},
 		{"without-syschar",    no_argument, &action->without_sys_chars, 1},
 		{"thin-results",        no_argument, &action->thin_results, 1},
+		{"oval-lazy-loading",   no_argument, &action->oval_lazy_loading, 1},
+		{"arf-sds-reference",   no_argument, &action->arf_sds_reference, 1},
 	// end
 		{0, 0, 0, 0}
 	};
@@ -1265,10 +1729,17 @@ bool getopt_xccdf(int argc, char **argv, struct oscap_action *action)
 		case XCCDF_OPT_RESULT_FILE:	action->f_results = optarg;	break;
 		case XCCDF_OPT_RESULT_FILE_STIG: action->f_results_stig = optarg;	break;
 		case XCCDF_OPT_RESULT_FILE_ARF:	action->f_results_arf = optarg;	break;
+		case XCCDF_OPT_RESULT_FILE_JSONL:	action->f_results_jsonl = optarg;	break;
 		case XCCDF_OPT_DATASTREAM_ID:	action->f_datastream_id = optarg;	break;
 		case XCCDF_OPT_XCCDF_ID:	action->f_xccdf_id = optarg; break;
 		case XCCDF_OPT_BENCHMARK_ID:	action->f_benchmark_id = optarg; break;
-		case XCCDF_OPT_PROFILE:		action->profile = optarg;	break;
+		case XCCDF_OPT_PROFILE:
+			/* eval accepts several profiles, the first one is selected */
+			if (action->profile != NULL && action->module == &XCCDF_EVAL)
+				oscap_stringlist_add_string(action->extra_profiles, optarg);
+			else
+				action->profile = optarg;
+			break;
 		case XCCDF_OPT_RULE:
 			oscap_stringlist_add_string(action->rules, optarg);
 			break;
@@ -1297,12 +1768,41 @@ bool getopt_xccdf(int argc, char **argv, struct oscap_action *action)
 		case XCCDF_OPT_LOCAL_FILES:
 			action->local_files = optarg;
 			break;
+		case XCCDF_OPT_PROFILING:	action->f_profiling = optarg; break;
+		case XCCDF_OPT_STATS:	action->f_stats = optarg; break;
+		case XCCDF_OPT_DIGEST_CACHE:	action->f_digest_cache = optarg; break;
+		case XCCDF_OPT_INCREMENTAL:	action->f_incremental = optarg; break;
+		case XCCDF_OPT_CPE_CACHE:	action->f_cpe_cache = optarg; break;
+		case XCCDF_OPT_STREAM_RESULTS:	action->f_stream_results = optarg; break;
+		case XCCDF_OPT_TARGET_ROOTS:	action->f_target_roots = optarg; break;
+		case XCCDF_OPT_MAX_IO_RATE:	action->max_io_rate = optarg; break;
+		case XCCDF_OPT_MAX_CPU:	action->max_cpu = optarg; break;
+		case XCCDF_OPT_NICE:	action->nice = optarg; break;
+		case XCCDF_OPT_IO_CLASS:	action->io_class = optarg; break;
+		case XCCDF_OPT_DEADLINE:	action->deadline = optarg; break;
+		case XCCDF_OPT_OBJECT_TIMEOUT:	action->object_timeout = optarg; break;
+		case XCCDF_OPT_SCHEDULE_FROM:	action->f_timings = optarg; break;
 		case 0: break;
 		default: return oscap_module_usage(action->module, stderr, NULL);
 		}
 	}
 
 	if (action->module == &XCCDF_EVAL) {
+		if (action->f_target_roots != NULL &&
+		    (action->f_results || action->f_results_arf || action->f_results_jsonl || action->f_results_stig ||
+		     action->f_report || action->f_profiling || action->f_stats || action->f_stream_results || action->oval_results ||
+		     action->export_variables || action->check_engine_results || action->remediate)) {
+			return oscap_module_usage(action->module, stderr,
+				"--target-roots writes one ARF per root and cannot be combined with other result, report or remediation options!");
+		}
+		if (action->f_target_roots != NULL) {
+			struct oscap_string_iterator *pit = oscap_stringlist_get_strings(action->extra_profiles);
+			bool extra_profiles = oscap_string_iterator_has_more(pit);
+			oscap_string_iterator_free(pit);
+			if (extra_profiles)
+				return oscap_module_usage(action->module, stderr,
+					"--target-roots evaluates a single profile, --profile can be given only once!");
+		}
 		/* We should have XCCDF file here */
 		if (optind >= argc) {
 			/* TODO */
@@ -58,6 +58,7 @@ struct oscap_module* OSCAP_ROOT_SUBMODULES[] = {
     &OSCAP_CVRF_MODULE,
     &OSCAP_VERSION_MODULE,
     &OSCAP_INFO_MODULE,
+    &OSCAP_DAEMON_MODULE,
     NULL
 };
 
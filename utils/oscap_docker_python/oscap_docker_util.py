@@ -20,6 +20,8 @@ from __future__ import print_function
 
 import os
 import io
+import re
+import subprocess
 from pathlib import Path
 from itertools import chain
 import tarfile
@@ -30,6 +32,7 @@ import sys
 import docker
 import uuid
 import collections
+from concurrent.futures import ThreadPoolExecutor
 from oscap_docker_python.oscap_docker_common import oscap_chroot, get_dist, \
     OscapResult, OscapError
 
@@ -227,3 +230,66 @@ class OscapDockerScan(object):
         self._end()
 
         return scan_result.returncode
+
+
+def scan_targets(targets, arf_dir, scan_args, oscap_binary=''):
+    '''
+    Mount the targets in parallel and scan them all by one oscap process
+    using --target-roots, so that the content is loaded only once.
+    OSCAP_TARGET_ROOTS_JOBS limits both the mounts and the scans.
+    '''
+    if tuple(scan_args[:2]) != ("xccdf", "eval"):
+        raise ValueError("Only 'xccdf eval' is supported with targets.\n")
+
+    def prepare(target):
+        kind, _, name = target.partition(":")
+        if kind not in ("image", "container") or not name:
+            raise ValueError("Target {0} is neither image:NAME nor container:NAME.\n"
+                             .format(target))
+        return OscapDockerScan(name, kind == "image", oscap_binary)
+
+    try:
+        jobs = int(os.environ.get("OSCAP_TARGET_ROOTS_JOBS", ""))
+    except ValueError:
+        jobs = os.cpu_count() or 1
+    jobs = max(1, jobs)
+
+    os.makedirs(arf_dir, exist_ok=True)
+    tmp_dir = tempfile.mkdtemp()
+    scans = []
+    rc = 0
+    with ThreadPoolExecutor(max_workers=jobs) as executor:
+        futures = [executor.submit(prepare, target) for target in targets]
+        for target, future in zip(targets, futures):
+            try:
+                scans.append(future.result())
+            except Exception as e:
+                sys.stderr.write("Cannot prepare {0} for the scan: {1}\n"
+                                 .format(target, e))
+                rc = 1
+
+    try:
+        roots_path = os.path.join(tmp_dir, "roots")
+        with open(roots_path, "w") as roots:
+            for i, scan in enumerate(scans):
+                env_path = os.path.join(tmp_dir, "{0}.env".format(i))
+                with open(env_path, "w") as env:
+                    env.write('\n'.join(scan.config["Config"].get("Env", []) or []))
+                name = scan.image_name or scan.container_name
+                arf = os.path.join(os.path.abspath(arf_dir),
+                                   re.sub(r"[/:, ]+", "_", name) + ".arf.xml")
+                roots.write("{0} {1} {2} {3}\n".format(
+                    scan.mountpoint, arf, env_path, name))
+
+        if scans:
+            cmd = [oscap_binary or 'oscap'] + list(scan_args) + \
+                ["--target-roots", roots_path]
+            scan_rc = subprocess.call(cmd)
+            if rc == 0 or scan_rc == 1:
+                rc = scan_rc
+    finally:
+        for scan in scans:
+            scan._end()
+        shutil.rmtree(tmp_dir)
+
+    return rc